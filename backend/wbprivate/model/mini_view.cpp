@@ -32,7 +32,8 @@ using namespace mdc;
 using namespace wb;
 using namespace base;
 
-MiniView::MiniView(mdc::Layer *layer) : mdc::Figure(layer), _canvas_view(0), _viewport_figure(0) {
+MiniView::MiniView(mdc::Layer *layer)
+  : mdc::Figure(layer), _canvas_view(0), _viewport_figure(0), _cache(0), _cache_scale(0), _cache_valid(false) {
   _updating_viewport = false;
   _skip_viewport_update = false;
 
@@ -47,13 +48,16 @@ MiniView::MiniView(mdc::Layer *layer) : mdc::Figure(layer), _canvas_view(0), _vi
 }
 
 MiniView::~MiniView() {
-  if (_view_repaint_connection.connected())
-    _view_repaint_connection.disconnect();
+  if (_view_damage_connection.connected())
+    _view_damage_connection.disconnect();
 
   if (_view_viewport_change_connection.connected())
     _view_viewport_change_connection.disconnect();
 
   delete _viewport_figure; // not added to layer, so delete it by hand
+
+  if (_cache)
+    cairo_surface_destroy(_cache);
 }
 
 bool MiniView::view_button_cb(mdc::CanvasView *view, mdc::MouseButton btn, bool press, Point pos, mdc::EventState) {
@@ -100,6 +104,7 @@ void MiniView::update_size() {
   set_fixed_size(size);
   resize_to(size);
 
+  invalidate_overview();
   viewport_changed();
 }
 
@@ -117,15 +122,16 @@ void MiniView::render_layer(CairoCtx *cr, const model_LayerRef &layer) {
     l->render_mini(cr);
 }
 
-void MiniView::render_layer_figures(mdc::CairoCtx *cr, const model_LayerRef &layer) {
+void MiniView::render_layer_figures(mdc::CairoCtx *cr, const model_LayerRef &layer, const Rect &area) {
   for (size_t c = layer->figures().count(), i = 0; i < c; i++) {
     model_FigureRef figure(layer->figures()[i]);
     mdc::CanvasItem *figure_layer;
+    mdc::CanvasItem *item = figure->get_data()->get_canvas_item();
 
-    if (figure->get_data()->get_canvas_item()) {
+    if (item && (area.empty() || mdc::bounds_intersect(area, item->get_root_bounds()))) {
       cr->save();
 
-      figure_layer = figure->get_data()->get_canvas_item()->get_parent();
+      figure_layer = item->get_parent();
       cr->translate(figure_layer->get_position());
 
       render_figure(cr, figure);
@@ -161,7 +167,11 @@ Rect MiniView::get_scaled_target_bounds(double &scale) {
   return rect;
 }
 
-void MiniView::draw_contents(CairoCtx *cr) {
+/**
+ * Renders the overview of the diagram. With a non empty area (in main view coordinates) only the figures
+ * intersecting it are rendered, the caller clips the output to it.
+ */
+void MiniView::render_diagram(CairoCtx *cr, const Rect &area) {
   cr->set_operator(CAIRO_OPERATOR_SOURCE);
   cr->set_color(Color(0.7, 0.7, 0.7));
   cr->paint();
@@ -216,13 +226,92 @@ void MiniView::draw_contents(CairoCtx *cr) {
     render_layer(cr, _model_diagram->layers()[i]);
 
   // now draw figures only
-  render_layer_figures(cr, _model_diagram->rootLayer());
+  render_layer_figures(cr, _model_diagram->rootLayer(), area);
   for (size_t c = _model_diagram->layers().count(), i = 0; i < c; i++)
-    render_layer_figures(cr, _model_diagram->layers()[i]);
+    render_layer_figures(cr, _model_diagram->layers()[i], area);
+
+  cr->restore();
+}
+
+/**
+ * Paints the overview from its cache. The cache is only rendered again where the main view reported
+ * changed contents, scrolling the main view just moves the viewport figure.
+ */
+void MiniView::draw_contents(CairoCtx *cr) {
+  double scale;
+  Rect bounds = get_scaled_target_bounds(scale);
+
+  // Size of the cache in device pixels.
+  double width = get_size().width, height = get_size().height;
+  cairo_user_to_device_distance(cr->get_cr(), &width, &height);
+  int cache_width = (int)ceil(width), cache_height = (int)ceil(height);
+  if (cache_width <= 0 || cache_height <= 0)
+    return;
+
+  if (_cache && (cairo_image_surface_get_width(_cache) != cache_width ||
+                 cairo_image_surface_get_height(_cache) != cache_height)) {
+    cairo_surface_destroy(_cache);
+    _cache = 0;
+  }
+  if (!_cache) {
+    _cache = cairo_image_surface_create(CAIRO_FORMAT_RGB24, cache_width, cache_height);
+    _cache_valid = false;
+  }
+  if (bounds != _cache_bounds || scale != _cache_scale)
+    _cache_valid = false;
+
+  if (!_cache_valid || !_damage.empty()) {
+    CairoCtx ctx(_cache);
+    ctx.scale(Point(cache_width / get_size().width, cache_height / get_size().height));
+
+    Rect area;
+    if (_cache_valid) {
+      // Map the damage to overview coordinates, with a pixel of slack for antialiasing.
+      area = _damage;
+      Rect patch(floor(bounds.left() + area.left() * scale) - 1, floor(bounds.top() + area.top() * scale) - 1,
+                 ceil(area.width() * scale) + 3, ceil(area.height() * scale) + 3);
+      ctx.rectangle(patch);
+      ctx.clip();
+    }
+    render_diagram(&ctx, area);
+
+    _cache_bounds = bounds;
+    _cache_scale = scale;
+    _cache_valid = true;
+    _damage = Rect();
+  }
 
+  cr->save();
+  cr->scale(Point(get_size().width / cache_width, get_size().height / cache_height));
+  cr->set_operator(CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface(cr->get_cr(), _cache, 0, 0);
+  cr->paint();
   cr->restore();
 }
 
+void MiniView::content_damaged(const Rect &area) {
+  if (area.empty())
+    _cache_valid = false;
+  else if (_cache_valid) {
+    if (_damage.empty())
+      _damage = area;
+    else {
+      double left = std::min(_damage.left(), area.left());
+      double top = std::min(_damage.top(), area.top());
+      double right = std::max(_damage.right(), area.right());
+      double bottom = std::max(_damage.bottom(), area.bottom());
+      _damage = Rect(left, top, right - left, bottom - top);
+    }
+  }
+  set_needs_render();
+}
+
+void MiniView::invalidate_overview() {
+  _cache_valid = false;
+  _damage = Rect();
+  set_needs_render();
+}
+
 void MiniView::viewport_changed() {
   if (_viewport_figure && _canvas_view && !_updating_viewport) {
     Rect vp = _canvas_view->get_viewport();
@@ -300,8 +389,8 @@ void MiniView::set_active_view(mdc::CanvasView *canvas_view, const model_Diagram
                    std::bind(&MiniView::viewport_dragged, this, std::placeholders::_1));
   }
 
-  if (_view_repaint_connection.connected())
-    _view_repaint_connection.disconnect();
+  if (_view_damage_connection.connected())
+    _view_damage_connection.disconnect();
 
   if (_view_viewport_change_connection.connected())
     _view_viewport_change_connection.disconnect();
@@ -310,8 +399,8 @@ void MiniView::set_active_view(mdc::CanvasView *canvas_view, const model_Diagram
     _view_viewport_change_connection =
       _canvas_view->signal_viewport_changed()->connect(std::bind(&MiniView::viewport_changed, this));
 
-    _view_repaint_connection =
-      _canvas_view->signal_repaint()->connect((std::bind(&CanvasItem::set_needs_render, this)));
+    _view_damage_connection = _canvas_view->signal_content_damaged()->connect(
+      std::bind(&MiniView::content_damaged, this, std::placeholders::_1));
 
     _viewport_figure->set_visible(true);
 
@@ -321,9 +410,9 @@ void MiniView::set_active_view(mdc::CanvasView *canvas_view, const model_Diagram
     viewport_changed();
   } else {
     _view_viewport_change_connection.disconnect();
-    _view_repaint_connection.disconnect();
+    _view_damage_connection.disconnect();
     _viewport_figure->set_visible(false);
   }
 
-  set_needs_render();
+  invalidate_overview();
 }
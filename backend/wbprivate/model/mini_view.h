@@ -43,14 +43,25 @@ namespace wb {
 
     mdc::RectangleFigure *_viewport_figure;
 
-    boost::signals2::scoped_connection _view_repaint_connection;
+    // The rendered overview, patched where the main view's contents changed.
+    cairo_surface_t *_cache;
+    base::Rect _cache_bounds;
+    double _cache_scale;
+    bool _cache_valid;
+    base::Rect _damage; // In main view coordinates, pending for _cache.
+
+    boost::signals2::scoped_connection _view_damage_connection;
     boost::signals2::scoped_connection _view_viewport_change_connection;
 
     void render_figure(mdc::CairoCtx *cr, const model_FigureRef &elem);
     void render_layer(mdc::CairoCtx *cr, const model_LayerRef &layer);
-    void render_layer_figures(mdc::CairoCtx *cr, const model_LayerRef &layer);
+    void render_layer_figures(mdc::CairoCtx *cr, const model_LayerRef &layer, const base::Rect &area);
+    void render_diagram(mdc::CairoCtx *cr, const base::Rect &area);
     virtual void draw_contents(mdc::CairoCtx *cr);
 
+    void content_damaged(const base::Rect &area);
+    void invalidate_overview();
+
     void viewport_changed();
 
     void viewport_dragged(const base::Rect &rect);
@@ -221,6 +221,25 @@ static std::vector<grt::Ref<T> > sort_db_object(grt::ListRef<T> list) {
   return vec;
 }
 
+// Adds a node per object in one go, then only what differs between them is set node by node.
+template <class T>
+void CatalogTreeView::add_object_nodes(mforms::TreeNodeRef parent, const std::vector<grt::Ref<T> > &objects,
+                                       const std::string &icon,
+                                       const std::unordered_set<grt::internal::Value *> &on_diagram) {
+  mforms::TreeNodeCollectionSkeleton nodes(icon);
+  nodes.captions.reserve(objects.size());
+  for (size_t i = 0; i < objects.size(); ++i)
+    nodes.captions.push_back(*objects[i]->name());
+
+  std::vector<mforms::TreeNodeRef> added(parent->add_node_collection(nodes));
+  for (size_t i = 0; i < added.size() && i < objects.size(); ++i) {
+    added[i]->set_tag(objects[i].id());
+    added[i]->set_data(new ObjectNodeData(objects[i]));
+    if (on_diagram.find(objects[i].valueptr()) != on_diagram.end())
+      added[i]->set_string(1, "\xe2\x97\x8f");
+  }
+}
+
 void CatalogTreeView::refill(bool force) {
   if (_initialized && !force)
     return;
@@ -243,7 +262,7 @@ void CatalogTreeView::refill(bool force) {
       uset.insert(f.get_member("routineGroup").valueptr());
   }
 
-  freeze_refresh();
+  mforms::TreeViewUpdateScope update(this);
   grt::ListRef<db_Schema> schema_list = workbench_physical_ModelRef::cast_from(model)->catalog()->schemata();
   for (size_t i = 0; i < schema_list.count(); ++i) {
     mforms::TreeNodeRef node = add_node();
@@ -258,51 +277,19 @@ void CatalogTreeView::refill(bool force) {
     child->set_string(0, _("Tables"));
     child->set_icon_path(0, get_node_icon_path(IconTablesMany));
 
-    std::vector<db_TableRef> table_list = sort_db_object<db_Table>(schema_list[i]->tables());
-
-    for (size_t j = 0; j < table_list.size(); ++j) {
-      db_TableRef table = table_list[j];
-      mforms::TreeNodeRef subchild = child->add_child();
-      subchild->set_string(0, table->name().c_str());
-      subchild->set_icon_path(0, get_node_icon_path(IconTable));
-      subchild->set_tag(table.id());
-      subchild->set_data(new ObjectNodeData(table));
-      if (uset.find(table.valueptr()) != uset.end())
-        subchild->set_string(1, "\xe2\x97\x8f");
-    }
+    add_object_nodes(child, sort_db_object<db_Table>(schema_list[i]->tables()), get_node_icon_path(IconTable), uset);
 
     child = node->add_child();
     child->set_string(0, _("Views"));
     child->set_icon_path(0, get_node_icon_path(IconViewsMany));
-    std::vector<db_ViewRef> view_list = sort_db_object<db_View>(schema_list[i]->views());
-    for (size_t j = 0; j < view_list.size(); ++j) {
-      db_ViewRef view = view_list[j];
-      mforms::TreeNodeRef subchild = child->add_child();
-      subchild->set_string(0, view->name().c_str());
-      subchild->set_icon_path(0, get_node_icon_path(IconView));
-      subchild->set_tag(view.id());
-      subchild->set_data(new ObjectNodeData(view));
-      if (uset.find(view.valueptr()) != uset.end())
-        subchild->set_string(1, "\xe2\x97\x8f");
-    }
+    add_object_nodes(child, sort_db_object<db_View>(schema_list[i]->views()), get_node_icon_path(IconView), uset);
 
     child = node->add_child();
     child->set_string(0, _("Routine Groups"));
     child->set_icon_path(0, get_node_icon_path(IconRoutineGroupsMany));
-    std::vector<db_RoutineGroupRef> routine_group_list =
-      sort_db_object<db_RoutineGroup>(schema_list[i]->routineGroups());
-    for (size_t j = 0; j < routine_group_list.size(); ++j) {
-      db_RoutineGroupRef routineGrp = routine_group_list[j];
-      mforms::TreeNodeRef subchild = child->add_child();
-      subchild->set_string(0, routineGrp->name().c_str());
-      subchild->set_icon_path(0, get_node_icon_path(IconRoutineGroup));
-      subchild->set_tag(routineGrp.id());
-      subchild->set_data(new ObjectNodeData(routineGrp));
-      if (uset.find(routineGrp.valueptr()) != uset.end())
-        subchild->set_string(1, "\xe2\x97\x8f");
-    }
+    add_object_nodes(child, sort_db_object<db_RoutineGroup>(schema_list[i]->routineGroups()),
+                     get_node_icon_path(IconRoutineGroup), uset);
   }
-  thaw_refresh();
   _initialized = true;
 }
 
@@ -399,57 +386,45 @@ void CatalogTreeView::add_update_node_caption(grt::ValueRef val) {
       node = create_new_node(otype, root_node(), new_name, obj);
   }
 
-  if (node.is_valid() &&
-      node->get_parent()->count() >
-        1) // We check if node is valid, and if so we need to rearrange this into different position.
-  {
-    mforms::TreeNodeRef next_node = node->next_sibling();
-    mforms::TreeNodeRef parent = node->get_parent();
-    mforms::TreeNodeRef prev_node = node->previous_sibling();
-    bool moved = false;
-    if (next_node.is_valid()) {
-      int new_idx = -1;
-      while (next_node.is_valid()) {
-        int ret = base::string_compare(node->get_string(0), next_node->get_string(0), false);
-        if (ret > 0)
-          new_idx = parent->get_child_index(next_node);
-        else {
-          next_node = next_node->previous_sibling(); // wee need to get back to the prev node
-          break;
-        }
-
-        if (next_node->next_sibling().is_valid())
-          next_node = next_node->next_sibling();
-        else
-          break;
-      }
-      if (new_idx > -1 && next_node.is_valid()) {
-        node->move_node(next_node, false);
-        moved = true;
-      }
-    }
-    if (prev_node.is_valid() && !moved) {
-      int new_idx = -1;
-      while (prev_node.is_valid()) {
-        int ret = base::string_compare(node->get_string(0), prev_node->get_string(0), false);
-        if (ret < 0)
-          new_idx = parent->get_child_index(prev_node);
-        else {
-          prev_node = prev_node->next_sibling(); // wee need to get back to the prev node
-          break;
-        }
-
-        if (prev_node->previous_sibling().is_valid())
-          prev_node = prev_node->previous_sibling();
-        else
-          break;
-      }
-      if (new_idx > -1 && prev_node.is_valid()) {
-        node->move_node(prev_node, true);
-        moved = true;
-      }
-    }
+  if (node.is_valid())
+    move_to_sorted_position(node);
+}
+
+/**
+ * Moves a new or renamed node to its place among its alphabetically sorted siblings. The place is found with a
+ * binary search, so sections with thousands of objects don't walk all siblings for each change.
+ */
+void CatalogTreeView::move_to_sorted_position(mforms::TreeNodeRef node) {
+  mforms::TreeNodeRef parent = node->get_parent();
+  int count = parent.is_valid() ? parent->count() : 0;
+  if (count < 2)
+    return;
+
+  std::string name = node->get_string(0);
+  int index = parent->get_child_index(node);
+
+  // Nothing to do if the neighbours are still in order, the common case for a rename.
+  bool after_prev = index == 0 || base::string_compare(parent->get_child(index - 1)->get_string(0), name, false) <= 0;
+  bool before_next =
+    index == count - 1 || base::string_compare(name, parent->get_child(index + 1)->get_string(0), false) <= 0;
+  if (after_prev && before_next)
+    return;
+
+  // Search the siblings without the node itself for the first one that sorts after it.
+  int low = 0, high = count - 1;
+  while (low < high) {
+    int middle = (low + high) / 2;
+    int sibling = middle < index ? middle : middle + 1;
+    if (base::string_compare(parent->get_child(sibling)->get_string(0), name, false) > 0)
+      high = middle;
+    else
+      low = middle + 1;
   }
+
+  if (low < count - 1)
+    node->move_node(parent->get_child(low < index ? low : low + 1), true);
+  else
+    node->move_node(parent->get_child(index == count - 1 ? count - 2 : count - 1), false);
 }
 
 void CatalogTreeView::remove_node(grt::ValueRef val) {
@@ -29,6 +29,8 @@
 #include "mforms/treeview.h"
 #include "grtpp_value.h"
 
+#include <unordered_set>
+
 namespace mforms {
   class ContextMenu;
 }
@@ -72,11 +74,16 @@ namespace wb {
     void context_menu_will_show(mforms::MenuItem *parent_item);
     std::function<void(grt::ValueRef)> _activate_callback;
 
+    template <class T>
+    void add_object_nodes(mforms::TreeNodeRef parent, const std::vector<grt::Ref<T> > &objects,
+                          const std::string &icon, const std::unordered_set<grt::internal::Value *> &on_diagram);
+
   protected:
     virtual bool get_drag_data(mforms::DragDetails &details, void **data, std::string &format);
     void menu_action(const std::string &name, grt::ValueRef val);
     mforms::TreeNodeRef create_new_node(const ObjectType &otype, mforms::TreeNodeRef parent, const std::string &name,
                                         grt::ObjectRef val);
+    void move_to_sorted_position(mforms::TreeNodeRef node);
 
   public:
     CatalogTreeView(ModelDiagramForm *owner);
@@ -118,7 +118,7 @@ void WBComponentPhysical::load_app_options(bool update) {
   if (g_file_test(conn_list_xml.c_str(), G_FILE_TEST_EXISTS)) {
     try {
       grt::ListRef<db_mgmt_Connection> list(
-        grt::ListRef<db_mgmt_Connection>::cast_from(grt::GRT::get()->unserialize(conn_list_xml)));
+        grt::ListRef<db_mgmt_Connection>::cast_from(grt::GRT::get()->unserialize_with_snapshot(conn_list_xml)));
 
       if (list.is_valid()) {
         logDebug("Loaded connection list, %i connections found.\n", (int)list.count());
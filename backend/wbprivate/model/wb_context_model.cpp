@@ -78,7 +78,9 @@ WBContextModel::WBContextModel()
     _locked_view_for_plugin_exec(0),
     _auto_save_point(0),
     _last_auto_save_time(0),
-    _auto_save_timer(NULL)
+    _auto_save_timer(NULL),
+    _auto_save_journal_size(0),
+    _auto_save_full_pending(true)
 
 {
   _overview = new PhysicalOverviewBE(wb::WBContextUI::get()->get_wb());
@@ -115,6 +117,9 @@ WBContextModel::WBContextModel()
   _sidebar_dockpoint = NULL;
   _template_panel = NULL;
 
+  scoped_connect(grt::GRT::get()->get_undo_manager()->signal_action_added(),
+                 std::bind(&WBContextModel::undo_action_added, this, std::placeholders::_1));
+
   scoped_connect(wb::WBContextUI::get()->get_wb()->get_root()->options()->signal_dict_changed(),
                  std::bind(&WBContextModel::option_changed, this, std::placeholders::_1, std::placeholders::_2,
                            std::placeholders::_3));
@@ -206,6 +211,80 @@ void WBContextModel::option_changed(grt::internal::OwnedDict *dict, bool, const
   }
 }
 
+// Autosave writes the whole document again once this many objects were written to the journal.
+#define AUTO_SAVE_JOURNAL_LIMIT 500
+
+/**
+ * Returns the schema object or diagram that contains @value. Their XML can replace the old version as a whole
+ * when the autosave journal is replayed. An invalid ref means the change needs a full autosave.
+ */
+static GrtObjectRef autosave_journal_unit(const grt::ObjectRef &value) {
+  if (!GrtObjectRef::can_wrap(value))
+    return GrtObjectRef();
+
+  GrtObjectRef object(GrtObjectRef::cast_from(value));
+  while (object.is_valid()) {
+    GrtObjectRef owner(object->owner());
+    if (!owner.is_valid())
+      break;
+
+    if ((db_DatabaseObjectRef::can_wrap(object) && db_SchemaRef::can_wrap(owner)) ||
+        (model_DiagramRef::can_wrap(object) && model_ModelRef::can_wrap(owner)))
+      return object;
+    object = owner;
+  }
+  return GrtObjectRef();
+}
+
+// The object whose member, list or dict is changed by the undo action.
+static grt::ObjectRef undo_action_object(grt::UndoAction *action) {
+  if (grt::UndoObjectChangeAction *change = dynamic_cast<grt::UndoObjectChangeAction *>(action))
+    return change->get_object();
+
+  grt::BaseListRef list;
+  if (grt::UndoListInsertAction *insert = dynamic_cast<grt::UndoListInsertAction *>(action))
+    list = insert->get_list();
+  else if (grt::UndoListSetAction *set = dynamic_cast<grt::UndoListSetAction *>(action))
+    list = set->get_list();
+  else if (grt::UndoListReorderAction *reorder = dynamic_cast<grt::UndoListReorderAction *>(action))
+    list = reorder->get_list();
+  else if (grt::UndoListRemoveAction *remove = dynamic_cast<grt::UndoListRemoveAction *>(action))
+    list = remove->get_list();
+  if (list.is_valid()) {
+    grt::internal::OwnedList *owned = dynamic_cast<grt::internal::OwnedList *>(list.valueptr());
+    return owned ? grt::ObjectRef(owned->owner_of_owned_list()) : grt::ObjectRef();
+  }
+
+  grt::DictRef dict;
+  if (grt::UndoDictSetAction *set = dynamic_cast<grt::UndoDictSetAction *>(action))
+    dict = set->get_dict();
+  else if (grt::UndoDictRemoveAction *remove = dynamic_cast<grt::UndoDictRemoveAction *>(action))
+    dict = remove->get_dict();
+  if (dict.is_valid()) {
+    grt::internal::OwnedDict *owned = dynamic_cast<grt::internal::OwnedDict *>(dict.valueptr());
+    return owned ? grt::ObjectRef(owned->owner_of_owned_dict()) : grt::ObjectRef();
+  }
+
+  return grt::ObjectRef();
+}
+
+void WBContextModel::undo_action_added(grt::UndoAction *action) {
+  if (!_doc.is_valid() || dynamic_cast<grt::UndoGroup *>(action))
+    return;
+
+  base::MutexLock lock(_auto_save_mutex);
+  if (_auto_save_full_pending)
+    return;
+
+  GrtObjectRef unit(autosave_journal_unit(undo_action_object(action)));
+  if (unit.is_valid())
+    _auto_save_changes[unit->id()] = unit;
+  else {
+    _auto_save_full_pending = true;
+    _auto_save_changes.clear();
+  }
+}
+
 bool WBContextModel::auto_save_document() {
   WBContext *wb = wb::WBContextUI::get()->get_wb();
   ssize_t interval = wb->get_root()->options()->options().get_int("workbench:AutoSaveModelInterval", 60);
@@ -220,10 +299,31 @@ bool WBContextModel::auto_save_document() {
       grt::GRT::get()->get_undo_manager()->get_latest_closed_undo_action() != _auto_save_point) {
     _auto_save_point = grt::GRT::get()->get_undo_manager()->get_latest_closed_undo_action();
     _last_auto_save_time = now;
+    std::list<GrtObjectRef> changes;
+    bool full;
+    {
+      base::MutexLock lock(_auto_save_mutex);
+      full = _auto_save_full_pending || _auto_save_journal_size + _auto_save_changes.size() > AUTO_SAVE_JOURNAL_LIMIT;
+      for (std::map<std::string, GrtObjectRef>::const_iterator iter = _auto_save_changes.begin();
+           iter != _auto_save_changes.end(); ++iter)
+        changes.push_back(iter->second);
+      _auto_save_changes.clear();
+      _auto_save_full_pending = false;
+    }
+
     try {
       // save the document in the same directory containing the expanded mwb file
-      _file->store_document_autosave(doc);
+      if (!full && !changes.empty())
+        full = !_file->store_document_autosave_changes(changes);
+      if (!full)
+        _auto_save_journal_size += changes.size();
+      else {
+        _file->store_document_autosave(doc);
+        _auto_save_journal_size = 0;
+      }
     } catch (std::exception &exc) {
+      base::MutexLock lock(_auto_save_mutex);
+      _auto_save_full_pending = true;
       wb->show_exception(_("Could not store document data to autosave file."), exc);
     }
   }
@@ -259,7 +359,8 @@ void WBContextModel::detect_auto_save_files(const std::string &autosave_dir) {
     if (base::LockFile::check(base::makePath(*d, ModelFile::lock_filename.c_str())) != base::LockFile::NotLocked)
       continue;
 
-    if (g_file_test(base::makePath(*d, MAIN_DOCUMENT_AUTOSAVE_NAME).c_str(), G_FILE_TEST_EXISTS)) {
+    if (g_file_test(base::makePath(*d, MAIN_DOCUMENT_AUTOSAVE_BINARY_NAME).c_str(), G_FILE_TEST_EXISTS) ||
+        g_file_test(base::makePath(*d, MAIN_DOCUMENT_AUTOSAVE_NAME).c_str(), G_FILE_TEST_EXISTS)) {
       std::string path = base::makePath(*d, "real_path");
       gchar *orig_path;
       gsize length;
@@ -1133,7 +1234,16 @@ void WBContextModel::export_png(const std::string &path) {
     wb::WBContextUI::get()->get_wb()->_frontendCallbacks->show_status_text(
       strfmt(_("Exporting to %s..."), path.c_str()));
     try {
-      form->get_view()->export_png(path, true);
+      int shown_percent = 0;
+      form->get_view()->export_png(path, true, [&shown_percent, path](float fraction) {
+        int percent = (int)(fraction * 100);
+        if (percent >= shown_percent + 10) {
+          shown_percent = percent;
+          wb::WBContextUI::get()->get_wb()->_frontendCallbacks->show_status_text(
+            strfmt(_("Exporting to %s... %i%%"), path.c_str(), percent));
+        }
+        return true;
+      });
       wb::WBContextUI::get()->get_wb()->_frontendCallbacks->show_status_text(
         strfmt(_("Exported diagram image to %s"), path.c_str()));
     } catch (const std::exception &exc) {
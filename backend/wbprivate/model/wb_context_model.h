@@ -25,6 +25,7 @@
 
 #include "workbench/wb_backend_public_interface.h"
 #include "base/notifications.h"
+#include "base/threading.h"
 
 #include "wbcanvas/model_model_impl.h"
 
@@ -200,6 +201,14 @@ namespace wb {
     int _auto_save_interval;
     bec::GRTManager::Timer *_auto_save_timer;
 
+    // Objects changed since the last autosave, written to the autosave journal instead of the whole document.
+    base::Mutex _auto_save_mutex;
+    std::map<std::string, GrtObjectRef> _auto_save_changes;
+    size_t _auto_save_journal_size;
+    bool _auto_save_full_pending;
+
+    void undo_action_added(grt::UndoAction *action);
+
     std::map<std::string, ModelDiagramForm *> _model_forms;
   };
 };
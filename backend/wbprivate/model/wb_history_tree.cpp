@@ -45,34 +45,52 @@ HistoryTree::HistoryTree(UndoManager *undom)
                  std::bind(&HistoryTree::activate_node, this, std::placeholders::_1, std::placeholders::_2));
 }
 
+/**
+ * Brings the list in line with the undo and redo stacks. Only rows that differ from what is shown are touched:
+ * usually that is the row of the action just done or undone, the redo rows dropped by a new action and the oldest
+ * rows trimmed by the undo limit, so long editing sessions don't update thousands of rows per action.
+ */
 void HistoryTree::refresh() {
+  std::vector<ShownAction> actions;
+
   _undom->lock();
-  std::deque<UndoAction *> undostack(_undom->get_undo_stack());
-  std::deque<UndoAction *> redostack(_undom->get_redo_stack());
+  std::deque<UndoAction *> &undostack(_undom->get_undo_stack());
+  std::deque<UndoAction *> &redostack(_undom->get_redo_stack());
 
   _refresh_pending = false;
 
-  int new_count = (int)(undostack.size() + redostack.size());
-  while (count() < new_count)
-    add_node();
-  while (count() > new_count)
-    node_at_row(count() - 1)->remove_from_parent();
-
-  // just update the captions of the existing nodes
+  actions.reserve(undostack.size() + redostack.size());
+  for (std::deque<UndoAction *>::const_iterator iter = undostack.begin(); iter != undostack.end(); ++iter)
+    actions.push_back(ShownAction(*iter, (*iter)->description()));
+  for (std::deque<UndoAction *>::const_reverse_iterator iter = redostack.rbegin(); iter != redostack.rend(); ++iter)
+    actions.push_back(ShownAction(*iter, "(" + (*iter)->description() + ")"));
+  _undom->unlock();
 
-  int row = 0;
-  for (std::deque<UndoAction *>::const_iterator iter = undostack.begin(); iter != undostack.end(); ++iter) {
-    mforms::TreeNodeRef node = node_at_row(row++);
-    node->set_icon_path(0, _icon);
-    node->set_string(0, (*iter)->description());
+  // Actions trimmed from the bottom of the undo stack remove the first rows.
+  if (!actions.empty() && !_shown.empty() && _shown.front().first != actions.front().first) {
+    size_t trimmed = 1;
+    while (trimmed < _shown.size() && _shown[trimmed].first != actions.front().first)
+      ++trimmed;
+    if (trimmed < _shown.size()) {
+      for (size_t i = 0; i < trimmed; ++i)
+        node_at_row(0)->remove_from_parent();
+      _shown.erase(_shown.begin(), _shown.begin() + trimmed);
+    }
   }
 
-  for (std::deque<UndoAction *>::const_reverse_iterator iter = redostack.rbegin(); iter != redostack.rend(); ++iter) {
-    mforms::TreeNodeRef node = node_at_row(row++);
+  size_t row = 0;
+  while (row < _shown.size() && row < actions.size() && _shown[row] == actions[row])
+    ++row;
+
+  while (count() > (int)actions.size())
+    node_at_row(count() - 1)->remove_from_parent();
+
+  for (; row < actions.size(); ++row) {
+    mforms::TreeNodeRef node = row < (size_t)count() ? node_at_row((int)row) : add_node();
     node->set_icon_path(0, _icon);
-    node->set_string(0, "(" + (*iter)->description() + ")");
+    node->set_string(0, actions[row].second);
   }
-  _undom->unlock();
+  _shown.swap(actions);
 }
 
 void HistoryTree::activate_node(mforms::TreeNodeRef node, int column) {
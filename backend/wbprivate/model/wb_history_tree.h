@@ -27,15 +27,21 @@
 #include "mforms/treeview.h"
 #include <grtpp_undo_manager.h>
 
+#include <utility>
+#include <vector>
+
 namespace bec {
   class GRTManager;
 };
 
 namespace wb {
   class HistoryTree : public mforms::TreeView {
+    typedef std::pair<grt::UndoAction *, std::string> ShownAction;
+
     grt::UndoManager *_undom;
     std::string _icon;
     bool _refresh_pending;
+    std::vector<ShownAction> _shown; // Action and caption of each row, as last shown.
 
     void handle_redo(grt::UndoAction *);
     void handle_undo(grt::UndoAction *);
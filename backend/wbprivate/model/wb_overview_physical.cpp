@@ -122,6 +122,14 @@ class SchemaListUpdater
     return (*diter)->object == _schemata.get(siter);
   }
 
+  virtual std::string dest_key(dest_iterator iter) {
+    return (*iter)->object.is_valid() ? (*iter)->object.id() : "";
+  }
+
+  virtual std::string source_key(source_iterator iter) {
+    return _schemata.get(iter).id();
+  }
+
   virtual dest_ref get_dest(dest_iterator iter) {
     _reused_items.insert(*iter);
     return *iter;
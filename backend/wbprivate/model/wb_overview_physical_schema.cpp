@@ -28,6 +28,7 @@
 
 #include "grt/icon_manager.h"
 #include "grt/clipboard.h"
+#include "grt/incremental_list_updater.h"
 #include "base/ui_form.h"
 #include "grt/exceptions.h"
 
@@ -168,6 +169,93 @@ static bool CompNodeLabel(OverviewBE::Node *a, OverviewBE::Node *b) {
 
 //----------------------------------------------------------------------
 
+/**
+ * Brings the object nodes of a schema section in line with its object list. Nodes of objects still in the list
+ * are kept and relabeled, only added objects get a new node, so adding or renaming one table in a schema with
+ * thousands of them doesn't recreate all the other nodes.
+ */
+class SchemaContentListUpdater
+  : public IncrementalListUpdater<std::vector<OverviewBE::Node *>::iterator, OverviewBE::Node *, size_t> {
+  virtual dest_iterator get_dest_iterator() {
+    return _nodes.begin();
+  }
+
+  virtual source_iterator get_source_iterator() {
+    return 0;
+  }
+
+  virtual dest_iterator increment_dest(dest_iterator &iter) {
+    return ++iter;
+  }
+
+  virtual source_iterator increment_source(source_iterator &iter) {
+    return ++iter;
+  }
+
+  virtual bool has_more_dest(dest_iterator iter) {
+    return iter != _nodes.end();
+  }
+
+  virtual bool has_more_source(source_iterator iter) {
+    return _list.is_valid() && iter < _list.count();
+  }
+
+  virtual bool items_match(dest_iterator diter, source_iterator siter) {
+    return (*diter)->object == _list.get(siter);
+  }
+
+  virtual std::string dest_key(dest_iterator iter) {
+    return (*iter)->object.is_valid() ? (*iter)->object.id() : "";
+  }
+
+  virtual std::string source_key(source_iterator iter) {
+    return _list.get(iter).id();
+  }
+
+  virtual dest_ref get_dest(dest_iterator iter) {
+    _reused_items.insert(*iter);
+    return *iter;
+  }
+
+  virtual void update(dest_ref dest_item, source_iterator source_item) {
+    dest_item->refresh();
+  }
+
+  virtual dest_iterator begin_adding() {
+    for (dest_iterator i = _nodes.begin(); i != _nodes.end(); ++i) {
+      if (_reused_items.find(*i) == _reused_items.end())
+        delete *i;
+    }
+    _nodes.clear();
+
+    return _nodes.end();
+  }
+
+  virtual dest_iterator add(dest_iterator &iter, source_iterator source_item) {
+    return ++_nodes.insert(iter, _create_node(_list.get(source_item)));
+  }
+
+  virtual dest_iterator add(dest_iterator &iter, dest_ref item) {
+    return ++_nodes.insert(iter, item);
+  }
+
+  virtual void end_adding(dest_iterator iter) {
+  }
+
+  std::vector<OverviewBE::Node *> &_nodes;
+  std::set<OverviewBE::Node *> _reused_items;
+  grt::ListRef<db_DatabaseObject> _list;
+  std::function<OverviewBE::Node *(const db_DatabaseObjectRef &)> _create_node;
+
+public:
+  SchemaContentListUpdater(std::vector<OverviewBE::Node *> &nodes, const grt::ListRef<db_DatabaseObject> &list,
+                           const std::function<OverviewBE::Node *(const db_DatabaseObjectRef &)> &create_node)
+    : _nodes(nodes), _list(list), _create_node(create_node) {
+  }
+};
+
+//----------------------------------------------------------------------
+
 class wb::internal::PhysicalSchemaContentNode : public OverviewBE::ContainerNode {
   std::vector<std::string> _fields;
 
@@ -196,31 +284,36 @@ public:
 
     focused = 0;
 
-    if (!children.empty()) {
-      add_node = children.front();
-      children.erase(children.begin());
+    std::vector<Node *> nodes(children);
+    children.clear();
+    if (!nodes.empty()) {
+      add_node = nodes.front();
+      nodes.erase(nodes.begin());
     }
-    clear_children();
+
+    SchemaContentListUpdater updater(nodes, _list,
+                                     std::bind(&PhysicalSchemaContentNode::create_object_node, this,
+                                               std::placeholders::_1));
+    updater.execute();
 
     if (add_node)
       children.push_back(add_node);
+    children.insert(children.end(), nodes.begin(), nodes.end());
 
-    for (size_t c = _list.count(), i = 0; i < c; i++) {
-      db_DatabaseObjectRef object(_list[i]);
-
-      SchemaObjectNode *node = _create_node(object);
-
-      node->type = OverviewBE::OItem;
-      node->label = object->name();
-      node->small_icon = IconManager::get_instance()->get_icon_id(object->get_metaclass(), Icon16);
-      node->large_icon = IconManager::get_instance()->get_icon_id(object->get_metaclass(), Icon48);
-
-      children.push_back(node);
-    }
     // sort items after add_node
     std::sort(children.begin() + (add_node ? 1 : 0), children.end(), CompNodeLabel);
   }
 
+  Node *create_object_node(const db_DatabaseObjectRef &object) {
+    SchemaObjectNode *node = _create_node(object);
+
+    node->type = OverviewBE::OItem;
+    node->label = object->name();
+    node->small_icon = IconManager::get_instance()->get_icon_id(object->get_metaclass(), Icon16);
+    node->large_icon = IconManager::get_instance()->get_icon_id(object->get_metaclass(), Icon48);
+    return node;
+  }
+
   void set_detail_fields(const std::vector<std::string> &fields) {
     _fields = fields;
   }
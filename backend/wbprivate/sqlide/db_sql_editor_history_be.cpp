@@ -21,23 +21,31 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include <algorithm>
 #include <fstream>
+#include <map>
 #include <glib/gstdio.h>
 #include <stdlib.h>
 
 #include <boost/foreach.hpp>
 #include <pcre.h>
 
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+
 #include "db_sql_editor_history_be.h"
 #include "sqlide/recordset_data_storage.h"
+#include "sqlide/sqlide_generics.h"
 
 #include "base/threading.h"
 #include "base/string_utilities.h"
 #include "base/util_functions.h"
 #include "base/log.h"
 #include "base/file_utilities.h"
+#include "base/file_functions.h"
 #include "base/scope_exit_trigger.h"
 #include "base/xml_functions.h"
+#include "base/boost_smart_ptr_helpers.h"
 
 #include "mforms/utilities.h"
 
@@ -48,8 +56,10 @@ using namespace grt;
 using namespace base;
 
 const char *SQL_HISTORY_DIR_NAME = "sql_history";
+const char *SQL_HISTORY_INDEX_NAME = "history.index";
+static const size_t INDEX_BATCH_SIZE = 50; // appended statements written to the index in one transaction
 
-DbSqlEditorHistory::DbSqlEditorHistory() : _current_entry_index(-1) {
+DbSqlEditorHistory::DbSqlEditorHistory() : _current_entry_index(-1), _index_fts(false) {
   _entries_model = EntriesModel::create(this);
   _details_model = DetailsModel::create();
   _write_only_details_model = DetailsModel::create();
@@ -57,6 +67,7 @@ DbSqlEditorHistory::DbSqlEditorHistory() : _current_entry_index(-1) {
 }
 
 DbSqlEditorHistory::~DbSqlEditorHistory() {
+  flush_index();
 }
 
 void DbSqlEditorHistory::reset() {
@@ -67,6 +78,16 @@ void DbSqlEditorHistory::reset() {
 
 void DbSqlEditorHistory::load() {
   _entries_model->load();
+
+  std::set<std::string> dates;
+  for (size_t i = 0; i < _entries_model->count(); ++i) {
+    std::string date;
+    _entries_model->get_field(i, 0, date);
+    dates.insert(date);
+  }
+
+  open_index();
+  sync_index(dates);
 }
 
 void DbSqlEditorHistory::add_entry(const std::list<std::string> &statements) {
@@ -85,7 +106,14 @@ void DbSqlEditorHistory::current_entry(int index) {
     _details_model->reset();
   else {
     update_timestamp(_entries_model->entry_date(index));
-    _details_model->load(_entries_model->entry_path(index));
+
+    std::string date;
+    TimedStatements rows;
+    _entries_model->get_field(index, 0, date);
+    if (load_indexed_day(date, rows))
+      _details_model->set_rows(rows);
+    else
+      _details_model->load(_entries_model->entry_path(index));
   }
 
   _current_entry_index = index;
@@ -104,8 +132,14 @@ std::string DbSqlEditorHistory::restore_sql_from_history(int entry_index, std::l
     if (entry_index == _current_entry_index)
       details_model = _details_model;
     else {
+      std::string date;
+      TimedStatements rows;
       details_model = DetailsModel::create();
-      details_model->load(_entries_model->entry_path(entry_index));
+      _entries_model->get_field(entry_index, 0, date);
+      if (load_indexed_day(date, rows))
+        details_model->set_rows(rows);
+      else
+        details_model->load(_entries_model->entry_path(entry_index));
     }
     std::string statement;
     for (int row : detail_indexes) {
@@ -196,6 +230,8 @@ void DbSqlEditorHistory::EntriesModel::add_statements(const std::list<std::strin
     _owner->details_model()->add_entries(timed_statements);
   else
     _owner->write_only_details_model()->add_entries(timed_statements);
+
+  _owner->index_statements(format_time(timestamp, "%Y-%m-%d"), timed_statements);
 }
 
 bool DbSqlEditorHistory::EntriesModel::insert_entry(const std::tm &t) {
@@ -266,6 +302,7 @@ void DbSqlEditorHistory::EntriesModel::delete_entries(const std::vector<std::siz
     return;
   {
     std::vector<size_t> sorted_rows = rows;
+    std::vector<std::string> dates;
     std::sort(sorted_rows.begin(), sorted_rows.end());
     BOOST_REVERSE_FOREACH(size_t row, sorted_rows) {
       try {
@@ -273,10 +310,14 @@ void DbSqlEditorHistory::EntriesModel::delete_entries(const std::vector<std::siz
       } catch (const std::exception &exc) {
         logError("Error deleting log entry %s: %s\n", entry_path(row).c_str(), exc.what());
       }
+      std::string date;
+      get_field(row, 0, date);
+      dates.push_back(date);
       Cell row_begin = _data.begin() + row * _column_count;
       _data.erase(row_begin, row_begin + _column_count);
       --_row_count;
     }
+    _owner->delete_indexed_days(dates);
   }
   refresh_ui();
   _owner->current_entry(-1);
@@ -332,65 +373,88 @@ void DbSqlEditorHistory::DetailsModel::reset() {
   refresh_ui();
 }
 
-void DbSqlEditorHistory::DetailsModel::load(const std::string &storage_file_path) {
-  if (base::file_exists(storage_file_path)) {
-    std::ifstream historyXml(storage_file_path);
-    if (historyXml.is_open()) {
-      std::string line;
-
-      // Skips the first line in the file as is the xml header
-      std::getline(historyXml, line);
-      _row_count = 0;
-
-      base::RecMutexLock data_mutex(_data_mutex);
-      _data.clear();
-      _data.reserve(_data.size() + _column_count);
-      while (historyXml.good()) {
-        std::getline(historyXml, line);
-
-        if (line.empty())
-          continue;
-
-        xmlDocPtr xmlDoc = base::xml::xmlParseFragment(line);
-        if (xmlDoc == nullptr) {
-          logError("Can't parse %s, of file: %s\n", line.c_str(), storage_file_path.c_str());
-          continue;
-        }
+/**
+ * Reads the entries of a history file, where each line is an ENTRY element and "~" stands for the time or statement
+ * of the previous entry.
+ */
+bool DbSqlEditorHistory::DetailsModel::read_file(const std::string &storage_file_path, TimedStatements &rows) {
+  if (!base::file_exists(storage_file_path))
+    return false;
+
+  std::ifstream historyXml(storage_file_path);
+  if (!historyXml.is_open())
+    return false;
 
-        // In history we've got one element per line.
-        auto element = xmlDoc->children;
-        if (element->next !=
-            nullptr) // If there's something more, we log proper information and parse only that one element.
-          logError("History line contains too many elements %s, of file: %s\n", line.c_str(),
-                   storage_file_path.c_str());
+  std::string line;
+  std::string last_timestamp, last_statement;
 
-        std::string timestamp = base::xml::getProp(element, "timestamp");
-        std::string statement = base::xml::getContent(element);
-        // decides whether to use or not the existing data
-        if (timestamp != _last_timestamp.toString() && timestamp != "~")
-          _last_timestamp = timestamp;
+  // Skips the first line in the file as is the xml header
+  std::getline(historyXml, line);
+  while (historyXml.good()) {
+    std::getline(historyXml, line);
 
-        if (statement != _last_statement.toString() && statement != "~")
-          _last_statement = statement;
+    if (line.empty())
+      continue;
 
-        _data.push_back(_last_statement);
-        _data.push_back(_last_timestamp);
+    xmlDocPtr xmlDoc = base::xml::xmlParseFragment(line);
+    if (xmlDoc == nullptr) {
+      logError("Can't parse %s, of file: %s\n", line.c_str(), storage_file_path.c_str());
+      continue;
+    }
 
-        _row_count++;
+    // In history we've got one element per line.
+    auto element = xmlDoc->children;
+    if (element->next !=
+        nullptr) // If there's something more, we log proper information and parse only that one element.
+      logError("History line contains too many elements %s, of file: %s\n", line.c_str(),
+               storage_file_path.c_str());
 
-        xmlFree(xmlDoc);
-      }
+    std::string timestamp = base::xml::getProp(element, "timestamp");
+    std::string statement = base::xml::getContent(element);
+    // decides whether to use or not the existing data
+    if (timestamp != "~")
+      last_timestamp = timestamp;
+    if (statement != "~")
+      last_statement = statement;
 
-      std::reverse(_data.begin(), _data.end());
+    rows.push_back(std::make_pair(last_timestamp, last_statement));
 
-      _data_frame_end = _row_count;
+    xmlFree(xmlDoc);
+  }
+  return true;
+}
 
-      _last_loaded_row = (int)_row_count - 1;
-    }
-  } else
+void DbSqlEditorHistory::DetailsModel::load(const std::string &storage_file_path) {
+  TimedStatements rows;
+  if (read_file(storage_file_path, rows))
+    set_rows(rows);
+  else
     logError("Can't open SQL history file %s\n", storage_file_path.c_str());
 }
 
+void DbSqlEditorHistory::DetailsModel::set_rows(const TimedStatements &rows) {
+  base::RecMutexLock data_mutex(_data_mutex);
+  _data.clear();
+  _data.reserve(rows.size() * _column_count);
+  _row_count = 0;
+
+  // Rows are shown newest first.
+  for (TimedStatements::const_reverse_iterator row = rows.rbegin(); row != rows.rend(); ++row) {
+    if (row->first != _last_timestamp.toString())
+      _last_timestamp = row->first;
+    if (row->second != _last_statement.toString())
+      _last_statement = row->second;
+
+    _data.push_back(_last_timestamp);
+    _data.push_back(_last_statement);
+    _row_count++;
+  }
+
+  _data_frame_end = _row_count;
+
+  _last_loaded_row = (int)_row_count - 1;
+}
+
 std::string DbSqlEditorHistory::DetailsModel::storage_file_path() const {
   std::string storage_file_path = base::makePath(bec::GRTManager::get()->get_user_datadir(), SQL_HISTORY_DIR_NAME);
   storage_file_path = base::makePath(storage_file_path, format_time(_datestamp, "%Y-%m-%d"));
@@ -499,3 +563,278 @@ void DbSqlEditorHistory::update_timestamp(std::tm timestamp) {
   write_only_details_model()->datestamp(timestamp);
 }
 //--------------------------------------------------------------------------------------------------
+
+static int history_file_size(const std::string &path) {
+#ifdef _WIN32
+  struct _stat stbuf;
+#else
+  struct stat stbuf;
+#endif
+  if (base_stat(path.c_str(), &stbuf) != 0)
+    return -1;
+  return (int)stbuf.st_size;
+}
+
+void DbSqlEditorHistory::open_index() {
+  std::lock_guard<std::recursive_mutex> lock(_index_mutex);
+  std::string sql_history_dir = base::makePath(bec::GRTManager::get()->get_user_datadir(), SQL_HISTORY_DIR_NAME);
+  std::string path = base::makePath(sql_history_dir, SQL_HISTORY_INDEX_NAME);
+  try {
+    _index.reset(new sqlite::connection(path));
+    sqlite::execute(*_index, "PRAGMA synchronous=NORMAL", true);
+    sqlite::execute(*_index, "create table if not exists files (date varchar(10) primary key, size int)", true);
+
+    std::string statements_sql;
+    {
+      sqlite::query q(*_index, "select sql from sqlite_master where name = 'statements'");
+      if (q.emit()) {
+        std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+        statements_sql = res->get_string(0);
+      }
+    }
+
+    if (!statements_sql.empty())
+      _index_fts = statements_sql.find("fts5") != std::string::npos;
+    else {
+      // FTS5 is not built into every SQLite library, without it searches use LIKE on a plain table.
+      try {
+        sqlite::execute(*_index, "create virtual table statements using fts5(date unindexed, time unindexed, sql)",
+                        true);
+        _index_fts = true;
+      } catch (std::exception &exc) {
+        logInfo("SQL history index without full text search: %s\n", exc.what());
+        sqlite::execute(*_index, "create table statements (date varchar(10), time varchar(10), sql text)", true);
+        sqlite::execute(*_index, "create index statements_date on statements (date)", true);
+        _index_fts = false;
+      }
+    }
+  } catch (std::exception &exc) {
+    logError("Can't open SQL history index %s: %s\n", path.c_str(), exc.what());
+    _index.reset();
+  }
+}
+
+/**
+ * Indexes again the days whose file changed since it was indexed, which includes all of them the first time, and
+ * removes the days whose file is gone.
+ */
+void DbSqlEditorHistory::sync_index(const std::set<std::string> &dates) {
+  std::lock_guard<std::recursive_mutex> lock(_index_mutex);
+  if (!_index)
+    return;
+
+  std::string sql_history_dir = base::makePath(bec::GRTManager::get()->get_user_datadir(), SQL_HISTORY_DIR_NAME);
+  int indexed_days = 0;
+  try {
+    std::map<std::string, int> indexed;
+    {
+      sqlite::query q(*_index, "select date, size from files");
+      if (q.emit()) {
+        std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+        do
+          indexed[res->get_string(0)] = res->get_int(1);
+        while (res->next_row());
+      }
+    }
+
+    std::vector<std::string> removed;
+    for (std::map<std::string, int>::const_iterator day = indexed.begin(); day != indexed.end(); ++day)
+      if (dates.find(day->first) == dates.end())
+        removed.push_back(day->first);
+    delete_indexed_days(removed);
+
+    sqlide::Sqlite_transaction_guarder transaction(_index.get());
+    for (std::set<std::string>::const_iterator date = dates.begin(); date != dates.end(); ++date) {
+      std::string path = base::makePath(sql_history_dir, *date);
+      int size = history_file_size(path);
+      std::map<std::string, int>::const_iterator day = indexed.find(*date);
+      if (day != indexed.end() && day->second == size)
+        continue;
+
+      TimedStatements rows;
+      DetailsModel::read_file(path, rows);
+
+      sqlite::query remove(*_index, "delete from statements where date = ?");
+      remove.bind(1, *date);
+      remove.emit();
+
+      sqlite::query insert(*_index, "insert into statements (date, time, sql) values (?, ?, ?)");
+      for (TimedStatements::const_iterator row = rows.begin(); row != rows.end(); ++row) {
+        insert.bind(1, *date);
+        insert.bind(2, row->first);
+        insert.bind(3, row->second);
+        insert.emit();
+        insert.clear();
+      }
+
+      sqlite::query file(*_index, "insert or replace into files values (?, ?)");
+      file.bind(1, *date);
+      file.bind(2, size);
+      file.emit();
+      ++indexed_days;
+    }
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error updating SQL history index: %s\n", exc.what());
+  }
+
+  if (indexed_days > 0)
+    logInfo("Indexed the SQL history of %i days\n", indexed_days);
+}
+
+void DbSqlEditorHistory::index_statements(const std::string &date, const std::list<std::string> &timed_statements) {
+  std::lock_guard<std::recursive_mutex> lock(_index_mutex);
+  if (!_index)
+    return;
+
+  for (std::list<std::string>::const_iterator item = timed_statements.begin(); item != timed_statements.end();) {
+    Statement statement;
+    statement.date = date;
+    statement.time = *item++;
+    if (item == timed_statements.end())
+      break;
+    statement.sql = *item++;
+    _pending_index_rows.push_back(statement);
+  }
+
+  if (_pending_index_rows.size() >= INDEX_BATCH_SIZE)
+    flush_index();
+}
+
+void DbSqlEditorHistory::flush_index() {
+  std::lock_guard<std::recursive_mutex> lock(_index_mutex);
+  if (!_index || _pending_index_rows.empty())
+    return;
+
+  std::string sql_history_dir = base::makePath(bec::GRTManager::get()->get_user_datadir(), SQL_HISTORY_DIR_NAME);
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_index.get());
+    std::set<std::string> dates;
+    sqlite::query insert(*_index, "insert into statements (date, time, sql) values (?, ?, ?)");
+    for (std::vector<Statement>::const_iterator row = _pending_index_rows.begin(); row != _pending_index_rows.end();
+         ++row) {
+      insert.bind(1, row->date);
+      insert.bind(2, row->time);
+      insert.bind(3, row->sql);
+      insert.emit();
+      insert.clear();
+      dates.insert(row->date);
+    }
+
+    // The files were written before, their sizes now include the rows just indexed.
+    sqlite::query file(*_index, "insert or replace into files values (?, ?)");
+    for (std::set<std::string>::const_iterator date = dates.begin(); date != dates.end(); ++date) {
+      file.bind(1, *date);
+      file.bind(2, history_file_size(base::makePath(sql_history_dir, *date)));
+      file.emit();
+      file.clear();
+    }
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error adding statements to the SQL history index: %s\n", exc.what());
+  }
+  _pending_index_rows.clear();
+}
+
+bool DbSqlEditorHistory::load_indexed_day(const std::string &date, TimedStatements &rows) {
+  std::lock_guard<std::recursive_mutex> lock(_index_mutex);
+  if (!_index)
+    return false;
+
+  flush_index();
+  try {
+    sqlite::query q(*_index, "select time, sql from statements where date = ? order by rowid");
+    q.bind(1, date);
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      do
+        rows.push_back(std::make_pair(res->get_string(0), res->get_string(1)));
+      while (res->next_row());
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading SQL history of %s from the index: %s\n", date.c_str(), exc.what());
+    rows.clear();
+  }
+  // Days missing from the index are read from their file.
+  return !rows.empty();
+}
+
+void DbSqlEditorHistory::delete_indexed_days(const std::vector<std::string> &dates) {
+  std::lock_guard<std::recursive_mutex> lock(_index_mutex);
+  if (!_index || dates.empty())
+    return;
+
+  flush_index();
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_index.get());
+    sqlite::query statements(*_index, "delete from statements where date = ?");
+    sqlite::query files(*_index, "delete from files where date = ?");
+    for (std::vector<std::string>::const_iterator date = dates.begin(); date != dates.end(); ++date) {
+      statements.bind(1, *date);
+      statements.emit();
+      statements.clear();
+      files.bind(1, *date);
+      files.emit();
+      files.clear();
+    }
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error removing days from the SQL history index: %s\n", exc.what());
+  }
+}
+
+std::vector<DbSqlEditorHistory::Statement> DbSqlEditorHistory::search(const std::string &text, std::size_t limit,
+                                                                       std::size_t offset) {
+  std::vector<Statement> result;
+  std::vector<std::string> words = base::split_by_set(base::trim(text), " \t\r\n");
+  words.erase(std::remove(words.begin(), words.end(), std::string()), words.end());
+
+  std::lock_guard<std::recursive_mutex> lock(_index_mutex);
+  if (!_index || words.empty())
+    return result;
+
+  flush_index();
+
+  std::string sql = "select date, time, sql from statements where ";
+  std::string match;
+  for (std::vector<std::string>::const_iterator word = words.begin(); word != words.end(); ++word) {
+    if (_index_fts) {
+      // Every word as a quoted FTS5 string, so operators and punctuation are searched literally.
+      match.append(match.empty() ? "\"" : " \"").append(base::replaceString(*word, "\"", "\"\"")).append("\"");
+    } else
+      sql.append(word == words.begin() ? "" : " and ").append("sql like ? escape '\\'");
+  }
+  if (_index_fts)
+    sql.append("statements match ?");
+  sql.append(" order by rowid desc limit ? offset ?");
+
+  try {
+    sqlite::query q(*_index, sql);
+    int param = 1;
+    if (_index_fts)
+      q.bind(param++, match);
+    else {
+      for (std::vector<std::string>::const_iterator word = words.begin(); word != words.end(); ++word) {
+        std::string pattern = base::replaceString(*word, "\\", "\\\\");
+        pattern = base::replaceString(base::replaceString(pattern, "%", "\\%"), "_", "\\_");
+        q.bind(param++, "%" + pattern + "%");
+      }
+    }
+    q.bind(param++, (int)limit);
+    q.bind(param++, (int)offset);
+
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      do {
+        Statement statement;
+        statement.date = res->get_string(0);
+        statement.time = res->get_string(1);
+        statement.sql = res->get_string(2);
+        result.push_back(statement);
+      } while (res->next_row());
+    }
+  } catch (std::exception &exc) {
+    logError("Error searching the SQL history: %s\n", exc.what());
+  }
+  return result;
+}
@@ -27,6 +27,9 @@
 #include "workbench/wb_backend_public_interface.h"
 #include "sqlide/var_grid_model_be.h"
 #include <time.h>
+#include <mutex>
+#include <set>
+#include <vector>
 #include "mforms/menu.h"
 
 class MYSQLWBBACKEND_PUBLIC_FUNC DbSqlEditorHistory {
@@ -49,9 +52,33 @@ public:
   void current_entry(int index);
   std::string restore_sql_from_history(int entry_index, std::list<int> &detail_indexes);
 
+  struct Statement {
+    std::string date; // YYYY-MM-DD, as the name of the entry
+    std::string time;
+    std::string sql;
+  };
+  typedef std::vector<std::pair<std::string, std::string> > TimedStatements; // time and SQL, oldest first
+
+  // Statements of all days containing all words of text, newest first.
+  std::vector<Statement> search(const std::string &text, std::size_t limit = 100, std::size_t offset = 0);
+
 protected:
   int _current_entry_index;
 
+  // Full text index of all history files, kept in the history directory. The files stay the storage of the
+  // history, the index is rebuilt from them for every day whose file size differs from the one indexed.
+  std::shared_ptr<sqlite::connection> _index;
+  bool _index_fts;
+  std::recursive_mutex _index_mutex;
+  std::vector<Statement> _pending_index_rows; // appended statements, written to the index in batches
+
+  void open_index();
+  void sync_index(const std::set<std::string> &dates);
+  void index_statements(const std::string &date, const std::list<std::string> &timed_statements);
+  void flush_index();
+  bool load_indexed_day(const std::string &date, TimedStatements &rows);
+  void delete_indexed_days(const std::vector<std::string> &dates);
+
 public:
   void load();
 
@@ -84,6 +111,9 @@ public:
 
     void save();
     void load(const std::string &storage_file_path);
+    void set_rows(const TimedStatements &rows);
+
+    static bool read_file(const std::string &storage_file_path, TimedStatements &rows);
 
   protected:
     int _last_loaded_row; // required to skip duplication of existing entries when dumping contents
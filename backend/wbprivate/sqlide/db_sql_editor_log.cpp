@@ -30,6 +30,7 @@
 #include "base/file_functions.h"
 #include "base/file_utilities.h"
 #include "base/log.h"
+#include "base/util_functions.h"
 
 #include "mforms/utilities.h"
 #include "wb_sql_editor_form.h"
@@ -46,10 +47,19 @@ using namespace base;
 // In the actions log file we use the full string.
 #define MAX_LOG_STATEMENT_TEXT 4098
 
+// Seconds between flushes of the buffered action log file.
+#define LOG_FLUSH_INTERVAL 1.0
+
 //--------------------------------------------------------------------------------------------------
 
 DbSqlEditorLog::DbSqlEditorLog(SqlEditorForm *owner, int max_entry_count)
-  : VarGridModel(), _owner(owner), _max_entry_count(max_entry_count) {
+  : VarGridModel(),
+    _owner(owner),
+    _max_entry_count(max_entry_count),
+    _first_row(0),
+    _log_file(nullptr),
+    _last_log_flush(0),
+    _refresh_pending(false) {
   reset();
   std::string log_dir = base::joinPath(bec::GRTManager::get()->get_user_datadir().c_str(), "log", "");
   create_directory(log_dir, 0700);
@@ -73,6 +83,14 @@ DbSqlEditorLog::DbSqlEditorLog(SqlEditorForm *owner, int max_entry_count)
 
 //--------------------------------------------------------------------------------------------------
 
+DbSqlEditorLog::~DbSqlEditorLog() {
+  base::MutexLock lock(_log_file_mutex);
+  if (_log_file)
+    fclose(_log_file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 std::string DbSqlEditorLog::get_selection_text(bool time, bool query, bool result, bool duration) {
   std::string sql;
   for (std::vector<int>::const_iterator end = _selection.end(), it = _selection.begin(); it != end; ++it) {
@@ -157,6 +175,7 @@ void DbSqlEditorLog::reset() {
     base::RecMutexLock data_mutex(_data_mutex);
     _data.clear();
     _next_id = 1;
+    _first_row = 0;
   }
 
   _readonly = true;
@@ -176,12 +195,34 @@ void DbSqlEditorLog::reset() {
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Messages can arrive for every statement of a script, so the grid is refreshed at most once per idle cycle,
+ * no matter how many messages were added in between.
+ */
 void DbSqlEditorLog::refresh() {
+  if (_refresh_pending.exchange(true))
+    return;
+  bec::GRTManager::get()->run_once_when_idle(this, std::bind(&DbSqlEditorLog::refresh_when_idle, this));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void DbSqlEditorLog::refresh_when_idle() {
+  _refresh_pending = false;
+  flush_log_file();
   refresh_ui();
 }
 
 //--------------------------------------------------------------------------------------------------
 
+VarGridModel::Cell DbSqlEditorLog::cell(RowId row, ColumnId column) {
+  if (row >= _row_count)
+    return _data.end();
+  return _data.begin() + ((_first_row + row) % _row_count) * _column_count + column;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 class MsgTypeIcons {
 public:
 
@@ -228,7 +269,8 @@ IconId DbSqlEditorLog::get_field_icon(const NodeId &node, ColumnId column, IconS
     case 0:
       Cell cell;
       if (get_cell(cell, node, column, false)) {
-        int msg_type = boost::get<int>(*cell);
+        sqlite::variant_t value = (*cell).get();
+        int msg_type = boost::get<int>(value);
         icon = msg_type_icons.icon((DbSqlEditorLog::MessageType)msg_type);
       }
       break;
@@ -277,23 +319,15 @@ RowId DbSqlEditorLog::add_message(int msg_type, const std::string &context, cons
     return -1;
 
   std::string time = current_time();
-  if (!_log_file_name.empty()) {
-    base::FILE_scope_ptr fp = base_fopen(_log_file_name.c_str(), "a");
-    fprintf(fp, "[%u, %s] %s: %s\n", _next_id, time.c_str(), context.c_str(), msg.c_str());
-  } else {
+  if (!_log_file_name.empty())
+    write_log_file(_next_id, time, context, msg);
+  else {
     logError("DbSqlEditorLog::add_message called with no log file name set\n");
     return -1;
   }
 
   {
     base::RecMutexLock data_mutex(_data_mutex);
-
-    // Remove oldest messages if there are more than the maximum allowed number.
-    if (_max_entry_count > -1 && _max_entry_count - 1 < (int)_row_count) {
-      _data.erase(_data.begin(), _data.begin() + (_row_count - _max_entry_count + 1) * _column_count);
-      _row_count = _max_entry_count - 1;
-    }
-
     add_message_with_id(_next_id, time, msg_type, context, msg, duration);
   }
 
@@ -305,10 +339,7 @@ RowId DbSqlEditorLog::add_message(int msg_type, const std::string &context, cons
 void DbSqlEditorLog::set_message(RowId row, int msg_type, const std::string &context, const std::string &msg,
                                  const std::string &duration) {
   std::string time = current_time();
-  {
-    base::FILE_scope_ptr fp = base_fopen(_log_file_name.c_str(), "a");
-    fprintf(fp, "[%u, %s] %s: %s\n", (unsigned)row, time.c_str(), context.c_str(), msg.c_str());
-  }
+  write_log_file((unsigned)row, time, context, msg);
 
   base::RecMutexLock data_mutex(_data_mutex);
 
@@ -321,18 +352,49 @@ void DbSqlEditorLog::set_message(RowId row, int msg_type, const std::string &con
     return;
   }
 
-  Data::reverse_iterator cell = _data.rbegin() + _column_count - 2;
-  while (cell != _data.rend()) {
-    unsigned id = (unsigned)boost::apply_visitor(_var_to_int, *cell);
+  for (RowId index = _row_count; index-- > 0;) {
+    sqlite::variant_t value = (*cell(index, 1)).get();
+    unsigned id = (unsigned)boost::apply_visitor(_var_to_int, value);
     if (id == row) {
-      *(cell + 1) = msg_type;
-      --cell;
-      *--cell = base::strip_text(context);
-      *--cell = msg;
-      *--cell = duration;
+      size_t first_cell = ((_first_row + index) % _row_count) * _column_count;
+      _data.set(first_cell, msg_type);
+      _data.set(first_cell + 3, base::strip_text(context));
+      _data.set(first_cell + 4, msg);
+      _data.set(first_cell + 5, duration);
       break;
     }
-    cell += _column_count;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void DbSqlEditorLog::write_log_file(unsigned id, const std::string &time, const std::string &context,
+                                    const std::string &msg) {
+  base::MutexLock lock(_log_file_mutex);
+  if (!_log_file) {
+    _log_file = base_fopen(_log_file_name.c_str(), "a");
+    if (!_log_file) {
+      logError("Can't open action log file %s\n", _log_file_name.c_str());
+      return;
+    }
+  }
+
+  fprintf(_log_file, "[%u, %s] %s: %s\n", id, time.c_str(), context.c_str(), msg.c_str());
+
+  double now = base::timestamp();
+  if (now - _last_log_flush >= LOG_FLUSH_INTERVAL) {
+    fflush(_log_file);
+    _last_log_flush = now;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void DbSqlEditorLog::flush_log_file() {
+  base::MutexLock lock(_log_file_mutex);
+  if (_log_file) {
+    fflush(_log_file);
+    _last_log_flush = base::timestamp();
   }
 }
 
@@ -344,6 +406,19 @@ void DbSqlEditorLog::set_message(RowId row, int msg_type, const std::string &con
  */
 void DbSqlEditorLog::add_message_with_id(RowId id, const std::string &time, int msg_type, const std::string &context,
                                          const std::string &msg, const std::string &duration) {
+  // With the maximum number of messages reached the oldest one is overwritten.
+  if (_max_entry_count > 0 && (int)_row_count >= _max_entry_count) {
+    size_t first_cell = _first_row * _column_count;
+    _data.set(first_cell, msg_type);
+    _data.set(first_cell + 1, (int)id);
+    _data.set(first_cell + 2, time);
+    _data.set(first_cell + 3, base::strip_text(context));
+    _data.set(first_cell + 4, msg);
+    _data.set(first_cell + 5, duration);
+    _first_row = (_first_row + 1) % _row_count;
+    return;
+  }
+
   _data.reserve(_data.size() + _column_count);
 
   try {
@@ -27,6 +27,9 @@
 #include "workbench/wb_backend_public_interface.h"
 #include "sqlide/var_grid_model_be.h"
 #include "mforms/menu.h"
+#include "base/threading.h"
+
+#include <atomic>
 
 class SqlEditorForm;
 
@@ -36,8 +39,7 @@ public:
 
   typedef std::shared_ptr<DbSqlEditorLog> Ref;
 
-  virtual ~DbSqlEditorLog() {
-  }
+  virtual ~DbSqlEditorLog();
 
   static Ref create(SqlEditorForm *owner, int max_entry_count) {
     return Ref(new DbSqlEditorLog(owner, max_entry_count));
@@ -69,6 +71,9 @@ protected:
   void add_message_with_id(RowId id, const std::string &time, int msg_type, const std::string &context,
                            const std::string &msg, const std::string &duration);
 
+  // Once the maximum number of messages is reached _data is used as a ring buffer, starting at _first_row.
+  virtual Cell cell(RowId row, ColumnId column);
+
 private:
   SqlEditorForm *_owner;
   mforms::Menu _context_menu;
@@ -76,8 +81,17 @@ private:
   int _max_entry_count;       // For the internal list which is used in the UI.
   std::string _log_file_name; // For the action log file.
   unsigned _next_id;
+  RowId _first_row;
+
+  base::Mutex _log_file_mutex;
+  FILE *_log_file;       // Kept open, written buffered and flushed every LOG_FLUSH_INTERVAL.
+  double _last_log_flush;
+  std::atomic<bool> _refresh_pending;
 
   void handle_context_menu(const std::string &action);
+  void write_log_file(unsigned id, const std::string &time, const std::string &context, const std::string &msg);
+  void flush_log_file();
+  void refresh_when_idle();
 };
 
 #endif /* _DB_SQL_EDITOR_LOG_BE_H_ */
@@ -530,6 +530,16 @@ ToolBar *QuerySidePalette::prepare_snippet_toolbar() {
                  std::bind(&QuerySidePalette::snippet_toolbar_item_activated, this, std::placeholders::_1));
   toolbar->add_item(item);
 
+  item = mforms::manage(new ToolBarItem(mforms::ExpanderItem));
+  toolbar->add_item(item);
+
+  item = mforms::manage(new ToolBarItem(mforms::SearchFieldItem));
+  item->set_name("filter_snippets");
+  item->set_tooltip(_("Show only snippets containing the text, or of the statement type (e.g. CREATE TABLE)"));
+  scoped_connect(item->signal_activated(),
+                 std::bind(&QuerySidePalette::snippet_toolbar_item_activated, this, std::placeholders::_1));
+  toolbar->add_item(item);
+
   return toolbar;
 }
 
@@ -540,6 +550,9 @@ void QuerySidePalette::snippet_toolbar_item_activated(ToolBarItem *item) {
   if (action == "select_category") {
     _snippet_list->show_category(item->get_text());
     bec::GRTManager::get()->set_app_option("DbSqlEditor:SelectedSnippetCategory", grt::StringRef(item->get_text()));
+  } else if (action == "filter_snippets") {
+    DbSqlEditorSnippets::get_instance()->set_filter(item->get_text());
+    _snippet_list->refresh_snippets();
   } else {
     DbSqlEditorSnippets *snippets_model = DbSqlEditorSnippets::get_instance();
     snippets_model->activate_toolbar_item(bec::NodeId(_snippet_list->selected_index()), action);
@@ -43,6 +43,8 @@
 
 #include "mdc.h"
 
+#define LOAD_BATCH_SIZE 4096 // geometries parsed in parallel at a time
+
 DEFAULT_LOG_DOMAIN("spatial");
 
 class RecordsetLayer : public spatial::Layer {
@@ -65,13 +67,23 @@ public:
       ssize_t row_count = rs->row_count();
       float step = 1.0f / row_count;
 
-      for (ssize_t c = row_count, row = 0; row < c; row++) {
+      // The recordset is read here, the geometries of each batch are then parsed in parallel.
+      std::vector<int> row_ids;
+      std::vector<std::string> geometries;
+      for (ssize_t c = row_count, row = 0; row < c && !_interrupt; row++) {
         std::string geom_data; // data in MySQL internal binary geometry format.. this is neither WKT nor WKB
         // but the internal format seems to be 4 bytes of SRID followed by WKB data
-        if (rs->get_raw_field(row, _geom_column, geom_data) && !geom_data.empty())
-          add_feature((int)row, geom_data, false);
+        if (rs->get_raw_field(row, _geom_column, geom_data) && !geom_data.empty()) {
+          row_ids.push_back((int)row);
+          geometries.push_back(std::move(geom_data));
+        }
 
-        _render_progress += step;
+        if (geometries.size() >= LOAD_BATCH_SIZE || row == c - 1) {
+          add_features(row_ids, geometries, false);
+          row_ids.clear();
+          geometries.clear();
+          _render_progress = (row + 1) * step;
+        }
       }
     }
   }
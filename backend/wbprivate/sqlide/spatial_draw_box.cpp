@@ -31,9 +31,73 @@
 #include "mforms/progressbar.h"
 
 #include "base/log.h"
+#include "base/task_scheduler.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#define SPATIAL_TILE_SIZE 256              // device pixels
+#define SPATIAL_TILE_CACHE_SIZE 128        // rendered tiles kept, the least recently painted ones are dropped first
+#define SPATIAL_TILE_CHECK_INTERVAL 0.05f // seconds between repaints while tiles come in
 
 DEFAULT_LOG_DOMAIN("spatial_draw_box");
 
+// A tile covers SPATIAL_TILE_SIZE x SPATIAL_TILE_SIZE pixels of the zoomed map, starting at (x, y) * SPATIAL_TILE_SIZE.
+struct SpatialTileKey {
+  int generation;
+  float zoom;
+  int x, y;
+
+  bool operator<(const SpatialTileKey &other) const {
+    return std::tie(generation, zoom, x, y) < std::tie(other.generation, other.zoom, other.x, other.y);
+  }
+};
+
+struct SpatialTile {
+  std::shared_ptr<mdc::ImageSurface> surface; // Not set while the tile is rendered.
+  int epoch;                                  // Of the last paint that needed the tile.
+  unsigned last_used;
+
+  SpatialTile() : epoch(0), last_used(0) {
+  }
+};
+
+/**
+ * Shared with the tile tasks, which can still be queued when the draw box is gone. Every paint starts a new epoch
+ * and tiles still to be rendered that it didn't need are dropped, so a pan or zoom cancels the work for the parts
+ * of the map that can't be seen anymore. The generation changes with the contents of the layers.
+ */
+class SpatialTileCache {
+public:
+  std::mutex mutex;
+  std::condition_variable idle;
+  SpatialDrawBox *owner; // NULL once the draw box is gone.
+  std::map<SpatialTileKey, SpatialTile> tiles;
+  int generation;
+  int epoch;
+  int running;    // Tiles being rendered.
+  int suspended;  // Nesting count of suspend_tiles(), while the layers are reprojected or deleted.
+  bool finished;  // A tile was rendered since the last check_tiles().
+  unsigned clock;
+
+  SpatialTileCache(SpatialDrawBox *owner)
+    : owner(owner), generation(0), epoch(0), running(0), suspended(0), finished(false), clock(0) {
+  }
+
+  // Called with the mutex locked.
+  bool wanted(const SpatialTileKey &key) {
+    std::map<SpatialTileKey, SpatialTile>::iterator tile = tiles.find(key);
+    return owner != NULL && suspended == 0 && tile != tiles.end() && tile->second.epoch == epoch;
+  }
+};
+
+static int floor_div(int value, int divisor) {
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
 class ProgressPanel : public mforms::Box {
 public:
   ProgressPanel(const std::string &title) : mforms::Box(false), _timer(0) {
@@ -91,7 +155,7 @@ void *SpatialDrawBox::do_render_layers(void *data) {
   SpatialDrawBox *self = (SpatialDrawBox *)data;
   {
     base::MutexLock lock(self->_thread_mutex);
-    self->render(self->_needs_reprojection);
+    self->reproject_layers();
     if (!self->_quitting)
       mforms::Utilities::perform_from_main_thread(std::bind(&SpatialDrawBox::render_done, self));
     else
@@ -101,22 +165,27 @@ void *SpatialDrawBox::do_render_layers(void *data) {
   return NULL;
 }
 
-void SpatialDrawBox::render_in_thread(bool reproject) { 
+void SpatialDrawBox::render_in_thread() {
+  if (_rendering) {
+    // Started again by render_done(), so the layers are not reprojected by two threads.
+    _reproject_pending = true;
+    return;
+  }
+
   if (_renderThread != nullptr) {
-    logDebug3("Render thread didn't finish yet, waiting.\n");
+    // render_done() ran already, the thread is about to end.
     g_thread_join(_renderThread);
     _renderThread = nullptr;
   }
 
-  _needs_reprojection = reproject;
-  if (!_rendering && !_layers.empty()) {
+  if (!_layers.empty()) {
     _current_layer = NULL;
     _rendering = true;
     _progress = new ProgressPanel("Rendering spatial data, please wait.");
     _progress->start(std::bind(&SpatialDrawBox::get_progress, this, std::placeholders::_1, std::placeholders::_2),
                      0.2f);
     _renderThread = base::create_thread(do_render_layers, this);
-    work_started(_progress, reproject);
+    work_started(_progress, true);
 
     set_needs_repaint();
   }
@@ -133,10 +202,27 @@ void *SpatialDrawBox::render_done() {
 
   set_needs_repaint();
 
+  if (_reproject_pending) {
+    _reproject_pending = false;
+    render_in_thread();
+  }
+
   return NULL;
 }
 
-void SpatialDrawBox::render(bool reproject) {
+// The part of the user space that is shown in a w x h device area, so that layers only paint what can be seen.
+static base::Rect visible_user_area(mdc::CairoCtx &cr, int w, int h) {
+  double x1 = 0, y1 = 0, x2 = w, y2 = h;
+  cr.device_to_user(&x1, &y1);
+  cr.device_to_user(&x2, &y2);
+  return base::Rect(std::min(x1, x2), std::min(y1, y2), fabs(x2 - x1), fabs(y2 - y1));
+}
+
+/**
+ * Projects the layers for the visible area. Painting them is left to the tiles, which are all rendered again
+ * afterwards.
+ */
+void SpatialDrawBox::reproject_layers() {
   int width = get_width();
   int height = get_height();
 
@@ -177,55 +263,230 @@ void SpatialDrawBox::render(bool reproject) {
         new spatial::Converter(visible_area, spatial::Projection::get_instance().get_projection(spatial::ProjGeodetic),
                                spatial::Projection::get_instance().get_projection(_proj));
   } catch (std::exception &exc) {
-    logError("SpatialDrawBox::render: %s\n", exc.what());
+    logError("SpatialDrawBox::reproject_layers: %s\n", exc.what());
     return;
   }
 
   _spatial_reprojector->change_projection(visible_area, NULL,
                                           spatial::Projection::get_instance().get_projection(_proj));
 
-  // TODO lat/long ranges must be adjusted accordingly to account for the aspect ratio of the visible area
-  std::shared_ptr<mdc::ImageSurface> surface(new mdc::ImageSurface(get_width(), get_height(), CAIRO_FORMAT_ARGB32));
-  _cache = surface;
-
-  if (_ctx_cache != NULL)
-    delete _ctx_cache;
-  _ctx_cache = new mdc::CairoCtx(*surface);
-
   _current_work = "Rendering layers...";
   _current_layer = NULL;
   _current_layer_index = 0;
 
-  if (_zoom_level != 1) {
-    _ctx_cache->translate(base::Point(this->get_width() / 2.0, this->get_height() / 2.0));
-    _ctx_cache->scale(base::Point(_zoom_level, _zoom_level));
-    _ctx_cache->translate(base::Point(-this->get_width() / 2.0, -this->get_height() / 2.0));
+  suspend_tiles();
+  if (!_background_layer->hidden())
+    _background_layer->render(_spatial_reprojector);
+
+  int i = 0;
+  {
+    base::MutexLock lock(_layer_mutex);
+    for (std::deque<spatial::Layer *>::iterator it = _layers.begin(); it != _layers.end() && !_quitting; ++it, ++i) {
+      _current_work = base::strfmt("Rendering %i objects in layer %i...", (int)(*it)->size(), i + 1);
+
+      _current_layer_index = i;
+      _current_layer = *it;
+      if (!(*it)->hidden())
+        (*it)->render(_spatial_reprojector);
+    }
   }
+  resume_tiles(true);
+}
 
-  _ctx_cache->translate(base::Point(_offset_x, _offset_y));
+/**
+ * Renders one tile on a worker thread. It stops when the tile is not needed anymore, checked before each layer.
+ */
+void SpatialDrawBox::render_tile(std::shared_ptr<SpatialTileCache> cache, const SpatialTileKey &key) {
+  SpatialDrawBox *self;
+  {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (!cache->wanted(key)) {
+      std::map<SpatialTileKey, SpatialTile>::iterator tile = cache->tiles.find(key);
+      if (tile != cache->tiles.end() && !tile->second.surface)
+        cache->tiles.erase(tile);
+      return;
+    }
+    self = cache->owner;
+    ++cache->running;
+  }
 
-  _ctx_cache->set_line_width(0);
+  std::shared_ptr<mdc::ImageSurface> surface;
+  bool cancelled = false;
+  try {
+    surface.reset(new mdc::ImageSurface(SPATIAL_TILE_SIZE, SPATIAL_TILE_SIZE, CAIRO_FORMAT_ARGB32));
+    mdc::CairoCtx ctx(*surface);
+    ctx.translate(base::Point(-key.x * SPATIAL_TILE_SIZE, -key.y * SPATIAL_TILE_SIZE));
+    ctx.scale(base::Point(key.zoom, key.zoom));
+    ctx.set_line_width(0);
+    double size = SPATIAL_TILE_SIZE / key.zoom;
+    base::Rect clip_area(key.x * size, key.y * size, size, size);
+
+    std::deque<spatial::Layer *> layers;
+    {
+      base::MutexLock lock(self->_layer_mutex);
+      layers = self->_layers;
+    }
+    for (std::deque<spatial::Layer *>::iterator it = layers.begin(); it != layers.end(); ++it) {
+      {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cancelled = !cache->wanted(key);
+      }
+      if (cancelled)
+        break;
+      if (!(*it)->hidden())
+        (*it)->repaint(ctx, key.zoom, clip_area);
+    }
+  } catch (std::exception &exc) {
+    logError("Error rendering map tile: %s\n", exc.what());
+    surface.reset();
+  }
 
-  if (reproject && !_background_layer->hidden())
-    _background_layer->render(_spatial_reprojector);
+  bool again = false;
+  {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    std::map<SpatialTileKey, SpatialTile>::iterator tile = cache->tiles.find(key);
+    if (tile != cache->tiles.end() && !tile->second.surface) {
+      if (surface && !cancelled) {
+        tile->second.surface = surface;
+        cache->finished = true;
+      } else if (surface && cache->wanted(key))
+        again = true; // Needed again by a paint after it was cancelled.
+      else
+        cache->tiles.erase(tile);
+    }
+    if (--cache->running == 0)
+      cache->idle.notify_all();
+  }
 
-  int i = 0;
+  if (again)
+    base::TaskScheduler::get()->post(base::TaskInteractive, [cache, key]() { render_tile(cache, key); });
+}
 
-  base::MutexLock lock(_layer_mutex);
-  for (std::deque<spatial::Layer *>::iterator it = _layers.begin(); it != _layers.end() && !_quitting; ++it, ++i) {
-    _current_work = base::strfmt("Rendering %i objects in layer %i...", (int)(*it)->size(), i + 1);
+/**
+ * Paints the tiles that are ready and requests the missing ones, unless faded is set. That is used while the layers
+ * are reprojected, the tiles of the old projection are then painted faded.
+ */
+void SpatialDrawBox::paint_tiles(mdc::CairoCtx &cr, bool faded) {
+  base::Point shift = map_shift();
+  int first_x = floor_div(-(int)shift.x, SPATIAL_TILE_SIZE);
+  int first_y = floor_div(-(int)shift.y, SPATIAL_TILE_SIZE);
+  int last_x = floor_div(get_width() - 1 - (int)shift.x, SPATIAL_TILE_SIZE);
+  int last_y = floor_div(get_height() - 1 - (int)shift.y, SPATIAL_TILE_SIZE);
+
+  std::vector<SpatialTileKey> missing;
+  std::vector<std::pair<std::shared_ptr<mdc::ImageSurface>, base::Point> > ready;
+  {
+    std::lock_guard<std::mutex> lock(_tiles->mutex);
+    if (!faded)
+      ++_tiles->epoch;
+    unsigned now = ++_tiles->clock;
+
+    for (int y = first_y; y <= last_y; ++y) {
+      for (int x = first_x; x <= last_x; ++x) {
+        SpatialTileKey key = {_tiles->generation, _zoom_level, x, y};
+        std::map<SpatialTileKey, SpatialTile>::iterator tile = _tiles->tiles.find(key);
+        if (tile == _tiles->tiles.end()) {
+          if (faded)
+            continue;
+          tile = _tiles->tiles.insert(std::make_pair(key, SpatialTile())).first;
+          missing.push_back(key);
+        }
+        if (!faded)
+          tile->second.epoch = _tiles->epoch;
+        tile->second.last_used = now;
+        if (tile->second.surface)
+          ready.push_back(std::make_pair(tile->second.surface, base::Point(x * SPATIAL_TILE_SIZE + shift.x,
+                                                                           y * SPATIAL_TILE_SIZE + shift.y)));
+      }
+    }
 
-    _current_layer_index = i;
-    _current_layer = *it;
-    if (!(*it)->hidden()) {
-      if (reproject)
-        (*it)->render(_spatial_reprojector);
-      (*it)->repaint(*_ctx_cache, _zoom_level, base::Rect());
+    if (_tiles->tiles.size() > SPATIAL_TILE_CACHE_SIZE) {
+      std::vector<std::map<SpatialTileKey, SpatialTile>::iterator> rendered;
+      for (std::map<SpatialTileKey, SpatialTile>::iterator tile = _tiles->tiles.begin();
+           tile != _tiles->tiles.end(); ++tile)
+        if (tile->second.surface && tile->second.last_used != now)
+          rendered.push_back(tile);
+      std::sort(rendered.begin(), rendered.end(),
+                [](const std::map<SpatialTileKey, SpatialTile>::iterator &a,
+                   const std::map<SpatialTileKey, SpatialTile>::iterator &b) {
+                  return a->second.last_used < b->second.last_used;
+                });
+      for (size_t i = 0; i < rendered.size() && _tiles->tiles.size() > SPATIAL_TILE_CACHE_SIZE; ++i)
+        _tiles->tiles.erase(rendered[i]);
     }
   }
 
-  if (reproject)
-    _needs_reprojection = false;
+  cr.save();
+  for (size_t i = 0; i < ready.size(); ++i) {
+    cr.set_source_surface(ready[i].first->get_surface(), ready[i].second.x, ready[i].second.y);
+    if (faded)
+      cr.paint_with_alpha(0.4);
+    else
+      cr.paint();
+  }
+  cr.restore();
+
+  std::shared_ptr<SpatialTileCache> cache(_tiles);
+  for (std::vector<SpatialTileKey>::const_iterator key = missing.begin(); key != missing.end(); ++key) {
+    SpatialTileKey tile_key = *key;
+    base::TaskScheduler::get()->post(base::TaskInteractive, [cache, tile_key]() { render_tile(cache, tile_key); });
+  }
+  if (!missing.empty() && _tile_timer == 0)
+    _tile_timer = mforms::Utilities::add_timeout(SPATIAL_TILE_CHECK_INTERVAL,
+                                                 std::bind(&SpatialDrawBox::check_tiles, this));
+}
+
+// Repaints while tiles come in, the timer ends when no tile is rendered anymore.
+bool SpatialDrawBox::check_tiles() {
+  bool finished;
+  bool pending = false;
+  {
+    std::lock_guard<std::mutex> lock(_tiles->mutex);
+    finished = _tiles->finished;
+    _tiles->finished = false;
+    for (std::map<SpatialTileKey, SpatialTile>::const_iterator tile = _tiles->tiles.begin();
+         tile != _tiles->tiles.end() && !pending; ++tile)
+      pending = !tile->second.surface;
+  }
+
+  if (finished)
+    set_needs_repaint();
+  if (!pending)
+    _tile_timer = 0;
+  return pending;
+}
+
+// Waits for the tiles being rendered, no new ones are started until the matching resume_tiles().
+// Calls nest, e.g. clear() or remove_layer() while the layers are reprojected in the rendering thread.
+void SpatialDrawBox::suspend_tiles() {
+  std::unique_lock<std::mutex> lock(_tiles->mutex);
+  ++_tiles->suspended;
+  _tiles->idle.wait(lock, [this]() { return _tiles->running == 0; });
+}
+
+void SpatialDrawBox::resume_tiles(bool new_generation) {
+  std::lock_guard<std::mutex> lock(_tiles->mutex);
+  if (_tiles->suspended > 0)
+    --_tiles->suspended;
+  if (new_generation)
+    discard_tiles();
+}
+
+// Drops the tiles painted from the previous layer contents. Called with the mutex locked.
+void SpatialDrawBox::discard_tiles() {
+  ++_tiles->generation;
+  for (std::map<SpatialTileKey, SpatialTile>::iterator tile = _tiles->tiles.begin(); tile != _tiles->tiles.end();)
+    if (tile->first.generation != _tiles->generation)
+      _tiles->tiles.erase(tile++);
+    else
+      ++tile;
+}
+
+// Where the origin of the zoomed map is on the screen, whole pixels so tiles are painted without resampling.
+base::Point SpatialDrawBox::map_shift() const {
+  double center_x = get_width() / 2.0, center_y = get_height() / 2.0;
+  return base::Point(floor(_zoom_level * (_offset_x - center_x) + center_x + 0.5),
+                     floor(_zoom_level * (_offset_y - center_y) + center_y + 0.5));
 }
 
 bool SpatialDrawBox::get_progress(std::string &action, float &pct) {
@@ -248,7 +509,7 @@ SpatialDrawBox::SpatialDrawBox()
   : _background_layer(NULL),
     _last_autozoom_layer(0),
     _proj(spatial::ProjRobinson),
-    _ctx_cache(NULL),
+    _tile_timer(0),
     _spatial_reprojector(NULL),
     _zoom_level(1.0),
     _offset_x(0),
@@ -257,7 +518,7 @@ SpatialDrawBox::SpatialDrawBox()
     _dragging(false),
     _rendering(false),
     _quitting(false),
-    _needs_reprojection(true),
+    _reproject_pending(false),
     _select_pending(false),
     _selecting(false) {
   _displaying_restricted = false;
@@ -269,10 +530,19 @@ SpatialDrawBox::SpatialDrawBox()
   _current_layer = NULL;
   _progress = NULL;
   _renderThread = nullptr;
+  _tiles.reset(new SpatialTileCache(this));
 }
 
 SpatialDrawBox::~SpatialDrawBox() {
   _quitting = true;
+  if (_tile_timer != 0)
+    mforms::Utilities::cancel_timeout(_tile_timer);
+  {
+    // Queued tile tasks find no owner anymore, running ones are waited for.
+    std::unique_lock<std::mutex> lock(_tiles->mutex);
+    _tiles->owner = NULL;
+    _tiles->idle.wait(lock, [this]() { return _tiles->running == 0; });
+  }
   if (_renderThread != nullptr) {
     logDebug3("Waiting for render thread to finish.\n");
     g_thread_join(_renderThread);
@@ -282,8 +552,6 @@ SpatialDrawBox::~SpatialDrawBox() {
   // lock the mutex, so that if the worker is still busy, we'll wait for it
 
   base::MutexLock lock(_thread_mutex);
-  delete _ctx_cache;
-  _ctx_cache = NULL;
 }
 
 void SpatialDrawBox::set_projection(spatial::ProjectionType proj) {
@@ -310,12 +578,15 @@ void SpatialDrawBox::zoom_out() {
     _offset_y = 0;
     reproject = true;
   }
-  invalidate(reproject);
+  if (reproject)
+    invalidate(true);
+  else
+    set_needs_repaint();
 }
 
 void SpatialDrawBox::zoom_in() {
   _zoom_level += 0.2f;
-  invalidate();
+  set_needs_repaint();
 }
 
 void SpatialDrawBox::auto_zoom(spatial::LayerId layer_id) {
@@ -367,7 +638,7 @@ void SpatialDrawBox::auto_zoom(spatial::LayerId layer_id) {
 
 void SpatialDrawBox::center_on(double lat, double lon) {
   // XXX
-  invalidate();
+  set_needs_repaint();
 }
 
 void SpatialDrawBox::reset_view() {
@@ -385,7 +656,10 @@ void SpatialDrawBox::reset_view() {
   while (!_hw_zoom_history.empty())
     _hw_zoom_history.pop();
 
-  invalidate(_displaying_restricted);
+  if (_displaying_restricted)
+    invalidate(true);
+  else
+    set_needs_repaint();
   _displaying_restricted = false;
 }
 
@@ -398,21 +672,25 @@ void SpatialDrawBox::select_area(bool flag) {
 }
 
 void SpatialDrawBox::clear() {
-  delete _background_layer;
-  _background_layer = NULL;
-
   for (std::deque<spatial::Layer *>::iterator i = _layers.begin(); i != _layers.end(); ++i)
     (*i)->interrupt();
+  suspend_tiles();
 
-  base::MutexLock lock(_layer_mutex);
-  for (std::deque<spatial::Layer *>::iterator i = _layers.begin(); i != _layers.end(); ++i)
-    delete *i;
-  _layers.clear();
-  if (_spatial_reprojector) {
-    _spatial_reprojector->interrupt();
-    delete _spatial_reprojector;
-    _spatial_reprojector = NULL;
+  delete _background_layer;
+  _background_layer = NULL;
+
+  {
+    base::MutexLock lock(_layer_mutex);
+    for (std::deque<spatial::Layer *>::iterator i = _layers.begin(); i != _layers.end(); ++i)
+      delete *i;
+    _layers.clear();
+    if (_spatial_reprojector) {
+      _spatial_reprojector->interrupt();
+      delete _spatial_reprojector;
+      _spatial_reprojector = NULL;
+    }
   }
+  resume_tiles(true);
 }
 
 void SpatialDrawBox::set_background(spatial::Layer *layer) {
@@ -432,11 +710,16 @@ void SpatialDrawBox::add_layer(spatial::Layer *layer) {
 }
 
 void SpatialDrawBox::remove_layer(spatial::Layer *layer) {
-  base::MutexLock lock(_layer_mutex);
+  // The caller deletes the layer, no tile may still paint it.
   layer->interrupt();
-  std::deque<spatial::Layer *>::iterator l = std::find(_layers.begin(), _layers.end(), layer);
-  if (l != _layers.end())
-    _layers.erase(l);
+  suspend_tiles();
+  {
+    base::MutexLock lock(_layer_mutex);
+    std::deque<spatial::Layer *>::iterator l = std::find(_layers.begin(), _layers.end(), layer);
+    if (l != _layers.end())
+      _layers.erase(l);
+  }
+  resume_tiles(true);
 }
 
 void SpatialDrawBox::change_layer_order(const std::vector<spatial::LayerId> &order) {
@@ -488,9 +771,15 @@ void SpatialDrawBox::activate() {
   }
 }
 
+// Called when the layers changed. Only a new projection or visible area needs them reprojected, otherwise
+// painting them again in new tiles is enough.
 void SpatialDrawBox::invalidate(bool reproject) {
-  if (_ready)
-    render_in_thread(reproject);
+  if (_ready && reproject)
+    render_in_thread();
+  else if (!_rendering) {
+    std::lock_guard<std::mutex> lock(_tiles->mutex);
+    discard_tiles();
+  }
   set_needs_repaint(); // repaint the grid
 }
 
@@ -501,7 +790,6 @@ bool SpatialDrawBox::mouse_double_click(mforms::MouseButton button, int x, int y
   _offset_x = (int)(_initial_offset_x - (x - dx) / _zoom_level);
   _offset_y = (int)(_initial_offset_y - (y - dy) / _zoom_level);
   _dragging = false;
-  invalidate();
   zoom_in();
 
   return false;
@@ -538,10 +826,8 @@ bool SpatialDrawBox::mouse_up(mforms::MouseButton button, int x, int y) {
       // handle feature click
       if (position_clicked_cb)
         position_clicked_cb(base::Point(x, y));
-    } else {
+    } else
       mouse_move(button, x, y);
-      invalidate();
-    }
     _dragging = false;
   } else if (button == mforms::MouseButtonLeft && _selecting) {
     restrict_displayed_area(_drag_x, _drag_y, x, y);
@@ -626,33 +912,40 @@ void SpatialDrawBox::restrict_displayed_area(int x1, int y1, int x2, int y2, boo
 }
 
 void SpatialDrawBox::repaint(cairo_t *crt, int x, int y, int w, int h) {
-  std::shared_ptr<mdc::Surface> cache(_cache);
+  paint(crt, false);
+}
+
+/**
+ * With complete set the layers are painted directly, as the tiles might not all be rendered yet. While the layers
+ * are reprojected the old tiles are painted faded instead.
+ */
+void SpatialDrawBox::paint(cairo_t *crt, bool complete) {
   mdc::CairoCtx cr(crt);
-  if (cache) {
-    cr.set_color(_background_layer && _background_layer->fill() ? _background_layer->color() : base::Color(1, 1, 1));
-    cr.paint();
-    cr.set_source_surface(cache->get_surface(), 0, 0);
-    if (_rendering) // if we're currently re-rendering the image, we paint the old version half transparent
-      cr.paint_with_alpha(0.4);
-    else
-      cr.paint();
-  } else if (!_progress) {
-    cr.set_color(_background_layer && _background_layer->fill() ? _background_layer->color() : base::Color(1, 1, 1));
-    cr.paint();
-  }
+  cr.set_color(_background_layer && _background_layer->fill() ? _background_layer->color() : base::Color(1, 1, 1));
+  cr.paint();
 
-  if (_background_layer && !_background_layer->hidden()) {
+  if (complete && !_rendering) {
     cr.save();
-    if (_zoom_level != 1) {
-      cr.translate(base::Point(this->get_width() / 2, this->get_height() / 2));
-      cr.scale(base::Point(_zoom_level, _zoom_level));
-      cr.translate(base::Point(-this->get_width() / 2, -this->get_height() / 2));
-    }
+    cr.translate(map_shift());
+    cr.scale(base::Point(_zoom_level, _zoom_level));
+    cr.set_line_width(0);
+    base::Rect visible_area = visible_user_area(cr, get_width(), get_height());
+
+    base::MutexLock lock(_layer_mutex);
+    for (std::deque<spatial::Layer *>::iterator it = _layers.begin(); it != _layers.end(); ++it)
+      if (!(*it)->hidden())
+        (*it)->repaint(cr, _zoom_level, visible_area);
+    cr.restore();
+  } else if (!_layers.empty())
+    paint_tiles(cr, _rendering);
 
-    cr.translate(base::Point(_offset_x, _offset_y));
+  if (_background_layer && !_background_layer->hidden()) {
+    cr.save();
+    cr.translate(map_shift());
+    cr.scale(base::Point(_zoom_level, _zoom_level));
 
     cr.set_line_width(0);
-    _background_layer->repaint(cr, _zoom_level, base::Rect());
+    _background_layer->repaint(cr, _zoom_level, visible_user_area(cr, get_width(), get_height()));
     cr.restore();
   }
 
@@ -705,7 +998,7 @@ void SpatialDrawBox::world_to_screen(const double &lat, const double &lon, int &
 void SpatialDrawBox::save_to_png(const std::string &destination) {
   std::shared_ptr<mdc::ImageSurface> surface(new mdc::ImageSurface(get_width(), get_height(), CAIRO_FORMAT_ARGB32));
   mdc::CairoCtx ctx(*surface);
-  this->repaint(ctx.get_cr(), 0, 0, get_width(), get_height());
+  paint(ctx.get_cr(), true);
   surface->save_to_png(destination);
 }
 
@@ -714,16 +1007,15 @@ void SpatialDrawBox::clear_pins() {
   set_needs_repaint();
 }
 
+// The transformations the map is painted with, see map_shift().
 base::Point SpatialDrawBox::unapply_cairo_transformation(const base::Point &p) const {
-  double xx = p.x, yy = p.y;
-  _ctx_cache->user_to_device(&xx, &yy);
-  return base::Point(xx, yy);
+  base::Point shift = map_shift();
+  return base::Point(p.x * _zoom_level + shift.x, p.y * _zoom_level + shift.y);
 }
 
 base::Point SpatialDrawBox::apply_cairo_transformation(const base::Point &p) const {
-  double xx = p.x, yy = p.y;
-  _ctx_cache->device_to_user(&xx, &yy);
-  return base::Point(xx, yy);
+  base::Point shift = map_shift();
+  return base::Point((p.x - shift.x) / _zoom_level, (p.y - shift.y) / _zoom_level);
 }
 
 void SpatialDrawBox::place_pin(cairo_surface_t *pin, const base::Point &p) {
@@ -36,6 +36,8 @@ namespace mforms {
 };
 
 class ProgressPanel;
+class SpatialTileCache;
+struct SpatialTileKey;
 
 class SpatialDrawBox : public mforms::DrawBox {
   base::Mutex _layer_mutex;
@@ -43,8 +45,9 @@ class SpatialDrawBox : public mforms::DrawBox {
   std::deque<spatial::Layer *> _layers;
   spatial::LayerId _last_autozoom_layer;
   spatial::ProjectionType _proj;
-  std::shared_ptr<mdc::Surface> _cache;
-  mdc::CairoCtx *_ctx_cache;
+  // Rendered layers, in tiles of the zoomed map. Panning only paints them at another place.
+  std::shared_ptr<SpatialTileCache> _tiles;
+  mforms::TimeoutHandle _tile_timer;
   base::Mutex _thread_mutex;
   spatial::Converter *_spatial_reprojector;
 
@@ -88,7 +91,7 @@ class SpatialDrawBox : public mforms::DrawBox {
 
   bool _rendering;
   bool _quitting;
-  bool _needs_reprojection;
+  bool _reproject_pending; // Requested while the layers were being reprojected.
   bool _select_pending;
   bool _selecting;
   bool _displaying_restricted;
@@ -103,13 +106,22 @@ class SpatialDrawBox : public mforms::DrawBox {
 
   static void *do_render_layers(void *data);
 
-  void render_in_thread(bool reproject);
+  void render_in_thread();
 
   void *render_done();
 
-  void render(bool reproject = false);
+  void reproject_layers();
   bool get_progress(std::string &action, float &pct);
 
+  static void render_tile(std::shared_ptr<SpatialTileCache> cache, const SpatialTileKey &key);
+  void paint_tiles(mdc::CairoCtx &cr, bool faded);
+  bool check_tiles();
+  void suspend_tiles();
+  void resume_tiles(bool new_generation);
+  void discard_tiles();
+  base::Point map_shift() const;
+  void paint(cairo_t *crt, bool complete);
+
   void restrict_displayed_area(int x1, int y1, int x2, int y2, bool no_invalidate = false);
 
 public:
@@ -4669,4 +4669,115 @@ TEST_FUNCTION(36) {
   deleg_filtered->check_and_reset("TF036CHK001");
 }
 
+// Tests the deferred node creation for large collections
+TEST_FUNCTION(37) {
+  _tester.enable_events(true);
+
+  base::StringListPtr schemas(new std::list<std::string>());
+  schemas->push_back("big_schema");
+  _lst.update_schemata(schemas);
+  mforms::TreeNodeRef schema = _lst.get_node_for_object("big_schema", LiveSchemaTree::Schema, "");
+
+  deleg->expect_fetch_schema_contents_call();
+  for (int index = 0; index < 2000; index++) {
+    deleg->_mock_table_list->push_back(base::strfmt("table%04d", index));
+    deleg->_mock_view_list->push_back(base::strfmt("view%04d", index));
+  }
+  deleg->_mock_procedure_list->push_back("procedure1");
+  deleg->_mock_call_back_slot = true;
+  deleg->_mock_schema_name = "big_schema";
+  deleg->_check_id = "TF037CHK001";
+  _tester.load_schema_content(schema);
+  deleg->check_and_reset("TF037CHK001");
+
+  mforms::TreeNodeRef tables = schema->get_child(LiveSchemaTree::TABLES_NODE_INDEX);
+  mforms::TreeNodeRef views = schema->get_child(LiveSchemaTree::VIEWS_NODE_INDEX);
+  ensure_equals("TF037CHK002: Unexpected table node count", tables->count(), 1);
+  ensure_equals("TF037CHK002: Unexpected view node count", views->count(), 1);
+  ensure_equals("TF037CHK002: Unexpected procedure node count",
+                schema->get_child(LiveSchemaTree::PROCEDURES_NODE_INDEX)->count(), 1);
+
+  // Looking for an unknown object doesn't create the nodes.
+  mforms::TreeNodeRef node = _lst.get_node_for_object("big_schema", LiveSchemaTree::Table, "table9999");
+  ensure("TF037CHK003: Unexpected table found", node.ptr() == NULL);
+  ensure_equals("TF037CHK003: Unexpected table node count", tables->count(), 1);
+
+  // Looking for a known object does.
+  node = _lst.get_node_for_object("big_schema", LiveSchemaTree::Table, "table1234");
+  ensure("TF037CHK004: Expected table not found", node.ptr() != NULL);
+  ensure_equals("TF037CHK004: Unexpected table name", node->get_string(0), "table1234");
+  ensure_equals("TF037CHK004: Unexpected table node count", tables->count(), 2000);
+  ensure("TF037CHK004: Missing table data", dynamic_cast<LiveSchemaTree::TableData*>(node->get_data()) != NULL);
+
+  // Expanding the collection creates them too.
+  views->expand();
+  _tester.expand_toggled(views, true);
+  ensure_equals("TF037CHK005: Unexpected view node count", views->count(), 2000);
+  ensure_equals("TF037CHK005: Unexpected first view", views->get_child(0)->get_string(0), "view0000");
+  ensure_equals("TF037CHK005: Unexpected last view", views->get_child(1999)->get_string(0), "view1999");
+
+  pmodel_view->root_node()->remove_children();
+}
+
+// Tests narrowing the filtered tree while the filter is being typed
+TEST_FUNCTION(38) {
+  std::vector<std::string> schemas;
+  std::vector<std::string> tables;
+  std::vector<std::string> views;
+  std::vector<std::string> procedures;
+  std::vector<std::string> functions;
+
+  fill_complex_schema("TF038CHK001");
+  _lst_filtered.set_base(&_lst);
+
+  schemas.push_back("basic_schema");
+  schemas.push_back("basic_training");
+  tables.push_back("store");
+  views.push_back("second_view");
+  views.push_back("secure_view");
+  _lst_filtered.set_filter("basic*.s");
+  _lst_filtered.filter_data();
+  verify_filter_result("TF038CHK002", pmodel_view_filtered->root_node(), schemas, tables, views, procedures, functions);
+
+  // Extending the filter only removes nodes.
+  mforms::TreeNodeRef schema_node = pmodel_view_filtered->root_node()->get_child(0);
+  tables.clear();
+  _lst_filtered.set_filter("basic*.se");
+  _lst_filtered.filter_data();
+  verify_filter_result("TF038CHK003", pmodel_view_filtered->root_node(), schemas, tables, views, procedures, functions);
+  ensure("TF038CHK003: Schema node was recreated", pmodel_view_filtered->root_node()->get_child(0) == schema_node);
+
+  views.clear();
+  views.push_back("secure_view");
+  _lst_filtered.set_filter("basic*.sec");
+  _lst_filtered.filter_data();
+  verify_filter_result("TF038CHK004", pmodel_view_filtered->root_node(), schemas, tables, views, procedures, functions);
+
+  // Any other change rebuilds the filtered tree.
+  schemas.clear();
+  schemas.push_back("basic_schema");
+  tables.clear();
+  tables.push_back("client");
+  tables.push_back("customer");
+  tables.push_back("product");
+  tables.push_back("store");
+  views.clear();
+  views.push_back("first_view");
+  views.push_back("second_view");
+  views.push_back("secure_view");
+  views.push_back("third");
+  procedures.push_back("get_debths");
+  procedures.push_back("get_lazy");
+  procedures.push_back("get_payments");
+  functions.push_back("calc_debth_list");
+  functions.push_back("calc_income");
+  functions.push_back("dummy");
+  _lst_filtered.set_filter("basic_s");
+  _lst_filtered.filter_data();
+  verify_filter_result("TF038CHK005", pmodel_view_filtered->root_node(), schemas, tables, views, procedures, functions);
+
+  pmodel_view->root_node()->remove_children();
+  pmodel_view_filtered->root_node()->remove_children();
+}
+
 END_TESTS
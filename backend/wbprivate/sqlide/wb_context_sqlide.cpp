@@ -206,6 +206,26 @@ public:
       ref->exec_management_sql(sql, log);
   }
 
+  virtual grt::DictRef importTableData(const grt::DictRef &options) {
+    std::shared_ptr<SqlEditorForm> ref(_editor);
+    if (ref)
+      return ref->import_table_data(options);
+    return grt::DictRef();
+  }
+
+  virtual grt::DictListRef queryStatistics(const std::string &order, ssize_t limit) {
+    std::shared_ptr<SqlEditorForm> ref(_editor);
+    if (ref)
+      return ref->query_statistics(order, limit);
+    return grt::DictListRef();
+  }
+
+  virtual void clearQueryStatistics() {
+    std::shared_ptr<SqlEditorForm> ref(_editor);
+    if (ref)
+      ref->clear_query_statistics();
+  }
+
   virtual db_query_ResultsetRef executeQuery(const std::string &sql, bool log) {
     std::shared_ptr<SqlEditorForm> ref(_editor);
     if (ref) {
@@ -752,6 +772,10 @@ void WBContextSQLIDE::init() {
   cmdui->add_builtin_command("query.revert", std::bind(call_revert, this), std::bind(validate_revert, this));
 
   cmdui->add_builtin_command("query.export", std::bind(call_export, this), std::bind(validate_export, this));
+  cmdui->add_builtin_command("query.exportStatementToFile",
+                             std::bind(&WBContextSQLIDE::call_in_editor, this,
+                                       &SqlEditorForm::export_current_statement_to_file),
+                             std::bind(validate_exec_sql, this));
 
   cmdui->add_builtin_command("query.cancel",
                              std::bind(&WBContextSQLIDE::call_in_editor, this, &SqlEditorForm::cancel_query));
@@ -854,6 +878,9 @@ static bool cancel_connect_editor(SqlEditorForm::Ref editor) {
 }
 
 SqlEditorForm::Ref WBContextSQLIDE::create_connected_editor(const db_mgmt_ConnectionRef &conn) {
+  // Module initializers register the observers for new editors.
+  WBContextUI::get()->get_wb()->finish_deferred_init();
+
   // start by opening the tunnel, if needed
   std::shared_ptr<sql::TunnelConnection> tunnel;
 
@@ -430,7 +430,10 @@ LiveSchemaTree::LiveSchemaTree()
     _base(0),
     _filter_type(Any),
     _schema_pattern(0),
-    _object_pattern(0) {
+    _object_pattern(0),
+    _content_revision(0),
+    _filtered_revision(0),
+    _narrow_filter(false) {
   fill_node_icons();
 
   // Setup the schema node collection skeleton
@@ -529,7 +532,7 @@ void LiveSchemaTree::set_case_sensitive_identifiers(bool flag) {
 }
 
 bool LiveSchemaTree::identifiers_equal(const std::string& a, const std::string& b) {
-  return base::string_compare(a, b, _case_sensitive_identifiers) == 0;
+  return base::same_string(a, b, _case_sensitive_identifiers);
 }
 
 void LiveSchemaTree::setup_node(mforms::TreeNodeRef node, ObjectType type, mforms::TreeNodeData* pdata,
@@ -788,6 +791,8 @@ bool LiveSchemaTree::update_node_children(mforms::TreeNodeRef parent, base::Stri
     bool removed = false;
     std::vector<mforms::TreeNodeRef> childs_to_remove;
 
+    create_pending_nodes(parent);
+
     //_model_view->freeze_refresh(); cannot be called from a background thread.
 
     // Calculates the nodes to be removed and the new nodes to be created
@@ -876,6 +881,8 @@ bool LiveSchemaTree::update_node_children(mforms::TreeNodeRef parent, base::Stri
     }
 
     ret_val = (added || removed);
+    if (ret_val)
+      _content_revision++;
 
     std::string icon = get_node_icon_path(type);
 
@@ -899,7 +906,11 @@ std::string LiveSchemaTree::get_field_description(const mforms::TreeNodeRef& nod
         if (is_object_type(TableOrView, type)) {
           short fetch_mask = (type == Table) ? COLUMN_DATA | INDEX_DATA : COLUMN_DATA;
 
-          load_table_details(type, get_schema_name(node), temp_node->get_string(0), fetch_mask);
+          mforms::TreeNodeRef object_node = get_node_for_object(get_schema_name(node), type, temp_node->get_string(0));
+          if (object_node)
+            load_table_details_with_siblings(object_node, fetch_mask);
+          else
+            load_table_details(type, get_schema_name(node), temp_node->get_string(0), fetch_mask);
         } else if (is_object_type(RoutineObject, type)) {
           load_routine_details(temp_node);
         }
@@ -975,6 +986,7 @@ void LiveSchemaTree::set_active_schema(const std::string& schema) {
 
 void LiveSchemaTree::update_live_object_state(ObjectType type, const std::string& schema_name,
                                               const std::string& old_obj_name, const std::string& new_obj_name) {
+  _content_revision++;
   if (_model_view) {
     mforms::TreeNodeRef schema_node;
     bool created = old_obj_name.empty() && !new_obj_name.empty();
@@ -1066,6 +1078,7 @@ void LiveSchemaTree::schema_contents_arrived(const std::string& schema_name, bas
                                              base::StringListPtr functions, bool just_append) {
   if (_base) {
     _base->schema_contents_arrived(schema_name, tables, views, procedures, functions, just_append);
+    _narrow_filter = false;
     filter_data();
   } else {
     if (_model_view) {
@@ -1086,17 +1099,20 @@ void LiveSchemaTree::schema_contents_arrived(const std::string& schema_name, bas
 
           // We need to duplicate the data, because it's being changed inside update_node_children
           // and we can't do this because it's shared between threads
-          update_node_children(tables_node, std::make_shared<StringList>(*tables), Table, true, just_append);
-          update_node_children(views_node, std::make_shared<StringList>(*views), View, true, just_append);
-          update_node_children(procedures_node, std::make_shared<StringList>(*procedures), Procedure, true,
-                               just_append);
-          update_node_children(functions_node, std::make_shared<StringList>(*functions), Function, true, just_append);
+          update_collection_children(tables_node, std::make_shared<StringList>(*tables), Table, just_append);
+          update_collection_children(views_node, std::make_shared<StringList>(*views), View, just_append);
+          update_collection_children(procedures_node, std::make_shared<StringList>(*procedures), Procedure,
+                                     just_append);
+          update_collection_children(functions_node, std::make_shared<StringList>(*functions), Function, just_append);
 
           // If there were nodes that means this is a refresh, in such case loaded tables
-          // must be reloaded so the changes are displayed
+          // must be reloaded so the changes are displayed (except those the delegate knows are unchanged)
           if (old_table_count) {
+            std::shared_ptr<FetchDelegate> delegate = _fetch_delegate.lock();
             for (std::size_t index = 0; index < (std::size_t)tables_node->count(); index++) {
               mforms::TreeNodeRef pnode = tables_node->get_child((int)index);
+              if (delegate && delegate->is_object_unchanged(schema_name, pnode->get_string(0)))
+                continue;
               reload_object_data(pnode);
             }
           }
@@ -1171,6 +1187,58 @@ void LiveSchemaTree::load_table_details(mforms::TreeNodeRef& node, int fetch_mas
   }
 }
 
+/**
+ * Same as load_table_details, but also loads the same details for the following siblings of the node which
+ * don't have them yet. Used when showing object info, so that moving through a list of tables doesn't
+ * cost a server round trip for each object.
+ */
+void LiveSchemaTree::load_table_details_with_siblings(mforms::TreeNodeRef& node, int fetch_mask) {
+  static const int PREFETCH_LIMIT = 50;
+
+  ViewData* pdata = dynamic_cast<ViewData*>(node->get_data());
+  mforms::TreeNodeRef parent = node->get_parent();
+  std::shared_ptr<FetchDelegate> delegate = _fetch_delegate.lock();
+  if (!pdata || !parent || !delegate) {
+    load_table_details(node, fetch_mask);
+    return;
+  }
+
+  // Same computation as in load_table_details.
+  short data_load_flags = (fetch_mask ^ pdata->get_loaded_mask()) & fetch_mask;
+  data_load_flags = (data_load_flags ^ pdata->get_loading_mask()) & data_load_flags;
+  if (data_load_flags == 0)
+    return;
+
+  // Collect siblings which need exactly the same data.
+  std::vector<std::string> names;
+  for (int index = parent->get_child_index(node); index >= 0 && index < parent->count(); ++index) {
+    mforms::TreeNodeRef sibling = parent->get_child(index);
+    ViewData* sibling_data = dynamic_cast<ViewData*>(sibling->get_data());
+    if (sibling_data == nullptr || sibling_data->get_type() != pdata->get_type())
+      continue;
+
+    short sibling_flags = (fetch_mask ^ sibling_data->get_loaded_mask()) & fetch_mask;
+    sibling_flags = (sibling_flags ^ sibling_data->get_loading_mask()) & sibling_flags;
+    if (sibling_flags != data_load_flags)
+      continue;
+
+    sibling_data->set_loading_mask(data_load_flags);
+    names.push_back(sibling->get_string(0));
+    if ((int)names.size() == PREFETCH_LIMIT)
+      break;
+  }
+
+  if (names.empty()) {
+    load_table_details(node, fetch_mask);
+    return;
+  }
+
+  delegate->fetch_objects_details(
+    get_schema_name(node), names, pdata->get_type(), data_load_flags,
+    std::bind(&LiveSchemaTree::update_node_children, this, std::placeholders::_1, std::placeholders::_2,
+              std::placeholders::_3, std::placeholders::_4, std::placeholders::_5));
+}
+
 void LiveSchemaTree::fetch_table_details(ObjectType object_type, const std::string schema_name,
                                          const std::string object_name, int fetch_mask) {
   std::shared_ptr<FetchDelegate> delegate = _fetch_delegate.lock();
@@ -1211,12 +1279,14 @@ void LiveSchemaTree::load_data_for_filter(const std::string& schema_filter, cons
   }
 }
 
-void LiveSchemaTree::load_schema_content(mforms::TreeNodeRef& schema_node) {
+/**
+ * Marks the given schema node as being fetched. Returns false if there's nothing to do.
+ */
+bool LiveSchemaTree::prepare_schema_content_fetch(mforms::TreeNodeRef& schema_node) {
   SchemaData* data = dynamic_cast<SchemaData*>(schema_node->get_data());
 
   if (!data->fetched && !data->fetching) {
     data->fetching = true;
-    std::string name = schema_node->get_string(0);
 
     if (_base) {
       mforms::TreeNodeRef base_schema_node = _base->get_node_from_path(get_node_path(schema_node));
@@ -1233,11 +1303,18 @@ void LiveSchemaTree::load_schema_content(mforms::TreeNodeRef& schema_node) {
     schema_node->get_child(FUNCTIONS_NODE_INDEX)->set_string(0, FUNCTIONS_CAPTION + " " + FETCHING_CAPTION);
 
     update_node_icon(schema_node);
+    return true;
+  }
+  return false;
+}
 
+void LiveSchemaTree::load_schema_content(mforms::TreeNodeRef& schema_node) {
+  if (prepare_schema_content_fetch(schema_node)) {
     if (std::shared_ptr<FetchDelegate> delegate = _fetch_delegate.lock()) {
       delegate->fetch_schema_contents(
-        name, std::bind(&LiveSchemaTree::schema_contents_arrived, this, std::placeholders::_1, std::placeholders::_2,
-                        std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+        schema_node->get_string(0),
+        std::bind(&LiveSchemaTree::schema_contents_arrived, this, std::placeholders::_1, std::placeholders::_2,
+                  std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
     }
   }
 }
@@ -1658,6 +1735,7 @@ void LiveSchemaTree::is_schema_contents_enabled(bool value) {
 
 void LiveSchemaTree::set_no_connection() {
   _model_view->clear();
+  _content_revision++;
   mforms::TreeNodeRef node = _model_view->add_node();
   node->set_string(0, "Not connected");
 }
@@ -1701,21 +1779,86 @@ std::string LiveSchemaTree::get_filter_wildcard(const std::string& filter, Filte
 void LiveSchemaTree::filter_data() {
   _enabled_events = false;
 
-  // Removes all the objects on the target tree
-  _model_view->clear();
+  // While the user keeps typing the filter, the previous results only need to be reduced.
+  // That is, unless the base tree changed since then.
+  if (_narrow_filter && _filtered_revision == _base->_content_revision)
+    narrow_filtered_data();
+  else {
+    // Removes all the objects on the target tree
+    _model_view->clear();
+    _pending_nodes.clear();
 
-  mforms::TreeNodeRef base_root = _base->_model_view->root_node();
-  mforms::TreeNodeRef this_root = _model_view->root_node();
-  filter_children(Schema, base_root, this_root, _schema_pattern);
+    mforms::TreeNodeRef base_root = _base->_model_view->root_node();
+    mforms::TreeNodeRef this_root = _model_view->root_node();
+    filter_children(Schema, base_root, this_root, _schema_pattern);
+    _filtered_revision = _base->_content_revision;
 
-  // To keep the active schema on the filtered tree
-  set_active_schema(_base->_active_schema);
+    // To keep the active schema on the filtered tree
+    set_active_schema(_base->_active_schema);
+  }
+  _narrow_filter = false;
 
   _enabled_events = true;
 }
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Removes the nodes that don't match the current filter from the filtered tree. Used instead of a rebuild
+ * when the filter got more specific.
+ */
+void LiveSchemaTree::narrow_filtered_data() {
+  mforms::TreeNodeRef root = _model_view->root_node();
+  for (int index = root->count() - 1; index >= 0; index--) {
+    mforms::TreeNodeRef schema_node = root->get_child(index);
+    if (_schema_pattern && !g_pattern_match_string(_schema_pattern, base::toupper(schema_node->get_string(0)).c_str())) {
+      schema_node->remove_from_parent();
+      continue;
+    }
+
+    if (_object_pattern) {
+      bool found = false;
+      for (int collection_index = TABLES_NODE_INDEX; collection_index <= FUNCTIONS_NODE_INDEX; collection_index++) {
+        if (narrow_filtered_collection(schema_node->get_child(collection_index)))
+          found = true;
+      }
+
+      if (!found)
+        schema_node->remove_from_parent();
+    }
+  }
+}
+
+/**
+ * Removes the objects not matching the object filter from a schema collection of the filtered tree.
+ * Returns true if there are objects left.
+ */
+bool LiveSchemaTree::narrow_filtered_collection(mforms::TreeNodeRef collection) {
+  base::StringListPtr pending = get_pending_nodes(collection);
+  if (pending) {
+    pending->remove_if([this](const std::string& name) {
+      return !g_pattern_match_string(_object_pattern, base::toupper(name).c_str());
+    });
+
+    if (!pending->empty())
+      return true;
+
+    _pending_nodes.erase(std::make_pair(collection->get_parent()->get_string(0), get_collection_child_type(collection)));
+    collection->remove_children();
+    return false;
+  }
+
+  for (int index = collection->count() - 1; index >= 0; index--) {
+    mforms::TreeNodeRef node = collection->get_child(index);
+    if (!g_pattern_match_string(_object_pattern, base::toupper(node->get_string(0)).c_str()))
+      node->remove_from_parent();
+  }
+
+  return collection->count() > 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 /*
 *  filter_children_collection: will trigger a children copy for the collection nodes of the given source
 *                              right now the pattern is only used for nodes on schema collections
@@ -1785,6 +1928,22 @@ bool LiveSchemaTree::filter_children(ObjectType type, mforms::TreeNodeRef& sourc
   // Clears the collection...
   target->remove_children();
 
+  // Deferred collections of the base tree are matched by name, the nodes are created when the target is expanded.
+  if (_base && is_object_type(SchemaObject, type)) {
+    base::StringListPtr pending = _base->get_pending_nodes(source);
+    if (pending) {
+      base::StringListPtr matches(new base::StringList());
+      for (auto& name : *pending) {
+        if (!validate || g_pattern_match_string(pattern, base::toupper(name).c_str()))
+          matches->push_back(name);
+      }
+
+      if (!matches->empty())
+        set_pending_nodes(target, type, matches);
+      return !matches->empty();
+    }
+  }
+
   int count = source->count();
   for (int index = 0; index < count; index++) {
     mforms::TreeNodeRef source_node = source->get_child(index);
@@ -1834,6 +1993,10 @@ void LiveSchemaTree::clean_filter() {
 }
 
 void LiveSchemaTree::set_filter(std::string filter) {
+  // A filter that starts with the previous one can only match a subset of what the previous one matched
+  // (a wildcard is always appended to both parts).
+  _narrow_filter = !_filter.empty() && base::hasPrefix(filter, _filter);
+
   // Cleans the previous filter if any...
   clean_filter();
 
@@ -1912,6 +2075,24 @@ mforms::TreeNodeRef LiveSchemaTree::get_child_node(const mforms::TreeNodeRef& pa
   bool found = false;
   mforms::TreeNodeRef child;
 
+  // Nodes of a deferred collection are only created if the searched object is part of it.
+  if (parent) {
+    base::StringListPtr pending = get_pending_nodes(parent);
+    if (pending) {
+      for (auto& pending_name : *pending) {
+        if (base::string_compare(pending_name, name, _case_sensitive_identifiers) == 0) {
+          found = true;
+          break;
+        }
+      }
+      if (!found)
+        return mforms::TreeNodeRef();
+
+      found = false;
+      create_pending_nodes(parent);
+    }
+  }
+
   if (binary_search) {
     if (parent && parent->count())
       child = binary_search_node(parent, 0, parent->count() - 1, name, type, last_position);
@@ -1952,6 +2133,9 @@ bool LiveSchemaTree::find_child_position(const mforms::TreeNodeRef& parent, cons
 
   position = 0;
 
+  if (parent)
+    create_pending_nodes(parent);
+
   if (parent && parent->count())
     child = binary_search_node(parent, 0, parent->count() - 1, name, type, position);
 
@@ -1961,6 +2145,112 @@ bool LiveSchemaTree::find_child_position(const mforms::TreeNodeRef& parent, cons
   return child ? true : false;
 }
 
+// Collections with more objects than this get their nodes created only when they are needed.
+static const std::size_t DEFERRED_NODES_THRESHOLD = 1000;
+
+/**
+ * Returns the type of the objects in the given schema collection node (tables, views, procedures or functions)
+ * or NoneType for any other node.
+ */
+LiveSchemaTree::ObjectType LiveSchemaTree::get_collection_child_type(const mforms::TreeNodeRef& node) {
+  if (!node->get_parent() || node->get_data() != NULL)
+    return NoneType;
+
+  std::string tag = node->get_tag();
+  if (tag == TABLES_TAG)
+    return Table;
+  if (tag == VIEWS_TAG)
+    return View;
+  if (tag == PROCEDURES_TAG)
+    return Procedure;
+  if (tag == FUNCTIONS_TAG)
+    return Function;
+  return NoneType;
+}
+
+/**
+ * Returns the names of the objects in the given collection if their nodes have not been created yet.
+ */
+base::StringListPtr LiveSchemaTree::get_pending_nodes(const mforms::TreeNodeRef& collection) {
+  if (_pending_nodes.empty())
+    return base::StringListPtr();
+
+  ObjectType type = get_collection_child_type(collection);
+  if (type == NoneType)
+    return base::StringListPtr();
+
+  auto iterator = _pending_nodes.find(std::make_pair(collection->get_parent()->get_string(0), type));
+  if (iterator == _pending_nodes.end())
+    return base::StringListPtr();
+
+  // The collection only holds the placeholder node as long as the names are pending. If that is no longer
+  // the case, the schema node was recreated in the meantime.
+  if (collection->count() != 1 || collection->get_child(0)->get_data() != NULL ||
+      collection->get_child(0)->get_string(0) != FETCHING_CAPTION) {
+    _pending_nodes.erase(iterator);
+    return base::StringListPtr();
+  }
+
+  return iterator->second;
+}
+
+/**
+ * Replaces the children of the collection by a placeholder node, keeping the given (sorted) names to create
+ * the real nodes later.
+ */
+void LiveSchemaTree::set_pending_nodes(mforms::TreeNodeRef collection, ObjectType type, base::StringListPtr names) {
+  collection->remove_children();
+
+  mforms::TreeNodeRef placeholder = collection->add_child();
+  placeholder->set_string(0, FETCHING_CAPTION);
+  placeholder->set_icon_path(0, _icon_paths[type]);
+
+  _pending_nodes[std::make_pair(collection->get_parent()->get_string(0), type)] = names;
+  _content_revision++;
+}
+
+/**
+ * Creates the nodes of the given collection if they were deferred. In a filtered tree the base collection
+ * is completed first, as both trees share the node data.
+ */
+bool LiveSchemaTree::create_pending_nodes(mforms::TreeNodeRef collection) {
+  base::StringListPtr names = get_pending_nodes(collection);
+  if (!names)
+    return false;
+
+  ObjectType type = get_collection_child_type(collection);
+  _pending_nodes.erase(std::make_pair(collection->get_parent()->get_string(0), type));
+  collection->remove_children();
+
+  if (_base) {
+    mforms::TreeNodeRef base_collection = _base->get_node_from_path(get_node_path(collection));
+    if (base_collection) {
+      if (collection->is_expanded())
+        base_collection->expand();
+      _base->create_pending_nodes(base_collection);
+      filter_children(type, base_collection, collection, _object_pattern);
+    }
+  } else
+    update_node_children(collection, names, type, false, false);
+
+  return true;
+}
+
+/**
+ * Sets the objects of a schema collection. Creating tens of thousands of nodes takes a while in the native
+ * tree controls, so large collections keep only the names until they are expanded.
+ */
+void LiveSchemaTree::update_collection_children(mforms::TreeNodeRef collection, base::StringListPtr children,
+                                                ObjectType type, bool just_append) {
+  if (!just_append && children->size() > DEFERRED_NODES_THRESHOLD && !collection->is_expanded() &&
+      (collection->count() == 0 || get_pending_nodes(collection))) {
+    children->sort(
+      std::bind(base::stl_string_compare, std::placeholders::_1, std::placeholders::_2, _case_sensitive_identifiers));
+    set_pending_nodes(collection, type, children);
+  } else
+    update_node_children(collection, children, type, true, just_append);
+}
+
 void LiveSchemaTree::update_schemata(base::StringListPtr schema_list) {
   mforms::TreeNodeRef schema_node;
 
@@ -1981,6 +2271,8 @@ void LiveSchemaTree::update_schemata(base::StringListPtr schema_list) {
     if (_active_schema.length())
       set_active_schema(_active_schema);
 
+    // Reload all expanded schemas in one go.
+    std::vector<std::string> expanded_schemas;
     int total_schemas = root->count();
     for (int index = 0; index < total_schemas; index++) {
       schema_node = root->get_child(index);
@@ -1989,8 +2281,20 @@ void LiveSchemaTree::update_schemata(base::StringListPtr schema_list) {
       if (data->fetched) {
         data->fetched = false;
 
-        if (schema_node->is_expanded())
-          load_schema_content(schema_node);
+        if (schema_node->is_expanded() && prepare_schema_content_fetch(schema_node))
+          expanded_schemas.push_back(schema_node->get_string(0));
+      }
+    }
+
+    if (!expanded_schemas.empty()) {
+      if (std::shared_ptr<FetchDelegate> delegate = _fetch_delegate.lock()) {
+        NewSchemaContentArrivedSlot arrived_slot =
+          std::bind(&LiveSchemaTree::schema_contents_arrived, this, std::placeholders::_1, std::placeholders::_2,
+                    std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6);
+        if (expanded_schemas.size() == 1)
+          delegate->fetch_schema_contents(expanded_schemas[0], arrived_slot);
+        else
+          delegate->fetch_schemas_contents(expanded_schemas, arrived_slot);
       }
     }
   }
@@ -2029,6 +2333,8 @@ void LiveSchemaTree::expand_toggled(mforms::TreeNodeRef node, bool value) {
           load_table_details(parent, TRIGGER_DATA);
         else if (node_tag == FOREIGN_KEYS_TAG)
           load_table_details(parent, FK_DATA);
+        else
+          create_pending_nodes(node);
       }
     }
 
@@ -2258,6 +2564,7 @@ mforms::TreeNodeRef LiveSchemaTree::insert_node(mforms::TreeNodeRef parent, cons
     node = group_added_nodes[0];
 
     setup_node(node, type);
+    _content_revision++;
   }
 
   return node;
@@ -2323,6 +2630,7 @@ void LiveSchemaTree::reload_object_data(mforms::TreeNodeRef& node) {
 
 void LiveSchemaTree::discard_object_data(mforms::TreeNodeRef& node, int data_mask) {
   mforms::TreeNodeRef parent_node;
+  _content_revision++;
 
   if (data_mask & COLUMN_DATA) {
     LSTData* pdata = dynamic_cast<LSTData*>(node->get_data());
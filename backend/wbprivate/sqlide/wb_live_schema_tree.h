@@ -27,6 +27,7 @@
 #include "grt/tree_model.h"
 #include "workbench/wb_backend_public_interface.h"
 #include "base/string_utilities.h"
+#include "base/interned_string.h"
 #include "mforms/treeview.h"
 #include "base/trackable.h"
 
@@ -155,10 +156,11 @@ namespace wb {
       // NOTE than name will contain the column name duplicating this info as it
       //      is already on the TreeNode. Duplicating it is better than having
       //      full HTML for all the columns on all the tables in the db.
-      std::string name;
-      std::string type;
-      std::string default_value;
-      std::string charset_collation;
+      // The values repeat a lot over the columns of a schema, so they are interned.
+      base::InternedString name;
+      base::InternedString type;
+      base::InternedString default_value;
+      base::InternedString charset_collation;
       bool is_pk;
       bool is_fk;
       bool is_id;
@@ -180,7 +182,7 @@ namespace wb {
       }
       unsigned char update_rule;
       unsigned char delete_rule;
-      std::string referenced_table;
+      base::InternedString referenced_table;
       std::string from_cols;
       std::string to_cols;
 
@@ -201,7 +203,7 @@ namespace wb {
       bool visible;
       bool unique;
       unsigned char type;
-      std::vector<std::string> columns;
+      std::vector<base::InternedString> columns;
 
       virtual void copy(LSTData* other);
       virtual ObjectType get_type() {
@@ -348,10 +350,31 @@ namespace wb {
       virtual bool fetch_data_for_filter(const std::string&, const std::string&,
                                          const NewSchemaContentArrivedSlot&) = 0;
       virtual bool fetch_schema_contents(const std::string&, const NewSchemaContentArrivedSlot&) = 0;
+      // Loads the contents of several schemas in one go. Override to save round trips to the server.
+      virtual bool fetch_schemas_contents(const std::vector<std::string>& schema_names,
+                                          const NewSchemaContentArrivedSlot& arrived_slot) {
+        for (auto& name : schema_names)
+          fetch_schema_contents(name, arrived_slot);
+        return true;
+      }
       virtual bool fetch_object_details(const std::string& schema_name, const std::string& object_name,
                                         wb::LiveSchemaTree::ObjectType type, short, const NodeChildrenUpdaterSlot&) = 0;
       virtual bool fetch_routine_details(const std::string& schema_name, const std::string& object_name,
                                          wb::LiveSchemaTree::ObjectType type) = 0;
+      // Loads the same details for several tables or views of a schema. Override to save round trips to the server.
+      virtual bool fetch_objects_details(const std::string& schema_name, const std::vector<std::string>& object_names,
+                                         wb::LiveSchemaTree::ObjectType type, short flags,
+                                         const NodeChildrenUpdaterSlot& updater_slot) {
+        for (auto& name : object_names)
+          fetch_object_details(schema_name, name, type, flags, updater_slot);
+        return false;
+      }
+
+      // Tells whether an object is known to be unchanged by the last content fetch of its schema, in which case
+      // its loaded details are kept.
+      virtual bool is_object_unchanged(const std::string& schema_name, const std::string& object_name) {
+        return false;
+      }
     };
 
     struct Delegate {
@@ -375,9 +398,11 @@ namespace wb {
     void schema_contents_arrived(const std::string& schema_name, base::StringListPtr tables, base::StringListPtr views,
                                  base::StringListPtr procedures, base::StringListPtr functions, bool just_append);
     void load_table_details(mforms::TreeNodeRef& node, int fetch_mask);
+    void load_table_details_with_siblings(mforms::TreeNodeRef& node, int fetch_mask);
     void fetch_table_details(ObjectType object_type, const std::string schema_name, const std::string object_name,
                              int fetch_mask);
     void load_routine_details(mforms::TreeNodeRef& node);
+    bool prepare_schema_content_fetch(mforms::TreeNodeRef& schema_node);
     void load_schema_content(mforms::TreeNodeRef& schema_node);
     void reload_object_data(mforms::TreeNodeRef& node);
     void discard_object_data(mforms::TreeNodeRef& node, int data_mask);
@@ -389,6 +414,8 @@ namespace wb {
     // Filtering functions
     std::string get_filter_wildcard(const std::string& filter, FilterType type = LocalLike);
     void clean_filter();
+    void narrow_filtered_data();
+    bool narrow_filtered_collection(mforms::TreeNodeRef collection);
     void filter_children_collection(mforms::TreeNodeRef& source, mforms::TreeNodeRef& target);
     bool filter_children(ObjectType type, mforms::TreeNodeRef& source, mforms::TreeNodeRef& target,
                          GPatternSpec* pattern = NULL);
@@ -480,13 +507,28 @@ namespace wb {
     GPatternSpec* _object_pattern;
     LSTData* notify_on_reload_data;
 
+    // Counts changes to the content of the tree, so a filtered tree knows when its copy is outdated.
+    unsigned int _content_revision;
+    unsigned int _filtered_revision;
+    bool _narrow_filter; // The current filter only extends the one used for the filtered tree.
+
     static const char* _schema_tokens[16];
 
     std::map<ObjectType, std::string> _icon_paths;
 
     std::map<ObjectType, mforms::TreeNodeCollectionSkeleton> _node_collections;
 
+    // Names of large schema object collections whose nodes are only created when they are needed, usually when the
+    // collection node is expanded. Keyed by schema name and child type.
+    std::map<std::pair<std::string, ObjectType>, base::StringListPtr> _pending_nodes;
+
     void fill_node_icons();
+    ObjectType get_collection_child_type(const mforms::TreeNodeRef& node);
+    base::StringListPtr get_pending_nodes(const mforms::TreeNodeRef& collection);
+    void set_pending_nodes(mforms::TreeNodeRef collection, ObjectType type, base::StringListPtr names);
+    bool create_pending_nodes(mforms::TreeNodeRef collection);
+    void update_collection_children(mforms::TreeNodeRef collection, base::StringListPtr children, ObjectType type,
+                                    bool just_append);
     std::string get_node_icon_path(ObjectType type);
     bec::IconId get_node_icon(ObjectType type);
   };
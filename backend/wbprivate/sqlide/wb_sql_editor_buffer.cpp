@@ -33,11 +33,13 @@
 
 #include <fstream>
 #include <errno.h>
+#include <glib/gstdio.h>
 
 #include "base/util_functions.h"
 #include "base/file_functions.h"
 #include "base/string_utilities.h"
 #include "base/log.h"
+#include "base/task_scheduler.h"
 
 #include "mforms/utilities.h"
 #include "mforms/filechooser.h"
@@ -51,11 +53,107 @@ DEFAULT_LOG_DOMAIN("SqlEditor")
 using namespace bec;
 using namespace base;
 
+//--------------------------------------------------------------------------------------------------
+
+SqlEditorAutoSaver *SqlEditorAutoSaver::get() {
+  static SqlEditorAutoSaver *instance = new SqlEditorAutoSaver();
+  return instance;
+}
+
+SqlEditorAutoSaver::SqlEditorAutoSaver() : _running(false) {
+}
+
+void SqlEditorAutoSaver::write(const std::string &path, const std::string &data) {
+  add_job(Write, path, data);
+}
+
+void SqlEditorAutoSaver::append(const std::string &path, const std::string &data) {
+  add_job(Append, path, data);
+}
+
+void SqlEditorAutoSaver::remove(const std::string &path) {
+  add_job(Remove, path, "");
+}
+
+void SqlEditorAutoSaver::flush() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _idle.wait(lock, [this]() { return !_running; });
+}
+
+std::string SqlEditorAutoSaver::take_error() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::string error;
+  error.swap(_error);
+  return error;
+}
+
+void SqlEditorAutoSaver::add_job(Operation operation, const std::string &path, const std::string &data) {
+  Job job;
+  job.operation = operation;
+  job.path = path;
+  job.data = data;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _jobs.push_back(job);
+  if (!_running) {
+    _running = true;
+    base::TaskScheduler::get()->post(base::TaskBackground, std::bind(&SqlEditorAutoSaver::run_jobs, this));
+  }
+}
+
+// Only one of these runs at a time, so the files are written in the order requested.
+void SqlEditorAutoSaver::run_jobs() {
+  for (;;) {
+    Job job;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_jobs.empty()) {
+        _running = false;
+        _idle.notify_all();
+        return;
+      }
+      job = _jobs.front();
+      _jobs.pop_front();
+    }
+
+    std::string error;
+    if (job.operation == Write) {
+      // writes a temporary file and renames it
+      GError *gerror = NULL;
+      if (!g_file_set_contents(job.path.c_str(), job.data.data(), (gssize)job.data.size(), &gerror)) {
+        error = gerror->message;
+        g_error_free(gerror);
+      }
+    } else if (job.operation == Append) {
+      FILE *file = base_fopen(job.path.c_str(), "ab");
+      if (!file || fwrite(job.data.data(), 1, job.data.size(), file) != job.data.size())
+        error = g_strerror(errno);
+      if (file && fclose(file) != 0 && error.empty())
+        error = g_strerror(errno);
+    } else if (g_file_test(job.path.c_str(), G_FILE_TEST_EXISTS) && g_remove(job.path.c_str()) != 0)
+      error = g_strerror(errno);
+
+    if (!error.empty()) {
+      logError("Could not auto-save %s: %s\n", job.path.c_str(), error.c_str());
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_error.empty())
+        _error = strfmt("Could not auto-save %s: %s", job.path.c_str(), error.c_str());
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void SqlEditorForm::auto_save() {
   if (!_autosave_disabled && _startup_done) {
     logDebug("Auto saving workspace\n");
 
     try {
+      // writes of the previous auto-save that failed in the background
+      std::string error = SqlEditorAutoSaver::get()->take_error();
+      if (!error.empty())
+        throw std::runtime_error(error);
+
       save_workspace(sanitize_file_name(_connection.is_valid() ? _connection->name() : "unconnected"), true);
     } catch (std::exception &exc) {
       std::string message = strfmt(_("An error occurred during auto-save:\n%s"), exc.what());
@@ -90,14 +188,14 @@ void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_au
     if (is_autosave) {
       _autosave_lock = new base::LockFile(base::makePath(path, "lock"));
       _autosave_path = path;
+      _autosave_files.clear();
     }
   } else
     path = _autosave_path;
 
   // save the real id of the connection
   if (_connection.is_valid())
-    g_file_set_contents(base::makePath(path, "connection_id").c_str(), _connection->id().c_str(),
-                        (gssize)_connection->id().size(), NULL);
+    write_workspace_file(base::makePath(path, "connection_id"), _connection->id());
 
   // save some of the state of the schema tree
   {
@@ -125,7 +223,7 @@ void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_au
       info.append("expanded=").append(expand_state).append("\n");
     }
 
-    g_file_set_contents(base::makePath(path, "schema_tree").c_str(), info.c_str(), info.size(), NULL);
+    write_workspace_file(base::makePath(path, "schema_tree"), info);
   }
 
   if (_tabdock) {
@@ -145,6 +243,22 @@ void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_au
     }
   }
   save_workspace_order(path);
+
+  // a workspace that is not auto-saved is complete only once all files are written
+  if (!is_autosave)
+    SqlEditorAutoSaver::get()->flush();
+}
+
+/**
+ * Queues a workspace state file for writing, unless the auto-save already wrote the same contents to it.
+ */
+void SqlEditorForm::write_workspace_file(const std::string &path, const std::string &data) {
+  std::map<std::string, std::string>::iterator written = _autosave_files.find(path);
+  if (written != _autosave_files.end() && written->second == data)
+    return;
+
+  SqlEditorAutoSaver::get()->write(path, data);
+  _autosave_files[path] = data;
 }
 
 std::string SqlEditorForm::find_workspace_state(const std::string &workspace_name,
@@ -280,6 +394,14 @@ bool SqlEditorForm::load_workspace(const std::string &workspace_name) {
       } catch (std::exception &e) {
         logError("Could not delete autosave file %s\n%s\n", text_file.c_str(), e.what());
       }
+      std::string delta_file = base::makePath(workspace_path, file + ".delta");
+      if (base::file_exists(delta_file)) {
+        try {
+          base::remove(delta_file);
+        } catch (std::exception &e) {
+          logError("Could not delete autosave file %s\n%s\n", delta_file.c_str(), e.what());
+        }
+      }
     }
     // remove the pre-created editor
     remove_sql_editor(editor);
@@ -506,14 +628,13 @@ void SqlEditorForm::save_workspace_order(const std::string &prefix) {
     logError("save with empty path\n");
 
   if (_tabdock) {
-    std::wofstream orderFile;
-    openStream(base::makePath(prefix, "tab_order"), orderFile);
+    std::string order;
     for (int c = _tabdock->view_count(), i = 0; i < c; i++) {
       SqlEditorPanel *editor = sql_editor_panel(i);
-      if (editor && orderFile.good())
-        orderFile << base::string_to_wstring(editor->autosave_file_suffix()) << std::endl;
+      if (editor)
+        order.append(editor->autosave_file_suffix()).append("\n");
     }
-    orderFile.close();
+    write_workspace_file(base::makePath(prefix, "tab_order"), order);
   }
 }
 
@@ -644,7 +765,8 @@ void SqlEditorForm::open_file(const std::string &path, bool in_new_tab, bool ask
   }
 
   try {
-    if (askForFile && panel->load_from(file_path) == SqlEditorPanel::RunInstead) {
+    SqlEditorPanel::LoadResult result = askForFile ? panel->load_from(file_path) : SqlEditorPanel::Loaded;
+    if (result == SqlEditorPanel::RunInstead) {
       if (in_new_tab)
         remove_sql_editor(panel);
       grt::BaseListRef args(true);
@@ -652,6 +774,11 @@ void SqlEditorForm::open_file(const std::string &path, bool in_new_tab, bool ask
       args.ginsert(grt::StringRef(file_path));
       grt::GRT::get()->call_module_function("SQLIDEUtils", "runSQLScriptFile", args);
       return;
+    } else if (result == SqlEditorPanel::ExecuteInstead) {
+      if (in_new_tab)
+        remove_sql_editor(panel);
+      exec_sql_file(file_path);
+      return;
     }
   } catch (std::exception &exc) {
     logError("Cannot open file %s: %s\n", file_path.c_str(), exc.what());
@@ -21,3 +21,49 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+
+#pragma once
+
+#include "workbench/wb_backend_public_interface.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+/**
+ * Writes the workspace auto-save files of the SQL editors in a background thread, in the order they were
+ * requested. Files are replaced atomically, so a crash while writing leaves the previous version. Errors are
+ * kept until the next auto-save picks them up with take_error().
+ */
+class MYSQLWBBACKEND_PUBLIC_FUNC SqlEditorAutoSaver {
+public:
+  static SqlEditorAutoSaver *get();
+
+  void write(const std::string &path, const std::string &data);
+  void append(const std::string &path, const std::string &data);
+  void remove(const std::string &path);
+
+  // Waits for all writes requested so far, e.g. before a workspace dir is renamed or deleted.
+  void flush();
+
+  std::string take_error();
+
+private:
+  enum Operation { Write, Append, Remove };
+  struct Job {
+    Operation operation;
+    std::string path;
+    std::string data;
+  };
+
+  std::mutex _mutex;
+  std::condition_variable _idle;
+  std::deque<Job> _jobs;
+  bool _running;
+  std::string _error;
+
+  SqlEditorAutoSaver();
+  void add_job(Operation operation, const std::string &path, const std::string &data);
+  void run_jobs();
+};
@@ -32,13 +32,18 @@
 
 #include "sqlide/recordset_be.h"
 #include "sqlide/recordset_cdbc_storage.h"
+#include "sqlide/recordset_stream_writer.h"
+#include "sqlide/table_data_importer.h"
 #include "sqlide/wb_sql_editor_snippets.h"
+#include "sqlide/wb_sql_editor_buffer.h"
 #include "sqlide/wb_sql_editor_panel.h"
 #include "sqlide/wb_sql_editor_result_panel.h"
 #include "sqlide/wb_sql_editor_tree_controller.h"
 #include "sqlide/sql_script_run_wizard.h"
 
 #include "sqlide/column_width_cache.h"
+#include "sqlide/schema_metadata_cache.h"
+#include "sqlide/query_stats_cache.h"
 
 #include "objimpl/db.query/db_query_Resultset.h"
 #include "objimpl/wrapper/mforms_ObjectReference_impl.h"
@@ -53,6 +58,7 @@
 #include "base/util_functions.h"
 #include "base/scope_exit_trigger.h"
 #include "base/threading.h"
+#include "base/trace.h"
 
 #include "workbench/wb_command_ui.h"
 #include "workbench/wb_context_names.h"
@@ -72,12 +78,16 @@
 #include "mforms/splitter.h"  // needed for d-tor
 #include "mforms/toolbar.h"
 #include "mforms/code_editor.h"
+#include "mforms/filechooser.h"
+#include "mforms/simpleform.h"
 
 #include "grtsqlparser/mysql_parser_services.h"
 
 #include <math.h>
+#include <algorithm>
 #include <mutex>
 #include <thread>
+#include <future>
 
 using namespace bec;
 using namespace grt;
@@ -92,6 +102,39 @@ DEFAULT_LOG_DOMAIN("SQL Editor Form")
 static const char *SQL_EXCEPTION_MSG_FORMAT = _("Error Code: %i\n%s");
 static const char *EXCEPTION_MSG_FORMAT = _("Error: %s");
 
+// rows read before a result is shown, the rest of it is read while the grid is already up
+static const size_t STREAMED_RESULT_FIRST_FRAME_ROWS = 1000;
+// Session variables read in the same round trip that opens a connection, get_session_variable() takes them from
+// there instead of querying each one. All of them exist since MySQL 5.0.
+static const char *CACHED_SESSION_VARIABLES[] = {"version", "version_comment", "version_compile_os", "sql_mode",
+                                                 "lower_case_table_names", "max_allowed_packet", "wait_timeout",
+                                                 "interactive_timeout"};
+
+static const size_t MAX_STATEMENT_BATCH_LENGTH = 1024 * 1024; // Stay well below the usual max_allowed_packet.
+static const double TABLE_IMPORT_SLICE_SECONDS = 0.5;          // Part of a table data import run per call.
+
+// Statements which can be sent in a batch, because they never produce a result set or change the session state.
+static bool is_batchable_statement(Sql_syntax_check::Statement_type type) {
+  return type == Sql_syntax_check::sql_insert || type == Sql_syntax_check::sql_update ||
+         type == Sql_syntax_check::sql_delete;
+}
+
+// Whether the statement may set a user variable (@name, system variables like @@sql_mode don't count).
+static bool uses_user_variable(const std::string &statement) {
+  for (size_t pos = statement.find('@'); pos != std::string::npos; pos = statement.find('@', pos + 2)) {
+    if (pos + 1 == statement.size() || statement[pos + 1] != '@')
+      return true;
+  }
+  return false;
+}
+
+// Whether the statement is a SET, which may change the session variables cached for the connection.
+static bool is_set_statement(const std::string &statement) {
+  size_t start = statement.find_first_not_of(" \t\r\n");
+  return start != std::string::npos && statement.size() > start + 3 &&
+         g_ascii_strncasecmp(statement.c_str() + start, "set", 3) == 0 && std::isspace(statement[start + 3]);
+}
+
 #define CATCH_SQL_EXCEPTION_AND_DISPATCH(statement, log_message_index, duration)                        \
   catch (sql::SQLException & e) {                                                                       \
     set_log_message(log_message_index, DbSqlEditorLog::ErrorMsg,                                        \
@@ -279,14 +322,26 @@ SqlEditorForm::SqlEditorForm(wb::WBContextSQLIDE *wbsql)
   exec_sql_task->msg_cb(std::bind(&SqlEditorForm::add_log_message, this, std::placeholders::_1, std::placeholders::_2,
                                   std::placeholders::_3, ""));
 
+  _column_prefetch_task = GrtThreadedTask::create();
+  _column_prefetch_task->desc("Column Prefetch Task");
+  _column_prefetch_task->send_task_res_msg(false);
+
   _last_log_message_timestamp = timestamp();
 
-  long keep_alive_interval = bec::GRTManager::get()->get_app_option_int("DbSqlEditor:KeepAliveInterval", 600);
+  for (auto &conn : _metadata_dbc_conns)
+    conn.reset(new sql::Dbc_connection_handler());
+  _metadata_connection_count = (int)std::max(
+    1L, std::min((long)MAX_METADATA_CONNECTIONS,
+                 bec::GRTManager::get()->get_app_option_int("DbSqlEditor:MetadataConnections", 2)));
+
+  _keep_alive_interval = bec::GRTManager::get()->get_app_option_int("DbSqlEditor:KeepAliveInterval", 600);
 
-  if (keep_alive_interval != 0) {
+  if (_keep_alive_interval > 0) {
+    // Ticking at half the interval lets the ticks skip connections used since the last one, without leaving any
+    // connection idle for longer than the interval.
     logDebug3("Creating KeepAliveInterval timer...\n");
-    _keep_alive_task_id = ThreadedTimer::add_task(
-      TimerTimeSpan, keep_alive_interval, false, std::bind(&SqlEditorForm::send_message_keep_alive_bool_wrapper, this));
+    _keep_alive_task_id = ThreadedTimer::add_task(TimerTimeSpan, _keep_alive_interval / 2.0, false,
+                                                  std::bind(&SqlEditorForm::send_message_keep_alive_bool_wrapper, this));
   }
 
   _lower_case_table_names = 0;
@@ -314,6 +369,7 @@ SqlEditorForm::~SqlEditorForm() {
                                               _connection->parameterValues().get_string("userName"));
 
   delete _column_width_cache;
+  delete _query_stats_cache;
 
   // debug: ensure that close() was called when the tab is closed
   if (_toolbar != nullptr)
@@ -347,7 +403,7 @@ void SqlEditorForm::cancel_connect() {
 void SqlEditorForm::check_server_problems() {
   //_lower_case_table_names
   std::string compile_os;
-  if (_usr_dbc_conn && get_session_variable(_usr_dbc_conn->ref.get(), "version_compile_os", compile_os)) {
+  if (_usr_dbc_conn && get_session_variable(_usr_dbc_conn, "version_compile_os", compile_os)) {
     if ((_lower_case_table_names == 0 && (base::hasPrefix(compile_os, "Win") || base::hasPrefix(compile_os, "osx"))) ||
         (_lower_case_table_names == 2 && base::hasPrefix(compile_os, "Win")))
       mforms::Utilities::show_message_and_remember(
@@ -362,8 +418,6 @@ void SqlEditorForm::check_server_problems() {
 void SqlEditorForm::finish_startup() {
   setup_side_palette();
 
-  _live_tree->finish_init();
-
   std::string cache_dir = bec::GRTManager::get()->get_user_datadir() + "/cache/";
   try {
     base::create_directory(cache_dir, 0700); // No-op if the folder already exists.
@@ -372,6 +426,14 @@ void SqlEditorForm::finish_startup() {
   }
 
   _column_width_cache = new ColumnWidthCache(sanitize_file_name(get_session_name()), cache_dir);
+  _schema_metadata_cache = SchemaMetadataCache::get(sanitize_file_name(get_session_name()), cache_dir);
+  scoped_connect(_schema_metadata_cache->signal_object_dropped(),
+                 std::bind(&SqlEditorForm::schema_object_dropped, this, std::placeholders::_1, std::placeholders::_2,
+                           std::placeholders::_3));
+  _query_stats_cache = new QueryStatsCache(sanitize_file_name(get_session_name()), cache_dir);
+
+  // The schema tree uses the meta data cache to fill in its initial content.
+  _live_tree->finish_init();
 
   if (_usr_dbc_conn && !_usr_dbc_conn->active_schema.empty())
     _live_tree->on_active_schema_change(_usr_dbc_conn->active_schema);
@@ -400,11 +462,11 @@ void SqlEditorForm::finish_startup() {
   {
     std::string value;
 
-    if (get_session_variable(_usr_dbc_conn->ref.get(), "wait_timeout", value) &&
+    if (get_session_variable(_usr_dbc_conn, "wait_timeout", value) &&
         base::atoi<int>(value) < keep_alive_interval)
       exec_main_sql(base::strfmt("SET @@SESSION.wait_timeout=%d", keep_alive_interval + 10), false);
 
-    if (get_session_variable(_usr_dbc_conn->ref.get(), "interactive_timeout", value) &&
+    if (get_session_variable(_usr_dbc_conn, "interactive_timeout", value) &&
         base::atoi<int>(value) < keep_alive_interval)
       exec_main_sql(base::strfmt("SET @@SESSION.interactive_timeout=%d", keep_alive_interval + 10), false);
   }
@@ -548,6 +610,8 @@ grt::StringRef SqlEditorForm::do_disconnect() {
       close_connection(_aux_dbc_conn);
       _aux_dbc_conn->ref.reset();
     }
+
+    close_metadata_connections();
   }
 
   return grt::StringRef();
@@ -563,6 +627,7 @@ void SqlEditorForm::close() {
       delete _autosave_lock;
     } else {
       auto_save();
+      SqlEditorAutoSaver::get()->flush();
 
       // Remove auto lock first or renaming the folder will fail.
       delete _autosave_lock;
@@ -597,6 +662,7 @@ void SqlEditorForm::close() {
   } else {
     delete _autosave_lock;
     _autosave_lock = 0;
+    SqlEditorAutoSaver::get()->flush();
     if (!_autosave_path.empty())
       base_rmdir_recursively(_autosave_path.c_str());
   }
@@ -619,6 +685,7 @@ void SqlEditorForm::close() {
 
   exec_sql_task->exec(true, std::bind(&SqlEditorForm::do_disconnect, this));
   exec_sql_task->disconnect_callbacks();
+  _column_prefetch_task->disconnect_callbacks();
   reset_keep_alive_thread();
   bec::GRTManager::get()->replace_status_text("SQL Editor closed");
 
@@ -670,6 +737,15 @@ bool SqlEditorForm::get_session_variable(sql::Connection *dbc_conn, const std::s
   return false;
 }
 
+bool SqlEditorForm::get_session_variable(const sql::Dbc_connection_handler::Ref &conn, const std::string &name,
+                                         std::string &value) {
+  if (!conn)
+    return false;
+  if (conn->cached_variable(name, value))
+    return true;
+  return get_session_variable(conn->ref.get(), name, value);
+}
+
 void SqlEditorForm::schema_tree_did_populate() {
   if (!_pending_expand_nodes.empty() &&
       bec::GRTManager::get()->get_app_option_int("DbSqlEditor:SchemaTreeRestoreState", 1)) {
@@ -719,13 +795,44 @@ void SqlEditorForm::update_sql_mode_for_editors() {
   }
 }
 
+void SqlEditorForm::update_auto_completion_for_editors() {
+  for (int c = sql_editor_count(), i = 0; i < c; i++) {
+    SqlEditorPanel *panel = sql_editor_panel(i);
+    if (panel)
+      panel->editor_be()->auto_completion_symbols_changed();
+  }
+}
+
 void SqlEditorForm::cache_sql_mode() {
   std::string sql_mode;
-  if (_usr_dbc_conn && get_session_variable(_usr_dbc_conn->ref.get(), "sql_mode", sql_mode)) {
-    if (sql_mode != _sql_mode) {
-      _sql_mode = sql_mode;
-      bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlEditorForm::update_sql_mode_for_editors, this));
-    }
+  if (get_session_variable(_usr_dbc_conn, "sql_mode", sql_mode))
+    update_sql_mode(sql_mode);
+}
+
+void SqlEditorForm::update_sql_mode(const std::string &sql_mode) {
+  if (sql_mode != _sql_mode) {
+    _sql_mode = sql_mode;
+    bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlEditorForm::update_sql_mode_for_editors, this));
+  }
+}
+
+/**
+ * Remembers the user variables of the user connection, so they can be restored when it has to be reopened.
+ * This needs performance_schema (MySQL 5.7+), without it variables are lost on reconnect as before.
+ * Values are kept as quoted strings, the server converts them back when they are used as numbers.
+ */
+void SqlEditorForm::cache_user_variables() {
+  try {
+    std::unique_ptr<sql::Statement> stmt(_usr_dbc_conn->ref->createStatement());
+    std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(
+      "SELECT v.VARIABLE_NAME, QUOTE(v.VARIABLE_VALUE) FROM performance_schema.user_variables_by_thread v "
+      "JOIN performance_schema.threads t USING (THREAD_ID) WHERE t.PROCESSLIST_ID = CONNECTION_ID()"));
+    std::map<std::string, std::string> variables;
+    while (rs->next())
+      variables[rs->getString(1)] = rs->getString(2);
+    _usr_dbc_conn->user_variables.swap(variables);
+  } catch (sql::SQLException &exc) {
+    logDebug("Cannot read user variables of the connection: %s\n", exc.what());
   }
 }
 
@@ -1001,14 +1108,11 @@ static void set_active_schema(SqlEditorForm::Ptr self, const std::string &schema
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void SqlEditorForm::create_connection(sql::Dbc_connection_handler::Ref &dbc_conn, db_mgmt_ConnectionRef db_mgmt_conn,
-                                      std::shared_ptr<sql::TunnelConnection> tunnel, sql::Authentication::Ref auth,
-                                      bool autocommit_mode, bool user_connection) {
-  dbc_conn->is_stop_query_requested = false;
-
-  sql::DriverManager *dbc_drv_man = sql::DriverManager::getDriverManager();
-
-  db_mgmt_ConnectionRef temp_connection = db_mgmt_ConnectionRef::cast_from(grt::CopyContext().copy(db_mgmt_conn));
+/**
+ * Returns a copy of the connection with the options of SQL editor connections applied.
+ */
+db_mgmt_ConnectionRef SqlEditorForm::editor_connection_properties(const db_mgmt_ConnectionRef &connection) {
+  db_mgmt_ConnectionRef temp_connection = db_mgmt_ConnectionRef::cast_from(grt::CopyContext().copy(connection));
 
   int read_timeout = (int)bec::GRTManager::get()->get_app_option_int("DbSqlEditor:ReadTimeOut");
   if (read_timeout > 0)
@@ -1019,8 +1123,20 @@ void SqlEditorForm::create_connection(sql::Dbc_connection_handler::Ref &dbc_conn
     temp_connection->parameterValues().set("OPT_CONNECT_TIMEOUT", grt::IntegerRef(connect_timeout));
 
   temp_connection->parameterValues().set("CLIENT_INTERACTIVE", grt::IntegerRef(1));
+  return temp_connection;
+}
+
+void SqlEditorForm::create_connection(sql::Dbc_connection_handler::Ref &dbc_conn, db_mgmt_ConnectionRef db_mgmt_conn,
+                                      std::shared_ptr<sql::TunnelConnection> tunnel, sql::Authentication::Ref auth,
+                                      bool autocommit_mode, bool user_connection) {
+  dbc_conn->is_stop_query_requested = false;
+
+  sql::DriverManager *dbc_drv_man = sql::DriverManager::getDriverManager();
+
+  db_mgmt_ConnectionRef temp_connection = editor_connection_properties(db_mgmt_conn);
 
   try {
+    dbc_conn->clear_prepared_statements();
     dbc_conn->ref = dbc_drv_man->getConnection(temp_connection, tunnel, auth,
                                                std::bind(&SqlEditorForm::init_connection, this, std::placeholders::_1,
                                                          std::placeholders::_2, dbc_conn, user_connection));
@@ -1036,36 +1152,85 @@ void SqlEditorForm::create_connection(sql::Dbc_connection_handler::Ref &dbc_conn
     throw std::runtime_error("MySQL Server version is older than 5.x, which is not supported");
   }
 
-  // get SSL enabled info
-  {
-    std::auto_ptr<sql::Statement> stmt(dbc_conn->ref->createStatement());
-    std::auto_ptr<sql::ResultSet> result(stmt->executeQuery("SHOW SESSION STATUS LIKE 'Ssl_cipher'"));
-    if (result->next()) {
-      dbc_conn->ssl_cipher = result->getString(2);
-    }
+  // Query the SSL state and the cached variables and restore the session state in a single round trip. The server
+  // stops at the first failing statement, so the default schema, which may no longer exist, comes last.
+  std::vector<std::string> statements;
+  statements.push_back("SHOW SESSION STATUS LIKE 'Ssl_cipher'");
+  std::string variables_query;
+  for (const char *variable : CACHED_SESSION_VARIABLES)
+    variables_query.append(variables_query.empty() ? "SELECT " : ", ").append("@@").append(variable);
+  statements.push_back(variables_query);
+  if (user_connection) {
+    if (!dbc_conn->sql_mode.empty())
+      statements.push_back(base::sqlstring("SET SESSION sql_mode = ?", 0) << dbc_conn->sql_mode);
+    for (auto &variable : dbc_conn->user_variables)
+      statements.push_back(std::string(base::sqlstring("SET @! = ", 0) << variable.first) + variable.second);
+    statements.push_back("SELECT @@SESSION.sql_mode");
   }
 
   // Activate default schema, if it's empty, use last active
-  if (dbc_conn->active_schema.empty()) {
-    std::string default_schema = temp_connection->parameterValues().get_string("schema");
-
+  bool restore_last_schema = dbc_conn->active_schema.empty();
+  std::string default_schema = dbc_conn->active_schema;
+  if (restore_last_schema) {
+    default_schema = temp_connection->parameterValues().get_string("schema");
     if (default_schema.empty())
       default_schema = temp_connection->parameterValues().get_string("DbSqlEditor:LastDefaultSchema");
-    if (!default_schema.empty()) {
-      try {
-        dbc_conn->ref->setSchema(default_schema);
-        dbc_conn->active_schema = default_schema;
+  }
+  if (!default_schema.empty())
+    statements.push_back(base::sqlstring("USE !", 0) << default_schema);
+
+  size_t executed = 0;
+  std::string sql_mode;
+  dbc_conn->clear_cached_variables();
+  try {
+    std::auto_ptr<sql::Statement> stmt(dbc_conn->ref->createStatement());
+    bool is_result_set = stmt->execute(base::join(statements, ";\n"));
+    while (true) {
+      if (is_result_set) {
+        std::unique_ptr<sql::ResultSet> result(stmt->getResultSet());
+        if (result->next()) {
+          if (executed == 0)
+            dbc_conn->ssl_cipher = result->getString(2);
+          else if (executed == 1) {
+            unsigned int column = 1;
+            for (const char *variable : CACHED_SESSION_VARIABLES) {
+              if (!result->isNull(column))
+                dbc_conn->cache_variable(variable, result->getString(column));
+              ++column;
+            }
+          } else
+            sql_mode = result->getString(1);
+        }
+      } else if (stmt->getUpdateCount() < 0)
+        break;
+      ++executed;
+      is_result_set = stmt->getMoreResults();
+    }
+  } catch (sql::SQLException &exc) {
+    // Only the schema may fail if it was dropped, anything else is not worth failing the connection for.
+    if (executed + 1 < statements.size() || default_schema.empty())
+      logError("Can't restore the session state: %s\n", exc.what());
+  }
 
+  if (user_connection && !sql_mode.empty()) {
+    dbc_conn->cache_variable("sql_mode", sql_mode);
+    update_sql_mode(sql_mode);
+  }
+
+  if (!default_schema.empty()) {
+    if (executed == statements.size()) {
+      dbc_conn->active_schema = default_schema;
+      if (restore_last_schema)
         bec::GRTManager::get()->run_once_when_idle(this,
                                                    std::bind(&set_active_schema, shared_from_this(), default_schema));
-      } catch (std::exception &exc) {
-        logError("Can't restore default schema (%s): %s\n", default_schema.c_str(), exc.what());
-        temp_connection->parameterValues().gset("DbSqlEditor:LastDefaultSchema", "");
-      }
-    }
-  } else
-    dbc_conn->ref->setSchema((dbc_conn->active_schema));
+    } else if (restore_last_schema) {
+      logError("Can't restore default schema (%s)\n", default_schema.c_str());
+      temp_connection->parameterValues().gset("DbSqlEditor:LastDefaultSchema", "");
+    } else
+      dbc_conn->ref->setSchema(default_schema);
+  }
 
+  // Goes through the connector rather than the batch above, so it knows the mode.
   dbc_conn->ref->setAutoCommit(autocommit_mode);
   dbc_conn->autocommit_mode = dbc_conn->ref->getAutoCommit();
 }
@@ -1241,6 +1406,7 @@ grt::StringRef SqlEditorForm::do_connect(std::shared_ptr<sql::TunnelConnection>
 
     _aux_dbc_conn->ref.reset();
     _usr_dbc_conn->ref.reset();
+    close_metadata_connections();
 
     // connection info
     _connection_details["name"] = _connection->name();
@@ -1273,20 +1439,54 @@ grt::StringRef SqlEditorForm::do_connect(std::shared_ptr<sql::TunnelConnection>
         create_html_line("Port:", strfmt("%i", (int)_connection->parameterValues().get_int("port"))));
     }
 
-    // open connections
-    create_connection(_aux_dbc_conn, _connection, tunnel, auth, _aux_dbc_conn->autocommit_mode, false);
-    create_connection(_usr_dbc_conn, _connection, tunnel, auth, _usr_dbc_conn->autocommit_mode, true);
+    // Open all connections at once, so a reconnect over a slow link waits for one handshake instead of several.
+    // The other threads get their own copy of the credentials, a failed login invalidates them.
+    auto copyAuth = [auth]() {
+      sql::Authentication::Ref copy = sql::Authentication::create(auth->connectionProperties(), auth->service());
+      if (auth->is_valid())
+        copy->set_password(auth->password());
+      return copy;
+    };
+    sql::Authentication::Ref auxAuth = copyAuth();
+    std::future<void> auxConnect = std::async(std::launch::async, [this, tunnel, auxAuth]() {
+      base::ScopeExitTrigger cleanup([]() { sql::DriverManager::getDriverManager()->thread_cleanup(); });
+      create_connection(_aux_dbc_conn, _connection, tunnel, auxAuth, _aux_dbc_conn->autocommit_mode, false);
+    });
+    std::vector<std::future<void>> metadataConnects;
+    for (int index = 0; index < _metadata_connection_count; ++index) {
+      sql::Authentication::Ref metadataAuth = copyAuth();
+      metadataConnects.push_back(std::async(std::launch::async, [this, index, tunnel, metadataAuth]() {
+        base::ScopeExitTrigger cleanup([]() { sql::DriverManager::getDriverManager()->thread_cleanup(); });
+        try {
+          open_metadata_connection(index, tunnel, metadataAuth);
+        } catch (std::exception &exc) {
+          // Not fatal, it's opened again when first needed.
+          logWarning("Could not open meta data connection: %s\n", exc.what());
+        }
+      }));
+    }
+
+    try {
+      create_connection(_usr_dbc_conn, _connection, tunnel, auth, _usr_dbc_conn->autocommit_mode, true);
+    } catch (...) {
+      for (auto &metadataConnect : metadataConnects)
+        metadataConnect.wait();
+      close_metadata_connections();
+      throw;
+    }
+    auxConnect.get();
+    for (auto &metadataConnect : metadataConnects)
+      metadataConnect.get();
     _serverIsOffline = false;
-    cache_sql_mode();
 
     // We need this so later we can get tunnel port
     _tunnel = tunnel;
     try {
       {
         std::string value;
-        get_session_variable(_usr_dbc_conn->ref.get(), "version_comment", value);
+        get_session_variable(_usr_dbc_conn, "version_comment", value);
         _connection_details["dbmsProductName"] = value;
-        get_session_variable(_usr_dbc_conn->ref.get(), "version", value);
+        get_session_variable(_usr_dbc_conn, "version", value);
         _connection_details["dbmsProductVersion"] = value;
 
         logInfo("Opened connection '%s' to %s version %s\n", _connection->name().c_str(),
@@ -1320,7 +1520,7 @@ grt::StringRef SqlEditorForm::do_connect(std::shared_ptr<sql::TunnelConnection>
 
       // get lower_case_table_names value
       std::string value;
-      if (_usr_dbc_conn && get_session_variable(_usr_dbc_conn->ref.get(), "lower_case_table_names", value))
+      if (get_session_variable(_usr_dbc_conn, "lower_case_table_names", value))
         _lower_case_table_names = base::atoi<int>(value, 0);
 
       parsers::MySQLParserServices::Ref services = parsers::MySQLParserServices::get();
@@ -1496,6 +1696,62 @@ RecMutexLock SqlEditorForm::ensure_valid_aux_connection(bool throw_on_block, boo
   return ensure_valid_dbc_connection(_aux_dbc_conn, _aux_dbc_conn_mutex, throw_on_block, lockOnly);
 }
 
+/**
+ * Returns a connection for reading meta data, so that loading it neither waits for nor blocks the
+ * aux connection. The first connection is kept for requests the user waits for (expanding nodes, object details),
+ * background loading only uses the others. Every request takes an idle connection if there is one.
+ */
+RecMutexLock SqlEditorForm::ensure_valid_metadata_connection(sql::Dbc_connection_handler::Ref &conn,
+                                                             MetadataPriority priority) {
+  int first = (priority == BackgroundMetadata && _metadata_connection_count > 1) ? 1 : 0;
+  for (int index = first; index < _metadata_connection_count; ++index) {
+    try {
+      RecMutexLock lock(ensure_valid_metadata_connection(index, true));
+      conn = _metadata_dbc_conns[index];
+      return lock;
+    } catch (base::mutex_busy_error &) {
+      // In use, try the next one.
+    }
+  }
+
+  RecMutexLock lock(ensure_valid_metadata_connection(first, false));
+  conn = _metadata_dbc_conns[first];
+  return lock;
+}
+
+RecMutexLock SqlEditorForm::ensure_valid_metadata_connection(int index, bool throw_on_block) {
+  {
+    RecMutexLock lock(_metadata_dbc_conn_mutexes[index], throw_on_block);
+    sql::Dbc_connection_handler::Ref &dbc_conn = _metadata_dbc_conns[index];
+    if (!dbc_conn->ref.get_ptr()) {
+      if (!_usr_dbc_conn->ref.get_ptr())
+        throw grt::db_not_connected("DBMS connection is not available");
+
+      open_metadata_connection(index, sql::DriverManager::getDriverManager()->getTunnel(_connection), _dbc_auth);
+    }
+  }
+
+  return ensure_valid_dbc_connection(_metadata_dbc_conns[index], _metadata_dbc_conn_mutexes[index], throw_on_block);
+}
+
+void SqlEditorForm::open_metadata_connection(int index, std::shared_ptr<sql::TunnelConnection> tunnel,
+                                             sql::Authentication::Ref auth) {
+  RecMutexLock lock(_metadata_dbc_conn_mutexes[index]);
+
+  // All meta data queries qualify their object names. Setting a schema here keeps create_connection from
+  // restoring the default schema of the editor.
+  _metadata_dbc_conns[index]->active_schema = "information_schema";
+  create_connection(_metadata_dbc_conns[index], _connection, tunnel, auth, true, false);
+}
+
+void SqlEditorForm::close_metadata_connections() {
+  for (int index = 0; index < MAX_METADATA_CONNECTIONS; ++index) {
+    RecMutexLock lock(_metadata_dbc_conn_mutexes[index]);
+    close_connection(_metadata_dbc_conns[index]);
+    _metadata_dbc_conns[index]->ref.reset();
+  }
+}
+
 RecMutexLock SqlEditorForm::ensure_valid_usr_connection(bool throw_on_block, bool lockOnly) {
   return ensure_valid_dbc_connection(_usr_dbc_conn, _usr_dbc_conn_mutex, throw_on_block, lockOnly);
 }
@@ -1503,6 +1759,7 @@ RecMutexLock SqlEditorForm::ensure_valid_usr_connection(bool throw_on_block, boo
 void SqlEditorForm::close_connection(sql::Dbc_connection_handler::Ref &dbc_conn) {
   sql::Dbc_connection_handler::Ref myref(dbc_conn);
   if (dbc_conn && dbc_conn->ref.get_ptr()) {
+    dbc_conn->clear_prepared_statements();
     try {
       dbc_conn->ref->close();
     } catch (sql::SQLException &) {
@@ -1519,6 +1776,7 @@ RecMutexLock SqlEditorForm::ensure_valid_dbc_connection(sql::Dbc_connection_hand
 
   sql::Dbc_connection_handler::Ref myref(dbc_conn);
   if (dbc_conn && dbc_conn->ref.get_ptr()) {
+    dbc_conn->last_activity = timestamp();
     if (lockOnly) // this is a special case, we need it in some situations like for example recordset_cdbc
       return mutex_lock;
 
@@ -1693,6 +1951,340 @@ void SqlEditorForm::exec_sql_retaining_editor_contents(const std::string &sql_sc
                                       (ExecFlags)(dont_add_limit_clause ? DontAddLimitClause : 0), RecordsetsRef()));
 }
 
+/**
+ * Executes all statements of the given file without loading it into an editor, for dumps too large to edit.
+ */
+void SqlEditorForm::exec_sql_file(const std::string &path) {
+  if (!connected())
+    throw grt::db_not_connected("Not connected");
+
+  exec_sql_task->exec(false, std::bind(&SqlEditorForm::do_exec_sql_file, this, weak_ptr_from(this), path));
+}
+
+/**
+ * Runs a query and writes its result straight into a file in one of the streamed export formats, without
+ * creating a result grid. Meant for results too large to load.
+ */
+void SqlEditorForm::export_query_to_file(const std::string &query, const std::string &format, const std::string &path,
+                                         bool gzip, const std::map<std::string, std::string> &parameters) {
+  if (!connected())
+    throw grt::db_not_connected("Not connected");
+
+  exec_sql_task->exec(false, std::bind(&SqlEditorForm::do_export_query_to_file, this, weak_ptr_from(this), query,
+                                       format, path, gzip, parameters));
+}
+
+/**
+ * Asks for a file and format, then exports the result of the statement at the caret without showing it.
+ */
+void SqlEditorForm::export_current_statement_to_file() {
+  SqlEditorPanel *panel = active_sql_editor_panel();
+  if (!panel)
+    return;
+  std::string query = panel->editor_be()->current_statement();
+  if (query.empty())
+    return;
+
+  std::map<std::string, Recordset_text_storage::TemplateInfo> formats; // by description
+  std::string format_list;
+  for (const Recordset_storage_info &type : Recordset_text_storage::storage_types()) {
+    Recordset_text_storage::TemplateInfo info(Recordset_text_storage::storage_type(type.name));
+    if (Recordset_stream_writer::create(info, Recordset_stream_writer::Parameters())) {
+      format_list.append("|").append(info.description).append("|").append(info.extension);
+      formats[info.description] = info;
+    }
+  }
+  if (formats.empty())
+    return;
+
+  mforms::FileChooser chooser(mforms::SaveFile);
+  chooser.set_title(_("Export Query Result to File"));
+  chooser.add_selector_option("format", _("Format:"), format_list.substr(1));
+  chooser.add_selector_option("compression", _("Compression:"), "None|none|gzip|gz");
+  if (!chooser.run_modal())
+    return;
+
+  const Recordset_text_storage::TemplateInfo &info(formats[chooser.get_selector_option_value("format")]);
+  bool gzip = chooser.get_selector_option_value("compression") == "gzip";
+  std::string path = chooser.get_path();
+  if (gzip && !base::hasSuffix(path, ".gz"))
+    path.append(".gz");
+
+  std::map<std::string, std::string> parameters;
+  parameters["GENERATE_DATE"] = base::fmttime(time(NULL), DATETIME_FMT);
+  parameters["TABLE_NAME"] = "TABLE";
+  if (!info.arguments.empty()) {
+    mforms::SimpleForm form(_("Export Query Result"), _("Export"));
+    form.add_label(strfmt(_("Export options for %s"), info.description.c_str()), false);
+    for (const std::pair<std::string, std::string> &arg : info.arguments)
+      form.add_text_entry(arg.second, arg.first + ":", parameters[arg.second]);
+    form.set_size(400, -1);
+    if (!form.show())
+      return;
+    for (const std::pair<std::string, std::string> &arg : info.arguments)
+      parameters[arg.second] = form.get_string_view_value(arg.second);
+  }
+
+  export_query_to_file(query, info.name, path, gzip, parameters);
+}
+
+/**
+ * Scans the gap between two statements for DELIMITER commands and returns the delimiter in effect after it.
+ */
+static std::string delimiter_after(const char *head, const char *end, const std::string &delimiter) {
+  static const char keyword[] = "delimiter";
+  static const size_t keyword_length = sizeof(keyword) - 1;
+
+  std::string result = delimiter;
+  while (head < end) {
+    while (head < end && std::isspace(*head))
+      ++head;
+    if ((size_t)(end - head) > keyword_length && g_ascii_strncasecmp(head, keyword, keyword_length) == 0 &&
+        std::isspace(head[keyword_length])) {
+      head += keyword_length;
+      while (head < end && (*head == ' ' || *head == '\t'))
+        ++head;
+      const char *start = head;
+      while (head < end && !std::isspace(*head))
+        ++head;
+      if (head > start)
+        result.assign(start, head);
+    }
+    while (head < end && *head != '\n')
+      ++head;
+  }
+  return result;
+}
+
+/**
+ * Runs in the sql execution thread. The result set is forward only, which makes the connector read it with
+ * mysql_use_result(), so rows arrive from the server as they are written and are never all in memory.
+ * Cancelling the query stops the export and removes the incomplete file.
+ */
+grt::StringRef SqlEditorForm::do_export_query_to_file(Ptr self_ptr, const std::string &query,
+                                                      const std::string &format, const std::string &path, bool gzip,
+                                                      const std::map<std::string, std::string> &parameters) {
+  std::shared_ptr<SqlEditorForm> self_ref = self_ptr.lock();
+  if (!self_ref) {
+    logError("Couldn't aquire lock for SQL editor form\n");
+    return grt::StringRef("");
+  }
+
+  RowId log_message_index = add_log_message(DbSqlEditorLog::BusyMsg, _("Exporting..."), query, "");
+  Timer timer(false);
+
+  bool completed = false;
+  sql::Driver *dbc_driver = nullptr;
+  Recordset_stream_writer::Ref writer;
+  try {
+    writer = Recordset_stream_writer::create(Recordset_text_storage::storage_type(format), parameters);
+    if (!writer)
+      throw std::runtime_error(strfmt(_("Format %s can't be exported directly from the server"), format.c_str()));
+
+    RecMutexLock use_dbc_conn_mutex(ensure_valid_usr_connection());
+
+    dbc_driver = _usr_dbc_conn->ref->getDriver();
+    dbc_driver->threadInit();
+
+    bool is_running_query = true;
+    AutoSwap<bool> is_running_query_keeper(_is_running_query, is_running_query);
+    update_menu_and_toolbar();
+
+    base::ScopeExitTrigger schedule_timer_stop(std::bind(&Timer::stop, &timer));
+    timer.run();
+
+    writer->open(path, gzip);
+
+    std::unique_ptr<sql::Statement> stmt(_usr_dbc_conn->ref->createStatement());
+    stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+    if (!stmt->execute(query))
+      throw std::runtime_error(_("The statement did not return a result set"));
+    std::unique_ptr<sql::ResultSet> rs(stmt->getResultSet());
+
+    double last_status_update = 0;
+    completed = writer->write_resultset(rs.get(), query, [&](size_t rows) {
+      if (base::timestamp() - last_status_update > 1) {
+        last_status_update = base::timestamp();
+        bec::GRTManager::get()->replace_status_text(
+          strfmt(_("Exported %lu rows to %s (%s)"), (unsigned long)rows, path.c_str(),
+                 base::sizefmt((int64_t)writer->bytes_written(), false).c_str()));
+      }
+      return !_usr_dbc_conn->is_stop_query_requested;
+    });
+
+    std::string message = strfmt(_("%lu row(s) exported to %s"), (unsigned long)writer->row_count(), path.c_str());
+    if (completed) {
+      set_log_message(log_message_index, DbSqlEditorLog::OKMsg, message, query, timer.duration_formatted());
+      bec::GRTManager::get()->replace_status_text(_("Export Completed"));
+    } else {
+      set_log_message(log_message_index, DbSqlEditorLog::NoteMsg, message + _(" - export cancelled"), query,
+                      timer.duration_formatted());
+      bec::GRTManager::get()->replace_status_text(_("Export cancelled"));
+    }
+  } catch (sql::SQLException &e) {
+    set_log_message(log_message_index, DbSqlEditorLog::ErrorMsg,
+                    strfmt(SQL_EXCEPTION_MSG_FORMAT, e.getErrorCode(), e.what()), query, timer.duration_formatted());
+  } catch (std::exception &e) {
+    set_log_message(log_message_index, DbSqlEditorLog::ErrorMsg, strfmt(EXCEPTION_MSG_FORMAT, e.what()), query,
+                    timer.duration_formatted());
+  }
+
+  // a partial file is of no use, close it before removing
+  writer.reset();
+  if (!completed)
+    base::remove(path);
+
+  if (dbc_driver)
+    dbc_driver->threadEnd();
+
+  update_menu_and_toolbar();
+
+  _usr_dbc_conn->is_stop_query_requested = false;
+
+  return grt::StringRef("");
+}
+
+/**
+ * Runs in the sql execution thread. The file is memory mapped and split into statements in windows of a few MB,
+ * which are executed right away. This way only the pages of the window are touched and they can be dropped
+ * by the OS at any time (they are backed by the file), instead of holding the entire text in memory.
+ */
+grt::StringRef SqlEditorForm::do_exec_sql_file(Ptr self_ptr, const std::string &path) {
+  static const size_t WINDOW_SIZE = 16 * 1024 * 1024;
+  static const size_t MAX_LOGGED_STATEMENT_SIZE = 1024;
+
+  std::shared_ptr<SqlEditorForm> self_ref = self_ptr.lock();
+  if (!self_ref) {
+    logError("Couldn't aquire lock for SQL editor form\n");
+    return grt::StringRef("");
+  }
+
+  GError *error = nullptr;
+  GMappedFile *file = g_mapped_file_new(path.c_str(), FALSE, &error);
+  if (file == nullptr) {
+    add_log_message(DbSqlEditorLog::ErrorMsg, strfmt(_("Could not open file: %s"), error->message), path, "");
+    g_error_free(error);
+    return grt::StringRef("");
+  }
+  base::ScopeExitTrigger unmap_file(std::bind(g_mapped_file_unref, file));
+
+  const char *text = g_mapped_file_get_contents(file);
+  size_t size = g_mapped_file_get_length(file);
+
+  _exec_sql_error_count = 0;
+  RowId log_message_index = add_log_message(DbSqlEditorLog::BusyMsg, _("Running..."), path, "");
+  Timer timer(false);
+
+  size_t statement_count = 0;
+  size_t failed_count = 0;
+  bool interrupted = false;
+  std::string statement;
+  sql::Driver *dbc_driver = nullptr;
+  try {
+    RecMutexLock use_dbc_conn_mutex(ensure_valid_usr_connection());
+
+    dbc_driver = _usr_dbc_conn->ref->getDriver();
+    dbc_driver->threadInit();
+
+    bool is_running_query = true;
+    AutoSwap<bool> is_running_query_keeper(_is_running_query, is_running_query);
+    update_menu_and_toolbar();
+
+    _has_pending_log_messages = false;
+    base::ScopeExitTrigger schedule_log_messages_refresh(std::bind(&SqlEditorForm::refresh_log_messages, this, true));
+    base::ScopeExitTrigger schedule_timer_stop(std::bind(&Timer::stop, &timer));
+    timer.run();
+
+    MySQLParserServices::Ref services = MySQLParserServices::get();
+    std::unique_ptr<sql::Statement> stmt(_usr_dbc_conn->ref->createStatement());
+    std::string delimiter = ";";
+    size_t offset = 0;
+    size_t window = WINDOW_SIZE;
+    double last_status_update = 0;
+    while (offset < size && !interrupted) {
+      size_t length = std::min(window, size - offset);
+      std::vector<StatementRange> ranges;
+      services->determineStatementRanges(text + offset, length, delimiter, ranges);
+
+      // The last statement may continue behind the window, so it starts the next one. If it is the only one
+      // the window is too small for it.
+      size_t next = length;
+      if (offset + length < size) {
+        if (ranges.size() < 2) {
+          window *= 2;
+          continue;
+        }
+        next = ranges.back().start;
+        ranges.pop_back();
+      }
+      window = WINDOW_SIZE;
+
+      const char *gap = text + offset;
+      for (auto &range : ranges) {
+        delimiter = delimiter_after(gap, text + offset + range.start, delimiter);
+        gap = text + offset + range.start + range.length;
+
+        if (_usr_dbc_conn->is_stop_query_requested) {
+          interrupted = true;
+          break;
+        }
+
+        statement.assign(text + offset + range.start, range.length);
+        ++statement_count;
+        try {
+          if (stmt->execute(statement)) {
+            std::unique_ptr<sql::ResultSet> rs(stmt->getResultSet()); // Results are not shown in this mode.
+          }
+        } catch (sql::SQLException &e) {
+          ++failed_count;
+          if (statement.size() > MAX_LOGGED_STATEMENT_SIZE)
+            statement = statement.substr(0, MAX_LOGGED_STATEMENT_SIZE) + "...";
+          add_log_message(DbSqlEditorLog::ErrorMsg, strfmt(SQL_EXCEPTION_MSG_FORMAT, e.getErrorCode(), e.what()),
+                          statement, "");
+          if (!continue_on_error()) {
+            interrupted = true;
+            break;
+          }
+        }
+      }
+      if (interrupted)
+        break;
+
+      delimiter = delimiter_after(gap, text + offset + next, delimiter);
+      offset += next;
+
+      if (base::timestamp() - last_status_update > 1) {
+        last_status_update = base::timestamp();
+        bec::GRTManager::get()->replace_status_text(strfmt(_("Executed %lu statements from %s (%.0f%%)"),
+                                                           (unsigned long)statement_count, path.c_str(),
+                                                           100.0 * offset / size));
+      }
+    }
+
+    std::string message = strfmt(_("%lu statement(s) executed, %lu failed"), (unsigned long)statement_count,
+                                 (unsigned long)failed_count);
+    if (interrupted) {
+      set_log_message(log_message_index, DbSqlEditorLog::NoteMsg, message + _(" - script interrupted"), path,
+                      timer.duration_formatted());
+      bec::GRTManager::get()->replace_status_text(_("Query interrupted"));
+    } else {
+      set_log_message(log_message_index, failed_count > 0 ? DbSqlEditorLog::WarningMsg : DbSqlEditorLog::OKMsg,
+                      message, path, timer.duration_formatted());
+      bec::GRTManager::get()->replace_status_text(_("Query Completed"));
+    }
+  }
+  CATCH_ANY_EXCEPTION_AND_DISPATCH(path)
+
+  if (dbc_driver)
+    dbc_driver->threadEnd();
+
+  update_menu_and_toolbar();
+
+  _usr_dbc_conn->is_stop_query_requested = false;
+
+  return grt::StringRef("");
+}
+
 void SqlEditorForm::run_editor_contents(bool current_statement_only) {
   SqlEditorPanel *panel(active_sql_editor_panel());
   if (panel) {
@@ -1796,6 +2388,7 @@ void SqlEditorForm::update_live_schema_tree(const std::string &sql) {
 
 grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::string> sql, SqlEditorPanel *editor,
                                           ExecFlags flags, RecordsetsRef result_list) {
+  TRACE_SPAN("sqlide", "SqlEditorForm::do_exec_sql");
 
   logDebug("Background task for sql execution started\n");
 
@@ -1811,6 +2404,8 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
   int limit_rows = 0;
   if (bec::GRTManager::get()->get_app_option_int("SqlEditor:LimitRows") != 0)
     limit_rows = (int)bec::GRTManager::get()->get_app_option_int("SqlEditor:LimitRowsCount", 0);
+  size_t batch_size = (size_t)std::max<ssize_t>(
+    1, bec::GRTManager::get()->get_app_option_int("DbSqlEditor:StatementBatchSize", 100));
 
   bec::GRTManager::get()->replace_status_text(_("Executing Query..."));
 
@@ -1844,10 +2439,14 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
     Sql_specifics::Ref sql_specifics = sql_facade->sqlSpecifics();
 
     bool ran_set_sql_mode = false;
+    bool ran_user_variable = false;
     bool logging_queries;
     std::vector<std::pair<std::size_t, std::size_t>> statement_ranges;
+    std::uint64_t split_start = base::Tracer::now();
     sql_facade->splitSqlScript(sql->c_str(), sql->size(),
                                use_non_std_delimiter ? sql_specifics->non_std_sql_delimiter() : ";", statement_ranges);
+    // counted as parse time of the first statement
+    std::uint64_t split_time = base::Tracer::now() - split_start;
 
     if (statement_ranges.size() > 1) {
       query_ps_stats = false;
@@ -1868,10 +2467,18 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
     // Intentionally allow any value. For values <= 0 show no result set at all.
     ssize_t max_resultset_count = bec::GRTManager::get()->get_app_option_int("DbSqlEditor::MaxResultsets", 50);
     ssize_t total_result_count = (editor != nullptr) ? editor->resultset_count() : 0; // Consider pinned result sets.
+    // Result tabs after these get their grid when they are first selected, not while the script still runs.
+    ssize_t eager_result_tabs =
+      std::max<ssize_t>(1, bec::GRTManager::get()->get_app_option_int("DbSqlEditor:EagerResultTabs", 10));
+    ssize_t result_tab_count = 0;
 
     bool results_left = false;
-    for (auto &statement_range : statement_ranges) {
+    for (size_t range_index = 0; range_index < statement_ranges.size(); ++range_index) {
+      auto &statement_range = statement_ranges[range_index];
       logDebug3("Executing statement range: %lu, %lu...\n", statement_range.first, statement_range.second);
+      std::uint64_t statement_start = base::Tracer::now();
+      if (range_index == 0)
+        statement_start -= split_time;
 
       statement = sql->substr(statement_range.first, statement_range.second);
       std::list<std::string> sub_statements;
@@ -1890,6 +2497,46 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
         if (Sql_syntax_check::sql_empty == statement_type)
           continue;
 
+        // Consecutive data changes (like the INSERTs of a dump) produce no result sets and are sent in batches
+        // instead, to save the round trips and log entries for each of them.
+        if (batch_size > 1 && !use_non_std_delimiter && !is_multiple_statement &&
+            is_batchable_statement(statement_type)) {
+          std::vector<std::string> batch = { statement };
+          std::vector<size_t> batch_ranges = { range_index };
+          size_t batch_length = statement.size();
+          for (size_t next = range_index + 1; next < statement_ranges.size() && batch.size() < batch_size &&
+                                              batch_length < MAX_STATEMENT_BATCH_LENGTH;
+               ++next) {
+            std::string next_statement =
+              strip_text(sql->substr(statement_ranges[next].first, statement_ranges[next].second), false, true);
+            if (!is_batchable_statement(sql_syntax_check->determine_statement_type(next_statement)))
+              break;
+            batch_length += next_statement.size();
+            batch.push_back(next_statement);
+            batch_ranges.push_back(next);
+          }
+
+          if (batch.size() > 1) {
+            for (auto &batch_statement : batch)
+              ran_user_variable = ran_user_variable || uses_user_variable(batch_statement);
+            if (logging_queries)
+              _history->add_entry(std::list<std::string>(batch.begin(), batch.end()));
+
+            if (_usr_dbc_conn->is_stop_query_requested)
+              throw std::runtime_error(
+                _("Query execution has been stopped, the connection to the DB server was not restarted, any open "
+                  "transaction remains open"));
+
+            // Statements behind a failed one are not run by the server. Continue after the failed one, if at all.
+            bool batch_failed = false;
+            size_t executed = exec_statement_batch(batch, batch_failed);
+            if (batch_failed && !_continueOnError)
+              goto stop_processing_sql_script;
+            range_index = batch_ranges[std::min(executed, batch.size() - 1)];
+            continue;
+          }
+        }
+
         std::string schema_name;
         std::string table_name;
 
@@ -1933,10 +2580,18 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
 
             if (limit_rows > 0)
               data_storage->limit_rows_count(limit_rows);
+            data_storage->keyset_paging(bec::GRTManager::get()->get_app_option_int("SqlEditor:KeysetPaging", 1) != 0);
+            data_storage->lazy_large_columns(
+              bec::GRTManager::get()->get_app_option_int("Recordset:OptimizeBlobFetching", 0) != 0);
           }
           statement = data_storage->decorated_sql_query();
         }
 
+        std::uint64_t parse_time = base::Tracer::now() - statement_start;
+        if (base::Tracer::enabled())
+          base::Tracer::record("sqlide", "SqlEditorForm::parse_statement", statement_start,
+                               statement_start + parse_time);
+
         {
           RowId log_message_index = add_log_message(DbSqlEditorLog::BusyMsg, _("Running..."), statement,
                                                     ((Sql_syntax_check::sql_select == statement_type) ? "? / ?" : "?"));
@@ -1955,6 +2610,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
 
           try {
             {
+              TRACE_SPAN("sqlide", "SqlEditorForm::execute_statement");
               base::ScopeExitTrigger schedule_statement_exec_timer_stop(std::bind(&Timer::stop, &statement_exec_timer));
               statement_exec_timer.run();
               is_result_set_first = dbc_statement->execute(statement);
@@ -1969,8 +2625,13 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
             // Updating the UI during a run of many commands is not useful either.
             if (Sql_syntax_check::sql_use == statement_type)
               cache_active_schema_name();
+            // Any SET may change the session variables read when the connection was opened.
+            if (Sql_syntax_check::sql_set == statement_type)
+              _usr_dbc_conn->clear_cached_variables();
             if (Sql_syntax_check::sql_set == statement_type && statement.find("@sql_mode") != std::string::npos)
               ran_set_sql_mode = true;
+            if (uses_user_variable(statement))
+              ran_user_variable = true;
             if (Sql_syntax_check::sql_drop == statement_type)
               update_live_schema_tree(statement);
           } catch (sql::SQLException &e) {
@@ -2075,7 +2736,9 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                                     statement_exec_timer.duration_formatted() + " / ?");
                   reuse_log_msg = false;
                   std::shared_ptr<sql::ResultSet> dbc_resultset;
+                  double fetched_before = statement_fetch_timer.duration();
                   {
+                    TRACE_SPAN("sqlide", "SqlEditorForm::get_resultset");
                     base::ScopeExitTrigger schedule_statement_fetch_timer_stop(
                       std::bind(&Timer::stop, &statement_fetch_timer));
                     statement_fetch_timer.run();
@@ -2137,6 +2800,14 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                       data_storage->table_name(table_name);
                     }
 
+                    // the grid gets the first rows while the rest of them is still being read
+                    data_storage->first_frame_row_count(STREAMED_RESULT_FIRST_FRAME_ROWS);
+                    data_storage->use_columnar_data(
+                      bec::GRTManager::get()->get_app_option_int("SqlEditor:InMemoryReadOnlyResults", 1) != 0);
+                    data_storage->server_side_sort_filter(
+                      bec::GRTManager::get()->get_app_option_int("SqlEditor:ServerSideSortFilter", 1) != 0);
+                    data_storage->prepared_reloads(
+                      bec::GRTManager::get()->get_app_option_int("SqlEditor:PreparedReloads", 0) != 0);
                     data_storage->dbc_statement(dbc_statement);
                     data_storage->dbc_resultset(dbc_resultset);
                     data_storage->reloadable(!is_multiple_statement &&
@@ -2152,15 +2823,25 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                       std::bind(&SqlEditorForm::apply_changes_to_recordset, this, Recordset::Ptr(rs));
                     rs->generator_query(statement);
 
+                    RecordsetData *rdata = new RecordsetData();
                     {
                       if (query_ps_stats) {
                         query_ps_statistics(_usr_dbc_conn->id, ps_stats);
+                        if (_query_stats_cache != nullptr && !ps_stats.empty())
+                          _query_stats_cache->add(statement, ps_stats);
                         ps_stages = query_ps_stages(ps_stats["EVENT_ID"]);
                         ps_waits = query_ps_waits(ps_stats["EVENT_ID"]);
                         query_ps_stats = false;
                       }
-                      RecordsetData *rdata = new RecordsetData();
                       rdata->duration = statement_exec_timer.duration();
+                      rdata->start_time = statement_start;
+                      // only the first result of a statement took the time to parse and execute it
+                      if (resultset_count == 0) {
+                        rdata->parse_time = parse_time;
+                        rdata->execute_time = (std::uint64_t)(statement_exec_timer.duration() * 1000000000.0);
+                      }
+                      rdata->transfer_time =
+                        (std::uint64_t)((statement_fetch_timer.duration() - fetched_before) * 1000000000.0);
                       rdata->ps_stat_error = query_ps_statement_events_error;
                       rdata->ps_stat_info = ps_stats;
                       rdata->ps_stage_info = ps_stages;
@@ -2177,7 +2858,13 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                         result_list->push_back(rs);
 
                       if (editor)
-                        editor->add_panel_for_recordset_from_main(rs);
+                        editor->add_panel_for_recordset_from_main(rs, result_tab_count++ >= eager_result_tabs);
+
+                      rs->fetch_pending_rows(true);
+                      rdata->fetch_timings = data_storage->fetch_timings();
+                      rdata->fetch_complete = true;
+                      bec::GRTManager::get()->run_once_when_idle(
+                        this, std::bind(&SqlEditorForm::limit_result_memory, this));
 
                       std::string statement_res_msg = std::to_string(rs->row_count()) + _(" row(s) returned");
                       if (!last_statement_info->empty())
@@ -2222,8 +2909,13 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
       bec::GRTManager::get()->replace_status_text(_("Query interrupted"));
     // try to minimize the times this is called, since this will change the state of the connection
     // after a user query is ran (eg, it will reset all warnings)
-    if (ran_set_sql_mode)
+    // Both are restored when the connection has to be reopened.
+    if (ran_set_sql_mode) {
       cache_sql_mode();
+      _usr_dbc_conn->sql_mode = _sql_mode;
+    }
+    if (ran_user_variable)
+      cache_user_variables();
   }
   CATCH_ANY_EXCEPTION_AND_DISPATCH(statement)
 
@@ -2239,6 +2931,62 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
   return grt::StringRef("");
 }
 
+/**
+ * Sends the given statements as one multi statement query and adds a single log entry for all of them.
+ * Errors are logged for the statement which caused them. The server doesn't run any statement after a failed one.
+ * Returns the number of statements which succeeded. On error this is also the index of the failed statement.
+ */
+size_t SqlEditorForm::exec_statement_batch(const std::vector<std::string> &statements, bool &failed) {
+  std::string sql;
+  for (auto &statement : statements) {
+    if (!sql.empty())
+      sql += "\n;\n"; // The line break ends a trailing line comment in the previous statement.
+    sql += statement;
+  }
+
+  std::string summary = strfmt(_("%lu statements, starting with: %s"), (unsigned long)statements.size(),
+                               statements[0].substr(0, 256).c_str());
+  RowId log_message_index = add_log_message(DbSqlEditorLog::BusyMsg, _("Running..."), summary, "?");
+  Timer statement_exec_timer(false);
+  std::shared_ptr<sql::Statement> dbc_statement(_usr_dbc_conn->ref->createStatement());
+
+  size_t executed = 0;
+  long long affected_rows = 0;
+  failed = false;
+  try {
+    base::ScopeExitTrigger schedule_statement_exec_timer_stop(std::bind(&Timer::stop, &statement_exec_timer));
+    statement_exec_timer.run();
+
+    // Every statement returns a result (usually an update count). We are done when there is none left.
+    bool is_result_set = dbc_statement->execute(sql);
+    while (true) {
+      if (is_result_set) {
+        std::unique_ptr<sql::ResultSet> rs(dbc_statement->getResultSet());
+      } else {
+        long long updated_rows_count = dbc_statement->getUpdateCount();
+        if (updated_rows_count < 0)
+          break;
+        affected_rows += updated_rows_count;
+      }
+      ++executed;
+      is_result_set = dbc_statement->getMoreResults();
+    }
+  } catch (sql::SQLException &e) {
+    failed = true;
+    set_log_message(log_message_index, DbSqlEditorLog::OKMsg,
+                    strfmt(_("%lu statement(s) executed, %lli row(s) affected"), (unsigned long)executed, affected_rows),
+                    summary, statement_exec_timer.duration_formatted());
+    add_log_message(DbSqlEditorLog::ErrorMsg, strfmt(_("Error Code: %i. %s"), e.getErrorCode(), e.what()),
+                    statements[std::min(executed, statements.size() - 1)], "");
+    return executed;
+  }
+
+  set_log_message(log_message_index, DbSqlEditorLog::OKMsg,
+                  strfmt(_("%lu statement(s) executed, %lli row(s) affected"), (unsigned long)executed, affected_rows),
+                  summary, statement_exec_timer.duration_formatted());
+  return executed;
+}
+
 void SqlEditorForm::exec_management_sql(const std::string &sql, bool log) {
   sql::Dbc_connection_handler::Ref conn;
   base::RecMutexLock lock(ensure_valid_aux_connection(conn));
@@ -2259,6 +3007,8 @@ void SqlEditorForm::exec_management_sql(const std::string &sql, bool log) {
     if (log)
       set_log_message(rid, DbSqlEditorLog::OKMsg, _("OK"), sql, statement_exec_timer.duration_formatted());
 
+    if (is_set_statement(sql))
+      _usr_dbc_conn->clear_cached_variables();
     handle_command_side_effects(sql);
   }
 }
@@ -2282,6 +3032,8 @@ void SqlEditorForm::exec_main_sql(const std::string &sql, bool log) {
     if (log)
       set_log_message(rid, DbSqlEditorLog::OKMsg, _("OK"), sql, statement_exec_timer.duration_formatted());
 
+    if (is_set_statement(sql))
+      conn->clear_cached_variables();
     handle_command_side_effects(sql);
   }
 }
@@ -2320,7 +3072,7 @@ void SqlEditorForm::handle_command_side_effects(const std::string &sql) {
 
       if (obj == wb::LiveSchemaTree::Schema) {
         for (rit = object_names.rbegin(); rit != object_names.rend(); ++rit)
-          _live_tree->refresh_live_object_in_overview(obj, (*rit).first, (*rit).first, "");
+          notify_object_dropped(object_type, (*rit).first, (*rit).first);
 
         if (!object_names.empty())
           schema_name = object_names.back().first;
@@ -2334,13 +3086,31 @@ void SqlEditorForm::handle_command_side_effects(const std::string &sql) {
         }
       } else {
         for (rit = object_names.rbegin(); rit != object_names.rend(); ++rit)
-          _live_tree->refresh_live_object_in_overview(obj, (*rit).first.empty() ? schema_name : (*rit).first,
-                                                      (*rit).second, "");
+          notify_object_dropped(object_type, (*rit).first.empty() ? schema_name : (*rit).first, (*rit).second);
       }
     }
   }
 }
 
+/**
+ * Editors open on the same connection share the meta data cache, which passes the drop on to all of them,
+ * this one included.
+ */
+void SqlEditorForm::notify_object_dropped(const std::string &object_type, const std::string &schema,
+                                          const std::string &name) {
+  if (_schema_metadata_cache)
+    _schema_metadata_cache->object_dropped(object_type, schema, name);
+  else
+    schema_object_dropped(object_type, schema, name);
+}
+
+void SqlEditorForm::schema_object_dropped(const std::string &object_type, const std::string &schema,
+                                          const std::string &name) {
+  wb::LiveSchemaTree::ObjectType obj = str_to_object_type(object_type);
+  if (obj != wb::LiveSchemaTree::NoneType)
+    _live_tree->refresh_live_object_in_overview(obj, schema, name, "");
+}
+
 db_query_ResultsetRef SqlEditorForm::exec_management_query(const std::string &sql, bool log) {
   sql::Dbc_connection_handler::Ref conn;
   base::RecMutexLock lock(ensure_valid_aux_connection(conn));
@@ -2365,6 +3135,66 @@ db_query_ResultsetRef SqlEditorForm::exec_management_query(const std::string &sq
   return db_query_ResultsetRef();
 }
 
+/**
+ * Imports the next part of a CSV or JSON file on the aux connection, for the Table Data Import wizard. A call
+ * returns after TABLE_IMPORT_SLICE_SECONDS, so the wizard can update its progress and stop the import in between.
+ */
+grt::DictRef SqlEditorForm::import_table_data(const grt::DictRef &options) {
+  grt::DictRef result(true);
+  sql::Dbc_connection_handler::Ref conn;
+  base::RecMutexLock lock(ensure_valid_aux_connection(conn));
+  if (!conn)
+    throw std::runtime_error(_("Not connected"));
+
+  TableDataImporter importer(TableDataImporter::options_from_dict(options));
+  importer.seek(options.get_int("position", 0));
+
+  const std::unique_ptr<sql::Statement> stmt(conn->ref->createStatement());
+  bool done = importer.import([&stmt](const std::string &sql) { stmt->execute(sql); }, TABLE_IMPORT_SLICE_SECONDS);
+
+  result.set("position", grt::IntegerRef((ssize_t)importer.position()));
+  result.set("size", grt::IntegerRef((ssize_t)importer.file_size()));
+  result.set("rows", grt::IntegerRef((ssize_t)importer.rows_imported()));
+  result.set("failed", grt::IntegerRef((ssize_t)importer.rows_failed()));
+  result.gset("error", importer.last_error());
+  result.set("done", grt::IntegerRef(done ? 1 : 0));
+  return result;
+}
+
+/**
+ * The statements run in this connection's editors with the most expensive performance schema statistics, over all
+ * sessions. Times are in seconds.
+ */
+grt::DictListRef SqlEditorForm::query_statistics(const std::string &order, ssize_t limit) {
+  grt::DictListRef result(true);
+  if (_query_stats_cache == nullptr)
+    return result;
+
+  for (const QueryStatsCache::Entry &entry : _query_stats_cache->top(order, (size_t)std::max<ssize_t>(limit, 0))) {
+    grt::DictRef item(true);
+    item.gset("digest", entry.digest);
+    item.gset("statement", entry.statement);
+    item.set("count", grt::IntegerRef((ssize_t)entry.exec_count));
+    item.gset("total_time", entry.total_time / 1000000000000.0);
+    item.gset("max_time", entry.max_time / 1000000000000.0);
+    item.gset("lock_time", entry.lock_time / 1000000000000.0);
+    item.set("rows_examined", grt::IntegerRef((ssize_t)entry.rows_examined));
+    item.set("rows_sent", grt::IntegerRef((ssize_t)entry.rows_sent));
+    item.set("tmp_tables", grt::IntegerRef((ssize_t)entry.tmp_tables));
+    item.set("tmp_disk_tables", grt::IntegerRef((ssize_t)entry.tmp_disk_tables));
+    item.set("no_index_used", grt::IntegerRef((ssize_t)entry.no_index_used));
+    item.set("first_seen", grt::IntegerRef((ssize_t)entry.first_seen));
+    item.set("last_seen", grt::IntegerRef((ssize_t)entry.last_seen));
+    result.insert(item);
+  }
+  return result;
+}
+
+void SqlEditorForm::clear_query_statistics() {
+  if (_query_stats_cache != nullptr)
+    _query_stats_cache->clear();
+}
+
 db_query_ResultsetRef SqlEditorForm::exec_main_query(const std::string &sql, bool log) {
   base::RecMutexLock lock(ensure_valid_usr_connection());
   if (_usr_dbc_conn) {
@@ -2415,6 +3245,86 @@ void SqlEditorForm::send_message_keep_alive() {
   }
 }
 
+/**
+ * Keep alive timer tick. Only pings the user and aux connections that were idle for at least half the keep alive
+ * interval. Connections in use right now are skipped instead of waited for, so a busy editor doesn't hold one of the
+ * timer's few worker threads.
+ */
+void SqlEditorForm::send_idle_keep_alive() {
+  double idle_time = _keep_alive_interval / 2.0;
+  std::pair<sql::Dbc_connection_handler::Ref *, base::RecMutex *> connections[] = {
+    {&_aux_dbc_conn, &_aux_dbc_conn_mutex}, {&_usr_dbc_conn, &_usr_dbc_conn_mutex}};
+
+  for (auto &connection : connections) {
+    sql::Dbc_connection_handler::Ref conn(*connection.first);
+    if (!conn || !conn->ref.get_ptr() || timestamp() - conn->last_activity < idle_time)
+      continue;
+
+    try {
+      logDebug3("KeepAliveInterval tick\n");
+      // ping server and reset connection timeout counter
+      // this also checks the connection state and restores it if possible
+      ensure_valid_dbc_connection(*connection.first, *connection.second, true);
+    } catch (const std::exception &) {
+      // Busy connections are active anyway, broken ones are reported when used next.
+    }
+  }
+}
+
+/*
+ * Keeps the result data held in memory by all editor tabs within the SqlEditor:ResultMemoryBudget (in MB, 0 for no
+ * limit). Results not viewed for the longest time leave their data to their data swap dbs first, except for the one
+ * shown and those still being fetched.
+ */
+void SqlEditorForm::limit_result_memory() {
+  size_t budget = (size_t)bec::GRTManager::get()->get_app_option_int("SqlEditor:ResultMemoryBudget", 0) * 1024 * 1024;
+  if (budget == 0)
+    return;
+
+  SqlEditorPanel *active_panel = active_sql_editor_panel();
+  SqlEditorResult *active_result = active_panel ? active_panel->active_result_panel() : NULL;
+
+  std::vector<std::pair<SqlEditorResult *, Recordset::Ref> > results;
+  size_t total_size = 0;
+  for (int i = 0; i < sql_editor_count(); ++i) {
+    SqlEditorPanel *panel = sql_editor_panel(i);
+    if (!panel)
+      continue;
+    for (int j = 0; j < (int)panel->result_panel_count(); ++j) {
+      SqlEditorResult *result = panel->result_panel(j);
+      Recordset::Ref rs(result ? result->recordset() : Recordset::Ref());
+      if (!rs)
+        continue;
+      total_size += rs->memory_size();
+      if (result != active_result)
+        results.push_back(std::make_pair(result, rs));
+    }
+  }
+  if (total_size <= budget)
+    return;
+
+  std::sort(results.begin(), results.end(),
+            [](const std::pair<SqlEditorResult *, Recordset::Ref> &a,
+               const std::pair<SqlEditorResult *, Recordset::Ref> &b) {
+              return a.first->last_viewed() < b.first->last_viewed();
+            });
+  for (auto &result : results) {
+    if (total_size <= budget)
+      break;
+    size_t size = result.second->memory_size();
+    try {
+      if (result.second->release_memory()) {
+        size_t released = size - std::min(size, result.second->memory_size());
+        total_size -= std::min(total_size, released);
+        logDebug2("Released %i KB of result data held by \"%s\"\n", (int)(released / 1024),
+                  result.second->caption().c_str());
+      }
+    } catch (const std::exception &exc) {
+      logError("Could not release result data of \"%s\": %s\n", result.second->caption().c_str(), exc.what());
+    }
+  }
+}
+
 void SqlEditorForm::apply_changes_to_recordset(Recordset::Ptr rs_ptr) {
   RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, rs_ptr, rs)
 
@@ -2472,6 +3382,12 @@ void SqlEditorForm::apply_changes_to_recordset(Recordset::Ptr rs_ptr) {
 
         scoped_connection on_sql_script_run_error_conn(
           sql_storage->on_sql_script_run_error.connect(on_sql_script_run_error));
+        scoped_connection on_sql_script_run_progress_conn(
+          sql_storage->on_sql_script_run_progress.connect([](float progress) {
+            mforms::App::get()->set_status_text(
+              strfmt(_("Applying changes to recordset... %i%%"), (int)(progress * 100)));
+            return 0;
+          }));
         rs->do_apply_changes(rs_ptr, Recordset_data_storage::Ptr(data_storage_ref), skip_commit);
       }
 
@@ -2530,6 +3446,7 @@ void SqlEditorForm::apply_object_alter_script(const std::string &alter_script, b
 
   sql::SqlBatchExec sql_batch_exec;
   sql_batch_exec.stop_on_error(true);
+  sql_batch_exec.batch_statements(true);
 
   sql_batch_exec.error_cb(std::ref(on_sql_script_run_error));
   sql_batch_exec.batch_exec_progress_cb(std::ref(on_sql_script_run_progress));
@@ -2717,51 +3634,184 @@ void SqlEditorForm::schema_meta_data_refreshed(const std::string &schema_name, b
                                                base::StringListPtr functions) {
   std::unique_lock<std::mutex> lock(_pimplMutex->_symbolsMutex);
   std::unique_ptr<sql::Statement> statement;
-  RecMutexLock usr_dbc_conn_mutex(ensure_valid_usr_connection());
-  if (_usr_dbc_conn->ref.get() != nullptr)
-    statement.reset(_usr_dbc_conn->ref.get()->createStatement());
+  sql::Dbc_connection_handler::Ref conn;
+  RecMutexLock metadata_dbc_conn_mutex(ensure_valid_metadata_connection(conn, BackgroundMetadata));
+  if (conn->ref.get() != nullptr)
+    statement.reset(conn->ref.get()->createStatement());
 
   auto schemaSymbols = _databaseSymbols.getSymbolsOfType<SchemaSymbol>();
   for (SchemaSymbol *schemaSymbol : schemaSymbols) {
     if (schemaSymbol->name == schema_name) {
       schemaSymbol->clear();
-      for (auto table : *tables) {
-        TableSymbol *tableSymbol = _databaseSymbols.addNewSymbol<TableSymbol>(schemaSymbol, table);
 
-        // Fetch column info for each table.
-        if (statement != nullptr) {
-          std::auto_ptr<sql::ResultSet> rs(statement->executeQuery(
-            std::string(base::sqlstring("SHOW FULL COLUMNS FROM !.!", 0) << schema_name << table)));
+      // Add the object names first, so that open auto completion lists can show them while the columns
+      // are still being fetched.
+      std::vector<ScopedSymbol *> columnOwners;
+      for (auto table : *tables)
+        columnOwners.push_back(_databaseSymbols.addNewSymbol<TableSymbol>(schemaSymbol, table));
+      for (auto view : *views)
+        columnOwners.push_back(_databaseSymbols.addNewSymbol<ViewSymbol>(schemaSymbol, view));
 
-          while (rs->next()) {
-            _databaseSymbols.addNewSymbol<ColumnSymbol>(tableSymbol, rs->getString(1), nullptr);
-          }
-        }
+      for (auto procedure : *procedures) {
+        _databaseSymbols.addNewSymbol<StoredRoutineSymbol>(schemaSymbol, procedure, nullptr);
+      }
+
+      for (auto function : *functions) {
+        _databaseSymbols.addNewSymbol<StoredRoutineSymbol>(schemaSymbol, function, nullptr);
       }
-      for (auto view : *views) {
-        ViewSymbol *viewSymbol = _databaseSymbols.addNewSymbol<ViewSymbol>(schemaSymbol, view);
 
-        // Same for each view.
-        if (statement != nullptr) {
+      if (statement == nullptr)
+        break;
+
+      bec::GRTManager::get()->run_once_when_idle(
+        this, std::bind(&SqlEditorForm::update_auto_completion_for_editors, this));
+
+      // Fetch column info for all tables and views, in a single query if the server allows it.
+      if (rdbms_version().is_valid() && is_supported_mysql_version_at_least(rdbms_version(), 5, 5)) {
+        std::map<std::string, ScopedSymbol *> ownersByName;
+        for (auto owner : columnOwners)
+          ownersByName[owner->name] = owner;
+
+        // The cached columns are dropped whenever the schema content changes, so they can be used as is.
+        SchemaMetadataCache::ColumnList columns;
+        if (_schema_metadata_cache == nullptr || !_schema_metadata_cache->get_columns(schema_name, columns)) {
+          std::unique_ptr<sql::ResultSet> rs(statement->executeQuery(
+            std::string(base::sqlstring("SELECT TABLE_NAME, COLUMN_NAME FROM INFORMATION_SCHEMA.COLUMNS "
+                                        "WHERE TABLE_SCHEMA = ? ORDER BY TABLE_NAME, ORDINAL_POSITION",
+                                        0)
+                        << schema_name)));
+          while (rs->next())
+            columns.push_back({ rs->getString(1), rs->getString(2) });
+
+          if (_schema_metadata_cache != nullptr)
+            _schema_metadata_cache->store_columns(schema_name, columns);
+        }
+
+        for (auto &column : columns) {
+          auto iterator = ownersByName.find(column.first);
+          if (iterator != ownersByName.end())
+            _databaseSymbols.addNewSymbol<ColumnSymbol>(iterator->second, column.second, nullptr);
+        }
+      } else {
+        for (auto owner : columnOwners) {
           std::auto_ptr<sql::ResultSet> rs(statement->executeQuery(
-            std::string(base::sqlstring("SHOW FULL COLUMNS FROM !.!", 0) << schema_name << view)));
+            std::string(base::sqlstring("SHOW FULL COLUMNS FROM !.!", 0) << schema_name << owner->name)));
 
           while (rs->next()) {
-            _databaseSymbols.addNewSymbol<ColumnSymbol>(viewSymbol, rs->getString(1), nullptr);
+            _databaseSymbols.addNewSymbol<ColumnSymbol>(owner, rs->getString(1), nullptr);
           }
         }
       }
+      break;
+    }
+  }
 
-      for (auto procedure : *procedures) {
-        _databaseSymbols.addNewSymbol<StoredRoutineSymbol>(schemaSymbol, procedure, nullptr);
+  bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlEditorForm::update_auto_completion_for_editors, this));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Upper limit for the remembered prefetched tables. If reached the list starts over.
+static const size_t MAX_PREFETCHED_TABLES = 5000;
+
+/**
+ * Called (in the main thread) with the tables referenced by an editor. Those whose columns are not known to auto
+ * completion yet, because their schema was not loaded, get them fetched in the background over a metadata connection.
+ */
+void SqlEditorForm::prefetch_table_columns(const MySQLEditor::TableReferences &references) {
+  if (!connected() || !rdbms_version().is_valid() || !is_supported_mysql_version_at_least(rdbms_version(), 5, 5))
+    return;
+
+  if (_prefetched_tables.size() + references.size() > MAX_PREFETCHED_TABLES)
+    _prefetched_tables.clear();
+
+  std::string default_schema = active_schema();
+  std::map<std::string, std::vector<std::string> > missing;
+  {
+    std::unique_lock<std::mutex> lock(_pimplMutex->_symbolsMutex);
+    for (auto &reference : references) {
+      std::string schema = reference.first.empty() ? default_schema : reference.first;
+      if (schema.empty() || !_prefetched_tables.insert({ schema, reference.second }).second)
+        continue;
+
+      // Unknown schemas are skipped, as are tables with columns.
+      ScopedSymbol *schemaSymbol = dynamic_cast<SchemaSymbol *>(_databaseSymbols.resolve(schema, true));
+      if (schemaSymbol == nullptr)
+        continue;
+      ScopedSymbol *owner = dynamic_cast<ScopedSymbol *>(schemaSymbol->resolve(reference.second, true));
+      if (owner == nullptr || owner->getSymbolsOfType<ColumnSymbol>().empty())
+        missing[schema].push_back(reference.second);
+    }
+  }
+
+  if (!missing.empty())
+    _column_prefetch_task->exec(false, std::bind(&SqlEditorForm::do_prefetch_table_columns, this, weak_ptr_from(this),
+                                                 missing));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+grt::StringRef SqlEditorForm::do_prefetch_table_columns(Ptr self_ptr,
+                                                        std::map<std::string, std::vector<std::string> > tables) {
+  std::shared_ptr<SqlEditorForm> self_ref = self_ptr.lock();
+  if (!self_ref)
+    return grt::StringRef("");
+
+  try {
+    sql::Dbc_connection_handler::Ref conn;
+    RecMutexLock metadata_dbc_conn_mutex(ensure_valid_metadata_connection(conn, BackgroundMetadata));
+    if (conn->ref.get() == nullptr)
+      return grt::StringRef("");
+    std::unique_ptr<sql::Statement> statement(conn->ref->createStatement());
+
+    for (auto &entry : tables) {
+      // Columns of a whole schema in the persistent cache are used without a query. A partial list is not stored.
+      SchemaMetadataCache::ColumnList columns;
+      if (_schema_metadata_cache == nullptr || !_schema_metadata_cache->get_columns(entry.first, columns)) {
+        std::string table_list;
+        for (auto &table : entry.second)
+          table_list += (table_list.empty() ? "" : ", ") + std::string(base::sqlstring("?", 0) << table);
+
+        std::unique_ptr<sql::ResultSet> rs(statement->executeQuery(
+          std::string(base::sqlstring("SELECT TABLE_NAME, COLUMN_NAME FROM INFORMATION_SCHEMA.COLUMNS "
+                                      "WHERE TABLE_SCHEMA = ?",
+                                      0)
+                      << entry.first) +
+          " AND TABLE_NAME IN (" + table_list + ") ORDER BY TABLE_NAME, ORDINAL_POSITION"));
+        while (rs->next())
+          columns.push_back({ rs->getString(1), rs->getString(2) });
       }
 
-      for (auto function : *functions) {
-        _databaseSymbols.addNewSymbol<StoredRoutineSymbol>(schemaSymbol, function, nullptr);
+      std::unique_lock<std::mutex> lock(_pimplMutex->_symbolsMutex);
+      ScopedSymbol *schemaSymbol = dynamic_cast<SchemaSymbol *>(_databaseSymbols.resolve(entry.first, true));
+      if (schemaSymbol == nullptr)
+        continue;
+
+      // Tables which got their columns in the meantime (a schema load) are left alone.
+      std::map<std::string, ScopedSymbol *> owners;
+      for (auto &table : entry.second) {
+        ScopedSymbol *owner = dynamic_cast<ScopedSymbol *>(schemaSymbol->resolve(table, true));
+        if (owner == nullptr)
+          owners[table] = nullptr;
+        else if (owner->getSymbolsOfType<ColumnSymbol>().empty())
+          owners[table] = owner;
+      }
+
+      for (auto &column : columns) {
+        auto iterator = owners.find(column.first);
+        if (iterator == owners.end())
+          continue;
+        if (iterator->second == nullptr)
+          iterator->second = _databaseSymbols.addNewSymbol<TableSymbol>(schemaSymbol, column.first);
+        _databaseSymbols.addNewSymbol<ColumnSymbol>(iterator->second, column.second, nullptr);
       }
-      return;
     }
+  } catch (std::exception &e) {
+    logWarning("Error prefetching column info: %s\n", e.what());
   }
+
+  bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlEditorForm::update_auto_completion_for_editors, this));
+  return grt::StringRef("");
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -3107,6 +4157,9 @@ void SqlEditorForm::note_connection_open_outcome(int error) {
       break;
   }
 
+  // Connections of an editor are opened in parallel.
+  static std::mutex stateMutex;
+  std::lock_guard<std::mutex> lock(stateMutex);
   if (_last_server_running_state != newState && newState != UnknownState) {
     grt::DictRef info(true);
     _last_server_running_state = newState;
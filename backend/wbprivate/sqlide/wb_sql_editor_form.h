@@ -34,6 +34,7 @@
 #include "grtpp_notifications.h"
 
 #include "sqlide/recordset_be.h"
+#include "sqlide/recordset_cdbc_storage.h"
 #include "sqlide/sql_editor_be.h"
 #include "sqlide/db_sql_editor_log.h"
 #include "sqlide/db_sql_editor_history_be.h"
@@ -46,6 +47,9 @@
 
 #include "SymbolTable.h"
 
+#include <atomic>
+#include <map>
+
 namespace mforms {
   class ToolBar;
   class AppView;
@@ -64,6 +68,8 @@ namespace bec {
 class QuerySidePalette;
 class SqlEditorTreeController;
 class ColumnWidthCache;
+class SchemaMetadataCache;
+class QueryStatsCache;
 class SqlEditorPanel;
 class SqlEditorResult;
 
@@ -99,10 +105,32 @@ public:
     std::string generator_query;
 
     double duration;
+
+    // Phases of the statement as measured by do_exec_sql(), in nanoseconds. The fetch timings are for all rows
+    // and get set once the last row was read, fetch_complete tells when.
+    std::uint64_t start_time;    // Tracer::now() when the statement was taken from the script.
+    std::uint64_t parse_time;    // Splitting the script and analyzing the statement.
+    std::uint64_t execute_time;  // Sending it until the server responded.
+    std::uint64_t transfer_time; // Getting the result set, which receives all of a buffered result.
+    Recordset_cdbc_storage::FetchTimings fetch_timings;
+    std::atomic<bool> fetch_complete;
+    std::uint64_t ui_ready_time; // From start_time until the result panel was added, 0 before that.
+
     std::string ps_stat_error;
     std::map<std::string, std::int64_t> ps_stat_info;
     std::vector<PSStage> ps_stage_info;
     std::vector<PSWait> ps_wait_info;
+
+    RecordsetData()
+      : result_panel(nullptr),
+        duration(0),
+        start_time(0),
+        parse_time(0),
+        execute_time(0),
+        transfer_time(0),
+        fetch_complete(false),
+        ui_ready_time(0) {
+    }
   };
 
 public:
@@ -127,6 +155,7 @@ protected:
   void update_toolbar_icons();
 
   void save_workspace_order(const std::string &prefix);
+  void write_workspace_file(const std::string &path, const std::string &data);
   std::string find_workspace_state(const std::string &workspace_name, std::auto_ptr<base::LockFile> &lock_file);
 
 public:
@@ -204,6 +233,8 @@ public:
   int sql_editor_count();
   int sql_editor_panel_index(SqlEditorPanel *panel);
 
+  void limit_result_memory();
+
   virtual mforms::DragOperation drag_over(mforms::View *sender, base::Point p, mforms::DragOperation allowedOperations,
                                           const std::vector<std::string> &formats);
   virtual mforms::DragOperation files_dropped(mforms::View *sender, base::Point p,
@@ -286,10 +317,17 @@ public:
   db_mgmt_SSHConnectionRef getSSHConnection();
 
   bool get_session_variable(sql::Connection *dbc_conn, const std::string &name, std::string &value);
+  // Same, but takes the variables read when the connection was opened if the variable is one of them.
+  bool get_session_variable(const sql::Dbc_connection_handler::Ref &conn, const std::string &name, std::string &value);
+
+  static db_mgmt_ConnectionRef editor_connection_properties(const db_mgmt_ConnectionRef &connection);
 
 private:
   void cache_sql_mode();
+  void update_sql_mode(const std::string &sql_mode);
+  void cache_user_variables();
   void update_sql_mode_for_editors();
+  void update_auto_completion_for_editors();
 
   void query_ps_statistics(std::int64_t conn_id, std::map<std::string, std::int64_t> &stats);
 
@@ -313,14 +351,19 @@ private:
 
 public:
   base::RecMutexLock ensure_valid_aux_connection(sql::Dbc_connection_handler::Ref &conn, bool lockOnly = false);
+
+  enum MetadataPriority { InteractiveMetadata, BackgroundMetadata };
+  base::RecMutexLock ensure_valid_metadata_connection(sql::Dbc_connection_handler::Ref &conn,
+                                                      MetadataPriority priority);
   parsers::MySQLParserContext::Ref work_parser_context() {
     return _work_parser_context;
   };
 
 private:
   void send_message_keep_alive();
+  void send_idle_keep_alive();
   bool send_message_keep_alive_bool_wrapper() {
-    send_message_keep_alive();
+    send_idle_keep_alive();
     return false;
   } // need it for ThreadedTimer, which expects callbacks to return bool
   void reset_keep_alive_thread();
@@ -335,16 +378,31 @@ public:
     return _column_width_cache;
   }
 
+  SchemaMetadataCache *schema_metadata_cache() {
+    return _schema_metadata_cache.get();
+  }
+
+  QueryStatsCache *query_stats_cache() {
+    return _query_stats_cache;
+  }
+
   bool exec_editor_sql(SqlEditorPanel *editor, bool sync, bool current_statement_only = false,
                        bool wrap_with_non_std_delimiter = false, bool dont_add_limit_clause = false,
                        SqlEditorResult *into_result = NULL);
   void exec_sql_retaining_editor_contents(const std::string &sql_script, SqlEditorPanel *editor, bool sync,
                                           bool dont_add_limit_clause = false);
+  void exec_sql_file(const std::string &path);
+  void export_query_to_file(const std::string &query, const std::string &format, const std::string &path, bool gzip,
+                            const std::map<std::string, std::string> &parameters);
+  void export_current_statement_to_file();
 
   RecordsetsRef exec_sql_returning_results(const std::string &sql_script, bool dont_add_limit_clause);
 
   void exec_management_sql(const std::string &sql, bool log);
   db_query_ResultsetRef exec_management_query(const std::string &sql, bool log);
+  grt::DictRef import_table_data(const grt::DictRef &options);
+  grt::DictListRef query_statistics(const std::string &order, ssize_t limit);
+  void clear_query_statistics();
 
   void exec_main_sql(const std::string &sql, bool log);
   db_query_ResultsetRef exec_main_query(const std::string &sql, bool log);
@@ -362,8 +420,15 @@ private:
 
   grt::StringRef do_exec_sql(Ptr self_ptr, std::shared_ptr<std::string> sql, SqlEditorPanel *editor, ExecFlags flags,
                              RecordsetsRef result_list);
+  grt::StringRef do_exec_sql_file(Ptr self_ptr, const std::string &path);
+  grt::StringRef do_export_query_to_file(Ptr self_ptr, const std::string &query, const std::string &format,
+                                         const std::string &path, bool gzip,
+                                         const std::map<std::string, std::string> &parameters);
+  size_t exec_statement_batch(const std::vector<std::string> &statements, bool &failed);
 
   void handle_command_side_effects(const std::string &sql);
+  void notify_object_dropped(const std::string &object_type, const std::string &schema, const std::string &name);
+  void schema_object_dropped(const std::string &object_type, const std::string &schema, const std::string &name);
 
 public:
   GrtThreadedTask::Ref exec_sql_task;
@@ -431,6 +496,7 @@ public:
 
   void schema_meta_data_refreshed(const std::string &schema_name, base::StringListPtr tables, base::StringListPtr views,
                                   base::StringListPtr procedures, base::StringListPtr functions);
+  void prefetch_table_columns(const MySQLEditor::TableReferences &references);
 
 private:
   void cache_active_schema_name();
@@ -506,6 +572,7 @@ private:
   std::string _connection_info;
   base::LockFile *_autosave_lock = nullptr;
   std::string _autosave_path;
+  std::map<std::string, std::string> _autosave_files; // workspace state files as last written
 
   mforms::DockingPoint *_tabdock = nullptr;
 
@@ -514,6 +581,7 @@ private:
   boost::signals2::connection _editorRefreshPending;
 
   int _keep_alive_task_id = 0;
+  long _keep_alive_interval = 0;
   base::Mutex _keep_alive_thread_mutex;
 
   Batch_exec_progress_cb on_sql_script_run_progress;
@@ -553,15 +621,33 @@ private:
   sql::Dbc_connection_handler::Ref _usr_dbc_conn;
   mutable base::RecMutex _usr_dbc_conn_mutex;
 
+  // connections for reading meta data (schema tree, code completion), created when first needed
+  static const int MAX_METADATA_CONNECTIONS = 4;
+  sql::Dbc_connection_handler::Ref _metadata_dbc_conns[MAX_METADATA_CONNECTIONS];
+  base::RecMutex _metadata_dbc_conn_mutexes[MAX_METADATA_CONNECTIONS];
+  int _metadata_connection_count = 1;
+
+  base::RecMutexLock ensure_valid_metadata_connection(int index, bool throw_on_block);
+  void open_metadata_connection(int index, std::shared_ptr<sql::TunnelConnection> tunnel,
+                                sql::Authentication::Ref auth);
+  void close_metadata_connections();
+
   sql::Authentication::Ref _dbc_auth;
 
   ServerState _last_server_running_state = UnknownState;
 
   ColumnWidthCache *_column_width_cache = nullptr;
+  std::shared_ptr<SchemaMetadataCache> _schema_metadata_cache; // shared with the other editors of the connection
+  QueryStatsCache *_query_stats_cache = nullptr;
 
   parsers::SymbolTable _staticServerSymbols; // Charsets, collations, engines.
   parsers::SymbolTable _databaseSymbols; // All available db objects reachable via the current connection.
 
+  // Tables referenced in editors whose columns were prefetched already (or are being), so each is loaded once.
+  std::set<std::pair<std::string, std::string> > _prefetched_tables;
+  GrtThreadedTask::Ref _column_prefetch_task;
+  grt::StringRef do_prefetch_table_columns(Ptr self_ptr, std::map<std::string, std::vector<std::string> > tables);
+
   void activate_command(const std::string &command);
   void readStaticServerSymbols();
 
@@ -22,6 +22,9 @@
  */
 
 #include <pcrecpp.h>
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
 #include <thread>
 
 #include "base/log.h"
@@ -43,6 +46,10 @@
 
 DEFAULT_LOG_DOMAIN("Context help")
 
+// Identifies the index file layout and the way the help text in it is generated. Change the digits whenever
+// one of them changes, so that existing index files are rebuilt.
+#define HELP_INDEX_MAGIC "WBHLP001"
+
 using namespace parsers;
 using namespace antlr4;
 
@@ -277,6 +284,216 @@ std::string DbSqlEditorContextHelp::createHelpTextFromJson(long version, JsonPar
   return result;
 }
 
+//----------------- HelpIndex ------------------------------------------------------------------------------------------
+
+namespace {
+  struct IndexHeader {
+    char magic[8];
+    int64_t sourceTime; // Modification time of the JSON file the index was built from.
+    uint32_t count;
+    uint32_t reserved;
+  };
+
+  struct IndexEntry {
+    uint32_t topicOffset; // Offsets are relative to the string block following the entries.
+    uint32_t topicLength;
+    uint32_t textOffset;
+    uint32_t textLength;
+  };
+
+  std::string helpFilePath(const std::string &dir, long version, const std::string &extension) {
+    return base::makePath(dir, "help-" + std::to_string(version / 100) + "." + std::to_string(version % 10) +
+                                 extension);
+  }
+}
+
+/**
+ * The help of one server version: a header, the topic entries sorted by topic and a block with the topics and their
+ * HTML texts. The index is built once from the JSON help file and written to the user data folder. Later runs only
+ * map that file, so there is no parsing and a lookup is a binary search in the mapped data.
+ */
+class DbSqlEditorContextHelp::HelpIndex {
+public:
+  // Returns nullptr if the file cannot be mapped or was not built from the given source.
+  static HelpIndex *open(const std::string &path, int64_t sourceTime) {
+    if (!base::file_exists(path))
+      return nullptr;
+
+    GError *error = nullptr;
+    GMappedFile *file = g_mapped_file_new(path.c_str(), FALSE, &error);
+    if (file == nullptr) {
+      logWarning("Could not map help index %s: %s\n", path.c_str(), error->message);
+      g_error_free(error);
+      return nullptr;
+    }
+
+    HelpIndex *index = new HelpIndex(file);
+    if (!index->isValid(sourceTime)) {
+      logInfo("Help index %s is outdated, rebuilding it\n", path.c_str());
+      delete index;
+      return nullptr;
+    }
+    return index;
+  }
+
+  // Serializes the given topics (upper case topic -> HTML text) into the index layout.
+  static std::string build(const std::map<std::string, std::string> &topics, int64_t sourceTime) {
+    std::vector<IndexEntry> entries;
+    std::string strings;
+    entries.reserve(topics.size());
+    for (auto &topic : topics) {
+      IndexEntry entry;
+      entry.topicOffset = (uint32_t)strings.size();
+      entry.topicLength = (uint32_t)topic.first.size();
+      strings += topic.first;
+      entry.textOffset = (uint32_t)strings.size();
+      entry.textLength = (uint32_t)topic.second.size();
+      strings += topic.second;
+      entries.push_back(entry);
+    }
+
+    IndexHeader header;
+    memcpy(header.magic, HELP_INDEX_MAGIC, sizeof(header.magic));
+    header.sourceTime = sourceTime;
+    header.count = (uint32_t)entries.size();
+    header.reserved = 0;
+
+    std::string data;
+    data.reserve(sizeof(header) + entries.size() * sizeof(IndexEntry) + strings.size());
+    data.append((const char *)&header, sizeof(header));
+    data.append((const char *)entries.data(), entries.size() * sizeof(IndexEntry));
+    data += strings;
+    return data;
+  }
+
+  // An index kept in memory, for when it could not be written to disk.
+  explicit HelpIndex(std::string &&data) : _file(nullptr), _buffer(std::move(data)) {
+    _data = _buffer.data();
+    _size = _buffer.size();
+    isValid(0);
+  }
+
+  ~HelpIndex() {
+    if (_file != nullptr)
+      g_mapped_file_unref(_file);
+  }
+
+  // Returns true if the topic exists and, if text is given, copies its help text there.
+  bool find(const std::string &topic, std::string *text) const {
+    const IndexEntry *end = _entries + _count;
+    const IndexEntry *entry = std::lower_bound(_entries, end, topic, [this](const IndexEntry &entry,
+                                                                            const std::string &topic) {
+      return compare(topic, entry) > 0;
+    });
+    if (entry == end || compare(topic, *entry) != 0)
+      return false;
+
+    if (text != nullptr)
+      text->assign(_strings + entry->textOffset, entry->textLength);
+    return true;
+  }
+
+private:
+  GMappedFile *_file;
+  std::string _buffer;
+  const char *_data;
+  size_t _size;
+  const IndexEntry *_entries = nullptr;
+  const char *_strings = nullptr;
+  uint32_t _count = 0;
+
+  int compare(const std::string &topic, const IndexEntry &entry) const {
+    return topic.compare(0, std::string::npos, _strings + entry.topicOffset, entry.topicLength);
+  }
+
+  explicit HelpIndex(GMappedFile *file) : _file(file) {
+    _data = g_mapped_file_get_contents(file);
+    _size = g_mapped_file_get_length(file);
+  }
+
+  // Checks the header and all offsets, so that a truncated or foreign file never causes reads outside the data.
+  // A sourceTime of 0 accepts any source.
+  bool isValid(int64_t sourceTime) {
+    _count = 0;
+    if (_data == nullptr || _size < sizeof(IndexHeader))
+      return false;
+
+    const IndexHeader *header = (const IndexHeader *)_data;
+    if (memcmp(header->magic, HELP_INDEX_MAGIC, sizeof(header->magic)) != 0)
+      return false;
+    if (sourceTime != 0 && header->sourceTime != sourceTime)
+      return false;
+    if (header->count > (_size - sizeof(IndexHeader)) / sizeof(IndexEntry))
+      return false;
+
+    const IndexEntry *entries = (const IndexEntry *)(_data + sizeof(IndexHeader));
+    size_t stringsOffset = sizeof(IndexHeader) + header->count * sizeof(IndexEntry);
+    uint64_t stringsSize = _size - stringsOffset;
+    for (uint32_t i = 0; i < header->count; ++i) {
+      if ((uint64_t)entries[i].topicOffset + entries[i].topicLength > stringsSize ||
+          (uint64_t)entries[i].textOffset + entries[i].textLength > stringsSize)
+        return false;
+    }
+
+    _entries = entries;
+    _strings = _data + stringsOffset;
+    _count = header->count;
+    return true;
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the JSON help file of the given version and converts it to an index, which is written to indexPath
+ * (if not empty) for the next runs. Returns nullptr if the help file could not be read.
+ */
+DbSqlEditorContextHelp::HelpIndex *DbSqlEditorContextHelp::buildIndex(long version, const std::string &sourcePath,
+                                                                      const std::string &indexPath) {
+  std::string fileName = base::basename(sourcePath);
+  time_t sourceTime = 0;
+  base::file_mtime(sourcePath, sourceTime);
+
+  std::map<std::string, std::string> topics;
+  try {
+    JsonParser::JsonValue document;
+    JsonParser::JsonReader::readFromFile(sourcePath, document);
+
+    JsonParser::JsonObject &topicRoot = document;
+    JsonParser::JsonArray &topicList = topicRoot.get("topics");
+    for (JsonParser::JsonObject &topic: topicList) {
+      std::string id = base::toupper(topic.get("id"));
+      topics[id] = createHelpTextFromJson(version, topic);
+    }
+  } catch (JsonParser::ParserException &e) {
+    logError("Could not read help text file (%s)\nError message: %s\n", fileName.c_str(), e.what());
+    return nullptr;
+  } catch (std::bad_cast &e) {
+    logError("Unexpected file format (%s)\nError message: %s\n", fileName.c_str(), e.what());
+    return nullptr;
+  }
+
+  std::string data = HelpIndex::build(topics, sourceTime);
+  if (!indexPath.empty()) {
+    // Written under a temporary name first, so a concurrently starting instance never maps a partial file.
+    std::string tempPath = indexPath + ".tmp";
+    try {
+      {
+        base::FileHandle file(tempPath, "wb");
+        if (fwrite(data.data(), 1, data.size(), file.file()) != data.size())
+          throw base::file_error("Failed to write file \"" + tempPath + "\"", errno);
+      }
+      base::tryRemove(indexPath);
+      base::rename(tempPath, indexPath);
+    } catch (std::exception &e) {
+      logWarning("Could not write help index %s: %s\n", indexPath.c_str(), e.what());
+      base::tryRemove(tempPath);
+    }
+  }
+
+  return new HelpIndex(std::move(data));
+}
+
 //----------------- DbSqlEditorContextHelp -----------------------------------------------------------------------------
 
 DbSqlEditorContextHelp::DbSqlEditorContextHelp() {
@@ -287,43 +504,43 @@ DbSqlEditorContextHelp::DbSqlEditorContextHelp() {
     { "auto_increment", "example-auto-increment" },
   };
 
-  loaderThread = std::thread([this]() {
-    std::string dataDir = base::makePath(mforms::App::get()->baseDir(), "modules/data/sqlide");
-    for (long version : { 800, 507, 506, 505 }) {
-      std::string fileName = "help-" + std::to_string(version / 100) + "." + std::to_string(version % 10) + ".json";
-      std::string path = base::makePath(dataDir, fileName);
-      if (!base::file_exists(path)) {
-        logError("Help file not found (%s)\n", path.c_str());
-        continue;
-      }
+  // Help indexes built by a previous run are only mapped. The others are built from the JSON help files in the
+  // background, which waitForLoading() waits for.
+  std::string dataDir = base::makePath(mforms::App::get()->baseDir(), "modules/data/sqlide");
+  std::string indexDir = mforms::App::get()->get_user_data_folder();
+  std::vector<long> missingVersions;
+  for (long version : { 800, 507, 506, 505 }) {
+    std::string path = helpFilePath(dataDir, version, ".json");
+    if (!base::file_exists(path)) {
+      logError("Help file not found (%s)\n", path.c_str());
+      continue;
+    }
 
-      try {
-        JsonParser::JsonValue document;
-        JsonParser::JsonReader::readFromFile(path, document);
-
-        std::set<std::string> topics;
-        JsonParser::JsonObject &topicRoot = document;
-        JsonParser::JsonArray &topicList = topicRoot.get("topics");
-        for (JsonParser::JsonObject &topic: topicList) {
-          std::string id = base::toupper(topic.get("id"));
-          topics.insert(id);
-          helpContent[version][id] = createHelpTextFromJson(version, topic);
-        }
-        helpTopics[version] = topics;
-      } catch (JsonParser::ParserException &e) {
-        logError("Could not read help text file (%s)\nError message: %s\n", fileName.c_str(), e.what());
-      } catch (std::bad_cast &e) {
-        logError("Unexpected file format (%s)\nError message: %s\n", fileName.c_str(), e.what());
+    time_t sourceTime = 0;
+    base::file_mtime(path, sourceTime);
+    HelpIndex *index = indexDir.empty() ? nullptr : HelpIndex::open(helpFilePath(indexDir, version, ".idx"), sourceTime);
+    helpIndexes[version] = index;
+    if (index == nullptr)
+      missingVersions.push_back(version);
+  }
+
+  if (!missingVersions.empty()) {
+    // The entries exist already, the thread only sets their values.
+    loaderThread = std::thread([this, dataDir, indexDir, missingVersions]() {
+      for (long version : missingVersions) {
+        std::string indexPath = indexDir.empty() ? "" : helpFilePath(indexDir, version, ".idx");
+        helpIndexes[version] = buildIndex(version, helpFilePath(dataDir, version, ".json"), indexPath);
       }
-      
-    }
-  });
+    });
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 DbSqlEditorContextHelp::~DbSqlEditorContextHelp() {
   waitForLoading();
+  for (auto &index : helpIndexes)
+    delete index.second;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -341,10 +558,10 @@ void DbSqlEditorContextHelp::waitForLoading() {
 bool DbSqlEditorContextHelp::topicExists(long serverVersion, const std::string &topic) {
   waitForLoading();
 
-  auto iterator = helpTopics.find(serverVersion / 100);
-  if (iterator == helpTopics.end())
+  auto iterator = helpIndexes.find(serverVersion / 100);
+  if (iterator == helpIndexes.end() || iterator->second == nullptr)
     return false;
-  return iterator->second.count(topic) > 0;
+  return iterator->second->find(topic, nullptr);
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -353,11 +570,12 @@ bool DbSqlEditorContextHelp::helpTextForTopic(HelpContext *context, const std::s
   logDebug2("Looking up help topic: %s\n", topic.c_str());
 
   if (!loaderThread.joinable() && !topic.empty()) {
-    auto iterator = helpContent.find(context->serverVersion() / 100);
-    if (iterator == helpContent.end())
+    auto iterator = helpIndexes.find(context->serverVersion() / 100);
+    if (iterator == helpIndexes.end() || iterator->second == nullptr)
       return false;
 
-    text = iterator->second[topic];
+    text.clear();
+    iterator->second->find(topic, &text);
     return true;
   }
   return false;
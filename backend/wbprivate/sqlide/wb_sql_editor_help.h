@@ -58,15 +58,17 @@ namespace help {
     std::string helpTopicFromPosition(HelpContext *helpContext, const std::string &query, size_t caretPosition);
 
   protected:
+    class HelpIndex;
+
     std::thread loaderThread;
     std::map<std::string, std::string> pageMap;
-    std::map<long, std::set<std::string>> helpTopics;               // Quick lookup for help topics per server version.
-    std::map<long, std::map<std::string, std::string>> helpContent; // Help text from a topic (also per version).
+    std::map<long, HelpIndex *> helpIndexes; // Sorted topic table with the help texts, per server version.
 
     DbSqlEditorContextHelp();
     ~DbSqlEditorContextHelp();
 
     std::string createHelpTextFromJson(long version, JsonParser::JsonObject const &json);
+    HelpIndex *buildIndex(long version, const std::string &sourcePath, const std::string &indexPath);
     bool topicExists(long serverVersion, const std::string &topic);
   };
 
@@ -31,6 +31,7 @@
 #include "base/log.h"
 #include "base/file_functions.h"
 #include "base/util_functions.h"
+#include "base/trace.h"
 
 #include "mforms/toolbar.h"
 #include "mforms/menubar.h"
@@ -39,6 +40,7 @@
 #include "mforms/filechooser.h"
 
 #include "workbench/wb_command_ui.h"
+#include "sqlide/wb_sql_editor_buffer.h"
 
 #include "base/boost_smart_ptr_helpers.h"
 
@@ -57,6 +59,11 @@
 // 20 MB max file size for auto-restoring
 #define MAX_FILE_SIZE_FOR_AUTO_RESTORE 20000000
 
+// Buffers of this size or larger are auto-saved as changes to the last full snapshot.
+#define AUTOSAVE_DELTA_MIN_SIZE (1024 * 1024)
+// A new snapshot is written once the changes exceed this part of the buffer size.
+#define AUTOSAVE_DELTA_MAX_RATIO 4
+
 DEFAULT_LOG_DOMAIN("SqlEditorPanel");
 
 using namespace bec;
@@ -80,6 +87,10 @@ SqlEditorPanel::SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start
     _tab_action_apply(mforms::SmallButton),
     _tab_action_revert(mforms::SmallButton),
     _tab_action_info("Read Only"),
+    _autosave_delta_size(0),
+    _autosave_tracking(false),
+    _autosave_text_changed(true),
+    _autosave_text_written(false),
     _rs_sequence(0),
     _busy(false),
     _is_scratch(is_scratch) {
@@ -102,6 +113,8 @@ SqlEditorPanel::SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start
   _editor->set_sql_mode(owner->sql_mode());
   _editor->set_current_schema(owner->active_schema());
   UIForm::scoped_connect(_editor->text_change_signal(), std::bind(&SqlEditorPanel::update_title, this));
+  UIForm::scoped_connect(_editor->table_references_signal(),
+                         std::bind(&SqlEditorForm::prefetch_table_columns, owner, std::placeholders::_1));
 
   add(&_splitter, true, true);
 
@@ -115,6 +128,9 @@ SqlEditorPanel::SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start
   code_editor->set_status_text("");
   code_editor->set_show_find_panel_callback(
     std::bind(&SqlEditorPanel::show_find_panel, this, std::placeholders::_1, std::placeholders::_2));
+  UIForm::scoped_connect(code_editor->signal_changed(),
+                         std::bind(&SqlEditorPanel::text_modified, this, std::placeholders::_1, std::placeholders::_2,
+                                   std::placeholders::_3, std::placeholders::_4));
 
   if (start_collapsed)
     _editor->get_editor_control()->set_size(-1, 25);
@@ -373,12 +389,17 @@ static bool check_if_file_too_big_to_restore(const std::string &path, const std:
 #define EDITOR_TEXT_LIMIT 100 * 1024 * 1024
 
 SqlEditorPanel::AutoSaveInfo::AutoSaveInfo(const std::string &info_file) : word_wrap(false), show_special(false) {
-  wchar_t buffer[4098] = {0};
-  std::wifstream f;
-  openStream(info_file, f);
-  while (f.getline(buffer, sizeof(buffer))) {
+  // UTF-8, like the auto-save writes it
+  gchar *data = NULL;
+  gsize length = 0;
+  if (!g_file_get_contents(info_file.c_str(), &data, &length, NULL))
+    return;
+  std::vector<std::string> lines(base::split(std::string(data, length), "\n"));
+  g_free(data);
+
+  for (const std::string &line : lines) {
     std::string key, value;
-    base::partition(base::wstring_to_string(buffer), "=", key, value);
+    base::partition(base::trim_right(line, "\r"), "=", key, value);
     if (key == "orig_encoding")
       orig_encoding = value;
     else if (key == "type")
@@ -421,6 +442,38 @@ SqlEditorPanel::AutoSaveInfo SqlEditorPanel::AutoSaveInfo::old_autosave(const st
   return info;
 }
 
+static void merge_autosave_delta(const std::string &text_file, const std::string &delta_file) {
+  gchar *data = NULL;
+  gsize length = 0;
+  GError *error = NULL;
+  if (!g_file_get_contents(text_file.c_str(), &data, &length, &error)) {
+    std::string what = error->message;
+    g_error_free(error);
+    throw std::runtime_error(what);
+  }
+  std::string text(data, length);
+  g_free(data);
+
+  if (!g_file_get_contents(delta_file.c_str(), &data, &length, &error)) {
+    std::string what = error->message;
+    g_error_free(error);
+    throw std::runtime_error(what);
+  }
+  std::string delta(data, length);
+  g_free(data);
+
+  if (!SqlEditorPanel::apply_autosave_delta(text, delta))
+    logWarning("Auto-saved changes in %s are incomplete, restoring the text up to the last complete change\n",
+               delta_file.c_str());
+
+  if (!g_file_set_contents(text_file.c_str(), text.data(), (gssize)text.size(), &error)) {
+    std::string what = error->message;
+    g_error_free(error);
+    throw std::runtime_error(what);
+  }
+  base::remove(delta_file);
+}
+
 bool SqlEditorPanel::load_autosave(const AutoSaveInfo &info, const std::string &text_file) {
   _orig_encoding = info.orig_encoding;
   _file_timestamp = 0;
@@ -437,6 +490,11 @@ bool SqlEditorPanel::load_autosave(const AutoSaveInfo &info, const std::string &
     if (!info.filename.empty() && load_from(info.filename, info.orig_encoding, false) != Loaded)
       return false;
   } else {
+    // changes auto-saved after the snapshot of a large buffer
+    std::string delta_file = base::strip_extension(text_file) + ".delta";
+    if (base::file_exists(delta_file))
+      merge_autosave_delta(text_file, delta_file);
+
     // check if autosave too big
     if (!check_if_file_too_big_to_restore(text_file, strfmt("Saved editor '%s'", info.title.c_str()))) {
       return false;
@@ -481,13 +539,14 @@ SqlEditorPanel::LoadResult SqlEditorPanel::load_from(const std::string &file, co
     int result = mforms::Utilities::show_warning(
       _("Large File"), strfmt(_("The file \"%s\" has a size "
                                 "of %.2f MB. Are you sure you want to open this large file?\n\nNote: code folding "
-                                "will be disabled for this file.\n\nClick Run SQL Script... to just execute the file."),
+                                "will be disabled for this file.\n\nClick Execute to run the statements directly "
+                                "from the file, without loading it into the editor."),
                               file.c_str(), file_size / 1024.0 / 1024.0),
-      _("Open"), _("Cancel"), _("Run SQL Script..."));
+      _("Open"), _("Cancel"), _("Execute"));
     if (result == mforms::ResultCancel)
       return Cancelled;
     else if (result == mforms::ResultOther)
-      return RunInstead;
+      return ExecuteInstead;
   }
 
   _orig_encoding = encoding;
@@ -634,10 +693,12 @@ std::string SqlEditorPanel::autosave_file_suffix() {
 //--------------------------------------------------------------------------------------------------
 
 void SqlEditorPanel::auto_save(const std::string &path) {
+  SqlEditorAutoSaver *saver = SqlEditorAutoSaver::get();
+  bool new_dir = path != _autosave_dir;
+  _autosave_dir = path;
+
   // save info about the file
   {
-    std::wofstream f;
-    openStream(base::makePath(path, _autosave_file_suffix + ".info"), f);
     std::string content;
     if (_is_scratch)
       content += "type=scratch\n";
@@ -666,50 +727,126 @@ void SqlEditorPanel::auto_save(const std::string &path) {
     size_t first_line = _editor->get_editor_control()->send_editor(SCI_GETFIRSTVISIBLELINE, 0, 0);
     content += "first_visible_line=" + std::to_string(first_line) + "\n";
 
-    if (f.good())
-      f << base::string_to_wstring(content);
-    f.close();
+    if (new_dir || content != _autosave_info) {
+      saver->write(base::makePath(path, _autosave_file_suffix + ".info"), content);
+      _autosave_info = content;
+    }
   }
 
   std::string fn = base::makePath(path, _autosave_file_suffix + ".scratch");
+  std::string delta_fn = base::makePath(path, _autosave_file_suffix + ".delta");
 
   // only save editor contents for scratch areas and unsaved editors
-  if (_is_scratch || _filename.empty() || (!_filename.empty() && is_dirty())) {
-    // We don't need to lock the editor as we are in the main thread here
-    // and directly set the file content without detouring to anything that could change the text.
-    GError *error = 0;
+  if (!_is_scratch && !_filename.empty() && !is_dirty()) {
+    // delete the autosave file if the file was saved
+    if (_autosave_text_written || new_dir) {
+      saver->remove(delta_fn);
+      saver->remove(fn);
+    }
+    _autosave_text_written = false;
+    _autosave_tracking = false;
+    _autosave_delta_size = 0;
+    std::string().swap(_autosave_delta);
+    return;
+  }
 
+  if (!new_dir && _autosave_text_written && !_autosave_text_changed)
+    return;
+
+  if (!new_dir && _autosave_text_written && _autosave_tracking) {
+    saver->append(delta_fn, _autosave_delta);
+    _autosave_delta_size += _autosave_delta.size();
+  } else {
+    // We don't need to lock the editor as we are in the main thread here. The old changes are removed first,
+    // so an interrupted auto-save leaves the previous snapshot and never a snapshot with changes not meant for it.
     std::pair<const char *, size_t> text = text_data();
-    if (!g_file_set_contents(fn.c_str(), text.first, text.second, &error)) {
-      logError("Could not save snapshot of editor contents to %s: %s\n", fn.c_str(), error->message);
-      std::string msg(strfmt("Could not save snapshot of editor contents to %s: %s", fn.c_str(), error->message));
-      g_error_free(error);
-      throw std::runtime_error(msg);
+    if (_autosave_delta_size > 0)
+      saver->remove(delta_fn);
+    saver->write(fn, std::string(text.first, text.second));
+    _autosave_delta_size = 0;
+    _autosave_tracking = text.second >= AUTOSAVE_DELTA_MIN_SIZE;
+  }
+  _autosave_delta.clear();
+  _autosave_text_changed = false;
+  _autosave_text_written = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Records a change of the editor text for the next auto-save of a large buffer. Inserted text is read back
+ * from the editor, which has it already at this point.
+ */
+void SqlEditorPanel::text_modified(int position, int length, int lines_changed, bool added) {
+  _autosave_text_changed = true;
+  if (!_autosave_tracking)
+    return;
+
+  mforms::CodeEditor *code_editor = _editor->get_editor_control();
+  size_t limit = code_editor->text_length() / AUTOSAVE_DELTA_MAX_RATIO;
+  if (_autosave_delta_size + _autosave_delta.size() + (added ? length : 0) <= limit) {
+    if (!added) {
+      _autosave_delta.append(strfmt("-%d %d\n", position, length));
+      return;
     }
-  } else {
-    // delete the autosave file if the file was saved
-    try {
-      base::remove(fn);
-    } catch (std::exception &e) {
-      logWarning("Error deleting autosave file %s: %s\n", fn.c_str(), e.what());
+
+    std::string text = code_editor->get_text_in_range(position, position + length);
+    if ((int)text.size() == length) {
+      _autosave_delta.append(strfmt("+%d %d\n", position, length)).append(text);
+      return;
+    }
+  }
+
+  // too many changes (or text with NUL bytes), the next auto-save writes a full snapshot
+  _autosave_tracking = false;
+  std::string().swap(_autosave_delta);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Applies the changes recorded by text_modified() to an auto-saved snapshot. Returns false if the changes
+ * don't fit the text or end in an incomplete record, e.g. after a crash while appending. Changes before that are
+ * applied.
+ */
+bool SqlEditorPanel::apply_autosave_delta(std::string &text, const std::string &delta) {
+  size_t offset = 0;
+  while (offset < delta.size()) {
+    size_t end = delta.find('\n', offset);
+    if (end == std::string::npos)
+      return false;
+
+    char op = delta[offset];
+    unsigned long position = 0, length = 0;
+    if ((op != '+' && op != '-') ||
+        sscanf(delta.substr(offset + 1, end - offset - 1).c_str(), "%lu %lu", &position, &length) != 2 ||
+        position > text.size())
+      return false;
+    offset = end + 1;
+
+    if (op == '+') {
+      if (delta.size() - offset < length)
+        return false;
+      text.insert(position, delta, offset, length);
+      offset += length;
+    } else {
+      if (text.size() - position < length)
+        return false;
+      text.erase(position, length);
     }
   }
+  return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void SqlEditorPanel::delete_auto_save(const std::string &path) {
   // delete the autosave related files
-  try {
-    base::remove(base::makePath(path, _autosave_file_suffix + ".autosave"));
-  } catch (std::exception &exc) {
-    logWarning("Could not delete auto-save file: %s\n", exc.what());
-  }
-  try {
-    base::remove(base::makePath(path, _autosave_file_suffix + ".info"));
-  } catch (std::exception &exc) {
-    logWarning("Could not delete auto-save file: %s\n", exc.what());
-  }
+  SqlEditorAutoSaver *saver = SqlEditorAutoSaver::get();
+  saver->remove(base::makePath(path, _autosave_file_suffix + ".autosave"));
+  saver->remove(base::makePath(path, _autosave_file_suffix + ".info"));
+  saver->remove(base::makePath(path, _autosave_file_suffix + ".delta"));
+  _autosave_dir.clear();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1050,6 +1187,10 @@ void SqlEditorPanel::lower_tab_switched() {
   SqlEditorResult *result = active_result_panel();
   Recordset::Ref rset;
   if (result && (rset = result->recordset())) {
+    result->create_result_views();
+    result->mark_viewed();
+    _form->limit_result_memory();
+
     bool found = false;
     for (size_t c = qeditor->resultPanels().count(), i = 0; i < c; i++) {
       if (mforms_from_grt(qeditor->resultPanels()[i]->dockingPoint()) == result->dock()) {
@@ -1168,30 +1309,39 @@ SqlEditorResult *SqlEditorPanel::result_panel(int i) {
 
 //--------------------------------------------------------------------------------------------------
 
-void SqlEditorPanel::add_panel_for_recordset_from_main(Recordset::Ref rset) {
+void SqlEditorPanel::add_panel_for_recordset_from_main(Recordset::Ref rset, bool deferred) {
   if (bec::GRTManager::get()->in_main_thread()) {
     SqlEditorForm::RecordsetData *rdata = dynamic_cast<SqlEditorForm::RecordsetData *>(rset->client_data());
 
-    rdata->result_panel = add_panel_for_recordset(rset);
+    rdata->result_panel = add_panel_for_recordset(rset, deferred);
+    std::uint64_t ready = base::Tracer::now();
+    rdata->ui_ready_time = ready - rdata->start_time;
+    if (base::Tracer::enabled())
+      base::Tracer::record("sqlide", "SqlEditorPanel::result_ready", rdata->start_time, ready);
   } else
     bec::GRTManager::get()->run_once_when_idle(
-      dynamic_cast<bec::UIForm *>(this), std::bind(&SqlEditorPanel::add_panel_for_recordset_from_main, this, rset));
+      dynamic_cast<bec::UIForm *>(this),
+      std::bind(&SqlEditorPanel::add_panel_for_recordset_from_main, this, rset, deferred));
 }
 
 //--------------------------------------------------------------------------------------------------
 
-SqlEditorResult *SqlEditorPanel::add_panel_for_recordset(Recordset::Ref rset) {
+/**
+ * A deferred result gets its views when its tab is selected and docking it doesn't select it, which would create
+ * them right away.
+ */
+SqlEditorResult *SqlEditorPanel::add_panel_for_recordset(Recordset::Ref rset, bool deferred) {
   SqlEditorResult *result = mforms::manage(new SqlEditorResult(this));
   if (rset)
-    result->set_recordset(rset);
-  dock_result_panel(result);
+    result->set_recordset(rset, deferred);
+  dock_result_panel(result, !deferred || !rset);
 
   return result;
 }
 
 //--------------------------------------------------------------------------------------------------
 
-void SqlEditorPanel::dock_result_panel(SqlEditorResult *result) {
+void SqlEditorPanel::dock_result_panel(SqlEditorResult *result, bool select) {
   result->grtobj()->owner(grtobj());
   grtobj()->resultPanels().insert(result->grtobj());
 
@@ -1199,7 +1349,8 @@ void SqlEditorPanel::dock_result_panel(SqlEditorResult *result) {
     result->set_title(rset->caption());
 
   _lower_dock.dock_view(result);
-  _lower_dock.select_view(result);
+  if (select)
+    _lower_dock.select_view(result);
   _splitter.set_expanded(false, true);
   if (_was_empty) {
     int position = (int)bec::GRTManager::get()->get_app_option_int("DbSqlEditor:ResultSplitterPosition", 200);
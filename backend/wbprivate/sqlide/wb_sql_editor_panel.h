@@ -81,6 +81,15 @@ class MYSQLWBBACKEND_PUBLIC_FUNC SqlEditorPanel : public mforms::AppView {
 
   std::string _autosave_file_suffix;
 
+  // auto-save state, see auto_save()
+  std::string _autosave_dir;   // workspace dir the files were last written to
+  std::string _autosave_info;  // contents of the .info file written last
+  std::string _autosave_delta; // changes since the last auto-save, recorded for large buffers only
+  size_t _autosave_delta_size; // size of the .delta file written since the last full snapshot
+  bool _autosave_tracking;     // whether _autosave_delta holds all changes since the last auto-save
+  bool _autosave_text_changed;
+  bool _autosave_text_written;
+
   time_t _file_timestamp;
 
   int _rs_sequence;
@@ -92,7 +101,7 @@ class MYSQLWBBACKEND_PUBLIC_FUNC SqlEditorPanel : public mforms::AppView {
   mforms::ToolBar *setup_editor_toolbar();
   void update_title();
 
-  void dock_result_panel(SqlEditorResult *result);
+  void dock_result_panel(SqlEditorResult *result, bool select = true);
   void show_find_panel(mforms::CodeEditor *editor, bool show);
 
   void dispose_recordset(Recordset::Ptr rs_ptr);
@@ -123,6 +132,8 @@ class MYSQLWBBACKEND_PUBLIC_FUNC SqlEditorPanel : public mforms::AppView {
 
   void limit_rows(mforms::ToolBarItem *);
 
+  void text_modified(int position, int length, int lines_changed, bool added);
+
 public:
   typedef std::shared_ptr<SqlEditorPanel> Ref;
   SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start_collapsed);
@@ -165,7 +176,7 @@ public:
     static AutoSaveInfo old_autosave(const std::string &autosave_file);
   };
 
-  enum LoadResult { Cancelled, Loaded, RunInstead };
+  enum LoadResult { Cancelled, Loaded, RunInstead, ExecuteInstead };
 
   LoadResult load_from(const std::string &file, const std::string &encoding = "", bool keep_dirty = false);
   bool load_autosave(const AutoSaveInfo &info, const std::string &text_file);
@@ -178,6 +189,7 @@ public:
   void revert_to_saved();
 
   void auto_save(const std::string &directory);
+  static bool apply_autosave_delta(std::string &text, const std::string &delta);
   void delete_auto_save(const std::string &directory);
   std::string autosave_file_suffix();
 
@@ -207,8 +219,8 @@ public:
   size_t result_panel_count();
   size_t resultset_count();
 
-  SqlEditorResult *add_panel_for_recordset(Recordset::Ref rset);
-  void add_panel_for_recordset_from_main(Recordset::Ref rset);
+  SqlEditorResult *add_panel_for_recordset(Recordset::Ref rset, bool deferred = false);
+  void add_panel_for_recordset_from_main(Recordset::Ref rset, bool deferred = false);
 
   std::list<SqlEditorResult *> dirty_result_panels();
 };
@@ -97,7 +97,8 @@ SqlEditorResult::SqlEditorResult(SqlEditorPanel *owner)
     _switcher(mforms::VerticalIconSwitcher),
     _tabdock_delegate(new DockingDelegate(&_tabview, &_switcher, std::string("SqlResultPanel"))),
     _tabdock(_tabdock_delegate, true),
-    _pinned(false)
+    _pinned(false),
+    _last_viewed(0)
 
 {
   _result_grid = NULL;
@@ -106,6 +107,7 @@ SqlEditorResult::SqlEditorResult(SqlEditorPanel *owner)
   _column_info_created = false;
   _query_stats_created = false;
   _form_view_created = false;
+  _views_pending = false;
 
   _spatial_view_initialized = false;
   _spatial_result_view = NULL;
@@ -190,18 +192,38 @@ void SqlEditorResult::update_selection_for_menu_extra(mforms::ContextMenu *menu,
   }
 }
 
-void SqlEditorResult::set_recordset(Recordset::Ref rset) {
-  if (_resultset_placeholder) {
-    _tabdock_delegate->undock_view(_resultset_placeholder);
-    _resultset_placeholder = NULL;
-  }
-
+/**
+ * With deferred set only the recordset and its caption are assigned, the grid and the other views are created
+ * by create_result_views() when the result is first shown, so scripts returning many result sets dock quickly.
+ */
+void SqlEditorResult::set_recordset(Recordset::Ref rset, bool deferred) {
   _rset = rset;
+  mark_viewed();
   if (!rset->is_readonly())
     _grtobj->resultset(grtwrap_editablerecordset(grtobj(), rset));
   else
     _grtobj->resultset(grtwrap_recordset(grtobj(), rset));
 
+  Recordset_cdbc_storage::Ref storage(std::dynamic_pointer_cast<Recordset_cdbc_storage>(rset->data_storage()));
+  rset->caption(strfmt("%s %i", (storage->table_name().empty() ? _("Result") : storage->table_name().c_str()),
+                       ++_owner->_rs_sequence));
+
+  _views_pending = true;
+  if (!deferred)
+    create_result_views();
+}
+
+void SqlEditorResult::create_result_views() {
+  Recordset::Ref rset(_rset.lock());
+  if (!_views_pending || !rset)
+    return;
+  _views_pending = false;
+
+  if (_resultset_placeholder) {
+    _tabdock_delegate->undock_view(_resultset_placeholder);
+    _resultset_placeholder = NULL;
+  }
+
   rset->update_selection_for_menu_extra =
     std::bind(&SqlEditorResult::update_selection_for_menu_extra, this, std::placeholders::_1, std::placeholders::_2,
               std::placeholders::_3);
@@ -245,10 +267,6 @@ void SqlEditorResult::set_recordset(Recordset::Ref rset) {
   }
   dock_result_grid(grid);
 
-  Recordset_cdbc_storage::Ref storage(std::dynamic_pointer_cast<Recordset_cdbc_storage>(rset->data_storage()));
-  rset->caption(strfmt("%s %i", (storage->table_name().empty() ? _("Result") : storage->table_name().c_str()),
-                       ++_owner->_rs_sequence));
-
   bec::UIForm::scoped_connect(rset->get_context_menu()->signal_will_show(),
                               std::bind(&SqlEditorPanel::on_recordset_context_menu_show, _owner, Recordset::Ptr(rset)));
 
@@ -322,6 +340,11 @@ void SqlEditorResult::set_title(const std::string &title) {
   mforms::AppView::set_title(title);
 }
 
+void SqlEditorResult::mark_viewed() {
+  static size_t view_count = 0;
+  _last_viewed = ++view_count;
+}
+
 bool SqlEditorResult::can_close() {
   if (Recordset::Ref rs = recordset())
     if (!rs->can_close(true))
@@ -358,7 +381,9 @@ void SqlEditorResult::switch_tab() {
       }
       _form_result_view->display_record();
     } else if (tab->identifier() == "result_grid") {
-      if (_resultset_placeholder) {
+      if (_views_pending)
+        create_result_views();
+      else if (_resultset_placeholder) {
         _owner->owner()->exec_editor_sql(_owner, true, true, true, false, this);
         if (!_rset.expired())
           set_title(_rset.lock()->caption());
@@ -474,7 +499,10 @@ void SqlEditorResult::on_recordset_column_resized(int column) {
   if (column >= 0) {
     std::string column_id = _column_width_storage_ids[column];
     int width = _result_grid->get_column_width(column);
-    _owner->owner()->column_width_cache()->save_column_width(column_id, width);
+    ColumnWidthCache *cache = _owner->owner()->column_width_cache();
+    cache->save_column_width(column_id, width);
+    // a drag resizes the column many times, store the width it ends up with
+    bec::GRTManager::get()->run_once_when_idle(this, std::bind(&ColumnWidthCache::flush, cache));
   }
 }
 
@@ -500,36 +528,44 @@ void SqlEditorResult::reset_column_widths() {
   ColumnWidthCache *cache = _owner->owner()->column_width_cache();
 
   RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, _rset, rs) {
-    Recordset_cdbc_storage::Ref storage(std::dynamic_pointer_cast<Recordset_cdbc_storage>(rs->data_storage()));
-    std::vector<Recordset_cdbc_storage::FieldInfo> &field_info(storage->field_info());
-
-    for (int c = (int)field_info.size(), i = 0; i < c; i++) {
-      std::string column_storage_id;
-
-      column_storage_id = field_info[i].field + "::" + field_info[i].schema + "::" + field_info[i].table;
-
+    std::vector<std::string> column_storage_ids(column_width_storage_ids(rs));
+    for (const std::string &column_storage_id : column_storage_ids)
       cache->delete_column_width(column_storage_id);
-    }
+    cache->delete_autofit_widths(ColumnWidthCache::query_fingerprint(rs->generator_query(), column_storage_ids));
   }
 
   restore_grid_column_widths();
 }
 
+std::vector<std::string> SqlEditorResult::column_width_storage_ids(Recordset *rs) {
+  std::vector<std::string> ids;
+  Recordset_cdbc_storage::Ref storage(std::dynamic_pointer_cast<Recordset_cdbc_storage>(rs->data_storage()));
+  if (storage) {
+    for (auto &field_info : storage->field_info())
+      ids.push_back(field_info.field + "::" + field_info.schema + "::" + field_info.table);
+  }
+  return ids;
+}
+
 std::vector<float> SqlEditorResult::get_autofit_column_widths(Recordset *rs) {
+  static const size_t SAMPLE_ROW_COUNT = 10;
+  static const int SAMPLE_VALUE_LENGTH = 100; // longer values get the maximum width anyway
+
   std::vector<float> widths(rs->get_column_count());
   std::string font = bec::GRTManager::get()->get_app_option_string("workbench.general.Resultset:Font");
+  size_t row_count = std::min<size_t>(SAMPLE_ROW_COUNT, rs->count());
 
+  // measuring the text is what takes time on wide results, so only the longest value of each column is measured
   for (size_t c = rs->get_column_count(), j = 0; j < c; j++) {
-    widths[j] = (float)mforms::Utilities::get_text_width(rs->get_column_caption(j), font);
-  }
-
-  // look in 1st 10 rows for the max width of the columns
-  for (size_t i = 0; i < 10; i++) {
-    for (size_t c = rs->get_column_count(), j = 0; j < c; j++) {
+    std::string longest_value;
+    for (size_t i = 0; i < row_count; i++) {
       std::string value;
-      rs->get_field(i, j, value);
-      widths[j] = std::max(widths[j], (float)mforms::Utilities::get_text_width(value, font));
+      if (rs->get_field(i, j, value) && value.size() > longest_value.size())
+        longest_value = base::truncate_text(value, SAMPLE_VALUE_LENGTH);
     }
+    widths[j] = (float)mforms::Utilities::get_text_width(rs->get_column_caption(j), font);
+    if (!longest_value.empty())
+      widths[j] = std::max(widths[j], (float)mforms::Utilities::get_text_width(longest_value, font));
   }
   return widths;
 }
@@ -538,33 +574,39 @@ void SqlEditorResult::restore_grid_column_widths() {
   ColumnWidthCache *cache = _owner->owner()->column_width_cache();
 
   RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, _rset, rs) {
-    Recordset_cdbc_storage::Ref storage(std::dynamic_pointer_cast<Recordset_cdbc_storage>(rs->data_storage()));
-    std::vector<Recordset_cdbc_storage::FieldInfo> &field_info(storage->field_info());
-    std::vector<float> autofit_widths;
-
-    for (int c = (int)field_info.size(), i = 0; i < c; i++) {
-      std::string column_storage_id;
-
-      column_storage_id = field_info[i].field + "::" + field_info[i].schema + "::" + field_info[i].table;
-      _column_width_storage_ids.push_back(column_storage_id);
-
-      // check if we have a remembered column width
-      int width = cache->get_column_width(column_storage_id);
-      if (width > 0) {
-        _result_grid->set_column_width(i, width);
-      } else {
-        // if not, we set a default width based on the width of the 1st 50 rows
-        if (autofit_widths.empty())
-          autofit_widths = get_autofit_column_widths(rs);
-
-        int width = int(autofit_widths[i] + 10);
-        if (width < 40)
-          width = 40;
-        else if (width > 250)
-          width = 250;
-        _result_grid->set_column_width(i, width);
+    _column_width_storage_ids = column_width_storage_ids(rs);
+    std::map<std::string, int> stored_widths(cache->get_columns_width(_column_width_storage_ids));
+
+    // the widths fitted to the values are kept by query, reopening it skips measuring them again
+    std::vector<int> autofit_widths;
+    std::string fingerprint;
+    if (stored_widths.size() < _column_width_storage_ids.size()) {
+      fingerprint = ColumnWidthCache::query_fingerprint(rs->generator_query(), _column_width_storage_ids);
+      autofit_widths = cache->get_autofit_widths(fingerprint);
+      if (autofit_widths.size() != _column_width_storage_ids.size()) {
+        std::vector<float> measured_widths(get_autofit_column_widths(rs));
+        autofit_widths.clear();
+        for (size_t i = 0; i < _column_width_storage_ids.size(); i++) {
+          int width = i < measured_widths.size() ? int(measured_widths[i] + 10) : 0;
+          if (width < 40)
+            width = 40;
+          else if (width > 250)
+            width = 250;
+          autofit_widths.push_back(width);
+        }
+        if (rs->count() > 0)
+          cache->save_autofit_widths(fingerprint, autofit_widths);
       }
     }
+
+    for (int c = (int)_column_width_storage_ids.size(), i = 0; i < c; i++) {
+      // a remembered column width comes first
+      std::map<std::string, int>::const_iterator width = stored_widths.find(_column_width_storage_ids[i]);
+      if (width != stored_widths.end() && width->second > 0)
+        _result_grid->set_column_width(i, width->second);
+      else
+        _result_grid->set_column_width(i, autofit_widths[i]);
+    }
   }
 }
 
@@ -948,6 +990,24 @@ void SqlEditorResult::create_query_stats_panel() {
     info = strfmt("Execution time: %s\n", format_ps_time(std::int64_t(rsdata->duration * 1000000000000.0)).c_str());
     box->add(mforms::manage(new mforms::Label(info)), false, true);
 
+    // phases timed by SqlEditorForm::do_exec_sql(), in nanoseconds
+    box->add(bold_label("Execution phases (as measured at client side):"), false, true);
+    info = strfmt("Parsing: %s\n", format_ps_time(rsdata->parse_time * 1000).c_str());
+    info.append(
+      strfmt("Sending until the server responded: %s\n", format_ps_time(rsdata->execute_time * 1000).c_str()));
+    info.append(strfmt("Receiving the result set: %s\n", format_ps_time(rsdata->transfer_time * 1000).c_str()));
+    if (rsdata->fetch_complete) {
+      const Recordset_cdbc_storage::FetchTimings &fetch = rsdata->fetch_timings;
+      info.append(
+        strfmt("Reading %lu row(s): %s\n", (unsigned long)fetch.rows, format_ps_time(fetch.read * 1000).c_str()));
+      info.append(strfmt("Converting values: %s\n", format_ps_time(fetch.convert * 1000).c_str()));
+      info.append(strfmt("Storing rows: %s\n", format_ps_time(fetch.store * 1000).c_str()));
+    } else
+      info.append("Rows are still being fetched.\n");
+    if (rsdata->ui_ready_time > 0)
+      info.append(strfmt("Result shown after: %s\n", format_ps_time(rsdata->ui_ready_time * 1000).c_str()));
+    box->add(mforms::manage(new mforms::Label(info)), false, true);
+
     // if we're in a server with PS, show some extra PS goodies
     // we need to convert this to long long it cause int64_t is not the same (long long) on the all platforms.
     std::map<std::string, long long int> ps_stats;
@@ -57,7 +57,8 @@ class MYSQLWBBACKEND_PUBLIC_FUNC SqlEditorResult : public mforms::AppView {
 
 public:
   SqlEditorResult(SqlEditorPanel *owner);
-  void set_recordset(Recordset::Ref rset);
+  void set_recordset(Recordset::Ref rset, bool deferred = false);
+  void create_result_views();
 
   virtual ~SqlEditorResult();
 
@@ -107,6 +108,12 @@ public:
     return _pinned;
   }
 
+  // results not viewed for the longest time are the first to give up their memory
+  void mark_viewed();
+  size_t last_viewed() const {
+    return _last_viewed;
+  }
+
   void view_record_in_form(int row_id);
 
   void open_field_editor(int row, int column);
@@ -120,6 +127,7 @@ private:
   mforms::AppView *_column_info_box;
   mforms::AppView *_query_stats_box;
   mforms::AppView *_resultset_placeholder;
+  bool _views_pending; // set_recordset() was deferred, the grid is not created yet
   mforms::AppView *_execution_plan_placeholder;
   ResultFormView *_form_result_view;
   SpatialDataView *_spatial_result_view;
@@ -140,6 +148,7 @@ private:
   bool _spatial_view_initialized;
 
   bool _pinned;
+  size_t _last_viewed;
 
   void update_selection_for_menu_extra(mforms::ContextMenu *menu, const std::vector<int> &rows, int column);
   void switch_tab();
@@ -154,6 +163,7 @@ private:
   void dock_result_grid(mforms::GridView *view);
 
   void restore_grid_column_widths();
+  std::vector<std::string> column_width_storage_ids(Recordset *rs);
   std::vector<float> get_autofit_column_widths(Recordset *rs);
   void reset_column_widths();
 
@@ -23,6 +23,8 @@
 
 #include <glib.h>
 #include <glib/gstdio.h>
+#include <cctype>
+#include <cstring>
 
 #include "base/string_utilities.h"
 #include "base/file_functions.h"
@@ -44,6 +46,73 @@ using namespace mforms;
 
 static DbSqlEditorSnippets *singleton = 0;
 
+//--------------------------------------------------------------------------------------------------
+
+static bool snippet_file_stamp(const std::string &path, time_t &mtime, long long &size) {
+#ifdef _WIN32
+  struct _stat stbuf;
+#else
+  struct stat stbuf;
+#endif
+  if (base_stat(path.c_str(), &stbuf) != 0)
+    return false;
+  mtime = stbuf.st_mtime;
+  size = (long long)stbuf.st_size;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static const char *skip_blanks_and_comments(const char *p) {
+  for (;;) {
+    while (*p && isspace((unsigned char)*p))
+      ++p;
+    if (*p == '#' || (p[0] == '-' && p[1] == '-')) {
+      while (*p && *p != '\n')
+        ++p;
+    } else if (p[0] == '/' && p[1] == '*') {
+      const char *end = strstr(p + 2, "*/");
+      if (!end)
+        return p + strlen(p);
+      p = end + 2;
+    } else
+      return p;
+  }
+}
+
+static std::string next_keyword(const char *&p) {
+  p = skip_blanks_and_comments(p);
+  const char *start = p;
+  while (*p && (isalpha((unsigned char)*p) || *p == '_'))
+    ++p;
+  return base::toupper(std::string(start, p));
+}
+
+/**
+ * Leading keyword of the snippet, with the object kind for DDL statements (CREATE TABLE, DROP VIEW...).
+ */
+static std::string snippet_statement_type(const std::string &code) {
+  const char *p = code.c_str();
+  std::string type = next_keyword(p);
+  if (type == "CREATE" || type == "ALTER" || type == "DROP") {
+    std::string word = next_keyword(p);
+    if (word == "OR") {
+      next_keyword(p); // REPLACE
+      word = next_keyword(p);
+    }
+    while (word == "TEMPORARY" || word == "UNIQUE" || word == "FULLTEXT" || word == "SPATIAL" || word == "ONLINE")
+      word = next_keyword(p);
+    if (!word.empty())
+      type += " " + word;
+  }
+  return type;
+}
+
+void DbSqlEditorSnippets::Snippet::update_metadata() {
+  statement_type = snippet_statement_type(code);
+  search_text = base::tolower(title + "\n" + statement_type + "\n" + code);
+}
+
 void DbSqlEditorSnippets::setup(wb::WBContextSQLIDE *sqlide, const std::string &path) {
   if (singleton != 0)
     return;
@@ -67,6 +136,7 @@ bool DbSqlEditorSnippets::activate_toolbar_item(const bec::NodeId &selected, con
       _("Continue"), _("Cancel"));
     if (result == mforms::ResultOk) {
       copy_original_file(_selected_category + ".txt", true);
+      _files.erase(_selected_category);
       load();
     }
 
@@ -80,22 +150,22 @@ bool DbSqlEditorSnippets::activate_toolbar_item(const bec::NodeId &selected, con
     return true;
   }
 
-  if (name == "del_snippet" && selected.is_valid() && selected[0] < _entries.size()) {
+  Snippet *snippet = entry_for_node(selected);
+  if (name == "del_snippet" && snippet != NULL) {
     delete_node(selected);
     return true;
   }
 
-  else if (name == "exec_snippet") {
+  else if (name == "exec_snippet" && snippet != NULL) {
     SqlEditorForm *editor_form = _sqlide->get_active_sql_editor();
     std::string script;
 
-    script = _entries[selected[0]].code;
-    if (!script.empty()) {
+    script = snippet->code;
+    if (editor_form != NULL && !script.empty()) {
       editor_form->run_sql_in_scratch_tab(script, true, false);
     }
-  } else if ((name == "replace_text" || name == "insert_text" || name == "copy_to_clipboard") && selected.is_valid() &&
-             selected[0] < _entries.size()) {
-    std::string script = _entries[selected[0]].code;
+  } else if ((name == "replace_text" || name == "insert_text" || name == "copy_to_clipboard") && snippet != NULL) {
+    std::string script = snippet->code;
 
     if (name == "copy_to_clipboard")
       mforms::Utilities::set_clipboard_text(script);
@@ -191,6 +261,26 @@ std::string DbSqlEditorSnippets::selected_category() {
   return category_file_to_name(_selected_category);
 }
 
+void DbSqlEditorSnippets::set_filter(const std::string &text) {
+  _filter = base::tolower(base::trim(text));
+  update_visible();
+}
+
+void DbSqlEditorSnippets::update_visible() {
+  _visible.clear();
+  _visible.reserve(_entries.size());
+  for (size_t i = 0; i < _entries.size(); ++i) {
+    if (_filter.empty() || _entries[i].search_text.find(_filter) != std::string::npos)
+      _visible.push_back(i);
+  }
+}
+
+DbSqlEditorSnippets::Snippet *DbSqlEditorSnippets::entry_for_node(const bec::NodeId &node) {
+  if (node.is_valid() && node[0] < _visible.size())
+    return &_entries[_visible[node[0]]];
+  return NULL;
+}
+
 bool DbSqlEditorSnippets::shared_snippets_usable() {
   return _sqlide->get_active_sql_editor() != NULL && _sqlide->get_active_sql_editor()->connected();
 }
@@ -201,6 +291,7 @@ void DbSqlEditorSnippets::load_from_db(SqlEditorForm *editor) {
 
   _shared_snippets_enabled = false;
   _entries.clear();
+  _visible.clear();
 
   if (editor) {
     if (_snippet_db.empty())
@@ -227,8 +318,10 @@ void DbSqlEditorSnippets::load_from_db(SqlEditorForm *editor) {
         snippet.db_snippet_id = result->getInt(1);
         snippet.title = result->getString(2);
         snippet.code = result->getString(3);
+        snippet.update_metadata();
         _entries.push_back(snippet);
       }
+      update_visible();
 
       _shared_snippets_enabled = true;
     } catch (std::exception &e) {
@@ -285,10 +378,26 @@ void DbSqlEditorSnippets::delete_db_snippet(int snippet_id) {
   }
 }
 
+/**
+ * Loads the selected category. Files are parsed only the first time and when they changed on disk since,
+ * switching categories otherwise reuses the snippets in memory.
+ */
 void DbSqlEditorSnippets::load() {
   _entries.clear();
 
-  FILE *f = base_fopen(base::strfmt("%s/%s.txt", _path.c_str(), _selected_category.c_str()).c_str(), "r");
+  std::string path = base::strfmt("%s/%s.txt", _path.c_str(), _selected_category.c_str());
+  time_t mtime = 0;
+  long long size = -1;
+  bool has_stamp = snippet_file_stamp(path, mtime, size);
+
+  std::map<std::string, SnippetFile>::const_iterator cached = _files.find(_selected_category);
+  if (has_stamp && cached != _files.end() && cached->second.mtime == mtime && cached->second.size == size) {
+    _entries = cached->second.entries;
+    update_visible();
+    return;
+  }
+
+  FILE *f = base_fopen(path.c_str(), "r");
   if (f) {
     char line[1000];
 
@@ -321,11 +430,31 @@ void DbSqlEditorSnippets::load() {
       snippet.db_snippet_id = 0;
       snippet.title = name;
       snippet.code = script;
+      snippet.update_metadata();
       _entries.push_back(snippet);
     }
 
     fclose(f);
   }
+
+  if (has_stamp) {
+    SnippetFile &file = _files[_selected_category];
+    file.mtime = mtime;
+    file.size = size;
+    file.entries = _entries;
+  } else
+    _files.erase(_selected_category);
+  update_visible();
+}
+
+void DbSqlEditorSnippets::update_file_cache() {
+  SnippetFile file;
+  if (snippet_file_stamp(base::strfmt("%s/%s.txt", _path.c_str(), _selected_category.c_str()), file.mtime,
+                         file.size)) {
+    file.entries = _entries;
+    _files[_selected_category] = file;
+  } else
+    _files.erase(_selected_category);
 }
 
 void DbSqlEditorSnippets::save() {
@@ -344,6 +473,7 @@ void DbSqlEditorSnippets::save() {
       }
       fclose(f);
     }
+    update_file_cache();
   }
 }
 
@@ -397,32 +527,41 @@ void DbSqlEditorSnippets::add_snippet(const std::string &name, const std::string
   snippet.db_snippet_id = 0;
   snippet.title = base::trim_left(name);
   snippet.code = code;
+  snippet.update_metadata();
 
+  // A new snippet is listed even if it doesn't match the filter, so it can be edited right away.
   if (_selected_category.empty()) {
     snippet.db_snippet_id = add_db_snippet(name, code);
-    if (snippet.db_snippet_id != 0)
+    if (snippet.db_snippet_id != 0) {
       _entries.push_back(snippet);
+      _visible.push_back(_entries.size() - 1);
+    }
   } else {
     _entries.push_back(snippet);
+    _visible.push_back(_entries.size() - 1);
     save();
   }
 }
 
 size_t DbSqlEditorSnippets::count() {
-  return _entries.size();
+  return _visible.size();
 }
 
 bool DbSqlEditorSnippets::get_field(const bec::NodeId &node, ColumnId column, std::string &value) {
-  if (node.is_valid() && node[0] < _entries.size()) {
+  Snippet *snippet = entry_for_node(node);
+  if (snippet != NULL) {
     switch ((Column)column) {
       case Description:
-        value = _entries[node[0]].title;
+        value = snippet->title;
         break;
       case Script:
-        value = _entries[node[0]].code;
+        value = snippet->code;
         if (value.empty())
           return false;
         break;
+      case StatementType:
+        value = snippet->statement_type;
+        break;
     }
     return true;
   }
@@ -430,15 +569,19 @@ bool DbSqlEditorSnippets::get_field(const bec::NodeId &node, ColumnId column, st
 }
 
 bool DbSqlEditorSnippets::set_field(const bec::NodeId &node, ColumnId column, const std::string &value) {
-  if (node.is_valid() && node[0] < _entries.size()) {
+  Snippet *snippet = entry_for_node(node);
+  if (snippet != NULL) {
     switch ((Column)column) {
       case Description:
-        _entries[node[0]].title = value;
+        snippet->title = value;
         break;
       case Script:
-        _entries[node[0]].code = value;
+        snippet->code = value;
         break;
+      case StatementType:
+        return false; // Derived from the code.
     }
+    snippet->update_metadata();
     if (_selected_category.empty() && _shared_snippets_enabled && _sqlide->get_active_sql_editor()) {
       sql::Dbc_connection_handler::Ref conn;
       base::RecMutexLock aux_dbc_conn_mutex(_sqlide->get_active_sql_editor()->ensure_valid_aux_connection(conn));
@@ -446,10 +589,12 @@ bool DbSqlEditorSnippets::set_field(const bec::NodeId &node, ColumnId column, co
       try {
         switch ((Column)column) {
           case Description:
-            internal_schema.set_snippet_title(_entries[node[0]].db_snippet_id, value);
+            internal_schema.set_snippet_title(snippet->db_snippet_id, value);
             break;
           case Script:
-            internal_schema.set_snippet_code(_entries[node[0]].db_snippet_id, value);
+            internal_schema.set_snippet_code(snippet->db_snippet_id, value);
+            break;
+          default:
             break;
         }
       } catch (std::exception &exc) {
@@ -465,14 +610,19 @@ bool DbSqlEditorSnippets::set_field(const bec::NodeId &node, ColumnId column, co
 }
 
 bool DbSqlEditorSnippets::can_delete_node(const bec::NodeId &node) {
-  return node.is_valid() && node[0] < _entries.size();
+  return entry_for_node(node) != NULL;
 }
 
 bool DbSqlEditorSnippets::delete_node(const bec::NodeId &node) {
-  if (node.is_valid() && node[0] < _entries.size()) {
-    int entry_id = _entries[node[0]].db_snippet_id;
-
-    _entries.erase(_entries.begin() + node[0]);
+  if (entry_for_node(node) != NULL) {
+    size_t index = _visible[node[0]];
+    int entry_id = _entries[index].db_snippet_id;
+
+    _entries.erase(_entries.begin() + index);
+    _visible.erase(_visible.begin() + node[0]);
+    for (size_t &i : _visible)
+      if (i > index)
+        --i;
 
     if (_selected_category.empty()) {
       if (_shared_snippets_enabled && entry_id > 0) {
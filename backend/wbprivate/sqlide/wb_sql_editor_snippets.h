@@ -27,6 +27,9 @@
 #include "workbench/wb_backend_public_interface.h"
 #include "base/ui_form.h"
 #include "grt/tree_model.h"
+
+#include <ctime>
+#include <map>
 //#include "workbench/wb_command_ui.h"
 //#include "sqlide/wb_context_sqlide.h"
 
@@ -40,7 +43,7 @@ class SqlEditorForm;
 
 class MYSQLWBBACKEND_PUBLIC_FUNC DbSqlEditorSnippets : public bec::ListModel {
 public:
-  enum Column { Description, Script };
+  enum Column { Description, Script, StatementType };
 
   static void setup(wb::WBContextSQLIDE *sqlide, const std::string &path);
   static DbSqlEditorSnippets *get_instance();
@@ -55,6 +58,9 @@ public:
   void select_category(const std::string &category);
   std::string selected_category();
 
+  // Lists only the snippets whose title, code or statement type contain the text (case insensitive).
+  void set_filter(const std::string &text);
+
   virtual size_t count();
   virtual bool get_field(const bec::NodeId &node, ColumnId column, std::string &value);
   virtual bool set_field(const bec::NodeId &node, ColumnId column, const std::string &value);
@@ -83,9 +89,29 @@ protected:
     std::string title;
     std::string code;
     int db_snippet_id; // only if it comes from the DB
+
+    // Computed once when the snippet is loaded or changed, so filtering doesn't look at the code again.
+    std::string statement_type; // e.g. SELECT or CREATE TABLE
+    std::string search_text;    // lower case title, type and code
+
+    void update_metadata();
+  };
+
+  // Parsed snippet files, kept until the file changes on disk.
+  struct SnippetFile {
+    time_t mtime;
+    long long size;
+    std::vector<Snippet> entries;
   };
 
   std::vector<Snippet> _entries;
+  std::map<std::string, SnippetFile> _files;
+  std::string _filter;
+  std::vector<size_t> _visible; // Indexes into _entries of the snippets matching _filter.
+
+  Snippet *entry_for_node(const bec::NodeId &node);
+  void update_visible();
+  void update_file_cache();
 
   void toolbar_item_activated(const std::string &name);
   void copy_original_file(const std::string &name, bool overwrite);
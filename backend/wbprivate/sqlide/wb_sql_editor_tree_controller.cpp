@@ -53,6 +53,8 @@
 
 #include "objimpl/wrapper/mforms_ObjectReference_impl.h"
 
+#include "sqlide/schema_metadata_cache.h"
+
 #include "advanced_sidebar.h"
 
 #include "mforms/textentry.h"
@@ -279,7 +281,7 @@ void SqlEditorTreeController::finish_init() {
   // update the info box
   schema_row_selected();
 
-  tree_refresh();
+  refresh_schema_tree();
 
   // make sure to restore the splitter pos after layout is ready
   bec::GRTManager::get()->run_once_when_idle(
@@ -427,7 +429,8 @@ std::vector<std::string> SqlEditorTreeController::fetch_schema_list() {
   try {
     sql::Dbc_connection_handler::Ref conn;
 
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::BackgroundMetadata));
 
     bool showSystemSchemas = bec::GRTManager::get()->get_app_option_int("DbSqlEditor:ShowMetadataSchemata", 0) != 0;
 
@@ -449,6 +452,10 @@ bool SqlEditorTreeController::fetch_schema_contents(
   // in windows we use TreeViewAdv feature to expand nodes asynchronously
   // that is this function is already called from a separate thread
   // and it must have items loaded when it returns.
+  // Newer servers go through the bulk loader, which can use the schema meta data cache.
+  if (_owner->rdbms_version().is_valid() && is_supported_mysql_version_at_least(_owner->rdbms_version(), 5, 5))
+    return fetch_schemas_contents({ schema_name }, arrived_slot);
+
   bool sync = !bec::GRTManager::get()->in_main_thread();
   logDebug3("Fetch schema contents for %s\n", schema_name.c_str());
 
@@ -458,6 +465,28 @@ bool SqlEditorTreeController::fetch_schema_contents(
   return true;
 }
 
+/**
+ * Loads the content of several schemas with a few INFORMATION_SCHEMA queries instead of 3 SHOW statements
+ * per schema. Schemas which didn't change since they were stored in the schema meta data cache are taken from there.
+ * Servers before 5.5 use the per schema path.
+ */
+bool SqlEditorTreeController::fetch_schemas_contents(
+  const std::vector<std::string> &schema_names, const wb::LiveSchemaTree::NewSchemaContentArrivedSlot &arrived_slot) {
+  if (!_owner->rdbms_version().is_valid() || !is_supported_mysql_version_at_least(_owner->rdbms_version(), 5, 5)) {
+    for (auto &name : schema_names)
+      fetch_schema_contents(name, arrived_slot);
+    return true;
+  }
+
+  bool sync = !bec::GRTManager::get()->in_main_thread();
+  logDebug3("Fetch schema contents for %i schemas\n", (int)schema_names.size());
+
+  live_schema_fetch_task->exec(sync, std::bind(&SqlEditorTreeController::do_fetch_live_schemas_contents, this,
+                                               weak_ptr_from(this), schema_names, arrived_slot));
+
+  return true;
+}
+
 void SqlEditorTreeController::refresh_live_object_in_overview(wb::LiveSchemaTree::ObjectType type,
                                                               const std::string schema_name,
                                                               const std::string old_obj_name,
@@ -490,7 +519,8 @@ grt::StringRef SqlEditorTreeController::do_fetch_live_schema_contents(
 
     {
       sql::Dbc_connection_handler::Ref conn;
-      RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+      RecMutexLock metadata_dbc_conn_mutex(
+        _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::BackgroundMetadata));
       std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
 
       {
@@ -526,6 +556,10 @@ grt::StringRef SqlEditorTreeController::do_fetch_live_schema_contents(
         }
     }
 
+    // SHOW FULL TABLES doesn't tell when the tables changed.
+    std::map<std::string, std::string> no_create_times;
+    update_table_versions(schema_name, &no_create_times);
+
     if (arrived_slot) {
       std::function<void()> schema_contents_arrived =
         std::bind(arrived_slot, schema_name, tables, views, procedures, functions, false);
@@ -553,6 +587,215 @@ grt::StringRef SqlEditorTreeController::do_fetch_live_schema_contents(
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Computes a digest of the server side state of each of the given schemas, from the number of tables and routines
+ * and their latest creation and change times. Used to validate the content stored in the schema meta data cache.
+ */
+static std::map<std::string, std::string> fetch_schema_digests(sql::Statement *stmt,
+                                                               const std::vector<std::string> &schema_names) {
+  std::map<std::string, std::string> table_digests;
+  std::map<std::string, std::string> routine_digests;
+
+  std::string schemaList;
+  for (auto &name : schema_names) {
+    if (!schemaList.empty())
+      schemaList += ", ";
+    schemaList += std::string(sqlstring("?", 0) << name);
+  }
+
+  {
+    std::unique_ptr<sql::ResultSet> rs(
+      stmt->executeQuery("SELECT TABLE_SCHEMA, COUNT(*), MAX(CREATE_TIME), MAX(UPDATE_TIME) "
+                         "FROM INFORMATION_SCHEMA.TABLES WHERE TABLE_SCHEMA IN (" +
+                         schemaList + ") GROUP BY TABLE_SCHEMA"));
+    while (rs->next())
+      table_digests[rs->getString(1)] = rs->getString(2) + "|" + rs->getString(3) + "|" + rs->getString(4);
+  }
+
+  {
+    std::unique_ptr<sql::ResultSet> rs(
+      stmt->executeQuery("SELECT ROUTINE_SCHEMA, COUNT(*), MAX(LAST_ALTERED) FROM INFORMATION_SCHEMA.ROUTINES "
+                         "WHERE ROUTINE_SCHEMA IN (" +
+                         schemaList + ") GROUP BY ROUTINE_SCHEMA"));
+    while (rs->next())
+      routine_digests[rs->getString(1)] = rs->getString(2) + "|" + rs->getString(3);
+  }
+
+  std::map<std::string, std::string> digests;
+  for (auto &name : schema_names)
+    digests[name] = "tables:" + table_digests[name] + ";routines:" + routine_digests[name];
+  return digests;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Records the CREATE_TIME values of the tables of a schema as just fetched. Tables that had the same value
+ * before are unchanged. Passing no values means the whole schema is unchanged.
+ */
+void SqlEditorTreeController::update_table_versions(const std::string &schema_name,
+                                                    const std::map<std::string, std::string> *create_times) {
+  MutexLock lock(_table_versions_mutex);
+  std::map<std::string, std::string> &previous = _table_create_times[schema_name];
+  std::set<std::string> &unchanged = _unchanged_tables[schema_name];
+  unchanged.clear();
+
+  if (create_times == nullptr) {
+    for (auto &entry : previous)
+      unchanged.insert(entry.first);
+    return;
+  }
+
+  for (auto &entry : *create_times) {
+    auto iterator = previous.find(entry.first);
+    if (iterator != previous.end() && iterator->second == entry.second)
+      unchanged.insert(entry.first);
+  }
+  previous = *create_times;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool SqlEditorTreeController::is_object_unchanged(const std::string &schema_name, const std::string &object_name) {
+  MutexLock lock(_table_versions_mutex);
+  auto iterator = _unchanged_tables.find(schema_name);
+  return iterator != _unchanged_tables.end() && iterator->second.count(object_name) > 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// The number of schemas queried at once in do_fetch_live_schemas_contents. Results for a chunk
+// are sent to the tree before the next chunk is loaded.
+static const size_t SCHEMA_FETCH_CHUNK_SIZE = 50;
+
+grt::StringRef SqlEditorTreeController::do_fetch_live_schemas_contents(
+  std::weak_ptr<SqlEditorTreeController> self_ptr, std::vector<std::string> schema_names,
+  wb::LiveSchemaTree::NewSchemaContentArrivedSlot arrived_slot) {
+  RETVAL_IF_FAIL_TO_RETAIN_WEAK_PTR(SqlEditorTreeController, self_ptr, self, grt::StringRef(""))
+
+  size_t done = 0;
+  try {
+    MutexLock schema_contents_mutex(_schema_contents_mutex);
+    if (!arrived_slot)
+      return grt::StringRef("");
+
+    sql::Dbc_connection_handler::Ref conn;
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::BackgroundMetadata));
+    std::unique_ptr<sql::Statement> stmt(conn->ref->createStatement());
+
+    while (done < schema_names.size()) {
+      size_t count = std::min(SCHEMA_FETCH_CHUNK_SIZE, schema_names.size() - done);
+
+      struct SchemaContent {
+        StringListPtr tables = StringListPtr(new std::list<std::string>());
+        StringListPtr views = StringListPtr(new std::list<std::string>());
+        StringListPtr procedures = StringListPtr(new std::list<std::string>());
+        StringListPtr functions = StringListPtr(new std::list<std::string>());
+      };
+      std::map<std::string, SchemaContent> contents;
+      std::vector<std::string> chunk(schema_names.begin() + done, schema_names.begin() + done + count);
+
+      // Take what we can from the cache. Digests are only computed if there's a cache.
+      std::map<std::string, std::string> digests;
+      SchemaMetadataCache *cache = _owner->schema_metadata_cache();
+      if (cache != nullptr)
+        digests = fetch_schema_digests(stmt.get(), chunk);
+
+      std::vector<std::string> fetched;
+      std::map<std::string, std::map<std::string, std::string> > create_times;
+      std::string schemaList;
+      for (auto &name : chunk) {
+        SchemaContent &content = contents[name];
+        if (cache != nullptr && cache->get_schema_contents(name, digests[name], content.tables, content.views,
+                                                           content.procedures, content.functions))
+          continue;
+
+        fetched.push_back(name);
+        if (!schemaList.empty())
+          schemaList += ", ";
+        schemaList += std::string(sqlstring("?", 0) << name);
+      }
+
+      if (!fetched.empty()) {
+        {
+          std::unique_ptr<sql::ResultSet> rs(
+            stmt->executeQuery("SELECT TABLE_SCHEMA, TABLE_NAME, TABLE_TYPE, CREATE_TIME FROM INFORMATION_SCHEMA.TABLES "
+                               "WHERE TABLE_SCHEMA IN (" +
+                               schemaList + ")"));
+          while (rs->next()) {
+            auto iterator = contents.find(rs->getString(1));
+            if (iterator == contents.end())
+              continue;
+
+            if (rs->getString(3) == "VIEW")
+              iterator->second.views->push_back(rs->getString(2));
+            else {
+              iterator->second.tables->push_back(rs->getString(2));
+              if (!rs->isNull(4))
+                create_times[rs->getString(1)][rs->getString(2)] = rs->getString(4);
+            }
+          }
+        }
+
+        {
+          std::unique_ptr<sql::ResultSet> rs(
+            stmt->executeQuery("SELECT ROUTINE_SCHEMA, ROUTINE_NAME, ROUTINE_TYPE FROM INFORMATION_SCHEMA.ROUTINES "
+                               "WHERE ROUTINE_SCHEMA IN (" +
+                               schemaList + ")"));
+          while (rs->next()) {
+            auto iterator = contents.find(rs->getString(1));
+            if (iterator == contents.end())
+              continue;
+
+            if (rs->getString(3) == "PROCEDURE")
+              iterator->second.procedures->push_back(rs->getString(2));
+            else
+              iterator->second.functions->push_back(rs->getString(2));
+          }
+        }
+
+        if (cache != nullptr) {
+          for (auto &name : fetched) {
+            SchemaContent &content = contents[name];
+            cache->store_schema_contents(name, digests[name], content.tables, content.views, content.procedures,
+                                         content.functions);
+          }
+        }
+      }
+
+      // Schemas taken from the cache did not change at all.
+      for (auto &name : chunk) {
+        if (std::find(fetched.begin(), fetched.end(), name) == fetched.end())
+          update_table_versions(name, nullptr);
+        else
+          update_table_versions(name, &create_times[name]);
+      }
+
+      for (size_t i = done; i < done + count; ++i) {
+        SchemaContent &content = contents[schema_names[i]];
+        bec::GRTManager::get()->run_once_when_idle(this, std::bind(arrived_slot, schema_names[i], content.tables,
+                                                                   content.views, content.procedures,
+                                                                   content.functions, false));
+        _owner->schema_meta_data_refreshed(schema_names[i], content.tables, content.views, content.procedures,
+                                           content.functions);
+      }
+      done += count;
+    }
+  } catch (const sql::SQLException &e) {
+    logWarning("Bulk loading of schema contents failed, falling back to loading schemas one by one: %s\n",
+               strfmt(SQL_EXCEPTION_MSG_FORMAT, e.getErrorCode(), e.what()).c_str());
+
+    // Since we are already in the fetch task here, load the remaining schemas directly.
+    for (size_t i = done; i < schema_names.size(); ++i)
+      do_fetch_live_schema_contents(self_ptr, schema_names[i], arrived_slot);
+  }
+
+  return grt::StringRef("");
+}
+
+//--------------------------------------------------------------------------------------------------
+
 grt::StringRef SqlEditorTreeController::do_fetch_data_for_filter(
   std::weak_ptr<SqlEditorTreeController> self_ptr, const std::string &schema_filter, const std::string &object_filter,
   wb::LiveSchemaTree::NewSchemaContentArrivedSlot arrived_slot) {
@@ -635,6 +878,126 @@ grt::StringRef SqlEditorTreeController::do_fetch_data_for_filter(
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Reads the column at the current row of the result set, which must hold the values of the
+ * SHOW FULL COLUMNS result (Field, Type, Collation, Null, Key, Default, Extra), starting at the given index.
+ */
+static void read_column_data(sql::ResultSet *rs, int first, wb::LiveSchemaTree::ObjectType owner_type,
+                             StringListPtr columns, std::map<std::string, LiveSchemaTree::ColumnData> &column_data) {
+  LiveSchemaTree::ColumnData col_node(owner_type);
+  std::string column_name = rs->getString(first);
+
+  columns->push_back(column_name);
+
+  std::string type = rs->getString(first + 1);
+  std::string collation = rs->isNull(first + 2) ? "" : rs->getString(first + 2);
+  std::string nullable = rs->getString(first + 3);
+  std::string key = rs->getString(first + 4);
+  std::string default_value = rs->getString(first + 5);
+  std::string extra = rs->getString(first + 6);
+
+  base::replaceStringInplace(type, "unsigned", "UN");
+
+  if (extra == "auto_increment")
+    type += " AI";
+
+  col_node.name = column_name;
+  col_node.type = type;
+  col_node.charset_collation = collation;
+  col_node.is_pk = key == "PRI";
+  col_node.is_id = (col_node.is_pk || (nullable == "NO" && key == "UNI"));
+  col_node.is_idx = key != "";
+  col_node.default_value = default_value;
+
+  column_data[column_name] = col_node;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Puts the loaded columns of a table or view into the schema tree.
+ */
+void SqlEditorTreeController::update_column_nodes(const std::string &schema_name, const std::string &obj_name,
+                                                  wb::LiveSchemaTree::ObjectType type, StringListPtr columns,
+                                                  std::map<std::string, LiveSchemaTree::ColumnData> &column_data,
+                                                  const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &updater_slot) {
+  LiveSchemaTree::ViewData *pdata = NULL;
+
+  // Creates the node if it didn't exist...
+  mforms::TreeNodeRef node = _schema_tree->get_node_for_object(schema_name, type, obj_name);
+  if (!node)
+    node = _schema_tree->create_node_for_object(schema_name, type, obj_name);
+
+  if (node)
+    pdata = dynamic_cast<LiveSchemaTree::ViewData *>(node->get_data());
+  else
+    logWarning("Error fetching column information for '%s'.'%s'", schema_name.c_str(), obj_name.c_str());
+
+  if (pdata) {
+    // Identifies the node that will be the parent for the loaded columns...
+    mforms::TreeNodeRef target_parent;
+    if (pdata->get_type() == LiveSchemaTree::Table) {
+      target_parent = node->get_child(wb::LiveSchemaTree::TABLE_COLUMNS_NODE_INDEX);
+      type = LiveSchemaTree::TableColumn;
+    } else if (pdata->get_type() == LiveSchemaTree::View) {
+      target_parent = node;
+      type = LiveSchemaTree::ViewColumn;
+    }
+
+    if (target_parent) {
+      updater_slot(target_parent, columns, type, false, false);
+
+      for (int index = 0; index < target_parent->count(); index++) {
+        mforms::TreeNodeRef child = target_parent->get_child(index);
+        LiveSchemaTree::LSTData *pchilddata = dynamic_cast<LiveSchemaTree::LSTData *>(child->get_data());
+        LiveSchemaTree::LSTData *psource = &column_data[child->get_string(0)];
+        pchilddata->copy(psource);
+      }
+
+      pdata->columns_load_error = false;
+      pdata->set_loaded_data(LiveSchemaTree::COLUMN_DATA);
+      _schema_tree->notify_on_reload(target_parent);
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Puts the loaded indexes, triggers or foreign keys of a table into the schema tree.
+ */
+template <class T>
+static void update_table_child_nodes(wb::LiveSchemaTree *schema_tree, const std::string &schema_name,
+                                     const std::string &obj_name, wb::LiveSchemaTree::ObjectType type,
+                                     int child_node_index, wb::LiveSchemaTree::ObjectType child_type,
+                                     short data_mask, StringListPtr names, std::map<std::string, T> &data_dict,
+                                     const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &updater_slot) {
+  // Searches for the target node...
+  mforms::TreeNodeRef node = schema_tree->get_node_for_object(schema_name, type, obj_name);
+
+  // Creates the node if it didn't exist...
+  if (!node)
+    node = schema_tree->create_node_for_object(schema_name, type, obj_name);
+
+  // Identifies the node that will be the parent for the loaded data...
+  mforms::TreeNodeRef target_parent = node->get_child(child_node_index);
+  updater_slot(target_parent, names, child_type, false, false);
+
+  for (int index = 0; index < target_parent->count(); index++) {
+    mforms::TreeNodeRef child = target_parent->get_child(index);
+    LiveSchemaTree::LSTData *pchilddata = dynamic_cast<LiveSchemaTree::LSTData *>(child->get_data());
+    LiveSchemaTree::LSTData *psource = &data_dict[child->get_string(0)];
+    pchilddata->copy(psource);
+  }
+
+  // Whether there was data or not, it was loaded.
+  LiveSchemaTree::ViewData *pdata = dynamic_cast<LiveSchemaTree::ViewData *>(node->get_data());
+  pdata->set_loaded_data(data_mask);
+  schema_tree->notify_on_reload(target_parent);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void SqlEditorTreeController::fetch_column_data(const std::string &schema_name, const std::string &obj_name,
                                                 wb::LiveSchemaTree::ObjectType type,
                                                 const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &updater_slot) {
@@ -654,80 +1017,19 @@ void SqlEditorTreeController::fetch_column_data(const std::string &schema_name,
   try {
     sql::Dbc_connection_handler::Ref conn;
 
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
     std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
     std::auto_ptr<sql::ResultSet> rs(
       stmt->executeQuery(std::string(base::sqlstring("SHOW FULL COLUMNS FROM !.!", 0) << schema_name << obj_name)));
 
-    while (rs->next()) {
-      LiveSchemaTree::ColumnData col_node(type);
-      std::string column_name = rs->getString(1);
-
-      columns->push_back(column_name);
-
-      std::string type = rs->getString(2);
-      std::string collation = rs->isNull(3) ? "" : rs->getString(3);
-      std::string nullable = rs->getString(4);
-      std::string key = rs->getString(5);
-      std::string default_value = rs->getString(6);
-      std::string extra = rs->getString(7);
-
-      base::replaceStringInplace(type, "unsigned", "UN");
-
-      if (extra == "auto_increment")
-        type += " AI";
-
-      col_node.name = column_name;
-      col_node.type = type;
-      col_node.charset_collation = collation;
-      col_node.is_pk = key == "PRI";
-      col_node.is_id = (col_node.is_pk || (nullable == "NO" && key == "UNI"));
-      col_node.is_idx = key != "";
-      col_node.default_value = default_value;
-
-      column_data[column_name] = col_node;
-    }
+    while (rs->next())
+      read_column_data(rs.get(), 1, type, columns, column_data);
 
     // If information was found, creates the TreeNode structure for it
-    if (columns->size()) {
-      // Creates the node if it didn't exist...
-      if (!node) {
-        node = _schema_tree->create_node_for_object(schema_name, type, obj_name);
-
-        if (node)
-          pdata = dynamic_cast<LiveSchemaTree::ViewData *>(node->get_data());
-        else
-          logWarning("Error fetching column information for '%s'.'%s'", schema_name.c_str(), obj_name.c_str());
-      }
-
-      if (pdata) {
-        // Identifies the node that will be the parent for the loaded columns...
-        mforms::TreeNodeRef target_parent;
-        if (pdata->get_type() == LiveSchemaTree::Table) {
-          target_parent = node->get_child(wb::LiveSchemaTree::TABLE_COLUMNS_NODE_INDEX);
-          type = LiveSchemaTree::TableColumn;
-        } else if (pdata->get_type() == LiveSchemaTree::View) {
-          target_parent = node;
-          type = LiveSchemaTree::ViewColumn;
-        }
-
-        if (target_parent) {
-          updater_slot(target_parent, columns, type, false, false);
-
-          for (int index = 0; index < target_parent->count(); index++) {
-            mforms::TreeNodeRef child = target_parent->get_child(index);
-            LiveSchemaTree::LSTData *pchilddata = dynamic_cast<LiveSchemaTree::LSTData *>(child->get_data());
-            LiveSchemaTree::LSTData *psource = &column_data[child->get_string(0)];
-            pchilddata->copy(psource);
-          }
-
-          pdata->columns_load_error = false;
-          pdata->set_loaded_data(LiveSchemaTree::COLUMN_DATA);
-          _schema_tree->notify_on_reload(target_parent);
-        }
-      }
-    }
+    if (columns->size())
+      update_column_nodes(schema_name, obj_name, type, columns, column_data, updater_slot);
   } catch (const sql::SQLException &exc) {
     logWarning("Error fetching column information for '%s'.'%s': %s", schema_name.c_str(), obj_name.c_str(),
                exc.what());
@@ -755,7 +1057,8 @@ void SqlEditorTreeController::fetch_trigger_data(const std::string &schema_name,
   try {
     sql::Dbc_connection_handler::Ref conn;
 
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
     std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
     std::auto_ptr<sql::ResultSet> rs(
@@ -772,29 +1075,9 @@ void SqlEditorTreeController::fetch_trigger_data(const std::string &schema_name,
       trigger_data_dict[name] = trigger_node;
     }
 
-    // If information was found, creates the TreeNode structure for it
-    // Searches for the target node...
-    mforms::TreeNodeRef node = _schema_tree->get_node_for_object(schema_name, type, obj_name);
-
-    // Creates the node if it didn't exist...
-    if (!node)
-      node = _schema_tree->create_node_for_object(schema_name, type, obj_name);
-
-    // Identifies the node that will be the parent for the loaded columns...
-    mforms::TreeNodeRef target_parent = node->get_child(wb::LiveSchemaTree::TABLE_TRIGGERS_NODE_INDEX);
-    updater_slot(target_parent, triggers, LiveSchemaTree::Trigger, false, false);
-
-    for (int index = 0; index < target_parent->count(); index++) {
-      mforms::TreeNodeRef child = target_parent->get_child(index);
-      LiveSchemaTree::LSTData *pchilddata = dynamic_cast<LiveSchemaTree::LSTData *>(child->get_data());
-      LiveSchemaTree::LSTData *psource = &trigger_data_dict[child->get_string(0)];
-      pchilddata->copy(psource);
-    }
-
-    // Where there data or not the triggers were loaded
-    LiveSchemaTree::ViewData *pdata = dynamic_cast<LiveSchemaTree::ViewData *>(node->get_data());
-    pdata->set_loaded_data(LiveSchemaTree::TRIGGER_DATA);
-    _schema_tree->notify_on_reload(target_parent);
+    update_table_child_nodes(_schema_tree, schema_name, obj_name, type, wb::LiveSchemaTree::TABLE_TRIGGERS_NODE_INDEX,
+                             LiveSchemaTree::Trigger, LiveSchemaTree::TRIGGER_DATA, triggers, trigger_data_dict,
+                             updater_slot);
   } catch (const sql::SQLException &exc) {
     g_warning("Error fetching trigger information for '%s'.'%s': %s", schema_name.c_str(), obj_name.c_str(),
               exc.what());
@@ -811,7 +1094,8 @@ void SqlEditorTreeController::fetch_index_data(const std::string &schema_name, c
   try {
     sql::Dbc_connection_handler::Ref conn;
 
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
     std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
     std::auto_ptr<sql::ResultSet> rs(
@@ -841,27 +1125,9 @@ void SqlEditorTreeController::fetch_index_data(const std::string &schema_name, c
       index_data_dict[name].columns.push_back(rs->getString(5));
     }
 
-    // Searches for the target node...
-    mforms::TreeNodeRef node = _schema_tree->get_node_for_object(schema_name, type, obj_name);
-
-    // Creates the node if it didn't exist...
-    if (!node)
-      node = _schema_tree->create_node_for_object(schema_name, type, obj_name);
-
-    // Identifies the node that will be the parent for the loaded indexes...
-    mforms::TreeNodeRef target_parent = node->get_child(wb::LiveSchemaTree::TABLE_INDEXES_NODE_INDEX);
-    updater_slot(target_parent, indexes, LiveSchemaTree::Index, false, false);
-
-    for (int index = 0; index < target_parent->count(); index++) {
-      mforms::TreeNodeRef child = target_parent->get_child(index);
-      LiveSchemaTree::LSTData *pchilddata = dynamic_cast<LiveSchemaTree::LSTData *>(child->get_data());
-      LiveSchemaTree::LSTData *psource = &index_data_dict[child->get_string(0)];
-      pchilddata->copy(psource);
-    }
-
-    LiveSchemaTree::ViewData *pdata = dynamic_cast<LiveSchemaTree::ViewData *>(node->get_data());
-    pdata->set_loaded_data(LiveSchemaTree::INDEX_DATA);
-    _schema_tree->notify_on_reload(target_parent);
+    update_table_child_nodes(_schema_tree, schema_name, obj_name, type, wb::LiveSchemaTree::TABLE_INDEXES_NODE_INDEX,
+                             LiveSchemaTree::Index, LiveSchemaTree::INDEX_DATA, indexes, index_data_dict,
+                             updater_slot);
   } catch (const sql::SQLException &exc) {
     g_warning("Error fetching index information for '%s'.'%s': %s", schema_name.c_str(), obj_name.c_str(), exc.what());
   }
@@ -875,7 +1141,8 @@ void SqlEditorTreeController::fetch_foreign_key_data(const std::string &schema_n
 
   sql::Dbc_connection_handler::Ref conn;
 
-  RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+  RecMutexLock metadata_dbc_conn_mutex(
+    _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
   try {
     std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
@@ -996,27 +1263,9 @@ void SqlEditorTreeController::fetch_foreign_key_data(const std::string &schema_n
       }
     }
 
-    // Searches for the target node...
-    mforms::TreeNodeRef node = _schema_tree->get_node_for_object(schema_name, type, obj_name);
-
-    // Creates the node if it didn't exist...
-    if (!node)
-      node = _schema_tree->create_node_for_object(schema_name, type, obj_name);
-
-    // Identifies the node that will be the parent for the loaded columns...
-    mforms::TreeNodeRef target_parent = node->get_child(wb::LiveSchemaTree::TABLE_FOREIGN_KEYS_NODE_INDEX);
-    updater_slot(target_parent, foreign_keys, LiveSchemaTree::ForeignKey, false, false);
-
-    for (int index = 0; index < target_parent->count(); index++) {
-      mforms::TreeNodeRef child = target_parent->get_child(index);
-      LiveSchemaTree::LSTData *pchilddata = dynamic_cast<LiveSchemaTree::LSTData *>(child->get_data());
-      LiveSchemaTree::LSTData *psource = &fk_data_dict[child->get_string(0)];
-      pchilddata->copy(psource);
-    }
-
-    LiveSchemaTree::ViewData *pdata = dynamic_cast<LiveSchemaTree::ViewData *>(node->get_data());
-    pdata->set_loaded_data(LiveSchemaTree::FK_DATA);
-    _schema_tree->notify_on_reload(target_parent);
+    update_table_child_nodes(_schema_tree, schema_name, obj_name, type,
+                             wb::LiveSchemaTree::TABLE_FOREIGN_KEYS_NODE_INDEX, LiveSchemaTree::ForeignKey,
+                             LiveSchemaTree::FK_DATA, foreign_keys, fk_data_dict, updater_slot);
   } catch (const sql::SQLException &exc) {
     g_warning("Error fetching foreign key information for '%s'.'%s': %s", schema_name.c_str(), obj_name.c_str(),
               exc.what());
@@ -1050,6 +1299,219 @@ bool SqlEditorTreeController::fetch_object_details(const std::string &schema_nam
   return false;
 }
 
+/**
+ * Runs a query on the connection as a cached prepared statement, binding the values to its placeholders in order.
+ */
+static sql::ResultSet *execute_prepared(sql::Dbc_connection_handler::Ref &conn, const std::string &query,
+                                        const std::vector<std::string> &values) {
+  sql::PreparedStatement *statement = conn->prepared_statement(query);
+  for (size_t i = 0; i < values.size(); ++i)
+    statement->setString((unsigned int)(i + 1), values[i]);
+  return statement->executeQuery();
+}
+
+/**
+ * Loads the details of several tables or views of a schema with INFORMATION_SCHEMA queries, which each cover
+ * a chunk of objects, instead of up to 4 statements per object. Servers before 5.5 use the per object path.
+ */
+bool SqlEditorTreeController::fetch_objects_details(const std::string &schema_name,
+                                                    const std::vector<std::string> &object_names,
+                                                    wb::LiveSchemaTree::ObjectType type, short flags,
+                                                    const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &updater_slot) {
+  if (object_names.size() < 2 || (type != wb::LiveSchemaTree::Table && type != wb::LiveSchemaTree::View) ||
+      !_owner->rdbms_version().is_valid() || !is_supported_mysql_version_at_least(_owner->rdbms_version(), 5, 5)) {
+    for (auto &name : object_names)
+      fetch_object_details(schema_name, name, type, flags, updater_slot);
+    return false;
+  }
+
+  logDebug3("Fetching details for %i objects in %s\n", (int)object_names.size(), schema_name.c_str());
+
+  bool supportVisibility = is_supported_mysql_version_at_least(_owner->rdbms_version(), 8, 0, 0);
+  for (size_t done = 0; done < object_names.size(); done += SCHEMA_FETCH_CHUNK_SIZE) {
+    size_t count = std::min(SCHEMA_FETCH_CHUNK_SIZE, object_names.size() - done);
+    std::vector<std::string> names(object_names.begin() + done, object_names.begin() + done + count);
+
+    // The queries are prepared once per connection and chunk size, with the schema and object names as parameters.
+    std::vector<std::string> values(1, schema_name);
+    values.insert(values.end(), names.begin(), names.end());
+    std::string placeholders;
+    for (size_t i = 0; i < names.size(); ++i)
+      placeholders += i == 0 ? "?" : ", ?";
+
+    // Objects for which the bulk query failed or returned nothing (e.g. broken views) are loaded one by one,
+    // to get the same error handling as before.
+    std::set<std::string> missing_columns;
+    try {
+      sql::Dbc_connection_handler::Ref conn;
+      RecMutexLock metadata_dbc_conn_mutex(
+        _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
+
+      if (flags & wb::LiveSchemaTree::COLUMN_DATA) {
+        std::map<std::string, StringListPtr> columns;
+        std::map<std::string, std::map<std::string, LiveSchemaTree::ColumnData> > column_data;
+        std::unique_ptr<sql::ResultSet> rs(execute_prepared(
+          conn,
+          "SELECT TABLE_NAME, COLUMN_NAME, COLUMN_TYPE, COLLATION_NAME, IS_NULLABLE, COLUMN_KEY, COLUMN_DEFAULT, EXTRA "
+          "FROM INFORMATION_SCHEMA.COLUMNS WHERE TABLE_SCHEMA = ? AND TABLE_NAME IN (" +
+            placeholders + ") ORDER BY TABLE_NAME, ORDINAL_POSITION",
+          values));
+        while (rs->next()) {
+          std::string table = rs->getString(1);
+          StringListPtr &list = columns[table];
+          if (!list)
+            list.reset(new std::list<std::string>());
+          read_column_data(rs.get(), 2, type, list, column_data[table]);
+        }
+
+        for (auto &name : names) {
+          auto iterator = columns.find(name);
+          if (iterator == columns.end())
+            missing_columns.insert(name);
+          else
+            update_column_nodes(schema_name, name, type, iterator->second, column_data[name], updater_slot);
+        }
+      }
+
+      if ((flags & wb::LiveSchemaTree::INDEX_DATA) && type == wb::LiveSchemaTree::Table) {
+        std::map<std::string, StringListPtr> indexes;
+        std::map<std::string, std::map<std::string, LiveSchemaTree::IndexData> > index_data;
+        const char *query = supportVisibility
+                              ? "SELECT TABLE_NAME, INDEX_NAME, NON_UNIQUE, COLUMN_NAME, INDEX_TYPE, SEQ_IN_INDEX, "
+                                "IS_VISIBLE FROM INFORMATION_SCHEMA.STATISTICS WHERE TABLE_SCHEMA = ? AND TABLE_NAME IN ("
+                              : "SELECT TABLE_NAME, INDEX_NAME, NON_UNIQUE, COLUMN_NAME, INDEX_TYPE, SEQ_IN_INDEX, "
+                                "'YES' FROM INFORMATION_SCHEMA.STATISTICS WHERE TABLE_SCHEMA = ? AND TABLE_NAME IN (";
+        std::unique_ptr<sql::ResultSet> rs(execute_prepared(conn, query + placeholders + ")", values));
+        while (rs->next()) {
+          std::string table = rs->getString(1);
+          std::string name = rs->getString(2);
+          std::map<std::string, LiveSchemaTree::IndexData> &dict = index_data[table];
+
+          if (!dict.count(name)) {
+            StringListPtr &list = indexes[table];
+            if (!list)
+              list.reset(new std::list<std::string>());
+            list->push_back(name);
+
+            dict[name].type = wb::LiveSchemaTree::internalize_token(rs->getString(5));
+            dict[name].unique = rs->getInt(3) == 0;
+            dict[name].visible = rs->getString(7) == "YES";
+          }
+
+          // Rows are not ordered by column position.
+          std::vector<base::InternedString> &index_columns = dict[name].columns;
+          size_t position = std::max(1, rs->getInt(6));
+          if (index_columns.size() < position)
+            index_columns.resize(position);
+          index_columns[position - 1] = rs->getString(4);
+        }
+
+        for (auto &name : names) {
+          StringListPtr &list = indexes[name];
+          if (!list)
+            list.reset(new std::list<std::string>());
+          update_table_child_nodes(_schema_tree, schema_name, name, type, wb::LiveSchemaTree::TABLE_INDEXES_NODE_INDEX,
+                                   LiveSchemaTree::Index, LiveSchemaTree::INDEX_DATA, list, index_data[name],
+                                   updater_slot);
+        }
+      }
+
+      if ((flags & wb::LiveSchemaTree::TRIGGER_DATA) && type == wb::LiveSchemaTree::Table) {
+        std::map<std::string, StringListPtr> triggers;
+        std::map<std::string, std::map<std::string, LiveSchemaTree::TriggerData> > trigger_data;
+        std::unique_ptr<sql::ResultSet> rs(
+          execute_prepared(conn,
+                           "SELECT EVENT_OBJECT_TABLE, TRIGGER_NAME, EVENT_MANIPULATION, ACTION_TIMING "
+                           "FROM INFORMATION_SCHEMA.TRIGGERS WHERE EVENT_OBJECT_SCHEMA = ? AND EVENT_OBJECT_TABLE IN (" +
+                             placeholders + ")",
+                           values));
+        while (rs->next()) {
+          std::string table = rs->getString(1);
+          std::string name = rs->getString(2);
+
+          StringListPtr &list = triggers[table];
+          if (!list)
+            list.reset(new std::list<std::string>());
+          list->push_back(name);
+
+          LiveSchemaTree::TriggerData &trigger = trigger_data[table][name];
+          trigger.event_manipulation = wb::LiveSchemaTree::internalize_token(rs->getString(3));
+          trigger.timing = wb::LiveSchemaTree::internalize_token(rs->getString(4));
+        }
+
+        for (auto &name : names) {
+          StringListPtr &list = triggers[name];
+          if (!list)
+            list.reset(new std::list<std::string>());
+          update_table_child_nodes(_schema_tree, schema_name, name, type,
+                                   wb::LiveSchemaTree::TABLE_TRIGGERS_NODE_INDEX, LiveSchemaTree::Trigger,
+                                   LiveSchemaTree::TRIGGER_DATA, list, trigger_data[name], updater_slot);
+        }
+      }
+
+      if ((flags & wb::LiveSchemaTree::FK_DATA) && type == wb::LiveSchemaTree::Table) {
+        std::map<std::string, StringListPtr> foreign_keys;
+        std::map<std::string, std::map<std::string, LiveSchemaTree::FKData> > fk_data;
+        std::unique_ptr<sql::ResultSet> rs(execute_prepared(
+          conn,
+          "SELECT kcu.TABLE_NAME, kcu.CONSTRAINT_NAME, kcu.COLUMN_NAME, kcu.REFERENCED_TABLE_SCHEMA, "
+          "kcu.REFERENCED_TABLE_NAME, kcu.REFERENCED_COLUMN_NAME, rc.UPDATE_RULE, rc.DELETE_RULE "
+          "FROM INFORMATION_SCHEMA.KEY_COLUMN_USAGE kcu "
+          "JOIN INFORMATION_SCHEMA.REFERENTIAL_CONSTRAINTS rc ON rc.CONSTRAINT_SCHEMA = kcu.CONSTRAINT_SCHEMA AND "
+          "rc.TABLE_NAME = kcu.TABLE_NAME AND rc.CONSTRAINT_NAME = kcu.CONSTRAINT_NAME "
+          "WHERE kcu.TABLE_SCHEMA = ? AND kcu.TABLE_NAME IN (" +
+            placeholders + ") ORDER BY kcu.TABLE_NAME, kcu.CONSTRAINT_NAME, kcu.ORDINAL_POSITION",
+          values));
+        while (rs->next()) {
+          std::string table = rs->getString(1);
+          std::string name = rs->getString(2);
+          std::map<std::string, LiveSchemaTree::FKData> &dict = fk_data[table];
+
+          if (!dict.count(name)) {
+            StringListPtr &list = foreign_keys[table];
+            if (!list)
+              list.reset(new std::list<std::string>());
+            list->push_back(name);
+
+            LiveSchemaTree::FKData &new_fk = dict[name];
+            std::string referenced_schema = rs->getString(4);
+            new_fk.referenced_table = rs->getString(5);
+            if (referenced_schema != schema_name)
+              new_fk.referenced_table = referenced_schema + "." + new_fk.referenced_table.str();
+            new_fk.update_rule = wb::LiveSchemaTree::internalize_token(rs->getString(7));
+            new_fk.delete_rule = wb::LiveSchemaTree::internalize_token(rs->getString(8));
+            new_fk.from_cols = rs->getString(3);
+            new_fk.to_cols = rs->getString(6);
+          } else {
+            dict[name].from_cols.append(", ").append(rs->getString(3));
+            dict[name].to_cols.append(", ").append(rs->getString(6));
+          }
+        }
+
+        for (auto &name : names) {
+          StringListPtr &list = foreign_keys[name];
+          if (!list)
+            list.reset(new std::list<std::string>());
+          update_table_child_nodes(_schema_tree, schema_name, name, type,
+                                   wb::LiveSchemaTree::TABLE_FOREIGN_KEYS_NODE_INDEX, LiveSchemaTree::ForeignKey,
+                                   LiveSchemaTree::FK_DATA, list, fk_data[name], updater_slot);
+        }
+      }
+    } catch (const sql::SQLException &exc) {
+      logWarning("Error fetching details for objects in '%s', loading them one by one: %s\n", schema_name.c_str(),
+                 exc.what());
+      for (auto &name : names)
+        fetch_object_details(schema_name, name, type, flags, updater_slot);
+      continue;
+    }
+
+    for (auto &name : missing_columns)
+      fetch_column_data(schema_name, name, type, updater_slot);
+  }
+
+  return false;
+}
+
 bool SqlEditorTreeController::fetch_routine_details(const std::string &schema_name, const std::string &obj_name,
                                                     wb::LiveSchemaTree::ObjectType type) {
   bool ret_val = false;
@@ -1062,7 +1524,8 @@ bool SqlEditorTreeController::fetch_routine_details(const std::string &schema_na
   try {
     sql::Dbc_connection_handler::Ref conn;
 
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
     std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
     std::auto_ptr<sql::ResultSet> rs(
@@ -1131,7 +1594,8 @@ wb::LiveSchemaTree::ObjectType SqlEditorTreeController::fetch_object_type(const
 
     {
       sql::Dbc_connection_handler::Ref conn;
-      RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+      RecMutexLock metadata_dbc_conn_mutex(
+        _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
       {
         std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
@@ -1155,7 +1619,16 @@ wb::LiveSchemaTree::ObjectType SqlEditorTreeController::fetch_object_type(const
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Called when the user explicitly refreshes the schema tree. Everything is loaded again from the server then.
+ */
 void SqlEditorTreeController::tree_refresh() {
+  if (_owner->schema_metadata_cache() != nullptr)
+    _owner->schema_metadata_cache()->invalidate();
+  refresh_schema_tree();
+}
+
+void SqlEditorTreeController::refresh_schema_tree() {
   if (_owner->connected()) {
     live_schemata_refresh_task->exec(false, std::bind((grt::StringRef(SqlEditorTreeController::*)(SqlEditorForm::Ptr)) &
                                                         SqlEditorTreeController::do_refresh_schema_tree_safe,
@@ -1382,7 +1855,7 @@ void SqlEditorTreeController::do_alter_live_object(wb::LiveSchemaTree::ObjectTyp
         sql::Dbc_connection_handler::Ref conn;
         RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
         if (conn)
-          _owner->get_session_variable(conn->ref.get(), "sql_mode", sql_mode);
+          _owner->get_session_variable(conn, "sql_mode", sql_mode);
       }
 
       // if this is a View, then auto-reformat it before sending it to parser/editor
@@ -1655,7 +2128,8 @@ std::string SqlEditorTreeController::get_object_ddl_script(wb::LiveSchemaTree::O
     sql::Dbc_connection_handler::Ref conn;
     std::string query;
 
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
     // Can't use getSchemaObjects() because it silently ignores errors.
     switch (type) {
@@ -1728,7 +2202,8 @@ std::string SqlEditorTreeController::get_object_ddl_script(wb::LiveSchemaTree::O
     if (type == wb::LiveSchemaTree::View && e.getErrorCode() == 1356) {
       sql::Dbc_connection_handler::Ref conn;
       std::string query, view;
-      RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+      RecMutexLock metadata_dbc_conn_mutex(
+        _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
       query = base::sqlstring(
                 "SELECT DEFINER, SECURITY_TYPE, VIEW_DEFINITION FROM INFORMATION_SCHEMA.VIEWS WHERE TABLE_SCHEMA = ? "
                 "AND TABLE_NAME = ?",
@@ -1777,7 +2252,8 @@ std::pair<std::string, std::string> SqlEditorTreeController::get_object_create_s
     sql::Dbc_connection_handler::Ref conn;
     std::string query;
 
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
     // cant use getSchemaObjects() because it silently ignores errors
     switch (type) {
@@ -1820,7 +2296,8 @@ std::pair<std::string, std::string> SqlEditorTreeController::get_object_create_s
       // Error for not being allowed to run SHOW CREATE VIEW. Use I_S instead to get the code.
       sql::Dbc_connection_handler::Ref conn;
       std::string query, view;
-      RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+      RecMutexLock metadata_dbc_conn_mutex(
+        _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
       query = base::sqlstring(
                 "SELECT DEFINER, SECURITY_TYPE, VIEW_DEFINITION FROM INFORMATION_SCHEMA.VIEWS WHERE TABLE_SCHEMA = ? "
                 "AND TABLE_NAME = ?",
@@ -1860,7 +2337,8 @@ std::vector<std::string> SqlEditorTreeController::get_trigger_sql_for_table(cons
 
   try {
     sql::Dbc_connection_handler::Ref conn;
-    RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
+    RecMutexLock metadata_dbc_conn_mutex(
+      _owner->ensure_valid_metadata_connection(conn, SqlEditorForm::InteractiveMetadata));
 
     std::vector<std::string> triggers;
     {
@@ -1964,7 +2442,7 @@ void SqlEditorTreeController::refresh_live_object_in_editor(bec::DBObjectEditorB
         sql::Dbc_connection_handler::Ref conn;
         RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
         if (conn)
-          _owner->get_session_variable(conn->ref.get(), "sql_mode", sql_mode);
+          _owner->get_session_variable(conn, "sql_mode", sql_mode);
       }
       CATCH_ANY_EXCEPTION_AND_DISPATCH(_("Get 'sql_mode' session variable"));
 
@@ -2334,7 +2812,7 @@ bool SqlEditorTreeController::expand_live_table_stub(bec::DBObjectEditorBE *tabl
       std::string sql_mode;
       sql::Dbc_connection_handler::Ref conn;
       RecMutexLock aux_dbc_conn_mutex(_owner->ensure_valid_aux_connection(conn));
-      if (conn && _owner->get_session_variable(conn->ref.get(), "sql_mode", sql_mode))
+      if (_owner->get_session_variable(conn, "sql_mode", sql_mode))
         options.gset("sql_mode", sql_mode);
       else
         logWarning("Unable to get sql_mode for connection");
@@ -2466,7 +2944,7 @@ void SqlEditorTreeController::handle_grt_notification(const std::string &name, g
   } else if (name == "GRNSQLEditorReconnected") {
     if (sender == _owner->wbsql()->get_grt_editor_object(_owner)) {
       _session_info->set_markup_text(_owner->get_connection_info());
-      tree_refresh();
+      refresh_schema_tree();
     }
   }
 }
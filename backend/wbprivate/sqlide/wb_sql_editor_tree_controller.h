@@ -84,6 +84,14 @@ private:
   wb::LiveSchemaTree _base_schema_tree;
   wb::LiveSchemaTree _filtered_schema_tree;
   base::Mutex _schema_contents_mutex;
+
+  // CREATE_TIME of the tables of each schema from the last content fetch and the tables that kept theirs,
+  // so a refresh doesn't need to reload the details of unchanged tables.
+  base::Mutex _table_versions_mutex;
+  std::map<std::string, std::map<std::string, std::string> > _table_create_times;
+  std::map<std::string, std::set<std::string> > _unchanged_tables;
+  void update_table_versions(const std::string &schema_name, const std::map<std::string, std::string> *create_times);
+
   GrtThreadedTask::Ref live_schema_fetch_task;
   GrtThreadedTask::Ref live_schemata_refresh_task;
   bool _is_refreshing_schema_tree;
@@ -107,11 +115,17 @@ private:
                                      const wb::LiveSchemaTree::NewSchemaContentArrivedSlot &arrived_slot);
   virtual bool fetch_schema_contents(const std::string &schema_name,
                                      const wb::LiveSchemaTree::NewSchemaContentArrivedSlot &arrived_slot);
+  virtual bool fetch_schemas_contents(const std::vector<std::string> &schema_names,
+                                      const wb::LiveSchemaTree::NewSchemaContentArrivedSlot &arrived_slot);
   virtual bool fetch_object_details(const std::string &schema_name, const std::string &object_name,
                                     wb::LiveSchemaTree::ObjectType type, short flags,
                                     const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &);
+  virtual bool fetch_objects_details(const std::string &schema_name, const std::vector<std::string> &object_names,
+                                     wb::LiveSchemaTree::ObjectType type, short flags,
+                                     const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &updater_slot);
   virtual bool fetch_routine_details(const std::string &schema_name, const std::string &obj_name,
                                      wb::LiveSchemaTree::ObjectType type);
+  virtual bool is_object_unchanged(const std::string &schema_name, const std::string &object_name);
   // LiveSchemaTree::Delegate
   virtual void tree_refresh();
   virtual bool sidebar_action(const std::string &);
@@ -128,7 +142,14 @@ private:
   grt::StringRef do_fetch_live_schema_contents(std::weak_ptr<SqlEditorTreeController> self_ptr,
                                                const std::string &schema_name,
                                                wb::LiveSchemaTree::NewSchemaContentArrivedSlot arrived_slot);
+  grt::StringRef do_fetch_live_schemas_contents(std::weak_ptr<SqlEditorTreeController> self_ptr,
+                                                std::vector<std::string> schema_names,
+                                                wb::LiveSchemaTree::NewSchemaContentArrivedSlot arrived_slot);
   wb::LiveSchemaTree::ObjectType fetch_object_type(const std::string &schema_name, const std::string &obj_name);
+  void update_column_nodes(const std::string &schema_name, const std::string &obj_name,
+                           wb::LiveSchemaTree::ObjectType type, base::StringListPtr columns,
+                           std::map<std::string, wb::LiveSchemaTree::ColumnData> &column_data,
+                           const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &updater_slot);
   void fetch_column_data(const std::string &schema_name, const std::string &obj_name,
                          wb::LiveSchemaTree::ObjectType type,
                          const wb::LiveSchemaTree::NodeChildrenUpdaterSlot &updater_slot);
@@ -146,6 +167,7 @@ private:
                                           const std::string &schema_filter, const std::string &object_filter,
                                           wb::LiveSchemaTree::NewSchemaContentArrivedSlot arrived_slot);
 
+  void refresh_schema_tree();
   void schema_row_selected();
   void side_bar_filter_changed(const std::string &filter);
   void sidebar_splitter_changed();
@@ -161,7 +161,7 @@ namespace ssh {
 
 
   SSHConnectionConfig::SSHConnectionConfig() : localport(0), bufferSize(10240),
-      remoteSSHport(22), remoteport(3306), strictHostKeyCheck(true), compressionLevel(5), connectTimeout(10), readWriteTimeout(5), commandTimeout(1), commandRetryCount(3) {
+      remoteSSHport(22), remoteport(3306), strictHostKeyCheck(true), compressionLevel(5), connectTimeout(10), readWriteTimeout(5), commandTimeout(1), commandRetryCount(3), sessionIdleTimeout(60) {
 
   }
 
@@ -172,6 +172,8 @@ namespace ssh {
     logDebug2("SSH readWriteTimeout: %lu\n", readWriteTimeout);
     logDebug2("SSH commandTimeout: %lu\n", commandTimeout);
     logDebug2("SSH commandRetryCount: %lu\n", commandRetryCount);
+    logDebug2("SSH sessionIdleTimeout: %lu\n", sessionIdleTimeout);
+    logDebug2("SSH compressionLevel: %i\n", compressionLevel);
     logDebug2("SSH optionsDir: %s\n", optionsDir.c_str());
     logDebug2("SSH known hosts file: %s\n", knownHostsFile.c_str());
     logDebug2("SSH strict host key check: %s\n", strictHostKeyCheck ? "yes" : "no");
@@ -181,7 +183,7 @@ namespace ssh {
     return (tun1.localhost == tun2.localhost && tun1.remoteSSHhost == tun2.remoteSSHhost
         && tun1.remoteSSHport == tun2.remoteSSHport && tun1.remotehost == tun2.remotehost
         && tun1.configFile == tun2.configFile && tun1.knownHostsFile == tun2.knownHostsFile
-        && tun1.connectTimeout == tun2.connectTimeout);
+        && tun1.connectTimeout == tun2.connectTimeout && tun1.compressionLevel == tun2.compressionLevel);
   }
 
   bool operator!=(const SSHConnectionConfig &tun1, const SSHConnectionConfig &tun2) {
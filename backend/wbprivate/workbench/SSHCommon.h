@@ -70,6 +70,15 @@ namespace ssh {
 #endif
   }
 
+  // True if the last socket call failed only because it would have to block.
+  inline bool wbSocketWouldBlock() {
+#if _MSC_VER
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+  }
+
   inline int wbPoll(pollfd *data, size_t size) {
 #if _MSC_VER
     return WSAPoll(data, static_cast<ULONG>(size), -1);
@@ -105,6 +114,7 @@ namespace ssh {
     std::size_t readWriteTimeout;
     std::size_t commandTimeout;
     std::size_t commandRetryCount;
+    std::size_t sessionIdleTimeout; // Seconds an SSH session without tunnels is kept for reuse.
     std::string getServer() {
       return remotehost + ":" + std::to_string(remoteport);
     }
@@ -177,6 +177,10 @@ namespace ssh {
     return _config;
   }
 
+  SSHConnectionCredentials SSHSession::getCredentials() const {
+    return _credentials;
+  }
+
   ssh::Session* SSHSession::getSession() const {
     return _session;
   }
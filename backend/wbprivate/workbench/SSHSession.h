@@ -61,6 +61,7 @@ namespace ssh {
     void disconnect();
     bool isConnected() const;
     SSHConnectionConfig getConfig() const;
+    SSHConnectionCredentials getCredentials() const;
     ssh::Session* getSession() const;
     std::string execCmd(std::string command, std::size_t logSize = LOG_SIZE_1MB);
     std::string execCmdSudo(std::string command, std::string password, std::string passwordQuery = "EnterPasswordHere",
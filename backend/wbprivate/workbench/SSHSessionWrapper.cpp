@@ -25,6 +25,7 @@
 #include "SSHFileWrapper.h"
 #include "base/log.h"
 #include <fcntl.h>
+#include <algorithm>
 #include <vector>
 #include "mforms/utilities.h"
 #include "base/string_utilities.h"
@@ -194,9 +195,10 @@ namespace ssh {
     config.readWriteTimeout = bec::GRTManager::get()->get_app_option_int("SSH:readWriteTimeout", 5);
     config.commandTimeout = bec::GRTManager::get()->get_app_option_int("SSH:commandTimeout", 1);
     config.commandRetryCount = bec::GRTManager::get()->get_app_option_int("SSH:commandRetryCount", 3);
+    config.sessionIdleTimeout = bec::GRTManager::get()->get_app_option_int("SSH:sessionIdleTimeout", 60);
     config.configFile = bec::GRTManager::get()->get_app_option_string("SSH:pathtosshconfig");
     config.knownHostsFile = bec::GRTManager::get()->get_app_option_string("SSH:knownhostsfile");
-    config.compressionLevel = static_cast<int>(connectionProperties->parameterValues().get_int("sshCompressionLevel", 0));
+    config.compressionLevel = std::max(0, std::min(9, static_cast<int>(parameter_values.get_int("sshCompressionLevel", 0))));
 
     auto parts = base::split(parameter_values.get_string("sshHost"), ":");
     config.remoteSSHhost = parts[0];
@@ -228,6 +230,7 @@ namespace ssh {
     config.readWriteTimeout = bec::GRTManager::get()->get_app_option_int("SSH:readWriteTimeout", 5);
     config.commandTimeout = bec::GRTManager::get()->get_app_option_int("SSH:commandTimeout", 1);
     config.commandRetryCount = bec::GRTManager::get()->get_app_option_int("SSH:commandRetryCount", 3);
+    config.sessionIdleTimeout = bec::GRTManager::get()->get_app_option_int("SSH:sessionIdleTimeout", 60);
     config.configFile = bec::GRTManager::get()->get_app_option_string("SSH:pathtosshconfig");
     config.knownHostsFile = bec::GRTManager::get()->get_app_option_string("SSH:knownhostsfile");
 
@@ -303,10 +306,28 @@ namespace ssh {
 
   }
 
+  /**
+   * Shows the progress of a file transfer in the status bar, at most once per percent.
+   */
+  static SSHSftp::ProgressSlot transferStatus(const std::string &action, const std::string &path) {
+    auto lastPercent = std::make_shared<int>(-1);
+    return [action, path, lastPercent](uint64_t done, uint64_t total) {
+      if (total == 0)
+        return;
+      int percent = static_cast<int>(std::min<uint64_t>(done * 100 / total, 100));
+      if (percent == *lastPercent)
+        return;
+      *lastPercent = percent;
+      bec::GRTManager::get()->replace_status_text(base::strfmt("%s %s: %s of %s", action.c_str(), path.c_str(),
+                                                               base::sizefmt(done, false).c_str(),
+                                                               base::sizefmt(total, false).c_str()));
+    };
+  }
+
   void SSHSessionWrapper::get(const std::string &src, const std::string &dest) {
     auto lock = _session->lockSession();
     if (_sftp)
-      _sftp->get(src, dest);
+      _sftp->get(src, dest, transferStatus("Downloading", src));
     else
       throw std::runtime_error("Not connected");
   }
@@ -371,7 +392,7 @@ namespace ssh {
     if (!_sftp)
       throw std::runtime_error("Not connected");
 
-    _sftp->put(src, dest);
+    _sftp->put(src, dest, transferStatus("Uploading", dest));
   }
 
   grt::StringRef SSHSessionWrapper::pwd() {
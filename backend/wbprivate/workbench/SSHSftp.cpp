@@ -28,11 +28,18 @@
 #ifndef _WIN32
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <deque>
 #include <vector>
 #include "SSHSftp.h"
 
 DEFAULT_LOG_DOMAIN("SSHSftp")
 
+// Size of a single read or write request, 32KB is accepted by every SFTP server.
+#define SFTP_CHUNK_SIZE 32768
+// Requests kept in flight, so that a transfer isn't limited to one chunk per round trip.
+#define SFTP_MAX_REQUESTS 32
+
 namespace ssh {
 
   SSHSftp::SSHSftp(std::shared_ptr<SSHSession> session, std::size_t maxFileSize)
@@ -217,112 +224,197 @@ namespace ssh {
     return ftpFileUniqueDeleter(new ftpFile(_file), [](ftpFile* f) { sftp_close(f->ptr); delete f;});
   }
 
-  void SSHSftp::get(const std::string &src, const std::string &dest) const {
-    auto lock = _session->lockSession();
-    sftp_file file = sftp_open(_sftp, createRemotePath(src).c_str(), O_RDONLY, 0);
-    if (file == nullptr)
-      throw SSHSftpException(_session->getSession()->getError());
+  /**
+   * Reads the whole file with up to SFTP_MAX_REQUESTS read requests outstanding. Replies arrive in request order,
+   * a short reply (which servers may send for any request) restarts the pipeline right after the data received.
+   */
+  void SSHSftp::readFile(sftp_file file, const std::function<void(const char *, std::size_t)> &consumer,
+                         const ProgressSlot &progress) const {
+    uint64_t total = 0;
+    sftp_attributes attributes = sftp_fstat(file);
+    if (attributes != nullptr) {
+      total = attributes->size;
+      sftp_attributes_free(attributes);
+    }
 
-    base::FileHandle fileHandle;
-    try {
-      fileHandle = base::FileHandle(dest, "w+", true);
-    } catch (base::file_error &fe) {
-      throw SSHSftpException(fe.what());
+    std::vector<char> buffer(SFTP_CHUNK_SIZE);
+    std::deque<uint32_t> requests;
+    uint64_t offset = 0;
+    bool eof = false;
+
+    while (!eof || !requests.empty()) {
+      while (!eof && requests.size() < SFTP_MAX_REQUESTS) {
+        int id = sftp_async_read_begin(file, SFTP_CHUNK_SIZE);
+        if (id < 0)
+          throw SSHSftpException(_session->getSession()->getError());
+        requests.push_back(static_cast<uint32_t>(id));
+      }
+
+      int nBytes = sftp_async_read(file, buffer.data(), SFTP_CHUNK_SIZE, requests.front());
+      requests.pop_front();
+      if (nBytes < 0)
+        throw SSHSftpException(_session->getSession()->getError());
+      if (eof)
+        continue; // Only collecting the replies to requests past the end.
+
+      if (nBytes == 0) {
+        eof = true;
+        continue;
+      }
+
+      consumer(buffer.data(), nBytes);
+      offset += nBytes;
+      if (progress)
+        progress(offset, total);
+
+      if (nBytes < SFTP_CHUNK_SIZE && !requests.empty()) {
+        // The following requests start at the wrong offset now. Collect their replies and continue behind the data.
+        while (!requests.empty()) {
+          sftp_async_read(file, buffer.data(), SFTP_CHUNK_SIZE, requests.front());
+          requests.pop_front();
+        }
+        sftp_seek64(file, offset);
+      }
     }
+  }
+
+  /**
+   * Writes the file in chunks the producer fills until it returns 0. With libssh 0.11+ up to
+   * SFTP_MAX_REQUESTS writes are in flight, older versions have no asynchronous writes and send one chunk at a time.
+   */
+  void SSHSftp::writeFile(sftp_file file, const std::function<std::size_t(char *, std::size_t)> &producer,
+                          uint64_t total, const ProgressSlot &progress) const {
+    std::vector<char> buffer(SFTP_CHUNK_SIZE);
+    uint64_t written = 0;
+
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    std::deque<sftp_aio> requests;
+    auto waitForOldest = [&]() {
+      sftp_aio aio = requests.front();
+      requests.pop_front();
+      ssize_t nWritten = sftp_aio_wait_write(&aio);
+      if (nWritten < 0) {
+        for (auto &pending : requests)
+          sftp_aio_free(pending);
+        throw SSHSftpException(_session->getSession()->getError());
+      }
+      written += nWritten;
+      if (progress)
+        progress(written, total);
+    };
 
-    char buffer[16384];
     while (true) {
-      ssize_t nBytes = sftp_read(file, buffer, sizeof(buffer));
+      std::size_t nBytes = producer(buffer.data(), buffer.size());
       if (nBytes == 0)
         break;
-      else if (nBytes < 0) {
-        sftp_close(file);
+
+      if (requests.size() == SFTP_MAX_REQUESTS)
+        waitForOldest();
+
+      // The data is copied into the request, so the buffer can be reused right away.
+      sftp_aio aio = nullptr;
+      if (sftp_aio_begin_write(file, buffer.data(), nBytes, &aio) < 0) {
+        for (auto &pending : requests)
+          sftp_aio_free(pending);
         throw SSHSftpException(_session->getSession()->getError());
       }
+      requests.push_back(aio);
+    }
+    while (!requests.empty())
+      waitForOldest();
+#else
+    while (true) {
+      std::size_t nBytes = producer(buffer.data(), buffer.size());
+      if (nBytes == 0)
+        break;
 
-      std::size_t nWritten = fwrite(buffer, sizeof(char), nBytes, fileHandle.file());
-      if (nBytes > 0 && nWritten != (std::size_t) nBytes) {
-        sftp_close(file);
+      ssize_t nWritten = sftp_write(file, buffer.data(), nBytes);
+      if (nWritten < 0 || (std::size_t)nWritten != nBytes)
         throw SSHSftpException("Error writing file");
-      }
+
+      written += nWritten;
+      if (progress)
+        progress(written, total);
     }
+#endif
+  }
 
-    int rc = sftp_close(file);
-    if (rc != SSH_OK)
+  void SSHSftp::get(const std::string &src, const std::string &dest, const ProgressSlot &progress) const {
+    auto lock = _session->lockSession();
+    auto file = createPtr(sftp_open(_sftp, createRemotePath(src).c_str(), O_RDONLY, 0));
+    if (!file->ptr)
       throw SSHSftpException(_session->getSession()->getError());
+
+    base::FileHandle fileHandle;
+    try {
+      fileHandle = base::FileHandle(dest, "wb", true);
+    } catch (base::file_error &fe) {
+      throw SSHSftpException(fe.what());
+    }
+
+    readFile(file->ptr, [&fileHandle](const char *data, std::size_t length) {
+      if (fwrite(data, sizeof(char), length, fileHandle.file()) != length)
+        throw SSHSftpException("Error writing file");
+    }, progress);
   }
 
   void SSHSftp::setContent(const std::string &path, const std::string &data) const {
     auto lock = _session->lockSession();
     auto file = createPtr(sftp_open(_sftp, createRemotePath(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU));
-    if (!file)
+    if (!file->ptr)
       throw SSHSftpException(_session->getSession()->getError());
 
-    ssize_t nWritten = sftp_write(file->ptr, data.c_str(), data.size());
-    if (nWritten > 0 && (std::size_t) nWritten != data.size()) {
-      throw SSHSftpException("Error writing file");
-    }
+    std::size_t offset = 0;
+    writeFile(file->ptr, [&data, &offset](char *buffer, std::size_t length) {
+      length = std::min(length, data.size() - offset);
+      memcpy(buffer, data.data() + offset, length);
+      offset += length;
+      return length;
+    }, data.size(), ProgressSlot());
   }
 
-  void SSHSftp::put(const std::string &src, const std::string &dest) const {
+  void SSHSftp::put(const std::string &src, const std::string &dest, const ProgressSlot &progress) const {
     auto lock = _session->lockSession();
-    auto file = createPtr(sftp_open(_sftp, createRemotePath(src).c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU));
-
-    if (!file)
-      throw SSHSftpException(_session->getSession()->getError());
 
     base::FileHandle fileHandle;
     try {
-      fileHandle = base::FileHandle(src, "w+", true);
+      fileHandle = base::FileHandle(src, "rb", true);
     } catch (base::file_error &fe) {
       throw SSHSftpException(fe.what());
     }
 
-    std::size_t buffSize = 16384;
-    std::vector<char> buff;
-    buff.reserve(buffSize);
-    while (true) {
+    auto file = createPtr(sftp_open(_sftp, createRemotePath(dest).c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU));
+    if (!file->ptr)
+      throw SSHSftpException(_session->getSession()->getError());
 
-      std::size_t nBytes = fread(buff.data(), sizeof(char), buffSize, fileHandle.file());
-      if (nBytes == buffSize) {
-        ssize_t nWritten = sftp_write(file->ptr, buff.data(), buffSize);
-        if (nWritten > 0 && (std::size_t) nWritten != buffSize) {
-          throw SSHSftpException("Error writing file");
-        }
-      } else if (feof(fileHandle.file())) {
-        ssize_t nWritten = sftp_write(file->ptr, buff.data(), nBytes);
-        if (nWritten > 0 && (std::size_t) nWritten != nBytes) {
-          throw SSHSftpException("Error writing file");
-        }
-      } else {
-        throw SSHSftpException("Error reading file");
-      }
+    uint64_t total = 0;
+    if (fseek(fileHandle.file(), 0, SEEK_END) == 0) {
+      long size = ftell(fileHandle.file());
+      if (size > 0)
+        total = static_cast<uint64_t>(size);
+      rewind(fileHandle.file());
     }
+
+    writeFile(file->ptr, [&fileHandle](char *buffer, std::size_t length) {
+      std::size_t nBytes = fread(buffer, sizeof(char), length, fileHandle.file());
+      if (nBytes < length && ferror(fileHandle.file()))
+        throw SSHSftpException("Error reading file");
+      return nBytes;
+    }, total, progress);
   }
 
   std::string SSHSftp::getContent(const std::string &src) const {
     auto lock = _session->lockSession();
     auto file = createPtr(sftp_open(_sftp, createRemotePath(src).c_str(), O_RDONLY, 0));
-    if (!file)
+    if (!file->ptr)
       throw SSHSftpException(_session->getSession()->getError());
 
     std::string buff;
-    size_t bytesCount = 0;
-    char buffer[16384];
-    while (true) {
-      ssize_t nBytes = sftp_read(file->ptr, buffer, sizeof(buffer));
-      if (nBytes == 0)
-        break;
-      else if (nBytes < 0) {
-        throw SSHSftpException(_session->getSession()->getError());
-      }
-      buff.append(buffer, nBytes);
-      bytesCount += nBytes;
-      if (bytesCount > _maxFileLimit) {
+    readFile(file->ptr, [this, &buff](const char *data, std::size_t length) {
+      buff.append(data, length);
+      if (buff.size() > _maxFileLimit)
         throw SSHSftpException("Max file limit exceeded\n.");
-      }
-
-    }
+    }, ProgressSlot());
 
     return buff;
   }
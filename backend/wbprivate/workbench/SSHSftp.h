@@ -41,6 +41,7 @@
 #include "SSHCommon.h"
 #include "SSHSession.h"
 #include "base/any.h"
+#include <functional>
 #include <vector>
 
 #if defined(_WIN32)
@@ -81,6 +82,11 @@ namespace ssh {
   };
 
   class MYSQLWBBACKEND_PUBLIC_FUNC SSHSftp {
+  public:
+    // Called with the bytes transferred so far and the size of the file (0 if unknown).
+    typedef std::function<void(uint64_t, uint64_t)> ProgressSlot;
+
+  private:
     std::shared_ptr<SSHSession> _session;
     sftp_session _sftp;
     std::size_t _maxFileLimit;
@@ -94,9 +100,9 @@ namespace ssh {
     void rmdir(const std::string &dirname);
     void unlink(const std::string &file);
     SftpStatAttrib stat(const std::string &path);
-    void get(const std::string &src, const std::string &dest) const;
+    void get(const std::string &src, const std::string &dest, const ProgressSlot &progress = ProgressSlot()) const;
     void setContent(const std::string &path, const std::string &data) const;
-    void put(const std::string &src, const std::string &dest) const;
+    void put(const std::string &src, const std::string &dest, const ProgressSlot &progress = ProgressSlot()) const;
     std::string getContent(const std::string &src) const;
     void setMaxFileLimit(std::size_t limit);
     int cd(const std::string &dirname);
@@ -110,6 +116,10 @@ namespace ssh {
     SSHSftp &operator =(SSHSftp&) = delete;
     void throwOnError(int rc) const;
     std::string createRemotePath(const std::string &path) const;
+    void readFile(sftp_file file, const std::function<void(const char *, std::size_t)> &consumer,
+                  const ProgressSlot &progress) const;
+    void writeFile(sftp_file file, const std::function<std::size_t(char *, std::size_t)> &producer, uint64_t total,
+                   const ProgressSlot &progress) const;
 
   };
 
@@ -21,6 +21,8 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <algorithm>
+
 #include "SSHTunnelHandler.h"
 
 #include "base/log.h"
@@ -35,12 +37,47 @@ DEFAULT_LOG_DOMAIN("SSHTunnelHandler")
 #  endif
 #endif
 
+// Lower bound for the buffers kept per direction and connection, SSH:BufferSize is often smaller than a TCP window.
+#define MIN_TRANSFER_BUFFER_SIZE (64 * 1024)
+
 namespace ssh {
 
+  TransferBuffer::TransferBuffer(std::size_t capacity) : _buffer(capacity), _start(0), _size(0) {
+  }
+
+  char *TransferBuffer::freeSpace(std::size_t &length) {
+    std::size_t end = (_start + _size) % _buffer.size();
+    if (end < _start || full())
+      length = _buffer.size() - _size;
+    else
+      length = _buffer.size() - end;
+    return _buffer.data() + end;
+  }
+
+  void TransferBuffer::produced(std::size_t length) {
+    _size += length;
+  }
+
+  const char *TransferBuffer::data(std::size_t &length) const {
+    length = std::min(_size, _buffer.size() - _start);
+    return _buffer.data() + _start;
+  }
+
+  void TransferBuffer::consumed(std::size_t length) {
+    _size -= length;
+    _start = _size == 0 ? 0 : (_start + length) % _buffer.size();
+  }
+
   SSHTunnelHandler::SSHTunnelHandler(uint16_t localPort, int localSocket, std::shared_ptr<SSHSession> session)
-      : _session(std::move(session)), _localPort(localPort), _localSocket(localSocket), _pollTimeout(-1) {
+      : _session(std::move(session)),
+        _localPort(localPort),
+        _localSocket(localSocket),
+        _pollTimeout(-1),
+        _idle(false),
+        _closing(false) {
     _event = ssh_event_new();
     ssh_event_add_session(_event, _session->getSession()->getCSession());
+    _listeners[localSocket] = { localPort, _session->getConfig() };
   }
 
   SSHTunnelHandler::~SSHTunnelHandler() {
@@ -66,6 +103,75 @@ namespace ssh {
     return _session->getConfig();
   }
 
+  /**
+   * A session can be shared by connections going through the same SSH server as the same user with the same key.
+   */
+  bool SSHTunnelHandler::canShareSession(const SSHConnectionConfig &config, const SSHConnectionCredentials &credentials) {
+    std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
+    if (_closing || !isRunning() || !_session->isConnected())
+      return false;
+
+    SSHConnectionConfig sessionConfig = _session->getConfig();
+    SSHConnectionCredentials sessionCredentials = _session->getCredentials();
+    return sessionConfig.remoteSSHhost == config.remoteSSHhost && sessionConfig.remoteSSHport == config.remoteSSHport &&
+           sessionConfig.configFile == config.configFile && sessionConfig.knownHostsFile == config.knownHostsFile &&
+           sessionConfig.localhost == config.localhost && sessionConfig.compressionLevel == config.compressionLevel &&
+           sessionCredentials.username == credentials.username &&
+           sessionCredentials.keyfile == credentials.keyfile && sessionCredentials.auth == credentials.auth;
+  }
+
+  // Returns false if the handler is about to close its session, the caller has to open a new one then.
+  bool SSHTunnelHandler::addListener(uint16_t localPort, int localSocket, const SSHConnectionConfig &target) {
+    std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
+    if (_closing)
+      return false;
+
+    _listeners[localSocket] = { localPort, target };
+    return true;
+  }
+
+  // Returns the local socket of the removed listener or -1. Connections that came in through it stay open, the
+  // session is closed after the idle timeout once nothing uses it anymore.
+  int SSHTunnelHandler::removeListener(const SSHConnectionConfig &target) {
+    std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
+    for (auto it = _listeners.begin(); it != _listeners.end(); ++it) {
+      if (it->second.target == target) {
+        int localSocket = it->first;
+        _listeners.erase(it);
+        return localSocket;
+      }
+    }
+    return -1;
+  }
+
+  uint16_t SSHTunnelHandler::findListener(const SSHConnectionConfig &target) {
+    std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
+    for (auto &listener : _listeners) {
+      if (listener.second.target == target)
+        return listener.second.port;
+    }
+    return 0;
+  }
+
+  bool SSHTunnelHandler::idleTimeoutReached() {
+    std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
+    if (!_listeners.empty() || !_clientSocketList.empty() || !_newConnection.empty()) {
+      _idle = false;
+      return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!_idle) {
+      _idle = true;
+      _idleSince = now;
+    }
+    if (now - _idleSince < std::chrono::seconds(_session->getConfig().sessionIdleTimeout))
+      return false;
+
+    _closing = true;
+    return true;
+  }
+
   void SSHTunnelHandler::run() {
     handleConnection();
   }
@@ -87,7 +193,7 @@ namespace ssh {
     do {
       std::unique_lock<std::recursive_mutex> lock(_newConnMtx);
       if(!_newConnection.empty()) {
-        prepareTunnel(_newConnection.back());
+        prepareTunnel(_newConnection.back().first, _newConnection.back().second);
         _newConnection.pop_back();
       }
       lock.unlock();
@@ -98,9 +204,9 @@ namespace ssh {
 
         for (auto &sIt : _clientSocketList) {
           ssh_event_remove_fd(_event, sIt.first);
-          sIt.second->close();
+          sIt.second.channel->close();
           wbCloseSocket(sIt.first);
-          sIt.second.reset();
+          sIt.second.channel.reset();
         }
         _clientSocketList.clear();
 
@@ -119,32 +225,32 @@ namespace ssh {
         continue;
       }
 
-      auto tmpClientSocketList = _clientSocketList;
-
-      for (auto it = tmpClientSocketList.begin(); it != tmpClientSocketList.end() && !_stop; ++it) {
+      for (auto it = _clientSocketList.begin(); it != _clientSocketList.end() && !_stop;) {
         try {
-          transferDataFromClient(it->first, it->second);
-          transferDataToClient(it->first, it->second);
+          transferData(it->first, it->second);
+          ++it;
         } catch (SSHTunnelException &exc) {
-          auto elem = _clientSocketList.find(it->first);
-          if (elem != _clientSocketList.end()) {
-            ssh_event_remove_fd(_event, elem->first);
-            elem->second->close();
-            elem->second.reset();
-            wbCloseSocket(elem->first);
-            _clientSocketList.erase(elem);
-          }
+          ssh_event_remove_fd(_event, it->first);
+          it->second.channel->close();
+          it->second.channel.reset();
+          wbCloseSocket(it->first);
+          it = _clientSocketList.erase(it);
           logError("Error during data transfer: %s\n", exc.what());
         }
       }
 
+      if (idleTimeoutReached()) {
+        logInfo("SSH session to %s is not used anymore, closing it.\n", _session->getConfig().remoteSSHhost.c_str());
+        _session->disconnect();
+        break;
+      }
     } while (!_stop);
 
     for (auto &sIt : _clientSocketList) {
       ssh_event_remove_fd(_event, sIt.first);
-      sIt.second->close();
+      sIt.second.channel->close();
       wbCloseSocket(sIt.first);
-      sIt.second.reset();
+      sIt.second.channel.reset();
     }
     _clientSocketList.clear();
     logDebug3("Tunnel handler thread stopped.\n");
@@ -165,60 +271,139 @@ namespace ssh {
     setSocketNonBlocking(clientSock);
 
     std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
-    _newConnection.push_back(clientSock);
+    _newConnection.push_back(std::make_pair(clientSock, incomingSocket));
     logDebug3("Accepted new connection.\n");
   }
 
-  void SSHTunnelHandler::transferDataFromClient(int sock, std::shared_ptr<ssh::Channel> &chan) {
+  /**
+   * Moves data in both directions until neither the client socket nor the channel has anything more to give or
+   * take, so a single poll wake-up transfers as much as possible. Data the receiving end does not accept right away
+   * stays in the connection's buffers and no more is read from the sending end while they are full.
+   */
+  void SSHTunnelHandler::transferData(int sock, TunnelConnection &conn) {
+    bool moved;
+    do {
+      moved = transferDataFromClient(sock, conn);
+      moved = transferDataToClient(sock, conn) || moved;
+    } while (moved && !_stop);
+
+    updatePollEvents(sock, conn);
+  }
+
+  bool SSHTunnelHandler::transferDataFromClient(int sock, TunnelConnection &conn) {
     logDebug3("Data from client.\n");
-    ssize_t readlen = 0;
-    std::vector<char> buff(_session->getConfig().bufferSize, '\0');
+    bool moved = false;
+    bool drained = false;
+
+    while (!_stop) {
+      while (!drained && !conn.toRemote.full()) {
+        std::size_t length;
+        char *space = conn.toRemote.freeSpace(length);
+        ssize_t readlen = recv(sock, space, static_cast<int>(length), 0);
+        if (readlen <= 0) {
+          drained = true;
+          break;
+        }
+        conn.toRemote.produced(readlen);
+      }
+
+      std::size_t sent = 0;
+      while (!conn.toRemote.empty() && !_stop) {
+        std::size_t length;
+        const char *data = conn.toRemote.data(length);
+        // Don't write more than the remote end currently accepts, libssh would wait for a window adjust otherwise.
+        length = std::min<std::size_t>(length, ssh_channel_window_size(conn.channel->getCChannel()));
+        if (length == 0)
+          break;
 
-    while (!_stop && (readlen = recv(sock, buff.data(), static_cast<int>(buff.size()), 0)) > 0) {
-      int bWritten = 0;
-      for (char* buffPtr = buff.data(); readlen > 0 && !_stop; buffPtr += bWritten, readlen -= bWritten) {
+        int bWritten;
         try {
-          bWritten = chan->write(buffPtr, readlen);
-          if (bWritten <= 0) {
-            throw SSHTunnelException("unable to write, remote end disconnected");
-          }
+          bWritten = conn.channel->write(data, length);
         } catch (SshException &exc) {
           throw SSHTunnelException(exc.getError());
         }
+        if (bWritten == SSH_AGAIN || (bWritten == 0 && !conn.channel->isClosed()))
+          break;
+        if (bWritten <= 0)
+          throw SSHTunnelException("unable to write, remote end disconnected");
+
+        conn.toRemote.consumed(bWritten);
+        sent += bWritten;
       }
+
+      if (sent == 0)
+        break;
+      moved = true;
     }
+    return moved;
   }
 
-  void SSHTunnelHandler::transferDataToClient(int sock, std::shared_ptr<ssh::Channel> &chan) {
+  bool SSHTunnelHandler::transferDataToClient(int sock, TunnelConnection &conn) {
     logDebug3("Data to client.\n");
-    ssize_t readlen = 0;
-    std::vector<char> buff(_session->getConfig().bufferSize, '\0');
-    do {
-      try {
-        readlen = chan->readNonblocking(buff.data(), buff.size());
-      } catch (SshException &exc) {
-        throw SSHTunnelException(exc.getError());
-      }
+    bool moved = false;
+    bool drained = false;
+
+    while (!_stop) {
+      while (!drained && !conn.toClient.full()) {
+        std::size_t length;
+        char *space = conn.toClient.freeSpace(length);
+        int readlen;
+        try {
+          readlen = conn.channel->readNonblocking(space, length);
+        } catch (SshException &exc) {
+          throw SSHTunnelException(exc.getError());
+        }
 
-      if (readlen < 0 && readlen != SSH_AGAIN)
-        throw SSHTunnelException("unable to read, remote end disconnected");
+        if (readlen < 0 && readlen != SSH_AGAIN)
+          throw SSHTunnelException("unable to read, remote end disconnected");
 
-      if (readlen == 0) {
-        if (chan->isClosed())
-          throw SSHTunnelException("channel is closed");
-        break;
+        if (readlen <= 0) {
+          // Deliver what is still buffered before giving up on a closed channel.
+          if (readlen == 0 && conn.toClient.empty() && conn.channel->isClosed())
+            throw SSHTunnelException("channel is closed");
+          drained = true;
+          break;
+        }
+        conn.toClient.produced(readlen);
       }
 
-      ssize_t bWritten = 0;
-      for (char* buffPtr = buff.data(); readlen > 0 && !_stop; buffPtr += bWritten, readlen -= bWritten) {
-        bWritten = send(sock, buffPtr, static_cast<int>(readlen), MSG_NOSIGNAL);
+      std::size_t sent = 0;
+      while (!conn.toClient.empty() && !_stop) {
+        std::size_t length;
+        const char *data = conn.toClient.data(length);
+        ssize_t bWritten = send(sock, data, static_cast<int>(length), MSG_NOSIGNAL);
+        if (bWritten < 0 && wbSocketWouldBlock())
+          break;
         if (bWritten <= 0)
           throw SSHTunnelException("unable to write, client disconnected");
+
+        conn.toClient.consumed(bWritten);
+        sent += bWritten;
       }
-    } while (!_stop && true);
+
+      if (sent == 0)
+        break;
+      moved = true;
+    }
+    return moved;
   }
 
-  std::shared_ptr<ssh::Channel> SSHTunnelHandler::openTunnel() {
+  /**
+   * Polls the client socket for writability too while data for it is pending, so that a slow client wakes the
+   * handler as soon as it can take more.
+   */
+  void SSHTunnelHandler::updatePollEvents(int sock, TunnelConnection &conn) {
+    short events = conn.toClient.empty() ? POLLIN : POLLIN | POLLOUT;
+    if (events == conn.events)
+      return;
+
+    ssh_event_remove_fd(_event, sock);
+    if (ssh_event_add_fd(_event, sock, events, onSocketEvent, this) != SSH_OK)
+      throw SSHTunnelException("could not register event handler");
+    conn.events = events;
+  }
+
+  std::shared_ptr<ssh::Channel> SSHTunnelHandler::openTunnel(const SSHConnectionConfig &target) {
     std::shared_ptr<ssh::Channel> channel(new ssh::Channel(*(_session->getSession())));
     ssh_channel_set_blocking(channel->getCChannel(), false);
 
@@ -226,8 +411,8 @@ namespace ssh {
     std::size_t i = 0;
 
     while (i < _session->getConfig().connectTimeout) {
-      rc = channel->openForward(_session->getConfig().remotehost.c_str(), _session->getConfig().remoteport,
-                              _session->getConfig().localhost.c_str(), _session->getConfig().localport);
+      rc = channel->openForward(target.remotehost.c_str(), target.remoteport, target.localhost.c_str(),
+                                target.localport);
       if (rc == SSH_AGAIN) {
         logDebug3("Unable to open channel, wait a moment and retry.\n");
         i++;
@@ -244,10 +429,22 @@ namespace ssh {
     return channel;
   }
 
-  void SSHTunnelHandler::prepareTunnel(int clientSocket) {
+  void SSHTunnelHandler::prepareTunnel(int clientSocket, int localSocket) {
+    SSHConnectionConfig target;
+    {
+      std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
+      auto listener = _listeners.find(localSocket);
+      if (listener == _listeners.end()) {
+        wbCloseSocket(clientSocket);
+        logWarning("Connection came in on a tunnel that is closed already.\n");
+        return;
+      }
+      target = listener->second.target;
+    }
+
     std::shared_ptr<ssh::Channel> channel;
     try {
-      channel = openTunnel();
+      channel = openTunnel(target);
     } catch (ssh::SSHTunnelException &exc) {
       wbCloseSocket(clientSocket);
       logError("Unable to open tunnel. Exception when opening tunnel: %s\n", exc.what());
@@ -268,7 +465,8 @@ namespace ssh {
       logDebug("Tunnel created.\n");
     }
 
-    _clientSocketList.insert(std::make_pair(clientSocket, channel));
+    std::size_t bufferSize = std::max<std::size_t>(_session->getConfig().bufferSize, MIN_TRANSFER_BUFFER_SIZE);
+    _clientSocketList.insert(std::make_pair(clientSocket, TunnelConnection(channel, bufferSize)));
     return;
   }
 
@@ -28,6 +28,7 @@
 #include <poll.h>
 #endif
 #include <string.h>
+#include <chrono>
 #include <thread>
 #include <map>
 #include <mutex>
@@ -37,6 +38,43 @@
 
 namespace ssh {
 
+  // Ring buffer for the data read from one end of a tunnel that the other end did not accept yet.
+  class MYSQLWBBACKEND_PUBLIC_FUNC TransferBuffer {
+  public:
+    TransferBuffer(std::size_t capacity);
+
+    // Contiguous free space to read into, followed by the number of bytes actually stored there.
+    char *freeSpace(std::size_t &length);
+    void produced(std::size_t length);
+
+    // Contiguous buffered data to write out, followed by the number of bytes actually written.
+    const char *data(std::size_t &length) const;
+    void consumed(std::size_t length);
+
+    bool empty() const {
+      return _size == 0;
+    }
+    bool full() const {
+      return _size == _buffer.size();
+    }
+
+  private:
+    std::vector<char> _buffer;
+    std::size_t _start;
+    std::size_t _size;
+  };
+
+  struct TunnelConnection {
+    std::shared_ptr<ssh::Channel> channel;
+    TransferBuffer toRemote;
+    TransferBuffer toClient;
+    short events; // What the client socket is polled for.
+
+    TunnelConnection(std::shared_ptr<ssh::Channel> chan, std::size_t bufferSize)
+        : channel(std::move(chan)), toRemote(bufferSize), toClient(bufferSize), events(POLLIN) {
+    }
+  };
+
   class MYSQLWBBACKEND_PUBLIC_FUNC SSHTunnelHandler : public SSHThread {
   public:
     SSHTunnelHandler(uint16_t localPort, int localSocket, std::shared_ptr<ssh::SSHSession> session);
@@ -45,26 +83,44 @@ namespace ssh {
     int getLocalPort() const;
     SSHConnectionConfig getConfig() const;
 
+    // Further local sockets can be forwarded over the same session, each of them to its own target.
+    bool canShareSession(const SSHConnectionConfig &config, const SSHConnectionCredentials &credentials);
+    bool addListener(uint16_t localPort, int localSocket, const SSHConnectionConfig &target);
+    int removeListener(const SSHConnectionConfig &target);
+    uint16_t findListener(const SSHConnectionConfig &target);
+
     void handleConnection();
     void handleNewConnection(int incomingSocket);
-    void transferDataFromClient(int sock, std::shared_ptr<ssh::Channel> &chan);
-    void transferDataToClient(int sock, std::shared_ptr<ssh::Channel> &chan);
+    void transferData(int sock, TunnelConnection &conn);
+    bool transferDataFromClient(int sock, TunnelConnection &conn);
+    bool transferDataToClient(int sock, TunnelConnection &conn);
 
-    std::shared_ptr<ssh::Channel> openTunnel();
-    void prepareTunnel(int clientSocket);
+    std::shared_ptr<ssh::Channel> openTunnel(const SSHConnectionConfig &target);
+    void prepareTunnel(int clientSocket, int localSocket);
 
   protected:
+    struct Listener {
+      uint16_t port;
+      SSHConnectionConfig target;
+    };
+
     virtual void run() override;
+    void updatePollEvents(int sock, TunnelConnection &conn);
+    bool idleTimeoutReached();
 
     std::shared_ptr<SSHSession> _session;
     uint16_t _localPort;
     int _localSocket;
-    std::map<int, std::shared_ptr<ssh::Channel>> _clientSocketList;
+    std::map<int, TunnelConnection> _clientSocketList;
     int _pollTimeout;
     ssh_event _event;
     std::vector<int> _sockRemovalList;
-    std::recursive_mutex _newConnMtx;
-    std::vector<int> _newConnection;
+    std::recursive_mutex _newConnMtx; // Also guards the listeners and _closing.
+    std::vector<std::pair<int, int>> _newConnection; // Accepted client socket and the local socket it came in on.
+    std::map<int, Listener> _listeners;
+    bool _idle;
+    std::chrono::steady_clock::time_point _idleSince;
+    bool _closing; // Set once the idle timeout is reached, no listeners can be added anymore.
   };
 
 } /* namespace ssh */
@@ -66,9 +66,9 @@ namespace ssh {
 
     stop();  // wait for thread to finish
     auto sockLock = lockSocketList();
-    for (auto &it : _socketList) {
-      it.second->stop();
-      it.second.release();
+    for (auto &handler : _handlers) {
+      handler->stop();
+      handler.release();
     }
 #if _MSC_VER
     WSACleanup();
@@ -127,10 +127,12 @@ namespace ssh {
   std::tuple<SSHReturnType, base::any> SSHTunnelManager::createTunnel(std::shared_ptr<SSHSession> &session) {
     logDebug3("About to create ssh tunnel.\n");
     auto sockLock = lockSocketList();
-    for (auto &it : _socketList) {
-      if (it.second->getConfig() == session->getConfig()) {
+    removeClosedHandlers();
+    for (auto &handler : _handlers) {
+      uint16_t port = handler->findListener(session->getConfig());
+      if (port != 0) {
         logDebug3("Found existing ssh tunnel.\n");
-        return std::make_tuple(SSHReturnType::CONNECTED, it.second->getLocalPort());
+        return std::make_tuple(SSHReturnType::CONNECTED, port);
       }
     }
 
@@ -138,22 +140,69 @@ namespace ssh {
     logDebug2("Tunnel port created on socket: %d\n", ret.port);
     std::unique_ptr<SSHTunnelHandler> handler(new SSHTunnelHandler(ret.port, ret.socketHandle, session));
     handler->start();
-    _socketList.insert(std::make_pair(ret.socketHandle, std::move(handler)));
+    _socketList.insert(std::make_pair(ret.socketHandle, handler.get()));
+    _handlers.push_back(std::move(handler));
     pokeWakeupSocket();  // If we're connected, we should notify manager that it shoud reload connection list.
     return std::make_tuple(SSHReturnType::CONNECTED, ret.port);
   }
 
+  /**
+   * Opens a tunnel to the target in config over an already authenticated session to the same SSH server and user,
+   * if there is one. Returns the local port of the new tunnel or 0 if a new session must be opened.
+   */
+  int SSHTunnelManager::shareTunnel(const SSHConnectionConfig &config, const SSHConnectionCredentials &credentials) {
+    auto sockLock = lockSocketList();
+    removeClosedHandlers();
+
+    for (auto &handler : _handlers) {
+      if (!handler->canShareSession(config, credentials))
+        continue;
+
+      auto ret = createSocket();
+      if (!handler->addListener(ret.port, ret.socketHandle, config)) {
+        wbCloseSocket(ret.socketHandle);
+        continue;
+      }
+      logDebug2("Tunnel port %d created on existing session to %s\n", ret.port, config.remoteSSHhost.c_str());
+      _socketList.insert(std::make_pair(ret.socketHandle, handler.get()));
+      pokeWakeupSocket();
+      return ret.port;
+    }
+
+    return 0;
+  }
+
   int SSHTunnelManager::lookupTunnel(const SSHConnectionConfig &config) {
     auto sockLock = lockSocketList();
 
-    for (auto &it : _socketList) {
-      if (it.second->getConfig() == config)
-        return it.second->getLocalPort();
+    for (auto &handler : _handlers) {
+      uint16_t port = handler->findListener(config);
+      if (port != 0)
+        return port;
     }
 
     return 0;
   }
 
+  // Handlers stop by themselves once their session was idle for too long or could not be reconnected.
+  void SSHTunnelManager::removeClosedHandlers() {
+    for (auto it = _handlers.begin(); it != _handlers.end();) {
+      if (!(*it)->isRunning()) {
+        for (auto sIt = _socketList.begin(); sIt != _socketList.end();) {
+          if (sIt->second == it->get()) {
+            shutdown(sIt->first, SHUT_RDWR);
+            sIt = _socketList.erase(sIt);
+          } else
+            ++sIt;
+        }
+        (*it)->stop();
+        it->release();
+        it = _handlers.erase(it);
+      } else
+        ++it;
+    }
+  }
+
   // We need to handle wakeupsocket connection, this should be enough.
   static void acceptAndClose(int socket) {
     struct sockaddr_in client;
@@ -172,7 +221,7 @@ namespace ssh {
       auto sockLock = lockSocketList();
       for (auto &it : _socketList) {
         pollfd p;
-        p.fd = it.second->getLocalSocket();
+        p.fd = it.first;
         p.events = POLLIN;
         socketList.push_back(p);
       }
@@ -216,7 +265,7 @@ namespace ssh {
           auto sockLock = lockSocketList();
           for (auto &it : _socketList) {
             pollfd p;
-            p.fd = it.second->getLocalSocket();
+            p.fd = it.first;
             p.events = POLLIN;
             socketList.push_back(p);
           }
@@ -256,15 +305,16 @@ namespace ssh {
 
     {
       auto sockLock = lockSocketList();
-      for (auto &sIt : _socketList) {
-        sIt.second.release();
+      for (auto &handler : _handlers)
+        handler.release();
+      for (auto &sIt : _socketList)
         shutdown(sIt.first, SHUT_RDWR);
-      }
     }
 
     // This means wakeup socket is also cleared.
     _wakeupSocket = 0;
     _socketList.clear();
+    _handlers.clear();
   }
 
   void SSHTunnelManager::pokeWakeupSocket() {
@@ -301,17 +351,17 @@ namespace ssh {
 
   void SSHTunnelManager::disconnect(const SSHConnectionConfig &config) {
     auto sockLock = lockSocketList();
-    for (auto &it : _socketList) {
-      if (it.second->getConfig() == config) {
-        // Here we need to perform disconnect
-        it.second->stop();
-        it.second.release();
-        shutdown(it.first, SHUT_RDWR);
-        _socketList.erase(it.first);
+    for (auto &handler : _handlers) {
+      // The session stays open for a while, so that it can be reused by the next tunnel to the same server.
+      int localSocket = handler->removeListener(config);
+      if (localSocket >= 0) {
+        shutdown(localSocket, SHUT_RDWR);
+        _socketList.erase(localSocket);
         logDebug2("Shutdown port: %d\n", config.localport);
         break;
       }
     }
+    removeClosedHandlers();
   }
 
 } /* namespace ssh */
@@ -43,6 +43,7 @@ namespace ssh {
   public:
     SSHTunnelManager();
     std::tuple<SSHReturnType, base::any> createTunnel(std::shared_ptr<SSHSession> &session);
+    int shareTunnel(const SSHConnectionConfig &config, const SSHConnectionCredentials &credentials);
     int lookupTunnel(const SSHConnectionConfig &config);
     virtual ~SSHTunnelManager();
     void pokeWakeupSocket();
@@ -58,10 +59,12 @@ namespace ssh {
     virtual void run() override;
     sockInfo createSocket();
     void localSocketHandler();
+    void removeClosedHandlers();
 
     uint16_t _wakeupSocketPort;
     int _wakeupSocket;
-    std::map<int, std::unique_ptr<SSHTunnelHandler>> _socketList;
+    std::vector<std::unique_ptr<SSHTunnelHandler>> _handlers; // One per SSH session.
+    std::map<int, SSHTunnelHandler *> _socketList;            // Local listening socket and the handler forwarding it.
 
   };
 
@@ -30,6 +30,7 @@
 #include "wb_helpers.h"
 #include "workbench/SSHCommon.h"
 #include "workbench/SSHTunnelManager.h"
+#include "workbench/SSHTunnelHandler.h"
 #include "workbench/SSHSessionWrapper.h"
 #include "workbench/SSHSftp.h"
 
@@ -291,6 +292,45 @@ TEST_FUNCTION(5) {
   manager->pokeWakeupSocket();
 }
 
+// The ring buffer used by tunnel connections, data must come out in order also when it wraps around.
+TEST_FUNCTION(6) {
+  ssh::TransferBuffer buffer(8);
+  ensure_true("new buffer is empty", buffer.empty());
+
+  std::size_t length;
+  char *space = buffer.freeSpace(length);
+  ensure_equals("free space of new buffer", length, 8U);
+  memcpy(space, "abcdef", 6);
+  buffer.produced(6);
+
+  const char *data = buffer.data(length);
+  ensure_equals("buffered data", std::string(data, length), "abcdef");
+  buffer.consumed(4);
+
+  // Free space is split now, first the tail of the buffer, then the part freed at its start.
+  space = buffer.freeSpace(length);
+  ensure_equals("free space at end", length, 2U);
+  memcpy(space, "gh", 2);
+  buffer.produced(2);
+  space = buffer.freeSpace(length);
+  ensure_equals("free space at start", length, 4U);
+  memcpy(space, "ijkl", 4);
+  buffer.produced(4);
+  ensure_true("buffer is full", buffer.full());
+
+  std::string result;
+  while (!buffer.empty()) {
+    data = buffer.data(length);
+    result.append(data, length);
+    buffer.consumed(length);
+  }
+  ensure_equals("data after wrap around", result, "efghijkl");
+
+  // An emptied buffer starts over at its beginning, so all of it is contiguous again.
+  buffer.freeSpace(length);
+  ensure_equals("free space after draining", length, 8U);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -450,6 +450,49 @@ TEST_FUNCTION(50) // Plugin Execution
   */
 }
 
+TEST_FUNCTION(52) // Coalescing and memory limit
+{
+  db_SchemaRef schema(tester->get_catalog()->schemata()[0]);
+  db_TableRef table(schema->tables()[0]);
+  std::string old_name = table->name();
+
+  um->reset();
+  ensure_equals("memory accounting after reset", um->get_undo_memory_size(), 0U);
+
+  // Repeated changes of the same member in one group keep only the first old value.
+  grt::AutoUndo undo;
+  for (int i = 0; i < 100; i++)
+    table->name(base::strfmt("renamed_%i", i));
+  undo.end("Rename Table");
+
+  UndoGroup *group = dynamic_cast<UndoGroup *>(um->get_undo_stack().back());
+  ensure("undo group", group != nullptr);
+  ensure_equals("coalesced actions", group->get_actions().size(), 1U);
+  ensure("memory accounted", um->get_undo_memory_size() > 0);
+
+  um->undo();
+  ensure_equals("name restored", *table->name(), old_name);
+  um->redo();
+  ensure_equals("name redone", *table->name(), "renamed_99");
+
+  // Old entries are dropped when the memory limit is exceeded, the newest one is always kept.
+  size_t limit = um->get_undo_memory_limit();
+  um->set_undo_memory_limit(1);
+  ensure_equals("undo stack trimmed", um->get_undo_stack().size(), 1U);
+  std::string old_comment = table->comment();
+  table->comment("changed");
+  ensure_equals("undo stack kept newest", um->get_undo_stack().size(), 1U);
+  ensure_equals("memory size of newest entry", um->get_undo_memory_size(), um->get_undo_stack().back()->memory_size());
+  um->set_undo_memory_limit(limit);
+
+  um->undo();
+  ensure_equals("comment restored", *table->comment(), old_comment);
+  ensure("rename was dropped", !um->can_undo());
+
+  table->name(old_name);
+  um->reset();
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
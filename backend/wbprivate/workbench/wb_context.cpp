@@ -41,6 +41,7 @@
 
 #include "grt/clipboard.h"
 #include "grt/plugin_manager.h"
+#include "grtpp_notifications.h"
 
 #include "cppdbc.h"
 
@@ -105,12 +106,17 @@ DEFAULT_LOG_DOMAIN(DOMAIN_WB_CONTEXT)
 #define UI_REQUEST_THROTTLE 0.3
 
 #define DEFAULT_UNDO_STACK_SIZE 10
+// Memory limit of the undo history in MB.
+#define DEFAULT_UNDO_MEMORY_LIMIT 256
 
 // auto-save every 1 minute (default)
 #define AUTO_SAVE_MODEL_INTERVAL (60)
 
 #define AUTO_SAVE_SQLEDITOR_INTERVAL 10
 
+// zlib level for saving models, 0 stores the files uncompressed.
+#define MODEL_COMPRESSION_LEVEL 6
+
 #if defined(_WIN32) || defined(__APPLE__)
 #define HAVE_BUNDLED_MYSQLDUMP
 #endif
@@ -328,6 +334,13 @@ WBOptions::WBOptions(const std::string &appBinaryName)
                                                     return true;
                                                   }));
 
+  programOptions->addEntry(dataTypes::OptionEntry(dataTypes::OptionArgumentType::OptionArgumentLogical, "log-async",
+                                                  "Write the log file in the background, for the debug levels",
+                                                  [](const dataTypes::OptionEntry &entry, int *retval) {
+                                                    Logger::async_mode(true);
+                                                    return true;
+                                                  }));
+
   programOptions->addEntry(dataTypes::OptionEntry(dataTypes::OptionArgumentType::OptionArgumentText, "log-level",
                                                   "Valid levels are: error, warning, info, debug1, debug2, debug3",
                                                   [](const dataTypes::OptionEntry &entry, int *retval) {
@@ -454,6 +467,7 @@ WBContext::WBContext(bool verbose) : _frontendCallbacks(nullptr) {
   _send_messages_to_shell = true;
 
   _initialization_finished = false;
+  _deferred_init_pending = false;
   _attachments_changed = false;
 
   _grtManager->setVerbose(verbose);
@@ -739,6 +753,8 @@ bool WBContext::init_(WBFrontendCallbacks *callbacks, WBOptions *options) {
   logInfo("WbContext::init\n");
   grt::ValueRef res;
 
+  _startup_timer.start("Workbench startup");
+
   _force_opengl_rendering = options->force_opengl_rendering;
   _force_sw_rendering = options->force_sw_rendering;
 
@@ -784,6 +800,10 @@ bool WBContext::init_(WBFrontendCallbacks *callbacks, WBOptions *options) {
     bec::IconManager::get_instance()->add_search_path(dirs[i]);
   }
 
+  // Decode the tree icons ahead, so the first paint of the schema and model trees doesn't have to wait for them.
+  bec::IconManager::get_instance()->preload_icons(
+    bec::Icon16, [](const std::vector<std::string> &paths) { mforms::Utilities::preload_icons(paths); });
+
   std::string loader_module_path = options->plugin_search_path;
 
   _tunnel_manager = new TunnelManager();
@@ -871,6 +891,7 @@ bool WBContext::init_(WBFrontendCallbacks *callbacks, WBOptions *options) {
   _frontendCallbacks->show_status_text(_("Initializing GRT..."));
   // Initialize GRT Manager.
   _grtManager->initialize(options->init_python, loader_module_path);
+  _startup_timer.lap("GRT and modules initialized");
 
   _grtManager->get_shell()->set_save_directory(options->user_data_dir);
   _grtManager->get_shell()->set_saves_history(200); // limit history to 200 commands
@@ -904,6 +925,7 @@ bool WBContext::init_(WBFrontendCallbacks *callbacks, WBOptions *options) {
   } catch (std::exception &) {
     _grtManager->initialize_shell("python");
   }
+  _startup_timer.lap("GRT shell initialized");
 
   get_root()->options()->signal_dict_changed()->connect(std::bind(
     &WBContext::option_dict_changed, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
@@ -941,37 +963,75 @@ void WBContext::warnIfRunningOnUnsupportedOS() {
   }
 }
 
-void WBContext::init_finish_(WBOptions *options) {
+void WBContext::init_module_initializers() {
   // initialize plugins that have a initializer (start with builtins and then go through user plugins)
-  // Initialization to be done ONLY when WB is first started.
-  // This point is also reached when i.e. a document was opened by double clicking and a WB instance was already open
-  // full_init is used to identify the initialization mode.
-  if (options->full_init) {
-    const std::vector<grt::Module *> &modules(_grt->get_modules());
-    grt::BaseListRef args(true);
+  const std::vector<grt::Module *> &modules(_grt->get_modules());
+  grt::BaseListRef args(true);
 
-    for (std::vector<grt::Module *>::const_iterator it = modules.begin(); it != modules.end(); ++it) {
-      if ((*it)->has_function("initialize0")) {
-        logDebug("Calling %s.initialize0()...\n", (*it)->name().c_str());
-        try {
-          (*it)->call_function("initialize0", args);
-        } catch (std::exception &e) {
-          logError("Error calling %s.initialize0(): %s\n", (*it)->name().c_str(), e.what());
-        }
+  for (std::vector<grt::Module *>::const_iterator it = modules.begin(); it != modules.end(); ++it) {
+    if ((*it)->has_function("initialize0")) {
+      logDebug("Calling %s.initialize0()...\n", (*it)->name().c_str());
+      try {
+        (*it)->call_function("initialize0", args);
+      } catch (std::exception &e) {
+        logError("Error calling %s.initialize0(): %s\n", (*it)->name().c_str(), e.what());
       }
     }
+  }
 
-    for (std::vector<grt::Module *>::const_iterator it = modules.begin(); it != modules.end(); ++it) {
-      if ((*it)->has_function("initialize")) {
-        logDebug("Calling %s.initialize()...\n", (*it)->name().c_str());
-        try {
-          (*it)->call_function("initialize", args);
-        } catch (std::exception &e) {
-          logError("Error calling %s.initialize(): %s\n", (*it)->name().c_str(), e.what());
-        }
+  for (std::vector<grt::Module *>::const_iterator it = modules.begin(); it != modules.end(); ++it) {
+    if ((*it)->has_function("initialize")) {
+      logDebug("Calling %s.initialize()...\n", (*it)->name().c_str());
+      try {
+        (*it)->call_function("initialize", args);
+      } catch (std::exception &e) {
+        logError("Error calling %s.initialize(): %s\n", (*it)->name().c_str(), e.what());
       }
     }
   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Module initializers mostly register observers for SQL editors and table templates are only used by models.
+ * Neither is needed to show the home screen, so both run when the application gets idle after startup, or earlier
+ * if something needs them before that.
+ */
+void WBContext::finish_deferred_init() {
+  if (!_deferred_init_pending)
+    return;
+  _deferred_init_pending = false;
+
+  base::StopWatch timer;
+  timer.start("Deferred startup");
+
+  init_module_initializers();
+  timer.lap("Module initializers called");
+
+  // Table templates can be initialized only after rdbms info because it needs column datatypes.
+  init_templates();
+  timer.lap("Table templates loaded");
+
+  timer.stop("Deferred startup");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void WBContext::init_finish_(WBOptions *options) {
+  // Initialization to be done ONLY when WB is first started.
+  // This point is also reached when i.e. a document was opened by double clicking and a WB instance was already open
+  // full_init is used to identify the initialization mode.
+  if (options->full_init) {
+    _deferred_init_pending = true;
+
+    // Startup actions may open editors or run scripts that rely on the module initializers, do everything now then.
+    if (!options->open_at_startup.empty() || !options->open_at_startup_type.empty() ||
+        !options->run_at_startup.empty() || get_wb_options().get_int("workbench.AutoReopenLastModel", 0))
+      finish_deferred_init();
+    else
+      _grtManager->run_once_when_idle(this, std::bind(&WBContext::finish_deferred_init, this));
+  }
 
   // open initial document when GUI init finishes
   std::string initial_file;
@@ -1114,6 +1174,7 @@ void WBContext::init_finish_(WBOptions *options) {
   }
 
   _initialization_finished = true;
+  _startup_timer.stop("Workbench startup (home screen ready)");
 
   if (options->quit_when_done && (!options->run_at_startup.empty() || options->open_at_startup_type == "script" ||
                                   options->open_at_startup_type == "run-script"))
@@ -1165,25 +1226,29 @@ grt::ValueRef WBContext::setup_context_grt(WBOptions *options) {
   load_app_state(unserializer);
 
   loadStarters();
+  _startup_timer.lap("GRT tree, app state and starters loaded");
 
   init_plugin_groups_grt(options);
 
   init_plugins_grt(options);
+  _startup_timer.lap("Plugins registered");
 
   // Initialize RDBMS specific modules. must happen before connections are loaded.
   init_rdbms_modules();
+  _startup_timer.lap("RDBMS modules initialized");
 
-  // Table templates can be initialized only after rdbms info because it needs column datatypes.
-  init_templates();
+  // Table templates are only used by models, they are loaded in finish_deferred_init().
 
   FOREACH_COMPONENT(_components, iter)
   (*iter)->setup_context_grt(options);
+  _startup_timer.lap("Components set up");
 
   // App options must be loaded after everything else is initialized.
   load_app_options(false);
 
   // Rescan plugins so that list of disabled plugins is applied.
   _plugin_manager->rescan_plugins();
+  _startup_timer.lap("App options loaded");
 
   return grt::IntegerRef(1);
 }
@@ -1384,8 +1449,10 @@ void WBContext::set_default_options(grt::DictRef options) {
   set_default(options, "workbench:ForceSWRendering", 0);
   set_default(options, "workbench:OSSHideMissing", 0);
   set_default(options, "workbench:UndoEntries", DEFAULT_UNDO_STACK_SIZE);
+  set_default(options, "workbench:UndoMemoryLimit", DEFAULT_UNDO_MEMORY_LIMIT);
   set_default(options, "workbench:AutoSaveModelInterval", AUTO_SAVE_MODEL_INTERVAL);
   set_default(options, "workbench:AutoSaveSQLEditorInterval", AUTO_SAVE_SQLEDITOR_INTERVAL);
+  set_default(options, "workbench:ModelCompressionLevel", MODEL_COMPRESSION_LEVEL);
   set_default(options, "workbench.AutoReopenLastModel", 0);
   set_default(options, "workbench:SaveSQLWorkspaceOnClose", 1);
   set_default(options, "workbench:InternalSchema", ".mysqlworkbench");
@@ -1422,8 +1489,11 @@ void WBContext::set_default_options(grt::DictRef options) {
   set_default(options, "DbSqlEditor:KeepAliveInterval", 600);            // in seconds
   set_default(options, "DbSqlEditor:ReadTimeOut", 30);                  // in seconds
   set_default(options, "DbSqlEditor:ConnectionTimeOut", 60);             // in seconds
+  set_default(options, "DbSqlEditor:PreconnectOnHover", 1);
+  set_default(options, "DbSqlEditor:MetadataConnections", 2); // connections for loading meta data, 1 to 4
   set_default(options, "DbSqlEditor:MaxQuerySizeToHistory", 65536);
   set_default(options, "DbSqlEditor:ContinueOnError", 0); // continue running sql script bypassing failed statements
+  set_default(options, "DbSqlEditor:StatementBatchSize", 100); // max. data changing statements sent in one round trip
   set_default(options, "DbSqlEditor:AutocommitMode", 1);  // when enabled, each statement will be committed immediately
   set_default(options, "DbSqlEditor:IsDataChangesCommitWizardEnabled", 1);
   set_default(options, "DbSqlEditor:ShowSchemaTreeSchemaContents", 1);
@@ -1439,6 +1509,7 @@ void WBContext::set_default_options(grt::DictRef options) {
 
   set_default(options, "DbSqlEditor:Reformatter:UpcaseKeywords", 1);
   set_default(options, "DbSqlEditor::MaxResultsets", 50);
+  set_default(options, "DbSqlEditor:EagerResultTabs", 10); // result tabs of a query filled before being shown
 
   // Migration
   set_default(options, "Migration:ConnectionTimeOut", 60); // in seconds
@@ -1449,6 +1520,12 @@ void WBContext::set_default_options(grt::DictRef options) {
   set_default(options, "SqlEditor:LimitRows", 1);
   set_default(options, "SqlEditor:LimitRowsCount", 1000);
   set_default(options, "SqlEditor:PreserveRowFilter", 1);
+  set_default(options, "SqlEditor:InMemoryReadOnlyResults", 1);
+  set_default(options, "SqlEditor:ServerSideSortFilter", 1);
+  set_default(options, "SqlEditor:KeysetPaging", 1);
+  set_default(options, "SqlEditor:PreparedReloads", 0);
+  set_default(options, "Recordset:OptimizeBlobFetching", 0);
+  set_default(options, "SqlEditor:ResultMemoryBudget", 0);
   set_default(options, "SqlEditor:geographicLocationURL", "http://www.openstreetmap.org/?mlat=%LAT%&mlon=%LON%");
 
   // Name templates
@@ -1579,6 +1656,7 @@ void WBContext::set_default_options(grt::DictRef options) {
   set_default(options, "SSH:readWriteTimeout", 5);
   set_default(options, "SSH:commandTimeout", 1);
   set_default(options, "SSH:commandRetryCount", 3);
+  set_default(options, "SSH:sessionIdleTimeout", 60);
   
 #ifndef _WIN32
   set_default(options, "SSH:pathtosshconfig", base::expand_tilde("~/.ssh/config"));
@@ -1646,35 +1724,40 @@ void WBContext::load_app_options(bool update) {
     try {
       app_OptionsRef curOptions(get_root()->options());
 
-      xmlDocPtr xmlDocument = _grt->load_xml(options_xml);
-      if (!xmlDocument) {
-        throw std::runtime_error(
-          _("The file is not a valid MySQL Workbench options file.\n"
-            "The file will skipped and settings are reset to their default values."));
-      }
+      // The snapshot holds the options as they were after the last load or save, already upgraded.
+      grt::ValueRef options_value = _grt->load_snapshot(options_xml);
+      if (!options_value.is_valid()) {
+        xmlDocPtr xmlDocument = _grt->load_xml(options_xml);
+        if (!xmlDocument) {
+          throw std::runtime_error(
+            _("The file is not a valid MySQL Workbench options file.\n"
+              "The file will skipped and settings are reset to their default values."));
+        }
 
-      base::ScopeExitTrigger free_on_leave(std::bind(xmlFreeDoc, xmlDocument));
+        base::ScopeExitTrigger free_on_leave(std::bind(xmlFreeDoc, xmlDocument));
+
+        std::string doctype, version;
+        _grt->get_xml_metainfo(xmlDocument, doctype, version);
+
+        // Older option files without a version number are considered as 1.0.0 and
+        // upgraded from there to latest version.
+        if (version.empty())
+          version = "1.0.0";
+        else
+          // Document format has been introduced in 1.0.1.
+          if (doctype != OPTIONS_DOCUMENT_FORMAT) {
+          throw std::runtime_error(
+            _("The file is not a valid MySQL Workbench options file.\n"
+              "The file will skipped and settings are reset to their default values."));
+        }
 
-      std::string doctype, version;
-      _grt->get_xml_metainfo(xmlDocument, doctype, version);
+        // Try to upgrade document at XML level.
+        if (version != OPTIONS_DOCUMENT_VERSION)
+          attempt_options_upgrade(xmlDocument, version);
 
-      // Older option files without a version number are considered as 1.0.0 and
-      // upgraded from there to latest version.
-      if (version.empty())
-        version = "1.0.0";
-      else
-        // Document format has been introduced in 1.0.1.
-        if (doctype != OPTIONS_DOCUMENT_FORMAT) {
-        throw std::runtime_error(
-          _("The file is not a valid MySQL Workbench options file.\n"
-            "The file will skipped and settings are reset to their default values."));
+        options_value = _grt->unserialize_xml(xmlDocument, options_xml);
+        _grt->save_snapshot(options_value, options_xml);
       }
-
-      // Try to upgrade document at XML level.
-      if (version != OPTIONS_DOCUMENT_VERSION)
-        attempt_options_upgrade(xmlDocument, version);
-
-      grt::ValueRef options_value = _grt->unserialize_xml(xmlDocument, options_xml);
       app_OptionsRef options(app_OptionsRef::cast_from(options_value));
 
       if (options.is_valid()) {
@@ -1750,7 +1833,7 @@ void WBContext::load_app_options(bool update) {
   if (g_file_test(inst_list_xml.c_str(), G_FILE_TEST_EXISTS)) {
     try {
       grt::ListRef<db_mgmt_ServerInstance> list(
-        grt::ListRef<db_mgmt_ServerInstance>::cast_from(_grt->unserialize(inst_list_xml)));
+        grt::ListRef<db_mgmt_ServerInstance>::cast_from(_grt->unserialize_with_snapshot(inst_list_xml)));
 
       if (list.is_valid()) {
         while (mgmt->storedInstances().count() > 0)
@@ -1776,7 +1859,7 @@ void WBContext::load_other_connections() {
   if (g_file_test(conn_list_xml.c_str(), G_FILE_TEST_EXISTS)) {
     try {
       grt::ListRef<db_mgmt_Connection> list(
-        grt::ListRef<db_mgmt_Connection>::cast_from(_grt->unserialize(conn_list_xml)));
+        grt::ListRef<db_mgmt_Connection>::cast_from(_grt->unserialize_with_snapshot(conn_list_xml)));
       total_connections = (int)list->count();
       if (list.is_valid()) {
         replace_contents(mgmt->otherStoredConns(), list);
@@ -1826,6 +1909,7 @@ void WBContext::save_app_options() {
   _grt->serialize(options, options_file + ".tmp", OPTIONS_DOCUMENT_FORMAT, OPTIONS_DOCUMENT_VERSION);
   g_remove(options_file.c_str());
   g_rename(std::string(options_file + ".tmp").c_str(), options_file.c_str());
+  _grt->save_snapshot(options, options_file);
 
   options->owner(owner);
 
@@ -1840,6 +1924,7 @@ void WBContext::save_instances() {
     return;
   std::string inst_list_xml = base::makePath(get_user_datadir(), SERVER_INSTANCE_LIST);
   _grt->serialize(mgmt->storedInstances(), inst_list_xml);
+  _grt->save_snapshot(mgmt->storedInstances(), inst_list_xml);
 }
 
 void WBContext::save_connections() {
@@ -1852,10 +1937,13 @@ void WBContext::save_connections() {
   if (mgmt->otherStoredConns()->count()) {
     std::string conn_list_xml = base::makePath(get_user_datadir(), FILE_OTHER_CONNECTION_LIST);
     _grt->serialize(mgmt->otherStoredConns(), conn_list_xml);
+    _grt->save_snapshot(mgmt->otherStoredConns(), conn_list_xml);
     logDebug("Saved connection list (Non-MySQL: %u)\n", (unsigned int)mgmt->otherStoredConns()->count());
   }
 
-  _grt->serialize(mgmt->storedConns(), base::makePath(get_user_datadir(), FILE_CONNECTION_LIST));
+  std::string conn_list_xml = base::makePath(get_user_datadir(), FILE_CONNECTION_LIST);
+  _grt->serialize(mgmt->storedConns(), conn_list_xml);
+  _grt->save_snapshot(mgmt->storedConns(), conn_list_xml);
   logDebug("Saved connection list (MySQL: %u)\n", (unsigned int)mgmt->storedConns()->count());
 }
 
@@ -1865,22 +1953,27 @@ void WBContext::load_app_state(std::shared_ptr<grt::internal::Unserializer> unse
   // Load saved state.
   std::string state_xml = base::makePath(_user_datadir, STATE_FILE_NAME);
   if (g_file_test(state_xml.c_str(), G_FILE_TEST_EXISTS)) {
-    xmlDocPtr xmlDocument = NULL;
     try {
-      xmlDocument = _grt->load_xml(state_xml);
-      base::ScopeExitTrigger free_on_leave(std::bind(xmlFreeDoc, xmlDocument));
-
-      std::string doctype, version;
-      _grt->get_xml_metainfo(xmlDocument, doctype, version);
+      grt::ValueRef state_value = _grt->load_snapshot(state_xml);
+      if (!state_value.is_valid()) {
+        xmlDocPtr xmlDocument = _grt->load_xml(state_xml);
+        base::ScopeExitTrigger free_on_leave(std::bind(xmlFreeDoc, xmlDocument));
+
+        std::string doctype, version;
+        _grt->get_xml_metainfo(xmlDocument, doctype, version);
+
+        if (doctype != STATE_DOCUMENT_FORMAT) {
+          throw std::runtime_error(
+            _("The file is not a valid MySQL Workbench state file.\n"
+              "The file will skipped and the application starts in its default state."));
+        }
 
-      if (doctype != STATE_DOCUMENT_FORMAT) {
-        throw std::runtime_error(
-          _("The file is not a valid MySQL Workbench state file.\n"
-            "The file will skipped and the application starts in its default state."));
+        state_value = _grt->unserialize_xml(xmlDocument, state_xml);
+        _grt->save_snapshot(state_value, state_xml);
       }
 
       grt::DictRef current_state(get_root()->state());
-      grt::DictRef new_state = grt::DictRef::cast_from(_grt->unserialize_xml(xmlDocument, state_xml));
+      grt::DictRef new_state = grt::DictRef::cast_from(state_value);
 
       // Store new state in grt tree.
       grt::merge_contents(current_state, new_state, true);
@@ -1908,6 +2001,7 @@ void WBContext::save_app_state() {
   _grt->serialize(get_root()->state(), state_file + ".tmp", STATE_DOCUMENT_FORMAT, STATE_DOCUMENT_VERSION);
   g_remove(state_file.c_str());
   g_rename(std::string(state_file + ".tmp").c_str(), state_file.c_str());
+  _grt->save_snapshot(get_root()->state(), state_file);
 
   try {
     _grtManager->get_shell()->store_state();
@@ -2065,6 +2159,9 @@ void WBContext::option_dict_changed(grt::internal::OwnedDict *options, bool, con
       undo_size = 1;
 
     _grt->get_undo_manager()->set_undo_limit(undo_size);
+
+    ssize_t undo_memory = get_wb_options().get_int("workbench:UndoMemoryLimit", DEFAULT_UNDO_MEMORY_LIMIT);
+    _grt->get_undo_manager()->set_undo_memory_limit(undo_memory > 0 ? (size_t)undo_memory * 1024 * 1024 : 0);
   }
 }
 
@@ -2080,6 +2177,7 @@ bool WBContext::cancel_idle_tasks() {
 
   MutexLock lock(_pending_refresh_mutex);
   _pending_refreshes.clear();
+  _pending_refresh_index.clear();
 
   return result;
 }
@@ -2092,6 +2190,12 @@ void WBContext::flush_idle_tasks(bool force) {
       return;
     }
 
+    // Refreshes requested while notifications are being coalesced (undo groups, undo/redo) wait for the batch
+    // to end, so a bulk change is shown once.
+    grt::GRTNotificationCenter *center = grt::GRTNotificationCenter::get();
+    if (!force && center && center->in_batch())
+      return;
+
     mdc::Timestamp now = mdc::get_time();
 
     std::list<RefreshRequest> refreshes;
@@ -2105,6 +2209,7 @@ void WBContext::flush_idle_tasks(bool force) {
 
         if (force || (now - iter->timestamp >= UI_REQUEST_THROTTLE)) {
           refreshes.push_back(*iter);
+          _pending_refresh_index.erase(std::make_tuple((int)iter->type, iter->str, iter->ptr));
           _pending_refreshes.erase(iter);
         }
 
@@ -2126,14 +2231,13 @@ void WBContext::request_refresh(RefreshType type, const std::string &str, Native
   mdc::Timestamp now = mdc::get_time();
 
   // check if dupe
-  for (std::list<RefreshRequest>::iterator iter = _pending_refreshes.begin(); iter != _pending_refreshes.end();
-       ++iter) {
-    if (iter->type == type && iter->str == str && iter->ptr == ptr) {
-      // if its a dupe, update the timestamp so that notifications are only sent when
-      // there's no more fresh requests arriving
-      iter->timestamp = now;
-      return;
-    }
+  std::tuple<int, std::string, NativeHandle> key((int)type, str, ptr);
+  auto dupe = _pending_refresh_index.find(key);
+  if (dupe != _pending_refresh_index.end()) {
+    // if its a dupe, update the timestamp so that notifications are only sent when
+    // there's no more fresh requests arriving
+    dupe->second->timestamp = now;
+    return;
   }
 
   RefreshRequest refresh;
@@ -2151,6 +2255,13 @@ void WBContext::request_refresh(RefreshType type, const std::string &str, Native
 #endif
 
   _pending_refreshes.push_back(refresh);
+  _pending_refresh_index[key] = --_pending_refreshes.end();
+}
+
+void WBContext::rebuild_refresh_index() {
+  _pending_refresh_index.clear();
+  for (std::list<RefreshRequest>::iterator iter = _pending_refreshes.begin(); iter != _pending_refreshes.end(); ++iter)
+    _pending_refresh_index[std::make_tuple((int)iter->type, iter->str, iter->ptr)] = iter;
 }
 
 #ifndef Document____
@@ -2323,8 +2434,11 @@ int WBContext::closeModelFile() {
 };
 
 std::string WBContext::getTempDir() {
-  if (_model_import_file)
+  if (_model_import_file) {
+    // callers read the directory directly, so nothing may be left in the archive
+    _model_import_file->extract_pending_files();
     return _model_import_file->get_tempdir_path();
+  }
   return "";
 }
 
@@ -2357,6 +2471,8 @@ workbench_DocumentRef WBContext::openModelFile(const std::string &file) {
 };
 
 bool WBContext::open_document(const std::string &file) {
+  finish_deferred_init();
+
   if (_model_context != NULL) {
     // A model is already loaded. Warn the user it will be closed. Ask for saving pending changes
     // if there are any.
@@ -2629,7 +2745,11 @@ void WBContext::do_close_document(bool destroying) {
 
   if (!destroying && _frontendCallbacks->refresh_gui) {
     // Cancel all pending model related events.
-    _pending_refreshes.remove_if(CancelRefreshCandidate());
+    {
+      MutexLock lock(_pending_refresh_mutex);
+      _pending_refreshes.remove_if(CancelRefreshCandidate());
+      rebuild_refresh_index();
+    }
 
     _frontendCallbacks->refresh_gui(RefreshCloseDocument, "", (NativeHandle)0);
   }
@@ -2694,8 +2814,13 @@ grt::ValueRef WBContext::save_grt() {
     return grt::ValueRef();
   }
 
+  _file->set_compression_level(
+    (int)get_root()->options()->options().get_int("workbench:ModelCompressionLevel", MODEL_COMPRESSION_LEVEL));
+
   try {
-    if (!_file->save_to(_filename, zip_comment))
+    // the archive is compressed and written in the background, the document can be edited meanwhile
+    if (!_file->save_to(_filename, zip_comment,
+                        std::bind(&WBContext::model_saved, this, _filename, std::placeholders::_1)))
       return grt::ValueRef();
   } catch (std::exception &exc) {
     show_exception(strfmt(_("Could not save document to %s"), _filename.c_str()), exc);
@@ -2719,6 +2844,24 @@ grt::ValueRef WBContext::save_grt() {
   return grt::IntegerRef(1);
 }
 
+/**
+ * Called by the thread that wrote the model file.
+ */
+void WBContext::model_saved(const std::string &path, const std::string &error) {
+  _grtManager->run_once_when_idle(this, [this, path, error]() {
+    if (error.empty()) {
+      _frontendCallbacks->show_status_text(strfmt(_("%s saved."), path.c_str()));
+      return;
+    }
+
+    _grtManager->has_unsaved_changes(true);
+    _frontendCallbacks->show_status_text(_("Error saving document."));
+    mforms::Utilities::show_error(_("Error saving document"),
+                                  strfmt(_("Could not save document to %s:\n%s"), path.c_str(), error.c_str()),
+                                  _("OK"));
+  });
+}
+
 std::string WBContext::get_filename() const {
   return _filename;
 }
@@ -2766,10 +2909,10 @@ bool WBContext::save_as(const std::string &path) {
   try {
     _frontendCallbacks->show_status_text(strfmt(_("Saving %s..."), _filename.c_str()));
 
-    if (grt::IntegerRef::cast_from(save_grt()) == 1) {
-      _frontendCallbacks->show_status_text(strfmt(_("%s saved."), _filename.c_str()));
+    // the status is updated by model_saved() once the file was written
+    if (grt::IntegerRef::cast_from(save_grt()) == 1)
       return true;
-    } else
+    else
       _frontendCallbacks->show_status_text(_("Error saving document."));
   } catch (grt::grt_runtime_error &error) {
     show_exception(_("Error saving document"), error);
@@ -3116,6 +3259,7 @@ void WBContext::add_new_admin_window(const db_mgmt_ConnectionRef &target) {
 #ifndef AutoStartPlugins____
 
 void WBContext::add_new_plugin_window(const std::string &plugin_id, const std::string &caption) {
+  finish_deferred_init();
   _frontendCallbacks->show_status_text(strfmt(_("Starting %s Module..."), caption.c_str()));
 
   try {
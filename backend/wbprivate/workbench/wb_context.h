@@ -24,6 +24,7 @@
 #pragma once
 
 #ifndef _WIN32
+#include <tuple>
 #include <vector>
 #endif
 
@@ -42,6 +43,7 @@
 #include "base/trackable.h"
 #include "base/threading.h"
 #include "base/data_types.h"
+#include "base/profiling.h"
 
 #include "wb_version.h"
 
@@ -211,6 +213,10 @@ namespace wb {
     void init_finish_(WBOptions *options);
     void finalize();
 
+    // Runs the startup steps that are not needed for the home screen, if that didn't happen yet.
+    // Called when idle after startup and by everything that may depend on them (opening editors and models).
+    void finish_deferred_init();
+
     bool is_commercial();
 
     bec::UIForm *get_active_form();
@@ -368,8 +374,11 @@ namespace wb {
     bool _send_messages_to_shell;
     bool _asked_for_saving;
     bool _initialization_finished;
+    bool _deferred_init_pending;
     bool _attachments_changed;
 
+    base::StopWatch _startup_timer; // Logs how long each startup phase took.
+
     std::string _datadir;
     std::string _user_datadir;
 
@@ -390,8 +399,12 @@ namespace wb {
     };
 
     std::list<RefreshRequest> _pending_refreshes;
+    // Type, string and handle of each pending request, so duplicates are found without scanning the list.
+    std::map<std::tuple<int, std::string, NativeHandle>, std::list<RefreshRequest>::iterator> _pending_refresh_index;
     base::Mutex _pending_refresh_mutex;
 
+    void rebuild_refresh_index();
+
     base::RecMutex _block_user_interaction_mutex;
 
     WBContextModel *_model_context;
@@ -430,6 +443,7 @@ namespace wb {
     void do_close_document(bool destroying);
 
     grt::ValueRef setup_context_grt(WBOptions *options);
+    void init_module_initializers();
 
     void set_default_options(grt::DictRef options);
 
@@ -454,6 +468,7 @@ namespace wb {
     void saveStarters();
 
     grt::ValueRef save_grt();
+    void model_saved(const std::string &path, const std::string &error);
 
     grt::ValueRef execute_plugin_grt(const app_PluginRef &plugin, const grt::BaseListRef &args);
     void plugin_finished(const grt::ValueRef &result, const app_PluginRef &plugin);
@@ -92,6 +92,7 @@ WBContextUI::WBContextUI() : _wb(new WBContext(false)), _launchersSection(nullpt
   _last_unsaved_changes_state = false;
   _quitting = false;
   _processing_action_open_connection = false;
+  _preconnect_timer = 0;
 
   _home_screen = nullptr;
 
@@ -105,6 +106,8 @@ WBContextUI::WBContextUI() : _wb(new WBContext(false)), _launchersSection(nullpt
 //--------------------------------------------------------------------------------------------------
 
 WBContextUI::~WBContextUI() {
+  if (_preconnect_timer != 0)
+    mforms::Utilities::cancel_timeout(_preconnect_timer);
   _wb->do_close_document(true);
   delete _addon_download_window;
   delete _plugin_install_window;
@@ -34,6 +34,7 @@
 #include "grts/structs.db.mgmt.h"
 #include "grt/plugin_manager.h"
 #include "mforms/home_screen_helpers.h"
+#include "mforms/utilities.h"
 
 namespace bec {
   class ValueTreeBE;
@@ -238,5 +239,6 @@ namespace wb {
     bool _initializing_home_screen;
     bool _quitting;
     bool _processing_action_open_connection;
+    mforms::TimeoutHandle _preconnect_timer;
   };
 };
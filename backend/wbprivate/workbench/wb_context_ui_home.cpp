@@ -32,6 +32,7 @@
 #include "mforms/menu.h"
 
 #include "grt.h"
+#include "cppdbc.h"
 
 #include "grts/structs.app.h"
 #include "grts/structs.h"
@@ -61,6 +62,9 @@
 
 DEFAULT_LOG_DOMAIN(DOMAIN_WB_CONTEXT_UI);
 
+// Seconds the mouse has to rest on a connection tile before its connections are opened ahead.
+#define PRECONNECT_HOVER_DELAY 0.4f
+
 using namespace bec;
 using namespace wb;
 using namespace base;
@@ -987,6 +991,26 @@ void WBContextUI::handle_home_action(mforms::HomeScreenAction action, const base
     case HomeScreenAction::RescanLocalServers:
       _wb->execute_plugin("wb.tools.createMissingLocalConnections", ArgumentPool());
       break;
+
+    case HomeScreenAction::ActionHoverConnection: {
+      if (!bec::GRTManager::get()->get_app_option_int("DbSqlEditor:PreconnectOnHover", 1) || anyObject.isNull())
+        break;
+
+      // Only when the mouse rests on the tile, not while it passes over several of them.
+      if (_preconnect_timer != 0)
+        mforms::Utilities::cancel_timeout(_preconnect_timer);
+      std::string connectionId = anyObject.as<std::string>();
+      _preconnect_timer = mforms::Utilities::add_timeout(PRECONNECT_HOVER_DELAY, [this, connectionId]() {
+        _preconnect_timer = 0;
+        // Opened with the settings of SQL editor connections, otherwise the editor wouldn't find them.
+        db_mgmt_ConnectionRef connection = getConnectionById(connectionId);
+        if (connection.is_valid())
+          sql::DriverManager::getDriverManager()->preconnect(
+            SqlEditorForm::editor_connection_properties(connection));
+        return false;
+      });
+      break;
+    }
     default:
       logError("Unknown Action.\n");
   }
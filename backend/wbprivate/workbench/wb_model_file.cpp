@@ -25,11 +25,17 @@
 #include <fcntl.h>
 
 #include <zip.h>
+#include <zlib.h>
 #include "wb_model_file.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <set>
 #include <stdexcept>
+#include <thread>
 #include <errno.h>
 
 #include "grt.h"
@@ -39,6 +45,8 @@
 #include "base/file_utilities.h"
 #include "base/file_functions.h"
 #include "base/util_functions.h"
+#include "base/trace.h"
+#include "base/task_scheduler.h"
 
 #include "mforms/utilities.h"
 #include "mdc_image.h"
@@ -71,13 +79,22 @@
 
 #define ZIP_FILE_COMMENT DOCUMENT_FORMAT " archive " ZIP_FILE_FORMAT
 
+#define DEFAULT_COMPRESSION_LEVEL 6
+// Files are deflated by several threads in pieces of this size.
+#define DEFLATE_CHUNK_SIZE (1024 * 1024)
+// deflate window size, the end of the previous piece is used as dictionary for the next one.
+#define DEFLATE_DICTIONARY_SIZE 32768
+
 /* Auto-saving
  *
- * Auto-saving works by saving the model document file (the XML) to the expanded document folder
- * from time to time, named as document-autosave.mwb.xml. The expanded document folder is
+ * Auto-saving works by saving the model document file to the expanded document folder
+ * from time to time, named as document-autosave.mwb.grtb (binary GRT format, older versions
+ * wrote document-autosave.mwb.xml). Changes made after that are appended to
+ * document-autosave.journal as long as only a few tables, views, routines or diagrams were
+ * touched, and are replayed on top of the full autosave when recovering. The expanded document folder is
  * automatically deleted when it is closed normally.
  * When a document is opened, it will check if there already is a document folder for that file
- * and if so, the recovery function will kick in, using the autosave XML file.
+ * and if so, the recovery function will kick in, using the autosave file.
  */
 
 DEFAULT_LOG_DOMAIN("model")
@@ -174,7 +191,8 @@ std::string ModelFile::create_document_dir(const std::string &dir, const std::st
   return path;
 }
 
-ModelFile::ModelFile(const std::string &tmpdir) : _temp_dir_lock(0), _dirty(false) {
+ModelFile::ModelFile(const std::string &tmpdir)
+  : _temp_dir_lock(0), _dirty(false), _compression_level(DEFAULT_COMPRESSION_LEVEL) {
   _temp_dir = tmpdir;
 }
 
@@ -187,6 +205,7 @@ void ModelFile::copy_file_to(const std::string &file, const std::string &dest) {
 }
 
 void ModelFile::open(const std::string &path) {
+  TRACE_SPAN("model", "ModelFile::open");
   bool file_is_zip;
   bool file_is_autosave = false;
 
@@ -291,7 +310,31 @@ void ModelFile::open(const std::string &path) {
       recover = true;
       _content_dir = auto_save_dir;
 
-      if (g_file_test((auto_save_dir + "/" + MAIN_DOCUMENT_AUTOSAVE_NAME).c_str(), G_FILE_TEST_EXISTS)) {
+      std::string binary_autosave = auto_save_dir + "/" + MAIN_DOCUMENT_AUTOSAVE_BINARY_NAME;
+      if (g_file_test(binary_autosave.c_str(), G_FILE_TEST_EXISTS)) {
+        // the autosave is stored in the binary format, turn it back into the XML document
+        g_warning("Committing autosaved binary document file: %s", binary_autosave.c_str());
+        try {
+          std::string doctype, version;
+          grt::ValueRef value(grt::GRT::get()->unserialize(binary_autosave, doctype, version));
+          grt::GRT::get()->serialize(value, auto_save_dir + "/" + MAIN_DOCUMENT_NAME, doctype, version);
+
+          // changes saved after the full autosave are in the journal
+          std::string journal = auto_save_dir + "/" + MAIN_DOCUMENT_AUTOSAVE_JOURNAL_NAME;
+          if (g_file_test(journal.c_str(), G_FILE_TEST_EXISTS)) {
+            apply_autosave_journal(auto_save_dir + "/" + MAIN_DOCUMENT_NAME, journal);
+            g_remove(journal.c_str());
+          }
+          g_remove(binary_autosave.c_str());
+        } catch (const std::exception &exc) {
+          g_warning("Failed converting autosaved binary file: %s", exc.what());
+          mforms::Utilities::show_error("Error recovering file",
+                                        base::strfmt("There was an error recovering the document: %s\n", exc.what()),
+                                        "OK", "", "");
+          g_rename(auto_save_dir.c_str(), (auto_save_dir + ".cantrecover").c_str());
+          recover = false;
+        }
+      } else if (g_file_test((auto_save_dir + "/" + MAIN_DOCUMENT_AUTOSAVE_NAME).c_str(), G_FILE_TEST_EXISTS)) {
         g_warning("Committing autosaved document XML file: %s",
                   (auto_save_dir + "/" + MAIN_DOCUMENT_AUTOSAVE_NAME).c_str());
         g_remove((auto_save_dir + "/" + MAIN_DOCUMENT_NAME).c_str());
@@ -324,7 +367,7 @@ void ModelFile::open(const std::string &path) {
     _content_dir = create_document_dir(_temp_dir, basename);
 
     if (file_is_zip) {
-      unpack_zip(path, _content_dir);
+      unpack_document(path);
 
       check_and_fix_data_file_bug();
     } else {
@@ -388,6 +431,11 @@ void ModelFile::create() {
 }
 
 std::string ModelFile::get_path_for(const std::string &file) {
+  try {
+    extract_pending_file(file);
+  } catch (std::exception &exc) {
+    logError("Cannot extract %s from the document file: %s\n", file.c_str(), exc.what());
+  }
   return _content_dir + "/" + file;
 }
 
@@ -397,6 +445,10 @@ std::string ModelFile::get_path_for(const std::string &file) {
 workbench_DocumentRef ModelFile::retrieve_document() {
   RecMutexLock lock(_mutex);
 
+  workbench_DocumentRef streamed_doc(unserialize_document_stream(get_path_for(MAIN_DOCUMENT_NAME)));
+  if (streamed_doc.is_valid())
+    return streamed_doc;
+
   xmlDocPtr xmldoc = grt::GRT::get()->load_xml(get_path_for(MAIN_DOCUMENT_NAME));
 
 retry:
@@ -435,12 +487,7 @@ bool ModelFile::semantic_check(workbench_DocumentRef doc) {
 
 //--------------------------------------------------------------------------------------------------
 
-std::list<std::string> ModelFile::unpack_zip(const std::string &zipfile, const std::string &destdir) {
-  std::list<std::string> unpacked_files;
-
-  if (g_mkdir_with_parents(destdir.c_str(), 0700) < 0)
-    throw grt::os_error(strfmt(_("Cannot create temporary directory for open document: %s"), destdir.c_str()), errno);
-
+static zip *open_zip_archive(const std::string &zipfile) {
   int err;
 #ifdef ZIP_DISABLE_DEPRECATED
   // Would be good if we could test for zip_fdopen, but there's no way in the preprocessor.
@@ -478,151 +525,535 @@ std::list<std::string> ModelFile::unpack_zip(const std::string &zipfile, const s
     throw std::runtime_error(strfmt(_("Cannot open document file: %s"), msg.c_str()));
   }
 
+  return z;
+}
+
+static int zip_entry_count(zip *z) {
 #ifdef ZIP_DISABLE_DEPRECATED
-  zip_int64_t count = zip_get_num_entries(z, 0);
+  return (int)zip_get_num_entries(z, 0);
 #else
-  int count = zip_get_num_files(z);
+  return zip_get_num_files(z);
 #endif
-  for (int i = 0; i < count; i++) {
-    zip_file *file = zip_fopen_index(z, i, 0);
-    if (!file) {
-      const char *err = zip_strerror(z);
-      zip_close(z);
-      throw std::runtime_error(strfmt(_("Error opening document file: %s"), err));
-    }
+}
+
+/**
+ * Writes the archive entry at @index to its place below @destdir. Returns the path of the new file or an
+ * empty string if the entry is skipped. The archive is left open on error.
+ */
+static std::string extract_zip_entry(zip *z, int index, const std::string &destdir) {
+  zip_file *file = zip_fopen_index(z, index, 0);
+  if (!file)
+    throw std::runtime_error(strfmt(_("Error opening document file: %s"), zip_strerror(z)));
+
+  const char *zname = zip_get_name(z, index, 0);
+  if (strcmp(zname, "/") == 0 || strcmp(zname, "\\") == 0) {
+    zip_fclose(file);
+    return "";
+  }
+  std::string dirname = base::dirname(zname);
+  std::string basename = base::basename(zname);
+
+  // skip lock file as it is already locked and inaccessible
+  if (basename == ModelFile::lock_filename) {
+    zip_fclose(file);
+    return "";
+  }
 
-    const char *zname = zip_get_name(z, i, 0);
-    if (strcmp(zname, "/") == 0 || strcmp(zname, "\\") == 0) {
+  std::string outpath = destdir;
+
+  if (!dirname.empty()) {
+    outpath.append("/");
+    outpath.append(dirname);
+    if (g_mkdir_with_parents(outpath.c_str(), 0700) < 0) {
       zip_fclose(file);
-      continue;
+      throw grt::os_error(_("Error creating temporary directory while opending document."), errno);
     }
-    std::string dirname = base::dirname(zname);
-    std::string basename = base::basename(zname);
+  }
+  outpath.append("/");
+  outpath.append(basename);
+
+  FILE *outfile = base_fopen(outpath.c_str(), "w+");
+  if (!outfile) {
+    zip_fclose(file);
+    throw grt::os_error(_("Error creating temporary file while opending document."), errno);
+  }
 
-    // skip lock file as it is already locked and inaccessible
-    if (basename == lock_filename) {
+  char buffer[4098];
+  ssize_t c;
+  while ((c = (size_t)zip_fread(file, buffer, sizeof(buffer))) > 0) {
+    if ((ssize_t)fwrite(buffer, 1, c, outfile) < c) {
+      int err = ferror(outfile);
+      fclose(outfile);
       zip_fclose(file);
-      continue;
+      throw grt::os_error(_("Error writing temporary file while opending document."), err);
     }
+  }
 
-    std::string outpath = destdir;
+  if (c < 0) {
+    std::string err = zip_file_strerror(file) ? zip_file_strerror(file) : "";
+    zip_fclose(file);
+    fclose(outfile);
+    throw std::runtime_error(strfmt(_("Error opening document file: %s"), err.c_str()));
+  }
 
-    if (!dirname.empty()) {
-      outpath.append("/");
-      outpath.append(dirname);
-      if (g_mkdir_with_parents(outpath.c_str(), 0700) < 0) {
-        zip_fclose(file);
-        zip_close(z);
-        throw grt::os_error(_("Error creating temporary directory while opending document."), errno);
-      }
+  zip_fclose(file);
+  fclose(outfile);
+
+  return outpath;
+}
+
+std::list<std::string> ModelFile::unpack_zip(const std::string &zipfile, const std::string &destdir) {
+  std::list<std::string> unpacked_files;
+
+  if (g_mkdir_with_parents(destdir.c_str(), 0700) < 0)
+    throw grt::os_error(strfmt(_("Cannot create temporary directory for open document: %s"), destdir.c_str()), errno);
+
+  zip *z = open_zip_archive(zipfile);
+  try {
+    for (int count = zip_entry_count(z), i = 0; i < count; i++) {
+      std::string outpath = extract_zip_entry(z, i, destdir);
+      if (!outpath.empty())
+        unpacked_files.push_back(outpath);
     }
-    outpath.append("/");
-    outpath.append(basename);
+  } catch (...) {
+    zip_close(z);
+    throw;
+  }
 
-    FILE *outfile = base_fopen(outpath.c_str(), "w+");
-    if (!outfile) {
-      zip_fclose(file);
-      zip_close(z);
-      throw grt::os_error(_("Error creating temporary file while opending document."), errno);
+  zip_close(z);
+
+  return unpacked_files;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Attachments of at least this size are only extracted when they are accessed.
+#define LAZY_EXTRACTION_SIZE (256 * 1024)
+
+// Attachments of an opened archive that were not extracted yet, see unpack_document().
+struct ModelFile::PendingEntries {
+  std::string zipfile;
+  std::string destdir;
+
+  std::mutex mutex;
+  std::condition_variable extracted;
+  std::map<std::string, int> entries; // entry name -> index in the archive
+  std::deque<std::string> queue;      // entries to be extracted by the worker threads
+  std::set<std::string> in_progress;
+  std::vector<std::thread> workers;
+  bool cancelled;
+
+  PendingEntries() : cancelled(false) {
+  }
+};
+
+/**
+ * Extracts the main document and the data file right away, so they can be loaded while the worker threads
+ * extract the attachments. Large attachments are left in the archive until they are first accessed
+ * (get_path_for()) or the document is saved.
+ */
+void ModelFile::unpack_document(const std::string &zipfile) {
+  if (g_mkdir_with_parents(_content_dir.c_str(), 0700) < 0)
+    throw grt::os_error(strfmt(_("Cannot create temporary directory for open document: %s"), _content_dir.c_str()),
+                        errno);
+
+  std::shared_ptr<PendingEntries> pending(new PendingEntries());
+  pending->zipfile = zipfile;
+  pending->destdir = _content_dir;
+
+  zip *z = open_zip_archive(zipfile);
+  try {
+    for (int count = zip_entry_count(z), i = 0; i < count; i++) {
+      const char *zname = zip_get_name(z, i, 0);
+      std::string dirname = zname ? base::dirname(zname) : "";
+
+      if (dirname == IMAGES_DIR || dirname == SCRIPTS_DIR || dirname == NOTES_DIR) {
+        struct zip_stat st;
+        pending->entries[zname] = i;
+        if (zip_stat_index(z, i, 0, &st) == 0 && st.size < LAZY_EXTRACTION_SIZE)
+          pending->queue.push_back(zname);
+      } else
+        extract_zip_entry(z, i, _content_dir);
     }
+  } catch (...) {
+    zip_close(z);
+    throw;
+  }
+  zip_close(z);
 
-    unpacked_files.push_back(outpath);
-
-    char buffer[4098];
-    ssize_t c;
-    while ((c = (size_t)zip_fread(file, buffer, sizeof(buffer))) > 0) {
-      if ((ssize_t)fwrite(buffer, 1, c, outfile) < c) {
-        int err = ferror(outfile);
-        fclose(outfile);
-        zip_fclose(file);
-        zip_close(z);
-        throw grt::os_error(_("Error writing temporary file while opending document."), err);
-      }
+  if (pending->entries.empty())
+    return;
+
+  _pending_entries = pending;
+
+  size_t worker_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1U), 4);
+  worker_count = std::min(worker_count, pending->queue.size());
+  for (size_t i = 0; i < worker_count; i++)
+    pending->workers.push_back(std::thread(&ModelFile::extraction_worker, pending));
+}
+
+void ModelFile::extraction_worker(std::shared_ptr<PendingEntries> pending) {
+  zip *z = NULL;
+  try {
+    z = open_zip_archive(pending->zipfile);
+  } catch (std::exception &exc) {
+    logError("Cannot open %s to extract attached files: %s\n", pending->zipfile.c_str(), exc.what());
+    return;
+  }
+
+  for (;;) {
+    std::string name;
+    int index;
+    {
+      std::lock_guard<std::mutex> lock(pending->mutex);
+      while (!pending->queue.empty() && (pending->entries.count(pending->queue.front()) == 0 ||
+                                         pending->in_progress.count(pending->queue.front()) > 0))
+        pending->queue.pop_front();
+      if (pending->cancelled || pending->queue.empty())
+        break;
+
+      name = pending->queue.front();
+      pending->queue.pop_front();
+      index = pending->entries[name];
+      pending->in_progress.insert(name);
     }
 
-    if (c < 0) {
-      std::string err = zip_file_strerror(file) ? zip_file_strerror(file) : "";
-      zip_fclose(file);
-      zip_close(z);
-      throw std::runtime_error(strfmt(_("Error opening document file: %s"), err.c_str()));
+    bool extracted = true;
+    try {
+      extract_zip_entry(z, index, pending->destdir);
+    } catch (std::exception &exc) {
+      // stays pending, so the error is reported again when the file is accessed
+      logWarning("Error extracting %s from %s: %s\n", name.c_str(), pending->zipfile.c_str(), exc.what());
+      extracted = false;
     }
 
-    zip_fclose(file);
-    fclose(outfile);
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    pending->in_progress.erase(name);
+    if (extracted)
+      pending->entries.erase(name);
+    pending->extracted.notify_all();
   }
 
   zip_close(z);
+}
 
-  return unpacked_files;
+/**
+ * Makes sure the given attachment was extracted from the archive, either by extracting it now or by
+ * waiting for the worker thread that is already doing it.
+ */
+void ModelFile::extract_pending_file(const std::string &name) {
+  std::shared_ptr<PendingEntries> pending(_pending_entries);
+  if (!pending)
+    return;
+
+  int index;
+  {
+    std::unique_lock<std::mutex> lock(pending->mutex);
+    pending->extracted.wait(lock, [&]() { return pending->in_progress.count(name) == 0; });
+
+    std::map<std::string, int>::const_iterator entry = pending->entries.find(name);
+    if (entry == pending->entries.end())
+      return;
+    index = entry->second;
+    pending->in_progress.insert(name);
+  }
+
+  try {
+    zip *z = open_zip_archive(pending->zipfile);
+    try {
+      extract_zip_entry(z, index, pending->destdir);
+    } catch (...) {
+      zip_close(z);
+      throw;
+    }
+    zip_close(z);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    pending->in_progress.erase(name);
+    pending->extracted.notify_all();
+    throw;
+  }
+
+  std::lock_guard<std::mutex> lock(pending->mutex);
+  pending->in_progress.erase(name);
+  pending->entries.erase(name);
+  pending->extracted.notify_all();
+}
+
+/**
+ * Extracts all attachments that are still in the archive and whose name starts with @prefix.
+ */
+void ModelFile::extract_pending_files(const std::string &prefix) {
+  std::shared_ptr<PendingEntries> pending(_pending_entries);
+  if (!pending)
+    return;
+
+  std::vector<std::string> names;
+  {
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    for (std::map<std::string, int>::const_iterator entry = pending->entries.begin();
+         entry != pending->entries.end(); ++entry) {
+      if (base::hasPrefix(entry->first, prefix))
+        names.push_back(entry->first);
+    }
+  }
+
+  for (std::vector<std::string>::const_iterator name = names.begin(); name != names.end(); ++name)
+    extract_pending_file(*name);
+
+  if (prefix.empty())
+    stop_extraction();
+}
+
+void ModelFile::stop_extraction() {
+  std::shared_ptr<PendingEntries> pending(_pending_entries);
+  if (!pending)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    pending->cancelled = true;
+    pending->queue.clear();
+  }
+
+  for (std::vector<std::thread>::iterator worker = pending->workers.begin(); worker != pending->workers.end();
+       ++worker) {
+    if (worker->joinable())
+      worker->join();
+  }
+  pending->workers.clear();
+
+  _pending_entries.reset();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+  // A file of the document dir as stored in the archive.
+  struct ArchiveEntry {
+    std::string name; // path in the archive, relative to the document dir
+    std::string data; // contents of the file, replaced by the deflated data when compressed
+    time_t mtime;
+    bool store;
+    zip_uint64_t size; // size of the file
+    uLong crc;
+    size_t offset; // read position of libzip in data
+  };
+
+  // A piece of an entry deflated by one thread, the pieces of an entry are concatenated into one deflate stream.
+  struct DeflateChunk {
+    size_t entry;
+    size_t start;
+    size_t length;
+    std::string output;
+    uLong crc;
+  };
+}
+
+typedef std::vector<ArchiveEntry> ArchiveContents;
+
+// Images, thumbnails and archives don't get smaller when deflated again.
+static bool is_compressed_file(const std::string &name) {
+  static const char *extensions[] = {".png", ".jpg", ".jpeg", ".gif", ".gz", ".zip", NULL};
+
+  std::string ext = base::tolower(base::extension(name));
+  for (const char **e = extensions; *e; ++e) {
+    if (ext == *e)
+      return true;
+  }
+  return false;
 }
 
-static void zip_dir_contents(zip *z, const std::string &destdir, const std::string &partial) {
+/**
+ * Reads the files of the document dir into memory, so the archive can be written in the background while the
+ * dir keeps changing. Files come before the contents of the subdirectories, which is the order of older versions.
+ */
+static void collect_archive_entries(const std::string &basedir, const std::string &prefix, int level,
+                                    ArchiveContents &entries) {
+  std::string path = prefix.empty() ? basedir : basedir + "/" + prefix;
   GError *error = 0;
-  GDir *dir = g_dir_open(destdir.empty() ? "." : destdir.c_str(), 0, &error);
+  GDir *dir = g_dir_open(path.c_str(), 0, &error);
   if (!dir) {
-    zip_close(z);
     std::string err = error ? error->message : "Cannot open document directory.";
-    g_error_free(error);
+    if (error)
+      g_error_free(error);
     throw grt::os_error(err);
   }
 
-  // must add stuff in 2 steps, 1st files only and then dirs only
-  for (int add_directories = 0; add_directories < 2; add_directories++) {
-    const gchar *entry;
-    while ((entry = g_dir_read_name(dir))) {
-      std::string tmp = destdir;
+  std::vector<std::string> subdirs;
+  const gchar *name;
+  while ((name = g_dir_read_name(dir))) {
+    ArchiveEntry entry;
+    entry.name = prefix.empty() ? name : prefix + "/" + name;
 
-      if (!tmp.empty())
-        tmp.append("/").append(entry);
-      else
-        tmp.append(entry);
+    std::string file = basedir + "/" + entry.name;
+    if (g_file_test(file.c_str(), G_FILE_TEST_IS_DIR)) {
+      subdirs.push_back(entry.name);
+      continue;
+    }
 
-      if (g_file_test(tmp.c_str(), G_FILE_TEST_IS_DIR)) {
-        if (add_directories) {
-          try {
-            zip_dir_contents(z, destdir.empty() ? entry : destdir + G_DIR_SEPARATOR + entry, tmp);
-          } catch (...) {
-            g_dir_close(dir);
-            throw;
-          }
-        }
-      } else {
-        if (!add_directories) {
-          zip_source *src = zip_source_file(z, tmp.c_str(), 0, 0);
-#ifdef _WIN32
-          if (!src || zip_file_add(z, tmp.c_str(), src, ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8) < 0) {
-            zip_source_free(src);
-            g_dir_close(dir);
-            throw std::runtime_error(zip_strerror(z));
-          }
-#else
-          if (!src || zip_add(z, tmp.c_str(), src) < 0) {
-            zip_source_free(src);
-            g_dir_close(dir);
-            throw std::runtime_error(zip_strerror(z));
-          }
-#endif
-        }
-      }
+    gchar *contents = NULL;
+    gsize length = 0;
+    if (!g_file_get_contents(file.c_str(), &contents, &length, &error)) {
+      std::string err = error ? error->message : "Cannot read " + file;
+      if (error)
+        g_error_free(error);
+      g_dir_close(dir);
+      throw grt::os_error(err);
     }
-    g_dir_rewind(dir);
+    entry.data.assign(contents, length);
+    g_free(contents);
+
+    GStatBuf st;
+    entry.mtime = g_stat(file.c_str(), &st) == 0 ? st.st_mtime : time(NULL);
+    entry.store = level == 0 || is_compressed_file(entry.name);
+    entry.size = entry.data.size();
+    entry.crc = 0;
+    entry.offset = 0;
+    entries.push_back(entry);
   }
   g_dir_close(dir);
+
+  for (std::vector<std::string>::const_iterator subdir = subdirs.begin(); subdir != subdirs.end(); ++subdir)
+    collect_archive_entries(basedir, *subdir, level, entries);
 }
 
-void ModelFile::pack_zip(const std::string &zipfile, const std::string &destdir, const std::string &comment) {
-  std::string curdir;
+//--------------------------------------------------------------------------------------------------
 
-  {
-    gchar *cwd = g_get_current_dir();
-    curdir = cwd;
-    g_free(cwd);
+/**
+ * Deflates a piece of an entry into a raw deflate stream. All but the last piece end with a sync flush instead of
+ * the final block, which leaves the output byte aligned so the pieces can simply be concatenated.
+ */
+static void deflate_chunk(const ArchiveEntry &entry, DeflateChunk &chunk, int level) {
+  const Bytef *data = (const Bytef *)entry.data.data() + chunk.start;
+  chunk.crc = crc32(crc32(0L, Z_NULL, 0), data, (uInt)chunk.length);
+  if (entry.store)
+    return;
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // Negative window bits select raw deflate data, zip entries have no zlib header.
+  if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    throw std::runtime_error("Cannot initialize compression for " + entry.name);
+
+  if (chunk.start > 0) {
+    uInt dictionary = (uInt)std::min<size_t>(chunk.start, DEFLATE_DICTIONARY_SIZE);
+    deflateSetDictionary(&stream, data - dictionary, dictionary);
+  }
+
+  bool last = chunk.start + chunk.length == entry.data.size();
+  chunk.output.resize(deflateBound(&stream, (uLong)chunk.length) + 16);
+  stream.next_in = (Bytef *)data;
+  stream.avail_in = (uInt)chunk.length;
+  stream.next_out = (Bytef *)&chunk.output[0];
+  stream.avail_out = (uInt)chunk.output.size();
+
+  int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool complete = last ? result == Z_STREAM_END : (result == Z_OK && stream.avail_out > 0 && stream.avail_in == 0);
+  chunk.output.resize(chunk.output.size() - stream.avail_out);
+  deflateEnd(&stream);
+
+  if (!complete)
+    throw std::runtime_error("Error compressing " + entry.name);
+}
+
+/**
+ * Compresses all entries with the shared thread pool. Files larger than DEFLATE_CHUNK_SIZE, usually the document
+ * XML and the data file, are split so even a model with a single big file uses all threads. Entries that don't
+ * get smaller are stored.
+ */
+static void compress_archive_entries(ArchiveContents &entries, int level) {
+  std::vector<DeflateChunk> chunks;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    size_t start = 0;
+    do {
+      DeflateChunk chunk;
+      chunk.entry = i;
+      chunk.start = start;
+      chunk.length = std::min<size_t>(DEFLATE_CHUNK_SIZE, entries[i].data.size() - start);
+      chunk.crc = 0;
+      chunks.push_back(chunk);
+      start += chunk.length;
+    } while (start < entries[i].data.size());
+  }
+  if (chunks.empty())
+    return;
+
+  std::atomic<size_t> next_chunk(0);
+  size_t thread_count = std::min(base::TaskScheduler::get()->thread_count(), chunks.size());
+  base::TaskScheduler::get()->run_parallel(base::TaskBackground, thread_count, [&](size_t) {
+    for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++)
+      deflate_chunk(entries[chunks[i].entry], chunks[i], level);
+  });
+
+  std::string compressed;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    ArchiveEntry &entry = entries[chunks[i].entry];
+    if (chunks[i].start == 0) {
+      entry.crc = chunks[i].crc;
+      compressed.clear();
+    } else
+      entry.crc = crc32_combine(entry.crc, chunks[i].crc, (z_off_t)chunks[i].length);
+    compressed.append(chunks[i].output);
+    std::string().swap(chunks[i].output);
+
+    if (!entry.store && chunks[i].start + chunks[i].length == entry.data.size()) {
+      if (compressed.size() < entry.data.size())
+        entry.data.swap(compressed);
+      else
+        entry.store = true;
+    }
   }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// libzip source for an entry compressed by compress_archive_entries(), libzip copies the data as it is.
+static zip_int64_t archive_entry_source(void *state, void *data, zip_uint64_t length, enum zip_source_cmd cmd) {
+  ArchiveEntry *entry = (ArchiveEntry *)state;
+
+  switch (cmd) {
+    case ZIP_SOURCE_OPEN:
+      entry->offset = 0;
+      return 0;
+
+    case ZIP_SOURCE_READ: {
+      size_t count = (size_t)std::min<zip_uint64_t>(length, entry->data.size() - entry->offset);
+      memcpy(data, entry->data.data() + entry->offset, count);
+      entry->offset += count;
+      return (zip_int64_t)count;
+    }
+
+    case ZIP_SOURCE_STAT: {
+      struct zip_stat *st = (struct zip_stat *)data;
+      zip_stat_init(st);
+      st->size = entry->size;
+      st->comp_size = entry->data.size();
+      st->crc = (zip_uint32_t)entry->crc;
+      st->mtime = entry->mtime;
+      st->comp_method = entry->store ? ZIP_CM_STORE : ZIP_CM_DEFLATE;
+      st->valid = ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_CRC | ZIP_STAT_MTIME | ZIP_STAT_COMP_METHOD;
+      return sizeof(*st);
+    }
 
-  // change to the document data directory (after opening the zip file)
-  // so that the zip won't have the full paths of the contents stored
-  if (g_chdir(destdir.c_str()) < 0)
-    throw grt::os_error("chdir failed.");
+    case ZIP_SOURCE_ERROR: {
+      int *error = (int *)data;
+      error[0] = error[1] = 0;
+      return 2 * sizeof(int);
+    }
+
+    case ZIP_SOURCE_CLOSE:
+    case ZIP_SOURCE_FREE:
+      return 0;
+
+    default:
+      return -1;
+  }
+}
+
+static void write_archive(const std::string &zipfile, ArchiveContents &entries, const std::string &comment,
+                          int level) {
+  compress_archive_entries(entries, level);
 
   // zip_open will open an existing file even if ZIP_CREATE is specified, so
   // we have to 1st delete the file...
@@ -660,22 +1091,78 @@ void ModelFile::pack_zip(const std::string &zipfile, const std::string &destdir,
 #endif
 
   try {
-    zip_dir_contents(z, "", "");
+    for (ArchiveContents::iterator entry = entries.begin(); entry != entries.end(); ++entry) {
+      zip_source *src = zip_source_function(z, archive_entry_source, &*entry);
+#ifdef _WIN32
+      zip_int64_t index = src ? zip_file_add(z, entry->name.c_str(), src, ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8) : -1;
+#else
+      zip_int64_t index = src ? zip_add(z, entry->name.c_str(), src) : -1;
+#endif
+      if (index < 0) {
+        if (src)
+          zip_source_free(src);
+        throw std::runtime_error(zip_strerror(z));
+      }
+      // Without this libzip would deflate the stored data.
+      if (entry->store)
+        zip_set_file_compression(z, (zip_uint64_t)index, ZIP_CM_STORE, 0);
+    }
 
     if (zip_close(z) < 0) {
       std::string err = zip_strerror(z) ? zip_strerror(z) : "";
 
       throw std::runtime_error(strfmt(_("Error writing zip file: %s"), err.c_str()));
     }
-
-    g_chdir(curdir.c_str());
   } catch (...) {
     zip_close(z);
-    g_chdir(curdir.c_str());
     throw;
   }
 }
 
+void ModelFile::pack_zip(const std::string &zipfile, const std::string &destdir, const std::string &comment) {
+  ArchiveContents entries;
+  collect_archive_entries(destdir, "", _compression_level, entries);
+  write_archive(zipfile, entries, comment, _compression_level);
+}
+
+/**
+ * Loads a document of the current format with the streaming unserializer, which avoids keeping the whole
+ * XML tree in memory next to the objects created from it. Returns an invalid ref if the document must go
+ * through the DOM based load instead (older format versions, or data that needs repairs at XML level).
+ */
+workbench_DocumentRef ModelFile::unserialize_document_stream(const std::string &path) {
+  std::string doctype, version;
+  grt::ValueRef value;
+
+  try {
+    value = grt::GRT::get()->unserialize(path, doctype, version);
+  } catch (std::exception &exc) {
+    logInfo("Streaming load of %s failed, loading it as XML tree: %s\n", path.c_str(), exc.what());
+    return workbench_DocumentRef();
+  }
+
+  if (doctype != DOCUMENT_FORMAT || version != DOCUMENT_VERSION || !workbench_DocumentRef::can_wrap(value))
+    return workbench_DocumentRef();
+
+  _loaded_version = version;
+  _load_warnings.clear();
+
+  workbench_DocumentRef doc(workbench_DocumentRef::cast_from(value));
+
+  doc = attempt_document_upgrade(doc, NULL, version);
+
+  cleanup_upgrade_data();
+
+  check_and_fix_inconsistencies(doc, version);
+
+  if (!semantic_check(doc))
+    return workbench_DocumentRef();
+
+  return doc;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 workbench_DocumentRef ModelFile::unserialize_document(xmlDocPtr xmldoc, const std::string &path) {
   std::string doctype, version;
 
@@ -724,8 +1211,15 @@ workbench_DocumentRef ModelFile::unserialize_document(xmlDocPtr xmldoc, const st
  * (if there is one). Checks are performed to ensure existing backup files can be removed and existing
  * model files can be renamed to .bak.
  */
-bool ModelFile::save_to(const std::string &path, const std::string &comment) {
+bool ModelFile::save_to(const std::string &path, const std::string &comment, const SaveFinishedSlot &finished) {
   RecMutexLock lock(_mutex);
+
+  // a previous save may still be writing the file that is backed up below
+  wait_for_save();
+
+  // the archive the document was opened from may be replaced below
+  extract_pending_files();
+
 #ifdef _WIN32
   const int read_write = _S_IWRITE | _S_IREAD;
 #else
@@ -788,26 +1282,61 @@ bool ModelFile::save_to(const std::string &path, const std::string &comment) {
   _delete_queue.clear();
 
   // saving the file for real can delete the autosave
-  g_remove(get_path_for("document-autosave.mwb.xml").c_str());
+  g_remove(get_path_for(MAIN_DOCUMENT_AUTOSAVE_NAME).c_str());
+  g_remove(get_path_for(MAIN_DOCUMENT_AUTOSAVE_BINARY_NAME).c_str());
+  g_remove(get_path_for(MAIN_DOCUMENT_AUTOSAVE_JOURNAL_NAME).c_str());
   g_remove(get_path_for("real_path").c_str());
 
-  if (g_path_is_absolute(path.c_str()))
-    pack_zip(path, _content_dir, comment);
-  else {
+  std::string zipfile = path;
+  if (!g_path_is_absolute(path.c_str())) {
     char *prefix = g_get_current_dir();
-    pack_zip(std::string(prefix).append("/").append(path), _content_dir, comment);
+    zipfile = std::string(prefix).append("/").append(path);
     g_free(prefix);
   }
 
+  if (!finished) {
+    pack_zip(zipfile, _content_dir, comment);
+    _dirty = false;
+    return true;
+  }
+
+  // The files are read here, so the document can change again while the archive is written.
+  std::shared_ptr<ArchiveContents> entries(new ArchiveContents());
+  collect_archive_entries(_content_dir, "", _compression_level, *entries);
   _dirty = false;
+
+  int level = _compression_level;
+  _save_thread = std::thread([zipfile, entries, comment, level, finished]() {
+    std::string error;
+    try {
+      write_archive(zipfile, *entries, comment, level);
+    } catch (std::exception &exc) {
+      logError("Error saving %s: %s\n", zipfile.c_str(), exc.what());
+      error = exc.what();
+    }
+    entries->clear();
+    finished(error);
+  });
   return true;
 }
 
+void ModelFile::wait_for_save() {
+  if (_save_thread.joinable())
+    _save_thread.join();
+}
+
+void ModelFile::set_compression_level(int level) {
+  _compression_level = std::min(std::max(level, 0), 9);
+}
+
 //--------------------------------------------------------------------------------------------------
 
 void ModelFile::cleanup() {
   RecMutexLock lock(_mutex);
 
+  wait_for_save();
+  stop_extraction();
+
   delete _temp_dir_lock;
   _temp_dir_lock = 0;
 
@@ -876,18 +1405,21 @@ std::string ModelFile::add_attachment_file(const std::string &destdir, const std
 
 std::string ModelFile::add_image_file(const std::string &path) {
   _dirty = true;
+  extract_pending_files(IMAGES_DIR "/"); // the new name must not clash with a file still in the archive
 
   return add_attachment_file(_content_dir + "/" + IMAGES_DIR, path);
 }
 
 std::string ModelFile::add_script_file(const std::string &path) {
   _dirty = true;
+  extract_pending_files(SCRIPTS_DIR "/"); // the new name must not clash with a file still in the archive
 
   return add_attachment_file(_content_dir + "/" + SCRIPTS_DIR, path);
 }
 
 std::string ModelFile::add_note_file(const std::string &path) {
   _dirty = true;
+  extract_pending_files(NOTES_DIR "/"); // the new name must not clash with a file still in the archive
 
   return add_attachment_file(_content_dir + "/" + NOTES_DIR, path);
 }
@@ -933,7 +1465,37 @@ void ModelFile::store_document(const workbench_DocumentRef &doc) {
 }
 
 void ModelFile::store_document_autosave(const workbench_DocumentRef &doc) {
-  grt::GRT::get()->serialize(doc, get_path_for("document-autosave.mwb.xml"), DOCUMENT_FORMAT, DOCUMENT_VERSION);
+  // Autosaves are only read back by this application, so the faster binary format is used for them.
+  grt::GRT::get()->serialize_binary(doc, get_path_for(MAIN_DOCUMENT_AUTOSAVE_BINARY_NAME), DOCUMENT_FORMAT,
+                                    DOCUMENT_VERSION);
+  g_remove(get_path_for(MAIN_DOCUMENT_AUTOSAVE_NAME).c_str());
+  g_remove(get_path_for(MAIN_DOCUMENT_AUTOSAVE_JOURNAL_NAME).c_str());
+}
+
+/**
+ * Appends the given objects to the autosave journal, which records changes made after the last full
+ * autosave. Each record is the XML of one object, prefixed by its size in a line of its own. Recovery
+ * replaces the objects with the same id in the autosaved document with these, in order.
+ * Returns false without writing anything if there is no full autosave the journal could apply to.
+ */
+bool ModelFile::store_document_autosave_changes(const std::list<GrtObjectRef> &objects) {
+  if (!g_file_test(get_path_for(MAIN_DOCUMENT_AUTOSAVE_BINARY_NAME).c_str(), G_FILE_TEST_EXISTS))
+    return false;
+
+  std::string data;
+  for (std::list<GrtObjectRef>::const_iterator object = objects.begin(); object != objects.end(); ++object) {
+    std::string xml = grt::GRT::get()->serialize_xml_data(*object, DOCUMENT_FORMAT, DOCUMENT_VERSION);
+    data.append(strfmt("%lu\n", (unsigned long)xml.size())).append(xml);
+  }
+
+  FILE *file = base_fopen(get_path_for(MAIN_DOCUMENT_AUTOSAVE_JOURNAL_NAME).c_str(), "ab");
+  if (!file)
+    throw grt::os_error("Cannot open autosave journal", errno);
+
+  size_t written = fwrite(data.data(), 1, data.size(), file);
+  if (fclose(file) != 0 || written != data.size())
+    throw grt::os_error("Error writing autosave journal", errno);
+  return true;
 }
 
 void ModelFile::delete_file(const std::string &path) {
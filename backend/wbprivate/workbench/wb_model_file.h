@@ -25,7 +25,9 @@
 
 #include "wb_backend_public_interface.h"
 
+#include <functional>
 #include <string>
+#include <thread>
 #include "grt.h"
 #include "base/file_utilities.h"
 #include "grts/structs.workbench.h"
@@ -37,6 +39,8 @@
 
 #define MAIN_DOCUMENT_NAME "document.mwb.xml"
 #define MAIN_DOCUMENT_AUTOSAVE_NAME "document-autosave.mwb.xml"
+#define MAIN_DOCUMENT_AUTOSAVE_BINARY_NAME "document-autosave.mwb.grtb"
+#define MAIN_DOCUMENT_AUTOSAVE_JOURNAL_NAME "document-autosave.journal"
 
 namespace bec {
   class GRTManager;
@@ -55,7 +59,17 @@ namespace wb {
 
     void cleanup();
 
-    bool save_to(const std::string &path, const std::string &comment = "");
+    // Called by the saving thread once a save in the background is done, with the error message if it failed.
+    typedef std::function<void(const std::string &error)> SaveFinishedSlot;
+
+    // With a finished slot the archive is compressed and written in the background from a snapshot of the
+    // document files, otherwise before returning.
+    bool save_to(const std::string &path, const std::string &comment = "",
+                 const SaveFinishedSlot &finished = SaveFinishedSlot());
+    void wait_for_save();
+
+    // zlib level used when saving, 0 stores all files uncompressed.
+    void set_compression_level(int level);
 
     bool has_unsaved_changes() {
       return _dirty;
@@ -69,6 +83,7 @@ namespace wb {
 
     void store_document(const workbench_DocumentRef &doc);
     void store_document_autosave(const workbench_DocumentRef &doc);
+    bool store_document_autosave_changes(const std::list<GrtObjectRef> &objects);
 
     std::list<std::string> get_file_list(const std::string &prefixdir = "");
     bool has_file(const std::string &name);
@@ -89,6 +104,7 @@ namespace wb {
     std::string get_file_contents(const std::string &path);
 
     std::string get_path_for(const std::string &file);
+    void extract_pending_files(const std::string &prefix = "");
     std::string get_tempdir_path() {
       return _content_dir;
     }
@@ -121,6 +137,8 @@ namespace wb {
     std::list<std::string> _load_warnings; //< warnings from loaded model
 
     bool _dirty;
+    int _compression_level;
+    std::thread _save_thread; //< writes the archive of a save in the background
 
     typedef std::map<std::string, std::string> TableInsertsSqlScripts; // table guid -> sql script (inserts)
     TableInsertsSqlScripts
@@ -128,7 +146,16 @@ namespace wb {
 
     boost::signals2::signal<void()> _changed_signal;
 
+    struct PendingEntries;
+    std::shared_ptr<PendingEntries> _pending_entries; //< attachments not extracted from the archive yet
+
+    void unpack_document(const std::string &zipfile);
+    static void extraction_worker(std::shared_ptr<PendingEntries> pending);
+    void extract_pending_file(const std::string &name);
+    void stop_extraction();
+
     workbench_DocumentRef unserialize_document(xmlDocPtr xmldoc, const std::string &path);
+    workbench_DocumentRef unserialize_document_stream(const std::string &path);
 
   private:
     bool attempt_xml_document_upgrade(xmlDocPtr xmldoc, const std::string &version);
@@ -143,6 +170,8 @@ namespace wb {
 
     void check_and_fix_inconsistencies(const workbench_DocumentRef &doc, const std::string &version);
 
+    void apply_autosave_journal(const std::string &document_path, const std::string &journal_path);
+
   public:
     static std::list<std::string> unpack_zip(const std::string &zipfile, const std::string &destdir);
     void pack_zip(const std::string &zipfile, const std::string &destdir, const std::string &comment = "");
@@ -939,25 +939,79 @@ static void check_schema_objects(db_SchemaRef schema, std::list<std::string> &lo
       }
     }
 
-    /* this is not done in the FK check
-    GRTLIST_FOREACH(db_ForeignKey, (*table)->foreignKeys(), fk)
-    {
-      if ((*fk)->columns().count() != (*fk)->referencedColumns().count())
-      {
-        load_warnings.push_back(strfmt("Foreign Key %s has an invalid column definition. The invalid values were
-    removed.",
-                                       (*fk)->name().c_str()));
+    // documents loaded by the streaming unserializer don't get the XML level FK check
+    GRTLIST_FOREACH(db_ForeignKey, (*table)->foreignKeys(), fk) {
+      if ((*fk)->columns().count() != (*fk)->referencedColumns().count()) {
+        load_warnings.push_back(
+          strfmt("Foreign Key %s has an invalid column definition. The invalid values were removed.",
+                 (*fk)->name().c_str()));
 
         while ((*fk)->columns().count() > (*fk)->referencedColumns().count())
-          (*fk)->columns().remove((*fk)->columns().count()-1);
+          (*fk)->columns().remove((*fk)->columns().count() - 1);
         while ((*fk)->columns().count() < (*fk)->referencedColumns().count())
-          (*fk)->referencedColumns().remove((*fk)->referencedColumns().count()-1);
+          (*fk)->referencedColumns().remove((*fk)->referencedColumns().count() - 1);
       }
     }
-     */
   }
 }
 
+/**
+ * Replaces objects in the XML document at @document_path with the versions written to the autosave journal,
+ * in the order they were written. A record cut short by a crash is ignored.
+ */
+void ModelFile::apply_autosave_journal(const std::string &document_path, const std::string &journal_path) {
+  gchar *contents = NULL;
+  gsize length = 0;
+  if (!g_file_get_contents(journal_path.c_str(), &contents, &length, NULL))
+    throw std::runtime_error("Cannot read autosave journal " + journal_path);
+  std::string journal(contents, length);
+  g_free(contents);
+
+  xmlDocPtr xmldoc = grt::GRT::get()->load_xml(document_path);
+  XMLTraverser traverser(xmldoc);
+  std::map<std::string, xmlNodePtr> replaced_nodes;
+
+  size_t pos = 0;
+  while (pos < journal.size()) {
+    size_t eol = journal.find('\n', pos);
+    size_t size = eol == std::string::npos ? 0 : strtoul(journal.c_str() + pos, NULL, 10);
+    if (size == 0 || eol + 1 + size > journal.size()) {
+      logWarning("Ignoring incomplete record at the end of the autosave journal\n");
+      break;
+    }
+
+    xmlDocPtr record = xmlReadMemory(journal.data() + eol + 1, (int)size, NULL, NULL, 0);
+    pos = eol + 1 + size;
+    if (!record) {
+      logWarning("Ignoring invalid record in the autosave journal\n");
+      continue;
+    }
+
+    xmlNodePtr value = XMLTraverser(record).get_root();
+    std::string id = value ? XMLTraverser::node_prop(value, "id") : "";
+    xmlNodePtr target = NULL;
+    if (replaced_nodes.find(id) != replaced_nodes.end())
+      target = replaced_nodes[id];
+    else if (!id.empty())
+      target = traverser.get_object(id.c_str());
+
+    if (target) {
+      xmlNodePtr copy = xmlDocCopyNode(value, xmldoc, 1);
+      xmlReplaceNode(target, copy);
+      xmlFreeNode(target);
+      replaced_nodes[id] = copy;
+    } else
+      logWarning("Object %s from the autosave journal is not in the document\n", id.c_str());
+
+    xmlFreeDoc(record);
+  }
+
+  int result = xmlSaveFile(document_path.c_str(), xmldoc);
+  xmlFreeDoc(xmldoc);
+  if (result < 0)
+    throw std::runtime_error("Cannot write recovered document " + document_path);
+}
+
 void ModelFile::check_and_fix_inconsistencies(xmlDocPtr xmldoc, const std::string &version) {
   std::vector<std::string> ver = base::split(version, ".");
 
@@ -25,6 +25,7 @@
 
 #include "base/config_file.h"
 #include "base/log.h"
+#include "base/mem_stat.h"
 
 #include "wb_module.h"
 #include "wb_overview.h"
@@ -1156,6 +1157,12 @@ int WorkbenchImpl::debugValidateGRT() {
 
 //--------------------------------------------------------------------------------------------------
 
+std::string WorkbenchImpl::getMemoryUsage() {
+  return base::MemoryAccounting::report();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 int WorkbenchImpl::refreshHomeConnections() {
   wb::WBContextUI::get()->refresh_home_connections();
   return 0;
@@ -129,6 +129,7 @@ namespace wb {
       DECLARE_MODULE_FUNCTION(WorkbenchImpl::getTempDir),
 
       DECLARE_MODULE_FUNCTION(WorkbenchImpl::debugValidateGRT),
+      DECLARE_MODULE_FUNCTION(WorkbenchImpl::getMemoryUsage),
       DECLARE_MODULE_FUNCTION(WorkbenchImpl::getVideoAdapter),
 
       DECLARE_MODULE_FUNCTION(WorkbenchImpl::runScriptFile),
@@ -279,6 +280,8 @@ namespace wb {
 
     // debugging
     int debugValidateGRT();
+    // Memory held by the subsystems registered with base::MemoryAccounting, as a printable table.
+    std::string getMemoryUsage();
 
     int showUserTypeEditor(const workbench_physical_ModelRef &model);
     int showDocumentProperties();
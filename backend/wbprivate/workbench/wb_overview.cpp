@@ -61,7 +61,7 @@ bool OverviewBE::ObjectNode::rename(WBContext *wb, const std::string &name) {
     grt::AutoUndo undo;
     dbobj->name(name);
     undo.end(strfmt(_("Rename %s"), dbobj.get_metaclass()->get_attribute("caption").c_str()));
-    bec::ValidationManager::validate_instance(object, CHECK_NAME);
+    bec::ValidationManager::validate_instance_later(object, CHECK_NAME);
   } else
     throw std::runtime_error("rename not implemented for this object");
 
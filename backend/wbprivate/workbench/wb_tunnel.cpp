@@ -169,6 +169,15 @@ std::shared_ptr<sql::TunnelConnection> TunnelManager::createTunnel(db_mgmt_Conne
       logInfo("Existing SSH tunnel found, connecting\n");
       config.localport = tunnel_port;
       return std::shared_ptr<sql::TunnelConnection>(new ::SSHTunnel(this, tunnel_port, config));
+    }
+
+    // A session to the same SSH server and user can forward another target without a new login.
+    tunnel_port = _manager->shareTunnel(config, credentials);
+    if (tunnel_port > 0) {
+      bec::GRTManager::get()->replace_status_text("Reusing SSH session to " + config.remoteSSHhost + ", connecting...");
+      logInfo("Opened SSH tunnel on port %d over an existing session\n", tunnel_port);
+      config.localport = tunnel_port;
+      return std::shared_ptr<sql::TunnelConnection>(new ::SSHTunnel(this, tunnel_port, config));
     } else {
       bool resetPassword = false;
 
@@ -22,6 +22,7 @@
  */
 
 #include "base/threading.h"
+#include "base/task_scheduler.h"
 #include "base/log.h"
 
 #include "grt_dispatcher.h"
@@ -335,7 +336,9 @@ GRTDispatcher::GRTDispatcher(bool threaded, bool is_main_dispatcher)
     _w_runing(0),
     _is_main_dispatcher(is_main_dispatcher),
     _shut_down(false),
-    _started(false) {
+    _started(false),
+    _pooled(false),
+    _draining(0) {
   _shutdown_callback = false;
 
   if (threaded) {
@@ -377,14 +380,19 @@ void GRTDispatcher::start() {
 
   _shut_down = false;
   if (!_threading_disabled) {
-    logDebug("starting worker thread\n");
-
-    GrtDispatcherHelper *helper = new GrtDispatcherHelper(shared_from_this());
-    _thread = base::create_thread(worker_thread, helper);
-    if (_thread == 0) {
-      logError("base::create_thread failed to create the GRT worker thread. Falling back into non-threaded mode.\n");
-      _threading_disabled = true;
-    }
+    // The main dispatcher keeps a thread of its own, the GRT and Python state belong to it. The others, one per
+    // editor or threaded task, are mostly idle and run their tasks on the shared task scheduler.
+    if (_is_main_dispatcher) {
+      logDebug("starting worker thread\n");
+
+      GrtDispatcherHelper *helper = new GrtDispatcherHelper(shared_from_this());
+      _thread = base::create_thread(worker_thread, helper);
+      if (_thread == 0) {
+        logError("base::create_thread failed to create the GRT worker thread. Falling back into non-threaded mode.\n");
+        _threading_disabled = true;
+      }
+    } else
+      _pooled = true;
   }
 
   _grtm.lock()->add_dispatcher(shared_from_this());
@@ -410,7 +418,7 @@ void GRTDispatcher::shutdown() {
   _shutdown_callback = true;
 
   // _thread == 0, means that init was not called, but threading_disabled was set to false.
-  if (!_threading_disabled && _thread != 0) {
+  if (!_threading_disabled && (_thread != 0 || _pooled)) {
     std::shared_ptr<GrtNullTask> task(new GrtNullTask(shared_from_this()));
     add_task(task);
     logDebug2("Main thread waiting for background thread to finish\n");
@@ -468,61 +476,109 @@ gpointer GRTDispatcher::worker_thread(gpointer data) {
     delete helper;
 #endif
 
-    g_atomic_int_inc(&self->_busy);
-    logDebug3("Running task \"%s\"\n", task->name().c_str());
-
-    if (dynamic_cast<GrtNullTask *>(task.get()) != 0) { // a NULL task terminates the thread
-      logDebug3("Null task found. Terminating worker thread...\n");
-      task->finished(grt::ValueRef());
-      g_atomic_int_dec_and_test(&self->_busy);
+    if (!self->run_queued_task(task))
       break;
-    }
+  }
 
-    if (task->is_cancelled()) {
-      logDebug3("Task \"%s\" cancelled\n", task->name().c_str());
-      g_atomic_int_dec_and_test(&self->_busy);
-      continue;
-    }
+  self->worker_thread_release();
 
-    int count = grt::GRT::get()->message_handler_count();
+  g_async_queue_unref(task_queue);
+  g_async_queue_unref(callback_queue);
 
-    // do pre-execution preparations
-    self->prepare_task(task);
+  self->_w_runing.post();
 
-    // execute the task
-    self->execute_task(task);
+  logDebug("worker thread exiting...\n");
 
-    logDebug3("Task \"%s\" finished\n", task->name().c_str());
-    if (task->get_error()) {
-      logError("%s\n",
-               std::string(("worker: task '" + task->name() + "' has failed with error:.") + task->get_error()->what())
-                 .c_str());
-      g_atomic_int_dec_and_test(&self->_busy);
-      continue;
-    }
+  return NULL;
+}
 
-    if (count != grt::GRT::get()->message_handler_count()) {
-      logError("INTERNAL ERROR: Message handler count mismatch after executing task '%s' (%i vs %i)",
-               task->name().c_str(), count, grt::GRT::get()->message_handler_count());
-    }
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Runs a task taken from the queue. Returns false for the null task, which ends the worker thread or drain.
+ */
+bool GRTDispatcher::run_queued_task(const GRTTaskBase::Ref task) {
+  g_atomic_int_inc(&_busy);
+  logDebug3("Running task \"%s\"\n", task->name().c_str());
 
-    g_atomic_int_dec_and_test(&self->_busy);
+  if (dynamic_cast<GrtNullTask *>(task.get()) != 0) { // a NULL task terminates the thread
+    logDebug3("Null task found. Terminating worker thread...\n");
+    task->finished(grt::ValueRef());
+    g_atomic_int_dec_and_test(&_busy);
+    return false;
   }
 
-  self->worker_thread_release();
+  if (task->is_cancelled()) {
+    logDebug3("Task \"%s\" cancelled\n", task->name().c_str());
+    g_atomic_int_dec_and_test(&_busy);
+    return true;
+  }
 
-  g_async_queue_unref(task_queue);
-  g_async_queue_unref(callback_queue);
+  int count = grt::GRT::get()->message_handler_count();
 
-  self->_w_runing.post();
+  // do pre-execution preparations
+  prepare_task(task);
 
-  logDebug("worker thread exiting...\n");
+  // execute the task
+  execute_task(task);
 
-  return NULL;
+  logDebug3("Task \"%s\" finished\n", task->name().c_str());
+  if (task->get_error()) {
+    logError("%s\n",
+             std::string(("worker: task '" + task->name() + "' has failed with error:.") + task->get_error()->what())
+               .c_str());
+    g_atomic_int_dec_and_test(&_busy);
+    return true;
+  }
+
+  if (count != grt::GRT::get()->message_handler_count()) {
+    logError("INTERNAL ERROR: Message handler count mismatch after executing task '%s' (%i vs %i)",
+             task->name().c_str(), count, grt::GRT::get()->message_handler_count());
+  }
+
+  g_atomic_int_dec_and_test(&_busy);
+  return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Runs the queued tasks of a pooled dispatcher on a task scheduler worker, one after the other as the worker
+ * thread would. Only one drain runs at a time. The pool threads live as long as the process, so unlike the
+ * worker thread no driver cleanup is done at the end.
+ */
+void GRTDispatcher::drain_queue() {
+  // Tasks wait for the server or the main thread, let the scheduler start another worker meanwhile.
+  base::TaskScheduler::BlockingScope blocking;
+
+  bool terminated = false;
+  while (!terminated) {
+    _thread = g_thread_self();
+    while (true) {
+      GRTTaskHelper *helper = static_cast<GRTTaskHelper *>(g_async_queue_try_pop(_task_queue));
+      if (helper == NULL)
+        break;
+      GRTTaskBase::Ref task = helper->task;
+      delete helper;
+
+      if (!run_queued_task(task)) {
+        terminated = true;
+        break;
+      }
+    }
+    _thread = 0;
+
+    // A task added after the last pop but before the flag is cleared found a drain running and didn't post one.
+    g_atomic_int_set(&_draining, 0);
+    if (terminated || g_async_queue_length(_task_queue) <= 0 || !g_atomic_int_compare_and_exchange(&_draining, 0, 1))
+      break;
+  }
+
+  if (terminated)
+    _w_runing.post();
+}
+//--------------------------------------------------------------------------------------------------
+
 void GRTDispatcher::execute_now(const GRTTaskBase::Ref task) {
   g_atomic_int_inc(&_busy);
   prepare_task(task);
@@ -542,6 +598,11 @@ void GRTDispatcher::add_task(const GRTTaskBase::Ref task) {
   else {
     GRTTaskHelper *helper = new GRTTaskHelper(task);
     g_async_queue_push(_task_queue, helper);
+
+    if (_pooled && g_atomic_int_compare_and_exchange(&_draining, 0, 1)) {
+      GRTDispatcher::Ref self = shared_from_this();
+      base::TaskScheduler::get()->post(base::TaskBackground, [self]() { self->drain_queue(); });
+    }
   }
 }
 
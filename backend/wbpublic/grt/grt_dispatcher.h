@@ -309,7 +309,10 @@ namespace bec {
     bool _started;
 
     GAsyncQueue *_callback_queue;
-    GThread *_thread;
+    GThread *_thread; // For pooled dispatchers the worker draining the queue, if any.
+
+    bool _pooled;                       // Tasks run on the task scheduler instead of an own thread.
+    volatile base::refcount_t _draining; // Set while a drain of the task queue is posted or running.
 
     static gpointer worker_thread(gpointer data);
 
@@ -324,6 +327,9 @@ namespace bec {
     void worker_thread_release();
     void worker_thread_iteration();
 
+    bool run_queued_task(const GRTTaskBase::Ref task);
+    void drain_queue();
+
     void restore_callbacks(const GRTTaskBase::Ref task);
 
     bool message_callback(const grt::Message &msg, void *sender);
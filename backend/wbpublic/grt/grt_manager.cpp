@@ -47,6 +47,8 @@ using namespace base;
 
 DEFAULT_LOG_DOMAIN("GRTManager");
 
+#define PYTHON_MODULE_CACHE "python_modules.cache"
+
 static GThread *main_thread = nullptr;
 
 static void init_all() {
@@ -667,6 +669,11 @@ void GRTManager::scan_modules_grt(const std::list<std::string> &extensions, bool
   int c, count = 0;
   gchar **paths = g_strsplit(_module_pathlist.c_str(), G_SEARCHPATH_SEPARATOR_S, 0);
 
+  // Python modules that didn't change since the last scan are registered without importing them.
+  PythonModuleLoader *python_loader = dynamic_cast<PythonModuleLoader *>(_grt->get_module_loader(LanguagePython));
+  if (python_loader && !_user_datadir.empty())
+    python_loader->set_module_cache_path(base::makePath(_user_datadir, PYTHON_MODULE_CACHE));
+
   for (int i = 0; paths[i]; i++) {
     c = do_scan_modules(paths[i], extensions, refresh);
     if (c >= 0)
@@ -674,6 +681,8 @@ void GRTManager::scan_modules_grt(const std::list<std::string> &extensions, bool
   }
 
   _grt->end_loading_modules();
+  if (python_loader)
+    python_loader->save_module_cache();
 
   _shell->writef(_("Registered %i modules (from %i files).\n"), _grt->get_modules().size(), count);
 
@@ -22,9 +22,15 @@
  */
 
 #include "grt_string_list_model.h"
-#include <pcre.h>
 #include "grtpp_util.h"
 
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+// Lists shorter than this per thread are filtered in the calling thread only.
+#define PARALLEL_MASK_MIN_ITEMS 10000
+
 using namespace bec;
 
 GrtStringListModel::GrtStringListModel()
@@ -141,51 +147,42 @@ void GrtStringListModel::copy_items_to_val_masks_list(std::vector<size_t> &item_
 }
 
 std::vector<std::string> GrtStringListModel::items() const {
-  // init visibility map
-  std::vector<bool> items;
-  items.reserve(_items.size());
-  std::fill_n(std::back_inserter(items), _items.size(), true);
-
-  // iterate all masks
-  if (_items_val_masks) {
-    std::vector<std::string> masks = _items_val_masks->items();
-    for (std::vector<std::string>::iterator i = masks.begin(); i != masks.end(); ++i)
-      process_mask(*i, items, false);
-  }
+  std::vector<char> items;
+  active_items(items);
 
   // determine active items
   std::vector<std::string> res;
   res.reserve(items.size());
   size_t n = 0;
-  for (std::vector<bool>::const_iterator i = items.begin(); i != items.end(); ++i, ++n)
+  for (std::vector<char>::const_iterator i = items.begin(); i != items.end(); ++i, ++n)
     if (*i)
       res.push_back(_items[n].val);
   return res;
 }
 
 GrtStringListModel::Items_ids GrtStringListModel::items_ids() const {
-  // init visibility map
-  std::vector<bool> items;
-  items.reserve(_items.size());
-  std::fill_n(std::back_inserter(items), _items.size(), true);
-
-  // iterate all masks
-  if (_items_val_masks) {
-    std::vector<std::string> masks = _items_val_masks->items();
-    for (std::vector<std::string>::iterator i = masks.begin(); i != masks.end(); ++i)
-      process_mask(*i, items, false);
-  }
+  std::vector<char> items;
+  active_items(items);
 
   // determine active items
   std::vector<size_t> res;
   res.reserve(items.size());
   size_t n = 0;
-  for (std::vector<bool>::const_iterator i = items.begin(); i != items.end(); ++i, ++n)
+  for (std::vector<char>::const_iterator i = items.begin(); i != items.end(); ++i, ++n)
     if (*i)
       res.push_back(_items[n].iid);
   return res;
 }
 
+// Inits the visibility map with the items not excluded by any of the masks.
+void GrtStringListModel::active_items(std::vector<char> &items) const {
+  items.assign(_items.size(), true);
+
+  // iterate all masks
+  if (_items_val_masks)
+    process_masks(_items_val_masks->items(), items, false);
+}
+
 void GrtStringListModel::refresh() {
   if (!_invalidated)
     return;
@@ -201,30 +198,21 @@ void GrtStringListModel::refresh() {
     return;
   }
 
-  // init visibility map
-  std::vector<bool> items;
-  items.reserve(_items.size());
-  std::fill_n(std::back_inserter(items), _items.size(), true);
-
-  // iterate all masks
-  if (_items_val_masks) {
-    std::vector<std::string> masks = _items_val_masks->items();
-    for (std::vector<std::string>::iterator i = masks.begin(); i != masks.end(); ++i)
-      process_mask(*i, items, false);
-  }
+  std::vector<char> items;
+  active_items(items);
 
-  _active_items_count = std::count_if(items.begin(), items.end(), std::bind2nd(std::equal_to<bool>(), true));
+  _active_items_count = std::count(items.begin(), items.end(), true);
 
   // also process preview mask
   if (!_items_val_mask.empty())
-    process_mask(_items_val_mask, items, true);
+    process_masks(std::vector<std::string>(1, _items_val_mask), items, true);
 
   // set final items visibility
   {
     _visible_items.clear();
     _visible_items.reserve(_items.size());
     size_t n = 0;
-    for (std::vector<bool>::const_iterator i = items.begin(); i != items.end(); ++i, ++n)
+    for (std::vector<char>::const_iterator i = items.begin(); i != items.end(); ++i, ++n)
       if (*i)
         _visible_items.push_back(n);
   }
@@ -232,66 +220,135 @@ void GrtStringListModel::refresh() {
   _invalidated = false;
 }
 
-void GrtStringListModel::process_mask(const std::string &mask, std::vector<bool> &items,
-                                      bool match_means_visible) const {
+//----------------------------------------------------------------------------------------------------------------------
+
+GrtStringListModel::MaskMatcher::MaskMatcher(const std::vector<std::string> &masks) : _longest_literal(0) {
   //! static const char *ANY_SYM= "(?:\\pL(?:" UNICODE_CHAR_PCRE ")?)";
   //! static const char *ANY_SEQ= "(?:\\pL(?:" UNICODE_CHAR_PCRE ")*)";
   static const char *ANY_SYM = ".?";
   static const char *ANY_SEQ = ".*";
-
-  // build regexp string
-  std::string regexp;
-  {
-    static const std::string meta_symbols = "~!@#$%^&*()-+=:;`\'\"|,.<>{}[]?/";
-    bool term_state = false;
-    regexp.reserve(mask.size());
-    for (std::string::const_iterator i = mask.begin(); i != mask.end(); ++i) {
-      if (term_state) {
-        term_state = false;
-        regexp.push_back(*i);
-      } else if ('\\' == *i) {
-        term_state = true;
-        regexp.push_back(*i);
-      } else if ('?' == *i)
-        regexp.append(ANY_SYM);
-      else if ('*' == *i)
-        regexp.append(ANY_SEQ);
-      else {
-        if (std::find(meta_symbols.begin(), meta_symbols.end(), *i) != meta_symbols.end())
-          regexp.push_back('\\');
-        regexp.push_back(*i);
+  static const std::string meta_symbols = "~!@#$%^&*()-+=:;`\'\"|,.<>{}[]?/";
+
+  for (std::vector<std::string>::const_iterator mask = masks.begin(); mask != masks.end(); ++mask) {
+    // build regexp string, and the plain text if the mask has no wildcards
+    std::string regexp;
+    std::string literal;
+    bool is_literal = true;
+    {
+      bool term_state = false;
+      regexp.reserve(mask->size());
+      for (std::string::const_iterator i = mask->begin(); i != mask->end(); ++i) {
+        if (term_state) {
+          term_state = false;
+          regexp.push_back(*i);
+          literal.push_back(*i);
+          // an escaped letter or digit is a regexp class, not the character itself
+          if (isalnum((unsigned char)*i))
+            is_literal = false;
+        } else if ('\\' == *i) {
+          term_state = true;
+          regexp.push_back(*i);
+        } else if ('?' == *i) {
+          regexp.append(ANY_SYM);
+          is_literal = false;
+        } else if ('*' == *i) {
+          regexp.append(ANY_SEQ);
+          is_literal = false;
+        } else {
+          if (std::find(meta_symbols.begin(), meta_symbols.end(), *i) != meta_symbols.end())
+            regexp.push_back('\\');
+          regexp.push_back(*i);
+          literal.push_back(*i);
+        }
       }
+      if (term_state)
+        is_literal = false;
     }
-  }
 
-  // compile regexp
-  pcre *patre;
-  {
+    if (is_literal && !literal.empty()) {
+      _literals.insert(literal);
+      _longest_literal = std::max(_longest_literal, literal.size());
+      continue;
+    }
+
+    // compile regexp
     const char *error;
     int erroffset;
-    patre = pcre_compile(regexp.c_str(), PCRE_UTF8 | PCRE_EXTRA, &error, &erroffset, NULL);
+    pcre *patre = pcre_compile(regexp.c_str(), PCRE_UTF8 | PCRE_EXTRA, &error, &erroffset, NULL);
     if (!patre)
       throw std::logic_error("error compiling regex " + std::string(error));
+    _patterns.push_back(std::make_pair(patre, pcre_study(patre, 0, &error)));
   }
+}
 
-  // sift items
-  size_t n = 0;
-  for (std::vector<bool>::iterator i = items.begin(); i != items.end(); ++i, ++n) {
-    if (*i) {
-      const Item_handler &item = _items[n];
-      int patres[2];
-
-      int substr_count = pcre_exec(patre, NULL, item.val.c_str(), static_cast<int>(item.val.size()), 0, 0, patres,
-                                   sizeof(patres) / sizeof(int));
-
-      if (substr_count > 0 && patres[1] == (int)item.val.size())
-        *i = match_means_visible;
-      else
-        *i = !match_means_visible;
+GrtStringListModel::MaskMatcher::~MaskMatcher() {
+  for (std::vector<std::pair<pcre *, pcre_extra *> >::iterator i = _patterns.begin(); i != _patterns.end(); ++i) {
+    if (i->second)
+      pcre_free(i->second);
+    pcre_free(i->first);
+  }
+}
+
+/**
+ * A mask matches when its first match in the value extends to the end of the value. For plain text masks that is a
+ * suffix of the value not found earlier in it, so those are looked up by the suffixes of the value instead of being
+ * tried one by one.
+ */
+bool GrtStringListModel::MaskMatcher::matches(const std::string &value) const {
+  if (!_literals.empty()) {
+    size_t longest = std::min(_longest_literal, value.size());
+    for (size_t length = 1; length <= longest; ++length) {
+      if (_literals.find(value.substr(value.size() - length)) != _literals.end() &&
+          value.find(value.c_str() + value.size() - length, 0, length) == value.size() - length)
+        return true;
     }
   }
 
-  pcre_free(patre);
+  for (std::vector<std::pair<pcre *, pcre_extra *> >::const_iterator i = _patterns.begin(); i != _patterns.end();
+       ++i) {
+    int patres[2];
+    int substr_count = pcre_exec(i->first, i->second, value.c_str(), static_cast<int>(value.size()), 0, 0, patres,
+                                 sizeof(patres) / sizeof(int));
+    if (substr_count > 0 && patres[1] == (int)value.size())
+      return true;
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void GrtStringListModel::process_masks(const std::vector<std::string> &masks, std::vector<char> &items,
+                                       bool match_means_visible) const {
+  if (masks.empty()) {
+    // no mask matches anything
+    if (match_means_visible)
+      std::fill(items.begin(), items.end(), false);
+    return;
+  }
+
+  MaskMatcher matcher(masks);
+
+  // sift items, large lists in parallel, the matcher is only read
+  std::function<void(size_t, size_t)> sift = [&](size_t begin, size_t end) {
+    for (size_t n = begin; n < end; ++n) {
+      if (items[n])
+        items[n] = matcher.matches(_items[n].val) ? match_means_visible : !match_means_visible;
+    }
+  };
+
+  size_t thread_count = std::min<size_t>(std::thread::hardware_concurrency(), items.size() / PARALLEL_MASK_MIN_ITEMS);
+  if (thread_count < 2) {
+    sift(0, items.size());
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  size_t chunk = (items.size() + thread_count - 1) / thread_count;
+  for (size_t begin = chunk; begin < items.size(); begin += chunk)
+    threads.push_back(std::thread(sift, begin, std::min(begin + chunk, items.size())));
+  sift(0, chunk);
+  for (std::vector<std::thread>::iterator t = threads.begin(); t != threads.end(); ++t)
+    t->join();
 }
 
 std::string GrtStringListModel::terminate_wildcard_symbols(const std::string &str) {
@@ -27,6 +27,9 @@
 #include "wbpublic_public_interface.h"
 #include "tree_model.h"
 
+#include <pcre.h>
+#include <unordered_set>
+
 namespace bec {
 
   class WBPUBLICBACKEND_PUBLIC_FUNC GrtStringListModel : public ListModel {
@@ -87,7 +90,25 @@ namespace bec {
 
     bool _invalidated;
 
-    void process_mask(const std::string &mask, std::vector<bool> &items, bool match_means_visible) const;
+    // All masks compiled once, to test values against the whole set of masks.
+    class MaskMatcher {
+    public:
+      MaskMatcher(const std::vector<std::string> &masks);
+      ~MaskMatcher();
+      bool matches(const std::string &value) const;
+
+    private:
+      std::unordered_set<std::string> _literals; // Masks without wildcards, unescaped.
+      size_t _longest_literal;
+      std::vector<std::pair<pcre *, pcre_extra *> > _patterns;
+
+      MaskMatcher(const MaskMatcher &);
+      MaskMatcher &operator=(const MaskMatcher &);
+    };
+
+    void active_items(std::vector<char> &items) const;
+    void process_masks(const std::vector<std::string> &masks, std::vector<char> &items,
+                       bool match_means_visible) const;
     std::string terminate_wildcard_symbols(const std::string &str);
   };
 };
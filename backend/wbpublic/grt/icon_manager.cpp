@@ -27,9 +27,14 @@
 #endif
 
 #include "base/file_utilities.h"
+#include "base/log.h"
 #include "base/string_utilities.h"
+#include "base/task_scheduler.h"
 #include "icon_manager.h"
 #include "common.h"
+
+#include <list>
+#include <set>
 #ifdef __APPLE__
 #include "mforms/app.h"
 #endif
@@ -39,14 +44,24 @@
  * @brief
  */
 
+DEFAULT_LOG_DOMAIN("IconManager")
+
 using namespace bec;
 
+static float current_scale() {
+#ifdef __APPLE__
+  return mforms::App::get()->backing_scale_factor();
+#else
+  return 1;
+#endif
+}
+
 IconManager::IconManager() {
   gchar *tmp = g_get_current_dir();
   _basedir = tmp;
   g_free(tmp);
 
-  _next_id = 1;
+  _icon_files.push_back("");
   /* do not hardcode stuff
     add_search_path(".");
     add_search_path("./images");
@@ -57,6 +72,7 @@ IconManager::IconManager() {
 }
 
 void IconManager::set_basedir(const std::string &basedir) {
+  base::MutexLock lock(_mutex);
   _basedir = basedir;
 }
 
@@ -109,6 +125,11 @@ static std::string get_icon_file_for_size(const std::string &aicon_file, IconSiz
 }
 
 std::string IconManager::get_icon_path(const std::string &file) {
+  base::MutexLock lock(_mutex);
+  return find_icon_path(file, current_scale());
+}
+
+std::string IconManager::find_icon_path(const std::string &file, float scale) {
   std::unordered_map<std::string, std::string>::const_iterator it = _icon_paths.find(file);
   if (it != _icon_paths.end())
     return it->second;
@@ -119,7 +140,7 @@ std::string IconManager::get_icon_path(const std::string &file) {
 #ifdef __APPLE__
     std::string mac_path;
 
-    if (mforms::App::get()->backing_scale_factor() > 1) {
+    if (scale > 1) {
       mac_path = base::strip_extension(path) + "_mac@2x.png";
       if (g_file_test(mac_path.c_str(), G_FILE_TEST_EXISTS)) {
         _icon_paths[file] = mac_path;
@@ -150,16 +171,22 @@ std::string IconManager::get_icon_path(const std::string &file) {
   return "";
 }
 
+IconId IconManager::register_icon(const std::string &file) {
+  std::unordered_map<std::string, IconId>::const_iterator it = _icon_ids.find(file);
+  if (it != _icon_ids.end())
+    return it->second;
+
+  IconId id = (IconId)_icon_files.size();
+  _icon_files.push_back(file);
+  _icon_ids[file] = id;
+  return id;
+}
+
 IconId IconManager::get_icon_id(const std::string &icon_file, IconSize size, const std::string &extra_qualifier) {
-  std::map<std::string, IconId>::iterator it;
   std::string file = get_icon_file_for_size(icon_file, size, extra_qualifier);
 
-  if ((it = _icon_ids.find(file)) != _icon_ids.end()) {
-    return it->second;
-  }
-  _icon_files[_next_id] = file;
-  _icon_ids[file] = _next_id;
-  return _next_id++;
+  base::MutexLock lock(_mutex);
+  return register_icon(file);
 }
 
 IconId IconManager::get_icon_id(const grt::ObjectRef &object, IconSize size, const std::string &extra_qualifier) {
@@ -169,7 +196,9 @@ IconId IconManager::get_icon_id(const grt::ObjectRef &object, IconSize size, con
 IconId IconManager::get_icon_id(grt::MetaClass *metaclass, IconSize size, const std::string &extra_qualifier) {
   grt::MetaClass *parent, *gstruct;
   std::string file, path;
+  float scale = current_scale();
 
+  base::MutexLock lock(_mutex);
   parent = metaclass;
 
   do {
@@ -181,22 +210,17 @@ IconId IconManager::get_icon_id(grt::MetaClass *metaclass, IconSize size, const
 
     file = get_icon_file_for_size(file, size, extra_qualifier);
 
-    path = get_icon_path(file);
+    path = find_icon_path(file, scale);
 
     parent = gstruct->parent();
   } while (path.empty() && parent);
 
-  std::map<std::string, IconId>::iterator it;
-  if ((it = _icon_ids.find(file)) != _icon_ids.end()) {
-    return it->second;
-  }
-  _icon_files[_next_id] = file;
-  _icon_ids[file] = _next_id;
-  return _next_id++;
+  return register_icon(file);
 }
 
 std::string IconManager::get_icon_file(IconId icon) {
-  if (icon == 0)
+  base::MutexLock lock(_mutex);
+  if (icon <= 0 || (size_t)icon >= _icon_files.size())
     return "";
 
   return _icon_files[icon];
@@ -219,7 +243,50 @@ void IconManager::add_search_path(const std::string &path) {
   npath = path;
 #endif
 
+  base::MutexLock lock(_mutex);
   if (std::find(_search_path.begin(), _search_path.end(), npath) == _search_path.end() &&
       g_file_test((_basedir + G_DIR_SEPARATOR + npath).c_str(), G_FILE_TEST_IS_DIR))
     _search_path.push_back(npath);
 }
+
+void IconManager::preload_icons(IconSize size, const PreloadHandler &handler) {
+  std::string pattern = "*" + get_icon_file_for_size("$.png", size, "");
+  std::vector<std::string> directories;
+  {
+    base::MutexLock lock(_mutex);
+    for (std::vector<std::string>::const_iterator i = _search_path.begin(); i != _search_path.end(); ++i)
+      directories.push_back(_basedir + G_DIR_SEPARATOR + *i);
+  }
+  float scale = current_scale();
+
+  base::TaskScheduler::get()->post(base::TaskBulk, [this, directories, pattern, scale, handler]() {
+    std::vector<std::string> paths;
+    std::set<std::string> files;
+    for (std::vector<std::string>::const_iterator directory = directories.begin(); directory != directories.end();
+         ++directory) {
+      std::list<std::string> matches;
+      try {
+        matches = base::scan_for_files_matching(base::makePath(*directory, pattern));
+      } catch (std::exception &exc) {
+        logWarning("Could not look for icons to preload: %s\n", exc.what());
+      }
+
+      // The platform variants (_mac, @2x) end differently and are picked by the path lookup.
+      for (std::list<std::string>::const_iterator match = matches.begin(); match != matches.end(); ++match) {
+        std::string file = base::basename(*match);
+        if (!files.insert(file).second)
+          continue;
+
+        std::string path;
+        {
+          base::MutexLock lock(_mutex);
+          path = find_icon_path(file, scale);
+        }
+        if (!path.empty())
+          paths.push_back(path);
+      }
+    }
+    logDebug2("Preloading %i icons\n", (int)paths.size());
+    handler(paths);
+  });
+}
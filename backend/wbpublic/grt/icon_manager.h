@@ -26,6 +26,8 @@
 #include "grt.h"
 
 #include "wbpublic_public_interface.h"
+#include "base/threading.h"
+#include <functional>
 #include <unordered_map>
 
 namespace bec {
@@ -35,17 +37,22 @@ namespace bec {
 
   class WBPUBLICBACKEND_PUBLIC_FUNC IconManager {
     std::string _basedir;
-    std::map<std::string, IconId> _icon_ids;
-    std::map<IconId, std::string> _icon_files;
+    std::unordered_map<std::string, IconId> _icon_ids;
+    std::vector<std::string> _icon_files; // Indexed by IconId, 0 stands for no icon.
     std::vector<std::string> _search_path;
 
     std::unordered_map<std::string, std::string> _icon_paths;
-
-    IconId _next_id;
+    base::Mutex _mutex; // Icon paths are also resolved by the preloading worker.
 
     IconManager();
 
+    IconId register_icon(const std::string &file);
+    std::string find_icon_path(const std::string &file, float scale);
+
   public:
+    // Gets the paths of the icon files to decode ahead. Called on a worker thread.
+    typedef std::function<void(const std::vector<std::string> &paths)> PreloadHandler;
+
     static IconManager *get_instance();
 
     std::string get_icon_path(const std::string &file);
@@ -61,5 +68,9 @@ namespace bec {
     void set_basedir(const std::string &basedir);
 
     void add_search_path(const std::string &path);
+
+    // Looks up all icons of the given size in the search path, for the current scale factor, on a worker thread
+    // and passes their paths to the handler, which decodes them into the image cache of the platform.
+    void preload_icons(IconSize size, const PreloadHandler &handler);
   };
 };
@@ -35,6 +35,10 @@
 #ifndef _INCREMENTAL_LIST_UPDATER_H_
 #define _INCREMENTAL_LIST_UPDATER_H_
 
+#include <map>
+#include <string>
+#include <unordered_map>
+
 namespace bec {
 
   template <class DestIterator, class DestRef, class SourceIterator>
@@ -58,6 +62,16 @@ namespace bec {
 
     virtual bool items_match(dest_iterator diter, source_iterator siter) = 0;
 
+    //! Optional key of an item, the same for matching dest and source items (e.g. an object id). When all dest
+    //! items have one, matches are found with a hash lookup instead of comparing every source item with every
+    //! dest item, which matters for lists with thousands of items.
+    virtual std::string dest_key(dest_iterator iter) {
+      return "";
+    }
+    virtual std::string source_key(source_iterator iter) {
+      return "";
+    }
+
     virtual dest_ref get_dest(dest_iterator iter) = 0;
 
     virtual void update(dest_ref dest_item, source_iterator source_item) = 0;
@@ -70,10 +84,28 @@ namespace bec {
     virtual void end_adding(dest_iterator iter) = 0;
 
     virtual void execute() {
+      std::unordered_map<std::string, dest_iterator> dest_keys;
+      bool keyed = true;
+      for (dest_iterator item = get_dest_iterator(); keyed && has_more_dest(item); increment_dest(item)) {
+        std::string key = dest_key(item);
+        if (key.empty())
+          keyed = false;
+        else
+          dest_keys.emplace(key, item);
+      }
+
       // find location of items in the source list in the dest list
       for (source_iterator src_item = get_source_iterator(); has_more_source(src_item); increment_source(src_item)) {
         //        bool found= false;
 
+        if (keyed) {
+          typename std::unordered_map<std::string, dest_iterator>::iterator match =
+            dest_keys.find(source_key(src_item));
+          if (match != dest_keys.end() && items_match(match->second, src_item))
+            source_mapping[src_item] = get_dest(match->second);
+          continue;
+        }
+
         for (dest_iterator item = get_dest_iterator(); has_more_dest(item); increment_dest(item)) {
           if (items_match(item, src_item)) {
             source_mapping[src_item] = get_dest(item);
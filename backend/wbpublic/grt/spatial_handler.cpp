@@ -23,9 +23,24 @@
 
 #include "spatial_handler.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 #include "base/log.h"
+#include "base/task_scheduler.h"
+
+#define SPATIAL_INDEX_NODE_SIZE 16 // entries per R-tree node
+#define SPATIAL_CLIP_MARGIN 6      // pixels painted outside of a feature envelope
+#define SPATIAL_PARALLEL_CHUNK 64  // features parsed or reprojected by a thread at a time
+
+// Zoomed out features are painted from simplified copies, a pyramid of levels that each allow a larger error.
+#define SPATIAL_SIMPLIFY_LEVELS 4
+#define SPATIAL_SIMPLIFY_TOLERANCE 0.01 // degrees, finest level
+#define SPATIAL_SIMPLIFY_STEP 4         // tolerance factor between levels
+#define SPATIAL_SIMPLIFY_MIN_POINTS 256 // smaller features are always painted in full
+#define SPATIAL_SIMPLIFY_MAX_ERROR 0.5  // pixels
 
 DEFAULT_LOG_DOMAIN("spatial");
 
@@ -119,7 +134,7 @@ spatial::Envelope::Envelope(double left, double top, double right, double bottom
   bottom_right.y = 90;
 }
 
-bool spatial::Envelope::is_init() {
+bool spatial::Envelope::is_init() const {
   return (top_left.x != 180 && top_left.y != -90 && bottom_right.x != -180 && bottom_right.y != 90);
 }
 
@@ -127,6 +142,12 @@ bool spatial::Envelope::within(const base::Point &p) const {
   return (top_left.x <= p.x && top_left.y <= p.y && bottom_right.x >= p.x && bottom_right.y >= p.y);
 }
 
+// Like within(), for envelopes in screen coordinates.
+bool spatial::Envelope::intersects(const Envelope &other) const {
+  return (top_left.x <= other.bottom_right.x && top_left.y <= other.bottom_right.y &&
+          bottom_right.x >= other.top_left.x && bottom_right.y >= other.top_left.y);
+}
+
 double spatial::ShapeContainer::distance(const base::Point &p) const {
   switch (type) {
     case ShapePoint:
@@ -460,9 +481,208 @@ void spatial::Importer::extract_points(OGRGeometry *shape, std::deque<ShapeConta
   }
 }
 
-void spatial::Importer::get_points(std::deque<ShapeContainer> &shapes_container) {
-  if (_geometry)
-    extract_points(_geometry, shapes_container);
+namespace {
+  // WKB reader for decode_mysql_geometry(), every geometry in the data starts with its own byte order.
+  class WKBReader {
+  public:
+    WKBReader(const unsigned char *data, size_t size) : _data(data), _end(data + size), _little_endian(true) {
+    }
+
+    bool read_geometry(std::deque<spatial::ShapeContainer> &shapes, int depth) {
+      if (_data == _end || depth > 32)
+        return false;
+      _little_endian = *_data++ == 1;
+
+      uint32_t type, count;
+      if (!read_uint32(type))
+        return false;
+      switch (type) {
+        case wkbPoint: {
+          spatial::ShapeContainer shape;
+          shape.type = spatial::ShapePoint;
+          shape.points.resize(1);
+          if (!read_double(shape.points[0].x) || !read_double(shape.points[0].y))
+            return false;
+          shape.bounding_box.top_left = shape.bounding_box.bottom_right = shape.points[0];
+          shapes.push_back(shape);
+          return true;
+        }
+
+        case wkbLineString:
+          return read_points(shapes, spatial::ShapeLineString);
+
+        case wkbPolygon:
+          if (!read_uint32(count) || count == 0)
+            return false;
+          // Like in Importer the exterior ring is the polygon, the holes follow as plain rings.
+          for (uint32_t i = 0; i < count; ++i) {
+            if (!read_points(shapes, i == 0 ? spatial::ShapePolygon : spatial::ShapeLinearRing))
+              return false;
+          }
+          return true;
+
+        case wkbMultiPoint:
+        case wkbMultiLineString:
+        case wkbMultiPolygon:
+        case wkbGeometryCollection:
+          if (!read_uint32(count))
+            return false;
+          for (uint32_t i = 0; i < count; ++i) {
+            if (!read_geometry(shapes, depth + 1))
+              return false;
+          }
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+  private:
+    const unsigned char *_data;
+    const unsigned char *_end;
+    bool _little_endian;
+
+    bool read_bytes(uint64_t &value, size_t size) {
+      if ((size_t)(_end - _data) < size)
+        return false;
+      value = 0;
+      for (size_t i = 0; i < size; ++i)
+        value |= (uint64_t)_data[_little_endian ? i : size - 1 - i] << (8 * i);
+      _data += size;
+      return true;
+    }
+
+    bool read_uint32(uint32_t &value) {
+      uint64_t tmp;
+      if (!read_bytes(tmp, 4))
+        return false;
+      value = (uint32_t)tmp;
+      return true;
+    }
+
+    bool read_double(double &value) {
+      uint64_t tmp;
+      if (!read_bytes(tmp, 8))
+        return false;
+      memcpy(&value, &tmp, sizeof(value));
+      return true;
+    }
+
+    // The points are stored last to first, as Importer::extract_points() does.
+    bool read_points(std::deque<spatial::ShapeContainer> &shapes, spatial::ShapeType type) {
+      uint32_t count;
+      if (!read_uint32(count) || count == 0 || count > (size_t)(_end - _data) / 16)
+        return false;
+
+      spatial::ShapeContainer shape;
+      shape.type = type;
+      shape.points.resize(count);
+      for (uint32_t i = count; i > 0; --i) {
+        base::Point &point = shape.points[i - 1];
+        read_double(point.x);
+        read_double(point.y);
+        if (i == count) {
+          shape.bounding_box.top_left = shape.bounding_box.bottom_right = point;
+          continue;
+        }
+        shape.bounding_box.top_left.x = std::min(shape.bounding_box.top_left.x, point.x);
+        shape.bounding_box.top_left.y = std::max(shape.bounding_box.top_left.y, point.y);
+        shape.bounding_box.bottom_right.x = std::max(shape.bounding_box.bottom_right.x, point.x);
+        shape.bounding_box.bottom_right.y = std::min(shape.bounding_box.bottom_right.y, point.y);
+      }
+      shapes.push_back(shape);
+      return true;
+    }
+  };
+}
+
+bool spatial::decode_mysql_geometry(const std::string &data, std::deque<ShapeContainer> &shapes, Envelope &envelope) {
+  if (data.size() <= 4)
+    return false;
+
+  std::deque<ShapeContainer> decoded;
+  WKBReader reader((const unsigned char *)data.data() + 4, data.size() - 4);
+  if (!reader.read_geometry(decoded, 0) || decoded.empty())
+    return false;
+
+  envelope = decoded.front().bounding_box;
+  for (std::deque<ShapeContainer>::const_iterator it = decoded.begin() + 1; it != decoded.end(); ++it) {
+    envelope.top_left.x = std::min(envelope.top_left.x, it->bounding_box.top_left.x);
+    envelope.top_left.y = std::max(envelope.top_left.y, it->bounding_box.top_left.y);
+    envelope.bottom_right.x = std::max(envelope.bottom_right.x, it->bounding_box.bottom_right.x);
+    envelope.bottom_right.y = std::min(envelope.bottom_right.y, it->bounding_box.bottom_right.y);
+  }
+  shapes.insert(shapes.end(), decoded.begin(), decoded.end());
+  return true;
+}
+
+// Douglas-Peucker, for GDAL builds without GEOS. Unlike SimplifyPreserveTopology rings may cross each other after it,
+// but only by less than the tolerance.
+static void simplify_points(std::vector<base::Point> &points, double tolerance) {
+  if (points.size() < 3)
+    return;
+
+  std::vector<bool> keep(points.size(), false);
+  keep.front() = keep.back() = true;
+
+  std::vector<std::pair<size_t, size_t> > pending(1, std::make_pair((size_t)0, points.size() - 1));
+  while (!pending.empty()) {
+    size_t first = pending.back().first, last = pending.back().second;
+    pending.pop_back();
+
+    size_t farthest = first;
+    double max_distance = tolerance;
+    for (size_t i = first + 1; i < last; ++i) {
+      double distance = distance_to_segment(points[first], points[last], points[i]);
+      if (distance > max_distance) {
+        max_distance = distance;
+        farthest = i;
+      }
+    }
+    if (farthest != first) {
+      keep[farthest] = true;
+      pending.push_back(std::make_pair(first, farthest));
+      pending.push_back(std::make_pair(farthest, last));
+    }
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < points.size(); ++i)
+    if (keep[i])
+      points[count++] = points[i];
+  points.resize(count);
+}
+
+void spatial::Importer::get_points(std::deque<ShapeContainer> &shapes_container, double tolerance) {
+  if (!_geometry)
+    return;
+
+  if (tolerance > 0 && OGRGeometryFactory::haveGEOS()) {
+    OGRGeometry *simplified = _geometry->SimplifyPreserveTopology(tolerance);
+    if (simplified != NULL) {
+      extract_points(simplified, shapes_container);
+      OGRGeometryFactory::destroyGeometry(simplified);
+      return;
+    }
+  }
+
+  size_t first = shapes_container.size();
+  extract_points(_geometry, shapes_container);
+  if (tolerance <= 0)
+    return;
+
+  for (size_t i = first; i < shapes_container.size() && !_interrupt; ++i) {
+    ShapeContainer &shape = shapes_container[i];
+    if (shape.type == ShapePoint)
+      continue;
+
+    std::vector<base::Point> points = shape.points;
+    simplify_points(points, tolerance);
+    // Rings that would collapse are kept as they are, small islands shouldn't disappear.
+    if (shape.type == ShapeLineString || points.size() >= 4)
+      shape.points.swap(points);
+  }
 }
 
 void spatial::Importer::get_envelope(spatial::Envelope &env) {
@@ -728,25 +948,24 @@ bool spatial::Converter::from_proj_to_latlon(double &lat, double &lon) {
 }
 
 void spatial::Converter::transform_points(std::deque<ShapeContainer> &shapes_container) {
+  project_points(shapes_container);
+  projected_to_screen(shapes_container);
+}
+
+void spatial::Converter::project_points(std::deque<ShapeContainer> &shapes_container,
+                                        OGRCoordinateTransformation *transformation) {
+  OGRCoordinateTransformation *geo_to_proj = transformation ? transformation : _geo_to_proj;
   std::deque<ShapeContainer>::iterator it;
   for (it = shapes_container.begin(); it != shapes_container.end() && !_interrupt; it++) {
     std::deque<size_t> for_removal;
     for (size_t i = 0; i < (*it).points.size() && !_interrupt; i++) {
-      if (!_geo_to_proj->Transform(1, &(*it).points[i].x, &(*it).points[i].y))
+      if (!geo_to_proj->Transform(1, &(*it).points[i].x, &(*it).points[i].y))
         for_removal.push_back(i);
     }
 
-    if (_geo_to_proj->Transform(1, &(*it).bounding_box.bottom_right.x, &(*it).bounding_box.bottom_right.y) &&
-        _geo_to_proj->Transform(1, &(*it).bounding_box.top_left.x, &(*it).bounding_box.top_left.y)) {
-      int x, y;
-      from_projected((*it).bounding_box.bottom_right.x, (*it).bounding_box.bottom_right.y, x, y);
-      (*it).bounding_box.bottom_right.x = x;
-      (*it).bounding_box.bottom_right.y = y;
-      from_projected((*it).bounding_box.top_left.x, (*it).bounding_box.top_left.y, x, y);
-      (*it).bounding_box.top_left.x = x;
-      (*it).bounding_box.top_left.y = y;
+    if (geo_to_proj->Transform(1, &(*it).bounding_box.bottom_right.x, &(*it).bounding_box.bottom_right.y) &&
+        geo_to_proj->Transform(1, &(*it).bounding_box.top_left.x, &(*it).bounding_box.top_left.y))
       (*it).bounding_box.converted = true;
-    }
 
     if (!for_removal.empty())
       logDebug("%i points that could not be converted were skipped\n", (int)for_removal.size());
@@ -754,16 +973,43 @@ void spatial::Converter::transform_points(std::deque<ShapeContainer> &shapes_con
     std::deque<size_t>::reverse_iterator rit;
     for (rit = for_removal.rbegin(); rit != for_removal.rend() && !_interrupt; rit++)
       (*it).points.erase((*it).points.begin() + *rit);
+  }
+}
+
+// Same as from_projected() for every point, with the projection copied once instead of locked per point.
+void spatial::Converter::projected_to_screen(std::deque<ShapeContainer> &shapes_container) {
+  double inv[6];
+  {
+    base::RecMutexLock mtx(_projection_protector);
+    std::copy(_inv_projection, _inv_projection + 6, inv);
+  }
+
+  std::deque<ShapeContainer>::iterator it;
+  for (it = shapes_container.begin(); it != shapes_container.end() && !_interrupt; it++) {
+    if ((*it).bounding_box.converted) {
+      base::Point &br = (*it).bounding_box.bottom_right, &tl = (*it).bounding_box.top_left;
+      br.x = (int)(inv[0] + inv[1] * br.x);
+      br.y = (int)(inv[3] + inv[5] * br.y);
+      tl.x = (int)(inv[0] + inv[1] * tl.x);
+      tl.y = (int)(inv[3] + inv[5] * tl.y);
+    }
 
     for (size_t i = 0; i < (*it).points.size() && !_interrupt; i++) {
-      int x, y;
-      from_projected((*it).points[i].x, (*it).points[i].y, x, y);
-      (*it).points[i].x = x;
-      (*it).points[i].y = y;
+      base::Point &p = (*it).points[i];
+      p.x = (int)(inv[0] + inv[1] * p.x);
+      p.y = (int)(inv[3] + inv[5] * p.y);
     }
   }
 }
 
+OGRCoordinateTransformation *spatial::Converter::create_transformation() {
+  base::RecMutexLock mtx(_projection_protector);
+  OGRCoordinateTransformation *transformation = OGRCreateCoordinateTransformation(_source_srs, _target_srs);
+  if (!transformation)
+    throw std::logic_error("Unable to create coordinate transformation context.");
+  return transformation;
+}
+
 void spatial::Converter::transform_envelope(spatial::Envelope &env) {
   if (!env.is_init()) {
     logError("Can't transform empty envelope.\n");
@@ -786,17 +1032,39 @@ void spatial::Converter::transform_envelope(spatial::Envelope &env) {
   }
 }
 
+double spatial::Converter::unit_size() {
+  base::RecMutexLock mtx(_projection_protector);
+  if (_view.width <= 0 || _view.height <= 0)
+    return 0;
+  return std::min(fabs(_view.MaxLat - _view.MinLat) / _view.width, fabs(_view.MaxLon - _view.MinLon) / _view.height);
+}
+
 void spatial::Converter::interrupt() {
   _interrupt = true;
 }
 
 using namespace spatial;
 
-Feature::Feature(Layer *layer, int row_id, const std::string &data, bool wkt = false) : _owner(layer), _row_id(row_id) {
+static size_t count_points(const std::deque<ShapeContainer> &shapes) {
+  size_t count = 0;
+  for (std::deque<ShapeContainer>::const_iterator it = shapes.begin(); it != shapes.end(); ++it)
+    count += it->points.size();
+  return count;
+}
+
+Feature::Feature(Layer *layer, int row_id, const std::string &data, bool wkt = false)
+  : _owner(layer), _row_id(row_id), _decoded(false), _projected_srs(NULL), _unit_size(0) {
   if (wkt)
     _geometry.import_from_wkt(data);
-  else
-    _geometry.import_from_mysql(data);
+  else {
+    // Features large enough to be simplified keep using OGR, which simplifies with GEOS when it can.
+    _decoded = decode_mysql_geometry(data, _decoded_shapes, _decoded_env) &&
+               count_points(_decoded_shapes) < SPATIAL_SIMPLIFY_MIN_POINTS;
+    if (!_decoded) {
+      _decoded_shapes.clear();
+      _geometry.import_from_mysql(data);
+    }
+  }
 }
 
 Feature::~Feature() {
@@ -804,20 +1072,76 @@ Feature::~Feature() {
 
 void Feature::get_envelope(spatial::Envelope &env, const bool &screen_coords) {
   if (!screen_coords) {
-    _geometry.get_envelope(env);
+    if (_decoded)
+      env = _decoded_env;
+    else
+      _geometry.get_envelope(env);
     return;
   }
 
   env = _env_screen;
 }
 
-void Feature::render(Converter *converter) {
-  std::deque<ShapeContainer> tmp_shapes;
-  _geometry.get_points(tmp_shapes);
-  converter->transform_points(tmp_shapes);
+/**
+ * The reprojection is only done again when the projection changed, for a new visible area only the projected
+ * coordinates are mapped to the screen again. Large features get their simplified levels at the same time.
+ */
+void Feature::render(Converter *converter, OGRCoordinateTransformation *transformation) {
+  if (_projected_srs != converter->target_srs() || _projected.empty()) {
+    _projected.assign(1, std::deque<ShapeContainer>());
+    _tolerances.clear();
+    if (_decoded)
+      _projected[0] = _decoded_shapes;
+    else
+      _geometry.get_points(_projected[0]);
+
+    size_t point_count = count_points(_projected[0]);
+    if (point_count >= SPATIAL_SIMPLIFY_MIN_POINTS) {
+      double tolerance = SPATIAL_SIMPLIFY_TOLERANCE;
+      for (int i = 0; i < SPATIAL_SIMPLIFY_LEVELS; ++i, tolerance *= SPATIAL_SIMPLIFY_STEP) {
+        std::deque<ShapeContainer> level;
+        _geometry.get_points(level, tolerance);
+        size_t level_count = count_points(level);
+        if (level_count >= point_count)
+          continue;
+
+        point_count = level_count;
+        _projected.push_back(level);
+        _tolerances.push_back(tolerance);
+      }
+    }
+
+    for (size_t i = 0; i < _projected.size(); ++i)
+      converter->project_points(_projected[i], transformation);
+    _projected_srs = converter->target_srs();
+  }
+
+  std::deque<ShapeContainer> tmp_shapes = _projected[0];
+  converter->projected_to_screen(tmp_shapes);
+
+  _simplified_shapes.assign(_projected.begin() + 1, _projected.end());
+  for (size_t i = 0; i < _simplified_shapes.size(); ++i)
+    converter->projected_to_screen(_simplified_shapes[i]);
+  _unit_size = converter->unit_size();
+
+  // The envelope is taken from the points, the corners of the geometry envelope don't bound the shapes in every
+  // projection.
   spatial::Envelope env;
-  _geometry.get_envelope(env);
-  converter->transform_envelope(env);
+  bool first = true;
+  for (std::deque<ShapeContainer>::const_iterator it = tmp_shapes.begin(); it != tmp_shapes.end(); ++it) {
+    for (std::vector<base::Point>::const_iterator p = it->points.begin(); p != it->points.end(); ++p) {
+      if (first) {
+        env.top_left = env.bottom_right = *p;
+        first = false;
+        continue;
+      }
+      env.top_left.x = std::min(env.top_left.x, p->x);
+      env.top_left.y = std::min(env.top_left.y, p->y);
+      env.bottom_right.x = std::max(env.bottom_right.x, p->x);
+      env.bottom_right.y = std::max(env.bottom_right.y, p->y);
+    }
+  }
+  env.converted = !first;
   _env_screen = env;
 
   _shapes = tmp_shapes;
@@ -850,8 +1174,21 @@ void Feature::interrupt() {
   _geometry.interrupt();
 }
 
+// The coarsest level that doesn't move any point by more than SPATIAL_SIMPLIFY_MAX_ERROR pixels.
+const std::deque<ShapeContainer> &Feature::shapes_for_scale(float scale) const {
+  if (_unit_size > 0) {
+    for (size_t i = _tolerances.size(); i > 0; --i) {
+      if (_tolerances[i - 1] / _unit_size * scale <= SPATIAL_SIMPLIFY_MAX_ERROR)
+        return _simplified_shapes[i - 1];
+    }
+  }
+  return _shapes;
+}
+
 void Feature::repaint(mdc::CairoCtx &cr, float scale, const base::Rect &clip_area, base::Color fill_color) {
-  for (std::deque<ShapeContainer>::iterator it = _shapes.begin(); it != _shapes.end() && !_owner->_interrupt; it++) {
+  const std::deque<ShapeContainer> &shapes = shapes_for_scale(scale);
+  for (std::deque<ShapeContainer>::const_iterator it = shapes.begin(); it != shapes.end() && !_owner->_interrupt;
+       it++) {
     if ((*it).points.empty()) {
       logError("%s is empty", shape_description(it->type).c_str());
       continue;
@@ -906,6 +1243,112 @@ static void extend_env(spatial::Envelope &env, const spatial::Envelope &env2) {
   env.bottom_right.y = MIN(env.bottom_right.y, env2.bottom_right.y);
 }
 
+void EnvelopeIndex::build(const std::vector<Envelope> &envelopes) {
+  clear();
+  for (size_t i = 0; i < envelopes.size(); ++i) {
+    const Envelope &env = envelopes[i];
+    if (!env.is_init())
+      continue;
+
+    Node entry;
+    entry.min_x = std::min(env.top_left.x, env.bottom_right.x);
+    entry.min_y = std::min(env.top_left.y, env.bottom_right.y);
+    entry.max_x = std::max(env.top_left.x, env.bottom_right.x);
+    entry.max_y = std::max(env.top_left.y, env.bottom_right.y);
+    entry.first = i;
+    entry.count = 0;
+    entry.leaf = false;
+    _entries.push_back(entry);
+  }
+  if (_entries.empty())
+    return;
+
+  std::vector<Node> level = pack(_entries);
+  for (std::vector<Node>::iterator it = level.begin(); it != level.end(); ++it)
+    it->leaf = true;
+
+  // Every level is packed into the next one until a single root is left.
+  while (level.size() > 1) {
+    std::vector<Node> parents = pack(level);
+    for (std::vector<Node>::iterator it = parents.begin(); it != parents.end(); ++it)
+      it->first += _nodes.size();
+    _nodes.insert(_nodes.end(), level.begin(), level.end());
+    level.swap(parents);
+  }
+  _nodes.push_back(level[0]);
+}
+
+/**
+ * Sort-tile-recursive packing: the entries are sorted into vertical slices by their centers, each slice is sorted
+ * by y and cut into nodes. The entries are reordered so that the children of a node follow each other.
+ */
+std::vector<EnvelopeIndex::Node> EnvelopeIndex::pack(std::vector<Node> &entries) {
+  size_t node_count = (entries.size() + SPATIAL_INDEX_NODE_SIZE - 1) / SPATIAL_INDEX_NODE_SIZE;
+  size_t slice_count = (size_t)ceil(sqrt((double)node_count));
+  size_t slice_size = slice_count * SPATIAL_INDEX_NODE_SIZE;
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Node &a, const Node &b) { return a.min_x + a.max_x < b.min_x + b.max_x; });
+  for (size_t start = 0; start < entries.size(); start += slice_size)
+    std::sort(entries.begin() + start, entries.begin() + std::min(start + slice_size, entries.size()),
+              [](const Node &a, const Node &b) { return a.min_y + a.max_y < b.min_y + b.max_y; });
+
+  std::vector<Node> nodes;
+  nodes.reserve(node_count + slice_count);
+  for (size_t start = 0, end; start < entries.size(); start = end) {
+    // Nodes don't span slices, or their envelopes would get much larger.
+    size_t slice_end = std::min((start / slice_size + 1) * slice_size, entries.size());
+    end = std::min(start + SPATIAL_INDEX_NODE_SIZE, slice_end);
+
+    Node node = entries[start];
+    node.first = start;
+    node.count = end - start;
+    node.leaf = false;
+    for (size_t i = start + 1; i < end; ++i) {
+      node.min_x = std::min(node.min_x, entries[i].min_x);
+      node.min_y = std::min(node.min_y, entries[i].min_y);
+      node.max_x = std::max(node.max_x, entries[i].max_x);
+      node.max_y = std::max(node.max_y, entries[i].max_y);
+    }
+    nodes.push_back(node);
+  }
+  return nodes;
+}
+
+void EnvelopeIndex::clear() {
+  _nodes.clear();
+  _entries.clear();
+}
+
+void EnvelopeIndex::query(const Envelope &area, std::vector<size_t> &result) const {
+  result.clear();
+  if (_nodes.empty())
+    return;
+
+  double min_x = std::min(area.top_left.x, area.bottom_right.x);
+  double min_y = std::min(area.top_left.y, area.bottom_right.y);
+  double max_x = std::max(area.top_left.x, area.bottom_right.x);
+  double max_y = std::max(area.top_left.y, area.bottom_right.y);
+
+  std::vector<const Node *> pending(1, &_nodes.back());
+  while (!pending.empty()) {
+    const Node *node = pending.back();
+    pending.pop_back();
+    if (node->min_x > max_x || node->max_x < min_x || node->min_y > max_y || node->max_y < min_y)
+      continue;
+
+    for (size_t i = node->first; i < node->first + node->count; ++i) {
+      if (node->leaf) {
+        const Node &entry = _entries[i];
+        if (entry.min_x <= max_x && entry.max_x >= min_x && entry.min_y <= max_y && entry.max_y >= min_y)
+          result.push_back(entry.first);
+      } else
+        pending.push_back(&_nodes[i]);
+    }
+  }
+  std::sort(result.begin(), result.end());
+}
+
 Layer::Layer(int layer_id, base::Color color) : _layer_id(layer_id), _color(color), _show(false), _interrupt(false) {
   _spatial_envelope.top_left.x = 180;
   _spatial_envelope.top_left.y = -90;
@@ -953,10 +1396,67 @@ void Layer::add_feature(int row_id, const std::string &geom_data, bool wkt) {
   feature->get_envelope(env);
   extend_env(_spatial_envelope, env);
   _features.push_back(feature);
+  _index.clear();
+}
+
+void Layer::add_features(const std::vector<int> &row_ids, const std::vector<std::string> &geom_data, bool wkt) {
+  std::vector<Feature *> features(geom_data.size(), (Feature *)NULL);
+  size_t chunk_count = (features.size() + SPATIAL_PARALLEL_CHUNK - 1) / SPATIAL_PARALLEL_CHUNK;
+  size_t thread_count = std::min(base::TaskScheduler::get()->thread_count(), chunk_count);
+
+  // OGR parses geometries independently of each other, each thread takes the next chunk of them.
+  std::atomic<size_t> next_chunk(0);
+  try {
+    base::TaskScheduler::get()->run_parallel(base::TaskInteractive, thread_count, [&](size_t) {
+      for (size_t chunk = next_chunk++; chunk < chunk_count && !_interrupt; chunk = next_chunk++) {
+        size_t end = std::min((chunk + 1) * SPATIAL_PARALLEL_CHUNK, features.size());
+        for (size_t i = chunk * SPATIAL_PARALLEL_CHUNK; i < end; ++i)
+          features[i] = new Feature(this, row_ids[i], geom_data[i], wkt);
+      }
+    });
+  } catch (...) {
+    for (std::vector<Feature *>::iterator it = features.begin(); it != features.end(); ++it)
+      delete *it;
+    throw;
+  }
+
+  for (std::vector<Feature *>::iterator it = features.begin(); it != features.end(); ++it) {
+    if (*it == NULL)
+      continue;
+    spatial::Envelope env;
+    (*it)->get_envelope(env);
+    extend_env(_spatial_envelope, env);
+    _features.push_back(*it);
+  }
+  _index.clear();
+}
+
+// The features whose screen envelope intersects the area, in the order they were added.
+void Layer::features_in(const Envelope &area, std::vector<Feature *> &result) {
+  std::vector<size_t> found;
+  _index.query(area, found);
+  result.reserve(found.size());
+  for (std::vector<size_t>::const_iterator it = found.begin(); it != found.end(); ++it)
+    result.push_back(_features[*it]);
 }
 
+/**
+ * Only features in the clip area are painted, if one is given and the layer was rendered since its last change.
+ * The area is in user space.
+ */
 void Layer::repaint(mdc::CairoCtx &cr, float scale, const base::Rect &clip_area) {
-  std::deque<ShapeContainer>::const_iterator it;
+  std::vector<Feature *> features;
+  if (clip_area.width() > 0 && clip_area.height() > 0 && !_index.empty()) {
+    // Lines are stroked beyond the envelope and point markers are painted at a constant screen size.
+    double margin = SPATIAL_CLIP_MARGIN / scale;
+    Envelope area;
+    area.top_left.x = clip_area.left() - margin;
+    area.top_left.y = clip_area.top() - margin;
+    area.bottom_right.x = clip_area.right() + margin;
+    area.bottom_right.y = clip_area.bottom() + margin;
+    features_in(area, features);
+  } else
+    features.assign(_features.begin(), _features.end());
 
   cr.save();
   cr.set_line_width(0.5);
@@ -965,7 +1465,7 @@ void Layer::repaint(mdc::CairoCtx &cr, float scale, const base::Rect &clip_area)
   color.green *= 0.6;
   color.blue *= 0.6;
   cr.set_color(color);
-  for (std::deque<Feature *>::iterator it = _features.begin(); it != _features.end() && !_interrupt; ++it)
+  for (std::vector<Feature *>::iterator it = features.begin(); it != features.end() && !_interrupt; ++it)
     (*it)->repaint(cr, scale, clip_area, _fill_polygons ? _color : base::Color::Invalid());
 
   cr.restore();
@@ -979,21 +1479,63 @@ spatial::Envelope spatial::Layer::get_envelope() {
   return _spatial_envelope;
 }
 
+/**
+ * Features are reprojected in parallel, in chunks. OGR transformations can't be shared between threads, so each
+ * thread creates its own one.
+ */
 void Layer::render(Converter *converter) {
   _render_progress = 0.0;
   float step = 1.0f / _features.size();
 
+  size_t chunk_count = (_features.size() + SPATIAL_PARALLEL_CHUNK - 1) / SPATIAL_PARALLEL_CHUNK;
+  size_t thread_count = std::min(base::TaskScheduler::get()->thread_count(), chunk_count);
+  std::atomic<size_t> next_chunk(0);
+  std::atomic<size_t> rendered(0);
+  base::TaskScheduler::get()->run_parallel(base::TaskInteractive, thread_count, [&](size_t) {
+    OGRCoordinateTransformation *transformation = converter->create_transformation();
+    try {
+      for (size_t chunk = next_chunk++; chunk < chunk_count && !_interrupt; chunk = next_chunk++) {
+        size_t end = std::min((chunk + 1) * SPATIAL_PARALLEL_CHUNK, _features.size());
+        for (size_t i = chunk * SPATIAL_PARALLEL_CHUNK; i < end && !_interrupt; ++i)
+          _features[i]->render(converter, transformation);
+        _render_progress = (rendered += end - chunk * SPATIAL_PARALLEL_CHUNK) * step;
+      }
+    } catch (...) {
+      OCTDestroyCoordinateTransformation(transformation);
+      throw;
+    }
+    OCTDestroyCoordinateTransformation(transformation);
+  });
+
+  std::vector<Envelope> envelopes;
+  envelopes.reserve(_features.size());
   for (std::deque<spatial::Feature *>::iterator iter = _features.begin(); iter != _features.end() && !_interrupt;
        ++iter) {
-    (*iter)->render(converter);
-    _render_progress += step;
+    envelopes.push_back(Envelope());
+    (*iter)->get_envelope(envelopes.back(), true);
   }
+  if (_interrupt)
+    _index.clear();
+  else
+    _index.build(envelopes);
 }
 
 spatial::Feature *Layer::feature_closest(const base::Point &p, const double &allowed_distance) {
   double rval = -1;
   spatial::Feature *f = NULL;
-  for (std::deque<spatial::Feature *>::iterator iter = _features.begin(); iter != _features.end() && !_interrupt;
+
+  std::vector<spatial::Feature *> candidates;
+  if (!_index.empty()) {
+    Envelope area;
+    area.top_left.x = p.x - allowed_distance;
+    area.top_left.y = p.y - allowed_distance;
+    area.bottom_right.x = p.x + allowed_distance;
+    area.bottom_right.y = p.y + allowed_distance;
+    features_in(area, candidates);
+  } else
+    candidates.assign(_features.begin(), _features.end());
+
+  for (std::vector<spatial::Feature *>::iterator iter = candidates.begin(); iter != candidates.end() && !_interrupt;
        ++iter) {
     double dist = (*iter)->distance(p, allowed_distance);
     if (dist < allowed_distance && dist != -1 && (dist < rval || rval == -1)) {
@@ -31,6 +31,7 @@
 #include <gdal/gdal_alg.h>
 #include <gdal/gdal.h>
 #include <deque>
+#include <vector>
 #include "base/geometry.h"
 #include "wbpublic_public_interface.h"
 
@@ -72,8 +73,9 @@ namespace spatial {
     base::Point bottom_right;
     friend bool operator==(const Envelope &env1, const Envelope &env2);
     friend bool operator!=(const Envelope &env1, const Envelope &env2);
-    bool is_init();
+    bool is_init() const;
     bool within(const base::Point &p) const;
+    bool intersects(const Envelope &other) const;
   };
 
   bool operator==(const ProjectionView &v1, const ProjectionView &v2);
@@ -108,6 +110,12 @@ namespace spatial {
     double distance(const base::Point &p) const;
   };
 
+  // Decodes geometry data as MySQL sends it, a 4 byte SRID followed by WKB, into the same shapes and envelope
+  // Importer would give for it, without creating OGR geometries. Only 2D points, line strings, polygons, their multi
+  // variants and collections of them are decoded, false is returned for anything else.
+  bool WBPUBLICBACKEND_PUBLIC_FUNC decode_mysql_geometry(const std::string &data, std::deque<ShapeContainer> &shapes,
+                                                         Envelope &envelope);
+
   class WBPUBLICBACKEND_PUBLIC_FUNC Projection {
   protected:
     OGRSpatialReference _mercator_srs;
@@ -138,7 +146,8 @@ namespace spatial {
     ~Importer();
     int import_from_mysql(const std::string &data);
     int import_from_wkt(std::string data);
-    void get_points(std::deque<ShapeContainer> &shapes_container);
+    // With a tolerance the points are simplified first, so that none moves by more than it.
+    void get_points(std::deque<ShapeContainer> &shapes_container, double tolerance = 0);
     void get_envelope(Envelope &env);
     void interrupt();
     std::string getName() const;
@@ -180,6 +189,19 @@ namespace spatial {
     bool from_proj_to_latlon(double &lat, double &lon);
     static std::string dec_to_dms(double angle, AxisType axis, int precision);
     void transform_points(std::deque<ShapeContainer> &shapes_container);
+    // The two steps of transform_points: the reprojection, which only depends on the projection, and the mapping
+    // of the projected coordinates to the screen, which depends on the view.
+    // Without a transformation the converter's own one is used, which only one thread at a time may do.
+    void project_points(std::deque<ShapeContainer> &shapes_container,
+                        OGRCoordinateTransformation *transformation = NULL);
+    void projected_to_screen(std::deque<ShapeContainer> &shapes_container);
+    // A new transformation to the target projection, for threads that reproject in parallel. The caller owns it.
+    OGRCoordinateTransformation *create_transformation();
+    OGRSpatialReference *target_srs() const {
+      return _target_srs;
+    }
+    // Size of a screen unit in source coordinates, the smaller one of the two axes.
+    double unit_size();
     void transform_envelope(spatial::Envelope &env);
     void interrupt();
   };
@@ -190,16 +212,29 @@ namespace spatial {
     Layer *_owner;
     int _row_id;
     Importer _geometry;
-    std::deque<ShapeContainer> _shapes;
+    // Small geometries are decoded without OGR, _geometry stays empty for them.
+    bool _decoded;
+    std::deque<ShapeContainer> _decoded_shapes;
+    spatial::Envelope _decoded_env;
+    // Reprojected shapes, still to be mapped to the screen. The first level has all points, the others are
+    // simplified with _tolerances.
+    std::vector<std::deque<ShapeContainer> > _projected;
+    OGRSpatialReference *_projected_srs; // The projection of _projected.
+    std::vector<double> _tolerances;     // In source units, increasing.
+    double _unit_size;                   // Source units per screen unit at the last render.
+    std::deque<ShapeContainer> _shapes;  // All points, hit tests use these.
+    std::vector<std::deque<ShapeContainer> > _simplified_shapes;
     spatial::Envelope _env_screen;
 
+    const std::deque<ShapeContainer> &shapes_for_scale(float scale) const;
+
   public:
     Feature(Layer *layer, int row_id, const std::string &data, bool wkt);
     ~Feature();
 
     void interrupt();
     void get_envelope(spatial::Envelope &env, const bool &screen_coords = false);
-    void render(spatial::Converter *converter);
+    void render(spatial::Converter *converter, OGRCoordinateTransformation *transformation = NULL);
     void repaint(mdc::CairoCtx &cr, float scale, const base::Rect &clip_area,
                  base::Color fill_color = base::Color::Invalid());
 
@@ -209,6 +244,36 @@ namespace spatial {
     double distance(const base::Point &p, const double &allowed_distance = 4.0);
   };
 
+  /**
+   * An R-tree over envelopes, packed with the sort-tile-recursive method. It is built in one go, after the
+   * features of a layer were rendered, and only answers queries afterwards.
+   */
+  class WBPUBLICBACKEND_PUBLIC_FUNC EnvelopeIndex {
+  public:
+    // Envelopes that are not initialized are left out.
+    void build(const std::vector<Envelope> &envelopes);
+    void clear();
+    bool empty() const {
+      return _nodes.empty();
+    }
+
+    // Indices of the envelopes intersecting the area, in ascending order.
+    void query(const Envelope &area, std::vector<size_t> &result) const;
+
+  private:
+    struct Node {
+      double min_x, min_y, max_x, max_y;
+      size_t first; // Leaves: first of _entries, others: first of _nodes and in entries: the envelope index.
+      size_t count;
+      bool leaf;
+    };
+
+    std::vector<Node> _nodes; // The root is the last one.
+    std::vector<Node> _entries;
+
+    static std::vector<Node> pack(std::vector<Node> &entries);
+  };
+
   typedef int LayerId;
   WBPUBLICBACKEND_PUBLIC_FUNC LayerId new_layer_id();
 
@@ -225,6 +290,9 @@ namespace spatial {
     bool _interrupt;
     spatial::Envelope _spatial_envelope;
     bool _fill_polygons;
+    EnvelopeIndex _index; // Screen envelopes of _features, built by render().
+
+    void features_in(const Envelope &area, std::vector<Feature *> &result);
 
   public:
     Layer(LayerId layer_id, base::Color color);
@@ -252,6 +320,8 @@ namespace spatial {
     }
 
     void add_feature(int row_id, const std::string &geom_data, bool wkt);
+    // Like add_feature for each of the geometries, which are parsed in parallel.
+    void add_features(const std::vector<int> &row_ids, const std::vector<std::string> &geom_data, bool wkt);
     virtual void render(spatial::Converter *converter);
     spatial::Feature *feature_closest(const base::Point &p, const double &allowed_distance = 4.0);
     void set_fill_polygons(bool fill);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "grt/grt_string_list_model.h"
+#include "wb_helpers.h"
+
+#include <algorithm>
+
+using namespace bec;
+
+BEGIN_TEST_DATA_CLASS(grt_string_list_model)
+public:
+GrtStringListModel objects;
+GrtStringListModel masks;
+
+void set_masks(const std::list<std::string> &values) {
+  masks.reset(values);
+  objects.items_val_masks(&masks);
+  objects.invalidate();
+  objects.refresh();
+}
+END_TEST_DATA_CLASS;
+
+TEST_MODULE(grt_string_list_model, "string list model with exclusion masks");
+
+TEST_FUNCTION(1) {
+  std::list<std::string> names = {"actor", "actor_info", "address", "film", "film_category", "film.text", "payment"};
+  objects.reset(names);
+
+  // Plain names as added when moving objects to the exclusion list, and wildcard masks.
+  set_masks({"actor", "film\\.text"});
+  std::vector<std::string> items = objects.items();
+  ensure_equals("plain masks", items.size(), 5U);
+  ensure("actor excluded", std::find(items.begin(), items.end(), "actor") == items.end());
+  ensure("film.text excluded", std::find(items.begin(), items.end(), "film.text") == items.end());
+  ensure_equals("active items", objects.active_items_count(), 5U);
+
+  set_masks({"film*", "pay?ent"});
+  items = objects.items();
+  ensure_equals("wildcard masks", items.size(), 3U);
+  ensure_equals("ids of wildcard masks", objects.items_ids().size(), 3U);
+
+  set_masks({});
+  ensure_equals("no masks", objects.items().size(), names.size());
+}
+
+TEST_FUNCTION(2) {
+  // Large lists are filtered in parallel, the result must not depend on it.
+  std::list<std::string> names;
+  for (int i = 0; i < 100000; ++i)
+    names.push_back("table_" + std::to_string(i));
+  objects.reset(names);
+
+  set_masks({"table_1*", "table_42"});
+  std::vector<std::string> items = objects.items();
+  ensure_equals("parallel filtering", items.size(), 100000U - 11111U - 1U);
+  ensure("table_42 excluded", std::find(items.begin(), items.end(), "table_42") == items.end());
+  ensure("table_421 kept", std::find(items.begin(), items.end(), "table_421") != items.end());
+}
+
+END_TESTS
@@ -27,12 +27,16 @@
 #include "grt/grt_manager.h"
 
 #include <algorithm>
+#include <chrono>
+#include <set>
 
 DEFAULT_LOG_DOMAIN("validation")
 
+#define VALIDATION_SLICE_TIME 0.05 // Seconds of validation per idle run before giving the UI a chance.
+
 //--------------------------------------------------------------------------------------------------
 
-bec::ValidationMessagesBE::ValidationMessagesBE() {
+bec::ValidationMessagesBE::ValidationMessagesBE() : _refresh_pending(false) {
   _error_icon = IconManager::get_instance()->get_icon_id("mini_error.png");
   _warning_icon = IconManager::get_instance()->get_icon_id("mini_warning.png");
   _info_icon = IconManager::get_instance()->get_icon_id("mini_notice.png");
@@ -58,8 +62,8 @@ bool bec::ValidationMessagesBE::get_field(const bec::NodeId& node, ColumnId colu
 
     if (idx < _errors.size())
       value = _errors[idx].msg;
-    else
-      value = _warnings[idx].msg;
+    else if (idx - _errors.size() < _warnings.size())
+      value = _warnings[idx - _errors.size()].msg;
 
     ret = true;
   }
@@ -110,32 +114,47 @@ bool bec::ValidationMessagesBE::match_message(const bec::ValidationMessagesBE::M
 
 //--------------------------------------------------------------------------------------------------
 
-void bec::ValidationMessagesBE::remove_messages(bec::ValidationMessagesBE::MessageList* ml, const grt::ObjectRef& obj,
+bool bec::ValidationMessagesBE::remove_messages(bec::ValidationMessagesBE::MessageList* ml, const grt::ObjectRef& obj,
                                                 const grt::Validator::Tag& tag) {
-  bec::ValidationMessagesBE::MessageList::iterator it = ml->end();
-  bool was_remove = true;
-
-  while (was_remove) {
-    it = std::remove_if(ml->begin(), ml->end(),
-                        std::bind(&bec::ValidationMessagesBE::match_message, std::placeholders::_1, obj, tag));
-    if (it != ml->end()) {
-      was_remove = true;
-      ml->erase(it);
-    } else
-      was_remove = false;
+  bec::ValidationMessagesBE::MessageList::iterator it = std::remove_if(
+    ml->begin(), ml->end(), std::bind(&bec::ValidationMessagesBE::match_message, std::placeholders::_1, obj, tag));
+  if (it == ml->end())
+    return false;
+  ml->erase(it, ml->end());
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Validation of many objects sends a message pair (clear + result) for each of them. The list is rebuilt
+ * once afterwards instead of after each message.
+ */
+void bec::ValidationMessagesBE::schedule_refresh() {
+  if (!_refresh_pending) {
+    _refresh_pending = true;
+    bec::GRTManager::get()->run_once_when_idle(this, std::bind(&bec::ValidationMessagesBE::do_refresh, this));
   }
 }
 
 //--------------------------------------------------------------------------------------------------
 
+void bec::ValidationMessagesBE::do_refresh() {
+  _refresh_pending = false;
+  tree_changed();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void bec::ValidationMessagesBE::validation_message(const grt::Validator::Tag& tag, const grt::ObjectRef& obj,
                                                    const std::string& msg, const int type) {
   switch (type) {
     case grt::NoErrorMsg: {
       if ("*" != tag) {
         // Clear all types with obj and tag. Argument @msg in this case holds tag value
-        remove_messages(&_errors, obj, tag);
-        remove_messages(&_warnings, obj, tag);
+        bool removed = remove_messages(&_errors, obj, tag);
+        if (!remove_messages(&_warnings, obj, tag) && !removed)
+          return; // Nothing changed, which is the common case when revalidating a valid object.
       } else
         clear();
       break;
@@ -151,11 +170,20 @@ void bec::ValidationMessagesBE::validation_message(const grt::Validator::Tag& ta
     default: { logWarning("Unhandled type in validation_message"); }
   }
 
-  tree_changed();
+  schedule_refresh();
 }
 
 bec::ValidationManager::MessageSignal* bec::ValidationManager::_signal_notify = 0;
 
+struct PendingValidation {
+  grt::ObjectRef object;
+  grt::Validator::Tag tag;
+};
+
+static std::deque<PendingValidation> pending_validations;
+static std::set<std::string> pending_validation_keys; // object id + tag of each queued entry
+static bool pending_validation_scheduled = false;
+
 //--------------------------------------------------------------------------------------------------
 
 bool bec::ValidationManager::is_validation_plugin(const app_PluginRef& plugin) {
@@ -213,6 +241,53 @@ bool bec::ValidationManager::validate_instance(const grt::ObjectRef& obj, const
 
 //--------------------------------------------------------------------------------------------------
 
+void bec::ValidationManager::validate_instance_later(const grt::ObjectRef& obj, const grt::Validator::Tag& tag) {
+  if (!obj.is_valid() || !pending_validation_keys.insert(obj->id() + "\n" + tag).second)
+    return;
+
+  PendingValidation entry;
+  entry.object = obj;
+  entry.tag = tag;
+  pending_validations.push_back(entry);
+
+  if (!pending_validation_scheduled) {
+    pending_validation_scheduled = true;
+    bec::GRTManager::get()->run_once_when_idle(&bec::ValidationManager::validate_pending);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Validates queued objects for a slice of time and reschedules itself for the rest, so a large batch of
+ * changes doesn't block the UI. Validators work on GRT objects, which may only be used from the main thread.
+ */
+void bec::ValidationManager::validate_pending() {
+  pending_validation_scheduled = false;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while (!pending_validations.empty()) {
+    PendingValidation entry = pending_validations.front();
+    pending_validations.pop_front();
+    pending_validation_keys.erase(entry.object->id() + "\n" + entry.tag);
+
+    // An object removed from the model in the meantime only needs its old messages cleared.
+    if (entry.object->is_global())
+      validate_instance(entry.object, entry.tag);
+    else
+      (*signal_notify())(entry.tag, entry.object, entry.tag, grt::NoErrorMsg);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed.count() > VALIDATION_SLICE_TIME && !pending_validations.empty()) {
+      pending_validation_scheduled = true;
+      bec::GRTManager::get()->run_once_when_idle(&bec::ValidationManager::validate_pending);
+      break;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void bec::ValidationManager::message(const grt::Validator::Tag& tag, const grt::ObjectRef& o, const std::string& m,
                                      const int level) {
   // Add message to the Object
@@ -222,6 +297,9 @@ void bec::ValidationManager::message(const grt::Validator::Tag& tag, const grt::
 //--------------------------------------------------------------------------------------------------
 
 void bec::ValidationManager::clear() {
+  pending_validations.clear();
+  pending_validation_keys.clear();
+
   // Clear messages from listeners
   (*signal_notify())("*", grt::ObjectRef(), "", grt::NoErrorMsg);
 }
@@ -78,8 +78,12 @@ namespace bec {
     MessageList _errors;
     MessageList _warnings;
 
+    bool _refresh_pending;
+
     static bool match_message(const Message& m, const grt::ObjectRef& obj, const grt::Validator::Tag& tag);
-    void remove_messages(MessageList* ml, const grt::ObjectRef& obj, const grt::Validator::Tag& tag);
+    bool remove_messages(MessageList* ml, const grt::ObjectRef& obj, const grt::Validator::Tag& tag);
+    void schedule_refresh();
+    void do_refresh();
   };
 
   class WBPUBLICBACKEND_PUBLIC_FUNC ValidationManager {
@@ -93,6 +97,10 @@ namespace bec {
     static void register_validator(const std::string& type, grt::Validator* v);
     static bool validate_instance(const grt::ObjectRef& obj, const grt::Validator::Tag& tag);
 
+    // Queues the object for validation when the application is idle. Requests for the same object and tag made
+    // before that are merged, so a burst of edits validates each changed object once.
+    static void validate_instance_later(const grt::ObjectRef& obj, const grt::Validator::Tag& tag);
+
     static MessageSignal* signal_notify();
     static void message(const grt::Validator::Tag&, const grt::ObjectRef&, const std::string&,
                         const int level); // level is grt::MessageType
@@ -100,6 +108,7 @@ namespace bec {
 
   private:
     static bool is_validation_plugin(const app_PluginRef& plugin);
+    static void validate_pending();
 
     static MessageSignal* _signal_notify;
   };
@@ -27,6 +27,21 @@
 #include <map>
 #endif
 
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_SSE2_SCAN 1
+#endif
+
+// Texts shorter than this are converted by iconv directly, building the tables for a charset costs some 30000
+// iconv calls.
+#define TABLE_CONVERSION_MIN_LENGTH (1024 * 1024)
+
 #include "base/string_utilities.h"
 #include "charset_utils.h"
 
@@ -372,3 +387,156 @@ std::string charsetForCollation(const std::string &collationName) {
 }
 
 //--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+  // The UTF-8 sequence of one character, length 0 if the input is invalid.
+  struct Utf8Char {
+    unsigned char length;
+    char bytes[7];
+  };
+
+  /**
+   * Conversion tables for a charset with ASCII as single bytes and other characters of one or two bytes, like
+   * latin1, gbk, big5, sjis or euckr. They are built by converting every byte and byte pair with iconv once, so the
+   * text is converted exactly as iconv does it.
+   */
+  struct CharsetTables {
+    Utf8Char single[256];
+    bool lead[256];
+    std::vector<Utf8Char> pairs; // 256 entries per lead byte, indexed by leadIndex.
+    int leadIndex[256];
+  };
+
+  enum ProbeResult { ProbeConverted, ProbePartial, ProbeIllegal };
+
+  ProbeResult probe(GIConv cd, const char *input, size_t length, Utf8Char &result) {
+    g_iconv(cd, NULL, NULL, NULL, NULL);
+
+    gchar *in = const_cast<gchar *>(input);
+    gsize inLeft = length;
+    gchar *out = result.bytes;
+    gsize outLeft = sizeof(result.bytes);
+    result.length = 0;
+    if (g_iconv(cd, &in, &inLeft, &out, &outLeft) == (gsize)-1)
+      return errno == EINVAL ? ProbePartial : ProbeIllegal;
+    if (inLeft > 0 || g_iconv(cd, NULL, NULL, &out, &outLeft) == (gsize)-1)
+      return ProbeIllegal;
+
+    result.length = (unsigned char)(sizeof(result.bytes) - outLeft);
+    return ProbeConverted;
+  }
+
+  // Returns no tables for charsets not made of single bytes and byte pairs, or not ASCII compatible.
+  std::shared_ptr<CharsetTables> buildTables(const std::string &charset) {
+    GIConv cd = g_iconv_open("UTF-8", charset.c_str());
+    if (cd == (GIConv)-1)
+      return std::shared_ptr<CharsetTables>();
+
+    std::shared_ptr<CharsetTables> tables(new CharsetTables());
+    bool usable = true;
+    for (int b = 0; b < 256 && usable; ++b) {
+      char input[2] = {(char)b, 0};
+      tables->lead[b] = false;
+      tables->leadIndex[b] = -1;
+
+      ProbeResult result = probe(cd, input, 1, tables->single[b]);
+      if (b < 0x80) {
+        usable = result == ProbeConverted && tables->single[b].length == 1 && tables->single[b].bytes[0] == (char)b;
+        continue;
+      }
+      if (result != ProbePartial)
+        continue;
+
+      tables->lead[b] = true;
+      tables->leadIndex[b] = (int)(tables->pairs.size() / 256);
+      tables->pairs.resize(tables->pairs.size() + 256);
+      Utf8Char *pairs = &tables->pairs[tables->leadIndex[b] * 256];
+      for (int t = 0; t < 256 && usable; ++t) {
+        input[1] = (char)t;
+        // A pair which is still incomplete means longer sequences, which the tables don't cover.
+        usable = probe(cd, input, 2, pairs[t]) != ProbePartial;
+      }
+    }
+    g_iconv_close(cd);
+
+    if (!usable)
+      return std::shared_ptr<CharsetTables>();
+    return tables;
+  }
+
+  std::shared_ptr<CharsetTables> tablesForCharset(const std::string &charset) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<CharsetTables> > cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, std::shared_ptr<CharsetTables> >::iterator entry = cache.find(charset);
+    if (entry == cache.end())
+      entry = cache.insert(std::make_pair(charset, buildTables(charset))).first;
+    return entry->second;
+  }
+
+  // Converts the whole text, false if it has invalid or incomplete characters.
+  bool convertWithTables(const CharsetTables &tables, const unsigned char *data, size_t length, std::string &result) {
+    result.clear();
+    result.reserve(length + length / 2);
+
+    const unsigned char *end = data + length;
+    while (data < end) {
+      // Plain ASCII is copied as is.
+      const unsigned char *run = data;
+#ifdef HAVE_SSE2_SCAN
+      while (end - run >= 16 && _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)run)) == 0)
+        run += 16;
+#endif
+      while (run < end && *run < 0x80)
+        ++run;
+      if (run > data) {
+        result.append((const char *)data, run - data);
+        data = run;
+        if (data == end)
+          break;
+      }
+
+      const Utf8Char *c;
+      if (tables.lead[*data]) {
+        if (data + 1 == end)
+          return false;
+        c = &tables.pairs[tables.leadIndex[*data] * 256 + data[1]];
+        data += 2;
+      } else
+        c = &tables.single[*data++];
+
+      if (c->length == 0)
+        return false;
+      result.append(c->bytes, c->length);
+    }
+    return true;
+  }
+}
+
+/**
+ * Large texts in charsets the tables can be built for are converted by table lookups, ASCII is copied through
+ * in blocks. If that fails g_convert() converts the text again to report the error the usual way.
+ */
+gchar *convertToUtf8(const gchar *data, gssize length, const std::string &charset, gsize *bytesRead,
+                     gsize *bytesWritten, GError **error) {
+  size_t size = length < 0 ? strlen(data) : (size_t)length;
+  if (size >= TABLE_CONVERSION_MIN_LENGTH) {
+    std::shared_ptr<CharsetTables> tables = tablesForCharset(charset);
+    std::string converted;
+    if (tables && convertWithTables(*tables, (const unsigned char *)data, size, converted)) {
+      gchar *result = (gchar *)g_malloc(converted.size() + 1);
+      memcpy(result, converted.data(), converted.size());
+      result[converted.size()] = 0;
+      if (bytesRead)
+        *bytesRead = size;
+      if (bytesWritten)
+        *bytesWritten = converted.size();
+      return result;
+    }
+  }
+
+  return g_convert(data, length, "UTF-8", charset.c_str(), bytesRead, bytesWritten, error);
+}
@@ -27,7 +27,13 @@
 #include <string>
 #endif
 
+#include <glib.h>
+
 #include "wbpublic_public_interface.h"
 
 WBPUBLICBACKEND_PUBLIC_FUNC std::string defaultCollationForCharset(const std::string &charsetName);
 WBPUBLICBACKEND_PUBLIC_FUNC std::string charsetForCollation(const std::string &collationName);
+
+// Same as g_convert() to UTF-8, faster for large texts in single and double byte charsets.
+WBPUBLICBACKEND_PUBLIC_FUNC gchar *convertToUtf8(const gchar *data, gssize length, const std::string &charset,
+                                                 gsize *bytesRead, gsize *bytesWritten, GError **error);
@@ -27,6 +27,7 @@
 #include "grts/structs.h"
 #include "grts/structs.db.mysql.h"
 #include "base/log.h"
+#include "base/string_utilities.h"
 #include "grt.h"
 #include "db_helpers.h"
 
@@ -203,8 +204,201 @@ bool grt::DbObjectMatchAlterOmf::equal(const ValueRef& l, const ValueRef& r) con
   return std::equal_to<grt::ValueRef>()(l, r);
 }
 
+// Must stay in sync with equal(): values it considers equal get the same key.
+bool grt::DbObjectMatchAlterOmf::match_key(const ValueRef& value, std::string& key) const {
+  if (value.type() == ObjectType) {
+    if (db_IndexColumnRef::can_wrap(value)) {
+      if (!match_key(db_IndexColumnRef::cast_from(value)->referencedColumn(), key))
+        return false;
+      key.insert(0, "c:");
+      return true;
+    } else if (db_mysql_SchemaRef::can_wrap(value)) {
+      key = std::string("s:").append(db_mysql_SchemaRef::cast_from(value)->name().c_str());
+      return true;
+    } else if (GrtNamedObjectRef::can_wrap(value)) {
+      GrtNamedObjectRef object = GrtNamedObjectRef::cast_from(value);
+      key = "n:" + (strlen(object->oldName().c_str()) > 0 ? get_qualified_schema_object_old_name(object, case_sensitive)
+                                                          : get_qualified_schema_object_name(object, case_sensitive));
+      return true;
+    } else if (GrtObjectRef::can_wrap(value)) {
+      key = std::string("o:").append(GrtObjectRef::cast_from(value)->name().c_str());
+      return true;
+    }
+
+    ObjectRef object = ObjectRef::cast_from(value);
+    if (object.has_member("oldName")) {
+      std::string name = object.get_string_member("oldName");
+      key = "x:" + object.class_name() + ":" + (name.empty() ? object.get_string_member("name") : name);
+      return true;
+    }
+  }
+
+  identity_match_key(value, key);
+  return true;
+}
+
+// Schemas don't depend on each other for diffing, so they can be compared concurrently.
+bool grt::DbObjectMatchAlterOmf::diff_items_in_parallel(const BaseListRef& list) const {
+  if (list.content_type() != ObjectType)
+    return false;
+  MetaClass* meta = grt::GRT::get()->get_metaclass(list.content_class_name());
+  return meta && meta->is_a(db_Schema::static_class_name());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool grt::DbObjectMatchAlterOmf::known_equal(const ObjectRef& source, const ObjectRef& target) const {
+  return known_equal_targets.find(target->id()) != known_equal_targets.end() &&
+         source.class_name() == target.class_name();
+}
+
 //--------------------------------------------------------------------------------------------------
 
+namespace {
+  struct HeaderToken {
+    size_t begin;
+    size_t end;
+    std::string value; // Unquoted value of identifiers.
+    bool quoted;
+  };
+
+  // Reads the next token of a statement header. Comments are not handled, the caller falls back to the parser.
+  bool next_header_token(const std::string& sql, size_t& pos, HeaderToken& token) {
+    while (pos < sql.size() && isspace((unsigned char)sql[pos]))
+      ++pos;
+    if (pos >= sql.size() || sql[pos] == '#' || sql.compare(pos, 2, "--") == 0 || sql.compare(pos, 2, "/*") == 0)
+      return false;
+
+    token.begin = pos;
+    token.value.clear();
+    token.quoted = false;
+    char c = sql[pos];
+    if (c == '`' || c == '\'' || c == '"') {
+      token.quoted = true;
+      for (++pos; pos < sql.size(); ++pos) {
+        if (sql[pos] == c) {
+          if (pos + 1 < sql.size() && sql[pos + 1] == c)
+            ++pos;
+          else
+            break;
+        }
+        token.value.push_back(sql[pos]);
+      }
+      if (pos >= sql.size())
+        return false;
+      ++pos;
+    } else if (isalnum((unsigned char)c) || c == '_' || c == '$' || (unsigned char)c >= 0x80) {
+      while (pos < sql.size() && (isalnum((unsigned char)sql[pos]) || sql[pos] == '_' || sql[pos] == '$' ||
+                                  (unsigned char)sql[pos] >= 0x80))
+        token.value.push_back(sql[pos++]);
+    } else
+      token.value.push_back(sql[pos++]);
+    token.end = pos;
+    return true;
+  }
+
+  bool is_keyword(const HeaderToken& token, const char* keyword) {
+    return !token.quoted && base::same_string(token.value, keyword, false);
+  }
+
+  // Reads an optionally qualified object name and appends it qualified with the schema, the way the parser based
+  // normalizer does. Replaces the text from the given position up to the end of the name.
+  bool qualify_header_name(const std::string& sql, size_t& pos, size_t& copied, const std::string& schema,
+                           std::string& result) {
+    HeaderToken name, dot;
+    if (!next_header_token(sql, pos, name) || (!name.quoted && name.value.size() == 1 && !isalnum(name.value[0])))
+      return false;
+
+    std::string schema_name = schema;
+    size_t after_name = pos;
+    if (next_header_token(sql, after_name, dot) && dot.value == "." && !dot.quoted) {
+      HeaderToken object;
+      if (!next_header_token(sql, after_name, object))
+        return false;
+      schema_name = name.value;
+      name.value = object.value;
+      name.end = object.end;
+      pos = after_name;
+    }
+
+    result.append(sql, copied, name.begin - copied);
+    result.append("`").append(schema_name).append("`.`").append(name.value).append("`");
+    copied = name.end;
+    return true;
+  }
+}
+
+bool grt::normalize_create_statement(const std::string& text, const std::string& schema, std::string& result) {
+  // The parser splits the text at backslashes, leave those cases to it.
+  if (text.find('\\') != std::string::npos)
+    return false;
+
+  static const char* blanks = " \t\r\n";
+  size_t start = text.find_first_not_of(blanks);
+  if (start == std::string::npos)
+    return false;
+  std::string sql = text.substr(start, text.find_last_not_of(blanks) + 1 - start);
+
+  size_t pos = 0;
+  HeaderToken token;
+  if (!next_header_token(sql, pos, token) || !is_keyword(token, "CREATE"))
+    return false;
+  size_t create_end = token.end;
+
+  // Skip the definer and other clauses up to the object type.
+  bool trigger = false;
+  for (int skipped = 0;; ++skipped) {
+    if (skipped > 16 || !next_header_token(sql, pos, token))
+      return false;
+    if (is_keyword(token, "PROCEDURE") || is_keyword(token, "FUNCTION"))
+      break;
+    if (is_keyword(token, "TRIGGER")) {
+      trigger = true;
+      break;
+    }
+    if (is_keyword(token, "VIEW") || is_keyword(token, "TABLE") || is_keyword(token, "EVENT"))
+      return false;
+  }
+
+  result.clear();
+  result.reserve(sql.size() + 2 * schema.size());
+  size_t copied = 0;
+  if (trigger) {
+    // The definer clause is replaced by a single space.
+    result.append(sql, 0, create_end).append(" ");
+    copied = token.begin;
+  }
+  if (!qualify_header_name(sql, pos, copied, schema, result))
+    return false;
+
+  if (!trigger) {
+    result.append(sql, copied, std::string::npos);
+    return true;
+  }
+
+  // CREATE TRIGGER name {BEFORE | AFTER} {INSERT | UPDATE | DELETE} ON table
+  if (!next_header_token(sql, pos, token) || !(is_keyword(token, "BEFORE") || is_keyword(token, "AFTER")))
+    return false;
+  if (!next_header_token(sql, pos, token) ||
+      !(is_keyword(token, "INSERT") || is_keyword(token, "UPDATE") || is_keyword(token, "DELETE")))
+    return false;
+  if (!next_header_token(sql, pos, token) || !is_keyword(token, "ON"))
+    return false;
+  if (!qualify_header_name(sql, pos, copied, schema, result))
+    return false;
+  result.append(sql, copied, std::string::npos);
+  return true;
+}
+
+namespace {
+  std::string normalize_sql_definition(SqlFacade* parser, const std::string& sql, const std::string& schema) {
+    std::string result;
+    if (grt::normalize_create_statement(sql, schema, result))
+      return result;
+    return parser->normalizeSqlStatement(sql, schema);
+  }
+}
+
 bool sqlCompare(const ValueRef obj1, const ValueRef obj2, const std::string& name) {
   // views are compared by sqlDefinition
   if (!db_ViewRef::can_wrap(obj1)) {
@@ -218,8 +412,12 @@ bool sqlCompare(const ValueRef obj1, const ValueRef obj2, const std::string& nam
                                                         : GrtObjectRef::cast_from(obj1)->owner()->name();
     std::string schema2 = db_TriggerRef::can_wrap(obj2) ? GrtObjectRef::cast_from(obj2)->owner()->owner()->name()
                                                         : GrtObjectRef::cast_from(obj2)->owner()->name();
-    sql1 = parser->normalizeSqlStatement(sql1, schema1);
-    sql2 = parser->normalizeSqlStatement(sql2, schema2);
+    // The normalization only depends on the text and the schema.
+    if (sql1 == sql2 && schema1 == schema2)
+      return true;
+
+    sql1 = normalize_sql_definition(parser, sql1, schema1);
+    sql2 = normalize_sql_definition(parser, sql2, schema2);
     return sql1 == sql2;
   } else
     return true; // consider it as always matching
@@ -32,6 +32,8 @@
 #include "grtsqlparser/sql_facade.h"
 #include "db_object_helpers.h"
 
+#include <set>
+
 namespace sql {
   class DatabaseMetaData;
 }
@@ -39,10 +41,24 @@ namespace sql {
 namespace grt {
 
   struct WBPUBLICBACKEND_PUBLIC_FUNC DbObjectMatchAlterOmf : public Omf {
+    // Ids of target objects known to equal the source object they are matched with.
+    std::set<std::string> known_equal_targets;
+
     virtual bool less(const ValueRef&, const ValueRef&) const;
     virtual bool equal(const ValueRef&, const ValueRef&) const;
+    virtual bool match_key(const ValueRef& value, std::string& key) const;
+    virtual bool diff_items_in_parallel(const BaseListRef& list) const;
+    virtual bool known_equal(const ObjectRef& source, const ObjectRef& target) const;
   };
 
+  /**
+   * Normalizes CREATE PROCEDURE, FUNCTION and TRIGGER statements like Mysql_sql_normalizer, by only reading the
+   * statement header: names are qualified with the schema and the definer clause of triggers is removed. Returns
+   * false for anything else, which is then left to the parser.
+   */
+  WBPUBLICBACKEND_PUBLIC_FUNC bool normalize_create_statement(const std::string& text, const std::string& schema,
+                                                              std::string& result);
+
   typedef std::function<bool(const ValueRef obj1, const ValueRef obj2, const std::string name)> comparison_rule;
   class WBPUBLICBACKEND_PUBLIC_FUNC NormalizedComparer {
   protected:
@@ -1173,12 +1173,58 @@ bool TableColumnsListBE::delete_node(const NodeId &node) {
 
 //----------------- IndexColumnsListBE ---------------------------------------------------------------------------------
 
+ColumnPositions::ColumnPositions() : _valid(false) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool ColumnPositions::is_current(const GrtObjectRef &owner) const {
+  return _valid && owner.is_valid() && owner->id() == _owner_id;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Empties the map and makes it follow the given index or FK until the next change in it.
+ */
+void ColumnPositions::reset(const GrtObjectRef &owner) {
+  _positions.clear();
+  _owner_id = owner->id();
+  _valid = true;
+  _list_changed = owner->signal_list_changed()->connect(std::bind(&ColumnPositions::invalidate, this));
+  _member_changed = owner->signal_changed()->connect(std::bind(&ColumnPositions::invalidate, this));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ColumnPositions::add(const db_ColumnRef &column, size_t position) {
+  // The first entry wins, as with a scan of the list.
+  if (column.is_valid())
+    _positions.emplace(column->id(), position);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t ColumnPositions::find(const db_ColumnRef &column) const {
+  std::unordered_map<std::string, size_t>::const_iterator iter = _positions.find(column->id());
+  return iter != _positions.end() ? iter->second : grt::BaseListRef::npos;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ColumnPositions::invalidate() {
+  _valid = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 IndexColumnsListBE::IndexColumnsListBE(IndexListBE *owner) : _owner(owner) {
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 void IndexColumnsListBE::refresh() {
+  _positions.invalidate();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -1190,31 +1236,32 @@ size_t IndexColumnsListBE::count() {
 //----------------------------------------------------------------------------------------------------------------------
 
 db_IndexColumnRef IndexColumnsListBE::get_index_column(const db_ColumnRef &column) {
-  if (column.is_valid() && _owner->get_selected_index().is_valid()) {
-    grt::ListRef<db_IndexColumn> index_columns(_owner->get_selected_index()->columns());
-
-    for (size_t c = index_columns.count(), i = 0; i < c; i++) {
-      // because of the way the index editing works, it's impossible
-      // to have 2 index columns referring to the same table column
-      if (index_columns[i]->referencedColumn() == column)
-        return index_columns[i];
-    }
-  }
+  size_t i = get_index_column_index(column);
+  if (i != grt::BaseListRef::npos)
+    return _owner->get_selected_index()->columns()[i];
   return db_IndexColumnRef();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 size_t IndexColumnsListBE::get_index_column_index(const db_ColumnRef &column) {
-  if (column.is_valid() && _owner->get_selected_index().is_valid()) {
-    grt::ListRef<db_IndexColumn> index_columns(_owner->get_selected_index()->columns());
-
-    for (size_t c = index_columns.count(), i = 0; i < c; i++) {
-      // because of the way the index editing works, it's impossible
-      // to have 2 index columns referring to the same table column
-      if (index_columns[i]->referencedColumn() == column)
-        return i;
+  db_IndexRef index(_owner->get_selected_index());
+
+  if (column.is_valid() && index.is_valid()) {
+    grt::ListRef<db_IndexColumn> index_columns(index->columns());
+
+    // because of the way the index editing works, it's impossible
+    // to have 2 index columns referring to the same table column
+    size_t i = _positions.is_current(index) ? _positions.find(column) : grt::BaseListRef::npos;
+    bool moved =
+      i != grt::BaseListRef::npos && (i >= index_columns.count() || index_columns[i]->referencedColumn() != column);
+    if (!_positions.is_current(index) || moved) {
+      _positions.reset(index);
+      for (size_t c = index_columns.count(), j = 0; j < c; j++)
+        _positions.add(index_columns[j]->referencedColumn(), j);
+      i = _positions.find(column);
     }
+    return i;
   }
   return -1;
 }
@@ -1639,7 +1686,7 @@ bool IndexListBE::set_field(const NodeId &node, ColumnId column, const std::stri
         index->name(value);
         _owner->update_change_date();
         undo.end(strfmt(_("Rename Index '%s.%s'"), _owner->get_name().c_str(), index->name().c_str()));
-        bec::ValidationManager::validate_instance(index, CHECK_NAME);
+        bec::ValidationManager::validate_instance_later(index, CHECK_NAME);
       }
       return true;
     case Type:
@@ -1720,6 +1767,7 @@ FKConstraintColumnsListBE::FKConstraintColumnsListBE(FKConstraintListBE *owner)
 
 void FKConstraintColumnsListBE::refresh() {
   _referenced_columns.clear();
+  _positions.invalidate();
 
   db_ForeignKeyRef fk(_owner->get_selected_fk());
   if (fk.is_valid()) {
@@ -1912,12 +1960,19 @@ ssize_t FKConstraintColumnsListBE::get_fk_column_index(const NodeId &node) {
 
   if (fk.is_valid() && node[0] < table->columns().count()) {
     db_ColumnRef column = table->columns()[node[0]];
+    grt::ListRef<db_Column> fk_columns(fk->columns());
 
     // find index in list of columns for the FK
-    for (size_t c = fk->columns().count(), i = 0; i < c; i++) {
-      if (fk->columns().get(i) == column)
-        return i;
+    size_t i = _positions.is_current(fk) ? _positions.find(column) : grt::BaseListRef::npos;
+    if (!_positions.is_current(fk) ||
+        (i != grt::BaseListRef::npos && (i >= fk_columns.count() || fk_columns[i] != column))) {
+      _positions.reset(fk);
+      for (size_t c = fk_columns.count(), j = 0; j < c; j++)
+        _positions.add(fk_columns[j], j);
+      i = _positions.find(column);
     }
+    if (i != grt::BaseListRef::npos)
+      return i;
   }
   return -1;
 }
@@ -2420,8 +2475,8 @@ bool FKConstraintListBE::set_field(const NodeId &node, ColumnId column, const st
           TableHelper::update_foreign_key_index(fk);
 
           _owner->update_change_date();
-          bec::ValidationManager::validate_instance(_owner->get_table(), "chk_fk_lgc");
-          bec::ValidationManager::validate_instance(dbtable, "chk_fk_lgc");
+          bec::ValidationManager::validate_instance_later(_owner->get_table(), "chk_fk_lgc");
+          bec::ValidationManager::validate_instance_later(dbtable, "chk_fk_lgc");
 
           undo.end(strfmt(_("Change Ref. Table for FK '%s.%s'"), _owner->get_name().c_str(), fk->name().c_str()));
         }
@@ -2573,7 +2628,8 @@ bool FKConstraintListBE::activate_popup_item_for_nodes(const std::string &name,
                                   // that's ok as we just store pointer for later use
 #endif
 
-TableEditorBE::TableEditorBE(const db_TableRef &table) : DBObjectEditorBE(table), _fk_list(this) {
+TableEditorBE::TableEditorBE(const db_TableRef &table)
+  : DBObjectEditorBE(table), _fk_list(this), _column_names_valid(false), _column_names_unique(true) {
   _inserts_panel = NULL;
   _inserts_grid = NULL;
 
@@ -2582,6 +2638,13 @@ TableEditorBE::TableEditorBE(const db_TableRef &table) : DBObjectEditorBE(table)
 
   scoped_connect(get_catalog()->signal_changed(),
                  std::bind(&TableEditorBE::catalogChanged, this, std::placeholders::_1, std::placeholders::_2));
+  scoped_connect(table->signal_list_changed(), std::bind(&TableEditorBE::table_list_changed, this,
+                                                         std::placeholders::_1, std::placeholders::_2,
+                                                         std::placeholders::_3));
+
+  grt::UndoManager *um = grt::GRT::get()->get_undo_manager();
+  scoped_connect(um->signal_undo(), std::bind(&TableEditorBE::invalidate_column_names, this));
+  scoped_connect(um->signal_redo(), std::bind(&TableEditorBE::invalidate_column_names, this));
 }
 
 #ifdef _WIN32
@@ -2595,7 +2658,7 @@ void TableEditorBE::set_name(const std::string &name) {
     RefreshUI::Blocker __centry(*this);
 
     AutoUndoEdit undo(this, get_object(), "name");
-    bec::ValidationManager::validate_instance(get_table(), CHECK_NAME);
+    bec::ValidationManager::validate_instance_later(get_table(), CHECK_NAME);
     std::string name_ = base::trim_right(name);
     get_dbobject()->name(name_);
     undo.end(strfmt(_("Rename Table to '%s'"), name_.c_str()));
@@ -2621,8 +2684,8 @@ NodeId TableEditorBE::add_column(const std::string &name) {
   get_columns()->refresh();
   column_count_changed();
 
-  bec::ValidationManager::validate_instance(column, CHECK_NAME);
-  bec::ValidationManager::validate_instance(get_table(), "columns-count");
+  bec::ValidationManager::validate_instance_later(column, CHECK_NAME);
+  bec::ValidationManager::validate_instance_later(get_table(), "columns-count");
   return NodeId(get_table()->columns().count() - 1);
 }
 
@@ -2635,7 +2698,7 @@ NodeId TableEditorBE::duplicate_column(const db_ColumnRef &column, ssize_t inser
   std::string name = new_column->name();
   std::string new_name = name;
   for (int i = 1;; i++) {
-    if (!find_named_object_in_list(get_table()->columns(), new_name).is_valid())
+    if (!get_column_with_name(new_name).is_valid())
       break;
     new_name = strfmt("%s_copy%i", name.c_str(), i);
   }
@@ -2646,8 +2709,8 @@ NodeId TableEditorBE::duplicate_column(const db_ColumnRef &column, ssize_t inser
   if (insert_after >= 0)
     get_table()->columns()->reorder(get_table()->columns()->get_index(new_column), insert_after);
 
-  bec::ValidationManager::validate_instance(new_column, CHECK_NAME);
-  bec::ValidationManager::validate_instance(get_table(), "columns-count");
+  bec::ValidationManager::validate_instance_later(new_column, CHECK_NAME);
+  bec::ValidationManager::validate_instance_later(get_table(), "columns-count");
 
   column_count_changed();
 
@@ -2657,7 +2720,53 @@ NodeId TableEditorBE::duplicate_column(const db_ColumnRef &column, ssize_t inser
 //----------------------------------------------------------------------------------------------------------------------
 
 db_ColumnRef TableEditorBE::get_column_with_name(const std::string &name) {
-  return grt::find_named_object_in_list<db_Column>(get_table()->columns(), name, "name");
+  grt::ListRef<db_Column> columns(get_table()->columns());
+
+  std::unordered_map<std::string, size_t>::const_iterator iter = _column_names.find(name);
+  if (_column_names_valid && iter == _column_names.end())
+    return db_ColumnRef();
+
+  // Reorders are not signaled, so the position is checked before using it.
+  if (_column_names_valid && iter->second < columns.count() && *columns[iter->second]->name() == name)
+    return columns[iter->second];
+
+  _column_names.clear();
+  _column_names_unique = true;
+  for (size_t c = columns.count(), i = 0; i < c; i++) {
+    if (!_column_names.emplace(columns[i]->name(), i).second)
+      _column_names_unique = false;
+  }
+  _column_names_valid = true;
+
+  iter = _column_names.find(name);
+  if (iter != _column_names.end())
+    return columns[iter->second];
+  return db_ColumnRef();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Keeps the column name map current: a column appended to the list is added to it, any other change drops it.
+ */
+void TableEditorBE::table_list_changed(grt::internal::OwnedList *list, bool added, const grt::ValueRef &value) {
+  grt::ListRef<db_Column> columns(get_table()->columns());
+  if (list != columns.valueptr() || !_column_names_valid)
+    return;
+
+  size_t count = columns.count();
+  if (added && count > 0 && columns[count - 1] == value) {
+    if (!_column_names.emplace(columns[count - 1]->name(), count - 1).second)
+      _column_names_unique = false;
+  } else
+    invalidate_column_names();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TableEditorBE::invalidate_column_names() {
+  _column_names_valid = false;
+  _column_names.clear();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -2670,8 +2779,21 @@ void TableEditorBE::rename_column(const db_ColumnRef &column, const std::string
   ((db_ColumnRef)column)->name(name);
   update_change_date();
 
+  if (_column_names_valid) {
+    // With duplicate names another column would have to take over the entry, that needs a rebuild.
+    std::unordered_map<std::string, size_t>::iterator iter = _column_names.find(old_name);
+    if (_column_names_unique && iter != _column_names.end() && iter->second < get_table()->columns().count() &&
+        get_table()->columns()[iter->second] == column) {
+      size_t position = iter->second;
+      _column_names.erase(iter);
+      if (!_column_names.emplace(name, position).second)
+        invalidate_column_names();
+    } else
+      invalidate_column_names();
+  }
+
   undo.end(strfmt(_("Rename '%s.%s' to '%s'"), get_name().c_str(), old_name.c_str(), name.c_str()));
-  bec::ValidationManager::validate_instance(column, CHECK_NAME);
+  bec::ValidationManager::validate_instance_later(column, CHECK_NAME);
 
   column_count_changed();
 }
@@ -2692,7 +2814,7 @@ void TableEditorBE::remove_column(const NodeId &node) {
   undo.end(strfmt(_("Remove '%s.%s'"), get_name().c_str(), column->name().c_str()));
 
   get_columns()->refresh();
-  bec::ValidationManager::validate_instance(get_table(), "columns-count");
+  bec::ValidationManager::validate_instance_later(get_table(), "columns-count");
 
   column_count_changed();
 }
@@ -2720,7 +2842,7 @@ NodeId TableEditorBE::add_fk(const std::string &name) {
 
   _fk_list.refresh();
 
-  bec::ValidationManager::validate_instance(fk, CHECK_NAME);
+  bec::ValidationManager::validate_instance_later(fk, CHECK_NAME);
 
   return NodeId(fklist.count() - 1);
 }
@@ -2745,8 +2867,8 @@ bool TableEditorBE::remove_fk(const NodeId &fk) {
 
   // There might be no referenced table yet.
   if (ref_table.is_valid())
-    bec::ValidationManager::validate_instance(ref_table, "chk_fk_lgc");
-  bec::ValidationManager::validate_instance(get_table(), "chk_fk_lgc");
+    bec::ValidationManager::validate_instance_later(ref_table, "chk_fk_lgc");
+  bec::ValidationManager::validate_instance_later(get_table(), "chk_fk_lgc");
 
   return true;
 }
@@ -2783,8 +2905,8 @@ NodeId TableEditorBE::add_index(const std::string &name) {
 
   get_indexes()->refresh();
 
-  bec::ValidationManager::validate_instance(index, CHECK_NAME);
-  bec::ValidationManager::validate_instance(get_table(), CHECK_EFFICIENCY);
+  bec::ValidationManager::validate_instance_later(index, CHECK_NAME);
+  bec::ValidationManager::validate_instance_later(get_table(), CHECK_EFFICIENCY);
 
   return NodeId(indices.count() - 1);
 }
@@ -2811,7 +2933,7 @@ bool TableEditorBE::remove_index(const NodeId &index, bool delete_even_if_foreig
   update_change_date();
   undo.end(strfmt(_("Remove Index '%s'.'%s'"), indexobj->name().c_str(), get_name().c_str()));
 
-  bec::ValidationManager::validate_instance(get_table(), CHECK_EFFICIENCY);
+  bec::ValidationManager::validate_instance_later(get_table(), CHECK_EFFICIENCY);
 
   return true;
 }
@@ -2835,7 +2957,7 @@ NodeId TableEditorBE::add_index_with_columns(const std::vector<NodeId> &columns)
   update_change_date();
   undo.end(strfmt(_("Add Index '%s' to '%s'"), index->name().c_str(), get_name().c_str()));
 
-  bec::ValidationManager::validate_instance(index, CHECK_NAME);
+  bec::ValidationManager::validate_instance_later(index, CHECK_NAME);
 
   return id;
 }
@@ -2859,7 +2981,7 @@ NodeId TableEditorBE::add_fk_with_columns(const std::vector<NodeId> &columns) {
   update_change_date();
   undo.end(strfmt(_("Add Foreign Key '%s' to '%s'"), fk->name().c_str(), get_name().c_str()));
 
-  bec::ValidationManager::validate_instance(fk, CHECK_NAME);
+  bec::ValidationManager::validate_instance_later(fk, CHECK_NAME);
 
   return id;
 }
@@ -32,6 +32,8 @@
 
 #include "wbpublic_public_interface.h"
 
+#include <unordered_map>
+
 #define TableEditorBE_VERSION 2
 
 class Recordset;
@@ -135,6 +137,27 @@ namespace bec {
     virtual bool get_field_grt(const NodeId &node, ColumnId column, grt::ValueRef &value);
   };
 
+  //! Positions of table columns in the column list of an index or FK, so that per row lookups don't scan that list.
+  //! The map is dropped when a list of the owner changes and rebuilt by the next lookup. Lists can be reordered
+  //! without a signal, so callers check a found position against the list before using it.
+  class WBPUBLICBACKEND_PUBLIC_FUNC ColumnPositions {
+  public:
+    ColumnPositions();
+
+    bool is_current(const GrtObjectRef &owner) const;
+    void reset(const GrtObjectRef &owner);
+    void add(const db_ColumnRef &column, size_t position);
+    size_t find(const db_ColumnRef &column) const;
+    void invalidate();
+
+  private:
+    std::unordered_map<std::string, size_t> _positions;
+    std::string _owner_id;
+    bool _valid;
+    boost::signals2::scoped_connection _list_changed;
+    boost::signals2::scoped_connection _member_changed;
+  };
+
   class WBPUBLICBACKEND_PUBLIC_FUNC IndexColumnsListBE : public ListModel {
   public:
     enum IndexColumnsListColumns { Name, Descending, Length, OrderIndex };
@@ -154,6 +177,7 @@ namespace bec {
 
   protected:
     IndexListBE *_owner;
+    ColumnPositions _positions;
 
     // for internal use only
     virtual bool get_field_grt(const NodeId &node, ColumnId column, grt::ValueRef &value);
@@ -245,6 +269,7 @@ namespace bec {
     // if id is in the map, then it's enabled, if column is nil, it's unset
     // only valid entries will be committed to actual table
     std::map<std::string, db_ColumnRef> _referenced_columns;
+    ColumnPositions _positions;
 
     FKConstraintListBE *_owner;
   };
@@ -372,9 +397,17 @@ namespace bec {
     RecordsetRef _inserts_model;
     RecordsetTableInsertsStorageRef _inserts_storage;
 
+    // Column name to position, kept up to date from the column list signals. Renames don't go through the table,
+    // so rename_column() and undo/redo update it too.
+    std::unordered_map<std::string, size_t> _column_names;
+    bool _column_names_valid;
+    bool _column_names_unique;
+
     void inserts_column_resized(int);
     void restore_inserts_columns();
     void catalogChanged(const std::string &member, const grt::ValueRef &value);
+    void table_list_changed(grt::internal::OwnedList *list, bool added, const grt::ValueRef &value);
+    void invalidate_column_names();
 
     void update_selection_for_menu_extra(mforms::ContextMenu *menu, const std::vector<int> &rows, int column);
     void open_field_editor(int row, int column);
@@ -131,3 +131,131 @@ void bec::update_sync_profile_from_schema(db_mgmt_SyncProfileRef profile, db_Sch
     profile->lastSyncDate(base::fmttime(0, "%Y-%m-%d %H:%M:%S"));
   }
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+  // 64 bit FNV-1a, good enough to tell definitions apart, not meant to be cryptographically strong.
+  class Fingerprint {
+  public:
+    Fingerprint() : _hash(14695981039346656037ULL) {
+    }
+
+    void add(const std::string &data) {
+      for (unsigned char c : data) {
+        _hash ^= c;
+        _hash *= 1099511628211ULL;
+      }
+      // Terminate every piece, so "ab" + "c" and "a" + "bc" differ.
+      _hash ^= 0xff;
+      _hash *= 1099511628211ULL;
+    }
+
+    std::string str() const {
+      return base::strfmt("%016llx", (unsigned long long)_hash);
+    }
+
+  private:
+    unsigned long long _hash;
+  };
+
+  // Walks the value the way GrtDiff compares it: members excluded from diffing are skipped and referenced objects
+  // which are not owned only contribute their name.
+  void add_value(Fingerprint &fingerprint, const grt::ValueRef &value, bool follow) {
+    if (!value.is_valid()) {
+      fingerprint.add("");
+      return;
+    }
+
+    switch (value.type()) {
+      case grt::ListType: {
+        grt::BaseListRef list(grt::BaseListRef::cast_from(value));
+        fingerprint.add(base::strfmt("[%i", (int)list.count()));
+        for (size_t i = 0; i < list.count(); ++i)
+          add_value(fingerprint, list.get(i), follow);
+        break;
+      }
+
+      case grt::DictType: {
+        grt::DictRef dict(grt::DictRef::cast_from(value));
+        fingerprint.add(base::strfmt("{%i", (int)dict.count()));
+        for (grt::DictRef::const_iterator iter = dict.begin(); iter != dict.end(); ++iter) {
+          fingerprint.add(iter->first);
+          add_value(fingerprint, iter->second, follow);
+        }
+        break;
+      }
+
+      case grt::ObjectType: {
+        grt::ObjectRef object(grt::ObjectRef::cast_from(value));
+        fingerprint.add(object.class_name());
+        if (!follow) {
+          fingerprint.add(object.get_string_member("name"));
+          break;
+        }
+
+        grt::MetaClass *meta = object.get_metaclass();
+        do {
+          for (grt::MetaClass::MemberList::const_iterator iter = meta->get_members_partial().begin();
+               iter != meta->get_members_partial().end(); ++iter) {
+            if (iter->second.overrides)
+              continue;
+
+            const std::string &name = iter->second.name;
+            std::string attr = meta->get_member_attribute(name, "dontdiff");
+            if (attr.size() && (base::atoi<int>(attr, 0) & 3))
+              continue;
+
+            const bool member_follow =
+              iter->second.owned_object || name == "flags" || (name == "columns" && !meta->is_a("db.Index"));
+            fingerprint.add(name);
+            add_value(fingerprint, object.get_member(name), member_follow);
+          }
+          meta = meta->parent();
+        } while (meta != 0);
+        break;
+      }
+
+      default:
+        fingerprint.add(value.toString());
+        break;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** ddl_fingerprint()
+
+ Fingerprint of a CREATE statement as the server returns it. The AUTO_INCREMENT table option is left out, the counter
+ changes with the data and is not compared by synchronization.
+ */
+std::string bec::ddl_fingerprint(const std::string &ddl) {
+  static const std::string auto_increment = " AUTO_INCREMENT=";
+
+  // Table options follow the closing parenthesis of the column list.
+  std::string normalized(ddl);
+  size_t options = normalized.rfind(')');
+  size_t start = normalized.find(auto_increment, options == std::string::npos ? 0 : options);
+  if (start != std::string::npos) {
+    size_t end = start + auto_increment.size();
+    while (end < normalized.size() && isdigit((unsigned char)normalized[end]))
+      ++end;
+    normalized.erase(start, end - start);
+  }
+
+  Fingerprint fingerprint;
+  fingerprint.add(normalized);
+  return fingerprint.str();
+}
+
+/** object_fingerprint()
+
+ Fingerprint of everything synchronization compares in the object and the objects it owns, so two objects with the
+ same fingerprint give the same diff result against the same counterpart.
+ */
+std::string bec::object_fingerprint(const grt::ObjectRef &object) {
+  Fingerprint fingerprint;
+  add_value(fingerprint, object, true);
+  return fingerprint.str();
+}
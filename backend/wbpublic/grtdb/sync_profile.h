@@ -29,6 +29,9 @@
 #include "grts/structs.workbench.physical.h"
 #include "wbpublic_public_interface.h"
 
+// customData key of server tables holding the fingerprint of the DDL they were parsed from.
+#define SYNC_DDL_FINGERPRINT_KEY "db.mysql.synchronize:ddlFingerprint"
+
 namespace bec {
   WBPUBLICBACKEND_PUBLIC_FUNC db_mgmt_SyncProfileRef create_sync_profile(workbench_physical_ModelRef model,
                                                                          const std::string &profile_name,
@@ -39,4 +42,8 @@ namespace bec {
   WBPUBLICBACKEND_PUBLIC_FUNC void update_schema_from_sync_profile(db_SchemaRef schema, db_mgmt_SyncProfileRef profile);
   WBPUBLICBACKEND_PUBLIC_FUNC void update_sync_profile_from_schema(db_mgmt_SyncProfileRef profile, db_SchemaRef schema,
                                                                    bool view_code_only = false);
+
+  // Fingerprints to tell cheaply whether a table changed since it was last synchronized.
+  WBPUBLICBACKEND_PUBLIC_FUNC std::string ddl_fingerprint(const std::string &ddl);
+  WBPUBLICBACKEND_PUBLIC_FUNC std::string object_fingerprint(const grt::ObjectRef &object);
 };
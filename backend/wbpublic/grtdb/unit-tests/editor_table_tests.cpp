@@ -796,6 +796,37 @@ TEST_FUNCTION(20) {
   */
 }
 
+TEST_FUNCTION(21) {
+  // column lookups by name must follow adds, renames, reorders and removals
+  db_mysql_TableRef table(grt::Initialized);
+
+  table->owner(wbt->get_schema());
+  table->name("table");
+
+  TestTableEditor editor(table, wbt->get_rdbms());
+
+  editor.add_column("a");
+  editor.add_column("b");
+  editor.add_column("c");
+  ensure("lookup a", editor.get_column_with_name("a") == table->columns()[0]);
+  ensure("lookup c", editor.get_column_with_name("c") == table->columns()[2]);
+
+  editor.rename_column(table->columns()[1], "x");
+  ensure("old name gone", !editor.get_column_with_name("b").is_valid());
+  ensure("lookup renamed", editor.get_column_with_name("x") == table->columns()[1]);
+
+  editor.get_columns()->reorder(2, 0);
+  ensure("lookup after reorder", editor.get_column_with_name("c") == table->columns()[0]);
+  ensure("lookup after reorder 2", editor.get_column_with_name("a") == table->columns()[1]);
+
+  editor.add_column("d");
+  ensure("lookup added", editor.get_column_with_name("d") == table->columns()[3]);
+
+  editor.remove_column(0);
+  ensure("removed gone", !editor.get_column_with_name("c").is_valid());
+  ensure("lookup after remove", editor.get_column_with_name("d") == table->columns()[2]);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
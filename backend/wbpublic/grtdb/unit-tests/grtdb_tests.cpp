@@ -710,6 +710,35 @@ TEST_FUNCTION(30) {
   ensure("5.5.5 vs 6.6.6", !bec::is_supported_mysql_version_at_least(5, 5, 5, 6, 6, 6));
 }
 
+// test the referenced table -> foreign key index
+TEST_FUNCTION(31) {
+  db_mysql_SchemaRef schema(grt::Initialized);
+  db_mysql_TableRef parent(grt::Initialized);
+  db_mysql_TableRef child(grt::Initialized);
+
+  parent->owner(schema);
+  child->owner(schema);
+  schema->tables().insert(parent);
+  schema->tables().insert(child);
+
+  db_mysql_ForeignKeyRef fk(grt::Initialized);
+  fk->owner(child);
+  fk->referencedTable(parent);
+  child->foreignKeys().insert(fk);
+
+  ensure_equals("FK referencing parent", schema->getForeignKeysReferencingTable(parent).count(), 1U);
+  ensure_equals("no FK referencing child", schema->getForeignKeysReferencingTable(child).count(), 0U);
+
+  // FKs of tables removed from the schema are no longer indexed, but come back with the table.
+  schema->tables().remove_value(child);
+  ensure_equals("FK of removed table", schema->getForeignKeysReferencingTable(parent).count(), 0U);
+  schema->tables().insert(child);
+  ensure_equals("FK of re-added table", schema->getForeignKeysReferencingTable(parent).count(), 1U);
+
+  child->foreignKeys().remove_value(fk);
+  ensure_equals("removed FK", schema->getForeignKeysReferencingTable(parent).count(), 0U);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -28,6 +28,7 @@
 #include "grtdb/db_object_helpers.h"
 #include "base/string_utilities.h"
 #include "sqlide/recordset_be.h"
+#include "sqlide/table_inserts_loader_be.h"
 #include "wb_helpers.h"
 
 using namespace grt;
@@ -430,6 +431,23 @@ TEST_FUNCTION(15) {
                 "INSERT INTO `table` (`id`, `name`, `ts`, `pic`) VALUES (DEFAULT, DEFAULT, NOW(), NULL);\n");
 }
 
+TEST_FUNCTION(16) {
+  // loading an inserts script, rows go straight to the inserts storage of the table
+  db_TableRef table(make_inserts_test_table(wbt->get_rdbms(), wbt->get_catalog()));
+
+  TableInsertsLoader loader;
+  loader.process_table(table,
+                       "INSERT INTO `table` (`id`, `name`, `ts`) VALUES (1, 'a', '2012-01-01'), (2, 'b', NULL);\n"
+                       "INSERT INTO `other` (`id`) VALUES (5);\n"
+                       "INSERT INTO `table` (`id`, `extra`) VALUES (3, 'x');\n");
+
+  std::string output = table->inserts();
+  ensure_equals("loaded sql", output,
+                "INSERT INTO `table` (`id`, `name`, `ts`, `pic`) VALUES (1, 'a', '2012-01-01', NULL);\n"
+                "INSERT INTO `table` (`id`, `name`, `ts`, `pic`) VALUES (2, 'b', NULL, NULL);\n"
+                "INSERT INTO `table` (`id`, `name`, `ts`, `pic`) VALUES (3, NULL, NULL, NULL);\n");
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -59,6 +59,9 @@ namespace parsers {
 
     virtual Scanner createScanner() = 0;
 
+    // A context with the same settings, to parse on another thread than this one.
+    virtual Ref clone() const = 0;
+
     // Identifier determination depends on e.g the sql mode, hence we need extra handling.
     virtual bool isIdentifier(size_t type) const = 0;
   };
@@ -47,6 +47,8 @@ public:
   virtual ~Sql_inserts_loader() {
   }
 
+  // Parses the script one statement at a time and calls the process_insert callback for every row as soon as its
+  // statement is recognized, so neither the parse trees nor the values of the whole script are kept.
   virtual void load(const std::string &sql, const std::string &schema_name) = 0;
 
   typedef std::vector<std::string> Strings;
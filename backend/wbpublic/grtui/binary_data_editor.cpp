@@ -30,10 +30,16 @@
 #include <glib/gstdio.h>
 #ifdef _WIN32
 #include <io.h>
+#else
+#include <unistd.h>
 #endif
 
 DEFAULT_LOG_DOMAIN("BlobViewer");
 
+#define MAPPED_VALUE_SIZE (16 * 1024 * 1024)  // values from this size on are kept in a mapped temporary file
+#define MAPPED_VALUE_WRITE_CHUNK (1024 * 1024) // bytes written to the temporary file at a time
+#define TEXT_PAGE_SIZE (4 * 1024 * 1024)       // larger values are shown as text a page at a time, read-only
+
 #include "mforms/scrollpanel.h"
 #include "mforms/imagebox.h"
 #include "mforms/textbox.h"
@@ -222,13 +228,24 @@ private:
 class TextDataViewer : public BinaryDataViewer {
 public:
   TextDataViewer(BinaryDataEditor *owner, const std::string &encoding, bool read_only)
-    : BinaryDataViewer(owner), _text(), _encoding(encoding) {
+    : BinaryDataViewer(owner), _text(), _encoding(encoding), _pager(true), _offset(0), _paged(false) {
     if (_encoding.empty())
       _encoding = "UTF-8";
 
     add(&_message, false, true);
+    add_end(&_pager, false, true);
     add_end(&_text, true, true);
 
+    _pager.set_spacing(8);
+    _pager.add(&_previous, false, true);
+    _pager.add(&_next, false, true);
+    _pager.add(&_range, true, true);
+    _previous.set_text("< Previous");
+    _next.set_text("Next >");
+    scoped_connect(_previous.signal_clicked(), std::bind(&TextDataViewer::go, this, -1));
+    scoped_connect(_next.signal_clicked(), std::bind(&TextDataViewer::go, this, 1));
+    _pager.show(false);
+
     _text.set_language(mforms::LanguageNone);
     _text.set_features(mforms::FeatureWrapText, true);
     _text.set_features(mforms::FeatureReadOnly, read_only);
@@ -239,6 +256,16 @@ public:
   }
 
   virtual void data_changed() {
+    // Putting hundreds of MB into the text editor would block the UI, so large values are only viewed by pages.
+    _paged = _owner->length() > TEXT_PAGE_SIZE;
+    _pager.show(_paged);
+    if (_paged) {
+      if (_offset >= _owner->length())
+        _offset = 0;
+      show_page();
+      return;
+    }
+
     GError *error = 0;
     gchar *converted = NULL;
     gsize bread, bwritten;
@@ -275,8 +302,59 @@ private:
   mforms::CodeEditor _text;
   mforms::Label _message;
   std::string _encoding;
+  mforms::Box _pager;
+  mforms::Button _previous;
+  mforms::Button _next;
+  mforms::Label _range;
+  size_t _offset;
+  bool _paged;
+
+  void go(int step) {
+    if (step < 0)
+      _offset = _offset > TEXT_PAGE_SIZE ? _offset - TEXT_PAGE_SIZE : 0;
+    else if (_offset + TEXT_PAGE_SIZE < _owner->length())
+      _offset += TEXT_PAGE_SIZE;
+    show_page();
+  }
+
+  void show_page() {
+    const char *data = _owner->data();
+    size_t start = _offset;
+    size_t end = std::min<size_t>(start + TEXT_PAGE_SIZE, _owner->length());
+
+    // Pages of UTF-8 text must not cut a character in two.
+    if (base::tolower(_encoding) == "utf-8" || base::tolower(_encoding) == "utf8") {
+      while (start > 0 && ((unsigned char)data[start] & 0xC0) == 0x80)
+        --start;
+      while (end < _owner->length() && ((unsigned char)data[end] & 0xC0) == 0x80)
+        --end;
+    }
+
+    gsize bread, bwritten;
+    gchar *converted =
+      g_convert(data + start, (gssize)(end - start), "UTF-8", _encoding.c_str(), &bread, &bwritten, NULL);
+    bool converted_page = converted != NULL;
+    _text.set_features(mforms::FeatureReadOnly, false);
+    _text.set_value(converted_page ? std::string(converted, bwritten) : std::string());
+    _text.set_features(mforms::FeatureReadOnly, true);
+    g_free(converted);
+
+    if (converted_page)
+      _message.set_text("The value is too large to be edited as text, change it in the Binary tab or load a file.");
+    else
+      _message.set_text("Data could not be converted to UTF-8 text");
+    _range.set_text(base::strfmt("Viewing Range %s to %s of %s", base::sizefmt((int64_t)start, false).c_str(),
+                                 base::sizefmt((int64_t)end, false).c_str(),
+                                 base::sizefmt((int64_t)_owner->length(), false).c_str()));
+    _previous.set_enabled(start > 0);
+    _next.set_enabled(end < _owner->length());
+  }
 
   void edited() {
+    // Only the page is in the editor, and it is read-only anyway.
+    if (_paged)
+      return;
+
     std::string data = _text.get_string_value();
     gchar *converted;
     gsize bread, bwritten;
@@ -455,11 +533,64 @@ private:
 
 //--------------------------------------------------------------------------------
 
+/**
+ * Maps a file privately, edits change the mapped pages but never the file.
+ */
+static GMappedFile *map_file(const std::string &path) {
+  GError *error = NULL;
+  GMappedFile *mapped_file = g_mapped_file_new(path.c_str(), TRUE, &error);
+  if (!mapped_file) {
+    logWarning("Could not map %s: %s\n", path.c_str(), error->message);
+    g_error_free(error);
+  }
+  return mapped_file;
+}
+
+//--------------------------------------------------------------------------------
+
+/**
+ * Writes a value to a temporary file and maps it, so the value no longer takes memory the system can't page out.
+ */
+static GMappedFile *map_copy(const char *data, size_t length, std::string &temp_file) {
+  GError *error = NULL;
+  gchar *path = NULL;
+  int fd = g_file_open_tmp("wb_blob_XXXXXX", &path, &error);
+  if (fd < 0) {
+    logWarning("Could not create a temporary file for a value of %s: %s\n",
+               base::sizefmt((int64_t)length, false).c_str(), error->message);
+    g_error_free(error);
+    return NULL;
+  }
+  temp_file = path;
+  g_free(path);
+
+  bool written = true;
+  for (size_t offset = 0; written && offset < length; offset += MAPPED_VALUE_WRITE_CHUNK) {
+    unsigned int chunk = (unsigned int)std::min<size_t>(length - offset, MAPPED_VALUE_WRITE_CHUNK);
+    written = write(fd, data + offset, chunk) == (int)chunk;
+  }
+  close(fd);
+
+  GMappedFile *mapped_file = NULL;
+  if (!written)
+    logWarning("Could not write %s\n", temp_file.c_str());
+  else
+    mapped_file = map_file(temp_file);
+  if (!mapped_file) {
+    g_remove(temp_file.c_str());
+    temp_file.clear();
+  }
+  return mapped_file;
+}
+
+//--------------------------------------------------------------------------------
+
 BinaryDataEditor::BinaryDataEditor(const char *data, size_t length, bool read_only)
   : mforms::Form(0), _box(false), _hbox(true), _read_only(read_only) {
   set_name("blob_editor");
   _data = 0;
   _length = 0;
+  _mapped_file = NULL;
 
   grt::IntegerRef tab = grt::IntegerRef::cast_from(bec::GRTManager::get()->get_app_option("BlobViewer:DefaultTab"));
 
@@ -491,6 +622,7 @@ BinaryDataEditor::BinaryDataEditor(const char *data, size_t length, const std::s
   set_name("blob_editor");
   _data = 0;
   _length = 0;
+  _mapped_file = NULL;
   _updating = false;
 
   grt::IntegerRef tab = grt::IntegerRef::cast_from(bec::GRTManager::get()->get_app_option("BlobViewer:DefaultTab"));
@@ -523,7 +655,7 @@ BinaryDataEditor::BinaryDataEditor(const char *data, size_t length, const std::s
 }
 
 BinaryDataEditor::~BinaryDataEditor() {
-  g_free(_data);
+  set_value(NULL, 0, NULL, "");
 }
 
 void BinaryDataEditor::setup() {
@@ -570,20 +702,45 @@ void BinaryDataEditor::assign_data(const char *data, size_t length, bool steal_p
     return;
 
   if (data != _data) {
-    g_free(_data);
     if (steal_pointer)
-      _data = (char *)data;
-    else
-      _data = (char *)g_memdup(data, (guint)length);
-
-    for (size_t i = 0; i < _viewers.size(); i++)
-      _pendingUpdates.insert(_viewers[i]);
+      set_value((char *)data, length, NULL, "");
+    else {
+      std::string temp_file;
+      GMappedFile *mapped_file = length >= MAPPED_VALUE_SIZE ? map_copy(data, length, temp_file) : NULL;
+      if (mapped_file)
+        set_value(g_mapped_file_get_contents(mapped_file), length, mapped_file, temp_file);
+      else
+        set_value((char *)g_memdup(data, (guint)length), length, NULL, "");
+    }
   }
   _length = length;
 
   _length_text.set_text(base::strfmt("Data Length: %i bytes", (int)_length));
 }
 
+//--------------------------------------------------------------------------------
+
+/**
+ * Replaces the value, which is either allocated with g_malloc() or the contents of mapped_file. The old value is
+ * released only now, as the new one may have been copied from it.
+ */
+void BinaryDataEditor::set_value(char *data, size_t length, GMappedFile *mapped_file, const std::string &temp_file) {
+  if (_mapped_file) {
+    g_mapped_file_unref(_mapped_file);
+    if (!_temp_file.empty())
+      g_remove(_temp_file.c_str());
+  } else
+    g_free(_data);
+
+  _data = data;
+  _length = length;
+  _mapped_file = mapped_file;
+  _temp_file = temp_file;
+
+  for (size_t i = 0; i < _viewers.size(); i++)
+    _pendingUpdates.insert(_viewers[i]);
+}
+
 void BinaryDataEditor::tab_changed() {
   int i = _tab_view.get_active_tab();
   if (i < 0)
@@ -617,7 +774,8 @@ void BinaryDataEditor::add_viewer(BinaryDataViewer *viewer, const std::string &t
 }
 
 void BinaryDataEditor::add_json_viewer(bool read_only, const std::string &text_encoding, const std::string &title) {
-  if (!data())
+  // Parsing a value that large would block the UI, it can still be viewed as text.
+  if (!data() || length() >= MAPPED_VALUE_SIZE)
     return;
   GError *error = NULL;
   gsize bread = 0, bwritten = 0;
@@ -660,6 +818,18 @@ void BinaryDataEditor::import_value() {
     char *data;
     gsize length;
 
+    // Large files are used in place rather than read into memory.
+    GStatBuf info;
+    if (g_stat(path.c_str(), &info) == 0 && (size_t)info.st_size >= MAPPED_VALUE_SIZE) {
+      GMappedFile *mapped_file = map_file(path);
+      if (mapped_file) {
+        set_value(g_mapped_file_get_contents(mapped_file), g_mapped_file_get_length(mapped_file), mapped_file, "");
+        _length_text.set_text(base::strfmt("Data Length: %i bytes", (int)_length));
+        tab_changed();
+        return;
+      }
+    }
+
     if (!g_file_get_contents(path.c_str(), &data, &length, &error)) {
       mforms::Utilities::show_error(base::strfmt("Could not import data from %s", path.c_str()), error->message, "OK");
       g_error_free(error);
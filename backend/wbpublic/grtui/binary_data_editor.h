@@ -36,6 +36,8 @@ namespace bec {
   class GRTManager;
 };
 
+typedef struct _GMappedFile GMappedFile;
+
 class BinaryDataEditor;
 
 class WBPUBLICBACKEND_PUBLIC_FUNC BinaryDataViewer : public mforms::Box {
@@ -84,6 +86,10 @@ protected:
   size_t _length;
   std::string _type;
 
+  // Large values are kept in a private mapping of a file instead of the heap, edits stay in the mapped pages.
+  GMappedFile *_mapped_file;
+  std::string _temp_file; // removed when the value is replaced, if the mapping is of a copy
+
   std::vector<BinaryDataViewer *> _viewers;
   std::set<BinaryDataViewer *> _pendingUpdates;
   bool _updating;
@@ -100,6 +106,7 @@ protected:
   bool _read_only;
 
   void setup();
+  void set_value(char *data, size_t length, GMappedFile *mapped_file, const std::string &temp_file);
   void save();
   void tab_changed();
 
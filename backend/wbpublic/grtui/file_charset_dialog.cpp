@@ -35,6 +35,7 @@
 #include <mforms/utilities.h>
 
 #include "grts/structs.db.h"
+#include "grtdb/charset_utils.h"
 
 using namespace mforms;
 using namespace base;
@@ -163,7 +164,7 @@ retry:
       retrying = true; // in case we fail..
     }
 
-    converted = g_convert(data, (gssize)length, "UTF-8", charset.c_str(), &bytes_read, &bytes_written, &error);
+    converted = convertToUtf8(data, (gssize)length, charset, &bytes_read, &bytes_written, &error);
     if (!converted) {
       int res;
 
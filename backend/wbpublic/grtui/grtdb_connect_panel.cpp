@@ -30,6 +30,8 @@
 #include "base/log.h"
 #include "base/file_utilities.h"
 
+#include <chrono>
+
 #include "mforms/uistyle.h"
 #include "mforms/utilities.h"
 #include "mforms/checkbox.h"
@@ -40,6 +42,11 @@
 
 #define MYSQL_RDBMS_ID "com.mysql.rdbms.mysql"
 
+#define SSH_BENCHMARK_QUERY "SELECT * FROM information_schema.COLUMNS"
+#define SSH_BENCHMARK_RUNS 3
+// zlib's own default, used when the connection itself has compression disabled.
+#define SSH_BENCHMARK_COMPRESSION_LEVEL 6
+
 DEFAULT_LOG_DOMAIN("DbConnectPanel");
 
 using namespace base;
@@ -695,6 +702,74 @@ bool DbConnectPanel::test_connection() {
   return ret_val;
 }
 
+/**
+ * Runs the query SSH_BENCHMARK_RUNS times on a connection with the given SSH compression level and returns the
+ * result bytes fetched per second.
+ */
+static double measure_ssh_throughput(db_mgmt_ConnectionRef connectionProperties, int level, const std::string &query) {
+  db_mgmt_ConnectionRef probe(grt::Initialized);
+  probe->owner(connectionProperties->owner());
+  probe->driver(connectionProperties->driver());
+  grt::merge_contents(probe->parameterValues(), connectionProperties->parameterValues(), true);
+  probe->hostIdentifier(connectionProperties->hostIdentifier());
+  probe->parameterValues().set("sshCompressionLevel", grt::IntegerRef(level));
+
+  sql::ConnectionWrapper dbc_conn = sql::DriverManager::getDriverManager()->getConnection(probe);
+  std::auto_ptr<sql::Statement> stmt(dbc_conn->createStatement());
+
+  uint64_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < SSH_BENCHMARK_RUNS; ++i) {
+    std::auto_ptr<sql::ResultSet> result(stmt->executeQuery(query));
+    unsigned int columns = result->getMetaData()->getColumnCount();
+    while (result->next()) {
+      for (unsigned int column = 1; column <= columns; ++column)
+        bytes += result->getString(column).size();
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  return elapsed.count() > 0 ? bytes / elapsed.count() : 0;
+}
+
+/**
+ * Compares the throughput of a sample query through the SSH tunnel with and without SSH compression.
+ */
+void DbConnectPanel::benchmark_ssh_compression() {
+  db_mgmt_ConnectionRef connectionProperties = get_be()->get_connection();
+  if (!connectionProperties.is_valid() || connectionProperties->driver()->name() != "MysqlNativeSSH") {
+    mforms::Utilities::show_message(_("SSH Compression Benchmark"),
+                                    _("The benchmark is only available for connections over SSH."), _("OK"));
+    return;
+  }
+
+  std::string query;
+  if (!mforms::Utilities::request_input(_("SSH Compression Benchmark"), _("Query to fetch through the tunnel:"),
+                                        SSH_BENCHMARK_QUERY, query) ||
+      query.empty())
+    return;
+
+  get_be()->save_changes();
+  int level = (int)connectionProperties->parameterValues().get_int("sshCompressionLevel", 0);
+  if (level <= 0)
+    level = SSH_BENCHMARK_COMPRESSION_LEVEL;
+
+  try {
+    double uncompressed = measure_ssh_throughput(connectionProperties, 0, query);
+    double compressed = measure_ssh_throughput(connectionProperties, level, query);
+
+    std::string message = strfmt(_("Without compression: %s/s\nWith compression level %i: %s/s\n\n"),
+                                 sizefmt((int64_t)uncompressed, false).c_str(), level,
+                                 sizefmt((int64_t)compressed, false).c_str());
+    if (uncompressed > 0)
+      message += strfmt(_("Compression makes this query %.1fx as fast."), compressed / uncompressed);
+    mforms::Utilities::show_message(_("SSH Compression Benchmark"), message, _("OK"));
+  } catch (const std::exception &e) {
+    if (std::string(e.what()) != "Operation Cancelled")
+      mforms::Utilities::show_error(_("SSH Compression Benchmark"), e.what(), _("OK"));
+  }
+}
+
 void DbConnectPanel::set_active_stored_conn(const std::string &name) {
   if (name.empty())
     _connection->set_connection_keeping_parameters(_anonymous_connection);
@@ -97,6 +97,7 @@ namespace grtui {
     };
 
     bool test_connection();
+    void benchmark_ssh_compression();
 
     void connection_user_input(std::string &text_entry, bool &create_group, bool new_entry = true);
 
@@ -95,17 +95,23 @@ void grtui::DbConnectionEditor::init() {
   _bottom_hbox.add_end(&_ok_button, false, true);
   //  _bottom_hbox.add_end(&_cancel_button, false, true);
   _bottom_hbox.add_end(&_test_button, false, true);
+  _bottom_hbox.add_end(&_benchmark_button, false, true);
 
   _ok_button.set_text(_("Close"));
   scoped_connect(_ok_button.signal_clicked(), std::bind(&DbConnectionEditor::ok_clicked, this));
   _test_button.set_text(_("Test Connection"));
   scoped_connect(_test_button.signal_clicked(), std::bind(&DbConnectPanel::test_connection, std::ref(_panel)));
+  _benchmark_button.set_text(_("Benchmark SSH Compression"));
+  _benchmark_button.set_tooltip(_("Compare the speed of a query through the SSH tunnel with and without compression"));
+  scoped_connect(_benchmark_button.signal_clicked(),
+                 std::bind(&DbConnectPanel::benchmark_ssh_compression, std::ref(_panel)));
 
   _add_conn_button.enable_internal_padding(true);
   _del_conn_button.enable_internal_padding(true);
   _ok_button.enable_internal_padding(true);
   _cancel_button.enable_internal_padding(true);
   _test_button.enable_internal_padding(true);
+  _benchmark_button.enable_internal_padding(true);
 
   _stored_connection_list.set_size(180, -1);
 
@@ -293,6 +299,7 @@ void grtui::DbConnectionEditor::change_active_stored_conn() {
     _panel.resume_layout();
 
     _test_button.set_enabled(true);
+    _benchmark_button.set_enabled(true);
     _del_conn_button.set_enabled(true);
     _dup_conn_button.set_enabled(true);
     _move_up_button.set_enabled(true);
@@ -300,6 +307,7 @@ void grtui::DbConnectionEditor::change_active_stored_conn() {
   } else {
     _panel.set_enabled(false);
     _test_button.set_enabled(false);
+    _benchmark_button.set_enabled(false);
     _del_conn_button.set_enabled(false);
     _dup_conn_button.set_enabled(false);
     _move_up_button.set_enabled(false);
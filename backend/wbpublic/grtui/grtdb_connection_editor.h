@@ -65,6 +65,7 @@ namespace grtui {
     mforms::Button _ok_button;
     mforms::Button _cancel_button;
     mforms::Button _test_button;
+    mforms::Button _benchmark_button;
 
     bool _mysql_only;
 
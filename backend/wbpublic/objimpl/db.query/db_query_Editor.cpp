@@ -144,6 +144,23 @@ void db_query_Editor::executeManagementCommand(const std::string &sql, ssize_t l
     _data->executeManagementCommand(sql, log != 0);
 }
 
+grt::DictRef db_query_Editor::importTableData(const grt::DictRef &options) {
+  if (_data)
+    return _data->importTableData(options);
+  return grt::DictRef();
+}
+
+grt::DictListRef db_query_Editor::queryStatistics(const std::string &order, ssize_t limit) {
+  if (_data)
+    return _data->queryStatistics(order, limit);
+  return grt::DictListRef();
+}
+
+void db_query_Editor::clearQueryStatistics() {
+  if (_data)
+    _data->clearQueryStatistics();
+}
+
 db_query_ResultsetRef db_query_Editor::executeQuery(const std::string &sql, ssize_t log) {
   if (_data)
     return _data->executeQuery(sql, log != 0);
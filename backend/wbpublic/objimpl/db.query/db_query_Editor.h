@@ -62,6 +62,9 @@ public:
 
   virtual db_query_ResultsetRef executeManagementQuery(const std::string &sql, bool log) = 0;
   virtual void executeManagementCommand(const std::string &sql, bool log) = 0;
+  virtual grt::DictRef importTableData(const grt::DictRef &options) = 0;
+  virtual grt::DictListRef queryStatistics(const std::string &order, ssize_t limit) = 0;
+  virtual void clearQueryStatistics() = 0;
 };
 
 #endif
@@ -37,16 +37,15 @@ using namespace base;
 //================================================================================
 // db_Column
 
-static void notify_visible_member_change(const std::string &member, const grt::ValueRef &ovalue, db_Column *ref) {
-  if (member == "name" || member == "simpleType" || member == "userType") {
-    if (ovalue != ref->get_member(member) && ref->owner().is_valid())
-      (*db_TableRef::cast_from(ref->owner())->signal_refreshDisplay())("column");
-  }
+void db_Column::init() {
 }
 
-void db_Column::init() {
-  // No need to disconnect management since the signal is part of the object.
-  _changed_signal.connect(std::bind(notify_visible_member_change, std::placeholders::_1, std::placeholders::_2, this));
+// Overridden instead of connecting to the change signal, so columns don't need one each.
+void db_Column::member_value_changed(const std::string &member, const grt::ValueRef &ovalue) {
+  if (member == "name" || member == "simpleType" || member == "userType") {
+    if (ovalue != get_member(member) && owner().is_valid())
+      (*db_TableRef::cast_from(owner())->signal_refreshDisplay())("column");
+  }
 }
 
 db_Column::~db_Column() {
@@ -63,6 +63,19 @@ void add_foreign_key_mapping(const db_TableRef &table, db_ForeignKey *fk) {
   }
 }
 
+// Called by the schema when a table is added to or removed from it, so the FKs of tables that are no longer part of
+// the catalog (deleted tables held by the undo stack, for instance) are not reported as referencing anything.
+void update_table_foreign_key_mappings(const db_TableRef &table, bool added) {
+  for (grt::ListRef<db_ForeignKey>::const_iterator end = table->foreignKeys().end(), fk = table->foreignKeys().begin();
+       fk != end; ++fk) {
+    db_ForeignKey *key = dynamic_cast<db_ForeignKey *>((*fk).valueptr());
+    if (added)
+      add_foreign_key_mapping((*fk)->referencedTable(), key);
+    else
+      delete_foreign_key_mapping((*fk)->referencedTable(), key);
+  }
+}
+
 db_ForeignKey::~db_ForeignKey() {
   if (_referencedTable.is_valid())
     delete_foreign_key_mapping(_referencedTable, this);
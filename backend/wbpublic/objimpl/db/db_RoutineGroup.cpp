@@ -35,7 +35,7 @@ static void routine_group_list_changed(grt::internal::OwnedList *list, bool adde
 
 void db_RoutineGroup::init() {
   // No need in disconnet management since signal it part of object
-  _list_changed_signal.connect(
+  signal_list_changed()->connect(
     std::bind(&routine_group_list_changed, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, this));
 }
 
@@ -36,7 +36,20 @@ using namespace base;
 //================================================================================
 // db_Schema
 
+// from db_ForeignKey.cpp
+extern void update_table_foreign_key_mappings(const db_TableRef &table, bool added);
+
+static void schema_list_changed(grt::internal::OwnedList *list, bool added, const grt::ValueRef &value,
+                                db_Schema *schema) {
+  // Keep the referenced table -> FK index limited to tables that are part of the schema.
+  if (schema->tables().valueptr() == list)
+    update_table_foreign_key_mappings(db_TableRef::cast_from(value), added);
+}
+
 void db_Schema::init() {
+  // No need in disconnet management since signal it part of object
+  signal_list_changed()->connect(
+    std::bind(&schema_list_changed, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, this));
 }
 
 db_Schema::~db_Schema() {
@@ -25,6 +25,7 @@
 #include <sqlite/query.hpp>
 #include <sqlite/database_exception.hpp>
 #include <glib.h>
+#include <algorithm>
 
 #include "base/string_utilities.h"
 #include "base/log.h"
@@ -64,9 +65,11 @@ ColumnWidthCache::ColumnWidthCache(const std::string &connection_id, const std::
     logDebug3("Initializing cache\n");
     init_db();
   }
+  init_autofit_db();
 }
 
 ColumnWidthCache::~ColumnWidthCache() {
+  flush();
   delete _sqconn;
 }
 
@@ -81,34 +84,59 @@ void ColumnWidthCache::init_db() {
   }
 }
 
-void ColumnWidthCache::save_column_width(const std::string &column_id, int width) {
+void ColumnWidthCache::init_autofit_db() {
+  std::string code = "create table if not exists autofit_widths (query_id varchar(32) primary key, widths text)";
   try {
-    sqlite::query q(*_sqconn, "insert or replace into widths values (?, ?)");
-    q.bind(1, column_id);
-    q.bind(2, width);
-    q.emit();
+    sqlite::execute(*_sqconn, code, true);
   } catch (std::exception &exc) {
-    logError("Error storing column width to cache %s: %s\n", column_id.c_str(), exc.what());
+    logError("Error creating cache %s: %s\n", code.c_str(), exc.what());
   }
 }
 
+void ColumnWidthCache::save_column_width(const std::string &column_id, int width) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _pending_widths[column_id] = width;
+}
+
 void ColumnWidthCache::save_columns_width(const std::map<std::string, int> &columns) {
-  std::map<std::string, int>::const_iterator it;
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto &column : columns)
+    _pending_widths[column.first] = column.second;
+  flush_pending_widths();
+}
+
+void ColumnWidthCache::flush() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  flush_pending_widths();
+}
+
+void ColumnWidthCache::flush_pending_widths() {
+  if (_pending_widths.empty())
+    return;
+
+  std::map<std::string, int>::const_iterator it = _pending_widths.begin();
   try {
     sqlide::Sqlite_transaction_guarder transaction(_sqconn);
     sqlite::query q(*_sqconn, "insert or replace into widths values (?, ?)");
-    for (it = columns.begin(); it != columns.end(); ++it) {
+    for (; it != _pending_widths.end(); ++it) {
       q.bind(1, it->first);
       q.bind(2, it->second);
       q.emit();
       q.clear();
     }
+    transaction.commit();
   } catch (std::exception &exc) {
     logError("Error storing column width to cache %s: %s\n", it->first.c_str(), exc.what());
   }
+  _pending_widths.clear();
 }
 
 int ColumnWidthCache::get_column_width(const std::string &column_id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::map<std::string, int>::const_iterator pending = _pending_widths.find(column_id);
+  if (pending != _pending_widths.end())
+    return pending->second;
+
   sqlite::query q(*_sqconn, "select width from widths where column_id = ?");
   q.bind(1, column_id);
   try {
@@ -122,7 +150,46 @@ int ColumnWidthCache::get_column_width(const std::string &column_id) {
   return -1;
 }
 
+/*
+ * Widths of the given columns which have one stored, read with a query per batch of columns instead of one for each.
+ */
+std::map<std::string, int> ColumnWidthCache::get_columns_width(const std::vector<std::string> &column_ids) {
+  static const size_t BATCH_SIZE = 500; // stays below the bound parameter limit of SQLite
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::map<std::string, int> widths;
+  try {
+    for (size_t begin = 0; begin < column_ids.size(); begin += BATCH_SIZE) {
+      size_t end = std::min(begin + BATCH_SIZE, column_ids.size());
+      std::string sql = "select column_id, width from widths where column_id in (?";
+      for (size_t i = begin + 1; i < end; ++i)
+        sql.append(", ?");
+      sql.append(")");
+
+      sqlite::query q(*_sqconn, sql);
+      for (size_t i = begin; i < end; ++i)
+        q.bind((int)(i - begin + 1), column_ids[i]);
+      if (q.emit()) {
+        std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+        do
+          widths[res->get_string(0)] = res->get_int(1);
+        while (res->next_row());
+      }
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading column widths from cache: %s\n", exc.what());
+  }
+
+  for (auto &pending : _pending_widths)
+    if (std::find(column_ids.begin(), column_ids.end(), pending.first) != column_ids.end())
+      widths[pending.first] = pending.second;
+  return widths;
+}
+
 void ColumnWidthCache::delete_column_width(const std::string &column_id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _pending_widths.erase(column_id);
+
   sqlite::query q(*_sqconn, "delete from widths where column_id = ?");
   q.bind(1, column_id);
   try {
@@ -131,3 +198,74 @@ void ColumnWidthCache::delete_column_width(const std::string &column_id) {
     logDebug("Error deleting column width to cache %s: %s\n", column_id.c_str(), exc.what());
   }
 }
+
+/*
+ * Identifies a result by its query, with white space collapsed, and the columns it returned.
+ */
+std::string ColumnWidthCache::query_fingerprint(const std::string &query, const std::vector<std::string> &column_ids) {
+  std::string text;
+  text.reserve(query.size());
+  bool space = false;
+  for (char c : query) {
+    if (g_ascii_isspace(c))
+      space = !text.empty();
+    else {
+      if (space)
+        text.push_back(' ');
+      space = false;
+      text.push_back(c);
+    }
+  }
+  for (const std::string &column_id : column_ids)
+    text.append(1, '\0').append(column_id);
+
+  gchar *checksum = g_compute_checksum_for_data(G_CHECKSUM_MD5, (const guchar *)text.data(), text.size());
+  std::string fingerprint(checksum);
+  g_free(checksum);
+  return fingerprint;
+}
+
+void ColumnWidthCache::save_autofit_widths(const std::string &fingerprint, const std::vector<int> &widths) {
+  std::string text;
+  for (int width : widths)
+    text.append(text.empty() ? "" : ",").append(std::to_string(width));
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::query q(*_sqconn, "insert or replace into autofit_widths values (?, ?)");
+    q.bind(1, fingerprint);
+    q.bind(2, text);
+    q.emit();
+  } catch (std::exception &exc) {
+    logError("Error storing fitted column widths to cache %s: %s\n", fingerprint.c_str(), exc.what());
+  }
+}
+
+std::vector<int> ColumnWidthCache::get_autofit_widths(const std::string &fingerprint) {
+  std::vector<int> widths;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::query q(*_sqconn, "select widths from autofit_widths where query_id = ?");
+    q.bind(1, fingerprint);
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      for (const std::string &width : base::split(res->get_string(0), ","))
+        widths.push_back(base::atoi<int>(width, 0));
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading fitted column widths from cache %s: %s\n", fingerprint.c_str(), exc.what());
+  }
+  return widths;
+}
+
+void ColumnWidthCache::delete_autofit_widths(const std::string &fingerprint) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  sqlite::query q(*_sqconn, "delete from autofit_widths where query_id = ?");
+  q.bind(1, fingerprint);
+  try {
+    q.emit();
+  } catch (std::exception &exc) {
+    logDebug("Error deleting fitted column widths from cache %s: %s\n", fingerprint.c_str(), exc.what());
+  }
+}
@@ -25,13 +25,24 @@
 
 #include <sqlite/connection.hpp>
 
+#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
+/*
+ * Column widths set by the user, by column, and the widths fitted to the values of a query's result, by query
+ * fingerprint. Widths saved one by one are written together by the next flush().
+ */
 class WBPUBLICBACKEND_PUBLIC_FUNC ColumnWidthCache {
   std::string _connection_id;
   sqlite::connection *_sqconn;
+  std::mutex _mutex; // widths of resized columns are stored from a worker thread
+  std::map<std::string, int> _pending_widths;
 
   void init_db();
+  void init_autofit_db();
+  void flush_pending_widths();
 
 public:
   ColumnWidthCache(const std::string &connection_id, const std::string &cache_dir);
@@ -39,6 +50,13 @@ public:
 
   void save_column_width(const std::string &column_id, int width);
   void save_columns_width(const std::map<std::string, int> &columns);
+  void flush();
   int get_column_width(const std::string &column_id);
+  std::map<std::string, int> get_columns_width(const std::vector<std::string> &column_ids);
   void delete_column_width(const std::string &column_id);
+
+  static std::string query_fingerprint(const std::string &query, const std::vector<std::string> &column_ids);
+  void save_autofit_widths(const std::string &fingerprint, const std::vector<int> &widths);
+  std::vector<int> get_autofit_widths(const std::string &fingerprint);
+  void delete_autofit_widths(const std::string &fingerprint);
 };
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2007, 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "packed_data.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+static_assert(sizeof(long double) <= 16, "long double values must fit into an arena entry");
+
+//--------------------------------------------------------------------------------------------------
+
+class Packed_data::Packer : public boost::static_visitor<void> {
+public:
+  Packer(Packed_data *data, Slot &slot) : _data(data), _slot(slot) {
+  }
+
+  result_type operator()(const sqlite::unknown_t &) {
+    _slot.tag = UnknownTag;
+  }
+
+  result_type operator()(const sqlite::null_t &) {
+    _slot.tag = NullTag;
+  }
+
+  result_type operator()(int v) {
+    _slot.tag = IntTag;
+    memcpy(_slot.payload, &v, sizeof(v));
+  }
+
+  result_type operator()(const std::int64_t &v) {
+    _slot.tag = Int64Tag;
+    memcpy(_slot.payload, &v, sizeof(v));
+  }
+
+  result_type operator()(const long double &v) {
+    _slot.tag = LongDoubleTag;
+    if (sizeof(v) <= sizeof(_slot.payload))
+      memcpy(_slot.payload, &v, sizeof(v));
+    else {
+      std::uint64_t offset = _data->_arena.size();
+      const char *bytes = reinterpret_cast<const char *>(&v);
+      _data->_arena.insert(_data->_arena.end(), bytes, bytes + sizeof(v));
+      memcpy(_slot.payload, &offset, sizeof(offset));
+    }
+  }
+
+  result_type operator()(const std::string &v) {
+    if (v.size() <= sizeof(_slot.payload)) {
+      _slot.tag = InlineStringTag;
+      _slot.length = (std::uint8_t)v.size();
+      memcpy(_slot.payload, v.data(), v.size());
+    } else if (v.size() <= std::numeric_limits<std::uint32_t>::max()) {
+      _slot.tag = ArenaStringTag;
+      std::uint64_t offset = _data->_arena.size();
+      std::uint32_t length = (std::uint32_t)v.size();
+      _data->_arena.insert(_data->_arena.end(), v.begin(), v.end());
+      memcpy(_slot.payload, &offset, sizeof(offset));
+      memcpy(_slot.payload + sizeof(offset), &length, sizeof(length));
+    } else
+      store_variant(v);
+  }
+
+  result_type operator()(const sqlite::blob_ref_t &v) {
+    store_variant(v);
+  }
+
+private:
+  Packed_data *_data;
+  Slot &_slot;
+
+  template <typename T>
+  void store_variant(const T &v) {
+    _slot.tag = VariantTag;
+    std::uint64_t index = _data->_variants.size();
+    _data->_variants.push_back(v);
+    memcpy(_slot.payload, &index, sizeof(index));
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+Packed_data::Packed_data() {
+  static_assert(sizeof(Slot) == 16, "cells are expected to be 16 bytes");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Packed_data::resize(size_t count) {
+  Slot empty;
+  memset(&empty, 0, sizeof(empty));
+  empty.tag = UnknownTag;
+  _slots.resize(count, empty);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Packed_data::clear() {
+  _slots.clear();
+  _arena.clear();
+  _variants.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Packed_data::swap(Packed_data &other) {
+  _slots.swap(other._slots);
+  _arena.swap(other._arena);
+  _variants.swap(other._variants);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Packed_data::push_back(const sqlite::variant_t &value) {
+  _slots.push_back(Slot());
+  set(_slots.size() - 1, value);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Packed_data::iterator Packed_data::insert(iterator pos, const sqlite::variant_t &value) {
+  size_t index = pos.index();
+  _slots.insert(_slots.begin() + index, Slot());
+  set(index, value);
+  return iterator(this, index);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Packed_data::iterator Packed_data::erase(iterator first, iterator last) {
+  // Arena and side variants are only released when the frame is cleared, but let go of erased blobs right away.
+  for (size_t index = first.index(); index < last.index(); ++index)
+    if (_slots[index].tag == VariantTag) {
+      std::uint64_t variant_index;
+      memcpy(&variant_index, _slots[index].payload, sizeof(variant_index));
+      _variants[variant_index] = sqlite::unknown_t();
+    }
+  _slots.erase(_slots.begin() + first.index(), _slots.begin() + last.index());
+  return iterator(this, first.index());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+sqlite::variant_t Packed_data::get(size_t index) const {
+  const Slot &slot = _slots[index];
+  switch (slot.tag) {
+    case IntTag: {
+      int v;
+      memcpy(&v, slot.payload, sizeof(v));
+      return v;
+    }
+    case Int64Tag: {
+      std::int64_t v;
+      memcpy(&v, slot.payload, sizeof(v));
+      return v;
+    }
+    case LongDoubleTag: {
+      long double v;
+      if (sizeof(v) <= sizeof(slot.payload))
+        memcpy(&v, slot.payload, sizeof(v));
+      else {
+        std::uint64_t offset;
+        memcpy(&offset, slot.payload, sizeof(offset));
+        memcpy(&v, &_arena[(size_t)offset], sizeof(v));
+      }
+      return v;
+    }
+    case InlineStringTag:
+      return std::string(slot.payload, slot.length);
+    case ArenaStringTag: {
+      std::uint64_t offset;
+      std::uint32_t length;
+      memcpy(&offset, slot.payload, sizeof(offset));
+      memcpy(&length, slot.payload + sizeof(offset), sizeof(length));
+      return std::string(&_arena[(size_t)offset], length);
+    }
+    case NullTag:
+      return sqlite::null_t();
+    case VariantTag: {
+      std::uint64_t variant_index;
+      memcpy(&variant_index, slot.payload, sizeof(variant_index));
+      return _variants[(size_t)variant_index];
+    }
+    default:
+      return sqlite::unknown_t();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t Packed_data::string_length(size_t index) const {
+  const Slot &slot = _slots[index];
+  switch (slot.tag) {
+    case InlineStringTag:
+      return slot.length;
+    case ArenaStringTag: {
+      std::uint32_t length;
+      memcpy(&length, slot.payload + sizeof(std::uint64_t), sizeof(length));
+      return length;
+    }
+    case VariantTag: {
+      std::uint64_t variant_index;
+      memcpy(&variant_index, slot.payload, sizeof(variant_index));
+      const std::string *value = boost::get<std::string>(&_variants[(size_t)variant_index]);
+      return value ? value->size() : std::string::npos;
+    }
+    default:
+      return std::string::npos;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string Packed_data::string_prefix(size_t index, size_t max_length) const {
+  const Slot &slot = _slots[index];
+  switch (slot.tag) {
+    case InlineStringTag:
+      return std::string(slot.payload, std::min<size_t>(slot.length, max_length));
+    case ArenaStringTag: {
+      std::uint64_t offset;
+      std::uint32_t length;
+      memcpy(&offset, slot.payload, sizeof(offset));
+      memcpy(&length, slot.payload + sizeof(offset), sizeof(length));
+      return std::string(&_arena[(size_t)offset], std::min<size_t>(length, max_length));
+    }
+    case VariantTag: {
+      std::uint64_t variant_index;
+      memcpy(&variant_index, slot.payload, sizeof(variant_index));
+      const std::string *value = boost::get<std::string>(&_variants[(size_t)variant_index]);
+      return value ? value->substr(0, max_length) : std::string();
+    }
+    default:
+      return std::string();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Packed_data::set(size_t index, const sqlite::variant_t &value) {
+  Slot &slot = _slots[index];
+  if (slot.tag == VariantTag) {
+    std::uint64_t variant_index;
+    memcpy(&variant_index, slot.payload, sizeof(variant_index));
+    _variants[(size_t)variant_index] = sqlite::unknown_t();
+  }
+  memset(&slot, 0, sizeof(slot));
+  Packer packer(this, slot);
+  boost::apply_visitor(packer, value);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t Packed_data::memory_size() const {
+  return _slots.capacity() * sizeof(Slot) + _arena.capacity() + _variants.capacity() * sizeof(sqlite::variant_t);
+}
+
+//--------------------------------------------------------------------------------------------------
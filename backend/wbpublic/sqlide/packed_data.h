@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2007, 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include "wbpublic_public_interface.h"
+#include <sqlite/result.hpp>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Cell storage for the data frame cached by VarGridModel.
+ *
+ * Every cell is a 16 byte slot holding a type tag and the value itself: numbers are stored in place, strings of up
+ * to 14 bytes inline and longer ones as offset and length into a character arena shared by the whole frame. Only
+ * blobs (and strings too long to be addressed) are kept as full variants on the side. Cells are read and written as
+ * sqlite::variant_t through proxy references, so the container can be used like the vector of variants it replaces.
+ *
+ * Overwritten strings are not reclaimed from the arena until the frame is cleared, which is fine for the mostly
+ * read-only grid frames.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC Packed_data {
+public:
+  class reference {
+  public:
+    reference(Packed_data *owner, size_t index) : _owner(owner), _index(index) {
+    }
+
+    operator sqlite::variant_t() const {
+      return _owner->get(_index);
+    }
+    sqlite::variant_t get() const {
+      return _owner->get(_index);
+    }
+
+    reference &operator=(const sqlite::variant_t &value) {
+      _owner->set(_index, value);
+      return *this;
+    }
+    reference &operator=(const reference &other) {
+      _owner->set(_index, other.get());
+      return *this;
+    }
+
+    void swap(reference other) {
+      if (_owner == other._owner)
+        std::swap(_owner->_slots[_index], other._owner->_slots[other._index]);
+      else {
+        sqlite::variant_t tmp = get();
+        *this = other.get();
+        other = tmp;
+      }
+    }
+
+    friend void swap(reference a, reference b) {
+      a.swap(b);
+    }
+
+  private:
+    Packed_data *_owner;
+    size_t _index;
+  };
+
+  template <typename Owner, typename Reference>
+  class basic_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef sqlite::variant_t value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef void pointer;
+    typedef Reference reference;
+
+    basic_iterator() : _owner(NULL), _index(0) {
+    }
+    basic_iterator(Owner *owner, size_t index) : _owner(owner), _index(index) {
+    }
+    template <typename O, typename R>
+    basic_iterator(const basic_iterator<O, R> &other) : _owner(other.owner()), _index(other.index()) {
+    }
+
+    Reference operator*() const {
+      return Packed_data::deref(_owner, _index);
+    }
+    Reference operator[](difference_type n) const {
+      return Packed_data::deref(_owner, _index + n);
+    }
+
+    basic_iterator &operator++() {
+      ++_index;
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      basic_iterator tmp(*this);
+      ++_index;
+      return tmp;
+    }
+    basic_iterator &operator--() {
+      --_index;
+      return *this;
+    }
+    basic_iterator operator--(int) {
+      basic_iterator tmp(*this);
+      --_index;
+      return tmp;
+    }
+    basic_iterator &operator+=(difference_type n) {
+      _index += n;
+      return *this;
+    }
+    basic_iterator &operator-=(difference_type n) {
+      _index -= n;
+      return *this;
+    }
+    basic_iterator operator+(difference_type n) const {
+      return basic_iterator(_owner, _index + n);
+    }
+    basic_iterator operator-(difference_type n) const {
+      return basic_iterator(_owner, _index - n);
+    }
+    difference_type operator-(const basic_iterator &other) const {
+      return (difference_type)_index - (difference_type)other._index;
+    }
+
+    bool operator==(const basic_iterator &other) const {
+      return _index == other._index && _owner == other._owner;
+    }
+    bool operator!=(const basic_iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator<(const basic_iterator &other) const {
+      return _index < other._index;
+    }
+    bool operator>(const basic_iterator &other) const {
+      return _index > other._index;
+    }
+    bool operator<=(const basic_iterator &other) const {
+      return _index <= other._index;
+    }
+    bool operator>=(const basic_iterator &other) const {
+      return _index >= other._index;
+    }
+
+    Owner *owner() const {
+      return _owner;
+    }
+    size_t index() const {
+      return _index;
+    }
+
+  private:
+    Owner *_owner;
+    size_t _index;
+  };
+
+  typedef sqlite::variant_t value_type;
+  typedef sqlite::variant_t const_reference;
+  typedef size_t size_type;
+  typedef basic_iterator<Packed_data, reference> iterator;
+  typedef basic_iterator<const Packed_data, const_reference> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  Packed_data();
+
+  size_t size() const {
+    return _slots.size();
+  }
+  bool empty() const {
+    return _slots.empty();
+  }
+
+  void reserve(size_t count) {
+    _slots.reserve(count);
+  }
+  void resize(size_t count); // new cells are unknown_t, like default constructed variants
+  void clear();
+  void swap(Packed_data &other);
+
+  void push_back(const sqlite::variant_t &value);
+  iterator insert(iterator pos, const sqlite::variant_t &value);
+  iterator erase(iterator first, iterator last);
+
+  sqlite::variant_t get(size_t index) const;
+  void set(size_t index, const sqlite::variant_t &value);
+
+  // Length of the string in a cell without copying it, std::string::npos for cells holding something else.
+  size_t string_length(size_t index) const;
+  // The first max_length bytes of a string cell.
+  std::string string_prefix(size_t index, size_t max_length) const;
+
+  reference operator[](size_t index) {
+    return reference(this, index);
+  }
+  const_reference operator[](size_t index) const {
+    return get(index);
+  }
+
+  iterator begin() {
+    return iterator(this, 0);
+  }
+  iterator end() {
+    return iterator(this, _slots.size());
+  }
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+  const_iterator end() const {
+    return const_iterator(this, _slots.size());
+  }
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  size_t memory_size() const;
+
+private:
+  enum Tag {
+    UnknownTag = 0,
+    IntTag,
+    Int64Tag,
+    LongDoubleTag,
+    InlineStringTag,
+    ArenaStringTag,
+    NullTag,
+    VariantTag // blobs and anything else kept in _variants
+  };
+
+  struct Slot {
+    char payload[14];
+    std::uint8_t length; // InlineStringTag
+    std::uint8_t tag;
+  };
+
+  class Packer;
+
+  static reference deref(Packed_data *owner, size_t index) {
+    return reference(owner, index);
+  }
+  static const_reference deref(const Packed_data *owner, size_t index) {
+    return owner->get(index);
+  }
+
+  std::vector<Slot> _slots;
+  std::vector<char> _arena;
+  std::vector<sqlite::variant_t> _variants;
+};
+
+inline void swap(Packed_data &a, Packed_data &b) {
+  a.swap(b);
+}
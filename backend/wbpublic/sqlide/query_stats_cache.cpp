@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/database_exception.hpp>
+#include <glib.h>
+#include <algorithm>
+#include <cstring>
+
+#include "base/log.h"
+#include "base/file_utilities.h"
+#include "base/boost_smart_ptr_helpers.h"
+#include "sqlide_generics.h"
+
+#include "query_stats_cache.h"
+
+DEFAULT_LOG_DOMAIN("query_stats");
+
+#define QUERY_STATS_MAX_STATEMENT_LENGTH 4096 // characters of the digest text that are stored
+#define QUERY_STATS_MAX_ENTRIES 5000          // digests kept, the ones not run for the longest time go first
+#define QUERY_STATS_PRUNE_INTERVAL 100        // runs added between checks of the entry count
+
+//----------------------------------------------------------------------------------------------------------------------
+
+QueryStatsCache::QueryStatsCache(const std::string &connection_id, const std::string &cache_dir)
+  : _connection_id(connection_id), _added(0) {
+  _sqconn = new sqlite::connection(base::makePath(cache_dir, connection_id) + ".query_stats");
+  sqlite::execute(*_sqconn, "PRAGMA temp_store=MEMORY", true);
+  sqlite::execute(*_sqconn, "PRAGMA synchronous=NORMAL", true);
+
+  logDebug2("Using query statistics file %s\n", (base::makePath(cache_dir, connection_id) + ".query_stats").c_str());
+  init_db();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+QueryStatsCache::~QueryStatsCache() {
+  delete _sqconn;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void QueryStatsCache::init_db() {
+  std::string code =
+    "create table if not exists query_stats (digest varchar(32) primary key, statement text, exec_count int, "
+    "total_time int, max_time int, lock_time int, rows_examined int, rows_sent int, tmp_tables int, "
+    "tmp_disk_tables int, no_index_used int, first_seen int, last_seen int)";
+  try {
+    sqlite::execute(*_sqconn, code, true);
+  } catch (std::exception &exc) {
+    logError("Error creating query statistics %s: %s\n", code.c_str(), exc.what());
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool is_identifier_char(char c) {
+  return g_ascii_isalnum(c) || c == '_' || c == '$' || (unsigned char)c >= 0x80;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool ends_with(const std::string &text, const char *suffix) {
+  size_t length = strlen(suffix);
+  return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// A literal becomes ?, and a list of two or more of them becomes ..., like in the digests of the server.
+static void append_placeholder(std::string &text) {
+  size_t end = text.size();
+  if (end > 0 && text[end - 1] == ' ')
+    --end;
+  if (end > 0 && text[end - 1] == ',') {
+    size_t item = end - 1;
+    if (item > 0 && text[item - 1] == ' ')
+      --item;
+    if (item >= 3 && text.compare(item - 3, 3, "...") == 0) {
+      text.resize(item);
+      return;
+    }
+    if (item >= 1 && text[item - 1] == '?') {
+      text.resize(item - 1);
+      text.append("...");
+      return;
+    }
+  }
+  text.push_back('?');
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * The statement with string and number literals replaced by ?, comments removed and white space collapsed. The rows
+ * of a multi-row insert collapse into one.
+ */
+std::string QueryStatsCache::digest_text(const std::string &statement) {
+  std::string text;
+  text.reserve(std::min(statement.size(), (size_t)QUERY_STATS_MAX_STATEMENT_LENGTH));
+
+  bool space = false;
+  size_t length = statement.size();
+  for (size_t i = 0; i < length;) {
+    char c = statement[i];
+    if (g_ascii_isspace(c)) {
+      space = !text.empty();
+      ++i;
+      continue;
+    }
+
+    if (c == '#' || (c == '-' && i + 1 < length && statement[i + 1] == '-' &&
+                     (i + 2 == length || g_ascii_isspace(statement[i + 2])))) {
+      i = statement.find('\n', i);
+      if (i == std::string::npos)
+        break;
+      continue;
+    }
+    if (c == '/' && i + 1 < length && statement[i + 1] == '*') {
+      i = statement.find("*/", i + 2);
+      if (i == std::string::npos)
+        break;
+      i += 2;
+      space = !text.empty();
+      continue;
+    }
+
+    if (space)
+      text.push_back(' ');
+    space = false;
+
+    if (c == '\'' || c == '"') {
+      for (++i; i < length; ++i) {
+        if (statement[i] == '\\')
+          ++i;
+        else if (statement[i] == c) {
+          if (i + 1 < length && statement[i + 1] == c)
+            ++i;
+          else
+            break;
+        }
+      }
+      ++i;
+      append_placeholder(text);
+    } else if (c == '`') {
+      size_t end = statement.find('`', i + 1);
+      end = end == std::string::npos ? length : end + 1;
+      text.append(statement, i, end - i);
+      i = end;
+    } else if (g_ascii_isdigit(c) && (text.empty() || !is_identifier_char(text.back()))) {
+      for (++i; i < length; ++i) {
+        char d = statement[i];
+        if ((d == '+' || d == '-') && (statement[i - 1] == 'e' || statement[i - 1] == 'E'))
+          continue;
+        if (!is_identifier_char(d) && d != '.')
+          break;
+      }
+      append_placeholder(text);
+    } else {
+      text.push_back(c);
+      ++i;
+      if (c == ')' && (ends_with(text, "(...), (...)") || ends_with(text, "(...),(...)") ||
+                       ends_with(text, "(?), (?)") || ends_with(text, "(?),(?)")))
+        text.resize(text.rfind(','));
+    }
+  }
+  return text;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string QueryStatsCache::digest(const std::string &digest_text) {
+  gchar *checksum =
+    g_compute_checksum_for_data(G_CHECKSUM_MD5, (const guchar *)digest_text.data(), digest_text.size());
+  std::string digest(checksum);
+  g_free(checksum);
+  return digest;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void QueryStatsCache::add(const std::string &statement, const std::map<std::string, std::int64_t> &stats) {
+  auto value = [&stats](const char *field) -> std::int64_t {
+    std::map<std::string, std::int64_t>::const_iterator iter = stats.find(field);
+    return iter != stats.end() ? iter->second : 0;
+  };
+
+  std::string text = digest_text(statement);
+  if (text.empty())
+    return;
+  std::string key = digest(text);
+  if (text.size() > QUERY_STATS_MAX_STATEMENT_LENGTH)
+    text = text.substr(0, QUERY_STATS_MAX_STATEMENT_LENGTH - 3) + "...";
+  std::int64_t now = (std::int64_t)std::time(nullptr);
+  std::int64_t time = value("TIMER_WAIT");
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_sqconn);
+    {
+      sqlite::query q(*_sqconn, "insert or ignore into query_stats values (?, ?, 0, 0, 0, 0, 0, 0, 0, 0, 0, ?, ?)");
+      q % key % text % now % now;
+      q.emit();
+    }
+    sqlite::query q(*_sqconn,
+                    "update query_stats set statement = ?, exec_count = exec_count + 1, total_time = total_time + ?, "
+                    "max_time = max(max_time, ?), lock_time = lock_time + ?, rows_examined = rows_examined + ?, "
+                    "rows_sent = rows_sent + ?, tmp_tables = tmp_tables + ?, tmp_disk_tables = tmp_disk_tables + ?, "
+                    "no_index_used = no_index_used + ?, last_seen = ? where digest = ?");
+    q % text % time % time % value("LOCK_TIME") % value("ROWS_EXAMINED") % value("ROWS_SENT") %
+      value("CREATED_TMP_TABLES") % value("CREATED_TMP_DISK_TABLES") % value("NO_INDEX_USED") % now % key;
+    q.emit();
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error storing statistics of query %s: %s\n", key.c_str(), exc.what());
+    return;
+  }
+
+  if (++_added % QUERY_STATS_PRUNE_INTERVAL == 0)
+    prune();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void QueryStatsCache::prune() {
+  try {
+    sqlite::query q(*_sqconn,
+                    "delete from query_stats where digest not in "
+                    "(select digest from query_stats order by last_seen desc limit ?)");
+    q.bind(1, QUERY_STATS_MAX_ENTRIES);
+    q.emit();
+  } catch (std::exception &exc) {
+    logError("Error removing old query statistics: %s\n", exc.what());
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<QueryStatsCache::Entry> QueryStatsCache::top(const std::string &order, size_t limit) {
+  std::string order_by = "total_time";
+  if (order == "average")
+    order_by = "total_time / exec_count";
+  else if (order == "max")
+    order_by = "max_time";
+  else if (order == "rows_examined")
+    order_by = "rows_examined";
+  else if (!order.empty() && order != "total")
+    logWarning("Unknown query statistics order %s, using total time\n", order.c_str());
+
+  std::vector<Entry> entries;
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::query q(*_sqconn, "select digest, statement, exec_count, total_time, max_time, lock_time, rows_examined, "
+                              "rows_sent, tmp_tables, tmp_disk_tables, no_index_used, first_seen, last_seen "
+                              "from query_stats where exec_count > 0 order by " +
+                                order_by + " desc limit ?");
+    q.bind(1, (int)limit);
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      do {
+        Entry entry;
+        entry.digest = res->get_string(0);
+        entry.statement = res->get_string(1);
+        entry.exec_count = res->get_int64(2);
+        entry.total_time = res->get_int64(3);
+        entry.max_time = res->get_int64(4);
+        entry.lock_time = res->get_int64(5);
+        entry.rows_examined = res->get_int64(6);
+        entry.rows_sent = res->get_int64(7);
+        entry.tmp_tables = res->get_int64(8);
+        entry.tmp_disk_tables = res->get_int64(9);
+        entry.no_index_used = res->get_int64(10);
+        entry.first_seen = (std::time_t)res->get_int64(11);
+        entry.last_seen = (std::time_t)res->get_int64(12);
+        entries.push_back(entry);
+      } while (res->next_row());
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading query statistics: %s\n", exc.what());
+  }
+  return entries;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void QueryStatsCache::clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::execute(*_sqconn, "delete from query_stats", true);
+  } catch (std::exception &exc) {
+    logError("Error clearing query statistics: %s\n", exc.what());
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "wbpublic_public_interface.h"
+
+#include <sqlite/connection.hpp>
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Performance schema statistics of the statements run in the SQL editor of a connection, kept between sessions.
+ * Statements are aggregated by their digest: the statement text with literals replaced and white space and comments
+ * dropped, so runs of the same query with different values add up. Times are in picoseconds, as the server reports them.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC QueryStatsCache {
+public:
+  struct Entry {
+    std::string digest;
+    std::string statement; // Digest text, shortened for very long statements.
+    std::int64_t exec_count;
+    std::int64_t total_time;
+    std::int64_t max_time;
+    std::int64_t lock_time;
+    std::int64_t rows_examined;
+    std::int64_t rows_sent;
+    std::int64_t tmp_tables;
+    std::int64_t tmp_disk_tables;
+    std::int64_t no_index_used;
+    std::time_t first_seen;
+    std::time_t last_seen;
+  };
+
+  QueryStatsCache(const std::string &connection_id, const std::string &cache_dir);
+  virtual ~QueryStatsCache();
+
+  static std::string digest_text(const std::string &statement);
+  static std::string digest(const std::string &digest_text);
+
+  // Adds a run of the statement, with the fields of events_statements_current the SQL editor reads.
+  void add(const std::string &statement, const std::map<std::string, std::int64_t> &stats);
+
+  // Ordered by total, average or max time, or by rows examined. Most expensive first.
+  std::vector<Entry> top(const std::string &order, size_t limit);
+  void clear();
+
+private:
+  std::string _connection_id;
+  sqlite::connection *_sqconn;
+  std::mutex _mutex; // statements are added from the query thread
+  size_t _added;
+
+  void init_db();
+  void prune();
+};
@@ -37,12 +37,15 @@
 #include "base/log.h"
 #include "base/string_utilities.h"
 #include "base/boost_smart_ptr_helpers.h"
+#include "base/mem_stat.h"
 #include "sqlite/command.hpp"
+#include <atomic>
 #include <fstream>
 #include <sstream>
 #include "grt/spatial_handler.h"
 
 #include "recordset_text_storage.h"
+#include "recordset_columnar_data.h"
 
 DEFAULT_LOG_DOMAIN("Recordset")
 
@@ -61,6 +64,10 @@ using namespace base;
     rethrow ? throw : task->send_msg(grt::ErrorMsg, e.what(), context);                                         \
   }
 
+static const RowId NEXT_PAGE_PREFETCH_ROWS = 100; // distance to the last row at which the next page is read
+static const size_t BACKGROUND_COPY_ROWS = 5000;  // larger selections are copied to the clipboard by a worker thread
+static const size_t COPY_ROWS_PER_LOCK = 1000;    // rows formatted per lock of the data, the grid can paint in between
+
 const std::string ERRMSG_PENDING_CHANGES = _("There are pending changes. Please commit or rollback first.");
 std::string Recordset::_add_change_record_statement =
   "insert into `changes` (`record`, `action`, `column`) values (?, ?, ?)";
@@ -84,6 +91,8 @@ Recordset::Recordset()
   : VarGridModel(), _preserveRowFilters(false), _inserts_editor(false), task(GrtThreadedTask::create()) {
   _toolbar = NULL;
   _client_data = NULL;
+  _fetching_rows = false;
+  _sort_filter_on_server = false;
   _context_menu = 0;
   _id = g_atomic_int_get(&next_id);
   g_atomic_int_inc(&next_id);
@@ -93,12 +102,15 @@ Recordset::Recordset()
   apply_changes_cb = [this]() { apply_changes_(); };
   register_default_actions();
   reset();
+  register_memory_source();
 }
 
 Recordset::Recordset(GrtThreadedTask::Ref parent_task)
   : VarGridModel(), _inserts_editor(false), task(GrtThreadedTask::create(parent_task)) {
   _toolbar = NULL;
   _client_data = NULL;
+  _fetching_rows = false;
+  _sort_filter_on_server = false;
   _context_menu = 0;
   _id = g_atomic_int_get(&next_id);
   g_atomic_int_inc(&next_id);
@@ -107,9 +119,18 @@ Recordset::Recordset(GrtThreadedTask::Ref parent_task)
   apply_changes_cb = [this]() { apply_changes_(); };
   register_default_actions();
   reset();
+  register_memory_source();
+}
+
+void Recordset::register_memory_source() {
+  _memory_source = base::MemoryAccounting::add_source("Result set data", [this](base::MemoryAccounting::Usage &usage) {
+    usage.bytes = memory_size();
+    usage.items = 1;
+  });
 }
 
 Recordset::~Recordset() {
+  base::MemoryAccounting::remove_source(_memory_source);
   // recordset can't be freed before all calls planned from this class in main thread are finished
   bec::GRTManager::get()->get_dispatcher()->flush_pending_callbacks();
   delete _client_data;
@@ -127,11 +148,17 @@ bool Recordset::reset(Recordset_data_storage::Ptr data_storage_ptr, bool rethrow
   _aux_column_count = 0;
   _rowid_column = 0;
   _real_row_count = 0;
+  _fetching_rows = false;
+  _columnar_data.reset();
+  _columnar_index.clear();
+  _columnar_selection = ColumnarSelection();
+  _columnar_data_flushed = false;
   _min_new_rowid = 0;
   _next_new_rowid = 0;
   _sort_columns.clear();
   _column_filter_expr_map.clear();
   _data_search_string.clear();
+  _sort_filter_on_server = false;
 
   RETAIN_WEAK_PTR(Recordset_data_storage, data_storage_ptr, data_storage)
   if (data_storage) {
@@ -151,7 +178,9 @@ bool Recordset::reset(Recordset_data_storage::Ptr data_storage_ptr, bool rethrow
       _real_column_types.push_back(int());
       _column_flags.push_back(0);
 
-      {
+      if (_columnar_data)
+        _min_new_rowid = _columnar_data->row_count() + 1; // ids of in memory rows are their positions + 1
+      else {
         sqlite::query q(*data_swap_db, "select coalesce(max(id)+1, 0) from `data`");
         if (q.emit()) {
           std::shared_ptr<sqlite::result> rs = BoostHelper::convertPointer(q.get_result());
@@ -159,14 +188,21 @@ bool Recordset::reset(Recordset_data_storage::Ptr data_storage_ptr, bool rethrow
         } else {
           _min_new_rowid = 0;
         }
-        _next_new_rowid = _min_new_rowid;
       }
+      _next_new_rowid = _min_new_rowid;
 
       recalc_row_count(data_swap_db.get());
 
       _readonly = data_storage->readonly();
 
       _readonly_reason = data_storage->readonly_reason();
+
+      // the grid only gets to edit the data once all of it is there, see fetch_pending_rows()
+      _fetching_rows = data_storage->has_pending_rows();
+      if (_fetching_rows) {
+        _readonly = true;
+        _readonly_reason = _("The result set is still being fetched.");
+      }
       res = true;
     }
     CATCH_AND_DISPATCH_EXCEPTION(rethrow, "Reset recordset")
@@ -211,6 +247,121 @@ bool Recordset::reset(bool rethrow) {
   return reset(_data_storage, rethrow);
 }
 
+/**
+ * Reads the rows the data storage didn't read in reset(), in chunks, while the grid is already showing the first
+ * ones. The data lock is only held while a chunk is stored, row counts are updated after each chunk and the UI is
+ * refreshed at most every PENDING_ROWS_REFRESH_INTERVAL. Must be called from the thread that called reset().
+ */
+bool Recordset::fetch_pending_rows(bool rethrow) {
+  Recordset_data_storage::Ref data_storage(_data_storage);
+  if (!data_storage || !_fetching_rows)
+    return true;
+
+  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
+  bool res = false;
+
+  try {
+    try {
+      fetch_pending_row_chunks(data_storage.get(), data_swap_db.get());
+    } catch (...) {
+      finish_fetching_rows();
+      throw;
+    }
+    res = true;
+  }
+  CATCH_AND_DISPATCH_EXCEPTION(rethrow, "Fetch recordset rows")
+
+  if (res)
+    finish_fetching_rows();
+  return res;
+}
+
+void Recordset::fetch_pending_row_chunks(Recordset_data_storage *data_storage, sqlite::connection *data_swap_db) {
+  static const size_t PENDING_ROWS_CHUNK_SIZE = 10000;
+  static const gint64 PENDING_ROWS_REFRESH_INTERVAL = 250000; // usecs
+
+  gint64 last_refresh = g_get_monotonic_time();
+  while (data_storage->has_pending_rows()) {
+    {
+      base::RecMutexLock data_mutex WB_UNUSED(_data_mutex);
+      if (data_storage->fetch_pending_rows(this, data_swap_db, PENDING_ROWS_CHUNK_SIZE) > 0) {
+        // new rows go to the end of an unsorted and unfiltered index, no need to rebuild it
+        bool append = _sort_columns.empty() && _column_filter_expr_map.empty() && _data_search_string.empty();
+        if (!append)
+          rebuild_data_index(data_swap_db, false, false);
+        else if (_columnar_data) {
+          for (RowId row = _min_new_rowid - 1; row < _columnar_data->row_count(); ++row)
+            _columnar_index.push_back(row);
+          recalc_row_count(data_swap_db);
+        } else {
+          sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db);
+          sqlite::execute(*data_swap_db,
+                          strfmt("insert into `data_index` select `id` from `data` where `id` >= %u",
+                                 (unsigned int)_min_new_rowid),
+                          true);
+          transaction_guarder.commit();
+          recalc_row_count(data_swap_db);
+        }
+
+        if (_columnar_data)
+          _min_new_rowid = _columnar_data->row_count() + 1;
+        else {
+          sqlite::query q(*data_swap_db, "select coalesce(max(id)+1, 0) from `data`");
+          if (q.emit()) {
+            std::shared_ptr<sqlite::result> rs = BoostHelper::convertPointer(q.get_result());
+            _min_new_rowid = rs->get_int(0);
+          }
+        }
+        _next_new_rowid = _min_new_rowid;
+      }
+    }
+
+    gint64 now = g_get_monotonic_time();
+    if (now - last_refresh >= PENDING_ROWS_REFRESH_INTERVAL) {
+      last_refresh = now;
+      refresh_ui();
+    }
+  }
+}
+
+/**
+ * Appends the rows of the page following the ones fetched so far, for data storages that page by key.
+ */
+void Recordset::fetch_next_page() {
+  Recordset_data_storage::Ref data_storage(_data_storage);
+  if (!data_storage || _fetching_rows || !data_storage->has_next_page() || has_pending_changes())
+    return;
+
+  try {
+    if (!data_storage->start_next_page())
+      return;
+  }
+  CATCH_AND_DISPATCH_EXCEPTION(false, "Fetch next rows")
+
+  {
+    base::RecMutexLock data_mutex WB_UNUSED(_data_mutex);
+    _fetching_rows = data_storage->has_pending_rows();
+    if (!_fetching_rows)
+      return;
+    _readonly = true;
+    _readonly_reason = _("The result set is still being fetched.");
+  }
+  fetch_pending_rows(false);
+
+  if (rows_changed)
+    rows_changed();
+}
+
+void Recordset::finish_fetching_rows() {
+  {
+    base::RecMutexLock data_mutex WB_UNUSED(_data_mutex);
+    _fetching_rows = false;
+    _readonly = _data_storage ? _data_storage->readonly() : true;
+    _readonly_reason = _data_storage ? _data_storage->readonly_reason() : "";
+  }
+  refresh_ui();
+}
+
 bool Recordset::can_close() {
   return can_close(true);
 }
@@ -251,6 +402,14 @@ void Recordset::refresh() {
     return;
   }
 
+  // like below sorting and column filters are dropped, but the server gets to apply the search string
+  if (can_sort_and_filter_on_server()) {
+    _sort_columns.clear();
+    _column_filter_expr_map.clear();
+    apply_sort_and_filter();
+    return;
+  }
+
   std::string data_search_string = _data_search_string;
 
   VarGridModel::refresh();
@@ -283,6 +442,12 @@ RowId Recordset::real_row_count() const {
 }
 
 void Recordset::recalc_row_count(sqlite::connection *data_swap_db) {
+  if (_columnar_data) {
+    _row_count = _columnar_index.size();
+    _real_row_count = _columnar_data->row_count();
+    return;
+  }
+
   // row count (visible rows only, some can be filtered out by applied column filters)
   {
     sqlite::query q(*data_swap_db, "select count(*) from `data_index`");
@@ -307,6 +472,12 @@ void Recordset::recalc_row_count(sqlite::connection *data_swap_db) {
 }
 
 Recordset::Cell Recordset::cell(RowId row, ColumnId column) {
+  // getting close to the end of a keyset paged result, have the next page read once the UI is idle
+  if (!_fetching_rows && row < _row_count && _row_count - row <= NEXT_PAGE_PREFETCH_ROWS && _data_storage &&
+      _data_storage->has_next_page() && !_next_page_connection.connected())
+    _next_page_connection =
+      bec::GRTManager::get()->run_once_when_idle(this, std::bind(&Recordset::fetch_next_page, this));
+
   if (_row_count == row) {
     RowId rowid = _next_new_rowid++; // rowid of the new record
     {
@@ -340,6 +511,7 @@ Recordset::Cell Recordset::cell(RowId row, ColumnId column) {
 
       transaction_guarder.commit();
     }
+    invalidate_data_frames();
 
     _data.resize(_data.size() + _column_count);
     ++_row_count;
@@ -381,7 +553,8 @@ void Recordset::mark_dirty(RowId row, ColumnId column, const sqlite::variant_t &
         strfmt("update `data%s` set `_%u`=? where `id`=?", partition_suffix.c_str(), (unsigned int)column);
       sqlite::command update_data_record_statement(*data_swap_db, sql);
       sqlide::BindSqlCommandVar bind_sql_command_var(&update_data_record_statement);
-      boost::apply_visitor(bind_sql_command_var, new_value);
+      sqlite::variant_t value = sqlide::pack_data_swap_value(new_value);
+      boost::apply_visitor(bind_sql_command_var, value);
       update_data_record_statement % (int)rowid;
       update_data_record_statement.emit();
     }
@@ -396,6 +569,7 @@ void Recordset::mark_dirty(RowId row, ColumnId column, const sqlite::variant_t &
     }
 
     transaction_guarder.commit();
+    invalidate_data_frames();
   }
 }
 
@@ -471,6 +645,7 @@ bool Recordset::delete_nodes(std::vector<bec::NodeId> &nodes) {
         }
 
         transaction_guarder.commit();
+        invalidate_data_frames();
 
         --_row_count;
         --_data_frame_end;
@@ -710,8 +885,7 @@ void Recordset::sort_by(ColumnId column, int direction, bool retaining) {
   if (!retaining) {
     _sort_columns.clear();
     if (!(direction)) {
-      std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-      rebuild_data_index(data_swap_db.get(), true, true);
+      apply_sort_and_filter();
 
       refresh_ui(); // refresh the sort indicators in column headers
       return;
@@ -740,8 +914,7 @@ void Recordset::sort_by(ColumnId column, int direction, bool retaining) {
   if (!is_resort_needed || _sort_columns.empty())
     return;
 
-  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-  rebuild_data_index(data_swap_db.get(), true, true);
+  apply_sort_and_filter();
 }
 
 std::string Recordset::get_column_filter_expr(ColumnId column) const {
@@ -763,8 +936,7 @@ bool Recordset::has_column_filter(ColumnId column) const {
 void Recordset::reset_column_filters() {
   _column_filter_expr_map.clear();
 
-  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-  rebuild_data_index(data_swap_db.get(), true, true);
+  apply_sort_and_filter();
 }
 
 void Recordset::reset_column_filter(ColumnId column) {
@@ -773,8 +945,7 @@ void Recordset::reset_column_filter(ColumnId column) {
     return;
   _column_filter_expr_map.erase(i);
 
-  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-  rebuild_data_index(data_swap_db.get(), true, true);
+  apply_sort_and_filter();
 }
 
 void Recordset::set_column_filter(ColumnId column, const std::string &filter_expr) {
@@ -785,8 +956,7 @@ void Recordset::set_column_filter(ColumnId column, const std::string &filter_exp
     return;
   _column_filter_expr_map[column] = filter_expr;
 
-  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-  rebuild_data_index(data_swap_db.get(), true, true);
+  apply_sort_and_filter();
 }
 
 size_t Recordset::column_filter_icon_id() const {
@@ -803,8 +973,7 @@ void Recordset::set_data_search_string(const std::string &value) {
     return;
   _data_search_string = value;
 
-  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-  rebuild_data_index(data_swap_db.get(), true, true);
+  apply_sort_and_filter();
 }
 
 void Recordset::reset_data_search_string() {
@@ -812,13 +981,58 @@ void Recordset::reset_data_search_string() {
     return;
   _data_search_string.clear();
 
-  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-  rebuild_data_index(data_swap_db.get(), true, true);
+  apply_sort_and_filter();
+}
+
+// Also hands the current sort columns and filters over to the data storage, to be used by its next reload.
+bool Recordset::can_sort_and_filter_on_server() {
+  // a reload would discard pending changes and must not race with the rows still being read
+  Recordset_data_storage::Ref data_storage(_data_storage);
+  return data_storage && data_storage->reloadable() && !_fetching_rows && !has_pending_changes() &&
+         data_storage->sort_and_filter_on_server(this);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Applies the current sort columns, column filters and search string. If the data storage supports it, its query is
+ * re-executed with them, so the server sorts and filters all the rows instead of just the ones fetched so far.
+ * Otherwise the data index is rebuilt from the fetched rows.
+ */
+void Recordset::apply_sort_and_filter() {
+  if (!can_sort_and_filter_on_server()) {
+    // whatever the server applied before stays, the rest is done on the fetched rows
+    _sort_filter_on_server = false;
+    std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
+    rebuild_data_index(data_swap_db.get(), true, true);
+    return;
+  }
+
+  // reset() clears them
+  SortColumns sort_columns(_sort_columns);
+  Column_filter_expr_map column_filter_expr_map(_column_filter_expr_map);
+  std::string data_search_string(_data_search_string);
+
+  VarGridModel::refresh();
+  bool res = reset(false);
+
+  _sort_columns.swap(sort_columns);
+  _column_filter_expr_map.swap(column_filter_expr_map);
+  _data_search_string.swap(data_search_string);
+  _sort_filter_on_server =
+    res && (!_sort_columns.empty() || !_column_filter_expr_map.empty() || !_data_search_string.empty());
+
+  if (rows_changed)
+    rows_changed();
+  refresh_ui();
 }
 
+//--------------------------------------------------------------------------------------------------
+
 void Recordset::rebuild_data_index(sqlite::connection *data_swap_db, bool do_cache_data_frame, bool do_refresh_ui) {
   {
     base::RecMutexLock data_mutex(_data_mutex);
+    invalidate_data_frames();
 
     std::string where_clause;
     {
@@ -917,7 +1131,15 @@ void Recordset::rebuild_data_index(sqlite::connection *data_swap_db, bool do_cac
       }
     }
 
-    {
+    // the rows already come sorted and filtered from the server
+    if (_sort_filter_on_server) {
+      where_clause.clear();
+      orderby_clause.clear();
+    }
+
+    if (_columnar_data)
+      rebuild_columnar_data_index();
+    else {
       sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db);
 
       std::string temp_table_name = "`data_index_" + grt::get_guid() + "`";
@@ -943,6 +1165,182 @@ void Recordset::rebuild_data_index(sqlite::connection *data_swap_db, bool do_cac
     refresh_ui();
 }
 
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * In memory version of the index built by rebuild_data_index(), applying the same column filters, search string
+ * and sort order to the rows of _columnar_data.
+ *
+ * The filtered rows are kept in _columnar_selection. When only the sort order changed or more rows arrived, just the
+ * new rows are filtered, and when the filters got narrower (a filter added, a text added to a pattern) only the
+ * rows of the previous selection are tried again.
+ */
+void Recordset::rebuild_columnar_data_index() {
+  size_t data_row_count = _columnar_data->row_count();
+  std::vector<RowId> index;
+
+  if (_sort_filter_on_server) {
+    _columnar_selection = ColumnarSelection();
+    index.reserve(data_row_count);
+    for (RowId row = 0; row < data_row_count; ++row)
+      index.push_back(row);
+    _columnar_index.swap(index);
+    return;
+  }
+
+  bool filtered = !_column_filter_expr_map.empty() || !_data_search_string.empty();
+  bool unchanged = false, narrower = false;
+  if (_columnar_selection.valid && filtered && _columnar_selection.data_row_count <= data_row_count) {
+    unchanged = _columnar_selection.filters == _column_filter_expr_map &&
+                _columnar_selection.search == _data_search_string;
+    narrower = _columnar_selection.search.empty() ||
+               Recordset_columnar_data::Matcher("%" + _data_search_string + "%")
+                 .narrows(Recordset_columnar_data::Matcher("%" + _columnar_selection.search + "%"));
+    for (auto &old_filter : _columnar_selection.filters) {
+      Column_filter_expr_map::const_iterator filter = _column_filter_expr_map.find(old_filter.first);
+      narrower = narrower && filter != _column_filter_expr_map.end() &&
+                 Recordset_columnar_data::Matcher(filter->second)
+                   .narrows(Recordset_columnar_data::Matcher(old_filter.second));
+    }
+  }
+
+  std::vector<RowId> new_rows;
+  RowId first_new_row = (unchanged || narrower) ? _columnar_selection.data_row_count : 0;
+  new_rows.reserve(data_row_count - first_new_row);
+  for (RowId row = first_new_row; row < data_row_count; ++row)
+    new_rows.push_back(row);
+
+  if (unchanged)
+    filter_columnar_rows(new_rows);
+  if (unchanged || narrower) {
+    index.reserve(_columnar_selection.rows.size() + new_rows.size());
+    index.assign(_columnar_selection.rows.begin(), _columnar_selection.rows.end());
+    index.insert(index.end(), new_rows.begin(), new_rows.end());
+  } else
+    index.swap(new_rows);
+  if (!unchanged)
+    filter_columnar_rows(index);
+
+  // without filters all rows are selected anyway, so there's nothing worth keeping
+  if (filtered) {
+    _columnar_selection.rows = index;
+    _columnar_selection.filters = _column_filter_expr_map;
+    _columnar_selection.search = _data_search_string;
+    _columnar_selection.data_row_count = data_row_count;
+    _columnar_selection.valid = true;
+  } else
+    _columnar_selection = ColumnarSelection();
+
+  if (!_sort_columns.empty()) {
+    struct SortKey {
+      ColumnId column;
+      bool numeric_cast;
+      bool nocase;
+      bool descending;
+    };
+    std::vector<SortKey> keys;
+    for (auto &sort_column : _sort_columns) {
+      if (sort_column.first >= _columnar_data->column_count())
+        continue;
+      ColumnType type = get_real_column_type(sort_column.first);
+      SortKey key = {sort_column.first, type == NumericType || type == FloatType || type == DatetimeType,
+                     type == StringType, sort_column.second == -1};
+      keys.push_back(key);
+    }
+
+    std::stable_sort(index.begin(), index.end(), [this, &keys](RowId row1, RowId row2) {
+      for (const SortKey &key : keys) {
+        int res = _columnar_data->compare(row1, row2, key.column, key.numeric_cast, key.nocase);
+        if (res != 0)
+          return key.descending ? res > 0 : res < 0;
+      }
+      return false;
+    });
+  }
+
+  _columnar_index.swap(index);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Applies the column filters and then the search string to the given rows. Each filter goes over all the rows still
+// left before the next one is tried.
+void Recordset::filter_columnar_rows(std::vector<RowId> &rows) const {
+  for (auto &column_filter_expr : _column_filter_expr_map) {
+    if (rows.empty())
+      return;
+    _columnar_data->filter(column_filter_expr.first, Recordset_columnar_data::Matcher(column_filter_expr.second),
+                           rows);
+  }
+
+  if (!_data_search_string.empty() && !rows.empty())
+    _columnar_data->search(std::min(get_column_count(), _columnar_data->column_count()),
+                           Recordset_columnar_data::Matcher("%" + _data_search_string + "%"), rows);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset::load_data_frame(RowId first_row, RowId row_count) {
+  if (!_columnar_data)
+    return false;
+
+  ColumnId data_column_count = _columnar_data->column_count();
+  RowId end_row = std::min<RowId>(first_row + row_count, _columnar_index.size());
+  _data.reserve((end_row > first_row ? end_row - first_row : 0) * _column_count);
+  for (RowId row = first_row; row < end_row; ++row) {
+    RowId data_row = _columnar_index[row];
+    for (ColumnId column = 0; column < _column_count; ++column) {
+      if (column == _rowid_column)
+        _data.push_back((int)(data_row + 1));
+      else if (column >= data_column_count ||
+               (optimized_blob_fetching() && sqlide::is_var_blob(_real_column_types[column])))
+        _data.push_back(sqlite::null_t());
+      else {
+        sqlite::variant_t value = _columnar_data->get(data_row, column);
+        _data.push_back(boost::apply_visitor(_var_cast, _column_types[column], value));
+      }
+    }
+  }
+  return true;
+}
+
+size_t Recordset::memory_size() {
+  base::RecMutexLock data_mutex WB_UNUSED(_data_mutex);
+  size_t size = data_frames_memory_size();
+  if (_columnar_data)
+    size += _columnar_data->memory_size() +
+            (_columnar_index.capacity() + _columnar_selection.rows.capacity()) * sizeof(RowId);
+  return size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/*
+ * Used to keep the results of all editor tabs within the memory budget. In memory rows are written to the data
+ * swap db tables and dropped, later data frames are read from there like for editable results.
+ */
+bool Recordset::release_memory() {
+  if (_fetching_rows)
+    return false;
+
+  base::RecMutexLock data_mutex WB_UNUSED(_data_mutex);
+  size_t size = memory_size();
+  std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
+  if (_columnar_data) {
+    Recordset_data_storage::flush_columnar_data(this, data_swap_db.get());
+    _columnar_data.reset();
+    std::vector<RowId>().swap(_columnar_index);
+    _columnar_selection = ColumnarSelection();
+    rebuild_data_index(data_swap_db.get(), false, false);
+  }
+  release_data_frames();
+  sqlite::execute(*data_swap_db, "pragma shrink_memory", true);
+
+  return memory_size() < size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Recordset::paste_rows_from_clipboard(ssize_t dest_row) {
   std::string text = mforms::Utilities::get_clipboard_text();
   std::vector<std::string> rows;
@@ -1203,8 +1601,10 @@ void Recordset::activate_menu_item(const std::string &action, const std::vector<
       std::string function;
       if (!get_cell(cell, node, clicked_column, false))
         function = "";
-      else
-        function = boost::apply_visitor(_var_to_str, *cell);
+      else {
+        sqlite::variant_t value = (*cell).get();
+        function = boost::apply_visitor(_var_to_str, value);
+      }
       if (!g_str_has_prefix(function.c_str(), "\\func"))
         set_field(node, clicked_column, std::string("\\func ") + function);
     }
@@ -1274,10 +1674,43 @@ void Recordset::activate_menu_item(const std::string &action, const std::vector<
 
 void Recordset::copy_rows_to_clipboard(const std::vector<int> &indeces, std::string sep, bool quoted,
                                        bool with_header) {
-  ColumnId editable_col_count = get_column_count();
-  if (!editable_col_count)
+  if (!get_column_count())
     return;
 
+  std::string text;
+  if (indeces.size() < BACKGROUND_COPY_ROWS) {
+    format_rows(indeces, sep, quoted, with_header, text, std::function<bool()>());
+    mforms::Utilities::set_clipboard_text(text);
+    return;
+  }
+
+  // A cancelled task only stops at the next block of rows, so it keeps the recordset and its result alive itself.
+  Recordset::Ref self(std::dynamic_pointer_cast<Recordset>(shared_from_this()));
+  std::shared_ptr<std::string> result(new std::string());
+  std::shared_ptr<std::atomic<bool> > cancelled(new std::atomic<bool>(false));
+  std::function<void *()> task = [self, indeces, sep, quoted, with_header, result, cancelled]() -> void * {
+    bool finished =
+      self->format_rows(indeces, sep, quoted, with_header, *result, [cancelled]() { return cancelled->load(); });
+    return finished ? result.get() : NULL;
+  };
+
+  std::function<bool()> cancel = [cancelled]() {
+    *cancelled = true;
+    return true;
+  };
+
+  void *task_result = NULL;
+  std::string message = strfmt(_("Copying %i rows to the clipboard..."), (int)indeces.size());
+  if (mforms::Utilities::run_cancelable_task(_("Copy Rows"), message, task, cancel, task_result) && task_result)
+    mforms::Utilities::set_clipboard_text(*result);
+}
+
+/**
+ * Formats the given rows as copy_rows_to_clipboard() puts them on the clipboard. May run on a worker thread, the data
+ * is locked for a block of rows at a time. Returns false if cancelled() returned true before all rows were done.
+ */
+bool Recordset::format_rows(const std::vector<int> &indeces, const std::string &sep, bool quoted, bool with_header,
+                            std::string &text, const std::function<bool()> &cancelled) {
   sqlide::QuoteVar qv;
   {
     qv.escape_string = std::bind(base::escape_sql_string, std::placeholders::_1, false);
@@ -1285,36 +1718,52 @@ void Recordset::copy_rows_to_clipboard(const std::vector<int> &indeces, std::str
     qv.allow_func_escaping = true;
   }
 
-  Cell cell;
-  std::string text;
-
-  if (with_header) {
-    text = "# ";
-    for (ColumnId col = 0; editable_col_count > col; ++col) {
-      if (col > 0)
-        text.append(sep);
-      text.append(get_column_caption(col));
+  // The converters keep a stream for formatting, so the grid's own one can't be shared with a worker.
+  ColumnId editable_col_count;
+  sqlide::VarToStr var_to_str;
+  {
+    base::RecMutexLock data_mutex(_data_mutex);
+    editable_col_count = get_column_count();
+    var_to_str.is_truncation_enabled = _var_to_str.is_truncation_enabled;
+    var_to_str.truncation_threshold = _var_to_str.truncation_threshold;
+
+    if (with_header) {
+      text = "# ";
+      for (ColumnId col = 0; editable_col_count > col; ++col) {
+        if (col > 0)
+          text.append(sep);
+        text.append(get_column_caption(col));
+      }
+      text.append("\n");
     }
-    text.append("\n");
   }
 
-  for (auto row : indeces) {
-    std::string line;
-    for (ColumnId col = 0; editable_col_count > col; ++col) {
-      bec::NodeId node(row);
-      if (!get_cell(cell, node, col, false))
-        continue;
-      if (col > 0)
-        line += sep;
-      if (quoted)
-        line += boost::apply_visitor(qv, _column_types[col], *cell);
-      else
-        line += boost::apply_visitor(_var_to_str, *cell);
+  Cell cell;
+  std::string line;
+  for (size_t first = 0; first < indeces.size(); first += COPY_ROWS_PER_LOCK) {
+    if (cancelled && cancelled())
+      return false;
+
+    base::RecMutexLock data_mutex(_data_mutex);
+    for (size_t i = first, end = std::min(first + COPY_ROWS_PER_LOCK, indeces.size()); i < end; ++i) {
+      line.clear();
+      bec::NodeId node(indeces[i]);
+      for (ColumnId col = 0; editable_col_count > col; ++col) {
+        if (!get_cell(cell, node, col, false))
+          continue;
+        if (col > 0)
+          line += sep;
+        sqlite::variant_t value = (*cell).get();
+        if (quoted)
+          line += boost::apply_visitor(qv, _column_types[col], value);
+        else
+          line += boost::apply_visitor(var_to_str, value);
+      }
+      if (!line.empty())
+        text.append(line).push_back('\n');
     }
-    if (!line.empty())
-      text += line + "\n";
   }
-  mforms::Utilities::set_clipboard_text(text);
+  return true;
 }
 
 void Recordset::copy_field_to_clipboard(int row, ColumnId column, bool quoted) {
@@ -1328,10 +1777,11 @@ void Recordset::copy_field_to_clipboard(int row, ColumnId column, bool quoted) {
   bec::NodeId node(row);
   Cell cell;
   if (get_cell(cell, node, column, false)) {
+    sqlite::variant_t value = (*cell).get();
     if (quoted)
-      text = boost::apply_visitor(qv, _column_types[column], *cell);
+      text = boost::apply_visitor(qv, _column_types[column], value);
     else
-      text = boost::apply_visitor(_var_to_str, *cell);
+      text = boost::apply_visitor(_var_to_str, value);
   }
   mforms::Utilities::set_clipboard_text(text);
 }
@@ -1352,7 +1802,16 @@ std::string Recordset::status_text() {
   }
 
   std::stringstream out;
-  out << "Fetched " << real_row_count() << " records" << skipped_row_count_text << limit_text;
+  if (_fetching_rows)
+    out << "Fetching records... " << real_row_count() << " so far" << skipped_row_count_text << limit_text;
+  else
+    out << "Fetched " << real_row_count() << " records" << skipped_row_count_text << limit_text;
+  if (_sort_filter_on_server)
+    out << ", sorted and filtered by the server";
+  else if (_data_storage && _data_storage->has_next_page())
+    out << ", more are fetched when scrolling down";
+  if (size_t size = memory_size())
+    out << strfmt(", %.1f MB in memory", size / (1024.0 * 1024.0));
   std::string status_text = out.str();
   {
     int upd_count = 0, ins_count = 0, del_count = 0;
@@ -1579,6 +2038,11 @@ public:
   }
 };
 
+bool Recordset::fetches_values_on_demand(ColumnId column) const {
+  return sqlide::is_var_blob(_real_column_types[column]) ||
+         (column < _column_flags.size() && (_column_flags[column] & LazyValueFlag));
+}
+
 void Recordset::open_field_data_editor(RowId row, ColumnId column, const std::string &logical_type) {
   base::RecMutexLock data_mutex(_data_mutex);
 
@@ -1586,7 +2050,7 @@ void Recordset::open_field_data_editor(RowId row, ColumnId column, const std::st
     sqlite::variant_t blob_value;
     sqlite::variant_t *value;
 
-    if (sqlide::is_var_blob(_real_column_types[column])) {
+    if (fetches_values_on_demand(column)) {
       if (!_data_storage)
         return;
       RowId rowid;
@@ -1601,7 +2065,8 @@ void Recordset::open_field_data_editor(RowId row, ColumnId column, const std::st
       bec::NodeId node(row);
       if (!get_cell(cell, node, column, false))
         return;
-      value = &(*cell);
+      blob_value = (*cell).get();
+      value = &blob_value;
     }
 
     DataEditorSelector2 data_editor_selector2(is_readonly(), logical_type);
@@ -1715,7 +2180,7 @@ bool Recordset::get_raw_field(const bec::NodeId &node, ColumnId column, std::str
   sqlite::variant_t blob_value;
   sqlite::variant_t *value;
 
-  if (sqlide::is_var_blob(_real_column_types[column])) {
+  if (fetches_values_on_demand(column)) {
     if (!_data_storage)
       return false;
     ssize_t rowid;
@@ -1728,7 +2193,8 @@ bool Recordset::get_raw_field(const bec::NodeId &node, ColumnId column, std::str
     Cell cell;
     if (!get_cell(cell, node, column, false))
       return false;
-    value = &(*cell);
+    blob_value = (*cell).get();
+    value = &blob_value;
   }
 
   BlobCopier copier;
@@ -1763,7 +2229,7 @@ void Recordset::save_to_file(const bec::NodeId &node, ColumnId column, const std
   sqlite::variant_t blob_value;
   sqlite::variant_t *value;
 
-  if (sqlide::is_var_blob(_real_column_types[column])) {
+  if (fetches_values_on_demand(column)) {
     if (!_data_storage)
       return;
     ssize_t rowid;
@@ -1776,7 +2242,8 @@ void Recordset::save_to_file(const bec::NodeId &node, ColumnId column, const std
     Cell cell;
     if (!get_cell(cell, node, column, false))
       return;
-    value = &(*cell);
+    blob_value = (*cell).get();
+    value = &blob_value;
   }
 
   DataValueDump data_value_dump(file.c_str());
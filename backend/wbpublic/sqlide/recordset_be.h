@@ -32,6 +32,7 @@
 #include <list>
 
 class Recordset_data_storage;
+class Recordset_columnar_data;
 class BinaryDataEditor;
 
 namespace mforms {
@@ -99,6 +100,20 @@ private:
   bool reset(Recordset_data_storage_Ptr data_storage_ptr, bool rethrow);
   void data_edited();
 
+public:
+  bool fetch_pending_rows(bool rethrow);
+  bool is_fetching_rows() const {
+    return _fetching_rows;
+  }
+
+private:
+  bool _fetching_rows;
+  void fetch_pending_row_chunks(Recordset_data_storage *data_storage, sqlite::connection *data_swap_db);
+  void finish_fetching_rows();
+
+  boost::signals2::scoped_connection _next_page_connection;
+  void fetch_next_page();
+
 public:
   RowId real_row_count() const;
 
@@ -203,6 +218,8 @@ private:
   int _selected_column;
 
   void activate_menu_item(const std::string &action, const std::vector<int> &rows, int clicked_column);
+  bool format_rows(const std::vector<int> &indeces, const std::string &sep, bool quoted, bool with_header,
+                   std::string &text, const std::function<bool()> &cancelled);
 
 public:
   void copy_rows_to_clipboard(const std::vector<int> &indeces, std::string sep = ", ", bool quoted = true,
@@ -233,9 +250,17 @@ public:
   virtual SortColumns sort_columns() const {
     return _sort_columns;
   }
+  // whether the current sorting and filtering was done by the server when the data was fetched
+  bool sorts_and_filters_on_server() const {
+    return _sort_filter_on_server;
+  }
 
 private:
   SortColumns _sort_columns; // column:direction(asc/desc)
+  bool _sort_filter_on_server;
+
+  bool can_sort_and_filter_on_server();
+  void apply_sort_and_filter();
 
 public:
   bool has_column_filters() const;
@@ -267,6 +292,45 @@ private:
 private:
   void rebuild_data_index(sqlite::connection *data_swap_db, bool do_cache_data_frame, bool do_refresh_ui);
 
+private:
+  std::shared_ptr<Recordset_columnar_data> _columnar_data; // data of read-only results, if kept in memory
+  std::vector<RowId> _columnar_index; // counterpart of the `data_index` table for _columnar_data
+  bool _columnar_data_flushed;        // whether the data swap db tables also got a copy of _columnar_data
+
+  // Rows of _columnar_data passing the filters and search string it was built with, in data order. A later rebuild
+  // with the same or narrower filters starts from these rows instead of all of them.
+  struct ColumnarSelection {
+    std::vector<RowId> rows;
+    Column_filter_expr_map filters;
+    std::string search;
+    size_t data_row_count; // rows of _columnar_data when it was built, the ones added later were not filtered yet
+    bool valid;
+
+    ColumnarSelection() : data_row_count(0), valid(false) {
+    }
+  };
+  ColumnarSelection _columnar_selection;
+
+  void rebuild_columnar_data_index();
+  void filter_columnar_rows(std::vector<RowId> &rows) const;
+
+protected:
+  virtual bool load_data_frame(RowId first_row, RowId row_count);
+  virtual bool prefetch_data_frames() const {
+    return !_columnar_data;
+  }
+  // whether the cells of the column may not hold the whole values, which then have to be read from the data storage
+  bool fetches_values_on_demand(ColumnId column) const;
+
+public:
+  // bytes of result data held in memory, by the data frames and the in memory rows of read-only results
+  size_t memory_size();
+  // leaves the data to the data swap db, returns false if nothing could be released
+  bool release_memory();
+
+private:
+  void register_memory_source();
+
 public:
   void caption(const std::string &val) {
     _caption = val;
@@ -294,6 +358,7 @@ private:
   std::string _caption;
   std::string _generator_query;
   long _id;
+  int _memory_source; // memory accounting of the recordset, see base::MemoryAccounting
   ClientData *_client_data;
   mforms::ToolBar *_toolbar;
 
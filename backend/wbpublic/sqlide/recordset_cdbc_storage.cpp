@@ -29,8 +29,12 @@
 #include "grtsqlparser/sql_facade.h"
 #include "base/string_utilities.h"
 #include "base/sqlstring.h"
+#include "base/trace.h"
 #include <sqlite/query.hpp>
 #include <algorithm>
+#include <set>
+#include <sstream>
+#include <cstdlib>
 #include <ctype.h>
 
 using namespace bec;
@@ -38,7 +42,19 @@ using namespace grt;
 using namespace base;
 
 Recordset_cdbc_storage::Recordset_cdbc_storage()
-  : Recordset_sql_storage(), _reloadable(true), _gather_field_info(false) {
+  : Recordset_sql_storage(),
+    _reloadable(true),
+    _gather_field_info(false),
+    _first_frame_row_count(0),
+    _use_columnar_data(false),
+    _server_side_sort_filter(false),
+    _keyset_paging(false),
+    _keyset_columns_read(false),
+    _keyset_page_rows(0),
+    _max_allowed_packet(0),
+    _lazy_large_columns(false),
+    _prepared_reloads(false),
+    _table_columns_read(false) {
 }
 
 Recordset_cdbc_storage::~Recordset_cdbc_storage() {
@@ -110,6 +126,40 @@ private:
   size_t _foreknown_blob_size;
 };
 
+// State of a result set that is still being read after its first frame of rows was handed over to the grid.
+struct Recordset_cdbc_storage::PendingFetch {
+  std::shared_ptr<sql::Statement> stmt;
+  std::shared_ptr<sql::ResultSet> rs;
+  ColumnId editable_col_count;
+  std::vector<ColumnId> pkey_columns; // as found in the result set, before remapping to the duplicated columns
+  std::vector<bool> null_value_columns;
+  std::vector<bool> lazy_columns; // read as "size:preview" strings
+  Recordset_columnar_data::Ref columnar_data; // where rows go instead of the data swap db, if set
+};
+
+/*
+ * Turns the "size:preview" read for a lazy column into what the grid shows. Values that came in whole are kept as
+ * they are.
+ */
+static std::string lazy_value_preview(const std::string &value) {
+  std::string::size_type colon = value.find(':');
+  if (colon == std::string::npos)
+    return value;
+  std::uint64_t size = std::strtoull(value.substr(0, colon).c_str(), NULL, 10);
+  std::string preview = value.substr(colon + 1);
+  if (preview.size() == size)
+    return preview;
+
+  std::string size_text;
+  if (size < 1024)
+    size_text = strfmt("%u B", (unsigned int)size);
+  else if (size < 1024 * 1024)
+    size_text = strfmt("%.1f KB", size / 1024.0);
+  else
+    size_text = strfmt("%.1f MB", size / (1024.0 * 1024.0));
+  return preview.empty() ? size_text : size_text + " " + preview + "...";
+}
+
 size_t Recordset_cdbc_storage::determine_pkey_columns(Recordset::Column_names &column_names,
                                                       Recordset::Column_types &column_types,
                                                       Recordset::Column_types &real_column_types) {
@@ -157,6 +207,48 @@ size_t Recordset_cdbc_storage::determine_pkey_columns(Recordset::Column_names &c
   return 0;
 }
 
+/*
+ * Reads the PRIMARY key columns of the table and the columns of the first other key having a NOT NULL column.
+ */
+void Recordset_cdbc_storage::read_key_columns(sql::Dbc_connection_handler::Ref &conn,
+                                              std::list<std::string> &primary_columns,
+                                              std::list<std::string> &unique_notnull_columns) {
+  // Same rows as SHOW INDEX, but the names are parameters so the statement is prepared only once per connection.
+  sql::PreparedStatement *stmt = conn->prepared_statement(
+    "SELECT COLUMN_NAME AS Column_name, NULLABLE AS `Null`, INDEX_NAME AS Key_name FROM INFORMATION_SCHEMA.STATISTICS "
+    "WHERE TABLE_SCHEMA = ? AND TABLE_NAME = ? ORDER BY INDEX_NAME <> 'PRIMARY', INDEX_NAME, SEQ_IN_INDEX");
+  stmt->setString(1, _schema_name);
+  stmt->setString(2, _table_name);
+  std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery());
+  std::list<std::string> columns;
+
+  bool found_not_null = false;
+  std::string prev_key;
+  while (rs->next()) {
+    std::string column = rs->getString("Column_name");
+    std::string null = rs->getString("Null");
+    std::string key = rs->getString("Key_name");
+
+    if (key == "PRIMARY") {
+      primary_columns.push_back(column);
+    } else {
+      // at least one of the columns must be NOT NULL in a UNIQUE key
+      if (prev_key != key) {
+        prev_key = key;
+        if (found_not_null && unique_notnull_columns.empty())
+          unique_notnull_columns = columns;
+        found_not_null = false;
+        columns.clear();
+      }
+      columns.push_back(column);
+      if (null == "")
+        found_not_null = true;
+    }
+  }
+  if (found_not_null && unique_notnull_columns.empty() && !columns.empty())
+    unique_notnull_columns = columns;
+}
+
 size_t Recordset_cdbc_storage::determine_pkey_columns_alt(Recordset::Column_names &column_names,
                                                           Recordset::Column_types &column_types,
                                                           Recordset::Column_types &real_column_types) {
@@ -166,38 +258,10 @@ size_t Recordset_cdbc_storage::determine_pkey_columns_alt(Recordset::Column_name
   base::RecMutexLock lock(
     _getAuxConnection(conn, true)); // we can't perform full connection check, hence we use the simple one
   {
-    std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
-    std::string q = base::sqlstring("SHOW INDEX FROM !.!", 0) << _schema_name << _table_name;
     try {
-      std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery(q));
       std::list<std::string> primary_columns;
       std::list<std::string> unique_notnull_columns, columns;
-
-      bool found_not_null = false;
-      std::string prev_key;
-      while (rs->next()) {
-        std::string column = rs->getString("Column_name");
-        std::string null = rs->getString("Null");
-        std::string key = rs->getString("Key_name");
-
-        if (key == "PRIMARY") {
-          primary_columns.push_back(column);
-        } else {
-          // at least one of the columns must be NOT NULL in a UNIQUE key
-          if (prev_key != key) {
-            prev_key = key;
-            if (found_not_null && unique_notnull_columns.empty())
-              unique_notnull_columns = columns;
-            found_not_null = false;
-            columns.clear();
-          }
-          columns.push_back(column);
-          if (null == "")
-            found_not_null = true;
-        }
-      }
-      if (found_not_null && unique_notnull_columns.empty() && !columns.empty())
-        unique_notnull_columns = columns;
+      read_key_columns(conn, primary_columns, unique_notnull_columns);
 
       if (!primary_columns.empty())
         columns = primary_columns;
@@ -238,6 +302,38 @@ size_t Recordset_cdbc_storage::determine_pkey_columns_alt(Recordset::Column_name
   return 0;
 }
 
+/**
+ * Runs the stored query (or a page of it) on the user connection. With prepared_reloads() set the result is read in
+ * the binary protocol. Statements the server refuses to prepare, e.g. ones with a ? outside of a literal, fall back
+ * to the text protocol. Note that FLOAT values then arrive with the precision of a float rather than as the shortest
+ * text the server would print for them.
+ */
+void Recordset_cdbc_storage::run_query(sql::Dbc_connection_handler::Ref &conn, const std::string &sql_query,
+                                       std::shared_ptr<sql::Statement> &stmt, std::shared_ptr<sql::ResultSet> &rs) {
+  if (_prepared_reloads) {
+    std::shared_ptr<sql::PreparedStatement> prepared;
+    try {
+      prepared.reset(conn->ref->prepareStatement(sql_query));
+    } catch (sql::SQLException &) {
+      prepared.reset();
+    }
+
+    if (prepared) {
+      prepared->execute();
+      rs.reset(prepared->getResultSet());
+      stmt = prepared;
+      return;
+    }
+  }
+
+  stmt.reset(conn->ref->createStatement());
+  // if (!_schema_name.empty()) //! default schema is to be set for connector
+  //  stmt->execute(strfmt("use `%s`", _schema_name.c_str()));
+  // stmt->setFetchSize(100); //! setFetchSize is not implemented. param value to be customized.
+  stmt->execute(sql_query);
+  rs.reset(stmt->getResultSet());
+}
+
 void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connection *data_swap_db) {
   sql::Dbc_connection_handler::Ref conn;
   base::RecMutexLock lock(
@@ -255,7 +351,12 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
   
   std::shared_ptr<sql::Statement> stmt;
   std::shared_ptr<sql::ResultSet> rs;
+  size_t first_frame_row_count = 0;
+  _pending_fetch.reset();
+  _fetch_timings = FetchTimings();
   if (_dbc_resultset) {
+    // only a result set handed over by the caller is streamed, as only that caller knows to read the rest of it
+    first_frame_row_count = _first_frame_row_count;
     rs = _dbc_resultset;
     _dbc_resultset.reset(); // handover memory management to scope shared_ptr because resultset can be read 1 time only
     // same about statement
@@ -264,12 +365,7 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
   } else {
     if (!_reloadable)
       throw std::runtime_error("Recordset can't be reloaded, original statement must be reexecuted instead");
-    stmt.reset(conn->ref->createStatement());
-    // if (!_schema_name.empty()) //! default schema is to be set for connector
-    //  stmt->execute(strfmt("use `%s`", _schema_name.c_str()));
-    // stmt->setFetchSize(100); //! setFetchSize is not implemented. param value to be customized.
-    stmt->execute(sql_query);
-    rs.reset(stmt->getResultSet());
+    run_query(conn, sql_query, stmt, rs);
   }
 
   _valid = (NULL != rs.get());
@@ -409,6 +505,25 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
   for (unsigned int n = (unsigned int)column_names.size(); (unsigned int)editable_col_count > n; ++n)
     column_names.push_back(rs_meta->getColumnLabel(n + 1));
 
+  // columns read as size and preview keep the types of the table columns
+  std::vector<bool> lazy_columns(editable_col_count);
+  if (!_lazy_columns.empty()) {
+    for (auto &table_column : _table_columns) {
+      if (_lazy_columns.find(table_column.first) == _lazy_columns.end())
+        continue;
+      for (ColumnId n = 0; n < editable_col_count; ++n)
+        if (column_names[n] == table_column.first && n < column_types.size()) {
+          std::string type_name = base::toupper(table_column.second);
+          type_name = type_name.substr(0, type_name.find_first_of("( "));
+          dbColumnTypes[n] = type_name;
+          column_types[n] = known_types[type_name];
+          real_column_types[n] = known_real_types[type_name];
+          column_flags[n] |= Recordset::LazyValueFlag;
+          lazy_columns[n] = true;
+        }
+    }
+  }
+
   // determine pkey or unique identifier columns
   ColumnId rowid_col_count = 0;
   if (!_table_name
@@ -425,46 +540,202 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
   {
     bool are_null_columns_possible = recordset->optimized_blob_fetching() && _reloadable && rowid_col_count;
     for (ColumnId col = 0; editable_col_count > col; ++col)
-      null_value_columns[col] = are_null_columns_possible && sqlide::is_var_blob(real_column_types[col]);
+      null_value_columns[col] =
+        are_null_columns_possible && sqlide::is_var_blob(real_column_types[col]) && !lazy_columns[col];
   }
 
   // data
   {
+    PendingFetch fetch;
+    fetch.stmt = stmt;
+    fetch.rs = rs;
+    fetch.editable_col_count = editable_col_count;
+    fetch.pkey_columns = _pkey_columns;
+    fetch.null_value_columns = null_value_columns;
+    fetch.lazy_columns = lazy_columns;
+
+    // nothing gets written back for read-only results, so their rows don't need to go through SQLite
+    if (_use_columnar_data && _readonly && rowid_col_count == 0) {
+      fetch.columnar_data = Recordset_columnar_data::create(column_types);
+      set_columnar_data(recordset, fetch.columnar_data);
+    }
+
+    // the query got ordered by the primary key if keyset paging applies, it can be used if the key is in the results
+    _keyset_fetch.reset();
+    _keyset_last_key.clear();
+    _keyset_page_rows = 0;
+    if (keyset_paging_applies() && !fetch.columnar_data && fetch.pkey_columns.size() == _keyset_columns.size()) {
+      bool key_in_results = true;
+      for (size_t i = 0; i < _keyset_columns.size() && key_in_results; ++i)
+        key_in_results = column_names[fetch.pkey_columns[i]] == _keyset_columns[i] &&
+                         !sqlide::is_var_blob(column_types[fetch.pkey_columns[i]]);
+      if (key_in_results) {
+        _keyset_fetch.reset(new PendingFetch(fetch));
+        _keyset_fetch->stmt.reset();
+        _keyset_fetch->rs.reset();
+      }
+    }
+
     sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db, false);
 
     create_data_swap_tables(data_swap_db, column_names, column_types);
 
-    FetchVar fetch_var(rs.get());
-    Var_vector row_values(editable_col_count + rowid_col_count);
+    // With a first frame size set, only that many rows are read here. The rest stay on the server until
+    // fetch_pending_rows() is called, so the grid can show the first rows while the result is still arriving.
+    size_t fetched_rows;
+    if (fetch_rows(fetch, recordset, data_swap_db, conn, first_frame_row_count, fetched_rows))
+      _pending_fetch.reset(new PendingFetch(fetch));
 
-    std::list<std::shared_ptr<sqlite::command> > insert_commands =
-      prepare_data_swap_record_add_statement(data_swap_db, column_names);
-    // XXX this will fetch all records before displaying them, which will result in a huge unnecessary lag in the UI
-    while (rs->next()) {
-      for (ColumnId n = 0; editable_col_count > n; ++n) {
-        if (rs->isNull((int)n + 1) || null_value_columns[n]) {
-          row_values[n] = sqlite::null_t();
-        } else {
-          sqlite::variant_t index = (int)n + 1;
-          row_values[n] = boost::apply_visitor(fetch_var, column_types[n], index);
-        }
+    transaction_guarder.commit();
+  }
+
+  // remap rowid columns to duplicated columns
+  for (ColumnId rowid_col = 0, col = editable_col_count; rowid_col_count > rowid_col; ++col, ++rowid_col)
+    _pkey_columns[rowid_col] = col;
+}
+
+/*
+ * Reads up to max_rows rows (0 for all) of the result set into the data swap db.
+ * Returns true if there are rows left to read.
+ */
+bool Recordset_cdbc_storage::fetch_rows(PendingFetch &fetch, Recordset *recordset, sqlite::connection *data_swap_db,
+                                        sql::Dbc_connection_handler::Ref &conn, size_t max_rows,
+                                        size_t &fetched_rows) {
+  Recordset::Column_names &column_names = get_column_names(recordset);
+  Recordset::Column_types &column_types = get_column_types(recordset);
+
+  ColumnId editable_col_count = fetch.editable_col_count;
+  ColumnId rowid_col_count = fetch.pkey_columns.size();
+  sql::ResultSet *rs = fetch.rs.get();
+
+  FetchVar fetch_var(rs);
+  Var_vector row_values(editable_col_count + rowid_col_count);
+
+  // the aux `id` column added by the recordset doesn't go into the data tables
+  Recordset::Column_names data_column_names(column_names.begin(),
+                                            column_names.begin() + (editable_col_count + rowid_col_count));
+  std::list<std::shared_ptr<sqlite::command> > insert_commands;
+  if (!fetch.columnar_data)
+    insert_commands = prepare_data_swap_record_add_statement(data_swap_db, data_column_names);
+  bool more_rows = true;
+  std::uint64_t start = base::Tracer::now();
+  std::uint64_t read_time = 0, convert_time = 0, store_time = 0;
+  std::uint64_t last = start, now;
+  for (fetched_rows = 0; max_rows == 0 || fetched_rows < max_rows; ++fetched_rows) {
+    if (!rs->next()) {
+      more_rows = false;
+      break;
+    }
+    now = base::Tracer::now();
+    read_time += now - last;
+    last = now;
+
+    for (ColumnId n = 0; editable_col_count > n; ++n) {
+      if (rs->isNull((int)n + 1) || fetch.null_value_columns[n]) {
+        row_values[n] = sqlite::null_t();
+      } else if (fetch.lazy_columns[n]) {
+        row_values[n] = lazy_value_preview(rs->getString((int)n + 1));
+      } else {
+        sqlite::variant_t index = (int)n + 1;
+        row_values[n] = boost::apply_visitor(fetch_var, column_types[n], index);
       }
-      for (ColumnId n = 0; rowid_col_count > n; ++n) // copy original value of pk field(s)
-        row_values[editable_col_count + n] = row_values[_pkey_columns[n]];
+    }
+    for (ColumnId n = 0; rowid_col_count > n; ++n) // copy original value of pk field(s)
+      row_values[editable_col_count + n] = row_values[fetch.pkey_columns[n]];
+    now = base::Tracer::now();
+    convert_time += now - last;
+    last = now;
+    if (fetch.columnar_data)
+      fetch.columnar_data->add_row(row_values);
+    else
       add_data_swap_record(insert_commands, row_values);
+    now = base::Tracer::now();
+    store_time += now - last;
+    last = now;
+
+    if (conn->is_stop_query_requested)
+      throw std::runtime_error(
+        _("Query execution has been stopped, the connection to the DB server was not restarted, any open transaction "
+          "remains open"));
+  }
 
-      if (conn->is_stop_query_requested)
-        throw std::runtime_error(
-          _("Query execution has been stopped, the connection to the DB server was not restarted, any open transaction "
-            "remains open"));
-    }
+  // the reading of the end of the result set counts too
+  read_time += base::Tracer::now() - last;
+  _fetch_timings.read += read_time;
+  _fetch_timings.convert += convert_time;
+  _fetch_timings.store += store_time;
+  _fetch_timings.rows += fetched_rows;
+
+  // the phases alternate for every row, so the trace gets their totals one after the other
+  if (base::Tracer::enabled()) {
+    std::uint64_t converted = start + read_time + convert_time;
+    base::Tracer::record("sqlide", "Recordset_cdbc_storage::read_rows", start, start + read_time);
+    base::Tracer::record("sqlide", "Recordset_cdbc_storage::convert_values", start + read_time, converted);
+    base::Tracer::record("sqlide", "Recordset_cdbc_storage::store_rows", converted, converted + store_time);
+  }
 
+  // row_values still holds the last row read, with the copies of its key at the end
+  if (_keyset_fetch && fetched_rows > 0)
+    _keyset_last_key.assign(row_values.begin() + editable_col_count, row_values.end());
+  _keyset_page_rows += fetched_rows;
+
+  return more_rows;
+}
+
+size_t Recordset_cdbc_storage::fetch_pending_rows(Recordset *recordset, sqlite::connection *data_swap_db,
+                                                  size_t max_rows) {
+  if (!_pending_fetch)
+    return 0;
+
+  // once something goes wrong the rest of the result set is dropped, whatever was read so far stays
+  std::shared_ptr<PendingFetch> fetch(_pending_fetch);
+  _pending_fetch.reset();
+
+  sql::Dbc_connection_handler::Ref conn;
+  base::RecMutexLock lock(
+    _getUserConnection(conn, true)); // we can't perform full connection check, hence we use the simple one
+
+  size_t fetched_rows;
+  {
+    sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db, false);
+    if (fetch_rows(*fetch, recordset, data_swap_db, conn, max_rows, fetched_rows))
+      _pending_fetch = fetch;
     transaction_guarder.commit();
   }
+  return fetched_rows;
+}
 
-  // remap rowid columns to duplicated columns
-  for (ColumnId rowid_col = 0, col = editable_col_count; rowid_col_count > rowid_col; ++col, ++rowid_col)
-    _pkey_columns[rowid_col] = col;
+bool Recordset_cdbc_storage::has_next_page() const {
+  // a page that came back shorter than the limit was the last one
+  return _keyset_fetch && !_pending_fetch && !_keyset_last_key.empty() && _limit_rows && _limit_rows_count > 0 &&
+         _keyset_page_rows >= (size_t)_limit_rows_count;
+}
+
+/*
+ * Runs the query for the rows following the last key read, they are then read by fetch_pending_rows().
+ */
+bool Recordset_cdbc_storage::start_next_page() {
+  if (!has_next_page())
+    return false;
+
+  std::string sql_query = keyset_page_query();
+
+  sql::Dbc_connection_handler::Ref conn;
+  base::RecMutexLock lock(
+    _getUserConnection(conn, true)); // we can't perform full connection check, hence we use the simple one
+
+  std::shared_ptr<sql::Statement> stmt;
+  std::shared_ptr<sql::ResultSet> rs;
+  run_query(conn, sql_query, stmt, rs);
+  if (!rs)
+    return false;
+
+  std::shared_ptr<PendingFetch> fetch(new PendingFetch(*_keyset_fetch));
+  fetch->stmt = stmt;
+  fetch->rs = rs;
+  _pending_fetch = fetch;
+  _keyset_page_rows = 0;
+  return true;
 }
 
 void Recordset_cdbc_storage::do_fetch_blob_value(Recordset *recordset, sqlite::connection *data_swap_db, RowId rowid,
@@ -479,7 +750,8 @@ void Recordset_cdbc_storage::do_fetch_blob_value(Recordset *recordset, sqlite::c
   if (column >= column_names.size())
     return;
 
-  std::string sql_query = decorated_sql_query();
+  // the query reading the whole values
+  std::string sql_query = decorated_sql_query(false);
   {
     std::string pkey_predicate;
     get_pkey_predicate_for_data_cache_rowid(recordset, data_swap_db, rowid, pkey_predicate);
@@ -518,19 +790,52 @@ void Recordset_cdbc_storage::do_fetch_blob_value(Recordset *recordset, sqlite::c
   }
 }
 
-class BlobVarToStream : public boost::static_visitor<std::shared_ptr<std::stringstream> > {
+// Reads a bound value in place. The statement sends it in chunks with mysql_stmt_send_long_data(), so large values
+// are not copied into a string and then into a stream first.
+class ValueStreamBuf : public std::streambuf {
+public:
+  ValueStreamBuf(const char *data, size_t length) {
+    char *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + length);
+  }
+
+protected:
+  virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    char *position = (dir == std::ios_base::beg ? eback() : (dir == std::ios_base::end ? egptr() : gptr())) + offset;
+    if (position < eback() || position > egptr())
+      return pos_type(off_type(-1));
+    setg(eback(), position, egptr());
+    return pos_type(position - eback());
+  }
+  virtual pos_type seekpos(pos_type position, std::ios_base::openmode which) {
+    return seekoff(off_type(position), std::ios_base::beg, which);
+  }
+};
+
+class ValueStream : public std::istream {
+public:
+  ValueStream(const char *data, size_t length) : std::istream(NULL), _buffer(data, length) {
+    rdbuf(&_buffer);
+  }
+
+private:
+  ValueStreamBuf _buffer;
+};
+
+// The streams point into the bound values, they must not outlive the statement bindings.
+class BlobVarToStream : public boost::static_visitor<std::shared_ptr<std::istream> > {
 public:
   result_type operator()(const sqlite::blob_ref_t &v) {
-    size_t data_length = v->size();
-    std::string data((const char *)&(*v)[0], data_length);
-    return result_type(new std::stringstream(data));
+    if (!v || v->empty())
+      return result_type(new ValueStream(NULL, 0));
+    return result_type(new ValueStream((const char *)&(*v)[0], v->size()));
   }
   result_type operator()(const std::string &v) {
-    return result_type(new std::stringstream(v));
+    return result_type(new ValueStream(v.data(), v.size()));
   }
   template <typename V>
   result_type operator()(const V &t) {
-    return result_type(new std::stringstream());
+    return result_type(new ValueStream(NULL, 0));
   }
 };
 
@@ -550,14 +855,14 @@ void Recordset_cdbc_storage::run_sql_script(const Sql_script &sql_script, bool s
   for (const std::string &sql : sql_script.statements) {
     try {
       stmt.reset(conn->ref->prepareStatement(sql));
-      std::list<std::shared_ptr<std::stringstream> > blob_streams;
+      std::list<std::shared_ptr<std::istream> > blob_streams;
       if (sql_script.statements_bindings.end() != sql_bindings) {
         int bind_var_index = 1;
         for (const sqlite::variant_t &bind_var : *sql_bindings) {
           if (sqlide::is_var_null(bind_var)) {
             stmt->setNull(bind_var_index, 0);
           } else {
-            std::shared_ptr<std::stringstream> blob_stream = boost::apply_visitor(blob_var_to_stream, bind_var);
+            std::shared_ptr<std::istream> blob_stream = boost::apply_visitor(blob_var_to_stream, bind_var);
             if (binding_blobs()) {
               blob_streams.push_back(blob_stream);
               stmt->setBlob(bind_var_index, blob_stream.get());
@@ -590,12 +895,63 @@ void Recordset_cdbc_storage::run_sql_script(const Sql_script &sql_script, bool s
   }
 }
 
+/*
+ * Multi-row statements must fit into a packet the server accepts, leave some room for the protocol.
+ */
+size_t Recordset_cdbc_storage::max_batch_statement_size() {
+  static const size_t DEFAULT_MAX_ALLOWED_PACKET = 1024 * 1024;
+  static const size_t PACKET_OVERHEAD = 1024;
+
+  if (_max_allowed_packet == 0) {
+    _max_allowed_packet = DEFAULT_MAX_ALLOWED_PACKET;
+    sql::Dbc_connection_handler::Ref conn;
+    base::RecMutexLock lock(_getAuxConnection(conn, true));
+    try {
+      std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
+      std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT @@max_allowed_packet"));
+      if (rs->next() && rs->getUInt64(1) > PACKET_OVERHEAD)
+        _max_allowed_packet = (size_t)rs->getUInt64(1);
+    } catch (sql::SQLException &) {
+      // stay with the server default
+    }
+  }
+  return _max_allowed_packet - PACKET_OVERHEAD;
+}
+
 std::string Recordset_cdbc_storage::decorated_sql_query() {
+  return decorated_sql_query(true);
+}
+
+std::string Recordset_cdbc_storage::decorated_sql_query(bool lazy_columns) {
   std::string sql_query;
-  if (!_sql_query.empty())
-    sql_query = _sql_query;
-  else
-    sql_query = strfmt("select * from %s%s", full_table_name().c_str(), _additional_clauses.c_str());
+  if (lazy_columns) {
+    _lazy_columns.clear();
+    if (lazy_columns_apply())
+      sql_query = lazy_columns_query();
+  }
+  if (sql_query.empty()) {
+    if (!_sql_query.empty())
+      sql_query = _sql_query;
+    else
+      sql_query = strfmt("select * from %s%s", full_table_name().c_str(), _additional_clauses.c_str());
+  }
+
+  // sorting and filtering requested by the recordset go around the original query, so they also cover the rows the
+  // limit clause would otherwise leave out
+  if (!_server_where_clause.empty() || !_server_order_by_clause.empty()) {
+    sql_query = "SELECT * FROM (\n" + sql_query + "\n) AS `sorted_result`";
+    if (!_server_where_clause.empty())
+      sql_query += " WHERE " + _server_where_clause;
+    if (!_server_order_by_clause.empty())
+      sql_query += " ORDER BY " + _server_order_by_clause;
+  } else if (keyset_paging_applies()) {
+    // pages must come in key order for the next one to start after the last key read
+    sql_query = base::trim_right(sql_query, SPACES ";");
+    std::string key_columns;
+    for (auto &column : _keyset_columns)
+      key_columns += std::string(base::sqlstring(key_columns.empty() ? "!" : ", !", 0) << column);
+    sql_query += "\nORDER BY " + key_columns;
+  }
 
   if (_limit_rows) {
     SqlFacade::Ref sql_facade = SqlFacade::instance_for_rdbms(_rdbms);
@@ -605,3 +961,191 @@ std::string Recordset_cdbc_storage::decorated_sql_query() {
 
   return sql_query;
 }
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_cdbc_storage::sort_and_filter_on_server(const Recordset *recordset) {
+  // only single table results (as opened with Select Rows) are known to be safe to wrap into a derived table
+  if (!_server_side_sort_filter || !_reloadable || _table_name.empty())
+    return false;
+
+  const Recordset::Column_names &column_names = *recordset->column_names();
+  ColumnId column_count = std::min(recordset->get_column_count(), column_names.size());
+  std::set<std::string> unique_column_names(column_names.begin(), column_names.begin() + column_count);
+  if (unique_column_names.size() != column_count)
+    return false; // columns of the derived table must be addressable by name
+
+  std::string where_clause;
+  for (ColumnId column = 0; column < column_count; ++column) {
+    if (recordset->has_column_filter(column))
+      where_clause += std::string(base::sqlstring("! LIKE ? AND ", 0)
+                                  << column_names[column] << recordset->get_column_filter_expr(column));
+  }
+  if (!recordset->data_search_string().empty()) {
+    std::string pattern = "%" + recordset->data_search_string() + "%";
+    std::string search_clause;
+    for (ColumnId column = 0; column < column_count; ++column)
+      search_clause += std::string(base::sqlstring("! LIKE ? OR ", 0) << column_names[column] << pattern);
+    if (!search_clause.empty()) {
+      search_clause.resize(search_clause.size() - std::string(" OR ").size());
+      where_clause += "(" + search_clause + ") AND ";
+    }
+  }
+  if (!where_clause.empty())
+    where_clause.resize(where_clause.size() - std::string(" AND ").size());
+
+  std::string order_by_clause;
+  for (auto &sort_column : recordset->sort_columns()) {
+    if (sort_column.first >= column_count)
+      continue;
+    order_by_clause += std::string(base::sqlstring("!", 0) << column_names[sort_column.first]);
+    order_by_clause += (sort_column.second == -1) ? " DESC, " : " ASC, ";
+  }
+  if (!order_by_clause.empty())
+    order_by_clause.resize(order_by_clause.size() - std::string(", ").size());
+
+  _server_where_clause = where_clause;
+  _server_order_by_clause = order_by_clause;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// whether the query is a plain select of all of a table, as issued by Select Rows
+static bool is_plain_table_select(const std::string &query) {
+  std::istringstream stream(base::trim_right(query, SPACES ";"));
+  std::vector<std::string> words;
+  std::string word;
+  while (stream >> word)
+    words.push_back(base::tolower(word));
+  return words.size() == 4 && words[0] == "select" && words[1] == "*" && words[2] == "from";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_cdbc_storage::keyset_paging_applies() {
+  if (!_keyset_paging || !_limit_rows || !_reloadable || _table_name.empty() || !_server_where_clause.empty() ||
+      !_server_order_by_clause.empty())
+    return false;
+  if (_sql_query.empty() ? !_additional_clauses.empty() : !is_plain_table_select(_sql_query))
+    return false;
+
+  if (!_keyset_columns_read) {
+    _keyset_columns_read = true;
+    sql::Dbc_connection_handler::Ref conn;
+    base::RecMutexLock lock(_getAuxConnection(conn, true));
+    try {
+      std::list<std::string> primary_columns, unique_notnull_columns;
+      read_key_columns(conn, primary_columns, unique_notnull_columns);
+      _keyset_columns.assign(primary_columns.begin(), primary_columns.end());
+    } catch (sql::SQLException &) {
+      // no keyset paging then, the row limit still works with offsets
+      _keyset_columns.clear();
+    }
+  }
+  return !_keyset_columns.empty();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string Recordset_cdbc_storage::keyset_page_query() {
+  std::string sql_query = _sql_query.empty() ? "select * from " + full_table_name() : _sql_query;
+  if (!_lazy_columns.empty())
+    sql_query = lazy_columns_query();
+
+  sqlide::VarToStr var_to_str;
+  std::string key_columns, key_values;
+  for (size_t i = 0; i < _keyset_columns.size(); ++i) {
+    if (i > 0) {
+      key_columns += ", ";
+      key_values += ", ";
+    }
+    key_columns += std::string(base::sqlstring("!", 0) << _keyset_columns[i]);
+    key_values += std::string(base::sqlstring("?", 0) << boost::apply_visitor(var_to_str, _keyset_last_key[i]));
+  }
+
+  return strfmt("%s\nWHERE (%s) > (%s)\nORDER BY %s\nLIMIT %i", base::trim_right(sql_query, SPACES ";").c_str(),
+                key_columns.c_str(), key_values.c_str(), key_columns.c_str(), _limit_rows_count);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static bool is_large_column_type(const std::string &type) {
+  std::string type_name = base::tolower(type);
+  type_name = type_name.substr(0, type_name.find_first_of("( "));
+  return type_name == "blob" || type_name == "mediumblob" || type_name == "longblob" || type_name == "text" ||
+         type_name == "mediumtext" || type_name == "longtext" || type_name == "json";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/*
+ * Whether large columns of the table can be read as size and preview, which needs their values to be fetched again
+ * by key later.
+ */
+bool Recordset_cdbc_storage::lazy_columns_apply() {
+  if (!_lazy_large_columns || !_reloadable || _table_name.empty())
+    return false;
+  if (_sql_query.empty() ? !_additional_clauses.empty() : !is_plain_table_select(_sql_query))
+    return false;
+
+  if (!_table_columns_read) {
+    _table_columns_read = true;
+    sql::Dbc_connection_handler::Ref conn;
+    base::RecMutexLock lock(_getAuxConnection(conn, true));
+    try {
+      std::auto_ptr<sql::Statement> stmt(conn->ref->createStatement());
+      std::string q = base::sqlstring("SHOW COLUMNS FROM !.!", 0) << _schema_name << _table_name;
+      std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery(q));
+      while (rs->next())
+        _table_columns.push_back(std::make_pair(rs->getString("Field"), rs->getString("Type")));
+
+      std::list<std::string> primary_columns, unique_notnull_columns;
+      read_key_columns(conn, primary_columns, unique_notnull_columns);
+      if (!primary_columns.empty())
+        _table_key_columns.insert(primary_columns.begin(), primary_columns.end());
+      else
+        _table_key_columns.insert(unique_notnull_columns.begin(), unique_notnull_columns.end());
+    } catch (sql::SQLException &) {
+      // values are read whole then
+      _table_columns.clear();
+      _table_key_columns.clear();
+    }
+  }
+  if (_table_key_columns.empty())
+    return false;
+
+  for (auto &column : _table_columns)
+    if (is_large_column_type(column.second) && _table_key_columns.find(column.first) == _table_key_columns.end())
+      return true;
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/*
+ * Selects the columns of the table one by one, with "size:preview" strings for the large ones.
+ */
+std::string Recordset_cdbc_storage::lazy_columns_query() {
+  static const int PREVIEW_LENGTH = 256;
+
+  std::string select_list;
+  _lazy_columns.clear();
+  for (auto &column : _table_columns) {
+    if (!select_list.empty())
+      select_list += ", ";
+    if (!is_large_column_type(column.second) || _table_key_columns.find(column.first) != _table_key_columns.end())
+      select_list += std::string(base::sqlstring("!", 0) << column.first);
+    else {
+      // blobs get no preview, there's no telling how to show one
+      std::string type_name = base::tolower(column.second);
+      if (type_name.find("blob") != std::string::npos)
+        select_list += std::string(base::sqlstring("CONCAT(LENGTH(!), ':') AS !", 0) << column.first << column.first);
+      else
+        select_list += std::string(base::sqlstring("CONCAT(LENGTH(!), ':', LEFT(!, ?)) AS !", 0)
+                                   << column.first << column.first << PREVIEW_LENGTH << column.first);
+      _lazy_columns.insert(column.first);
+    }
+  }
+  return "SELECT " + select_list + " FROM " + full_table_name();
+}
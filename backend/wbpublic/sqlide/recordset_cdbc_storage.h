@@ -26,6 +26,8 @@
 #include "wbpublic_public_interface.h"
 #include "sqlide/recordset_sql_storage.h"
 #include "cppdbc.h"
+#include <cstdint>
+#include <set>
 
 class WBPUBLICBACKEND_PUBLIC_FUNC Recordset_cdbc_storage : public Recordset_sql_storage {
 public:
@@ -54,9 +56,16 @@ protected:
   virtual void do_unserialize(Recordset *recordset, sqlite::connection *data_swap_db);
   virtual void do_fetch_blob_value(Recordset *recordset, sqlite::connection *data_swap_db, RowId rowid, ColumnId column,
                                    sqlite::variant_t &blob_value);
+  virtual bool has_pending_rows() const {
+    return (bool)_pending_fetch;
+  }
+  virtual size_t fetch_pending_rows(Recordset *recordset, sqlite::connection *data_swap_db, size_t max_rows);
+  virtual bool has_next_page() const;
+  virtual bool start_next_page();
 
 protected:
   virtual void run_sql_script(const Sql_script &sql_script, bool skip_transaction);
+  virtual size_t max_batch_statement_size();
 
 public:
   std::string decorated_sql_query(); // adds limit clause if defined by options
@@ -84,6 +93,56 @@ public:
     _reloadable = val;
   }
 
+  // number of rows read by unserialize, the rest of a result set handed over with dbc_resultset() is read by
+  // Recordset::fetch_pending_rows() afterwards. 0 reads everything right away.
+  void first_frame_row_count(size_t count) {
+    _first_frame_row_count = count;
+  }
+
+  // keeps the data of read-only results in memory instead of the data swap db
+  void use_columnar_data(bool flag) {
+    _use_columnar_data = flag;
+  }
+
+  // lets sort_and_filter_on_server() push sorting and filtering of single table results into the query
+  void server_side_sort_filter(bool flag) {
+    _server_side_sort_filter = flag;
+  }
+  virtual bool sort_and_filter_on_server(const Recordset *recordset);
+
+  // lets plain selects of a whole table (as issued by Select Rows) be ordered by their primary key, so the rows
+  // following a full page can be read with a WHERE (pk) > (last key) condition instead of a growing offset
+  void keyset_paging(bool flag) {
+    _keyset_paging = flag;
+  }
+
+  // lets plain selects of a whole table read only the size and the start of BLOB, TEXT and JSON values, the values
+  // themselves are read by fetch_blob_value() when needed
+  void lazy_large_columns(bool flag) {
+    _lazy_large_columns = flag;
+  }
+
+  // lets reloads of the query and the pages of keyset paged results run as server side prepared statements, so
+  // numbers and temporal values arrive in binary instead of having to be parsed from their text form
+  void prepared_reloads(bool flag) {
+    _prepared_reloads = flag;
+  }
+
+  // Time spent in unserialize() and fetch_pending_rows() of the current result in nanoseconds, kept apart for
+  // reading rows from the result set, converting their values and storing them in the data swap db or columns.
+  struct FetchTimings {
+    std::uint64_t read;
+    std::uint64_t convert;
+    std::uint64_t store;
+    size_t rows;
+
+    FetchTimings() : read(0), convert(0), store(0), rows(0) {
+    }
+  };
+  const FetchTimings &fetch_timings() const {
+    return _fetch_timings;
+  }
+
   void set_gather_field_info(bool flag) {
     _gather_field_info = flag;
   }
@@ -101,8 +160,47 @@ private:
   bool _reloadable; // whether can be reloaded using stored sql query
   bool _gather_field_info;
 
+  struct PendingFetch;
+  std::shared_ptr<PendingFetch> _pending_fetch; // rest of the result set if it's being streamed
+  size_t _first_frame_row_count;
+  FetchTimings _fetch_timings;
+  bool _use_columnar_data;
+  bool _server_side_sort_filter;
+  std::string _server_where_clause;    // applied to the query by decorated_sql_query()
+  std::string _server_order_by_clause; // ditto
+
+  bool _keyset_paging;
+  bool _keyset_columns_read;
+  std::vector<std::string> _keyset_columns;    // PRIMARY key of the table, read once
+  std::shared_ptr<PendingFetch> _keyset_fetch; // how pages are read, set if the current result is keyset paged
+  Var_vector _keyset_last_key;                 // key of the last row read
+  size_t _keyset_page_rows;                    // rows read of the last page
+  size_t _max_allowed_packet;                  // of the server, read when changes are first applied
+
+  bool _lazy_large_columns;
+  bool _prepared_reloads;
+  bool _table_columns_read;
+  std::vector<std::pair<std::string, std::string> > _table_columns; // names and types of the table, read once
+  std::set<std::string> _table_key_columns;                         // columns identifying rows, never lazy
+  std::set<std::string> _lazy_columns; // read as size and preview by the last query from decorated_sql_query()
+
+  bool lazy_columns_apply();
+  std::string lazy_columns_query();
+  std::string decorated_sql_query(bool lazy_columns);
+
+  void run_query(sql::Dbc_connection_handler::Ref &conn, const std::string &sql_query,
+                 std::shared_ptr<sql::Statement> &stmt, std::shared_ptr<sql::ResultSet> &rs);
+
+  bool keyset_paging_applies();
+  std::string keyset_page_query();
+
+  bool fetch_rows(PendingFetch &fetch, Recordset *recordset, sqlite::connection *data_swap_db,
+                  sql::Dbc_connection_handler::Ref &conn, size_t max_rows, size_t &fetched_rows);
+
   size_t determine_pkey_columns(Recordset::Column_names &column_names, Recordset::Column_types &column_types,
                                 Recordset::Column_types &real_column_types);
+  void read_key_columns(sql::Dbc_connection_handler::Ref &conn, std::list<std::string> &primary_columns,
+                        std::list<std::string> &unique_notnull_columns);
   size_t determine_pkey_columns_alt(Recordset::Column_names &column_names, Recordset::Column_types &column_types,
                                     Recordset::Column_types &real_column_types);
 };
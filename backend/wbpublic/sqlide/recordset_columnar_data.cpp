@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2007, 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "recordset_columnar_data.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctype.h>
+
+namespace {
+
+  class ColumnKindOfType : public boost::static_visitor<int> {
+  public:
+    ColumnKindOfType(int integer, int int64, int floating, int string, int blob, int null)
+      : _integer(integer), _int64(int64), _float(floating), _string(string), _blob(blob), _null(null) {
+    }
+    result_type operator()(const int &) const {
+      return _integer;
+    }
+    result_type operator()(const std::int64_t &) const {
+      return _int64;
+    }
+    result_type operator()(const long double &) const {
+      return _float;
+    }
+    result_type operator()(const sqlite::blob_ref_t &) const {
+      return _blob;
+    }
+    result_type operator()(const sqlite::null_t &) const {
+      return _null;
+    }
+    template <typename T>
+    result_type operator()(const T &) const {
+      return _string; // strings and values of unknown type, which are fetched as strings
+    }
+
+  private:
+    int _integer, _int64, _float, _string, _blob, _null;
+  };
+
+  inline bool bit(const std::vector<std::uint64_t> &bits, size_t index) {
+    return (bits[index / 64] & (1ULL << (index % 64))) != 0;
+  }
+
+  inline void set_bit(std::vector<std::uint64_t> &bits, size_t index) {
+    bits[index / 64] |= 1ULL << (index % 64);
+  }
+
+  // compares the way SQLite's NOCASE collation does, folding ASCII letters only
+  int compare_nocase(const char *s1, size_t l1, const char *s2, size_t l2) {
+    for (size_t i = 0, l = std::min(l1, l2); i < l; ++i) {
+      int c1 = (unsigned char)s1[i], c2 = (unsigned char)s2[i];
+      if (c1 < 128)
+        c1 = tolower(c1);
+      if (c2 < 128)
+        c2 = tolower(c2);
+      if (c1 != c2)
+        return c1 - c2;
+    }
+    return (l1 < l2) ? -1 : (l1 > l2 ? 1 : 0);
+  }
+
+  template <typename T>
+  int compare_values(const T &v1, const T &v2) {
+    return (v1 < v2) ? -1 : ((v2 < v1) ? 1 : 0);
+  }
+
+  // ASCII only lower casing, as LIKE and NOCASE do
+  inline char fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+  }
+
+  std::string fold(const std::string &s) {
+    std::string folded(s);
+    for (char &c : folded)
+      c = fold(c);
+    return folded;
+  }
+
+  // compares against text that is already folded
+  inline bool equals_folded(const char *value, const std::string &text) {
+    for (size_t i = 0; i < text.size(); ++i)
+      if (fold(value[i]) != text[i])
+        return false;
+    return true;
+  }
+
+  bool like(const char *value, size_t length, const std::string &pattern) {
+    // iterative matcher, remembering the last % to backtrack to
+    size_t v = 0, p = 0, star_p = std::string::npos, star_v = 0;
+    while (v < length) {
+      if (p < pattern.size() && pattern[p] == '%') {
+        star_p = p++;
+        star_v = v;
+      } else if (p < pattern.size() && (pattern[p] == '_' || fold(pattern[p]) == fold(value[v]))) {
+        ++p;
+        ++v;
+      } else if (star_p != std::string::npos) {
+        p = star_p + 1;
+        v = ++star_v;
+      } else
+        return false;
+    }
+    while (p < pattern.size() && pattern[p] == '%')
+      ++p;
+    return p == pattern.size();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Recordset_columnar_data::Recordset_columnar_data(const Column_types &column_types) : _row_count(0) {
+  ColumnKindOfType kind_of_type(IntegerKind, Int64Kind, FloatKind, StringKind, BlobKind, NullKind);
+
+  _columns.resize(column_types.size());
+  for (size_t i = 0; i < column_types.size(); ++i) {
+    _columns[i].kind = (Kind)boost::apply_visitor(kind_of_type, column_types[i]);
+    _columns[i].offsets.push_back(0);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Recordset_columnar_data::add_row(const std::vector<sqlite::variant_t> &values) {
+  ColumnKindOfType kind_of_value(IntegerKind, Int64Kind, FloatKind, StringKind, BlobKind, NullKind);
+
+  RowId row = _row_count++;
+  for (ColumnId c = 0; c < _columns.size(); ++c) {
+    Column &column(_columns[c]);
+    if (row % 64 == 0)
+      column.nulls.push_back(0);
+
+    const sqlite::variant_t &value(values[c]);
+    Kind kind = (Kind)boost::apply_visitor(kind_of_value, value);
+    // unknown_t reports as a string but has no value to keep
+    if (kind == StringKind && !boost::get<std::string>(&value))
+      kind = NullKind;
+    bool fits = (kind == column.kind) || (kind == IntegerKind && column.kind == Int64Kind);
+
+    switch (column.kind) {
+      case IntegerKind:
+      case Int64Kind:
+        column.integers.push_back(!fits ? 0 : (kind == IntegerKind ? boost::get<int>(value)
+                                                                   : boost::get<std::int64_t>(value)));
+        break;
+      case FloatKind:
+        column.floats.push_back(fits ? boost::get<long double>(value) : 0);
+        break;
+      case StringKind:
+        if (fits) {
+          const std::string &s(boost::get<std::string>(value));
+          column.arena.insert(column.arena.end(), s.begin(), s.end());
+        }
+        column.offsets.push_back(column.arena.size());
+        break;
+      case BlobKind:
+        column.blobs.push_back(fits ? boost::get<sqlite::blob_ref_t>(value) : sqlite::blob_ref_t());
+        break;
+      case NullKind:
+        break;
+    }
+
+    if (!fits) {
+      set_bit(column.nulls, row);
+      if (kind != NullKind)
+        column.others.push_back(std::make_pair(row, value));
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const sqlite::variant_t *Recordset_columnar_data::other_value(const Column &column, RowId row) const {
+  if (column.others.empty())
+    return NULL;
+  std::vector<std::pair<RowId, sqlite::variant_t> >::const_iterator other =
+    std::lower_bound(column.others.begin(), column.others.end(), std::make_pair(row, sqlite::variant_t()),
+                     [](const std::pair<RowId, sqlite::variant_t> &a, const std::pair<RowId, sqlite::variant_t> &b) {
+                       return a.first < b.first;
+                     });
+  return (other != column.others.end() && other->first == row) ? &other->second : NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_columnar_data::is_null(RowId row, ColumnId column) const {
+  const Column &col(_columns[column]);
+  return bit(col.nulls, row) && !other_value(col, row);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+sqlite::variant_t Recordset_columnar_data::get(RowId row, ColumnId column) const {
+  const Column &col(_columns[column]);
+  if (bit(col.nulls, row)) {
+    const sqlite::variant_t *other = other_value(col, row);
+    return other ? *other : sqlite::variant_t(sqlite::null_t());
+  }
+
+  switch (col.kind) {
+    case IntegerKind:
+      return (int)col.integers[row];
+    case Int64Kind:
+      return col.integers[row];
+    case FloatKind:
+      return col.floats[row];
+    case StringKind:
+      return std::string(col.arena.data() + col.offsets[row], col.offsets[row + 1] - col.offsets[row]);
+    case BlobKind:
+      return col.blobs[row];
+    case NullKind:
+      break;
+  }
+  return sqlite::null_t();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string Recordset_columnar_data::get_string(RowId row, ColumnId column) const {
+  const Column &col(_columns[column]);
+  if (!bit(col.nulls, row)) {
+    if (col.kind == StringKind)
+      return std::string(col.arena.data() + col.offsets[row], col.offsets[row + 1] - col.offsets[row]);
+    if (col.kind == BlobKind)
+      return std::string(col.blobs[row]->begin(), col.blobs[row]->end());
+  }
+
+  sqlite::variant_t value = get(row, column);
+  if (sqlite::blob_ref_t *blob = boost::get<sqlite::blob_ref_t>(&value))
+    return std::string((*blob)->begin(), (*blob)->end());
+  sqlide::VarToStr var_to_str;
+  return boost::apply_visitor(var_to_str, value);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+long double Recordset_columnar_data::numeric_value(RowId row, ColumnId column) const {
+  const Column &col(_columns[column]);
+  if (!bit(col.nulls, row)) {
+    if (col.kind == IntegerKind || col.kind == Int64Kind)
+      return (long double)col.integers[row];
+    if (col.kind == FloatKind)
+      return col.floats[row];
+  }
+  // leading number of the text, 0 if there's none
+  std::string text = get_string(row, column);
+  return strtold(text.c_str(), NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Recordset_columnar_data::compare(RowId row1, RowId row2, ColumnId column, bool numeric_cast,
+                                     bool nocase) const {
+  bool null1 = is_null(row1, column), null2 = is_null(row2, column);
+  if (null1 || null2)
+    return (null1 && null2) ? 0 : (null1 ? -1 : 1);
+
+  const Column &col(_columns[column]);
+  bool plain1 = !bit(col.nulls, row1), plain2 = !bit(col.nulls, row2);
+  if (numeric_cast || ((col.kind == IntegerKind || col.kind == Int64Kind || col.kind == FloatKind) && plain1 && plain2)) {
+    if ((col.kind == IntegerKind || col.kind == Int64Kind) && plain1 && plain2)
+      return compare_values(col.integers[row1], col.integers[row2]);
+    return compare_values(numeric_value(row1, column), numeric_value(row2, column));
+  }
+
+  if (col.kind == StringKind && plain1 && plain2) {
+    const char *s1 = col.arena.data() + col.offsets[row1], *s2 = col.arena.data() + col.offsets[row2];
+    size_t l1 = col.offsets[row1 + 1] - col.offsets[row1], l2 = col.offsets[row2 + 1] - col.offsets[row2];
+    if (nocase)
+      return compare_nocase(s1, l1, s2, l2);
+    int res = memcmp(s1, s2, std::min(l1, l2));
+    return res ? res : compare_values(l1, l2);
+  }
+
+  std::string s1 = get_string(row1, column), s2 = get_string(row2, column);
+  return nocase ? compare_nocase(s1.data(), s1.size(), s2.data(), s2.size()) : s1.compare(s2);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_columnar_data::like(const std::string &value, const std::string &pattern) {
+  return ::like(value.data(), value.size(), pattern);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t Recordset_columnar_data::memory_size() const {
+  size_t size = 0;
+  for (const Column &column : _columns) {
+    size += column.integers.capacity() * sizeof(std::int64_t) + column.floats.capacity() * sizeof(long double) +
+            column.arena.capacity() + column.offsets.capacity() * sizeof(size_t) +
+            column.nulls.capacity() * sizeof(std::uint64_t);
+    for (const sqlite::blob_ref_t &blob : column.blobs)
+      size += sizeof(blob) + (blob ? blob->size() : 0);
+  }
+  return size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Recordset_columnar_data::Matcher::Matcher(const std::string &pattern) : _form(General), _pattern(pattern) {
+  if (pattern.empty()) {
+    _form = Equal;
+    return;
+  }
+
+  size_t first = pattern.find_first_not_of('%');
+  if (first == std::string::npos) {
+    _form = Any;
+    return;
+  }
+
+  size_t last = pattern.find_last_not_of('%');
+  std::string text = pattern.substr(first, last - first + 1);
+  if (text.find_first_of("%_") != std::string::npos)
+    return;
+
+  bool leading = first > 0, trailing = last + 1 < pattern.size();
+  _form = leading ? (trailing ? Substring : Suffix) : (trailing ? Prefix : Equal);
+  _text = fold(text);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_columnar_data::Matcher::matches(const char *value, size_t length) const {
+  switch (_form) {
+    case Equal:
+      return length == _text.size() && equals_folded(value, _text);
+    case Prefix:
+      return length >= _text.size() && equals_folded(value, _text);
+    case Suffix:
+      return length >= _text.size() && equals_folded(value + length - _text.size(), _text);
+    case Substring:
+      return std::search(value, value + length, _text.begin(), _text.end(),
+                         [](char c, char t) { return fold(c) == t; }) != value + length;
+    case Any:
+      return true;
+    case General:
+      break;
+  }
+  return ::like(value, length, _pattern);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_columnar_data::Matcher::narrows(const Matcher &other) const {
+  if (_pattern == other._pattern || other._form == Any)
+    return true;
+  if (_form == General || _form == Any || other._form == General)
+    return false;
+
+  switch (other._form) {
+    case Equal:
+      return _form == Equal && _text == other._text;
+    case Prefix:
+      return (_form == Equal || _form == Prefix) && _text.compare(0, other._text.size(), other._text) == 0;
+    case Suffix:
+      return (_form == Equal || _form == Suffix) && _text.size() >= other._text.size() &&
+             _text.compare(_text.size() - other._text.size(), other._text.size(), other._text) == 0;
+    case Substring:
+      return _text.find(other._text) != std::string::npos;
+    default:
+      return false;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_columnar_data::matches(RowId row, ColumnId column, const Matcher &matcher) const {
+  const Column &col(_columns[column]);
+  if (!bit(col.nulls, row)) {
+    switch (col.kind) {
+      case StringKind:
+        return matcher.matches(col.arena.data() + col.offsets[row], col.offsets[row + 1] - col.offsets[row]);
+      case BlobKind:
+        if (col.blobs[row] && !col.blobs[row]->empty())
+          return matcher.matches((const char *)&(*col.blobs[row])[0], col.blobs[row]->size());
+        return matcher.matches("", 0);
+      case IntegerKind:
+      case Int64Kind: {
+        char text[32];
+        int length = snprintf(text, sizeof(text), "%lld", (long long)col.integers[row]);
+        return matcher.matches(text, (size_t)length);
+      }
+      default:
+        break;
+    }
+  } else if (!other_value(col, row))
+    return false; // NULL
+
+  std::string text = get_string(row, column);
+  return matcher.matches(text.data(), text.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Recordset_columnar_data::filter(ColumnId column, const Matcher &matcher, std::vector<RowId> &rows) const {
+  if (column >= _columns.size()) {
+    rows.clear();
+    return;
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < rows.size(); ++i)
+    if (matches(rows[i], column, matcher))
+      rows[kept++] = rows[i];
+  rows.resize(kept);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Recordset_columnar_data::search(ColumnId column_count, const Matcher &matcher, std::vector<RowId> &rows) const {
+  // one column at a time, trying only the rows without a match so far
+  std::vector<char> found(rows.size(), 0);
+  size_t remaining = rows.size();
+  for (ColumnId column = 0; column < std::min<size_t>(column_count, _columns.size()) && remaining > 0; ++column) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (!found[i] && matches(rows[i], column, matcher)) {
+        found[i] = 1;
+        --remaining;
+      }
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < rows.size(); ++i)
+    if (found[i])
+      rows[kept++] = rows[i];
+  rows.resize(kept);
+}
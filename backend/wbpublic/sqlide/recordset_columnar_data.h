@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2007, 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "wbpublic_public_interface.h"
+#include "sqlide/sqlide_generics.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/*
+ * In-memory store for the data of read-only result sets, used instead of the data swap db tables.
+ *
+ * Values are kept per column: integers and floats in plain vectors, strings in a per column character arena
+ * addressed by offsets and blobs as shared references. NULLs are tracked in a bitmap, so a cell costs its value
+ * plus one bit. Rows are only ever appended; row ids are the positions rows were added at.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC Recordset_columnar_data {
+public:
+  typedef std::shared_ptr<Recordset_columnar_data> Ref;
+  typedef std::vector<sqlite::variant_t> Column_types;
+
+  static Ref create(const Column_types &column_types) {
+    return Ref(new Recordset_columnar_data(column_types));
+  }
+
+private:
+  Recordset_columnar_data(const Column_types &column_types);
+
+public:
+  void add_row(const std::vector<sqlite::variant_t> &values);
+
+  size_t row_count() const {
+    return _row_count;
+  }
+  size_t column_count() const {
+    return _columns.size();
+  }
+
+  bool is_null(RowId row, ColumnId column) const;
+  sqlite::variant_t get(RowId row, ColumnId column) const;
+  std::string get_string(RowId row, ColumnId column) const; // as SQLite would convert it for LIKE
+
+  // ordering as used by sort_by(): numeric_cast compares the leading number of the value (like CAST AS NUMERIC),
+  // nocase compares strings ignoring ASCII case. Returns <0, 0 or >0, NULLs come first.
+  int compare(RowId row1, RowId row2, ColumnId column, bool numeric_cast, bool nocase) const;
+
+  // SQLite LIKE: % and _ wildcards, ASCII case insensitive
+  static bool like(const std::string &value, const std::string &pattern);
+
+  /*
+   * A LIKE pattern prepared for matching many values. Patterns without _ and with % only at their ends are matched
+   * as equality, prefix, suffix or substring comparisons, the others with like().
+   */
+  class WBPUBLICBACKEND_PUBLIC_FUNC Matcher {
+  public:
+    Matcher(const std::string &pattern);
+
+    bool matches(const char *value, size_t length) const;
+    // whether every value this matches is also matched by other, i.e. this only narrows what other selects
+    bool narrows(const Matcher &other) const;
+
+  private:
+    enum Form { Equal, Prefix, Suffix, Substring, Any, General };
+
+    Form _form;
+    std::string _pattern;
+    std::string _text; // the pattern without its % and in lower case, for all but General
+  };
+
+  // Removes from rows those whose value in the column is NULL or doesn't match. Columns are walked in their native
+  // representation, so only values not stored as text are converted.
+  void filter(ColumnId column, const Matcher &matcher, std::vector<RowId> &rows) const;
+  // Removes from rows those without a match in any of the first column_count columns.
+  void search(ColumnId column_count, const Matcher &matcher, std::vector<RowId> &rows) const;
+
+  size_t memory_size() const;
+
+private:
+  enum Kind { IntegerKind, Int64Kind, FloatKind, StringKind, BlobKind, NullKind };
+
+  struct Column {
+    Kind kind;
+    std::vector<std::int64_t> integers; // IntegerKind, Int64Kind
+    std::vector<long double> floats;
+    std::vector<char> arena;     // StringKind, the values back to back
+    std::vector<size_t> offsets; // StringKind, start of every value plus the end of the last one
+    std::vector<sqlite::blob_ref_t> blobs;
+    std::vector<std::uint64_t> nulls;
+    std::vector<std::pair<RowId, sqlite::variant_t> > others; // values not of the column type, by row
+  };
+
+  std::vector<Column> _columns;
+  size_t _row_count;
+
+  const sqlite::variant_t *other_value(const Column &column, RowId row) const;
+  long double numeric_value(RowId row, ColumnId column) const;
+  bool matches(RowId row, ColumnId column, const Matcher &matcher) const;
+};
@@ -26,6 +26,7 @@
 #include "recordset_data_storage.h"
 #include "base/string_utilities.h"
 #include "base/boost_smart_ptr_helpers.h"
+#include "base/trace.h"
 
 using namespace bec;
 using namespace grt;
@@ -56,13 +57,19 @@ void Recordset_data_storage::apply_changes(Recordset::Ptr recordset_ptr, bool sk
 void Recordset_data_storage::serialize(Recordset::Ptr recordset_ptr) {
   RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, recordset_ptr, recordset)
   std::shared_ptr<sqlite::connection> data_swap_db = recordset->data_swap_db();
+  // serializers read the data swap db tables
+  flush_columnar_data(recordset, data_swap_db.get());
   do_serialize(recordset, data_swap_db.get());
 }
 
 void Recordset_data_storage::unserialize(Recordset::Ptr recordset_ptr) {
   RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, recordset_ptr, recordset)
   std::shared_ptr<sqlite::connection> data_swap_db = recordset->data_swap_db();
-  do_unserialize(recordset, data_swap_db.get());
+  {
+    TRACE_SPAN("sqlide", "Recordset_data_storage::do_unserialize");
+    do_unserialize(recordset, data_swap_db.get());
+  }
+  TRACE_SPAN("sqlide", "Recordset::rebuild_data_index");
   recordset->rebuild_data_index(data_swap_db.get(), false, false);
 }
 
@@ -77,6 +84,14 @@ void Recordset_data_storage::fetch_blob_value(Recordset *recordset, sqlite::conn
                                               ColumnId column, sqlite::variant_t &blob_value) {
   blob_value = sqlite::null_t();
 
+  // in memory data has the blob values already
+  const Recordset_columnar_data::Ref &columnar_data = get_columnar_data(recordset);
+  if (columnar_data) {
+    if (rowid > 0 && rowid <= columnar_data->row_count() && column < columnar_data->column_count())
+      blob_value = columnar_data->get(rowid - 1, column);
+    return;
+  }
+
   do_fetch_blob_value(recordset, data_swap_db, rowid, column, blob_value);
 
   // cache fetched blob in data swap db, blob shouldn't stay in memory for long
@@ -87,6 +102,33 @@ void Recordset_data_storage::fetch_blob_value(Recordset *recordset, sqlite::conn
   }
 }
 
+/*
+ * Copies the rows of a recordset kept in memory into its data swap db tables, once. The `id` of each row comes
+ * out as its position + 1, as used by the in memory index.
+ */
+void Recordset_data_storage::flush_columnar_data(Recordset *recordset, sqlite::connection *data_swap_db) {
+  const Recordset_columnar_data::Ref &columnar_data = get_columnar_data(recordset);
+  if (!columnar_data || recordset->_columnar_data_flushed)
+    return;
+
+  base::RecMutexLock data_mutex WB_UNUSED(recordset->_data_mutex);
+  sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db);
+
+  Recordset::Column_names column_names(get_column_names(recordset).begin(),
+                                       get_column_names(recordset).begin() + columnar_data->column_count());
+  std::list<std::shared_ptr<sqlite::command> > insert_commands =
+    prepare_data_swap_record_add_statement(data_swap_db, column_names);
+  Var_vector row_values(columnar_data->column_count());
+  for (RowId row = 0; row < columnar_data->row_count(); ++row) {
+    for (ColumnId column = 0; column < columnar_data->column_count(); ++column)
+      row_values[column] = columnar_data->get(row, column);
+    add_data_swap_record(insert_commands, row_values);
+  }
+
+  transaction_guarder.commit();
+  recordset->_columnar_data_flushed = true;
+}
+
 void Recordset_data_storage::create_data_swap_tables(sqlite::connection *data_swap_db,
                                                      Recordset::Column_names &column_names,
                                                      Recordset::Column_types &column_types) {
@@ -186,7 +228,7 @@ void Recordset_data_storage::add_data_swap_record(std::list<std::shared_ptr<sqli
            col = partition * Recordset::DATA_SWAP_DB_TABLE_MAX_COL_COUNT,
            col_end = std::min<ColumnId>(values.size(), (partition + 1) * Recordset::DATA_SWAP_DB_TABLE_MAX_COL_COUNT);
          col < col_end; ++col) {
-      const sqlite::variant_t &value = values[col];
+      sqlite::variant_t value = sqlide::pack_data_swap_value(values[col]);
       boost::apply_visitor(bind_sql_command_var, value);
     }
     insert_command->emit();
@@ -202,6 +244,7 @@ void Recordset_data_storage::update_data_swap_record(sqlite::connection *data_sw
     new sqlite::command(*data_swap_db, strfmt("update `data%s` set `_%u`=? where rowid=%u", partition_suffix.c_str(),
                                               (unsigned int)column, (unsigned int)rowid)));
   sqlide::BindSqlCommandVar bind_sql_command_var(update_command.get());
-  boost::apply_visitor(bind_sql_command_var, value);
+  sqlite::variant_t packed_value = sqlide::pack_data_swap_value(value);
+  boost::apply_visitor(bind_sql_command_var, packed_value);
   update_command->emit();
 }
@@ -25,6 +25,7 @@
 
 #include "wbpublic_public_interface.h"
 #include "sqlide/recordset_be.h"
+#include "sqlide/recordset_columnar_data.h"
 
 namespace sqlite {
   struct command;
@@ -65,6 +66,22 @@ protected:
   virtual void do_fetch_blob_value(Recordset *recordset, sqlite::connection *data_swap_db, RowId rowid, ColumnId column,
                                    sqlite::variant_t &blob_value) = 0;
 
+  // storages that can hand over a result before all of it was read keep the rest for fetch_pending_rows
+  virtual bool has_pending_rows() const {
+    return false;
+  }
+  virtual size_t fetch_pending_rows(Recordset *recordset, sqlite::connection *data_swap_db, size_t max_rows) {
+    return 0;
+  }
+
+  // storages paging through their rows by key can have the page after the last one read fetched as pending rows
+  virtual bool has_next_page() const {
+    return false;
+  }
+  virtual bool start_next_page() {
+    return false;
+  }
+
 public:
   bool valid() {
     return _valid;
@@ -90,6 +107,12 @@ public:
     return true;
   }
 
+  // storages that re-execute a query can have the server apply the sort columns, column filters and search string
+  // of the recordset on the next reload. Returns false if the recordset has to sort and filter the data itself.
+  virtual bool sort_and_filter_on_server(const Recordset *recordset) {
+    return false;
+  }
+
 public:
   static void create_data_swap_tables(sqlite::connection *data_swap_db, Recordset::Column_names &column_names,
                                       Recordset::Column_types &column_types);
@@ -129,8 +152,16 @@ protected:
   static const Recordset::Column_flags &get_column_flags(const Recordset *recordset) {
     return recordset->_column_flags;
   }
+  static void set_columnar_data(Recordset *recordset, const Recordset_columnar_data::Ref &data) {
+    recordset->_columnar_data = data;
+  }
+  static const Recordset_columnar_data::Ref &get_columnar_data(const Recordset *recordset) {
+    return recordset->_columnar_data;
+  }
 
 public:
+  static void flush_columnar_data(Recordset *recordset, sqlite::connection *data_swap_db);
+
   bool limit_rows() {
     return _limit_rows;
   }
@@ -58,6 +58,7 @@ std::string PrimaryKeyPredicate::operator()(std::vector<std::shared_ptr<sqlite::
     std::shared_ptr<sqlite::result> &data_row_rs = data_row_results[partition];
 
     v = data_row_rs->get_variant((int)partition_column);
+    sqlide::unpack_data_swap_value(v);
     predicate += "(`" + (*_column_names)[col] + "`";
     std::string value = boost::apply_visitor(*_qv, (*_column_types)[col], v);
     predicate += (value == "NULL" ? " IS NULL" : " = " + value) + ")";
@@ -66,6 +67,114 @@ std::string PrimaryKeyPredicate::operator()(std::vector<std::shared_ptr<sqlite::
   return predicate;
 }
 
+std::string PrimaryKeyPredicate::columns() const {
+  std::string columns;
+  for (auto col : *_pkey_columns) {
+    if (!columns.empty())
+      columns += ", ";
+    columns += "`" + (*_column_names)[col] + "`";
+  }
+  return _pkey_columns->size() == 1 ? columns : "(" + columns + ")";
+}
+
+/*
+ * Returns false if a key value is NULL, such rows can only be matched with the predicate.
+ */
+bool PrimaryKeyPredicate::values(std::vector<std::shared_ptr<sqlite::result> > &data_row_results,
+                                 std::string &values) {
+  values.clear();
+  sqlite::variant_t v;
+
+  for (auto col : *_pkey_columns) {
+    if (!values.empty())
+      values += ", ";
+
+    size_t partition;
+    ColumnId partition_column = Recordset::translate_data_swap_db_column(col, &partition);
+    std::shared_ptr<sqlite::result> &data_row_rs = data_row_results[partition];
+
+    v = data_row_rs->get_variant((int)partition_column);
+    sqlide::unpack_data_swap_value(v);
+    std::string value = boost::apply_visitor(*_qv, (*_column_types)[col], v);
+    if (value == "NULL")
+      return false;
+    values += value;
+  }
+  if (_pkey_columns->size() != 1)
+    values = "(" + values + ")";
+
+  return !_pkey_columns->empty();
+}
+
+//------------------------------------------------------------------------------
+
+/*
+ * Collects consecutive row statements sharing the same head into one multi-row statement, e.g. an INSERT with a list
+ * of VALUES or a DELETE with an IN list, as long as it stays below the given size. Statements are never reordered,
+ * so the script keeps the effect of running the row statements one by one.
+ */
+class StatementBatch {
+public:
+  static const size_t MAX_ROWS = 1000;
+
+  StatementBatch(Sql_script &sql_script, size_t max_size)
+    : _sql_script(sql_script), _max_size(max_size), _size(0), _rows(0) {
+  }
+  ~StatementBatch() {
+    flush();
+  }
+
+  // single_sql is used as is when the row ends up alone in its batch
+  void add(const std::string &head, const std::string &item, const std::string &tail, const std::string &single_sql) {
+    if (_max_size == 0) {
+      push(single_sql);
+      return;
+    }
+    if (_rows > 0 && (head != _head || tail != _tail || _rows >= MAX_ROWS || _size + item.size() + 2 > _max_size))
+      flush();
+    if (_rows == 0) {
+      _head = head;
+      _tail = tail;
+      _items.clear();
+      _size = head.size() + tail.size();
+      _single_sql = single_sql;
+    } else
+      _items += ",\n";
+    _items += item;
+    _size += item.size() + 2;
+    ++_rows;
+  }
+
+  void add(const std::string &sql, const Sql_script::Statement_bindings &sql_bindings) {
+    flush();
+    _sql_script.statements.push_back(sql);
+    _sql_script.statements_bindings.push_back(sql_bindings);
+  }
+
+  void flush() {
+    if (_rows == 0)
+      return;
+    push(_rows == 1 ? _single_sql : _head + _items + _tail);
+    _rows = 0;
+    _items.clear();
+  }
+
+private:
+  Sql_script &_sql_script;
+  size_t _max_size;
+  std::string _head;
+  std::string _tail;
+  std::string _items;
+  std::string _single_sql;
+  size_t _size;
+  size_t _rows;
+
+  void push(const std::string &sql) {
+    _sql_script.statements.push_back(sql);
+    _sql_script.statements_bindings.push_back(Sql_script::Statement_bindings());
+  }
+};
+
 //------------------------------------------------------------------------------
 
 class JsonTypeFinder : public boost::static_visitor<bool> {
@@ -137,44 +246,36 @@ void Recordset_sql_storage::do_unserialize(Recordset *recordset, sqlite::connect
 
   if (!sql_script().empty()) // load data from sql script
   {
-    Var_list var_list;
+    // Rows go to the data swap db as the loader recognizes them, so the loaded values are never all held in memory.
+    // The swap tables are created with the first row, as that is where the set of columns is known.
+    sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db);
+    Var_vector row_values;
+    std::list<std::shared_ptr<sqlite::command> > insert_commands;
+
     SqlFacade::Ref sql_facade = SqlFacade::instance_for_rdbms_name("Mysql"); //!
     Sql_inserts_loader::Ref loader = sql_facade->sqlInsertsLoader();
-    loader->process_insert_cb(std::bind(&Recordset_sql_storage::load_insert_statement, this, std::placeholders::_1,
-                                        std::placeholders::_2, std::placeholders::_3, std::placeholders::_4,
-                                        std::placeholders::_5, &column_names, &var_list));
-    loader->load(sql_script(), schema_name());
-
-    // column types
-    column_types.reserve(column_names.size());
-    std::fill_n(std::back_inserter(column_types), column_names.size(), std::string());
-
-    // real column types
-    real_column_types.reserve(column_names.size());
-    std::fill_n(std::back_inserter(real_column_types), column_names.size(), std::string());
-
-    column_flags.reserve(column_names.size());
-    std::fill_n(std::back_inserter(column_flags), column_names.size(), Recordset::NeedsQuoteFlag);
-
-    if (!column_names.empty()) {
-      // data
-      {
-        sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db);
+    loader->process_insert_cb([&](const std::string &sql, const std::pair<std::string, std::string> &schema_table,
+                                  const Sql_inserts_loader::Strings &fields_names,
+                                  const Sql_inserts_loader::Strings &fields_values,
+                                  const std::vector<bool> &null_fields) {
+      if (!load_insert_statement(sql, schema_table, fields_names, fields_values, null_fields, &column_names,
+                                 &row_values) ||
+          column_names.empty())
+        return;
+
+      if (insert_commands.empty()) {
+        column_types.assign(column_names.size(), std::string());
+        real_column_types.assign(column_names.size(), std::string());
+        column_flags.assign(column_names.size(), Recordset::NeedsQuoteFlag);
 
         create_data_swap_tables(data_swap_db, column_names, column_types);
-        Var_vector row_values(column_names.size());
-        std::list<std::shared_ptr<sqlite::command> > insert_commands =
-          prepare_data_swap_record_add_statement(data_swap_db, column_names);
-        Var_list::iterator var_list_iter = var_list.begin();
-        for (size_t n = 0, count = var_list.size() / column_names.size(); n < count; ++n) {
-          for (size_t l = 0, count = column_names.size(); l < count; ++l)
-            row_values[l] = *var_list_iter++;
-          add_data_swap_record(insert_commands, row_values);
-        }
-
-        transaction_guarder.commit();
+        insert_commands = prepare_data_swap_record_add_statement(data_swap_db, column_names);
       }
-    }
+      add_data_swap_record(insert_commands, row_values);
+    });
+    loader->load(sql_script(), schema_name());
+
+    transaction_guarder.commit();
 
     _readonly = column_names.empty();
     _valid = !column_names.empty();
@@ -186,20 +287,20 @@ void Recordset_sql_storage::do_unserialize(Recordset *recordset, sqlite::connect
   }
 }
 
-void Recordset_sql_storage::load_insert_statement(const std::string &sql,
+bool Recordset_sql_storage::load_insert_statement(const std::string &sql,
                                                   const std::pair<std::string, std::string> &schema_table,
                                                   const Sql_inserts_loader::Strings &fields_names,
                                                   const Sql_inserts_loader::Strings &fields_values,
                                                   const std::vector<bool> &null_fields,
-                                                  Recordset::Column_names *column_names, Var_list *var_list) {
+                                                  Recordset::Column_names *column_names, Var_vector *row_values) {
   if ((schema_table.first != _schema_name) || (schema_table.second != _table_name)) {
     grt::GRT::get()->send_error("Irrelevant insert statement (skipped): " + sql);
-    return;
+    return false;
   }
 
   if (fields_names.size() != fields_values.size()) {
     grt::GRT::get()->send_error("Invalid insert statement: " + sql);
-    return;
+    return false;
   }
 
   // 1st insert statement defines the set & order of fields in recordset
@@ -218,14 +319,16 @@ void Recordset_sql_storage::load_insert_statement(const std::string &sql,
       col_index_map[i->second] = (int)n;
   }
 
-  // insert row
+  // row values, in recordset column order
+  row_values->resize(_fields_order.size());
   for (ColumnId n = 0, count = _fields_order.size(); n < count; ++n) {
     std::map<int, int>::const_iterator i = col_index_map.find((int)n);
     if ((col_index_map.end() != i) && !null_fields[i->second])
-      var_list->push_back(fields_values[i->second]);
+      (*row_values)[n] = fields_values[i->second];
     else
-      var_list->push_back(sqlite::null_t());
+      (*row_values)[n] = sqlite::null_t();
   }
+  return true;
 }
 
 void Recordset_sql_storage::do_serialize(const Recordset *recordset, sqlite::connection *data_swap_db) {
@@ -261,10 +364,20 @@ void Recordset_sql_storage::fetch_blob_value(Recordset *recordset, sqlite::conne
     if (blob_query.emit()) {
       std::shared_ptr<sqlite::result> rs = BoostHelper::convertPointer(blob_query.get_result());
       blob_value = rs->get_variant(0);
+      sqlide::unpack_data_swap_value(blob_value);
     }
   }
 
-  if (!recordset->optimized_blob_fetching() || !sqlide::is_var_null(blob_value))
+  // the cache holds only a preview of lazy values, unless the value was set here
+  const Recordset::Column_flags &column_flags = get_column_flags(recordset);
+  if (column < column_flags.size() && (column_flags[column] & Recordset::LazyValueFlag)) {
+    sqlite::query changes_query(*data_swap_db,
+                                "select 1 from `changes` where `record` = ? and (`column` = ? or `action` = 1)");
+    changes_query % (int)rowid;
+    changes_query % (int)column;
+    if (changes_query.emit())
+      return;
+  } else if (!recordset->optimized_blob_fetching() || !sqlide::is_var_null(blob_value))
     return;
 
   Recordset_data_storage::fetch_blob_value(recordset, data_swap_db, rowid, column, blob_value);
@@ -399,11 +512,13 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
     changes_query % (int)min_new_rowid;
     changes_query % (int)min_new_rowid;
     if (changes_query.emit()) {
+      StatementBatch batch(sql_script, max_batch_statement_size());
       std::shared_ptr<sqlite::result> rs = BoostHelper::convertPointer(changes_query.get_result());
       do {
         RowId rowid = rs->get_int(1);
         std::string sql;
         Sql_script::Statement_bindings sql_bindings;
+        bool batched = false;
 
         switch (rs->get_int(2)) // action
         {
@@ -413,6 +528,12 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
             bind_vars.push_back((int)rowid);
             if (Recordset::emit_partition_queries(data_swap_db, deleted_row_queries, deleted_row_results, bind_vars)) {
               sql = strfmt("DELETE FROM %s WHERE %s", full_table_name.c_str(), pkey_pred(deleted_row_results).c_str());
+              std::string key_values;
+              if (pkey_pred.values(deleted_row_results, key_values)) {
+                batch.add(strfmt("DELETE FROM %s WHERE %s IN (", full_table_name.c_str(), pkey_pred.columns().c_str()),
+                          key_values, ")", sql);
+                batched = true;
+              }
             }
           } break;
 
@@ -447,6 +568,7 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
                 std::shared_ptr<sqlite::result> &data_row_rs = data_row_results[partition];
 
                 v = data_row_rs->get_variant((int)partition_column);
+                sqlide::unpack_data_swap_value(v);
                 if (!qv.store_unknown_as_string && boost::apply_visitor(jsonTypeFinder, column_types[column], v))
                   qv.store_unknown_as_string = true;
                 values += strfmt("%s, ", boost::apply_visitor(qv, column_types[column], v).c_str());
@@ -459,10 +581,14 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
                 col_names.resize(col_names.size() - 2);
               if (!values.empty())
                 values.resize(values.size() - 2);
-              sql = strfmt("INSERT INTO %s (%s) VALUES (%s)",
-                           _omit_schema_qualifier ? (std::string("`") + table_name() + std::string("`")).c_str()
-                                                  : full_table_name.c_str(),
-                           col_names.c_str(), values.c_str());
+              std::string table = _omit_schema_qualifier ? "`" + table_name() + "`" : full_table_name;
+              sql = strfmt("INSERT INTO %s (%s) VALUES (%s)", table.c_str(), col_names.c_str(), values.c_str());
+              // bound blobs are kept in separate statements
+              if (sql_bindings.empty()) {
+                batch.add(strfmt("INSERT INTO %s (%s) VALUES\n", table.c_str(), col_names.c_str()), "(" + values + ")",
+                          "", sql);
+                batched = true;
+              }
             }
           } break;
 
@@ -491,6 +617,7 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
                 std::shared_ptr<sqlite::result> &data_row_rs = data_row_results[partition];
 
                 v = data_row_rs->get_variant((int)partition_column);
+                sqlide::unpack_data_swap_value(v);
 
                 if (!qv.store_unknown_as_string && boost::apply_visitor(jsonTypeFinder, column_types[column], v))
                   qv.store_unknown_as_string = true;
@@ -509,9 +636,10 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
           } break;
         }
 
-        sql_script.statements.push_back(sql);
-        sql_script.statements_bindings.push_back(sql_bindings);
+        if (!batched)
+          batch.add(sql, sql_bindings);
       } while (rs->next_row());
+      batch.flush();
     }
   } else {
     std::string col_names;
@@ -536,6 +664,7 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
                col < col_end; ++col) {
             ColumnId partition_column = col - col_begin;
             v = data_rs->get_variant((int)partition_column);
+            sqlide::unpack_data_swap_value(v);
             values +=
               strfmt("%s, ", (column_flags[partition_column] & Recordset::NeedsQuoteFlag) || sqlide::is_var_null(v)
                                ? boost::apply_visitor(qv, column_types[partition_column], v).c_str()
@@ -607,6 +736,7 @@ void Recordset_sql_storage::generate_inserts(const Recordset *recordset, sqlite:
              col < col_end; ++col) {
           ColumnId partition_column = col - col_begin;
           v = data_rs->get_variant((int)partition_column);
+          sqlide::unpack_data_swap_value(v);
           sqlide::VarToStr var_to_str;
 
           std::string value;
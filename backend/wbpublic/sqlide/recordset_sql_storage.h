@@ -76,6 +76,12 @@ protected:
   }
   virtual void init_variant_quoter(sqlide::QuoteVar &qv) const;
 
+  // Size in bytes up to which consecutive inserts and deletes of the update script are merged into multi-row
+  // statements, 0 keeps one statement per row.
+  virtual size_t max_batch_statement_size() {
+    return 0;
+  }
+
 public:
   void schema_name(const std::string &schema_name) {
     _schema_name = schema_name;
@@ -168,10 +174,11 @@ private:
   typedef std::map<std::string, int> Fields_order;
   Fields_order _fields_order;
 
-  void load_insert_statement(const std::string &sql, const std::pair<std::string, std::string> &schema_table,
+  // Fills row_values with the row of an insert statement, returns false if the statement is skipped.
+  bool load_insert_statement(const std::string &sql, const std::pair<std::string, std::string> &schema_table,
                              const Sql_inserts_loader::Strings &fields_names,
                              const Sql_inserts_loader::Strings &fields_values, const std::vector<bool> &null_fields,
-                             Recordset::Column_names *column_names, Var_list *var_list);
+                             Recordset::Column_names *column_names, Var_vector *row_values);
 
 public:
   db_mgmt_RdbmsRef rdbms() {
@@ -222,6 +229,10 @@ public:
   PrimaryKeyPredicate(const Recordset::Column_types *column_types, const Recordset::Column_names *column_names,
                       const std::vector<ColumnId> *pkey_columns, sqlide::QuoteVar *qv);
   std::string operator()(std::vector<std::shared_ptr<sqlite::result> > &data_row_results);
+
+  // key columns and values in row constructor form, for "(columns) IN ((values), ...)" lists
+  std::string columns() const;
+  bool values(std::vector<std::shared_ptr<sqlite::result> > &data_row_results, std::string &values);
 };
 
 #endif /* _RECORDSET_SQL_STORAGE_BE_H_ */
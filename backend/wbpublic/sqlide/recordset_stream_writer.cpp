@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "recordset_stream_writer.h"
+#include "base/string_utilities.h"
+#include "cppdbc.h"
+
+#include <errno.h>
+#include <stdexcept>
+#include <zlib.h>
+
+#define EXPORT_BUFFER_SIZE (256 * 1024)
+#define EXPORT_PROGRESS_INTERVAL 1000 // rows
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Same rules as the csv_quote template modifier: the field is enclosed in " if it contains any of the given characters.
+static void append_csv_field(std::string &out, const std::string &value, const std::string &quote_if_any_of) {
+  if (value.find_first_of(quote_if_any_of) == std::string::npos) {
+    out.append(value);
+    return;
+  }
+
+  out.push_back('"');
+  for (char c : value) {
+    if (c == '"')
+      out.push_back('"');
+    out.push_back(c);
+  }
+  out.push_back('"');
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class CSVStreamWriter : public Recordset_stream_writer {
+public:
+  CSVStreamWriter(const Recordset_text_storage::TemplateInfo &info, const Parameters &parameters, char separator)
+    : Recordset_stream_writer(info, parameters), _separator(separator) {
+    // The tab template quotes only fields containing a tab, the others also quote on blanks and quotes.
+    if (separator == '\t')
+      _quote_if_any_of = "\t";
+    else
+      _quote_if_any_of = std::string(" \"\t\r\n") + separator;
+  }
+
+protected:
+  virtual void write_header(const std::string &generator_query) {
+    write_fields(_column_names);
+  }
+
+  virtual void write_row() {
+    write_fields(_fields);
+  }
+
+private:
+  char _separator;
+  std::string _quote_if_any_of;
+  std::string _line;
+
+  void write_fields(const std::vector<std::string> &fields) {
+    _line.clear();
+    for (size_t i = 0; i < fields.size(); ++i) {
+      if (i > 0)
+        _line.push_back(_separator);
+      append_csv_field(_line, fields[i], _quote_if_any_of);
+    }
+    _line.push_back('\n');
+    write(_line);
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class JSONStreamWriter : public Recordset_stream_writer {
+public:
+  JSONStreamWriter(const Recordset_text_storage::TemplateInfo &info, const Parameters &parameters)
+    : Recordset_stream_writer(info, parameters) {
+  }
+
+protected:
+  virtual void write_header(const std::string &generator_query) {
+    // The template asks for xml_escape on the names, but that modifier is not registered in mtemplate and the
+    // template writes them unchanged.
+    _names.clear();
+    for (const std::string &name : _column_names)
+      _names.push_back("\n\t\t\"" + name + "\" : ");
+    write("[\n");
+  }
+
+  // The separator of a row is written when the next one starts, so a row doesn't need to know if it is the last.
+  virtual void write_row() {
+    _line.clear();
+    if (_row_count > 0)
+      _line.append(_info.row_separator).push_back('\n');
+    _line.append("\t{");
+    for (size_t i = 0; i < _fields.size(); ++i) {
+      if (i > 0)
+        _line.push_back(',');
+      _line.append(i < _names.size() ? _names[i] : std::string()).append(_fields[i]);
+    }
+    _line.append("\n\t}");
+    write(_line);
+  }
+
+  virtual void write_footer() {
+    write(_row_count > 0 ? "\n]\n" : "]\n");
+  }
+
+private:
+  std::vector<std::string> _names; // Field name prefixes, built once.
+  std::string _line;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class SQLInsertsStreamWriter : public Recordset_stream_writer {
+public:
+  SQLInsertsStreamWriter(const Recordset_text_storage::TemplateInfo &info, const Parameters &parameters)
+    : Recordset_stream_writer(info, parameters) {
+  }
+
+protected:
+  virtual void write_header(const std::string &generator_query) {
+    Parameters::const_iterator date = _parameters.find("GENERATE_DATE");
+    Parameters::const_iterator table = _parameters.find("TABLE_NAME");
+
+    write("/*\n-- Query: " + generator_query + "\n-- Date: " +
+          (date != _parameters.end() ? date->second : std::string()) + "\n*/\n");
+
+    _insert = "INSERT INTO `" + (table != _parameters.end() ? table->second : std::string()) + "` (";
+    for (size_t i = 0; i < _column_names.size(); ++i) {
+      if (i > 0)
+        _insert.push_back(',');
+      _insert.append("`").append(_column_names[i]).append("`");
+    }
+    _insert.append(") VALUES (");
+  }
+
+  virtual void write_row() {
+    _line = _insert;
+    for (size_t i = 0; i < _fields.size(); ++i) {
+      if (i > 0)
+        _line.push_back(',');
+      _line.append(_fields[i]);
+    }
+    _line.append(");\n");
+    write(_line);
+  }
+
+private:
+  std::string _insert; // Statement up to the values, the same for every row.
+  std::string _line;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Recordset_stream_writer::Ref Recordset_stream_writer::create(const Recordset_text_storage::TemplateInfo &info,
+                                                             const Parameters &parameters) {
+  // A user template with the name of a builtin one replaces it, so only the builtin templates are streamed.
+  if (!info.builtin)
+    return Ref();
+
+  if (info.name == "CSV")
+    return Ref(new CSVStreamWriter(info, parameters, ','));
+  if (info.name == "CSV_semicolon")
+    return Ref(new CSVStreamWriter(info, parameters, ';'));
+  if (info.name == "tab")
+    return Ref(new CSVStreamWriter(info, parameters, '\t'));
+  if (info.name == "JSON")
+    return Ref(new JSONStreamWriter(info, parameters));
+  if (info.name == "SQL_inserts")
+    return Ref(new SQLInsertsStreamWriter(info, parameters));
+  return Ref();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Recordset_stream_writer::Recordset_stream_writer(const Recordset_text_storage::TemplateInfo &info,
+                                                 const Parameters &parameters)
+  : _info(info), _parameters(parameters), _row_count(0), _zstream(nullptr), _bytes_written(0) {
+  _buffer.reserve(EXPORT_BUFFER_SIZE);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Recordset_stream_writer::~Recordset_stream_writer() {
+  if (_zstream) {
+    deflateEnd(_zstream);
+    delete _zstream;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string Recordset_stream_writer::quote_string(const std::string &value) const {
+  std::string quote = _info.quote.empty() ? "'" : _info.quote;
+  if (_info.name == "JSON")
+    return quote + base::escape_json_string(value) + quote;
+  return quote + base::escape_sql_string(value, false) + quote;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Recordset_stream_writer::open(const std::string &path, bool gzip) {
+  // Same mode as the template output, so line endings don't change between the two paths.
+  base::FileHandle file(path, gzip ? "wb" : "w+");
+  _file = file;
+  _bytes_written = 0;
+
+  if (gzip) {
+    _zstream = new z_stream();
+    // 16 added to the window bits selects the gzip header and trailer instead of the zlib ones.
+    if (deflateInit2(_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      delete _zstream;
+      _zstream = nullptr;
+      throw std::runtime_error("Could not initialize gzip compression");
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Recordset_stream_writer::begin(const std::vector<std::string> &column_names, const std::string &generator_query) {
+  _column_names = column_names;
+  _fields.clear();
+  _fields.reserve(column_names.size());
+  _row_count = 0;
+  write_header(generator_query);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Recordset_stream_writer::end_row() {
+  write_row();
+  ++_row_count;
+  _fields.clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Recordset_stream_writer::end() {
+  write_footer();
+  flush();
+  if (_zstream)
+    deflate_buffer(true);
+  if (_file.file() && fflush(_file.file()) != 0)
+    throw base::file_error("Failed to write file \"" + _file.getPath() + "\"", errno);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool Recordset_stream_writer::write_resultset(sql::ResultSet *rs, const std::string &generator_query,
+                                              const Progress &progress) {
+  sql::ResultSetMetaData *meta = rs->getMetaData();
+  unsigned int column_count = meta->getColumnCount();
+
+  // Same rule as the cdbc recordset storage uses for its NeedsQuoteFlag.
+  std::vector<std::string> names;
+  std::vector<bool> quoted;
+  for (unsigned int column = 1; column <= column_count; ++column) {
+    names.push_back(meta->getColumnLabel(column));
+    quoted.push_back(!meta->isNumeric(column) && meta->getColumnType(column) != sql::DataType::DECIMAL);
+  }
+
+  begin(names, generator_query);
+  while (rs->next()) {
+    for (unsigned int column = 1; column <= column_count; ++column) {
+      std::string value = rs->getString(column);
+      if (rs->isNull(column))
+        add_null();
+      else if (pre_quote_strings() && quoted[column - 1])
+        add_value(quote_string(value));
+      else
+        add_value(value);
+    }
+    end_row();
+
+    if (progress && _row_count % EXPORT_PROGRESS_INTERVAL == 0 && !progress(_row_count))
+      return false;
+  }
+  end();
+
+  if (progress)
+    progress(_row_count);
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Recordset_stream_writer::write(const std::string &data) {
+  if (_buffer.size() + data.size() > EXPORT_BUFFER_SIZE)
+    flush();
+  if (data.size() > EXPORT_BUFFER_SIZE) {
+    _buffer = data;
+    flush();
+  } else
+    _buffer.append(data);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Recordset_stream_writer::flush() {
+  if (_buffer.empty())
+    return;
+
+  if (_zstream)
+    deflate_buffer(false);
+  else
+    write_file(_buffer.data(), _buffer.size());
+  _buffer.clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Recordset_stream_writer::write_file(const char *data, size_t size) {
+  if (!_file.file())
+    throw std::logic_error("Recordset_stream_writer: output file was not opened");
+  if (size > 0 && fwrite(data, 1, size, _file.file()) != size)
+    throw base::file_error("Failed to write file \"" + _file.getPath() + "\"", errno);
+  _bytes_written += size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Compresses the buffer into the file. With finish set the remaining compressed data and the gzip trailer are
+ * written, after that nothing more can be compressed.
+ */
+void Recordset_stream_writer::deflate_buffer(bool finish) {
+  _compressed.resize(EXPORT_BUFFER_SIZE);
+  _zstream->next_in = (Bytef *)_buffer.data();
+  _zstream->avail_in = (uInt)_buffer.size();
+  do {
+    _zstream->next_out = (Bytef *)&_compressed[0];
+    _zstream->avail_out = (uInt)_compressed.size();
+    if (deflate(_zstream, finish ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR)
+      throw std::runtime_error("Error compressing \"" + _file.getPath() + "\"");
+    write_file(_compressed.data(), _compressed.size() - _zstream->avail_out);
+  } while (_zstream->avail_out == 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
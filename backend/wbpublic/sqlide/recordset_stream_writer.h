@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _RECORDSET_STREAM_WRITER_BE_H_
+#define _RECORDSET_STREAM_WRITER_BE_H_
+
+#include "wbpublic_public_interface.h"
+#include "recordset_text_storage.h"
+#include "base/file_utilities.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sql {
+  class ResultSet;
+}
+
+struct z_stream_s;
+
+/**
+ * Writes exported rows straight to a file, one row at a time, for the builtin CSV, tab separated, JSON and
+ * SQL INSERT formats. The output is byte for byte what their templates produce, but no dictionaries are built and
+ * memory use does not grow with the number of rows.
+ *
+ * Usage: begin() with the column names, then add_value()/add_null() for every field of a row followed by
+ * end_row(), and finally end(). write_resultset() does all of that for a server side result set.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC Recordset_stream_writer {
+public:
+  typedef std::shared_ptr<Recordset_stream_writer> Ref;
+  typedef Recordset_text_storage::Parameters Parameters;
+  // Called with the number of rows written so far, returns false to stop the export.
+  typedef std::function<bool(size_t)> Progress;
+
+  // Returns an empty ref if the format has no streaming writer and must be exported through its template.
+  static Ref create(const Recordset_text_storage::TemplateInfo &info, const Parameters &parameters);
+  virtual ~Recordset_stream_writer();
+
+  // Whether string values are passed as literals of the format (see quote_string()) or as they are.
+  bool pre_quote_strings() const {
+    return _info.pre_quote_strings;
+  }
+  std::string quote_string(const std::string &value) const;
+
+  void open(const std::string &path, bool gzip = false);
+  void begin(const std::vector<std::string> &column_names, const std::string &generator_query);
+  void add_value(const std::string &value) {
+    _fields.push_back(value);
+  }
+  void add_null() {
+    _fields.push_back(_info.null_syntax);
+  }
+  void end_row();
+  void end();
+
+  // Fetches the rows one by one, so an unbuffered result set is never held in memory. Returns false if cancelled.
+  bool write_resultset(sql::ResultSet *rs, const std::string &generator_query, const Progress &progress = Progress());
+
+  size_t row_count() const {
+    return _row_count;
+  }
+  // Bytes written to the file so far, after compression.
+  size_t bytes_written() const {
+    return _bytes_written;
+  }
+
+protected:
+  Recordset_stream_writer(const Recordset_text_storage::TemplateInfo &info, const Parameters &parameters);
+
+  virtual void write_header(const std::string &generator_query) = 0;
+  virtual void write_row() = 0;
+  virtual void write_footer() {
+  }
+
+  void write(const std::string &data);
+  void flush();
+
+  Recordset_text_storage::TemplateInfo _info;
+  Parameters _parameters;
+  std::vector<std::string> _column_names;
+  std::vector<std::string> _fields; // The row being written, reused for all rows.
+  size_t _row_count;
+
+private:
+  base::FileHandle _file;
+  std::string _buffer;
+  z_stream_s *_zstream; // Set when writing gzip.
+  std::string _compressed;
+  size_t _bytes_written;
+
+  void write_file(const char *data, size_t size);
+  void deflate_buffer(bool finish);
+};
+
+#endif /* _RECORDSET_STREAM_WRITER_BE_H_ */
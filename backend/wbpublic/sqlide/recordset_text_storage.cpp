@@ -25,6 +25,7 @@
 
 #include "recordset_text_storage.h"
 #include "recordset_be.h"
+#include "recordset_stream_writer.h"
 #include "base/string_utilities.h"
 #include "base/file_functions.h"
 #include "base/file_utilities.h"
@@ -52,7 +53,7 @@ static const Recordset_text_storage::TemplateInfo &template_info(const std::stri
   return _templates[template_name];
 }
 
-static void process_templates(const std::list<std::string> &files) {
+static void process_templates(const std::list<std::string> &files, bool builtin) {
   for (std::list<std::string>::const_iterator f = files.begin(); f != files.end(); ++f) {
     ConfigurationFile cf(AutoCreateNothing);
     if (cf.load(*f)) {
@@ -66,6 +67,7 @@ static void process_templates(const std::list<std::string> &files) {
       info.include_column_types = cf.get_value("include_column_types");
       info.null_syntax = cf.get_value("null_syntax");
       info.row_separator = cf.get_value("row_separator");
+      info.builtin = builtin;
       if (info.include_column_types != "xls")
         info.include_column_types = "";
       std::string args = cf.get_value("arguments");
@@ -84,11 +86,11 @@ static void scan_templates() {
   if (_templates.empty()) {
     std::string template_dir = base::makePath(bec::GRTManager::get()->get_basedir(), "modules/data/sqlide");
     std::list<std::string> files = base::scan_for_files_matching(template_dir + "/*.tpli");
-    process_templates(files);
+    process_templates(files, true);
 
     template_dir = base::makePath(bec::GRTManager::get()->get_user_datadir(), "recordset_export_templates");
     files = base::scan_for_files_matching(template_dir + "/*.tpli");
-    process_templates(files);
+    process_templates(files, false);
   }
 }
 
@@ -146,8 +148,84 @@ static std::string escape_json_string_(const std::string &s) {
   return base::escape_json_string(s);
 }
 
+static sqlide::QuoteVar quote_var(const Recordset_text_storage::TemplateInfo &info) {
+  sqlide::QuoteVar qv;
+  if (info.quote != "")
+    qv.quote = info.quote;
+  if (info.name == "JSON")
+    qv.escape_string = std::ptr_fun(escape_json_string_);
+  else
+    qv.escape_string = std::ptr_fun(escape_sql_string_);
+  // swap db (sqlite) stores unknown values as quoted strings
+  qv.store_unknown_as_string = true;
+  qv.allow_func_escaping = false;
+  qv.blob_to_string =
+    (true) ? sqlide::QuoteVar::Blob_to_string() : std::ptr_fun(sqlide::QuoteVar::blob_to_hex_string);
+  return qv;
+}
+
+// Writes the swap db rows through a stream writer, producing the same output as the template would.
+void Recordset_text_storage::serialize_streamed(const Recordset *recordset, sqlite::connection *data_swap_db,
+                                                Recordset_stream_writer &writer) {
+  const Recordset::Column_names *column_names = recordset->column_names();
+  const Recordset::Column_types &column_types = get_column_types(recordset);
+  const Recordset::Column_flags &column_flags = get_column_flags(recordset);
+  ColumnId visible_col_count = recordset->get_column_count();
+  sqlide::QuoteVar qv(quote_var(template_info(_data_format)));
+  sqlide::VarToStr var_to_str;
+
+  std::vector<std::string> names;
+  for (ColumnId col = 0; col < visible_col_count; ++col)
+    names.push_back((*column_names)[col]);
+
+  writer.open(_file_path);
+  writer.begin(names, recordset->generator_query());
+
+  const size_t partition_count = recordset->data_swap_db_partition_count();
+  std::list<std::shared_ptr<sqlite::query> > data_queries(partition_count);
+  Recordset::prepare_partition_queries(data_swap_db, "select * from `data%s`", data_queries);
+  std::vector<std::shared_ptr<sqlite::result> > data_results(data_queries.size());
+
+  if (Recordset::emit_partition_queries(data_swap_db, data_queries, data_results)) {
+    bool next_row_exists = true;
+    sqlite::variant_t v;
+    do {
+      for (size_t partition = 0; partition < partition_count; ++partition) {
+        std::shared_ptr<sqlite::result> &data_rs = data_results[partition];
+        for (ColumnId col_begin = partition * Recordset::DATA_SWAP_DB_TABLE_MAX_COL_COUNT, col = col_begin,
+                      col_end = std::min<ColumnId>(visible_col_count,
+                                                   (partition + 1) * Recordset::DATA_SWAP_DB_TABLE_MAX_COL_COUNT);
+             col < col_end; ++col) {
+          v = data_rs->get_variant((int)(col - col_begin));
+          sqlide::unpack_data_swap_value(v);
+          if (sqlide::is_var_null(v))
+            writer.add_null();
+          else if (writer.pre_quote_strings() && (column_flags[col] & Recordset::NeedsQuoteFlag))
+            writer.add_value(boost::apply_visitor(qv, column_types[col], v));
+          else
+            writer.add_value(boost::apply_visitor(var_to_str, v));
+        }
+      }
+      writer.end_row();
+
+      for (std::shared_ptr<sqlite::result> &data_rs : data_results)
+        next_row_exists = data_rs->next_row();
+    } while (next_row_exists);
+  }
+
+  writer.end();
+}
+
 void Recordset_text_storage::do_serialize(const Recordset *recordset, sqlite::connection *data_swap_db) {
   const TemplateInfo &info(template_info(_data_format));
+
+  // the builtin plain text formats don't need the template engine, which keeps a dictionary per row
+  Recordset_stream_writer::Ref writer(Recordset_stream_writer::create(info, _parameters));
+  if (writer) {
+    serialize_streamed(recordset, data_swap_db, *writer);
+    return;
+  }
+
   std::string template_name(info.name);
   bool strings_are_pre_quoted(info.pre_quote_strings);
   std::string include_column_types(info.include_column_types);
@@ -196,20 +274,7 @@ void Recordset_text_storage::do_serialize(const Recordset *recordset, sqlite::co
   const Recordset::Column_flags &column_flags = get_column_flags(recordset);
 
   ColumnId visible_col_count = recordset->get_column_count();
-  sqlide::QuoteVar qv;
-  {
-    if (info.quote != "")
-      qv.quote = info.quote;
-    if (_data_format == "JSON")
-      qv.escape_string = std::ptr_fun(escape_json_string_);
-    else
-      qv.escape_string = std::ptr_fun(escape_sql_string_);
-    // swap db (sqlite) stores unknown values as quoted strings
-    qv.store_unknown_as_string = true;
-    qv.allow_func_escaping = false;
-    qv.blob_to_string =
-      (true) ? sqlide::QuoteVar::Blob_to_string() : std::ptr_fun(sqlide::QuoteVar::blob_to_hex_string);
-  }
+  sqlide::QuoteVar qv(quote_var(info));
 
   // global variables
   mtemplate::SetGlobalValue("INDENT", "\t");
@@ -280,6 +345,7 @@ void Recordset_text_storage::do_serialize(const Recordset *recordset, sqlite::co
               ColumnId partition_column = col - col_begin;
               bool is_null;
               v = data_rs->get_variant((int)partition_column);
+              sqlide::unpack_data_swap_value(v);
 
               is_null = sqlide::is_var_null(v); // for some reason, the apply_visitor stuff isnt handling NULL
 
@@ -347,6 +413,7 @@ void Recordset_text_storage::do_serialize(const Recordset *recordset, sqlite::co
                  col < col_end; ++col) {
               ColumnId partition_column = col - col_begin;
               v = data_rs->get_variant((int)partition_column);
+              sqlide::unpack_data_swap_value(v);
               mtemplate::DictionaryInterface *field_dictionary = row_dictionary->addSectionDictionary("FIELD");
               field_dictionary->setValue("FIELD_NAME", (*column_names)[col]);
               std::string field_value;
@@ -385,6 +452,11 @@ std::string Recordset_text_storage::parameter_value(const std::string &name) con
   return (_parameters.end() != i) ? i->second : std::string();
 }
 
+Recordset_text_storage::TemplateInfo Recordset_text_storage::storage_type(const std::string &name) {
+  scan_templates();
+  return template_info(name);
+}
+
 std::vector<Recordset_storage_info> Recordset_text_storage::storage_types() {
   scan_templates();
 
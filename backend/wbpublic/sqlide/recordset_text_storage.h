@@ -28,6 +28,8 @@
 #include "recordset_data_storage.h"
 #include <map>
 
+class Recordset_stream_writer;
+
 class WBPUBLICBACKEND_PUBLIC_FUNC Recordset_text_storage : public Recordset_data_storage {
 public:
   class TemplateInfo : public Recordset_storage_info {
@@ -38,8 +40,10 @@ public:
     std::string row_separator;
     bool pre_quote_strings;
     std::string quote;
+    bool builtin; // Shipped with the application, not a user template.
   };
   static std::vector<Recordset_storage_info> storage_types();
+  static TemplateInfo storage_type(const std::string &name);
 
 public:
   typedef std::shared_ptr<Recordset_text_storage> Ref;
@@ -58,6 +62,10 @@ protected:
   virtual void do_fetch_blob_value(Recordset *recordset, sqlite::connection *data_swap_db, RowId rowid, ColumnId column,
                                    sqlite::variant_t &blob_value);
 
+private:
+  void serialize_streamed(const Recordset *recordset, sqlite::connection *data_swap_db,
+                          Recordset_stream_writer &writer);
+
 public:
   virtual ColumnId aux_column_count();
 
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/database_exception.hpp>
+
+#include "base/log.h"
+#include "base/file_utilities.h"
+#include "base/boost_smart_ptr_helpers.h"
+#include "sqlide_generics.h"
+
+#include "schema_metadata_cache.h"
+
+#include <map>
+
+DEFAULT_LOG_DOMAIN("schema_cache");
+
+// The caches in use, by file. Entries of released caches are removed when the next one is asked for.
+static std::mutex instances_mutex;
+static std::map<std::string, std::weak_ptr<SchemaMetadataCache> > instances;
+
+SchemaMetadataCache::Ref SchemaMetadataCache::get(const std::string &connection_id, const std::string &cache_dir) {
+  std::string path = base::makePath(cache_dir, connection_id);
+
+  std::lock_guard<std::mutex> lock(instances_mutex);
+  for (auto iterator = instances.begin(); iterator != instances.end();) {
+    if (iterator->second.expired())
+      iterator = instances.erase(iterator);
+    else
+      ++iterator;
+  }
+
+  Ref cache = instances[path].lock();
+  if (!cache) {
+    cache = Ref(new SchemaMetadataCache(connection_id, cache_dir));
+    instances[path] = cache;
+  }
+  return cache;
+}
+
+SchemaMetadataCache::SchemaMetadataCache(const std::string &connection_id, const std::string &cache_dir)
+  : _connection_id(connection_id) {
+  _sqconn = new sqlite::connection(base::makePath(cache_dir, connection_id) + ".schema_metadata");
+  sqlite::execute(*_sqconn, "PRAGMA temp_store=MEMORY", true);
+  sqlite::execute(*_sqconn, "PRAGMA synchronous=NORMAL", true);
+
+  logDebug2("Using schema meta data cache file %s\n",
+            (base::makePath(cache_dir, connection_id) + ".schema_metadata").c_str());
+  init_db();
+}
+
+SchemaMetadataCache::~SchemaMetadataCache() {
+  delete _sqconn;
+}
+
+void SchemaMetadataCache::init_db() {
+  static const char *code[] = {
+    "create table if not exists schemas (schema_name text primary key, digest text, columns_fetched int)",
+    "create table if not exists objects (schema_name text, name text, type char(1))",
+    "create index if not exists objects_schema on objects (schema_name)",
+    "create table if not exists columns (schema_name text, table_name text, column_name text)",
+    "create index if not exists columns_schema on columns (schema_name)"};
+
+  for (const char *statement : code) {
+    try {
+      sqlite::execute(*_sqconn, statement, true);
+    } catch (std::exception &exc) {
+      logError("Error creating cache %s: %s\n", statement, exc.what());
+    }
+  }
+}
+
+/*
+ * Fills the given lists with the stored object names of the schema, if they were stored with the given digest.
+ */
+bool SchemaMetadataCache::get_schema_contents(const std::string &schema, const std::string &digest,
+                                              base::StringListPtr tables, base::StringListPtr views,
+                                              base::StringListPtr procedures, base::StringListPtr functions) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::query check(*_sqconn, "select digest from schemas where schema_name = ?");
+    check.bind(1, schema);
+    if (!check.emit())
+      return false;
+
+    std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(check.get_result()));
+    if (res->get_string(0) != digest)
+      return false;
+
+    sqlite::query q(*_sqconn, "select name, type from objects where schema_name = ? order by rowid");
+    q.bind(1, schema);
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      do {
+        std::string type = res->get_string(1);
+        if (type == "T")
+          tables->push_back(res->get_string(0));
+        else if (type == "V")
+          views->push_back(res->get_string(0));
+        else if (type == "P")
+          procedures->push_back(res->get_string(0));
+        else
+          functions->push_back(res->get_string(0));
+      } while (res->next_row());
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading schema %s from cache: %s\n", schema.c_str(), exc.what());
+    tables->clear();
+    views->clear();
+    procedures->clear();
+    functions->clear();
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Replaces the stored object names of the schema. Stored columns of the schema are removed.
+ */
+void SchemaMetadataCache::store_schema_contents(const std::string &schema, const std::string &digest,
+                                                base::StringListPtr tables, base::StringListPtr views,
+                                                base::StringListPtr procedures, base::StringListPtr functions) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_sqconn);
+    {
+      sqlite::query q(*_sqconn, "delete from objects where schema_name = ?");
+      q.bind(1, schema);
+      q.emit();
+    }
+    {
+      sqlite::query q(*_sqconn, "delete from columns where schema_name = ?");
+      q.bind(1, schema);
+      q.emit();
+    }
+    {
+      sqlite::query q(*_sqconn, "insert or replace into schemas values (?, ?, 0)");
+      q.bind(1, schema);
+      q.bind(2, digest);
+      q.emit();
+    }
+
+    sqlite::query q(*_sqconn, "insert into objects values (?, ?, ?)");
+    std::pair<base::StringListPtr, std::string> lists[] = {
+      {tables, "T"}, {views, "V"}, {procedures, "P"}, {functions, "F"}};
+    for (auto &list : lists) {
+      if (!list.first)
+        continue;
+      for (auto &name : *list.first) {
+        q.bind(1, schema);
+        q.bind(2, name);
+        q.bind(3, list.second);
+        q.emit();
+        q.clear();
+      }
+    }
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error storing schema %s to cache: %s\n", schema.c_str(), exc.what());
+  }
+}
+
+/*
+ * Returns the stored columns of all tables and views of the schema, if they were stored after its object names.
+ */
+bool SchemaMetadataCache::get_columns(const std::string &schema, ColumnList &columns) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::query check(*_sqconn, "select columns_fetched from schemas where schema_name = ?");
+    check.bind(1, schema);
+    if (!check.emit())
+      return false;
+
+    std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(check.get_result()));
+    if (res->get_int(0) == 0)
+      return false;
+
+    sqlite::query q(*_sqconn, "select table_name, column_name from columns where schema_name = ? order by rowid");
+    q.bind(1, schema);
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      do
+        columns.push_back({res->get_string(0), res->get_string(1)});
+      while (res->next_row());
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading columns of schema %s from cache: %s\n", schema.c_str(), exc.what());
+    columns.clear();
+    return false;
+  }
+  return true;
+}
+
+void SchemaMetadataCache::store_columns(const std::string &schema, const ColumnList &columns) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_sqconn);
+    {
+      sqlite::query q(*_sqconn, "delete from columns where schema_name = ?");
+      q.bind(1, schema);
+      q.emit();
+    }
+
+    sqlite::query q(*_sqconn, "insert into columns values (?, ?, ?)");
+    for (auto &column : columns) {
+      q.bind(1, schema);
+      q.bind(2, column.first);
+      q.bind(3, column.second);
+      q.emit();
+      q.clear();
+    }
+
+    sqlite::query update(*_sqconn, "update schemas set columns_fetched = 1 where schema_name = ?");
+    update.bind(1, schema);
+    update.emit();
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error storing columns of schema %s to cache: %s\n", schema.c_str(), exc.what());
+  }
+}
+
+/*
+ * Removes everything, so that all schemas are fetched again from the server.
+ */
+void SchemaMetadataCache::invalidate() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_sqconn);
+    sqlite::execute(*_sqconn, "delete from columns", true);
+    sqlite::execute(*_sqconn, "delete from objects", true);
+    sqlite::execute(*_sqconn, "delete from schemas", true);
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error clearing schema meta data cache: %s\n", exc.what());
+  }
+}
+
+void SchemaMetadataCache::remove_schema(const std::string &schema) {
+  sqlide::Sqlite_transaction_guarder transaction(_sqconn);
+  const char *tables[] = {"columns", "objects", "schemas"};
+  for (const char *table : tables) {
+    sqlite::query q(*_sqconn, std::string("delete from ") + table + " where schema_name = ?");
+    q.bind(1, schema);
+    q.emit();
+  }
+  transaction.commit();
+}
+
+/*
+ * The digest of a schema changes with a dropped object anyway, its data is removed here so that no editor works with
+ * it until the schema is loaded again.
+ */
+void SchemaMetadataCache::object_dropped(const std::string &object_type, const std::string &schema,
+                                         const std::string &name) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    try {
+      remove_schema(schema);
+    } catch (std::exception &exc) {
+      logError("Error removing schema %s from cache: %s\n", schema.c_str(), exc.what());
+    }
+  }
+  _object_dropped(object_type, schema, name);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "wbpublic_public_interface.h"
+#include "base/string_utilities.h"
+
+#include <sqlite/connection.hpp>
+#include <boost/signals2.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Schema meta data (object names and columns) of a connection, kept between sessions. Each schema is stored with
+ * a digest of its server side state. Data is only returned for the digest it was stored with.
+ *
+ * All editors open on the same connection share one instance, so what one of them fetched is there for the others
+ * and objects dropped in one are removed from the schema trees of all of them.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC SchemaMetadataCache {
+public:
+  typedef std::shared_ptr<SchemaMetadataCache> Ref;
+  typedef std::vector<std::pair<std::string, std::string> > ColumnList; // (table or view, column) in column order
+  // object type (db.Table, db.Schema...), schema and object name; for schemas the name is the schema again
+  typedef boost::signals2::signal<void(const std::string &, const std::string &, const std::string &)>
+    ObjectDroppedSignal;
+
+  // Returns the cache of the connection, created on first use and released with the last editor using it.
+  static Ref get(const std::string &connection_id, const std::string &cache_dir);
+
+  virtual ~SchemaMetadataCache();
+
+private:
+  std::string _connection_id;
+  sqlite::connection *_sqconn;
+  std::mutex _mutex; // used from the tree fetch tasks and the main threads of all editors of the connection
+  ObjectDroppedSignal _object_dropped;
+
+  SchemaMetadataCache(const std::string &connection_id, const std::string &cache_dir);
+  void init_db();
+  void remove_schema(const std::string &schema);
+
+public:
+
+  bool get_schema_contents(const std::string &schema, const std::string &digest, base::StringListPtr tables,
+                           base::StringListPtr views, base::StringListPtr procedures, base::StringListPtr functions);
+  void store_schema_contents(const std::string &schema, const std::string &digest, base::StringListPtr tables,
+                             base::StringListPtr views, base::StringListPtr procedures,
+                             base::StringListPtr functions);
+
+  bool get_columns(const std::string &schema, ColumnList &columns);
+  void store_columns(const std::string &schema, const ColumnList &columns);
+
+  void invalidate();
+
+  // Drops what is stored for the object's schema and tells all editors of the connection about it.
+  void object_dropped(const std::string &object_type, const std::string &schema, const std::string &name);
+  ObjectDroppedSignal *signal_object_dropped() {
+    return &_object_dropped;
+  }
+};
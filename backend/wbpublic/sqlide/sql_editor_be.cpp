@@ -24,6 +24,7 @@
 #include "base/boost_smart_ptr_helpers.h"
 #include "base/log.h"
 #include "base/string_utilities.h"
+#include "base/task_scheduler.h"
 #include "base/threaded_timer.h"
 #include "base/util_functions.h"
 
@@ -46,6 +47,11 @@
 
 #include "sql_editor_be.h"
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <boost/functional/hash.hpp>
 
 DEFAULT_LOG_DOMAIN("MySQL editor");
 
@@ -79,6 +85,13 @@ public:
   // Entries determined the last time we started auto completion. The actually shown list
   // is derived from these entries filtered by the current input.
   std::vector<std::pair<int, std::string>> codeCompletionCandidates;
+  std::string codeCompletionPrefix; // The written part when the candidates were collected (they match only that).
+
+  // Candidates are collected in a background thread. Each request (and each text change) gets a new generation,
+  // so results from an outdated request are dropped.
+  std::atomic<size_t> _completion_generation;
+  int _completion_task_id;
+  base::RecMutex _completion_mutex; // Held while candidates are collected.
 
   base::RecMutex _sql_checker_mutex;
   MySQLParseUnit parseUnit; // The type of query we want to limit our parsing to.
@@ -94,12 +107,36 @@ public:
   std::vector<ParserErrorInfo> _recognition_errors; // List of errors from the last sql check run.
   std::set<size_t> _error_marker_lines;
 
+  // Ranges (start, length) that have the error indicator in the editor, moved along with text changes. Where the
+  // text was edited since the last update the editor may have extended or cut them, that span is redone as a whole.
+  std::set<std::pair<size_t, size_t>> _error_indicator_ranges;
+  size_t _indicators_dirty_start = std::string::npos;
+  size_t _indicators_dirty_end = 0;
+
   bool _splitting_required;
   bool _updating_statement_markers;
   std::set<size_t> _statement_marker_lines;
   base::RecMutex _sql_statement_borders_mutex;
 
   std::vector<StatementRange> _statementRanges;
+  std::atomic<size_t> _split_position; // First position changed since the last split, npos if none.
+  std::atomic<size_t> _statement_markers_from; // Start of the first statement split again since the last
+                                               // marker update, npos if none.
+
+  // Errors found in each statement by the last checks, relative to the statement start and keyed by a hash of
+  // its text. Only statements whose text changed need a new check then.
+  std::unordered_map<size_t, std::vector<ParserErrorInfo>> _statement_errors;
+  std::atomic<bool> _statement_errors_outdated; // Set when the parser settings change.
+  std::vector<MySQLParserContext::Ref> _check_contexts; // Copies of parserContext for the additional check threads.
+
+  // Tables named after FROM, JOIN, UPDATE and INTO in each statement, keyed like _statement_errors.
+  std::unordered_map<size_t, std::vector<std::pair<std::string, std::string>>> _statement_tables;
+  MySQLEditor::TableReferences _table_references; // All of them (up to MAX_TABLE_REFERENCES) from the last check.
+  boost::signals2::signal<void(const MySQLEditor::TableReferences &)> _table_references_signal;
+  std::set<size_t> _table_intro_tokens;
+  size_t _dot_token = 0;
+  size_t _comma_token = 0;
+  size_t _as_token = 0;
 
   bool _is_refresh_enabled;   // whether FE control is permitted to replace its
                               // contents from BE
@@ -121,6 +158,9 @@ public:
     parseUnit = MySQLParseUnit::PuGeneric;
     _is_refresh_enabled = true;
     _splitting_required = false;
+    _split_position = 0;
+    _statement_markers_from = std::string::npos;
+    _statement_errors_outdated = false;
 
     parserContext = syntaxcheck_context;
     autocompletionContext = autocomplete_context;
@@ -128,6 +168,8 @@ public:
 
     _current_delay_timer = nullptr;
     _current_work_timer_id = -1;
+    _completion_generation = 0;
+    _completion_task_id = -1;
 
     _is_sql_check_enabled = true;
     container = nullptr;
@@ -141,7 +183,20 @@ public:
   //--------------------------------------------------------------------------------------------------------------------
 
   /**
-   * Determines ranges for all statements in the current text.
+   * Marks the text from the given position on as changed, for the next split.
+   */
+  void text_changed_from(size_t position) {
+    size_t current = _split_position;
+    while (position < current && !_split_position.compare_exchange_weak(current, position))
+      ;
+    _splitting_required = true;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Determines ranges for all statements in the current text. Statements ending before the first change since the
+   * last run are kept, the text is split again from the one before them on.
    */
   void split_statements_if_required() {
     // If we have restricted content (e.g. for object editors) then we don't split and handle the entire content
@@ -149,21 +204,225 @@ public:
     if (_splitting_required) {
       logDebug3("Start splitting\n");
       _splitting_required = false;
+      size_t position = _split_position.exchange(std::string::npos);
 
       base::RecMutexLock lock(_sql_statement_borders_mutex);
 
-      _statementRanges.clear();
       if (parseUnit == MySQLParseUnit::PuGeneric) {
         double start = timestamp();
-        services->determineStatementRanges(_textInfo.first, _textInfo.second, ";", _statementRanges);
+
+        // The statement before the first changed one may have lost its delimiter.
+        std::vector<StatementRange>::iterator first =
+          std::lower_bound(_statementRanges.begin(), _statementRanges.end(), position,
+                           [](const StatementRange &range, size_t position) {
+                             return range.start + range.length < position;
+                           });
+        if (first != _statementRanges.begin())
+          --first;
+
+        if (first == _statementRanges.begin() || first->start > _textInfo.second) {
+          _statementRanges.clear();
+          services->determineStatementRanges(_textInfo.first, _textInfo.second, ";", _statementRanges);
+          _statement_markers_from = 0;
+        } else {
+          size_t offset = first->start;
+          size_t current = _statement_markers_from;
+          while (offset < current && !_statement_markers_from.compare_exchange_weak(current, offset))
+            ;
+          size_t line = first->line;
+          std::string delimiter = delimiter_at(offset, first - _statementRanges.begin());
+
+          std::vector<StatementRange> ranges;
+          services->determineStatementRanges(_textInfo.first + offset, _textInfo.second - offset, delimiter, ranges);
+          _statementRanges.erase(first, _statementRanges.end());
+          for (auto &range : ranges)
+            _statementRanges.push_back({ range.line + line, range.start + offset, range.length });
+        }
         logDebug3("Splitting ended after %f ticks\n", timestamp() - start);
-      } else
+      } else {
+        _statementRanges.clear();
         _statementRanges.push_back({ 0, 0, _textInfo.second });
+        _statement_markers_from = 0;
+      }
     }
   }
 
   //--------------------------------------------------------------------------------------------------------------------
 
+  /**
+   * Collects the table references in the statement last parsed with the given context. This is a plain token scan
+   * for a (qualified) identifier after the keywords that introduce tables, plus more of them in comma separated
+   * lists (skipping aliases).
+   */
+  void collect_table_references(MySQLParserContext::Ref context,
+                                std::vector<std::pair<std::string, std::string>> &references) {
+    Scanner scanner = context->createScanner();
+    do {
+      if (_table_intro_tokens.count(scanner.tokenType()) == 0)
+        continue;
+
+      while (scanner.next() && context->isIdentifier(scanner.tokenType())) {
+        std::string schema;
+        std::string table = base::unquote_identifier(scanner.tokenText());
+        if (scanner.lookAhead() == _dot_token) {
+          scanner.next();
+          if (!scanner.next() || !context->isIdentifier(scanner.tokenType()))
+            break;
+          schema = table;
+          table = base::unquote_identifier(scanner.tokenText());
+        }
+        references.push_back({ schema, table });
+
+        if (scanner.lookAhead() == _as_token)
+          scanner.next();
+        if (context->isIdentifier(scanner.lookAhead()))
+          scanner.next();
+        if (scanner.lookAhead() != _comma_token)
+          break;
+        scanner.next();
+      }
+    } while (scanner.next());
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Checks the given statements (indices into _statementRanges) and stores their errors in _statement_errors.
+   * Many statements are spread over a few threads, each with its own parser context, taking the next unchecked
+   * statement when done with one. Returns false if stopped.
+   */
+  bool check_statements(const std::vector<size_t> &statements, const std::vector<size_t> &hashes) {
+    static const size_t MIN_STATEMENTS_PER_THREAD = 100;
+    static const size_t MAX_THREAD_COUNT = 4;
+
+    size_t thread_count = std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()), MAX_THREAD_COUNT);
+    thread_count = std::max<size_t>(1, std::min(thread_count, statements.size() / MIN_STATEMENTS_PER_THREAD));
+    while (_check_contexts.size() + 1 < thread_count)
+      _check_contexts.push_back(parserContext->clone());
+
+    if (_table_intro_tokens.empty()) {
+      for (auto name : { "FROM_SYMBOL", "JOIN_SYMBOL", "UPDATE_SYMBOL", "INTO_SYMBOL" })
+        _table_intro_tokens.insert(services->tokenFromString(parserContext, name));
+      _dot_token = services->tokenFromString(parserContext, "DOT_SYMBOL");
+      _comma_token = services->tokenFromString(parserContext, "COMMA_SYMBOL");
+      _as_token = services->tokenFromString(parserContext, "AS_SYMBOL");
+    }
+
+    std::vector<std::vector<ParserErrorInfo>> errors(statements.size());
+    std::vector<std::vector<std::pair<std::string, std::string>>> tables(statements.size());
+    std::vector<char> checked(statements.size(), 0);
+    std::atomic<size_t> next_statement(0);
+    auto check = [&](MySQLParserContext::Ref context) {
+      for (size_t i = next_statement++; i < statements.size() && !_stop_processing; i = next_statement++) {
+        const StatementRange &range = _statementRanges[statements[i]];
+        try {
+          if (services->checkSqlSyntax(context, _textInfo.first + range.start, range.length, parseUnit) > 0)
+            errors[i] = context->errorsWithOffset(0);
+          collect_table_references(context, tables[i]);
+          checked[i] = 1;
+        } catch (std::exception &e) {
+          logError("Error checking statement syntax: %s\n", e.what());
+        }
+      }
+    };
+
+    // Interactive, the user is typing and waiting for the error markers.
+    base::TaskScheduler::get()->run_parallel(base::TaskInteractive, thread_count, [&](size_t i) {
+      check(i == 0 ? parserContext : _check_contexts[i - 1]);
+    });
+
+    for (size_t i = 0; i < statements.size(); ++i)
+      if (checked[i]) {
+        _statement_errors[hashes[statements[i]]].swap(errors[i]);
+        _statement_tables[hashes[statements[i]]].swap(tables[i]);
+      }
+    return !_stop_processing;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Determines the delimiter in effect at the given offset, which is the start of the statement with the given
+   * index. DELIMITER commands are not part of any statement range, so only the text between the ranges before it
+   * is scanned, skipping comments as the splitter does.
+   */
+  std::string delimiter_at(size_t offset, size_t index) {
+    static const char keyword[] = "delimiter";
+
+    std::string delimiter = ";";
+    const char *text = _textInfo.first;
+    for (size_t i = 0; i <= index; ++i) {
+      const char *head = text + (i == 0 ? 0 : _statementRanges[i - 1].start + _statementRanges[i - 1].length);
+      const char *end = text + (i == index ? offset : _statementRanges[i].start);
+      while (head < end) {
+        if (*head == '/' && head + 1 < end && head[1] == '*') {
+          head += 2;
+          while (head < end && !(*head == '*' && head + 1 < end && head[1] == '/'))
+            ++head;
+          head = std::min(head + 2, end);
+        } else if (*head == '#' || (*head == '-' && head + 2 < end && head[1] == '-' &&
+                                    (head[2] == ' ' || head[2] == '\t' || head[2] == '\n'))) {
+          while (head < end && *head != '\n')
+            ++head;
+        } else if ((*head | 0x20) == 'd' && end - head > 9 && head[9] == ' ' &&
+                   g_ascii_strncasecmp(head, keyword, 9) == 0 &&
+                   (head == text || !(g_ascii_isalnum(head[-1]) || head[-1] == '_' || head[-1] == '$' ||
+                                      (unsigned char)head[-1] >= 0x80))) {
+          const char *run = head + 9;
+          while (run < end && *run != '\n')
+            ++run;
+          delimiter = base::trim(std::string(head + 9, run));
+          head = run;
+        } else
+          ++head;
+      }
+    }
+    return delimiter;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Moves the error indicator ranges like the editor does for a text change. Ranges touched by the change are
+   * dropped and their span marked dirty.
+   */
+  void move_error_indicators(size_t position, size_t length, bool inserted) {
+    // Where a position before the change is afterwards.
+    auto moved = [&](size_t offset) -> size_t {
+      if (inserted)
+        return offset >= position ? offset + length : offset;
+      if (offset >= position + length)
+        return offset - length;
+      return offset > position ? position : offset;
+    };
+
+    size_t dirty_start = position;
+    size_t dirty_end = inserted ? position + length : position;
+    if (_indicators_dirty_start != std::string::npos) {
+      dirty_start = std::min(dirty_start, moved(_indicators_dirty_start));
+      dirty_end = std::max(dirty_end, moved(_indicators_dirty_end));
+    }
+
+    std::set<std::pair<size_t, size_t>> ranges;
+    size_t change_end = inserted ? position : position + length; // In the text before the change.
+    for (auto &range : _error_indicator_ranges) {
+      size_t end = range.first + range.second;
+      if (end < position)
+        ranges.insert(range);
+      else if (range.first > change_end)
+        ranges.insert({ moved(range.first), range.second });
+      else {
+        dirty_start = std::min(dirty_start, moved(range.first));
+        dirty_end = std::max(dirty_end, moved(end));
+      }
+    }
+    _error_indicator_ranges.swap(ranges);
+    _indicators_dirty_start = dirty_start;
+    _indicators_dirty_end = dirty_end;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
   /**
    * One or more markers on that line where changed. We have to stay in sync with our statement markers list
    * to make the optimized add/remove algorithm working.
@@ -263,6 +522,7 @@ MySQLEditor::~MySQLEditor() {
     // still holding them.
     base::RecMutexLock lock1(d->_sql_checker_mutex);
     base::RecMutexLock lock2(d->_sql_statement_borders_mutex);
+    base::RecMutexLock lock3(d->_completion_mutex);
   }
 
   if (d->editorTextSubmenu != nullptr)
@@ -545,7 +805,7 @@ void MySQLEditor::append_text(const std::string &text) {
  */
 void MySQLEditor::sql(const char *sql) {
   d->codeEditor->set_text(sql);
-  d->_splitting_required = true;
+  d->text_changed_from(0);
   d->_statement_marker_lines.clear();
   d->codeEditor->set_eol_mode(mforms::EolLF, true);
 }
@@ -612,6 +872,22 @@ boost::signals2::signal<void()> *MySQLEditor::text_change_signal() {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+boost::signals2::signal<void(const MySQLEditor::TableReferences &)> *MySQLEditor::table_references_signal() {
+  return &d->_table_references_signal;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Called in the main thread when the statement check found a different set of table references than before.
+ */
+void *MySQLEditor::table_references_changed(const TableReferences &references) {
+  d->_table_references_signal(references);
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 std::string MySQLEditor::sql_mode() {
   return d->sqlMode;
 };
@@ -621,6 +897,7 @@ std::string MySQLEditor::sql_mode() {
 void MySQLEditor::set_sql_mode(const std::string &value) {
   d->sqlMode = value;
   d->parserContext->updateSqlMode(value);
+  d->_statement_errors_outdated = true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -665,6 +942,7 @@ void MySQLEditor::setServerVersion(GrtVersionRef version) {
   d->codeEditor->set_language(lang);
 
   d->parserContext->updateServerVersion(version);
+  d->_statement_errors_outdated = true;
   start_sql_processing();
 }
 
@@ -698,6 +976,8 @@ void MySQLEditor::restrict_content_to(ContentType type) {
       d->parseUnit = MySQLParseUnit::PuGeneric;
       break;
   }
+  d->_statement_errors_outdated = true;
+  d->text_changed_from(0);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -719,7 +999,8 @@ void MySQLEditor::text_changed(int position, int length, int lines_changed, bool
     update_auto_completion(text);
   }
 
-  d->_splitting_required = true;
+  d->text_changed_from(position);
+  d->move_error_indicators(position, length, added);
   d->_textInfo = d->codeEditor->get_text_ptr();
   if (d->_is_sql_check_enabled)
     d->_current_delay_timer =
@@ -800,18 +1081,68 @@ bool MySQLEditor::do_statement_split_and_check(int id) {
 
   base::RecMutexLock lock(d->_sql_checker_mutex);
 
-  // Now do error checking for each of the statements, collecting error
-  // positions for later markup.
+  if (d->_statement_errors_outdated.exchange(false)) {
+    d->_statement_errors.clear();
+    d->_statement_tables.clear();
+    d->_check_contexts.clear();
+  }
+
+  // Statements not checked before with the same text are parsed first, on several threads if there are many.
+  std::vector<size_t> hashes;
+  std::vector<size_t> unchecked_statements;
+  hashes.reserve(d->_statementRanges.size());
   for (auto &range : d->_statementRanges) {
-    if (d->_stop_processing)
-      return false;
+    const char *statement = d->_textInfo.first + range.start;
+    hashes.push_back(boost::hash_range(statement, statement + range.length));
+    if (d->_statement_errors.count(hashes.back()) == 0)
+      unchecked_statements.push_back(hashes.size() - 1);
+  }
+  if (!d->check_statements(unchecked_statements, hashes))
+    return false;
+
+  // Now collect the error positions of each statement for later markup, in statement order.
+  std::unordered_set<size_t> checked_statements(hashes.begin(), hashes.end());
+  for (size_t i = 0; i < d->_statementRanges.size(); ++i) {
+    auto entry = d->_statement_errors.find(hashes[i]);
+    if (entry == d->_statement_errors.end())
+      continue;
 
-    if (d->services->checkSqlSyntax(d->parserContext, d->_textInfo.first + range.start, range.length, d->parseUnit) > 0) {
-      std::vector<ParserErrorInfo> errors = d->parserContext->errorsWithOffset(range.start);
-      d->_recognition_errors.insert(d->_recognition_errors.end(), errors.begin(), errors.end());
+    for (ParserErrorInfo error : entry->second) {
+      error.charOffset += d->_statementRanges[i].start;
+      d->_recognition_errors.push_back(error);
     }
   }
 
+  // Forget about statements which are gone.
+  for (auto entry = d->_statement_errors.begin(); entry != d->_statement_errors.end();) {
+    if (checked_statements.count(entry->first) == 0)
+      entry = d->_statement_errors.erase(entry);
+    else
+      ++entry;
+  }
+  for (auto entry = d->_statement_tables.begin(); entry != d->_statement_tables.end();) {
+    if (checked_statements.count(entry->first) == 0)
+      entry = d->_statement_tables.erase(entry);
+    else
+      ++entry;
+  }
+
+  // Tell listeners (e.g. to prefetch column info) only when the set of referenced tables changed.
+  TableReferences references;
+  for (size_t i = 0; i < hashes.size() && references.size() < MAX_TABLE_REFERENCES; ++i) {
+    auto entry = d->_statement_tables.find(hashes[i]);
+    if (entry == d->_statement_tables.end())
+      continue;
+    for (auto &reference : entry->second)
+      if (references.size() < MAX_TABLE_REFERENCES)
+        references.insert(reference);
+  }
+  if (references != d->_table_references) {
+    d->_table_references = references;
+    bec::GRTManager::get()->run_once_when_idle(
+      this, std::bind(&MySQLEditor::table_references_changed, this, references));
+  }
+
   bec::GRTManager::get()->run_once_when_idle(this, std::bind(&MySQLEditor::update_error_markers, this));
 
   return false;
@@ -832,20 +1163,38 @@ void *MySQLEditor::splitting_done() {
     show_auto_completion(false);
   }
 
+  // Statements before the first one split again are unchanged, and so are their markers.
+  size_t from = d->_statement_markers_from.exchange(std::string::npos);
+  if (from == std::string::npos)
+    return nullptr;
+
+  size_t first_line = d->codeEditor->line_from_position(from);
+  ssize_t line_start, line_end;
+  if (!d->codeEditor->get_range_of_line((ssize_t)first_line, line_start, line_end)) // Returns true on failure.
+    from = (size_t)line_start;
+
   std::set<size_t> removal_candidates;
   std::set<size_t> insert_candidates;
 
   std::set<size_t> lines;
-  for (auto &range : d->_statementRanges)
-    lines.insert(d->codeEditor->line_from_position(range.start));
+  {
+    base::RecMutexLock lock(d->_sql_statement_borders_mutex);
+    std::vector<StatementRange>::const_iterator range =
+      std::lower_bound(d->_statementRanges.begin(), d->_statementRanges.end(), from,
+                       [](const StatementRange &range, size_t position) { return range.start < position; });
+    for (; range != d->_statementRanges.end(); ++range)
+      lines.insert(d->codeEditor->line_from_position(range->start));
+  }
 
-  std::set_difference(lines.begin(), lines.end(), d->_statement_marker_lines.begin(), d->_statement_marker_lines.end(),
+  std::set<size_t>::iterator old_lines = d->_statement_marker_lines.lower_bound(first_line);
+  std::set_difference(lines.begin(), lines.end(), old_lines, d->_statement_marker_lines.end(),
                       inserter(insert_candidates, insert_candidates.begin()));
 
-  std::set_difference(d->_statement_marker_lines.begin(), d->_statement_marker_lines.end(), lines.begin(), lines.end(),
+  std::set_difference(old_lines, d->_statement_marker_lines.end(), lines.begin(), lines.end(),
                       inserter(removal_candidates, removal_candidates.begin()));
 
-  d->_statement_marker_lines.swap(lines);
+  d->_statement_marker_lines.erase(old_lines, d->_statement_marker_lines.end());
+  d->_statement_marker_lines.insert(lines.begin(), lines.end());
 
   d->_updating_statement_markers = true;
   for (std::set<size_t>::const_iterator iterator = removal_candidates.begin(); iterator != removal_candidates.end();
@@ -867,8 +1216,8 @@ void *MySQLEditor::update_error_markers() {
   std::set<size_t> insert_candidates;
 
   std::set<size_t> lines;
+  std::set<std::pair<size_t, size_t>> ranges;
 
-  d->codeEditor->remove_indicator(mforms::RangeIndicatorError, 0, d->codeEditor->text_length());
   if (d->_recognition_errors.size() > 0) {
     if (d->_recognition_errors.size() == 1)
       d->codeEditor->set_status_text(_("1 error found"));
@@ -876,13 +1225,33 @@ void *MySQLEditor::update_error_markers() {
       d->codeEditor->set_status_text(base::strfmt(_("%lu errors found"), (unsigned long)d->_recognition_errors.size()));
 
     for (size_t i = 0; i < d->_recognition_errors.size(); ++i) {
-      d->codeEditor->show_indicator(mforms::RangeIndicatorError, d->_recognition_errors[i].charOffset,
-                                   d->_recognition_errors[i].length);
+      ranges.insert({ d->_recognition_errors[i].charOffset, d->_recognition_errors[i].length });
       lines.insert(d->codeEditor->line_from_position(d->_recognition_errors[i].charOffset));
     }
   } else
     d->codeEditor->set_status_text("");
 
+  // Only indicators that changed are touched, plus everything in the text edited since the last update.
+  size_t text_length = d->codeEditor->text_length();
+  for (auto &range : d->_error_indicator_ranges) {
+    if (ranges.count(range) == 0 && range.first < text_length)
+      d->codeEditor->remove_indicator(mforms::RangeIndicatorError, range.first,
+                                      std::min(range.second, text_length - range.first));
+  }
+  size_t dirty_start = d->_indicators_dirty_start;
+  size_t dirty_end = std::min(d->_indicators_dirty_end, text_length);
+  if (dirty_start < dirty_end)
+    d->codeEditor->remove_indicator(mforms::RangeIndicatorError, dirty_start, dirty_end - dirty_start);
+
+  for (auto &range : ranges) {
+    bool dirty = dirty_start != std::string::npos && range.first <= dirty_end && range.first + range.second >= dirty_start;
+    if (dirty || d->_error_indicator_ranges.count(range) == 0)
+      d->codeEditor->show_indicator(mforms::RangeIndicatorError, range.first, range.second);
+  }
+  d->_error_indicator_ranges.swap(ranges);
+  d->_indicators_dirty_start = std::string::npos;
+  d->_indicators_dirty_end = 0;
+
   std::set_difference(lines.begin(), lines.end(), d->_error_marker_lines.begin(), d->_error_marker_lines.end(),
                       inserter(insert_candidates, insert_candidates.begin()));
 
@@ -1228,11 +1597,57 @@ void MySQLEditor::show_auto_completion(bool auto_choose_single) {
     caretOffset = g_utf8_pointer_to_offset(line_text.c_str(), line_text.c_str() + caretOffset);
   }
 
-  d->codeCompletionCandidates = d->services->getCodeCompletionCandidates(
-    d->autocompletionContext, { caretOffset, caretLine }, statement, d->currentSchema, make_keywords_uppercase(),
-    d->symbolTable);
+  // Collecting the candidates can take a while (large statements or schemas), so do it in a background thread
+  // with an own parser context and let the popup come up when done. Typing on cancels this run.
+  ThreadedTimer::get()->remove_task(d->_completion_task_id);
+  size_t generation = ++d->_completion_generation;
+  MySQLParserContext::Ref context = d->autocompletionContext->clone();
+  std::pair<size_t, size_t> caret = { caretOffset, caretLine };
+  std::string schema = d->currentSchema;
+  bool uppercaseKeywords = make_keywords_uppercase();
+  std::string writtenPart = getWrittenPart(caretPosition);
+
+  d->_completion_task_id = ThreadedTimer::get()->add_task(TimerTimeSpan, 0.01, true, [=](int) {
+    base::RecMutexLock lock(d->_completion_mutex);
+    if (generation != d->_completion_generation)
+      return false;
+
+    std::vector<std::pair<int, std::string>> candidates =
+      d->services->getCodeCompletionCandidates(context, caret, statement, schema, uppercaseKeywords, d->symbolTable);
 
-  update_auto_completion(getWrittenPart(caretPosition));
+    if (generation == d->_completion_generation)
+      bec::GRTManager::get()->run_once_when_idle(
+        this, std::bind(&MySQLEditor::auto_completion_candidates_ready, this, generation, candidates, writtenPart));
+    return false;
+  });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Called in the main thread when the background thread started in show_auto_completion is done.
+ */
+void MySQLEditor::auto_completion_candidates_ready(size_t generation,
+                                                   std::vector<std::pair<int, std::string>> const &candidates,
+                                                   std::string const &writtenPart) {
+  if (generation != d->_completion_generation)
+    return;
+
+  d->_completion_task_id = -1;
+  d->codeCompletionCandidates = candidates;
+  d->codeCompletionPrefix = writtenPart;
+  update_auto_completion(getWrittenPart(d->codeEditor->get_caret_pos()));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * To be called when the symbols used for auto completion changed (e.g. because schema objects were loaded).
+ * Refreshes an open auto completion popup with the new names.
+ */
+void MySQLEditor::auto_completion_symbols_changed() {
+  if (code_completion_enabled() && d->codeEditor->auto_completion_active())
+    show_auto_completion(false);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -1248,6 +1663,21 @@ std::vector<std::pair<int, std::string>> MySQLEditor::update_auto_completion(con
 
   // Remove all entries that don't start with the typed text before showing the
   // list.
+  // Object names were only collected for the text written at that time. If that got shorter (e.g. by
+  // backspace) we would miss entries, so close the popup instead. It comes back with the next typed char.
+  if (!d->codeCompletionPrefix.empty()) {
+    gchar *typed = g_utf8_casefold(typed_part.c_str(), -1);
+    gchar *collected = g_utf8_casefold(d->codeCompletionPrefix.c_str(), -1);
+    bool outdated = !g_str_has_prefix(typed, collected);
+    g_free(collected);
+    g_free(typed);
+    if (outdated) {
+      logDebug2("Auto completion candidates are outdated - hiding popup\n");
+      d->codeEditor->auto_completion_cancel();
+      return {};
+    }
+  }
+
   if (!typed_part.empty()) {
     gchar *prefix = g_utf8_casefold(typed_part.c_str(), -1);
 
@@ -1302,6 +1732,7 @@ std::vector<std::pair<int, std::string>> MySQLEditor::update_auto_completion(con
 void MySQLEditor::cancel_auto_completion() {
   // Make sure a pending timed autocompletion won't kick in after we cancel it.
   d->_last_typed_char = 0;
+  ++d->_completion_generation;
   d->codeEditor->auto_completion_cancel();
 }
 
@@ -1393,6 +1824,11 @@ void MySQLEditor::stop_processing() {
   ThreadedTimer::get()->remove_task(d->_current_work_timer_id);
   d->_current_work_timer_id = -1;
 
+  // Candidates being collected refer to the old text.
+  ThreadedTimer::get()->remove_task(d->_completion_task_id);
+  d->_completion_task_id = -1;
+  ++d->_completion_generation;
+
   if (d->_current_delay_timer != nullptr) {
     bec::GRTManager::get()->cancel_timer(d->_current_delay_timer);
     d->_current_delay_timer = nullptr;
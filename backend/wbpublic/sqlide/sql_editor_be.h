@@ -79,6 +79,10 @@ public:
   typedef std::shared_ptr<MySQLEditor> Ref;
   typedef std::weak_ptr<MySQLEditor> Ptr;
 
+  // Tables referenced in the editor text as (schema, table). The schema is empty if the name was not qualified.
+  typedef std::set<std::pair<std::string, std::string>> TableReferences;
+  static const size_t MAX_TABLE_REFERENCES = 100;
+
   static Ref create(parsers::MySQLParserContext::Ref syntaxCheckContext,
                     parsers::MySQLParserContext::Ref autocompleteContext,
                     std::vector<parsers::SymbolTable *> const &globalSymbols,
@@ -127,12 +131,14 @@ public:
   void show_auto_completion(bool auto_choose_single);
   std::vector<std::pair<int, std::string>> update_auto_completion(const std::string &typed_part);
   void cancel_auto_completion();
+  void auto_completion_symbols_changed();
 
   std::string selected_text();
   void set_selected_text(const std::string &new_text);
   void insert_text(const std::string &new_text);
 
   boost::signals2::signal<void()> *text_change_signal();
+  boost::signals2::signal<void(const TableReferences &)> *table_references_signal();
 
   std::string sql_mode();
   void set_sql_mode(const std::string &value);
@@ -160,6 +166,8 @@ private:
 
   void setup_auto_completion();
   void *run_code_completion();
+  void auto_completion_candidates_ready(size_t generation, std::vector<std::pair<int, std::string>> const &candidates,
+                                        std::string const &writtenPart);
 
   std::string getWrittenPart(size_t position);
 
@@ -180,6 +188,7 @@ private:
 
   void *splitting_done();
   void *update_error_markers();
+  void *table_references_changed(const TableReferences &references);
 
   bool code_completion_enabled();
   bool auto_start_code_completion();
@@ -26,7 +26,22 @@
 #ifndef _WIN32
 #include <sys/time.h>
 #endif
+#include <cstdint>
 #include <locale>
+#include <stdexcept>
+#include <string.h>
+#include <zlib.h>
+
+#define DATA_SWAP_PACK_THRESHOLD (16 * 1024)
+
+// Tag of the packed values, followed by the unpacked size (8 bytes, little endian) and the zlib stream.
+static const unsigned char DATA_SWAP_PACK_TAG[] = {0, 'W', 'B', 'Z'};
+static const size_t DATA_SWAP_PACK_HEADER_SIZE = sizeof(DATA_SWAP_PACK_TAG) + 8;
+
+static bool is_packed_data_swap_value(const sqlite::blob_t &data) {
+  return data.size() >= DATA_SWAP_PACK_HEADER_SIZE &&
+         memcmp(&data[0], DATA_SWAP_PACK_TAG, sizeof(DATA_SWAP_PACK_TAG)) == 0;
+}
 
 namespace sqlide {
 
@@ -60,6 +75,55 @@ namespace sqlide {
     return boost::apply_visitor(is_var_type_eq_to, value, blob_value);
   }
 
+  /*
+   * Blobs that start with the tag are always packed, even when they are small or don't compress, so that every
+   * tagged value read back is a packed one.
+   */
+  sqlite::variant_t pack_data_swap_value(const sqlite::variant_t &value) {
+    const sqlite::blob_ref_t *blob = boost::get<sqlite::blob_ref_t>(&value);
+    if (!blob || !*blob)
+      return value;
+
+    const sqlite::blob_t &data = **blob;
+    bool tagged = is_packed_data_swap_value(data);
+    if ((data.size() < DATA_SWAP_PACK_THRESHOLD && !tagged) || (uLong)data.size() != data.size())
+      return value;
+
+    uLongf packed_size = compressBound((uLong)data.size());
+    sqlite::blob_ref_t packed(new sqlite::blob_t(DATA_SWAP_PACK_HEADER_SIZE + packed_size));
+    if (compress2(&(*packed)[DATA_SWAP_PACK_HEADER_SIZE], &packed_size, data.empty() ? nullptr : &data[0],
+                  (uLong)data.size(), Z_BEST_SPEED) != Z_OK)
+      throw std::runtime_error("Could not compress a value for the result data cache");
+    if (!tagged && DATA_SWAP_PACK_HEADER_SIZE + packed_size >= data.size())
+      return value;
+
+    memcpy(&(*packed)[0], DATA_SWAP_PACK_TAG, sizeof(DATA_SWAP_PACK_TAG));
+    std::uint64_t size = data.size();
+    for (size_t i = 0; i < 8; ++i)
+      (*packed)[sizeof(DATA_SWAP_PACK_TAG) + i] = (unsigned char)(size >> (8 * i));
+    packed->resize(DATA_SWAP_PACK_HEADER_SIZE + packed_size);
+    return packed;
+  }
+
+  void unpack_data_swap_value(sqlite::variant_t &value) {
+    sqlite::blob_ref_t *blob = boost::get<sqlite::blob_ref_t>(&value);
+    if (!blob || !*blob || !is_packed_data_swap_value(**blob))
+      return;
+
+    const sqlite::blob_t &packed = **blob;
+    std::uint64_t size = 0;
+    for (size_t i = 0; i < 8; ++i)
+      size |= (std::uint64_t)packed[sizeof(DATA_SWAP_PACK_TAG) + i] << (8 * i);
+
+    sqlite::blob_ref_t data(new sqlite::blob_t((size_t)size));
+    uLongf data_size = (uLongf)size;
+    if (uncompress(data->empty() ? nullptr : &(*data)[0], &data_size, &packed[DATA_SWAP_PACK_HEADER_SIZE],
+                   (uLong)(packed.size() - DATA_SWAP_PACK_HEADER_SIZE)) != Z_OK ||
+        data_size != size)
+      throw std::runtime_error("Corrupted value in the result data cache");
+    value = data;
+  }
+
   void optimize_sqlite_connection_for_speed(sqlite::connection *conn) {
     //! sqlite::execute(*conn, "pragma locking_mode = exclusive", true);
     sqlite::execute(*conn, "pragma fsync = 0", true);
@@ -25,6 +25,7 @@
 #define _SQLIDE_GENERICS_H_
 
 #include "wbpublic_public_interface.h"
+#include "sqlide/packed_data.h"
 #include <sqlite/result.hpp>
 #include <sqlite/connection.hpp>
 #include <limits>
@@ -365,6 +366,11 @@ namespace sqlide {
   WBPUBLICBACKEND_PUBLIC_FUNC bool is_var_unknown(const sqlite::variant_t &value);
   WBPUBLICBACKEND_PUBLIC_FUNC bool is_var_blob(const sqlite::variant_t &value);
 
+  // Large blob values are kept compressed in the data swap db. Values are packed before they are written to its
+  // data tables and unpacked after they are read, other values pass unchanged.
+  WBPUBLICBACKEND_PUBLIC_FUNC sqlite::variant_t pack_data_swap_value(const sqlite::variant_t &value);
+  WBPUBLICBACKEND_PUBLIC_FUNC void unpack_data_swap_value(sqlite::variant_t &value);
+
   WBPUBLICBACKEND_PUBLIC_FUNC void optimize_sqlite_connection_for_speed(sqlite::connection *conn);
 
   class WBPUBLICBACKEND_PUBLIC_FUNC Sqlite_transaction_guarder {
@@ -382,7 +388,7 @@ namespace sqlide {
 
 typedef size_t RowId;
 typedef size_t ColumnId;
-typedef std::vector<sqlite::variant_t> Data;
+typedef Packed_data Data;
 
 template <typename C>
 inline void reinit(C &c) {
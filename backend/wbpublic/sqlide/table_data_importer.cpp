@@ -0,0 +1,788 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "table_data_importer.h"
+#include "base/file_utilities.h"
+#include "base/log.h"
+#include "base/string_utilities.h"
+#include "cppdbc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <set>
+#include <stdexcept>
+
+DEFAULT_LOG_DOMAIN("TableDataImporter")
+
+#define IMPORT_BUFFER_SIZE (1024 * 1024)
+#define IMPORT_TIME_CHECK_INTERVAL 256 // rows
+#define IMPORT_LOGGED_ERRORS 100
+
+// Client errors for a lost connection, retrying single rows makes no sense after those.
+#define CR_SERVER_GONE_ERROR 2006
+#define CR_SERVER_LOST 2013
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Buffered reading of the import file, with the absolute offset of every byte so an import can be continued from
+ * the last complete row.
+ */
+class TableDataInput {
+public:
+  TableDataInput(const std::string &path) : _file(path, "rb"), _start(0), _length(0), _offset(0) {
+    _buffer.resize(IMPORT_BUFFER_SIZE);
+  }
+
+  int peek() {
+    if (_offset == _length && !fill())
+      return EOF;
+    return (unsigned char)_buffer[_offset];
+  }
+
+  int get() {
+    int c = peek();
+    if (c != EOF)
+      ++_offset;
+    return c;
+  }
+
+  int64_t tell() const {
+    return _start + (int64_t)_offset;
+  }
+
+  void seek(int64_t position) {
+    if (file_seek(position, SEEK_SET) != 0)
+      throw base::file_error("Cannot seek in \"" + _file.getPath() + "\"", errno);
+    _start = position;
+    _length = 0;
+    _offset = 0;
+  }
+
+  int64_t size() {
+    int64_t current = file_tell();
+    file_seek(0, SEEK_END);
+    int64_t size = file_tell();
+    file_seek(current, SEEK_SET);
+    return size;
+  }
+
+private:
+  base::FileHandle _file;
+  std::string _buffer;
+  int64_t _start; // File offset of the buffer.
+  size_t _length;
+  size_t _offset;
+
+  bool fill() {
+    _start += (int64_t)_length;
+    _offset = 0;
+    _length = fread(&_buffer[0], 1, _buffer.size(), _file.file());
+    if (_length == 0 && ferror(_file.file()))
+      throw base::file_error("Error reading \"" + _file.getPath() + "\"", errno);
+    return _length > 0;
+  }
+
+  int file_seek(int64_t offset, int whence) {
+#ifdef _MSC_VER
+    return _fseeki64(_file.file(), offset, whence);
+#else
+    return fseeko(_file.file(), (off_t)offset, whence);
+#endif
+  }
+
+  int64_t file_tell() {
+#ifdef _MSC_VER
+    return _ftelli64(_file.file());
+#else
+    return ftello(_file.file());
+#endif
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Kinds of JSON values, CSV fields are all strings.
+enum ValueKind { StringValue, NumberValue, TrueValue, FalseValue, NullValue, NestedValue };
+
+static void append_quoted(std::string &out, const char *data, size_t length) {
+  size_t start = out.size();
+  out.resize(start + 2 * length + 2);
+  out[start] = '\'';
+  size_t escaped = base::escape_sql_buffer(data, length, &out[start + 1]);
+  out[start + 1 + escaped] = '\'';
+  out.resize(start + escaped + 2);
+}
+
+static void append_quoted(std::string &out, const std::string &value) {
+  append_quoted(out, value.data(), value.size());
+}
+
+static std::runtime_error json_error(TableDataInput &input, const char *what) {
+  return std::runtime_error(base::strfmt("Invalid JSON data at offset %lld: %s", (long long)input.tell(), what));
+}
+
+static int skip_json_whitespace(TableDataInput &input) {
+  int c = input.peek();
+  while (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+    input.get();
+    c = input.peek();
+  }
+  return c;
+}
+
+static void append_utf8(std::string &out, unsigned int code) {
+  if (code < 0x80)
+    out.push_back((char)code);
+  else if (code < 0x800) {
+    out.push_back((char)(0xC0 | (code >> 6)));
+    out.push_back((char)(0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    out.push_back((char)(0xE0 | (code >> 12)));
+    out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (code & 0x3F)));
+  } else {
+    out.push_back((char)(0xF0 | (code >> 18)));
+    out.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+    out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (code & 0x3F)));
+  }
+}
+
+static unsigned int read_json_hex4(TableDataInput &input) {
+  unsigned int code = 0;
+  for (int i = 0; i < 4; ++i) {
+    int c = input.get();
+    code <<= 4;
+    if (c >= '0' && c <= '9')
+      code |= c - '0';
+    else if (c >= 'a' && c <= 'f')
+      code |= c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      code |= c - 'A' + 10;
+    else
+      throw json_error(input, "bad \\u escape");
+  }
+  return code;
+}
+
+// Reads a string, the opening quote was already consumed. The value is stored unescaped.
+static void read_json_string(TableDataInput &input, std::string &value) {
+  for (;;) {
+    int c = input.get();
+    if (c == EOF)
+      throw json_error(input, "unterminated string");
+    if (c == '"')
+      return;
+    if (c != '\\') {
+      value.push_back((char)c);
+      continue;
+    }
+
+    c = input.get();
+    switch (c) {
+      case 'b':
+        value.push_back('\b');
+        break;
+      case 'f':
+        value.push_back('\f');
+        break;
+      case 'n':
+        value.push_back('\n');
+        break;
+      case 'r':
+        value.push_back('\r');
+        break;
+      case 't':
+        value.push_back('\t');
+        break;
+      case 'u': {
+        unsigned int code = read_json_hex4(input);
+        if (code >= 0xD800 && code < 0xDC00 && input.peek() == '\\') {
+          input.get();
+          if (input.get() != 'u')
+            throw json_error(input, "bad surrogate pair");
+          unsigned int low = read_json_hex4(input);
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        append_utf8(value, code);
+        break;
+      }
+      case EOF:
+        throw json_error(input, "unterminated string");
+      default:
+        value.push_back((char)c);
+        break;
+    }
+  }
+}
+
+// Copies an object or array as it is, for JSON and geometry columns.
+static void copy_json_nested(TableDataInput &input, std::string &value) {
+  int depth = 0;
+  do {
+    int c = input.get();
+    if (c == EOF)
+      throw json_error(input, "unexpected end of data");
+    value.push_back((char)c);
+    if (c == '"') {
+      for (;;) {
+        c = input.get();
+        if (c == EOF)
+          throw json_error(input, "unterminated string");
+        value.push_back((char)c);
+        if (c == '\\') {
+          c = input.get();
+          if (c == EOF)
+            throw json_error(input, "unterminated string");
+          value.push_back((char)c);
+        } else if (c == '"')
+          break;
+      }
+    } else if (c == '{' || c == '[')
+      ++depth;
+    else if (c == '}' || c == ']')
+      --depth;
+  } while (depth > 0);
+}
+
+static ValueKind read_json_value(TableDataInput &input, std::string &value) {
+  value.clear();
+  int c = skip_json_whitespace(input);
+  if (c == '"') {
+    input.get();
+    read_json_string(input, value);
+    return StringValue;
+  }
+  if (c == '{' || c == '[') {
+    copy_json_nested(input, value);
+    return NestedValue;
+  }
+
+  while (c != EOF && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+    value.push_back((char)input.get());
+    c = input.peek();
+  }
+  if (value == "true")
+    return TrueValue;
+  if (value == "false")
+    return FalseValue;
+  if (value == "null")
+    return NullValue;
+  if (value.empty() || value.find_first_not_of("+-0123456789.eE") != std::string::npos)
+    throw json_error(input, "unknown value");
+  return NumberValue;
+}
+
+/**
+ * Adds the SQL for one value to the row, with the same conversions the wizard applied when inserting rows with a
+ * prepared statement.
+ */
+static void append_value(std::string &out, const TableDataImporter::Options &options, const std::string &type,
+                         const std::string &date_format, std::string &value, ValueKind kind, bool json) {
+  switch (kind) {
+    case NullValue:
+      out.append("NULL");
+      return;
+    case TrueValue:
+      out.append("TRUE");
+      return;
+    case FalseValue:
+      out.append("FALSE");
+      return;
+    default:
+      break;
+  }
+
+  if (type == "geometry") {
+    if (json)
+      out.append("ST_GeomFromGeoJSON(");
+    else
+      out.append(options.st_functions ? "ST_GeomFromText(" : "GeomFromText(");
+    append_quoted(out, value);
+    out.push_back(')');
+  } else if (type == "datetime") {
+    out.append("STR_TO_DATE(");
+    append_quoted(out, value);
+    out.push_back(',');
+    append_quoted(out, date_format);
+    out.push_back(')');
+  } else if (type == "double") {
+    if (!options.decimal_separator.empty() && options.decimal_separator != ".")
+      base::replaceStringInplace(value, options.decimal_separator, ".");
+    append_quoted(out, value);
+  } else if (type == "json" && json && kind == StringValue)
+    append_quoted(out, "\"" + base::escape_json_string(value) + "\"");
+  else if ((type == "int" || type == "bigint") && kind == NumberValue)
+    out.append(value);
+  else
+    append_quoted(out, value);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TableDataImporter::Options::Options()
+  : format("csv"),
+    separator(','),
+    quote('"'),
+    has_header(false),
+    decimal_separator("."),
+    date_format("%Y-%m-%d %H:%M:%S"),
+    st_functions(true),
+    max_statement_size(1024 * 1024),
+    max_statement_rows(1000) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TableDataImporter::Options TableDataImporter::options_from_dict(const grt::DictRef &dict) {
+  Options options;
+  options.path = dict.get_string("path");
+  options.format = dict.get_string("format", options.format);
+  std::string separator = dict.get_string("separator", std::string(1, options.separator));
+  options.separator = separator.empty() ? ',' : separator[0];
+  std::string quote = dict.get_string("quote", std::string(1, options.quote));
+  options.quote = quote.empty() ? 0 : quote[0];
+  options.has_header = dict.get_int("hasHeader", 0) != 0;
+  options.table = dict.get_string("table");
+  options.decimal_separator = dict.get_string("decimalSeparator", options.decimal_separator);
+  options.date_format = dict.get_string("dateFormat", options.date_format);
+  options.st_functions = dict.get_int("stFunctions", 1) != 0;
+
+  // Leave some room for the statement overhead of the protocol.
+  ssize_t max_allowed_packet = dict.get_int("maxAllowedPacket", 0);
+  if (max_allowed_packet > 1024)
+    options.max_statement_size = std::min(options.max_statement_size, (size_t)max_allowed_packet - 1024);
+  options.max_statement_rows = (size_t)dict.get_int("maxStatementRows", (ssize_t)options.max_statement_rows);
+
+  grt::BaseListRef columns(grt::BaseListRef::cast_from(dict.get("columns")));
+  if (columns.is_valid()) {
+    for (size_t i = 0; i < columns.count(); ++i) {
+      grt::DictRef entry(grt::DictRef::cast_from(columns[i]));
+      Column column;
+      column.source = entry.get_string("source");
+      column.source_index = (int)entry.get_int("index", 0);
+      column.target = entry.get_string("target");
+      column.type = entry.get_string("type", "text");
+      options.columns.push_back(column);
+    }
+  }
+  return options;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string TableDataImporter::mysql_date_format(const std::string &format) {
+  std::string result;
+  for (size_t i = 0; i < format.size(); ++i) {
+    if (format[i] != '%' || i + 1 == format.size()) {
+      result.push_back(format[i]);
+      continue;
+    }
+
+    char spec = format[++i];
+    result.push_back('%');
+    switch (spec) {
+      case 'M': // minutes
+        result.push_back('i');
+        break;
+      case 'B': // full month name
+        result.push_back('M');
+        break;
+      case 'A': // full weekday name
+        result.push_back('W');
+        break;
+      case 'I': // 12 hour clock
+        result.push_back('h');
+        break;
+      case 'W': // week, starting on Monday
+        result.push_back('u');
+        break;
+      default: // %Y %y %m %d %H %S %p %f %j %b %a %U %% are the same
+        result.push_back(spec);
+        break;
+    }
+  }
+  return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TableDataImporter::TableDataImporter(const Options &options)
+  : _options(options),
+    _input(nullptr),
+    _position(0),
+    _json_state(JSONStart),
+    _skip_header(false),
+    _field_count(0),
+    _rows_imported(0),
+    _rows_failed(0) {
+  if (_options.format != "csv" && _options.format != "json")
+    throw std::invalid_argument("Unsupported import format " + _options.format);
+
+  // A target column can be mapped only once, as with the prepared statement the wizard used before.
+  std::set<std::string> targets;
+  for (size_t i = 0; i < _options.columns.size(); ++i) {
+    if (targets.insert(_options.columns[i].target).second)
+      _columns.push_back(i);
+  }
+  if (_columns.empty())
+    throw std::invalid_argument("No columns to import");
+
+  _insert = "INSERT INTO " + _options.table + " (";
+  for (size_t i = 0; i < _columns.size(); ++i) {
+    if (i > 0)
+      _insert.push_back(',');
+    _insert.append(base::quote_identifier(_options.columns[_columns[i]].target, '`'));
+  }
+  _insert.append(") VALUES ");
+
+  if (_options.format == "json") {
+    for (size_t column : _columns) {
+      const std::string &source = _options.columns[column].source;
+      std::unordered_map<std::string, size_t>::const_iterator field = _sources.find(source);
+      if (field == _sources.end())
+        field = _sources.insert(std::make_pair(source, _sources.size())).first;
+      _source_of.push_back(field->second);
+    }
+    _fields.resize(_sources.size());
+    _present.resize(_sources.size());
+    _kinds.resize(_sources.size());
+  }
+  _date_format = mysql_date_format(_options.date_format);
+
+  _input = new TableDataInput(_options.path);
+  seek(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TableDataImporter::~TableDataImporter() {
+  delete _input;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int64_t TableDataImporter::file_size() const {
+  return _input->size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TableDataImporter::seek(int64_t position) {
+  _input->seek(position);
+  _position = position;
+  _statement.clear();
+  _records.clear();
+
+  if (position > 0) {
+    // Import slices end after a complete row, in JSON files that's inside the top level array.
+    _skip_header = false;
+    _json_state = JSONNextRow;
+    return;
+  }
+
+  _skip_header = _options.has_header;
+  _json_state = JSONStart;
+
+  // Skip an UTF-8 byte order mark.
+  if (_input->peek() == 0xEF) {
+    _input->get();
+    if (_input->get() != 0xBB || _input->get() != 0xBF)
+      _input->seek(0);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool TableDataImporter::import(const Executor &execute, double time_limit) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool csv = _options.format == "csv";
+  size_t rows = 0;
+
+  for (;;) {
+    if (!(csv ? read_csv_row() : read_json_row())) {
+      flush(execute);
+      _position = _input->tell();
+      return true;
+    }
+
+    if (_skip_header)
+      _skip_header = false;
+    else if (csv ? format_csv_record() : format_json_record())
+      add_record(execute);
+
+    if (time_limit > 0 && ++rows % IMPORT_TIME_CHECK_INTERVAL == 0 &&
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= time_limit) {
+      flush(execute);
+      _position = _input->tell();
+      return false;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the next record into _fields, with the rules of Python's csv reader the wizard used before: fields may be
+ * enclosed in the quote character, a doubled quote character stands for one, and lines end with LF, CR or CR LF.
+ * Empty lines are skipped.
+ */
+bool TableDataImporter::read_csv_row() {
+  int c = _input->peek();
+  while (c == '\r' || c == '\n') {
+    _input->get();
+    c = _input->peek();
+  }
+  if (c == EOF)
+    return false;
+
+  const int separator = (unsigned char)_options.separator;
+  const int quote = _options.quote != 0 ? (unsigned char)_options.quote : -2;
+
+  _field_count = 0;
+  for (;;) {
+    if (_field_count == _fields.size())
+      _fields.push_back(std::string());
+    std::string &field = _fields[_field_count++];
+    field.clear();
+
+    bool quoted = false;
+    c = _input->get();
+    if (c == quote) {
+      quoted = true;
+      c = _input->get();
+    }
+
+    for (;;) {
+      if (quoted) {
+        if (c == EOF)
+          break;
+        if (c == quote) {
+          if (_input->peek() != quote)
+            quoted = false;
+          else
+            field.push_back((char)_input->get());
+        } else
+          field.push_back((char)c);
+        c = _input->get();
+        continue;
+      }
+      if (c == separator || c == '\r' || c == '\n' || c == EOF)
+        break;
+      field.push_back((char)c);
+      c = _input->get();
+    }
+
+    if (c == separator)
+      continue;
+    if (c == '\r' && _input->peek() == '\n')
+      _input->get();
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the next object of the top level array into _fields. The file may also hold a single object.
+ */
+bool TableDataImporter::read_json_row() {
+  int c = skip_json_whitespace(*_input);
+  switch (_json_state) {
+    case JSONStart:
+      if (c == '{') {
+        _json_state = JSONDone;
+        break;
+      }
+      if (c != '[')
+        throw json_error(*_input, "expected an array of objects");
+      _input->get();
+      c = skip_json_whitespace(*_input);
+      if (c == ']') {
+        _input->get();
+        _json_state = JSONDone;
+        return false;
+      }
+      _json_state = JSONNextRow;
+      break;
+
+    case JSONNextRow:
+      if (c == EOF)
+        return false;
+      _input->get();
+      if (c == ']') {
+        _json_state = JSONDone;
+        return false;
+      }
+      if (c != ',')
+        throw json_error(*_input, "expected , or ]");
+      c = skip_json_whitespace(*_input);
+      break;
+
+    case JSONDone:
+      return false;
+  }
+
+  if (_input->get() != '{')
+    throw json_error(*_input, "expected an object");
+
+  std::fill(_present.begin(), _present.end(), false);
+  std::string name, skipped;
+  c = skip_json_whitespace(*_input);
+  if (c == '}') {
+    _input->get();
+    return true;
+  }
+
+  for (;;) {
+    if (skip_json_whitespace(*_input) != '"')
+      throw json_error(*_input, "expected a field name");
+    _input->get();
+    name.clear();
+    read_json_string(*_input, name);
+    if (skip_json_whitespace(*_input) != ':')
+      throw json_error(*_input, "expected :");
+    _input->get();
+
+    std::unordered_map<std::string, size_t>::const_iterator field = _sources.find(name);
+    if (field != _sources.end()) {
+      _kinds[field->second] = read_json_value(*_input, _fields[field->second]);
+      _present[field->second] = true;
+    } else
+      read_json_value(*_input, skipped);
+
+    c = skip_json_whitespace(*_input);
+    _input->get();
+    if (c == '}')
+      return true;
+    if (c != ',')
+      throw json_error(*_input, "expected , or }");
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool TableDataImporter::format_csv_record() {
+  _record = "(";
+  for (size_t i = 0; i < _columns.size(); ++i) {
+    const Column &column = _options.columns[_columns[i]];
+    if (column.source_index < 0 || (size_t)column.source_index >= _field_count) {
+      row_failed(base::strfmt("Row ending at offset %lld has no field %i", (long long)_input->tell(),
+                              column.source_index + 1));
+      return false;
+    }
+    if (i > 0)
+      _record.push_back(',');
+    append_value(_record, _options, column.type, _date_format, _fields[column.source_index], StringValue, false);
+  }
+  _record.push_back(')');
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool TableDataImporter::format_json_record() {
+  _record = "(";
+  for (size_t i = 0; i < _columns.size(); ++i) {
+    const Column &column = _options.columns[_columns[i]];
+    size_t field = _source_of[i];
+    if (!_present[field]) {
+      row_failed(base::strfmt("Row ending at offset %lld has no field %s", (long long)_input->tell(),
+                              column.source.c_str()));
+      return false;
+    }
+    if (i > 0)
+      _record.push_back(',');
+    append_value(_record, _options, column.type, _date_format, _fields[field], (ValueKind)_kinds[field], true);
+  }
+  _record.push_back(')');
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Adds the formatted row to the pending INSERT, which is sent when it would grow past the size or row limit.
+ */
+void TableDataImporter::add_record(const Executor &execute) {
+  if (!_records.empty() && (_statement.size() + _record.size() + 1 > _options.max_statement_size ||
+                            _records.size() >= _options.max_statement_rows))
+    flush(execute);
+
+  if (_records.empty())
+    _statement = _insert;
+  else
+    _statement.push_back(',');
+  _records.push_back(_statement.size());
+  _statement.append(_record);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Sends the pending INSERT. If the server rejects it, its rows are sent one by one, so only the bad rows are lost,
+ * as when the rows were inserted one at a time.
+ */
+void TableDataImporter::flush(const Executor &execute) {
+  if (_records.empty())
+    return;
+
+  try {
+    execute(_statement);
+    _rows_imported += _records.size();
+  } catch (sql::SQLException &exc) {
+    if (exc.getErrorCode() == CR_SERVER_GONE_ERROR || exc.getErrorCode() == CR_SERVER_LOST)
+      throw;
+
+    if (_records.size() == 1)
+      row_failed(exc.what());
+    else {
+      for (size_t i = 0; i < _records.size(); ++i) {
+        size_t end = i + 1 < _records.size() ? _records[i + 1] - 1 : _statement.size();
+        try {
+          execute(_insert + _statement.substr(_records[i], end - _records[i]));
+          ++_rows_imported;
+        } catch (sql::SQLException &row_exc) {
+          if (row_exc.getErrorCode() == CR_SERVER_GONE_ERROR || row_exc.getErrorCode() == CR_SERVER_LOST)
+            throw;
+          row_failed(row_exc.what());
+        }
+      }
+    }
+  }
+  _statement.clear();
+  _records.clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TableDataImporter::row_failed(const std::string &error) {
+  ++_rows_failed;
+  _last_error = error;
+  if (_rows_failed <= IMPORT_LOGGED_ERRORS)
+    logError("Row import failed with error: %s\n", error.c_str());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
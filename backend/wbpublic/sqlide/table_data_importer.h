@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _TABLE_DATA_IMPORTER_H_
+#define _TABLE_DATA_IMPORTER_H_
+
+#include "wbpublic_public_interface.h"
+#include "grt.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TableDataInput;
+
+/**
+ * Imports a CSV or JSON file into a table. The file is read with streaming tokenizers and the rows are sent as
+ * multi-row INSERT statements, so neither the file nor its rows are ever held in memory as a whole.
+ *
+ * The import runs in slices: import() returns after a given time and a later call, even from another importer
+ * created with the same options and seek()ed to position(), continues with the next row. This keeps progress
+ * reporting and cancelling with the caller, which is the Table Data Import wizard.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC TableDataImporter {
+public:
+  struct Column {
+    std::string source; // Field name in JSON files.
+    int source_index;   // Field number in CSV files.
+    std::string target;
+    std::string type; // Type from the import mapping: text, int, bigint, double, datetime, json, geometry...
+
+    Column() : source_index(0) {
+    }
+  };
+
+  struct Options {
+    std::string path;
+    std::string format; // csv or json
+    char separator;
+    char quote; // 0 if fields are not quoted
+    bool has_header;
+    std::string table; // Quoted and qualified target table.
+    std::vector<Column> columns;
+    std::string decimal_separator;
+    std::string date_format; // strftime style, as entered in the wizard.
+    bool st_functions;       // Whether the server has the ST_ spatial functions (5.7.5+).
+    size_t max_statement_size;
+    size_t max_statement_rows;
+
+    Options();
+  };
+
+  // Runs a statement, failures are reported with sql::SQLException.
+  typedef std::function<void(const std::string &)> Executor;
+
+  TableDataImporter(const Options &options);
+  ~TableDataImporter();
+
+  // Reads the options as the wizard passes them to db.query.Editor.importTableData().
+  static Options options_from_dict(const grt::DictRef &dict);
+  // Translates a strftime style date format into the STR_TO_DATE() one.
+  static std::string mysql_date_format(const std::string &format);
+
+  // Continues an import that stopped at the given position().
+  void seek(int64_t position);
+
+  // Imports rows until the end of the file or until time_limit seconds passed (0 for no limit).
+  // Returns true when the whole file was imported.
+  bool import(const Executor &execute, double time_limit = 0);
+
+  // Offset of the first row not imported yet.
+  int64_t position() const {
+    return _position;
+  }
+  int64_t file_size() const;
+  size_t rows_imported() const {
+    return _rows_imported;
+  }
+  size_t rows_failed() const {
+    return _rows_failed;
+  }
+  const std::string &last_error() const {
+    return _last_error;
+  }
+
+private:
+  enum JSONState { JSONStart, JSONNextRow, JSONDone };
+
+  Options _options;
+  TableDataInput *_input;
+  int64_t _position;
+  JSONState _json_state;
+  bool _skip_header;
+
+  std::vector<size_t> _columns; // The columns of _options used, one per target column.
+
+  // Fields of the current row. In CSV files all of them, in JSON files one per field name used by _columns.
+  std::vector<std::string> _fields;
+  size_t _field_count;
+  std::unordered_map<std::string, size_t> _sources; // JSON field name to its index in _fields.
+  std::vector<size_t> _source_of;                   // Index in _fields for each of _columns (JSON only).
+  std::vector<bool> _present;                       // Which JSON fields the current row has.
+  std::vector<int> _kinds;                          // JSON value kind of each field.
+  std::string _date_format;
+
+  std::string _insert; // INSERT INTO ... VALUES, the start of every statement.
+  std::string _statement;
+  std::vector<size_t> _records; // Start of each row in _statement.
+  std::string _record;
+
+  size_t _rows_imported;
+  size_t _rows_failed;
+  std::string _last_error;
+
+  bool read_csv_row();
+  bool read_json_row();
+  bool format_csv_record();
+  bool format_json_record();
+  void add_record(const Executor &execute);
+  void flush(const Executor &execute);
+  void row_failed(const std::string &error);
+};
+
+#endif /* _TABLE_DATA_IMPORTER_H_ */
@@ -24,33 +24,27 @@
 #include "table_inserts_loader_be.h"
 #include "recordset_table_inserts_storage.h"
 #include "recordset_be.h"
+#include "sqlide_generics_private.h"
+#include "grtsqlparser/sql_facade.h"
+#include "base/string_utilities.h"
+
+#include <sqlite/command.hpp>
+#include <map>
 
 using namespace grt;
 
 TableInsertsLoader::TableInsertsLoader() {
 }
 
+/**
+ * Rows are written to the inserts storage of the table as the loader recognizes them, instead of loading the whole
+ * script into a recordset first and generating inserts from it.
+ */
 void TableInsertsLoader::process_table(db_TableRef table, const std::string &inserts_script) //!
 {
   if (!table.is_valid() || inserts_script.empty())
     return;
 
-  Recordset_sql_storage::Ref input_storage = Recordset_sql_storage::create();
-  input_storage->sql_script(inserts_script);
-  input_storage->schema_name(table->owner()->name());
-  input_storage->table_name(table->name());
-  {
-    Sql_inserts_loader::Strings affective_columns;
-    affective_columns.reserve(table->columns().count());
-    GRTLIST_FOREACH(db_Column, table->columns(), col)
-    affective_columns.push_back((*col)->name());
-    input_storage->affective_columns(affective_columns);
-  }
-
-  Recordset::Ref rs = Recordset::create();
-  rs->data_storage(input_storage);
-  rs->reset();
-
   Recordset_table_inserts_storage::Ref output_storage = Recordset_table_inserts_storage::create();
   output_storage->table(table);
   // provoke creation of underlying table
@@ -58,5 +52,58 @@ void TableInsertsLoader::process_table(db_TableRef table, const std::string &ins
     Recordset::Ref rs = Recordset::create();
     output_storage->unserialize(rs);
   }
-  output_storage->serialize(rs);
+
+  // The storage table and its columns are named after the object ids.
+  const std::string schema_name = table->owner()->name();
+  const std::string table_name = table->name();
+  std::map<std::string, size_t> column_index;
+  std::string col_names;
+  std::string placeholders;
+  GRTLIST_FOREACH(db_Column, table->columns(), col) {
+    column_index.insert(std::make_pair(*(*col)->name(), column_index.size()));
+    col_names += base::strfmt("%s`%s`", col_names.empty() ? "" : ", ", (*col)->id().c_str());
+    placeholders += placeholders.empty() ? "?" : ", ?";
+  }
+  if (column_index.empty())
+    return;
+
+  sqlite::connection conn(output_storage->db_path());
+  sqlide::optimize_sqlite_connection_for_speed(&conn);
+  sqlide::Sqlite_transaction_guarder transaction_guarder(&conn);
+  sqlite::command insert_command(conn, base::strfmt("insert into `%s` (%s) values (%s)", table->id().c_str(),
+                                                    col_names.c_str(), placeholders.c_str()));
+  Recordset_data_storage::Var_vector row_values;
+
+  SqlFacade::Ref sql_facade = SqlFacade::instance_for_rdbms_name("Mysql");
+  Sql_inserts_loader::Ref loader = sql_facade->sqlInsertsLoader();
+  loader->process_insert_cb([&](const std::string &sql, const std::pair<std::string, std::string> &schema_table,
+                                const Sql_inserts_loader::Strings &fields_names,
+                                const Sql_inserts_loader::Strings &fields_values,
+                                const std::vector<bool> &null_fields) {
+    if ((schema_table.first != schema_name) || (schema_table.second != table_name)) {
+      grt::GRT::get()->send_error("Irrelevant insert statement (skipped): " + sql);
+      return;
+    }
+    if (fields_names.size() != fields_values.size()) {
+      grt::GRT::get()->send_error("Invalid insert statement: " + sql);
+      return;
+    }
+
+    // fields missing from the statement are stored as NULL, fields the table doesn't have are ignored
+    row_values.assign(column_index.size(), sqlite::null_t());
+    for (size_t n = 0; n < fields_names.size(); ++n) {
+      std::map<std::string, size_t>::const_iterator i = column_index.find(fields_names[n]);
+      if (i != column_index.end() && !null_fields[n])
+        row_values[i->second] = fields_values[n];
+    }
+
+    insert_command.clear();
+    sqlide::BindSqlCommandVar bind_sql_command_var(&insert_command);
+    for (const sqlite::variant_t &value : row_values)
+      boost::apply_visitor(bind_sql_command_var, value);
+    insert_command.emit();
+  });
+  loader->load(inserts_script, schema_name);
+
+  transaction_guarder.commit();
 }
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/file_utilities.h"
+#include "wb_helpers.h"
+
+#include "sqlide/query_stats_cache.h"
+
+BEGIN_TEST_DATA_CLASS(query_stats_cache)
+public:
+std::string cache_dir;
+TEST_DATA_CONSTRUCTOR(query_stats_cache) {
+  cache_dir = base::makePath(g_get_tmp_dir(), "query_stats_test");
+  base::create_directory(cache_dir, 0700);
+  base::remove(base::makePath(cache_dir, "test.query_stats"));
+}
+END_TEST_DATA_CLASS
+
+TEST_MODULE(query_stats_cache, "Query statistics cache");
+
+// Literals, comments and white space don't change the digest text.
+TEST_FUNCTION(1) {
+  ensure_equals("literals", QueryStatsCache::digest_text("select * from t1 where a = 10 and b='x''y' -- end\n"),
+                std::string("select * from t1 where a = ? and b=?"));
+  ensure_equals("comment and list", QueryStatsCache::digest_text("SELECT  *\n FROM t /* x */ WHERE id IN (1, 2,3)"),
+                std::string("SELECT * FROM t WHERE id IN (...)"));
+  ensure_equals("rows", QueryStatsCache::digest_text("insert into t (a, b) values (1, 'a'), (2, 'b'), (3, 'c')"),
+                std::string("insert into t (a, b) values (...)"));
+  ensure_equals("identifiers", QueryStatsCache::digest_text("select `col 1`, x2 from t limit 10"),
+                std::string("select `col 1`, x2 from t limit ?"));
+  ensure_equals("same digest", QueryStatsCache::digest(QueryStatsCache::digest_text("select 1")),
+                QueryStatsCache::digest(QueryStatsCache::digest_text("select   2")));
+}
+
+// Runs of the same statement add up and are ranked by the requested order.
+TEST_FUNCTION(2) {
+  QueryStatsCache cache("test", cache_dir);
+
+  std::map<std::string, std::int64_t> stats;
+  stats["TIMER_WAIT"] = 3000000000000LL;
+  stats["ROWS_EXAMINED"] = 10;
+  cache.add("select * from a where id = 1", stats);
+  stats["TIMER_WAIT"] = 1000000000000LL;
+  cache.add("select * from a where id = 2", stats);
+
+  stats["TIMER_WAIT"] = 2500000000000LL;
+  stats["ROWS_EXAMINED"] = 5000;
+  stats["CREATED_TMP_DISK_TABLES"] = 1;
+  cache.add("select * from b", stats);
+
+  std::vector<QueryStatsCache::Entry> entries = cache.top("total", 10);
+  ensure_equals("digests", entries.size(), 2U);
+  ensure_equals("slowest in total", entries[0].statement, std::string("select * from a where id = ?"));
+  ensure_equals("runs", entries[0].exec_count, 2);
+  ensure_equals("total time", entries[0].total_time, 4000000000000LL);
+  ensure_equals("max time", entries[0].max_time, 3000000000000LL);
+  ensure_equals("rows examined", entries[0].rows_examined, 20);
+
+  entries = cache.top("average", 1);
+  ensure_equals("limit", entries.size(), 1U);
+  ensure_equals("slowest on average", entries[0].statement, std::string("select * from b"));
+  ensure_equals("tmp disk tables", entries[0].tmp_disk_tables, 1);
+
+  cache.clear();
+  ensure("cleared", cache.top("total", 10).empty());
+}
+
+END_TESTS
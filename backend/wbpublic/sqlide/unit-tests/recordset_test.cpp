@@ -23,10 +23,15 @@
 
 #ifndef _WIN32
 #include <sstream>
+#include <algorithm>
 #endif
 
 #include "sqlide/recordset_cdbc_storage.h"
+#include "sqlide/recordset_columnar_data.h"
 #include "sqlide/recordset_be.h"
+#include "sqlide/recordset_stream_writer.h"
+#include "sqlide/table_data_importer.h"
+#include "base/file_utilities.h"
 #include "connection_helpers.h"
 #include "cppdbc.h"
 #include "wb_helpers.h"
@@ -84,6 +89,240 @@ TEST_FUNCTION(2) {
   ensure("NULL blob is NULL", rs->is_field_null(0, 1));
 }
 
+TEST_FUNCTION(3) {
+  Recordset_columnar_data::Column_types types;
+  types.push_back(int());
+  types.push_back(std::string());
+  types.push_back(sqlite::blob_ref_t());
+  Recordset_columnar_data::Ref data(Recordset_columnar_data::create(types));
+
+  std::vector<sqlite::variant_t> row(3);
+  row[0] = 10;
+  row[1] = std::string("Beta");
+  row[2] = sqlite::null_t();
+  data->add_row(row);
+  row[0] = sqlite::null_t();
+  row[1] = std::string("alpha");
+  row[2] = sqlite::blob_ref_t(new sqlite::blob_t(3, 'x'));
+  data->add_row(row);
+  row[0] = 2;
+  row[1] = std::string(); // empty, not NULL
+  row[2] = sqlite::null_t();
+  data->add_row(row);
+
+  ensure_equals("row count", data->row_count(), 3U);
+  ensure("int value", boost::get<int>(data->get(0, 0)) == 10);
+  ensure("NULL int", data->is_null(1, 0));
+  ensure("empty string is not NULL", !data->is_null(2, 1));
+  ensure_equals("string value", boost::get<std::string>(data->get(1, 1)), "alpha");
+  ensure_equals("blob size", boost::get<sqlite::blob_ref_t>(data->get(1, 2))->size(), 3U);
+
+  ensure("NULLs sort first", data->compare(1, 0, 0, false, false) < 0);
+  ensure("numbers", data->compare(2, 0, 0, false, false) < 0);
+  ensure("nocase", data->compare(1, 0, 1, false, true) < 0);
+  ensure("case sensitive", data->compare(1, 0, 1, false, false) > 0);
+
+  ensure("like prefix", Recordset_columnar_data::like("Beta", "b%"));
+  ensure("like single char", Recordset_columnar_data::like("Beta", "_eta"));
+  ensure("like infix", Recordset_columnar_data::like("alphabet", "%HAB%"));
+  ensure("like mismatch", !Recordset_columnar_data::like("alpha", "%beta%"));
+  ensure("like backtracking", Recordset_columnar_data::like("aaab", "%ab"));
+
+  const char *patterns[] = {"b%", "_eta", "%HAB%", "%beta%", "%ab", "beta", "%", "", "a%b", "%ta"};
+  const char *values[] = {"Beta", "alpha", "alphabet", "aaab", "", "xbetax"};
+  for (const char *pattern : patterns) {
+    Recordset_columnar_data::Matcher matcher(pattern);
+    for (std::string value : values)
+      ensure_equals("matcher " + value + " " + pattern, matcher.matches(value.data(), value.size()),
+                    Recordset_columnar_data::like(value, pattern));
+  }
+
+  typedef Recordset_columnar_data::Matcher Matcher;
+  ensure("longer substring narrows", Matcher("%beta%").narrows(Matcher("%bet%")));
+  ensure("shorter substring widens", !Matcher("%bet%").narrows(Matcher("%beta%")));
+  ensure("longer prefix narrows", Matcher("abc%").narrows(Matcher("ab%")));
+  ensure("any value narrows %", Matcher("x").narrows(Matcher("%")));
+  ensure("wildcards are not compared", !Matcher("a_c").narrows(Matcher("%b%")));
+
+  std::vector<RowId> rows = {0, 1, 2};
+  data->filter(1, Matcher("%PH%"), rows);
+  ensure_equals("filter", rows.size(), 1U);
+  ensure_equals("filtered row", rows[0], 1U);
+
+  rows = {0, 1, 2};
+  data->filter(0, Matcher("%"), rows);
+  ensure_equals("filter skips NULLs", rows.size(), 2U);
+
+  rows = {0, 1, 2};
+  data->search(3, Matcher("%xx%"), rows);
+  ensure_equals("search blob", rows.size(), 1U);
+  rows = {0, 1, 2};
+  data->search(3, Matcher("%0%"), rows);
+  ensure_equals("search int", rows.size(), 1U);
+  ensure_equals("searched row", rows[0], 0U);
+}
+
+TEST_FUNCTION(4) {
+  Data data;
+  data.push_back(1);
+  data.push_back((std::int64_t)1234567890123LL);
+  data.push_back((long double)2.5L);
+  data.push_back(std::string("inline"));
+  data.push_back(std::string(100, 'z'));
+  data.push_back(sqlite::null_t());
+  data.push_back(sqlite::blob_ref_t(new sqlite::blob_t(4, 'b')));
+
+  ensure_equals("cell count", data.size(), 7U);
+  ensure("int", boost::get<int>(data[0].get()) == 1);
+  ensure("int64", boost::get<std::int64_t>(data[1].get()) == 1234567890123LL);
+  ensure("long double", boost::get<long double>(data[2].get()) == 2.5L);
+  ensure_equals("inline string", boost::get<std::string>(data[3].get()), "inline");
+  ensure_equals("arena string", boost::get<std::string>(data[4].get()), std::string(100, 'z'));
+  ensure("NULL", sqlide::is_var_null(data[5].get()));
+  ensure_equals("blob", boost::get<sqlite::blob_ref_t>(data[6].get())->size(), 4U);
+
+  // overwriting through an iterator, as set_field() does
+  Data::iterator cell = data.begin() + 3;
+  *cell = std::string("now longer than the inline storage");
+  ensure_equals("overwritten", boost::get<std::string>((*cell).get()), "now longer than the inline storage");
+
+  data.insert(data.begin(), std::string("first"));
+  data.erase(data.end() - 2, data.end());
+  std::reverse(data.begin(), data.end());
+  ensure_equals("cells after edit", data.size(), 6U);
+  ensure_equals("reversed", boost::get<std::string>(data[5].get()), "first");
+  ensure("reversed int", boost::get<int>(data[4].get()) == 1);
+}
+
+static std::string stream_export(const std::string &format, const std::string &null_syntax) {
+  Recordset_text_storage::TemplateInfo info;
+  info.name = format;
+  info.null_syntax = null_syntax;
+  info.row_separator = format == "JSON" ? "," : "";
+  info.pre_quote_strings = format == "JSON" || format == "SQL_inserts";
+  info.quote = format == "JSON" ? "\"" : "";
+  info.builtin = true;
+
+  Recordset_text_storage::Parameters parameters;
+  parameters["TABLE_NAME"] = "t1";
+  parameters["GENERATE_DATE"] = "2018-06-01 12:00";
+
+  Recordset_stream_writer::Ref writer(Recordset_stream_writer::create(info, parameters));
+  ensure("streamed format", writer.get() != nullptr);
+
+  std::vector<std::string> names;
+  names.push_back("id");
+  names.push_back("a name");
+
+  writer->open("stream_export.txt");
+  writer->begin(names, "select * from t1");
+  writer->add_value("1");
+  writer->add_value(writer->pre_quote_strings() ? writer->quote_string("x, \"y\"") : "x, \"y\"");
+  writer->end_row();
+  writer->add_value("2");
+  writer->add_null();
+  writer->end_row();
+  writer->end();
+  writer.reset();
+
+  gchar *contents = NULL;
+  gsize length = 0;
+  ensure("read export", g_file_get_contents("stream_export.txt", &contents, &length, NULL) != FALSE);
+  std::string result(contents, length);
+  g_free(contents);
+  base::remove("stream_export.txt");
+  return result;
+}
+
+// Streamed exports must match what the builtin templates produce.
+TEST_FUNCTION(5) {
+  ensure_equals("CSV", stream_export("CSV", "NULL"), "id,\"a name\"\n1,\"x, \"\"y\"\"\"\n2,NULL\n");
+  ensure_equals("tab", stream_export("tab", "NULL"), "id\ta name\n1\tx, \"y\"\n2\tNULL\n");
+  ensure_equals("JSON", stream_export("JSON", "null"),
+                "[\n\t{\n\t\t\"id\" : 1,\n\t\t\"a name\" : \"x, \\\"y\\\"\"\n\t},\n"
+                "\t{\n\t\t\"id\" : 2,\n\t\t\"a name\" : null\n\t}\n]\n");
+  ensure_equals("SQL", stream_export("SQL_inserts", "NULL"),
+                "/*\n-- Query: select * from t1\n-- Date: 2018-06-01 12:00\n*/\n"
+                "INSERT INTO `t1` (`id`,`a name`) VALUES (1,'x, \"y\"');\n"
+                "INSERT INTO `t1` (`id`,`a name`) VALUES (2,NULL);\n");
+
+  Recordset_text_storage::TemplateInfo user_template;
+  user_template.name = "CSV";
+  user_template.pre_quote_strings = false;
+  user_template.builtin = false;
+  ensure("user templates are not streamed",
+         !Recordset_stream_writer::create(user_template, Recordset_text_storage::Parameters()));
+}
+
+static std::vector<std::string> import_file(TableDataImporter::Options &options, const std::string &data,
+                                            size_t &failed) {
+  options.path = "table_import.txt";
+  options.table = "`t1`";
+  ensure("write import file",
+         g_file_set_contents(options.path.c_str(), data.data(), (gssize)data.size(), NULL) != FALSE);
+
+  std::vector<std::string> statements;
+  {
+    TableDataImporter importer(options);
+    ensure("import done", importer.import([&statements](const std::string &sql) {
+      if (sql.find("bad") != std::string::npos)
+        throw sql::SQLException("bad row");
+      statements.push_back(sql);
+    }));
+    failed = importer.rows_failed();
+  }
+  base::remove(options.path);
+  return statements;
+}
+
+static TableDataImporter::Column import_column(const std::string &name, int index, const std::string &type) {
+  TableDataImporter::Column column;
+  column.source = name;
+  column.source_index = index;
+  column.target = name;
+  column.type = type;
+  return column;
+}
+
+// Rows from CSV and JSON files become multi-row INSERTs, a statement failing is retried row by row.
+TEST_FUNCTION(6) {
+  TableDataImporter::Options csv;
+  csv.separator = ';';
+  csv.has_header = true;
+  csv.decimal_separator = ",";
+  csv.max_statement_rows = 2;
+  csv.columns.push_back(import_column("id", 0, "int"));
+  csv.columns.push_back(import_column("name", 1, "text"));
+  csv.columns.push_back(import_column("price", 2, "double"));
+
+  size_t failed = 0;
+  std::vector<std::string> statements =
+    import_file(csv, "id;name;price\r\n1;\"a;\"\"b\"\"\nc\";1,5\r\n\n2;it's;3\n3;bad;4\n4;short\n", failed);
+  ensure_equals("CSV statements", statements.size(), (size_t)1);
+  ensure_equals("CSV rows", statements[0],
+                "INSERT INTO `t1` (`id`,`name`,`price`) VALUES ('1','a;\\\"b\\\"\\nc','1.5'),('2','it\\'s','3')");
+  ensure_equals("CSV failed rows", failed, (size_t)2);
+
+  TableDataImporter::Options json;
+  json.format = "json";
+  json.date_format = "%d.%m.%Y %H:%M";
+  json.columns.push_back(import_column("id", 0, "int"));
+  json.columns.push_back(import_column("doc", 0, "json"));
+  json.columns.push_back(import_column("created", 0, "datetime"));
+
+  statements = import_file(json,
+                           "[{\"id\": 1, \"other\": [\"]\"], \"doc\": {\"a\": [1, 2]},\n"
+                           "  \"created\": \"01.02.2018 10:30\"},\n"
+                           " {\"id\": null, \"doc\": \"x\", \"created\": \"\\u00e9\"}]",
+                           failed);
+  ensure_equals("JSON statements", statements.size(), (size_t)1);
+  ensure_equals("JSON rows", statements[0],
+                "INSERT INTO `t1` (`id`,`doc`,`created`) VALUES (1,'{\\\"a\\\": [1, 2]}',"
+                "STR_TO_DATE('01.02.2018 10:30','%d.%m.%Y %H:%i')),"
+                "(NULL,'\\\"x\\\"',STR_TO_DATE('\xC3\xA9','%d.%m.%Y %H:%i'))");
+  ensure_equals("JSON failed rows", failed, (size_t)0);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -223,6 +223,20 @@ TEST_FUNCTION(10) {
 
   auto systemFunctions = _mainSymbols.getSymbolsOfType<RoutineSymbol>(); // System functions.
   ensure_equals("Test 10.9", systemFunctions.size(), 294U);
+
+  schemas = _mainSymbols.getSymbolsOfTypeWithPrefix<SchemaSymbol>("SAK");
+  ensure_equals("Test 10.10", schemas.size(), 2U);
+  ensure_equals("Test 10.11", schemas[0]->name, "sakila");
+  ensure_equals("Test 10.12", schemas[1]->name, "sakila_test");
+
+  tables = _mainSymbols.getSymbolsOfTypeWithPrefix<TableSymbol>("c", schema);
+  ensure_equals("Test 10.13", tables.size(), 4U);
+  ensure_equals("Test 10.14", tables[0]->name, "category");
+  ensure_equals("Test 10.15", tables[3]->name, "custom");
+  views = _mainSymbols.getSymbolsOfTypeWithPrefix<ViewSymbol>("", schema);
+  ensure_equals("Test 10.16", views.size(), 5U);
+  ensure_equals("Test 10.17", schema->resolve("film", true)->name, "film");
+  ensure("Test 10.18", schema->resolve("FILM", true) == nullptr);
 }
 
 class ErrorListener : public BaseErrorListener {
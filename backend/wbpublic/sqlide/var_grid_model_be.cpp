@@ -29,6 +29,10 @@
 #include <sqlite/query.hpp>
 #include "glib/gstdio.h"
 #include "base/boost_smart_ptr_helpers.h"
+#include "base/task_scheduler.h"
+#include <list>
+#include <mutex>
+#include <condition_variable>
 
 using namespace bec;
 using namespace grt;
@@ -81,12 +85,195 @@ public:
 
 //--------------------------------------------------------------------------------------------------
 
+// Same text as VarToStr makes for a truncated string, without copying more of the cell than is shown.
+static std::string truncated_repr(const Packed_data &data, size_t index, std::string::size_type threshold) {
+  return base::truncate_text(data.string_prefix(index, threshold + 1), (int)threshold);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/*
+ * Data frames read from the data swap db besides the one in _data, least recently used last. Shared with the worker
+ * thread reading ahead, of which there is at most one at a time. Frames read by a worker are dropped if the cache was
+ * invalidated while it was running.
+ */
+class VarGridModel::Frame_cache {
+public:
+  static const size_t MAX_FRAMES = 4;
+
+  struct Frame {
+    RowId begin;
+    RowId end;
+    Data data;
+    Field_reprs reprs;
+  };
+
+  Frame_cache() : _generation(0), _loading(false), _closed(false) {
+  }
+
+  // moves a resident frame with the given row out of the cache
+  bool take(RowId row, Frame &frame) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (std::list<Frame>::iterator i = _frames.begin(); i != _frames.end(); ++i)
+      if (i->begin <= row && row < i->end) {
+        frame.begin = i->begin;
+        frame.end = i->end;
+        frame.data.swap(i->data);
+        frame.reprs.swap(i->reprs);
+        _frames.erase(i);
+        return true;
+      }
+    return false;
+  }
+
+  bool has(RowId row) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &frame : _frames)
+      if (frame.begin <= row && row < frame.end)
+        return true;
+    return false;
+  }
+
+  void put(Frame &frame) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    put_(frame);
+  }
+
+  void invalidate() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_generation;
+    _frames.clear();
+  }
+
+  size_t memory_size() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t size = 0;
+    for (auto &frame : _frames) {
+      size += frame.data.memory_size();
+      for (auto &repr : frame.reprs)
+        size += sizeof(repr) + repr.second.capacity();
+    }
+    return size;
+  }
+
+  bool start_loading(size_t &generation) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_loading || _closed)
+      return false;
+    _loading = true;
+    generation = _generation;
+    return true;
+  }
+
+  void finish_loading(size_t generation, Frame *frame) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (frame && generation == _generation && !_closed)
+      put_(*frame);
+    _loading = false;
+    _loading_finished.notify_all();
+  }
+
+  // waits for a running worker, the data swap db is about to go away
+  void close() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _closed = true;
+    _frames.clear();
+    _loading_finished.wait(lock, [this]() { return !_loading; });
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _loading_finished;
+  std::list<Frame> _frames;
+  size_t _generation;
+  bool _loading;
+  bool _closed;
+
+  void put_(Frame &frame) {
+    _frames.push_front(Frame());
+    _frames.front().begin = frame.begin;
+    _frames.front().end = frame.end;
+    _frames.front().data.swap(frame.data);
+    _frames.front().reprs.swap(frame.reprs);
+    if (_frames.size() > MAX_FRAMES)
+      _frames.pop_back();
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/*
+ * Everything needed to read a data frame from the data swap db, copied so that it can be done on a worker thread.
+ */
+struct VarGridModel::Frame_source {
+  ColumnId column_count;
+  Column_types column_types;
+  std::vector<bool> null_columns; // blob columns not read when blob fetching is optimized
+  sqlide::VarCast var_cast;
+  std::string::size_type repr_threshold; // truncation of the display strings made ahead, npos for none
+
+  // Makes the display strings of the cells that get truncated, which are the costly ones to show.
+  void make_reprs(const Data &data, Field_reprs &reprs) const {
+    if (repr_threshold == std::string::npos)
+      return;
+    for (size_t index = 0; index < data.size(); ++index) {
+      size_t length = data.string_length(index);
+      if (length != std::string::npos && length > repr_threshold)
+        reprs[index] = truncated_repr(data, index, repr_threshold);
+    }
+  }
+
+
+  void read(sqlite::connection *data_swap_db, RowId first_row, RowId row_count, Data &data) {
+    const size_t partition_count = data_swap_db_partition_count(column_count);
+
+    std::list<std::shared_ptr<sqlite::query> > data_queries(partition_count);
+    prepare_partition_queries(
+      data_swap_db,
+      "select d.* from `data%s` d inner join `data_index` di on (di.`id`=d.`id`) order by di.`rowid` limit ? offset ?",
+      data_queries);
+    std::list<sqlite::variant_t> bind_vars;
+    bind_vars.push_back((int)row_count);
+    bind_vars.push_back((int)first_row);
+    std::vector<std::shared_ptr<sqlite::result> > data_results(data_queries.size());
+    if (emit_partition_queries(data_swap_db, data_queries, data_results, bind_vars)) {
+      bool next_row_exists = true;
+
+      data.reserve(row_count * column_count);
+      do {
+        for (size_t partition = 0; partition < partition_count; ++partition) {
+          std::shared_ptr<sqlite::result> &data_rs = data_results[partition];
+          for (ColumnId col_begin = partition * DATA_SWAP_DB_TABLE_MAX_COL_COUNT, col = col_begin,
+                        col_end = std::min<ColumnId>(column_count, (partition + 1) * DATA_SWAP_DB_TABLE_MAX_COL_COUNT);
+               col < col_end; ++col) {
+            sqlite::variant_t v;
+            if (null_columns[col]) {
+              v = sqlite::null_t();
+            } else {
+              ColumnId partition_column = col - col_begin;
+              v = data_rs->get_variant((int)partition_column);
+              sqlide::unpack_data_swap_value(v);
+              v = boost::apply_visitor(var_cast, column_types[col], v);
+            }
+            data.push_back(v);
+          }
+        }
+        for (auto &data_rs : data_results)
+          next_row_exists = data_rs->next_row();
+      } while (next_row_exists);
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+
 VarGridModel::VarGridModel()
   : _readonly(true),
     _row_count(0),
     _column_count(0),
     _data_frame_begin(0),
     _data_frame_end(0),
+    _field_reprs_data_size(0),
     _is_field_value_truncation_enabled(false),
     _edited_field_row(-1),
     _edited_field_col(-1) {
@@ -99,6 +286,8 @@ VarGridModel::VarGridModel()
 //--------------------------------------------------------------------------------------------------
 
 VarGridModel::~VarGridModel() {
+  if (_frame_cache)
+    _frame_cache->close();
   _data_swap_db.reset();
   // clean temporary file to prevent crowding of files
   if (!_data_swap_db_path.empty())
@@ -136,6 +325,7 @@ void VarGridModel::reset() {
   _row_count = 0;
   _data_frame_begin = 0;
   _data_frame_end = 0;
+  invalidate_data_frames();
 
   _icon_for_val.reset(new IconForVal(_optimized_blob_fetching));
 }
@@ -272,7 +462,7 @@ bool VarGridModel::is_field_null(const NodeId &node, ColumnId column) {
     if (_optimized_blob_fetching && sqlide::is_var_blob(_real_column_types[column]))
       return false;
     else
-      return sqlide::is_var_null(*cell);
+      return sqlide::is_var_null((*cell).get());
   } else {
     return true;
   }
@@ -293,7 +483,7 @@ IconId VarGridModel::get_field_icon(const NodeId &node, ColumnId column, IconSiz
   static const sqlite::variant_t null_value((sqlite::null_t()));
   if (((ssize_t)column < 0) || (column + 1 >= _column_types.size()))
     return 0;
-  const sqlite::variant_t &var = get_cell(cell, node, column, false) ? *cell : null_value;
+  const sqlite::variant_t var = get_cell(cell, node, column, false) ? (*cell).get() : null_value;
   return boost::apply_visitor(*_icon_for_val, _column_types[column], var);
 }
 
@@ -309,8 +499,10 @@ bool VarGridModel::get_field(const NodeId &node, ColumnId column, std::string &v
 bool VarGridModel::get_field_(const NodeId &node, ColumnId column, std::string &value) {
   Cell cell;
   bool res = get_cell(cell, node, column, false);
-  if (res)
-    value = boost::apply_visitor(_var_to_str, *cell);
+  if (res) {
+    sqlite::variant_t v = (*cell).get();
+    value = boost::apply_visitor(_var_to_str, v);
+  }
   return res;
 }
 
@@ -326,8 +518,10 @@ bool VarGridModel::get_field_repr(const NodeId &node, ColumnId column, std::stri
 bool VarGridModel::get_field_repr_no_truncate(const bec::NodeId &node, ColumnId column, std::string &value) {
   Cell cell;
   bool res = get_cell(cell, node, column, false);
-  if (res)
-    value = boost::apply_visitor(_var_to_str_repr, *cell);
+  if (res) {
+    sqlite::variant_t v = (*cell).get();
+    value = boost::apply_visitor(_var_to_str_repr, v);
+  }
   return res;
 }
 
@@ -340,8 +534,27 @@ bool VarGridModel::get_field_repr_(const NodeId &node, ColumnId column, std::str
     if (_is_field_value_truncation_enabled) {
       size_t row = node[0];
       _var_to_str_repr.is_truncation_enabled = (row != _edited_field_row) || (column != _edited_field_col);
+
+      // Long texts are shown truncated, which is kept per cell instead of copying the whole text on every paint.
+      size_t index = cell.index();
+      size_t length = _data.string_length(index);
+      if (_var_to_str_repr.is_truncation_enabled && length != std::string::npos &&
+          length > _var_to_str_repr.truncation_threshold) {
+        if (_field_reprs_data_size != _data.size()) {
+          _field_reprs.clear();
+          _field_reprs_data_size = _data.size();
+        }
+        Field_reprs::const_iterator repr = _field_reprs.find(index);
+        if (repr == _field_reprs.end())
+          repr =
+            _field_reprs.insert(std::make_pair(index, truncated_repr(_data, index, _var_to_str_repr.truncation_threshold)))
+              .first;
+        value = repr->second;
+        return res;
+      }
     }
-    value = boost::apply_visitor(_var_to_str_repr, *cell);
+    sqlite::variant_t v = (*cell).get();
+    value = boost::apply_visitor(_var_to_str_repr, v);
   }
   return res;
 }
@@ -364,15 +577,17 @@ bool VarGridModel::get_field_(const NodeId &node, ColumnId column, sqlite::varia
   Cell cell;
   bool res = get_cell(cell, node, column, false);
   if (res)
-    value = *cell;
+    value = (*cell).get();
   return res;
 }
 
 bool VarGridModel::get_field_(const NodeId &node, ColumnId column, bool &value) {
   Cell cell;
   bool res = get_cell(cell, node, column, false);
-  if (res)
-    value = (ssize_t)boost::apply_visitor(_var_to_bool, *cell);
+  if (res) {
+    sqlite::variant_t v = (*cell).get();
+    value = (ssize_t)boost::apply_visitor(_var_to_bool, v);
+  }
   return res;
 }
 
@@ -388,8 +603,10 @@ bool VarGridModel::get_field(const NodeId &node, ColumnId column, ssize_t &value
 bool VarGridModel::get_field_(const NodeId &node, ColumnId column, ssize_t &value) {
   Cell cell;
   bool res = get_cell(cell, node, column, false);
-  if (res)
-    value = (ssize_t)boost::apply_visitor(_var_to_int, *cell);
+  if (res) {
+    sqlite::variant_t v = (*cell).get();
+    value = (ssize_t)boost::apply_visitor(_var_to_int, v);
+  }
   return res;
 }
 
@@ -405,8 +622,10 @@ bool VarGridModel::get_field(const NodeId &node, ColumnId column, double &value)
 bool VarGridModel::get_field_(const NodeId &node, ColumnId column, double &value) {
   Cell cell;
   bool res = get_cell(cell, node, column, false);
-  if (res)
-    value = (double)boost::apply_visitor(_var_to_long_double, *cell);
+  if (res) {
+    sqlite::variant_t v = (*cell).get();
+    value = (double)boost::apply_visitor(_var_to_long_double, v);
+  }
   return res;
 }
 
@@ -434,10 +653,14 @@ bool VarGridModel::set_field(const NodeId &node, ColumnId column, const sqlite::
       bool is_blob_column = sqlide::is_var_blob(_real_column_types[column]);
       if (!_optimized_blob_fetching || !is_blob_column) {
         static const sqlide::VarEq var_eq;
-        if (!is_blob_column)
-          res = !boost::apply_visitor(var_eq, value, *cell);
-        if (res)
+        if (!is_blob_column) {
+          sqlite::variant_t current = (*cell).get();
+          res = !boost::apply_visitor(var_eq, value, current);
+        }
+        if (res) {
           *cell = value;
+          _field_reprs.erase(cell.index());
+        }
       }
     }
   }
@@ -483,6 +706,12 @@ void VarGridModel::add_column(const std::string &name, const sqlite::variant_t &
 void VarGridModel::cache_data_frame(RowId center_row, bool force_reload) {
   static const RowId half_row_count = 500; //! load from options
   RowId row_count = half_row_count * 2;
+  RowId previous_frame_begin = _data_frame_begin;
+  bool prefetch = prefetch_data_frames() && -1 != (int)center_row;
+  bool resident = false;
+
+  if (force_reload || -1 == (int)center_row)
+    invalidate_data_frames();
 
   // center_row of -1 means only to forcibly reload current data frame
   if (-1 != (int)center_row) {
@@ -504,58 +733,133 @@ void VarGridModel::cache_data_frame(RowId center_row, bool force_reload) {
       return;
     }
 
+    if (prefetch) {
+      if (!_frame_cache)
+        _frame_cache.reset(new Frame_cache());
+
+      // keep the current frame for scrolling back and use a resident one if there is, read ahead or kept before
+      Frame_cache::Frame frame;
+      resident = !force_reload && _frame_cache->take(center_row, frame);
+      if (!force_reload && _data_frame_end > _data_frame_begin) {
+        Frame_cache::Frame current;
+        current.begin = _data_frame_begin;
+        current.end = _data_frame_end;
+        current.data.swap(_data);
+        current.reprs.swap(_field_reprs);
+        _frame_cache->put(current);
+      }
+      if (resident) {
+        _data.clear();
+        _data.swap(frame.data);
+        _field_reprs.clear();
+        _field_reprs.swap(frame.reprs);
+        _field_reprs_data_size = _data.size();
+        starting_row = frame.begin;
+        row_count = frame.end - frame.begin;
+      }
+    }
+
     _data_frame_begin = starting_row;
     _data_frame_end = starting_row + row_count;
   } else {
     row_count = _data_frame_end - _data_frame_begin;
   }
 
-  _data.clear();
+  if (!resident) {
+    _data.clear();
+    _field_reprs.clear();
 
-  // load data
-  {
-    std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
-    const size_t partition_count = data_swap_db_partition_count();
+    if (load_data_frame(_data_frame_begin, row_count))
+      return;
 
-    std::list<std::shared_ptr<sqlite::query> > data_queries(partition_count);
-    prepare_partition_queries(
-      data_swap_db.get(),
-      "select d.* from `data%s` d inner join `data_index` di on (di.`id`=d.`id`) order by di.`rowid` limit ? offset ?",
-      data_queries);
-    std::list<sqlite::variant_t> bind_vars;
-    bind_vars.push_back((int)row_count);
-    bind_vars.push_back((int)_data_frame_begin);
-    std::vector<std::shared_ptr<sqlite::result> > data_results(data_queries.size());
-    if (emit_partition_queries(data_swap_db.get(), data_queries, data_results, bind_vars)) {
-      bool next_row_exists = true;
+    data_frame_source()->read(this->data_swap_db().get(), _data_frame_begin, row_count, _data);
+  }
+
+  // read the frame following in scroll direction while the rows of this one are shown
+  if (prefetch) {
+    if (_data_frame_begin >= previous_frame_begin && _data_frame_end < _row_count)
+      prefetch_data_frame(_data_frame_end, std::min<RowId>(half_row_count * 2, _row_count - _data_frame_end));
+    else if (_data_frame_begin < previous_frame_begin && _data_frame_begin > 0)
+      prefetch_data_frame(_data_frame_begin - std::min<RowId>(half_row_count * 2, _data_frame_begin),
+                          std::min<RowId>(half_row_count * 2, _data_frame_begin));
+  }
+}
 
-      std::vector<bool> blob_columns(_column_count);
-      for (ColumnId col = 0; _column_count > col; ++col)
-        blob_columns[col] = sqlide::is_var_blob(_real_column_types[col]);
+//--------------------------------------------------------------------------------------------------
 
-      _data.reserve(row_count * _column_count);
-      do {
-        for (size_t partition = 0; partition < partition_count; ++partition) {
-          std::shared_ptr<sqlite::result> &data_rs = data_results[partition];
-          for (ColumnId col_begin = partition * DATA_SWAP_DB_TABLE_MAX_COL_COUNT, col = col_begin,
-                        col_end = std::min<ColumnId>(_column_count, (partition + 1) * DATA_SWAP_DB_TABLE_MAX_COL_COUNT);
-               col < col_end; ++col) {
-            sqlite::variant_t v;
-            if (_optimized_blob_fetching && blob_columns[col]) {
-              v = sqlite::null_t();
-            } else {
-              ColumnId partition_column = col - col_begin;
-              v = data_rs->get_variant((int)partition_column);
-              v = boost::apply_visitor(_var_cast, _column_types[col], v);
-            }
-            _data.push_back(v);
-          }
-        }
-        for (auto &data_rs : data_results)
-          next_row_exists = data_rs->next_row();
-      } while (next_row_exists);
+std::shared_ptr<VarGridModel::Frame_source> VarGridModel::data_frame_source() const {
+  std::shared_ptr<Frame_source> source(new Frame_source());
+  source->column_count = _column_count;
+  source->column_types = _column_types;
+  source->var_cast = _var_cast;
+  source->repr_threshold =
+    _is_field_value_truncation_enabled ? _var_to_str_repr.truncation_threshold : std::string::npos;
+  source->null_columns.resize(_column_count);
+  for (ColumnId col = 0; _column_count > col; ++col)
+    source->null_columns[col] = _optimized_blob_fetching && sqlide::is_var_blob(_real_column_types[col]) &&
+                                !(col < _column_flags.size() && (_column_flags[col] & LazyValueFlag));
+  return source;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void VarGridModel::prefetch_data_frame(RowId first_row, RowId row_count) {
+  size_t generation;
+  if (!_frame_cache || _data_swap_db_path.empty() || row_count == 0 || _frame_cache->has(first_row) ||
+      !_frame_cache->start_loading(generation))
+    return;
+
+  std::shared_ptr<Frame_source> source(data_frame_source());
+
+  // the worker doesn't touch the model, which may be gone by the time it's done
+  std::shared_ptr<Frame_cache> frame_cache(_frame_cache);
+  std::string data_swap_db_path = _data_swap_db_path;
+  base::TaskScheduler::get()->post(base::TaskBulk, [frame_cache, source, data_swap_db_path, first_row, row_count,
+                                                    generation]() {
+    Frame_cache::Frame frame;
+    frame.begin = first_row;
+    frame.end = first_row + row_count;
+    try {
+      sqlite::connection data_swap_db(data_swap_db_path);
+      sqlide::optimize_sqlite_connection_for_speed(&data_swap_db);
+      source->read(&data_swap_db, first_row, row_count, frame.data);
+      source->make_reprs(frame.data, frame.reprs);
+    } catch (...) {
+      // the data swap db may be busy with changes, the frame gets read when needed then
+      frame_cache->finish_loading(generation, NULL);
+      return;
     }
-  }
+    frame_cache->finish_loading(generation, frame.data.size() == row_count * source->column_count ? &frame : NULL);
+  });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void VarGridModel::invalidate_data_frames() {
+  if (_frame_cache)
+    _frame_cache->invalidate();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t VarGridModel::data_frames_memory_size() {
+  base::RecMutexLock data_mutex WB_UNUSED(_data_mutex);
+  return _data.memory_size() + (_frame_cache ? _frame_cache->memory_size() : 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/*
+ * Drops the cached data frames, including the one shown. It gets read again from the data swap db on the next
+ * access to a cell.
+ */
+void VarGridModel::release_data_frames() {
+  base::RecMutexLock data_mutex WB_UNUSED(_data_mutex);
+  invalidate_data_frames();
+  Data().swap(_data);
+  Field_reprs().swap(_field_reprs);
+  _data_frame_begin = 0;
+  _data_frame_end = 0;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -656,6 +960,10 @@ void VarGridModel::set_edited_field(RowId row_index, ColumnId col_index) {
 //--------------------------------------------------------------------------------------------------
 
 bool VarGridModel::is_field_value_truncation_enabled(bool val) {
+  // Display strings made with the previous setting are of no use anymore.
+  _field_reprs.clear();
+  invalidate_data_frames();
+
   _is_field_value_truncation_enabled = val;
   if (_is_field_value_truncation_enabled) {
     grt::DictRef options = grt::DictRef::cast_from(grt::GRT::get()->get("/wb/options/options"));
@@ -29,6 +29,7 @@
 #include "grt/grt_threaded_task.h"
 #include "grt/tree_model.h"
 #include "grt/grt_manager.h"
+#include <unordered_map>
 #include <vector>
 
 class Recordset_data_storage;
@@ -88,7 +89,8 @@ protected:
   std::string _readonly_reason;
 
 public:
-  enum ColumnFlags { NeedsQuoteFlag = 1, NotNullFlag = 2 };
+  // LazyValueFlag: cells hold the size and start of the values only, which are read through the data storage
+  enum ColumnFlags { NeedsQuoteFlag = 1, NotNullFlag = 2, LazyValueFlag = 4 };
 
   typedef std::vector<std::string> Column_names;
   typedef std::vector<std::string> DBColumn_types;
@@ -195,6 +197,30 @@ public:
 
 protected:
   void cache_data_frame(RowId center_row, bool force_reload);
+  // fills _data with the given rows from somewhere other than the data swap db, returns false if not applicable
+  virtual bool load_data_frame(RowId first_row, RowId row_count) {
+    return false;
+  }
+
+  // whether frames read from the data swap db are kept around and the next one in scroll direction is read ahead
+  // on a worker thread. Models changing _data or the data swap db have to call invalidate_data_frames() then.
+  virtual bool prefetch_data_frames() const {
+    return false;
+  }
+  void invalidate_data_frames();
+
+public:
+  // bytes held by the data frames read from the data swap db
+  size_t data_frames_memory_size();
+  void release_data_frames();
+
+private:
+  class Frame_cache;
+  struct Frame_source;
+  std::shared_ptr<Frame_cache> _frame_cache;
+
+  std::shared_ptr<Frame_source> data_frame_source() const;
+  void prefetch_data_frame(RowId first_row, RowId row_count);
 
 protected:
   RowId _data_frame_begin;
@@ -210,6 +236,11 @@ public:
 protected:
   sqlide::VarToStr _var_to_str;
   sqlide::VarToStr _var_to_str_repr; // supposed to be used only by UI part, set to do truncation of long text values
+
+  // Truncated display strings of the long text cells of _data, by cell index. Only used with truncation enabled.
+  typedef std::unordered_map<size_t, std::string> Field_reprs;
+  Field_reprs _field_reprs;
+  size_t _field_reprs_data_size; // size of _data the reprs were made for, they are dropped when it changes
   sqlide::VarToInt _var_to_int;
   sqlide::VarToBool _var_to_bool;
   sqlide::VarToLongDouble _var_to_long_double;
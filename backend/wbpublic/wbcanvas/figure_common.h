@@ -67,7 +67,13 @@ namespace wbfig {
     }
 
     void set_color(const base::Color &color);
+    const base::Color &get_color() const {
+      return _back_color;
+    }
     void set_text_color(const base::Color &color);
+    const base::Color &get_text_color() const {
+      return _icon_text.get_pen_color();
+    }
     void set_font(const mdc::FontSpec &font);
     const mdc::FontSpec &get_font() {
       return _icon_text.get_font();
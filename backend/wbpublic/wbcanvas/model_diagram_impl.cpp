@@ -38,6 +38,8 @@
 using namespace grt;
 using namespace base;
 
+#define CLOSED_DIAGRAM_UNREALIZE_DELAY 300 // seconds a closed diagram keeps its canvas items
+
 // this subclass allows repainting to happen in 3 steps, layer only, connection only and figure only
 // to follow a repaint ordering that's independent from logical ordering
 class RootAreaGroup : public mdc::AreaGroup {
@@ -97,6 +99,8 @@ public:
 model_Diagram::ImplData::ImplData(model_Diagram *self) : _self(self), _canvas_view(0) {
   _updating_selection = 0;
   _connected_update = false;
+  _contents_realized = false;
+  _unrealize_timer = NULL;
 
   scoped_connect(self->signal_changed(), std::bind(&model_Diagram::ImplData::member_changed, this,
                                                    std::placeholders::_1, std::placeholders::_2));
@@ -266,6 +270,7 @@ void model_Diagram::ImplData::update_options(const std::string &key) {
 }
 
 void model_Diagram::ImplData::realize_contents() {
+  _contents_realized = true;
   _self->_rootLayer->get_data()->realize();
 
   for (size_t c = _self->_layers.count(), i = 0; i < c; i++) {
@@ -312,9 +317,12 @@ bool model_Diagram::ImplData::realize() {
 
     _canvas_view->set_zoom((float)*_self->_zoom);
 
-    realize_contents();
+    // Diagrams that are not open in an editor get their contents only when opened (or printed).
+    if (*_self->_closed == 0) {
+      realize_contents();
 
-    run_later(std::bind(&model_Diagram::ImplData::realize_selection, this));
+      run_later(std::bind(&model_Diagram::ImplData::realize_selection, this));
+    }
   }
   if (!_canvas_view) {
     if (!_self->owner().is_valid())
@@ -325,9 +333,8 @@ bool model_Diagram::ImplData::realize() {
   return true;
 }
 
-void model_Diagram::ImplData::unrealize() {
-  if (_selection_signal_conn.connected())
-    _selection_signal_conn.disconnect();
+void model_Diagram::ImplData::unrealize_items() {
+  _contents_realized = false;
 
   for (size_t c = _self->_figures.count(), i = 0; i < c; i++) {
     _self->_figures[i]->get_data()->unrealize();
@@ -340,6 +347,58 @@ void model_Diagram::ImplData::unrealize() {
   }
   if (_self->_rootLayer.is_valid() && _self->_rootLayer->get_data())
     _self->_rootLayer->get_data()->unrealize();
+}
+
+/**
+ * Removes all canvas items but keeps the canvas view, for diagrams closed for a while. The selection stays in the
+ * diagram object and is applied again by realize_selection() once the contents are realized again.
+ */
+void model_Diagram::ImplData::unrealize_contents() {
+  _unrealize_timer = NULL;
+  if (!_contents_realized || *_self->_closed == 0)
+    return;
+
+  begin_selection_update();
+  unrealize_items();
+  end_selection_update();
+}
+
+void model_Diagram::ImplData::ensure_contents_realized() {
+  if (!_canvas_view || _contents_realized)
+    return;
+
+  realize_contents();
+  realize_selection();
+
+  if (*_self->_closed != 0)
+    schedule_unrealize_contents();
+}
+
+void model_Diagram::ImplData::schedule_unrealize_contents() {
+  if (_unrealize_timer != NULL || !_contents_realized)
+    return;
+
+  _unrealize_timer = bec::GRTManager::get()->run_every(
+    [this]() {
+      unrealize_contents();
+      return false;
+    },
+    CLOSED_DIAGRAM_UNREALIZE_DELAY);
+}
+
+void model_Diagram::ImplData::cancel_unrealize_contents() {
+  if (_unrealize_timer != NULL) {
+    bec::GRTManager::get()->cancel_timer(_unrealize_timer);
+    _unrealize_timer = NULL;
+  }
+}
+
+void model_Diagram::ImplData::unrealize() {
+  if (_selection_signal_conn.connected())
+    _selection_signal_conn.disconnect();
+
+  cancel_unrealize_contents();
+  unrealize_items();
 
   if (_canvas_view) {
     _canvas_view->pre_destroy();
@@ -366,6 +425,12 @@ void model_Diagram::ImplData::member_changed(const std::string &name, const grt:
     update_size();
   } else if (name == "width" || name == "height") {
     update_size();
+  } else if (name == "closed") {
+    if (*_self->_closed == 0) {
+      cancel_unrealize_contents();
+      ensure_contents_realized();
+    } else
+      schedule_unrealize_contents();
   }
 }
 
@@ -801,6 +866,10 @@ static void update_badge(const std::string &name, const ValueRef &ovalue, const
 }
 
 void model_Diagram::ImplData::add_tag_badge_to_figure(const model_FigureRef &figure, const meta_TagRef &tag) {
+  // Figures that are not realized yet add the badges of their tags when they are.
+  if (!figure->get_data()->get_canvas_item())
+    return;
+
   BadgeFigure *badge = new BadgeFigure(get_canvas_view()->get_current_layer());
 
   badge->set_badge_id(tag->id());
@@ -59,6 +59,8 @@ protected:
 
   int _updating_selection;
   bool _connected_update;
+  bool _contents_realized;
+  bec::GRTManager::Timer *_unrealize_timer;
 
   virtual ~ImplData();
 
@@ -72,6 +74,10 @@ protected:
 
   void realize_contents();
   void realize_selection();
+  void unrealize_items();
+  void unrealize_contents();
+  void schedule_unrealize_contents();
+  void cancel_unrealize_contents();
 
   void update_options(const std::string &key);
 
@@ -123,6 +129,12 @@ public:
   bool is_canvas_view_valid() {
     return _canvas_view != NULL;
   };
+  // Layers, figures and connections only get canvas items while this is set, which is while the diagram is open.
+  bool is_contents_realized() const {
+    return _contents_realized;
+  }
+  // For rendering a diagram that may be closed, e.g. for printing. Closed diagrams are unrealized again later.
+  void ensure_contents_realized();
 
   static base::Size get_size_for_page(const app_PageSettingsRef &page);
 
@@ -182,7 +182,8 @@ bool model_Layer::ImplData::is_canvas_view_valid() {
 //--------------------------------------------------------------------------------------------------
 
 bool model_Layer::ImplData::is_realizable() {
-  return _in_view && *self()->_width > 0 && *self()->_height > 0 && is_canvas_view_valid();
+  return _in_view && *self()->_width > 0 && *self()->_height > 0 && is_canvas_view_valid() &&
+         self()->owner()->get_data()->is_contents_realized();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -211,6 +211,29 @@ wbfig::FigureItem *Table::create_index_item(mdc::Layer *layer, FigureEventHub *h
   return new FigureItem(layer, hub, this);
 }
 
+/**
+ * When zoomed out far the column lists are unreadable anyway. Draw only the table body and a plain title bar
+ * with the table name, which is a lot cheaper than the full figure.
+ */
+bool Table::render_low_detail(mdc::CairoCtx *cr) {
+  mdc::Layouter::render(cr);
+
+  Rect title(get_position() + _title.get_position(), _title.get_size());
+  cr->rectangle(title);
+  cr->set_color(_title.get_color());
+  cr->fill_preserve();
+  cr->clip();
+
+  cairo_text_extents_t extents;
+  cr->get_text_extents(_title.get_font(), _title.get_title(), extents);
+  cr->set_font(_title.get_font());
+  cr->set_color(_title.get_text_color());
+  cr->move_to(title.left() + 4, title.top() + (title.height() + extents.height) / 2);
+  cr->show_text(_title.get_title());
+
+  return true;
+}
+
 bool Table::compare_connection_position(mdc::Connector *a, mdc::Connector *b, mdc::BoxSideMagnet::Side side) {
   wbfig::ConnectionLineLayouter *layouter;
   Point a_pos, b_pos;
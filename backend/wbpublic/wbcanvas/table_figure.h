@@ -158,6 +158,8 @@ namespace wbfig {
     virtual void set_max_columns_shown(int count) {
     }
 
+    virtual bool render_low_detail(mdc::CairoCtx *cr);
+
   protected:
     mdc::RectangleFigure _background;
     boost::signals2::signal<void(int, bool)> _signal_index_crossed;
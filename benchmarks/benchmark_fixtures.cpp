@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <glib.h>
+#include <map>
+#include <vector>
+
+#include "base/file_utilities.h"
+#include "grts/structs.h"
+#include "grts/structs.db.h"
+#include "grts/structs.db.mgmt.h"
+#include "grts/structs.app.h"
+#include "grts/structs.model.h"
+#include "grts/structs.workbench.h"
+#include "grts/structs.workbench.physical.h"
+
+#include "benchmark_fixtures.h"
+#include "schema_generator.h"
+
+using namespace benchmarks;
+
+#define ROWS_PER_INSERT 100
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void benchmarks::initGrt() {
+  static bool initialized = false;
+  if (initialized)
+    return;
+  initialized = true;
+
+  register_structs_xml();
+  register_structs_db_xml();
+  register_structs_db_mgmt_xml();
+  register_structs_db_mysql_xml();
+  register_structs_app_xml();
+  register_structs_model_xml();
+  register_structs_workbench_xml();
+  register_structs_workbench_physical_xml();
+
+  grt::GRT::get()->scan_metaclasses_in(base::makePath(BENCHMARK_SOURCE_DIR, "res/grt"));
+  grt::GRT::get()->end_loading_metaclasses(false);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void appendTableDump(std::string &dump, size_t number) {
+  std::string name = "table_" + std::to_string(number);
+
+  dump += "\n--\n-- Table structure for table `" + name + "`\n--\n\n";
+  dump += "DROP TABLE IF EXISTS `" + name + "`;\n";
+  dump += "/*!40101 SET @saved_cs_client     = @@character_set_client */;\n";
+  dump += "CREATE TABLE `" + name + "` (\n"
+          "  `id` int(11) NOT NULL AUTO_INCREMENT,\n"
+          "  `name` varchar(64) NOT NULL,\n"
+          "  `note` text COMMENT 'free text; may contain -- anything',\n"
+          "  `amount` decimal(10,2) DEFAULT NULL,\n"
+          "  `created` datetime NOT NULL DEFAULT CURRENT_TIMESTAMP,\n"
+          "  PRIMARY KEY (`id`),\n"
+          "  KEY `idx_name` (`name`)\n"
+          ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;\n\n";
+
+  dump += "--\n-- Dumping data for table `" + name + "`\n--\n\n";
+  dump += "LOCK TABLES `" + name + "` WRITE;\n";
+  for (size_t block = 0; block < 10; ++block) {
+    dump += "INSERT INTO `" + name + "` VALUES ";
+    for (size_t row = 0; row < ROWS_PER_INSERT; ++row) {
+      std::string id = std::to_string(block * ROWS_PER_INSERT + row + 1);
+      if (row > 0)
+        dump += ',';
+      dump += "(" + id + ",'name " + id + "','it\\'s a \"note\"; with a delimiter, -- a dash and a # hash'," + id +
+              ".50,'2018-01-01 12:00:00')";
+    }
+    dump += ";\n";
+  }
+  dump += "UNLOCK TABLES;\n";
+
+  if (number % 10 == 0) {
+    dump += "\nDELIMITER ;;\n";
+    dump += "CREATE DEFINER=`root`@`localhost` PROCEDURE `refresh_" + name + "`(IN threshold INT)\n"
+            "BEGIN\n"
+            "  /* Statements in the body end with ; which must not end the procedure. */\n"
+            "  DECLARE total INT DEFAULT 0;\n"
+            "  SELECT COUNT(*) INTO total FROM `" + name + "` WHERE amount > threshold;\n"
+            "  UPDATE `" + name + "` SET note = CONCAT(note, ';') WHERE id < total;\n"
+            "END ;;\n"
+            "DELIMITER ;\n";
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const std::string &benchmarks::sqlDump(size_t size) {
+  static std::map<size_t, std::string> dumps;
+
+  std::string &dump = dumps[size];
+  if (dump.empty()) {
+    dump.reserve(size + 64 * 1024);
+    dump = "-- MySQL dump 10.13  Distrib 8.0.12, for Linux (x86_64)\n--\n-- Host: localhost    Database: benchmark\n"
+           "-- ------------------------------------------------------\n\n"
+           "/*!40101 SET NAMES utf8mb4 */;\n/*!40014 SET @OLD_FOREIGN_KEY_CHECKS=@@FOREIGN_KEY_CHECKS */;\n";
+    for (size_t number = 0; dump.size() < size; ++number)
+      appendTableDump(dump, number);
+  }
+  return dump;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static db_mysql_CatalogRef buildCatalog(size_t schemaCount, size_t tablesPerSchema, bool changed) {
+  initGrt();
+
+  SchemaOptions options;
+  options.schemas = schemaCount;
+  options.tablesPerSchema = tablesPerSchema;
+  options.changeEvery = changed ? 10 : 0;
+  return generateCatalog(options);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+db_mysql_CatalogRef benchmarks::createCatalog(size_t schemaCount, size_t tablesPerSchema) {
+  return buildCatalog(schemaCount, tablesPerSchema, false);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+db_mysql_CatalogRef benchmarks::createChangedCatalog(size_t schemaCount, size_t tablesPerSchema) {
+  return buildCatalog(schemaCount, tablesPerSchema, true);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const std::string &benchmarks::modelFile(size_t schemaCount, size_t tablesPerSchema) {
+  static std::map<std::pair<size_t, size_t>, std::string> files;
+
+  std::string &path = files[std::make_pair(schemaCount, tablesPerSchema)];
+  if (path.empty()) {
+    path = base::makePath(g_get_tmp_dir(), "wb_benchmark_model_" + std::to_string(schemaCount) + "x" +
+                                             std::to_string(tablesPerSchema) + ".xml");
+    grt::GRT::get()->serialize(createCatalog(schemaCount, tablesPerSchema), path, "MySQL Workbench Model", "1.4.4");
+  }
+  return path;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string benchmarks::wideResultQuery(size_t rowCount) {
+  // Row numbers come from a cross join of digit lists, one list per decimal place.
+  static const std::string digits =
+    "(SELECT 0 AS n UNION ALL SELECT 1 UNION ALL SELECT 2 UNION ALL SELECT 3 UNION ALL SELECT 4 UNION ALL SELECT 5 "
+    "UNION ALL SELECT 6 UNION ALL SELECT 7 UNION ALL SELECT 8 UNION ALL SELECT 9)";
+
+  std::string sequence;
+  std::string from;
+  size_t factor = 1;
+  for (size_t i = 0; factor < rowCount || i == 0; ++i, factor *= 10) {
+    std::string name = "d" + std::to_string(i);
+    if (i > 0) {
+      sequence += " + ";
+      from += ", ";
+    }
+    sequence += name + ".n * " + std::to_string(factor);
+    from += digits + " " + name;
+  }
+
+  std::string columns;
+  for (size_t group = 0; group < 8; ++group) {
+    std::string value = "(seq + " + std::to_string(group) + ")";
+    std::string suffix = "_" + std::to_string(group);
+    if (group > 0)
+      columns += ", ";
+    columns += value + " AS int" + suffix;
+    columns += ", CONCAT('row ', " + value + ") AS text" + suffix;
+    columns += ", " + value + " * 1.25 AS decimal" + suffix;
+    columns += ", DATE_ADD('2018-01-01 00:00:00', INTERVAL " + value + " MINUTE) AS datetime" + suffix;
+    columns += ", IF(" + value + " % 7 = 0, NULL, REPEAT('x', " + value + " % 64)) AS nullable" + suffix;
+  }
+
+  return "SELECT " + columns + " FROM (SELECT " + sequence + " AS seq FROM " + from + ") numbers LIMIT " +
+         std::to_string(rowCount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+// Generated fixtures for the benchmarks. Everything is built from fixed patterns, so the same size gives the same
+// data on every run and results of different builds can be compared.
+
+#include <string>
+
+#include "grts/structs.db.mysql.h"
+
+namespace benchmarks {
+
+  // Loads the GRT struct definitions from res/grt, needed once before any GRT object is created.
+  void initGrt();
+
+  // A dump as written by mysqldump, of about the given size: table definitions with multi-row inserts, comments,
+  // quoted strings with delimiters in them and stored procedures in DELIMITER blocks.
+  const std::string &sqlDump(size_t size);
+
+  // A catalog from generateCatalog() with the given number of schemas and tables per schema and the default options
+  // for everything else.
+  db_mysql_CatalogRef createCatalog(size_t schemaCount, size_t tablesPerSchema);
+
+  // The same catalog as createCatalog(), with every 10th table changed: one column renamed, one added and one removed.
+  db_mysql_CatalogRef createChangedCatalog(size_t schemaCount, size_t tablesPerSchema);
+
+  // Path of an XML file with a serialized catalog (like document.mwb.xml in a model file). Written on first use into
+  // the temp folder.
+  const std::string &modelFile(size_t schemaCount, size_t tablesPerSchema);
+
+  // A query that returns the given number of rows with 40 columns of mixed types, without needing any table.
+  std::string wideResultQuery(size_t rowCount);
+
+} // namespace benchmarks
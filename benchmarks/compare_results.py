@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+# Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License, version 2.0,
+# as published by the Free Software Foundation.
+#
+# This program is also distributed with certain software (including
+# but not limited to OpenSSL) that is licensed under separate terms, as
+# designated in a particular file or component or in included license
+# documentation.  The authors of MySQL hereby grant you an additional
+# permission to link the program and your derivative works with the
+# separately licensed software that they have included with MySQL.
+# This program is distributed in the hope that it will be useful,  but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+# the GNU General Public License, version 2.0, for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+"""Compares two result files of wb_benchmarks (written with --benchmark_out_format=json).
+
+Exits with 1 if any benchmark in the current results is slower than in the baseline by more than the threshold.
+With --benchmark_repetitions the median of the repetitions is compared, otherwise the single run.
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import sys
+
+
+def load_times(path, field):
+    with open(path) as f:
+        data = json.load(f)
+
+    times = {}
+    medians = {}
+    for entry in data.get('benchmarks', []):
+        if entry.get('error_occurred'):
+            continue
+        if entry.get('run_type') == 'aggregate':
+            if entry.get('aggregate_name') == 'median':
+                medians[entry['run_name']] = entry[field]
+        else:
+            times.setdefault(entry.get('run_name', entry['name']), entry[field])
+    times.update(medians)
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('baseline', help='results of the reference build')
+    parser.add_argument('current', help='results of the build to check')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='allowed slowdown in percent (default: %(default)s)')
+    parser.add_argument('--field', default='real_time', choices=['real_time', 'cpu_time'],
+                        help='time to compare (default: %(default)s)')
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline, args.field)
+    current = load_times(args.current, args.field)
+
+    regressions = 0
+    print('%-60s %14s %14s %9s' % ('Benchmark', 'Baseline', 'Current', 'Change'))
+    for name in sorted(current):
+        if name not in baseline:
+            print('%-60s %14s %14.3f %9s' % (name, '-', current[name], 'new'))
+            continue
+
+        change = (current[name] - baseline[name]) * 100.0 / baseline[name] if baseline[name] else 0.0
+        marker = ''
+        if change > args.threshold:
+            marker = '  REGRESSION'
+            regressions += 1
+        print('%-60s %14.3f %14.3f %+8.1f%%%s' % (name, baseline[name], current[name], change, marker))
+
+    for name in sorted(set(baseline) - set(current)):
+        print('%-60s %14.3f %14s %9s' % (name, baseline[name], '-', 'missing'))
+
+    if regressions:
+        print('\n%d benchmark(s) got slower by more than %.1f%%' % (regressions, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
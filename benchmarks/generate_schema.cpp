@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+// Writes large generated schemas for scale tests: a model file, the matching DDL script and the serialized catalog.
+//
+//   wb_generate_schema --schemas 50 --tables 1000 --columns 40 --mwb big.mwb --sql big.sql
+//
+// The same options always produce the same schema, see schema_generator.h.
+
+#include <algorithm>
+#include <errno.h>
+#include <glib.h>
+#include <iostream>
+
+#include "base/data_types.h"
+#include "base/file_utilities.h"
+#include "base/log.h"
+#include "workbench/wb_model_file.h"
+
+#include "benchmark_fixtures.h"
+#include "schema_generator.h"
+
+DEFAULT_LOG_DOMAIN("schema generator")
+
+using namespace dataTypes;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void addNumber(OptionsList &options, const std::string &name, const std::string &description, int value) {
+  OptionEntry entry(OptionArgumentNumeric, name, description, nullptr, "<n>");
+  entry.value.numericValue = value;
+  options.addEntry(entry);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static size_t number(OptionsList &options, const std::string &name) {
+  int value = options.getEntry(name)->value.numericValue;
+  return value < 0 ? 0 : (size_t)value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+  benchmarks::SchemaOptions defaults;
+
+  OptionsList options;
+  addNumber(options, "schemas", "Number of schemas", (int)defaults.schemas);
+  addNumber(options, "tables", "Tables per schema", (int)defaults.tablesPerSchema);
+  addNumber(options, "columns", "Columns per table, without foreign key columns", (int)defaults.columnsPerTable);
+  addNumber(options, "indexes", "Secondary indexes per table", (int)defaults.indexesPerTable);
+  addNumber(options, "foreign-keys", "Foreign keys per table", (int)defaults.foreignKeysPerTable);
+  addNumber(options, "routines", "Stored procedures per schema", (int)defaults.routinesPerSchema);
+  addNumber(options, "change-every", "Change every n-th table, for diff and sync tests", (int)defaults.changeEvery);
+  addNumber(options, "seed", "Seed for column types and foreign key targets", (int)defaults.seed);
+  addNumber(options, "tables-per-diagram", "Figures per EER diagram, 0 for one diagram with all tables", 3000);
+  options.addEntry(OptionEntry(OptionArgumentFilename, "mwb", "Model file to write", nullptr, "<path>"));
+  options.addEntry(OptionEntry(OptionArgumentFilename, "sql", "DDL script to write", nullptr, "<path>"));
+  options.addEntry(OptionEntry(OptionArgumentFilename, "xml", "Serialized catalog to write", nullptr, "<path>"));
+  options.addEntry(OptionEntry(OptionArgumentLogical, "help", "Show this help"));
+
+  int result = 0;
+  try {
+    if (!options.parse(std::vector<std::string>(argv + 1, argv + argc), result))
+      return result;
+  } catch (std::exception &e) {
+    std::cerr << e.what() << std::endl << std::endl << options.getHelp(base::basename(argv[0]));
+    return 1;
+  }
+
+  std::string mwbPath = options.getEntry("mwb")->value.textValue;
+  std::string sqlPath = options.getEntry("sql")->value.textValue;
+  std::string xmlPath = options.getEntry("xml")->value.textValue;
+  if (options.getEntry("help")->value.logicalValue || (mwbPath.empty() && sqlPath.empty() && xmlPath.empty())) {
+    std::cout << options.getHelp(base::basename(argv[0]));
+    return 0;
+  }
+
+  benchmarks::SchemaOptions schemaOptions;
+  schemaOptions.schemas = number(options, "schemas");
+  schemaOptions.tablesPerSchema = number(options, "tables");
+  schemaOptions.columnsPerTable = std::max<size_t>(1, number(options, "columns"));
+  schemaOptions.indexesPerTable = number(options, "indexes");
+  schemaOptions.foreignKeysPerTable = number(options, "foreign-keys");
+  schemaOptions.routinesPerSchema = number(options, "routines");
+  schemaOptions.changeEvery = number(options, "change-every");
+  schemaOptions.seed = (unsigned int)number(options, "seed");
+
+  try {
+    benchmarks::initGrt();
+    db_mysql_CatalogRef catalog = benchmarks::generateCatalog(schemaOptions);
+
+    if (!sqlPath.empty()) {
+      std::string script = benchmarks::generateScript(catalog);
+      base::FileHandle file(sqlPath, "wb");
+      if (fwrite(script.data(), 1, script.size(), file.file()) != script.size())
+        throw base::file_error("Failed to write file \"" + sqlPath + "\"", errno);
+      std::cout << "Wrote " << sqlPath << std::endl;
+    }
+
+    if (!xmlPath.empty()) {
+      grt::GRT::get()->serialize(catalog, xmlPath);
+      std::cout << "Wrote " << xmlPath << std::endl;
+    }
+
+    if (!mwbPath.empty()) {
+      workbench_DocumentRef document = benchmarks::generateDocument(catalog, number(options, "tables-per-diagram"));
+      wb::ModelFile modelFile(g_get_tmp_dir());
+      modelFile.create();
+      modelFile.store_document(document);
+      if (!modelFile.save_to(mwbPath))
+        throw std::runtime_error("Could not save " + mwbPath);
+      modelFile.cleanup();
+      std::cout << "Wrote " << mwbPath << std::endl;
+    }
+  } catch (std::exception &e) {
+    logError("%s\n", e.what());
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
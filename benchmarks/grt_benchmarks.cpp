@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "grtpp_util.h"
+#include "diff/diffchange.h"
+#include "unserializer.h"
+
+#include <glib.h>
+
+#include "base/file_utilities.h"
+
+#include "benchmark_fixtures.h"
+#include "schema_generator.h"
+
+// Reading of model files and the catalog diff behind synchronization and ALTER script generation.
+// The arguments are the number of schemas and the number of tables per schema.
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BM_Unserializer_load_from_xml(benchmark::State &state) {
+  const std::string &path = benchmarks::modelFile((size_t)state.range(0), (size_t)state.range(1));
+  for (auto _ : state) {
+    grt::internal::Unserializer unserializer(false);
+    grt::ValueRef value = unserializer.load_from_xml(path);
+    benchmark::DoNotOptimize(value.valueptr());
+  }
+  state.counters["tables"] = (double)(state.range(0) * state.range(1));
+}
+
+BENCHMARK(BM_Unserializer_load_from_xml)->Args({ 1, 100 })->Args({ 10, 200 })->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BM_GrtDiff(benchmark::State &state) {
+  db_mysql_CatalogRef source = benchmarks::createCatalog((size_t)state.range(0), (size_t)state.range(1));
+  db_mysql_CatalogRef target = benchmarks::createChangedCatalog((size_t)state.range(0), (size_t)state.range(1));
+  grt::default_omf omf;
+
+  for (auto _ : state) {
+    std::shared_ptr<grt::DiffChange> change = grt::diff_make(source, target, &omf);
+    benchmark::DoNotOptimize(change.get());
+  }
+  state.counters["tables"] = (double)(state.range(0) * state.range(1));
+}
+
+BENCHMARK(BM_GrtDiff)->Args({ 1, 100 })->Args({ 10, 200 })->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Writing a model document with a diagram of as many figures, which is what ModelFile::store_document() does on save.
+static void BM_serialize_document(benchmark::State &state) {
+  db_mysql_CatalogRef catalog = benchmarks::createCatalog(1, (size_t)state.range(0));
+  workbench_DocumentRef document = benchmarks::generateDocument(catalog, 0);
+  std::string path = base::makePath(g_get_tmp_dir(), "wb_benchmark_document.xml");
+
+  for (auto _ : state)
+    grt::GRT::get()->serialize(document, path, "MySQL Workbench Model", "1.4.4");
+
+  base::tryRemove(path);
+  state.counters["figures"] = (double)state.range(0);
+}
+
+BENCHMARK(BM_serialize_document)->Arg(300)->Arg(3000)->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------------------------------------------------
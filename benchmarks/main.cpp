@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+// Micro benchmarks for the hot paths in library/ and backend/, built with -DWITH_BENCHMARKS=ON.
+//
+// Results are compared across builds with the JSON output of Google Benchmark:
+//
+//   wb_benchmarks --benchmark_repetitions=5 --benchmark_out=current.json --benchmark_out_format=json
+//   benchmarks/compare_results.py baseline.json current.json
+//
+// compare_results.py exits with an error if a benchmark got slower than the allowed threshold, which makes it usable
+// as a regression gate in a build pipeline.
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "mysql_parser_module.h"
+
+#include "benchmark_fixtures.h"
+
+// Splitting of SQL scripts into statements, as done for every script run in the SQL editor and for dump imports.
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BM_determineStatementRanges(benchmark::State &state) {
+  // The module is used directly, which avoids loading the GRT module infrastructure.
+  static MySQLParserServicesImpl services(nullptr);
+
+  const std::string &dump = benchmarks::sqlDump((size_t)state.range(0));
+  std::vector<parsers::StatementRange> ranges;
+  for (auto _ : state) {
+    ranges.clear();
+    services.determineStatementRanges(dump.c_str(), dump.size(), ";", ranges);
+    benchmark::DoNotOptimize(ranges.data());
+  }
+
+  state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)dump.size());
+  state.counters["statements"] = (double)ranges.size();
+}
+
+BENCHMARK(BM_determineStatementRanges)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------------------------------------------------
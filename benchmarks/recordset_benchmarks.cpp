@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <benchmark/benchmark.h>
+#include <mysql_driver.h>
+#include <stdlib.h>
+
+#include "base/log.h"
+#include "base/threading.h"
+#include "sqlide/recordset_be.h"
+#include "sqlide/recordset_cdbc_storage.h"
+
+#include "benchmark_fixtures.h"
+
+DEFAULT_LOG_DOMAIN("benchmarks")
+
+// Reading of result sets into recordsets, as done for every query result shown in the SQL editor.
+// These benchmarks need a server, given as WB_BENCHMARK_CONNECTION=user:password@host[:port]. The query creates its
+// rows itself, so no schema is needed on the server. The arguments are the row count and whether the columnar data
+// store is used instead of the sqlite data swap db.
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static sql::Dbc_connection_handler::Ref benchmarkConnection(std::string &error) {
+  static sql::Dbc_connection_handler::Ref handler;
+  static std::string connectError;
+  static bool connected = false;
+
+  if (!connected) {
+    connected = true;
+    const char *setting = getenv("WB_BENCHMARK_CONNECTION");
+    if (setting == nullptr)
+      connectError = "WB_BENCHMARK_CONNECTION is not set";
+    else {
+      std::string value = setting;
+      size_t at = value.rfind('@');
+      std::string account = at == std::string::npos ? "root" : value.substr(0, at);
+      std::string host = at == std::string::npos ? value : value.substr(at + 1);
+      size_t colon = account.find(':');
+      std::string user = account.substr(0, colon);
+      std::string password = colon == std::string::npos ? "" : account.substr(colon + 1);
+      if (host.find(':') == std::string::npos)
+        host += ":3306";
+
+      try {
+        std::shared_ptr<sql::Connection> connection(
+          sql::mysql::get_mysql_driver_instance()->connect("tcp://" + host, user, password));
+        handler = sql::Dbc_connection_handler::Ref(new sql::Dbc_connection_handler());
+        handler->ref = sql::ConnectionWrapper(connection, std::shared_ptr<sql::TunnelConnection>());
+      } catch (sql::SQLException &e) {
+        connectError = std::string("Could not connect to ") + host + ": " + e.what();
+        logError("%s\n", connectError.c_str());
+      }
+    }
+  }
+
+  error = connectError;
+  return handler;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BM_Recordset_cdbc_storage_unserialize(benchmark::State &state) {
+  std::string error;
+  sql::Dbc_connection_handler::Ref handler = benchmarkConnection(error);
+  if (!handler) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+
+  base::RecMutex connectionLock;
+  std::string query = benchmarks::wideResultQuery((size_t)state.range(0));
+  for (auto _ : state) {
+    // The server side of the query is not measured, the driver has the complete result when execute() returns.
+    state.PauseTiming();
+    Recordset_cdbc_storage::Ref storage(Recordset_cdbc_storage::create());
+    storage->setUserConnectionGetter([&](sql::Dbc_connection_handler::Ref &conn, bool) -> base::RecMutexLock {
+      base::RecMutexLock lock(connectionLock, false);
+      conn = handler;
+      return lock;
+    });
+    storage->use_columnar_data(state.range(1) != 0);
+
+    std::shared_ptr<sql::Statement> statement(handler->ref->createStatement());
+    statement->execute(query);
+    std::shared_ptr<sql::ResultSet> result(statement->getResultSet());
+    storage->dbc_statement(statement);
+    storage->dbc_resultset(result);
+
+    Recordset::Ref recordset = Recordset::create();
+    recordset->data_storage(storage);
+    state.ResumeTiming();
+
+    recordset->reset(true);
+    benchmark::DoNotOptimize(recordset->row_count());
+  }
+
+  state.SetItemsProcessed((int64_t)state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Recordset_cdbc_storage_unserialize)
+  ->Args({ 10000, 0 })
+  ->Args({ 10000, 1 })
+  ->Args({ 100000, 1 })
+  ->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "grts/structs.model.h"
+#include "grts/structs.workbench.physical.h"
+
+#include "schema_generator.h"
+
+using namespace benchmarks;
+
+#define FIGURE_WIDTH 200
+#define FIGURE_SPACING 60
+#define FIGURE_ROW_HEIGHT 16 // Per column, figures are sized to show all their columns.
+#define FIGURE_TITLE_HEIGHT 30
+#define FIGURE_COLOR "#98BFDA"
+
+namespace {
+  // The order is used for the random column types, new types go at the end to keep existing fixtures unchanged.
+  enum ColumnType { TypeInt, TypeVarchar, TypeDecimal, TypeDatetime, TypeText, TypeBigint, TypeCount };
+  const char *typeNames[TypeCount] = { "INT", "VARCHAR", "DECIMAL", "DATETIME", "TEXT", "BIGINT" };
+
+  class CatalogGenerator {
+  public:
+    CatalogGenerator(const SchemaOptions &options) : _options(options), _random(options.seed) {
+    }
+
+    db_mysql_CatalogRef run() {
+      db_mysql_CatalogRef catalog(grt::Initialized);
+      catalog->name("generated");
+      for (size_t i = 0; i < TypeCount; ++i) {
+        db_mysql_SimpleDatatypeRef datatype(grt::Initialized);
+        datatype->owner(catalog);
+        datatype->name(typeNames[i]);
+        catalog->simpleDatatypes().insert(datatype);
+        _datatypes.push_back(datatype);
+      }
+
+      for (size_t s = 0; s < _options.schemas; ++s) {
+        db_mysql_SchemaRef schema(grt::Initialized);
+        schema->owner(catalog);
+        schema->name("schema_" + std::to_string(s));
+        schema->defaultCharacterSetName("utf8mb4");
+        catalog->schemata().insert(schema);
+
+        for (size_t t = 0; t < _options.tablesPerSchema; ++t)
+          addTable(schema, t);
+        for (size_t r = 0; r < _options.routinesPerSchema; ++r)
+          addRoutine(schema, r);
+      }
+      return catalog;
+    }
+
+  private:
+    SchemaOptions _options;
+    std::mt19937 _random; // Its output is defined by the standard, unlike that of the distributions.
+    std::vector<db_mysql_SimpleDatatypeRef> _datatypes;
+
+    db_mysql_ColumnRef addColumn(db_mysql_TableRef table, const std::string &name, size_t type) {
+      db_mysql_ColumnRef column(grt::Initialized);
+      column->owner(table);
+      column->name(name);
+      column->simpleType(_datatypes[type]);
+      if (type == TypeVarchar)
+        column->length(64);
+      else if (type == TypeDecimal) {
+        column->precision(10);
+        column->scale(2);
+      }
+      table->addColumn(column);
+      return column;
+    }
+
+    void addTable(db_mysql_SchemaRef schema, size_t number) {
+      bool changed = _options.changeEvery > 0 && number % _options.changeEvery == 0;
+
+      db_mysql_TableRef table(grt::Initialized);
+      table->owner(schema);
+      table->name("table_" + std::to_string(number));
+      table->tableEngine("InnoDB");
+      table->comment("Generated table " + std::to_string(number));
+
+      db_mysql_ColumnRef id = addColumn(table, "id", TypeInt);
+      id->isNotNull(1);
+      id->autoIncrement(1);
+      table->addPrimaryKeyColumn(id);
+
+      // Random numbers are drawn for skipped columns too, so a changed catalog matches the unchanged one otherwise.
+      for (size_t i = 1; i < _options.columnsPerTable; ++i) {
+        size_t type = _random() % TypeCount;
+        if (changed && i > 1 && i == _options.columnsPerTable - 1)
+          continue;
+
+        std::string name = changed && i == 3 ? "renamed_3" : "column_" + std::to_string(i);
+        db_mysql_ColumnRef column = addColumn(table, name, type);
+        column->isNotNull(i % 2);
+        column->comment("Column " + std::to_string(i));
+      }
+      if (changed)
+        addColumn(table, "added_column", TypeInt);
+
+      size_t columnCount = table->columns().count();
+      for (size_t i = 0; i < _options.indexesPerTable && columnCount > 1; ++i) {
+        db_mysql_ColumnRef column = table->columns()[1 + i % (columnCount - 1)];
+
+        db_mysql_IndexRef index(grt::Initialized);
+        index->owner(table);
+        index->name("idx_" + std::to_string(number) + "_" + std::to_string(i));
+        index->indexType("INDEX");
+        db_mysql_IndexColumnRef indexColumn(grt::Initialized);
+        indexColumn->owner(index);
+        indexColumn->referencedColumn(column);
+        if (*column->simpleType()->name() == typeNames[TypeText])
+          indexColumn->columnLength(32);
+        index->columns().insert(indexColumn);
+        table->indices().insert(index);
+      }
+
+      for (size_t i = 0; i < _options.foreignKeysPerTable && number > 0; ++i) {
+        db_mysql_TableRef target = schema->tables()[_random() % number];
+        db_mysql_ColumnRef column = addColumn(table, "ref_" + std::to_string(i), TypeInt);
+
+        db_mysql_ForeignKeyRef foreignKey(grt::Initialized);
+        foreignKey->owner(table);
+        foreignKey->name("fk_" + std::to_string(number) + "_" + std::to_string(i));
+        foreignKey->referencedTable(target);
+        foreignKey->columns().insert(column);
+        foreignKey->referencedColumns().insert(target->columns()[0]);
+        foreignKey->deleteRule("CASCADE");
+        foreignKey->updateRule("NO ACTION");
+        table->foreignKeys().insert(foreignKey);
+      }
+
+      schema->tables().insert(table);
+    }
+
+    void addRoutine(db_mysql_SchemaRef schema, size_t number) {
+      std::string name = "routine_" + std::to_string(number);
+      std::string table = schema->tables().count() > 0
+                            ? *schema->tables()[number % schema->tables().count()]->name()
+                            : std::string("dual");
+
+      db_mysql_RoutineRef routine(grt::Initialized);
+      routine->owner(schema);
+      routine->name(name);
+      routine->routineType("procedure");
+      routine->sqlDefinition("CREATE PROCEDURE `" + name + "`(IN threshold INT)\n"
+                             "BEGIN\n"
+                             "  DECLARE total INT DEFAULT 0;\n"
+                             "  SELECT COUNT(*) INTO total FROM `" + table + "` WHERE id > threshold;\n"
+                             "  SELECT total;\n"
+                             "END");
+      schema->routines().insert(routine);
+    }
+  };
+
+  std::string formatType(const db_ColumnRef &column) {
+    std::string type = *column->simpleType()->name();
+    if (type == typeNames[TypeVarchar])
+      type += "(" + std::to_string(*column->length()) + ")";
+    else if (type == typeNames[TypeDecimal])
+      type += "(" + std::to_string(*column->precision()) + "," + std::to_string(*column->scale()) + ")";
+    return type;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+SchemaOptions::SchemaOptions()
+  : schemas(1),
+    tablesPerSchema(100),
+    columnsPerTable(12),
+    indexesPerTable(1),
+    foreignKeysPerTable(1),
+    routinesPerSchema(0),
+    changeEvery(0),
+    seed(1) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+db_mysql_CatalogRef benchmarks::generateCatalog(const SchemaOptions &options) {
+  return CatalogGenerator(options).run();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string benchmarks::generateScript(const db_mysql_CatalogRef &catalog) {
+  std::string script = "-- Generated schema: " + std::to_string(catalog->schemata().count()) + " schemas\n\n";
+
+  for (const db_mysql_SchemaRef &schema : catalog->schemata()) {
+    script += "CREATE SCHEMA IF NOT EXISTS `" + *schema->name() + "` DEFAULT CHARACTER SET utf8mb4;\n";
+    script += "USE `" + *schema->name() + "`;\n\n";
+
+    for (const db_mysql_TableRef &table : schema->tables()) {
+      std::string lines;
+      for (const db_mysql_ColumnRef &column : table->columns()) {
+        lines += "  `" + *column->name() + "` " + formatType(column);
+        if (*column->isNotNull())
+          lines += " NOT NULL";
+        if (*column->autoIncrement())
+          lines += " AUTO_INCREMENT";
+        if (!column->comment().empty())
+          lines += " COMMENT '" + *column->comment() + "'";
+        lines += ",\n";
+      }
+      lines += "  PRIMARY KEY (`id`)";
+
+      for (const db_mysql_IndexRef &index : table->indices()) {
+        if (*index->isPrimary())
+          continue;
+        lines += ",\n  INDEX `" + *index->name() + "` (";
+        for (size_t i = 0; i < index->columns().count(); ++i) {
+          db_IndexColumnRef indexColumn = index->columns()[i];
+          if (i > 0)
+            lines += ", ";
+          lines += "`" + *indexColumn->referencedColumn()->name() + "`";
+          if (*indexColumn->columnLength() > 0)
+            lines += "(" + std::to_string(*indexColumn->columnLength()) + ")";
+        }
+        lines += ")";
+      }
+
+      for (const db_mysql_ForeignKeyRef &foreignKey : table->foreignKeys()) {
+        lines += ",\n  CONSTRAINT `" + *foreignKey->name() + "` FOREIGN KEY (`" + *foreignKey->columns()[0]->name() +
+                 "`) REFERENCES `" + *foreignKey->referencedTable()->owner()->name() + "`.`" +
+                 *foreignKey->referencedTable()->name() + "` (`" + *foreignKey->referencedColumns()[0]->name() +
+                 "`) ON DELETE " + *foreignKey->deleteRule() + " ON UPDATE " + *foreignKey->updateRule();
+      }
+
+      script += "CREATE TABLE IF NOT EXISTS `" + *table->name() + "` (\n" + lines + "\n) ENGINE = " +
+                *table->tableEngine() + " COMMENT = '" + *table->comment() + "';\n\n";
+    }
+
+    if (schema->routines().count() > 0) {
+      script += "DELIMITER $$\n";
+      for (const db_mysql_RoutineRef &routine : schema->routines())
+        script += *routine->sqlDefinition() + "$$\n\n";
+      script += "DELIMITER ;\n\n";
+    }
+  }
+
+  return script;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+workbench_DocumentRef benchmarks::generateDocument(const db_mysql_CatalogRef &catalog, size_t tablesPerDiagram) {
+  workbench_DocumentRef document(grt::Initialized);
+  document->name("Generated Model");
+
+  workbench_physical_ModelRef model(grt::Initialized);
+  model->owner(document);
+  model->catalog(catalog);
+  catalog->owner(model);
+  document->physicalModels().insert(model);
+
+  std::vector<db_mysql_TableRef> tables;
+  for (const db_mysql_SchemaRef &schema : catalog->schemata())
+    for (const db_mysql_TableRef &table : schema->tables())
+      tables.push_back(table);
+
+  if (tablesPerDiagram == 0)
+    tablesPerDiagram = tables.size();
+
+  for (size_t first = 0; first < tables.size(); first += tablesPerDiagram) {
+    size_t count = std::min(tablesPerDiagram, tables.size() - first);
+
+    // Figures are placed in a square grid, each row as high as its tallest figure.
+    size_t gridColumns = (size_t)std::ceil(std::sqrt((double)count));
+    std::vector<double> heights;
+    for (size_t i = 0; i < count; ++i) {
+      double height = FIGURE_TITLE_HEIGHT + FIGURE_ROW_HEIGHT * (double)tables[first + i]->columns().count();
+      if (i % gridColumns == 0)
+        heights.push_back(height);
+      else
+        heights.back() = std::max(heights.back(), height);
+    }
+    double diagramHeight = FIGURE_SPACING;
+    for (double height : heights)
+      diagramHeight += height + FIGURE_SPACING;
+    double diagramWidth = FIGURE_SPACING + (double)gridColumns * (FIGURE_WIDTH + FIGURE_SPACING);
+
+    workbench_physical_DiagramRef diagram(grt::Initialized);
+    diagram->owner(model);
+    diagram->name("EER Diagram " + std::to_string(first / tablesPerDiagram + 1));
+    diagram->width(diagramWidth);
+    diagram->height(diagramHeight);
+    diagram->zoom(1);
+
+    model_LayerRef layer(grt::Initialized);
+    layer->owner(diagram);
+    layer->name("Layer");
+    layer->width(diagramWidth);
+    layer->height(diagramHeight);
+    diagram->rootLayer(layer);
+
+    std::map<std::string, workbench_physical_TableFigureRef> figures; // By table id.
+    double top = FIGURE_SPACING;
+    for (size_t i = 0; i < count; ++i) {
+      db_mysql_TableRef table = tables[first + i];
+      if (i > 0 && i % gridColumns == 0)
+        top += heights[i / gridColumns - 1] + FIGURE_SPACING;
+
+      workbench_physical_TableFigureRef figure(grt::Initialized);
+      figure->owner(diagram);
+      figure->layer(layer);
+      figure->name(table->name());
+      figure->left(FIGURE_SPACING + (double)(i % gridColumns) * (FIGURE_WIDTH + FIGURE_SPACING));
+      figure->top(top);
+      figure->width(FIGURE_WIDTH);
+      figure->height(FIGURE_TITLE_HEIGHT + FIGURE_ROW_HEIGHT * (double)table->columns().count());
+      figure->color(FIGURE_COLOR);
+      figure->table(table);
+      diagram->figures().insert(figure);
+      layer->figures().insert(figure);
+      figures[table->id()] = figure;
+    }
+
+    for (auto &entry : figures) {
+      db_TableRef table = entry.second->table();
+      for (const db_ForeignKeyRef &foreignKey : table->foreignKeys()) {
+        auto target = figures.find(foreignKey->referencedTable()->id());
+        if (target == figures.end())
+          continue;
+
+        workbench_physical_ConnectionRef connection(grt::Initialized);
+        connection->owner(diagram);
+        connection->name(foreignKey->name());
+        connection->foreignKey(foreignKey);
+        connection->startFigure(entry.second);
+        connection->endFigure(target->second);
+        diagram->connections().insert(connection);
+      }
+    }
+
+    model->diagrams().insert(diagram);
+  }
+
+  return document;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
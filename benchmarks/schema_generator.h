@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+// Generator for large schemas, for benchmarks and scale tests. The same options always give the same catalog, so
+// results of different runs and builds can be compared.
+
+#include <string>
+
+#include "grts/structs.db.mysql.h"
+#include "grts/structs.workbench.h"
+
+namespace benchmarks {
+
+  struct SchemaOptions {
+    size_t schemas;
+    size_t tablesPerSchema;
+    size_t columnsPerTable;     // Including the id column, without the foreign key columns.
+    size_t indexesPerTable;     // Secondary indexes, besides the primary key.
+    size_t foreignKeysPerTable; // Each to the id of a random table created before in the same schema.
+    size_t routinesPerSchema;
+    size_t changeEvery;         // When not 0, every n-th table gets a renamed, an added and a dropped column.
+    unsigned int seed;          // For the column types and the foreign key targets.
+
+    SchemaOptions();
+  };
+
+  // Builds a catalog as described by the options. GRT must be initialized (see initGrt()).
+  db_mysql_CatalogRef generateCatalog(const SchemaOptions &options);
+
+  // Creates a script with the DDL for the given catalog, in creation order so that it can be run on a server.
+  std::string generateScript(const db_mysql_CatalogRef &catalog);
+
+  // Creates a model document for the catalog, with EER diagrams of at most tablesPerDiagram figures each and a
+  // connection for every foreign key between tables on the same diagram.
+  workbench_DocumentRef generateDocument(const db_mysql_CatalogRef &catalog, size_t tablesPerDiagram);
+
+} // namespace benchmarks
@@ -824,6 +824,16 @@ mforms::View *PreferencesForm::create_sqlide_page() {
 
     entry = otable->add_entry_option("DbSqlEditor:ConnectionTimeOut", _("DBMS connection time out (in seconds):"),
                                      _("Maximum time to wait before a connection attempt is aborted."));
+
+    entry = otable->add_entry_option("DbSqlEditor:MetadataConnections", _("Connections for loading meta data:"),
+                                     _("Number of extra connections (1 to 4) used to load the schema tree and code "
+                                       "completion data. With more than one, object details you ask for don't wait for "
+                                       "background loading. Applies to new connections."));
+
+    otable->add_checkbox_option("DbSqlEditor:PreconnectOnHover", _("Connect ahead when hovering a connection tile"),
+                                _("Open the connections of a SQL editor in the background while the mouse is over "
+                                  "its tile on the home screen, so the editor opens faster. Not done for connections "
+                                  "over SSH or without a stored password."));
     box->add(otable, false, true);
   }
 
@@ -1152,6 +1162,21 @@ mforms::View *PreferencesForm::create_query_page() {
       vbox->add(check, false);
     }
 
+    {
+      mforms::Box *tbox = mforms::manage(new mforms::Box(true));
+      tbox->set_spacing(4);
+      vbox->add(tbox, false);
+
+      tbox->add(new_label(_("Max. statements to send in one batch:"), true), false, false);
+      mforms::TextEntry *entry = new_entry_option("DbSqlEditor:StatementBatchSize", false);
+      entry->set_size(50, -1);
+      entry->set_tooltip(
+        _("Consecutive INSERT, UPDATE and DELETE statements of a script are sent to the server together, with a "
+          "single entry in the output.\n"
+          "Set to 0 or 1 to run each statement on its own."));
+      tbox->add(entry, false, false);
+    }
+
     {
       mforms::CheckBox *check= new_checkbox_option("DbSqlEditor:AutocommitMode");
       check->set_text(_("New connections use auto commit mode"));
@@ -1222,6 +1247,21 @@ mforms::View *PreferencesForm::create_query_page() {
       tbox->add(entry, false, false);
     }
 
+    {
+      mforms::Box *tbox = mforms::manage(new mforms::Box(true));
+      tbox->set_spacing(4);
+      vbox->add(tbox, false);
+
+      tbox->add(new_label(_("Max. Results Memory (in MB):"), true), false, false);
+      mforms::TextEntry *entry = new_entry_option("SqlEditor:ResultMemoryBudget", false);
+      entry->set_size(50, -1);
+      entry->set_tooltip(
+        _("Memory the results of all editor tabs may take together. Results not viewed for the longest time are "
+          "moved to their temporary SQLite databases when it's exceeded.\n"
+          "Set to 0 for no limit."));
+      tbox->add(entry, false, false);
+    }
+
     {
       mforms::CheckBox *check = new_checkbox_option("DbSqlEditor:MySQL:TreatBinaryAsText");
       check->set_text(_("Treat BINARY/VARBINARY as nonbinary character string"));
@@ -1251,6 +1291,48 @@ mforms::View *PreferencesForm::create_query_page() {
       vbox->add(check, false);
     }
 
+    {
+      mforms::CheckBox *check = new_checkbox_option("SqlEditor:InMemoryReadOnlyResults");
+      check->set_text(_("Keep Read-Only Results in Memory"));
+      check->set_tooltip(_("Whether results that can't be edited are kept in memory instead of a temporary SQLite "
+                           "database. Makes scrolling and sorting faster."));
+      vbox->add(check, false);
+    }
+
+    {
+      mforms::CheckBox *check = new_checkbox_option("SqlEditor:ServerSideSortFilter");
+      check->set_text(_("Sort and Filter Table Data on the Server"));
+      check->set_tooltip(_("Whether sorting and filtering the rows of a single table result re-executes its query "
+                           "with ORDER BY and WHERE clauses, instead of working on only the rows fetched so far."));
+      vbox->add(check, false);
+    }
+
+    {
+      mforms::CheckBox *check = new_checkbox_option("SqlEditor:KeysetPaging");
+      check->set_text(_("Fetch More Table Rows when Scrolling"));
+      check->set_tooltip(_("Whether Select Rows results are ordered by primary key and the rows following the limited "
+                           "first page are fetched page by page when the grid is scrolled to the end."));
+      vbox->add(check, false);
+    }
+
+    {
+      mforms::CheckBox *check = new_checkbox_option("SqlEditor:PreparedReloads");
+      check->set_text(_("Refresh Results with Prepared Statements"));
+      check->set_tooltip(_("Whether refreshing, sorting or filtering on the server and fetching more rows of a result "
+                           "re-execute its query as a prepared statement. Numbers and dates are then transferred in "
+                           "binary, which is faster for results with many numeric columns."));
+      vbox->add(check, false);
+    }
+
+    {
+      mforms::CheckBox *check = new_checkbox_option("Recordset:OptimizeBlobFetching");
+      check->set_text(_("Fetch Large Values on Demand"));
+      check->set_tooltip(_("Whether BLOB, TEXT and JSON values of table results are shown by size and start only, "
+                           "the whole value is fetched when it's opened in the value editor. Exported rows contain "
+                           "the shortened values."));
+      vbox->add(check, false);
+    }
+
     /*{
      mforms::CheckBox *check= new_checkbox_option("DbSqlEditor:IsLiveObjectAlterationWizardEnabled");
      check->set_text(_("Enable Live Object Alteration Wizard"));
@@ -1302,6 +1384,16 @@ mforms::View *PreferencesForm::create_model_page() {
                           "and slow down operation."));
     }
 
+    {
+      mforms::TextEntry *entry = new_numeric_entry_option("workbench:UndoMemoryLimit", 0, 65536);
+      entry->set_max_length(5);
+      entry->set_size(100, -1);
+
+      table->add_option(entry, _("Model undo history memory limit (MB):"),
+                        _("The oldest undo steps are discarded when the undo history is estimated to use more "
+                          "memory than this. Set to 0 to disable the limit."));
+    }
+
     {
       static const char *auto_save_intervals =
         "disable:0,10 seconds:10,15 seconds:15,30 seconds:30,1 minute:60,5 minutes:300,10 minutes:600,20 minutes:1200";
@@ -1311,6 +1403,14 @@ mforms::View *PreferencesForm::create_model_page() {
                         _("Interval to perform auto-saving of the open model. The model will be restored from the last "
                           "auto-saved version if Workbench unexpectedly quits."));
     }
+
+    {
+      static const char *compression_levels = "no compression:0,fastest:1,default:6,smallest file:9";
+      mforms::Selector *sel = new_selector_option("workbench:ModelCompressionLevel", compression_levels, true);
+
+      table->add_option(sel, _("Model file compression:"),
+                        _("How much model files are compressed when saved. Already compressed images are stored as they are."));
+    }
   }
   return top_box;
 }
@@ -1373,6 +1473,19 @@ mforms::View* PreferencesForm::createSSHPage()
           _("SSH Command Retry count."));
       }
 
+      // SSH session idle timeout
+      {
+        mforms::TextEntry *entry = new_numeric_entry_option("SSH:sessionIdleTimeout", 0, 3600);
+        entry->set_max_length(5);
+        entry->set_size(50, -1);
+        entry->set_tooltip(_(
+          "Determines how long an SSH session is kept open after its last tunnel was closed,\n"
+          "so that new connections to the same SSH server and user can reuse it without logging in again"));
+
+        timeouts_table->add_option(entry, _("SSH Session Idle Timeout:"),
+          _("SSH Session Idle Timeout in seconds."));
+      }
+
       // SSH buffer
       {
         mforms::TextEntry *entry = new_numeric_entry_option("SSH:BufferSize", 0, 500);
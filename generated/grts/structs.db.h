@@ -2110,6 +2110,8 @@ obj.userType = value
   virtual void init();
 
 protected:
+  virtual void member_value_changed(const std::string &name, const grt::ValueRef &ovalue);
+
   grt::StringRef _characterSetName;
   grt::ListRef<db_CheckConstraint> _checks; // owned
   grt::StringRef _collationName;
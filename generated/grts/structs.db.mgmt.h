@@ -61,6 +61,7 @@ public:
   db_mgmt_SyncProfile(grt::MetaClass *meta = 0)
     : GrtObject(meta ? meta : grt::GRT::get()->get_metaclass(static_class_name())),
       _lastKnownDBNames(this, false),
+      _lastKnownFingerprints(this, false),
       _lastKnownViewDefinitions(this, false),
       _lastSyncDate(""),
       _targetHostIdentifier(""),
@@ -90,6 +91,25 @@ private: // the next attribute is read-only
     member_changed("lastKnownDBNames", ovalue, value);
   }
 
+public:
+  /** Getter for attribute lastKnownFingerprints (read-only)
+
+    dictionary of table name to the fingerprints of the model and server table definitions last found equal during
+synchronization. Tables whose fingerprints still match are not compared again.
+   \par In Python:
+value = obj.lastKnownFingerprints
+   */
+  grt::DictRef lastKnownFingerprints() const {
+    return _lastKnownFingerprints;
+  }
+
+private: // the next attribute is read-only
+  virtual void lastKnownFingerprints(const grt::DictRef &value) {
+    grt::ValueRef ovalue(_lastKnownFingerprints);
+    _lastKnownFingerprints = value;
+    member_changed("lastKnownFingerprints", ovalue, value);
+  }
+
 public:
   /** Getter for attribute lastKnownViewDefinitions (read-only)
 
@@ -176,6 +196,7 @@ obj.targetSchemaName = value
 
 protected:
   grt::DictRef _lastKnownDBNames;
+  grt::DictRef _lastKnownFingerprints;
   grt::DictRef _lastKnownViewDefinitions;
   grt::StringRef _lastSyncDate;
   grt::StringRef _targetHostIdentifier;
@@ -198,6 +219,12 @@ public:
       meta->bind_member("lastKnownDBNames",
                         new grt::MetaClass::Property<db_mgmt_SyncProfile, grt::DictRef>(getter, setter));
     }
+    {
+      void (db_mgmt_SyncProfile::*setter)(const grt::DictRef &) = &db_mgmt_SyncProfile::lastKnownFingerprints;
+      grt::DictRef (db_mgmt_SyncProfile::*getter)() const = &db_mgmt_SyncProfile::lastKnownFingerprints;
+      meta->bind_member("lastKnownFingerprints",
+                        new grt::MetaClass::Property<db_mgmt_SyncProfile, grt::DictRef>(getter, setter));
+    }
     {
       void (db_mgmt_SyncProfile::*setter)(const grt::DictRef &) = &db_mgmt_SyncProfile::lastKnownViewDefinitions;
       grt::DictRef (db_mgmt_SyncProfile::*getter)() const = &db_mgmt_SyncProfile::lastKnownViewDefinitions;
@@ -1363,6 +1363,11 @@ obj.sidebar = value
 
    */
   virtual void alterLiveObject(const std::string &type, const std::string &schemaName, const std::string &objectName);
+  /** Method. Removes the stored statement statistics of this connection
+  \return
+
+   */
+  virtual void clearQueryStatistics();
   /** Method. executes a SELECT statement on the table and returns an editable resultset that can be used to modify its
   contents
   \param schema name of the table schema
@@ -1424,6 +1429,21 @@ obj.sidebar = value
 
    */
   virtual grt::IntegerRef executeScriptAndOutputToGrid(const std::string &sql);
+  /** Method. Imports the next part of a CSV or JSON file into a table over the aux connection and returns how far it
+  got, call again with the returned position until done is set
+  \param options file, format, target table and column mapping, and the position to continue from
+  \return position, size, rows, failed, error and done
+
+   */
+  virtual grt::DictRef importTableData(const grt::DictRef &options);
+  /** Method. Returns the performance schema statistics of the statements run in the editors of this connection,
+  aggregated by statement digest over all sessions, most expensive first
+  \param order total, average, max or rows_examined
+  \param limit
+  \return statement, count, times in seconds, rows and temporary tables of each digest
+
+   */
+  virtual grt::DictListRef queryStatistics(const std::string &order, ssize_t limit);
 
   ImplData *get_data() const {
     return _data;
@@ -1463,6 +1483,11 @@ private: // wrapper methods for use by grt
     return grt::ValueRef();
   }
 
+  static grt::ValueRef call_clearQueryStatistics(grt::internal::Object *self, const grt::BaseListRef &args) {
+    dynamic_cast<db_query_Editor *>(self)->clearQueryStatistics();
+    return grt::ValueRef();
+  }
+
   static grt::ValueRef call_createTableEditResultset(grt::internal::Object *self, const grt::BaseListRef &args) {
     return dynamic_cast<db_query_Editor *>(self)->createTableEditResultset(
       grt::StringRef::cast_from(args[0]), grt::StringRef::cast_from(args[1]), grt::StringRef::cast_from(args[2]),
@@ -1505,6 +1530,15 @@ private: // wrapper methods for use by grt
     return dynamic_cast<db_query_Editor *>(self)->executeScriptAndOutputToGrid(grt::StringRef::cast_from(args[0]));
   }
 
+  static grt::ValueRef call_importTableData(grt::internal::Object *self, const grt::BaseListRef &args) {
+    return dynamic_cast<db_query_Editor *>(self)->importTableData(grt::DictRef::cast_from(args[0]));
+  }
+
+  static grt::ValueRef call_queryStatistics(grt::internal::Object *self, const grt::BaseListRef &args) {
+    return dynamic_cast<db_query_Editor *>(self)->queryStatistics(grt::StringRef::cast_from(args[0]),
+                                                                  grt::IntegerRef::cast_from(args[1]));
+  }
+
 public:
   static void grt_register() {
     grt::MetaClass *meta = grt::GRT::get()->get_metaclass(static_class_name());
@@ -1567,6 +1601,7 @@ public:
     meta->bind_method("addQueryEditor", &db_query_Editor::call_addQueryEditor);
     meta->bind_method("addToOutput", &db_query_Editor::call_addToOutput);
     meta->bind_method("alterLiveObject", &db_query_Editor::call_alterLiveObject);
+    meta->bind_method("clearQueryStatistics", &db_query_Editor::call_clearQueryStatistics);
     meta->bind_method("createTableEditResultset", &db_query_Editor::call_createTableEditResultset);
     meta->bind_method("editLiveObject", &db_query_Editor::call_editLiveObject);
     meta->bind_method("executeCommand", &db_query_Editor::call_executeCommand);
@@ -1575,6 +1610,8 @@ public:
     meta->bind_method("executeQuery", &db_query_Editor::call_executeQuery);
     meta->bind_method("executeScript", &db_query_Editor::call_executeScript);
     meta->bind_method("executeScriptAndOutputToGrid", &db_query_Editor::call_executeScriptAndOutputToGrid);
+    meta->bind_method("importTableData", &db_query_Editor::call_importTableData);
+    meta->bind_method("queryStatistics", &db_query_Editor::call_queryStatistics);
   }
 };
 
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "common.h"
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace base {
+  /**
+   * An immutable string of which every distinct value is stored only once in the process, for identifiers that
+   * repeat a lot, like column names, data types or collations. Copies share the stored text, so copying is a
+   * pointer copy and equal strings compare equal by their pointer.
+   *
+   * The stored texts are kept until the process ends, so only values from a limited set should be interned
+   * (names, not data). Strings can be interned from any thread, the pool is split into shards with their own lock.
+   */
+  class BASELIBRARY_PUBLIC_FUNC InternedString {
+  public:
+    InternedString();
+    InternedString(const std::string &value);
+    InternedString(const char *value);
+
+    const std::string &str() const {
+      return *_value;
+    }
+    operator const std::string &() const {
+      return *_value;
+    }
+    const char *c_str() const {
+      return _value->c_str();
+    }
+    bool empty() const {
+      return _value->empty();
+    }
+    size_t size() const {
+      return _value->size();
+    }
+
+    bool operator==(const InternedString &other) const {
+      return _value == other._value;
+    }
+    bool operator!=(const InternedString &other) const {
+      return _value != other._value;
+    }
+    // Text order, so sorted containers keep the same order as with std::string.
+    bool operator<(const InternedString &other) const {
+      return _value != other._value && *_value < *other._value;
+    }
+
+    size_t hash() const {
+      return std::hash<const void *>()(_value);
+    }
+
+    // The number of distinct strings interned so far and the bytes they use.
+    static void pool_usage(std::int64_t &bytes, std::int64_t &count);
+
+  private:
+    const std::string *_value;
+  };
+
+  inline bool operator==(const InternedString &a, const std::string &b) {
+    return a.str() == b;
+  }
+  inline bool operator==(const std::string &a, const InternedString &b) {
+    return a == b.str();
+  }
+  inline bool operator==(const InternedString &a, const char *b) {
+    return a.str() == b;
+  }
+  inline bool operator==(const char *a, const InternedString &b) {
+    return a == b.str();
+  }
+  inline bool operator!=(const InternedString &a, const std::string &b) {
+    return a.str() != b;
+  }
+  inline bool operator!=(const std::string &a, const InternedString &b) {
+    return a != b.str();
+  }
+  inline bool operator!=(const InternedString &a, const char *b) {
+    return a.str() != b;
+  }
+  inline bool operator!=(const char *a, const InternedString &b) {
+    return a != b.str();
+  }
+
+  inline std::ostream &operator<<(std::ostream &stream, const InternedString &value) {
+    return stream << value.str();
+  }
+} // namespace base
+
+namespace std {
+  template <>
+  struct hash<base::InternedString> {
+    size_t operator()(const base::InternedString &value) const {
+      return value.hash();
+    }
+  };
+}
@@ -26,6 +26,8 @@
 #include "common.h"
 
 #include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace JsonParser {
@@ -33,6 +35,9 @@ namespace JsonParser {
   enum DataType { VBoolean, VString, VDouble, VInt64, VUint64, VObject, VArray, VEmpty };
 
   class JsonValue;
+  class JsonReader;
+  struct JsonTape;
+
   class BASELIBRARY_PUBLIC_FUNC JsonObject {
   public:
     typedef std::map<std::string, JsonValue> Container;
@@ -134,6 +139,12 @@ namespace JsonParser {
     Container _data;
   };
 
+  /**
+   * Objects and arrays read by JsonReader are built on first access only: until then they keep a reference to the
+   * document text and where they are in it. Casting such a value to JsonObject or JsonArray builds that one level,
+   * its own objects and arrays stay unbuilt. getType() can be used without building anything.
+   * As building changes the value even through const access, a value must not be used by several threads at once.
+   */
   class BASELIBRARY_PUBLIC_FUNC JsonValue {
   public:
     JsonValue();
@@ -211,13 +222,21 @@ namespace JsonParser {
     bool isValid();
 
   private:
+    friend class JsonReader;
+
+    void materialize() const;
+
     double _double;
     int64_t _integer64;
     uint64_t _uinteger64;
     bool _bool;
     std::string _string;
-    JsonObject _object;
-    JsonArray _array;
+    mutable JsonObject _object;
+    mutable JsonArray _array;
+
+    // Set while the object or array is not built yet.
+    mutable std::shared_ptr<const JsonTape> _tape;
+    size_t _tapeIndex;
 
     DataType _type;
     bool _deleted;
@@ -262,69 +281,62 @@ namespace JsonParser {
 #endif
 
   class BASELIBRARY_PUBLIC_FUNC JsonReader {
-    struct JsonToken {
-      enum JsonTokenType {
-        JsonTokenString,
-        JsonTokenNumber,
-        JsonTokenBoolean,
-        JsonTokenEmpty,
-        JsonTokenObjectStart,
-        JsonTokenObjectEnd,
-        JsonTokenArrayStart,
-        JsonTokenArrayEnd,
-        JsonTokenNext,
-        JsonTokenAssign,
-      };
-
-      JsonToken(JsonTokenType type, const std::string &value) : _type(type), _value(value) {
+  public:
+    /**
+     * Receives the elements of a document from parse(), in the order of the text. Scalars are converted as read()
+     * converts them and the name of an object member comes right before its value. An exception thrown by a handler
+     * stops the parsing.
+     */
+    class BASELIBRARY_PUBLIC_FUNC Handler {
+    public:
+      virtual ~Handler() {
       }
-      JsonTokenType getType() const {
-        return _type;
+      virtual void objectStart() {
       }
-      const std::string &getValue() const {
-        return _value;
+      virtual void objectEnd() {
+      }
+      virtual void arrayStart() {
+      }
+      virtual void arrayEnd() {
+      }
+      virtual void key(const std::string &name) {
+      }
+      virtual void value(const JsonValue &value) {
       }
-
-    private:
-      JsonTokenType _type;
-      std::string _value;
     };
 
-  public:
-    typedef std::vector<JsonToken> Tokens;
-    typedef Tokens::const_iterator TokensConstIterator;
+    // The whole text is checked, but objects and arrays are only built when accessed (see JsonValue).
     static void read(const std::string &text, JsonValue &value);
     static void readFromFile(const std::string &path, JsonValue &value);
+    // Checks the text like read() does, but passes the elements to the handler instead of building values.
+    static void parse(const std::string &text, Handler &handler);
     explicit JsonReader(const std::string &text);
 
   private:
-    char peek();
-    bool eos();
+    friend class JsonValue;
+
+    JsonReader(const char *text, size_t length);
+    JsonReader(const std::shared_ptr<const JsonTape> &tape, size_t position);
+
     void eatWhitespace();
-    void moveAhead();
-    static bool isWhiteSpace(char c);
-    std::string getJsonNumber();
+    std::string tokenText() const;
+    void checkStringStart();
     std::string getJsonString();
-    bool match(const std::string &text);
-    bool processToken(JsonToken::JsonTokenType type, bool skip = false, bool mustMatch = true);
-    void checkJsonEmpty(const std::string &text = "null");
-    std::string getJsonBoolean();
-    void scan();
-    void parse(JsonObject &obj);
+    void skipJsonString();
+    void skipJsonNumber();
     void parseNumber(JsonValue &value);
-    void parseBoolean(JsonValue &value);
-    void parseString(JsonValue &value);
-    void parseEmpty(JsonValue &value);
-    void parseObject(JsonValue &value);
-    void parseArray(JsonValue &value);
-    void parse(JsonValue &value);
+    void parseLiteral(JsonValue *value);
+    void parseScalar(JsonValue *value);
+    void scan(JsonTape *tape, Handler *handler);
+    void parseMembers(JsonObject &object, size_t index);
+    void parseElements(JsonArray &array, size_t index);
+    void parseElement(JsonValue &value, size_t &index);
 
     // members
-    std::string _jsonText;
-    std::string::size_type _actualPos;
-    Tokens _tokens;
-    TokensConstIterator _tokenIterator;
-    TokensConstIterator _tokenEnd;
+    std::shared_ptr<const JsonTape> _tape;
+    const char *_begin;
+    const char *_end;
+    const char *_actualPos;
   };
 
   class BASELIBRARY_PUBLIC_FUNC JsonWriter {
@@ -114,6 +114,10 @@ namespace base {
 
     static void log_to_stderr(bool value);
 
+    static void async_mode(bool value);
+    static bool async_mode();
+    static void flush();
+
     static const std::string& logLevelName(std::size_t index) {
       return _logLevelNames[index];
     }
@@ -23,16 +23,44 @@
 
 #pragma once
 
-#ifdef _WIN32
-
 #include "common.h"
 
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
 namespace base {
+#ifdef _WIN32
   struct BASELIBRARY_PUBLIC_FUNC MemUsage {
   public:
     static void StartCounting();
     static void PrintUsage();
   };
-}
-
 #endif
+
+  /**
+   * Accounts the memory held by the subsystems of the application (result sets, GRT objects, canvas caches...).
+   * A subsystem registers a function that measures what it currently holds, which is called whenever a report
+   * is made, so nothing is counted on the allocation paths. Sources with the same name are summed up.
+   * Where only the number of items is known, e.g. GRT objects, the bytes are reported as 0.
+   */
+  class BASELIBRARY_PUBLIC_FUNC MemoryAccounting {
+  public:
+    struct Usage {
+      std::string name;
+      std::int64_t bytes;
+      std::int64_t items;
+    };
+    typedef std::function<void(Usage &usage)> Measure;
+
+    // Returns an id for remove_source().
+    static int add_source(const std::string &name, const Measure &measure);
+    static void remove_source(int id);
+
+    // The usage of all sources by name, highest bytes first.
+    static std::vector<Usage> usage();
+    // usage() as a text table.
+    static std::string report();
+  };
+}
@@ -27,6 +27,7 @@
 #include "base/string_utilities.h"
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits/is_signed.hpp>
+#include <cstdio>
 #include <stdexcept>
 
 namespace base {
@@ -42,14 +43,18 @@ namespace base {
     };
 
   private:
+    // Values are written straight into _formatted, the format string is only copied once and walked with
+    // _format_position, so formatting a query costs about one allocation for its result.
     std::string _formatted;
-    std::string _format_string_left;
+    std::string _format_string;
+    std::string::size_type _format_position; // start of the format string part not formatted yet
     sqlstringformat _format;
 
-    std::string consume_until_next_escape();
+    void append_until_next_escape();
     int next_escape();
 
-    sqlstring &append(const std::string &s);
+    void append_quoted(const char *data, size_t length);
+    void append_identifier(const char *data, size_t length);
 
   public:
     static const sqlstring null;
@@ -71,9 +76,13 @@ namespace base {
       if (esc != '?')
         throw std::invalid_argument("Error formatting SQL query: invalid escape for numeric argument");
 
-      const char *format = (sizeof(T) <= sizeof(int32_t) ? "%i" : "%lli");
-      append(strfmt(format, value));
-      append(consume_until_next_escape());
+      char buffer[32];
+      if (sizeof(T) <= sizeof(int32_t))
+        snprintf(buffer, sizeof(buffer), "%i", (int)value);
+      else
+        snprintf(buffer, sizeof(buffer), "%lli", (long long)value);
+      _formatted.append(buffer);
+      append_until_next_escape();
       return *this;
     }
     //! replaces a ? in the format string with a float numeric value
@@ -52,6 +52,7 @@ namespace base {
 
   BASELIBRARY_PUBLIC_FUNC std::wstring string_to_wstring(const std::string &s);
   BASELIBRARY_PUBLIC_FUNC std::string wstring_to_string(const std::wstring &s);
+  BASELIBRARY_PUBLIC_FUNC size_t wide_to_utf8_buffer(const wchar_t *data, size_t length, char *out, size_t out_size);
 #ifdef _WIN32
   BASELIBRARY_PUBLIC_FUNC std::wstring path_from_utf8(const std::string &s);
 #else
@@ -70,6 +71,11 @@ namespace base {
   BASELIBRARY_PUBLIC_FUNC std::string trim(const std::string &s, const std::string &t = SPACES);
   BASELIBRARY_PUBLIC_FUNC std::string tolower(const std::string &s);
   BASELIBRARY_PUBLIC_FUNC std::string toupper(const std::string &s);
+
+  // Fast paths for text without any non-ASCII character (and no NUL), where no GLib Unicode handling is needed.
+  BASELIBRARY_PUBLIC_FUNC bool is_ascii(const char *data, size_t length);
+  BASELIBRARY_PUBLIC_FUNC void ascii_tolower(char *data, size_t length); // In place, other bytes are kept.
+  BASELIBRARY_PUBLIC_FUNC void ascii_toupper(char *data, size_t length);
   BASELIBRARY_PUBLIC_FUNC std::string truncate_text(const std::string &s, int max_length);
   BASELIBRARY_PUBLIC_FUNC std::string sanitize_utf8(const std::string &s);
 
@@ -91,6 +97,8 @@ namespace base {
 
   BASELIBRARY_PUBLIC_FUNC std::string escape_sql_string(const std::string &string,
                                                         bool wildcards = false); // "strings" or 'strings'
+  BASELIBRARY_PUBLIC_FUNC size_t escape_sql_buffer(const char *data, size_t length, char *out,
+                                                   bool wildcards = false); // out needs 2 * length bytes
   BASELIBRARY_PUBLIC_FUNC std::string escape_json_string(const std::string &string);
   BASELIBRARY_PUBLIC_FUNC std::string unescape_sql_string(const std::string &string, char escape_char);
   BASELIBRARY_PUBLIC_FUNC std::string escape_backticks(const std::string &string); // `identifier`
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "common.h"
+
+#include <functional>
+
+namespace base {
+  // The order is also the order in which waiting tasks are started.
+  enum TaskPriority {
+    TaskInteractive, // Work the user waits for, like syntax checks while typing.
+    TaskBackground,  // Timers, GRT tasks of the editors and other work that should be done soon.
+    TaskBulk         // Prefetching, imports and other large jobs nobody is waiting on.
+  };
+
+  /**
+   * A pool of worker threads shared by all background work of the application. Every worker has its own queue,
+   * tasks posted from a worker go there and idle workers steal from the others. Tasks posted from other threads
+   * go to a shared queue. Higher priority tasks are always started first and one worker only runs interactive
+   * tasks, so those never wait for a bulk job to finish.
+   *
+   * Tasks must not wait on each other. A task that may block for long (network, main thread) must do so within a
+   * BlockingScope, which lets the scheduler start another worker while it waits.
+   */
+  class BASELIBRARY_PUBLIC_FUNC TaskScheduler {
+  public:
+    typedef std::function<void()> Task;
+
+    // The scheduler is created on first use and lives until the process exits.
+    static TaskScheduler *get();
+
+    // Exceptions thrown by the task are logged and otherwise ignored.
+    void post(TaskPriority priority, const Task &task);
+
+    // Calls body(0) ... body(count - 1) in parallel, the calling thread takes part, and returns when all calls
+    // are done. The first exception thrown by any of them is rethrown here.
+    void run_parallel(TaskPriority priority, size_t count, const std::function<void(size_t)> &body);
+
+    size_t thread_count() const;
+
+    class BASELIBRARY_PUBLIC_FUNC BlockingScope {
+    public:
+      BlockingScope();
+      ~BlockingScope();
+
+    private:
+      bool _counted; // False when not on a worker thread.
+
+      BlockingScope(const BlockingScope &) = delete;
+      BlockingScope &operator=(const BlockingScope &) = delete;
+    };
+
+    class Private;
+
+  private:
+    Private *_d;
+
+    TaskScheduler();
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+  };
+} // namespace base
@@ -74,7 +74,6 @@ public:
 
 private:
   base::Mutex _timer_lock; // Synchronize access to the timer class.
-  GThreadPool* _pool;      // A number of threads which trigger the callbacks (to make them independant of each other).
   int _wait_time;          // The time the timer thread has to wait until looking for new tasks to execute.
   bool _terminate;         // Set to true when shutting down the timer.
   int _next_id;            // A counter for task ids.
@@ -82,13 +81,17 @@ private:
   GThread* _thread; // This thread loops endlessly executing tasks as they come in.
   TaskList _tasks;
 
+  class Wakeup;     // Lets the timer thread sleep until the next task is due instead of polling.
+  Wakeup* _wakeup;
+
   ThreadedTimer(int base_frequency);
   ~ThreadedTimer();
 
   static gpointer start(gpointer data);
-  static gpointer pool_function(gpointer data, gpointer user_data);
+  void run_task(TimerTask* task);
   void main_loop();
   void remove(int task_id);
+  void wake();
 };
 
 #endif // _THREADED_TIMER_H_
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "common.h"
+
+#include <cstdint>
+#include <string>
+
+namespace base {
+  /**
+   * Records spans of wall time and writes them in the Chrome trace event format, which chrome://tracing and
+   * Perfetto load. Span names and categories must be string literals, only their pointers are stored.
+   * Every thread records into its own buffer, so recording threads don't wait for each other.
+   *
+   * Tracing is off by default, a span then costs a single flag check. Setting WB_TRACE_FILE to a path starts
+   * tracing when the base library loads and writes the trace there at exit (%p in the path is the process id).
+   */
+  class BASELIBRARY_PUBLIC_FUNC Tracer {
+  public:
+    static bool enabled() {
+      return _enabled;
+    }
+    static void start();
+    static void stop();
+    static void clear();
+
+    // Writes all recorded spans, returns false if the file could not be written.
+    static bool write(const std::string &path);
+
+    // Monotonic time in nanoseconds.
+    static std::uint64_t now();
+    static void record(const char *category, const char *name, std::uint64_t start, std::uint64_t end);
+
+  private:
+    static volatile bool _enabled;
+  };
+
+  // Records the time from its construction to its destruction as a span.
+  class TraceSpan {
+  public:
+    TraceSpan(const char *category, const char *name)
+      : _category(category), _name(name), _start(Tracer::enabled() ? Tracer::now() : 0) {
+    }
+    ~TraceSpan() {
+      if (_start != 0)
+        Tracer::record(_category, _name, _start, Tracer::now());
+    }
+
+  private:
+    const char *_category;
+    const char *_name;
+    std::uint64_t _start;
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+  };
+} // namespace base
+
+#define BASE_TRACE_CONCAT2(a, b) a##b
+#define BASE_TRACE_CONCAT(a, b) BASE_TRACE_CONCAT2(a, b)
+
+// Traces the rest of the enclosing scope.
+#define TRACE_SPAN(category, name) base::TraceSpan BASE_TRACE_CONCAT(trace_span_, __LINE__)(category, name)
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/interned_string.h"
+#include "base/mem_stat.h"
+
+#include <mutex>
+#include <unordered_set>
+
+#define INTERNED_STRING_SHARDS 16 // Must be a power of 2.
+
+using namespace base;
+
+namespace {
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_set<std::string> strings; // Node based, so the stored strings never move.
+  };
+
+  // Created on first use and never freed, interned strings may be used by static objects until the very end.
+  Shard *shards() {
+    static Shard *pool = [] {
+      Shard *result = new Shard[INTERNED_STRING_SHARDS];
+      MemoryAccounting::add_source("Interned strings", [](MemoryAccounting::Usage &usage) {
+        InternedString::pool_usage(usage.bytes, usage.items);
+      });
+      return result;
+    }();
+    return pool;
+  }
+
+  const std::string *intern(const std::string &value) {
+    Shard &shard = shards()[std::hash<std::string>()(value) & (INTERNED_STRING_SHARDS - 1)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return &*shard.strings.insert(value).first;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+InternedString::InternedString() : _value(intern(std::string())) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+InternedString::InternedString(const std::string &value) : _value(intern(value)) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+InternedString::InternedString(const char *value) : _value(intern(value != nullptr ? value : "")) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void InternedString::pool_usage(std::int64_t &bytes, std::int64_t &count) {
+  bytes = 0;
+  count = 0;
+  Shard *pool = shards();
+  for (int i = 0; i < INTERNED_STRING_SHARDS; ++i) {
+    std::lock_guard<std::mutex> lock(pool[i].mutex);
+    for (const std::string &value : pool[i].strings)
+      bytes += (std::int64_t)(sizeof(std::string) + value.capacity());
+    count += (std::int64_t)pool[i].strings.size();
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
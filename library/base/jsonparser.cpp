@@ -24,11 +24,20 @@
 #include "base/jsonparser.h"
 #include "base/string_utilities.h"
 #include <set>
+#include <unordered_set>
 #include <assert.h>
 #include <typeinfo>
 #include <algorithm>
 #include <sstream>
 #include <fstream>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_SSE2_SCAN 1
+#endif
 
 namespace JsonParser {
   JsonObject::JsonObject() {
@@ -563,7 +572,14 @@ namespace JsonParser {
   //----------------- JsonValue ----------------------------------------------------------------------
 
   JsonValue::JsonValue()
-    : _double(0), _integer64(0), _uinteger64(0), _bool(false), _type(VEmpty), _deleted(false), _isValid(false) {
+    : _double(0),
+      _integer64(0),
+      _uinteger64(0),
+      _bool(false),
+      _tapeIndex(0),
+      _type(VEmpty),
+      _deleted(false),
+      _isValid(false) {
   }
 
   //--------------------------------------------------------------------------------------------------
@@ -580,6 +596,8 @@ namespace JsonParser {
       _string(rhs._string),
       _object(rhs._object),
       _array(rhs._array),
+      _tape(rhs._tape),
+      _tapeIndex(rhs._tapeIndex),
       _type(rhs._type),
       _deleted(rhs._deleted),
       _isValid(rhs._isValid) {
@@ -599,6 +617,8 @@ namespace JsonParser {
       _string(std::move(rhs._string)),
       _object(std::move(rhs._object)),
       _array(std::move(rhs._array)),
+      _tape(std::move(rhs._tape)),
+      _tapeIndex(rhs._tapeIndex),
       _type(rhs._type),
       _deleted(rhs._deleted),
       _isValid(rhs._isValid) {
@@ -620,6 +640,8 @@ namespace JsonParser {
     _string = rhs._string;
     _object = rhs._object;
     _array = rhs._array;
+    _tape = rhs._tape;
+    _tapeIndex = rhs._tapeIndex;
     _type = rhs._type;
     _deleted = rhs._deleted;
     _isValid = rhs._isValid;
@@ -643,6 +665,8 @@ namespace JsonParser {
     _string = std::move(rhs._string);
     _object = std::move(rhs._object);
     _array = std::move(rhs._array);
+    _tape = std::move(rhs._tape);
+    _tapeIndex = rhs._tapeIndex;
     _type = rhs._type;
     _deleted = rhs._deleted;
     _isValid = rhs._isValid;
@@ -794,6 +818,8 @@ namespace JsonParser {
 
     if (_type != VObject)
       throw std::bad_cast();
+    if (_tape)
+      materialize();
     return _object;
   }
 
@@ -805,6 +831,8 @@ namespace JsonParser {
 
     if (_type != VObject)
       throw std::bad_cast();
+    if (_tape)
+      materialize();
     return _object;
   }
 
@@ -813,6 +841,7 @@ namespace JsonParser {
   const JsonObject &JsonValue::operator=(const JsonObject &other) {
     _isValid = true;
     _type = VObject;
+    _tape.reset();
     _object = other;
     return other;
   }
@@ -825,6 +854,8 @@ namespace JsonParser {
 
     if (_type != VArray)
       throw std::bad_cast();
+    if (_tape)
+      materialize();
     return _array;
   }
 
@@ -836,6 +867,8 @@ namespace JsonParser {
 
     if (_type != VArray)
       throw std::bad_cast();
+    if (_tape)
+      materialize();
     return _array;
   }
 
@@ -844,6 +877,7 @@ namespace JsonParser {
   const JsonArray &JsonValue::operator=(const JsonArray &other) {
     _isValid = true;
     _type = VArray;
+    _tape.reset();
     _array = other;
     return other;
   }
@@ -1070,6 +1104,7 @@ namespace JsonParser {
     _string = "";
     _object = JsonObject();
     _array = JsonArray();
+    _tape.reset();
   }
 
   //--------------------------------------------------------------------------------------------------
@@ -1078,513 +1113,612 @@ namespace JsonParser {
     return _isValid;
   }
 
-  //----------------- JsonReader ---------------------------------------------------------------------
 
-  // JSON reader implementation
+  //----------------- JsonReader ---------------------------------------------------------------------
 
   /**
-   * @brief Constructor
-   *        Construct JsonReader from string
-   *
-   * @param Value string reference containing JSON data.
+   * The text of a document read by JsonReader and where its objects and arrays are, in the order of the text.
+   * Shared by all values of the document which are not built yet.
    */
-  JsonReader::JsonReader(const std::string &value) : _jsonText(value), _actualPos(0) {
-  }
+  struct JsonTape {
+    struct Container {
+      size_t start; // Offset of the opening bracket.
+      size_t end;   // Offset after the closing bracket.
+      size_t next;  // Index of the next container which is not part of this one.
+    };
+
+    JsonTape(const std::string &text) : text(text) {
+    }
+
+    std::string text;
+    std::vector<Container> containers;
+  };
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Returns the next available character but does not consume it.
-   *
-   * @return An char representing the next character to be read, or 0 if there are no characters to be read.
+   * Returns the first quote or backslash at or after position, or end if there is none. Most of a document is
+   * string content, so this is what the reader spends most time on.
    */
-  char JsonReader::peek() {
-    return (_actualPos < _jsonText.length()) ? _jsonText[_actualPos] : static_cast<char>(0);
+  static const char *findStringSpecial(const char *position, const char *end) {
+#ifdef HAVE_SSE2_SCAN
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - position >= 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+      int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+      if (mask != 0) {
+        while ((mask & 1) == 0) {
+          mask >>= 1;
+          ++position;
+        }
+        return position;
+      }
+      position += 16;
+    }
+#endif
+    while (position < end && *position != '"' && *position != '\\')
+      ++position;
+    return position;
   }
 
   //--------------------------------------------------------------------------------------------------
 
-  /**
-   * @brief Check if the end of a string has been reached
-   *
-   * @param
-   * @return Returns a bool value true when the end of a string has been reached
-   */
-  bool JsonReader::eos() {
-    return _actualPos == _jsonText.length();
+  static bool isNumberChar(char c) {
+    return (c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+';
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Indicates whether the specified  character is categorized as white space.
+   * @brief Constructor
+   *        Construct JsonReader from string
    *
-   * @param c The character to evaluate.
-   * @return true if c is white space; otherwise, false.
+   * @param Value string reference containing JSON data.
    */
-  bool JsonReader::isWhiteSpace(char c) {
-    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  JsonReader::JsonReader(const std::string &value) : JsonReader(std::make_shared<JsonTape>(value), 0) {
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief skip white spaces.
-   *
+   * @brief Reads text it doesn't own, it must live as long as the reader.
    */
-  void JsonReader::eatWhitespace() {
-    while (isWhiteSpace(peek()))
-      moveAhead();
+  JsonReader::JsonReader(const char *text, size_t length) : _begin(text), _end(text + length), _actualPos(text) {
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Consume actual character and move the next available.
-   *
+   * @brief Reads the text of the tape, starting at the given offset.
    */
-  void JsonReader::moveAhead() {
-    _actualPos = std::min(_actualPos + 1, _jsonText.length());
+  JsonReader::JsonReader(const std::shared_ptr<const JsonTape> &tape, size_t position)
+    : _tape(tape),
+      _begin(tape->text.data()),
+      _end(tape->text.data() + tape->text.size()),
+      _actualPos(tape->text.data() + position) {
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Try to parse JSON data.
+   * @brief skip white spaces. Null characters are skipped too, some sources pass them at the end of the text.
    *
-   * @param text String to parse.
-   * @param value Parsed JSON value.
    */
-  void JsonReader::read(const std::string &text, JsonValue &value) {
-    JsonReader reader(text);
-    reader.scan();
-    reader.parse(value);
+  void JsonReader::eatWhitespace() {
+    while (_actualPos < _end &&
+           (*_actualPos == ' ' || *_actualPos == '\n' || *_actualPos == '\r' || *_actualPos == '\t' || *_actualPos == 0))
+      ++_actualPos;
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Try to read JSON data from file.
-   * @param path JSON data Filepath
-   * @param value Parsed JSON value.
-   * @return JsonValue
+   * @brief The text at the actual position, for error messages.
    */
+  std::string JsonReader::tokenText() const {
+    const char *end = _actualPos;
+    while (end < _end && end - _actualPos < 20 && !std::isspace((unsigned char)*end) &&
+           (end == _actualPos || std::strchr("{}[],:", *end) == nullptr))
+      ++end;
+    return std::string(_actualPos, end);
+  }
 
-  void JsonReader::readFromFile(const std::string &path, JsonValue &value) {
-    std::string str = base::getTextFileContent(path);
-    if (str.empty())
-      return;
-    read(str, value);
+  //--------------------------------------------------------------------------------------------------
+
+  void JsonReader::checkStringStart() {
+    if (_actualPos == _end)
+      throw ParserException("Incomplete JSON data");
+    if (*_actualPos != '"')
+      throw ParserException("Unexpected token: " + tokenText());
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Scan every character in JSON data.
+   * @brief Parse JSON string, starting at its opening quote.
    *
+   * @return Parsed value.
    */
-  void JsonReader::scan() {
-    while (!eos()) {
-      eatWhitespace();
-      std::string value;
-      auto type = JsonToken::JsonTokenEmpty;
-      char chr = peek();
-      switch (chr) {
-        case '{':
-          value += chr;
-          type = JsonToken::JsonTokenObjectStart;
-          moveAhead();
-          break;
-
-        case '}':
-          value += chr;
-          type = JsonToken::JsonTokenObjectEnd;
-          moveAhead();
-          break;
-
-        case '[':
-          value += chr;
-          type = JsonToken::JsonTokenArrayStart;
-          moveAhead();
-          break;
-
-        case ']':
-          value += chr;
-          type = JsonToken::JsonTokenArrayEnd;
-          moveAhead();
-          break;
-
-        case ',':
-          value += chr;
-          type = JsonToken::JsonTokenNext;
-          moveAhead();
-          break;
-
-        case ':':
-          value += chr;
-          type = JsonToken::JsonTokenAssign;
-          moveAhead();
-          break;
-
+  std::string JsonReader::getJsonString() {
+    ++_actualPos;
+    std::string string;
+    while (true) {
+      const char *special = findStringSpecial(_actualPos, _end);
+      string.append(_actualPos, special);
+      _actualPos = special;
+      if (_actualPos == _end)
+        throw ParserException(std::string("Expected: \" "));
+      if (*_actualPos++ == '"')
+        return string;
+      if (_actualPos == _end)
+        throw ParserException(std::string("Expected: \" "));
+
+      char currentChar = *_actualPos++;
+      switch (currentChar) {
+        case '/':
         case '"':
-          value = getJsonString();
-          type = JsonToken::JsonTokenString;
+        case '\\':
+          string += currentChar;
           break;
-
-        case '-':
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-          value = getJsonNumber();
-          type = JsonToken::JsonTokenNumber;
+        case 'b':
+          string += '\b';
           break;
-        case 't':
         case 'f':
-          value = getJsonBoolean();
-          type = JsonToken::JsonTokenBoolean;
+          string += '\f';
           break;
         case 'n':
-          checkJsonEmpty();
-          type = JsonToken::JsonTokenEmpty;
+          string += '\n';
           break;
-        case 'u':
-          checkJsonEmpty("undefined"); // only valid in java script, it is not valid JSON value according to
-                                       // www.json.org
-          type = JsonToken::JsonTokenEmpty;
+        case 'r':
+          string += '\r';
           break;
-
-        case 0:
-          moveAhead();
+        case 't':
+          string += '\t';
           break;
         default:
-          throw ParserException(std::string("Unexpected start sequence: ") + chr); // @@FIXMEE
+          throw ParserException(std::string("Unrecognized escape sequence: \\") + currentChar);
       }
-      _tokens.push_back(JsonToken(type, value));
     }
-    _tokenIterator = _tokens.cbegin();
-    _tokenEnd = _tokens.cend();
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Check if JSON data contains given text starting with actual reader position.
-   *
-   * @param text String to check.
-   * @return true if text match to readed text from JSON data member; otherwise, false.
+   * @brief Checks a JSON string like getJsonString() does, without decoding it.
    */
-  bool JsonReader::match(const std::string &text) {
-    bool match = !text.empty();
-    auto cend = text.cend();
-    std::for_each(text.cbegin(), cend, [&match, this](char value) {
-      if (eos() || value != peek()) {
-        match = false;
+  void JsonReader::skipJsonString() {
+    ++_actualPos;
+    while (true) {
+      _actualPos = findStringSpecial(_actualPos, _end);
+      if (_actualPos == _end)
+        throw ParserException(std::string("Expected: \" "));
+      if (*_actualPos++ == '"')
         return;
-      }
-      moveAhead();
-    });
-    return match;
-  }
+      if (_actualPos == _end)
+        throw ParserException(std::string("Expected: \" "));
 
-  //--------------------------------------------------------------------------------------------------
-
-  /**
-   * @brief Parse JSON string.
-   *
-   * @return Parsed value.
-   */
-  std::string JsonReader::getJsonString() {
-    moveAhead();
-    std::string string;
-    while (eos() == false && peek() != '"') {
-      char currentChar = peek();
-      moveAhead();
-      if (currentChar == '\\' && !eos()) {
-        currentChar = peek();
-        moveAhead();
-        switch (currentChar) {
-          case '/':
-          case '"':
-          case '\\':
-            string += currentChar;
-            break;
-          case 'b':
-            string += '\b';
-            break;
-          case 'f':
-            string += '\f';
-            break;
-          case 'n':
-            string += '\n';
-            break;
-          case 'r':
-            string += '\r';
-            break;
-          case 't':
-            string += '\t';
-            break;
-          /*case 'u':
-            string += '\x';*/
-          default:
-            throw ParserException(std::string("Unrecognized escape sequence: \\") + currentChar);
-        }
-      } else {
-        string.push_back(currentChar);
-      }
+      char currentChar = *_actualPos++;
+      if (std::strchr("/\"\\bfnrt", currentChar) == nullptr || currentChar == 0)
+        throw ParserException(std::string("Unrecognized escape sequence: \\") + currentChar);
     }
-    if (!match("\""))
-      throw ParserException(std::string("Expected: \" "));
-    return string;
   }
 
   //--------------------------------------------------------------------------------------------------
 
-  /**
-   * @brief Parse JSON null literal.
-   *
-   * @param text String to check.
-   */
-  void JsonReader::checkJsonEmpty(const std::string &text /* = "null" */) {
-    std::string emptyString;
-    for (size_t i = 0; i < text.size() && !eos(); ++i) {
-      char ch = peek();
-      if (std::isspace(ch))
-        break;
-      emptyString += ch;
-      moveAhead();
-    }
-    if (emptyString.compare(text) != 0)
-      throw ParserException(std::string("Unexpected token: ") + emptyString);
+  void JsonReader::skipJsonNumber() {
+    while (_actualPos < _end && isNumberChar(*_actualPos))
+      ++_actualPos;
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Get a string literal from JSON data buffer.
+   * @brief Parses a number, which is stored as an integer if it has no fraction and fits into an int.
    *
-   * @return returns the parsed bool as string.
+   * @param value JsonValue reference where to store parsed number.
    */
-  std::string JsonReader::getJsonBoolean() {
-    const int size = peek() == 'f' ? 5 : 4;
-    std::string boolString;
-    for (int i = 0; i < size && !eos(); ++i) {
-      boolString += peek();
-      moveAhead();
+  void JsonReader::parseNumber(JsonValue &value) {
+    const char *start = _actualPos;
+    skipJsonNumber();
+
+    // Plain integers are by far the most common numbers, they don't need the stream.
+    const char *digits = (*start == '-') ? start + 1 : start;
+    if (digits < _actualPos && _actualPos - digits <= 9) {
+      int number = 0;
+      const char *position = digits;
+      while (position < _actualPos && *position >= '0' && *position <= '9')
+        number = number * 10 + (*position++ - '0');
+      if (position == _actualPos) {
+        value = (start == digits) ? number : -number;
+        return;
+      }
     }
-    if (boolString == "true" && boolString == "false")
-      throw ParserException(std::string("Unexpected token: ") + boolString);
 
-    return boolString;
+    std::stringstream buffer;
+    buffer << std::string(start, _actualPos);
+    double number = 0;
+    buffer >> number;
+    double intpart = 0;
+    if (modf(number, &intpart) == 0.0 && number >= INT_MIN && number <= INT_MAX)
+      value = (int)number;
+    else
+      value = number;
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Get a string literal from JSON data buffer.
+   * @brief Parses true, false or null. The JavaScript undefined is read as null too, although it is no valid JSON.
    *
-   * @return returns the parsed number as string.
+   * @param value Where to store the literal, can be null to only check it.
    */
-  std::string JsonReader::getJsonNumber() {
-    std::set<char> numericChars = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', 'e', 'E', '-', '+'};
-    std::string number;
-    while (eos() == false && numericChars.count(peek()) == 1) {
-      number += peek();
-      moveAhead();
+  void JsonReader::parseLiteral(JsonValue *value) {
+    static const char *literals[] = {"true", "false", "null", "undefined"};
+    for (size_t i = 0; i < 4; ++i) {
+      size_t length = strlen(literals[i]);
+      if ((size_t)(_end - _actualPos) >= length && strncmp(_actualPos, literals[i], length) == 0) {
+        _actualPos += length;
+        if (value != nullptr) {
+          if (i < 2)
+            *value = (i == 0);
+          else
+            value->clear();
+        }
+        return;
+      }
     }
-    return number;
+    throw ParserException(std::string("Unexpected token: ") + tokenText());
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Check the specified token in current buffer position
+   * @brief Parses a string, number or literal.
    *
-   * @param token Token to check.
-   * @param skip Skip this token.
-   * @param mustMach True if specified thoken must macht, otherweise exception is thrown.
+   * @param value Where to store the value, can be null to only check it.
    */
-  bool JsonReader::processToken(JsonToken::JsonTokenType type, bool skip /*= false*/, bool mustMatch /* = true*/) {
-    bool ret = _tokenIterator != _tokenEnd && _tokenIterator->getType() == type;
-    if (!ret && mustMatch) {
-      std::string message;
-      if (_tokenIterator != _tokenEnd)
-        throw ParserException("Unexpected token: " + _tokenIterator->getValue());
-      else
-        throw ParserException("Incomplete JSON data");
-    }
-    if (skip && ret) {
-      ++_tokenIterator;
-      ret = _tokenIterator != _tokenEnd;
+  void JsonReader::parseScalar(JsonValue *value) {
+    char chr = *_actualPos;
+    switch (chr) {
+      case '"':
+        if (value != nullptr)
+          *value = getJsonString();
+        else
+          skipJsonString();
+        break;
+
+      case '-':
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+        if (value != nullptr)
+          parseNumber(*value);
+        else
+          skipJsonNumber();
+        break;
+
+      case 't':
+      case 'f':
+      case 'n':
+      case 'u':
+        parseLiteral(value);
+        break;
+
+      default:
+        throw ParserException(std::string("Unexpected start sequence: ") + chr);
     }
-    return ret;
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Parse a JsonObject from Json data buffer.
+   * @brief Checks the complete text, without recursion, so the nesting depth is only limited by memory.
    *
-   * @param value JsonValue reference where to store parsed JsonObject.
+   * @param tape If given, every object and array is recorded in it.
+   * @param handler If given, receives every element of the document.
    */
-  void JsonReader::parse(JsonObject &obj) {
-    bool go = processToken(JsonToken::JsonTokenObjectStart, true) &&
-              _tokenIterator->getType() != JsonToken::JsonTokenObjectStart;
-    while (go) {
-      // the member name
-      processToken(JsonToken::JsonTokenString, false, false);
-      if (_tokenIterator->getType() == JsonToken::JsonTokenObjectEnd)
-        break;
-      std::string name = _tokenIterator->getValue();
-      ++_tokenIterator;
+  void JsonReader::scan(JsonTape *tape, Handler *handler) {
+    struct Level {
+      bool object;
+      size_t container;
+      size_t depth;    // Number of objects this one is nested in.
+      size_t firstKey; // Index of the first member name of this object in keys.
+      bool hashed;     // Whether the member names are kept in keySets instead.
+    };
+
+    // The member names of the open objects, to find duplicates. Objects with many members use a hash set.
+    const size_t maxKeysToSearch = 16;
+    std::vector<std::pair<const char *, size_t>> keys;
+    std::vector<std::unordered_set<std::string>> keySets;
+
+    std::vector<Level> levels;
+    size_t objectDepth = 0;
+    JsonValue scalar;
+
+    auto parseMemberName = [&](Level &level) {
+      checkStringStart();
+      const char *start = _actualPos + 1;
+      std::string name;
+      if (handler != nullptr)
+        name = getJsonString();
+      else
+        skipJsonString();
+      size_t length = (size_t)(_actualPos - 1 - start);
+
+      bool duplicate = false;
+      if (!level.hashed) {
+        for (size_t i = level.firstKey; i < keys.size() && !duplicate; ++i)
+          duplicate = keys[i].second == length && memcmp(keys[i].first, start, length) == 0;
+        keys.push_back({start, length});
+        if (keys.size() - level.firstKey > maxKeysToSearch) {
+          if (keySets.size() <= level.depth)
+            keySets.resize(level.depth + 1);
+          std::unordered_set<std::string> &set = keySets[level.depth];
+          set.clear();
+          for (size_t i = level.firstKey; i < keys.size(); ++i)
+            set.insert(std::string(keys[i].first, keys[i].second));
+          keys.resize(level.firstKey);
+          level.hashed = true;
+        }
+      } else
+        duplicate = !keySets[level.depth].insert(std::string(start, length)).second;
+      if (duplicate)
+        throw ParserException(std::string("Duplicate member: ") + std::string(start, length));
+
+      if (handler != nullptr)
+        handler->key(name);
+
+      eatWhitespace();
+      if (_actualPos == _end)
+        throw ParserException("Incomplete JSON data");
+      if (*_actualPos != ':')
+        throw ParserException("Unexpected token: " + tokenText());
+      ++_actualPos;
+    };
+
+    auto closeLevel = [&]() {
+      ++_actualPos;
+      Level &level = levels.back();
+      if (tape != nullptr) {
+        JsonTape::Container &container = tape->containers[level.container];
+        container.end = (size_t)(_actualPos - _begin);
+        container.next = tape->containers.size();
+      }
+      if (level.object) {
+        keys.resize(level.firstKey);
+        --objectDepth;
+        if (handler != nullptr)
+          handler->objectEnd();
+      } else if (handler != nullptr)
+        handler->arrayEnd();
+      levels.pop_back();
+    };
+
+    bool needValue = true;
+    while (true) {
+      if (needValue) {
+        eatWhitespace();
+        if (_actualPos == _end) {
+          if (!levels.empty())
+            throw ParserException("Incomplete JSON data");
+
+          // Text without any value is read as null.
+          if (handler != nullptr)
+            handler->value(JsonValue());
+          break;
+        }
 
-      // assign separator
-      processToken(JsonToken::JsonTokenAssign, true);
+        char chr = *_actualPos;
+        if (chr == '{' || chr == '[') {
+          Level level = {chr == '{', 0, objectDepth, keys.size(), false};
+          if (tape != nullptr) {
+            level.container = tape->containers.size();
+            tape->containers.push_back({(size_t)(_actualPos - _begin), 0, 0});
+          }
+          if (level.object) {
+            ++objectDepth;
+            if (handler != nullptr)
+              handler->objectStart();
+          } else if (handler != nullptr)
+            handler->arrayStart();
+          levels.push_back(level);
+
+          ++_actualPos;
+          eatWhitespace();
+          if (_actualPos < _end && *_actualPos == (chr == '{' ? '}' : ']')) {
+            closeLevel();
+            needValue = false;
+          } else if (chr == '{')
+            parseMemberName(levels.back());
+          continue;
+        }
+
+        if (handler != nullptr) {
+          parseScalar(&scalar);
+          handler->value(scalar);
+        } else
+          parseScalar(nullptr);
+        needValue = false;
+      }
 
-      JsonValue value;
-      // json value
-      parse(value);
-      if (obj.find(name) != obj.end())
-        throw ParserException(std::string("Duplicate member: ") + name);
+      if (levels.empty())
+        break;
 
-      obj.insert(name, value);
+      eatWhitespace();
+      if (_actualPos == _end)
+        throw ParserException("Incomplete JSON data");
 
-      go = processToken(JsonToken::JsonTokenNext, true, false);
+      Level &level = levels.back();
+      if (*_actualPos == ',') {
+        ++_actualPos;
+        if (level.object) {
+          eatWhitespace();
+          parseMemberName(level);
+        }
+        needValue = true;
+      } else if (*_actualPos == (level.object ? '}' : ']'))
+        closeLevel();
+      else
+        throw ParserException(std::string("Unexpected token: ") + tokenText());
     }
-    processToken(JsonToken::JsonTokenObjectEnd, true);
+
+    eatWhitespace();
+    if (_actualPos != _end)
+      throw ParserException(std::string("Unexpected token: ") + tokenText());
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Parses a string, and returns a floating point number or integer.
+   * @brief Builds the members of a checked object of the tape, nested objects and arrays are left unbuilt.
    *
-   * @param value JsonValue reference where to store parsed number.
+   * @param object Where to store the members.
+   * @param index Index of the object in the tape.
    */
-  void JsonReader::parseNumber(JsonValue &value) {
-    std::stringstream buffer;
-    buffer << _tokenIterator->getValue();
-    double number = 0;
-    buffer >> number;
-    double intpart = 0;
-    if (modf(number, &intpart) == 0.0)
-      value = (int)number;
-    else
-      value = number;
-    ++_tokenIterator;
+  void JsonReader::parseMembers(JsonObject &object, size_t index) {
+    size_t child = index + 1;
+    ++_actualPos;
+    eatWhitespace();
+    if (*_actualPos == '}')
+      return;
+
+    while (true) {
+      eatWhitespace();
+      std::string name = getJsonString();
+      eatWhitespace();
+      ++_actualPos; // The colon.
+      eatWhitespace();
+      parseElement(object[name], child);
+      eatWhitespace();
+      if (*_actualPos++ == '}')
+        break;
+    }
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Parses a string, and returns a bool.
+   * @brief Builds the elements of a checked array of the tape, nested objects and arrays are left unbuilt.
    *
-   * @param value JsonValue reference where to store parsed bool value.
+   * @param array Where to store the elements.
+   * @param index Index of the array in the tape.
    */
-  void JsonReader::parseBoolean(JsonValue &value) {
-    value = (_tokenIterator->getValue() == "true" ? true : false);
-    ++_tokenIterator;
+  void JsonReader::parseElements(JsonArray &array, size_t index) {
+    size_t child = index + 1;
+    ++_actualPos;
+    eatWhitespace();
+    if (*_actualPos == ']')
+      return;
+
+    while (true) {
+      eatWhitespace();
+      array.pushBack(JsonValue());
+      parseElement(array[array.size() - 1], child);
+      eatWhitespace();
+      if (*_actualPos++ == ']')
+        break;
+    }
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Parse a string literal from JSON data buffer.
+   * @brief Reads a value of a checked document. Objects and arrays only get their place in the tape.
    *
-   * @param value JsonValue reference where to store parsed string.
+   * @param value Where to store the value.
+   * @param index Index in the tape of the next object or array, moved past it if the value is one.
    */
-  void JsonReader::parseString(JsonValue &value) {
-    value = _tokenIterator->getValue();
-    ++_tokenIterator;
+  void JsonReader::parseElement(JsonValue &value, size_t &index) {
+    char chr = *_actualPos;
+    if (chr != '{' && chr != '[') {
+      parseScalar(&value);
+      return;
+    }
+
+    const JsonTape::Container &container = _tape->containers[index];
+    value.clear();
+    value._isValid = true;
+    value._type = chr == '{' ? VObject : VArray;
+    value._tape = _tape;
+    value._tapeIndex = index;
+    _actualPos = _begin + container.end;
+    index = container.next;
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Parse a empty string literal from JSON data buffer.
-   *
-   * @param value JsonValue reference where to store parsed string.
+   * @brief Builds the members or elements of an object or array read from a document.
    */
-  void JsonReader::parseEmpty(JsonValue &value) {
-    value.clear();
-    ++_tokenIterator;
+  void JsonValue::materialize() const {
+    // Taken first, so a value is built only once even if that fails.
+    std::shared_ptr<const JsonTape> tape;
+    tape.swap(_tape);
+
+    JsonReader reader(tape, tape->containers[_tapeIndex].start);
+    if (_type == VObject)
+      reader.parseMembers(_object, _tapeIndex);
+    else
+      reader.parseElements(_array, _tapeIndex);
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Parse a JsonObject from JSON data buffer.
+   * @brief Try to parse JSON data.
    *
-   * @param value JsonValue reference where to store parsed JsonObject.
+   * @param text String to parse.
+   * @param value Parsed JSON value.
    */
-  void JsonReader::parseObject(JsonValue &value) {
-    JsonObject object;
-    parse(object);
-    value = object;
+  void JsonReader::read(const std::string &text, JsonValue &value) {
+    std::shared_ptr<JsonTape> tape = std::make_shared<JsonTape>(text);
+    JsonReader reader(tape, 0);
+    reader.scan(tape.get(), nullptr);
+
+    reader._actualPos = reader._begin;
+    reader.eatWhitespace();
+    size_t index = 0;
+    if (reader._actualPos == reader._end)
+      value.clear();
+    else
+      reader.parseElement(value, index);
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief Parse a JsonArray from JSON data buffer.
-   *
-   * @param value JsonValue reference where to store parsed JsonArray.
+   * @brief Try to read JSON data from file.
+   * @param path JSON data Filepath
+   * @param value Parsed JSON value.
+   * @return JsonValue
    */
-  void JsonReader::parseArray(JsonValue &value) {
-    JsonArray array_;
-    bool go =
-      processToken(JsonToken::JsonTokenArrayStart, true);
-    if (processToken(JsonToken::JsonTokenArrayEnd, false, false))
-      go = false;
-    while (go) {
-      JsonValue innerValue;
-      parse(innerValue);
-      array_.pushBack(innerValue);
-      go = processToken(JsonToken::JsonTokenNext, true, false);
-    }
-    processToken(JsonToken::JsonTokenArrayEnd, true);
-    value = array_;
+
+  void JsonReader::readFromFile(const std::string &path, JsonValue &value) {
+    std::string str = base::getTextFileContent(path);
+    if (str.empty())
+      return;
+    read(str, value);
   }
 
   //--------------------------------------------------------------------------------------------------
 
   /**
-   * @brief parse
+   * @brief Parse JSON data without building values.
    *
-   * @param reference to JSON value to be parsed
+   * @param text String to parse.
+   * @param handler Receives the elements of the document.
    */
-  void JsonReader::parse(JsonValue &value) {
-    if (_tokenIterator == _tokenEnd)
-      throw ParserException("Unexpected json data end.");
-    auto type = _tokenIterator->getType();
-    switch (type) {
-      case JsonToken::JsonTokenString:
-        parseString(value);
-        break;
-      case JsonToken::JsonTokenNumber:
-        parseNumber(value);
-        break;
-      case JsonToken::JsonTokenBoolean:
-        parseBoolean(value);
-        break;
-      case JsonToken::JsonTokenEmpty:
-        parseEmpty(value);
-        break;
-      case JsonToken::JsonTokenObjectStart:
-        parseObject(value);
-        break;
-      case JsonToken::JsonTokenArrayStart:
-        parseArray(value);
-        break;
-      default:
-        throw ParserException(std::string("Unexpected token: ") + _tokenIterator->getValue());
-    }
+  void JsonReader::parse(const std::string &text, Handler &handler) {
+    JsonReader reader(text.data(), text.size());
+    reader.scan(nullptr, &handler);
   }
 
   //--------------------------------------------------------------------------------------------------
@@ -1679,10 +1813,10 @@ namespace JsonParser {
         _output += std::to_string((uint64_t)value);
         break;
       case VObject:
-        write((JsonObject)value);
+        write((const JsonObject &)value);
         break;
       case VArray:
-        write((JsonArray)value);
+        write((const JsonArray &)value);
         break;
       case VEmpty:
         _output += "null";
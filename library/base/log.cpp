@@ -28,6 +28,9 @@
 #include <time.h>
 #include <string.h>
 #include <vector>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #include <glib/gstdio.h>
 #endif
@@ -39,9 +42,15 @@
 #include "base/file_utilities.h"
 #include "base/file_functions.h" // TODO: these two file libs should really be only one.
 #include "base/string_utilities.h"
+#include "base/threading.h"
 
 using namespace base;
 
+#define LOG_FORMAT_BUFFER_SIZE 1024           // Messages up to this size are formatted without allocating.
+#define ASYNC_LOG_BATCH_SIZE (64 * 1024)      // The writer thread is woken up when this much is queued.
+#define ASYNC_LOG_MAX_QUEUED (4 * 1024 * 1024) // Above this the logging thread writes the queue itself.
+#define ASYNC_LOG_FLUSH_INTERVAL 200          // ms, longest time a message stays queued.
+
 static const char* LevelText[] = {"", "ERR", "WRN", "INF", "DB1", "DB2", "DB3"};
 /*static*/ const std::string Logger::_logLevelNames[] = {"none",   "error",  "warning", "info",
                                                          "debug1", "debug2", "debug3"};
@@ -70,12 +79,68 @@ struct Logger::LoggerImpl {
     return _levels[enumIndex(level)];
   }
 
+  void open_file(const char* mode) {
+    std::lock_guard<std::mutex> lock(_file_mutex);
+    if (_file)
+      fclose(_file);
+    _file = _filename.empty() ? nullptr : base_fopen(_filename.c_str(), mode);
+  }
+
+  void write_file(const char* data, size_t size) {
+    if (_file && size > 0) {
+      fwrite(data, 1, size, _file);
+      fflush(_file);
+    }
+  }
+
+  // Writes everything queued in async mode. The file lock is held while taking the queue, so batches taken by
+  // different threads are written in order.
+  void write_queued() {
+    std::lock_guard<std::mutex> file_lock(_file_mutex);
+    {
+      std::lock_guard<std::mutex> queue_lock(_queue_mutex);
+      _writing.swap(_queue);
+    }
+    write_file(_writing.data(), _writing.size());
+    _writing.clear();
+  }
+
+  static gpointer writer_thread(gpointer data) {
+    LoggerImpl* impl = static_cast<LoggerImpl*>(data);
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(impl->_queue_mutex);
+        impl->_queue_ready.wait_for(lock, std::chrono::milliseconds(ASYNC_LOG_FLUSH_INTERVAL),
+                                    [impl]() { return impl->_queue.size() >= ASYNC_LOG_BATCH_SIZE; });
+        if (impl->_queue.empty())
+          continue;
+      }
+      impl->write_queued();
+    }
+    return nullptr;
+  }
+
+  static void flush_at_exit() {
+    Logger::flush();
+  }
+
   std::string _dir;
   std::string _filename;
 
   bool _levels[Logger::logLevelCount];
-  bool _new_line_pending; // Set to true when the last logged entry ended with a new line.
+  bool _new_line_pending = true; // Set to true when the last logged entry ended with a new line.
   bool _std_err_log;
+
+  FILE* _file = nullptr; // Kept open for all messages.
+  std::mutex _file_mutex;
+
+  // Async mode: the messages are queued and a background thread writes them in batches.
+  bool _async = false;
+  GThread* _writer = nullptr;
+  std::mutex _queue_mutex;
+  std::condition_variable _queue_ready;
+  std::string _queue;
+  std::string _writing; // The batch being written, kept to reuse its memory.
 };
 
 Logger::LoggerImpl* Logger::_impl = nullptr;
@@ -102,8 +167,7 @@ Logger::Logger(const bool stderr_log, const std::string& target_file) {
 
   if (!target_file.empty()) {
     _impl->_filename = target_file;
-
-    FILE_scope_ptr fp = base_fopen(_impl->_filename.c_str(), "w");
+    _impl->open_file("w");
   }
 }
 
@@ -148,7 +212,7 @@ Logger::Logger(const std::string& dir, const bool stderr_log, const std::string&
       }
     }
     // truncate log file we do not need gigabytes of logs
-    FILE_scope_ptr fp = base_fopen(_impl->_filename.c_str(), "w");
+    _impl->open_file("w");
   }
 }
 
@@ -168,42 +232,66 @@ void Logger::disable_level(const LogLevel level) {
 
 //--------------------------------------------------------------------------------------------------
 
-void local_free(char* d) {
-  g_free(d);
-}
-
-//--------------------------------------------------------------------------------------------------
-
 /**
  * Logs the given text with the given domain to the current log file.
  * Note: it should be pretty safe to use utf-8 encoded text too here, though avoid log messages
  * which are several thousands of chars long.
  */
 void Logger::logv(LogLevel level, const char* const domain, const char* format, va_list args) {
-  scope_ptr<char, local_free> buffer(g_strdup_vprintf(format, args));
+  // Most messages fit into the stack buffer, only longer ones are formatted again into a heap buffer.
+  char stack_buffer[LOG_FORMAT_BUFFER_SIZE];
+  std::vector<char> heap_buffer;
+  const char* buffer = stack_buffer;
+
+  va_list args_copy;
+  va_copy(args_copy, args);
+  int length = vsnprintf(stack_buffer, sizeof(stack_buffer), format, args_copy);
+  va_end(args_copy);
+  if (length < 0) {
+    length = 0;
+    stack_buffer[0] = 0;
+  } else if (length >= (int)sizeof(stack_buffer)) {
+    heap_buffer.resize(length + 1);
+    vsnprintf(&heap_buffer[0], heap_buffer.size(), format, args);
+    buffer = &heap_buffer[0];
+  }
 
   // Print to stderr if no logger is created (yet).
   if (!_impl) {
-    fprintf(stderr, "%s", buffer.get());
+    fprintf(stderr, "%s", buffer);
     fflush(stderr);
     return;
   }
 
-  const time_t t = time(NULL);
-  struct tm tm;
+  char prefix[128] = "";
+  if (_impl->_new_line_pending) {
+    const time_t t = time(NULL);
+    struct tm tm;
 #ifdef _WIN32
-  localtime_s(&tm, &t);
+    localtime_s(&tm, &t);
 #else
-  localtime_r(&t, &tm);
+    localtime_r(&t, &tm);
 #endif
+    snprintf(prefix, sizeof(prefix), "%02u:%02u:%02u [%3s][%15s]: ", tm.tm_hour, tm.tm_min, tm.tm_sec,
+             LevelText[enumIndex(level)], domain);
+  }
 
-  FILE_scope_ptr fp = _impl->_filename.empty() ? NULL : base_fopen(_impl->_filename.c_str(), "a");
-
-  if (fp) {
-    if (_impl->_new_line_pending)
-      fprintf(fp, "%02u:%02u:%02u [%3s][%15s]: ", tm.tm_hour, tm.tm_min, tm.tm_sec, LevelText[enumIndex(level)],
-              domain);
-    fwrite(buffer, 1, strlen(buffer.get()), fp);
+  if (_impl->_async) {
+    bool write_now = level == LogLevel::Error;
+    {
+      std::lock_guard<std::mutex> lock(_impl->_queue_mutex);
+      _impl->_queue.append(prefix).append(buffer, length);
+      write_now = write_now || _impl->_queue.size() >= ASYNC_LOG_MAX_QUEUED;
+      if (_impl->_queue.size() >= ASYNC_LOG_BATCH_SIZE)
+        _impl->_queue_ready.notify_one();
+    }
+    // Errors are written right away, so they are in the file if the application goes down next.
+    if (write_now)
+      _impl->write_queued();
+  } else {
+    std::lock_guard<std::mutex> lock(_impl->_file_mutex);
+    _impl->write_file(prefix, strlen(prefix));
+    _impl->write_file(buffer, length);
   }
 
   // No explicit newline here. If messages are composed (e.g. python errors)
@@ -232,24 +320,19 @@ void Logger::logv(LogLevel level, const char* const domain, const char* format,
 #endif
 
 #ifdef _WIN32
-    if (_impl->_new_line_pending) {
-      char* tmp = g_strdup_printf("%02u:%02u:%02u [%3s][%15s]: ", tm.tm_hour, tm.tm_min, tm.tm_sec,
-                                  LevelText[enumIndex(level)], domain);
-      OutputDebugStringA(tmp);
-      g_free(tmp);
-    }
+    if (_impl->_new_line_pending)
+      OutputDebugStringA(prefix);
     // if you want the program to stop when a specific log msg is printed, put a bp in the next line and set condition
     // to log_msg_serial==#
-    OutputDebugStringA(buffer.get());
+    OutputDebugStringA(buffer);
 #endif
     // We need the data in stderr even in Windows, so that the output can be read from other tools.
     if (_impl->_new_line_pending)
-      fprintf(stderr, "%02u:%02u:%02u [%3s][%15s]: ", tm.tm_hour, tm.tm_min, tm.tm_sec, LevelText[enumIndex(level)],
-              domain);
+      fprintf(stderr, "%s", prefix);
 
     // If you want the program to stop when a specific log msg is printed, put a bp in the next line
     // and set condition to log_msg_serial==#
-    fprintf(stderr, "%s", buffer.get());
+    fprintf(stderr, "%s", buffer);
 
 #if defined(_WIN32)
     if ((level == LogLevel::Error) || (level == LogLevel::Warning))
@@ -260,8 +343,10 @@ void Logger::logv(LogLevel level, const char* const domain, const char* format,
 #endif
   }
 
-  const char ending_char = buffer[strlen(buffer) - 1];
-  _impl->_new_line_pending = (ending_char == '\n') || (ending_char == '\r');
+  if (length > 0) {
+    const char ending_char = buffer[length - 1];
+    _impl->_new_line_pending = (ending_char == '\n') || (ending_char == '\r');
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -386,3 +471,41 @@ bool Logger::active_level(const std::string& value) {
 void Logger::log_to_stderr(bool value) {
   _impl->_std_err_log = value;
 }
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * In async mode messages are queued and written to the log file in batches by a background thread,
+ * which makes the chatty debug levels affordable. Errors and the messages queued at exit are still
+ * written before the logging call returns.
+ */
+void Logger::async_mode(bool value) {
+  if (_impl == nullptr || _impl->_async == value)
+    return;
+
+  if (value && _impl->_writer == nullptr) {
+    _impl->_writer = base::create_thread(&LoggerImpl::writer_thread, _impl, nullptr, "logger");
+    if (_impl->_writer == nullptr)
+      return;
+    atexit(&LoggerImpl::flush_at_exit);
+  }
+  _impl->_async = value;
+  if (!value)
+    _impl->write_queued();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Logger::async_mode() {
+  return _impl != nullptr && _impl->_async;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Writes all queued messages to the log file.
+ */
+void Logger::flush() {
+  if (_impl != nullptr)
+    _impl->write_queued();
+}
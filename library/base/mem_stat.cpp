@@ -21,17 +21,103 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include "base/mem_stat.h"
+#include "base/string_utilities.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using namespace base;
+
+namespace {
+  struct Source {
+    std::string name;
+    MemoryAccounting::Measure measure;
+  };
+
+  // Created on first use, as static objects of other modules may add sources, and never freed, as they may
+  // also remove them during shutdown.
+  std::mutex &sources_mutex() {
+    static std::mutex *mutex = new std::mutex();
+    return *mutex;
+  }
+
+  std::map<int, Source> &sources() {
+    static std::map<int, Source> *sources = new std::map<int, Source>();
+    return *sources;
+  }
+
+  int next_source_id = 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int MemoryAccounting::add_source(const std::string &name, const Measure &measure) {
+  std::lock_guard<std::mutex> lock(sources_mutex());
+  int id = next_source_id++;
+  sources()[id] = {name, measure};
+  return id;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MemoryAccounting::remove_source(int id) {
+  std::lock_guard<std::mutex> lock(sources_mutex());
+  sources().erase(id);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * The measure functions are called with the sources locked, so a source cannot go away while it is measured.
+ * They must not add or remove sources themselves.
+ */
+std::vector<MemoryAccounting::Usage> MemoryAccounting::usage() {
+  std::map<std::string, Usage> by_name;
+  {
+    std::lock_guard<std::mutex> lock(sources_mutex());
+    for (auto &source : sources()) {
+      Usage usage = {source.second.name, 0, 0};
+      source.second.measure(usage);
+
+      Usage &total = by_name[source.second.name];
+      total.name = source.second.name;
+      total.bytes += usage.bytes;
+      total.items += usage.items;
+    }
+  }
+
+  std::vector<Usage> result;
+  for (auto &entry : by_name)
+    result.push_back(entry.second);
+  std::stable_sort(result.begin(), result.end(), [](const Usage &a, const Usage &b) { return a.bytes > b.bytes; });
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string MemoryAccounting::report() {
+  std::string text = strfmt("%-28s %14s %12s\n", "Subsystem", "Bytes", "Items");
+  std::int64_t total = 0;
+  for (const Usage &usage : MemoryAccounting::usage()) {
+    text += strfmt("%-28s %14s %12s\n", usage.name.c_str(), std::to_string(usage.bytes).c_str(),
+                   std::to_string(usage.items).c_str());
+    total += usage.bytes;
+  }
+  text += strfmt("%-28s %14s\n", "Total", std::to_string(total).c_str());
+  return text;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 #ifdef _WIN32
 #include <windows.h>
 #include <psapi.h>
-#include "base/mem_stat.h"
 #include "base/log.h"
 
 DEFAULT_LOG_DOMAIN("base")
 
-
-
-using namespace base;
 MEMORYSTATUSEX memInfo;
 PROCESS_MEMORY_COUNTERS_EX pmc;
 
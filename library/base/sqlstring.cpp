@@ -23,62 +23,87 @@
 
 #include "base/sqlstring.h"
 
+#include <string.h>
+
 using namespace base;
 
 const sqlstring sqlstring::null(sqlstring("NULL", 0));
 
+// Whether escape_backticks() would change the identifier.
+static bool identifier_needs_escaping(const char *data, size_t length) {
+  for (const char *end = data + length; data < end; ++data) {
+    switch (*data) {
+      case 0:
+      case '\n':
+      case '\r':
+      case '\032':
+      case '`':
+        return true;
+    }
+  }
+  return false;
+}
+
 sqlstring::sqlstring(const char *format_string, const sqlstringformat format)
-  : _format_string_left(format_string), _format(format) {
-  append(consume_until_next_escape());
+  : _format_string(format_string), _format_position(0), _format(format) {
+  // the values are mostly short names and numbers
+  _formatted.reserve(_format_string.size() + 64);
+  append_until_next_escape();
 }
 
 sqlstring::sqlstring(const sqlstring &copy)
-  : _formatted(copy._formatted), _format_string_left(copy._format_string_left), _format(copy._format) {
+  : _formatted(copy._formatted),
+    _format_string(copy._format_string),
+    _format_position(copy._format_position),
+    _format(copy._format) {
 }
 
-sqlstring::sqlstring() : _format(0) {
+sqlstring::sqlstring() : _format_position(0), _format(0) {
 }
 
-std::string sqlstring::consume_until_next_escape() {
-  std::string::size_type e = _format_string_left.length(), p = 0;
-  while (p < e) {
-    char ch = _format_string_left[p];
-    if (ch == '?' || ch == '!')
-      break;
-    ++p;
-  }
-  if (p > 0) {
-    std::string s = _format_string_left.substr(0, p);
-    if (p < e)
-      _format_string_left = _format_string_left.substr(p);
-    else
-      _format_string_left.clear();
-    return s;
-  }
-  return "";
+void sqlstring::append_until_next_escape() {
+  std::string::size_type p = _format_string.find_first_of("?!", _format_position);
+  if (p == std::string::npos)
+    p = _format_string.size();
+  _formatted.append(_format_string, _format_position, p - _format_position);
+  _format_position = p;
 }
 
 int sqlstring::next_escape() {
-  if (_format_string_left.empty())
+  if (_format_position >= _format_string.size())
     throw std::invalid_argument("Error formatting SQL query: more arguments than escapes");
-  int c = _format_string_left[0];
-  _format_string_left = _format_string_left.substr(1);
-  return c;
+  return _format_string[_format_position++];
 }
 
-sqlstring &sqlstring::append(const std::string &s) {
-  _formatted.append(s);
-  return *this;
+// Escapes the value into the result, in place.
+void sqlstring::append_quoted(const char *data, size_t length) {
+  char quote = (_format._flags & UseAnsiQuotes) ? '"' : '\'';
+  size_t start = _formatted.size();
+  _formatted.resize(start + 2 * length + 2);
+  _formatted[start] = quote;
+  size_t written = escape_sql_buffer(data, length, &_formatted[start + 1]);
+  _formatted[start + 1 + written] = quote;
+  _formatted.resize(start + written + 2);
+}
+
+void sqlstring::append_identifier(const char *data, size_t length) {
+  if (identifier_needs_escaping(data, length))
+    _formatted.append(escape_backticks(std::string(data, length)));
+  else
+    _formatted.append(data, length);
 }
 
 sqlstring::operator std::string() const {
-  return _formatted + _format_string_left;
+  std::string result;
+  result.reserve(_formatted.size() + _format_string.size() - _format_position);
+  result.append(_formatted).append(_format_string, _format_position, std::string::npos);
+  return result;
 }
 
 bool sqlstring::done() const {
-  if (_format_string_left.empty())
+  if (_format_position >= _format_string.size())
     return true;
-  return _format_string_left[0] != '!' && _format_string_left[0] != '?';
+  return _format_string[_format_position] != '!' && _format_string[_format_position] != '?';
 }
 
 sqlstring &sqlstring::operator<<(const double v) {
@@ -86,8 +111,8 @@ sqlstring &sqlstring::operator<<(const double v) {
   if (esc != '?')
     throw std::invalid_argument("Error formatting SQL query: invalid escape for numeric argument");
 
-  append(strfmt("%f", v));
-  append(consume_until_next_escape());
+  _formatted.append(strfmt("%f", v));
+  append_until_next_escape();
 
   return *this;
 }
@@ -100,20 +125,19 @@ sqlstring &sqlstring::operator<<(const sqlstringformat format) {
 sqlstring &sqlstring::operator<<(const std::string &v) {
   int esc = next_escape();
   if (esc == '!') {
-    std::string escaped = escape_backticks(v);
     if ((_format._flags & QuoteOnlyIfNeeded) != 0)
-      append(base::quote_identifier_if_needed(escaped, '`'));
-    else
-      append(base::quote_identifier(escaped, '`'));
-  } else if (esc == '?') {
-    if (_format._flags & UseAnsiQuotes)
-      append("\"").append(escape_sql_string(v)).append("\"");
-    else
-      append("'").append(escape_sql_string(v)).append("'");
-  } else // shouldn't happen
+      _formatted.append(base::quote_identifier_if_needed(escape_backticks(v), '`'));
+    else {
+      _formatted.push_back('`');
+      append_identifier(v.data(), v.size());
+      _formatted.push_back('`');
+    }
+  } else if (esc == '?')
+    append_quoted(v.data(), v.size());
+  else // shouldn't happen
     throw std::invalid_argument(
       "Error formatting SQL query: internal error, expected ? or ! escape got something else");
-  append(consume_until_next_escape());
+  append_until_next_escape();
 
   return *this;
 }
@@ -121,8 +145,8 @@ sqlstring &sqlstring::operator<<(const std::string &v) {
 sqlstring &sqlstring::operator<<(const sqlstring &v) {
   next_escape();
 
-  append(v);
-  append(consume_until_next_escape());
+  _formatted.append(v._formatted).append(v._format_string, v._format_position, std::string::npos);
+  append_until_next_escape();
 
   return *this;
 }
@@ -133,23 +157,23 @@ sqlstring &sqlstring::operator<<(const char *v) {
   if (esc == '!') {
     if (!v)
       throw std::invalid_argument("Error formatting SQL query: NULL value found for identifier");
-    std::string quoted = escape_backticks(v);
-    if (quoted == v && (_format._flags & QuoteOnlyIfNeeded))
-      append(quoted);
-    else
-      append("`").append(quoted).append("`");
+    size_t length = strlen(v);
+    if ((_format._flags & QuoteOnlyIfNeeded) && !identifier_needs_escaping(v, length))
+      _formatted.append(v, length);
+    else {
+      _formatted.push_back('`');
+      append_identifier(v, length);
+      _formatted.push_back('`');
+    }
   } else if (esc == '?') {
-    if (v) {
-      if (_format._flags & UseAnsiQuotes)
-        append("\"").append(escape_sql_string(v)).append("\"");
-      else
-        append("'").append(escape_sql_string(v)).append("'");
-    } else
-      append("NULL");
+    if (v)
+      append_quoted(v, strlen(v));
+    else
+      _formatted.append("NULL");
   } else // shouldn't happen
     throw std::invalid_argument(
       "Error formatting SQL query: internal error, expected ? or ! escape got something else");
-  append(consume_until_next_escape());
+  append_until_next_escape();
 
   return *this;
 }
@@ -37,6 +37,11 @@
 #include <boost/locale/encoding_utf.hpp>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_SSE2_SCAN 1
+#endif
+
 DEFAULT_LOG_DOMAIN(DOMAIN_BASE);
 
 // updated as of 5.7
@@ -341,6 +346,60 @@ namespace base {
 
   //--------------------------------------------------------------------------------------------------
 
+  /**
+   * Converts a block of wide characters (UTF-16 where wchar_t is 2 bytes, UTF-32 otherwise) to utf-8,
+   * writing directly into the given buffer. Pure ASCII runs are copied without any code point decoding,
+   * unpaired surrogates become U+FFFD. Returns the number of bytes written or (size_t)-1 if the output
+   * buffer is too small (3 * length bytes are always enough for UTF-16, 4 * length for UTF-32).
+   */
+  size_t wide_to_utf8_buffer(const wchar_t *data, size_t length, char *out, size_t out_size) {
+    const wchar_t *end = data + length;
+    char *start = out;
+    char *out_end = out + out_size;
+
+    while (data < end) {
+      // ASCII fast path.
+      if ((unsigned)*data < 0x80) {
+        if (out == out_end)
+          return (size_t)-1;
+        *out++ = (char)*data++;
+        continue;
+      }
+
+      uint32_t code = (uint32_t)*data++;
+      if (sizeof(wchar_t) == 2 && code >= 0xD800 && code <= 0xDFFF) {
+        if (code <= 0xDBFF && data < end && (uint32_t)*data >= 0xDC00 && (uint32_t)*data <= 0xDFFF)
+          code = 0x10000 + ((code - 0xD800) << 10) + ((uint32_t)*data++ - 0xDC00);
+        else
+          code = 0xFFFD;
+      } else if (code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+        code = 0xFFFD;
+
+      if (code < 0x800) {
+        if (out_end - out < 2)
+          return (size_t)-1;
+        *out++ = (char)(0xC0 | (code >> 6));
+        *out++ = (char)(0x80 | (code & 0x3F));
+      } else if (code < 0x10000) {
+        if (out_end - out < 3)
+          return (size_t)-1;
+        *out++ = (char)(0xE0 | (code >> 12));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code & 0x3F));
+      } else {
+        if (out_end - out < 4)
+          return (size_t)-1;
+        *out++ = (char)(0xF0 | (code >> 18));
+        *out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code & 0x3F));
+      }
+    }
+    return out - start;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
   std::string string_to_path_for_open(const std::string &s) {
 // XXX: convert from utf-8 to wide string and then back to utf-8?
 //      How can this help in any way here?
@@ -432,12 +491,140 @@ namespace base {
 
   //--------------------------------------------------------------------------------------------------
 
+  /**
+   * Checks that all bytes are in the range 1..127, 16 bytes at a time where SSE2 is available.
+   * NUL is excluded because the GLib functions these checks shortcut stop at the first NUL.
+   */
+  bool is_ascii(const char *data, size_t length) {
+    const char *end = data + length;
+
+#ifdef HAVE_SSE2_SCAN
+    const __m128i zero = _mm_setzero_si128();
+    for (; end - data >= 16; data += 16) {
+      // Bytes above 127 are negative when compared as signed, so they fail just like NUL.
+      __m128i chunk = _mm_loadu_si128((const __m128i *)data);
+      if (_mm_movemask_epi8(_mm_cmpgt_epi8(chunk, zero)) != 0xFFFF)
+        return false;
+    }
+#endif
+
+    for (; data < end; ++data) {
+      unsigned char c = (unsigned char)*data;
+      if (c == 0 || c > 127)
+        return false;
+    }
+    return true;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  /**
+   * Like is_ascii, but also without control characters or DEL. Collation may ignore those, so only for
+   * printable text a byte wise comparison gives the same equality as the collation based one.
+   */
+  static bool is_printable_ascii(const std::string &s) {
+    const char *data = s.data();
+    const char *end = data + s.size();
+
+#ifdef HAVE_SSE2_SCAN
+    const __m128i space = _mm_set1_epi8(' ' - 1);
+    const __m128i del = _mm_set1_epi8(127);
+    for (; end - data >= 16; data += 16) {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)data);
+      __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(chunk, space), _mm_cmplt_epi8(chunk, del));
+      if (_mm_movemask_epi8(printable) != 0xFFFF)
+        return false;
+    }
+#endif
+
+    for (; data < end; ++data) {
+      unsigned char c = (unsigned char)*data;
+      if (c < ' ' || c > 126)
+        return false;
+    }
+    return true;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  // Flips the case of all bytes in the range first..last, which must be the upper or lower case ASCII letters.
+  static void ascii_flip_case(char *data, size_t length, char first, char last) {
+    char *end = data + length;
+
+#ifdef HAVE_SSE2_SCAN
+    const __m128i below = _mm_set1_epi8(first - 1);
+    const __m128i above = _mm_set1_epi8(last + 1);
+    const __m128i flip = _mm_set1_epi8(0x20);
+    for (; end - data >= 16; data += 16) {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)data);
+      __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(chunk, below), _mm_cmplt_epi8(chunk, above));
+      _mm_storeu_si128((__m128i *)data, _mm_xor_si128(chunk, _mm_and_si128(letters, flip)));
+    }
+#endif
+
+    for (; data < end; ++data) {
+      if (*data >= first && *data <= last)
+        *data ^= 0x20;
+    }
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  void ascii_tolower(char *data, size_t length) {
+    ascii_flip_case(data, length, 'A', 'Z');
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  void ascii_toupper(char *data, size_t length) {
+    ascii_flip_case(data, length, 'a', 'z');
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  // Case insensitive equality of two ASCII texts of the same length.
+  static bool ascii_equal_nocase(const char *first, const char *second, size_t length) {
+    const char *end = first + length;
+
+#ifdef HAVE_SSE2_SCAN
+    const __m128i below = _mm_set1_epi8('A' - 1);
+    const __m128i above = _mm_set1_epi8('Z' + 1);
+    const __m128i flip = _mm_set1_epi8(0x20);
+    for (; end - first >= 16; first += 16, second += 16) {
+      __m128i a = _mm_loadu_si128((const __m128i *)first);
+      __m128i b = _mm_loadu_si128((const __m128i *)second);
+      a = _mm_or_si128(a, _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi8(a, below), _mm_cmplt_epi8(a, above)), flip));
+      b = _mm_or_si128(b, _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi8(b, below), _mm_cmplt_epi8(b, above)), flip));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF)
+        return false;
+    }
+#endif
+
+    for (; first < end; ++first, ++second) {
+      char a = (*first >= 'A' && *first <= 'Z') ? (char)(*first | 0x20) : *first;
+      char b = (*second >= 'A' && *second <= 'Z') ? (char)(*second | 0x20) : *second;
+      if (a != b)
+        return false;
+    }
+    return true;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
   /**
    * Simple case conversion routine, which returns a new string.
    * Note: converting to lower can be wrong when the returned string is used for string comparison,
    * because in some cultures letter cases are more complicated. Use string_compare instead in such cases.
+   * ASCII text is converted without GLib, which also keeps identifiers and keywords unaffected by the
+   * locale (e.g. the Turkish dotted and dotless i).
    */
   std::string tolower(const std::string &s) {
+    if (is_ascii(s.data(), s.size())) {
+      std::string result(s);
+      ascii_tolower(&result[0], result.size());
+      return result;
+    }
+
     char *str_down = g_utf8_strdown(s.c_str(), (gsize)s.length());
     std::string result(str_down);
     g_free(str_down);
@@ -447,6 +634,12 @@ namespace base {
   //--------------------------------------------------------------------------------------------------
 
   std::string toupper(const std::string &s) {
+    if (is_ascii(s.data(), s.size())) {
+      std::string result(s);
+      ascii_toupper(&result[0], result.size());
+      return result;
+    }
+
     char *str_up = g_utf8_strup(s.c_str(), (gsize)s.length());
     std::string result(str_up);
     g_free(str_up);
@@ -1168,49 +1361,97 @@ namespace base {
    */
   std::string escape_sql_string(const std::string &s, bool wildcards) {
     std::string result;
-    result.reserve(s.size());
+    result.resize(s.size() * 2);
+    result.resize(escape_sql_buffer(s.data(), s.size(), &result[0], wildcards));
+    return result;
+  }
 
-    for (std::string::const_iterator ch = s.begin(); ch != s.end(); ++ch) {
-      char escape = 0;
+  //--------------------------------------------------------------------------------------------------
 
-      switch (*ch) {
-        case 0: /* Must be escaped for 'mysql' */
-          escape = '0';
-          break;
-        case '\n': /* Must be escaped for logs */
-          escape = 'n';
-          break;
-        case '\r':
-          escape = 'r';
-          break;
-        case '\\':
-          escape = '\\';
-          break;
-        case '\'':
-          escape = '\'';
-          break;
-        case '"': /* Better safe than sorry */
-          escape = '"';
-          break;
-        case '\032': /* This gives problems on Win32 */
-          escape = 'Z';
-          break;
-        case '_':
-          if (wildcards)
-            escape = '_';
-          break;
-        case '%':
-          if (wildcards)
-            escape = '%';
-          break;
+  static inline char sql_escape_char(char ch, bool wildcards) {
+    switch (ch) {
+      case 0: /* Must be escaped for 'mysql' */
+        return '0';
+      case '\n': /* Must be escaped for logs */
+        return 'n';
+      case '\r':
+        return 'r';
+      case '\\':
+        return '\\';
+      case '\'':
+        return '\'';
+      case '"': /* Better safe than sorry */
+        return '"';
+      case '\032': /* This gives problems on Win32 */
+        return 'Z';
+      case '_':
+        return wildcards ? '_' : 0;
+      case '%':
+        return wildcards ? '%' : 0;
+    }
+    return 0;
+  }
+
+  /**
+   * Buffer based version of escape_sql_string, escaping the same characters as mysql_real_escape_string
+   * does for single byte and utf-8 connections. The output buffer must hold at least 2 * length bytes.
+   * Runs of characters that need no escaping (the vast majority of real data) are located 16 bytes
+   * at a time where SSE2 is available and copied in one go. Returns the number of bytes written.
+   */
+  size_t escape_sql_buffer(const char *data, size_t length, char *out, bool wildcards) {
+    const char *end = data + length;
+    char *start = out;
+
+#ifdef HAVE_SSE2_SCAN
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i quote = _mm_set1_epi8('\'');
+    const __m128i dquote = _mm_set1_epi8('"');
+    const __m128i ctrl_z = _mm_set1_epi8('\032');
+    const __m128i underscore = _mm_set1_epi8('_');
+    const __m128i percent = _mm_set1_epi8('%');
+
+    while (end - data >= 16) {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)data);
+      __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, zero), _mm_cmpeq_epi8(chunk, newline)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, backslash)));
+      hits = _mm_or_si128(hits, _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, dquote)),
+                                             _mm_cmpeq_epi8(chunk, ctrl_z)));
+      if (wildcards)
+        hits = _mm_or_si128(hits, _mm_or_si128(_mm_cmpeq_epi8(chunk, underscore), _mm_cmpeq_epi8(chunk, percent)));
+
+      int mask = _mm_movemask_epi8(hits);
+      if (mask == 0) {
+        memcpy(out, data, 16);
+        out += 16;
+        data += 16;
+        continue;
       }
+
+      // Copy the clean prefix, then let the scalar loop below deal with the escaped character.
+      int clean = 0;
+      while ((mask & (1 << clean)) == 0)
+        ++clean;
+      memcpy(out, data, clean);
+      out += clean;
+      data += clean;
+
+      *out++ = '\\';
+      *out++ = sql_escape_char(*data++, wildcards);
+    }
+#endif
+
+    for (; data < end; ++data) {
+      char escape = sql_escape_char(*data, wildcards);
       if (escape) {
-        result.push_back('\\');
-        result.push_back(escape);
+        *out++ = '\\';
+        *out++ = escape;
       } else
-        result.push_back(*ch);
+        *out++ = *data;
     }
-    return result;
+    return out - start;
   }
 
   /**
@@ -1581,6 +1822,11 @@ namespace base {
    *         > 0 - If second sorts before first.
    */
   int string_compare(const std::string &first, const std::string &second, bool case_sensitive) {
+    // Equal printable ASCII strings need neither normalization nor collation.
+    if (first.size() == second.size() && is_printable_ascii(first) && is_printable_ascii(second) &&
+        (case_sensitive ? first == second : ascii_equal_nocase(first.data(), second.data(), first.size())))
+      return 0;
+
     int result = 0;
 
     gchar *left = g_utf8_normalize(first.c_str(), -1, G_NORMALIZE_DEFAULT);
@@ -1605,8 +1851,15 @@ namespace base {
   /**
    * Convenience function to determine if 2 strings are the same. This works also for culturally
    * equal letters (e.g. german ß and ss) and any normalization form.
+   * Printable ASCII strings are only equal to each other if their bytes are (ignoring case if requested),
+   * so they are compared without GLib.
    */
   bool same_string(const std::string &first, const std::string &second, bool case_sensitive) {
+    if (is_printable_ascii(first) && is_printable_ascii(second)) {
+      if (first.size() != second.size())
+        return false;
+      return case_sensitive ? first == second : ascii_equal_nocase(first.data(), second.data(), first.size());
+    }
     return string_compare(first, second, case_sensitive) == 0;
   }
 
@@ -1620,6 +1873,16 @@ namespace base {
     if (text.size() == 0 || candidate.size() == 0)
       return false;
 
+    // ASCII is not changed by normalization and folds to lower case, so a plain search does.
+    if (is_ascii(text.data(), text.size()) && is_ascii(candidate.data(), candidate.size())) {
+      if (case_sensitive)
+        return text.find(candidate) != std::string::npos;
+      std::string folded_text(text), folded_candidate(candidate);
+      ascii_tolower(&folded_text[0], folded_text.size());
+      ascii_tolower(&folded_candidate[0], folded_candidate.size());
+      return folded_text.find(folded_candidate) != std::string::npos;
+    }
+
     gchar *hay_stack = g_utf8_normalize(text.c_str(), -1, G_NORMALIZE_DEFAULT);
     gchar *needle = g_utf8_normalize(candidate.c_str(), -1, G_NORMALIZE_DEFAULT);
 
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/task_scheduler.h"
+#include "base/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#define SCHEDULER_MIN_THREADS 2
+#define SCHEDULER_MAX_THREADS 64         // Including the workers started while others are blocked.
+#define SCHEDULER_EXTRA_WORKER_IDLE_TIME 30 // Seconds until an idle extra worker stops.
+#define SCHEDULER_PRIORITY_COUNT 3
+
+DEFAULT_LOG_DOMAIN(DOMAIN_BASE)
+
+using namespace base;
+
+namespace {
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<TaskScheduler::Task> tasks[SCHEDULER_PRIORITY_COUNT];
+  };
+
+  // Index of the worker running on this thread, -1 on other threads.
+  thread_local int current_worker = -1;
+
+  bool take_from(std::deque<TaskScheduler::Task> &queue, bool newest, TaskScheduler::Task &task) {
+    if (queue.empty())
+      return false;
+    if (newest) {
+      task.swap(queue.back());
+      queue.pop_back();
+    } else {
+      task.swap(queue.front());
+      queue.pop_front();
+    }
+    return true;
+  }
+
+  void run_task(const TaskScheduler::Task &task) {
+    try {
+      task();
+    } catch (std::exception &e) {
+      logError("Exception in scheduled task: %s\n", e.what());
+    } catch (...) {
+      logError("Unknown exception in scheduled task\n");
+    }
+  }
+
+  // The state of a run_parallel() call, shared with the tasks it posted. These may start only after the call
+  // returned, they then find nothing left to do.
+  struct ParallelRun {
+    std::function<void(size_t)> body;
+    size_t count;
+    std::atomic<size_t> next;
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t finished;
+    std::exception_ptr error;
+
+    ParallelRun(const std::function<void(size_t)> &body, size_t count)
+      : body(body), count(count), next(0), finished(0) {
+    }
+
+    void run() {
+      for (size_t i = next++; i < count; i = next++) {
+        std::exception_ptr exception;
+        try {
+          body(i);
+        } catch (...) {
+          exception = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (exception && !error)
+          error = exception;
+        if (++finished == count)
+          done.notify_all();
+      }
+    }
+  };
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class TaskScheduler::Private {
+public:
+  std::mutex mutex; // Guards the shared queues, the idle state and starting or stopping workers.
+  std::condition_variable work_available;
+  std::condition_variable interactive_available; // Only for worker 0, which runs interactive tasks only.
+  std::deque<Task> shared[SCHEDULER_PRIORITY_COUNT];
+  WorkerQueue *queues[SCHEDULER_MAX_THREADS]; // Never freed, workers may still look at the queue of a stopped one.
+  std::atomic<int> worker_count;
+  std::atomic<size_t> queued[SCHEDULER_PRIORITY_COUNT]; // Tasks waiting in any queue, per priority.
+  int base_count;
+  int idle; // Not counting worker 0.
+  bool reserved_idle;
+  int blocked;
+
+  Private() : worker_count(0), idle(0), reserved_idle(false), blocked(0) {
+    for (int i = 0; i < SCHEDULER_MAX_THREADS; ++i)
+      queues[i] = nullptr;
+    for (int i = 0; i < SCHEDULER_PRIORITY_COUNT; ++i)
+      queued[i] = 0;
+
+    base_count = std::max(SCHEDULER_MIN_THREADS, (int)std::thread::hardware_concurrency());
+    std::lock_guard<std::mutex> lock(mutex);
+    while (worker_count < base_count)
+      start_worker();
+  }
+
+  // Must be called with the mutex locked.
+  void start_worker() {
+    int index = worker_count;
+    if (queues[index] == nullptr)
+      queues[index] = new WorkerQueue();
+    ++worker_count;
+    std::thread(&Private::worker_loop, this, index).detach();
+  }
+
+  // Must be called with the mutex locked.
+  void wake(TaskPriority priority) {
+    if (idle > 0)
+      work_available.notify_one();
+    else if (priority == TaskInteractive && reserved_idle)
+      interactive_available.notify_one();
+  }
+
+  bool has_work(int index) {
+    if (queued[TaskInteractive] > 0)
+      return true;
+    return index != 0 && (queued[TaskBackground] > 0 || queued[TaskBulk] > 0);
+  }
+
+  /**
+   * Takes the next task for the given worker: for each priority, starting with the highest, the newest task of its
+   * own queue (which likely still has its data in the cache), then the oldest shared one and finally the oldest
+   * one of another worker.
+   */
+  bool take(int index, Task &task) {
+    int priority_count = index == 0 ? 1 : SCHEDULER_PRIORITY_COUNT;
+    for (int priority = 0; priority < priority_count; ++priority) {
+      if (queued[priority] == 0)
+        continue;
+
+      {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        if (take_from(queues[index]->tasks[priority], true, task)) {
+          --queued[priority];
+          return true;
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (take_from(shared[priority], false, task)) {
+          --queued[priority];
+          return true;
+        }
+      }
+
+      int count = worker_count;
+      for (int i = 1; i < count; ++i) {
+        WorkerQueue *victim = queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (take_from(victim->tasks[priority], false, task)) {
+          --queued[priority];
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void worker_loop(int index) {
+    current_worker = index;
+    while (true) {
+      Task task;
+      if (take(index, task)) {
+        run_task(task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex);
+      if (index == 0) {
+        reserved_idle = true;
+        interactive_available.wait(lock, [this]() { return has_work(0); });
+        reserved_idle = false;
+        continue;
+      }
+
+      ++idle;
+      bool woken = true;
+      if (index < base_count)
+        work_available.wait(lock, [this, index]() { return has_work(index); });
+      else
+        woken = work_available.wait_for(lock, std::chrono::seconds(SCHEDULER_EXTRA_WORKER_IDLE_TIME),
+                                        [this, index]() { return has_work(index); });
+      --idle;
+
+      // Workers started for blocked ones stop when not needed for a while. Only the last one can, so the indices
+      // stay dense. Its own queue is empty, only the worker itself adds to it.
+      if (!woken && index == worker_count - 1) {
+        --worker_count;
+        break;
+      }
+    }
+    current_worker = -1;
+  }
+
+  void begin_blocking() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++blocked;
+    if (worker_count - blocked < base_count && idle == 0 && worker_count < SCHEDULER_MAX_THREADS)
+      start_worker();
+  }
+
+  void end_blocking() {
+    std::lock_guard<std::mutex> lock(mutex);
+    --blocked;
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TaskScheduler *TaskScheduler::get() {
+  // Never freed, so tasks can still be posted while static objects are destroyed.
+  static TaskScheduler *scheduler = new TaskScheduler();
+  return scheduler;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TaskScheduler::TaskScheduler() : _d(new Private()) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TaskScheduler::post(TaskPriority priority, const Task &task) {
+  // Counted first, so a worker never sees a task that isn't counted.
+  ++_d->queued[priority];
+
+  int index = current_worker;
+  if (index >= 0) {
+    std::lock_guard<std::mutex> lock(_d->queues[index]->mutex);
+    _d->queues[index]->tasks[priority].push_back(task);
+  }
+
+  std::lock_guard<std::mutex> lock(_d->mutex);
+  if (index < 0)
+    _d->shared[priority].push_back(task);
+  _d->wake(priority);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TaskScheduler::run_parallel(TaskPriority priority, size_t count, const std::function<void(size_t)> &body) {
+  if (count == 0)
+    return;
+
+  // The caller takes the calls not started by a worker yet, so this never waits for a free worker.
+  std::shared_ptr<ParallelRun> run = std::make_shared<ParallelRun>(body, count);
+  for (size_t i = 1; i < count; ++i)
+    post(priority, [run]() { run->run(); });
+  run->run();
+
+  std::unique_lock<std::mutex> lock(run->mutex);
+  run->done.wait(lock, [&run]() { return run->finished == run->count; });
+  if (run->error)
+    std::rethrow_exception(run->error);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t TaskScheduler::thread_count() const {
+  return (size_t)_d->worker_count.load();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TaskScheduler::BlockingScope::BlockingScope() : _counted(current_worker >= 0) {
+  if (_counted)
+    TaskScheduler::get()->_d->begin_blocking();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TaskScheduler::BlockingScope::~BlockingScope() {
+  if (_counted)
+    TaskScheduler::get()->_d->end_blocking();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -23,21 +23,33 @@
 
 #include <stdio.h>
 #include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #include "base/threaded_timer.h"
 #include "base/log.h"
 #include "base/threading.h"
+#include "base/task_scheduler.h"
 
 // 30 fps should ensure smooth animations. Higher values are better, but put higher load on a system.
 #define BASE_FREQUENCY 30
 
-// Define the maximum number of worker threads. If they are used up tasks have to wait.
-#define WORKER_THREAD_COUNT 2
-
 DEFAULT_LOG_DOMAIN(DOMAIN_BASE)
 
 //--------------------------------------------------------------------------------------------------
 
+class ThreadedTimer::Wakeup {
+public:
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool pending = false; // Set when the task list changed since the timer thread last looked at it.
+  int running = 0;      // Callbacks posted to the task scheduler and not finished yet.
+};
+
+//--------------------------------------------------------------------------------------------------
+
 static ThreadedTimer *_timer = NULL;
 G_LOCK_DEFINE(_timer);
 
@@ -111,6 +123,7 @@ int ThreadedTimer::add_task(TimerUnit unit, double value, bool single_shot, Time
     // We have the lock acquired so it is save to increment the id counter.
     task.task_id = timer->_next_id++;
     timer->_tasks.push_back(task);
+    timer->wake();
 
     return task.task_id;
   }
@@ -132,11 +145,10 @@ void ThreadedTimer::remove_task(int task_id) {
 
 //--------------------------------------------------------------------------------------------------
 
-ThreadedTimer::ThreadedTimer(int base_frequency) : _terminate(false), _next_id(1) {
+ThreadedTimer::ThreadedTimer(int base_frequency) : _terminate(false), _next_id(1), _wakeup(new Wakeup()) {
   // Wait time in microseconds.
   _wait_time = 1000 * 1000 / base_frequency;
   _thread = base::create_thread(start, this);
-  _pool = g_thread_pool_new((GFunc)pool_function, this, WORKER_THREAD_COUNT, FALSE, NULL);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -145,17 +157,21 @@ ThreadedTimer::ThreadedTimer(int base_frequency) : _terminate(false), _next_id(1
  * Shuts down the timer and does not return until currently running threads have terminated.
  */
 ThreadedTimer::~ThreadedTimer() {
-  // Free the thread pool but wait until tasks, which are currently executing have finished.
-  // Pending tasks are discarded.
+  // Wait until tasks, which are currently executing have finished. Pending tasks are discarded.
   logDebug2("Threaded timer shutdown...\n");
 
   // Don't lock the mutex or we might deadlock here if the mutex is currently held by the work loop.
   _terminate = true;
+  wake();
 
   // Wait for the timer thread to terminate.
   g_thread_join(_thread);
 
-  g_thread_pool_free(_pool, TRUE, TRUE);
+  {
+    std::unique_lock<std::mutex> wakeup_lock(_wakeup->mutex);
+    _wakeup->condition.wait(wakeup_lock, [this]() { return _wakeup->running == 0; });
+  }
+  delete _wakeup;
 
   logDebug2("Threaded timer shutdown done\n");
 }
@@ -174,34 +190,39 @@ gpointer ThreadedTimer::start(gpointer data) {
 //--------------------------------------------------------------------------------------------------
 
 /**
- * Entry point for all pool (worker) threads.
+ * Runs the callback of a due task on one of the task scheduler's workers. Callbacks may block (e.g. pinging a
+ * server), so they run within a blocking scope.
  */
-gpointer ThreadedTimer::pool_function(gpointer data, gpointer user_data) {
-  ThreadedTimer *timer = static_cast<ThreadedTimer *>(user_data);
-  TimerTask *task = static_cast<TimerTask *>(data);
-
-  try {
-    bool do_stop = task->callback(task->task_id);
-
-    base::MutexLock lock(timer->_timer_lock);
-    task->stop = do_stop || task->single_shot;
-    task->scheduled = false;
-  } catch (std::exception &e) {
-    // In the case of an exception we remove the task silently.
-    base::MutexLock lock(timer->_timer_lock);
-    task->stop = true;
-    task->scheduled = false;
-    logWarning("Threaded timer: exception in pool function: %s\n", e.what());
-  } catch (...) {
-    // Most exceptions should be caught by the part above. Just to be on the safe side
-    // do this extra branch.
-    base::MutexLock(timer->_timer_lock);
-    task->stop = true;
-    task->scheduled = false;
-    logWarning("Threaded timer: unknown exception in pool function\n");
+void ThreadedTimer::run_task(TimerTask *task) {
+  // The timer may be shutting down, which discards pending tasks.
+  if (!_terminate) {
+    base::TaskScheduler::BlockingScope blocking;
+    try {
+      bool do_stop = task->callback(task->task_id);
+
+      base::MutexLock lock(_timer_lock);
+      task->stop = do_stop || task->single_shot;
+      task->scheduled = false;
+      wake(); // The task might be due again already.
+    } catch (std::exception &e) {
+      // In the case of an exception we remove the task silently.
+      base::MutexLock lock(_timer_lock);
+      task->stop = true;
+      task->scheduled = false;
+      logWarning("Threaded timer: exception in pool function: %s\n", e.what());
+    } catch (...) {
+      // Most exceptions should be caught by the part above. Just to be on the safe side
+      // do this extra branch.
+      base::MutexLock lock(_timer_lock);
+      task->stop = true;
+      task->scheduled = false;
+      logWarning("Threaded timer: unknown exception in pool function\n");
+    }
   }
 
-  return NULL;
+  std::lock_guard<std::mutex> lock(_wakeup->mutex);
+  if (--_wakeup->running == 0)
+    _wakeup->condition.notify_all();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -220,9 +241,20 @@ void ThreadedTimer::main_loop() {
   // Provides a high-quality clock which is used to compute execution times of tasks.
   GTimer *clock = g_timer_new();
   g_timer_start(clock);
+  gdouble next_due = -1; // Seconds until the next task is due, negative if no task is waiting.
   while (!_terminate) {
-    // This sleep call forms our base frequency.
-    g_usleep(_wait_time);
+    // Sleep until the next task is due, at least the time that forms our base frequency. Without any task waiting
+    // we sleep until one is added, so an idle timer doesn't wake up at all.
+    {
+      std::unique_lock<std::mutex> wakeup_lock(_wakeup->mutex);
+      auto woken = [this]() { return _wakeup->pending || _terminate; };
+      if (next_due < 0)
+        _wakeup->condition.wait(wakeup_lock, woken);
+      else
+        _wakeup->condition.wait_for(
+          wakeup_lock, std::chrono::microseconds(std::max((gint64)_wait_time, (gint64)(next_due * 1000000))), woken);
+      _wakeup->pending = false;
+    }
 
     if (_terminate)
       break;
@@ -242,18 +274,28 @@ void ThreadedTimer::main_loop() {
         break;
 
       if (!iterator->scheduled && iterator->next_time <= current_time && !iterator->stop) {
-        // When the task is due push it to our thread pool. It will then get one of the
-        // free threads assigned to run in and pool_function is called in this thread's context.
+        // When the task is due hand it to the task scheduler, which runs it on one of its worker threads.
         // Do it only if it isn't already scheduled.
-        TimerTask &task = *iterator;
-        task.scheduled = true;
-        task.next_time += task.wait_time;
-        g_thread_pool_push(_pool, &task, NULL);
+        TimerTask *task = &*iterator;
+        task->scheduled = true;
+        task->next_time += task->wait_time;
+        {
+          std::lock_guard<std::mutex> wakeup_lock(_wakeup->mutex);
+          ++_wakeup->running;
+        }
+        base::TaskScheduler::get()->post(base::TaskBackground, [this, task]() { run_task(task); });
       }
     }
 
     // 3. Remove stopped task.
     _tasks.remove_if(IsStopped());
+
+    // 4. Find out when to look again. Scheduled tasks wake us up when they are done.
+    next_due = -1;
+    for (std::list<TimerTask>::iterator iterator = _tasks.begin(); iterator != _tasks.end(); ++iterator) {
+      if (!iterator->scheduled && (next_due < 0 || iterator->next_time - current_time < next_due))
+        next_due = std::max(0.0, iterator->next_time - current_time);
+    }
   }
   g_timer_destroy(clock);
 }
@@ -274,3 +316,14 @@ void ThreadedTimer::remove(int task_id) {
 }
 
 //--------------------------------------------------------------------------------------------------
+
+/**
+ * Tells the timer thread to look at the task list again, because it changed.
+ */
+void ThreadedTimer::wake() {
+  std::lock_guard<std::mutex> lock(_wakeup->mutex);
+  _wakeup->pending = true;
+  _wakeup->condition.notify_one();
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/trace.h"
+#include "base/file_functions.h"
+#include "base/string_utilities.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define TRACE_MAX_EVENTS_PER_THREAD (1024 * 1024) // Later spans of a thread are counted but not kept.
+
+using namespace base;
+
+namespace {
+  struct TraceEvent {
+    const char *category;
+    const char *name;
+    std::uint64_t start;
+    std::uint64_t end;
+  };
+
+  struct ThreadBuffer {
+    int tid;
+    std::mutex mutex; // Only contended while the trace is written or cleared.
+    std::vector<TraceEvent> events;
+    size_t dropped = 0;
+  };
+
+  // Never freed: buffers outlive their threads, so spans of finished threads are written too, and the trace can
+  // still be written by an atexit handler after static objects were destroyed.
+  std::mutex *buffers_mutex = new std::mutex();
+  std::list<std::unique_ptr<ThreadBuffer> > *buffers = new std::list<std::unique_ptr<ThreadBuffer> >();
+  std::uint64_t origin = 0; // Time tracing was first started, the trace timestamps are relative to it.
+
+  ThreadBuffer *thread_buffer() {
+    static thread_local ThreadBuffer *buffer = nullptr;
+    if (buffer == nullptr) {
+      std::lock_guard<std::mutex> lock(*buffers_mutex);
+      buffers->emplace_back(new ThreadBuffer());
+      buffer = buffers->back().get();
+      buffer->tid = (int)buffers->size();
+    }
+    return buffer;
+  }
+
+  // A %p in the path is replaced by the process id, so wbcopytables started from Workbench writes its own trace.
+  void write_at_exit() {
+    const char *path = getenv("WB_TRACE_FILE");
+    if (path != nullptr && *path != 0)
+      Tracer::write(replaceString(path, "%p", std::to_string(getpid())));
+  }
+
+  struct TraceFromEnvironment {
+    TraceFromEnvironment() {
+      const char *path = getenv("WB_TRACE_FILE");
+      if (path != nullptr && *path != 0) {
+        Tracer::start();
+        atexit(write_at_exit);
+      }
+    }
+  };
+}
+
+volatile bool Tracer::_enabled = false;
+
+static TraceFromEnvironment trace_from_environment;
+
+//--------------------------------------------------------------------------------------------------
+
+void Tracer::start() {
+  if (origin == 0)
+    origin = now();
+  _enabled = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Tracer::stop() {
+  _enabled = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(*buffers_mutex);
+  for (auto &buffer : *buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->dropped = 0;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::uint64_t Tracer::now() {
+  return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Tracer::record(const char *category, const char *name, std::uint64_t start, std::uint64_t end) {
+  ThreadBuffer *buffer = thread_buffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  if (buffer->events.size() >= TRACE_MAX_EVENTS_PER_THREAD) {
+    ++buffer->dropped;
+    return;
+  }
+  buffer->events.push_back({category, name, start, end});
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Writes the spans as complete ("X") events of the Chrome trace event format, with microsecond timestamps.
+ */
+bool Tracer::write(const std::string &path) {
+  FILE *file = base_fopen(path.c_str(), "w");
+  if (file == nullptr)
+    return false;
+
+  std::string line;
+  const char *separator = "";
+  fputs("{\"traceEvents\":[", file);
+
+  std::lock_guard<std::mutex> lock(*buffers_mutex);
+  for (auto &buffer : *buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    for (const TraceEvent &event : buffer->events) {
+      line = strfmt("%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    separator, escape_json_string(event.name).c_str(), escape_json_string(event.category).c_str(),
+                    buffer->tid, (event.start - origin) / 1000.0, (event.end - event.start) / 1000.0);
+      fwrite(line.data(), 1, line.size(), file);
+      separator = ",";
+    }
+    if (buffer->dropped > 0) {
+      line = strfmt("%s\n{\"name\":\"dropped %lu spans\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":0}",
+                    separator, (unsigned long)buffer->dropped, buffer->tid);
+      fwrite(line.data(), 1, line.size(), file);
+      separator = ",";
+    }
+  }
+
+  fputs("\n],\"displayTimeUnit\":\"ns\"}\n", file);
+  bool ok = ferror(file) == 0;
+  if (fclose(file) != 0)
+    ok = false;
+  return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/interned_string.h"
+#include "base/mem_stat.h"
+#include "wb_helpers.h"
+
+#include <map>
+#include <thread>
+#include <unordered_set>
+
+using namespace base;
+
+TEST_MODULE(interned_string_test, "Base library interned string tests");
+
+TEST_FUNCTION(10) {
+  // Equal values share their text, different ones don't.
+  InternedString a("interned_string_test id");
+  InternedString b(std::string("interned_string_test ") + "id");
+  InternedString c("interned_string_test name");
+  ensure("same text", &a.str() == &b.str());
+  ensure("equal", a == b);
+  ensure("not equal", a != c);
+  ensure_equals("hash", a.hash(), b.hash());
+
+  // Comparisons with plain strings go by the text.
+  ensure("std::string", a == std::string("interned_string_test id"));
+  ensure("literal", c == "interned_string_test name");
+  ensure("literal left", "interned_string_test name" == c);
+  ensure("different literal", a != "interned_string_test ID");
+  ensure_equals("size", a.size(), 23U);
+
+  InternedString empty;
+  ensure("default is empty", empty.empty());
+  ensure("empty equal", empty == InternedString(""));
+  ensure("null pointer", empty == InternedString((const char *)nullptr));
+
+  // Sorted containers keep the text order.
+  std::map<InternedString, int> sorted = { { "c", 3 }, { "a", 1 }, { "b", 2 } };
+  std::string order;
+  for (auto &entry : sorted)
+    order += entry.first;
+  ensure_equals("order", order, "abc");
+
+  std::unordered_set<InternedString> set = { a, b, c };
+  ensure_equals("hashed", set.size(), 2U);
+}
+
+TEST_FUNCTION(20) {
+  // Interning from several threads at once still stores every value once.
+  std::vector<std::thread> threads;
+  std::vector<std::vector<InternedString>> results(4);
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.push_back(std::thread([&results, i]() {
+      for (int j = 0; j < 1000; ++j)
+        results[i].push_back(InternedString("interned_string_test column " + std::to_string(j)));
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  for (size_t i = 1; i < results.size(); ++i)
+    for (size_t j = 0; j < 1000; ++j)
+      ensure("shared across threads", results[i][j] == results[0][j]);
+
+  std::int64_t bytes = 0, count = 0;
+  InternedString::pool_usage(bytes, count);
+  ensure("pool count", count >= 1000);
+  ensure("pool bytes", bytes >= count * (std::int64_t)sizeof(std::string));
+
+  bool found = false;
+  for (auto &usage : MemoryAccounting::usage())
+    if (usage.name == "Interned strings")
+      found = usage.items == count;
+  ensure("accounted", found);
+}
+
+END_TESTS;
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/mem_stat.h"
+#include "wb_helpers.h"
+
+using namespace base;
+
+TEST_MODULE(mem_stat_test, "Base library memory accounting tests");
+
+static const MemoryAccounting::Usage *find_usage(const std::vector<MemoryAccounting::Usage> &usage,
+                                                 const std::string &name) {
+  for (const MemoryAccounting::Usage &entry : usage)
+    if (entry.name == name)
+      return &entry;
+  return nullptr;
+}
+
+TEST_FUNCTION(10) {
+  // Sources with the same name are summed and the result is sorted by bytes.
+  std::int64_t cache = 100;
+  int first = MemoryAccounting::add_source("mem_stat_test cache", [&cache](MemoryAccounting::Usage &usage) {
+    usage.bytes = cache;
+    usage.items = 1;
+  });
+  int second = MemoryAccounting::add_source("mem_stat_test cache", [](MemoryAccounting::Usage &usage) {
+    usage.bytes = 50;
+    usage.items = 2;
+  });
+  int third = MemoryAccounting::add_source("mem_stat_test big", [](MemoryAccounting::Usage &usage) {
+    usage.bytes = 1000;
+  });
+
+  std::vector<MemoryAccounting::Usage> usage = MemoryAccounting::usage();
+  const MemoryAccounting::Usage *entry = find_usage(usage, "mem_stat_test cache");
+  ensure("cache found", entry != nullptr);
+  ensure_equals("cache bytes", entry->bytes, 150);
+  ensure_equals("cache items", entry->items, 3);
+  ensure("big before cache", find_usage(usage, "mem_stat_test big") < entry);
+
+  // Sources are measured again for every report.
+  cache = 200;
+  usage = MemoryAccounting::usage();
+  entry = find_usage(usage, "mem_stat_test cache");
+  ensure_equals("cache bytes", entry->bytes, 250);
+
+  ensure("report", MemoryAccounting::report().find("mem_stat_test big") != std::string::npos);
+
+  MemoryAccounting::remove_source(first);
+  MemoryAccounting::remove_source(second);
+  MemoryAccounting::remove_source(third);
+  usage = MemoryAccounting::usage();
+  ensure("removed", find_usage(usage, "mem_stat_test cache") == nullptr);
+}
+
+END_TESTS;
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -944,4 +944,44 @@ TEST_FUNCTION(50) {
                 base::replaceString("D:/files/to/scan", "/", separator));
 }
 
+// Buffer based escaping and wide char conversion used by the copy tables hot path.
+TEST_FUNCTION(55) {
+  std::string input = "plain text without anything to escape, long enough for several blocks";
+  ensure_equals("Escaping clean text", base::escape_sql_string(input), input);
+
+  input = std::string("a'b\"c\\d\ne\rf\032g", 13) + std::string(1, '\0') + "0123456789abcdef'";
+  std::string expected = "a\\'b\\\"c\\\\d\\ne\\rf\\Zg\\00123456789abcdef\\'";
+  ensure_equals("Escaping special characters", base::escape_sql_string(input), expected);
+  ensure_equals("Escaping wildcards", base::escape_sql_string("0123456789abcdef_%", true),
+                "0123456789abcdef\\_\\%");
+  ensure_equals("Escaping without wildcards", base::escape_sql_string("0123456789abcdef_%", false),
+                "0123456789abcdef_%");
+
+  std::wstring wide = L"ascii äöü €";
+  char buffer[64];
+  size_t length = base::wide_to_utf8_buffer(wide.c_str(), wide.size(), buffer, sizeof(buffer));
+  ensure_true("Wide char conversion", length != (size_t)-1);
+  ensure_equals("Wide char conversion", std::string(buffer, length), base::wstring_to_string(wide));
+  ensure_true("Wide char conversion overflow",
+              base::wide_to_utf8_buffer(wide.c_str(), wide.size(), buffer, 8) == (size_t)-1);
+}
+
+// ASCII fast paths of the case conversion and comparison functions.
+TEST_FUNCTION(60) {
+  std::string ascii = "The Quick Brown Fox Jumps Over The Lazy Dog 0123456789 []{}";
+  ensure_true("ASCII detection", base::is_ascii(ascii.data(), ascii.size()));
+  ensure_true("ASCII detection", !base::is_ascii("0123456789abcdef\xC3\xA4", 18));
+  ensure_true("ASCII detection with NUL", !base::is_ascii(std::string("0123456789abcdef\0x", 18).data(), 18));
+
+  ensure_equals("ASCII lower case", base::tolower(ascii), "the quick brown fox jumps over the lazy dog 0123456789 []{}");
+  ensure_equals("ASCII upper case", base::toupper(ascii), "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 []{}");
+  ensure_equals("Mixed lower case", base::tolower("Quick \xC3\x84pfel"), "quick \xC3\xA4pfel");
+
+  ensure_true("Case insensitive compare", base::same_string(ascii, base::toupper(ascii), false));
+  ensure_true("Case sensitive compare", !base::same_string(ascii, base::toupper(ascii), true));
+  ensure_true("Different lengths", !base::same_string("abc", "abcd", false));
+  ensure_true("Contains, case insensitive", base::contains_string(ascii, "LAZY DOG", false));
+  ensure_true("Contains, case sensitive", !base::contains_string(ascii, "LAZY DOG", true));
+}
+
 END_TESTS
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/task_scheduler.h"
+#include "wb_helpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace base;
+
+TEST_MODULE(task_scheduler_test, "Base library task scheduler tests");
+
+TEST_FUNCTION(10) {
+  // Every call of a parallel run is made once and all are done when it returns.
+  TaskScheduler *scheduler = TaskScheduler::get();
+  ensure("workers", scheduler->thread_count() >= 2);
+
+  std::vector<int> calls(100, 0);
+  scheduler->run_parallel(TaskBulk, calls.size(), [&calls](size_t index) { ++calls[index]; });
+  for (size_t i = 0; i < calls.size(); ++i)
+    ensure_equals("call count", calls[i], 1);
+
+  bool thrown = false;
+  try {
+    scheduler->run_parallel(TaskBackground, 4, [](size_t index) {
+      if (index == 2)
+        throw std::runtime_error("failed");
+    });
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  ensure("exception passed on", thrown);
+}
+
+TEST_FUNCTION(20) {
+  // Posted tasks run even when all workers are blocked, and an interactive task isn't held up by bulk ones.
+  TaskScheduler *scheduler = TaskScheduler::get();
+  std::atomic<bool> release(false);
+  std::atomic<size_t> finished(0);
+  size_t count = scheduler->thread_count();
+  for (size_t i = 0; i < count; ++i)
+    scheduler->post(TaskBulk, [&release, &finished]() {
+      TaskScheduler::BlockingScope blocking;
+      while (!release)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      ++finished;
+    });
+
+  std::atomic<bool> done(false);
+  scheduler->post(TaskInteractive, [&done]() { done = true; });
+  for (int i = 0; i < 5000 && !done; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  ensure("interactive task done", done);
+
+  std::atomic<bool> background_done(false);
+  scheduler->post(TaskBackground, [&background_done]() { background_done = true; });
+  for (int i = 0; i < 5000 && !background_done; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  ensure("background task done", background_done);
+
+  release = true;
+  while (finished < count)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+END_TESTS
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/trace.h"
+#include "base/file_utilities.h"
+#include "base/jsonparser.h"
+#include "wb_helpers.h"
+
+TEST_MODULE(trace_test, "Base library tracing tests");
+
+static void span(int count) {
+  for (int i = 0; i < count; ++i) {
+    TRACE_SPAN("test", "trace_test::span");
+  }
+}
+
+TEST_FUNCTION(10) {
+  // Spans are only recorded while tracing.
+  base::Tracer::clear();
+  span(3);
+
+  base::Tracer::start();
+  {
+    TRACE_SPAN("test", "trace_test::outer");
+    span(2);
+  }
+  base::Tracer::stop();
+  span(3);
+
+  std::string path = "trace_test.json";
+  ensure("write", base::Tracer::write(path));
+
+  JsonParser::JsonValue value;
+  JsonParser::JsonReader::readFromFile(path, value);
+  JsonParser::JsonObject &trace = value;
+  JsonParser::JsonArray &events = trace.get("traceEvents");
+  ensure_equals("event count", events.size(), 3U);
+
+  size_t spans = 0;
+  for (JsonParser::JsonValue &event : events) {
+    JsonParser::JsonObject &object = event;
+    ensure_equals("phase", (std::string)object.get("ph"), "X");
+    ensure_equals("category", (std::string)object.get("cat"), "test");
+    std::string name = object.get("name");
+    if (name == "trace_test::span")
+      ++spans;
+    else
+      ensure_equals("outer name", name, "trace_test::outer");
+    ensure("duration", (double)object.get("dur") >= 0);
+  }
+  ensure_equals("inner spans", spans, 2U);
+
+  base::Tracer::clear();
+  base::remove(path);
+}
+
+END_TESTS;
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -262,6 +262,8 @@ namespace base {
   }
 
   bool utf8string::validate() const {
+    if (is_ascii(_inner_string.data(), _inner_string.size()))
+      return true;
     return g_utf8_validate(_inner_string.c_str(), -1, nullptr) == TRUE;
   }
 
@@ -295,6 +297,9 @@ namespace base {
   }
 
   int utf8string::compareNormalized(const utf8string& s) const {
+    // Identical bytes normalize and collate the same, which is the common case for equality checks.
+    if (_inner_string == s._inner_string)
+      return 0;
     return g_utf8_collate(normalize().c_str(), s.normalize().c_str());
   }
 
@@ -335,7 +340,14 @@ namespace base {
     return !(*this < s);
   }
 
+  // ASCII text is converted in place on a copy, for all other text GLib does the Unicode case mapping.
   utf8string utf8string::to_lower() const {
+    if (is_ascii(_inner_string.data(), _inner_string.size())) {
+      utf8string result(*this);
+      ascii_tolower(&result._inner_string[0], result._inner_string.size());
+      return result;
+    }
+
     gchar* down = g_utf8_strdown(_inner_string.c_str(), _inner_string.size());
     utf8string result(down);
     g_free(down);
@@ -343,6 +355,12 @@ namespace base {
   }
 
   utf8string utf8string::to_upper() const {
+    if (is_ascii(_inner_string.data(), _inner_string.size())) {
+      utf8string result(*this);
+      ascii_toupper(&result._inner_string[0], result._inner_string.size());
+      return result;
+    }
+
     gchar* up = g_utf8_strup(_inner_string.c_str(), _inner_string.size());
     utf8string result(up);
     g_free(up);
@@ -350,6 +368,10 @@ namespace base {
   }
 
   utf8string utf8string::to_case_fold() const {
+    // Case folding of ASCII is the same as converting to lower case.
+    if (is_ascii(_inner_string.data(), _inner_string.size()))
+      return to_lower();
+
     gchar* casefold = g_utf8_casefold(_inner_string.c_str(), _inner_string.size());
     utf8string result(casefold);
     g_free(casefold);
@@ -421,6 +443,10 @@ namespace base {
     if (bytes() == 0 || s.bytes() == 0)
       return false;
 
+    if (is_ascii(_inner_string.data(), _inner_string.size()) &&
+        is_ascii(s._inner_string.data(), s._inner_string.size()))
+      return base::contains_string(_inner_string, s._inner_string, case_sensitive);
+
     gchar* hay_stack = g_utf8_normalize(c_str(), -1, G_NORMALIZE_DEFAULT);
     gchar* needle = g_utf8_normalize(s.c_str(), -1, G_NORMALIZE_DEFAULT);
 
@@ -602,11 +628,15 @@ namespace base {
   //  Capacity
   //////////////////////////////////////////////////////////////////////////////
   size_t utf8string::size() const {
+    if (is_ascii(_inner_string.data(), _inner_string.size()))
+      return _inner_string.size();
     const char* ptr = _inner_string.data();
     return g_utf8_pointer_to_offset(ptr, ptr + _inner_string.size());
   }
 
   size_t utf8string::length() const {
+    if (is_ascii(_inner_string.data(), _inner_string.size()))
+      return _inner_string.size();
     const char* ptr = _inner_string.data();
     // return g_utf8_pointer_to_offset(ptr, ptr + _inner_string.size());
     return g_utf8_strlen(ptr, _inner_string.size());
@@ -29,9 +29,19 @@
 #include "cppconn/exception.h"
 #include "cppconn/metadata.h"
 #include "base/string_utilities.h"
+#include "base/task_scheduler.h"
+#include "grtpp_util.h"
 
 #include <gmodule.h>
 
+// Number of connections opened ahead, enough for the user and aux connection of a new SQL editor.
+#define WARM_POOL_SIZE 2
+// Seconds an unused pre-opened connection is kept.
+#define WARM_POOL_TIMEOUT 30
+
+// Maximum number of prepared statements kept per connection. The cache starts over when it is full.
+#define PREPARED_STATEMENT_CACHE_SIZE 64
+
 namespace sql {
 
   typedef std::map<std::string, std::string> Param_types;
@@ -128,6 +138,15 @@ namespace sql {
     return uri;
   }
 
+  // Everything a connection is opened with, so a pre-opened connection is never used for changed settings.
+  static std::string warm_pool_signature(const db_mgmt_ConnectionRef &connectionProperties) {
+    std::string signature = connectionProperties->driver()->id() + "\n" + *connectionProperties->hostIdentifier();
+    grt::DictRef parameter_values = connectionProperties->parameterValues();
+    for (grt::DictRef::const_iterator it = parameter_values.begin(); it != parameter_values.end(); ++it)
+      signature += "\n" + it->first + "=" + it->second.toString();
+    return signature;
+  }
+
   //----------------- DriverManager ------------------------------------------------------------------
 
   DriverManager *DriverManager::getDriverManager() {
@@ -185,11 +204,128 @@ namespace sql {
     }
     return getConnection(connectionProperties, tunnel, Authentication::Ref(), connection_init_slot);
   }
+  //--------------------------------------------------------------------------------------------------
+
+  void DriverManager::preconnect(const db_mgmt_ConnectionRef &connectionProperties) {
+    db_mgmt_DriverRef drv = connectionProperties->driver();
+    grt::DictRef parameter_values = connectionProperties->parameterValues();
+
+    // SSH tunnels may have to ask for credentials or accept a host key, which a background connect cannot do.
+    if (!drv.is_valid() || drv->name() == "MysqlNativeSSH" || parameter_values.get_string("userName").empty())
+      return;
+
+    std::string password = parameter_values.get_string("password");
+    if (password.empty() && !(_findPassword && _findPassword(connectionProperties, password)))
+      return;
+
+    std::string signature = warm_pool_signature(connectionProperties);
+    std::size_t needed = WARM_POOL_SIZE;
+    std::list<ConnectionPtr> expired;
+    {
+      std::lock_guard<std::mutex> lock(_warmPoolMutex);
+      discardExpiredConnections(expired);
+      if (_warming.count(signature) > 0)
+        return;
+
+      for (auto &entry : _warmPool) {
+        if (entry.signature == signature && needed > 0)
+          --needed;
+      }
+      if (needed == 0)
+        return;
+      _warming.insert(signature);
+    }
+
+    // Connect with a copy of the settings, the original may be edited while the connection is opened.
+    db_mgmt_ConnectionRef copy(grt::Initialized);
+    copy->owner(connectionProperties->owner());
+    copy->driver(drv);
+    copy->hostIdentifier(connectionProperties->hostIdentifier());
+    grt::merge_contents(copy->parameterValues(), parameter_values, true);
+
+    // With an explicit password a failed login throws instead of prompting.
+    Authentication::Ref auth = Authentication::create(copy);
+    auth->set_password(password.c_str());
+
+    // The scheduler's threads live as long as the process, so there is no thread_cleanup() afterwards.
+    base::TaskScheduler::get()->post(base::TaskBulk, [this, copy, auth, signature, needed]() {
+      base::TaskScheduler::BlockingScope blocking;
+      for (std::size_t i = 0; i < needed; ++i) {
+        try {
+          ConnectionWrapper wrapper = openConnection(copy, std::shared_ptr<TunnelConnection>(), auth);
+          WarmConnection entry = {signature, wrapper.get_ptr(), time(NULL)};
+
+          std::lock_guard<std::mutex> lock(_warmPoolMutex);
+          _warmPool.push_back(entry);
+        } catch (std::exception &) {
+          // Not fatal, the connection is opened as usual when it's actually needed.
+          break;
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_warmPoolMutex);
+        _warming.erase(signature);
+      }
+    });
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  // Returns a pre-opened connection with the given settings that is still alive, if there is one.
+  ConnectionPtr DriverManager::takeWarmConnection(const db_mgmt_ConnectionRef &connectionProperties) {
+    std::list<ConnectionPtr> discarded; // Closed outside of the lock.
+    std::string signature;
+
+    while (true) {
+      ConnectionPtr connection;
+      {
+        std::lock_guard<std::mutex> lock(_warmPoolMutex);
+        discardExpiredConnections(discarded);
+        if (_warmPool.empty())
+          return ConnectionPtr();
+
+        if (signature.empty())
+          signature = warm_pool_signature(connectionProperties);
+        for (auto it = _warmPool.begin(); it != _warmPool.end(); ++it) {
+          if (it->signature == signature) {
+            connection = it->connection;
+            _warmPool.erase(it);
+            break;
+          }
+        }
+      }
+
+      if (!connection)
+        return ConnectionPtr();
+
+      // The server may have dropped the connection meanwhile, isValid() pings it.
+      if (connection->isValid())
+        return connection;
+      discarded.push_back(connection);
+    }
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  // Moves unused connections older than WARM_POOL_TIMEOUT to the given list. Must be called with the pool locked.
+  void DriverManager::discardExpiredConnections(std::list<ConnectionPtr> &expired) {
+    time_t now = time(NULL);
+    for (auto it = _warmPool.begin(); it != _warmPool.end();) {
+      if (now - it->created > WARM_POOL_TIMEOUT) {
+        expired.push_back(it->connection);
+        it = _warmPool.erase(it);
+      } else
+        ++it;
+    }
+  }
+
   //--------------------------------------------------------------------------------------------------
   // This method is called when each dispatcher is ending is about to be gone
   // it needs to be called right after that to cleanup the thread storage allocated by driver.
   // If we will not free the mem then after wb close we will get error about "threads didn't exit"
   void DriverManager::thread_cleanup() {
+    std::lock_guard<std::mutex> lock(_mutex);
     for (auto &it : _drivers)
       it.second();
   }
@@ -214,6 +350,23 @@ namespace sql {
   ConnectionWrapper DriverManager::getConnection(const db_mgmt_ConnectionRef &connectionProperties,
                                                  std::shared_ptr<TunnelConnection> tunnel, Authentication::Ref password,
                                                  ConnectionInitSlot connection_init_slot) {
+    if (!tunnel) {
+      ConnectionPtr warm = takeWarmConnection(connectionProperties);
+      if (warm) {
+        if (connection_init_slot)
+          connection_init_slot(warm.get(), connectionProperties);
+        return ConnectionWrapper(warm, tunnel);
+      }
+    }
+    return openConnection(connectionProperties, tunnel, password, connection_init_slot);
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  ConnectionWrapper DriverManager::openConnection(const db_mgmt_ConnectionRef &connectionProperties,
+                                                  std::shared_ptr<TunnelConnection> tunnel,
+                                                  Authentication::Ref password,
+                                                  ConnectionInitSlot connection_init_slot) {
     grt::DictRef parameter_values = connectionProperties->parameterValues();
     if (parameter_values.get_string("userName").empty())
       throw SQLException("No user name set for this connection");
@@ -263,10 +416,12 @@ namespace sql {
     }
     if (driver == NULL)
       throw SQLException("Database driver: Failed to get driver instance. Check  settings.");
-    else
-      _drivers[library] = std::bind(&Driver::threadEnd, driver);
 
-    getClientLibVersion(driver);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _drivers[library] = std::bind(&Driver::threadEnd, driver);
+      getClientLibVersion(driver);
+    }
 
     // 2. call driver->connect()
     Param_types param_types;
@@ -385,6 +540,7 @@ namespace sql {
       if (password->is_valid())
         properties["password"] = std::string(authref->password());
     } else {
+      std::lock_guard<std::mutex> lock(_mutex);
       // password not in profile (and no keyfile provided)
       if (_requestPassword && (force_ask_password || parameter_values.get_string("password") == "")) {
         // check if we have cached the password for this connection
@@ -492,6 +648,7 @@ namespace sql {
 
       throw;
     } catch (...) {
+      std::lock_guard<std::mutex> lock(_mutex);
       _cacheKey.clear();
       _cachedPassword.clear();
 
@@ -499,4 +656,67 @@ namespace sql {
     }
   }
 
+  //----------------------------------------------------------------------------------------------------------------------
+
+  sql::PreparedStatement *Dbc_connection_handler::prepared_statement(const std::string &query) {
+    sql::Connection *connection = ref.get();
+    if (connection == nullptr)
+      throw SQLException("Cannot prepare a statement without an open connection");
+
+    if (connection != _prepared_on || _prepared_statements.size() >= PREPARED_STATEMENT_CACHE_SIZE) {
+      clear_prepared_statements();
+      _prepared_on = connection;
+    }
+
+    std::shared_ptr<sql::PreparedStatement> &statement = _prepared_statements[query];
+    if (!statement) {
+      try {
+        statement.reset(connection->prepareStatement(query));
+      } catch (...) {
+        _prepared_statements.erase(query);
+        throw;
+      }
+    } else
+      statement->clearParameters();
+
+    return statement.get();
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+
+  void Dbc_connection_handler::clear_prepared_statements() {
+    _prepared_statements.clear();
+    _prepared_on = nullptr;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+
+  bool Dbc_connection_handler::cached_variable(const std::string &name, std::string &value) {
+    if (ref.get() == nullptr || ref.get() != _variables_on)
+      return false;
+
+    std::map<std::string, std::string>::const_iterator variable = _variables.find(name);
+    if (variable == _variables.end())
+      return false;
+    value = variable->second;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+
+  void Dbc_connection_handler::cache_variable(const std::string &name, const std::string &value) {
+    if (ref.get() != _variables_on) {
+      _variables.clear();
+      _variables_on = ref.get();
+    }
+    _variables[name] = value;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+
+  void Dbc_connection_handler::clear_cached_variables() {
+    _variables.clear();
+    _variables_on = nullptr;
+  }
+
 } // namespace sql
@@ -27,11 +27,14 @@
 #include "cppdbc_public_interface.h"
 
 #include <cppconn/driver.h>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <set>
 
 #include "grts/structs.db.mgmt.h"
 #include <cppconn/connection.h>
+#include <cppconn/prepared_statement.h>
 
 #ifndef THROW
 #ifdef _MSC_VER
@@ -157,6 +160,10 @@ namespace sql {
 
     void thread_cleanup();
 
+    // Opens connections in the background which the next getConnection() calls with the same settings return
+    // right away. Does nothing if that would need a tunnel or asking the user for a password.
+    void preconnect(const db_mgmt_ConnectionRef &connectionProperties);
+
     std::shared_ptr<TunnelConnection> getTunnel(const db_mgmt_ConnectionRef &connectionProperties);
 
     // Returns the list of available drivers
@@ -182,20 +189,43 @@ namespace sql {
 
   private:
     void getClientLibVersion(Driver *driver);
+    ConnectionWrapper openConnection(const db_mgmt_ConnectionRef &connectionProperties,
+                                     std::shared_ptr<TunnelConnection> tunnel, Authentication::Ref password,
+                                     ConnectionInitSlot connection_init_slot = ConnectionInitSlot());
+    ConnectionPtr takeWarmConnection(const db_mgmt_ConnectionRef &connectionProperties);
+    void discardExpiredConnections(std::list<ConnectionPtr> &expired);
+
+    struct WarmConnection {
+      std::string signature; // Connection settings the connection was opened with.
+      ConnectionPtr connection;
+      time_t created;
+    };
 
     TunnelFactoryFunction _createTunnel;
     PasswordFindFunction _findPassword;
     PasswordRequestFunction _requestPassword;
 
+    // Connections are opened from several threads at once, this guards the driver list and password cache.
+    std::mutex _mutex;
     std::string _cachedPassword;
     std::string _cacheKey;
     time_t _cacheTime;
     std::string _versionInfo;
+
+    std::mutex _warmPoolMutex;
+    std::list<WarmConnection> _warmPool;
+    std::set<std::string> _warming; // Signatures of connections being opened by preconnect().
   };
 
-  class Dbc_connection_handler {
+  class CPPDBC_PUBLIC_FUNC Dbc_connection_handler {
   public:
-    Dbc_connection_handler() : id(-1), autocommit_mode(true), is_stop_query_requested(false) {
+    Dbc_connection_handler()
+      : id(-1),
+        autocommit_mode(true),
+        is_stop_query_requested(false),
+        last_activity(0),
+        _prepared_on(nullptr),
+        _variables_on(nullptr) {
     }
     typedef std::shared_ptr<Dbc_connection_handler> Ref;
     typedef ConnectionWrapper ConnectionRef;
@@ -206,6 +236,34 @@ namespace sql {
     std::string ssl_cipher;
     bool autocommit_mode;
     bool is_stop_query_requested;
+    double last_activity; // Timestamp of the last time the connection was checked out for use.
+
+    // Session state the user changed, restored when the connection is opened again.
+    std::string sql_mode;
+    std::map<std::string, std::string> user_variables; // Name and value as SQL literal.
+
+    /**
+     * Returns a prepared statement for the given query on this connection, preparing it only the first time.
+     * Parameters are cleared. The statement is owned by the handler and stays valid until the connection changes
+     * or clear_prepared_statements() is called.
+     */
+    sql::PreparedStatement *prepared_statement(const std::string &query);
+    void clear_prepared_statements();
+
+    /**
+     * Session variables read once when the connection was opened, so that version, sql_mode and the like don't
+     * have to be queried again for every tab or operation. Values are only returned for the connection they were
+     * read from and must be cleared when a statement may have changed them.
+     */
+    bool cached_variable(const std::string &name, std::string &value);
+    void cache_variable(const std::string &name, const std::string &value);
+    void clear_cached_variables();
+
+  private:
+    std::map<std::string, std::shared_ptr<sql::PreparedStatement> > _prepared_statements;
+    sql::Connection *_prepared_on; // Connection the cached statements belong to.
+    std::map<std::string, std::string> _variables;
+    sql::Connection *_variables_on; // Connection the cached variables belong to.
   };
 } // namespace sql
 
@@ -24,16 +24,54 @@
 #include "sql_batch_exec.h"
 #include <cppconn/exception.h>
 #include <cppconn/resultset.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <memory>
 
+// Statements per multi-statement packet, so progress is still reported regularly.
+#define BATCH_MAX_STATEMENTS 1000
+// Upper limit of a packet no matter how large max_allowed_packet is, which keeps the memory used for it small.
+#define BATCH_MAX_LENGTH (16 * 1024 * 1024)
+// Room left in a packet for the protocol header.
+#define BATCH_PACKET_OVERHEAD 1024
+#define DEFAULT_SQL_LOG_LIMIT 10000
+
 namespace sql {
 
+  // CALL can return several results, which would break the mapping of results to statements in a batch.
+  static bool can_batch(const std::string &statement) {
+    const char *p = statement.c_str();
+    while (*p) {
+      if (isspace((unsigned char)*p))
+        ++p;
+      else if (*p == '#' || (p[0] == '-' && p[1] == '-')) {
+        while (*p && *p != '\n')
+          ++p;
+      } else if (p[0] == '/' && p[1] == '*') {
+        const char *end = strstr(p + 2, "*/");
+        if (!end)
+          return false;
+        p = end + 2;
+      } else
+        break;
+    }
+
+    for (const char *keyword = "CALL"; *keyword; ++keyword, ++p)
+      if (toupper((unsigned char)*p) != *keyword)
+        return true;
+    return isalnum((unsigned char)*p) || *p == '_';
+  }
+
   SqlBatchExec::SqlBatchExec()
     : _batch_exec_success_count(0),
       _batch_exec_err_count(0),
       _batch_exec_progress_state(0),
       _batch_exec_progress_inc(0),
-      _stop_on_error(true) {
+      _stop_on_error(true),
+      _batch_statements(false),
+      _max_batch_length(0),
+      _sql_log_limit(DEFAULT_SQL_LOG_LIMIT) {
   }
 
   long SqlBatchExec::operator()(sql::Statement *stmt, std::list<std::string> &statements) {
@@ -41,6 +79,19 @@ namespace sql {
     _batch_exec_err_count = 0;
     _sql_log.clear();
 
+    _max_batch_length = 0;
+    if (_batch_statements && statements.size() > 1) {
+      try {
+        std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT @@max_allowed_packet"));
+        if (rs->next())
+          _max_batch_length = (size_t)std::min<uint64_t>(rs->getUInt64(1), BATCH_MAX_LENGTH);
+        _max_batch_length = _max_batch_length > BATCH_PACKET_OVERHEAD ? _max_batch_length - BATCH_PACKET_OVERHEAD : 0;
+      } catch (SQLException &) {
+        // Not a MySQL server or no such variable, run the statements one by one.
+        _max_batch_length = 0;
+      }
+    }
+
     exec_sql_script(stmt, statements, _batch_exec_err_count);
     if (_batch_exec_err_count && !_failback_statements.empty()) {
       long failback_script_exec_err_count = 0;
@@ -59,23 +110,32 @@ namespace sql {
     _batch_exec_progress_state = 0;
     _batch_exec_progress_inc = 1.f / statements.size();
 
-    for (std::list<std::string>::const_iterator i = statements.begin(), i_end = statements.end(); i != i_end; ++i) {
-      try {
-        _sql_log.push_back(*i);
-        if (stmt->execute(*i))
-          std::auto_ptr<sql::ResultSet> rs(stmt->getResultSet());
-        ++_batch_exec_success_count;
-      } catch (SQLException &e) {
-        ++batch_exec_err_count;
-        if (!_error_cb)
-          throw;
-        else {
-          if (&_batch_exec_err_count != &batch_exec_err_count) // applies only to failback scripts
-            _error_cb(-1, "Error when running failback script. Details follow.", "");
-          _error_cb(e.getErrorCode(), e.what(), *i);
+    std::vector<const std::string *> batch;
+    std::list<std::string>::const_iterator i = statements.begin(), i_end = statements.end();
+    while (i != i_end) {
+      // Collect the statements which fit into one packet, including the separators between them.
+      batch.clear();
+      if (_max_batch_length > 0) {
+        size_t length = 0;
+        for (std::list<std::string>::const_iterator next = i; next != i_end && batch.size() < BATCH_MAX_STATEMENTS;
+             ++next) {
+          if (!can_batch(*next) || (!batch.empty() && length + next->size() + 3 > _max_batch_length))
+            break;
+          length += next->size() + 3;
+          batch.push_back(&*next);
         }
       }
-      _batch_exec_progress_state += _batch_exec_progress_inc;
+
+      size_t done;
+      if (batch.size() > 1) {
+        done = exec_batch(stmt, batch, batch_exec_err_count);
+      } else {
+        exec_statement(stmt, *i, batch_exec_err_count);
+        done = 1;
+      }
+
+      std::advance(i, done);
+      _batch_exec_progress_state += _batch_exec_progress_inc * done;
       if (_batch_exec_progress_cb)
         _batch_exec_progress_cb(_batch_exec_progress_state);
 
@@ -84,4 +144,72 @@ namespace sql {
     }
   }
 
+  bool SqlBatchExec::exec_statement(sql::Statement *stmt, const std::string &statement, long &batch_exec_err_count) {
+    try {
+      log_statement(statement);
+      if (stmt->execute(statement))
+        std::unique_ptr<sql::ResultSet> rs(stmt->getResultSet());
+      ++_batch_exec_success_count;
+    } catch (SQLException &e) {
+      ++batch_exec_err_count;
+      if (!_error_cb)
+        throw;
+      else {
+        if (&_batch_exec_err_count != &batch_exec_err_count) // applies only to failback scripts
+          _error_cb(-1, "Error when running failback script. Details follow.", "");
+        _error_cb(e.getErrorCode(), e.what(), statement);
+      }
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Runs the statements as one multi-statement packet. The server returns one result per statement and stops at the
+   * first failing one, so the number of results read tells which statement an error belongs to.
+   * Returns the number of statements done with, which is less than the batch size if one failed.
+   */
+  size_t SqlBatchExec::exec_batch(sql::Statement *stmt, const std::vector<const std::string *> &batch,
+                                  long &batch_exec_err_count) {
+    std::string sql;
+    for (const std::string *statement : batch) {
+      if (!sql.empty())
+        sql.append("\n;\n"); // The line break ends a trailing line comment in the previous statement.
+      sql.append(*statement);
+    }
+
+    size_t executed = 0;
+    try {
+      bool is_result_set = stmt->execute(sql);
+      while (true) {
+        if (is_result_set)
+          std::unique_ptr<sql::ResultSet> rs(stmt->getResultSet());
+        else if (stmt->getUpdateCount() < 0)
+          break;
+        log_statement(*batch[executed]);
+        ++_batch_exec_success_count;
+        if (++executed == batch.size())
+          break;
+        is_result_set = stmt->getMoreResults();
+      }
+    } catch (SQLException &e) {
+      const std::string &statement = *batch[std::min(executed, batch.size() - 1)];
+      log_statement(statement);
+      ++batch_exec_err_count;
+      if (!_error_cb)
+        throw;
+      if (&_batch_exec_err_count != &batch_exec_err_count) // applies only to failback scripts
+        _error_cb(-1, "Error when running failback script. Details follow.", "");
+      _error_cb(e.getErrorCode(), e.what(), statement);
+      return std::min(executed + 1, batch.size());
+    }
+
+    return batch.size();
+  }
+
+  void SqlBatchExec::log_statement(const std::string &statement) {
+    if (_sql_log_limit == 0 || _sql_log.size() < _sql_log_limit)
+      _sql_log.push_back(statement);
+  }
+
 } // namespace sql
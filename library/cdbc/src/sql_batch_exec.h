@@ -29,6 +29,7 @@
 #include <cppconn/connection.h>
 #include <list>
 #include <string>
+#include <vector>
 #include <functional>
 
 namespace sql {
@@ -42,6 +43,10 @@ namespace sql {
 
   private:
     void exec_sql_script(sql::Statement *stmt, std::list<std::string> &statements, long &batch_exec_err_count);
+    bool exec_statement(sql::Statement *stmt, const std::string &statement, long &batch_exec_err_count);
+    size_t exec_batch(sql::Statement *stmt, const std::vector<const std::string *> &batch,
+                      long &batch_exec_err_count);
+    void log_statement(const std::string &statement);
 
   public:
     typedef std::function<int(long long, const std::string &, const std::string &)> Error_cb;
@@ -91,12 +96,34 @@ namespace sql {
     std::list<std::string> _failback_statements;
 
   public:
+    // Sends consecutive statements together as one multi-statement packet, as large as the server's
+    // max_allowed_packet allows. This needs a connection opened with CLIENT_MULTI_STATEMENTS.
+    void batch_statements(bool value) {
+      _batch_statements = value;
+    }
+    bool batch_statements() const {
+      return _batch_statements;
+    }
+
+  private:
+    bool _batch_statements;
+    size_t _max_batch_length;
+
+  public:
+    // The first sql_log_limit() statements run, all of them if the limit is 0.
     const std::list<std::string> &sql_log() const {
       return _sql_log;
     }
+    void sql_log_limit(size_t value) {
+      _sql_log_limit = value;
+    }
+    size_t sql_log_limit() const {
+      return _sql_log_limit;
+    }
 
   private:
     std::list<std::string> _sql_log;
+    size_t _sql_log_limit;
   };
 
 } // namespace sql
@@ -138,9 +138,46 @@ TEST_FUNCTION(3) {
     std::cout << i << " row(s)" << std::endl;
 }
 
+// Prepared statements are cached per connection handler and dropped when the connection changes.
+TEST_FUNCTION(4) {
+  db_mgmt_ConnectionRef connectionProperties(grt::Initialized);
+
+  setup_env(connectionProperties);
+
+  sql::DriverManager *dm = sql::DriverManager::getDriverManager();
+  sql::Dbc_connection_handler::Ref handler(new sql::Dbc_connection_handler());
+  handler->ref = dm->getConnection(connectionProperties);
+
+  std::string query = "SELECT SCHEMA_NAME FROM INFORMATION_SCHEMA.SCHEMATA WHERE SCHEMA_NAME = ?";
+  sql::PreparedStatement *statement = handler->prepared_statement(query);
+  statement->setString(1, "test");
+  std::auto_ptr<sql::ResultSet> rs(statement->executeQuery());
+  ensure("schema found", rs->next());
+  ensure_equals("schema name", std::string(rs->getString(1)), "test");
+  rs.reset();
+
+  ensure("statement reused", handler->prepared_statement(query) == statement);
+
+  handler->ref = dm->getConnection(connectionProperties);
+  statement = handler->prepared_statement(query);
+  statement->setString(1, "no_such_schema");
+  rs.reset(statement->executeQuery());
+  ensure("no schema found", !rs->next());
+  rs.reset();
+
+  handler->ref.reset();
+  bool failed = false;
+  try {
+    handler->prepared_statement(query);
+  } catch (sql::SQLException &) {
+    failed = true;
+  }
+  ensure("prepare without connection fails", failed);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
-TEST_FUNCTION(4) {
+TEST_FUNCTION(5) {
   db_mgmt_ConnectionRef connectionProperties(grt::Initialized);
 
   setup_env(connectionProperties);
@@ -644,6 +644,60 @@ TEST_FUNCTION(16) {
   }
 }
 
+// Statements sent as multi-statement packets, with the error of a statement in the middle of one.
+TEST_FUNCTION(17) {
+  db_mgmt_ConnectionRef connectionProperties(grt::Initialized);
+
+  setup_env(connectionProperties);
+
+  try {
+    sql::DriverManager *dm = sql::DriverManager::getDriverManager();
+    sql::ConnectionWrapper wrapper = dm->getConnection(connectionProperties);
+    ensure("conn is NULL", wrapper.get() != NULL);
+
+    std::auto_ptr<sql::Statement> stmt(wrapper->createStatement());
+
+    std::string sql_script =
+      "DROP DATABASE IF EXISTS dbc_statement_test_17;"
+      "CREATE DATABASE dbc_statement_test_17;"
+      "CREATE TABLE dbc_statement_test_17.t1 (id int primary key);"
+      "INSERT INTO dbc_statement_test_17.t1 VALUES (1);"
+      "INSERT INTO dbc_statement_test_17.t1 VALUES (1);"
+      "INSERT INTO dbc_statement_test_17.t1 VALUES (2); -- trailing comment\n"
+      "SELECT 1;"
+      "INSERT INTO dbc_statement_test_17.t1 VALUES (3);";
+    std::list<std::string> statements;
+    sql_splitter->splitSqlScript(sql_script, statements);
+
+    std::vector<std::string> failed;
+    long success_count = 0;
+    sql::SqlBatchExec batch_exec;
+    batch_exec.batch_statements(true);
+    batch_exec.stop_on_error(false);
+    batch_exec.error_cb([&](long long, const std::string &, const std::string &statement) {
+      failed.push_back(statement);
+      return 0;
+    });
+    batch_exec.batch_exec_stat_cb([&](long success, long) {
+      success_count = success;
+      return 0;
+    });
+    ensure_equals("error count", batch_exec(stmt.get(), statements), 1);
+    ensure_equals("success count", success_count, 7);
+    ensure_equals("failed statements", failed.size(), 1U);
+    ensure_equals("failed statement", failed[0], "INSERT INTO dbc_statement_test_17.t1 VALUES (1)");
+
+    std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT COUNT(*) FROM dbc_statement_test_17.t1"));
+    ensure("no result", rs->next());
+    ensure_equals("rows inserted", rs->getInt(1), 3);
+
+    stmt->execute("DROP DATABASE IF EXISTS dbc_statement_test_17");
+  } catch (sql::SQLException &) {
+    printf("ERR: Caught sql::SQLException\n");
+    throw;
+  }
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -399,6 +399,10 @@ void CodeEditor::setup() {
   _code_editor_impl->send_editor(this, SCI_SETSCROLLWIDTHTRACKING, 1, 0);
   _code_editor_impl->send_editor(this, SCI_SETEOLMODE, SC_EOL_LF, 0);
 
+  // - Large buffers. Scintilla styles only up to the end of the visible text. Keeping the layout of the visible
+  //   page avoids laying out its lines again for each key press (the default only keeps the caret line).
+  _code_editor_impl->send_editor(this, SCI_SETLAYOUTCACHE, SC_CACHE_PAGE, 0);
+
   // - Auto completion
   _code_editor_impl->send_editor(this, SCI_AUTOCSETSEPARATOR, AC_LIST_SEPARATOR, 0);
   _code_editor_impl->send_editor(this, SCI_AUTOCSETTYPESEPARATOR, AC_TYPE_SEPARATOR, 0);
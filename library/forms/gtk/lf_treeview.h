@@ -74,6 +74,51 @@ namespace mforms {
       void copy_iter(Gtk::TreeModel::iterator &from, Gtk::TreeModel::iterator &to);
     };
 
+    /**
+     * Flat list model of a tree in virtual mode. It holds no rows, values are asked from the mforms TreeView when
+     * the view draws them. The columns are the same as those of the tree store, the index of a row is kept in the
+     * iterator.
+     */
+    class VirtualListModel : public Glib::Object, public Gtk::TreeModel {
+    public:
+      static Glib::RefPtr<VirtualListModel> create(mforms::TreeView *owner, const Gtk::TreeModelColumnRecord &columns,
+                                                   const std::vector<int> &column_value_index);
+
+      int row_count() const {
+        return _row_count;
+      }
+      void set_row_count(int count, bool notify);
+
+    protected:
+      VirtualListModel(mforms::TreeView *owner, const Gtk::TreeModelColumnRecord &columns,
+                       const std::vector<int> &column_value_index);
+
+      virtual Gtk::TreeModelFlags get_flags_vfunc() const;
+      virtual int get_n_columns_vfunc() const;
+      virtual GType get_column_type_vfunc(int index) const;
+      virtual void get_value_vfunc(const iterator &iter, int column, Glib::ValueBase &value) const;
+      virtual bool iter_next_vfunc(const iterator &iter, iterator &iter_next) const;
+      virtual bool iter_children_vfunc(const iterator &parent, iterator &iter) const;
+      virtual bool iter_has_child_vfunc(const iterator &iter) const;
+      virtual int iter_n_children_vfunc(const iterator &iter) const;
+      virtual int iter_n_root_children_vfunc() const;
+      virtual bool iter_nth_child_vfunc(const iterator &parent, int n, iterator &iter) const;
+      virtual bool iter_nth_root_child_vfunc(int n, iterator &iter) const;
+      virtual bool iter_parent_vfunc(const iterator &child, iterator &iter) const;
+      virtual Path get_path_vfunc(const iterator &iter) const;
+      virtual bool get_iter_vfunc(const Path &path, iterator &iter) const;
+
+    private:
+      mforms::TreeView *_owner;
+      std::vector<GType> _column_types;
+      std::vector<int> _value_column; // mforms column shown in each model column, -1 for icons, attributes etc.
+      int _row_count;
+      int _stamp;
+
+      bool set_iter(iterator &iter, int row) const;
+      int row_of(const iterator &iter) const;
+    };
+
     class TreeViewImpl; // rename
 
     class RootTreeNodeImpl : public ::mforms::TreeNode {
@@ -336,6 +381,10 @@ namespace mforms {
 
       Glib::RefPtr<Gtk::TreeStore> _tree_store;
       Glib::RefPtr<Gtk::TreeModelSort> _sort_model;
+      Glib::RefPtr<VirtualListModel> _virtual_model;
+      bool _update_sorted; // Sort order that EndUpdate() restores.
+      int _update_sort_column;
+      Gtk::SortType _update_sort_order;
       std::map<std::string, Glib::RefPtr<Gdk::Pixbuf> > _pixbufs;
 
       std::map<std::string, Gtk::TreeRowReference> _tagmap;
@@ -407,6 +456,10 @@ namespace mforms {
       static void set_column_width(TreeView *self, int column, int width);
       static int get_column_width(TreeView *self, int column);
       static TreeNodeRef node_at_position(TreeView *self, base::Point position);
+      static void set_virtual_row_count(TreeView *self, int count);
+      static std::vector<int> get_selected_rows(TreeView *self);
+      static void BeginUpdate(TreeView *self);
+      static void EndUpdate(TreeView *self);
 
       Gtk::TreeModel::iterator to_list_iter(const Gtk::TreeModel::iterator &it);
       Gtk::TreeModel::Path to_list_path(const Gtk::TreeModel::Path &path);
@@ -77,6 +77,7 @@ namespace mforms {
       static void init();
 
       static Glib::RefPtr<Gdk::Pixbuf> get_cached_icon(const std::string &icon);
+      static void preload_icons(const std::vector<std::string> &paths);
     };
 
     class MainThreadRequestQueue {
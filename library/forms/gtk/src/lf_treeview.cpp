@@ -21,6 +21,7 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include <cstdlib>
 #include <inttypes.h>
 
 #include "../lf_mforms.h"
@@ -82,6 +83,159 @@ namespace mforms {
       }
     }
 
+    //------------------------------------------------------------------------------------------------
+
+    VirtualListModel::VirtualListModel(mforms::TreeView *owner, const Gtk::TreeModelColumnRecord &columns,
+                                       const std::vector<int> &column_value_index)
+      : Glib::ObjectBase(typeid(VirtualListModel)), Glib::Object(), _owner(owner), _row_count(0), _stamp(1) {
+      _column_types.assign(columns.types(), columns.types() + columns.size());
+      _value_column.resize(_column_types.size(), -1);
+      for (std::size_t i = 0; i < column_value_index.size(); ++i)
+        if (column_value_index[i] >= 0 && column_value_index[i] < (int)_value_column.size())
+          _value_column[column_value_index[i]] = (int)i;
+    }
+
+    Glib::RefPtr<VirtualListModel> VirtualListModel::create(mforms::TreeView *owner,
+                                                            const Gtk::TreeModelColumnRecord &columns,
+                                                            const std::vector<int> &column_value_index) {
+      return Glib::RefPtr<VirtualListModel>(new VirtualListModel(owner, columns, column_value_index));
+    }
+
+    /**
+     * With notify set the view is told about each added or removed row, which keeps its scroll position and
+     * selection. Otherwise the model must be set on the view again.
+     */
+    void VirtualListModel::set_row_count(int count, bool notify) {
+      if (!notify) {
+        _row_count = count;
+        ++_stamp; // Iterators from before are no longer valid.
+        return;
+      }
+
+      while (_row_count < count) {
+        iterator iter;
+        Path path;
+        path.push_back(_row_count++);
+        set_iter(iter, path[0]);
+        row_inserted(path, iter);
+      }
+      while (_row_count > count) {
+        Path path;
+        path.push_back(--_row_count);
+        row_deleted(path);
+      }
+    }
+
+    bool VirtualListModel::set_iter(iterator &iter, int row) const {
+      if (row < 0 || row >= _row_count) {
+        iter = iterator();
+        return false;
+      }
+      iter.set_stamp(_stamp);
+      iter.gobj()->user_data = GINT_TO_POINTER(row);
+      return true;
+    }
+
+    int VirtualListModel::row_of(const iterator &iter) const {
+      if (iter.get_stamp() != _stamp)
+        return -1;
+      int row = GPOINTER_TO_INT(iter.gobj()->user_data);
+      return row < _row_count ? row : -1;
+    }
+
+    Gtk::TreeModelFlags VirtualListModel::get_flags_vfunc() const {
+      return Gtk::TREE_MODEL_LIST_ONLY;
+    }
+
+    int VirtualListModel::get_n_columns_vfunc() const {
+      return (int)_column_types.size();
+    }
+
+    GType VirtualListModel::get_column_type_vfunc(int index) const {
+      return index >= 0 && index < (int)_column_types.size() ? _column_types[index] : G_TYPE_INVALID;
+    }
+
+    void VirtualListModel::get_value_vfunc(const iterator &iter, int column, Glib::ValueBase &value) const {
+      if (column < 0 || column >= (int)_column_types.size())
+        return;
+
+      GType type = _column_types[column];
+      value.init(type);
+
+      // Icons, text attributes, tags and node data stay empty.
+      int row = row_of(iter);
+      if (row < 0 || _value_column[column] < 0)
+        return;
+
+      std::string text = _owner->get_virtual_value(row, _value_column[column]);
+      if (type == G_TYPE_STRING)
+        g_value_set_string(value.gobj(), text.c_str());
+      else if (type == G_TYPE_INT)
+        g_value_set_int(value.gobj(), base::atoi<int>(text, 0));
+      else if (type == G_TYPE_INT64)
+        g_value_set_int64(value.gobj(), base::atoi<std::int64_t>(text, 0));
+      else if (type == G_TYPE_DOUBLE)
+        g_value_set_double(value.gobj(), base::atof<double>(text, 0.0));
+      else if (type == G_TYPE_BOOLEAN)
+        g_value_set_boolean(value.gobj(), base::atoi<int>(text, 0) != 0);
+    }
+
+    bool VirtualListModel::iter_next_vfunc(const iterator &iter, iterator &iter_next) const {
+      int row = row_of(iter);
+      if (row < 0) {
+        iter_next = iterator();
+        return false;
+      }
+      return set_iter(iter_next, row + 1);
+    }
+
+    bool VirtualListModel::iter_children_vfunc(const iterator &parent, iterator &iter) const {
+      iter = iterator();
+      return false;
+    }
+
+    bool VirtualListModel::iter_has_child_vfunc(const iterator &iter) const {
+      return false;
+    }
+
+    int VirtualListModel::iter_n_children_vfunc(const iterator &iter) const {
+      return 0;
+    }
+
+    int VirtualListModel::iter_n_root_children_vfunc() const {
+      return _row_count;
+    }
+
+    bool VirtualListModel::iter_nth_child_vfunc(const iterator &parent, int n, iterator &iter) const {
+      iter = iterator();
+      return false;
+    }
+
+    bool VirtualListModel::iter_nth_root_child_vfunc(int n, iterator &iter) const {
+      return set_iter(iter, n);
+    }
+
+    bool VirtualListModel::iter_parent_vfunc(const iterator &child, iterator &iter) const {
+      iter = iterator();
+      return false;
+    }
+
+    Gtk::TreeModel::Path VirtualListModel::get_path_vfunc(const iterator &iter) const {
+      Path path;
+      int row = row_of(iter);
+      if (row >= 0)
+        path.push_back(row);
+      return path;
+    }
+
+    bool VirtualListModel::get_iter_vfunc(const Path &path, iterator &iter) const {
+      if (path.size() != 1) {
+        iter = iterator();
+        return false;
+      }
+      return set_iter(iter, path[0]);
+    }
+
     bool RootTreeNodeImpl::is_root() const {
       return true;
     }
@@ -223,8 +377,9 @@ namespace mforms {
 
         row.set_value(index_for_string, nvalue);
 
-        // Sets the icon...
-        row.set_value(index_for_icon, pixbuf);
+        // Sets the icon, if there is one (the column has no icon cell otherwise)...
+        if (pixbuf)
+          row.set_value(index_for_icon, pixbuf);
 
         added_nodes.push_back(ref_from_iter(new_iter));
 
@@ -1064,6 +1219,9 @@ namespace mforms {
     //---------------------------------------------------------------------------------------
 
     TreeViewImpl::TreeViewImpl(TreeView *self, mforms::TreeOptions opts) : ViewImpl(self), _row_height(-1) {
+      _update_sorted = false;
+      _update_sort_column = 0;
+      _update_sort_order = Gtk::SORT_ASCENDING;
       _mouse_inside = false;
       _hovering_overlay = -1;
       _clicking_overlay = -1;
@@ -1370,6 +1528,11 @@ namespace mforms {
       mforms::TreeView *tv = dynamic_cast<mforms::TreeView *>(
         owner); // owner is from deeply hidden class TreeViewImpl->ViewImpl->ObjectImpl.owner
       if (tv) {
+        if (_virtual_model) {
+          // There are no nodes in virtual mode, the activated row is the selected one.
+          tv->node_activated(mforms::TreeNodeRef(), (intptr_t)column->get_data("index"));
+          return;
+        }
         Gtk::TreePath tree_path = to_list_path(path);
         tv->node_activated(mforms::TreeNodeRef(new TreeNodeImpl(this, _tree_store, tree_path)),
                            (intptr_t)column->get_data("index"));
@@ -1719,6 +1882,9 @@ namespace mforms {
     }
 
     void TreeViewImpl::set_allow_sorting(bool flag) {
+      if (_virtual_model)
+        return; // Virtual lists are sorted by their data source.
+
       if (_tree.get_headers_visible())
         _tree.set_headers_clickable(flag);
 
@@ -2046,6 +2212,74 @@ namespace mforms {
       return TreeNodeRef(new TreeNodeImpl(impl, impl->tree_store(), path));
     }
 
+    /**
+     * A sorted tree is unsorted while updating, so inserted rows are not sorted in one by one, and sorted again once
+     * at the end.
+     */
+    void TreeViewImpl::BeginUpdate(TreeView *self) {
+      TreeViewImpl *impl = self->get_data<TreeViewImpl>();
+
+      impl->_tree.freeze_child_notify();
+      impl->_update_sorted = false;
+      if (impl->_sort_model && impl->_tree.get_headers_clickable()) {
+        impl->_update_sorted =
+          impl->_sort_model->get_sort_column_id(impl->_update_sort_column, impl->_update_sort_order);
+        if (impl->_update_sorted)
+          impl->_sort_model->set_sort_column(GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, impl->_update_sort_order);
+      }
+    }
+
+    void TreeViewImpl::EndUpdate(TreeView *self) {
+      TreeViewImpl *impl = self->get_data<TreeViewImpl>();
+
+      if (impl->_update_sorted && impl->_sort_model)
+        impl->_sort_model->set_sort_column(impl->_update_sort_column, impl->_update_sort_order);
+      impl->_update_sorted = false;
+      impl->_tree.thaw_child_notify();
+    }
+
+    // Rows added or removed at once beyond which the model is set on the view again instead of notifying each row.
+    static const int MAX_VIRTUAL_ROW_NOTIFICATIONS = 1000;
+
+    void TreeViewImpl::set_virtual_row_count(TreeView *self, int count) {
+      TreeViewImpl *impl = self->get_data<TreeViewImpl>();
+
+      bool reset = false;
+      if (!impl->_virtual_model) {
+        impl->_virtual_model = VirtualListModel::create(self, impl->_columns, impl->_columns.column_value_index);
+        impl->_sort_model.reset();
+        impl->_tree.set_headers_clickable(false);
+
+        // Rows are not measured one by one, which would read every value of the data source.
+        for (std::size_t i = 0; i < impl->_tree.get_columns().size(); ++i)
+          impl->_tree.get_column(i)->set_sizing(Gtk::TREE_VIEW_COLUMN_FIXED);
+        impl->_tree.set_fixed_height_mode(true);
+        reset = true;
+      } else if (std::abs(count - impl->_virtual_model->row_count()) > MAX_VIRTUAL_ROW_NOTIFICATIONS)
+        reset = true;
+
+      if (reset) {
+        impl->_tree.unset_model();
+        impl->_virtual_model->set_row_count(count, false);
+        impl->_tree.set_model(impl->_virtual_model);
+      } else
+        impl->_virtual_model->set_row_count(count, true);
+
+      // Values of the rows already shown may have changed too.
+      impl->_tree.queue_draw();
+    }
+
+    std::vector<int> TreeViewImpl::get_selected_rows(TreeView *self) {
+      TreeViewImpl *impl = self->get_data<TreeViewImpl>();
+      std::vector<int> rows;
+
+      std::vector<Gtk::TreePath> paths = impl->_tree.get_selection()->get_selected_rows();
+      for (std::vector<Gtk::TreePath>::const_iterator path = paths.begin(); path != paths.end(); ++path)
+        if (!path->empty())
+          rows.push_back((*path)[0]);
+      return rows;
+    }
+
     void TreeViewImpl::init() {
       ::mforms::ControlFactory *f = ::mforms::ControlFactory::get_instance();
 
@@ -2072,6 +2306,10 @@ namespace mforms {
       f->_treeview_impl.set_column_width = &TreeViewImpl::set_column_width;
       f->_treeview_impl.get_column_width = &TreeViewImpl::get_column_width;
       f->_treeview_impl.node_at_position = &TreeViewImpl::node_at_position;
+      f->_treeview_impl.set_virtual_row_count = &TreeViewImpl::set_virtual_row_count;
+      f->_treeview_impl.get_selected_rows = &TreeViewImpl::get_selected_rows;
+      f->_treeview_impl.BeginUpdate = &TreeViewImpl::BeginUpdate;
+      f->_treeview_impl.EndUpdate = &TreeViewImpl::EndUpdate;
     }
   }
 }
@@ -899,6 +899,29 @@ namespace mforms {
       return Glib::RefPtr<Gdk::Pixbuf>();
     }
 
+    /**
+     * The icons are decoded on the calling thread. Only the main thread uses the icon cache, so they are added to it
+     * from there, without replacing icons loaded in the meantime.
+     */
+    void UtilitiesImpl::preload_icons(const std::vector<std::string> &paths) {
+      std::shared_ptr<std::map<std::string, Glib::RefPtr<Gdk::Pixbuf> > > icons(
+        new std::map<std::string, Glib::RefPtr<Gdk::Pixbuf> >());
+      for (std::vector<std::string>::const_iterator path = paths.begin(); path != paths.end(); ++path) {
+        try {
+          (*icons)[*path] = Gdk::Pixbuf::create_from_file(*path);
+        } catch (Glib::Error &) {
+          g_warning("Can't load icon %s", path->c_str());
+        }
+      }
+
+      mforms::Utilities::perform_from_main_thread(
+        [icons]() -> void * {
+          icon_cache.insert(icons->begin(), icons->end());
+          return nullptr;
+        },
+        false);
+    }
+
 //------------------------------------------------------------------------------
 #include <pango/pangoft2.h>
 
@@ -998,6 +1021,7 @@ namespace mforms {
       f->_utilities_impl.beep = &UtilitiesImpl::beep;
 
       f->_utilities_impl.get_text_width = &UtilitiesImpl::get_text_width;
+      f->_utilities_impl.preload_icons = &UtilitiesImpl::preload_icons;
       MainThreadRequestQueue::get(); // init from main thread
     }
 
@@ -23,6 +23,7 @@
 
 #include "mforms/home_screen_connections.h"
 
+#include "mforms/app.h"
 #include "mforms/menu.h"
 #include "mforms/popup.h"
 #include "mforms/imagebox.h"
@@ -487,9 +488,16 @@ protected:
   std::string search_description;
   std::string search_user;
   std::string search_schema;
+  std::string search_key; // The search strings in lower case, one per line, which is what filtering looks at.
 
   base::Rect bounds;
 
+  // The tile as last drawn, which only changes with the hot state until invalidate_tile() is called.
+  cairo_surface_t *tile_surface;
+  bool tile_surface_hot;
+  bool tile_surface_details;
+  float tile_surface_scale;
+
   //------ Accesibility Methods -----
 
   virtual std::string getAccessibilityName() override {
@@ -561,10 +569,71 @@ protected:
 public:
   enum ItemPosition { First, Last, Other };
 
-  ConnectionEntry(ConnectionsSection *aowner) : owner(aowner), compute_strings(false) {
+  ConnectionEntry(ConnectionsSection *aowner)
+    : owner(aowner), compute_strings(false), tile_surface(nullptr), tile_surface_hot(false),
+      tile_surface_details(false), tile_surface_scale(0) {
     draw_info_tab = true;
   }
 
+  virtual ~ConnectionEntry() {
+    invalidate_tile();
+  }
+
+  void update_search_key() {
+    search_key = base::tolower(search_title + "\n" + search_description + "\n" + search_user + "\n" + search_schema);
+  }
+
+  void invalidate_tile() {
+    if (tile_surface != nullptr) {
+      cairo_surface_destroy(tile_surface);
+      tile_surface = nullptr;
+    }
+  }
+
+  base::Rect info_button_bounds() const {
+    return base::Rect(bounds.right() - 15, bounds.bottom() - 10, 10, 10);
+  }
+
+  /**
+   * Draws the tile at its bounds. The tile is rendered once into a surface, with its text measured and shortened,
+   * and later paints only copy that surface.
+   */
+  void paint_tile(cairo_t *cr, bool hot) {
+    bool details = hot && owner->_show_details && draw_info_tab;
+    float scale = mforms::App::get()->backing_scale_factor();
+    if (scale < 1)
+      scale = 1;
+
+    if (tile_surface == nullptr || tile_surface_hot != hot || tile_surface_details != details ||
+        tile_surface_scale != scale) {
+      invalidate_tile();
+      tile_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)ceil(bounds.width() * scale),
+                                                (int)ceil(bounds.height() * scale));
+      cairo_t *tile_cr = cairo_create(tile_surface);
+      cairo_scale(tile_cr, scale, scale);
+      cairo_translate(tile_cr, -bounds.left(), -bounds.top());
+      draw_tile(tile_cr, hot, 1.0, false);
+      cairo_destroy(tile_cr);
+
+      tile_surface_hot = hot;
+      tile_surface_details = details;
+      tile_surface_scale = scale;
+    }
+
+#ifdef __APPLE__
+    // Set when drawing the tile, but the cached tile may have moved since then.
+    if (details)
+      owner->_info_button_rect = info_button_bounds();
+#endif
+
+    cairo_save(cr);
+    cairo_translate(cr, bounds.left(), bounds.top());
+    cairo_scale(cr, 1 / scale, 1 / scale);
+    cairo_set_source_surface(cr, tile_surface, 0, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+  }
+
   virtual std::string section_name() {
     return "";
   }
@@ -633,7 +702,7 @@ public:
                              CAIRO_FONT_WEIGHT_BOLD);
       cairo_set_font_size(cr, mforms::HomeScreenSettings::HOME_TILES_TITLE_FONT_SIZE);
 
-      owner->_info_button_rect = base::Rect(bounds.right() - 15, bounds.bottom() - 10, 10, 10);
+      owner->_info_button_rect = info_button_bounds();
       cairo_move_to(cr, owner->_info_button_rect.left(), owner->_info_button_rect.top());
       cairo_show_text(cr, "i");
       cairo_stroke(cr);
@@ -710,6 +779,11 @@ public:
     owner->_owner->trigger_callback(HomeScreenAction::ActionOpenConnectionFromList, connectionId);
   }
 
+  // The mouse entered the tile, a click may follow soon.
+  virtual void hovered() {
+    owner->_owner->trigger_callback(HomeScreenAction::ActionHoverConnection, connectionId);
+  }
+
   virtual mforms::Menu *context_menu() {
     return owner->_connection_context_menu;
   }
@@ -801,6 +875,9 @@ public:
     owner->change_to_folder(shared_from_this());
   }
 
+  virtual void hovered() override {
+  }
+
   virtual base::Color getTitleColor() override {
     return owner->_folderTitleColor;
   }
@@ -876,6 +953,9 @@ public:
   virtual void activate() override {
     owner->change_to_folder(std::shared_ptr<FolderEntry>());
   }
+
+  virtual void hovered() override {
+  }
 };
 
 //----------------- ConnectionsWelcomeScreen ---------------------------------------------------------------------------
@@ -1216,6 +1296,14 @@ void ConnectionsSection::update_colors() {
 #endif
   _search_text.set_placeholder_color("#303030");
   _search_text.set_back_color("#ffffff");
+
+  for (auto &entry : _connections) {
+    entry->invalidate_tile();
+    if (FolderEntry *folder = dynamic_cast<FolderEntry *>(entry.get())) {
+      for (auto &child : folder->children)
+        child->invalidate_tile();
+    }
+  }
 }
 
 //------------------------------------------------------------------------------------------------
@@ -1237,23 +1325,28 @@ void ConnectionsSection::showWelcomeHeading(bool state) {
 //------------------------------------------------------------------------------------------------
 
 void ConnectionsSection::on_search_text_changed() {
-  std::string filter = _search_text.get_string_value();
+  std::string filter = base::tolower(_search_text.get_string_value());
+
+  // Typing on narrows the filter, so only the entries matching the previous text need to be looked at.
+  bool narrowing = _filtered && !_last_filter.empty() && filter.find(_last_filter) != std::string::npos;
+  ConnectionVector current_connections;
+  if (narrowing)
+    current_connections.swap(_filtered_connections);
+  else
+    current_connections = !_active_folder ? _connections : _active_folder->children;
   _filtered_connections.clear();
 
   _filtered = !filter.empty();
   if (_filtered) {
-    ConnectionVector current_connections = !_active_folder ? _connections : _active_folder->children;
     for (ConnectionIterator iterator = current_connections.begin(); iterator != current_connections.end(); ++iterator) {
       // Always keep the first entry if we are in a folder. It's not filtered.
       if (_active_folder && (iterator == current_connections.begin()))
         _filtered_connections.push_back(*iterator);
-      else if (base::contains_string((*iterator)->search_title, filter, false) ||
-               base::contains_string((*iterator)->search_description, filter, false) ||
-               base::contains_string((*iterator)->search_user, filter, false) ||
-               base::contains_string((*iterator)->search_schema, filter, false))
+      else if ((*iterator)->search_key.find(filter) != std::string::npos)
         _filtered_connections.push_back(*iterator);
     }
   }
+  _last_filter = filter;
 
   set_layout_dirty(true);
 }
@@ -1536,8 +1629,13 @@ void ConnectionsSection::repaint(cairo_t *cr, int areax, int areay, int areaw, i
       // Updates the bounds on the tile
       connections[index]->bounds = bounds;
 
-      bool draw_hot = connections[index] == _hot_entry;
-      connections[index]->draw_tile(cr, draw_hot, 1.0, false);
+      // Only tiles in the exposed area are drawn. Those far outside of it (more than its height away) also give
+      // up their cached surfaces, so memory use doesn't grow with the number of connections scrolled through.
+      if (bounds.bottom() >= areay && bounds.top() <= areay + areah) {
+        bool draw_hot = connections[index] == _hot_entry;
+        connections[index]->paint_tile(cr, draw_hot);
+      } else if (bounds.bottom() < areay - areah || bounds.top() > areay + 2 * areah)
+        connections[index]->invalidate_tile();
 
       // Draw drop indicator.
 
@@ -1691,6 +1789,7 @@ void ConnectionsSection::addConnection(const std::string &connectionId, const st
   entry->search_description = description;
   entry->search_user = user;
   entry->search_schema = schema;
+  entry->update_search_key();
 
   std::string::size_type slash_position = title.find("/");
   if (slash_position != std::string::npos) {
@@ -1698,12 +1797,14 @@ void ConnectionsSection::addConnection(const std::string &connectionId, const st
     std::string parent_name = title.substr(0, slash_position);
     entry->title = title.substr(slash_position + 1);
     entry->search_title = entry->title;
+    entry->update_search_key();
     bool found_parent = false;
     for (ConnectionIterator iterator = _connections.begin(); iterator != _connections.end(); iterator++) {
       if ((*iterator)->title == parent_name) {
         if (FolderEntry *folder = dynamic_cast<FolderEntry *>(iterator->get())) {
           found_parent = true;
           folder->children.push_back(entry);
+          folder->invalidate_tile(); // For the connection count.
           break;
         }
       }
@@ -1716,6 +1817,7 @@ void ConnectionsSection::addConnection(const std::string &connectionId, const st
       folder->title = parent_name;
       folder->compute_strings = true;
       folder->search_title = parent_name;
+      folder->update_search_key();
 
       folder->children.push_back(std::shared_ptr<ConnectionEntry>(new FolderBackEntry(this)));
       folder->children.push_back(entry);
@@ -1744,6 +1846,7 @@ void ConnectionsSection::clear_connections(bool clear_state) {
     if (_active_folder)
       _active_folder_title_before_refresh_start = _active_folder->title;
   }
+  _last_filter.clear();
   _entry_for_menu.reset();
   _active_folder.reset();
   _connections.clear();
@@ -1899,6 +2002,8 @@ bool ConnectionsSection::mouse_move(mforms::MouseButton button, int x, int y) {
     // (or hover effects in general).
     if (button == mforms::MouseButtonNone) {
       if (entry != _hot_entry || _show_details != in_details_area) {
+        if (entry && entry != _hot_entry)
+          entry->hovered();
         _hot_entry = entry;
 #ifndef __APPLE__
         if (_hot_entry)
@@ -25,6 +25,8 @@
 #include <sstream>
 #include <cctype>
 #include <future>
+#include <algorithm>
+#include <iterator>
 
 #include <boost/date_time.hpp>
 
@@ -48,6 +50,8 @@ using namespace JsonParser;
 namespace ph = std::placeholders;
 namespace bt = boost::posix_time;
 
+#define JSON_TREE_PAGE_SIZE 1000 // Arrays with more elements are shown in ranges of this size.
+
 // JSON Data structures implementation
 
 //--------------------------------------------------------------------------------------------------
@@ -77,6 +81,89 @@ static void findNode(TreeNodeRef parent, const std::string &text, JsonTreeBaseVi
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * @brief Get the member or element of a JSON value at the given position.
+ *
+ * @returns Child value or nullptr if there is none.
+ */
+static JsonValue *childValue(JsonValue &value, size_t index) {
+  switch (value.getType()) {
+    case VObject: {
+      auto &object = (JsonObject &)value;
+      if (index >= object.size())
+        return nullptr;
+      auto it = object.begin();
+      std::advance(it, index);
+      return &it->second;
+    }
+    case VArray: {
+      auto &array = (JsonArray &)value;
+      return index < array.size() ? &array[index] : nullptr;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Find values in a JSON document recursively.
+ *
+ * Only scalars are matched, against the text the tree view shows for them in the value column.
+ * The paths are added in the order the values appear in the tree.
+ */
+static void findValues(JsonValue &value, const std::string &text, std::vector<size_t> &path,
+                       std::vector<std::vector<size_t> > &found) {
+  std::string valueText;
+  switch (value.getType()) {
+    case VObject: {
+      auto &object = (JsonObject &)value;
+      size_t index = 0;
+      for (auto it = object.begin(); it != object.end(); ++it, ++index) {
+        if (it->second.isDeleted())
+          continue;
+        path.push_back(index);
+        findValues(it->second, text, path, found);
+        path.pop_back();
+      }
+      return;
+    }
+    case VArray: {
+      auto &array = (JsonArray &)value;
+      for (size_t index = 0; index < array.size(); ++index) {
+        if (array[index].isDeleted())
+          continue;
+        path.push_back(index);
+        findValues(array[index], text, path, found);
+        path.pop_back();
+      }
+      return;
+    }
+    case VString:
+      valueText = (std::string)value;
+      break;
+    case VDouble:
+      valueText = std::to_string((double)value);
+      break;
+    case VInt64:
+      valueText = std::to_string((int64_t)value);
+      break;
+    case VUint64:
+      valueText = std::to_string((uint64_t)value);
+      break;
+    case VBoolean:
+      valueText = (bool)value ? "true" : "false";
+      break;
+    default:
+      return;
+  }
+  if (base::contains_string(valueText, text, false))
+    found.push_back(path);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 JsonInputDlg::JsonInputDlg(mforms::Form *owner, bool showTextEntry)
   : mforms::Form(owner, mforms::FormResizable),
     _textEditor(manage(new CodeEditor())),
@@ -407,6 +494,7 @@ void JsonTreeBaseView::handleMenuCommand(const std::string &command) {
 void JsonTreeBaseView::openInputJsonWindow(TreeNodeRef node, bool updateMode /*= false*/) {
   auto data = dynamic_cast<JsonValueNodeData *>(node->get_data());
   if (data != nullptr) {
+    populateNode(node);
     auto &jv = data->getData();
     bool isObject = jv.getType() == VObject;
     JsonInputDlg dlg(_treeView->get_parent_form(), isObject);
@@ -433,6 +521,8 @@ void JsonTreeBaseView::openInputJsonWindow(TreeNodeRef node, bool updateMode /*=
             obj.insert(objectName, value);
           auto newNode = (updateMode) ? node : node->add_child();
           generateTree(objectName.empty() ? jv : obj[objectName], 0, newNode);
+          populateNode(newNode);
+          newNode->expand();
           newNode->set_string(0, objectName + "{" + std::to_string(obj.size()) + "}");
           newNode->set_tag(objectName);
           _dataChanged(false);
@@ -452,6 +542,8 @@ void JsonTreeBaseView::openInputJsonWindow(TreeNodeRef node, bool updateMode /*=
           size_t size = array.size();
           auto newNode = (updateMode) ? node : node->add_child();
           generateTree((updateMode) ? jv : array[size - 1], 0, newNode);
+          populateNode(newNode);
+          newNode->expand();
           newNode->set_string(0, objectName + "[" + std::to_string(array.size()) + "]");
           _dataChanged(false);
           break;
@@ -470,6 +562,16 @@ JsonTreeBaseView::~JsonTreeBaseView() {
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * @brief Create the children of a node which were left out until now.
+ *
+ * Views which build the whole tree at once have nothing to do here.
+ */
+void JsonTreeBaseView::populateNode(TreeNodeRef /*node*/) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
 /**
  * @brief Insert string value to the tree.
  *
@@ -872,7 +974,7 @@ void JsonTextView::findAndHighlightText(const std::string &text, bool backward /
 
 //--------------------------------------------------------------------------------------------------
 
-JsonTreeView::JsonTreeView() {
+JsonTreeView::JsonTreeView() : _rootValue(nullptr), _matchIndex(0) {
   _treeView = manage(new mforms::TreeView(mforms::TreeAltRowColors | mforms::TreeShowRowLines |
                                           mforms::TreeShowColumnLines | mforms::TreeNoBorder));
   _treeView->add_column(IconStringColumnType, "Key", 150, false, true);
@@ -882,6 +984,10 @@ JsonTreeView::JsonTreeView() {
   _treeView->set_cell_edit_handler(std::bind(&JsonTreeBaseView::setCellValue, this, ph::_1, ph::_2, ph::_3));
   _treeView->set_selection_mode(TreeSelectSingle);
   _treeView->set_context_menu(_contextMenu);
+  scoped_connect(_treeView->signal_expand_toggle(), std::bind(&JsonTreeView::expandToggled, this, ph::_1, ph::_2));
+
+  // Any change to the data can move or drop search results.
+  scoped_connect(&_dataChanged, [this](bool) { _textToFind.clear(); });
   init();
 }
 
@@ -915,6 +1021,8 @@ void JsonTreeView::clear() {
   _textToFind = "";
   _searchIdx = 0;
   _useFilter = false;
+  _rootValue = nullptr;
+  _matches.clear();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -922,12 +1030,30 @@ void JsonTreeView::clear() {
 /**
  * @brief Add the JSON data to the control.
  *
+ * Only the top level value gets its children created, everything below is populated when expanded.
+ *
  * @param value A JsonValue object to show in control.
  */
 void JsonTreeView::setJson(JsonParser::JsonValue &value) {
   clear();
+  _rootValue = &value;
   auto node = _treeView->root_node()->add_child();
+  _treeView->BeginUpdate();
   generateTree(value, 0, node);
+  populateNode(node);
+  _treeView->EndUpdate();
+  node->expand();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Re-create tree.
+ *
+ * @param value JSON value reference.
+ */
+void JsonTreeView::reCreateTree(JsonParser::JsonValue &value) {
+  setJson(value);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -942,7 +1068,9 @@ void JsonTreeView::appendJson(JsonParser::JsonValue &value) {
   _viewFindResult.clear();
   _textToFind = "";
   _searchIdx = 0;
+  _rootValue = nullptr; // Search goes over the tree nodes now, there is more than one document.
   generateTree(value, 0, node);
+  populateNode(node);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -952,55 +1080,20 @@ void JsonTreeView::appendJson(JsonParser::JsonValue &value) {
  *
  * @param value JsonValue to put in tree
  * @param node Tree node reference
- * @param addNew If true add as child node
  */
-void JsonTreeView::generateObjectInTree(JsonParser::JsonValue &value, int /*columnId*/, TreeNodeRef node, bool addNew) {
+void JsonTreeView::generateObjectInTree(JsonParser::JsonValue &value, int /*columnId*/, TreeNodeRef node,
+                                        bool /*addNew*/) {
   if (_useFilter && _filterGuard.count(&value) == 0)
     return;
   auto &object = (JsonObject &)value;
-  size_t size = 0;
-  auto end = object.end();
   node->set_data(new JsonTreeBaseView::JsonValueNodeData(value));
-  for (JsonObject::Iterator it = object.begin(); it != end; ++it) {
-    auto text = it->first;
-    std::stringstream textSize;
-    switch (it->second.getType()) {
-      case VArray: {
-        auto &arrayVal = (JsonArray &)it->second;
-        size = arrayVal.size();
-        node->set_tag(it->first);
-        textSize << size;
-        text += "[";
-        text += textSize.str();
-        text += "]";
-        break;
-      }
-      case VObject: {
-        auto &objectVal = (JsonObject &)it->second;
-        size = objectVal.size();
-        textSize << size;
-        text += "{";
-        text += textSize.str();
-        text += "}";
-        break;
-      }
-      default:
-        break;
-    }
-    auto node2 = (addNew) ? node->add_child() : node;
-    if (addNew) {
-      node->set_icon_path(0, "JS_Datatype_Object.png");
-      std::string name = node->get_string(0);
-      if (name.empty())
-        node->set_string(0, "<unnamed>");
-      node->set_string(1, "");
-      node->set_string(2, "Object");
-    }
-    node2->set_string(0, text);
-    node2->set_tag(it->first);
-    generateTree(it->second, 1, node2);
-    node2->expand();
-  }
+  node->set_icon_path(0, "JS_Datatype_Object.png");
+  std::string name = node->get_string(0);
+  if (name.empty())
+    node->set_string(0, "<unnamed>");
+  node->set_string(1, "");
+  node->set_string(2, "Object");
+  addChildren(value, node, 0, object.size());
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1010,7 +1103,6 @@ void JsonTreeView::generateObjectInTree(JsonParser::JsonValue &value, int /*colu
  *
  * @param value JsonValue to put in tree
  * @param node Tree node reference
- * @param addNew If true add as child node
  */
 void JsonTreeView::generateArrayInTree(JsonParser::JsonValue &value, int /*columnId*/, TreeNodeRef node) {
   if (_useFilter && _filterGuard.count(&value) == 0)
@@ -1024,24 +1116,241 @@ void JsonTreeView::generateArrayInTree(JsonParser::JsonValue &value, int /*colum
     node->set_string(0, "<unnamed>");
   node->set_string(1, "");
   node->set_string(2, "Array");
-  std::string tagName = node->get_tag();
   node->set_data(new JsonTreeBaseView::JsonValueNodeData(value));
+  addChildren(value, node, 0, arrayType.size());
+}
 
-  auto end = arrayType.end();
-  int index = 0;
-  for (auto it = arrayType.begin(); it != end; ++it, ++index) {
-    if (_useFilter && _filterGuard.count(&*it) == 0)
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Add the children of an object or array node.
+ *
+ * A filtered tree is small and gets all nodes created at once. Otherwise the node only gets a placeholder,
+ * which populateNode() replaces when the node is expanded.
+ *
+ * @param value Object or array shown by the node.
+ * @param first First array element to add.
+ * @param last End of the array elements to add.
+ */
+void JsonTreeView::addChildren(JsonParser::JsonValue &value, TreeNodeRef node, size_t first, size_t last) {
+  if (first >= last)
+    return;
+  if (_useFilter)
+    generateChildren(value, node, first, last);
+  else
+    node->add_child()->set_data(new PendingChildrenData(value, first, last));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Create the nodes for the members of an object or the elements of an array.
+ *
+ * Large arrays get a node per range of JSON_TREE_PAGE_SIZE elements instead, each populated on its own.
+ */
+void JsonTreeView::generateChildren(JsonParser::JsonValue &value, TreeNodeRef node, size_t first, size_t last) {
+  if (value.getType() == VObject) {
+    auto &object = (JsonObject &)value;
+    auto end = object.end();
+    for (JsonObject::Iterator it = object.begin(); it != end; ++it) {
+      if (it->second.isDeleted())
+        continue;
+      auto text = it->first;
+      switch (it->second.getType()) {
+        case VArray:
+          text += "[" + std::to_string(((JsonArray &)it->second).size()) + "]";
+          break;
+        case VObject:
+          text += "{" + std::to_string(((JsonObject &)it->second).size()) + "}";
+          break;
+        default:
+          break;
+      }
+      auto child = node->add_child();
+      child->set_string(0, text);
+      child->set_tag(it->first);
+      generateTree(it->second, 1, child);
+      if (_useFilter)
+        child->expand();
+    }
+    return;
+  }
+
+  auto &arrayType = (JsonArray &)value;
+  std::string tagName = node->get_tag();
+  if (!_useFilter && last - first > JSON_TREE_PAGE_SIZE) {
+    for (size_t i = first; i < last; i += JSON_TREE_PAGE_SIZE) {
+      size_t rangeEnd = std::min(i + JSON_TREE_PAGE_SIZE, last);
+      auto rangeNode = node->add_child();
+      rangeNode->set_icon_path(0, "JS_Datatype_Array.png");
+      rangeNode->set_string(0, "[" + std::to_string(i) + " ... " + std::to_string(rangeEnd - 1) + "]");
+      rangeNode->set_tag(tagName);
+      addChildren(value, rangeNode, i, rangeEnd);
+    }
+    return;
+  }
+
+  std::string keyName = tagName.empty() ? "key[%d]" : tagName + "[%d]";
+  for (size_t i = first; i < last; ++i) {
+    auto &element = arrayType[i];
+    if (element.isDeleted() || (_useFilter && _filterGuard.count(&element) == 0))
       continue;
     auto arrrayNode = node->add_child();
-    bool addNew = false;
-    if (it->getType() == VArray || it->getType() == VObject)
-      addNew = true;
-    std::string keyName = tagName.empty() ? "key[%d]" : tagName + "[%d]";
-    arrrayNode->set_string(0, base::strfmt(keyName.c_str(), index));
+    arrrayNode->set_string(0, base::strfmt(keyName.c_str(), (int)i));
     arrrayNode->set_string(1, "");
-    generateTree(*it, 1, arrrayNode, addNew);
+    generateTree(element, 1, arrrayNode);
+    if (_useFilter)
+      arrrayNode->expand();
   }
-  node->expand();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Replace the placeholder of a node by its real children.
+ *
+ * @param node Tree node reference.
+ */
+void JsonTreeView::populateNode(TreeNodeRef node) {
+  if (node->count() != 1)
+    return;
+  auto placeholder = node->get_child(0);
+  auto data = dynamic_cast<PendingChildrenData *>(placeholder->get_data());
+  if (data == nullptr)
+    return;
+
+  JsonValue &value = data->value;
+  size_t first = data->first;
+  size_t last = data->last;
+  placeholder->remove_from_parent();
+
+  _treeView->BeginUpdate();
+  generateChildren(value, node, first, last);
+  _treeView->EndUpdate();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void JsonTreeView::expandToggled(TreeNodeRef node, bool expanded) {
+  if (expanded)
+    populateNode(node);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Select the node of a value found by highlightMatchNode(), creating the nodes on the way.
+ *
+ * @returns False if the value is not in the tree (anymore).
+ */
+bool JsonTreeView::selectMatch(const ValuePath &path) {
+  if (_treeView->root_node()->count() == 0)
+    return false;
+  auto node = _treeView->root_node()->get_child(0);
+  JsonValue *value = _rootValue;
+  for (size_t index : path) {
+    JsonValue *child = childValue(*value, index);
+    if (child == nullptr)
+      return false;
+
+    populateNode(node);
+    node->expand();
+    if (value->getType() == VArray && ((JsonArray &)*value).size() > JSON_TREE_PAGE_SIZE) {
+      node = node->get_child((int)(index / JSON_TREE_PAGE_SIZE));
+      if (!node.is_valid())
+        return false;
+      populateNode(node);
+      node->expand();
+    }
+
+    TreeNodeRef childNode;
+    for (int i = 0; i < node->count(); ++i) {
+      auto data = dynamic_cast<JsonValueNodeData *>(node->get_child(i)->get_data());
+      if (data != nullptr && &data->getData() == child) {
+        childNode = node->get_child(i);
+        break;
+      }
+    }
+    if (!childNode.is_valid())
+      return false;
+    node = childNode;
+    value = child;
+  }
+
+  _treeView->select_node(node);
+  _treeView->scrollToNode(node);
+  _treeView->focus();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Highlight matches in tree view.
+ *
+ * The search runs over the JSON values, so it also finds values whose nodes were not created yet.
+ * A filtered tree has all its nodes and is searched like the grid view.
+ *
+ * @param text Text to find.
+ * @param backward Search backward.
+ */
+void JsonTreeView::highlightMatchNode(const std::string &text, bool backward) {
+  if (_useFilter || _rootValue == nullptr) {
+    JsonTreeBaseView::highlightMatchNode(text, backward);
+    return;
+  }
+
+  bool newSearch = _textToFind != text;
+  if (newSearch) {
+    _textToFind = text;
+    _matches.clear();
+    ValuePath path;
+    findValues(*_rootValue, text, path, _matches);
+  }
+  if (_matches.empty())
+    return;
+
+  if (newSearch)
+    _matchIndex = backward ? _matches.size() - 1 : 0;
+  else if (backward)
+    _matchIndex = (_matchIndex == 0 ? _matches.size() : _matchIndex) - 1;
+  else
+    _matchIndex = (_matchIndex + 1) % _matches.size();
+  selectMatch(_matches[_matchIndex]);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Filter tree view.
+ *
+ * Keeps the values containing the text and all the objects and arrays leading to them.
+ *
+ * @param text Text to find.
+ * @param value JSON value reference.
+ */
+bool JsonTreeView::filterView(const std::string &text, JsonParser::JsonValue &value) {
+  std::vector<ValuePath> found;
+  ValuePath path;
+  findValues(value, text, path, found);
+  if (found.empty())
+    return _useFilter;
+
+  _filterGuard.clear();
+  for (auto &foundPath : found) {
+    JsonValue *current = &value;
+    _filterGuard.insert(current);
+    for (size_t index : foundPath) {
+      current = childValue(*current, index);
+      _filterGuard.insert(current);
+    }
+  }
+  _useFilter = true;
+  _rootValue = &value;
+  _textToFind.clear();
+  _treeView->clear();
+  generateTree(value, 0, _treeView->root_node());
+  return _useFilter;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -108,6 +108,7 @@ namespace mforms {
     ConnectionVector _connections;
     ConnectionVector _filtered_connections;
     bool _filtered;
+    std::string _last_filter; // The lower case filter text _filtered_connections was made with.
 
     mforms::Menu *_connection_context_menu;
     mforms::Menu *_folder_context_menu;
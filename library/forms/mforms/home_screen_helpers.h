@@ -80,7 +80,9 @@ namespace mforms {
 
     CloseWelcomeMessage,
     
-    RescanLocalServers
+    RescanLocalServers,
+
+    ActionHoverConnection
   };
 
   enum HomeScreenMenuType {
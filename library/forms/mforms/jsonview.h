@@ -29,6 +29,7 @@
 #include "mforms/treeview.h"
 
 #include <set>
+#include <vector>
 #include <functional>
 
 /**
@@ -139,11 +140,12 @@ namespace mforms {
     virtual ~JsonTreeBaseView();
     enum JsonNodeIcons { JsonObjectIcon, JsonArrayIcon, JsonStringIcon, JsonNumericIcon, JsonNullIcon };
     void setCellValue(mforms::TreeNodeRef node, int column, const std::string &value);
-    void highlightMatchNode(const std::string &text, bool bacward = false);
-    bool filterView(const std::string &text, JsonParser::JsonValue &value);
-    void reCreateTree(JsonParser::JsonValue &value);
+    virtual void highlightMatchNode(const std::string &text, bool bacward = false);
+    virtual bool filterView(const std::string &text, JsonParser::JsonValue &value);
+    virtual void reCreateTree(JsonParser::JsonValue &value);
 
   protected:
+    virtual void populateNode(TreeNodeRef node);
     void generateTree(JsonParser::JsonValue &value, int columnId, mforms::TreeNodeRef node, bool addNew = true);
     virtual void generateArrayInTree(JsonParser::JsonValue &value, int columnId, TreeNodeRef node) = 0;
     virtual void generateObjectInTree(JsonParser::JsonValue &value, int columnId, TreeNodeRef node, bool addNew) = 0;
@@ -181,15 +183,38 @@ namespace mforms {
     void setJson(JsonParser::JsonValue &val);
     void appendJson(JsonParser::JsonValue &val);
     virtual void clear();
+    virtual void reCreateTree(JsonParser::JsonValue &value);
+    virtual void highlightMatchNode(const std::string &text, bool backward = false);
+    virtual bool filterView(const std::string &text, JsonParser::JsonValue &value);
 
   private:
+    // Placeholder child of a node whose children are only created when it gets expanded.
+    struct PendingChildrenData : public mforms::TreeNodeData {
+      PendingChildrenData(JsonParser::JsonValue &value, size_t first, size_t last)
+        : value(value), first(first), last(last) {
+      }
+      JsonParser::JsonValue &value;
+      size_t first; // Range of array elements, not used for objects.
+      size_t last;
+    };
+    typedef std::vector<size_t> ValuePath; // Member or element index at each level, starting at the root value.
+
     void init();
+    void addChildren(JsonParser::JsonValue &value, TreeNodeRef node, size_t first, size_t last);
+    void generateChildren(JsonParser::JsonValue &value, TreeNodeRef node, size_t first, size_t last);
+    virtual void populateNode(TreeNodeRef node);
+    void expandToggled(TreeNodeRef node, bool expanded);
+    bool selectMatch(const ValuePath &path);
     virtual void generateArrayInTree(JsonParser::JsonValue &value, int columnId, TreeNodeRef node);
     virtual void generateObjectInTree(JsonParser::JsonValue &value, int columnId, TreeNodeRef node, bool addNew);
     virtual void generateNumberInTree(JsonParser::JsonValue &value, int columnId, TreeNodeRef node);
     virtual void generateBoolInTree(JsonParser::JsonValue &value, int columnId, TreeNodeRef node);
     virtual void generateNullInTree(JsonParser::JsonValue &value, int columnId, TreeNodeRef node);
     virtual void setStringData(int columnId, TreeNodeRef node, const std::string &text);
+
+    JsonParser::JsonValue *_rootValue;
+    std::vector<ValuePath> _matches;
+    size_t _matchIndex;
   };
 
   /**
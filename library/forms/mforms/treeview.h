@@ -216,6 +216,11 @@ namespace mforms {
     virtual std::vector<mforms::TreeNodeRef> add_node_collection(const TreeNodeCollectionSkeleton &nodes,
                                                                  int position = -1) = 0;
 
+    // Adds count children in one go, each with the caption (column 0), icon and tag of the prototype and copies of
+    // its children. Much faster than add_child() and set_string() per node; combine with TreeView::BeginUpdate().
+    virtual std::vector<mforms::TreeNodeRef> add_children(int count, const TreeNodeSkeleton &prototype,
+                                                          int position = -1);
+
     virtual void expand() = 0;
     virtual void collapse() = 0;
     virtual bool is_expanded() = 0;
@@ -281,6 +286,10 @@ namespace mforms {
 
     void (*BeginUpdate)(TreeView *self);
     void (*EndUpdate)(TreeView *self);
+
+    // Virtual mode, optional. Without it TreeView creates the nodes from the data source itself.
+    void (*set_virtual_row_count)(TreeView *self, int count);
+    std::vector<int> (*get_selected_rows)(TreeView *self);
   };
 #endif
 #endif
@@ -447,11 +456,32 @@ namespace mforms {
     /** Sets the widths of a column */
     void set_column_width(int column, int width);
 
+#ifndef SWIG
+    /** Switches the tree to virtual mode, where no nodes are created. The view asks the data source for the
+     values of the rows it shows, by row index and column, and only keeps what is on screen.
+
+     Call after end_columns(). In virtual mode the list is flat and not sortable, rows are addressed by index
+     (get_selected_rows(), get_selected_row()) and the node based functions are not available; the node passed to
+     signal_node_activated() is empty. Platforms without native support fall back to creating the nodes. */
+    void set_virtual_data_source(const std::function<std::string(int, int)> &cell_value);
+#endif
+
+    /** Sets the number of rows in virtual mode. Call again whenever the data source changed, also when only values
+     changed, so the visible rows are redrawn. */
+    void set_virtual_row_count(int count);
+
+    bool is_virtual() const {
+      return (bool)_virtual_cell_value;
+    }
+
+    /** Returns the indexes of the selected rows, in both virtual and normal mode (top level rows only). */
+    std::vector<int> get_selected_rows();
+
   public:
     // backwards compatibility with TreeView
 
     int count() {
-      return root_node()->count();
+      return is_virtual() ? _virtual_row_count : root_node()->count();
     }
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -497,8 +527,13 @@ namespace mforms {
     // what column is it being shown for
     void header_clicked(int column);
 
+    // Batches changes to the tree: until the matching EndUpdate() the platform may suspend sorting and redraws,
+    // and selection changes are reported once at the end. Calls can be nested. See also TreeViewUpdateScope.
     void BeginUpdate();
     void EndUpdate();
+
+    // Value of a cell in virtual mode, called by the platform code.
+    std::string get_virtual_value(int row, int column);
 #endif
 #endif
 
@@ -510,12 +545,32 @@ namespace mforms {
     std::function<void(TreeNodeRef, int, std::string)> _cell_edited;
     boost::signals2::signal<void(int)> _signal_column_resized;
     std::function<std::vector<std::string>(TreeNodeRef)> _overlay_icons_for_node;
+    std::function<std::string(int, int)> _virtual_cell_value;
+    int _virtual_row_count;
     ContextMenu *_context_menu;
     ContextMenu *_header_menu;
     std::vector<TreeColumnType> _column_types;
     int _update_count;
+    int _batch_update_count;
+    bool _changed_during_update;
     int _clicked_header_column;
     bool _index_on_tag;
     bool _end_column_called;
   };
+
+#ifndef SWIG
+  // Calls BeginUpdate() on the tree for the lifetime of the object.
+  class MFORMS_EXPORT TreeViewUpdateScope {
+  public:
+    TreeViewUpdateScope(TreeView *tree) : _tree(tree) {
+      _tree->BeginUpdate();
+    }
+    ~TreeViewUpdateScope() {
+      _tree->EndUpdate();
+    }
+
+  private:
+    TreeView *_tree;
+  };
+#endif
 }
@@ -28,6 +28,7 @@
  */
 #include <cairo/cairo.h>
 #include <functional>
+#include <vector>
 #include "base/geometry.h"
 #include "mforms/base.h"
 
@@ -141,6 +142,7 @@ namespace mforms {
     void (*set_thread_name)(const std::string &name);
 
     double (*get_text_width)(const std::string &text, const std::string &font);
+    void (*preload_icons)(const std::vector<std::string> &paths);
   };
 #endif
 #endif
@@ -329,6 +331,9 @@ namespace mforms {
     static std::string shorten_string(cairo_t *cr, const std::string &text, double width);
 
     static double get_text_width(const std::string &text, const std::string &font);
+
+    // Decodes the given image files into the icon cache used for trees and lists. Can be called from any thread.
+    static void preload_icons(const std::vector<std::string> &paths);
 #endif
 
 #ifndef SWIG
@@ -22,6 +22,7 @@
  */
 
 #include "mforms/mforms.h"
+#include "base/string_utilities.h"
 
 using namespace mforms;
 
@@ -111,6 +112,22 @@ void TreeNode::remove_children() {
   }
 }
 
+/**
+ * Builds on add_node_collection(), which all platforms implement as a bulk insertion.
+ */
+std::vector<TreeNodeRef> TreeNode::add_children(int count, const TreeNodeSkeleton &prototype, int position) {
+  TreeNodeCollectionSkeleton nodes(prototype.icon);
+  nodes.captions.assign(count > 0 ? count : 0, prototype.caption);
+  nodes.children = prototype.children;
+
+  std::vector<TreeNodeRef> added(add_node_collection(nodes, position));
+  if (!prototype.tag.empty()) {
+    for (std::vector<TreeNodeRef>::iterator node = added.begin(); node != added.end(); ++node)
+      (*node)->set_tag(prototype.tag);
+  }
+  return added;
+}
+
 TreeNodeRef TreeNode::find_child_with_tag(const std::string &tag) {
   for (int c = count(), i = 0; i < c; i++) {
     TreeNodeRef child(get_child(i));
@@ -137,7 +154,10 @@ TreeView::TreeView(TreeOptions options) // yep
   : _context_menu(0),
     _header_menu(0),
     _update_count(0),
+    _batch_update_count(0),
+    _changed_during_update(false),
     _clicked_header_column(0),
+    _virtual_row_count(0),
     _end_column_called(false) {
   _treeview_impl = &ControlFactory::get_instance()->_treeview_impl;
   _index_on_tag = (options & TreeIndexOnTag) ? true : false;
@@ -229,10 +249,28 @@ TreeSelectionMode TreeView::get_selection_mode() {
 }
 
 int TreeView::get_selected_row() {
+  if (is_virtual()) {
+    std::vector<int> rows(get_selected_rows());
+    return rows.empty() ? -1 : rows.front();
+  }
   TreeNodeRef node(get_selected_node());
   return row_for_node(node);
 }
 
+std::vector<int> TreeView::get_selected_rows() {
+  if (is_virtual() && _treeview_impl->set_virtual_row_count)
+    return _treeview_impl->get_selected_rows(this);
+
+  std::vector<int> rows;
+  std::list<TreeNodeRef> selection(get_selection());
+  for (std::list<TreeNodeRef>::iterator node = selection.begin(); node != selection.end(); ++node) {
+    int row = row_for_node(*node);
+    if (row >= 0)
+      rows.push_back(row);
+  }
+  return rows;
+}
+
 std::list<TreeNodeRef> TreeView::get_selection() {
   return _treeview_impl->get_selection(this);
 }
@@ -305,6 +343,8 @@ void TreeView::column_resized(int column) {
 void TreeView::changed() {
   if (_update_count == 0)
     _signal_changed();
+  else if (_batch_update_count > 0 && _update_count == 1)
+    _changed_during_update = true; // Reported by EndUpdate(). Not for select_node() and the like within the batch.
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -460,12 +500,86 @@ double TreeView::parse_string_with_unit(const char *s) {
   return value;
 }
 
+void TreeView::set_virtual_data_source(const std::function<std::string(int, int)> &cell_value) {
+  if (!_end_column_called)
+    throw std::logic_error("TreeView::set_virtual_data_source() must be called after end_columns()");
+  _virtual_cell_value = cell_value;
+  _virtual_row_count = 0;
+  clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void TreeView::set_virtual_row_count(int count) {
+  if (!is_virtual())
+    throw std::logic_error("TreeView::set_virtual_row_count() requires a virtual data source");
+
+  _virtual_row_count = count;
+  if (_treeview_impl->set_virtual_row_count) {
+    _treeview_impl->set_virtual_row_count(this, count);
+    return;
+  }
+
+  // No native virtual mode on this platform, so the nodes are created from the data source.
+  freeze_refresh();
+  clear();
+  for (int row = 0; row < count; ++row) {
+    TreeNodeRef node(add_node());
+    for (int column = 0; column < get_column_count(); ++column) {
+      std::string value(get_virtual_value(row, column));
+      switch (_column_types[column]) {
+        case IntegerColumnType:
+        case TriCheckColumnType:
+          node->set_int(column, base::atoi<int>(value, 0));
+          break;
+        case CheckColumnType:
+          node->set_bool(column, base::atoi<int>(value, 0) != 0);
+          break;
+        case LongIntegerColumnType:
+          node->set_long(column, base::atoi<std::int64_t>(value, 0));
+          break;
+        case FloatColumnType:
+          node->set_float(column, base::atof<double>(value, 0.0));
+          break;
+        default:
+          node->set_string(column, value);
+          break;
+      }
+    }
+  }
+  thaw_refresh();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string TreeView::get_virtual_value(int row, int column) {
+  if (!_virtual_cell_value || row < 0 || row >= _virtual_row_count)
+    return "";
+  return _virtual_cell_value(row, column);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void TreeView::BeginUpdate() {
+  if (_batch_update_count++ > 0)
+    return;
+
+  _update_count++;
+  _changed_during_update = false;
   if (_treeview_impl->BeginUpdate)
     _treeview_impl->BeginUpdate(this);
 }
 
 void TreeView::EndUpdate() {
+  if (_batch_update_count == 0 || --_batch_update_count > 0)
+    return;
+
   if (_treeview_impl->EndUpdate)
     _treeview_impl->EndUpdate(this);
+  _update_count--;
+
+  if (_changed_during_update) {
+    _changed_during_update = false;
+    changed();
+  }
 }
@@ -197,6 +197,111 @@ TEST_FUNCTION(15) {
 
 //--------------------------------------------------------------------------------------------------
 
+TEST_FUNCTION(20) {
+  // Objects and arrays are built when accessed, copies taken before that are independent.
+  std::string json = "{\"list\" : [1, 2.5, \"a\\\"b\", {\"x\" : [true, null]}], \"empty\" : {}, \"n\" : -7}";
+  JsonValue value;
+  JsonReader::read(json, value);
+  ensure_equals("root type", value.getType(), VObject);
+
+  JsonValue copy = value;
+  JsonObject &root = value;
+  ensure_equals("member count", root.size(), 3U);
+  ensure_equals("negative number", (int)root.get("n"), -7);
+  ensure_equals("empty object", ((JsonObject &)root.get("empty")).size(), 0U);
+
+  JsonArray &list = root.get("list");
+  ensure_equals("element count", list.size(), 4U);
+  ensure_equals("integer", (int)list[0], 1);
+  ensure_equals("double", (double)list[1], 2.5);
+  ensure_equals("escaped string", (std::string)list[2], "a\"b");
+  JsonObject &nested = list[3];
+  ensure_equals("nested array", ((JsonArray &)nested.get("x")).size(), 2U);
+
+  list[0] = 5;
+  const JsonObject &original = copy;
+  ensure_equals("copy unchanged", (int)((const JsonArray &)original.get("list"))[0], 1);
+
+  std::string text;
+  JsonWriter::write(text, value);
+  JsonValue reread;
+  JsonReader::read(text, reread);
+  ensure_equals("changed value written", (int)((JsonArray &)((JsonObject &)reread).get("list"))[0], 5);
+
+  // Duplicates are found in objects with many members too.
+  std::string many = "{";
+  for (int i = 0; i < 40; ++i)
+    many += "\"k" + std::to_string(i) + "\" : " + std::to_string(i) + ", ";
+  bool exceptionThrown = false;
+  try {
+    JsonReader::read(many + "\"k33\" : 0}", value);
+  } catch (ParserException &) {
+    exceptionThrown = true;
+  }
+  ensure_true("Duplicate member should be found", exceptionThrown);
+  JsonReader::read(many + "\"k40\" : 0}", value);
+  ensure_equals("many members", ((JsonObject &)value).size(), 41U);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+class EventRecorder : public JsonReader::Handler {
+public:
+  std::string events;
+
+  virtual void objectStart() override {
+    events += "{";
+  }
+  virtual void objectEnd() override {
+    events += "}";
+  }
+  virtual void arrayStart() override {
+    events += "[";
+  }
+  virtual void arrayEnd() override {
+    events += "]";
+  }
+  virtual void key(const std::string &name) override {
+    events += name + ":";
+  }
+  virtual void value(const JsonValue &value) override {
+    switch (value.getType()) {
+      case VString:
+        events += "s";
+        break;
+      case VInt64:
+        events += "i";
+        break;
+      case VDouble:
+        events += "d";
+        break;
+      case VBoolean:
+        events += "b";
+        break;
+      default:
+        events += "0";
+        break;
+    }
+  }
+};
+
+TEST_FUNCTION(25) {
+  // The streaming parser reports the elements in text order and checks the text like read() does.
+  EventRecorder recorder;
+  JsonReader::parse("{\"b\" : [1, 1.5, \"x\", false, null], \"a\" : {}}", recorder);
+  ensure_equals("events", recorder.events, "{b:[idsb0]a:{}}");
+
+  bool exceptionThrown = false;
+  try {
+    JsonReader::parse("[1, 2 3]", recorder);
+  } catch (ParserException &) {
+    exceptionThrown = true;
+  }
+  ensure_true("Exception should be thrown", exceptionThrown);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 END_TESTS;
 
 //--------------------------------------------------------------------------------------------------
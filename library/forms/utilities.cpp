@@ -875,6 +875,13 @@ double Utilities::get_text_width(const std::string &text, const std::string &fon
 
 //--------------------------------------------------------------------------------------------------
 
+void Utilities::preload_icons(const std::vector<std::string> &paths) {
+  if (ControlFactory::get_instance()->_utilities_impl.preload_icons)
+    ControlFactory::get_instance()->_utilities_impl.preload_icons(paths);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 bool Utilities::in_main_thread() {
   return g_thread_self() == _mforms_main_thread;
 }
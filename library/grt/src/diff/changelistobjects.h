@@ -158,6 +158,19 @@ namespace grt {
       cs.append(_subchange);
     }
 
+    ListItemOrderChange(const ValueRef &source, const ValueRef &target,
+                        const std::shared_ptr<ListItemModifiedChange> &subchange, const ValueRef prev_value,
+                        size_t index)
+      : ListItemChange(ListItemOrderChanged, index),
+        _subchange(subchange),
+        _old_value(source),
+        _new_value(target),
+        _prev_value(prev_value) {
+      if (_subchange)
+        _subchange->set_parent(this);
+      cs.append(_subchange);
+    }
+
     virtual ValueRef get_old_value() const {
       return _old_value;
     };
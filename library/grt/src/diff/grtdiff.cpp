@@ -152,6 +152,8 @@ namespace grt {
       if ((1 == IntegerRef::cast_from(v1)) || (1 == IntegerRef::cast_from(v2)))
         return std::shared_ptr<DiffChange>();
     }
+    if (omf->known_equal(source, target))
+      return std::shared_ptr<DiffChange>();
 
     // Compare all members of the objects with each other, looking for any differences
     do {
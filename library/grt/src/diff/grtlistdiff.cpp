@@ -28,9 +28,14 @@
 #include "changelistobjects.h"
 #include "grtdiff.h"
 #include "base/log.h"
+#include "base/task_scheduler.h"
 
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace grt {
   // typedef ListDifference<ValueRef, internal::List::raw_iterator, internal::List::raw_iterator> GrtListDifference;
@@ -137,11 +142,103 @@ namespace grt {
       return a->get_index() < b->get_index();
   }
 
+  /**
+   * Finds list items equal to a value according to an Omf.
+   *
+   * If the Omf provides match keys for all items, the first item for each key is kept in a hash index.
+   * Since equal values have equal keys, the indexed item is the first equal one whenever it is equal to
+   * the value at all. Otherwise or on key collisions the list is searched linearly, as before.
+   */
+  class ListItemIndex {
+    const BaseListRef &_list;
+    const Omf *_omf;
+    bool _indexed;
+    std::unordered_map<std::string, size_t> _first_item;
+
+  public:
+    ListItemIndex(const BaseListRef &list, const Omf *omf) : _list(list), _omf(omf), _indexed(true) {
+      std::string key;
+      _first_item.reserve(list.count());
+      for (size_t i = 0, c = list.count(); i < c; ++i) {
+        if (!_omf->match_key(list.get(i), key)) {
+          _indexed = false;
+          _first_item.clear();
+          break;
+        }
+        _first_item.insert(std::make_pair(key, i));
+      }
+    }
+
+    // Index of the first item equal to value or BaseListRef::npos.
+    size_t find(const ValueRef &value) const {
+      std::string key;
+      if (_indexed && _omf->match_key(value, key)) {
+        std::unordered_map<std::string, size_t>::const_iterator iter = _first_item.find(key);
+        if (iter == _first_item.end())
+          return BaseListRef::npos;
+        if (_omf->equal(_list.get(iter->second), value))
+          return iter->second;
+      }
+
+      internal::List::raw_const_iterator it =
+        find_if(_list.content().raw_begin(), _list.content().raw_end(), std::bind2nd(OmfEqPred(_omf), value));
+      return it == _list.content().raw_end() ? BaseListRef::npos : it - _list.content().raw_begin();
+    }
+  };
+
+  // A source item that also exists in the target list, to be diffed in place or moved if it changed position.
+  struct MatchedListItem {
+    size_t source_index;
+    size_t target_index;
+    bool moved;
+    std::shared_ptr<ListItemModifiedChange> change;
+
+    MatchedListItem(size_t source_index, size_t target_index, bool moved)
+      : source_index(source_index), target_index(target_index), moved(moved) {
+    }
+  };
+
+  static void diff_matched_items(const BaseListRef &source, const BaseListRef &target, const Omf *omf,
+                                 std::vector<MatchedListItem> &items) {
+    size_t thread_count = std::min((size_t)std::max(1U, std::thread::hardware_concurrency()), items.size());
+
+    if (thread_count < 2 || !omf || !omf->diff_items_in_parallel(source)) {
+      for (std::vector<MatchedListItem>::iterator item = items.begin(); item != items.end(); ++item)
+        item->change =
+          create_item_modified_change(source.get(item->source_index), target.get(item->target_index), omf,
+                                      item->target_index);
+      return;
+    }
+
+    // The item diffs only read the lists, each worker takes the next item not yet diffed.
+    std::atomic<size_t> next_item(0);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    base::TaskScheduler::get()->run_parallel(base::TaskBulk, thread_count, [&](size_t) {
+      for (size_t index = next_item++; index < items.size(); index = next_item++) {
+        try {
+          MatchedListItem &item = items[index];
+          item.change = create_item_modified_change(source.get(item.source_index), target.get(item.target_index),
+                                                    omf, item.target_index);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error)
+            error = std::current_exception();
+        }
+      }
+    });
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+
   std::shared_ptr<MultiChange> GrtListDiff::diff(const BaseListRef &source, const BaseListRef &target, const Omf *omf) {
     typedef std::vector<size_t> TIndexContainer;
     default_omf def_omf;
     std::vector<std::shared_ptr<ListItemChange> > changes;
     const Omf *comparer = omf ? omf : &def_omf;
+    ListItemIndex source_index(source, comparer);
+    ListItemIndex target_index(target, comparer);
     ValueRef prev_value;
     // This is indexes of source's elements that exist in both target and source
     // in order of element appearance in target
@@ -152,16 +249,13 @@ namespace grt {
     for (size_t target_idx = 0; target_idx < target.count();
          ++target_idx) { // look for something that exists in target but not in source, it should be added
       const ValueRef v = target.get(target_idx);
-      internal::List::raw_const_iterator It_Dup = find_if(
-        target.content().raw_begin(), target.content().raw_begin() + target_idx, std::bind2nd(OmfEqPred(comparer), v));
-      if (It_Dup != target.content().raw_begin() + target_idx)
+      if (target_index.find(v) < target_idx)
         continue;
-      internal::List::raw_const_iterator It =
-        find_if(source.content().raw_begin(), source.content().raw_end(), std::bind2nd(OmfEqPred(comparer), v));
-      if (It == source.content().raw_end())
+      size_t index = source_index.find(v);
+      if (index == BaseListRef::npos)
         changes.push_back(std::shared_ptr<ListItemChange>(new ListItemAddedChange(v, prev_value, target_idx)));
       else // item exists in both target and source, save indexes
-        source_indexes.push_back(source.get_index(*It));
+        source_indexes.push_back(index);
       prev_value = v;
     };
 
@@ -172,14 +266,10 @@ namespace grt {
       // This shouldn't happend actually, since lists are expected to be unique
       // But in case of caseless compare we may have non-unique lists
       // so just skip it
-      internal::List::raw_const_iterator It_Dup = find_if(
-        source.content().raw_begin(), source.content().raw_begin() + source_idx, std::bind2nd(OmfEqPred(comparer), v));
-      if (It_Dup != source.content().raw_begin() + source_idx)
+      if (source_index.find(v) < source_idx)
         continue;
 
-      internal::List::raw_const_iterator It =
-        find_if(target.content().raw_begin(), target.content().raw_end(), std::bind2nd(OmfEqPred(comparer), v));
-      if (It == target.content().raw_end()) {
+      if (target_index.find(v) == BaseListRef::npos) {
 #ifdef DEBUG_DIFF
         logInfo("Removing %s from list\n", grt::ObjectRef::cast_from(v)->get_string_member("name").c_str());
         if (grt::ObjectRef::cast_from(v)->get_string_member("name") == "fk_tblClientApp_base_tblClient_base1_idx")
@@ -197,25 +287,26 @@ namespace grt {
     TIndexContainer moved_elements(source_indexes.size() - stable_elements.size());
     std::set_difference(ordered_indexes.begin(), ordered_indexes.end(), stable_elements.rbegin(),
                         stable_elements.rend(), moved_elements.begin());
-    for (TIndexContainer::iterator It = moved_elements.begin(); It != moved_elements.end(); ++It) {
-      internal::List::raw_const_iterator It_target = find_if(target.content().raw_begin(), target.content().raw_end(),
-                                                             std::bind2nd(OmfEqPred(comparer), source.get(*It)));
-      prev_value = It_target == target.content().raw_begin() ? ValueRef() : *(It_target - 1);
-      std::shared_ptr<ListItemOrderChange> orderchange(
-        new ListItemOrderChange(source.get(*It), *It_target, omf, prev_value, target.get_index(*It_target)));
-      //    if (!orderchange->subchanges()->empty())
-      changes.push_back(orderchange);
-    }
 
+    std::vector<MatchedListItem> matched;
+    matched.reserve(moved_elements.size() + stable_elements.size());
+    for (TIndexContainer::iterator It = moved_elements.begin(); It != moved_elements.end(); ++It)
+      matched.push_back(MatchedListItem(*It, target_index.find(source.get(*It)), true));
     for (TIndexContainer::iterator It = stable_elements.begin(); It != stable_elements.end(); ++It) {
-      internal::List::raw_const_iterator It_target = find_if(target.content().raw_begin(), target.content().raw_end(),
-                                                             std::bind2nd(OmfEqPred(comparer), source.get(*It)));
-      if (It_target != target.content().raw_end()) {
-        std::shared_ptr<ListItemChange> change =
-          create_item_modified_change(source.get(*It), *It_target, omf, target.get_index(*It_target));
-        if (change)
-          changes.push_back(change);
-      }
+      size_t index = target_index.find(source.get(*It));
+      if (index != BaseListRef::npos)
+        matched.push_back(MatchedListItem(*It, index, false));
+    }
+    diff_matched_items(source, target, omf, matched);
+
+    for (std::vector<MatchedListItem>::iterator item = matched.begin(); item != matched.end(); ++item) {
+      if (item->moved) {
+        prev_value = item->target_index == 0 ? ValueRef() : target.get(item->target_index - 1);
+        changes.push_back(std::shared_ptr<ListItemOrderChange>(
+          new ListItemOrderChange(source.get(item->source_index), target.get(item->target_index), item->change,
+                                  prev_value, item->target_index)));
+      } else if (item->change)
+        changes.push_back(item->change);
     }
     ChangeSet retval;
     std::sort(changes.begin(), changes.end(), diffPred);
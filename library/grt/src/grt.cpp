@@ -26,7 +26,9 @@
 #include "base/threading.h"
 #include "base/log.h"
 #include "base/file_utilities.h"
+#include "base/file_functions.h"
 #include "base/xml_functions.h"
+#include "base/task_scheduler.h"
 
 #include "grt.h"
 #include "grtpp_util.h"
@@ -37,7 +39,13 @@
 
 #include <cppconn/exception.h>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
 #include <glib.h>
+#include <glib/gstdio.h>
+#include <libxml/parser.h>
 
 #include "serializer.h"
 #include "unserializer.h"
@@ -226,7 +234,7 @@ StringRef StringRef::format(const char *format, ...) {
 
 //--------------------------------------------------------------------------------------------------
 
-GRT::GRT() : _check_serialized_crc(false), _verbose(false), _testing(false) {
+GRT::GRT() : _modules_generation(0), _check_serialized_crc(false), _verbose(false), _testing(false) {
   _scanning_modules = false;
 
   _tracking_changes = 0;
@@ -264,6 +272,7 @@ GRT::~GRT() {
     it->closeModule();
 
   _modules.clear();
+  _function_handles.clear();
 
   for (std::map<std::string, Interface *>::iterator iter = _interfaces.begin(); iter != _interfaces.end(); ++iter)
     delete iter->second;
@@ -333,12 +342,15 @@ void GRT::unlock() const {
 //--------------------------------------------------------------------------------------------------
 
 void GRT::load_metaclasses(const std::string &file, std::list<std::string> *requires) {
-  xmlNodePtr root;
-  xmlDocPtr doc;
-
-  doc = base::xml::loadXMLDoc(file);
+  load_metaclasses(file, base::xml::loadXMLDoc(file), requires);
+}
 
-  root = xmlDocGetRootElement(doc);
+/**
+ * Registers the structs of an already parsed struct file and frees the doc, also when that fails.
+ */
+void GRT::load_metaclasses(const std::string &file, xmlDocPtr doc, std::list<std::string> *requires) {
+  std::unique_ptr<xmlDoc, void (*)(xmlDocPtr)> doc_owner(doc, xmlFreeDoc);
+  xmlNodePtr root = xmlDocGetRootElement(doc);
 
   if (root && xmlStrcmp(root->name, (xmlChar *)"gstructs") == 0) {
     root = root->children;
@@ -368,13 +380,13 @@ void GRT::load_metaclasses(const std::string &file, std::list<std::string> *requ
       root = root->next;
     }
   }
-  xmlFreeDoc(doc);
 }
 
 int GRT::scan_metaclasses_in(const std::string &directory, std::multimap<std::string, std::string> *requires) {
   GDir *dir;
   const char *entry;
   size_t old_count = _metaclasses.size();
+  std::vector<std::string> paths;
 
   dir = g_dir_open(directory.c_str(), 0, NULL);
   if (!dir)
@@ -383,27 +395,55 @@ int GRT::scan_metaclasses_in(const std::string &directory, std::multimap<std::st
   while ((entry = g_dir_read_name(dir)) != NULL) {
     if ((g_str_has_prefix(entry, "structs.")) && (g_str_has_suffix(entry, ".xml"))) {
       char *path = g_build_filename(directory.c_str(), entry, NULL);
-      std::list<std::string> reqs;
-
-      reqs.clear();
-      try {
-        load_metaclasses(path, &reqs);
-      } catch (...) {
-        g_free(path);
-        throw;
-      }
-
-      if (requires) {
-        for (std::list<std::string>::const_iterator i = reqs.begin(); i != reqs.end(); ++i)
-          requires->insert(std::pair<std::string, std::string>(path, *i));
-      }
-
+      paths.push_back(path);
       g_free(path);
     }
   }
 
   g_dir_close(dir);
 
+  // Parsing the files is most of the work and doesn't touch the GRT, so it is done in parallel. The structs are
+  // then registered one file after the other in directory order, as placeholders and duplicates depend on it.
+  std::vector<xmlDocPtr> docs(paths.size(), nullptr);
+  std::vector<std::exception_ptr> errors(paths.size());
+  size_t thread_count = std::min((size_t)std::max(1U, std::thread::hardware_concurrency()), paths.size());
+  if (thread_count > 1) {
+    xmlInitParser(); // Must be done on the main thread before libxml is used from others.
+
+    std::atomic<size_t> next_file(0);
+    base::TaskScheduler::get()->run_parallel(base::TaskInteractive, thread_count, [&](size_t) {
+      for (size_t index = next_file++; index < paths.size(); index = next_file++) {
+        try {
+          docs[index] = base::xml::loadXMLDoc(paths[index]);
+        } catch (...) {
+          errors[index] = std::current_exception();
+        }
+      }
+    });
+  }
+
+  for (size_t index = 0; index < paths.size(); ++index) {
+    std::list<std::string> reqs;
+
+    try {
+      if (errors[index])
+        std::rethrow_exception(errors[index]);
+      xmlDocPtr doc = docs[index];
+      docs[index] = nullptr; // Owned by load_metaclasses() from here on.
+      load_metaclasses(paths[index], doc ? doc : base::xml::loadXMLDoc(paths[index]), &reqs);
+    } catch (...) {
+      for (size_t i = index + 1; i < docs.size(); ++i)
+        if (docs[i])
+          xmlFreeDoc(docs[i]);
+      throw;
+    }
+
+    if (requires) {
+      for (std::list<std::string>::const_iterator i = reqs.begin(); i != reqs.end(); ++i)
+        requires->insert(std::pair<std::string, std::string>(paths[index], *i));
+    }
+  }
+
   return (int)(_metaclasses.size() - old_count);
 }
 
@@ -463,6 +503,10 @@ void GRT::end_loading_metaclasses(bool check_class_binding) {
   // register GRT object classes
   internal::ClassRegistry::get_instance()->register_all();
 
+  // now that all members are bound, flatten them for faster dynamic access
+  for (std::map<std::string, MetaClass *>::iterator iter = _metaclasses.begin(); iter != _metaclasses.end(); ++iter)
+    iter->second->build_member_slots();
+
   if (check_class_binding) {
     // check if there are any metaclasses with unbound members
     for (std::map<std::string, MetaClass *>::iterator iter = _metaclasses.begin(); iter != _metaclasses.end(); ++iter) {
@@ -558,6 +602,13 @@ void GRT::serialize(const ValueRef &value, const std::string &path, const std::s
   ser.save_to_xml(value, path, doctype, version, list_objects_as_links);
 }
 
+void GRT::serialize_binary(const ValueRef &value, const std::string &path, const std::string &doctype,
+                           const std::string &version, bool list_objects_as_links) {
+  internal::Serializer ser;
+
+  ser.save_to_binary(value, path, doctype, version, list_objects_as_links);
+}
+
 std::shared_ptr<grt::internal::Unserializer> GRT::get_unserializer() {
   return std::shared_ptr<grt::internal::Unserializer>(new internal::Unserializer(_check_serialized_crc));
 };
@@ -570,6 +621,8 @@ ValueRef GRT::unserialize(const std::string &path, std::shared_ptr<grt::internal
     throw os_error(path);
 
   try {
+    if (internal::Unserializer::is_binary_file(path))
+      return unserializer->load_from_binary(path);
     return unserializer->load_from_xml(path);
   } catch (std::exception &exc) {
     throw std::runtime_error(
@@ -583,12 +636,82 @@ ValueRef GRT::unserialize(const std::string &path, std::string &doctype_ret, std
   if (!g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
     throw os_error(path);
   try {
+    if (internal::Unserializer::is_binary_file(path))
+      return unser.load_from_binary(path, &doctype_ret, &version_ret);
     return unser.load_from_xml(path, &doctype_ret, &version_ret);
   } catch (std::exception &exc) {
     throw grt_runtime_error("Error unserializing GRT data from " + path, exc.what());
   }
 }
 
+#define SNAPSHOT_DOCTYPE "GRTSnapshot"
+#define SNAPSHOT_SUFFIX ".grtb"
+
+// Identifies the version of an XML file and of the structs a snapshot of it was written with.
+static std::string snapshot_stamp(const std::string &path) {
+#ifdef _WIN32
+  struct _stat stbuf;
+#else
+  struct stat stbuf;
+#endif
+  if (base_stat(path.c_str(), &stbuf) != 0)
+    return "";
+
+  guint32 checksum = 0;
+  const std::list<MetaClass *> &metaclasses(GRT::get()->get_metaclasses());
+  for (std::list<MetaClass *>::const_iterator iter = metaclasses.begin(); iter != metaclasses.end(); ++iter)
+    checksum = (checksum << 5 | checksum >> 27) ^ (*iter)->crc32();
+
+  return strfmt("%lld:%lld:%08x", (long long)stbuf.st_mtime, (long long)stbuf.st_size, checksum);
+}
+
+ValueRef GRT::load_snapshot(const std::string &path) {
+  std::string snapshot = path + SNAPSHOT_SUFFIX;
+  std::string doctype, version;
+
+  if (!internal::Unserializer::read_binary_header(snapshot, doctype, version) || doctype != SNAPSHOT_DOCTYPE)
+    return ValueRef();
+
+  std::string stamp = snapshot_stamp(path);
+  if (stamp.empty() || version != stamp) {
+    logDebug("Snapshot %s is outdated\n", snapshot.c_str());
+    return ValueRef();
+  }
+
+  try {
+    internal::Unserializer unser(_check_serialized_crc);
+    return unser.load_from_binary(snapshot);
+  } catch (std::exception &exc) {
+    logWarning("Could not read snapshot %s: %s\n", snapshot.c_str(), exc.what());
+    return ValueRef();
+  }
+}
+
+void GRT::save_snapshot(const ValueRef &value, const std::string &path) {
+  std::string snapshot = path + SNAPSHOT_SUFFIX;
+  std::string stamp = snapshot_stamp(path);
+  if (stamp.empty() || !value.is_valid())
+    return;
+
+  try {
+    serialize_binary(value, snapshot + ".tmp", SNAPSHOT_DOCTYPE, stamp);
+    g_remove(snapshot.c_str());
+    g_rename(std::string(snapshot + ".tmp").c_str(), snapshot.c_str());
+  } catch (std::exception &exc) {
+    // Only a missed speedup, the next start reads the XML file again.
+    logWarning("Could not write snapshot %s: %s\n", snapshot.c_str(), exc.what());
+  }
+}
+
+ValueRef GRT::unserialize_with_snapshot(const std::string &path) {
+  ValueRef value = load_snapshot(path);
+  if (!value.is_valid()) {
+    value = unserialize(path);
+    save_snapshot(value, path);
+  }
+  return value;
+}
+
 xmlDocPtr GRT::load_xml(const std::string &path) {
   return base::xml::loadXMLDoc(path);
 }
@@ -757,10 +880,11 @@ Module *GRT::get_module(const std::string &name) {
 
 grt::ValueRef GRT::call_module_function(const std::string &module, const std::string &function,
                                         const grt::BaseListRef &args) {
-  Module *m = get_module(module);
-  if (!m)
-    throw grt::module_error("Module " + module + " not found");
-  return m->call_function(function, args);
+  std::string key = module + "." + function;
+  std::unordered_map<std::string, ModuleFunctionHandle>::iterator handle = _function_handles.find(key);
+  if (handle == _function_handles.end())
+    handle = _function_handles.emplace(key, ModuleFunctionHandle(module, function)).first;
+  return handle->second.call(args);
 }
 
 std::vector<Module *> GRT::find_modules_matching(const std::string &interface_name, const std::string &name_pattern) {
@@ -797,6 +921,7 @@ void GRT::register_new_module(Module *module) {
     throw std::runtime_error("Duplicate module " + module->name());
 
   _modules.push_back(module);
+  ++_modules_generation;
 
   if (!_scanning_modules)
     refresh_loaders();
@@ -806,6 +931,7 @@ void GRT::unregister_module(Module *module) {
   std::vector<Module *>::iterator iter = std::find(_modules.begin(), _modules.end(), module);
   if (iter != _modules.end())
     _modules.erase(iter);
+  ++_modules_generation;
 
   refresh_loaders();
 
@@ -823,6 +949,7 @@ void GRT::refresh_module(Module *module) {
       delete *iter;
 
       *iter = module;
+      ++_modules_generation;
       found = true;
       break;
     }
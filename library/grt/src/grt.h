@@ -1927,6 +1927,14 @@ namespace grt {
 
     typedef std::map<std::string, Member> MemberList;
     typedef std::map<std::string, Method> MethodList;
+
+    /** A member as found through the class hierarchy, for access without walking up the parents.
+     */
+    struct MemberSlot {
+      const Member *info;   //< the most derived declaration, 0 if there is no such member
+      const Member *getter; //< the declaration whose property reads the value
+      const Member *setter; //< the declaration whose property writes the value, 0 if the member can't be set
+    };
     typedef std::list<Signal> SignalList;
     typedef std::vector<Validator *> ValidatorList;
 
@@ -2070,9 +2078,13 @@ namespace grt {
 
     bool is_abstract() const;
 
+    MemberSlot get_member_slot(const std::string &member) const;
+
     void set_member_value(internal::Object *object, const std::string &name, const ValueRef &value);
+    void set_member_value(internal::Object *object, const MemberSlot &slot, const ValueRef &value);
     ValueRef get_member_value(const internal::Object *object, const std::string &name);
     ValueRef get_member_value(const internal::Object *object, const Member *member);
+    ValueRef get_member_value(const internal::Object *object, const MemberSlot &slot);
 
     ValueRef call_method(internal::Object *object, const std::string &name, const BaseListRef &args);
     ValueRef call_method(internal::Object *object, const Method *method, const BaseListRef &args);
@@ -2090,6 +2102,7 @@ namespace grt {
     }
     bool validate();
     bool is_bound() const;
+    void build_member_slots();
     std::string source() {
       return _source;
     }
@@ -2103,11 +2116,16 @@ namespace grt {
     bool watch_dicts() const {
       return _watch_dicts;
     }
+    bool watch_members() const {
+      return _watch_members;
+    }
     bool impl_data() const {
       return _impl_data;
     }
 
     void set_member_internal(internal::Object *object, const std::string &name, const ValueRef &value, bool force);
+    void set_member_internal(internal::Object *object, const MemberSlot &slot, const std::string &name,
+                             const ValueRef &value, bool force);
 
   public: // for use by Objects during registration
     void bind_allocator(Allocator alloc);
@@ -2124,6 +2142,7 @@ namespace grt {
     MetaClass();
     void load_xml(xmlNodePtr node);
     void load_attribute_list(xmlNodePtr node, const std::string &member = "");
+    MemberSlot resolve_member_slot(const std::string &member) const;
 
     std::string _name;
     MetaClass *_parent;
@@ -2135,6 +2154,8 @@ namespace grt {
     std::unordered_map<std::string, std::string> _attributes;
     //    std::map<std::string,std::string> _attributes;
     MemberList _members;
+    std::unordered_map<std::string, MemberSlot> _member_slots; //< all members incl. inherited ones, once bound
+    bool _member_slots_built;
     MethodList _methods;
     SignalList _signals;
     ValidatorList _validators;
@@ -2146,6 +2167,7 @@ namespace grt {
 
     bool _watch_lists; //< adds the virtual method that's called when owned lists are changed (watch-lists)
     bool _watch_dicts; //< adds the virtual method that's called when owned dicts are changed (watch-dicts)
+    bool _watch_members; //< adds the virtual method that's called when any member is changed (watch-members)
     bool _force_impl;
     bool _impl_data; //< needs extra data for the object
   };
@@ -2328,6 +2350,56 @@ namespace grt {
     Module *_module;
   };
 
+  /** A module function resolved once and called many times.
+   *
+   * Looking up a function by module and function name searches the module list and the functions of the module
+   * and of the modules it extends. A handle does that on the first call only and keeps the function, it resolves
+   * it again only after modules were registered, refreshed or unregistered.
+   *
+   * @ingroup GRT
+   */
+  class MYSQLGRT_PUBLIC ModuleFunctionHandle {
+  public:
+    ModuleFunctionHandle(const std::string &module, const std::string &function);
+
+    const std::string &module_name() const {
+      return _module_name;
+    }
+    const std::string &function_name() const {
+      return _function_name;
+    }
+
+    // Whether the module and function exist, resolving them if needed.
+    bool is_valid();
+
+    ValueRef call(const BaseListRef &args);
+
+    // Builds the argument list straight from the given values, for calls passing a few objects or values.
+    template <typename... Args>
+    ValueRef operator()(const Args &... args) {
+      BaseListRef list(true);
+      add_args(list, args...);
+      return call(list);
+    }
+
+  private:
+    std::string _module_name;
+    std::string _function_name;
+    Module *_module;
+    std::function<ValueRef(const BaseListRef &)> _call; // A copy, the function list of the module may still grow.
+    size_t _generation;
+
+    void resolve();
+
+    static void add_args(BaseListRef &) {
+    }
+    template <typename Arg, typename... Args>
+    static void add_args(BaseListRef &list, const Arg &arg, const Args &... args) {
+      list.ginsert(arg);
+      add_args(list, args...);
+    }
+  };
+
   //------------------------------------------------------------------------------------------------
   //------------------------------------------------------------------------------------------------
 
@@ -2476,9 +2548,20 @@ namespace grt {
     // serialization
     void serialize(const ValueRef &value, const std::string &path, const std::string &doctype = "",
                    const std::string &version = "", bool list_objects_as_links = false);
+    // Writes the compact binary format instead of XML, unserialize() detects the format when reading.
+    void serialize_binary(const ValueRef &value, const std::string &path, const std::string &doctype = "",
+                          const std::string &version = "", bool list_objects_as_links = false);
     ValueRef unserialize(const std::string &path, std::shared_ptr<grt::internal::Unserializer> unserializer =
                                                     std::shared_ptr<grt::internal::Unserializer>());
     ValueRef unserialize(const std::string &path, std::string &doctype_ret, std::string &version_ret);
+
+    // Binary snapshots of XML files, written next to them to read them faster on the next start. A snapshot is
+    // used only while the file's modification time and size and the checksum of the loaded structs are the ones
+    // it was taken for, load_snapshot() returns an invalid value otherwise.
+    ValueRef load_snapshot(const std::string &path);
+    void save_snapshot(const ValueRef &value, const std::string &path);
+    // Same as unserialize(), but through the snapshot of the file, which is written again when it can't be used.
+    ValueRef unserialize_with_snapshot(const std::string &path);
     std::shared_ptr<grt::internal::Unserializer> get_unserializer();
 
     xmlDocPtr load_xml(const std::string &path);
@@ -2548,6 +2631,11 @@ namespace grt {
 
     Module *get_module(const std::string &name);
 
+    // Changes whenever modules are registered, refreshed or unregistered, so module lookups can be cached.
+    size_t modules_generation() const {
+      return _modules_generation;
+    }
+
     // create an instance of the given native module and registers it with the GRT.
     // this should not be used for accessing modules, use the
     // wrapper class for the module you want, instead (with get_module())
@@ -2709,6 +2797,8 @@ namespace grt {
 
     std::list<ModuleLoader *> _loaders;
     std::vector<Module *> _modules;
+    size_t _modules_generation;
+    std::unordered_map<std::string, ModuleFunctionHandle> _function_handles; // For call_module_function().
     std::map<std::string, Interface *> _interfaces;
     std::map<std::string, ModuleWrapper *> _cached_module_wrapper;
 
@@ -2738,6 +2828,7 @@ namespace grt {
   private:
     GRT();
     GRT(const GRT &) = delete;
+    void load_metaclasses(const std::string &file, xmlDocPtr doc, std::list<std::string> *requires);
     GRT &operator=(GRT &) = delete;
   };
 
@@ -502,6 +502,9 @@ struct ClassImplGenerator {
       fprintf(f, "  virtual void owned_dict_item_removed(grt::internal::OwnedDict *dict, const std::string &key);\n");
     }
 
+    if (gstruct->watch_members())
+      fprintf(f, "  virtual void member_value_changed(const std::string &name, const grt::ValueRef &ovalue);\n");
+
     // signals
     for (MetaClass::SignalList::const_iterator iter = gstruct->get_signals_partial().begin();
          iter != gstruct->get_signals_partial().end(); ++iter) {
@@ -723,6 +726,13 @@ struct ClassImplGenerator {
       fprintf(f, "%s", separator);
     }
 
+    if (gstruct->watch_members()) {
+      fprintf(f, "void %s::member_value_changed(const std::string &name, const grt::ValueRef &ovalue)\n",
+              cname.c_str());
+      fprintf(f, "{\n}\n\n");
+      fprintf(f, "%s", separator);
+    }
+
     // generate methods
     for (std::map<std::string, MetaClass::Method>::const_iterator iter = methods.begin(); iter != methods.end();
          ++iter) {
@@ -185,12 +185,7 @@ bool MetaClass::foreach_validator(const ObjectRef &obj, const Validator::Tag &ta
 }
 
 bool MetaClass::has_member(const std::string &member) const {
-  if (_members.find(member) == _members.end()) {
-    if (_parent)
-      return _parent->has_member(member);
-    return false;
-  }
-  return true;
+  return get_member_slot(member).info != 0;
 }
 
 bool MetaClass::has_method(const std::string &method) const {
@@ -230,6 +225,8 @@ MetaClass::MetaClass() {
   _force_impl = false;
   _watch_lists = false;
   _watch_dicts = false;
+  _watch_members = false;
+  _member_slots_built = false;
 }
 
 MetaClass::~MetaClass() {
@@ -312,6 +309,9 @@ void MetaClass::load_xml(xmlNodePtr node) {
   if (get_prop(node, "watch-dicts") == "1")
     _watch_dicts = true;
 
+  if (get_prop(node, "watch-members") == "1")
+    _watch_members = true;
+
   if (get_prop(node, "impl-data") == "1")
     _impl_data = true;
 
@@ -666,6 +666,7 @@ void MetaClass::bind_member(const std::string &name, PropertyBase *prop) {
     throw std::runtime_error("Attempt to bind invalid member " + name);
 
   iter->second.property = prop;
+  _member_slots_built = false; // The setter to use may have changed, walk the hierarchy until rebuilt.
 }
 
 void MetaClass::bind_method(const std::string &name, Method::Function method) {
@@ -685,60 +686,122 @@ void MetaClass::remove_validator(Validator *v) {
   throw std::logic_error("void MetaClass::del_validator(Validator* v) not implemented!");
 }
 
+/**
+ * Looks up the declarations used to access a member by walking up the class hierarchy.
+ */
+MetaClass::MemberSlot MetaClass::resolve_member_slot(const std::string &member) const {
+  MemberSlot slot = {0, 0, 0};
+  const MetaClass *mc = this;
+  MemberList::const_iterator mem;
+
+  // The most derived declaration describes the member.
+  for (mc = this; mc && !slot.info; mc = mc->_parent) {
+    mem = mc->_members.find(member);
+    if (mem != mc->_members.end())
+      slot.info = &mem->second;
+  }
+  if (!slot.info)
+    return slot;
+
+  // Values are read through the first declaration that doesn't override another one.
+  mc = this;
+  do {
+    mem = mc->_members.find(member);
+    slot.getter = mem != mc->_members.end() ? &mem->second : 0;
+    mc = mc->_parent;
+  } while (mc && (!slot.getter || slot.getter->overrides));
+
+  // And written through the first one with a setter.
+  mc = this;
+  do {
+    mem = mc->_members.find(member);
+    slot.setter = mem != mc->_members.end() ? &mem->second : 0;
+    mc = mc->_parent;
+  } while (mc && (!slot.setter || slot.setter->overrides || !slot.setter->property ||
+                   !slot.setter->property->has_setter()));
+
+  return slot;
+}
+
+/**
+ * Flattens the members of this class and its parents into a single table, so dynamic member access takes
+ * one hash lookup. Must be called again whenever members are added or bound.
+ */
+void MetaClass::build_member_slots() {
+  _member_slots_built = false;
+  _member_slots.clear();
+  for (MetaClass *mc = this; mc; mc = mc->_parent) {
+    for (MemberList::const_iterator mem = mc->_members.begin(); mem != mc->_members.end(); ++mem) {
+      if (_member_slots.find(mem->first) == _member_slots.end())
+        _member_slots[mem->first] = resolve_member_slot(mem->first);
+    }
+  }
+  _member_slots_built = true;
+}
+
+MetaClass::MemberSlot MetaClass::get_member_slot(const std::string &member) const {
+  if (!_member_slots_built)
+    return resolve_member_slot(member);
+
+  std::unordered_map<std::string, MemberSlot>::const_iterator iter = _member_slots.find(member);
+  if (iter == _member_slots.end()) {
+    MemberSlot slot = {0, 0, 0};
+    return slot;
+  }
+  return iter->second;
+}
+
 void MetaClass::set_member_value(internal::Object *object, const std::string &name, const ValueRef &value) {
-  set_member_internal(object, name, value, false);
+  set_member_internal(object, get_member_slot(name), name, value, false);
+}
+
+void MetaClass::set_member_value(internal::Object *object, const MemberSlot &slot, const ValueRef &value) {
+  if (!slot.info)
+    throw bad_item(_name + ".(unknown member)");
+  set_member_internal(object, slot, slot.info->name, value, false);
 }
 
 void MetaClass::set_member_internal(internal::Object *object, const std::string &name, const ValueRef &value,
                                     bool force) {
-  MetaClass *mc = this;
-  MemberList::const_iterator mem, end;
-  bool found = false;
-  do {
-    mem = mc->_members.find(name);
-    end = mc->_members.end();
-
-    if (mem != end)
-      found = true;
-
-    mc = mc->_parent;
-  } while (mc && (mem == end || mem->second.overrides == true || !mem->second.property->has_setter()));
+  set_member_internal(object, get_member_slot(name), name, value, force);
+}
 
-  if (mem == end) {
-    if (found)
+void MetaClass::set_member_internal(internal::Object *object, const MemberSlot &slot, const std::string &name,
+                                    const ValueRef &value, bool force) {
+  if (!slot.setter) {
+    if (slot.info)
       throw grt::read_only_item(_name + "." + name);
     else
       throw bad_item(_name + "." + name);
   }
 
-  if (mem->second.read_only && !force) {
-    if (mem->second.type.base.type == ListType || mem->second.type.base.type == DictType)
+  if (slot.setter->read_only && !force) {
+    if (slot.setter->type.base.type == ListType || slot.setter->type.base.type == DictType)
       throw grt::read_only_item(_name + "." + name + " (which is a container)");
     throw grt::read_only_item(_name + "." + name);
   }
-  mem->second.property->set(object, value);
+  slot.setter->property->set(object, value);
 }
 
 ValueRef MetaClass::get_member_value(const internal::Object *object, const std::string &name) {
-  MetaClass *mc = this;
-  MemberList::const_iterator mem, end;
-  do {
-    mem = mc->_members.find(name);
-    end = mc->_members.end();
-
-    mc = mc->_parent;
-  } while (mc && (mem == end || mem->second.overrides));
-
-  if (mem == end || mem->second.property == NULL)
+  const Member *getter = get_member_slot(name).getter;
+  if (getter == NULL || getter->property == NULL)
     throw bad_item(name);
 
-  return mem->second.property->get(object);
+  return getter->property->get(object);
 }
 
 ValueRef MetaClass::get_member_value(const internal::Object *object, const MetaClass::Member *member) {
   return member->property->get(object);
 }
 
+ValueRef MetaClass::get_member_value(const internal::Object *object, const MemberSlot &slot) {
+  if (slot.getter == NULL || slot.getter->property == NULL)
+    throw bad_item(slot.info ? slot.info->name : std::string("(unknown member)"));
+
+  return slot.getter->property->get(object);
+}
+
 ValueRef MetaClass::call_method(internal::Object *object, const std::string &name, const BaseListRef &args) {
   MetaClass *mc = this;
   MethodList::const_iterator mem, end;
@@ -760,18 +823,7 @@ ValueRef MetaClass::call_method(internal::Object *object, const Method *method,
 }
 
 const MetaClass::Member *MetaClass::get_member_info(const std::string &member) const {
-  const MetaClass *mc = this;
-  MemberList::const_iterator mem, end;
-  do {
-    mem = mc->_members.find(member);
-    end = mc->_members.end();
-
-    mc = mc->_parent;
-  } while (mc && mem == end);
-
-  if (mem == end)
-    return 0;
-  return &mem->second;
+  return get_member_slot(member).info;
 }
 
 const MetaClass::Method *MetaClass::get_method_info(const std::string &method) const {
@@ -27,6 +27,7 @@
 #include "base/string_utilities.h"
 #include "base/file_functions.h"
 #include "base/file_utilities.h"
+#include "base/trace.h"
 
 using namespace grt;
 
@@ -94,6 +95,7 @@ bool Module::has_function(const std::string &name) const {
 }
 
 ValueRef Module::call_function(const std::string &name, const grt::BaseListRef &args) {
+  TRACE_SPAN("grt", "Module::call_function");
   const Function *f = get_function(name);
 
   if (!f)
@@ -102,6 +104,48 @@ ValueRef Module::call_function(const std::string &name, const grt::BaseListRef &
   return f->call(args);
 }
 
+ModuleFunctionHandle::ModuleFunctionHandle(const std::string &module, const std::string &function)
+  : _module_name(module), _function_name(function), _module(nullptr), _generation(0) {
+}
+
+void ModuleFunctionHandle::resolve() {
+  size_t generation = grt::GRT::get()->modules_generation();
+  if (_module && _generation == generation)
+    return;
+
+  _module = nullptr;
+  _call = nullptr;
+
+  Module *module = grt::GRT::get()->get_module(_module_name);
+  if (!module)
+    throw grt::module_error("Module " + _module_name + " not found");
+
+  // get_function() also looks in the modules this one extends.
+  const Module::Function *function = module->get_function(_function_name);
+  if (!function)
+    throw grt::module_error(
+      std::string("Module ").append(_module_name).append(" doesn't have function ").append(_function_name));
+
+  _call = function->call;
+  _module = module;
+  _generation = generation;
+}
+
+bool ModuleFunctionHandle::is_valid() {
+  try {
+    resolve();
+  } catch (grt::module_error &) {
+    return false;
+  }
+  return true;
+}
+
+ValueRef ModuleFunctionHandle::call(const BaseListRef &args) {
+  TRACE_SPAN("grt", "ModuleFunctionHandle::call");
+  resolve();
+  return _call(args);
+}
+
 std::string Module::bundle_path() const {
   return base::dirname(_path);
 }
@@ -35,6 +35,10 @@ DEFAULT_LOG_DOMAIN("ModulePython");
 using namespace grt;
 using namespace base;
 
+// Bumped whenever the layout of the module cache entries changes, older caches are then ignored.
+static const int MODULE_CACHE_VERSION = 1;
+static const char *MODULE_CACHE_DOCTYPE = "PythonModuleCache";
+
 PythonModule::PythonModule(PythonModuleLoader *loader, PyObject *module) : Module(loader), _module(module) {
 }
 
@@ -42,6 +46,44 @@ PythonModule::~PythonModule() {
   Py_XDECREF(_module);
 }
 
+/**
+ * Calls a function of a module registered from the module cache, importing the module the first time.
+ * The plugin list is returned from the cache, plugins can be listed without importing their module.
+ */
+ValueRef PythonModule::call_cached_function(const BaseListRef &args, const Function &funcdef) {
+  if (funcdef.name == "getPluginInfo" && _plugin_info.is_valid())
+    return _plugin_info;
+
+  WillEnterPython lock;
+
+  if (!_module) {
+    logDebug("Importing cached Python module %s\n", _path.c_str());
+    _module = ((PythonModuleLoader *)get_loader())->import_module(_path);
+    if (!_module)
+      throw grt::module_error(strfmt("Error importing Python module %s", _path.c_str()));
+
+    PyObject *moduleInfo = PyDict_GetItemString(PyModule_GetDict(_module), "ModuleInfo");
+    PyObject *functions = moduleInfo ? PyObject_GetAttrString(moduleInfo, "functions") : NULL;
+    if (functions && PyList_Check(functions)) {
+      for (Py_ssize_t c = PyList_Size(functions), i = 0; i < c; i++) {
+        const char *name = 0;
+        PyObject *rettype, *argtypes, *callable;
+
+        if (PyArg_ParseTuple(PyList_GetItem(functions, i), "z(OO)O", &name, &rettype, &argtypes, &callable) && name)
+          _callables[name] = callable;
+      }
+    }
+    Py_XDECREF(functions);
+    PyErr_Clear();
+  }
+
+  std::map<std::string, PyObject *>::const_iterator callable = _callables.find(funcdef.name);
+  if (callable == _callables.end())
+    throw grt::module_error(strfmt("Python module %s has no function %s", _name.c_str(), funcdef.name.c_str()));
+
+  return call_python_function(args, callable->second, funcdef);
+}
+
 static TypeSpec parse_type(PyObject *type) {
   if (PyString_Check(type)) {
     TypeSpec s;
@@ -236,7 +278,8 @@ ValueRef PythonModule::call_python_function(const BaseListRef &args, PyObject *f
   return result;
 }
 
-PythonModuleLoader::PythonModuleLoader(const std::string &module_path) : _pycontext(module_path) {
+PythonModuleLoader::PythonModuleLoader(const std::string &module_path)
+  : _pycontext(module_path), _module_cache_changed(false) {
 }
 
 PythonModuleLoader::~PythonModuleLoader() {
@@ -286,7 +329,7 @@ static std::string handlePyError() {
   return result;
 }
 
-Module *PythonModuleLoader::init_module(const std::string &path) {
+PyObject *PythonModuleLoader::import_module(const std::string &path) {
   PyObject *mod;
   std::string name;
 
@@ -324,6 +367,19 @@ Module *PythonModuleLoader::init_module(const std::string &path) {
       return 0;
     }
   }
+  return mod;
+}
+
+Module *PythonModuleLoader::init_module(const std::string &path) {
+  Module *cached = init_cached_module(path);
+  if (cached)
+    return cached;
+
+  WillEnterPython lock;
+
+  PyObject *mod = import_module(path);
+  if (mod == NULL)
+    return 0;
 
   {
     PyObject *module_dict = PyModule_GetDict(mod);
@@ -430,12 +486,206 @@ Module *PythonModuleLoader::init_module(const std::string &path) {
       if (g_str_has_suffix(base::dirname(path).c_str(), ".mwbplugin"))
         module->_is_bundle = true;
     }
+
+    cache_module(module);
     return module;
   }
 
   return 0;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool file_stamp(const std::string &path, long &mtime, long &size) {
+#ifdef _WIN32
+  struct _stat stbuf;
+#else
+  struct stat stbuf;
+#endif
+
+  if (base_stat(path.c_str(), &stbuf) != 0)
+    return false;
+  mtime = (long)stbuf.st_mtime;
+  size = (long)stbuf.st_size;
+  return true;
+}
+
+static DictRef type_spec_to_dict(const TypeSpec &type) {
+  DictRef dict(true);
+  dict.gset("type", type_to_str(type.base.type));
+  dict.gset("class", type.base.object_class);
+  dict.gset("contentType", type_to_str(type.content.type));
+  dict.gset("contentClass", type.content.object_class);
+  return dict;
+}
+
+static TypeSpec type_spec_from_dict(const DictRef &dict) {
+  TypeSpec type;
+  type.base.type = str_to_type(dict.get_string("type"));
+  type.base.object_class = dict.get_string("class");
+  type.content.type = str_to_type(dict.get_string("contentType"));
+  type.content.object_class = dict.get_string("contentClass");
+  return type;
+}
+
+void PythonModuleLoader::set_module_cache_path(const std::string &path) {
+  _module_cache_path = path;
+  _module_cache = DictRef(true);
+  _module_cache_changed = false;
+
+  if (!g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
+    return;
+
+  try {
+    std::string doctype, version;
+    ValueRef cache = grt::GRT::get()->unserialize(path, doctype, version);
+    if (doctype == MODULE_CACHE_DOCTYPE && version == std::to_string(MODULE_CACHE_VERSION) &&
+        DictRef::can_wrap(cache))
+      _module_cache = DictRef::cast_from(cache);
+  } catch (std::exception &exc) {
+    logWarning("Ignoring Python module cache %s: %s\n", path.c_str(), exc.what());
+  }
+}
+
+void PythonModuleLoader::save_module_cache() {
+  if (_module_cache_path.empty() || !_module_cache_changed)
+    return;
+
+  // Drop the entries of modules that were removed.
+  std::vector<std::string> paths = _module_cache.keys();
+  for (std::vector<std::string>::const_iterator path = paths.begin(); path != paths.end(); ++path) {
+    if (!g_file_test(path->c_str(), G_FILE_TEST_EXISTS))
+      _module_cache.remove(*path);
+  }
+
+  try {
+    base::create_directory(base::dirname(_module_cache_path), 0700, true);
+    grt::GRT::get()->serialize_binary(_module_cache, _module_cache_path, MODULE_CACHE_DOCTYPE,
+                                      std::to_string(MODULE_CACHE_VERSION));
+    _module_cache_changed = false;
+  } catch (std::exception &exc) {
+    logWarning("Could not save Python module cache %s: %s\n", _module_cache_path.c_str(), exc.what());
+  }
+}
+
+/**
+ * Registers a module from its cache entry, if the file didn't change since it was cached. The module is imported
+ * when one of its functions is called.
+ */
+Module *PythonModuleLoader::init_cached_module(const std::string &path) {
+  if (!_module_cache.is_valid() || !_module_cache.has_key(path))
+    return 0;
+
+  DictRef entry = DictRef::cast_from(_module_cache.get(path));
+  long mtime, size;
+  if (!file_stamp(path, mtime, size) || entry.get_int("mtime") != mtime || entry.get_int("size") != size)
+    return 0;
+
+  PythonModule *module = new PythonModule(this, NULL);
+  try {
+    module->_path = path;
+    module->_name = entry.get_string("name");
+    module->_meta_author = entry.get_string("author");
+    module->_meta_version = entry.get_string("version");
+    module->_meta_description = entry.get_string("description");
+    module->_is_bundle = entry.get_int("isBundle") != 0;
+
+    StringListRef interfaces = StringListRef::cast_from(entry.get("interfaces"));
+    for (StringListRef::const_iterator iter = interfaces.begin(); iter != interfaces.end(); ++iter)
+      module->_interfaces.push_back(*iter);
+
+    BaseListRef functions = BaseListRef::cast_from(entry.get("functions"));
+    for (size_t c = functions.count(), i = 0; i < c; i++) {
+      DictRef fdict = DictRef::cast_from(functions[i]);
+      Module::Function func;
+
+      func.name = fdict.get_string("name");
+      func.description = fdict.get_string("description");
+      func.ret_type = type_spec_from_dict(DictRef::cast_from(fdict.get("returnType")));
+
+      BaseListRef arguments = BaseListRef::cast_from(fdict.get("arguments"));
+      for (size_t d = arguments.count(), j = 0; j < d; j++) {
+        DictRef adict = DictRef::cast_from(arguments[j]);
+        ArgSpec arg;
+        arg.name = adict.get_string("name");
+        arg.type = type_spec_from_dict(DictRef::cast_from(adict.get("type")));
+        func.arg_types.push_back(arg);
+      }
+
+      func.call = std::bind(&PythonModule::call_cached_function, module, std::placeholders::_1, func);
+      module->add_function(func);
+    }
+
+    module->_plugin_info = entry.get("pluginInfo");
+  } catch (std::exception &exc) {
+    logWarning("Invalid Python module cache entry for %s: %s\n", path.c_str(), exc.what());
+    delete module;
+    return 0;
+  }
+
+  return module;
+}
+
+/**
+ * Stores the description of a just imported module in the cache. The plugin list of plugin modules is fetched
+ * here too, so the next start can register the plugins without importing the module.
+ */
+void PythonModuleLoader::cache_module(PythonModule *module) {
+  long mtime, size;
+  if (_module_cache_path.empty() || !file_stamp(module->_path, mtime, size))
+    return;
+
+  DictRef entry(true);
+  entry.gset("mtime", mtime);
+  entry.gset("size", size);
+  entry.gset("name", module->_name);
+  entry.gset("author", module->_meta_author);
+  entry.gset("version", module->_meta_version);
+  entry.gset("description", module->_meta_description);
+  entry.gset("isBundle", module->_is_bundle ? 1 : 0);
+
+  StringListRef interfaces(grt::Initialized);
+  for (Module::Interfaces::const_iterator iter = module->_interfaces.begin(); iter != module->_interfaces.end();
+       ++iter)
+    interfaces.insert(*iter);
+  entry.set("interfaces", interfaces);
+
+  BaseListRef functions(true);
+  for (std::vector<Module::Function>::const_iterator func = module->_functions.begin();
+       func != module->_functions.end(); ++func) {
+    DictRef fdict(true);
+    fdict.gset("name", func->name);
+    fdict.gset("description", func->description);
+    fdict.set("returnType", type_spec_to_dict(func->ret_type));
+
+    BaseListRef arguments(true);
+    for (ArgSpecList::const_iterator arg = func->arg_types.begin(); arg != func->arg_types.end(); ++arg) {
+      DictRef adict(true);
+      adict.gset("name", arg->name);
+      adict.set("type", type_spec_to_dict(arg->type));
+      arguments.ginsert(adict);
+    }
+    fdict.set("arguments", arguments);
+    functions.ginsert(fdict);
+  }
+  entry.set("functions", functions);
+
+  const Module::Function *plugin_info = module->get_function("getPluginInfo");
+  if (plugin_info && plugin_info->arg_types.empty()) {
+    try {
+      module->_plugin_info = module->call_function("getPluginInfo", BaseListRef());
+      entry.set("pluginInfo", module->_plugin_info);
+    } catch (std::exception &) {
+      // Not cached, the plugin manager will report the error when it calls getPluginInfo itself.
+      module->_plugin_info.clear();
+      return;
+    }
+  }
+
+  _module_cache.set(module->_path, entry);
+  _module_cache_changed = true;
+}
+
 void PythonModuleLoader::refresh() {
   _pycontext.refresh();
 }
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "python_context.h"
+#include <map>
 #include <string>
 #include "grt.h"
 
@@ -41,9 +42,12 @@ namespace grt {
     void add_parse_function(const std::string &name, PyObject *return_type, PyObject *arguments, PyObject *callable);
 
   protected:
-    PyObject *_module;
+    PyObject *_module; // NULL for modules registered from the module cache until one of their functions is called.
+    std::map<std::string, PyObject *> _callables;
+    ValueRef _plugin_info; // getPluginInfo() result, kept in the module cache.
 
     virtual ValueRef call_python_function(const BaseListRef &args, PyObject *function, const Function &funcdef);
+    ValueRef call_cached_function(const BaseListRef &args, const Function &funcdef);
   };
 
   class MYSQLGRT_PUBLIC PythonModuleLoader : public ModuleLoader {
@@ -71,9 +75,22 @@ namespace grt {
       return &_pycontext;
     }
 
+    // Modules not changed since they were described in the cache file are registered from it and imported only
+    // when one of their functions is called.
+    void set_module_cache_path(const std::string &path);
+    void save_module_cache();
+
   protected:
     friend class PythonModule;
 
     PythonContext _pycontext;
+
+    std::string _module_cache_path;
+    DictRef _module_cache;
+    bool _module_cache_changed;
+
+    PyObject *import_module(const std::string &path);
+    Module *init_cached_module(const std::string &path);
+    void cache_module(PythonModule *module);
   };
 };
@@ -22,9 +22,15 @@
  */
 
 #include "grtpp_notifications.h"
+#include "base/log.h"
+
+DEFAULT_LOG_DOMAIN("notifications")
 
 using namespace grt;
 
+GRTNotificationCenter::GRTNotificationCenter() : _main_thread(g_thread_self()), _batch_level(0) {
+}
+
 void GRTNotificationCenter::setup() {
   base::NotificationCenter::set_instance(new GRTNotificationCenter());
 }
@@ -60,6 +66,50 @@ void GRTNotificationCenter::send_grt(const std::string &name, ObjectRef sender,
   if (name.substr(0, 3) != "GRN")
     throw std::invalid_argument("Attempt to send GRT notification with a name that doesn't start with GRN");
 
+  if (_batch_level > 0 && name.find("Will") == std::string::npos) {
+    // Without info the same notification from the same sender carries nothing new, so only the first is kept.
+    if (!info.is_valid() || info.count() == 0) {
+      if (!_pending_keys.insert(name + "\n" + (sender.is_valid() ? sender.id() : "")).second)
+        return;
+    }
+
+    PendingNotification pending;
+    pending.name = name;
+    pending.sender = sender;
+    pending.info = info;
+    _pending.push_back(pending);
+    return;
+  }
+
+  deliver(name, sender, info);
+}
+
+bool GRTNotificationCenter::begin_batch() {
+  if (g_thread_self() != _main_thread)
+    return false;
+  ++_batch_level;
+  return true;
+}
+
+void GRTNotificationCenter::end_batch() {
+  if (_batch_level == 0 || --_batch_level > 0)
+    return;
+
+  // Observers may send new notifications, those are delivered right away as the batch is closed.
+  std::list<PendingNotification> pending;
+  pending.swap(_pending);
+  _pending_keys.clear();
+
+  for (std::list<PendingNotification>::iterator iter = pending.begin(); iter != pending.end(); ++iter) {
+    try {
+      deliver(iter->name, iter->sender, iter->info);
+    } catch (std::exception &exc) {
+      logError("Error delivering queued notification %s: %s\n", iter->name.c_str(), exc.what());
+    }
+  }
+}
+
+void GRTNotificationCenter::deliver(const std::string &name, ObjectRef sender, DictRef info) {
   // act on a copy of the observer list, because one of them could remove stuff from the list
   std::list<GRTObserverEntry> copy(_grt_observers);
   for (std::list<GRTObserverEntry>::iterator iter = copy.begin(); iter != copy.end(); ++iter) {
@@ -69,3 +119,15 @@ void GRTNotificationCenter::send_grt(const std::string &name, ObjectRef sender,
     }
   }
 }
+
+NotificationBatch::NotificationBatch() : _active(false) {
+  GRTNotificationCenter *center = GRTNotificationCenter::get();
+  if (center)
+    _active = center->begin_batch();
+}
+
+NotificationBatch::~NotificationBatch() {
+  GRTNotificationCenter *center = GRTNotificationCenter::get();
+  if (_active && center)
+    center->end_batch();
+}
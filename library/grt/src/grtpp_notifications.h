@@ -26,6 +26,8 @@
 #include "grt.h"
 #include "base/notifications.h"
 
+#include <set>
+
 namespace grt {
   class MYSQLGRT_PUBLIC GRTObserver : public base::Observer {
   protected:
@@ -47,9 +49,24 @@ namespace grt {
       std::string observed_object_id;
     };
 
+    struct PendingNotification {
+      std::string name;
+      ObjectRef sender;
+      DictRef info;
+    };
+
     std::list<GRTObserverEntry> _grt_observers;
 
+    GThread *_main_thread;
+    int _batch_level;
+    std::list<PendingNotification> _pending;
+    std::set<std::string> _pending_keys; // name and sender id of queued notifications without info
+
+    void deliver(const std::string &name, ObjectRef sender, DictRef info);
+
   public:
+    GRTNotificationCenter();
+
     static GRTNotificationCenter *get();
 
     void add_grt_observer(GRTObserver *observer, const std::string &name = "", ObjectRef object = ObjectRef());
@@ -58,7 +75,25 @@ namespace grt {
     // must be called from main thread only
     void send_grt(const std::string &name, ObjectRef sender, DictRef info);
 
+    // Notifications sent between begin_batch() and end_batch() are queued, with duplicates dropped, and delivered
+    // when the outermost batch ends. "Will" notifications announce something about to happen and are never queued.
+    // Batches are only opened on the main thread, begin_batch() returns false anywhere else.
+    bool begin_batch();
+    void end_batch();
+    bool in_batch() const {
+      return _batch_level > 0;
+    }
+
   public:
     static void setup();
   };
+
+  // Scope in which GRT notifications are coalesced. Undo groups and undo/redo open one automatically.
+  struct MYSQLGRT_PUBLIC NotificationBatch {
+    NotificationBatch();
+    ~NotificationBatch();
+
+  private:
+    bool _active;
+  };
 };
@@ -24,7 +24,9 @@
 #include "base/log.h"
 
 #include "grtpp_undo_manager.h"
+#include "grtpp_notifications.h"
 #include "base/string_utilities.h"
+#include "base/mem_stat.h"
 
 #include <iostream>
 #include <time.h>
@@ -104,6 +106,28 @@ static std::string member_for_object_dict(const ObjectRef &object, const DictRef
   return name;
 }
 
+/** Estimated memory used by a value kept by an undo action. Only the value itself is counted, as the contents
+ * of containers and objects are usually still referenced from elsewhere.
+ */
+static size_t value_memory_size(const ValueRef &value) {
+  if (!value.is_valid())
+    return 0;
+
+  switch (value.type()) {
+    case StringType:
+      return sizeof(internal::String) + (**static_cast<internal::String *>(value.valueptr())).size();
+    case ListType:
+      return sizeof(internal::List) + BaseListRef::cast_from(value).count() * sizeof(ValueRef);
+    case DictType:
+      return sizeof(internal::Dict) + DictRef::cast_from(value).count() * (sizeof(ValueRef) + sizeof(std::string));
+    case ObjectType:
+      return sizeof(internal::Object) +
+             ObjectRef::cast_from(value).get_metaclass()->get_members_partial().size() * sizeof(ValueRef);
+    default:
+      return sizeof(internal::Double);
+  }
+}
+
 //---------------------------------------------------------------------------------------------------
 
 void UndoAction::set_description(const std::string &description) {
@@ -151,6 +175,10 @@ void UndoObjectChangeAction::dump(std::ostream &out, int indent) const {
       << "> ->" << new_value << ": " << description() << std::endl;
 }
 
+size_t UndoObjectChangeAction::memory_size() const {
+  return sizeof(*this) + _member.size() + value_memory_size(_value);
+}
+
 //---------------------------------------------------------------------------------------------------
 
 UndoListInsertAction::UndoListInsertAction(const BaseListRef &list, size_t index) : _list(list), _index(index) {
@@ -258,6 +286,10 @@ void UndoListSetAction::dump(std::ostream &out, int indent) const {
   out << ": " << description() << std::endl;
 }
 
+size_t UndoListSetAction::memory_size() const {
+  return sizeof(*this) + value_memory_size(_value);
+}
+
 //---------------------------------------------------------------------------------------------------
 
 UndoListRemoveAction::UndoListRemoveAction(const BaseListRef &list, const ValueRef &value)
@@ -301,6 +333,10 @@ void UndoListRemoveAction::dump(std::ostream &out, int indent) const {
   out << ": " << description() << std::endl;
 }
 
+size_t UndoListRemoveAction::memory_size() const {
+  return sizeof(*this) + value_memory_size(_value);
+}
+
 //---------------------------------------------------------------------------------------------------
 
 UndoDictSetAction::UndoDictSetAction(const DictRef &dict, const std::string &key) : _dict(dict), _key(key) {
@@ -339,6 +375,10 @@ void UndoDictSetAction::dump(std::ostream &out, int indent) const {
   out << ": " << description() << std::endl;
 }
 
+size_t UndoDictSetAction::memory_size() const {
+  return sizeof(*this) + _key.size() + value_memory_size(_value);
+}
+
 //---------------------------------------------------------------------------------------------------
 
 UndoDictRemoveAction::UndoDictRemoveAction(const DictRef &dict, const std::string &key) : _dict(dict), _key(key) {
@@ -376,6 +416,10 @@ void UndoDictRemoveAction::dump(std::ostream &out, int indent) const {
   out << ": " << description() << std::endl;
 }
 
+size_t UndoDictRemoveAction::memory_size() const {
+  return sizeof(*this) + _key.size() + value_memory_size(_value);
+}
+
 //---------------------------------------------------------------------------------------------------
 
 UndoGroup::UndoGroup() {
@@ -445,14 +489,25 @@ void UndoGroup::close() {
     g_warning("trying to close already closed undo group");
 }
 
-void UndoGroup::add(UndoAction *op) {
-  // add the action to the topmost open undo group
+/** Adds the action to the topmost open undo group.
+ *
+ * Only the first change of an object member is kept in a group, as undoing it restores the member
+ * to its value before the group. Later changes of the same member are deleted and false is returned.
+ */
+bool UndoGroup::add(UndoAction *op) {
   UndoGroup *subgroup = get_deepest_open_subgroup();
 
-  if (subgroup)
-    subgroup->_actions.push_back(op);
-  else
+  if (!subgroup)
     throw std::logic_error("trying to add an action to a closed undo group");
+
+  UndoObjectChangeAction *change = dynamic_cast<UndoObjectChangeAction *>(op);
+  if (change &&
+      !subgroup->_changed_members.insert(std::make_pair(change->get_object().valueptr(), change->get_member())).second) {
+    delete op;
+    return false;
+  }
+  subgroup->_actions.push_back(op);
+  return true;
 }
 
 bool UndoGroup::empty() const {
@@ -486,6 +541,13 @@ std::string UndoGroup::description() const {
   return UndoAction::description();
 }
 
+size_t UndoGroup::memory_size() const {
+  size_t size = sizeof(*this);
+  for (std::list<UndoAction *>::const_iterator iter = _actions.begin(); iter != _actions.end(); ++iter)
+    size += (*iter)->memory_size();
+  return size;
+}
+
 void UndoGroup::dump(std::ostream &out, int indent) const {
   out << strfmt("%*s group%s { ", indent, "", _is_open ? "(open)" : "") << std::endl;
   for (std::list<UndoAction *>::const_iterator iter = _actions.begin(); iter != _actions.end(); ++iter) {
@@ -501,10 +563,20 @@ UndoManager::UndoManager() {
   _is_undoing = false;
   _is_redoing = false;
   _undo_limit = 0;
+  _undo_memory_limit = 0;
+  _undo_memory_size = 0;
   _blocks = 0;
+
+  // The size is the estimate also used for the memory limit, it only covers the undo stack.
+  _memory_source = base::MemoryAccounting::add_source("Undo history", [this](base::MemoryAccounting::Usage &usage) {
+    base::RecMutexLock lock(_mutex);
+    usage.bytes = (std::int64_t)_undo_memory_size;
+    usage.items = (std::int64_t)(_undo_stack.size() + _redo_stack.size());
+  });
 }
 
 UndoManager::~UndoManager() {
+  base::MemoryAccounting::remove_source(_memory_source);
   _changed_signal.disconnect_all_slots(); // prevent emission in reset()
   reset();
 }
@@ -548,13 +620,32 @@ void UndoManager::set_undo_limit(size_t limit) {
   trim_undo_stack();
 }
 
+void UndoManager::set_undo_memory_limit(size_t limit) {
+  _undo_memory_limit = limit;
+
+  trim_undo_stack();
+}
+
+/** Drops the oldest undo entries beyond the step limit and the memory limit. The newest entry is always kept,
+ * as it may be an undo group that is still open.
+ */
 void UndoManager::trim_undo_stack() {
   lock();
-  if (_undo_limit > 0)
-    _undo_stack.erase(_undo_stack.begin(), _undo_stack.begin() + std::max(0, (int)(_undo_stack.size() - _undo_limit)));
+  while (_undo_stack.size() > 1 && ((_undo_limit > 0 && _undo_stack.size() > _undo_limit) ||
+                                    (_undo_memory_limit > 0 && _undo_memory_size > _undo_memory_limit))) {
+    UndoAction *action = _undo_stack.front();
+    _undo_stack.pop_front();
+    undo_stack_released(action);
+    delete action;
+  }
   unlock();
 }
 
+// Must be called for every action taken off the undo stack, to keep the memory accounting in sync.
+void UndoManager::undo_stack_released(UndoAction *action) {
+  _undo_memory_size -= std::min(_undo_memory_size, action->memory_size());
+}
+
 bool UndoManager::can_undo() const {
   lock();
   bool empty = _undo_stack.empty();
@@ -629,6 +720,7 @@ void UndoManager::reset() {
   for (std::deque<UndoAction *>::iterator iter = _undo_stack.begin(); iter != _undo_stack.end(); ++iter)
     delete *iter;
   _undo_stack.clear();
+  _undo_memory_size = 0;
 
   for (std::deque<UndoAction *>::iterator iter = _redo_stack.begin(); iter != _redo_stack.end(); ++iter)
     delete *iter;
@@ -688,6 +780,8 @@ bool UndoManager::end_undo_group(const std::string &description, bool trim) {
 
   if (group->empty()) {
     stack->pop_back();
+    if (stack == &_undo_stack)
+      undo_stack_released(group);
     delete group;
     if (getenv("DEBUG_UNDO"))
       g_message("undo group '%s' was empty, so it was deleted", description.c_str());
@@ -758,6 +852,8 @@ void UndoManager::cancel_undo_group() {
 
       lock();
       // if this was the top-level undo group, delete it from the stack
+      if (stack == &_undo_stack)
+        undo_stack_released(subgroup);
       if (subgroup == group) {
         stack->pop_back();
         delete group;
@@ -809,6 +905,8 @@ void UndoManager::undo() {
 
   lock();
   if (can_undo()) {
+    // Replaying a group sends the notifications of all its actions, they are delivered together at the end.
+    NotificationBatch batch;
     UndoAction *cmd = _undo_stack.back();
     _is_undoing = true;
     unlock();
@@ -823,6 +921,7 @@ void UndoManager::undo() {
     _is_undoing = false;
 
     _undo_stack.pop_back();
+    undo_stack_released(cmd);
     unlock();
 
     _undo_signal(cmd);
@@ -838,6 +937,7 @@ void UndoManager::redo() {
 
   lock();
   if (can_redo()) {
+    NotificationBatch batch;
     UndoAction *cmd = _redo_stack.back();
     _is_redoing = true;
     unlock();
@@ -858,6 +958,8 @@ void UndoManager::redo() {
 }
 
 void UndoManager::add_undo(UndoAction *cmd) {
+  _action_added_signal(cmd);
+
   if (_blocks > 0) {
     delete cmd;
     return;
@@ -880,16 +982,19 @@ void UndoManager::add_undo(UndoAction *cmd) {
     if (!_undo_stack.empty()) {
       UndoGroup *group = dynamic_cast<UndoGroup *>(_undo_stack.back());
       if (group && group->is_open()) {
-        group->add(cmd);
+        size_t size = cmd->memory_size();
+        if (group->add(cmd))
+          _undo_memory_size += size;
         flag = true;
       }
     }
     if (!flag) {
       if (debug_undo && !dynamic_cast<UndoGroup *>(cmd))
         logDebug2("added undo action that's not a group to top");
+      _undo_memory_size += cmd->memory_size();
       _undo_stack.push_back(cmd);
-      trim_undo_stack();
     }
+    trim_undo_stack();
 
     // if we're not undoing neither redoing, then reset the redo stack
     if (!_is_redoing) {
@@ -921,17 +1026,18 @@ void UndoManager::dump_redo_stack() {
 
 //----------------- AutoUndo -------------------------------------------------------------------------------------------
 
-AutoUndo::AutoUndo(bool noop) {
+AutoUndo::AutoUndo(bool noop) : _batched(false) {
   _valid = true;
   if (!noop)
     group = grt::GRT::get()->begin_undoable_action();
   else
     group = nullptr;
+  begin_batch();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-AutoUndo::AutoUndo(UndoGroup *use_group, bool noop) : group(nullptr) {
+AutoUndo::AutoUndo(UndoGroup *use_group, bool noop) : group(nullptr), _batched(false) {
   _valid = true;
   if (noop) {
     delete use_group;
@@ -950,6 +1056,7 @@ AutoUndo::AutoUndo(UndoGroup *use_group, bool noop) : group(nullptr) {
     if (use_group != nullptr)
       group = grt::GRT::get()->begin_undoable_action(use_group);
   }
+  begin_batch();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -987,6 +1094,7 @@ void AutoUndo::cancel() {
     if (group != nullptr)
       grt::GRT::get()->cancel_undoable_action();
     _valid = false;
+    end_batch();
   } else
     throw std::logic_error("Trying to cancel an already finished undo action");
 }
@@ -1003,6 +1111,7 @@ void AutoUndo::end_or_cancel_if_empty(const std::string &descr) {
     else
       grt::GRT::get()->cancel_undoable_action();
     _valid = false;
+    end_batch();
   } else
     throw std::logic_error("Trying to end an already finished undo action");
 }
@@ -1012,8 +1121,26 @@ void AutoUndo::end(const std::string &descr) {
     if (group != nullptr)
       grt::GRT::get()->end_undoable_action(descr);
     _valid = false;
+    end_batch();
   } else
     throw std::logic_error("Trying to end an already finished undo action");
 }
 
 //----------------------------------------------------------------------------------------------------------------------
+
+void AutoUndo::begin_batch() {
+  GRTNotificationCenter *center = GRTNotificationCenter::get();
+  if (group != nullptr && center)
+    _batched = center->begin_batch();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void AutoUndo::end_batch() {
+  GRTNotificationCenter *center = GRTNotificationCenter::get();
+  if (_batched && center)
+    center->end_batch();
+  _batched = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
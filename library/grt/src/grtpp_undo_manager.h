@@ -26,6 +26,7 @@
 #include "grt.h"
 
 #include <deque>
+#include <set>
 #include <boost/signals2.hpp>
 #include <ostream>
 
@@ -47,6 +48,11 @@ namespace grt {
     }
 
     virtual void dump(std::ostream &out, int indent = 0) const = 0;
+
+    // Estimated number of bytes kept alive by this action, used for the memory limit of the undo stack.
+    virtual size_t memory_size() const {
+      return sizeof(*this);
+    }
   };
 
   class MYSQLGRT_PUBLIC SimpleUndoAction : public UndoAction {
@@ -84,6 +90,7 @@ namespace grt {
     }
 
     virtual void dump(std::ostream &out, int indent = 0) const;
+    virtual size_t memory_size() const;
   };
 
   class MYSQLGRT_PUBLIC UndoListInsertAction : public UndoAction {
@@ -95,6 +102,10 @@ namespace grt {
 
     virtual void undo(UndoManager *owner);
 
+    const BaseListRef &get_list() const {
+      return _list;
+    }
+
     virtual void dump(std::ostream &out, int indent = 0) const;
   };
 
@@ -108,7 +119,12 @@ namespace grt {
 
     virtual void undo(UndoManager *owner);
 
+    const BaseListRef &get_list() const {
+      return _list;
+    }
+
     virtual void dump(std::ostream &out, int indent = 0) const;
+    virtual size_t memory_size() const;
   };
 
   class MYSQLGRT_PUBLIC UndoListReorderAction : public UndoAction {
@@ -120,6 +136,10 @@ namespace grt {
     UndoListReorderAction(const BaseListRef &list, size_t oindex, size_t nindex);
 
     virtual void undo(UndoManager *owner);
+
+    const BaseListRef &get_list() const {
+      return _list;
+    }
     virtual void dump(std::ostream &out, int indent = 0) const;
   };
 
@@ -133,7 +153,12 @@ namespace grt {
     UndoListRemoveAction(const BaseListRef &list, size_t index);
 
     virtual void undo(UndoManager *owner);
+
+    const BaseListRef &get_list() const {
+      return _list;
+    }
     virtual void dump(std::ostream &out, int indent = 0) const;
+    virtual size_t memory_size() const;
   };
 
   class MYSQLGRT_PUBLIC UndoDictSetAction : public UndoAction {
@@ -146,7 +171,12 @@ namespace grt {
     UndoDictSetAction(const DictRef &dict, const std::string &key);
 
     virtual void undo(UndoManager *owner);
+
+    const DictRef &get_dict() const {
+      return _dict;
+    }
     virtual void dump(std::ostream &out, int indent = 0) const;
+    virtual size_t memory_size() const;
   };
 
   class MYSQLGRT_PUBLIC UndoDictRemoveAction : public UndoAction {
@@ -159,11 +189,18 @@ namespace grt {
     UndoDictRemoveAction(const DictRef &dict, const std::string &key);
 
     virtual void undo(UndoManager *owner);
+
+    const DictRef &get_dict() const {
+      return _dict;
+    }
     virtual void dump(std::ostream &out, int indent = 0) const;
+    virtual size_t memory_size() const;
   };
 
   class MYSQLGRT_PUBLIC UndoGroup : public UndoAction {
     std::list<UndoAction *> _actions;
+    // Object members already changed by a direct action of this group, see add().
+    std::set<std::pair<internal::Value *, std::string> > _changed_members;
     bool _is_open;
 
   public:
@@ -182,8 +219,9 @@ namespace grt {
     virtual void undo(UndoManager *owner);
 
     virtual void dump(std::ostream &out, int indent = 0) const;
+    virtual size_t memory_size() const;
 
-    void add(UndoAction *op);
+    bool add(UndoAction *op);
     bool empty() const;
 
     virtual bool matches_group(UndoGroup *group) const {
@@ -219,6 +257,15 @@ namespace grt {
       return _undo_limit;
     }
 
+    // Maximal estimated size in bytes of the undo stack, the oldest entries are dropped beyond it. 0 means no limit.
+    void set_undo_memory_limit(size_t limit);
+    size_t get_undo_memory_limit() const {
+      return _undo_memory_limit;
+    }
+    size_t get_undo_memory_size() const {
+      return _undo_memory_size;
+    }
+
     void disable();
     void enable();
     bool is_enabled() const {
@@ -264,6 +311,11 @@ namespace grt {
       return &_changed_signal;
     }
 
+    // Emitted for every action passed to add_undo(), also while undo is disabled or an undo/redo runs.
+    UndoSignal *signal_action_added() {
+      return &_action_added_signal;
+    }
+
     void dump_undo_stack();
     void dump_redo_stack();
 
@@ -285,16 +337,21 @@ namespace grt {
     std::deque<UndoAction *> _redo_stack;
 
     size_t _undo_limit;
+    size_t _undo_memory_limit;
+    size_t _undo_memory_size;
 
     int _blocks;
     bool _is_undoing;
     bool _is_redoing;
+    int _memory_source;
 
     UndoSignal _undo_signal;
     RedoSignal _redo_signal;
     boost::signals2::signal<void()> _changed_signal;
+    UndoSignal _action_added_signal;
 
     void trim_undo_stack();
+    void undo_stack_released(UndoAction *action);
   };
 
   struct MYSQLGRT_PUBLIC AutoUndo {
@@ -313,5 +370,9 @@ namespace grt {
 
   private:
     bool _valid;
+    bool _batched; // Notifications are coalesced until the group is closed.
+
+    void begin_batch();
+    void end_batch();
   };
 };
@@ -228,6 +228,33 @@ namespace grt {
     virtual ~Omf(){};
     virtual bool less(const ValueRef &, const ValueRef &) const = 0;
     virtual bool equal(const ValueRef &, const ValueRef &) const = 0;
+
+    // Computes a key that is the same for all values equal() to each other, so list items can be matched through
+    // a hash index. Returns false if no such key exists for the value, which makes the list be matched pairwise.
+    virtual bool match_key(const ValueRef &value, std::string &key) const {
+      return false;
+    }
+
+    // Whether the items matched between the lists may be diffed concurrently.
+    virtual bool diff_items_in_parallel(const BaseListRef &list) const {
+      return false;
+    }
+
+    // Whether the objects are already known to be equal, so their members don't need to be compared.
+    virtual bool known_equal(const ObjectRef &source, const ObjectRef &target) const {
+      return false;
+    }
+
+  protected:
+    // Match key for values compared with ValueRef::operator==.
+    static void identity_match_key(const ValueRef &value, std::string &key) {
+      if (!value.is_valid())
+        key = "0";
+      else if (is_simple_type(value.type()))
+        key = base::strfmt("%i:", (int)value.type()).append(value.toString());
+      else
+        key = base::strfmt("p:%p", value.valueptr());
+    }
   };
 
   struct default_omf : public Omf {
@@ -257,6 +284,14 @@ namespace grt {
     virtual bool equal(const ValueRef &l, const ValueRef &r) const {
       return peq(l, r);
     };
+
+    virtual bool match_key(const ValueRef &value, std::string &key) const {
+      if (value.type() == ObjectType && ObjectRef::can_wrap(value) && ObjectRef::cast_from(value)->has_member("name"))
+        key = "n:" + ObjectRef::cast_from(value)->get_string_member("name");
+      else
+        identity_match_key(value, key);
+      return true;
+    }
   };
 
   MYSQLGRT_PUBLIC
@@ -23,12 +23,16 @@
 
 #include "base/string_utilities.h"
 #include "base/threading.h"
+#include "base/mem_stat.h"
 
 #include "grt.h"
 #include "grtpp_util.h"
 #include "grtpp_undo_manager.h"
 
 #include <glib.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #ifdef GRT_LEAK_DETECTOR_ENABLED
 #include <iostream>
@@ -81,6 +85,151 @@ ClassRegistry* ClassRegistry::get_instance() {
 
 //--------------------------------------------------------------------------------------------------
 
+#ifndef GRT_VALUE_POOL_DISABLED
+
+/**
+ * Catalogs are made of many small objects, lists and dicts which are created and freed in bulk
+ * (loading a model, reverse engineering, diffing). Instead of going through malloc for each of them
+ * values are carved from 64KB chunks and kept in freelists per 16 byte size class. Every thread owns
+ * its freelists and hands them back to a shared pool when it ends. The memory is reused, but never
+ * returned to the system.
+ */
+namespace {
+  const size_t PoolGranularity = 16;
+  const size_t PoolMaxBlockSize = 1024;
+  const size_t PoolSizeClasses = PoolMaxBlockSize / PoolGranularity;
+  const size_t PoolChunkSize = 64 * 1024;
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  struct SharedPool {
+    std::mutex mutex;
+    FreeBlock *free_blocks[PoolSizeClasses];
+
+    SharedPool() {
+      std::fill(free_blocks, free_blocks + PoolSizeClasses, nullptr);
+    }
+  };
+
+  SharedPool &shared_pool() {
+    // Never destroyed, values can still be released while static objects are destroyed.
+    static SharedPool *pool = new SharedPool();
+    return *pool;
+  }
+
+  thread_local FreeBlock *thread_free_blocks[PoolSizeClasses];
+  thread_local bool thread_pool_registered = false;
+  thread_local bool thread_pool_exited = false;
+
+  // Takes all free blocks of the shared pool for the given size class, allocating a new chunk if there are none.
+  FreeBlock *take_shared_blocks(size_t size_class) {
+    SharedPool &pool = shared_pool();
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      FreeBlock *blocks = pool.free_blocks[size_class];
+      if (blocks != nullptr) {
+        pool.free_blocks[size_class] = nullptr;
+        return blocks;
+      }
+    }
+
+    size_t block_size = (size_class + 1) * PoolGranularity;
+    size_t count = PoolChunkSize / block_size;
+    char *chunk = static_cast<char *>(::operator new(count * block_size));
+    for (size_t i = 0; i < count; ++i)
+      reinterpret_cast<FreeBlock *>(chunk + i * block_size)->next =
+        i + 1 < count ? reinterpret_cast<FreeBlock *>(chunk + (i + 1) * block_size) : nullptr;
+    return reinterpret_cast<FreeBlock *>(chunk);
+  }
+
+  void return_shared_blocks(size_t size_class, FreeBlock *blocks) {
+    if (blocks == nullptr)
+      return;
+
+    FreeBlock *last = blocks;
+    while (last->next != nullptr)
+      last = last->next;
+
+    SharedPool &pool = shared_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    last->next = pool.free_blocks[size_class];
+    pool.free_blocks[size_class] = blocks;
+  }
+
+  // Hands the freelists of an ending thread back to the shared pool.
+  struct ThreadPoolReturner {
+    ~ThreadPoolReturner() {
+      for (size_t i = 0; i < PoolSizeClasses; ++i) {
+        return_shared_blocks(i, thread_free_blocks[i]);
+        thread_free_blocks[i] = nullptr;
+      }
+      thread_pool_exited = true;
+    }
+  };
+
+  thread_local ThreadPoolReturner thread_pool_returner;
+
+  inline void register_thread_pool() {
+    if (!thread_pool_registered) {
+      thread_pool_registered = true;
+      (void)&thread_pool_returner; // Constructs the returner, so its destructor runs when the thread ends.
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void *Value::operator new(size_t size) {
+  if (size == 0 || size > PoolMaxBlockSize)
+    return ::operator new(size);
+
+  size_t size_class = (size - 1) / PoolGranularity;
+  if (thread_pool_exited) {
+    // Values created while thread locals are destroyed go through the shared pool directly.
+    FreeBlock *block = take_shared_blocks(size_class);
+    return_shared_blocks(size_class, block->next);
+    return block;
+  }
+
+  FreeBlock *block = thread_free_blocks[size_class];
+  if (block == nullptr) {
+    register_thread_pool();
+    block = take_shared_blocks(size_class);
+  }
+  thread_free_blocks[size_class] = block->next;
+  return block;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Value::operator delete(void *ptr, size_t size) {
+  if (ptr == nullptr)
+    return;
+
+  if (size == 0 || size > PoolMaxBlockSize) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  size_t size_class = (size - 1) / PoolGranularity;
+  FreeBlock *block = static_cast<FreeBlock *>(ptr);
+  if (thread_pool_exited) {
+    block->next = nullptr;
+    return_shared_blocks(size_class, block);
+    return;
+  }
+
+  register_thread_pool();
+  block->next = thread_free_blocks[size_class];
+  thread_free_blocks[size_class] = block;
+}
+
+#endif
+
+//--------------------------------------------------------------------------------------------------
+
 std::string Integer::debugDescription(const std::string& indentation) const {
   // Simple values don't use indentation as they are always on a RHS.
   return toString();
@@ -773,6 +922,13 @@ namespace grt {
 
 //--------------------------------------------------------------------------------------------------
 
+// Objects don't know the size of their members, so only their number is reported.
+static std::atomic<std::int64_t> live_object_count(0);
+static int object_memory_source =
+  base::MemoryAccounting::add_source("GRT objects", [](base::MemoryAccounting::Usage& usage) {
+    usage.items = live_object_count;
+  });
+
 Object::Object(MetaClass* metaclass)
   : _metaclass(metaclass) //, _valid_flag(true)
 {
@@ -781,16 +937,18 @@ Object::Object(MetaClass* metaclass)
 
   _id = get_guid();
   _is_global = 0;
+  ++live_object_count;
 #ifdef GRT_LEAK_DETECTOR_ENABLED
   ObjectLeakDetector::get_detector()->register_obj(this);
 #endif
 }
 
-#ifdef GRT_LEAK_DETECTOR_ENABLED
 Object::~Object() {
+  --live_object_count;
+#ifdef GRT_LEAK_DETECTOR_ENABLED
   ObjectLeakDetector::get_detector()->unregister_obj(this);
-}
 #endif
+}
 
 const std::string& Object::id() const {
   return _id;
@@ -936,7 +1094,7 @@ void Object::__set_id(const std::string& id) {
   _id = id;
 }
 
-bool process_reset_references_for_member(const MetaClass::Member* m, Object* obj) {
+bool process_reset_references_for_member(const MetaClass::Member* m, Object* obj, Object::ChangedSignal* signal) {
   if (m && !m->calculated && !grt::is_simple_type(m->type.base.type)) {
     // g_log("grt", G_LOG_LEVEL_DEBUG, "\tprocess_reset_references_for_member'%s':'%s':'%s'", obj->class_name().c_str(),
     // obj->id().c_str(), m->name.c_str());
@@ -946,7 +1104,8 @@ bool process_reset_references_for_member(const MetaClass::Member* m, Object* obj
       if (m->owned_object)
         member_value.valueptr()->reset_references();
 
-      obj->signal_changed()->disconnect_all_slots();
+      if (signal != nullptr)
+        signal->disconnect_all_slots();
       // set the member value to null
       obj->get_metaclass()->set_member_internal(obj, m->name, grt::ValueRef(), true);
     }
@@ -956,7 +1115,8 @@ bool process_reset_references_for_member(const MetaClass::Member* m, Object* obj
 
 void Object::reset_references() {
   // g_log("grt", G_LOG_LEVEL_DEBUG, "Object::reset_references for '%s':'%s'", class_name().c_str(), id().c_str());
-  _metaclass->foreach_member(std::bind(&process_reset_references_for_member, std::placeholders::_1, this));
+  _metaclass->foreach_member(
+    std::bind(&process_reset_references_for_member, std::placeholders::_1, this, _changed_signal.get()));
 }
 
 void Object::init() {
@@ -1011,29 +1171,37 @@ void Object::owned_member_changed(const std::string& name, const grt::ValueRef&
     if (grt::GRT::get()->tracking_changes())
       grt::GRT::get()->get_undo_manager()->add_undo(new UndoObjectChangeAction(this, name, ovalue));
   }
-  _changed_signal(name, ovalue);
+  member_value_changed(name, ovalue);
+  if (_changed_signal)
+    (*_changed_signal)(name, ovalue);
 }
 
 void Object::member_changed(const std::string& name, const grt::ValueRef& ovalue, const grt::ValueRef& nvalue) {
   if (_is_global && grt::GRT::get()->tracking_changes())
     grt::GRT::get()->get_undo_manager()->add_undo(new UndoObjectChangeAction(this, name, ovalue));
-  _changed_signal(name, ovalue);
+  member_value_changed(name, ovalue);
+  if (_changed_signal)
+    (*_changed_signal)(name, ovalue);
 }
 
 void Object::owned_list_item_added(OwnedList* list, const grt::ValueRef& value) {
-  _list_changed_signal(list, true, value);
+  if (_list_changed_signal)
+    (*_list_changed_signal)(list, true, value);
 }
 
 void Object::owned_list_item_removed(OwnedList* list, const grt::ValueRef& value) {
-  _list_changed_signal(list, false, value);
+  if (_list_changed_signal)
+    (*_list_changed_signal)(list, false, value);
 }
 
 void Object::owned_dict_item_set(OwnedDict* dict, const std::string& key) {
-  _dict_changed_signal(dict, true, key);
+  if (_dict_changed_signal)
+    (*_dict_changed_signal)(dict, true, key);
 }
 
 void Object::owned_dict_item_removed(OwnedDict* dict, const std::string& key) {
-  _dict_changed_signal(dict, false, key);
+  if (_dict_changed_signal)
+    (*_dict_changed_signal)(dict, false, key);
 }
 
 #ifdef USE_EXPRERIMENTAL_REFS
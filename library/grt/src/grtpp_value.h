@@ -31,6 +31,7 @@ typedef int ssize_t;
 #endif
 #endif
 
+#include <memory>
 #include <boost/signals2.hpp>
 #include "base/threading.h"
 
@@ -39,6 +40,9 @@ typedef int ssize_t;
 //#define GRT_LEAK_DETECTOR_RECORD_CALL_STACK
 #endif
 
+// Uncomment to allocate values with the global operator new (e.g. when running under valgrind).
+//#define GRT_VALUE_POOL_DISABLED
+
 namespace grt {
   class GRT;
   class MetaClass;
@@ -167,6 +171,12 @@ namespace grt {
       virtual void reset_references() {
       }
 
+#ifndef GRT_VALUE_POOL_DISABLED
+      // Values are taken from per thread freelists of fixed size blocks.
+      static void *operator new(size_t size);
+      static void operator delete(void *ptr, size_t size);
+#endif
+
     protected:
       Value() : _refcount(0) {
       }
@@ -538,14 +548,25 @@ namespace grt {
         return _is_global != 0;
       }
 
-      boost::signals2::signal<void(const std::string &, const ValueRef &)> *signal_changed() {
-        return &_changed_signal;
+      typedef boost::signals2::signal<void(const std::string &, const ValueRef &)> ChangedSignal;
+      typedef boost::signals2::signal<void(OwnedList *, bool, const grt::ValueRef &)> ListChangedSignal;
+      typedef boost::signals2::signal<void(OwnedDict *, bool, const std::string &)> DictChangedSignal;
+
+      // The signals are only allocated when first asked for, as most objects never get a subscriber.
+      ChangedSignal *signal_changed() {
+        if (!_changed_signal)
+          _changed_signal.reset(new ChangedSignal());
+        return _changed_signal.get();
       }
-      boost::signals2::signal<void(OwnedList *, bool, const grt::ValueRef &)> *signal_list_changed() {
-        return &_list_changed_signal;
+      ListChangedSignal *signal_list_changed() {
+        if (!_list_changed_signal)
+          _list_changed_signal.reset(new ListChangedSignal());
+        return _list_changed_signal.get();
       }
-      boost::signals2::signal<void(OwnedDict *, bool, const std::string &)> *signal_dict_changed() {
-        return &_dict_changed_signal;
+      DictChangedSignal *signal_dict_changed() {
+        if (!_dict_changed_signal)
+          _dict_changed_signal.reset(new DictChangedSignal());
+        return _dict_changed_signal.get();
       }
 
       virtual void reset_references();
@@ -565,13 +586,16 @@ namespace grt {
       friend class internal::Unserializer;
 
       explicit Object(MetaClass *gclass);
-#ifdef GRT_LEAK_DETECTOR_ENABLED
       virtual ~Object();
-#endif
 
       void owned_member_changed(const std::string &name, const grt::ValueRef &ovalue, const grt::ValueRef &nvalue);
       void member_changed(const std::string &name, const grt::ValueRef &ovalue, const grt::ValueRef &nvalue);
 
+      // Called on every member change before signal_changed() is emitted (watch-members). Use this instead of
+      // connecting to the own signal in classes with many instances, which would allocate it for each of them.
+      virtual void member_value_changed(const std::string &name, const grt::ValueRef &ovalue) {
+      }
+
       virtual void owned_list_item_added(OwnedList *list, const grt::ValueRef &value);
       virtual void owned_list_item_removed(OwnedList *list, const grt::ValueRef &value);
 
@@ -580,9 +604,9 @@ namespace grt {
 
       MetaClass *_metaclass;
       std::string _id;
-      boost::signals2::signal<void(const std::string &, const grt::ValueRef &)> _changed_signal;
-      boost::signals2::signal<void(OwnedList *, bool, const grt::ValueRef &)> _list_changed_signal;
-      boost::signals2::signal<void(OwnedDict *, bool, const std::string &)> _dict_changed_signal;
+      std::unique_ptr<ChangedSignal> _changed_signal;
+      std::unique_ptr<ListChangedSignal> _list_changed_signal;
+      std::unique_ptr<DictChangedSignal> _dict_changed_signal;
 
       // ObjectValidFlag _valid_flag;
 
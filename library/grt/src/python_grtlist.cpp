@@ -117,6 +117,48 @@ static PyObject *list_item(PyGRTListObject *self, Py_ssize_t index) {
   }
 }
 
+/**
+ * L[i:j] returns the items as a native Python list. The items are converted in one call, so L[:] is the cheap way
+ * to iterate a whole list, and the copy is not affected when the GRT list changes while the script goes through it.
+ */
+static PyObject *list_slice(PyGRTListObject *self, Py_ssize_t low, Py_ssize_t high) {
+  PythonContext *ctx;
+
+  if (!(ctx = PythonContext::get_and_check()))
+    return NULL;
+
+  // Negative indexes were already adjusted by the interpreter, only clamping is left.
+  Py_ssize_t count = (Py_ssize_t)self->list->count();
+  if (low < 0)
+    low = 0;
+  else if (low > count)
+    low = count;
+  if (high < low)
+    high = low;
+  else if (high > count)
+    high = count;
+
+  PyObject *items = PyList_New(high - low);
+  if (!items)
+    return NULL;
+
+  try {
+    for (Py_ssize_t i = low; i < high; ++i) {
+      PyObject *item = ctx->from_grt(self->list->get(i));
+      if (!item) {
+        Py_DECREF(items);
+        return NULL;
+      }
+      PyList_SET_ITEM(items, i - low, item);
+    }
+  } catch (std::exception &exc) {
+    Py_DECREF(items);
+    PyErr_SetString(PyExc_RuntimeError, exc.what());
+    return NULL;
+  }
+  return items;
+}
+
 static int list_assign(PyGRTListObject *self, Py_ssize_t index, PyObject *value) {
   PythonContext *ctx = PythonContext::get_and_check();
   if (!ctx)
@@ -331,7 +373,7 @@ static PySequenceMethods PyGRTListObject_as_sequence = {
   0,                            // binaryfunc sq_concat;
   0,                            // ssizeargfunc sq_repeat;
   (ssizeargfunc)list_item,      // ssizeargfunc sq_item;
-  0,                            //(ssizessizeargfunc)list_slice, // ssizessizeargfunc sq_slice;
+  (ssizessizeargfunc)list_slice, // ssizessizeargfunc sq_slice;
   (ssizeobjargproc)list_assign, // ssizeobjargproc sq_ass_item;
   0,                            ///(ssizessizeobjargproc)list_assign_slice,// ssizessizeobjargproc sq_ass_slice;
   (objobjproc)list_contains,    // objobjproc sq_contains;
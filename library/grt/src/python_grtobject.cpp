@@ -270,12 +270,18 @@ static PyObject *object_getattro(PyGRTObjectObject *self, PyObject *attr_name) {
     else if (strcmp(attrname, "__id__") == 0)
       return Py_BuildValue("s", self->object->id().c_str());
     else {
-      if (self->object->has_member(attrname)) {
+      grt::MetaClass::MemberSlot slot = self->object->get_metaclass()->get_member_slot(attrname);
+      if (slot.info) {
         PythonContext *ctx = PythonContext::get_and_check();
         if (!ctx)
           return NULL;
 
-        return ctx->from_grt(self->object->get_member(attrname));
+        try {
+          return ctx->from_grt(self->object->get_metaclass()->get_member_value(&self->object->content(), slot));
+        } catch (const std::exception &exc) {
+          PythonContext::set_python_error(exc);
+          return NULL;
+        }
       } else if (self->object->has_method(attrname)) {
         // create a method call object and return it
         PyGRTMethodObject *method = (PyGRTMethodObject *)PyType_GenericNew(&PyGRTMethodObjectType, NULL, NULL);
@@ -297,34 +303,33 @@ static int object_setattro(PyGRTObjectObject *self, PyObject *attr_name, PyObjec
   if (PyString_Check(attr_name)) {
     const char *attrname = PyString_AsString(attr_name);
 
-    if (self->object->has_member(attrname)) {
+    grt::MetaClass::MemberSlot slot = self->object->get_metaclass()->get_member_slot(attrname);
+    if (slot.info) {
       PythonContext *ctx = PythonContext::get_and_check();
       if (!ctx)
         return -1;
-      const grt::MetaClass::Member *member = self->object->get_metaclass()->get_member_info(attrname);
-      if (member) {
-        grt::ValueRef value;
+      const grt::MetaClass::Member *member = slot.info;
+      grt::ValueRef value;
 
-        if (member->read_only) {
-          PyErr_Format(PyExc_TypeError, "%s is read-only", attrname);
-          return -1;
-        }
+      if (member->read_only) {
+        PyErr_Format(PyExc_TypeError, "%s is read-only", attrname);
+        return -1;
+      }
 
-        try {
-          value = ctx->from_pyobject(attr_value, member->type);
-        } catch (const std::exception &exc) {
-          PythonContext::set_python_error(exc);
-          return -1;
-        }
+      try {
+        value = ctx->from_pyobject(attr_value, member->type);
+      } catch (const std::exception &exc) {
+        PythonContext::set_python_error(exc);
+        return -1;
+      }
 
-        try {
-          self->object->set_member(attrname, value);
-        } catch (const std::exception &exc) {
-          PythonContext::set_python_error(exc);
-          return -1;
-        }
-        return 0;
+      try {
+        self->object->get_metaclass()->set_member_value(&self->object->content(), slot, value);
+      } catch (const std::exception &exc) {
+        PythonContext::set_python_error(exc);
+        return -1;
       }
+      return 0;
     }
 
     PyErr_Format(PyExc_AttributeError, "unknown attribute '%s'", attrname);
@@ -371,6 +376,127 @@ static PyObject *object_deep_copy(PyGRTObjectObject *self, void *nothing) {
   return ctx->from_grt(grt::copy_object(*self->object));
 }
 
+/**
+ * Reads the members named in the given sequence, or all members if none is given, into a dict. Scripts that look
+ * at many members of an object use this instead of one attribute lookup per member.
+ */
+static PyObject *object_get_member_values(PyGRTObjectObject *self, PyObject *args) {
+  PyObject *names = NULL;
+  if (!PyArg_ParseTuple(args, "|O:__getmembers__", &names))
+    return NULL;
+
+  PythonContext *ctx = PythonContext::get_and_check();
+  if (!ctx)
+    return NULL;
+
+  grt::MetaClass *meta = self->object->get_metaclass();
+  std::vector<std::string> member_names;
+  if (names && names != Py_None) {
+    PyObject *sequence = PySequence_Fast(names, "argument must be a sequence of member names");
+    if (!sequence)
+      return NULL;
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); ++i) {
+      PyObject *name = PySequence_Fast_GET_ITEM(sequence, i);
+      if (!PyString_Check(name)) {
+        Py_DECREF(sequence);
+        PyErr_SetString(PyExc_TypeError, "member names must be strings");
+        return NULL;
+      }
+      member_names.push_back(PyString_AsString(name));
+    }
+    Py_DECREF(sequence);
+  } else
+    meta->foreach_member([&member_names](const grt::MetaClass::Member *member) {
+      member_names.push_back(member->name);
+      return true;
+    });
+
+  PyObject *values = PyDict_New();
+  for (const std::string &name : member_names) {
+    grt::MetaClass::MemberSlot slot = meta->get_member_slot(name);
+    if (!slot.info) {
+      Py_DECREF(values);
+      PyErr_Format(PyExc_AttributeError, "unknown attribute '%s'", name.c_str());
+      return NULL;
+    }
+
+    PyObject *value;
+    try {
+      value = ctx->from_grt(meta->get_member_value(&self->object->content(), slot));
+    } catch (const std::exception &exc) {
+      Py_DECREF(values);
+      PythonContext::set_python_error(exc);
+      return NULL;
+    }
+    if (!value) {
+      Py_DECREF(values);
+      return NULL;
+    }
+    PyDict_SetItemString(values, name.c_str(), value);
+    Py_DECREF(value);
+  }
+  return values;
+}
+
+/**
+ * Sets several members from a dict or a sequence of (name, value) pairs. All values are converted and checked
+ * before the first one is set, so a wrong name or value type leaves the object unchanged.
+ */
+static PyObject *object_set_member_values(PyGRTObjectObject *self, PyObject *values) {
+  PythonContext *ctx = PythonContext::get_and_check();
+  if (!ctx)
+    return NULL;
+
+  PyObject *items = PyDict_Check(values) ? PyDict_Items(values)
+                                         : PySequence_Fast(values, "argument must be a dict or a sequence of pairs");
+  if (!items)
+    return NULL;
+
+  grt::MetaClass *meta = self->object->get_metaclass();
+  std::vector<std::pair<grt::MetaClass::MemberSlot, grt::ValueRef> > changes;
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(items); ++i) {
+    PyObject *item = PySequence_Fast_GET_ITEM(items, i);
+    const char *name;
+    PyObject *value;
+    if (!PyTuple_Check(item) || !PyArg_ParseTuple(item, "sO:__setmembers__", &name, &value)) {
+      if (!PyErr_Occurred())
+        PyErr_SetString(PyExc_TypeError, "items must be (name, value) pairs");
+      Py_DECREF(items);
+      return NULL;
+    }
+
+    grt::MetaClass::MemberSlot slot = meta->get_member_slot(name);
+    if (!slot.info) {
+      PyErr_Format(PyExc_AttributeError, "unknown attribute '%s'", name);
+      Py_DECREF(items);
+      return NULL;
+    }
+    if (slot.info->read_only) {
+      PyErr_Format(PyExc_TypeError, "%s is read-only", name);
+      Py_DECREF(items);
+      return NULL;
+    }
+
+    try {
+      changes.push_back(std::make_pair(slot, ctx->from_pyobject(value, slot.info->type)));
+    } catch (const std::exception &exc) {
+      PythonContext::set_python_error(exc);
+      Py_DECREF(items);
+      return NULL;
+    }
+  }
+  Py_DECREF(items);
+
+  try {
+    for (auto &change : changes)
+      meta->set_member_value(&self->object->content(), change.first, change.second);
+  } catch (const std::exception &exc) {
+    PythonContext::set_python_error(exc);
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
 static PyObject *object_get_doc(PyGRTObjectObject *self, void *closure) {
   return Py_BuildValue("s", self->object->get_metaclass()->get_attribute("description").c_str());
 }
@@ -410,9 +536,13 @@ Creates a new instance of a GRT object. grtclass specifies the name of\n\
 the GRT class of the object.");
 
 PyDoc_STRVAR(call_doc, "callmethod(method_name, ...) -> value");
+PyDoc_STRVAR(getmembers_doc, "__getmembers__([names]) -> dict of member values, all members if no names are given");
+PyDoc_STRVAR(setmembers_doc, "__setmembers__(values) -- set the members in a dict or sequence of (name, value) pairs");
 
 static PyMethodDef PyGRTObjectMethods[] = {
   {"__callmethod__", (PyCFunction)object_callmethod, METH_VARARGS, call_doc},
+  {"__getmembers__", (PyCFunction)object_get_member_values, METH_VARARGS, getmembers_doc},
+  {"__setmembers__", (PyCFunction)object_set_member_values, METH_O, setmembers_doc},
   {"reset_references", (PyCFunction)object_reset_references, METH_NOARGS, NULL},
   {"deep_copy", (PyCFunction)object_deep_copy, METH_NOARGS, NULL},
   {"shallow_copy", (PyCFunction)object_shallow_copy, METH_NOARGS, NULL},
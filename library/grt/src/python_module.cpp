@@ -86,7 +86,8 @@ static PyObject *function_call(PyGRTFunctionObject *self, PyObject *args, PyObje
     {
       WillLeavePython lock;
 
-      result = self->module->call_function(self->function->name, grtargs);
+      // The function was already looked up when it was taken from the module, no need to search it again by name.
+      result = self->function->call(grtargs);
     }
     PyObject *pyresult = ctx->from_grt(result);
 
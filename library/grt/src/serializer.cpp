@@ -29,6 +29,7 @@
 #include <libxml/parser.h>
 
 #include <glib.h>
+#include <cstring>
 
 #include "base/log.h"
 #include "base/file_functions.h"
@@ -344,3 +345,202 @@ std::string internal::Serializer::serialize_to_xmldata(const ValueRef &value, co
   } else
     return "";
 }
+
+static void write_varint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((char)((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char)value);
+}
+
+static void write_string(std::string &out, const std::string &str) {
+  write_varint(out, str.size());
+  out.append(str);
+}
+
+void internal::Serializer::write_interned(std::string &out, const std::string &str) {
+  std::map<std::string, size_t>::const_iterator iter = _binary_strings.find(str);
+  if (iter != _binary_strings.end()) {
+    write_varint(out, iter->second + 1);
+    return;
+  }
+
+  size_t index = _binary_strings.size();
+  _binary_strings[str] = index;
+  write_varint(out, 0);
+  write_string(out, str);
+}
+
+/**
+ * Binary counterpart of serialize_value(), with the same rules for writing objects as links.
+ */
+void internal::Serializer::write_binary_value(std::string &out, const ValueRef &value, bool list_objects_as_links) {
+  switch (value.type()) {
+    case IntegerType: {
+      int64_t i = *IntegerRef::cast_from(value);
+      out.push_back(BinaryInteger);
+      write_varint(out, ((uint64_t)i << 1) ^ (uint64_t)(i >> 63));
+      break;
+    }
+
+    case DoubleType: {
+      double d = *DoubleRef::cast_from(value);
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      out.push_back(BinaryDouble);
+      for (int i = 0; i < 8; i++, bits >>= 8)
+        out.push_back((char)(bits & 0xff));
+      break;
+    }
+
+    case StringType:
+      out.push_back(BinaryString);
+      write_string(out, *StringRef::cast_from(value));
+      break;
+
+    case ListType: {
+      BaseListRef list(BaseListRef::cast_from(value));
+
+      std::map<void *, size_t>::const_iterator iter = _binary_containers.find(list.valueptr());
+      if (iter != _binary_containers.end()) {
+        out.push_back(BinaryContainerLink);
+        write_varint(out, iter->second);
+        break;
+      }
+      size_t index = _binary_containers.size();
+      _binary_containers[list.valueptr()] = index;
+
+      out.push_back(BinaryList);
+      out.push_back((char)list.content_type());
+      write_interned(out, list.content_class_name());
+      write_varint(out, list.count());
+
+      for (size_t c = list.count(), i = 0; i < c; i++) {
+        ValueRef cvalue(list.get(i));
+
+        if (list_objects_as_links && cvalue.is_valid() && cvalue.type() == ObjectType) {
+          out.push_back(BinaryObjectLink);
+          write_interned(out, ObjectRef::cast_from(cvalue)->id());
+        } else
+          write_binary_value(out, cvalue, false);
+      }
+      break;
+    }
+
+    case DictType: {
+      DictRef dict(DictRef::cast_from(value));
+
+      std::map<void *, size_t>::const_iterator iter = _binary_containers.find(dict.valueptr());
+      if (iter != _binary_containers.end()) {
+        out.push_back(BinaryContainerLink);
+        write_varint(out, iter->second);
+        break;
+      }
+      size_t index = _binary_containers.size();
+      _binary_containers[dict.valueptr()] = index;
+
+      size_t count = 0;
+      for (Dict::const_iterator item = dict.begin(); item != dict.end(); ++item) {
+        if (item->second.is_valid())
+          count++;
+      }
+
+      out.push_back(BinaryDict);
+      out.push_back((char)dict.content_type());
+      write_interned(out, dict.content_class_name());
+      write_varint(out, count);
+
+      for (Dict::const_iterator item = dict.begin(); item != dict.end(); ++item) {
+        if (item->second.is_valid()) {
+          write_interned(out, item->first);
+          write_binary_value(out, item->second, false);
+        }
+      }
+      break;
+    }
+
+    case ObjectType: {
+      ObjectRef object(ObjectRef::cast_from(value));
+
+      if (seen(object)) {
+        out.push_back(BinaryObjectLink);
+        write_interned(out, object->id());
+      } else
+        write_binary_object(out, object);
+      break;
+    }
+
+    default:
+      out.push_back(BinaryNull);
+      break;
+  }
+}
+
+void internal::Serializer::write_binary_object(std::string &out, const ObjectRef &object) {
+  MetaClass *meta = object.get_metaclass();
+
+  out.push_back(BinaryObject);
+  write_interned(out, object.class_name());
+  write_interned(out, object->id());
+  write_varint(out, meta->crc32());
+
+  std::vector<std::pair<const MetaClass::Member *, ValueRef> > members;
+  meta->foreach_member([&](const MetaClass::Member *member) {
+    if (!member->calculated) {
+      ValueRef v(object->get_member(member->name));
+      if (v.is_valid())
+        members.push_back(std::make_pair(member, v));
+    }
+    return true;
+  });
+
+  write_varint(out, members.size());
+  for (size_t i = 0; i < members.size(); i++) {
+    const MetaClass::Member *member = members[i].first;
+    const ValueRef &v = members[i].second;
+
+    write_interned(out, member->name);
+    if (!member->owned_object && v.type() == ObjectType) {
+      out.push_back(BinaryObjectLink);
+      write_interned(out, ObjectRef::cast_from(v)->id());
+    } else
+      write_binary_value(out, v, !member->owned_object);
+  }
+}
+
+std::string internal::Serializer::serialize_to_binary(const ValueRef &value, const std::string &doctype,
+                                                      const std::string &docversion, bool list_objects_as_links) {
+  std::string out(GRT_BINARY_MAGIC);
+
+  out.push_back(GRT_BINARY_FORMAT_VERSION);
+  write_string(out, doctype);
+  write_string(out, docversion);
+  write_binary_value(out, value, list_objects_as_links);
+
+  return out;
+}
+
+/**
+ * Stores a GRT value to a file in the binary format, to be read back with GRT::unserialize().
+ * Like save_to_xml() an existing file is only replaced once the new data was written completely.
+ */
+void internal::Serializer::save_to_binary(const ValueRef &value, const std::string &path, const std::string &doctype,
+                                          const std::string &docversion, bool list_objects_as_links) {
+  std::string data = serialize_to_binary(value, doctype, docversion, list_objects_as_links);
+  std::string temp_path = path + ".tmp";
+
+  FILE *file = base_fopen(temp_path.c_str(), "wb");
+  if (file == NULL)
+    throw std::runtime_error("Could not save binary data to file " + path);
+
+  size_t written = fwrite(data.data(), 1, data.size(), file);
+  if (fclose(file) != 0 || written != data.size()) {
+    base_remove(temp_path);
+    throw std::runtime_error("Could not save binary data to file " + path);
+  }
+
+  base_remove(path);
+  if (base_rename(temp_path.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Could not save binary data to file " + path);
+}
@@ -29,6 +29,32 @@
 
 namespace grt {
   namespace internal {
+    /** Binary encoding of GRT values, a compact alternative to the XML format for data that doesn't need to be
+        read by other tools (e.g. auto-saved documents). The layout is:
+
+        file := "GRTB" u8(format version) string(document type) string(document version) value
+        value := u8(tag) payload, with the payload depending on the tag (see BinaryTag)
+
+        Numbers are stored as LEB128 varints (integers zig-zag encoded), strings as varint length + bytes.
+        Struct names, member names, dict keys and object ids are interned: varint 0 is followed by a new string
+        that gets the next index in the table, any other value n refers to table entry n - 1. Lists and dicts
+        are numbered in the order they are written, so that repeated containers can refer to the first copy. */
+    enum BinaryTag {
+      BinaryNull = 0,
+      BinaryInteger,       // zig-zag varint
+      BinaryDouble,        // 8 bytes, little endian IEEE 754
+      BinaryString,        // string
+      BinaryList,          // u8 content type, interned content struct, varint count, values
+      BinaryDict,          // u8 content type, interned content struct, varint count, [interned key, value]...
+      BinaryObject,        // interned struct name, interned id, varint checksum, varint count,
+                           //   [interned member name, value]...
+      BinaryObjectLink,    // interned id
+      BinaryContainerLink  // varint container index
+    };
+
+#define GRT_BINARY_MAGIC "GRTB"
+#define GRT_BINARY_FORMAT_VERSION 1
+
     class Serializer {
     public:
       Serializer();
@@ -42,8 +68,20 @@ namespace grt {
       std::string serialize_to_xmldata(const ValueRef &value, const std::string &type, const std::string &version,
                                        bool list_objects_as_links);
 
+      void save_to_binary(const ValueRef &value, const std::string &path, const std::string &doctype = "",
+                          const std::string &docversion = "", bool list_objects_as_links = false);
+
+      std::string serialize_to_binary(const ValueRef &value, const std::string &doctype,
+                                      const std::string &docversion, bool list_objects_as_links);
+
     protected:
       std::set<void *> _cache;
+      std::map<std::string, size_t> _binary_strings;
+      std::map<void *, size_t> _binary_containers;
+
+      void write_binary_value(std::string &out, const ValueRef &value, bool list_objects_as_links);
+      void write_binary_object(std::string &out, const ObjectRef &object);
+      void write_interned(std::string &out, const std::string &str);
 
       xmlNodePtr serialize_value(const ValueRef &value, xmlNodePtr parent, bool owned_objects);
       xmlNodePtr serialize_object(const Ref<Object> &object, xmlNodePtr parent);
@@ -24,11 +24,17 @@
 #include "unserializer.h"
 
 #include "grtpp_util.h"
+#include "serializer.h"
 
 #include "base/string_utilities.h"
 #include "base/log.h"
+#include "base/file_functions.h"
+#include "base/file_utilities.h"
 #include "base/xml_functions.h"
 
+#include <glib.h>
+#include <cstring>
+
 DEFAULT_LOG_DOMAIN(DOMAIN_GRT)
 
 using namespace grt;
@@ -45,19 +51,430 @@ ValueRef internal::Unserializer::find_cached(const std::string &id) {
   return iter->second;
 }
 
+// State of an element that is currently open in the streaming reader.
+struct internal::Unserializer::StreamFrame {
+  enum Kind { Root, Value, Link, Null, Ignored };
+
+  Kind kind;
+  Type type;
+  ValueRef value;
+  std::string key;
+  std::string text;
+  std::string link_type;
+  std::string struct_name;
+  int line;
+
+  // List elements are collected and inserted when the list element closes, to keep their order when
+  // some of them are links to objects that were not read yet.
+  std::vector<ValueRef> items;
+  std::map<size_t, PendingLink> links;
+  bool broken;
+
+  StreamFrame(Kind k, int l = 0) : kind(k), type(UnknownType), line(l), broken(false) {
+  }
+};
+
+static std::string reader_attribute(xmlTextReaderPtr reader, const char *name) {
+  xmlChar *prop = xmlTextReaderGetAttribute(reader, (xmlChar *)name);
+  std::string tmp = prop ? (char *)prop : "";
+  xmlFree(prop);
+  return tmp;
+}
+
 ValueRef internal::Unserializer::load_from_xml(const std::string &path, std::string *doctype, std::string *docversion) {
-  xmlDocPtr doc = base::xml::loadXMLDoc(path);
+  if (!base::file_exists(path))
+    throw std::runtime_error("unable to open XML file, doesn't exists: " + path);
 
-  ValueRef value = unserialize_xmldoc(doc, path);
+  xmlTextReaderPtr reader = xmlReaderForFile(path.c_str(), NULL, 0);
+  if (!reader)
+    throw std::runtime_error("unable to parse XML file " + path);
 
-  if (doctype && docversion)
-    base::xml::getXMLDocMetainfo(doc, *doctype, *docversion);
+  _source_name = path;
 
-  xmlFreeDoc(doc);
+  ValueRef value;
+  try {
+    value = unserialize_stream(reader, doctype, docversion);
+  } catch (...) {
+    xmlFreeTextReader(reader);
+    _member_fixups.clear();
+    _list_fixups.clear();
+    throw;
+  }
+  xmlFreeTextReader(reader);
 
   return value;
 }
 
+ValueRef internal::Unserializer::unserialize_stream(xmlTextReaderPtr reader, std::string *doctype,
+                                                    std::string *docversion) {
+  std::vector<StreamFrame> stack;
+  ValueRef result;
+  bool have_result = false;
+  int status;
+
+  _member_fixups.clear();
+  _list_fixups.clear();
+
+  while ((status = xmlTextReaderRead(reader)) == 1) {
+    switch (xmlTextReaderNodeType(reader)) {
+      case XML_READER_TYPE_ELEMENT: {
+        bool empty = xmlTextReaderIsEmptyElement(reader) != 0;
+
+        if (xmlTextReaderDepth(reader) == 0) {
+          if (doctype && docversion) {
+            *doctype = reader_attribute(reader, "document_type");
+            *docversion = reader_attribute(reader, "version");
+          }
+          stack.push_back(StreamFrame(StreamFrame::Root));
+        } else
+          open_stream_element(reader, stack);
+
+        if (empty)
+          close_stream_element(stack, result, have_result);
+        break;
+      }
+
+      case XML_READER_TYPE_END_ELEMENT:
+        close_stream_element(stack, result, have_result);
+        break;
+
+      case XML_READER_TYPE_TEXT:
+      case XML_READER_TYPE_CDATA:
+      case XML_READER_TYPE_WHITESPACE:
+      case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+        if (!stack.empty() && (stack.back().kind == StreamFrame::Link ||
+                               (stack.back().kind == StreamFrame::Value && !is_container_type(stack.back().type)))) {
+          const xmlChar *text = xmlTextReaderConstValue(reader);
+          if (text)
+            stack.back().text.append((const char *)text);
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (status < 0)
+    throw std::runtime_error("unable to parse XML file " + _source_name);
+
+  apply_link_fixups();
+
+  return result;
+}
+
+void internal::Unserializer::open_stream_element(xmlTextReaderPtr reader, std::vector<StreamFrame> &stack) {
+  StreamFrame &parent = stack.back();
+  const char *name = (const char *)xmlTextReaderConstName(reader);
+  int line = xmlTextReaderGetParserLineNumber(reader);
+
+  bool parent_is_container = parent.kind == StreamFrame::Root ||
+                             (parent.kind == StreamFrame::Value && is_container_type(parent.type));
+  if (!parent_is_container) {
+    stack.push_back(StreamFrame(StreamFrame::Ignored, line));
+    return;
+  }
+
+  std::string key = reader_attribute(reader, "key");
+  if ((parent.type == DictType || parent.type == ObjectType) && key.empty()) {
+    stack.push_back(StreamFrame(StreamFrame::Ignored, line));
+    return;
+  }
+
+  if (strcmp(name, "null") == 0) {
+    stack.push_back(StreamFrame(parent.type == ListType ? StreamFrame::Null : StreamFrame::Ignored, line));
+    return;
+  }
+
+  if (strcmp(name, "link") == 0) {
+    if (parent.kind == StreamFrame::Root) {
+      stack.push_back(StreamFrame(StreamFrame::Ignored, line));
+      return;
+    }
+    StreamFrame frame(StreamFrame::Link, line);
+    frame.key = key;
+    frame.link_type = reader_attribute(reader, "type");
+    frame.struct_name = reader_attribute(reader, "struct-name");
+    stack.push_back(std::move(frame));
+    return;
+  }
+
+  if (strcmp(name, "value") != 0) {
+    stack.push_back(StreamFrame(StreamFrame::Ignored, line));
+    return;
+  }
+
+  std::string ptr = reader_attribute(reader, "_ptr_");
+
+  if (parent.type == ObjectType) {
+    ObjectRef owner(ObjectRef::cast_from(parent.value));
+    if (!owner->has_member(key)) {
+      logWarning("in %s: %s", owner.id().c_str(),
+                 std::string("unserialized XML contains invalid member " + owner.class_name() + "::" + key).c_str());
+      stack.push_back(StreamFrame(StreamFrame::Ignored, line));
+      return;
+    }
+
+    // If the member is a container that already exists, register it for reuse by the list/dict below.
+    ValueRef member = owner->get_member(key);
+    if (member.is_valid() && !ptr.empty())
+      _cache[ptr] = member;
+  }
+
+  std::string node_type = reader_attribute(reader, "type");
+  if (node_type.empty())
+    throw std::runtime_error(std::string("Node '").append(name).append("' in xml doesn't have a type property"));
+
+  StreamFrame frame(StreamFrame::Value, line);
+  frame.key = key;
+  frame.type = str_to_type(node_type);
+
+  switch (frame.type) {
+    case ListType: {
+      if (!ptr.empty())
+        frame.value = find_cached(ptr);
+      if (!frame.value.is_valid()) {
+        frame.value = BaseListRef(str_to_type(reader_attribute(reader, "content-type")),
+                                  reader_attribute(reader, "content-struct-name"));
+        if (!ptr.empty())
+          _cache[ptr] = frame.value;
+      }
+      break;
+    }
+
+    case DictType: {
+      if (!ptr.empty())
+        frame.value = find_cached(ptr);
+      if (!frame.value.is_valid()) {
+        std::string prop = reader_attribute(reader, "content-type");
+        if (!prop.empty()) {
+          Type content_type = str_to_type(prop);
+          if (content_type == UnknownType)
+            throw std::runtime_error("Error parsing XML. Invalid type " + prop);
+          frame.value = DictRef(content_type, reader_attribute(reader, "content-struct-name"));
+        } else
+          frame.value = DictRef(true);
+
+        if (!ptr.empty())
+          _cache[ptr] = frame.value;
+      }
+      break;
+    }
+
+    case ObjectType: {
+      ObjectRef object(create_object(reader_attribute(reader, "struct-name"), reader_attribute(reader, "id"),
+                                     reader_attribute(reader, "struct-checksum"), line));
+      _cache[object->id()] = object;
+      frame.value = object;
+      break;
+    }
+
+    default:
+      break;
+  }
+
+  stack.push_back(std::move(frame));
+}
+
+void internal::Unserializer::close_stream_element(std::vector<StreamFrame> &stack, ValueRef &result,
+                                                  bool &have_result) {
+  StreamFrame frame(std::move(stack.back()));
+  stack.pop_back();
+
+  if (stack.empty() || frame.kind == StreamFrame::Ignored)
+    return;
+
+  ValueRef value;
+  bool pending = false;
+  PendingLink link;
+
+  switch (frame.kind) {
+    case StreamFrame::Link:
+      value = find_cached(frame.text);
+      if (!value.is_valid() && _invalid_cache.find(frame.text) == _invalid_cache.end()) {
+        if (frame.link_type != "object") {
+          logWarning("%s: link of type '%s' could not be resolved during unserialized", _source_name.c_str(),
+                     frame.link_type.c_str());
+        } else {
+          // The object may still come later in the document (or live in the global tree).
+          pending = true;
+          link.id = frame.text;
+          link.key = frame.key;
+          link.struct_name = frame.struct_name;
+          link.line = frame.line;
+        }
+      }
+      break;
+
+    case StreamFrame::Value:
+      switch (frame.type) {
+        case IntegerType:
+          value = IntegerRef(strtol(frame.text.c_str(), NULL, 0));
+          break;
+
+        case DoubleType:
+          value = DoubleRef(base::atof<double>(frame.text));
+          break;
+
+        case StringType:
+          value = StringRef(frame.text);
+          break;
+
+        case ListType: {
+          if (frame.broken)
+            break;
+
+          BaseListRef list(BaseListRef::cast_from(frame.value));
+          if (frame.links.empty())
+            insert_list_items(list, frame.items);
+          else {
+            ListFixup fixup;
+            fixup.list = list;
+            fixup.items.swap(frame.items);
+            fixup.links.swap(frame.links);
+            _list_fixups.push_back(fixup);
+          }
+          value = list;
+          break;
+        }
+
+        default:
+          value = frame.value;
+          break;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  StreamFrame &parent = stack.back();
+
+  if (parent.kind == StreamFrame::Root) {
+    if (!have_result && frame.kind == StreamFrame::Value) {
+      result = value;
+      have_result = true;
+    }
+    return;
+  }
+
+  switch (parent.type) {
+    case ListType:
+      if (frame.kind == StreamFrame::Null)
+        parent.items.push_back(ValueRef());
+      else if (pending) {
+        parent.links[parent.items.size()] = link;
+        parent.items.push_back(ValueRef());
+      } else if (value.is_valid())
+        parent.items.push_back(value);
+      else if (!parent.broken) {
+        logWarning("%s: skipping element in unserialized document, line %i", _source_name.c_str(), frame.line);
+        parent.broken = true;
+      }
+      break;
+
+    case DictType:
+      if (pending) {
+        MemberFixup fixup = {parent.value, link};
+        _member_fixups.push_back(fixup);
+      } else
+        DictRef::cast_from(parent.value).set(frame.key, value);
+      break;
+
+    case ObjectType: {
+      if (pending) {
+        MemberFixup fixup = {parent.value, link};
+        _member_fixups.push_back(fixup);
+      } else if (value.is_valid()) {
+        ObjectRef object(ObjectRef::cast_from(parent.value));
+        try {
+          object->get_metaclass()->set_member_internal((internal::Object *)object.valueptr(), frame.key, value, true);
+        } catch (const std::exception &exc) {
+          logWarning("exception setting %s<%s>:%s to %s %s", object.id().c_str(), object.class_name().c_str(),
+                     frame.key.c_str(), value.debugDescription().c_str(), exc.what());
+          throw;
+        }
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void internal::Unserializer::insert_list_items(BaseListRef &list, const std::vector<ValueRef> &items) {
+  for (std::vector<ValueRef>::const_iterator item = items.begin(); item != items.end(); ++item) {
+    if (!item->is_valid() && !list->null_allowed())
+      logWarning("%s: Attempt o add null value to %s list", _source_name.c_str(), list.content_class_name().c_str());
+    try {
+      list.ginsert(*item);
+    } catch (const std::exception &exc) {
+      logWarning("%s: Error inserting %s to list: %s", _source_name.c_str(),
+                 item->is_valid() ? item->debugDescription().c_str() : "NULL", exc.what());
+      throw;
+    }
+  }
+}
+
+ObjectRef internal::Unserializer::resolve_pending_link(const PendingLink &link) {
+  ValueRef value = find_cached(link.id);
+
+  if (!value.is_valid() && _invalid_cache.find(link.id) == _invalid_cache.end()) {
+    // if the linked object is not in the current tree, look for it in the global tree
+    ObjectRef object(grt::GRT::get()->find_object_by_id(link.id, "/"));
+
+    if (object.is_valid())
+      _cache[object->id()] = object;
+    else {
+      _invalid_cache.insert(link.id);
+      logWarning("%s:%i: link '%s' <object %s> key=%s could not be resolved\n", _source_name.c_str(), link.line,
+                 link.id.c_str(), link.struct_name.c_str(), link.key.c_str());
+    }
+    value = object;
+  }
+
+  return ObjectRef::cast_from(value);
+}
+
+void internal::Unserializer::apply_link_fixups() {
+  std::vector<MemberFixup> member_fixups;
+  std::vector<ListFixup> list_fixups;
+  member_fixups.swap(_member_fixups);
+  list_fixups.swap(_list_fixups);
+
+  for (std::vector<MemberFixup>::iterator fixup = member_fixups.begin(); fixup != member_fixups.end(); ++fixup) {
+    ObjectRef object(resolve_pending_link(fixup->link));
+
+    if (fixup->target.type() == DictType)
+      DictRef::cast_from(fixup->target).set(fixup->link.key, object);
+    else if (object.is_valid()) {
+      ObjectRef target(ObjectRef::cast_from(fixup->target));
+      target->get_metaclass()->set_member_internal((internal::Object *)target.valueptr(), fixup->link.key, object,
+                                                   true);
+    }
+  }
+
+  for (std::vector<ListFixup>::iterator fixup = list_fixups.begin(); fixup != list_fixups.end(); ++fixup) {
+    std::vector<ValueRef> items;
+
+    for (size_t i = 0; i < fixup->items.size(); i++) {
+      std::map<size_t, PendingLink>::const_iterator link = fixup->links.find(i);
+      if (link == fixup->links.end())
+        items.push_back(fixup->items[i]);
+      else {
+        ObjectRef object(resolve_pending_link(link->second));
+        if (object.is_valid())
+          items.push_back(object);
+        else
+          logWarning("%s: skipping element in unserialized document, line %i", _source_name.c_str(),
+                     link->second.line);
+      }
+    }
+    insert_list_items(fixup->list, items);
+  }
+}
+
 ValueRef internal::Unserializer::unserialize_xmldoc(xmlDocPtr doc, const std::string &source_path) {
   xmlNodePtr root;
   ValueRef value;
@@ -293,33 +710,23 @@ ValueRef internal::Unserializer::traverse_xml_recreating_tree(xmlNodePtr node) {
   return value;
 }
 
-ObjectRef internal::Unserializer::unserialize_object_step1(xmlNodePtr node) {
-  MetaClass *gstruct;
-  std::string id;
-
-  std::string prop = base::xml::getProp(node, "type");
-  if (prop != "object")
-    throw std::runtime_error("error unserializing object (unexpected type)");
-
-  prop = base::xml::getProp(node, "struct-name");
-  if (prop.empty())
+ObjectRef internal::Unserializer::create_object(const std::string &struct_name, const std::string &id,
+                                                const std::string &checksum, int line) {
+  if (struct_name.empty())
     throw std::runtime_error("error unserializing object (missing struct-name)");
 
-  gstruct = grt::GRT::get()->get_metaclass(prop);
+  MetaClass *gstruct = grt::GRT::get()->get_metaclass(struct_name);
   if (!gstruct) {
-    logWarning("%s:%i: error unserializing object: struct '%s' unknown", _source_name.c_str(), node->line,
-               prop.c_str());
-    throw std::runtime_error(base::strfmt("error unserializing object (struct '%s' unknown)", prop.c_str()));
+    logWarning("%s:%i: error unserializing object: struct '%s' unknown", _source_name.c_str(), line,
+               struct_name.c_str());
+    throw std::runtime_error(base::strfmt("error unserializing object (struct '%s' unknown)", struct_name.c_str()));
   }
 
-  id = base::xml::getProp(node, "id");
   if (id.empty())
     throw std::runtime_error("missing id in unserialized object");
 
-  prop = base::xml::getProp(node, "struct-checksum");
-  if (!prop.empty()) {
-    unsigned int checksum = (unsigned int)strtol(prop.c_str(), NULL, 0);
-    if (_check_serialized_crc && checksum != gstruct->crc32()) {
+  if (!checksum.empty()) {
+    if (_check_serialized_crc && (unsigned int)strtol(checksum.c_str(), NULL, 0) != gstruct->crc32()) {
       logWarning("current checksum of struct of serialized object %s (%s) differs from the one when it was saved",
                  id.c_str(), gstruct->name().c_str());
     }
@@ -331,6 +738,14 @@ ObjectRef internal::Unserializer::unserialize_object_step1(xmlNodePtr node) {
   return value;
 }
 
+ObjectRef internal::Unserializer::unserialize_object_step1(xmlNodePtr node) {
+  if (base::xml::getProp(node, "type") != "object")
+    throw std::runtime_error("error unserializing object (unexpected type)");
+
+  return create_object(base::xml::getProp(node, "struct-name"), base::xml::getProp(node, "id"),
+                       base::xml::getProp(node, "struct-checksum"), node->line);
+}
+
 ObjectRef internal::Unserializer::unserialize_object_step2(xmlNodePtr node) {
   std::string id = base::xml::getProp(node, "id");
 
@@ -415,3 +830,293 @@ ValueRef internal::Unserializer::unserialize_xmldata(const char *data, size_t si
 
   return value;
 }
+
+struct internal::Unserializer::BinaryReader {
+  const unsigned char *pos;
+  const unsigned char *end;
+
+  BinaryReader(const char *data, size_t size)
+    : pos((const unsigned char *)data), end((const unsigned char *)data + size) {
+  }
+
+  void need(size_t count) {
+    if ((size_t)(end - pos) < count)
+      throw std::runtime_error("Unexpected end of binary GRT data");
+  }
+
+  unsigned char byte() {
+    need(1);
+    return *pos++;
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      unsigned char b = byte();
+      value |= (uint64_t)(b & 0x7f) << shift;
+      if ((b & 0x80) == 0)
+        return value;
+    }
+    throw std::runtime_error("Invalid number in binary GRT data");
+  }
+
+  std::string string() {
+    uint64_t length = varint();
+    need((size_t)length);
+    std::string result((const char *)pos, (size_t)length);
+    pos += length;
+    return result;
+  }
+};
+
+bool internal::Unserializer::is_binary_file(const std::string &path) {
+  char magic[4];
+  FILE *file = base_fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+
+  bool result = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, GRT_BINARY_MAGIC, 4) == 0;
+  fclose(file);
+
+  return result;
+}
+
+bool internal::Unserializer::read_binary_header(const std::string &path, std::string &doctype,
+                                                std::string &docversion) {
+  // Both strings are short, the header fits easily in the start of the file.
+  char header[1024];
+  FILE *file = base_fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+
+  size_t size = fread(header, 1, sizeof(header), file);
+  fclose(file);
+
+  try {
+    BinaryReader reader(header, size);
+    reader.need(4);
+    if (memcmp(reader.pos, GRT_BINARY_MAGIC, 4) != 0)
+      return false;
+    reader.pos += 4;
+    if (reader.byte() != GRT_BINARY_FORMAT_VERSION)
+      return false;
+
+    doctype = reader.string();
+    docversion = reader.string();
+  } catch (std::exception &) {
+    return false;
+  }
+  return true;
+}
+
+ValueRef internal::Unserializer::load_from_binary(const std::string &path, std::string *doctype,
+                                                  std::string *docversion) {
+  gchar *contents = NULL;
+  gsize length = 0;
+
+  if (!g_file_get_contents(path.c_str(), &contents, &length, NULL))
+    throw std::runtime_error("unable to open binary GRT file " + path);
+
+  _source_name = path;
+
+  ValueRef value;
+  try {
+    value = unserialize_binary_data(contents, length, doctype, docversion);
+  } catch (...) {
+    g_free(contents);
+    throw;
+  }
+  g_free(contents);
+
+  return value;
+}
+
+ValueRef internal::Unserializer::unserialize_binary_data(const char *data, size_t size, std::string *doctype,
+                                                         std::string *docversion) {
+  BinaryReader reader(data, size);
+
+  reader.need(4);
+  if (memcmp(reader.pos, GRT_BINARY_MAGIC, 4) != 0)
+    throw std::runtime_error("Data is not in the binary GRT format");
+  reader.pos += 4;
+
+  if (reader.byte() != GRT_BINARY_FORMAT_VERSION)
+    throw std::runtime_error("Unsupported version of the binary GRT format");
+
+  std::string type = reader.string();
+  std::string version = reader.string();
+  if (doctype && docversion) {
+    *doctype = type;
+    *docversion = version;
+  }
+
+  _binary_strings.clear();
+  _binary_containers.clear();
+  _member_fixups.clear();
+  _list_fixups.clear();
+
+  ValueRef value;
+  try {
+    value = read_binary_value(reader, ValueRef(), NULL);
+    apply_link_fixups();
+  } catch (...) {
+    _member_fixups.clear();
+    _list_fixups.clear();
+    throw;
+  }
+
+  _binary_strings.clear();
+  _binary_containers.clear();
+
+  return value;
+}
+
+const std::string &internal::Unserializer::read_interned(BinaryReader &reader) {
+  uint64_t index = reader.varint();
+  if (index == 0) {
+    _binary_strings.push_back(reader.string());
+    return _binary_strings.back();
+  }
+
+  if (index > _binary_strings.size())
+    throw std::runtime_error("Invalid string reference in binary GRT data");
+  return _binary_strings[(size_t)index - 1];
+}
+
+/**
+ * Reads the next value. Containers are filled into @existing if it is a container of the same kind, which
+ * is how member lists and dicts created by the owner object are reused. Links to objects that were not read
+ * yet are returned in @pending (if given), to be resolved once all the data was read.
+ */
+ValueRef internal::Unserializer::read_binary_value(BinaryReader &reader, const ValueRef &existing,
+                                                   PendingLink *pending) {
+  switch (reader.byte()) {
+    case BinaryNull:
+      return ValueRef();
+
+    case BinaryInteger: {
+      uint64_t u = reader.varint();
+      return IntegerRef((IntegerRef::storage_type)((int64_t)(u >> 1) ^ -(int64_t)(u & 1)));
+    }
+
+    case BinaryDouble: {
+      uint64_t bits = 0;
+      for (int i = 0; i < 8; i++)
+        bits |= (uint64_t)reader.byte() << (8 * i);
+      double d;
+      memcpy(&d, &bits, sizeof(d));
+      return DoubleRef(d);
+    }
+
+    case BinaryString:
+      return StringRef(reader.string());
+
+    case BinaryList: {
+      Type content_type = (Type)reader.byte();
+      std::string content_class = read_interned(reader);
+      uint64_t count = reader.varint();
+
+      BaseListRef list;
+      if (existing.is_valid() && existing.type() == ListType)
+        list = BaseListRef::cast_from(existing);
+      else
+        list = BaseListRef(content_type, content_class);
+      _binary_containers.push_back(list);
+
+      std::vector<ValueRef> items;
+      std::map<size_t, PendingLink> links;
+      for (uint64_t i = 0; i < count; i++) {
+        PendingLink link;
+        ValueRef item = read_binary_value(reader, ValueRef(), &link);
+        if (!link.id.empty())
+          links[items.size()] = link;
+        items.push_back(item);
+      }
+
+      if (links.empty())
+        insert_list_items(list, items);
+      else {
+        ListFixup fixup;
+        fixup.list = list;
+        fixup.items.swap(items);
+        fixup.links.swap(links);
+        _list_fixups.push_back(fixup);
+      }
+      return list;
+    }
+
+    case BinaryDict: {
+      Type content_type = (Type)reader.byte();
+      std::string content_class = read_interned(reader);
+      uint64_t count = reader.varint();
+
+      DictRef dict;
+      if (existing.is_valid() && existing.type() == DictType)
+        dict = DictRef::cast_from(existing);
+      else if (content_type == AnyType)
+        dict = DictRef(true);
+      else
+        dict = DictRef(content_type, content_class);
+      _binary_containers.push_back(dict);
+
+      for (uint64_t i = 0; i < count; i++) {
+        std::string key = read_interned(reader);
+        PendingLink link;
+        ValueRef item = read_binary_value(reader, ValueRef(), &link);
+        if (!link.id.empty()) {
+          link.key = key;
+          MemberFixup fixup = {dict, link};
+          _member_fixups.push_back(fixup);
+        } else
+          dict.set(key, item);
+      }
+      return dict;
+    }
+
+    case BinaryObject: {
+      std::string struct_name = read_interned(reader);
+      std::string id = read_interned(reader);
+      ObjectRef object(create_object(struct_name, id, std::to_string(reader.varint()), 0));
+      _cache[id] = object;
+
+      MetaClass *mc = object->get_metaclass();
+      for (uint64_t i = 0, count = reader.varint(); i < count; i++) {
+        std::string key = read_interned(reader);
+        bool valid_member = object->has_member(key);
+        PendingLink link;
+
+        ValueRef member = read_binary_value(reader, valid_member ? object->get_member(key) : ValueRef(), &link);
+        if (!valid_member) {
+          logWarning("in %s: %s", object.id().c_str(),
+                     std::string("unserialized data contains invalid member " + object.class_name() + "::" + key)
+                       .c_str());
+        } else if (!link.id.empty()) {
+          link.key = key;
+          MemberFixup fixup = {object, link};
+          _member_fixups.push_back(fixup);
+        } else if (member.is_valid())
+          mc->set_member_internal((internal::Object *)object.valueptr(), key, member, true);
+      }
+      return object;
+    }
+
+    case BinaryObjectLink: {
+      std::string id = read_interned(reader);
+      ValueRef value = find_cached(id);
+      if (!value.is_valid() && pending) {
+        pending->id = id;
+      }
+      return value;
+    }
+
+    case BinaryContainerLink: {
+      uint64_t index = reader.varint();
+      if (index >= _binary_containers.size())
+        throw std::runtime_error("Invalid container reference in binary GRT data");
+      return _binary_containers[(size_t)index];
+    }
+
+    default:
+      throw std::runtime_error("Invalid value tag in binary GRT data");
+  }
+}
@@ -25,6 +25,7 @@
 
 #include "grt.h"
 #include <set>
+#include <libxml/xmlreader.h>
 
 namespace grt {
   namespace internal {
@@ -32,22 +33,75 @@ namespace grt {
     public:
       Unserializer(bool check_crc);
 
+      /** Reads the file with a streaming parser, without building a DOM for it first. Objects are created as
+          their elements are read and links to objects that appear later in the file are resolved once the
+          whole document was read. */
       ValueRef load_from_xml(const std::string &path, std::string *doctype = 0, std::string *docversion = 0);
 
       ValueRef unserialize_xmldoc(xmlDocPtr doc, const std::string &source_path = "");
 
       ValueRef unserialize_xmldata(const char *data, size_t size);
 
+      /** Reads a file written by Serializer::save_to_binary(). */
+      ValueRef load_from_binary(const std::string &path, std::string *doctype = 0, std::string *docversion = 0);
+      ValueRef unserialize_binary_data(const char *data, size_t size, std::string *doctype = 0,
+                                       std::string *docversion = 0);
+
+      static bool is_binary_file(const std::string &path);
+      /** Reads only the document type and version of a binary file, false if it is not one. */
+      static bool read_binary_header(const std::string &path, std::string &doctype, std::string &docversion);
+
     protected:
+      struct StreamFrame;
+      struct BinaryReader;
+
+      // A link to an object that was not read yet when the link was found.
+      struct PendingLink {
+        std::string id;
+        std::string key;
+        std::string struct_name;
+        int line;
+
+        PendingLink() : line(0) {
+        }
+      };
+
+      struct MemberFixup {
+        ValueRef target; // object or dict
+        PendingLink link;
+      };
+
+      struct ListFixup {
+        BaseListRef list;
+        std::vector<ValueRef> items;
+        std::map<size_t, PendingLink> links; // item index -> link
+      };
+
       std::string _source_name;
       std::map<std::string, ValueRef> _cache;
       std::set<std::string> _invalid_cache;
+      std::vector<MemberFixup> _member_fixups;
+      std::vector<ListFixup> _list_fixups;
+      std::vector<std::string> _binary_strings;
+      std::vector<ValueRef> _binary_containers;
       bool _check_serialized_crc;
 
+      ValueRef unserialize_stream(xmlTextReaderPtr reader, std::string *doctype, std::string *docversion);
+      void open_stream_element(xmlTextReaderPtr reader, std::vector<StreamFrame> &stack);
+      void close_stream_element(std::vector<StreamFrame> &stack, ValueRef &result, bool &have_result);
+      void insert_list_items(BaseListRef &list, const std::vector<ValueRef> &items);
+      ObjectRef resolve_pending_link(const PendingLink &link);
+      void apply_link_fixups();
+
+      const std::string &read_interned(BinaryReader &reader);
+      ValueRef read_binary_value(BinaryReader &reader, const ValueRef &existing, PendingLink *pending);
+
       ValueRef unserialize_from_xml(xmlNodePtr node);
       ValueRef traverse_xml_recreating_tree(xmlNodePtr node);
       void traverse_xml_creating_objects(xmlNodePtr node);
 
+      ObjectRef create_object(const std::string &struct_name, const std::string &id, const std::string &checksum,
+                              int line);
       ObjectRef unserialize_object_step1(xmlNodePtr node);
       ObjectRef unserialize_object_step2(xmlNodePtr node);
       void unserialize_object_contents(const ObjectRef &object, xmlNodePtr node);
@@ -33,6 +33,7 @@
 #include "synthetic_mysql_model.h"
 #include "module_db_mysql.h"
 #include "backend/diff_tree.h"
+#include "base/string_utilities.h"
 
 using namespace grt;
 
@@ -362,9 +363,41 @@ TEST_FUNCTION(10) {
   ensure("10.2 Routine definer, wasn't different", change2.get() != NULL);
 }
 
+// The header-only normalization of routines and triggers must give the same text as the parser.
+TEST_FUNCTION(11) {
+  static const struct {
+    const char* sql;
+    bool fast_path; // Whether normalize_create_statement() handles it or leaves it to the parser.
+  } statements[] = {
+    {"CREATE PROCEDURE p1()\nBEGIN\n  SELECT 1;\nEND", true},
+    {"CREATE DEFINER=`root`@`localhost` PROCEDURE `p 2`(IN a INT)\nBEGIN\n  -- comment\n  SELECT a /* inline */;\nEND",
+     true},
+    {"  CREATE   FUNCTION other.f1(x INT) RETURNS INT\n  DETERMINISTIC\n  RETURN x + 1  \n", true},
+    {"CREATE DEFINER = 'root'@'%' TRIGGER `tr1` BEFORE INSERT ON `t1` FOR EACH ROW SET NEW.a = 1", true},
+    {"CREATE TRIGGER tr2 AFTER UPDATE ON `other`.`t 2` FOR EACH ROW BEGIN\n  # comment\n  INSERT INTO log VALUES "
+     "(OLD.id);\nEND",
+     true},
+    {"CREATE /* header comment */ PROCEDURE p3() SELECT 1", false},
+    {"CREATE TABLE t1 (id INT AUTO_INCREMENT PRIMARY KEY) AUTO_INCREMENT=5", false},
+    {"CREATE VIEW v1 AS SELECT 1", false},
+  };
+
+  SqlFacade* parser = SqlFacade::instance_for_rdbms_name("Mysql");
+  ensure("failed to get sqlparser module", parser != NULL);
+
+  for (size_t i = 0; i < sizeof(statements) / sizeof(statements[0]); ++i) {
+    std::string result;
+    bool handled = grt::normalize_create_statement(statements[i].sql, "test", result);
+    ensure_equals(base::strfmt("11.%i fast path", (int)i + 1), handled, statements[i].fast_path);
+    if (handled)
+      ensure_equals(base::strfmt("11.%i normalized text", (int)i + 1), result,
+                    parser->normalizeSqlStatement(statements[i].sql, "test"));
+  }
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
-TEST_FUNCTION(11) {
+TEST_FUNCTION(12) {
   delete tester;
 }
 
@@ -250,4 +250,33 @@ TEST_FUNCTION(2) {
   assure_grt_values_equal(source, target);
 }
 
+// Matches items pairwise, as done for values without match keys.
+struct pairwise_omf : public default_omf {
+  virtual bool match_key(const ValueRef &value, std::string &key) const {
+    return false;
+  }
+};
+
+TEST_FUNCTION(3) {
+  // Hash indexed matching must produce the same changes as pairwise matching.
+  StringListRef source(grt::Initialized);
+  StringListRef target(grt::Initialized);
+  for (int i = 0; i < 500; ++i) {
+    if (i % 7 != 0)
+      source.insert(base::strfmt("item%i", i));
+    if (i % 5 != 0)
+      target.insert(base::strfmt("item%i", (i * 37) % 500));
+  }
+
+  default_omf omf;
+  pairwise_omf pairwise;
+  std::shared_ptr<DiffChange> change = diff_make(source, target, &omf);
+  std::shared_ptr<DiffChange> pairwise_change = diff_make(source, target, &pairwise);
+  ensure("changes found", change != nullptr && pairwise_change != nullptr);
+  ensure_equals("change count", change->subchanges()->changes.size(), pairwise_change->subchanges()->changes.size());
+
+  apply_change_to_object(source, change.get());
+  assure_grt_values_equal(source, target);
+}
+
 END_TESTS
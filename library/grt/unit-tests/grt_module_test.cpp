@@ -37,7 +37,23 @@ TEST_FUNCTION(5) {
   grt::GRT::get()->end_loading_metaclasses();
 }
 
-// ml: No tests defined currently, as the few previously defined tests are no longer valid and
-// have been removed. Remove this notice as soon as you start writing new tests.
+// Handles of missing modules or functions can be created, they only fail when called.
+TEST_FUNCTION(10) {
+  grt::ModuleFunctionHandle handle("NoSuchModule", "noSuchFunction");
+  ensure_equals("module name", handle.module_name(), "NoSuchModule");
+  ensure("missing module is not valid", !handle.is_valid());
+
+  try {
+    handle(grt::StringRef("value"));
+    fail("call of a missing module function didn't throw");
+  } catch (grt::module_error &) {
+  }
+
+  try {
+    grt::GRT::get()->call_module_function("NoSuchModule", "noSuchFunction", grt::BaseListRef(true));
+    fail("call_module_function() of a missing module didn't throw");
+  } catch (grt::module_error &) {
+  }
+}
 
 END_TESTS
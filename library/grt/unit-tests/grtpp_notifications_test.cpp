@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2011, 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+
+#include "testgrt.h"
+#include "grtpp_notifications.h"
+#include "grtpp_undo_manager.h"
+
+using namespace grt;
+
+class CountingObserver : public GRTObserver {
+public:
+  std::map<std::string, int> received;
+
+  virtual void handle_grt_notification(const std::string &name, ObjectRef sender, DictRef info) {
+    received[name]++;
+  }
+};
+
+BEGIN_TEST_DATA_CLASS(grtpp_notifications_test)
+public:
+CountingObserver observer;
+
+TEST_DATA_CONSTRUCTOR(grtpp_notifications_test) {
+  GRTNotificationCenter::setup();
+  GRTNotificationCenter::get()->add_grt_observer(&observer);
+}
+END_TEST_DATA_CLASS
+
+TEST_MODULE(grtpp_notifications_test, "GRT: notification batches");
+
+TEST_FUNCTION(1) { // duplicates are dropped and delivered at the end of the batch
+  GRTNotificationCenter *center = GRTNotificationCenter::get();
+
+  ensure("batch opened", center->begin_batch());
+  center->send_grt("GRNTestChanged", ObjectRef(), DictRef());
+  center->send_grt("GRNTestChanged", ObjectRef(), DictRef());
+  center->send_grt("GRNTestWillChange", ObjectRef(), DictRef());
+  ensure_equals("queued", observer.received["GRNTestChanged"], 0);
+  ensure_equals("will notifications are not queued", observer.received["GRNTestWillChange"], 1);
+
+  // nested batches deliver only when the outermost one ends
+  ensure("nested batch opened", center->begin_batch());
+  center->end_batch();
+  ensure_equals("still queued", observer.received["GRNTestChanged"], 0);
+
+  center->end_batch();
+  ensure("batch closed", !center->in_batch());
+  ensure_equals("delivered once", observer.received["GRNTestChanged"], 1);
+}
+
+TEST_FUNCTION(2) { // notifications with info are all kept
+  GRTNotificationCenter *center = GRTNotificationCenter::get();
+  observer.received.clear();
+
+  DictRef info(true);
+  info.set("value", IntegerRef(1));
+
+  {
+    NotificationBatch batch;
+    center->send_grt("GRNTestChanged", ObjectRef(), info);
+    center->send_grt("GRNTestChanged", ObjectRef(), info);
+  }
+  ensure_equals("delivered both", observer.received["GRNTestChanged"], 2);
+}
+
+TEST_FUNCTION(3) { // undo groups open a batch
+  GRTNotificationCenter *center = GRTNotificationCenter::get();
+  observer.received.clear();
+
+  AutoUndo undo;
+  ensure("batch opened by undo group", center->in_batch());
+  center->send_grt("GRNTestChanged", ObjectRef(), DictRef());
+  ensure_equals("queued in group", observer.received["GRNTestChanged"], 0);
+
+  undo.cancel();
+  ensure("batch closed with group", !center->in_batch());
+  ensure_equals("delivered after group", observer.received["GRNTestChanged"], 1);
+}
+
+TEST_FUNCTION(99) {
+  GRTNotificationCenter::get()->remove_grt_observer(&observer);
+}
+
+END_TESTS
@@ -71,6 +71,11 @@ void test_serialization(const ValueRef& val) {
   grt::GRT::get()->serialize(val, filename);
   ValueRef res_val(grt::GRT::get()->unserialize(filename));
   grt_ensure_equals("serialization test", res_val, val, true);
+
+  static const std::string binary_filename("output/serialization_test.grtb");
+  grt::GRT::get()->serialize_binary(val, binary_filename);
+  res_val = grt::GRT::get()->unserialize(binary_filename);
+  grt_ensure_equals("binary serialization test", res_val, val, true);
 }
 
 TEST_FUNCTION(2) {
@@ -153,6 +158,18 @@ TEST_FUNCTION(4) {
   tut::ensure("Check owner set", NULL != owner.valueptr());
 
   tut::ensure("Check owner", catalog->schemata().get(0)->tables().get(0).valueptr() == owner.valueptr());
+
+  // the binary format must restore the same tree, including owners and links between objects
+  grt::GRT::get()->serialize_binary(catalog, "output/catalog.grtb", "test", "1.0");
+  std::string doctype, version;
+  db_mysql_CatalogRef copy(
+    db_mysql_CatalogRef::cast_from(grt::GRT::get()->unserialize("output/catalog.grtb", doctype, version)));
+  ensure_equals("binary doctype", doctype, "test");
+  ensure_equals("binary version", version, "1.0");
+  grt_ensure_equals("binary catalog", copy, catalog, true);
+
+  owner = copy->schemata().get(0)->tables().get(0)->indices().get(0)->owner();
+  tut::ensure("Check binary owner", copy->schemata().get(0)->tables().get(0).valueptr() == owner.valueptr());
 }
 
 TEST_FUNCTION(5) {
@@ -173,6 +190,67 @@ TEST_FUNCTION(5) {
   ensure("list[2]", list[2].is_valid());
 }
 
+TEST_FUNCTION(6) {
+  // links to objects that appear later in the file must be resolved after the file was read
+  static const char *xml =
+    "<?xml version=\"1.0\"?>\n"
+    "<data grt_format=\"2.0\" document_type=\"test\" version=\"1.0\">\n"
+    "  <value type=\"list\" content-type=\"any\">\n"
+    "    <link type=\"object\">table-1</link>\n"
+    "    <value type=\"dict\">\n"
+    "      <link type=\"object\" key=\"table\">table-1</link>\n"
+    "      <value type=\"string\" key=\"name\">forward</value>\n"
+    "    </value>\n"
+    "    <value type=\"object\" struct-name=\"db.Table\" id=\"table-1\">\n"
+    "      <value type=\"string\" key=\"name\">t1</value>\n"
+    "    </value>\n"
+    "  </value>\n"
+    "</data>\n";
+
+  g_file_set_contents("output/forward_links.xml", xml, -1, NULL);
+
+  std::string doctype, version;
+  grt::BaseListRef list(
+    grt::BaseListRef::cast_from(grt::GRT::get()->unserialize("output/forward_links.xml", doctype, version)));
+
+  ensure_equals("doctype", doctype, "test");
+  ensure_equals("version", version, "1.0");
+  ensure_equals("list count", list.count(), 3U);
+
+  db_TableRef table(db_TableRef::cast_from(list[2]));
+  ensure_equals("table name", *table->name(), "t1");
+  ensure("list link", list[0].valueptr() == table.valueptr());
+
+  grt::DictRef dict(grt::DictRef::cast_from(list[1]));
+  ensure("dict link", dict.get("table").valueptr() == table.valueptr());
+  ensure_equals("dict value", dict.get_string("name"), "forward");
+}
+
+TEST_FUNCTION(7) {
+  // a snapshot is only used for the exact file it was taken of
+  static const std::string filename("output/snapshot_test.xml");
+
+  grt::DictRef dict(true);
+  dict.gset("name", "first");
+  grt::GRT::get()->serialize(dict, filename);
+  ensure("no snapshot yet", !grt::GRT::get()->load_snapshot(filename).is_valid());
+
+  grt::DictRef loaded(grt::DictRef::cast_from(grt::GRT::get()->unserialize_with_snapshot(filename)));
+  ensure_equals("loaded from XML", loaded.get_string("name"), "first");
+
+  loaded = grt::DictRef::cast_from(grt::GRT::get()->load_snapshot(filename));
+  ensure("snapshot written", loaded.is_valid());
+  ensure_equals("loaded from snapshot", loaded.get_string("name"), "first");
+
+  // the file changes size, so the snapshot must be ignored
+  dict.gset("name", "second value");
+  grt::GRT::get()->serialize(dict, filename);
+  ensure("outdated snapshot", !grt::GRT::get()->load_snapshot(filename).is_valid());
+
+  loaded = grt::DictRef::cast_from(grt::GRT::get()->unserialize_with_snapshot(filename));
+  ensure_equals("reloaded from XML", loaded.get_string("name"), "second value");
+}
+
 #ifdef badtest
 TEST_FUNCTION(5) {
   // dontfollow means the object will be saved as a link, not that it wont be saved
@@ -100,6 +100,30 @@ TEST_FUNCTION(7) {
   // check allocation
 }
 
+TEST_FUNCTION(10) {
+  // Member slots give the same results as walking the class hierarchy.
+  MetaClass *book = grt::GRT::get()->get_metaclass("test.Book");
+
+  MetaClass::MemberSlot slot = book->get_member_slot("title");
+  ensure("slot title (inherited)", slot.info == book->get_member_info("title"));
+  ensure("slot title getter", slot.getter != 0);
+  ensure("slot title setter", slot.setter != 0);
+  ensure("slot for unknown member", book->get_member_slot("xxx").info == 0);
+
+  test_BookRef book_obj(grt::Initialized);
+  book->set_member_value(&book_obj.content(), slot, StringRef("Slots"));
+  ensure_equals("title set through slot", *book_obj->title(), "Slots");
+  ensure_equals("title read through slot", *StringRef::cast_from(book->get_member_value(&book_obj.content(), slot)),
+                "Slots");
+  ensure_equals("title read by name", book_obj->get_string_member("title"), "Slots");
+
+  try {
+    book->get_member_value(&book_obj.content(), book->get_member_slot("xxx"));
+    fail("reading an unknown member through a slot didn't throw");
+  } catch (grt::bad_item &) {
+  }
+}
+
 TEST_FUNCTION(8) {
   // check method call
 }
@@ -21,8 +21,11 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include "base/string_utilities.h"
 #include "grtpp_util.h"
 
+#include <thread>
+
 #include "testgrt.h"
 #include "structs.test.h"
 #include "grt_values_test_data.h"
@@ -856,4 +859,28 @@ TEST_FUNCTION(36) { // test list reordering
   ensure_equals("reorder 3,0", *lv.get(3), 2);
 }
 
+TEST_FUNCTION(37) { // values created in one thread and released in another
+  StringListRef strings(grt::Initialized);
+  DictRef dict(true);
+
+  std::thread worker([&]() {
+    for (int i = 0; i < 10000; i++) {
+      strings.insert(StringRef(base::strfmt("value %i", i)));
+      dict.set(base::strfmt("key %i", i), IntegerRef(i));
+    }
+  });
+  worker.join();
+
+  ensure_equals("list filled by worker", strings.count(), 10000U);
+  ensure_equals("list item", *strings.get(1234), "value 1234");
+  ensure_equals("dict item", *IntegerRef::cast_from(dict.get("key 4321")), 4321);
+
+  // Released blocks are handed out again, the contents must not be affected by that.
+  strings.remove_all();
+  for (int i = 0; i < 10000; i++)
+    strings.insert(StringRef(base::strfmt("other %i", i)));
+  ensure_equals("list item after reuse", *strings.get(9999), "other 9999");
+  ensure_equals("dict item after reuse", *IntegerRef::cast_from(dict.get("key 9999")), 9999);
+}
+
 END_TESTS
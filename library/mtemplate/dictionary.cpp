@@ -24,10 +24,39 @@
 #include "dictionary.h"
 #include <base/string_utilities.h>
 
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 namespace mtemplate {
 
+  //-----------------------------------------------------------------------------------
+  //  Slot stuff
+  //-----------------------------------------------------------------------------------
+  static std::mutex SlotMutex;
+  static std::unordered_map<std::string, Slot> SlotsByName;
+  static std::deque<base::utf8string> SlotNames; // A deque keeps references to the names valid.
+
+  Slot GetSlot(const base::utf8string &name) {
+    std::string key(name.c_str(), name.bytes());
+    std::lock_guard<std::mutex> lock(SlotMutex);
+
+    std::unordered_map<std::string, Slot>::const_iterator slot = SlotsByName.find(key);
+    if (slot != SlotsByName.end())
+      return slot->second;
+
+    SlotNames.push_back(name);
+    return SlotsByName[key] = SlotNames.size() - 1;
+  }
+
+  const base::utf8string &GetSlotName(Slot slot) {
+    std::lock_guard<std::mutex> lock(SlotMutex);
+    return SlotNames[slot];
+  }
+
+  static const base::utf8string EmptyValue;
+
   //-----------------------------------------------------------------------------------
   //  DictionaryInterface stuff
   //-----------------------------------------------------------------------------------
@@ -71,17 +100,22 @@ namespace mtemplate {
     }
 
     //  DictionaryInterface
-    virtual void setValue(const base::utf8string &key, const base::utf8string &value) {
+    using DictionaryInterface::setValue;
+    using DictionaryInterface::getValue;
+    using DictionaryInterface::getSectionDictionaries;
+
+    virtual void setValue(Slot key, const base::utf8string &value) {
       _dictionary[key] = value;
     }
-    virtual base::utf8string getValue(const base::utf8string &key) {
-      return _dictionary.find(key) == _dictionary.end() ? "" : _dictionary[key];
+    virtual const base::utf8string &getValue(Slot key) {
+      dictionary_storage::const_iterator value = _dictionary.find(key);
+      return value == _dictionary.end() ? EmptyValue : value->second;
     }
 
     virtual DictionaryInterface *addSectionDictionary(const base::utf8string &name) {
       return NULL;
     }
-    virtual section_dictionary_storage &getSectionDictionaries(const base::utf8string &sections) {
+    virtual section_dictionary_storage &getSectionDictionaries(Slot section) {
       return _no_section;
     }
 
@@ -92,7 +126,7 @@ namespace mtemplate {
       std::cout << indent_str << "[" << _name << "] = " << std::endl << indent_str << "{" << std::endl;
 
       for (auto item : _dictionary)
-        std::cout << indent_plus_str << "[" << item.first << "] = \"" << item.second << "\"" << std::endl;
+        std::cout << indent_plus_str << "[" << GetSlotName(item.first) << "] = \"" << item.second << "\"" << std::endl;
 
       std::cout << indent_str << "}" << std::endl;
     }
@@ -101,13 +135,14 @@ namespace mtemplate {
   //-----------------------------------------------------------------------------------
   //  Dictionary stuff
   //-----------------------------------------------------------------------------------
-  void Dictionary::setValue(const base::utf8string &key, const base::utf8string &value) {
+  void Dictionary::setValue(Slot key, const base::utf8string &value) {
     _dictionary[key] = value;
   }
 
-  base::utf8string Dictionary::getValue(const base::utf8string &key) {
-    if (_dictionary.find(key) != _dictionary.end())
-      return _dictionary[key];
+  const base::utf8string &Dictionary::getValue(Slot key) {
+    dictionary_storage::const_iterator value = _dictionary.find(key);
+    if (value != _dictionary.end())
+      return value->second;
 
     if (_parent)
       return _parent->getValue(key);
@@ -119,18 +154,20 @@ namespace mtemplate {
     base::utf8string newName = _name + name + base::utf8string("/");
     DictionaryInterface *_sectionDict = new Dictionary(newName, this);
 
-    if (_section_dictionaries[name].size() > 0)
-      _section_dictionaries[name].back()->setIsLast(false);
+    section_dictionary_storage &section = _section_dictionaries[GetSlot(name)];
+    if (section.size() > 0)
+      section.back()->setIsLast(false);
 
     _sectionDict->setIsLast(true);
-    _section_dictionaries[name].push_back(_sectionDict);
+    section.push_back(_sectionDict);
     return _sectionDict;
   }
 
-  Dictionary::section_dictionary_storage &Dictionary::getSectionDictionaries(const base::utf8string &section) {
-    if (_section_dictionaries.find(section) == _section_dictionaries.end())
+  Dictionary::section_dictionary_storage &Dictionary::getSectionDictionaries(Slot section) {
+    section_storage::iterator dictionaries = _section_dictionaries.find(section);
+    if (dictionaries == _section_dictionaries.end())
       return _no_section;
-    return _section_dictionaries[section];
+    return dictionaries->second;
   }
 
   void Dictionary::dump(int indent) {
@@ -146,7 +183,7 @@ namespace mtemplate {
     std::cout << indent_str << "[" << _name << "] = " << std::endl << indent_str << "{" << std::endl;
 
     for (auto item : _dictionary)
-      std::cout << indent_plus_str << "[" << item.first << "] = \"" << item.second << "\"" << std::endl;
+      std::cout << indent_plus_str << "[" << GetSlotName(item.first) << "] = \"" << item.second << "\"" << std::endl;
 
     for (auto dict_item : _section_dictionaries)
       for (auto sect_item : dict_item.second)
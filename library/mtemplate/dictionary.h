@@ -38,6 +38,14 @@ namespace mtemplate {
   struct NodeSection;
   class Template;
 
+  /**
+   * Variable and section names are resolved to slots once, when a template is parsed or a value is set. Lookups during
+   * expansion then compare integers instead of collating utf8 strings.
+   */
+  typedef std::size_t Slot;
+  MTEMPLATELIBRARY_PUBLIC_FUNC Slot GetSlot(const base::utf8string &name);
+  MTEMPLATELIBRARY_PUBLIC_FUNC const base::utf8string &GetSlotName(Slot slot);
+
   class MTEMPLATELIBRARY_PUBLIC_FUNC DictionaryInterface {
   protected:
     base::utf8string _name;
@@ -46,13 +54,13 @@ namespace mtemplate {
     DictionaryInterface(const base::utf8string &name) : _name(name), _is_last(false) {
     }
 
-    typedef std::map<base::utf8string, base::utf8string> dictionary_storage;
+    typedef std::map<Slot, base::utf8string> dictionary_storage;
     typedef dictionary_storage::iterator dictionary_storage_iterator;
 
     typedef std::vector<DictionaryInterface *> section_dictionary_storage;
     typedef section_dictionary_storage::iterator section_dictionary_storage_iterator;
 
-    typedef std::map<base::utf8string, section_dictionary_storage> section_storage;
+    typedef std::map<Slot, section_dictionary_storage> section_storage;
 
     virtual DictionaryInterface *getParent() = 0;
 
@@ -63,8 +71,15 @@ namespace mtemplate {
     virtual ~DictionaryInterface() {
     }
 
-    virtual void setValue(const base::utf8string &key, const base::utf8string &value) = 0;
-    virtual base::utf8string getValue(const base::utf8string &key) = 0;
+    virtual void setValue(Slot key, const base::utf8string &value) = 0;
+    virtual const base::utf8string &getValue(Slot key) = 0;
+
+    void setValue(const base::utf8string &key, const base::utf8string &value) {
+      setValue(GetSlot(key), value);
+    }
+    base::utf8string getValue(const base::utf8string &key) {
+      return getValue(GetSlot(key));
+    }
 
     void setIntValue(const base::utf8string &key, long value);
     void setValueAndShowSection(const base::utf8string &key, const base::utf8string &value,
@@ -72,7 +87,10 @@ namespace mtemplate {
     void setFormatedValue(const base::utf8string &key, const char *format, ...); // G_GNUC_PRINTF(2, 3);
 
     virtual DictionaryInterface *addSectionDictionary(const base::utf8string &name) = 0;
-    virtual section_dictionary_storage &getSectionDictionaries(const base::utf8string &sections) = 0;
+    virtual section_dictionary_storage &getSectionDictionaries(Slot section) = 0;
+    section_dictionary_storage &getSectionDictionaries(const base::utf8string &section) {
+      return getSectionDictionaries(GetSlot(section));
+    }
 
     void setIsLast(bool value) {
       _is_last = value;
@@ -104,11 +122,15 @@ namespace mtemplate {
     }
 
     //  DictionaryInterface
-    virtual void setValue(const base::utf8string &key, const base::utf8string &value);
-    virtual base::utf8string getValue(const base::utf8string &key);
+    using DictionaryInterface::setValue;
+    using DictionaryInterface::getValue;
+    using DictionaryInterface::getSectionDictionaries;
+
+    virtual void setValue(Slot key, const base::utf8string &value);
+    virtual const base::utf8string &getValue(Slot key);
 
     virtual DictionaryInterface *addSectionDictionary(const base::utf8string &name);
-    virtual section_dictionary_storage &getSectionDictionaries(const base::utf8string &section);
+    virtual section_dictionary_storage &getSectionDictionaries(Slot section);
 
     virtual void dump(int indent = 0);
   };
@@ -24,6 +24,8 @@
 #include "output.h"
 #include <base/file_functions.h>
 
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+
 namespace mtemplate {
 
   TemplateOutput::TemplateOutput() {
@@ -47,10 +49,23 @@ namespace mtemplate {
   //  TemplateOutputFile stuff
   //-----------------------------------------------------------------------------------
   TemplateOutputFile::TemplateOutputFile(const base::utf8string &filename) : _file(filename.c_str(), "w+") {
+    _buffer.reserve(OUTPUT_BUFFER_SIZE);
+  }
+
+  TemplateOutputFile::~TemplateOutputFile() {
+    flush();
   }
 
   void TemplateOutputFile::out(const base::utf8string &str) {
-    fwrite(str.data(), 1, str.bytes(), _file.file());
+    _buffer.append(str.c_str(), str.bytes());
+    if (_buffer.size() >= OUTPUT_BUFFER_SIZE)
+      flush();
+  }
+
+  void TemplateOutputFile::flush() {
+    if (!_buffer.empty() && _file.file() != NULL)
+      fwrite(_buffer.data(), 1, _buffer.size(), _file.file());
+    _buffer.clear();
   }
 
 } //  namespace mtemplate
@@ -27,6 +27,8 @@
 
 #include "base/utf8string.h"
 #include "base/file_utilities.h"
+
+#include <string>
 // class FILE;
 
 namespace mtemplate {
@@ -47,12 +49,16 @@ namespace mtemplate {
     const base::utf8string &get();
   };
 
+  //  Output is collected and written in large blocks, the file is complete once the object is destroyed or flushed.
   class MTEMPLATELIBRARY_PUBLIC_FUNC TemplateOutputFile : public TemplateOutput {
     base::FileHandle _file;
+    std::string _buffer;
 
   public:
     TemplateOutputFile(const base::utf8string &filename);
+    virtual ~TemplateOutputFile();
     virtual void out(const base::utf8string &str);
+    void flush();
   };
 
 } //  namespace mtemplate
@@ -25,6 +25,8 @@
 #include <base/file_functions.h>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include "dictionary.h"
 #include "modifier.h"
 
@@ -54,7 +56,8 @@ namespace mtemplate {
   void Template::expand(DictionaryInterface *dict, TemplateOutput *output) {
     for (NodeStorageType node : _document) {
       if (node->type() == TemplateObject_Section) {
-        DictionaryInterface::section_dictionary_storage &section_dicts = dict->getSectionDictionaries(node->_text);
+        DictionaryInterface::section_dictionary_storage &section_dicts =
+          dict->getSectionDictionaries(static_cast<NodeSection *>(node.get())->_slot);
 
         for (DictionaryInterface::section_dictionary_storage_iterator section_iter = section_dicts.begin();
              section_iter != section_dicts.end(); ++section_iter)
@@ -64,6 +67,15 @@ namespace mtemplate {
     }
   }
 
+  //  Parsed templates by file and parse type. Callers never free what GetTemplate returns, so an entry replaced after
+  //  its file changed is left alive for whoever still holds it.
+  struct CachedTemplate {
+    Template *_template;
+    time_t _mtime;
+  };
+  static std::mutex TemplateCacheMutex;
+  static std::map<std::pair<std::string, int>, CachedTemplate> TemplateCache;
+
   Template *GetTemplate(const base::utf8string &path, PARSE_TYPE type) {
     if (type == STRIP_WHITESPACE)
       throw std::invalid_argument("STRIP_WHITESPACE");
@@ -71,13 +83,22 @@ namespace mtemplate {
     if (base::file_exists(path) == false)
       return NULL;
 
+    time_t mtime = 0;
+    base::file_mtime(path, mtime);
+
+    std::lock_guard<std::mutex> lock(TemplateCacheMutex);
+    CachedTemplate &cached = TemplateCache[std::make_pair(std::string(path), (int)type)];
+    if (cached._template != NULL && cached._mtime == mtime)
+      return cached._template;
+
     std::ifstream file(path);
     std::stringstream buffer;
     buffer << file.rdbuf();
 
-    Template *temp = new Template(parseTemplate(buffer.str(), type));
+    cached._template = new Template(parseTemplate(buffer.str(), type));
+    cached._mtime = mtime;
 
-    return temp;
+    return cached._template;
   }
 
 } //  namespace mtemplate
@@ -100,11 +100,17 @@ namespace mtemplate {
     if (isHidden())
       return true;
 
-    base::utf8string result = dict->getValue(_text);
+    const base::utf8string &value = dict->getValue(_slot);
 
     //   if (result == "")
     //     std::cout << "WARNING: value for " << _text << " is an empty string" << std::endl;
 
+    if (_modifiers.empty()) {
+      output->out(value);
+      return true;
+    }
+
+    base::utf8string result = value;
     for (std::vector<ModifierAndArgument>::iterator iter = _modifiers.begin(); iter != _modifiers.end(); ++iter) {
       Modifier *mod = mtemplate::GetModifier(iter->_name);
       if (mod)
@@ -158,7 +164,8 @@ namespace mtemplate {
   //  NodeSection stuff
   //-----------------------------------------------------------------------------------
   NodeSection::NodeSection(const base::utf8string &text, std::size_t length, TemplateDocument &contents)
-    : NodeInterface(TemplateObject_Section, text, length), _contents(contents), _is_separator(false) {
+    : NodeInterface(TemplateObject_Section, text, length), _contents(contents), _is_separator(false),
+      _slot(GetSlot(text)) {
   }
   //-----------------------------------------------------------------------------------
   bool NodeSection::expand(TemplateOutput *output, DictionaryInterface *dict) {
@@ -168,13 +175,13 @@ namespace mtemplate {
     for (NodeStorageType node : _contents) {
       if (node->type() == TemplateObject_Section) {
         //    Check for separator sections special marker
-        NodeSection *sec = dynamic_cast<NodeSection *>(node.get());
+        NodeSection *sec = static_cast<NodeSection *>(node.get());
         if (sec->is_separator() && dict->isLast() == false) {
           node->expand(output, dict);
           continue;
         }
 
-        DictionaryInterface::section_dictionary_storage &section_dicts = dict->getSectionDictionaries(node->_text);
+        DictionaryInterface::section_dictionary_storage &section_dicts = dict->getSectionDictionaries(sec->_slot);
 
         for (DictionaryInterface *item : section_dicts)
           node->expand(output, item);
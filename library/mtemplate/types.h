@@ -25,6 +25,7 @@
 
 #include "common.h"
 #include "modifier.h"
+#include "dictionary.h"
 
 #include "base/utf8string.h"
 #include <vector>
@@ -41,7 +42,6 @@ namespace mtemplate {
   };
 
   struct TemplateOutput;
-  class DictionaryInterface;
 
   /**
    * @brief This is the base type for all other node types
@@ -129,8 +129,9 @@ namespace mtemplate {
 
   struct MTEMPLATELIBRARY_PUBLIC_FUNC NodeVariable : public NodeTextInterface {
     std::vector<ModifierAndArgument> _modifiers;
+    Slot _slot;
     NodeVariable(const base::utf8string &text, std::size_t length, const std::vector<ModifierAndArgument> &modifiers)
-      : NodeTextInterface(TemplateObject_Variable, text, length), _modifiers(modifiers) {
+      : NodeTextInterface(TemplateObject_Variable, text, length), _modifiers(modifiers), _slot(GetSlot(text)) {
     }
 
     virtual bool expand(TemplateOutput *output, DictionaryInterface *dict);
@@ -143,6 +144,7 @@ namespace mtemplate {
     TemplateDocument _contents;
     TemplateDocument::iterator _separator;
     bool _is_separator;
+    Slot _slot;
 
     NodeSection(const base::utf8string &text, std::size_t length, TemplateDocument &contents);
 
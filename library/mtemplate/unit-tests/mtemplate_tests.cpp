@@ -253,4 +253,30 @@ TEST_FUNCTION(4) {
               compare_file_contents("data/mtemplate/test_result.html", "test_output/test_result.html"));
 }
 
+TEST_FUNCTION(5) {
+  //    Parsed templates are cached, the same file gives the same template until it changes.
+  mtemplate::Template *first = mtemplate::GetTemplate("data/mtemplate/CSV_semicolon.tpl");
+  mtemplate::Template *second = mtemplate::GetTemplate("data/mtemplate/CSV_semicolon.tpl");
+  ensure("Template loaded", first != nullptr);
+  ensure_equals("Cached template", first, second);
+
+  //    Values set by name are found through their slot, in the dictionary itself and in its parents.
+  mtemplate::DictionaryInterface *dictionary = mtemplate::CreateMainDictionary();
+  dictionary->setValue("TABLE_NAME", "languages");
+  mtemplate::DictionaryInterface *row = dictionary->addSectionDictionary("ROW");
+  row->setValueAndShowSection("FIELD_VALUE", "English", "FIELD");
+
+  mtemplate::Slot slot = mtemplate::GetSlot("TABLE_NAME");
+  ensure_equals("Same slot for the same name", slot, mtemplate::GetSlot("TABLE_NAME"));
+  ensure_equals("Slot name", std::string(mtemplate::GetSlotName(slot)), "TABLE_NAME");
+  ensure_equals("Value by slot", std::string(dictionary->getValue(slot)), "languages");
+  ensure_equals("Value from parent", std::string(row->getValue("TABLE_NAME")), "languages");
+  ensure_equals("Unknown value", std::string(row->getValue("NOT_SET")), "");
+  ensure_equals("Section by slot", dictionary->getSectionDictionaries(mtemplate::GetSlot("ROW")).size(), (size_t)1);
+
+  mtemplate::TemplateOutputString output;
+  first->expand(dictionary, &output);
+  ensure("Expanded row", std::string(output.get()).find("English") != std::string::npos);
+}
+
 END_TESTS
@@ -58,9 +58,19 @@ void AreaGroup::repaint_contents(const Rect &localClipArea, bool direct) {
       cr->translate(get_position());
     }
 
-    for (std::list<CanvasItem *>::reverse_iterator iter = _contents.rbegin(); iter != _contents.rend(); ++iter) {
-      if ((*iter)->get_visible() && (*iter)->intersects(localClipArea))
-        (*iter)->repaint(localClipArea, direct);
+    SpatialIndex *index = get_index();
+    if (index) {
+      // Large diagrams: only visit what the index has near the clip area, bottom-most first.
+      std::vector<CanvasItem *> candidates(index->items_intersecting(localClipArea));
+      for (std::vector<CanvasItem *>::reverse_iterator iter = candidates.rbegin(); iter != candidates.rend(); ++iter) {
+        if ((*iter)->get_visible() && (*iter)->intersects(localClipArea))
+          (*iter)->repaint(localClipArea, direct);
+      }
+    } else {
+      for (std::list<CanvasItem *>::reverse_iterator iter = _contents.rbegin(); iter != _contents.rend(); ++iter) {
+        if ((*iter)->get_visible() && (*iter)->intersects(localClipArea))
+          (*iter)->repaint(localClipArea, direct);
+      }
     }
     if (_layer->get_view()->has_gl() && !direct) {
       glMatrixMode(GL_MODELVIEW);
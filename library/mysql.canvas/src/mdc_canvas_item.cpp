@@ -78,13 +78,14 @@ CanvasItem::CanvasItem(Layer *layer) : _layer(layer), _parent(0) {
   _content_cache = 0;
   _content_texture = 0;
   _display_list = 0;
+  _texture_zoom = 0;
 
   _fixed_min_size = Size(-1, -1);
   _fixed_size = Size(-1, -1);
 
   _bounds_changed_signal.connect(std::bind(&CanvasItem::update_handles, this));
 
-  scoped_connect(layer->get_view()->signal_zoom_changed(), std::bind(&CanvasItem::invalidate_cache, this));
+  scoped_connect(layer->get_view()->signal_zoom_changed(), std::bind(&CanvasItem::zoom_changed, this));
 }
 
 CanvasItem::~CanvasItem() {
@@ -131,6 +132,8 @@ void CanvasItem::set_bounds(const Rect &rect) {
     _size = rect.size;
 
     //  _bounds_changed_signal.emit(obounds);
+    if (_parent)
+      _parent->child_bounds_changed(this);
 
     update_handles();
   }
@@ -143,6 +146,8 @@ void CanvasItem::set_position(const Point &pos) {
     _pos = pos.round();
 
     _bounds_changed_signal(obounds);
+    if (_parent)
+      _parent->child_bounds_changed(this);
 
     update_handles();
   }
@@ -155,6 +160,8 @@ void CanvasItem::set_size(const Size &size) {
     _size = size;
 
     _bounds_changed_signal(obounds);
+    if (_parent)
+      _parent->child_bounds_changed(this);
 
     update_handles();
   }
@@ -260,6 +267,8 @@ void CanvasItem::set_fixed_size(const Size &size) {
   _fixed_size = size;
   _size = size;
   _bounds_changed_signal(obounds);
+  if (_parent)
+    _parent->child_bounds_changed(this);
   set_needs_relayout();
 }
 
@@ -388,6 +397,13 @@ void CanvasItem::invalidate_cache() {
   set_needs_render();
 }
 
+void CanvasItem::zoom_changed() {
+  // An OpenGL texture is scaled by the view transformation while zooming and refreshed later in repaint_gl.
+  if (_layer->get_view()->has_gl() && _content_texture != 0)
+    return;
+  invalidate_cache();
+}
+
 void CanvasItem::set_has_shadow(bool flag) {
   if (_has_shadow != flag) {
     _has_shadow = flag;
@@ -649,11 +665,15 @@ void CanvasItem::repaint_gl(const Rect &clipArea) {
   // if direct gl render wasn't available, then use the cache as a texture and render
   // that instead
   bool generate_display_list = _display_list == 0;
+  float zoom = _layer->get_view()->get_zoom();
 
   // Check if we need to regenerate the cache. if so, do it and load it as a texture.
+  // A texture that is only out of date because the zoom changed is kept until the view has time to refresh it.
   Size texture_size = get_texture_size(Size(0, 0));
-  if (_needs_render || _content_texture == 0) {
+  if (_needs_render || _content_texture == 0 ||
+      (_texture_zoom != zoom && _layer->get_view()->take_texture_refresh())) {
     generate_display_list = true;
+    _texture_zoom = zoom;
 
     // _content_cache is the bitmap with image data, we load that as a texture and release it.
     regenerate_cache(texture_size);
@@ -673,8 +693,6 @@ void CanvasItem::repaint_gl(const Rect &clipArea) {
 
     glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     // don't tile the image
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
@@ -743,6 +761,12 @@ void CanvasItem::repaint_gl(const Rect &clipArea) {
     glEndList();
   }
 
+  // Texels map 1:1 to pixels at the zoom the texture was made for, otherwise it is scaled and must be filtered.
+  GLint filter = _texture_zoom == zoom ? GL_NEAREST : GL_LINEAR;
+  glBindTexture(GL_TEXTURE_2D, _content_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+
   glCallList(_display_list);
 
   glPopMatrix();
@@ -756,11 +780,35 @@ void CanvasItem::repaint(const Rect &clipArea, bool direct) {
   else {
     if (direct)
       repaint_direct();
-    else
+    else if (!_layer->get_view()->low_detail_rendering() || !repaint_low_detail())
       repaint_cached();
   }
 }
 
+/**
+ * Paints the simplified version of the item used at low zoom levels. Returns false if the item has none,
+ * in which case the normal rendering must be used.
+ */
+bool CanvasItem::repaint_low_detail() {
+  CairoCtx *ccr = _layer->get_view()->cairoctx();
+
+  ccr->save();
+  bool done = render_low_detail(ccr);
+  ccr->restore();
+
+  if (done && _needs_render) {
+    // The cache is stale now, drop it so that it gets rebuilt when the item is shown in full detail again.
+    if (_content_cache) {
+      _layer->get_view()->bookkeep_cache_mem(-cairo_image_surface_get_stride(_content_cache) *
+                                             cairo_image_surface_get_height(_content_cache));
+      cairo_surface_destroy(_content_cache);
+      _content_cache = 0;
+    }
+    _needs_render = false;
+  }
+  return done;
+}
+
 void CanvasItem::repaint_direct() {
   CairoCtx *ccr = _layer->get_view()->cairoctx();
 
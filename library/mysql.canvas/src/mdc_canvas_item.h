@@ -147,6 +147,7 @@ namespace mdc {
 
     void set_cache_toplevel_contents(bool flag);
     void invalidate_cache();
+    void zoom_changed();
 
     void set_has_shadow(bool flag);
 
@@ -154,6 +155,10 @@ namespace mdc {
     void relayout();
     virtual void repaint(const base::Rect &clipRect, bool direct);
     virtual void render(CairoCtx *cr);
+    /** Draws a cheap outline of the item when the view is zoomed out far. Return false to get the normal rendering. */
+    virtual bool render_low_detail(CairoCtx *cr) {
+      return false;
+    }
     void repaint_gl(const base::Rect &clipRect);
     virtual void render_gl(mdc::CairoCtx *cr);
     void render_to_surface(cairo_surface_t *surf, bool use_padding = true);
@@ -269,12 +274,17 @@ namespace mdc {
     static void *parent_destroyed(void *data);
 
   protected:
+    // Called on the parent whenever the bounds of one of its children changed.
+    virtual void child_bounds_changed(CanvasItem *item) {
+    }
+
     Layer *_layer;
     CanvasItem *_parent;
 
     cairo_surface_t *_content_cache;
     GLuint _content_texture;
     GLuint _display_list; // OpenGL's rendering list for this item.
+    float _texture_zoom;  // Zoom factor _content_texture was rasterized for.
 
     std::string _tag;
 
@@ -327,6 +337,7 @@ namespace mdc {
     base::Size get_texture_size(base::Size size);
     void repaint_direct();
     void repaint_cached();
+    bool repaint_low_detail();
     void regenerate_cache(base::Size size);
 
     // virtual bool can_drag_handle_to(const base::Point &pos);
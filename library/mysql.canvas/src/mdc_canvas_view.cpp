@@ -23,6 +23,9 @@
 
 #include "base/file_utilities.h"
 #include "base/threading.h"
+#include "base/mem_stat.h"
+
+#include <png.h>
 
 #ifndef _WIN32
 #include <cairo/cairo-pdf.h>
@@ -49,6 +52,19 @@ using namespace base;
 // XXX: use the values defined by the platform!
 #define DOUBLE_CLICK_TIME 0.5
 
+// Edge length of a backing store tile, in device pixels.
+#define TILE_SIZE 256
+// Device pixels added around invalidated areas, for antialiasing and line ends.
+#define TILE_INVALIDATION_PAD 4
+#define DEFAULT_TILE_CACHE_LIMIT (64 * 1024 * 1024)
+#define DEFAULT_LOW_DETAIL_ZOOM 0.5f
+
+// Number of item textures re-rasterized per OpenGL frame after a zoom change, the others are scaled meanwhile.
+#define TEXTURE_REFRESHES_PER_FRAME 24
+
+// Maximum size of the pixel buffer a PNG export renders into at a time.
+#define EXPORT_STRIP_BYTES (16 * 1024 * 1024)
+
 #include <stdio.h>
 
 struct CanvasAutoLock {
@@ -101,15 +117,32 @@ CanvasView::CanvasView(int width, int height) : _fps(0), _total_item_cache_mem(0
   _destroying = false;
   _debug = false;
 
+  _tile_zoom = 0;
+  _tile_frame = 0;
+  _tile_cache_limit = DEFAULT_TILE_CACHE_LIMIT;
+  _tile_cache_enabled = true;
+  _low_detail_zoom = DEFAULT_LOW_DETAIL_ZOOM;
+  _texture_refresh_budget = TEXTURE_REFRESHES_PER_FRAME;
+  _texture_refresh_pending = false;
+
+  _line_batch = 0;
+
   _blayer = new BackLayer(this);
   _ilayer = new InteractionLayer(this);
 
   _current_layer = new_layer("Default Layer");
 
   _selection = new Selection(this);
+
+  _memory_source =
+    base::MemoryAccounting::add_source("Canvas item caches", [this](base::MemoryAccounting::Usage &usage) {
+      usage.bytes = _total_item_cache_mem;
+      usage.items = 1;
+    });
 }
 
 CanvasView::~CanvasView() {
+  base::MemoryAccounting::remove_source(_memory_source);
   delete _blayer;
   delete _ilayer;
 
@@ -125,6 +158,8 @@ CanvasView::~CanvasView() {
   delete _selection;
   _selection = 0;
 
+  clear_tiles();
+
   delete _cairo;
 
   if (_crsurface) {
@@ -436,6 +471,7 @@ void CanvasView::add_layer(Layer *layer) {
 
   _layers.push_front(layer);
 
+  invalidate_tiles();
   queue_repaint();
 }
 
@@ -450,6 +486,7 @@ void CanvasView::remove_layer(Layer *layer) {
     else
       _current_layer = _layers.front();
   }
+  invalidate_tiles();
   queue_repaint();
 }
 
@@ -467,6 +504,7 @@ void CanvasView::raise_layer(Layer *layer, Layer *above) {
 
   restack_up(_layers, layer, above);
 
+  invalidate_tiles();
   queue_repaint();
 }
 
@@ -475,6 +513,7 @@ void CanvasView::lower_layer(Layer *layer) {
 
   restack_down(_layers, layer);
 
+  invalidate_tiles();
   queue_repaint();
 }
 
@@ -489,31 +528,157 @@ static bool is_line(CanvasItem *item) {
 
 void CanvasView::set_draws_line_hops(bool flag) {
   _line_hop_rendering = flag;
+  invalidate_tiles();
   queue_repaint();
 }
 
+void CanvasView::set_tile_cache_enabled(bool flag) {
+  if (_tile_cache_enabled != flag) {
+    _tile_cache_enabled = flag;
+    clear_tiles();
+    queue_repaint();
+  }
+}
+
+/**
+ * Sets the memory (in bytes) the tile backing store may use. Tiles on screen are kept even if they exceed it.
+ */
+void CanvasView::set_tile_cache_limit(size_t bytes) {
+  _tile_cache_limit = bytes;
+  trim_tiles();
+}
+
+static inline int tile_index(double device_coordinate) {
+  return (int)floor(device_coordinate / TILE_SIZE);
+}
+
+/**
+ * Marks all tiles as outdated. Content layers call this (or the variant with bounds) whenever they queue a repaint.
+ */
+// Tiles are invalidated whenever the contents of the content layers change, so these also report the damage.
+void CanvasView::invalidate_tiles() {
+  for (TileMap::iterator iter = _tiles.begin(); iter != _tiles.end(); ++iter)
+    iter->second.valid = false;
+
+  _content_damaged_signal(Rect());
+}
+
+void CanvasView::invalidate_tiles(const Rect &bounds) {
+  _content_damaged_signal(bounds);
+
+  if (_tiles.empty())
+    return;
+
+  int left = tile_index(bounds.left() * _tile_zoom - _tile_phase.x - TILE_INVALIDATION_PAD);
+  int top = tile_index(bounds.top() * _tile_zoom - _tile_phase.y - TILE_INVALIDATION_PAD);
+  int right = tile_index(bounds.right() * _tile_zoom - _tile_phase.x + TILE_INVALIDATION_PAD);
+  int bottom = tile_index(bounds.bottom() * _tile_zoom - _tile_phase.y + TILE_INVALIDATION_PAD);
+
+  for (TileMap::iterator iter = _tiles.begin(); iter != _tiles.end(); ++iter) {
+    if (iter->first.first >= left && iter->first.first <= right && iter->first.second >= top &&
+        iter->first.second <= bottom)
+      iter->second.valid = false;
+  }
+}
+
+void CanvasView::clear_tiles() {
+  for (TileMap::iterator iter = _tiles.begin(); iter != _tiles.end(); ++iter) {
+    if (iter->second.surface)
+      cairo_surface_destroy(iter->second.surface);
+  }
+  _tiles.clear();
+}
+
+/**
+ * Drops the least recently painted tiles until the cache fits into its memory limit.
+ */
+void CanvasView::trim_tiles() {
+  const size_t tile_bytes = TILE_SIZE * TILE_SIZE * 4;
+
+  while (_tiles.size() * tile_bytes > _tile_cache_limit) {
+    TileMap::iterator oldest = _tiles.end();
+    for (TileMap::iterator iter = _tiles.begin(); iter != _tiles.end(); ++iter) {
+      if (iter->second.last_used != _tile_frame &&
+          (oldest == _tiles.end() || iter->second.last_used < oldest->second.last_used))
+        oldest = iter;
+    }
+    if (oldest == _tiles.end()) // Everything left is on screen.
+      break;
+
+    if (oldest->second.surface)
+      cairo_surface_destroy(oldest->second.surface);
+    _tiles.erase(oldest);
+  }
+}
+
+void CanvasView::set_low_detail_zoom(float zoom) {
+  if (_low_detail_zoom != zoom) {
+    _low_detail_zoom = zoom;
+    invalidate_tiles();
+    queue_repaint();
+  }
+}
+
+/**
+ * Starts collecting line relayouts instead of doing them right away. Moving a group of figures makes each
+ * connector of a line report its change separately. In a batch every affected line is relayouted only once,
+ * after all figures have moved, and the view is repainted once for all of them. Batches can be nested.
+ */
+void CanvasView::begin_line_batch() {
+  _line_batch++;
+}
+
+void CanvasView::end_line_batch() {
+  if (_line_batch == 0)
+    throw std::logic_error("end_line_batch() called without matching begin_line_batch()");
+  if (--_line_batch > 0 || _batched_lines.empty())
+    return;
+
+  std::set<Line *> lines;
+  lines.swap(_batched_lines);
+
+  lock_redraw();
+  for (std::set<Line *>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
+    (*iter)->update_layout();
+  unlock_redraw();
+}
+
+void CanvasView::defer_line_update(Line *line) {
+  _batched_lines.insert(line);
+}
+
+void CanvasView::drop_line_update(Line *line) {
+  _batched_lines.erase(line);
+}
+
 void CanvasView::update_line_crossings(Line *line) {
   if (!_line_hop_rendering)
     return;
 
-  // get the lines in the same bounding box
+  // crossings of segments that did not move are cached in the lines, only the moved ones need a check
+  if (!line->has_moved_segments())
+    return;
 
-  std::list<CanvasItem *> items = get_items_bounded_by(line->get_root_bounds(), std::ptr_fun(is_line));
+  // get the lines around the moved segments
+  std::list<CanvasItem *> items = get_items_bounded_by(line->get_moved_segments_bounds(), std::ptr_fun(is_line));
 
-  std::list<CanvasItem *>::iterator iter = items.begin();
+  std::list<CanvasItem *>::iterator iter = std::find(items.begin(), items.end(), line);
+  if (iter == items.end())
+    return; // the line is not visible, its moved segments are checked once it is laid out again
 
   // check if the line crosses with anything under it
-  for (; iter != items.end() && *iter != line; ++iter) {
-    line->mark_crossings(static_cast<Line *>(*iter));
+  for (iter = items.begin(); *iter != line; ++iter) {
+    line->update_crossings(static_cast<Line *>(*iter));
   }
 
-  if (iter != items.end())
-    ++iter; // skip the line itself
+  ++iter; // skip the line itself
 
   // then check if anything over it crosses the line
   for (; iter != items.end(); ++iter) {
-    static_cast<Line *>(*iter)->mark_crossings(line);
+    static_cast<Line *>(*iter)->update_crossings(line);
   }
+
+  line->clear_moved_segments();
 }
 
 void CanvasView::remove_item(mdc::CanvasItem *item) {
@@ -683,8 +848,11 @@ void CanvasView::repaint_area(const Rect &aBounds, int wx, int wy, int ww, int w
   Rect clip;
 
   begin_repaint(wx, wy, ww, wh);
-  if (has_gl())
+  if (has_gl()) {
     glGetError(); // Resets error flag.
+    _texture_refresh_budget = TEXTURE_REFRESHES_PER_FRAME;
+    _texture_refresh_pending = false;
+  }
 
   _cairo->save();
 
@@ -713,9 +881,13 @@ void CanvasView::repaint_area(const Rect &aBounds, int wx, int wy, int ww, int w
   _cairo->clip();
 
   // Repaint layers from back to front.
-  for (LayerList::reverse_iterator iter = _layers.rbegin(); iter != _layers.rend(); ++iter) {
-    if ((*iter)->visible())
-      (*iter)->repaint(bounds);
+  if (use_tiles())
+    repaint_layers_tiled(bounds);
+  else {
+    for (LayerList::reverse_iterator iter = _layers.rbegin(); iter != _layers.rend(); ++iter) {
+      if ((*iter)->visible())
+        (*iter)->repaint(bounds);
+    }
   }
 
   _cairo->restore();
@@ -726,6 +898,115 @@ void CanvasView::repaint_area(const Rect &aBounds, int wx, int wy, int ww, int w
   _cairo->restore();
 
   end_repaint();
+
+  // Some items were composited from textures made for another zoom level, continue refining them with the next frame.
+  if (_texture_refresh_pending)
+    queue_repaint();
+}
+
+bool CanvasView::take_texture_refresh() {
+  if (_texture_refresh_budget > 0) {
+    --_texture_refresh_budget;
+    return true;
+  }
+  _texture_refresh_pending = true;
+  return false;
+}
+
+bool CanvasView::use_tiles() const {
+  // OpenGL views keep textures per item already and exports/printouts must render at full quality.
+  return _tile_cache_enabled && !has_gl() && !_printout_mode;
+}
+
+/**
+ * Paints the content layers for the given (canvas) area from the tile backing store, rendering only tiles that
+ * are missing or were invalidated since they were last painted.
+ * The caller has set up the canvas transformation and clipping on the view context.
+ */
+void CanvasView::repaint_layers_tiled(const Rect &bounds) {
+  // Relayouting moves items, which invalidates tiles. So get that done before looking at the tiles.
+  for (LayerList::iterator iter = _layers.begin(); iter != _layers.end(); ++iter)
+    (*iter)->flush_relayout_queue();
+
+  // The device position of the canvas origin, split into whole pixels (used when blitting) and the fraction
+  // that must be baked into the tiles.
+  Point origin((_offset.x - _extra_offset.x) * _zoom, (_offset.y - _extra_offset.y) * _zoom);
+  Point whole(floor(origin.x), floor(origin.y));
+  Point phase(origin.x - whole.x, origin.y - whole.y);
+  if (_zoom != _tile_zoom || phase.x != _tile_phase.x || phase.y != _tile_phase.y) {
+    clear_tiles();
+    _tile_zoom = _zoom;
+    _tile_phase = phase;
+  }
+  ++_tile_frame;
+
+  int left = tile_index(bounds.left() * _zoom - phase.x);
+  int top = tile_index(bounds.top() * _zoom - phase.y);
+  int right = tile_index(bounds.right() * _zoom - phase.x);
+  int bottom = tile_index(bounds.bottom() * _zoom - phase.y);
+
+  _cairo->save();
+  cairo_matrix_t identity;
+  cairo_matrix_init_identity(&identity);
+  cairo_set_matrix(_cairo->get_cr(), &identity);
+
+  for (int y = top; y <= bottom; ++y) {
+    for (int x = left; x <= right; ++x) {
+      Tile &tile = _tiles[std::make_pair(x, y)];
+      if (!tile.valid)
+        render_tile(x, y, tile);
+      tile.last_used = _tile_frame;
+
+      if (tile.surface) {
+        _cairo->set_source_surface(tile.surface, x * TILE_SIZE - whole.x, y * TILE_SIZE - whole.y);
+        _cairo->paint();
+      }
+    }
+  }
+  _cairo->restore();
+
+  trim_tiles();
+}
+
+void CanvasView::render_tile(int x, int y, Tile &tile) {
+  if (!tile.surface) {
+    tile.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, TILE_SIZE, TILE_SIZE);
+    if (cairo_surface_status(tile.surface) != CAIRO_STATUS_SUCCESS) {
+      cairo_surface_destroy(tile.surface);
+      tile.surface = NULL;
+      return;
+    }
+  }
+
+  CairoCtx ctx(tile.surface);
+  ctx.set_operator(CAIRO_OPERATOR_CLEAR);
+  ctx.paint();
+  ctx.set_operator(CAIRO_OPERATOR_OVER);
+
+  cairo_matrix_t matrix;
+  cairo_matrix_init(&matrix, _zoom, 0, 0, _zoom, -x * TILE_SIZE - _tile_phase.x, -y * TILE_SIZE - _tile_phase.y);
+  cairo_set_matrix(ctx.get_cr(), &matrix);
+
+  Rect area((x * TILE_SIZE + _tile_phase.x) / _zoom, (y * TILE_SIZE + _tile_phase.y) / _zoom, TILE_SIZE / _zoom,
+            TILE_SIZE / _zoom);
+  ctx.rectangle(area);
+  ctx.clip();
+
+  // Items draw into whatever cairoctx() returns, so point that to the tile while it is rendered.
+  CairoCtx *view_cairo = _cairo;
+  _cairo = &ctx;
+  try {
+    for (LayerList::reverse_iterator iter = _layers.rbegin(); iter != _layers.rend(); ++iter) {
+      if ((*iter)->visible())
+        (*iter)->repaint(area);
+    }
+  } catch (...) {
+    _cairo = view_cairo;
+    throw;
+  }
+  _cairo = view_cairo;
+
+  tile.valid = true;
 }
 
 void CanvasView::queue_repaint() {
@@ -785,7 +1066,82 @@ Rect CanvasView::get_content_bounds() const {
   return Rect(0, 0, 0, 0);
 }
 
-void CanvasView::export_png(const std::string &filename, bool crop) {
+namespace {
+  /**
+   * Writes a PNG file row by row, so that an export never needs the whole image in memory.
+   * libpng reports errors with longjmp, hence every call into it sets up its own jump target and turns the error
+   * into an exception once no libpng frame is on the stack anymore.
+   */
+  class PngStreamWriter {
+  public:
+    PngStreamWriter(FILE *file, int width, int height) : _png(NULL), _info(NULL), _row(width * 3) {
+      _png = png_create_write_struct(PNG_LIBPNG_VER_STRING, this, &PngStreamWriter::on_error, NULL);
+      if (_png == NULL)
+        throw canvas_error("Could not create PNG writer");
+      _info = png_create_info_struct(_png);
+      if (_info == NULL || setjmp(png_jmpbuf(_png))) {
+        png_destroy_write_struct(&_png, _info ? &_info : NULL);
+        throw canvas_error(_error.empty() ? "Could not create PNG writer" : _error);
+      }
+      png_init_io(_png, file);
+      png_set_IHDR(_png, _info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                   PNG_FILTER_TYPE_DEFAULT);
+      png_write_info(_png, _info);
+    }
+
+    ~PngStreamWriter() {
+      png_destroy_write_struct(&_png, &_info);
+    }
+
+    // Appends the rows of a CAIRO_FORMAT_RGB24 image surface.
+    void write_rows(cairo_surface_t *surface, int rows) {
+      unsigned char *data = cairo_image_surface_get_data(surface);
+      int stride = cairo_image_surface_get_stride(surface);
+      int width = cairo_image_surface_get_width(surface);
+
+      for (int y = 0; y < rows; ++y) {
+        const uint32_t *pixels = (const uint32_t *)(data + y * stride);
+        for (int x = 0; x < width; ++x) {
+          _row[x * 3] = (unsigned char)(pixels[x] >> 16);
+          _row[x * 3 + 1] = (unsigned char)(pixels[x] >> 8);
+          _row[x * 3 + 2] = (unsigned char)pixels[x];
+        }
+        write_row();
+      }
+    }
+
+    void finish() {
+      if (setjmp(png_jmpbuf(_png)))
+        throw canvas_error(_error);
+      png_write_end(_png, NULL);
+    }
+
+  private:
+    png_structp _png;
+    png_infop _info;
+    std::vector<unsigned char> _row;
+    std::string _error;
+
+    void write_row() {
+      if (setjmp(png_jmpbuf(_png)))
+        throw canvas_error(_error);
+      png_write_row(_png, &_row[0]);
+    }
+
+    static void on_error(png_structp png, png_const_charp message) {
+      ((PngStreamWriter *)png_get_error_ptr(png))->_error = message;
+      png_longjmp(png, 1);
+    }
+  };
+}
+
+/**
+ * Renders the diagram into a PNG file. The image is rendered in horizontal strips which are streamed to the file,
+ * so memory use does not depend on the diagram size.
+ * The progress slot is called with the fraction done after each strip, returning false cancels the export.
+ * Returns false if the export was cancelled, in which case the file is removed again.
+ */
+bool CanvasView::export_png(const std::string &filename, bool crop, const ExportProgressSlot &progress) {
   CanvasAutoLock lock(this);
 
   base::FileHandle fh(filename.c_str(), "wb");
@@ -803,24 +1159,49 @@ void CanvasView::export_png(const std::string &filename, bool crop) {
     bounds.size.height += 20;
   }
 
-  cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, (int)bounds.width(), (int)bounds.height());
+  int width = (int)bounds.width();
+  int height = (int)bounds.height();
+  if (width <= 0 || height <= 0)
+    throw canvas_error("Nothing to export");
+
+  int strip_height =
+    std::max(1, std::min(height, EXPORT_STRIP_BYTES / cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, width)));
+  cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, strip_height);
+  bool cancelled = false;
   try {
+    PngStreamWriter writer(fh.file(), width, height);
     CairoCtx ctx(surface);
 
-    ctx.rectangle(0, 0, bounds.width(), bounds.height());
-    ctx.set_color(Color::White());
-    ctx.fill();
-    render_for_export(bounds, &ctx);
+    for (int top = 0; top < height && !cancelled; top += strip_height) {
+      int rows = std::min(strip_height, height - top);
+
+      ctx.save();
+      ctx.rectangle(0, 0, width, strip_height);
+      ctx.set_color(Color::White());
+      ctx.fill();
+      render_for_export(Rect(bounds.left(), bounds.top() + top, width, rows), &ctx);
+      ctx.restore();
+      cairo_surface_flush(surface);
 
-    cairo_status_t status;
+      writer.write_rows(surface, rows);
 
-    if ((status = cairo_surface_write_to_png_stream(surface, &write_to_surface, fh.file())) != CAIRO_STATUS_SUCCESS)
-      throw canvas_error(cairo_status_to_string(status));
+      if (progress && !progress((float)(top + rows) / height))
+        cancelled = true;
+    }
+    if (!cancelled)
+      writer.finish();
   } catch (std::exception) {
     cairo_surface_destroy(surface);
     throw;
   }
   cairo_surface_destroy(surface);
+
+  if (cancelled) {
+    fh.dispose();
+    base::tryRemove(filename);
+    return false;
+  }
+  return true;
 }
 
 void CanvasView::export_pdf(const std::string &filename, const Size &size_in_pt) {
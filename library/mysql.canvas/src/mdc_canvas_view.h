@@ -32,6 +32,8 @@
 #include "mdc_selection.h"
 #include "base/threading.h"
 
+#include <map>
+
 #ifndef _WIN32
 #include <glib.h>
 #endif
@@ -137,6 +139,23 @@ namespace mdc {
 
     void set_draws_line_hops(bool flag);
 
+    void set_tile_cache_enabled(bool flag);
+    void set_tile_cache_limit(size_t bytes);
+    void invalidate_tiles();
+    void invalidate_tiles(const base::Rect &bounds);
+
+    void set_low_detail_zoom(float zoom);
+    /** True when items should draw a simplified version of themselves (see CanvasItem::render_low_detail). */
+    bool low_detail_rendering() const {
+      return _zoom < _low_detail_zoom && !_printout_mode;
+    }
+
+    /**
+     * OpenGL only: asks for permission to rasterize an item texture again for the current zoom. When the budget of
+     * the current frame is used up the item keeps compositing its old texture and another frame is queued.
+     */
+    bool take_texture_refresh();
+
     Layer *new_layer(const std::string &name);
     void set_current_layer(Layer *layer);
     Layer *get_current_layer() const {
@@ -199,6 +218,14 @@ namespace mdc {
 
     void update_line_crossings(Line *line);
 
+    void begin_line_batch();
+    void end_line_batch();
+    bool in_line_batch() const {
+      return _line_batch > 0;
+    }
+    void defer_line_update(Line *line);
+    void drop_line_update(Line *line);
+
     virtual bool initialize();
 
     const FontSpec &get_default_font();
@@ -219,7 +246,11 @@ namespace mdc {
 
     virtual Surface *create_temp_surface(const base::Size &size) const;
 
-    void export_png(const std::string &filename, bool crop = false);
+    // Called with the fraction of an export done so far, returns false to cancel it.
+    typedef std::function<bool(float)> ExportProgressSlot;
+
+    bool export_png(const std::string &filename, bool crop = false,
+                    const ExportProgressSlot &progress = ExportProgressSlot());
     void export_pdf(const std::string &filename, const base::Size &size_in_pt);
     void export_ps(const std::string &filename, const base::Size &size_in_pt);
     void export_svg(const std::string &filename, const base::Size &size_in_pt);
@@ -235,6 +266,13 @@ namespace mdc {
     boost::signals2::signal<void(int, int, int, int)> *signal_repaint() {
       return &_need_repaint_signal;
     }
+    /**
+     * Emitted with the canvas area whose contents changed, or an empty rect if all of them did. Unlike
+     * signal_repaint() this is not emitted for scrolling, zooming or the interaction layer.
+     */
+    boost::signals2::signal<void(const base::Rect &)> *signal_content_damaged() {
+      return &_content_damaged_signal;
+    }
     boost::signals2::signal<void()> *signal_viewport_changed() {
       return &_viewport_changed_signal;
     }
@@ -299,12 +337,42 @@ namespace mdc {
     bool _destroying;
     bool _debug;
 
+    // Backing store for the content layers, in tiles of TILE_SIZE device pixels. All tiles share the zoom
+    // and sub-pixel phase they were rendered with, so that scrolling by whole pixels can reuse them.
+    struct Tile {
+      cairo_surface_t *surface;
+      bool valid;
+      unsigned int last_used;
+
+      Tile() : surface(NULL), valid(false), last_used(0) {
+      }
+    };
+    typedef std::map<std::pair<int, int>, Tile> TileMap;
+
+    TileMap _tiles;
+    float _tile_zoom;
+    base::Point _tile_phase;
+    unsigned int _tile_frame;
+    size_t _tile_cache_limit;
+    bool _tile_cache_enabled;
+    float _low_detail_zoom;
+
+    // Item textures that may still be rasterized in the current OpenGL frame after a zoom change.
+    int _texture_refresh_budget;
+    bool _texture_refresh_pending;
+
+    // Lines whose connectors moved while a line batch was open, relayouted when it is closed.
+    int _line_batch;
+    std::set<Line *> _batched_lines;
+
     double _fps;
 
     size_t _total_item_cache_mem;
+    int _memory_source; // see base::MemoryAccounting
 
     boost::signals2::signal<void()> _resized_signal;
     boost::signals2::signal<void(int, int, int, int)> _need_repaint_signal;
+    boost::signals2::signal<void(const base::Rect &)> _content_damaged_signal;
     boost::signals2::signal<void()> _viewport_changed_signal;
     boost::signals2::signal<void()> _zoom_changed_signal;
 
@@ -318,6 +386,11 @@ namespace mdc {
     virtual void end_repaint() = 0;
 
     void repaint_area(const base::Rect &rect, int wx, int wy, int ww, int wh);
+    bool use_tiles() const;
+    void repaint_layers_tiled(const base::Rect &bounds);
+    void render_tile(int x, int y, Tile &tile);
+    void trim_tiles();
+    void clear_tiles();
 
     void update_offsets();
     void apply_transformations();
@@ -57,6 +57,10 @@ void CanvasViewExtras::set_progress_callback(const std::function<void(int, int)>
   _progress_cb = progress;
 }
 
+void CanvasViewExtras::set_cancel_callback(const std::function<bool()> &cancelled) {
+  _cancel_cb = cancelled;
+}
+
 void CanvasViewExtras::enable_custom_layout() {
 }
 
@@ -364,6 +368,8 @@ int CanvasViewExtras::render_pages(CairoCtx *cr, double render_scale, int page,
 
         if (_progress_cb)
           _progress_cb(x, y);
+        if (_cancel_cb && _cancel_cb())
+          return printed;
       }
       ++count;
 
@@ -42,6 +42,8 @@ namespace mdc {
     CanvasViewExtras(CanvasView *view);
 
     void set_progress_callback(const std::function<void(int, int)> &progress);
+    // Checked after every page, printing stops when it returns true.
+    void set_cancel_callback(const std::function<bool()> &cancelled);
 
     void enable_custom_layout();
     void set_show_print_guides(bool flag);
@@ -90,6 +92,7 @@ namespace mdc {
     CanvasView *_view;
 
     std::function<void(int, int)> _progress_cb;
+    std::function<bool()> _cancel_cb;
 
     double _page_width;  // in mm
     double _page_height; // in mm
@@ -38,6 +38,10 @@
 #include "mdc_common.h"
 #include "base/file_utilities.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 using namespace mdc;
 
 struct ScaledFont {
@@ -311,12 +315,104 @@ void CairoCtx::set_font(const FontSpec &font) const {
   cairo_set_scaled_font(cr, fm->get_font(font));
 }
 
+//--------------------------------------------------------------------------------------------------
+
+// The cache is simply emptied when it gets this large. Most of it are the names in the diagrams currently open.
+#define MAX_CACHED_TEXT_EXTENTS 100000
+// Fewer texts than this per thread are not worth starting workers for.
+#define MIN_PREFETCH_RUNS_PER_THREAD 64
+
+/**
+ * Text extents shared by all contexts. FontManager creates its scaled fonts with an identity CTM and without
+ * hinting, so the extents of a text only depend on the font spec, not on the context or the thread measuring it.
+ */
+class TextExtentsCache {
+  std::mutex _mutex;
+  std::map<std::string, cairo_text_extents_t> _extents;
+
+public:
+  static std::string make_key(const FontSpec &font, const char *text) {
+    std::string key(font.family);
+    key.push_back('\0');
+    key.push_back((char)font.slant);
+    key.push_back((char)font.weight);
+    key.append((const char *)&font.size, sizeof(font.size));
+    key.append(text);
+    return key;
+  }
+
+  bool lookup(const std::string &key, cairo_text_extents_t &extents) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::map<std::string, cairo_text_extents_t>::const_iterator iter = _extents.find(key);
+    if (iter == _extents.end())
+      return false;
+    extents = iter->second;
+    return true;
+  }
+
+  void store(const std::string &key, const cairo_text_extents_t &extents) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_extents.size() >= MAX_CACHED_TEXT_EXTENTS)
+      _extents.clear();
+    _extents[key] = extents;
+  }
+};
+
+static TextExtentsCache &text_extents_cache() {
+  // Never destroyed, items may still measure text during static destruction.
+  static TextExtentsCache *cache = new TextExtentsCache();
+  return *cache;
+}
+
 void CairoCtx::get_text_extents(const FontSpec &font, const std::string &text, cairo_text_extents_t &extents) {
-  cairo_scaled_font_text_extents(fm->get_font(font), text.c_str(), &extents);
+  get_text_extents(font, text.c_str(), extents);
 }
 
 void CairoCtx::get_text_extents(const FontSpec &font, const char *text, cairo_text_extents_t &extents) {
-  cairo_scaled_font_text_extents(fm->get_font(font), text, &extents);
+  std::string key(TextExtentsCache::make_key(font, text));
+  if (!text_extents_cache().lookup(key, extents)) {
+    cairo_scaled_font_text_extents(fm->get_font(font), text, &extents);
+    text_extents_cache().store(key, extents);
+  }
+}
+
+/**
+ * Measures the given runs of text on worker threads, so that the get_text_extents() calls made for them
+ * later (e.g. when relayouting many items at once) are served from the cache.
+ * Only texts not measured yet are considered and nothing is done if there are too few for threads to pay off.
+ */
+void mdc::prefetch_text_extents(const std::vector<TextRun> &runs) {
+  std::vector<const TextRun *> missing;
+  for (std::vector<TextRun>::const_iterator iter = runs.begin(); iter != runs.end(); ++iter) {
+    cairo_text_extents_t extents;
+    if (!text_extents_cache().lookup(TextExtentsCache::make_key(iter->first, iter->second.c_str()), extents))
+      missing.push_back(&*iter);
+  }
+
+  size_t thread_count = std::min((size_t)std::max(1U, std::thread::hardware_concurrency()),
+                                 missing.size() / MIN_PREFETCH_RUNS_PER_THREAD);
+  if (thread_count < 2)
+    return;
+
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i)
+    threads.push_back(std::thread([&]() {
+      // Every worker needs its own context, font manager and scaled fonts.
+      ImageSurface surface(1, 1, CAIRO_FORMAT_ARGB32);
+      CairoCtx ctx(surface);
+      for (size_t index = next++; index < missing.size(); index = next++) {
+        try {
+          cairo_text_extents_t extents;
+          ctx.get_text_extents(missing[index]->first, missing[index]->second, extents);
+        } catch (...) {
+          // Font problems are reported when the text is measured again for real.
+        }
+      }
+    }));
+
+  for (std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread)
+    thread->join();
 }
 
 bool CairoCtx::get_font_extents(const FontSpec &font, cairo_font_extents_t &extents) {
@@ -373,6 +373,9 @@ namespace mdc {
 
   MYSQLCANVAS_PUBLIC_FUNC Timestamp get_time();
 
+  typedef std::pair<FontSpec, std::string> TextRun;
+  MYSQLCANVAS_PUBLIC_FUNC void prefetch_text_extents(const std::vector<TextRun> &runs);
+
   cairo_status_t write_to_surface(void *closure, const unsigned char *data, unsigned int length);
 
 } // End of mdc namespace
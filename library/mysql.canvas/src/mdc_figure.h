@@ -37,6 +37,9 @@ namespace mdc {
     virtual base::Point get_intersection_with_line_to(const base::Point &p);
 
     void set_pen_color(const base::Color &color);
+    const base::Color &get_pen_color() const {
+      return _pen_color;
+    }
     void set_fill_color(const base::Color &color);
     void set_line_width(float width);
 
@@ -33,11 +33,17 @@
 using namespace mdc;
 using namespace base;
 
+// Groups with fewer items than this are searched linearly.
+#define GROUP_INDEX_THRESHOLD 64
+
 Group::Group(Layer *layer) : Layouter(layer) {
 #ifdef no_group_activate
   _activated = false;
 #endif
   _freeze_bounds_updates = 0;
+  _index_valid = false;
+  _index_top = 0;
+  _index_bottom = 0;
 
   set_accepts_focus(true);
   set_accepts_selection(true);
@@ -94,6 +100,8 @@ void Group::add(CanvasItem *item) {
   item->set_parent(this);
 
   _contents.push_front(item);
+  if (_index_valid)
+    _index.insert(item, item->get_bounds(), ++_index_top);
   update_bounds();
 
   if (select)
@@ -113,6 +121,8 @@ void Group::remove(CanvasItem *item) {
 
   item->set_parent(0);
   _contents.remove(item);
+  if (_index_valid)
+    _index.remove(item);
   update_bounds();
 }
 
@@ -181,6 +191,30 @@ void Group::update_bounds() {
   }
 }
 
+void Group::child_bounds_changed(CanvasItem *item) {
+  if (_index_valid)
+    _index.update(item, item->get_bounds());
+}
+
+/**
+ * Returns the spatial index of the group contents, or nullptr if the group is small enough to be
+ * searched linearly. The index is (re)built here when needed, front items get the higher orders.
+ */
+SpatialIndex *Group::get_index() {
+  if (!_index_valid) {
+    if (_contents.size() < GROUP_INDEX_THRESHOLD)
+      return nullptr;
+
+    _index.clear();
+    _index_bottom = 0;
+    _index_top = 0;
+    for (std::list<CanvasItem *>::reverse_iterator iter = _contents.rbegin(); iter != _contents.rend(); ++iter)
+      _index.insert(*iter, (*iter)->get_bounds(), ++_index_top);
+    _index_valid = true;
+  }
+  return &_index;
+}
+
 void Group::foreach (const std::function<void(CanvasItem *)> &slot) {
   for (std::list<CanvasItem *>::const_iterator it = _contents.begin(); it != _contents.end();) {
     std::list<CanvasItem *>::const_iterator next = it;
@@ -202,10 +236,9 @@ void Group::set_selected(bool flag) {
   _layer->queue_repaint(get_bounds());
 }
 
-CanvasItem *Group::get_direct_subitem_at(const Point &point) {
-  Point npoint = point - get_position();
-
-  for (std::list<CanvasItem *>::const_iterator iter = _contents.begin(); iter != _contents.end(); ++iter) {
+template <class Iterator>
+static CanvasItem *find_direct_subitem_at(Iterator begin, Iterator end, const Point &npoint) {
+  for (Iterator iter = begin; iter != end; ++iter) {
     if ((*iter)->get_visible() && (*iter)->contains_point(npoint)) {
       Group *subgroup = dynamic_cast<Group *>((*iter));
       if (subgroup) {
@@ -220,10 +253,20 @@ CanvasItem *Group::get_direct_subitem_at(const Point &point) {
   return 0;
 }
 
-CanvasItem *Group::get_other_item_at(const Point &point, CanvasItem *other_item) {
+CanvasItem *Group::get_direct_subitem_at(const Point &point) {
   Point npoint = point - get_position();
 
-  for (std::list<CanvasItem *>::const_iterator iter = _contents.begin(); iter != _contents.end(); ++iter) {
+  SpatialIndex *index = get_index();
+  if (index) {
+    std::vector<CanvasItem *> candidates(index->items_at(npoint));
+    return find_direct_subitem_at(candidates.begin(), candidates.end(), npoint);
+  }
+  return find_direct_subitem_at(_contents.begin(), _contents.end(), npoint);
+}
+
+template <class Iterator>
+static CanvasItem *find_other_item_at(Iterator begin, Iterator end, const Point &npoint, CanvasItem *other_item) {
+  for (Iterator iter = begin; iter != end; ++iter) {
     if ((*iter)->get_visible() && (*iter)->contains_point(npoint) && *iter != other_item) {
       Layouter *litem = dynamic_cast<Layouter *>(*iter);
       if (litem) {
@@ -238,16 +281,46 @@ CanvasItem *Group::get_other_item_at(const Point &point, CanvasItem *other_item)
   return 0;
 }
 
+CanvasItem *Group::get_other_item_at(const Point &point, CanvasItem *other_item) {
+  Point npoint = point - get_position();
+
+  SpatialIndex *index = get_index();
+  if (index) {
+    std::vector<CanvasItem *> candidates(index->items_at(npoint));
+    return find_other_item_at(candidates.begin(), candidates.end(), npoint, other_item);
+  }
+  return find_other_item_at(_contents.begin(), _contents.end(), npoint, other_item);
+}
+
+/**
+ * Returns the direct children that may intersect the given rectangle (in root coordinates), topmost first.
+ * Without an index all children are returned. Callers still need to check the bounds of the items.
+ */
+std::vector<CanvasItem *> Group::get_direct_subitems_near(const Rect &root_rect) {
+  SpatialIndex *index = get_index();
+  if (index)
+    return index->items_intersecting(Rect(root_rect.pos - get_root_position(), root_rect.size));
+  return std::vector<CanvasItem *>(_contents.begin(), _contents.end());
+}
+
 CanvasItem *Group::get_item_at(const Point &point) {
   return get_other_item_at(point, 0);
 }
 
 void Group::raise_item(CanvasItem *item, CanvasItem *above) {
   restack_up(_contents, item, above);
+  if (_index_valid) {
+    if (above)
+      _index_valid = false; // Renumbered on the next query.
+    else
+      _index.set_order(item, ++_index_top);
+  }
 }
 
 void Group::lower_item(CanvasItem *item) {
   restack_down(_contents, item);
+  if (_index_valid)
+    _index.set_order(item, --_index_bottom);
 }
 
 void Group::move_item(CanvasItem *item, const Point &pos) {
@@ -25,6 +25,7 @@
 #define _MDC_GROUP_H_
 
 #include "mdc_layouter.h"
+#include "mdc_spatial_index.h"
 
 namespace mdc {
 
@@ -54,6 +55,7 @@ namespace mdc {
     void thaw();
 
     CanvasItem *get_direct_subitem_at(const base::Point &point);
+    std::vector<CanvasItem *> get_direct_subitems_near(const base::Rect &root_rect);
     virtual CanvasItem *get_other_item_at(const base::Point &point, CanvasItem *item);
     virtual CanvasItem *get_item_at(const base::Point &point);
 
@@ -78,11 +80,20 @@ namespace mdc {
 
     std::map<CanvasItem *, ItemInfo> _content_info;
     int _freeze_bounds_updates;
+
+    // Grid over the bounds of _contents for hit-testing, built on demand once the group holds many items.
+    SpatialIndex _index;
+    bool _index_valid;
+    long _index_top;
+    long _index_bottom;
 #ifdef no_group_activate
     bool _activated;
 #endif
 
     virtual void update_bounds();
+    virtual void child_bounds_changed(CanvasItem *item);
+
+    SpatialIndex *get_index();
 
     void focus_changed(bool f, CanvasItem *item);
 #ifdef no_group_activate
@@ -28,6 +28,12 @@
 #include "mdc_item_handle.h"
 #include "mdc_area_group.h"
 #include "mdc_selection.h"
+#include "mdc_back_layer.h"
+#include "mdc_interaction_layer.h"
+#include "mdc_text.h"
+
+// Relayouting this many items at once (e.g. after loading a model) measures their texts on worker threads first.
+#define PREFETCH_TEXTS_RELAYOUT_COUNT 32
 
 using namespace mdc;
 using namespace base;
@@ -69,6 +75,8 @@ void Layer::set_visible(bool flag) {
     _visible = flag;
     if (flag)
       queue_repaint();
+    else if (is_tiled())
+      _owner->invalidate_tiles();
     _owner->queue_repaint();
   }
 }
@@ -125,21 +133,47 @@ void Layer::repaint_pending() {
   }
 }
 
-void Layer::repaint(const Rect &bounds) {
+static void collect_text_runs(CanvasItem *item, std::vector<TextRun> &runs) {
+  TextFigure *text = dynamic_cast<TextFigure *>(item);
+  if (text) {
+    // Multiline texts are measured per line (see TextLayout).
+    const std::string &str = text->get_text();
+    for (std::string::size_type start = 0, end; start < str.size(); start = end + 1) {
+      end = str.find('\n', start);
+      if (end == std::string::npos)
+        end = str.size();
+      runs.push_back(TextRun(text->get_font(), str.substr(start, end - start)));
+    }
+  }
+
+  Layouter *layouter = dynamic_cast<Layouter *>(item);
+  if (layouter)
+    layouter->foreach (std::bind(collect_text_runs, std::placeholders::_1, std::ref(runs)));
+}
+
+void Layer::flush_relayout_queue() {
+  if (_relayout_queue.size() >= PREFETCH_TEXTS_RELAYOUT_COUNT) {
+    std::vector<TextRun> runs;
+    for (std::list<CanvasItem *>::iterator iter = _relayout_queue.begin(); iter != _relayout_queue.end(); ++iter)
+      collect_text_runs(*iter, runs);
+    prefetch_text_extents(runs);
+  }
+
   for (std::list<CanvasItem *>::iterator iter = _relayout_queue.begin(); iter != _relayout_queue.end(); ++iter) {
     (*iter)->relayout();
   }
   _relayout_queue.clear();
+}
+
+void Layer::repaint(const Rect &bounds) {
+  flush_relayout_queue();
 
   if (_visible)
     _root_area->repaint(bounds, false);
 }
 
 void Layer::repaint_for_export(const Rect &aBounds) {
-  for (std::list<CanvasItem *>::iterator iter = _relayout_queue.begin(); iter != _relayout_queue.end(); ++iter) {
-    (*iter)->relayout();
-  }
-  _relayout_queue.clear();
+  flush_relayout_queue();
 
   if (_visible)
     _root_area->repaint(aBounds, true);
@@ -147,8 +181,20 @@ void Layer::repaint_for_export(const Rect &aBounds) {
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Only the content layers are painted through the view's tile cache. Background and interaction layers
+ * (grid, handles, rubberband) are painted directly, so their repaints don't invalidate any tile.
+ */
+bool Layer::is_tiled() const {
+  return this != _owner->get_background_layer() && this != _owner->get_interaction_layer();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Layer::queue_repaint() {
   _needs_repaint = true;
+  if (is_tiled())
+    _owner->invalidate_tiles();
   _owner->queue_repaint();
 }
 
@@ -156,6 +202,8 @@ void Layer::queue_repaint() {
 
 void Layer::queue_repaint(const Rect &bounds) {
   _needs_repaint = true;
+  if (is_tiled())
+    _owner->invalidate_tiles(bounds);
   _owner->queue_repaint(bounds);
 }
 
@@ -184,10 +232,10 @@ CanvasItem *Layer::get_top_item_at(const Point &point) {
 }
 
 static std::list<CanvasItem *> get_items_bounded_by(const Rect &rect, const Layer::ItemCheckFunc &pred, Group *group) {
-  std::list<CanvasItem *> &items = group->get_contents();
+  std::vector<CanvasItem *> items(group->get_direct_subitems_near(rect));
   std::list<CanvasItem *> result;
 
-  for (std::list<CanvasItem *>::iterator iter = items.begin(); iter != items.end(); ++iter) {
+  for (std::vector<CanvasItem *>::iterator iter = items.begin(); iter != items.end(); ++iter) {
     Group *g;
 
     if (bounds_intersect((*iter)->get_root_bounds(), rect) && (!pred || pred(*iter)))
@@ -58,6 +58,7 @@ namespace mdc {
     virtual void repaint_pending();
     virtual void repaint(const base::Rect &aBounds);
     void repaint_for_export(const base::Rect &aBounds);
+    void flush_relayout_queue();
 
     inline CanvasView *get_view() const {
       return _owner;
@@ -105,6 +106,7 @@ namespace mdc {
     bool _needs_repaint;
 
     Layer *get_layer_under_this();
+    bool is_tiled() const;
 
   private:
     void view_resized();
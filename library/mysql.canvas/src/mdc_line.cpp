@@ -103,6 +103,16 @@ Line::Line(Layer *layer, LineLayouter *layouter) : Figure(layer), _layouter(0) {
 }
 
 Line::~Line() {
+  for (CrossingMap::iterator iter = _crossings.begin(); iter != _crossings.end(); ++iter)
+    iter->first->_crossed_by.erase(this);
+
+  for (std::set<Line *>::iterator iter = _crossed_by.begin(); iter != _crossed_by.end(); ++iter) {
+    (*iter)->_crossings.erase(this);
+    (*iter)->rebuild_segments();
+  }
+
+  get_view()->drop_line_update(this);
+
   delete _layouter;
 }
 
@@ -115,6 +125,11 @@ void Line::set_layouter(LineLayouter *layouter) {
 }
 
 void Line::update_layout() {
+  if (get_view()->in_line_batch()) {
+    get_view()->defer_line_update(this);
+    return;
+  }
+
   set_vertices(_layouter->get_points());
 
   if (_hop_crossings)
@@ -750,74 +765,227 @@ void Line::set_vertex(size_t vertex, const Point &pos) {
   set_needs_render();
 }
 
-void Line::mark_crossings(Line *line) {
-  // nothing to cross with
-  if (_segments.size() < 2)
-    return;
-  // can't cross with one pointed line
-  // remove any hops we could have on it
-  if (line->_segments.size() < 2) {
-    size_t i = 0;
-    while (i < _segments.size())
-      if (_segments[i].hop == line)
-        _segments.erase(_segments.begin() + i);
-      else
-        i++;
-    return;
-  }
+/**
+ * Returns the segments between the vertices of the line, in root coordinates.
+ */
+std::vector<Line::SegmentEnds> Line::get_root_segments() const {
+  std::vector<SegmentEnds> segments;
+  Point offset = get_root_position() - get_position();
 
-  std::list<SegmentPoint> new_segs;
+  for (size_t i = 1; i < _vertices.size(); ++i)
+    segments.push_back(SegmentEnds(_vertices[i - 1] + offset, _vertices[i] + offset));
+  return segments;
+}
 
-  // look for intersections between our segments and the other line's segments
-  Point p1, p2;
-  Point op1, op2;
-  Point offset = line->get_root_position() - get_root_position();
-  Point intersection;
+//--------------------------------------------------------------------------------------------------
 
-  p1 = _segments.front().pos;
-  new_segs.push_back(_segments.front());
+static void remap_crossings(std::vector<Line::Crossing> &crossings, const std::vector<ptrdiff_t> &old_to_new,
+                            bool own_segment) {
+  size_t target = 0;
+  for (size_t i = 0; i < crossings.size(); ++i) {
+    size_t &segment = own_segment ? crossings[i].segment : crossings[i].other_segment;
+    if (old_to_new[segment] >= 0) {
+      segment = old_to_new[segment];
+      crossings[target++] = crossings[i];
+    }
+  }
+  crossings.erase(crossings.begin() + target, crossings.end());
+}
 
-  for (std::vector<SegmentPoint>::const_iterator segiter = _segments.begin() + 1; segiter != _segments.end();
-       ++segiter) {
-    if (segiter->hop) {
-      // don't pick previous interceptions with given line
-      if (segiter->hop != line)
-        new_segs.push_back(*segiter);
+/**
+ * Called when the vertices changed. Segments that are still in place keep their crossings (just renumbered),
+ * crossings on segments that moved (on this line and on the lines hopping over it) are dropped and the segments
+ * are flagged, so that update_crossings() only has to check those.
+ */
+void Line::update_crossing_segments() {
+  std::vector<SegmentEnds> segments(get_root_segments());
+  std::vector<ptrdiff_t> old_to_new(_crossing_segments.size(), -1);
+  std::vector<bool> moved(segments.size(), true);
+
+  for (size_t i = 0; i < segments.size(); ++i) {
+    for (size_t k = 0; k < _crossing_segments.size(); ++k) {
+      if (old_to_new[k] < 0 && _crossing_segments[k] == segments[i]) {
+        old_to_new[k] = i;
+        moved[i] = _moved_segments[k];
+        break;
+      }
+    }
+  }
+  _crossing_segments.swap(segments);
+  _moved_segments.swap(moved);
+
+  for (CrossingMap::iterator iter = _crossings.begin(); iter != _crossings.end();) {
+    remap_crossings(iter->second, old_to_new, true);
+    if (iter->second.empty()) {
+      iter->first->_crossed_by.erase(this);
+      _crossings.erase(iter++);
+    } else
+      ++iter;
+  }
+
+  for (std::set<Line *>::iterator iter = _crossed_by.begin(); iter != _crossed_by.end();) {
+    Line *other = *iter;
+    CrossingMap::iterator crossings = other->_crossings.find(this);
+    if (crossings == other->_crossings.end()) {
+      _crossed_by.erase(iter++);
       continue;
     }
+    size_t count = crossings->second.size();
 
-    p2 = segiter->pos;
-    op1 = line->_segments.front().pos + offset;
-    for (std::vector<SegmentPoint>::const_iterator oiter = line->_segments.begin() + 1; oiter != line->_segments.end();
-         ++oiter) {
-      // intercept with whole line not with each hop to hop interval
-      if (oiter->hop)
-        continue;
-      op2 = oiter->pos + offset;
-      if (intersect_hv_lines(p1, p2, op1, op2, intersection)) {
-        // got intersection with a straight line seg,
-        // but we need to put new hop on its place
-        // among rest of hops in this straingt segment
-        std::list<SegmentPoint>::reverse_iterator rIt = new_segs.rbegin();
-        while (rIt->hop && intersect_hv_lines(p1, rIt->pos, op1, op2, intersection) && (rIt != new_segs.rend()))
-          ++rIt;
-        new_segs.insert(rIt.base(), SegmentPoint(intersection, line));
+    remap_crossings(crossings->second, old_to_new, false);
+    if (crossings->second.empty()) {
+      other->_crossings.erase(crossings);
+      _crossed_by.erase(iter++);
+    } else
+      ++iter;
+
+    if (count != 0)
+      other->rebuild_segments();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Creates the points to draw (vertices and hops) from the vertices and the crossings of this line.
+ */
+void Line::rebuild_segments() {
+  std::vector<SegmentPoint> segments;
+  Point origin = get_root_position();
+  Point position = get_position();
+
+  if (!_vertices.empty())
+    segments.push_back(SegmentPoint(_vertices.front() - position, 0));
+
+  for (size_t i = 0; i < _crossing_segments.size() && i + 1 < _vertices.size(); ++i) {
+    const Point &start = _crossing_segments[i].first;
+    std::vector<std::pair<double, SegmentPoint> > hops;
+
+    for (CrossingMap::const_iterator iter = _crossings.begin(); iter != _crossings.end(); ++iter) {
+      for (std::vector<Crossing>::const_iterator crossing = iter->second.begin(); crossing != iter->second.end();
+           ++crossing) {
+        if (crossing->segment == i)
+          hops.push_back(std::make_pair(std::fabs(crossing->pos.x - start.x) + std::fabs(crossing->pos.y - start.y),
+                                        SegmentPoint(crossing->pos - origin, iter->first)));
       }
-      op1 = op2;
     }
-    p1 = p2;
-    new_segs.push_back(*segiter);
+    std::sort(hops.begin(), hops.end(),
+              [](const std::pair<double, SegmentPoint> &a, const std::pair<double, SegmentPoint> &b) {
+                return a.first < b.first;
+              });
+
+    for (size_t h = 0; h < hops.size(); ++h)
+      segments.push_back(hops[h].second);
+    segments.push_back(SegmentPoint(_vertices[i + 1] - position, 0));
   }
 
-  if (new_segs.size() == _segments.size() && (std::equal(_segments.begin(), _segments.end(), new_segs.begin())))
-    return; // no chnages
+  if (segments != _segments) {
+    _segments.swap(segments);
+    set_needs_render();
+  }
+}
 
-  _segments.clear();
-  _segments.reserve(new_segs.size());
-  _segments.insert(_segments.begin(), new_segs.begin(), new_segs.end());
-  set_needs_render();
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Computes the hops of this line over the given one. Only pairs of segments of which at least one moved
+ * since the last update are checked if moved_only is true, the other crossings are kept as they are.
+ */
+void Line::find_crossings(Line *line, bool moved_only) {
+  if (line == this)
+    return;
+
+  // The lines were restacked, the other line no longer hops over this one.
+  CrossingMap::iterator opposite = line->_crossings.find(this);
+  if (opposite != line->_crossings.end()) {
+    line->_crossings.erase(opposite);
+    _crossed_by.erase(line);
+    line->rebuild_segments();
+    moved_only = false;
+  }
+
+  std::vector<Crossing> crossings;
+  CrossingMap::iterator existing = _crossings.find(line);
+  if (existing != _crossings.end() && moved_only) {
+    for (std::vector<Crossing>::const_iterator iter = existing->second.begin(); iter != existing->second.end();
+         ++iter) {
+      if (!_moved_segments[iter->segment] && !line->_moved_segments[iter->other_segment])
+        crossings.push_back(*iter);
+    }
+  }
+
+  Point intersection;
+  for (size_t i = 0; i < _crossing_segments.size(); ++i) {
+    for (size_t k = 0; k < line->_crossing_segments.size(); ++k) {
+      if (moved_only && !_moved_segments[i] && !line->_moved_segments[k])
+        continue;
+
+      const SegmentEnds &own = _crossing_segments[i];
+      const SegmentEnds &other = line->_crossing_segments[k];
+      if (intersect_hv_lines(own.first, own.second, other.first, other.second, intersection))
+        crossings.push_back(Crossing(i, k, intersection));
+    }
+  }
+
+  if (crossings.empty()) {
+    if (existing == _crossings.end())
+      return;
+    _crossings.erase(existing);
+    line->_crossed_by.erase(this);
+  } else {
+    _crossings[line].swap(crossings);
+    line->_crossed_by.insert(this);
+  }
+  rebuild_segments();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Line::mark_crossings(Line *line) {
+  find_crossings(line, false);
 }
 
+//--------------------------------------------------------------------------------------------------
+
+void Line::update_crossings(Line *line) {
+  find_crossings(line, true);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Line::has_moved_segments() const {
+  return std::find(_moved_segments.begin(), _moved_segments.end(), true) != _moved_segments.end();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the bounds (in root coordinates) of the segments that moved since the last crossing update.
+ */
+Rect Line::get_moved_segments_bounds() const {
+  double xmin = INFINITY, ymin = INFINITY, xmax = -INFINITY, ymax = -INFINITY;
+
+  for (size_t i = 0; i < _crossing_segments.size(); ++i) {
+    if (_moved_segments[i]) {
+      xmin = std::min(xmin, std::min(_crossing_segments[i].first.x, _crossing_segments[i].second.x));
+      ymin = std::min(ymin, std::min(_crossing_segments[i].first.y, _crossing_segments[i].second.y));
+      xmax = std::max(xmax, std::max(_crossing_segments[i].first.x, _crossing_segments[i].second.x));
+      ymax = std::max(ymax, std::max(_crossing_segments[i].first.y, _crossing_segments[i].second.y));
+    }
+  }
+  if (xmin > xmax)
+    return Rect();
+  return Rect(xmin, ymin, xmax - xmin, ymax - ymin);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Line::clear_moved_segments() {
+  std::fill(_moved_segments.begin(), _moved_segments.end(), false);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Line::update_bounds() {
   if (_vertices.size() <= 1) {
     set_bounds(Rect());
@@ -832,18 +1000,14 @@ void Line::update_bounds() {
       ymax = std::max(v->y, ymax);
     }
 
-    Point new_pos(xmin, ymin);
-
     // update the line's bounding box to the new bounds
     set_bounds(Rect(xmin, ymin, xmax - xmin, ymax - ymin));
-
-    // update the segments. crossings should be handled by a listener of layout_changed
-    _segments.clear();
-    for (std::vector<Point>::const_iterator iter = _vertices.begin(); iter != _vertices.end(); ++iter) {
-      _segments.push_back(SegmentPoint(*iter - new_pos, 0));
-    }
   }
 
+  // update the segments. new crossings should be handled by a listener of layout_changed
+  update_crossing_segments();
+  rebuild_segments();
+
   update_handles();
 
   _layout_changed();
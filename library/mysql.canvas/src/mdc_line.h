@@ -134,6 +134,26 @@ namespace mdc {
     }
 
     virtual void mark_crossings(Line *line);
+    void update_crossings(Line *line);
+
+    bool has_moved_segments() const;
+    base::Rect get_moved_segments_bounds() const;
+    void clear_moved_segments();
+
+    // Takes the points from the layouter. Deferred to CanvasView::end_line_batch() while a line batch is open.
+    void update_layout();
+
+    typedef std::pair<base::Point, base::Point> SegmentEnds;
+
+    // A hop drawn on this line where one of its segments crosses a segment of another line (root coordinates).
+    struct Crossing {
+      size_t segment;
+      size_t other_segment;
+      base::Point pos;
+
+      Crossing(size_t s, size_t os, const base::Point &p) : segment(s), other_segment(os), pos(p) {
+      }
+    };
 
     virtual void create_handles(InteractionLayer *ilayer);
     virtual void update_handles();
@@ -172,8 +192,19 @@ namespace mdc {
 
     bool _hop_crossings;
 
+    typedef std::map<Line *, std::vector<Crossing> > CrossingMap;
+
+    // The crossings are cached per pair of segments, so only segments that moved need to be checked again.
+    CrossingMap _crossings;                     // Hops on this line, per line it crosses.
+    std::set<Line *> _crossed_by;                // Lines with hops over this one.
+    std::vector<SegmentEnds> _crossing_segments; // Segments the crossings refer to, in root coordinates.
+    std::vector<bool> _moved_segments;           // Segments not checked for crossings since they moved.
+
     void update_bounds();
-    void update_layout();
+    std::vector<SegmentEnds> get_root_segments() const;
+    void update_crossing_segments();
+    void rebuild_segments();
+    void find_crossings(Line *line, bool moved_only);
 
     void set_line_pattern(CairoCtx *cr, LinePatternType pattern);
     GLushort get_gl_pattern(LinePatternType pattern);
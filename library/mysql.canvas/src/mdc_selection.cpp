@@ -225,6 +225,7 @@ void Selection::update_move(const Point &mouse_pos) {
     snap_offset = npos - pos;
   }
 
+  _view->begin_line_batch();
   for (ContentType::const_iterator i = _items.begin(); i != _items.end(); ++i) {
     Group *group = dynamic_cast<Group *>((*i)->get_parent());
     if (!group) {
@@ -245,6 +246,7 @@ void Selection::update_move(const Point &mouse_pos) {
       group->move_item(*i, data.position - group->get_root_position());
     }
   }
+  _view->end_line_batch();
   unlock();
 }
 
@@ -257,6 +259,7 @@ void Selection::end_moving() {
   lock();
   // for (std::list<CanvasItem*>::const_iterator i= _items.begin(); i!= _items.end(); ++i)
   const ContentType::const_iterator last = _items.end();
+  _view->begin_line_batch();
   for (ContentType::const_iterator i = _items.begin(); i != last; ++i) {
     Group *group = dynamic_cast<Group *>((*i)->get_parent());
     DragData &data(_drag_data[*i]);
@@ -266,6 +269,7 @@ void Selection::end_moving() {
       group->move_item(*i, _view->snap_to_grid(position));
     }
   }
+  _view->end_line_batch();
   _drag_data.clear();
   unlock();
 
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "mdc_spatial_index.h"
+#include "mdc_algorithms.h"
+
+#include <cmath>
+
+using namespace mdc;
+using namespace base;
+
+// Slack added around the item bounds, lines accept clicks slightly outside of their (thin) bounding box.
+#define INDEX_BOUNDS_SLACK 4
+// Items covering more cells than this are not put in the grid, but checked on every query.
+#define INDEX_MAX_CELLS_PER_ITEM 64
+
+static inline uint64_t cell_key(int64_t x, int64_t y) {
+  return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+static inline bool finite_bounds(const Rect &bounds) {
+  return std::isfinite(bounds.left()) && std::isfinite(bounds.top()) && std::isfinite(bounds.right()) &&
+         std::isfinite(bounds.bottom());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+SpatialIndex::SpatialIndex(double cell_size) : _cell_size(cell_size) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::clear() {
+  _entries.clear();
+  _cells.clear();
+  _large_items.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+SpatialIndex::CellRange SpatialIndex::cell_range(const Rect &bounds) const {
+  CellRange range;
+  range.left = (int64_t)std::floor(bounds.left() / _cell_size);
+  range.top = (int64_t)std::floor(bounds.top() / _cell_size);
+  range.right = (int64_t)std::floor(bounds.right() / _cell_size);
+  range.bottom = (int64_t)std::floor(bounds.bottom() / _cell_size);
+  return range;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::add_to_cells(CanvasItem *item, Entry &entry) {
+  if (finite_bounds(entry.bounds)) {
+    entry.cells = cell_range(entry.bounds);
+    entry.large = (entry.cells.right - entry.cells.left + 1) * (entry.cells.bottom - entry.cells.top + 1) >
+                  INDEX_MAX_CELLS_PER_ITEM;
+  } else
+    entry.large = true;
+
+  if (entry.large)
+    _large_items.push_back(item);
+  else {
+    for (int64_t x = entry.cells.left; x <= entry.cells.right; ++x)
+      for (int64_t y = entry.cells.top; y <= entry.cells.bottom; ++y)
+        _cells[cell_key(x, y)].push_back(item);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::remove_from_cells(CanvasItem *item, const Entry &entry) {
+  if (entry.large)
+    _large_items.erase(std::find(_large_items.begin(), _large_items.end(), item));
+  else {
+    for (int64_t x = entry.cells.left; x <= entry.cells.right; ++x) {
+      for (int64_t y = entry.cells.top; y <= entry.cells.bottom; ++y) {
+        std::unordered_map<uint64_t, std::vector<CanvasItem *> >::iterator cell = _cells.find(cell_key(x, y));
+        if (cell == _cells.end())
+          continue;
+
+        cell->second.erase(std::find(cell->second.begin(), cell->second.end(), item));
+        if (cell->second.empty())
+          _cells.erase(cell);
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::insert(CanvasItem *item, const Rect &bounds, long order) {
+  if (_entries.find(item) != _entries.end())
+    remove(item);
+
+  Entry &entry = _entries[item];
+  entry.bounds = expand_bound(bounds, INDEX_BOUNDS_SLACK, INDEX_BOUNDS_SLACK);
+  entry.order = order;
+  add_to_cells(item, entry);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::update(CanvasItem *item, const Rect &bounds) {
+  std::unordered_map<CanvasItem *, Entry>::iterator iter = _entries.find(item);
+  if (iter == _entries.end())
+    return;
+
+  Entry &entry = iter->second;
+  Rect nbounds = expand_bound(bounds, INDEX_BOUNDS_SLACK, INDEX_BOUNDS_SLACK);
+  if (!entry.large && finite_bounds(nbounds) && cell_range(nbounds) == entry.cells) {
+    // Still covers the same cells, as it usually does when an item is moved by a few pixels.
+    entry.bounds = nbounds;
+    return;
+  }
+
+  remove_from_cells(item, entry);
+  entry.bounds = nbounds;
+  add_to_cells(item, entry);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::set_order(CanvasItem *item, long order) {
+  std::unordered_map<CanvasItem *, Entry>::iterator iter = _entries.find(item);
+  if (iter != _entries.end())
+    iter->second.order = order;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::remove(CanvasItem *item) {
+  std::unordered_map<CanvasItem *, Entry>::iterator iter = _entries.find(item);
+  if (iter == _entries.end())
+    return;
+
+  remove_from_cells(item, iter->second);
+  _entries.erase(iter);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SpatialIndex::sort_by_order(std::vector<CanvasItem *> &items) const {
+  std::vector<std::pair<long, CanvasItem *> > ordered;
+  ordered.reserve(items.size());
+  for (std::vector<CanvasItem *>::const_iterator iter = items.begin(); iter != items.end(); ++iter)
+    ordered.push_back(std::make_pair(_entries.find(*iter)->second.order, *iter));
+
+  // Higher orders are stacked on top.
+  std::sort(ordered.begin(), ordered.end(),
+            [](const std::pair<long, CanvasItem *> &a, const std::pair<long, CanvasItem *> &b) {
+              return a.first > b.first;
+            });
+
+  for (size_t i = 0; i < ordered.size(); ++i)
+    items[i] = ordered[i].second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the items whose (padded) bounds contain the given point, topmost first.
+ */
+std::vector<CanvasItem *> SpatialIndex::items_at(const Point &point) const {
+  std::vector<CanvasItem *> result;
+
+  std::unordered_map<uint64_t, std::vector<CanvasItem *> >::const_iterator cell = _cells.find(
+    cell_key((int64_t)std::floor(point.x / _cell_size), (int64_t)std::floor(point.y / _cell_size)));
+  if (cell != _cells.end()) {
+    for (std::vector<CanvasItem *>::const_iterator iter = cell->second.begin(); iter != cell->second.end(); ++iter) {
+      if (bounds_contain_point(_entries.find(*iter)->second.bounds, point.x, point.y))
+        result.push_back(*iter);
+    }
+  }
+
+  for (std::vector<CanvasItem *>::const_iterator iter = _large_items.begin(); iter != _large_items.end(); ++iter) {
+    const Rect &bounds(_entries.find(*iter)->second.bounds);
+    if (!finite_bounds(bounds) || bounds_contain_point(bounds, point.x, point.y))
+      result.push_back(*iter);
+  }
+
+  sort_by_order(result);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the items whose (padded) bounds intersect the given rectangle, topmost first.
+ */
+std::vector<CanvasItem *> SpatialIndex::items_intersecting(const Rect &rect) const {
+  std::vector<CanvasItem *> result;
+
+  if (!finite_bounds(rect) ||
+      (rect.width() / _cell_size + 2) * (rect.height() / _cell_size + 2) > (double)_cells.size()) {
+    // The rectangle covers more cells than there are filled, go through the items instead.
+    for (std::unordered_map<CanvasItem *, Entry>::const_iterator iter = _entries.begin(); iter != _entries.end();
+         ++iter) {
+      if (!finite_bounds(iter->second.bounds) || bounds_intersect(iter->second.bounds, rect))
+        result.push_back(iter->first);
+    }
+  } else {
+    CellRange range = cell_range(rect);
+    for (int64_t x = range.left; x <= range.right; ++x) {
+      for (int64_t y = range.top; y <= range.bottom; ++y) {
+        std::unordered_map<uint64_t, std::vector<CanvasItem *> >::const_iterator cell = _cells.find(cell_key(x, y));
+        if (cell == _cells.end())
+          continue;
+
+        for (std::vector<CanvasItem *>::const_iterator iter = cell->second.begin(); iter != cell->second.end();
+             ++iter) {
+          const Entry &entry(_entries.find(*iter)->second);
+          // Items spanning several cells are reported only from the first cell shared with the rectangle.
+          if (x == std::max(range.left, entry.cells.left) && y == std::max(range.top, entry.cells.top) &&
+              bounds_intersect(entry.bounds, rect))
+            result.push_back(*iter);
+        }
+      }
+    }
+
+    for (std::vector<CanvasItem *>::const_iterator iter = _large_items.begin(); iter != _large_items.end(); ++iter) {
+      const Rect &bounds(_entries.find(*iter)->second.bounds);
+      if (!finite_bounds(bounds) || bounds_intersect(bounds, rect))
+        result.push_back(*iter);
+    }
+  }
+
+  sort_by_order(result);
+  return result;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#ifndef _MDC_SPATIAL_INDEX_H_
+#define _MDC_SPATIAL_INDEX_H_
+
+#include "mdc_common.h"
+
+#include <stdint.h>
+#include <unordered_map>
+
+namespace mdc {
+
+  class CanvasItem;
+
+  /**
+   * Uniform grid over the bounds of a set of items (the direct children of a group), used to find the items
+   * at a point or in a rectangle without walking all of them. Each item carries a stacking order and candidates
+   * are returned from top to bottom, i.e. in the same order as they appear in Group::get_contents().
+   * The results are candidates only, callers still do the exact hit test on them.
+   */
+  class MYSQLCANVAS_PUBLIC_FUNC SpatialIndex {
+  public:
+    SpatialIndex(double cell_size = 256);
+
+    void clear();
+    size_t size() const {
+      return _entries.size();
+    }
+
+    void insert(CanvasItem *item, const base::Rect &bounds, long order);
+    void update(CanvasItem *item, const base::Rect &bounds);
+    void set_order(CanvasItem *item, long order);
+    void remove(CanvasItem *item);
+
+    std::vector<CanvasItem *> items_at(const base::Point &point) const;
+    std::vector<CanvasItem *> items_intersecting(const base::Rect &rect) const;
+
+  private:
+    struct CellRange {
+      int64_t left, top, right, bottom;
+
+      bool operator==(const CellRange &other) const {
+        return left == other.left && top == other.top && right == other.right && bottom == other.bottom;
+      }
+    };
+
+    struct Entry {
+      base::Rect bounds; // Item bounds, padded by a small slack for items hit-testing outside of their bounds.
+      long order;
+      bool large;        // Spans too many cells and is kept in _large_items instead.
+      CellRange cells;
+    };
+
+    double _cell_size;
+    std::unordered_map<CanvasItem *, Entry> _entries;
+    std::unordered_map<uint64_t, std::vector<CanvasItem *> > _cells;
+    std::vector<CanvasItem *> _large_items;
+
+    CellRange cell_range(const base::Rect &bounds) const;
+    void add_to_cells(CanvasItem *item, Entry &entry);
+    void remove_from_cells(CanvasItem *item, const Entry &entry);
+    void sort_by_order(std::vector<CanvasItem *> &items) const;
+  };
+
+} // end of mdc namespace
+
+#endif /* _MDC_SPATIAL_INDEX_H_ */
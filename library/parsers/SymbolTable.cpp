@@ -21,8 +21,12 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 
+#include "base/string_utilities.h"
+
 #include "SymbolTable.h"
 
 using namespace parsers;
@@ -79,22 +83,91 @@ TypedSymbol::TypedSymbol(std::string const &name, Type const *aType) : Symbol(na
 
 //----------------- ScopedSymbol ---------------------------------------------------------------------------------------
 
-ScopedSymbol::ScopedSymbol(std::string const &name) : Symbol(name) {
+class ScopedSymbol::Members {
+public:
+  std::mutex mutex; // Guards the children and the building of snapshots.
+  std::vector<std::shared_ptr<Symbol>> children;
+  std::multimap<std::string, Symbol *> nameIndex; // The same children, keyed by their lower cased name.
+
+  std::atomic<size_t> version; // Incremented with each change of the children.
+  std::shared_ptr<Snapshot const> snapshot; // Only accessed with std::atomic_load/std::atomic_store.
+
+  Members() : version(0) {
+  }
 };
 
+//----------------------------------------------------------------------------------------------------------------------
+
+ScopedSymbol::ScopedSymbol(std::string const &name) : Symbol(name), _members(new Members()) {
+};
+
+ScopedSymbol::~ScopedSymbol() {
+  delete _members;
+}
+
 void ScopedSymbol::clear() {
-  children.clear();
+  std::lock_guard<std::mutex> lock(_members->mutex);
+  _members->nameIndex.clear();
+  _members->children.clear();
+  ++_members->version;
 }
 
 void ScopedSymbol::addAndManageSymbol(Symbol *symbol) {
-  children.emplace_back(symbol);
   symbol->setParent(this);
+
+  std::lock_guard<std::mutex> lock(_members->mutex);
+  _members->children.emplace_back(symbol);
+  _members->nameIndex.emplace(base::tolower(symbol->name), symbol);
+  ++_members->version;
+}
+
+std::shared_ptr<ScopedSymbol::Snapshot const> ScopedSymbol::snapshot() const {
+  std::shared_ptr<Snapshot const> result = std::atomic_load(&_members->snapshot);
+  if (result && result->version == _members->version.load())
+    return result;
+
+  // Changed since the last snapshot. Concurrent readers can wait for one of them to rebuild it.
+  std::lock_guard<std::mutex> lock(_members->mutex);
+  result = std::atomic_load(&_members->snapshot);
+  size_t version = _members->version.load();
+  if (!result || result->version != version) {
+    std::shared_ptr<Snapshot> fresh = std::make_shared<Snapshot>();
+    fresh->version = version;
+    fresh->children = _members->children;
+    fresh->names.assign(_members->nameIndex.begin(), _members->nameIndex.end());
+    result = fresh;
+    std::atomic_store(&_members->snapshot, result);
+  }
+  return result;
+}
+
+static bool nameLess(std::pair<std::string, Symbol *> const &entry, std::string const &key) {
+  return entry.first < key;
+}
+
+std::vector<Symbol *> ScopedSymbol::getSymbolsWithPrefix(std::string const &prefix) const {
+  std::vector<Symbol *> result;
+
+  std::shared_ptr<Snapshot const> current = snapshot();
+  std::string key = base::tolower(prefix);
+  for (auto iterator = std::lower_bound(current->names.begin(), current->names.end(), key, nameLess);
+       iterator != current->names.end(); ++iterator) {
+    if (iterator->first.compare(0, key.size(), key) != 0)
+      break;
+    result.push_back(iterator->second);
+  }
+
+  return result;
 }
 
 Symbol *ScopedSymbol::resolve(std::string const &name, bool localOnly) {
-  for (auto &child : children) {
-    if (child->name == name)
-      return child.get();
+  // Entries with the same key keep their insertion order, so the first defined symbol wins, as before.
+  std::shared_ptr<Snapshot const> current = snapshot();
+  std::string key = base::tolower(name);
+  for (auto iterator = std::lower_bound(current->names.begin(), current->names.end(), key, nameLess);
+       iterator != current->names.end() && iterator->first == key; ++iterator) {
+    if (iterator->second->name == name)
+      return iterator->second;
   }
 
   // Nothing found locally. Let the parent continue.
@@ -124,7 +197,8 @@ std::vector<TypedSymbol *> ScopedSymbol::getTypedSymbols(bool localOnly) const {
 std::vector<std::string> ScopedSymbol::getTypedSymbolNames(bool localOnly) const {
   std::vector<std::string> result;
 
-  for (auto &child : children) {
+  std::shared_ptr<Snapshot const> current = snapshot();
+  for (auto &child : current->children) {
     TypedSymbol *typedChild = dynamic_cast<TypedSymbol *>(child.get());
     if (typedChild != nullptr)
       result.push_back(typedChild->name);
@@ -162,7 +236,8 @@ std::vector<ScopedSymbol *> ScopedSymbol::getDirectScopes() const {
 std::vector<Symbol *> ScopedSymbol::getAllSymbols() const {
   std::vector<Symbol *> result;
 
-  for (auto &child : children) {
+  std::shared_ptr<Snapshot const> current = snapshot();
+  for (auto &child : current->children) {
     result.push_back(child.get());
   }
 
@@ -178,7 +253,8 @@ std::vector<Symbol *> ScopedSymbol::getAllSymbols() const {
 std::set<std::string> ScopedSymbol::getAllSymbolNames() const {
   std::set<std::string> result;
 
-  for (auto &child : children) {
+  std::shared_ptr<Snapshot const> current = snapshot();
+  for (auto &child : current->children) {
     result.insert(child->name);
   }
 
@@ -304,7 +380,6 @@ void SymbolTable::addDependencies(std::vector<SymbolTable *> const &newDependenc
 //----------------------------------------------------------------------------------------------------------------------
 
 Symbol *SymbolTable::resolve(std::string const &name, bool localOnly) {
-  lock();
   Symbol *result = ScopedSymbol::resolve(name, localOnly);
 
   if (result == nullptr && !localOnly) {
@@ -315,8 +390,6 @@ Symbol *SymbolTable::resolve(std::string const &name, bool localOnly) {
     }
   }
 
-  unlock();
-
   return result;
 }
 
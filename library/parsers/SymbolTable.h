@@ -26,7 +26,10 @@
 #include "parsers-common.h"
 
 #include <set>
+#include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 // A simple symbol table implementation, tailored towards code completion.
 
@@ -63,6 +66,8 @@ namespace parsers {
     antlr4::ParserRuleContext *context = nullptr; // Reference to the parse tree which defines this symbol.
 
     Symbol(std::string const &aName = "");
+    virtual ~Symbol() {
+    }
 
     virtual void clear();
     void setParent(Symbol *parent);
@@ -101,16 +106,30 @@ namespace parsers {
   };
 
   // A symbol with a scope (so it can have child symbols).
+  // Readers work on an immutable snapshot of the children, which is rebuilt on first use after a change. So they
+  // need no lock while other threads add symbols, and the snapshot keeps its symbols alive even if the scope is
+  // cleared meanwhile. Writers are serialized by a mutex per scope.
   class PARSERS_PUBLIC_TYPE ScopedSymbol : public Symbol {
   public:
+    struct Snapshot {
+      size_t version = 0;
+      std::vector<std::shared_ptr<Symbol>> children;       // All child symbols in definition order.
+      std::vector<std::pair<std::string, Symbol *>> names; // Lower cased names, sorted. Ties in definition order.
+    };
+
+    virtual ~ScopedSymbol();
     virtual void clear() override;
 
     void addAndManageSymbol(Symbol *symbol); // Takes over ownership.
 
+    // The children as of now, safe to use from any thread.
+    std::shared_ptr<Snapshot const> snapshot() const;
+
     template <typename T>
     std::vector<T *> getSymbolsOfType() const {
       std::vector<T *> result;
-      for (auto &child : children) {
+      std::shared_ptr<Snapshot const> current = snapshot();
+      for (auto &child : current->children) {
         T *castChild = dynamic_cast<T *>(child.get());
         if (castChild != nullptr)
           result.push_back(castChild);
@@ -119,6 +138,22 @@ namespace parsers {
       return result;
     }
 
+    // Direct child symbols whose name starts with the given prefix (case insensitive), in name order.
+    // Uses the name index, so the costs depend on the number of matches, not the number of children.
+    std::vector<Symbol *> getSymbolsWithPrefix(std::string const &prefix) const;
+
+    template <typename T>
+    std::vector<T *> getSymbolsOfTypeWithPrefix(std::string const &prefix) const {
+      std::vector<T *> result;
+      for (auto symbol : getSymbolsWithPrefix(prefix)) {
+        T *castSymbol = dynamic_cast<T *>(symbol);
+        if (castSymbol != nullptr)
+          result.push_back(castSymbol);
+      }
+
+      return result;
+    }
+
     // Retrieval functions for this scope or any of the parent scopes (conditionally).
     virtual Symbol *resolve(std::string const &name, bool localOnly = false);
 
@@ -143,9 +178,11 @@ namespace parsers {
     ScopedSymbol(const ScopedSymbol&) = delete;
     ScopedSymbol& operator=(const ScopedSymbol&) = delete;
 
-    std::vector<std::unique_ptr<Symbol>> children; // All child symbols in definition order.
-
     ScopedSymbol(std::string const &name = "");
+
+  private:
+    class Members; // Must be in private class for use in C++/CLI code, like the mutex of the symbol table.
+    Members *_members;
   };
 
   class PARSERS_PUBLIC_TYPE VariableSymbol : public TypedSymbol {
@@ -362,16 +399,18 @@ namespace parsers {
   };
 
   // The main class managing all the symbols for a top level entity like a file, library or similar.
-  // This class is thread safe for all symbol manipulations.
+  // This class is thread safe for all symbol manipulations. Lookups take no lock (see ScopedSymbol), adding symbols
+  // is serialized by the table lock.
   class PARSERS_PUBLIC_TYPE SymbolTable : public ScopedSymbol {
   public:
     SymbolTable();
     virtual ~SymbolTable();
 
-    // Lock/unlock can be used recursively, but must be balanced of course.
+    // Lock/unlock can be used recursively, but must be balanced of course. Only needed to keep other writers out.
     void lock();
     void unlock();
 
+    // Dependencies must be set before the table is used from several threads.
     void addDependencies(std::vector<SymbolTable *> const &newDependencies);
 
     // The returned symbol instance is managed by this table.
@@ -393,13 +432,8 @@ namespace parsers {
     std::vector<T *> getSymbolsOfType(ScopedSymbol *parent = nullptr) {
       std::vector<T *> result;
 
-      lock();
       if (parent == nullptr || parent == this) {
-        for (auto &child : children) {
-          T *castChild = dynamic_cast<T *>(child.get());
-          if (castChild != nullptr)
-            result.push_back(castChild);
-        }
+        result = ScopedSymbol::getSymbolsOfType<T>();
 
         for (SymbolTable *table : _dependencies) {
           auto subList = table->getSymbolsOfType<T>();
@@ -409,7 +443,25 @@ namespace parsers {
         result = parent->getSymbolsOfType<T>();
       }
 
-      unlock();
+      return result;
+    }
+
+    // Same as getSymbolsOfType, but only returns symbols whose name starts with the given prefix (case insensitive).
+    template <typename T>
+    std::vector<T *> getSymbolsOfTypeWithPrefix(std::string const &prefix, ScopedSymbol *parent = nullptr) {
+      std::vector<T *> result;
+
+      if (parent == nullptr || parent == this) {
+        result = ScopedSymbol::getSymbolsOfTypeWithPrefix<T>(prefix);
+
+        for (SymbolTable *table : _dependencies) {
+          auto subList = table->getSymbolsOfTypeWithPrefix<T>(prefix);
+          result.insert(result.end(), subList.begin(), subList.end());
+        }
+      } else {
+        result = parent->getSymbolsOfTypeWithPrefix<T>(prefix);
+      }
+
       return result;
     }
 
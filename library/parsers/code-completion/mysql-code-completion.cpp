@@ -201,25 +201,10 @@ struct AutoCompletionContext {
     c3.showDebugOutput = false;
     referencesStack.emplace_back(); // For the root level of table references.
 
-    size_t startTokenIndex = 0;
-    size_t ruleIndex = 0;
-
-    parser->reset();
-    ParserRuleContext *context = parser->query();
-    /*
-    tree::ParseTree *tree = parser->contextFromPosition(context, { caretOffset, caretLine });
-    if (tree->parent) {
-      tree = tree->parent;
-    }
-    if (tree != nullptr) {
-      context = dynamic_cast<ParserRuleContext *>(tree->parent);
-      if (context != nullptr) {
-        startTokenIndex = context->start->getTokenIndex();
-        ruleIndex = context->getRuleIndex();
-      }
-    }
-*/
-    completionCandidates = c3.collectCandidates(caretIndex, context);
+    // The candidates are collected from the start of the query rule (the first rule of the grammar) and the first
+    // token on the default channel, which is what a parse of the whole statement gave us before. So the statement
+    // is not parsed here at all, the walk of the ATN only needs the tokens up to the caret.
+    completionCandidates = c3.collectCandidates(caretIndex, nullptr);
 
     // Post processing some entries.
     if (completionCandidates.tokens.count(MySQLLexer::NOT2_SYMBOL) > 0) {
@@ -543,6 +528,33 @@ static ObjectFlags determineSchemaTableQualifier(Scanner &scanner, MySQLLexer *l
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Returns the part of an unquoted identifier left to the caret (lower cased), if the caret is within or directly
+ * after one. Object names are looked up with this prefix, so that only matching names are collected.
+ * The editor filters the final list by the written text anyway, so this only saves work for large schemas.
+ */
+static std::string determineTypedPrefix(Scanner &scanner, MySQLLexer *lexer, size_t caretLine, size_t caretOffset) {
+  if (lexer == nullptr || !lexer->isIdentifier(scanner.tokenType()) || scanner.tokenLine() != caretLine)
+    return "";
+
+  size_t start = scanner.tokenStart();
+  if (caretOffset <= start)
+    return "";
+
+  std::string text = scanner.tokenText(true);
+  if (text.empty() || text[0] == '`' || text[0] == '"' || text[0] == '\'')
+    return "";
+
+  // The caret offset is given in characters, not bytes.
+  glong length = g_utf8_strlen(text.c_str(), (gssize)text.size());
+  if ((glong)(caretOffset - start) < length)
+    text.resize(g_utf8_offset_to_pointer(text.c_str(), (glong)(caretOffset - start)) - text.c_str());
+
+  return base::tolower(text);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 struct CompareAcEntries {
   bool operator()(const std::pair<int, std::string> &lhs, const std::pair<int, std::string> &rhs) const {
     return base::string_compare(lhs.second, rhs.second, false) < 0;
@@ -553,22 +565,23 @@ typedef std::set<std::pair<int, std::string>, CompareAcEntries> CompletionSet;
 
 //--------------------------------------------------------------------------------------------------
 
-static void insertSchemas(SymbolTable &symbolTable, CompletionSet &set) {
-  auto symbols = symbolTable.getSymbolsOfType<SchemaSymbol>();
+static void insertSchemas(SymbolTable &symbolTable, CompletionSet &set, std::string const &prefix) {
+  auto symbols = symbolTable.getSymbolsOfTypeWithPrefix<SchemaSymbol>(prefix);
   for (auto symbol : symbols)
     set.insert({ AC_SCHEMA_IMAGE, symbol->name });
 }
 
 //--------------------------------------------------------------------------------------------------
 
-static void insertTables(SymbolTable &symbolTable, CompletionSet &set, std::set<std::string> &schemas) {
+static void insertTables(SymbolTable &symbolTable, CompletionSet &set, std::set<std::string> &schemas,
+                         std::string const &prefix) {
 
   for (auto &schema : schemas) {
     SchemaSymbol *schemaSymbol = dynamic_cast<SchemaSymbol *>(symbolTable.resolve(schema));
     if (schemaSymbol == nullptr)
       continue;
 
-    auto symbols = schemaSymbol->getSymbolsOfType<TableSymbol>();
+    auto symbols = schemaSymbol->getSymbolsOfTypeWithPrefix<TableSymbol>(prefix);
     for (auto symbol : symbols)
       set.insert({ AC_TABLE_IMAGE, symbol->name });
   }
@@ -576,7 +589,8 @@ static void insertTables(SymbolTable &symbolTable, CompletionSet &set, std::set<
 
 //--------------------------------------------------------------------------------------------------
 
-static void insertViews(SymbolTable &symbolTable, CompletionSet &set, const std::set<std::string> &schemas) {
+static void insertViews(SymbolTable &symbolTable, CompletionSet &set, const std::set<std::string> &schemas,
+                        std::string const &prefix) {
 
   for (auto &schema : schemas) {
     Symbol *symbol = symbolTable.resolve(schema);
@@ -584,7 +598,7 @@ static void insertViews(SymbolTable &symbolTable, CompletionSet &set, const std:
     if (schemaSymbol == nullptr)
       continue;
 
-    auto symbols = schemaSymbol->getSymbolsOfType<ViewSymbol>();
+    auto symbols = schemaSymbol->getSymbolsOfTypeWithPrefix<ViewSymbol>(prefix);
     for (auto symbol : symbols)
       set.insert({ AC_VIEW_IMAGE, symbol->name });
   }
@@ -592,11 +606,12 @@ static void insertViews(SymbolTable &symbolTable, CompletionSet &set, const std:
 
 //--------------------------------------------------------------------------------------------------
 
-static void insertRoutines(SymbolTable &symbolTable, CompletionSet &set, std::string const &schema) {
+static void insertRoutines(SymbolTable &symbolTable, CompletionSet &set, std::string const &schema,
+                           std::string const &prefix) {
 
   SchemaSymbol *schemaSymbol = dynamic_cast<SchemaSymbol *>(symbolTable.resolve(schema));
   if (schemaSymbol != nullptr) {
-    auto symbols = schemaSymbol->getSymbolsOfType<RoutineSymbol>();
+    auto symbols = schemaSymbol->getSymbolsOfTypeWithPrefix<RoutineSymbol>(prefix);
     for (auto symbol : symbols)
       set.insert({ AC_ROUTINE_IMAGE, symbol->name + "()" });
   }
@@ -605,7 +620,7 @@ static void insertRoutines(SymbolTable &symbolTable, CompletionSet &set, std::st
 //--------------------------------------------------------------------------------------------------
 
 static void insertColumns(SymbolTable &symbolTable, CompletionSet &set, const std::set<std::string> &schemas,
-                          const std::set<std::string> &tables) {
+                          const std::set<std::string> &tables, std::string const &prefix) {
 
   for (auto &schema : schemas) {
     Symbol *symbol = symbolTable.resolve(schema);
@@ -619,7 +634,7 @@ static void insertColumns(SymbolTable &symbolTable, CompletionSet &set, const st
       if (tableSymbol == nullptr)
         continue;
 
-      auto symbols = tableSymbol->getSymbolsOfType<ColumnSymbol>();
+      auto symbols = tableSymbol->getSymbolsOfTypeWithPrefix<ColumnSymbol>(prefix);
       for (auto symbol : symbols)
         set.insert({ AC_COLUMN_IMAGE, symbol->name });
     }
@@ -725,6 +740,10 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
     queryType = lexer->determineQueryType();
   }
 
+  scanner.pop();
+  scanner.push();
+  std::string typedPrefix = determineTypedPrefix(scanner, lexer, caretLine + 1, caretOffset);
+
   dfa::Vocabulary const &vocabulary = parser->getVocabulary();
 
   for (auto &candidate : context.completionCandidates.tokens) {
@@ -774,7 +793,6 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
     }
   }
 
-  symbolTable.lock();
   for (auto &candidate : context.completionCandidates.rules) {
     // Restore the scanner position to the caret position and store that value again for the next round.
     scanner.pop();
@@ -806,13 +824,13 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         logDebug3("Adding function names from cache\n");
 
         if ((flags & ShowFirst) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         if ((flags & ShowSecond) != 0) {
           if (qualifier.empty())
             qualifier = defaultSchema;
 
-          insertRoutines(symbolTable, functionEntries, qualifier);
+          insertRoutines(symbolTable, functionEntries, qualifier, typedPrefix);
         }
 
         break;
@@ -831,7 +849,7 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
       case MySQLParser::RuleSchemaRef: {
         logDebug3("Adding schema names from cache\n");
 
-        insertSchemas(symbolTable, schemaEntries);
+        insertSchemas(symbolTable, schemaEntries, typedPrefix);
         break;
       }
 
@@ -842,13 +860,13 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         ObjectFlags flags = determineQualifier(scanner, lexer, caretOffset, qualifier);
 
         if ((flags & ShowFirst) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         if ((flags & ShowSecond) != 0) {
           if (qualifier.empty())
             qualifier = defaultSchema;
 
-          insertRoutines(symbolTable, functionEntries, qualifier);
+          insertRoutines(symbolTable, functionEntries, qualifier, typedPrefix);
         }
         break;
       }
@@ -861,13 +879,13 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         std::string schema, table;
         ObjectFlags flags = determineSchemaTableQualifier(scanner, lexer, schema, table);
         if ((flags & ShowSchemas) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         std::set<std::string> schemas;
         schemas.insert(schema.empty() ? defaultSchema : schema);
         if ((flags & ShowTables) != 0) {
-          insertTables(symbolTable, tableEntries, schemas);
-          insertViews(symbolTable, viewEntries, schemas);
+          insertTables(symbolTable, tableEntries, schemas, typedPrefix);
+          insertViews(symbolTable, viewEntries, schemas, typedPrefix);
         }
         break;
       }
@@ -881,14 +899,14 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         ObjectFlags flags = determineQualifier(scanner, lexer, caretOffset, qualifier);
 
         if ((flags & ShowFirst) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         if ((flags & ShowSecond) != 0) {
           std::set<std::string> schemas;
           schemas.insert(qualifier.empty() ? defaultSchema : qualifier);
 
-          insertTables(symbolTable, tableEntries, schemas);
-          insertViews(symbolTable, viewEntries, schemas);
+          insertTables(symbolTable, tableEntries, schemas, typedPrefix);
+          insertViews(symbolTable, viewEntries, schemas, typedPrefix);
         }
         break;
       }
@@ -904,7 +922,7 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         std::string schema, table;
         ObjectFlags flags = determineSchemaTableQualifier(scanner, lexer, schema, table);
         if ((flags & ShowSchemas) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         // If a schema is given then list only tables + columns from that schema.
         // If no schema is given but we have table references use the schemas from them.
@@ -925,10 +943,10 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
           schemas.insert(defaultSchema);
 
         if ((flags & ShowTables) != 0) {
-          insertTables(symbolTable, tableEntries, schemas);
+          insertTables(symbolTable, tableEntries, schemas, typedPrefix);
           if (candidate.first == MySQLParser::RuleColumnRef) {
             // Insert also views.
-            insertViews(symbolTable, viewEntries, schemas);
+            insertViews(symbolTable, viewEntries, schemas, typedPrefix);
 
             // Insert also tables from our references list.
             for (auto &reference : context.references) {
@@ -965,7 +983,7 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
           }
 
           if (!tables.empty())
-            insertColumns(symbolTable, columnEntries, schemas, tables);
+            insertColumns(symbolTable, columnEntries, schemas, tables, typedPrefix);
 
           // Special deal here: triggers. Show columns for the "new" and "old" qualifiers too.
           // Use the first reference in the list, which is the table to which this trigger belongs (there can be more
@@ -974,7 +992,7 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
               (base::same_string(table, "old") || base::same_string(table, "new"))) {
             tables.clear();
             tables.insert(context.references[0].table);
-            insertColumns(symbolTable, columnEntries, schemas, tables);
+            insertColumns(symbolTable, columnEntries, schemas, tables, typedPrefix);
           }
         }
 
@@ -990,7 +1008,7 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         ObjectFlags flags = determineQualifier(scanner, lexer, caretOffset, qualifier);
 
         if ((flags & ShowFirst) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         if ((flags & ShowSecond) != 0) {
           SchemaSymbol *schemaSymbol = dynamic_cast<SchemaSymbol *>(symbolTable.resolve(qualifier));
@@ -1011,12 +1029,12 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         ObjectFlags flags = determineQualifier(scanner, lexer, caretOffset, qualifier);
 
         if ((flags & ShowFirst) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         if ((flags & ShowSecond) != 0) {
           std::set<std::string> schemas;
           schemas.insert(qualifier.empty() ? defaultSchema : qualifier);
-          insertViews(symbolTable, viewEntries, schemas);
+          insertViews(symbolTable, viewEntries, schemas, typedPrefix);
         }
         break;
       }
@@ -1088,7 +1106,7 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
         ObjectFlags flags = determineQualifier(scanner, lexer, caretOffset, qualifier);
 
         if ((flags & ShowFirst) != 0)
-          insertSchemas(symbolTable, schemaEntries);
+          insertSchemas(symbolTable, schemaEntries, typedPrefix);
 
         if ((flags & ShowSecond) != 0) {
           if (qualifier.empty())
@@ -1110,7 +1128,6 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
     }
   }
 
-  symbolTable.unlock();
   scanner.pop(); // Clear the scanner stack.
 
   // Insert the groups "inside out", that is, most likely ones first + most inner first (columns before tables etc).
@@ -169,6 +169,60 @@ TEST_FUNCTION(5) {
   ensure_equals("Wrong statement", s2, sql);
 }
 
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * The splitter skips text in blocks of 16 bytes where possible. Make sure the result doesn't depend on
+ * where special characters fall within such a block.
+ */
+TEST_FUNCTION(7) {
+  std::string quoted = "'" + std::string(40, 'x') + "\\'" + std::string(20, 'y') + "\\\\' ";
+  std::string sql = "select 1 from dual where a = " + quoted + ";\r\n" +
+                    "/* a long comment with a ; inside " + std::string(30, '-') + " */ select `a;b` from t1;\r\n" +
+                    "-- single line comment;\r\n" + "# another one;\r\n" +
+                    "insert into t1 values (\"" + std::string(50, ';') + "\", " + quoted + ");\r\n" +
+                    "DELIMITER $$\r\n" + "create procedure p1() begin select 1; select " + quoted + "; end$$\r\n" +
+                    "DELIMITER ;\r\n" + "update t1 set description = " + quoted + " where id = 12345678901234;";
+
+  std::vector<StatementRange> expected;
+  _services->determineStatementRanges(sql.c_str(), sql.size(), ";", expected, "\r\n");
+  ensure_equals("Unexpected number of statements returned from splitter", expected.size(), 5U);
+
+  for (size_t shift = 1; shift < 16; ++shift) {
+    std::string shifted = std::string(shift, ' ') + sql;
+    std::vector<StatementRange> ranges;
+    _services->determineStatementRanges(shifted.c_str(), shifted.size(), ";", ranges, "\r\n");
+
+    ensure_equals("Wrong statement count for shift " + std::to_string(shift), ranges.size(), expected.size());
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      ensure_equals("Wrong statement line", ranges[i].line, expected[i].line);
+      ensure_equals("Wrong statement start", ranges[i].start, expected[i].start + shift);
+      ensure_equals("Wrong statement length", ranges[i].length, expected[i].length);
+    }
+  }
+
+#if VERBOSE_OUTPUT
+  std::ifstream stream("data/db/sakila-db/sakila-data.sql", std::ios::binary);
+  ensure("Error loading sql file", stream.good());
+  std::string data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+  std::string large;
+  for (size_t i = 0; i < 20; ++i)
+    large += data;
+
+  test_time_point t1;
+  std::vector<StatementRange> ranges;
+  _services->determineStatementRanges(large.c_str(), large.size(), ";", ranges);
+  test_time_point t2;
+
+  float time_rate = 1000.0f / (t2 - t1).get_ticks();
+  float size_per_sec = large.size() * time_rate / 1024.0f / 1024.0f;
+  std::cout << "Splitter throughput: " << (large.size() >> 20) << " MB were processed in " << (t2 - t1) << " ["
+            << size_per_sec << " MB/sec]" << std::endl;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+
 struct TestFile {
   std::string name;
   const char *line_break;
@@ -429,6 +429,7 @@ class GenericReverseEngineering(object):
                 cls.reverseEngineerTableIndices(connection, table)
         
                 i += 1.0
+            cls._connections[connection.__id__].pop('_schema_columns', None)
             progress_flags.add('%s_tables_first_pass' % schema.name)
         else:  # Second pass
             i = 0.0
@@ -441,6 +442,26 @@ class GenericReverseEngineering(object):
 
         return 0
 
+    @classmethod
+    def get_schema_columns(cls, connection, schema):
+        """Returns the ODBC type names and the columns of all tables in the schema, as a dict of row lists keyed by table name.
+
+        The columns are fetched with a single catalog call for the whole schema and kept until the schema changes, instead
+        of one call per table.
+        """
+        cache = cls._connections[connection.__id__].get('_schema_columns')
+        if cache is None or cache[0] != schema.__id__:
+            cursor = cls.get_connection(connection).cursor()
+            odbc_datatypes = dict( (dtype.data_type, dtype.type_name) for dtype in cursor.getTypeInfo() )
+            schema_columns = {}
+            # the names are search patterns for the driver, so the rows are checked for the exact schema name
+            for column_info in cursor.columns(catalog=schema.owner.name, schema=schema.name):
+                if column_info[1] == schema.name:
+                    schema_columns.setdefault(column_info[2], []).append(column_info)
+            cache = (schema.__id__, odbc_datatypes, schema_columns)
+            cls._connections[connection.__id__]['_schema_columns'] = cache
+        return cache[1], cache[2]
+
     @classmethod
     def reverseEngineerTableColumns(cls, connection, table):
         schema = table.owner
@@ -449,10 +470,8 @@ class GenericReverseEngineering(object):
         simple_datatypes_list = [ datatype.name.upper() for datatype in catalog.simpleDatatypes ]
         user_datatypes_list   = [ datatype.name.upper() for datatype in catalog.userDatatypes ]
 
-        odbc_datatypes = dict( (dtype.data_type, dtype.type_name) for dtype in cls.get_connection(connection).cursor().getTypeInfo() )
-
-        table_columns = cls.get_connection(connection).cursor().columns(catalog=catalog.name, schema=schema.name, table=table.name)
-        for column_info in table_columns:
+        odbc_datatypes, schema_columns = cls.get_schema_columns(connection, schema)
+        for column_info in schema_columns.get(table.name, []):
             column = grt.classes.db_Column()
             column.name = column_info[3]  # column_name
             column.isNotNull = column_info[17] == 'YES'  # is_nullable
@@ -571,6 +571,7 @@ WHERE schema_id = SCHEMA_ID('%s')"""
             i += 1.0
             
 #        grt.send_progress(1.0, 'Reverse engineering completed!')
+        _connections[connection.__id__].pop('_schema_columns', None)
         progress_flags.append('%s_tables_first_pass' % schema.name)
     else:  # Second pass
         i = 1.0
@@ -582,25 +583,30 @@ WHERE schema_id = SCHEMA_ID('%s')"""
 
     return 0
 
-#@# no need to export this. Remove the redundant params. catalog = schema.owner, schema = table.owner
-@ModuleInfo.export(grt.INT, grt.classes.db_mgmt_Connection, grt.classes.db_mssql_Table)
-def reverseEngineerTableColumns(connection, table):
-    schema = table.owner
-    catalog = schema.owner
-    execute_query(connection, 'USE %s' % quoteIdentifier(catalog.name))
+def get_schema_columns(connection, schema):
+    """Returns the columns of all tables in the schema as a dict of row value lists keyed by table name.
+
+    The columns are fetched with one query for the whole schema and kept until the schema changes, instead of
+    one query per table.
+    """
+    cache = _connections[connection.__id__].get('_schema_columns')
+    if cache is not None and cache[0] == schema.__id__:
+        return cache[1]
+
+    execute_query(connection, 'USE %s' % quoteIdentifier(schema.owner.name))
     query_post90 = """SELECT sys.columns.name AS COLUMN_NAME,
     sys.columns.is_nullable AS IS_NULLABLE, sys.types.name AS DATA_TYPE, sys.columns.max_length AS CHARACTER_MAXIMUM_LENGTH,
     sys.columns.precision AS NUMERIC_PRECISION, sys.columns.scale AS NUMERIC_SCALE,
     sys.columns.collation_name AS COLLATION_NAME, is_identity AS IS_IDENTITY_COLUMN,
     CAST (sys.default_constraints.definition as NVARCHAR(max)) as COLUMN_DEFAULT,
-    sys.extended_properties.value as COLUMN_COMMENT
+    sys.extended_properties.value as COLUMN_COMMENT, sys.objects.name AS TABLE_NAME
 FROM sys.columns JOIN sys.types ON sys.columns.user_type_id=sys.types.user_type_id JOIN sys.objects ON sys.columns.object_id = sys.objects.object_id
      LEFT JOIN sys.default_constraints ON (sys.columns.column_id=sys.default_constraints.parent_column_id AND sys.columns.object_id=sys.default_constraints.parent_object_id)
      LEFT JOIN sys.extended_properties ON sys.extended_properties.major_id = sys.columns.object_id and sys.extended_properties.minor_id = sys.columns.column_id and sys.extended_properties.name = 'MS_Description' and sys.extended_properties.class_desc = 'OBJECT_OR_COLUMN'
-WHERE sys.objects.schema_id=SCHEMA_ID(?) AND sys.objects.name=?
-ORDER BY sys.columns.column_id"""
+WHERE sys.objects.schema_id=SCHEMA_ID(?)
+ORDER BY sys.objects.name, sys.columns.column_id"""
 
-    query_pre90 = """SELECT COLUMN_NAME, COLUMN_DEFAULT,
+    query_pre90 = """SELECT TABLE_NAME, COLUMN_NAME, COLUMN_DEFAULT,
         IS_NULLABLE, DATA_TYPE, CHARACTER_MAXIMUM_LENGTH,
         NUMERIC_PRECISION, NUMERIC_SCALE, DATETIME_PRECISION,
         CHARACTER_SET_CATALOG, CHARACTER_SET_SCHEMA, CHARACTER_SET_NAME,
@@ -608,24 +614,37 @@ ORDER BY sys.columns.column_id"""
         (c.status & 128) / 128 AS IS_IDENTITY_COLUMN,
         '' AS COLUMN_COMMENT
 FROM INFORMATION_SCHEMA.COLUMNS, sysobjects t, sysusers u, syscolumns c
-WHERE TABLE_SCHEMA=? AND TABLE_NAME=? AND
+WHERE TABLE_SCHEMA=? AND
         u.name=TABLE_SCHEMA AND t.name=TABLE_NAME AND
         u.uid=t.uid AND c.id=t.id AND
         c.name=COLUMN_NAME
-ORDER BY ORDINAL_POSITION"""
-    
+ORDER BY TABLE_NAME, ORDINAL_POSITION"""
+
     serverVersion = connected_server_version(connection)
 
     query = query_pre90 if serverVersion.majorNumber < 9 else query_post90
-    rows = execute_query(connection, query, (schema.name, table.name) )
+    rows = execute_query(connection, query, (schema.name,) )
+
+    schema_columns = {}
+    col_names = [ col_description[0] for col_description in rows.description ]
+    for row in rows:
+        row_values = dict( nameval for nameval in zip(col_names, row) )
+        schema_columns.setdefault(row_values['TABLE_NAME'], []).append(row_values)
+    _connections[connection.__id__]['_schema_columns'] = (schema.__id__, schema_columns)
+    return schema_columns
+
+#@# no need to export this. Remove the redundant params. catalog = schema.owner, schema = table.owner
+@ModuleInfo.export(grt.INT, grt.classes.db_mgmt_Connection, grt.classes.db_mssql_Table)
+def reverseEngineerTableColumns(connection, table):
+    schema = table.owner
+    catalog = schema.owner
+    serverVersion = connected_server_version(connection)
 
     mssql_rdbms_instance = get_mssql_rdbms_instance()
     mssql_simple_datatypes_list = [ datatype.name for datatype in mssql_rdbms_instance.simpleDatatypes ]
     user_datatypes_list = [ datatype.name for datatype in catalog.userDatatypes ]
 
-    col_names = [ col_description[0] for col_description in rows.description ]
-    for row in rows:
-        row_values = dict( nameval for nameval in zip(col_names, row) )
+    for row_values in get_schema_columns(connection, schema).get(table.name, []):
         column = grt.classes.db_mssql_Column()
         column.name = row_values['COLUMN_NAME'] or ""
         column.isNotNull = not ( row_values['IS_NULLABLE']=='YES' if serverVersion.majorNumber < 9 else row_values['IS_NULLABLE'] )
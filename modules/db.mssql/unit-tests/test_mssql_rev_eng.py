@@ -117,6 +117,23 @@ class TestMSSQLRevEng(db_mssql_test_main.MssqlTestCase):
         self.assertIsNotNone(column.userType)
         self.assertEqual(column.userType.name, 'PHONE')
 
+    def test_rev_eng_columns_of_schema(self):
+        # The columns of all tables in a schema are fetched together, each table must still get only its own
+        catalog, schema, table = self._set_catalog_schema_table('AdventureWorks', 'Person', 'Contact')
+        other_table = grt.classes.db_mssql_Table()
+        other_table.name = 'Address'
+        other_table.owner = schema
+        DbMssqlRE.reverseEngineerUserDatatypes(self.connection, catalog)
+        self.assertEqual(DbMssqlRE.reverseEngineerTableColumns(self.connection, table), 0)
+        self.assertEqual(DbMssqlRE.reverseEngineerTableColumns(self.connection, other_table), 0)
+
+        column_names = [ column.name for column in table.columns ]
+        other_column_names = [ column.name for column in other_table.columns ]
+        self.assertTrue('Phone' in column_names)
+        self.assertFalse('City' in column_names)
+        self.assertTrue('City' in other_column_names)
+        self.assertFalse('Phone' in other_column_names)
+
     @unittest.skip('FIXME: grt table addPrimaryKeyColumn function is not adding the column into the columns list of the PK')
     def test_rev_eng_pks(self):
         catalog, schema, table = self._set_catalog_schema_table('AdventureWorks', 'Purchasing', 'VendorContact')
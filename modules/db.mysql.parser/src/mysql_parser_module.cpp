@@ -24,6 +24,9 @@
 #include "base/string_utilities.h"
 #include "base/util_functions.h"
 #include "base/log.h"
+#include "base/trace.h"
+#include "base/mem_stat.h"
+#include "base/task_scheduler.h"
 
 #include "grtpp_util.h"
 
@@ -34,6 +37,7 @@
 #include "mysql/MySQLParserBaseListener.h"
 
 #include "objimpl/wrapper/parser_ContextReference_impl.h"
+#include "grtdb/db_helpers.h"
 #include "grtdb/db_object_helpers.h"
 #include "code-completion/mysql-code-completion.h"
 
@@ -41,6 +45,16 @@
 
 #include "mysql_parser_module.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_SSE2_SCAN 1
+#endif
+
 using namespace grt;
 using namespace parsers;
 
@@ -96,6 +110,13 @@ public:
       
 //----------------------------------------------------------------------------------------------------------------------
 
+// Contexts are used from worker threads, so only their number is reported and not the size of their token buffers.
+static std::atomic<std::int64_t> parserContextCount(0);
+static int parserContextMemorySource =
+  base::MemoryAccounting::add_source("Parser contexts", [](base::MemoryAccounting::Usage &usage) {
+    usage.items = parserContextCount;
+  });
+
 struct MySQLParserContextImpl : public MySQLParserContext {
   ANTLRInputStream input;
   MySQLLexer lexer;
@@ -120,6 +141,27 @@ struct MySQLParserContextImpl : public MySQLParserContext {
     lexer.charsets = filteredCharsets;
     updateServerVersion(version_);
 
+    setupErrorListeners();
+    ++parserContextCount;
+  }
+
+  MySQLParserContextImpl(const MySQLParserContextImpl &other)
+    : lexer(&input), tokens(&lexer), parser(&tokens), lexerErrorListener(this), parserErrorListener(this),
+    caseSensitive(other.caseSensitive) {
+
+    lexer.charsets = other.lexer.charsets;
+    updateServerVersion(other.version);
+    updateSqlMode(other.mode);
+
+    setupErrorListeners();
+    ++parserContextCount;
+  }
+
+  virtual ~MySQLParserContextImpl() {
+    --parserContextCount;
+  }
+
+  void setupErrorListeners() {
     lexer.removeErrorListeners();
     lexer.addErrorListener(&lexerErrorListener);
 
@@ -190,6 +232,10 @@ struct MySQLParserContextImpl : public MySQLParserContext {
     return scanner;
   }
 
+  virtual MySQLParserContext::Ref clone() const override {
+    return std::make_shared<MySQLParserContextImpl>(*this);
+  }
+
   virtual bool isIdentifier(size_t type) const override {
     return lexer.isIdentifier(type);
   }
@@ -199,6 +245,43 @@ struct MySQLParserContextImpl : public MySQLParserContext {
     return startParsing(false, unit);
   }
 
+  /**
+   * Object editors parse the definition of the edited object again on each refresh, even if nothing changed.
+   * Returns true if the object was last parsed with the same text, server version and sql mode and
+   * was not changed since then. In that case the errors of that parse run are restored.
+   */
+  bool isUnchangedDefinition(db_DatabaseDdlObjectRef object, const std::string &sql) {
+    auto iterator = definitionCache.find(object->id());
+    if (iterator == definitionCache.end())
+      return false;
+
+    const DefinitionParseResult &result = iterator->second;
+    if (result.textHash != std::hash<std::string>()(sql) || result.version != lexer.serverVersion ||
+        result.mode != mode || result.name != *object->name() || *object->sqlDefinition() != base::trim(sql))
+      return false;
+
+    errors = result.errors;
+    return true;
+  }
+
+  /**
+   * Stores the outcome of the last parse run for the given object (see isUnchangedDefinition).
+   */
+  void cacheDefinition(db_DatabaseDdlObjectRef object, const std::string &sql) {
+    if (definitionCache.size() > 100)
+      definitionCache.clear();
+
+    definitionCache[object->id()] =
+      { std::hash<std::string>()(sql), lexer.serverVersion, mode, *object->name(), errors };
+  }
+
+  /**
+   * To be called when the given object was changed by other means than the definition parsers.
+   */
+  void forgetDefinition(db_DatabaseDdlObjectRef object) {
+    definitionCache.erase(object->id());
+  }
+
   bool errorCheck(const std::string &text, MySQLParseUnit unit) {
     parser.removeParseListeners();
     input.load(text);
@@ -233,6 +316,15 @@ struct MySQLParserContextImpl : public MySQLParserContext {
   }
 
 private:
+  struct DefinitionParseResult {
+    size_t textHash;
+    long version;
+    std::string mode;
+    std::string name; // The object name after the parse run (which can have been changed by it).
+    std::vector<ParserErrorInfo> errors;
+  };
+  std::map<std::string, DefinitionParseResult> definitionCache; // Keyed by object id.
+
   ParseTree *parseUnit(MySQLParseUnit unit) {
     switch (unit) {
       case MySQLParseUnit::PuCreateSchema:
@@ -293,10 +385,18 @@ private:
         tree = nullptr;
       else {
         // If parsing was canceled we either really have a syntax error or we need to do a second step,
-        // now with the default strategy and LL parsing.
-        tokens.reset();
+        // now with the default strategy and LL parsing. The tokens read so far can be reused, unless there were
+        // lexer errors. Those are only reported again (and in the same order with parser errors as in a single
+        // LL run) if the input is lexed again.
+        if (errors.empty())
+          tokens.reset();
+        else {
+          errors.clear();
+          lexer.reset();
+          lexer.setInputStream(&input);
+          tokens.setTokenSource(&lexer);
+        }
         parser.reset();
-        errors.clear();
         parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
         parser.getInterpreter<ParserATNSimulator>()->setPredictionMode(PredictionMode::LL);
         tree = parseUnit(unit);
@@ -492,6 +592,70 @@ void ParserErrorListener::syntaxError(Recognizer *recognizer, Token *offendingSy
 
 //------------------ MySQLParserServicesImpl ---------------------------------------------------------------------------
 
+/**
+ * Statements of the kinds found in scripts, DDL dumps and the SQL editor, parsed once at startup.
+ */
+static const char *warmUpStatements[] = {
+  "select a.id, b.name, count(*) as total from db.t1 a inner join t2 b on a.id = b.t1_id left join t3 c using (x) "
+  "where a.created > now() - interval 1 day and b.name like 'a%' or c.x in (1, 2, 3) group by a.id, b.name "
+  "having total > 1 order by 2 desc limit 10 offset 5",
+  "with recursive cte (n) as (select 1 union all select n + 1 from cte where n < 5) select n, row_number() "
+  "over (order by n) from cte where exists (select 1 from dual) for update",
+  "insert into t1 (a, b, c) values (1, 'x', null), (2, 'y', 3.5e2) on duplicate key update b = values(b)",
+  "update t1 set a = a + 1, b = concat(b, '-') where id between 1 and 100",
+  "delete from t1 where id not in (select id from t2 where t2.x is null)",
+  "create table if not exists `db`.`t1` (`id` int(11) unsigned not null auto_increment, `name` varchar(45) "
+  "character set utf8mb4 collate utf8mb4_general_ci default null comment 'name', `price` decimal(10,2) not null "
+  "default '0.00', `data` json, `created` timestamp null default current_timestamp on update current_timestamp, "
+  "`kind` enum('a','b') default 'a', primary key (`id`), unique key `name_UNIQUE` (`name`), key `fk_idx` "
+  "(`price`, `created`), constraint `fk1` foreign key (`id`) references `t2` (`id`) on delete cascade on update "
+  "no action) engine=InnoDB auto_increment=10 default charset=utf8mb4",
+  "alter table t1 add column x int after id, drop index fk_idx, add index (x), modify name varchar(100)",
+  "create or replace algorithm=merge definer=`root`@`localhost` sql security definer view v1 as select * from t1",
+  "create definer=`root`@`%` procedure p1(in a int, out b varchar(10)) begin declare c int default 0; "
+  "if a > 0 then set c = a; else set c = -a; end if; while c > 0 do set c = c - 1; end while; "
+  "select c into b; end",
+  "create trigger tr1 before insert on t1 for each row set new.created = now()",
+  "grant select, insert on db.* to 'user'@'localhost'",
+  "set @a = 1, session sql_mode = 'ANSI_QUOTES'",
+  "show full columns from t1",
+  "drop table if exists t1, t2",
+  "use db",
+};
+
+/**
+ * Parses a few typical statements on a background thread. The DFA cache of the generated lexer and parser is
+ * shared by all parser contexts, so this way already the first parse in a new editor doesn't have to fill it.
+ */
+void MySQLParserServicesImpl::startWarmUp() {
+  std::shared_ptr<MySQLParserContextImpl> context =
+    std::make_shared<MySQLParserContextImpl>(GrtCharacterSetsRef(grt::Initialized), bec::parse_version("8.0.0"), false);
+
+  _warmUpThread = std::thread([this, context]() {
+    double start = base::timestamp();
+    try {
+      for (const char *statement : warmUpStatements) {
+        if (_stopWarmUp)
+          return;
+        context->errorCheck(statement, MySQLParseUnit::PuGeneric);
+      }
+    } catch (std::exception &e) {
+      logWarning("Error while warming up the parser: %s\n", e.what());
+    }
+    logDebug2("Parser warm up took %f ticks\n", base::timestamp() - start);
+  });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MySQLParserServicesImpl::~MySQLParserServicesImpl() {
+  _stopWarmUp = true;
+  if (_warmUpThread.joinable())
+    _warmUpThread.join();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 MySQLParserContext::Ref MySQLParserServicesImpl::createParserContext(GrtCharacterSetsRef charsets,
                                                                      GrtVersionRef version, const std::string &sqlMode,
                                                                      bool caseSensitive) {
@@ -720,6 +884,7 @@ void resolveReferences(db_mysql_CatalogRef catalog, DbObjectsRefsCache &refCache
  */
 size_t MySQLParserServicesImpl::parseTable(MySQLParserContext::Ref context, db_mysql_TableRef table,
                                            const std::string &sql) {
+  TRACE_SPAN("parser", "MySQLParserServices::parseTable");
   logDebug2("Parse table\n");
 
   assert(table.is_valid());
@@ -770,12 +935,16 @@ size_t MySQLParserServicesImpl::parseTriggerSql(parser_ContextReferenceRef conte
 */
 size_t MySQLParserServicesImpl::parseTrigger(MySQLParserContext::Ref context, db_mysql_TriggerRef trigger,
                                              const std::string &sql) {
+  TRACE_SPAN("parser", "MySQLParserServices::parseTrigger");
+  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+  if (impl->isUnchangedDefinition(trigger, sql))
+    return impl->errors.size();
+
   logDebug2("Parse trigger\n");
 
   trigger->sqlDefinition(base::trim(sql));
   trigger->lastChangeDate(base::fmttime(0, DATETIME_FMT));
 
-  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
   auto tree = impl->parse(sql, MySQLParseUnit::PuCreateTrigger);
 
   db_mysql_TableRef table;
@@ -824,6 +993,7 @@ size_t MySQLParserServicesImpl::parseTrigger(MySQLParserContext::Ref context, db
     else
       table->customData().remove("triggerInvalid");
   }
+  impl->cacheDefinition(trigger, sql);
   return impl->errors.size();
 }
 
@@ -844,12 +1014,16 @@ size_t MySQLParserServicesImpl::parseViewSql(parser_ContextReferenceRef context_
  */
 size_t MySQLParserServicesImpl::parseView(MySQLParserContext::Ref context, db_mysql_ViewRef view,
                                           const std::string &sql) {
+  TRACE_SPAN("parser", "MySQLParserServices::parseView");
+  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+  if (impl->isUnchangedDefinition(view, sql))
+    return impl->errors.size();
+
   logDebug2("Parse view\n");
 
   view->sqlDefinition(base::trim(sql));
   view->lastChangeDate(base::fmttime(0, DATETIME_FMT));
 
-  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
   auto tree = impl->parse(sql, MySQLParseUnit::PuCreateView);
 
   if (impl->errors.empty()) {
@@ -877,6 +1051,7 @@ size_t MySQLParserServicesImpl::parseView(MySQLParserContext::Ref context, db_my
     view->modelOnly(1);
   }
 
+  impl->cacheDefinition(view, sql);
   return impl->errors.size();
 }
 
@@ -915,12 +1090,16 @@ size_t MySQLParserServicesImpl::parseRoutineSql(parser_ContextReferenceRef conte
  */
 size_t MySQLParserServicesImpl::parseRoutine(MySQLParserContext::Ref context, db_mysql_RoutineRef routine,
                                              const std::string &sql) {
+  TRACE_SPAN("parser", "MySQLParserServices::parseRoutine");
+  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+  if (impl->isUnchangedDefinition(routine, sql))
+    return impl->errors.size();
+
   logDebug2("Parse routine\n");
 
   routine->sqlDefinition(base::trim(sql));
   routine->lastChangeDate(base::fmttime(0, DATETIME_FMT));
 
-  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
   auto tree = impl->parse(sql, MySQLParseUnit::PuCreateRoutine);
 
   if (impl->errors.empty()) {
@@ -946,6 +1125,7 @@ size_t MySQLParserServicesImpl::parseRoutine(MySQLParserContext::Ref context, db
     routine->modelOnly(1);
   }
 
+  impl->cacheDefinition(routine, sql);
   return impl->errors.size();
 }
 
@@ -985,6 +1165,7 @@ size_t MySQLParserServicesImpl::parseRoutinesSql(parser_ContextReferenceRef cont
 */
 size_t MySQLParserServicesImpl::parseRoutines(MySQLParserContext::Ref context, db_mysql_RoutineGroupRef group,
                                               const std::string &sql) {
+  TRACE_SPAN("parser", "MySQLParserServices::parseRoutines");
   logDebug2("Parse routine group\n");
 
   MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
@@ -1069,6 +1250,7 @@ size_t MySQLParserServicesImpl::parseRoutines(MySQLParserContext::Ref context, d
 
       routine->sqlDefinition(base::trim(routineSQL));
       routine->lastChangeDate(base::fmttime(0, DATETIME_FMT));
+      impl->forgetDefinition(routine);
 
       // Finally add the routine to the group if it isn't already there.
       bool found = false;
@@ -1268,6 +1450,11 @@ size_t MySQLParserServicesImpl::parseSQLIntoCatalogSql(parser_ContextReferenceRe
 
 //----------------------------------------------------------------------------------------------------------------------
 
+// Scripts with fewer statements are parsed on the calling thread only.
+static const size_t PARALLEL_PARSE_MIN_STATEMENTS = 32;
+// Statements parsed in one go per scheduler thread, which is also the number of parser contexts per thread.
+static const size_t PARALLEL_PARSE_BATCH_PER_THREAD = 4;
+
 /**
 *	Expects the sql to be a single or multi-statement text in utf-8 encoding which is parsed and
 *	the details are used to build a grt tree. Existing objects are replaced unless the SQL has
@@ -1282,6 +1469,7 @@ size_t MySQLParserServicesImpl::parseSQLIntoCatalogSql(parser_ContextReferenceRe
 */
 size_t MySQLParserServicesImpl::parseSQLIntoCatalog(MySQLParserContext::Ref context, db_mysql_CatalogRef catalog,
                                                     const std::string &sql, grt::DictRef options) {
+  TRACE_SPAN("parser", "MySQLParserServices::parseSQLIntoCatalog");
   MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
 
   static std::set<MySQLQueryType> relevantQueryTypes = {
@@ -1361,551 +1549,651 @@ size_t MySQLParserServicesImpl::parseSQLIntoCatalog(MySQLParserContext::Ref cont
 
   StringListRef errors = StringListRef::cast_from(options.get("errors"));
 
+  // Statements are parsed a batch at a time, each one with its own parser context, so that all trees of a batch
+  // stay valid until they were turned into catalog objects. Parsing is spread over the task scheduler threads,
+  // the objects are created on this thread in statement order. There are two sets of batches and contexts: while
+  // this thread applies one batch to the catalog the next one is parsed in the background.
+  struct ParsedStatement {
+    std::string query;
+    MySQLQueryType queryType;
+    ParseTree *tree;
+    MySQLParserContextImpl *parser;
+  };
+
+  size_t batchSize = 1;
+  std::vector<std::shared_ptr<MySQLParserContextImpl>> batchContexts;
+  std::vector<ParsedStatement> batches[2];
+  if (ranges.size() >= PARALLEL_PARSE_MIN_STATEMENTS) {
+    batchSize = std::min(ranges.size(), base::TaskScheduler::get()->thread_count() * PARALLEL_PARSE_BATCH_PER_THREAD);
+    for (size_t i = 1; i < 2 * batchSize; ++i)
+      batchContexts.push_back(std::make_shared<MySQLParserContextImpl>(*impl));
+  }
+  bool pipelined = batchSize > 1;
+  for (size_t b = 0; b < (pipelined ? 2U : 1U); ++b) {
+    batches[b].resize(batchSize);
+    for (size_t i = 0; i < batchSize; ++i)
+      batches[b][i].parser = (b == 0 && i == 0) ? impl : batchContexts[b * batchSize + i - 1].get();
+  }
+
+  auto parseBatch = [&](std::vector<ParsedStatement> &batch, size_t batchStart) {
+    size_t count = std::min(batchSize, ranges.size() - batchStart);
+    auto parseStatement = [&](size_t i) {
+      const StatementRange &range = ranges[batchStart + i];
+      ParsedStatement &statement = batch[i];
+      statement.query.assign(sql.c_str() + range.start, range.length);
+      statement.queryType = statement.parser->determineQueryType(statement.query);
+
+      // Something we are not interested in. Don't bother parsing it.
+      statement.tree = nullptr;
+      if (relevantQueryTypes.count(statement.queryType) > 0)
+        statement.tree = statement.parser->parse(statement.query, MySQLParseUnit::PuGeneric);
+    };
+
+    if (count > 1)
+      base::TaskScheduler::get()->run_parallel(base::TaskBackground, count, parseStatement);
+    else
+      parseStatement(0);
+  };
+
+  // State of the batch parsed in the background.
+  std::mutex pendingMutex;
+  std::condition_variable pendingDone;
+  bool pendingRunning = false;
+  std::exception_ptr pendingError;
+  auto waitForPending = [&]() {
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    pendingDone.wait(lock, [&]() { return !pendingRunning; });
+  };
+
+  // The background parse uses the locals of this function, so it must be finished before an exception leaves it.
+  struct PendingGuard {
+    std::function<void()> wait;
+    ~PendingGuard() {
+      wait();
+    }
+  } pendingGuard = { waitForPending };
+
   // Collect textual FK references into a local cache. At the end this is used
   // to find actual ref tables + columns, when all tables have been parsed.
   DbObjectsRefsCache refCache;
-  for (auto &range : ranges) {
-    std::string query(sql.c_str() + range.start, range.length);
-    MySQLQueryType queryType = impl->determineQueryType(query);
-
-    if (relevantQueryTypes.count(queryType) == 0)
-      continue; // Something we are not interested in. Don't bother parsing it.
-
-    auto tree = impl->parse(query, MySQLParseUnit::PuGeneric);
-    if (!impl->errors.empty()) {
-      errorCount += impl->errors.size();
-      if (errors.is_valid()) {
-        for (auto &error : impl->errors)
-          errors.insert("(" + std::to_string(range.line) + ", " + std::to_string(error.offset) + ") "
-                        + error.message);
-      }
-      continue;
+  if (!ranges.empty())
+    parseBatch(batches[0], 0);
+  for (size_t batchStart = 0, current = 0; batchStart < ranges.size(); batchStart += batchSize) {
+    size_t count = std::min(batchSize, ranges.size() - batchStart);
+    std::vector<ParsedStatement> &batch = batches[current];
+    if (!pipelined && batchStart > 0)
+      parseBatch(batch, batchStart);
+
+    size_t nextStart = batchStart + batchSize;
+    if (pipelined && nextStart < ranges.size()) {
+      std::vector<ParsedStatement> *next = &batches[1 - current];
+      pendingRunning = true;
+      base::TaskScheduler::get()->post(base::TaskBackground, [&, next, nextStart]() {
+        std::exception_ptr error;
+        try {
+          parseBatch(*next, nextStart);
+        } catch (...) {
+          error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pendingError = error;
+        pendingRunning = false;
+        pendingDone.notify_all();
+      });
     }
+    if (pipelined)
+      grt::GRT::get()->send_progress((float)batchStart / ranges.size(), "Parsing SQL statements", "");
+
+    for (size_t i = 0; i < count; ++i) {
+      const StatementRange &range = ranges[batchStart + i];
+      const std::string &query = batch[i].query;
+      MySQLQueryType queryType = batch[i].queryType;
+      if (batch[i].tree == nullptr)
+        continue;
+
+      const std::vector<ParserErrorInfo> &parseErrors = batch[i].parser->errors;
+      auto tree = batch[i].tree;
+      if (!parseErrors.empty()) {
+        errorCount += parseErrors.size();
+        if (errors.is_valid()) {
+          for (auto &error : parseErrors)
+            errors.insert("(" + std::to_string(range.line) + ", " + std::to_string(error.offset) + ") "
+                          + error.message);
+        }
+        continue;
+      }
 
-    auto statementContext = dynamic_cast<MySQLParser::QueryContext *>(tree)->simpleStatement();
-    switch (queryType) {
-      case QtCreateDatabase: {
-        db_mysql_SchemaRef schema(grt::Initialized);
-        schema->createDate(base::fmttime(0, DATETIME_FMT));
-        schema->lastChangeDate(schema->createDate());
-        schema->owner(catalog);
-
-        SchemaListener listener(statementContext, catalog, schema, impl->caseSensitive);
-        schema->oldName(schema->name());
-
-        db_SchemaRef existing = find_named_object_in_list(catalog->schemata(), schema->name(), caseSensitive);
-        if (existing.is_valid()) {
-          if (!listener.ignoreIfExists) {
-            catalog->schemata()->remove(existing);
-            createdObjects.remove_value(existing);
+      auto statementContext = dynamic_cast<MySQLParser::QueryContext *>(tree)->simpleStatement();
+      switch (queryType) {
+        case QtCreateDatabase: {
+          db_mysql_SchemaRef schema(grt::Initialized);
+          schema->createDate(base::fmttime(0, DATETIME_FMT));
+          schema->lastChangeDate(schema->createDate());
+          schema->owner(catalog);
+
+          SchemaListener listener(statementContext, catalog, schema, impl->caseSensitive);
+          schema->oldName(schema->name());
+
+          db_SchemaRef existing = find_named_object_in_list(catalog->schemata(), schema->name(), caseSensitive);
+          if (existing.is_valid()) {
+            if (!listener.ignoreIfExists) {
+              catalog->schemata()->remove(existing);
+              createdObjects.remove_value(existing);
 
+              catalog->schemata().insert(schema);
+              createdObjects.insert(schema);
+            }
+          } else {
             catalog->schemata().insert(schema);
             createdObjects.insert(schema);
           }
-        } else {
-          catalog->schemata().insert(schema);
-          createdObjects.insert(schema);
-        }
 
-        break;
-      }
-
-      case QtUse: {
-        std::string schemaName =
-          base::unquote(statementContext->utilityStatement()->useCommand()->identifier()->getText());
-        currentSchema = ObjectListener::ensureSchemaExists(catalog, schemaName, caseSensitive);
-        break;
-      }
+          break;
+        }
 
-      case QtCreateTable: {
-        db_mysql_TableRef table(grt::Initialized);
-        table->createDate(base::fmttime(0, DATETIME_FMT));
-        table->lastChangeDate(table->createDate());
-        table->owner(currentSchema);
-
-        TableListener listener(statementContext, catalog, currentSchema, table, caseSensitive, autoGenerateFkNames,
-                               refCache);
-        table->oldName(table->name());
-
-        db_mysql_SchemaRef schema =
-          db_mysql_SchemaRef::cast_from(table->owner()); // Might be different from current schema.
-
-        // Ignore tables that use a name that is already used for a view (no drop/new-add takes place then).
-        db_mysql_ViewRef existingView = find_named_object_in_list(schema->views(), table->name());
-        if (!existingView.is_valid()) {
-          db_TableRef existingTable = find_named_object_in_list(schema->tables(), table->name());
-          if (existingTable.is_valid()) {
-            // Ignore if the table exists already?
-            if (!listener.ignoreIfExists) {
-              schema->tables()->remove(existingTable);
-              createdObjects.remove_value(existingTable);
+        case QtUse: {
+          std::string schemaName =
+            base::unquote(statementContext->utilityStatement()->useCommand()->identifier()->getText());
+          currentSchema = ObjectListener::ensureSchemaExists(catalog, schemaName, caseSensitive);
+          break;
+        }
 
+        case QtCreateTable: {
+          db_mysql_TableRef table(grt::Initialized);
+          table->createDate(base::fmttime(0, DATETIME_FMT));
+          table->lastChangeDate(table->createDate());
+          table->owner(currentSchema);
+
+          TableListener listener(statementContext, catalog, currentSchema, table, caseSensitive, autoGenerateFkNames,
+                                 refCache);
+          table->oldName(table->name());
+
+          db_mysql_SchemaRef schema =
+            db_mysql_SchemaRef::cast_from(table->owner()); // Might be different from current schema.
+
+          // Ignore tables that use a name that is already used for a view (no drop/new-add takes place then).
+          db_mysql_ViewRef existingView = find_named_object_in_list(schema->views(), table->name());
+          if (!existingView.is_valid()) {
+            db_TableRef existingTable = find_named_object_in_list(schema->tables(), table->name());
+            if (existingTable.is_valid()) {
+              // Ignore if the table exists already?
+              if (!listener.ignoreIfExists) {
+                schema->tables()->remove(existingTable);
+                createdObjects.remove_value(existingTable);
+
+                schema->tables().insert(table);
+                createdObjects.insert(table);
+              }
+            } else {
               schema->tables().insert(table);
               createdObjects.insert(table);
             }
-          } else {
-            schema->tables().insert(table);
-            createdObjects.insert(table);
           }
-        }
 
-        break;
-      }
+          break;
+        }
 
-      case QtCreateIndex: {
-        db_mysql_IndexRef index(grt::Initialized);
-        index->createDate(base::fmttime(0, DATETIME_FMT));
-        index->lastChangeDate(index->createDate());
+        case QtCreateIndex: {
+          db_mysql_IndexRef index(grt::Initialized);
+          index->createDate(base::fmttime(0, DATETIME_FMT));
+          index->lastChangeDate(index->createDate());
 
-        IndexListener listener(statementContext, catalog, currentSchema, index, impl->caseSensitive, refCache);
-        index->oldName(index->name());
+          IndexListener listener(statementContext, catalog, currentSchema, index, impl->caseSensitive, refCache);
+          index->oldName(index->name());
 
-        db_TableRef table = db_TableRef::cast_from(index->owner());
-        if (table.is_valid()) {
-          db_IndexRef existing = find_named_object_in_list(table->indices(), index->name());
-          if (existing.is_valid()) {
-            table->indices()->remove(existing);
-            createdObjects.remove_value(existing);
+          db_TableRef table = db_TableRef::cast_from(index->owner());
+          if (table.is_valid()) {
+            db_IndexRef existing = find_named_object_in_list(table->indices(), index->name());
+            if (existing.is_valid()) {
+              table->indices()->remove(existing);
+              createdObjects.remove_value(existing);
+            }
+            table->indices().insert(index);
+            createdObjects.insert(index);
           }
-          table->indices().insert(index);
-          createdObjects.insert(index);
+
+          break;
         }
 
-        break;
-      }
+        case QtCreateEvent: {
+          db_mysql_EventRef event(grt::Initialized);
+          event->sqlDefinition(base::trim(query));
+          event->createDate(base::fmttime(0, DATETIME_FMT));
+          event->lastChangeDate(event->createDate());
+          event->owner(currentSchema);
 
-      case QtCreateEvent: {
-        db_mysql_EventRef event(grt::Initialized);
-        event->sqlDefinition(base::trim(query));
-        event->createDate(base::fmttime(0, DATETIME_FMT));
-        event->lastChangeDate(event->createDate());
-        event->owner(currentSchema);
-
-        EventListener listener(statementContext, catalog, event, impl->caseSensitive);
-        event->oldName(event->name());
-
-        db_mysql_SchemaRef schema =
-          db_mysql_SchemaRef::cast_from(event->owner()); // Might be different from current schema.
-        db_EventRef existing = find_named_object_in_list(schema->events(), event->name());
-        if (existing.is_valid()) {
-          if (!listener.ignoreIfExists) // Ignore if exists?
-          {
-            schema->events()->remove(existing);
-            createdObjects.remove_value(existing);
+          EventListener listener(statementContext, catalog, event, impl->caseSensitive);
+          event->oldName(event->name());
+
+          db_mysql_SchemaRef schema =
+            db_mysql_SchemaRef::cast_from(event->owner()); // Might be different from current schema.
+          db_EventRef existing = find_named_object_in_list(schema->events(), event->name());
+          if (existing.is_valid()) {
+            if (!listener.ignoreIfExists) // Ignore if exists?
+            {
+              schema->events()->remove(existing);
+              createdObjects.remove_value(existing);
 
+              schema->events().insert(event);
+              createdObjects.insert(event);
+            }
+          } else {
             schema->events().insert(event);
             createdObjects.insert(event);
           }
-        } else {
-          schema->events().insert(event);
-          createdObjects.insert(event);
-        }
 
-        break;
-      }
+          break;
+        }
 
-      case QtCreateView: {
-        db_mysql_ViewRef view(grt::Initialized);
-        view->sqlDefinition(base::trim(base::trim(query)));
-        view->createDate(base::fmttime(0, DATETIME_FMT));
-        view->lastChangeDate(view->createDate());
-        view->owner(currentSchema);
-
-        ViewListener listener(statementContext, catalog, view, caseSensitive);
-        view->oldName(view->name());
-
-        db_mysql_SchemaRef schema =
-          db_mysql_SchemaRef::cast_from(view->owner()); // Might be different from current schema.
-
-        // Ignore views that use a name that is already used for a table (no drop/new-add takes place then).
-        db_mysql_TableRef existingTable = find_named_object_in_list(schema->tables(), view->name());
-        if (!existingTable.is_valid()) {
-          db_mysql_ViewRef existingView = find_named_object_in_list(schema->views(), view->name());
-          if (existingView.is_valid()) {
-            schema->views()->remove(existingView);
-            createdObjects.remove_value(existingView);
+        case QtCreateView: {
+          db_mysql_ViewRef view(grt::Initialized);
+          view->sqlDefinition(base::trim(base::trim(query)));
+          view->createDate(base::fmttime(0, DATETIME_FMT));
+          view->lastChangeDate(view->createDate());
+          view->owner(currentSchema);
+
+          ViewListener listener(statementContext, catalog, view, caseSensitive);
+          view->oldName(view->name());
+
+          db_mysql_SchemaRef schema =
+            db_mysql_SchemaRef::cast_from(view->owner()); // Might be different from current schema.
+
+          // Ignore views that use a name that is already used for a table (no drop/new-add takes place then).
+          db_mysql_TableRef existingTable = find_named_object_in_list(schema->tables(), view->name());
+          if (!existingTable.is_valid()) {
+            db_mysql_ViewRef existingView = find_named_object_in_list(schema->views(), view->name());
+            if (existingView.is_valid()) {
+              schema->views()->remove(existingView);
+              createdObjects.remove_value(existingView);
+            }
+            schema->views().insert(view);
+            createdObjects.insert(view);
           }
-          schema->views().insert(view);
-          createdObjects.insert(view);
+
+          break;
         }
 
-        break;
-      }
+        case QtCreateProcedure:
+        case QtCreateFunction:
+        case QtCreateUdf: {
+          db_mysql_RoutineRef routine(grt::Initialized);
+          routine->owner(currentSchema);
+          routine->sqlDefinition(base::trim(query));
+          routine->createDate(base::fmttime(0, DATETIME_FMT));
+          routine->lastChangeDate(routine->createDate());
 
-      case QtCreateProcedure:
-      case QtCreateFunction:
-      case QtCreateUdf: {
-        db_mysql_RoutineRef routine(grt::Initialized);
-        routine->owner(currentSchema);
-        routine->sqlDefinition(base::trim(query));
-        routine->createDate(base::fmttime(0, DATETIME_FMT));
-        routine->lastChangeDate(routine->createDate());
+          RoutineListener listener(statementContext, catalog, routine, caseSensitive);
+          routine->oldName(routine->name());
 
-        RoutineListener listener(statementContext, catalog, routine, caseSensitive);
-        routine->oldName(routine->name());
+          db_mysql_SchemaRef schema =
+            db_mysql_SchemaRef::cast_from(routine->owner()); // Might be different from current schema.
 
-        db_mysql_SchemaRef schema =
-          db_mysql_SchemaRef::cast_from(routine->owner()); // Might be different from current schema.
+          db_RoutineRef existing = find_named_object_in_list(schema->routines(), routine->name());
+          if (existing.is_valid()) {
+            schema->routines()->remove(existing);
+            createdObjects.remove_value(existing);
+          }
+          schema->routines().insert(routine);
+          createdObjects.insert(routine);
 
-        db_RoutineRef existing = find_named_object_in_list(schema->routines(), routine->name());
-        if (existing.is_valid()) {
-          schema->routines()->remove(existing);
-          createdObjects.remove_value(existing);
+          break;
         }
-        schema->routines().insert(routine);
-        createdObjects.insert(routine);
 
-        break;
-      }
+        case QtCreateTrigger: {
+          db_mysql_TriggerRef trigger(grt::Initialized);
+          trigger->sqlDefinition(base::trim(query));
+          trigger->createDate(base::fmttime(0, DATETIME_FMT));
+          trigger->lastChangeDate(trigger->createDate());
 
-      case QtCreateTrigger: {
-        db_mysql_TriggerRef trigger(grt::Initialized);
-        trigger->sqlDefinition(base::trim(query));
-        trigger->createDate(base::fmttime(0, DATETIME_FMT));
-        trigger->lastChangeDate(trigger->createDate());
+          TriggerListener listener(statementContext, catalog, currentSchema, trigger, caseSensitive);
+          trigger->oldName(trigger->name());
 
-        TriggerListener listener(statementContext, catalog, currentSchema, trigger, caseSensitive);
-        trigger->oldName(trigger->name());
+          // It could be the listener had to create stub table. We have to add this to our created objects list.
+          db_mysql_TableRef table = db_mysql_TableRef::cast_from(trigger->owner());
+          if (table->isStub())
+            createdObjects.insert(table);
 
-        // It could be the listener had to create stub table. We have to add this to our created objects list.
-        db_mysql_TableRef table = db_mysql_TableRef::cast_from(trigger->owner());
-        if (table->isStub())
-          createdObjects.insert(table);
+          db_TriggerRef existing = find_named_object_in_list(table->triggers(), trigger->name());
+          if (existing.is_valid()) {
+            table->triggers()->remove(existing);
+            createdObjects.remove_value(existing);
+          }
+          table->triggers().insert(trigger);
+          createdObjects.insert(trigger);
 
-        db_TriggerRef existing = find_named_object_in_list(table->triggers(), trigger->name());
-        if (existing.is_valid()) {
-          table->triggers()->remove(existing);
-          createdObjects.remove_value(existing);
+          break;
         }
-        table->triggers().insert(trigger);
-        createdObjects.insert(trigger);
 
-        break;
-      }
+        case QtCreateLogFileGroup: {
+          db_mysql_LogFileGroupRef group(grt::Initialized);
+          group->createDate(base::fmttime(0, DATETIME_FMT));
+          group->lastChangeDate(group->createDate());
+          group->owner(catalog);
 
-      case QtCreateLogFileGroup: {
-        db_mysql_LogFileGroupRef group(grt::Initialized);
-        group->createDate(base::fmttime(0, DATETIME_FMT));
-        group->lastChangeDate(group->createDate());
-        group->owner(catalog);
+          LogfileGroupListener listener(statementContext, catalog, group, impl->caseSensitive);
+          group->oldName(group->name());
 
-        LogfileGroupListener listener(statementContext, catalog, group, impl->caseSensitive);
-        group->oldName(group->name());
+          db_LogFileGroupRef existing = find_named_object_in_list(catalog->logFileGroups(), group->name());
+          if (existing.is_valid()) {
+            catalog->logFileGroups()->remove(existing);
+            createdObjects.remove_value(existing);
+          }
+
+          catalog->logFileGroups().insert(group);
+          createdObjects.insert(group);
 
-        db_LogFileGroupRef existing = find_named_object_in_list(catalog->logFileGroups(), group->name());
-        if (existing.is_valid()) {
-          catalog->logFileGroups()->remove(existing);
-          createdObjects.remove_value(existing);
+          break;
         }
 
-        catalog->logFileGroups().insert(group);
-        createdObjects.insert(group);
+        case QtCreateServer: {
+          db_mysql_ServerLinkRef server(grt::Initialized);
+          server->createDate(base::fmttime(0, DATETIME_FMT));
+          server->lastChangeDate(server->createDate());
+          server->owner(catalog);
 
-        break;
-      }
-
-      case QtCreateServer: {
-        db_mysql_ServerLinkRef server(grt::Initialized);
-        server->createDate(base::fmttime(0, DATETIME_FMT));
-        server->lastChangeDate(server->createDate());
-        server->owner(catalog);
+          ServerListener listener(statementContext, catalog, server, impl->caseSensitive);
+          server->oldName(server->name());
 
-        ServerListener listener(statementContext, catalog, server, impl->caseSensitive);
-        server->oldName(server->name());
+          db_ServerLinkRef existing = find_named_object_in_list(catalog->serverLinks(), server->name());
+          if (existing.is_valid()) {
+            catalog->serverLinks()->remove(existing);
+            createdObjects.remove_value(existing);
+          }
+          catalog->serverLinks().insert(server);
+          createdObjects.insert(server);
 
-        db_ServerLinkRef existing = find_named_object_in_list(catalog->serverLinks(), server->name());
-        if (existing.is_valid()) {
-          catalog->serverLinks()->remove(existing);
-          createdObjects.remove_value(existing);
+          break;
         }
-        catalog->serverLinks().insert(server);
-        createdObjects.insert(server);
 
-        break;
-      }
+        case QtCreateTableSpace: {
+          db_mysql_TablespaceRef tablespace(grt::Initialized);
+          tablespace->createDate(base::fmttime(0, DATETIME_FMT));
+          tablespace->lastChangeDate(tablespace->createDate());
+          tablespace->owner(catalog);
 
-      case QtCreateTableSpace: {
-        db_mysql_TablespaceRef tablespace(grt::Initialized);
-        tablespace->createDate(base::fmttime(0, DATETIME_FMT));
-        tablespace->lastChangeDate(tablespace->createDate());
-        tablespace->owner(catalog);
+          TablespaceListener listener(statementContext, catalog, tablespace, impl->caseSensitive);
+          tablespace->oldName(tablespace->name());
 
-        TablespaceListener listener(statementContext, catalog, tablespace, impl->caseSensitive);
-        tablespace->oldName(tablespace->name());
+          db_TablespaceRef existing = find_named_object_in_list(catalog->tablespaces(), tablespace->name());
+          if (existing.is_valid()) {
+            catalog->tablespaces()->remove(existing);
+            createdObjects.remove_value(existing);
+          }
+          catalog->tablespaces().insert(tablespace);
+          createdObjects.insert(tablespace);
 
-        db_TablespaceRef existing = find_named_object_in_list(catalog->tablespaces(), tablespace->name());
-        if (existing.is_valid()) {
-          catalog->tablespaces()->remove(existing);
-          createdObjects.remove_value(existing);
+          break;
         }
-        catalog->tablespaces().insert(tablespace);
-        createdObjects.insert(tablespace);
-
-        break;
-      }
 
-      case QtDropDatabase: {
-        std::string name = base::unquote(statementContext->dropStatement()->dropDatabase()->schemaRef()->getText());
-        db_SchemaRef schema = find_named_object_in_list(catalog->schemata(), name);
-        if (schema.is_valid()) {
-          catalog->schemata()->remove(schema);
-          createdObjects.remove_value(schema);
-
-          if (catalog->defaultSchema() == schema)
-            catalog->defaultSchema(db_mysql_SchemaRef());
-          if (currentSchema == schema)
-            currentSchema = db_mysql_SchemaRef::cast_from(catalog->defaultSchema());
-          if (!currentSchema.is_valid())
-            currentSchema = ObjectListener::ensureSchemaExists(catalog, "default_schema", caseSensitive);
+        case QtDropDatabase: {
+          std::string name = base::unquote(statementContext->dropStatement()->dropDatabase()->schemaRef()->getText());
+          db_SchemaRef schema = find_named_object_in_list(catalog->schemata(), name);
+          if (schema.is_valid()) {
+            catalog->schemata()->remove(schema);
+            createdObjects.remove_value(schema);
+
+            if (catalog->defaultSchema() == schema)
+              catalog->defaultSchema(db_mysql_SchemaRef());
+            if (currentSchema == schema)
+              currentSchema = db_mysql_SchemaRef::cast_from(catalog->defaultSchema());
+            if (!currentSchema.is_valid())
+              currentSchema = ObjectListener::ensureSchemaExists(catalog, "default_schema", caseSensitive);
+          }
+          break;
         }
-        break;
-      }
 
-      case QtDropEvent: {
-        IdentifierListener listener(statementContext->dropStatement()->dropEvent()->eventRef());
+        case QtDropEvent: {
+          IdentifierListener listener(statementContext->dropStatement()->dropEvent()->eventRef());
 
-        db_SchemaRef schema = currentSchema;
-        if (listener.parts.size() > 1 && !listener.parts[0].empty())
-          schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
-        db_EventRef event = find_named_object_in_list(schema->events(), listener.parts.back());
-        if (event.is_valid()) {
-          schema->events()->remove(event);
-          createdObjects.remove_value(event);
-        }
-
-        break;
-      }
+          db_SchemaRef schema = currentSchema;
+          if (listener.parts.size() > 1 && !listener.parts[0].empty())
+            schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+          db_EventRef event = find_named_object_in_list(schema->events(), listener.parts.back());
+          if (event.is_valid()) {
+            schema->events()->remove(event);
+            createdObjects.remove_value(event);
+          }
 
-      case QtDropProcedure:
-      case QtDropFunction: // Including UDFs.
-      {
-        tree::ParseTree *nameContext;
-        if (queryType == QtDropFunction)
-          nameContext = statementContext->dropStatement()->dropFunction()->functionRef();
-        else
-          nameContext = statementContext->dropStatement()->dropProcedure()->procedureRef();
-        IdentifierListener listener(nameContext);
-
-        db_SchemaRef schema = currentSchema;
-        if (listener.parts.size() > 1 && !listener.parts[0].empty())
-          schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
-        db_RoutineRef routine = find_named_object_in_list(schema->routines(), listener.parts.back());
-        if (routine.is_valid()) {
-          schema->routines()->remove(routine);
-          createdObjects.remove_value(routine);
+          break;
         }
 
-        break;
-      }
-
-      case QtDropIndex: {
-        std::string name;
+        case QtDropProcedure:
+        case QtDropFunction: // Including UDFs.
         {
-          IdentifierListener listener(statementContext->dropStatement()->dropIndex()->indexRef());
-          name = listener.parts.back();
-        }
+          tree::ParseTree *nameContext;
+          if (queryType == QtDropFunction)
+            nameContext = statementContext->dropStatement()->dropFunction()->functionRef();
+          else
+            nameContext = statementContext->dropStatement()->dropProcedure()->procedureRef();
+          IdentifierListener listener(nameContext);
 
-        IdentifierListener listener(statementContext->dropStatement()->dropIndex()->tableRef());
-
-        db_SchemaRef schema = currentSchema;
-        if (listener.parts.size() > 1 && !listener.parts[0].empty())
-          schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
-        db_TableRef table = find_named_object_in_list(schema->tables(), listener.parts.back());
-        if (table.is_valid()) {
-          db_IndexRef index = find_named_object_in_list(table->indices(), name);
-          if (index.is_valid()) {
-            table->indices()->remove(index);
-            createdObjects.remove_value(index);
+          db_SchemaRef schema = currentSchema;
+          if (listener.parts.size() > 1 && !listener.parts[0].empty())
+            schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+          db_RoutineRef routine = find_named_object_in_list(schema->routines(), listener.parts.back());
+          if (routine.is_valid()) {
+            schema->routines()->remove(routine);
+            createdObjects.remove_value(routine);
           }
-        }
-        break;
-      }
 
-      case QtDropLogfileGroup: {
-        IdentifierListener listener(statementContext->dropStatement()->dropLogfileGroup()->logfileGroupRef());
-
-        db_LogFileGroupRef group = find_named_object_in_list(catalog->logFileGroups(), listener.parts.back());
-        if (group.is_valid()) {
-          catalog->logFileGroups()->remove(group);
-          createdObjects.remove_value(group);
+          break;
         }
 
-        break;
-      }
-
-      case QtDropServer: {
-        IdentifierListener listener(statementContext->dropStatement()->dropServer()->serverRef());
-        db_ServerLinkRef server = find_named_object_in_list(catalog->serverLinks(), listener.parts.back());
-        if (server.is_valid()) {
-          catalog->serverLinks()->remove(server);
-          createdObjects.remove_value(server);
-        }
+        case QtDropIndex: {
+          std::string name;
+          {
+            IdentifierListener listener(statementContext->dropStatement()->dropIndex()->indexRef());
+            name = listener.parts.back();
+          }
 
-        break;
-      }
+          IdentifierListener listener(statementContext->dropStatement()->dropIndex()->tableRef());
 
-      case QtDropTable: {
-        // We can have a list of tables to drop here.
-        for (auto tableRef : statementContext->dropStatement()->dropTable()->tableRefList()->tableRef()) {
-          IdentifierListener listener(tableRef);
           db_SchemaRef schema = currentSchema;
           if (listener.parts.size() > 1 && !listener.parts[0].empty())
             schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
-
           db_TableRef table = find_named_object_in_list(schema->tables(), listener.parts.back());
           if (table.is_valid()) {
-            schema->tables()->remove(table);
-            createdObjects.remove_value(table);
+            db_IndexRef index = find_named_object_in_list(table->indices(), name);
+            if (index.is_valid()) {
+              table->indices()->remove(index);
+              createdObjects.remove_value(index);
+            }
           }
+          break;
         }
 
-        break;
-      }
+        case QtDropLogfileGroup: {
+          IdentifierListener listener(statementContext->dropStatement()->dropLogfileGroup()->logfileGroupRef());
 
-      case QtDropView: {
-        // We can have a list of views to drop here.
-        for (auto tableRef : statementContext->dropStatement()->dropView()->viewRefList()->viewRef()) {
-          IdentifierListener listener(tableRef);
-          db_SchemaRef schema = currentSchema;
-          if (listener.parts.size() > 1 && !listener.parts[0].empty())
-            schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+          db_LogFileGroupRef group = find_named_object_in_list(catalog->logFileGroups(), listener.parts.back());
+          if (group.is_valid()) {
+            catalog->logFileGroups()->remove(group);
+            createdObjects.remove_value(group);
+          }
 
-          db_ViewRef view = find_named_object_in_list(schema->views(), listener.parts.back());
-          if (view.is_valid()) {
-            schema->views()->remove(view);
-            createdObjects.remove_value(view);
+          break;
+        }
+
+        case QtDropServer: {
+          IdentifierListener listener(statementContext->dropStatement()->dropServer()->serverRef());
+          db_ServerLinkRef server = find_named_object_in_list(catalog->serverLinks(), listener.parts.back());
+          if (server.is_valid()) {
+            catalog->serverLinks()->remove(server);
+            createdObjects.remove_value(server);
           }
+
+          break;
         }
 
-        break;
-      }
+        case QtDropTable: {
+          // We can have a list of tables to drop here.
+          for (auto tableRef : statementContext->dropStatement()->dropTable()->tableRefList()->tableRef()) {
+            IdentifierListener listener(tableRef);
+            db_SchemaRef schema = currentSchema;
+            if (listener.parts.size() > 1 && !listener.parts[0].empty())
+              schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+
+            db_TableRef table = find_named_object_in_list(schema->tables(), listener.parts.back());
+            if (table.is_valid()) {
+              schema->tables()->remove(table);
+              createdObjects.remove_value(table);
+            }
+          }
 
-      case QtDropTablespace: {
-        IdentifierListener listener(statementContext->dropStatement()->dropTableSpace()->tablespaceRef());
-        db_TablespaceRef tablespace = find_named_object_in_list(catalog->tablespaces(), listener.parts.back());
-        if (tablespace.is_valid()) {
-          catalog->tablespaces()->remove(tablespace);
-          createdObjects.remove_value(tablespace);
+          break;
         }
 
-        break;
-      }
+        case QtDropView: {
+          // We can have a list of views to drop here.
+          for (auto tableRef : statementContext->dropStatement()->dropView()->viewRefList()->viewRef()) {
+            IdentifierListener listener(tableRef);
+            db_SchemaRef schema = currentSchema;
+            if (listener.parts.size() > 1 && !listener.parts[0].empty())
+              schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+
+            db_ViewRef view = find_named_object_in_list(schema->views(), listener.parts.back());
+            if (view.is_valid()) {
+              schema->views()->remove(view);
+              createdObjects.remove_value(view);
+            }
+          }
 
-      case QtDropTrigger: {
-        IdentifierListener listener(statementContext->dropStatement()->dropTrigger()->triggerRef());
+          break;
+        }
 
-        // Even though triggers are schema level objects they work on specific tables
-        // and that's why we store them under the affected tables, not in the schema object.
-        // This however makes it more difficult to find the trigger to delete, as we have to
-        // iterate over all tables.
-        db_SchemaRef schema = currentSchema;
-        if (listener.parts.size() > 1 && !listener.parts[0].empty())
-          schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+        case QtDropTablespace: {
+          IdentifierListener listener(statementContext->dropStatement()->dropTableSpace()->tablespaceRef());
+          db_TablespaceRef tablespace = find_named_object_in_list(catalog->tablespaces(), listener.parts.back());
+          if (tablespace.is_valid()) {
+            catalog->tablespaces()->remove(tablespace);
+            createdObjects.remove_value(tablespace);
+          }
 
-        for (auto table : schema->tables()) {
-          db_TriggerRef trigger = find_named_object_in_list(table->triggers(), listener.parts.back());
-          if (trigger.is_valid()) {
-            table->triggers()->remove(trigger);
-            createdObjects.remove_value(trigger);
+          break;
+        }
+
+        case QtDropTrigger: {
+          IdentifierListener listener(statementContext->dropStatement()->dropTrigger()->triggerRef());
+
+          // Even though triggers are schema level objects they work on specific tables
+          // and that's why we store them under the affected tables, not in the schema object.
+          // This however makes it more difficult to find the trigger to delete, as we have to
+          // iterate over all tables.
+          db_SchemaRef schema = currentSchema;
+          if (listener.parts.size() > 1 && !listener.parts[0].empty())
+            schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+
+          for (auto table : schema->tables()) {
+            db_TriggerRef trigger = find_named_object_in_list(table->triggers(), listener.parts.back());
+            if (trigger.is_valid()) {
+              table->triggers()->remove(trigger);
+              createdObjects.remove_value(trigger);
 
-            break; // A trigger can only be assigned to a single table, so we can stop here.
+              break; // A trigger can only be assigned to a single table, so we can stop here.
+            }
           }
+          break;
         }
-        break;
-      }
 
-      case QtRenameTable: {
-        // Renaming a table is special as you can use it also to rename a view and to move
-        // a table from one schema to the other (not for views, though).
-        // Due to the way we store triggers we have an easy life wrt. related triggers.
-        for (auto renamePair : statementContext->renameTableStatement()->renamePair()) {
-          IdentifierListener sourceListener(renamePair->tableRef());
-
-          db_SchemaRef sourceSchema = currentSchema;
-          if (sourceListener.parts.size() > 1 && !sourceListener.parts[0].empty())
-            sourceSchema = ObjectListener::ensureSchemaExists(catalog, sourceListener.parts[0], caseSensitive);
-
-          IdentifierListener targetListener(renamePair->tableName());
-          db_SchemaRef targetSchema = currentSchema;
-          if (targetListener.parts.size() > 1 && !targetListener.parts[0].empty())
-            targetSchema = ObjectListener::ensureSchemaExists(catalog, targetListener.parts[0], caseSensitive);
-
-          db_ViewRef view = find_named_object_in_list(sourceSchema->views(), sourceListener.parts.back());
-          if (view.is_valid()) {
-            // Cannot move between schemas.
-            if (sourceSchema == targetSchema)
-              view->name(targetListener.parts.back());
-          } else {
-            // Renaming a table.
-            db_TableRef table = find_named_object_in_list(sourceSchema->tables(), sourceListener.parts.back());
-            if (table.is_valid()) {
-              if (sourceSchema != targetSchema) {
-                sourceSchema->tables()->remove(table);
-                targetSchema->tables().insert(table);
-                createdObjects.insert(table);
+        case QtRenameTable: {
+          // Renaming a table is special as you can use it also to rename a view and to move
+          // a table from one schema to the other (not for views, though).
+          // Due to the way we store triggers we have an easy life wrt. related triggers.
+          for (auto renamePair : statementContext->renameTableStatement()->renamePair()) {
+            IdentifierListener sourceListener(renamePair->tableRef());
+
+            db_SchemaRef sourceSchema = currentSchema;
+            if (sourceListener.parts.size() > 1 && !sourceListener.parts[0].empty())
+              sourceSchema = ObjectListener::ensureSchemaExists(catalog, sourceListener.parts[0], caseSensitive);
+
+            IdentifierListener targetListener(renamePair->tableName());
+            db_SchemaRef targetSchema = currentSchema;
+            if (targetListener.parts.size() > 1 && !targetListener.parts[0].empty())
+              targetSchema = ObjectListener::ensureSchemaExists(catalog, targetListener.parts[0], caseSensitive);
+
+            db_ViewRef view = find_named_object_in_list(sourceSchema->views(), sourceListener.parts.back());
+            if (view.is_valid()) {
+              // Cannot move between schemas.
+              if (sourceSchema == targetSchema)
+                view->name(targetListener.parts.back());
+            } else {
+              // Renaming a table.
+              db_TableRef table = find_named_object_in_list(sourceSchema->tables(), sourceListener.parts.back());
+              if (table.is_valid()) {
+                if (sourceSchema != targetSchema) {
+                  sourceSchema->tables()->remove(table);
+                  targetSchema->tables().insert(table);
+                  createdObjects.insert(table);
+                }
+                table->name(targetListener.parts.back());
               }
-              table->name(targetListener.parts.back());
             }
           }
-        }
 
-        break;
-      }
+          break;
+        }
 
-      // Alter commands. At the moment we only support a limited number of cases as we mostly
-      // need SQL-to-GRT conversion for create scripts.
-      case QtAlterDatabase: {
-        IdentifierListener listener(statementContext->alterStatement()->alterDatabase()->schemaRef());
+        // Alter commands. At the moment we only support a limited number of cases as we mostly
+        // need SQL-to-GRT conversion for create scripts.
+        case QtAlterDatabase: {
+          IdentifierListener listener(statementContext->alterStatement()->alterDatabase()->schemaRef());
 
-        db_mysql_SchemaRef schema = ObjectListener::ensureSchemaExists(catalog, listener.parts.back(), caseSensitive);
-        schema->lastChangeDate(base::fmttime(0, DATETIME_FMT));
+          db_mysql_SchemaRef schema = ObjectListener::ensureSchemaExists(catalog, listener.parts.back(), caseSensitive);
+          schema->lastChangeDate(base::fmttime(0, DATETIME_FMT));
 
-        SchemaListener(statementContext, catalog, schema, impl->caseSensitive);
-        break;
-      }
+          SchemaListener(statementContext, catalog, schema, impl->caseSensitive);
+          break;
+        }
 
-      case QtAlterLogFileGroup:
-        break;
+        case QtAlterLogFileGroup:
+          break;
 
-      case QtAlterFunction:
-        break;
+        case QtAlterFunction:
+          break;
 
-      case QtAlterProcedure:
-        break;
+        case QtAlterProcedure:
+          break;
 
-      case QtAlterServer:
-        break;
+        case QtAlterServer:
+          break;
 
-      case QtAlterTable: { // Alter table only for adding/removing indices and for renames.
-        IdentifierListener listener(statementContext->alterStatement()->alterTable()->tableRef());
+        case QtAlterTable: { // Alter table only for adding/removing indices and for renames.
+          IdentifierListener listener(statementContext->alterStatement()->alterTable()->tableRef());
 
-        db_mysql_SchemaRef schema = currentSchema;
-        if (listener.parts.size() > 1 && !listener.parts[0].empty())
-          schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
+          db_mysql_SchemaRef schema = currentSchema;
+          if (listener.parts.size() > 1 && !listener.parts[0].empty())
+            schema = ObjectListener::ensureSchemaExists(catalog, listener.parts[0], caseSensitive);
 
-        db_mysql_TableRef table = find_named_object_in_list(schema->tables(), listener.parts.back(), caseSensitive);
-        if (table.is_valid())
-          TableAlterListener(statementContext, catalog, table, caseSensitive, autoGenerateFkNames, refCache);
-        else {
-          db_mysql_ViewRef view = find_named_object_in_list(schema->views(), listener.parts.back(), caseSensitive);
-          if (view.is_valid())
-            TableAlterListener(statementContext, catalog, view, caseSensitive, autoGenerateFkNames, refCache);
+          db_mysql_TableRef table = find_named_object_in_list(schema->tables(), listener.parts.back(), caseSensitive);
+          if (table.is_valid())
+            TableAlterListener(statementContext, catalog, table, caseSensitive, autoGenerateFkNames, refCache);
+          else {
+            db_mysql_ViewRef view = find_named_object_in_list(schema->views(), listener.parts.back(), caseSensitive);
+            if (view.is_valid())
+              TableAlterListener(statementContext, catalog, view, caseSensitive, autoGenerateFkNames, refCache);
+          }
+          break;
         }
-        break;
-      }
 
-      case QtAlterTableSpace:
-        break;
+        case QtAlterTableSpace:
+          break;
 
-      case QtAlterEvent:
-        break;
+        case QtAlterEvent:
+          break;
 
-      case QtAlterView:
-        break;
+        case QtAlterView:
+          break;
 
-      default:
-        continue; // Ignore anything else.
+        default:
+          continue; // Ignore anything else.
+      }
     }
+
+    waitForPending();
+    if (pendingError)
+      std::rethrow_exception(pendingError);
+    if (pipelined)
+      current = 1 - current;
   }
 
   resolveReferences(catalog, refCache, context->isCaseSensitive());
@@ -1954,6 +2242,7 @@ size_t MySQLParserServicesImpl::doSyntaxCheck(parser_ContextReferenceRef context
  */
 size_t MySQLParserServicesImpl::checkSqlSyntax(MySQLParserContext::Ref context, const char *sql, size_t length,
                                                MySQLParseUnit type) {
+  TRACE_SPAN("parser", "MySQLParserServices::checkSqlSyntax");
   MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
   impl->errorCheck({sql, length}, type);
 
@@ -2118,6 +2407,78 @@ bool isLineBreak(const unsigned char *head, const unsigned char *line_break) {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+#ifdef HAVE_SSE2_SCAN
+
+static const size_t SPECIAL_CHARACTER_COUNT = 10;
+
+/**
+ * Skips over text which needs no special handling in the splitter loop (no comment or quote start, no possible
+ * DELIMITER keyword, delimiter or line break), 16 bytes at a time. Sets haveContent if anything else but
+ * whitespaces were skipped. Stops at the first special character or when less than 16 bytes are left.
+ */
+static const unsigned char *skipPlainText(const unsigned char *tail, const unsigned char *end,
+                                          const __m128i *specialCharacters, bool &haveContent) {
+  const __m128i space = _mm_set1_epi8(' ');
+  while (end - tail >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tail));
+    __m128i hits = _mm_cmpeq_epi8(chunk, specialCharacters[0]);
+    for (size_t i = 1; i < SPECIAL_CHARACTER_COUNT; ++i)
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, specialCharacters[i]));
+
+    int mask = _mm_movemask_epi8(hits);
+    int clean = 0;
+    if (mask == 0)
+      clean = 16;
+    else {
+      while ((mask & (1 << clean)) == 0)
+        ++clean;
+    }
+
+    if (!haveContent && clean > 0) {
+      // A byte is a whitespace (or control char) if max(byte, ' ') == ' ' (unsigned compare).
+      int blanks = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, space), space));
+      int cleanBits = (1 << clean) - 1;
+      if ((blanks & cleanBits) != cleanBits)
+        haveContent = true;
+    }
+
+    tail += clean;
+    if (mask != 0)
+      break;
+  }
+  return tail;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Skips over the content of a quoted text up to the closing quote or a backslash, 16 bytes at a time.
+ */
+static const unsigned char *skipQuotedText(const unsigned char *tail, const unsigned char *end, unsigned char quote) {
+  const __m128i quoteCharacter = _mm_set1_epi8(static_cast<char>(quote));
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while (end - tail >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tail));
+    int mask =
+      _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quoteCharacter), _mm_cmpeq_epi8(chunk, backslash)));
+    if (mask == 0) {
+      tail += 16;
+      continue;
+    }
+
+    while ((mask & 1) == 0) {
+      mask >>= 1;
+      ++tail;
+    }
+    break;
+  }
+  return tail;
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
 grt::BaseListRef MySQLParserServicesImpl::getSqlStatementRanges(const std::string &sql) {
 
   std::vector<StatementRange> ranges;
@@ -2139,9 +2500,11 @@ grt::BaseListRef MySQLParserServicesImpl::getSqlStatementRanges(const std::strin
 /**
  * A statement splitter to take a list of sql statements and split them into individual statements,
  * return their position and length in the original string (instead the copied strings).
+ * With SSE2 plain text and the content of quoted text are skipped in blocks of 16 bytes.
  */
 size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t length,
   const std::string &initialDelimiter, std::vector<StatementRange> &ranges, const std::string &lineBreak) {
+  TRACE_SPAN("parser", "MySQLParserServices::determineStatementRanges");
 
   static const unsigned char keyword[] = "delimiter";
 
@@ -2158,6 +2521,16 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
   size_t statementStart = 0;
   bool haveContent = false; // Set when anything else but comments were found for the current statement.
 
+#ifdef HAVE_SSE2_SCAN
+  // All characters the loop below acts on. The last one is the start of the current delimiter.
+  __m128i specialCharacters[SPECIAL_CHARACTER_COUNT];
+  const char special[] = { '/', '-', '#', '"', '\'', '`', 'd', 'D' };
+  for (size_t i = 0; i < 8; ++i)
+    specialCharacters[i] = _mm_set1_epi8(special[i]);
+  specialCharacters[8] = _mm_set1_epi8(static_cast<char>(*newLine != '\0' ? *newLine : '/'));
+  specialCharacters[9] = _mm_set1_epi8(static_cast<char>(*delimiterHead));
+#endif
+
   while (tail < end) {
     switch (*tail) {
       case '/': { // Possible multi line comment or hidden (conditional) command.
@@ -2230,6 +2603,11 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
         haveContent = true;
         char quote = *tail++;
         while (tail < end && *tail != quote) {
+#ifdef HAVE_SSE2_SCAN
+          tail = skipQuotedText(tail, end, quote);
+          if (tail == end || *tail == quote)
+            break;
+#endif
           // Skip any escaped character too.
           if (*tail == '\\')
             tail++;
@@ -2264,6 +2642,9 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
               ++run;
             delimiter = base::trim(std::string(reinterpret_cast<const char *>(tail), run - tail));
             delimiterHead = reinterpret_cast<const unsigned char *>(delimiter.c_str());
+#ifdef HAVE_SSE2_SCAN
+            specialCharacters[9] = _mm_set1_epi8(static_cast<char>(*delimiterHead));
+#endif
 
             // Skip over the delimiter statement and any following line breaks.
             while (isLineBreak(run, newLine)) {
@@ -2291,6 +2672,9 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
         if (*tail > ' ')
           haveContent = true;
         tail++;
+#ifdef HAVE_SSE2_SCAN
+        tail = skipPlainText(tail, end, specialCharacters, haveContent);
+#endif
         break;
     }
 
@@ -2479,6 +2863,7 @@ grt::DictRef MySQLParserServicesImpl::parseStatementDetails(parser_ContextRefere
 //----------------------------------------------------------------------------------------------------------------------
 
 grt::DictRef MySQLParserServicesImpl::parseStatement(MySQLParserContext::Ref context, const std::string &sql) {
+  TRACE_SPAN("parser", "MySQLParserServices::parseStatement");
   // This part can potentially grow very large because of the sheer amount of possible query types.
   // So it should be moved into an own file if it grows beyond a few 100 lines.
   MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
@@ -36,6 +36,9 @@
 #include "grtpp_module_cpp.h"
 #include "grtsqlparser/mysql_parser_services.h"
 
+#include <atomic>
+#include <thread>
+
 #ifndef HAVE_PRECOMPILED_HEADERS
 #include "grts/structs.db.mysql.h"
 #include "grts/structs.wrapper.h"
@@ -51,8 +54,10 @@
 
 class MYSQL_PARSER_PUBLIC MySQLParserServicesImpl : public parsers::MySQLParserServices, public grt::ModuleImplBase {
 public:
-  MySQLParserServicesImpl(grt::CPPModuleLoader *loader) : grt::ModuleImplBase(loader) {
+  MySQLParserServicesImpl(grt::CPPModuleLoader *loader) : grt::ModuleImplBase(loader), _stopWarmUp(false) {
+    startWarmUp();
   }
+  virtual ~MySQLParserServicesImpl();
 
   DEFINE_INIT_MODULE_DOC(
     "1.0", "Oracle Corporation", DOC_MYSQLPARSERSERVICESIMPL, grt::ModuleImplBase,
@@ -204,4 +209,10 @@ public:
   virtual std::vector<std::pair<int, std::string>> getCodeCompletionCandidates(
     parsers::MySQLParserContext::Ref context, std::pair<size_t, size_t> caret, std::string const &sql,
     std::string const &defaultSchema, bool uppercaseKeywords, parsers::SymbolTable &symbolTable) override;
+
+private:
+  std::thread _warmUpThread;
+  std::atomic<bool> _stopWarmUp;
+
+  void startWarmUp();
 };
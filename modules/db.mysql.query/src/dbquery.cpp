@@ -29,6 +29,8 @@
 
 #include "grts/structs.db.mgmt.h"
 
+#include "status_sampler.h"
+
 #define DOC_DbMySQLQueryImpl                                                       \
   "Query execution and utility routines for  MySQL servers.\n"                     \
   "\n"                                                                             \
@@ -40,10 +42,17 @@
 class DbMySQLQueryImpl : public grt::ModuleImplBase {
 public:
   DbMySQLQueryImpl(grt::CPPModuleLoader *loader)
-    : grt::ModuleImplBase(loader), _last_error_code(0), _connection_id(0), _resultset_id(0), _tunnel_id(0) {
+    : grt::ModuleImplBase(loader),
+      _last_error_code(0),
+      _connection_id(0),
+      _resultset_id(0),
+      _tunnel_id(0),
+      _sampler_id(0) {
   }
 
   virtual ~DbMySQLQueryImpl() {
+    for (auto &sampler : _samplers)
+      sampler.second->stop();
   }
 
   DEFINE_INIT_MODULE_DOC(
@@ -167,6 +176,28 @@ public:
                                 "Utility function to return a dictionary containing name/value pairs for the server "
                                 "variables, as returned by SHOW VARIABLES.",
                                 "conn_id the connection id"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::startStatusSampler,
+                                "Starts running SHOW GLOBAL STATUS in the background on the given connection, which "
+                                "must not be used for anything else until the sampler is stopped. Returns the id of "
+                                "the sampler.",
+                                "conn_id the connection id\n"
+                                "interval the time between samples in seconds\n"
+                                "history the number of samples to keep"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::stopStatusSampler, "Stops a status sampler.",
+                                "sampler the sampler id"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::statusSamplerSnapshot,
+                                "Returns a sample of a status sampler as a dictionary with the keys serial (the "
+                                "number of samples taken so far), time, elapsed (seconds since the sample before), "
+                                "error (of the last sample attempt), values (name/value pairs of all status "
+                                "variables), deltas and rates (their change since the sample before and its rate "
+                                "per second). Without a sample for the age the dictionary only has serial and error.",
+                                "sampler the sampler id\n"
+                                "age 0 for the latest sample, 1 for the one before and so on"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::statusSamplerHistory,
+                                "Returns the rates per second of a status variable in all kept samples, oldest "
+                                "first.",
+                                "sampler the sampler id\n"
+                                "name the status variable name"),
     NULL);
 
   // returns connection-id or -1 for error
@@ -230,6 +261,11 @@ public:
 
   std::string scramblePassword(const std::string &pass);
 
+  int startStatusSampler(int conn, double interval, int history);
+  int stopStatusSampler(int sampler);
+  grt::DictRef statusSamplerSnapshot(int sampler, int age);
+  grt::DoubleListRef statusSamplerHistory(int sampler, const std::string &name);
+
 private:
   struct ConnectionInfo {
     typedef std::shared_ptr<ConnectionInfo> Ref;
@@ -260,12 +296,16 @@ private:
   std::map<int, ConnectionInfo::Ref> _connections;
   std::map<int, sql::ResultSet *> _resultsets;
   std::map<int, std::shared_ptr<sql::TunnelConnection> > _tunnels;
+  std::map<int, StatusSampler::Ref> _samplers;
   std::string _last_error;
   int _last_error_code;
 
   int _connection_id;
   base::refcount_t _resultset_id;
   int _tunnel_id;
+  int _sampler_id;
+
+  StatusSampler::Ref get_sampler(int sampler);
 };
 
 GRT_MODULE_ENTRY_POINT(DbMySQLQueryImpl);
@@ -810,3 +850,91 @@ int DbMySQLQueryImpl::closeTunnel(int tunnel) {
   _tunnels.erase(tunnel);
   return 0;
 }
+
+int DbMySQLQueryImpl::startStatusSampler(int conn, double interval, int history) {
+  ConnectionInfo::Ref cinfo;
+  {
+    base::MutexLock lock(_mutex);
+    if (_connections.find(conn) == _connections.end())
+      throw std::invalid_argument("Invalid connection");
+    cinfo = _connections[conn];
+  }
+
+  // The query keeps the connection open while the sampler runs, even if it is closed meanwhile.
+  StatusSampler::Ref sampler(new StatusSampler(
+    [cinfo](StatusSampler::Rows &rows) {
+      std::unique_ptr<sql::Statement> statement(cinfo->conn->createStatement());
+      std::unique_ptr<sql::ResultSet> rset(statement->executeQuery("SHOW GLOBAL STATUS"));
+      while (rset->next())
+        rows.push_back(std::make_pair(rset->getString(1), rset->getString(2)));
+    },
+    history > 0 ? (size_t)history : 1));
+
+  // The first sample is taken right away, so callers have values and rates after the first interval.
+  sampler->sample();
+  sampler->start(interval);
+
+  base::MutexLock lock(_mutex);
+  _samplers[++_sampler_id] = sampler;
+  return _sampler_id;
+}
+
+int DbMySQLQueryImpl::stopStatusSampler(int sampler) {
+  StatusSampler::Ref ref = get_sampler(sampler);
+  ref->stop();
+
+  base::MutexLock lock(_mutex);
+  _samplers.erase(sampler);
+  return 0;
+}
+
+grt::DictRef DbMySQLQueryImpl::statusSamplerSnapshot(int sampler, int age) {
+  StatusSampler::Ref ref = get_sampler(sampler);
+
+  grt::DictRef snapshot(true);
+  snapshot.gset("serial", (long)ref->serial());
+  snapshot.gset("error", ref->last_error());
+
+  StatusSampler::Sample sample;
+  if (age < 0 || !ref->get_sample((size_t)age, sample))
+    return snapshot;
+
+  std::vector<std::string> names = ref->names();
+  grt::DictRef values(true);
+  grt::DictRef deltas(true);
+  grt::DictRef rates(true);
+  for (size_t i = 0; i < names.size() && i < sample.values.size(); ++i) {
+    values.gset(names[i], sample.values[i]);
+    deltas.gset(names[i], sample.deltas[i]);
+    rates.gset(names[i], sample.rates[i]);
+  }
+  snapshot.gset("time", sample.time);
+  snapshot.gset("elapsed", sample.elapsed);
+  snapshot.set("values", values);
+  snapshot.set("deltas", deltas);
+  snapshot.set("rates", rates);
+  return snapshot;
+}
+
+grt::DoubleListRef DbMySQLQueryImpl::statusSamplerHistory(int sampler, const std::string &name) {
+  StatusSampler::Ref ref = get_sampler(sampler);
+  grt::DoubleListRef list(grt::Initialized);
+
+  int index = ref->name_index(name);
+  if (index < 0)
+    return list;
+
+  StatusSampler::Sample sample;
+  for (size_t age = ref->history_size(); age > 0; --age) {
+    if (ref->get_sample(age - 1, sample))
+      list.insert(sample.rates[index]);
+  }
+  return list;
+}
+
+StatusSampler::Ref DbMySQLQueryImpl::get_sampler(int sampler) {
+  base::MutexLock lock(_mutex);
+  if (_samplers.find(sampler) == _samplers.end())
+    throw std::invalid_argument("Invalid status sampler");
+  return _samplers[sampler];
+}
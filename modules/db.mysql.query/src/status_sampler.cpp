@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "status_sampler.h"
+
+#include "base/log.h"
+#include "base/threaded_timer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+DEFAULT_LOG_DOMAIN("StatusSampler")
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static double parse_number(const std::string &value) {
+  if (value.empty())
+    return std::numeric_limits<double>::quiet_NaN();
+  char *end;
+  double number = strtod(value.c_str(), &end);
+  return *end == '\0' ? number : std::numeric_limits<double>::quiet_NaN();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+StatusSampler::StatusSampler(const Query &query, size_t history)
+  : _query(query),
+    _samples(history > 0 ? history : 1),
+    _last_steady_time(0),
+    _serial(0),
+    _task_id(0),
+    _stopped(false) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatusSampler::start(double interval) {
+  stop();
+  _stopped = false;
+
+  // The task keeps the sampler alive while it runs, it ends with the first run after stop().
+  Ref self = shared_from_this();
+  _task_id = ThreadedTimer::add_task(TimerTimeSpan, interval, false, [self](int) {
+    if (self->_stopped)
+      return true;
+    if (!self->sample())
+      logWarning("Sampling server status failed: %s\n", self->last_error().c_str());
+    return false;
+  });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatusSampler::stop() {
+  _stopped = true;
+  if (_task_id != 0) {
+    ThreadedTimer::remove_task(_task_id);
+    _task_id = 0;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool StatusSampler::sample() {
+  Rows rows;
+  try {
+    _query(rows);
+  } catch (std::exception &e) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _last_error = e.what();
+    return false;
+  }
+
+  double time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+  double steady_time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _last_error.clear();
+
+  Sample &sample = _samples[_serial % _samples.size()];
+  sample.time = time;
+  sample.elapsed = _serial > 0 ? steady_time - _last_steady_time : 0;
+
+  // The server normally returns the same variables in the same order, so parsing needs no lookups then.
+  std::vector<double> numbers(_names.size(), std::numeric_limits<double>::quiet_NaN());
+  sample.values.assign(_names.size(), std::string());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    size_t index = i;
+    if (i >= _names.size() || _names[i] != rows[i].first) {
+      auto known = _index.find(rows[i].first);
+      if (known != _index.end())
+        index = known->second;
+      else {
+        index = _names.size();
+        _index[rows[i].first] = index;
+        _names.push_back(rows[i].first);
+        numbers.push_back(std::numeric_limits<double>::quiet_NaN());
+        sample.values.push_back(std::string());
+      }
+    }
+    sample.values[index] = rows[i].second;
+    numbers[index] = parse_number(rows[i].second);
+  }
+
+  // Counters start over when the server was restarted, the sample before can't be compared then.
+  auto uptime = _index.find("Uptime");
+  if (uptime != _index.end() && uptime->second < _numbers.size() &&
+      !(numbers[uptime->second] >= _numbers[uptime->second]))
+    sample.elapsed = 0;
+
+  sample.deltas.assign(numbers.size(), 0);
+  sample.rates.assign(numbers.size(), 0);
+  if (sample.elapsed > 0) {
+    for (size_t i = 0; i < numbers.size() && i < _numbers.size(); ++i) {
+      if (std::isnan(numbers[i]) || std::isnan(_numbers[i]))
+        continue;
+      sample.deltas[i] = numbers[i] - _numbers[i];
+      sample.rates[i] = sample.deltas[i] / sample.elapsed;
+    }
+  }
+
+  _numbers.swap(numbers);
+  _last_steady_time = steady_time;
+  ++_serial;
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool StatusSampler::get_sample(size_t age, Sample &sample) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (age >= _serial || age >= _samples.size())
+    return false;
+  sample = _samples[(_serial - 1 - age) % _samples.size()];
+  // Variables the server reported only later are missing in older samples.
+  sample.values.resize(_names.size());
+  sample.deltas.resize(_names.size(), 0);
+  sample.rates.resize(_names.size(), 0);
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<std::string> StatusSampler::names() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _names;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int StatusSampler::name_index(const std::string &name) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto index = _index.find(name);
+  return index != _index.end() ? (int)index->second : -1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t StatusSampler::serial() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _serial;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t StatusSampler::history_size() const {
+  return _samples.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string StatusSampler::last_error() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _last_error;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Samples the global status of a server in the background and keeps the history of all counters, with their change
+ * since the sample before and its rate per second. The performance dashboard and the admin monitor read the
+ * samples from here, instead of running and parsing SHOW GLOBAL STATUS in their own timers.
+ *
+ * Samples are taken in a ThreadedTimer task, on a connection nobody else uses meanwhile.
+ */
+class StatusSampler : public std::enable_shared_from_this<StatusSampler> {
+public:
+  typedef std::shared_ptr<StatusSampler> Ref;
+  typedef std::vector<std::pair<std::string, std::string> > Rows;
+  // Runs the status query and returns its name/value rows. Errors are reported with exceptions.
+  typedef std::function<void(Rows &rows)> Query;
+
+  struct Sample {
+    double time;    // Seconds since the epoch, as Python's time.time().
+    double elapsed; // Seconds since the sample before, 0 for the first one and after a server restart.
+    std::vector<std::string> values;
+    std::vector<double> deltas; // Change since the sample before, 0 for values that aren't numbers.
+    std::vector<double> rates;  // deltas per second.
+
+    Sample() : time(0), elapsed(0) {
+    }
+  };
+
+  StatusSampler(const Query &query, size_t history);
+
+  // Takes a sample every interval seconds until stop() is called.
+  void start(double interval);
+  void stop();
+
+  // Takes a sample now, returns false if the query failed.
+  bool sample();
+
+  // The sample taken age samples ago, false if there is none. Values are in the order of names().
+  bool get_sample(size_t age, Sample &sample) const;
+  std::vector<std::string> names() const;
+  // Index of a status variable in names(), -1 if the server didn't report it.
+  int name_index(const std::string &name) const;
+
+  // Number of samples taken so far, which tells readers whether there is a new one.
+  size_t serial() const;
+  size_t history_size() const;
+  std::string last_error() const;
+
+private:
+  Query _query;
+  mutable std::mutex _mutex;
+  std::vector<std::string> _names;
+  std::unordered_map<std::string, size_t> _index;
+  std::vector<Sample> _samples; // Ring buffer, _serial % size is the next one to overwrite.
+  std::vector<double> _numbers; // Numeric values of the last sample, NaN where the value isn't a number.
+  double _last_steady_time;
+  size_t _serial;
+  std::string _last_error;
+
+  int _task_id;
+  std::atomic<bool> _stopped;
+};
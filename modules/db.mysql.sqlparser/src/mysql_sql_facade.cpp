@@ -39,6 +39,7 @@
 #include "mysql_sql_statement_decomposer.h"
 #include "mysql_sql_schema_rename.h"
 #include "base/string_utilities.h"
+#include "grtsqlparser/mysql_parser_services.h"
 
 #include "myx_statement_parser.h"
 #include "mysql_sql_parser_fe.h"
@@ -48,8 +49,14 @@ using namespace bec;
 
 //--------------------------------------------------------------------------------------------------
 
+// Splitting is done by the parser services, the statement parser of the old parser copies every statement
+// character by character and is much slower on large scripts.
 int MysqlSqlFacadeImpl::splitSqlScript(const std::string &sql, std::list<std::string> &statements) {
-  return Mysql_sql_script_splitter::create()->process(sql, statements);
+  std::vector<parsers::StatementRange> ranges;
+  parsers::MySQLParserServices::get()->determineStatementRanges(sql.c_str(), sql.size(), ";", ranges);
+  for (std::vector<parsers::StatementRange>::const_iterator i = ranges.begin(); i != ranges.end(); ++i)
+    statements.push_back(sql.substr(i->start, i->length));
+  return 0;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -248,13 +255,13 @@ int MysqlSqlFacadeImpl::splitSqlScript(const char *sql, std::size_t length, cons
 // A splitter using the grt (probably for python).
 grt::BaseListRef MysqlSqlFacadeImpl::getSqlStatementRanges(const std::string &sql) {
   grt::BaseListRef list(true);
-  std::list<std::pair<std::size_t, std::size_t> > ranges;
-  Mysql_sql_script_splitter::create()->process(sql.c_str(), ranges);
+  std::vector<parsers::StatementRange> ranges;
+  parsers::MySQLParserServices::get()->determineStatementRanges(sql.c_str(), sql.size(), ";", ranges);
 
-  for (std::list<std::pair<size_t, size_t> >::const_iterator i = ranges.begin(); i != ranges.end(); ++i) {
+  for (std::vector<parsers::StatementRange>::const_iterator i = ranges.begin(); i != ranges.end(); ++i) {
     grt::BaseListRef item(true);
-    item.ginsert(grt::IntegerRef((long)i->first));
-    item.ginsert(grt::IntegerRef((long)i->second));
+    item.ginsert(grt::IntegerRef((long)i->start));
+    item.ginsert(grt::IntegerRef((long)i->length));
     list.ginsert(item);
   }
   return list;
@@ -29,6 +29,14 @@
 #include "testgrt.h"
 #include "grtsqlparser/sql_facade.h"
 #include "wb_helpers.h"
+#include "base/string_utilities.h"
+#include "db.mysql.sqlparser/src/mysql_sql_script_splitter.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#define VERBOSE_OUTPUT 0
 
 BEGIN_TEST_DATA_CLASS(mysql_sql_facade)
 public:
@@ -230,6 +238,100 @@ TEST_FUNCTION(11) {
   ensure_equals("Unexpected Column Count", columns.size(), 0U);
 }
 
+// Dumps the statement splitting is compared on, the old splitter and the parser services one.
+static const char *split_test_files[] = {"data/db/sakila-db/sakila-schema.sql", "data/db/sakila-db/sakila-data.sql",
+                                         "data/db/nasty_tables.sql"};
+
+static std::string load_split_test_file(const std::string &name) {
+  std::ifstream stream(name.c_str(), std::ios::binary);
+  ensure("Error loading sql file: " + name, stream.good());
+  return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+}
+
+// The old splitter keeps whitespace and comments before a statement and returns comment-only statements,
+// the new one skips them.
+static std::string strip_leading_comments(const std::string &statement) {
+  size_t pos = 0;
+  while (pos < statement.size()) {
+    if (isspace((unsigned char)statement[pos]))
+      ++pos;
+    else if (statement[pos] == '#' || statement.compare(pos, 3, "-- ") == 0 || statement.compare(pos, 3, "--\t") == 0 ||
+             statement.compare(pos, 3, "--\n") == 0)
+      pos = std::min(statement.find('\n', pos), statement.size());
+    else if (statement.compare(pos, 2, "/*") == 0 && statement.compare(pos, 3, "/*!") != 0) {
+      size_t end = statement.find("*/", pos);
+      pos = end == std::string::npos ? statement.size() : end + 2;
+    }
+    else
+      break;
+  }
+  return statement.substr(pos);
+}
+
+// Splitting scripts must give the same statements as the old statement parser did.
+TEST_FUNCTION(12) {
+  for (size_t i = 0; i < sizeof(split_test_files) / sizeof(split_test_files[0]); ++i) {
+    std::string sql = load_split_test_file(split_test_files[i]);
+
+    std::list<std::string> old_statements;
+    Mysql_sql_script_splitter::create()->process(sql, old_statements);
+    std::vector<std::string> expected;
+    for (std::list<std::string>::const_iterator s = old_statements.begin(); s != old_statements.end(); ++s) {
+      std::string statement = strip_leading_comments(*s);
+      if (!statement.empty())
+        expected.push_back(statement);
+    }
+
+    std::list<std::string> statements;
+    sql_facade->splitSqlScript(sql, statements);
+    ensure_equals(std::string("Statement count in ") + split_test_files[i], statements.size(), expected.size());
+
+    size_t n = 0;
+    for (std::list<std::string>::const_iterator s = statements.begin(); s != statements.end(); ++s, ++n)
+      ensure_equals(std::string("Statement in ") + split_test_files[i], base::trim_right(*s),
+                    base::trim_right(expected[n]));
+  }
+}
+
+// Both splitters must agree on the combined dumps. Timings are only printed with verbose output,
+// they depend too much on the machine to be checked.
+TEST_FUNCTION(13) {
+  std::string sql;
+  for (size_t i = 0; i < sizeof(split_test_files) / sizeof(split_test_files[0]); ++i)
+    sql += load_split_test_file(split_test_files[i]) + "\n";
+
+#if VERBOSE_OUTPUT
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#endif
+  std::list<std::string> old_statements;
+  Mysql_sql_script_splitter::create()->process(sql, old_statements);
+#if VERBOSE_OUTPUT
+  double old_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+#endif
+  std::list<std::string> statements;
+  sql_facade->splitSqlScript(sql, statements);
+#if VERBOSE_OUTPUT
+  double new_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "Splitting " << (sql.size() >> 10) << " KB: old splitter " << old_time << " s, parser services "
+            << new_time << " s" << std::endl;
+#endif
+
+  std::vector<std::string> expected;
+  for (std::list<std::string>::const_iterator s = old_statements.begin(); s != old_statements.end(); ++s) {
+    std::string statement = strip_leading_comments(*s);
+    if (!statement.empty())
+      expected.push_back(statement);
+  }
+
+  ensure_equals("Statement count", statements.size(), expected.size());
+  size_t n = 0;
+  for (std::list<std::string>::const_iterator s = statements.begin(); s != statements.end(); ++s, ++n)
+    ensure_equals("Statement", base::trim_right(*s), base::trim_right(expected[n]));
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -38,6 +38,9 @@ def check_interruption():
 
 _connections = {}
 
+# number of objects whose definition is fetched with a single query
+RE_FETCH_BATCH_SIZE = 100
+
 def get_connection(connection_object):
     if connection_object.__id__ in _connections:
         return _connections[connection_object.__id__]
@@ -285,13 +288,24 @@ def reverseEngineer(connection, catalog_name, schemata_list, context):
         grt.send_progress(0.1 * (i/len(schemata_list)), "Preparing...")
         i += 1.0
 
-    def wrap_sql(sql, schema):
-        return "USE `%s`;\n%s"%(escape_sql_identifier(schema), sql)
-
-    def wrap_routine_sql(sql):
-        return "DELIMITER " + grt.root.wb.options.options['SqlDelimiter'] + "\n" + sql
-
-    i = 0.0
+    def fetch_definitions(schema_name, object_type, names, field):
+        # SHOW CREATE statements are sent in batches as one multi-statement query, which saves a round trip
+        # per object on schemas with many of them
+        definitions = []
+        for start in range(0, len(names), RE_FETCH_BATCH_SIZE):
+            check_interruption()
+            batch = names[start:start + RE_FETCH_BATCH_SIZE]
+            grt.send_progress(0.1 + 0.9 * (progress[0] / total), "Retrieving %s %s.%s..." % (object_type.lower(), schema_name, batch[0]))
+            query = ";\n".join("SHOW CREATE %s `%s`.`%s`" % (object_type, escape_sql_identifier(schema_name), escape_sql_identifier(name)) for name in batch)
+            results = get_connection(connection).executeQueryMultiResult(query)
+            for index, name in enumerate(batch):
+                if index >= len(results) or not results[index].nextRow():
+                    raise Exception("Could not fetch %s information for %s.%s" % (object_type.lower(), schema_name, name))
+                definitions.append(results[index].stringByIndex(2) if field is None else results[index].stringByName(field))
+            progress[0] += 0.5 * len(batch)
+        return definitions
+
+    progress = [0.0]
     for schema_name in schemata_list:
         schema = grt.classes.db_mysql_Schema()
         schema.owner = catalog
@@ -300,75 +314,43 @@ def reverseEngineer(connection, catalog_name, schemata_list, context):
         context = grt.modules.MySQLParserServices.createNewParserContext(catalog.characterSets, getServerVersion(connection), getServerMode(connection), 1)
         options = {}
 
+        # all definitions of the schema are parsed in one go, which lets the parser work on several statements
+        # in parallel and resolve foreign keys to tables that come later in the schema
+        statements = []
+        routines = []
         if get_tables or get_views:
             grt.send_info("Reverse engineering tables from %s" % schema_name)
-            for table_name in table_names_per_schema[schema_name]:
-                check_interruption()
-                grt.send_progress(0.1 + 0.9 * (i / total), "Retrieving table %s.%s..." % (schema_name, table_name))
-                result = execute_query(connection, "SHOW CREATE TABLE `%s`.`%s`" % (escape_sql_identifier(schema_name), escape_sql_identifier(table_name)))
-                i += 0.5
-                grt.send_progress(0.1 + 0.9 * (i / total), "Reverse engineering %s.%s..." % (schema_name, table_name))
-                if result and result.nextRow():
-                    sql = result.stringByIndex(2)
-                    grt.push_message_handler(filter_warnings)
-                    grt.begin_progress_step(0.1 + 0.9 * (i / total), 0.1 + 0.9 * ((i+0.5) / total))
-                    grt.modules.MySQLParserServices.parseSQLIntoCatalogSql(context, catalog, wrap_sql(sql, schema_name), options)
-                    grt.end_progress_step()
-                    grt.pop_message_handler()
-                    i += 0.5
-                else:
-                    raise Exception("Could not fetch table information for %s.%s" % (schema_name, table_name))
+            statements += fetch_definitions(schema_name, "TABLE", table_names_per_schema[schema_name], None)
 
         if get_triggers:
             grt.send_info("Reverse engineering triggers from %s" % schema_name)
-            for trigger_name in trigger_names_per_schema[schema_name]:
-                check_interruption()
-                grt.send_progress(0.1 + 0.9 * (i / total), "Retrieving trigger %s.%s..." % (schema_name, trigger_name))
-                result = execute_query(connection, "SHOW CREATE TRIGGER `%s`.`%s`" % (escape_sql_identifier(schema_name), escape_sql_identifier(trigger_name)))
-                i += 0.5
-                grt.send_progress(0.1 + 0.9 * (i / total), "Reverse engineering %s.%s..." % (schema_name, trigger_name))
-                if result and result.nextRow():
-                    sql = result.stringByName("SQL Original Statement")
-                    grt.begin_progress_step(0.1 + 0.9 * (i / total), 0.1 + 0.9 * ((i+0.5) / total))
-                    grt.modules.MySQLParserServices.parseSQLIntoCatalogSql(context, catalog, wrap_sql(wrap_routine_sql(sql), schema_name), options)
-                    grt.end_progress_step()
-                    i += 0.5
-                else:
-                    raise Exception("Could not fetch trigger information for %s.%s" % (schema_name, trigger_name))
-        
+            routines += fetch_definitions(schema_name, "TRIGGER", trigger_names_per_schema[schema_name], "SQL Original Statement")
+
         if get_routines:
             grt.send_info("Reverse engineering stored procedures from %s" % schema_name)
             procedure_names, function_names = routine_names_per_schema[schema_name]
-            for name in procedure_names:
-                check_interruption()
-                grt.send_progress(0.1 + 0.9 * (i / total), "Retrieving stored procedure %s.%s..." % (schema_name, name))
-                result = execute_query(connection, "SHOW CREATE PROCEDURE `%s`.`%s`" % (escape_sql_identifier(schema_name), escape_sql_identifier(name)))
-                i += 0.5
-                grt.send_progress(0.1 + 0.9 * (i / total), "Reverse engineering %s.%s..." % (schema_name, name))
-                if result and result.nextRow():
-                    sql = result.stringByName("Create Procedure")
-                    grt.begin_progress_step(0.1 + 0.9 * (i / total), 0.1 + 0.9 * ((i+0.5) / total))
-                    grt.modules.MySQLParserServices.parseSQLIntoCatalogSql(context, catalog, wrap_sql(wrap_routine_sql(sql), schema_name), options)
-                    grt.end_progress_step()
-                    i += 0.5
-                else:
-                    raise Exception("Could not fetch procedure information for %s.%s" % (schema_name, name))
+            routines += fetch_definitions(schema_name, "PROCEDURE", procedure_names, "Create Procedure")
 
             grt.send_info("Reverse engineering functions from %s" % schema_name)
-            for name in function_names:
-                check_interruption()
-                grt.send_progress(0.1 + 0.9 * (i / total), "Retrieving function %s.%s..." % (schema_name, name))
-                result = execute_query(connection, "SHOW CREATE FUNCTION `%s`.`%s`" % (escape_sql_identifier(schema_name), escape_sql_identifier(name)))
-                i += 0.5
-                grt.send_progress(0.1 + 0.9 * (i / total), "Reverse engineering %s.%s..." % (schema_name, name))
-                if result and result.nextRow():
-                    sql = result.stringByName("Create Function")
-                    grt.begin_progress_step(0.1 + 0.9 * (i / total), 0.1 + 0.9 * ((i+0.5) / total))
-                    grt.modules.MySQLParserServices.parseSQLIntoCatalogSql(context, catalog, wrap_sql(wrap_routine_sql(sql), schema_name), options)
-                    grt.end_progress_step()
-                    i += 0.5
-                else:
-                    raise Exception("Could not fetch function information for %s.%s" % (schema_name, name))
+            routines += fetch_definitions(schema_name, "FUNCTION", function_names, "Create Function")
+
+        object_count = len(statements) + len(routines)
+        if object_count == 0:
+            continue
+
+        check_interruption()
+        sql = "USE `%s`;\n" % escape_sql_identifier(schema_name) + "".join(statement + ";\n" for statement in statements)
+        if routines:
+            delimiter = grt.root.wb.options.options['SqlDelimiter']
+            sql += "DELIMITER %s\n" % delimiter + "".join(routine + delimiter + "\n" for routine in routines)
+
+        grt.send_progress(0.1 + 0.9 * (progress[0] / total), "Reverse engineering objects from %s..." % schema_name)
+        grt.push_message_handler(filter_warnings)
+        grt.begin_progress_step(0.1 + 0.9 * (progress[0] / total), 0.1 + 0.9 * ((progress[0] + 0.5 * object_count) / total))
+        grt.modules.MySQLParserServices.parseSQLIntoCatalogSql(context, catalog, sql, options)
+        grt.end_progress_step()
+        grt.pop_message_handler()
+        progress[0] += 0.5 * object_count
 
     grt.send_progress(1.0, "Reverse engineered %i objects" % total)
     
@@ -376,7 +358,7 @@ def reverseEngineer(connection, catalog_name, schemata_list, context):
     empty_schemas = []
     for schema in catalog.schemata:
         schema_has_stub_tables = False
-        for table in reversed(schema.tables):
+        for table in reversed(schema.tables[:]):
             if table.isStub:
                 grt.send_warning("Table %s was referenced from another table, but was not reverse engineered" % table.name)
                 schema.tables.remove(table)
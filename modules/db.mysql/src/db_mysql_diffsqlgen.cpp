@@ -31,9 +31,14 @@
 #include "db_mysql_diffsqlgen_grant.h"
 
 #include "grt/common.h"
+#include "base/task_scheduler.h"
 
 #include <algorithm>
+#include <atomic>
 #include <ctype.h>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "module_db_mysql.h"
 #include "module_db_mysql_shared_code.h"
@@ -404,11 +409,13 @@ void DiffSQLGeneratorBE::generate_create_stmt(db_UserRef user) {
 }
 
 void DiffSQLGeneratorBE::generate_create_stmt(db_mysql_CatalogRef catalog) {
+  std::vector<SchemaTask> tasks;
   grt::ListRef<db_mysql_Schema> schemata = catalog->schemata();
   for (size_t count = schemata.count(), i = 0; i < count; i++) {
     db_mysql_SchemaRef schema = schemata.get(i);
-    generate_create_stmt(schema);
+    tasks.push_back([schema](DiffSQLGeneratorBE &generator) { generator.generate_create_stmt(schema); });
   }
+  run_schema_tasks(tasks);
 
   for (size_t count = catalog->users().count(), i = 0; i < count; i++) {
     db_UserRef user = catalog->users().get(i);
@@ -1353,6 +1360,8 @@ void DiffSQLGeneratorBE::generate_alter_stmt(db_mysql_SchemaRef schema, const gr
 }
 
 void DiffSQLGeneratorBE::generate_alter_stmt(db_mysql_CatalogRef catalog, const grt::DiffChange *diffchange) {
+  std::vector<SchemaTask> tasks;
+
   // process changes in schemata
   for (grt::ChangeSet::const_iterator e = diffchange->subchanges()->end(), it = diffchange->subchanges()->begin();
        it != e; it++) {
@@ -1371,25 +1380,34 @@ void DiffSQLGeneratorBE::generate_alter_stmt(db_mysql_CatalogRef catalog, const
                schemata_it != schemata_e; schemata_it++) {
             const grt::DiffChange *schema_subchange = schemata_it->get();
             switch (schema_subchange->get_change_type()) {
-              case grt::ListItemAdded:
-                generate_create_stmt(db_mysql_SchemaRef::cast_from(
+              case grt::ListItemAdded: {
+                db_mysql_SchemaRef schema(db_mysql_SchemaRef::cast_from(
                   static_cast<const grt::ListItemAddedChange *>(schema_subchange)->get_value()));
-                break;
-              case grt::ListItemRemoved:
-                generate_drop_stmt(db_mysql_SchemaRef::cast_from(
+                tasks.push_back([schema](DiffSQLGeneratorBE &generator) { generator.generate_create_stmt(schema); });
+              } break;
+              case grt::ListItemRemoved: {
+                db_mysql_SchemaRef schema(db_mysql_SchemaRef::cast_from(
                   static_cast<const grt::ListItemRemovedChange *>(schema_subchange)->get_value()));
-                break;
-              case grt::ListItemModified:
-                generate_alter_stmt(
-                  db_mysql_SchemaRef::cast_from(
-                    static_cast<const grt::ListItemModifiedChange *>(schema_subchange)->get_new_value()),
-                  static_cast<const grt::ListItemModifiedChange *>(schema_subchange)->get_subchange().get());
-                break;
+                tasks.push_back([schema](DiffSQLGeneratorBE &generator) { generator.generate_drop_stmt(schema); });
+              } break;
+              case grt::ListItemModified: {
+                const grt::ListItemModifiedChange *change =
+                  static_cast<const grt::ListItemModifiedChange *>(schema_subchange);
+                db_mysql_SchemaRef schema(db_mysql_SchemaRef::cast_from(change->get_new_value()));
+                const grt::DiffChange *schema_change = change->get_subchange().get();
+                tasks.push_back([schema, schema_change](DiffSQLGeneratorBE &generator) {
+                  generator.generate_alter_stmt(schema, schema_change);
+                });
+              } break;
               case grt::ListItemOrderChanged: {
                 const grt::ListItemOrderChange *oc = static_cast<const grt::ListItemOrderChange *>(schema_subchange);
-                if (oc->get_subchange())
-                  generate_alter_stmt(db_mysql_SchemaRef::cast_from(oc->get_subchange()->get_new_value()),
-                                      oc->get_subchange()->get_subchange().get());
+                if (oc->get_subchange()) {
+                  db_mysql_SchemaRef schema(db_mysql_SchemaRef::cast_from(oc->get_subchange()->get_new_value()));
+                  const grt::DiffChange *schema_change = oc->get_subchange()->get_subchange().get();
+                  tasks.push_back([schema, schema_change](DiffSQLGeneratorBE &generator) {
+                    generator.generate_alter_stmt(schema, schema_change);
+                  });
+                }
               } break;
               default:
                 break;
@@ -1399,6 +1417,92 @@ void DiffSQLGeneratorBE::generate_alter_stmt(db_mysql_CatalogRef catalog, const
       }
     }
   }
+
+  run_schema_tasks(tasks);
+}
+
+void DiffSQLGeneratorBE::run_schema_tasks(const std::vector<SchemaTask> &tasks) {
+  size_t thread_count = std::min((size_t)std::max(1U, std::thread::hardware_concurrency()), tasks.size());
+
+  std::vector<DiffSQLGeneratorBE> workers;
+  std::vector<std::unique_ptr<DiffSQLGeneratorBEActionInterface> > worker_callbacks;
+  for (size_t i = 0; thread_count > 1 && i < tasks.size(); ++i) {
+    DiffSQLGeneratorBE worker(*this);
+    grt::ValueRef target;
+    if (target_list.is_valid()) {
+      worker.target_list = grt::StringListRef(grt::Initialized);
+      if (target_object_list.is_valid())
+        worker.target_object_list = grt::ListRef<GrtNamedObject>(true);
+      target = worker.target_list;
+    } else {
+      worker.target_map = grt::DictRef(true);
+      target = worker.target_map;
+    }
+
+    worker.callback = callback->create_worker(target, worker.target_object_list);
+    if (!worker.callback)
+      break;
+    worker_callbacks.push_back(std::unique_ptr<DiffSQLGeneratorBEActionInterface>(worker.callback));
+    workers.push_back(worker);
+  }
+
+  if (workers.size() < tasks.size()) {
+    for (std::vector<SchemaTask>::const_iterator task = tasks.begin(); task != tasks.end(); ++task)
+      (*task)(*this);
+    return;
+  }
+
+  std::atomic<size_t> next_task(0);
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  base::TaskScheduler::get()->run_parallel(base::TaskBulk, thread_count, [&](size_t) {
+    for (size_t index = next_task++; index < tasks.size(); index = next_task++) {
+      try {
+        tasks[index](workers[index]);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  });
+
+  if (error)
+    std::rethrow_exception(error);
+
+  for (std::vector<DiffSQLGeneratorBE>::const_iterator worker = workers.begin(); worker != workers.end(); ++worker)
+    append_output(*worker);
+}
+
+void DiffSQLGeneratorBE::append_output(const DiffSQLGeneratorBE &worker) {
+  if (target_list.is_valid()) {
+    for (size_t count = worker.target_list.count(), i = 0; i < count; i++)
+      target_list.insert(worker.target_list.get(i));
+    if (target_object_list.is_valid())
+      for (size_t count = worker.target_object_list.count(), i = 0; i < count; i++)
+        target_object_list.insert(worker.target_object_list.get(i));
+    return;
+  }
+
+  // Same as remember_alter(), several statements for one key are kept in a list.
+  for (grt::DictRef::const_iterator item = worker.target_map.begin(); item != worker.target_map.end(); ++item) {
+    if (!target_map.has_key(item->first)) {
+      target_map.set(item->first, item->second);
+      continue;
+    }
+
+    grt::StringListRef list_value(grt::Initialized);
+    grt::ValueRef values[] = {target_map.get(item->first), item->second};
+    for (size_t i = 0; i < 2; i++) {
+      if (grt::StringListRef::can_wrap(values[i])) {
+        grt::StringListRef list(grt::StringListRef::cast_from(values[i]));
+        for (size_t count = list.count(), j = 0; j < count; j++)
+          list_value.insert(list.get(j));
+      } else
+        list_value.insert(grt::StringRef::cast_from(values[i]));
+    }
+    target_map.set(item->first, list_value);
+  }
 }
 
 static void fill_set_from_list(grt::StringListRef string_list, std::set<std::string> &string_set) {
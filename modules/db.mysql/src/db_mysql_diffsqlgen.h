@@ -52,7 +52,9 @@
 #include "grtpp_module_cpp.h"
 #include "grts/structs.db.mysql.h"
 
+#include <functional>
 #include <set>
+#include <vector>
 
 namespace grt {
   class DiffChange;
@@ -236,6 +238,15 @@ class DiffSQLGeneratorBE {
 
   void do_process_diff_change(grt::ValueRef org_object, grt::DiffChange *);
 
+  /**
+   * Schemas are generated independently of each other. If the call-back can create workers, each task runs
+   * on a copy of this generator with its own output containers, on several threads. The outputs are then
+   * appended in task order, so the result is the same as running the tasks one after the other.
+   */
+  typedef std::function<void(DiffSQLGeneratorBE &)> SchemaTask;
+  void run_schema_tasks(const std::vector<SchemaTask> &tasks);
+  void append_output(const DiffSQLGeneratorBE &worker);
+
 public:
   /**
    * DiffSQLGeneratorBE c-tor
@@ -275,6 +275,9 @@ namespace {
     std::string fk_add_sql;
     std::string fk_drop_sql;
 
+    // Looked up once, so that workers don't need to access the module list concurrently.
+    SqlFacade* _sql_facade;
+
     std::list<std::string> partitions_to_drop;
     std::list<std::string> partitions_to_change;
     std::list<std::string> partitions_to_add;
@@ -294,6 +297,9 @@ namespace {
                       bool use_oids_as_key);
     virtual ~ActionGenerateSQL();
 
+    virtual DiffSQLGeneratorBEActionInterface* create_worker(grt::ValueRef target,
+                                                             grt::ListRef<GrtNamedObject> obj_list);
+
     // create table
     void create_table_props_begin(db_mysql_TableRef);
     void create_table_props_end(db_mysql_TableRef);
@@ -440,8 +446,7 @@ namespace {
 
     _use_oids_as_dict_key = options.get_int("UseOIDAsResultDictKey", use_oids_as_key) != 0;
 
-    SqlFacade::Ref sql_facade = SqlFacade::instance_for_rdbms_name("Mysql");
-    Sql_specifics::Ref sql_specifics = sql_facade->sqlSpecifics();
+    _sql_facade = SqlFacade::instance_for_rdbms_name("Mysql");
     _non_std_sql_delimiter = bec::GRTManager::get()->get_app_option_string("SqlDelimiter", "$$");
 
     if (target.type() == DictType) {
@@ -457,6 +462,20 @@ namespace {
   ActionGenerateSQL::~ActionGenerateSQL() {
   }
 
+  DiffSQLGeneratorBEActionInterface* ActionGenerateSQL::create_worker(grt::ValueRef target,
+                                                                      grt::ListRef<GrtNamedObject> obj_list) {
+    ActionGenerateSQL* worker = new ActionGenerateSQL(*this);
+    if (target.type() == DictType) {
+      worker->target_list = grt::StringListRef();
+      worker->target_map = grt::DictRef::cast_from(target);
+    } else {
+      worker->target_list = grt::StringListRef::cast_from(target);
+      worker->target_map = grt::DictRef();
+    }
+    worker->target_object_list = obj_list;
+    return worker;
+  }
+
   // create table methods
 
   void ActionGenerateSQL::create_table_props_begin(db_mysql_TableRef table) {
@@ -1492,8 +1511,7 @@ namespace {
     }
 
     if (_omitSchemas) {
-      SqlFacade* parser = SqlFacade::instance_for_rdbms_name("Mysql");
-      Sql_schema_rename::Ref renamer = parser->sqlSchemaRenamer();
+      Sql_schema_rename::Ref renamer = _sql_facade->sqlSchemaRenamer();
       renamer->rename_schema_references(view_def, view->owner()->name(), "");
     }
     if (!_omitSchemas || _gen_use) {
@@ -1524,8 +1542,7 @@ namespace {
     routine_sql.append(routine->sqlDefinition().c_str()).append(_non_std_sql_delimiter).append("\n");
 
     if (_omitSchemas) {
-      SqlFacade* parser = SqlFacade::instance_for_rdbms_name("Mysql");
-      Sql_schema_rename::Ref renamer = parser->sqlSchemaRenamer();
+      Sql_schema_rename::Ref renamer = _sql_facade->sqlSchemaRenamer();
       renamer->rename_schema_references(routine_sql, routine->owner()->name(), "");
     }
 
@@ -198,6 +198,15 @@ public:
   virtual void alter_schema_default_collate(db_mysql_SchemaRef, grt::StringRef value) = 0;
   virtual void alter_schema_props_end(db_mysql_SchemaRef) = 0;
   virtual void disable_list_insert(const bool flag) = 0;
+
+  /**
+   * Returns a new call-back with the same settings, storing its output into the given containers. It is used to
+   * generate the SQL of several schemas concurrently. Returns nullptr if the call-back can't be used that way.
+   */
+  virtual DiffSQLGeneratorBEActionInterface* create_worker(grt::ValueRef target,
+                                                           grt::ListRef<GrtNamedObject> obj_list) {
+    return nullptr;
+  }
 };
 
 #define DOC_DbMySQLImpl                                          \
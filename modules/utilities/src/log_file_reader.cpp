@@ -0,0 +1,931 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "log_file_reader.h"
+
+#include "base/log.h"
+#include "base/string_utilities.h"
+
+#include <glib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#define LOG_WINDOW_SIZE (1024 * 1024)
+#define LOG_LINE_PREFIX 256              // Bytes of a line that are enough to tell whether it starts an entry.
+#define LOG_PAGE_ENTRIES 200
+#define LOG_INDEX_STRIDE 1024
+#define LOG_ENTRY_READ_LIMIT (64 * 1024) // Bytes of an entry that are parsed, its details are truncated anyway.
+#define LOG_FIELD_PREVIEW 256
+
+DEFAULT_LOG_DOMAIN("LogFileReader")
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+  class MappedFileSource : public LogFileReader::Source {
+  public:
+    MappedFileSource(const std::string &path) : _path(path), _file(nullptr) {
+      reopen();
+    }
+
+    virtual ~MappedFileSource() {
+      if (_file)
+        g_mapped_file_unref(_file);
+    }
+
+    virtual std::int64_t size() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _file ? (std::int64_t)g_mapped_file_get_length(_file) : 0;
+    }
+
+    virtual void read(std::int64_t offset, size_t length, std::string &data) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      data.clear();
+      std::int64_t size = _file ? (std::int64_t)g_mapped_file_get_length(_file) : 0;
+      if (offset < size)
+        data.assign(g_mapped_file_get_contents(_file) + offset, (size_t)std::min<std::int64_t>(length, size - offset));
+    }
+
+    // A mapping keeps the size the file had, data appended later needs a new one.
+    virtual void reopen() {
+      GError *error = nullptr;
+      GMappedFile *file = g_mapped_file_new(_path.c_str(), FALSE, &error);
+      if (file == nullptr) {
+        std::string message = error->message;
+        g_error_free(error);
+        throw std::runtime_error("Could not open log file " + _path + ": " + message);
+      }
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_file)
+        g_mapped_file_unref(_file);
+      _file = file;
+    }
+
+  private:
+    std::string _path;
+    GMappedFile *_file;
+    std::mutex _mutex;
+  };
+
+  enum LineKind { OtherLine, EntryLine, TimeLine, UserLine };
+  enum TimeKind { NoTime, IsoTime, ShortTime, PlainTime };
+
+  bool starts_with(const char *p, size_t length, const char *prefix) {
+    size_t prefix_length = strlen(prefix);
+    return length >= prefix_length && memcmp(p, prefix, prefix_length) == 0;
+  }
+
+  // The skip_ helpers return the position after what they skipped or npos if it wasn't there, which the next one
+  // passes on. That way a pattern is matched with a chain of calls and a single check at the end.
+  const size_t npos = std::string::npos;
+
+  size_t skip_digits(const char *p, size_t length, size_t pos, size_t min, size_t max) {
+    if (pos == npos)
+      return npos;
+    size_t start = pos;
+    while (pos < length && pos - start < max && g_ascii_isdigit(p[pos]))
+      ++pos;
+    return pos - start >= min ? pos : npos;
+  }
+
+  size_t skip_char(const char *p, size_t length, size_t pos, char c) {
+    return pos != npos && pos < length && p[pos] == c ? pos + 1 : npos;
+  }
+
+  size_t skip_blanks(const char *p, size_t length, size_t pos) {
+    if (pos == npos)
+      return npos;
+    while (pos < length && (p[pos] == ' ' || p[pos] == '\t'))
+      ++pos;
+    return pos;
+  }
+
+  /**
+   * Returns the length of the timestamp at the start of p, 0 if there is none. The server wrote these over time:
+   *   2018-03-01T14:00:00.123456Z (5.7+, also with a time zone offset instead of the Z)
+   *   2018-03-01 14:00:00         (5.6 error log)
+   *   180301 14:00:00             (general and slow logs before 5.7, older error logs)
+   */
+  size_t parse_timestamp(const char *p, size_t length, TimeKind &kind) {
+    kind = NoTime;
+    size_t pos = skip_digits(p, length, 0, 6, 6);
+    if (pos != npos && pos < length && p[pos] == ' ') {
+      pos = skip_blanks(p, length, pos);
+      pos = skip_digits(p, length, pos, 1, 2);
+      pos = skip_digits(p, length, skip_char(p, length, pos, ':'), 2, 2);
+      pos = skip_digits(p, length, skip_char(p, length, pos, ':'), 2, 2);
+      if (pos == npos)
+        return 0;
+      kind = ShortTime;
+      return pos;
+    }
+
+    pos = skip_digits(p, length, 0, 2, 4);
+    pos = skip_digits(p, length, skip_char(p, length, pos, '-'), 1, 2);
+    pos = skip_digits(p, length, skip_char(p, length, pos, '-'), 2, 2);
+    if (pos == npos || pos >= length)
+      return 0;
+    bool iso = p[pos] == 'T';
+    if (iso)
+      ++pos;
+    else
+      pos = skip_blanks(p, length, pos);
+    pos = skip_digits(p, length, pos, 1, 2);
+    pos = skip_digits(p, length, skip_char(p, length, pos, ':'), 2, 2);
+    pos = skip_digits(p, length, skip_char(p, length, pos, ':'), 2, 2);
+    if (pos == npos)
+      return 0;
+    if (!iso) {
+      kind = PlainTime;
+      return pos;
+    }
+
+    if (pos < length && p[pos] == '.')
+      pos = skip_digits(p, length, pos + 1, 1, 9);
+    if (pos != npos && pos < length && p[pos] == 'Z')
+      ++pos;
+    else if (pos != npos && pos < length && (p[pos] == '+' || p[pos] == '-')) {
+      pos = skip_digits(p, length, pos + 1, 2, 2);
+      pos = skip_digits(p, length, skip_char(p, length, pos, ':'), 2, 2);
+    } else
+      return 0;
+    if (pos == npos)
+      return 0;
+    kind = IsoTime;
+    return pos;
+  }
+
+  /**
+   * Formats a timestamp found by parse_timestamp() as YYYY-MM-DD HH:MM:SS, the only one which sorts as text.
+   * Times in UTC or with a time zone are converted to local time and keep their fraction, like ts_iso_to_local()
+   * in wb_log_reader.py does.
+   */
+  std::string format_timestamp(const char *p, size_t length, TimeKind kind) {
+    int values[6] = {0};
+    size_t pos = 0;
+    for (int i = 0; i < 6 && pos < length; ++i) {
+      while (pos < length && !g_ascii_isdigit(p[pos]))
+        ++pos;
+      size_t count = (kind == ShortTime && i < 3) ? 2 : 4;
+      for (size_t start = pos; pos < length && pos - start < count && g_ascii_isdigit(p[pos]); ++pos)
+        values[i] = values[i] * 10 + (p[pos] - '0');
+    }
+    if (values[0] < 100)
+      values[0] += 2000;
+
+    if (kind != IsoTime)
+      return base::strfmt("%04i-%02i-%02i %02i:%02i:%02i", values[0], values[1], values[2], values[3], values[4],
+                          values[5]);
+
+    std::string fraction;
+    std::string zone = "UTC";
+    if (pos < length && p[pos] == '.') {
+      size_t end = skip_digits(p, length, pos + 1, 1, 9);
+      fraction.assign(p + pos, end - pos);
+      pos = end;
+    }
+    if (pos < length && p[pos] != 'Z')
+      zone.assign(p + pos, length - pos);
+
+    GTimeZone *time_zone = g_time_zone_new(zone.c_str());
+    GDateTime *time = g_date_time_new(time_zone, values[0], values[1], values[2], values[3], values[4], values[5]);
+    g_time_zone_unref(time_zone);
+    if (time == nullptr) {
+      logWarning("Error parsing timestamp %s\n", std::string(p, length).c_str());
+      return std::string(p, length);
+    }
+    GDateTime *local_time = g_date_time_to_local(time);
+    gchar *text = g_date_time_format(local_time, "%Y-%m-%d %H:%M:%S");
+    std::string result = text;
+    g_free(text);
+    g_date_time_unref(local_time);
+    g_date_time_unref(time);
+    return result + fraction;
+  }
+
+  // Same lines as the regular expression of GeneralLogFileReader matches: a time or blanks, the thread id, the
+  // command and the argument, which is separated by tabs or at least 2 spaces.
+  bool is_general_entry(const char *p, size_t length) {
+    TimeKind kind;
+    size_t pos = parse_timestamp(p, length, kind);
+    if (kind == PlainTime)
+      return false;
+    size_t id = skip_blanks(p, length, pos);
+    if (id == 0)
+      return false;
+    size_t command = skip_digits(p, length, id, 1, 20);
+    if (command == npos)
+      return false;
+    for (size_t i = command; i < length; ++i)
+      if (p[i] == '\t' || (p[i] == ' ' && i + 1 < length && p[i + 1] == ' '))
+        return true;
+    return false;
+  }
+
+  LineKind classify_line(LogFileReader::Format format, const char *p, size_t length) {
+    switch (format) {
+      case LogFileReader::ErrorLog:
+        return length > 0 ? EntryLine : OtherLine;
+      case LogFileReader::GeneralLog:
+        return is_general_entry(p, length) ? EntryLine : OtherLine;
+      case LogFileReader::SlowLog:
+        if (starts_with(p, length, "# Time: "))
+          return TimeLine;
+        if (starts_with(p, length, "# User@Host: "))
+          return UserLine;
+        return OtherLine;
+    }
+    return OtherLine;
+  }
+
+  // The timestamp a line starting an entry is logged with.
+  size_t entry_timestamp(LogFileReader::Format format, const char *&p, size_t length, TimeKind &kind) {
+    if (format == LogFileReader::SlowLog) {
+      if (!starts_with(p, length, "# Time: ")) {
+        kind = NoTime;
+        return 0;
+      }
+      p += 8;
+      length -= 8;
+    }
+    return parse_timestamp(p, length, kind);
+  }
+
+  // Like _shorten_query_field() in wb_log_reader.py, total is the length of the whole value.
+  std::string shorten_field(const std::string &value, std::int64_t total) {
+    if (total <= LOG_FIELD_PREVIEW)
+      return value;
+
+    size_t cut = std::min<size_t>(LOG_FIELD_PREVIEW, value.size());
+    while (cut > 0 && (value[cut] & 0xC0) == 0x80)
+      --cut;
+    std::string size = total < 1024 ? base::strfmt("%i bytes", (int)total) : base::strfmt("%.1f KB", total / 1024.0);
+    return value.substr(0, cut) + " [truncated, " + size + " total]";
+  }
+
+  // Log files have whatever the statements were written in, anything that isn't UTF-8 is taken as Latin-1.
+  std::string to_utf8(const std::string &value) {
+    if (g_utf8_validate(value.data(), (gssize)value.size(), nullptr))
+      return value;
+    std::string result;
+    result.reserve(value.size() * 2);
+    for (unsigned char c : value) {
+      if (c < 0x80)
+        result.push_back((char)c);
+      else {
+        result.push_back((char)(0xC0 | (c >> 6)));
+        result.push_back((char)(0x80 | (c & 0x3F)));
+      }
+    }
+    return result;
+  }
+
+  std::vector<std::string> split_lines(const std::string &text) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start < text.size()) {
+      size_t end = text.find('\n', start);
+      if (end == std::string::npos)
+        end = text.size();
+      size_t length = end - start;
+      if (length > 0 && text[end - 1] == '\r')
+        --length;
+      lines.push_back(text.substr(start, length));
+      start = end + 1;
+    }
+    return lines;
+  }
+
+  std::string rest_of(const std::string &line, size_t pos) {
+    return pos < line.size() ? line.substr(pos) : std::string();
+  }
+
+  // Value of a "Name: value" pair in the # Query_time: line of slow log entries.
+  std::string slow_log_value(const std::string &line, const char *name) {
+    size_t pos = line.find(name);
+    if (pos == std::string::npos)
+      return "";
+    pos = skip_blanks(line.data(), line.size(), pos + strlen(name));
+    size_t end = line.find_first_of(" \t", pos);
+    return line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * A buffered part of the source. Forward windows start at the requested offset, backward ones end there, so a scan
+ * in either direction reads every byte about once.
+ */
+class LogFileReader::Window {
+public:
+  Window(LogFileReader::Source *source, std::int64_t size, bool backward = false)
+    : _source(source), _size(size), _backward(backward), _base(0) {
+  }
+
+  // Returns the data at offset, at least length bytes of it unless the file ends before. available is set to the
+  // number of bytes following the returned pointer.
+  const char *get(std::int64_t offset, size_t length, size_t &available) {
+    available = 0;
+    if (offset >= _size)
+      return "";
+    length = (size_t)std::min<std::int64_t>(std::min<size_t>(length, LOG_WINDOW_SIZE), _size - offset);
+    if (offset < _base || offset + (std::int64_t)length > _base + (std::int64_t)_data.size()) {
+      if (_backward)
+        _base = std::max<std::int64_t>(0, offset + (std::int64_t)length - LOG_WINDOW_SIZE);
+      else
+        _base = offset;
+      _source->read(_base, (size_t)std::min<std::int64_t>(LOG_WINDOW_SIZE, _size - _base), _data);
+      if (offset >= _base + (std::int64_t)_data.size())
+        return ""; // The file got shorter than we knew.
+    }
+    available = (size_t)(_base + (std::int64_t)_data.size() - offset);
+    return _data.data() + (offset - _base);
+  }
+
+  // The first bytes of the line at offset, without the line break.
+  const char *line(std::int64_t offset, size_t &length) {
+    size_t available;
+    const char *p = get(offset, LOG_LINE_PREFIX, available);
+    length = std::min<size_t>(available, LOG_LINE_PREFIX);
+    const char *end = (const char *)memchr(p, '\n', length);
+    if (end != nullptr)
+      length = end - p;
+    if (length > 0 && p[length - 1] == '\r')
+      --length;
+    return p;
+  }
+
+  void resize(std::int64_t size) {
+    if (size != _size) {
+      _size = size;
+      _data.clear();
+      _base = 0;
+    }
+  }
+
+  std::int64_t size() const {
+    return _size;
+  }
+
+private:
+  LogFileReader::Source *_source;
+  std::int64_t _size;
+  bool _backward;
+  std::int64_t _base;
+  std::string _data;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+LogFileReader::Source *LogFileReader::open_local(const std::string &path) {
+  return new MappedFileSource(path);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+LogFileReader::Format LogFileReader::format_from_name(const std::string &name) {
+  if (name == "error")
+    return ErrorLog;
+  if (name == "general")
+    return GeneralLog;
+  if (name == "slow")
+    return SlowLog;
+  throw std::invalid_argument("Unknown log format " + name);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+LogFileReader::LogFileReader(Source *source, Format format, size_t page_entries)
+  : _source(source),
+    _format(format),
+    _page_entries(page_entries > 0 ? page_entries : LOG_PAGE_ENTRIES),
+    _size(source->size()),
+    _positioned(false),
+    _page_start(0),
+    _page_end(0),
+    _page_count(0),
+    _page_number(-2),
+    _indexed_bytes(0),
+    _indexed_entries(0),
+    _index_after_time_line(false),
+    _indexing(false),
+    _stop_indexing(false) {
+  start_indexing();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+LogFileReader::~LogFileReader() {
+  stop_indexing();
+  delete _source;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<LogFileReader::Entry> LogFileReader::first() {
+  return page_from(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<LogFileReader::Entry> LogFileReader::last() {
+  return page_before(_size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<LogFileReader::Entry> LogFileReader::next() {
+  if (!has_next())
+    return std::vector<Entry>();
+  return page_from(_page_end);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<LogFileReader::Entry> LogFileReader::previous() {
+  if (!has_previous())
+    return std::vector<Entry>();
+  return page_before(_page_start);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<LogFileReader::Entry> LogFileReader::current() {
+  if (!_positioned)
+    return last();
+
+  Window window(_source, _size);
+  std::vector<Entry> entries;
+  std::int64_t offset = next_entry(window, _page_start, _page_end);
+  while (offset < _page_end) {
+    std::int64_t end = next_entry(window, line_end(window, offset) + 1, _page_end);
+    std::string text;
+    _source->read(offset, (size_t)std::min<std::int64_t>(end - offset, LOG_ENTRY_READ_LIMIT), text);
+    entries.push_back(parse_entry(text, end - offset));
+    offset = end;
+  }
+  _page_count = entries.size();
+  return entries;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * The entry sought is the first one with a time at or after the given one, entries logged without a time have the
+ * time of the one before. Times only grow through the file, so P(offset) = "the first entry with a time after offset
+ * has a time at or after the one sought" is false up to some point and true after it. The index and a bisection find
+ * a small range where P changes, the entry is then at most a few entries after its start.
+ */
+std::vector<LogFileReader::Entry> LogFileReader::seek_time(const std::string &time) {
+  Window window(_source, _size);
+  std::int64_t low = 0;
+  std::int64_t high = _size;
+  {
+    std::lock_guard<std::mutex> lock(_index_mutex);
+    auto sample = std::lower_bound(_samples.begin(), _samples.end(), time,
+                                   [](const Sample &sample, const std::string &time) { return sample.time < time; });
+    if (sample != _samples.begin())
+      low = (sample - 1)->offset;
+    if (sample != _samples.end())
+      high = sample->offset;
+  }
+
+  std::string entry_time_text;
+  while (high - low > LOG_WINDOW_SIZE) {
+    std::int64_t middle = line_end(window, low + (high - low) / 2) + 1;
+    std::int64_t offset = next_entry(window, middle, _size);
+    while (offset < _size && !entry_time(window, offset, entry_time_text))
+      offset = next_entry(window, line_end(window, offset) + 1, _size);
+    if (offset >= _size || entry_time_text >= time)
+      high = middle;
+    else
+      low = middle;
+  }
+
+  std::string last_time;
+  std::int64_t offset = next_entry(window, low, _size);
+  while (offset < _size) {
+    if (entry_time(window, offset, entry_time_text))
+      last_time = entry_time_text;
+    if (!last_time.empty() && last_time >= time)
+      return page_from(offset);
+    offset = next_entry(window, line_end(window, offset) + 1, _size);
+  }
+  return last();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool LogFileReader::has_previous() {
+  return _positioned && _page_start > 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool LogFileReader::has_next() {
+  return _positioned && _page_end < _size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::int64_t LogFileReader::page_entry_number() {
+  if (_page_number != -2)
+    return _page_number;
+
+  Window window(_source, _size);
+  std::int64_t first = next_entry(window, _page_start, _page_end);
+  Sample sample;
+  size_t index;
+  {
+    std::lock_guard<std::mutex> lock(_index_mutex);
+    if (_samples.empty() || first >= _indexed_bytes)
+      return -1; // Not cached, the index will get there.
+    auto next = std::upper_bound(_samples.begin(), _samples.end(), first,
+                                 [](std::int64_t offset, const Sample &sample) { return offset < sample.offset; });
+    if (next == _samples.begin())
+      return _page_number = 0; // Nothing but text before the first entry.
+    index = (next - _samples.begin()) - 1;
+    sample = _samples[index];
+  }
+
+  std::int64_t number = (std::int64_t)index * LOG_INDEX_STRIDE;
+  for (std::int64_t offset = sample.offset; offset < first; ++number)
+    offset = next_entry(window, line_end(window, offset) + 1, first);
+  _page_number = number;
+  return number;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool LogFileReader::indexing_done() {
+  std::lock_guard<std::mutex> lock(_index_mutex);
+  return !_indexing;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void LogFileReader::refresh() {
+  _source->reopen();
+  std::int64_t size = _source->size();
+  if (size == _size)
+    return;
+
+  _positioned = false;
+  if (size < _size) {
+    stop_indexing();
+    _samples.clear();
+    _indexed_bytes = 0;
+    _indexed_entries = 0;
+    _index_time.clear();
+    _index_after_time_line = false;
+    _size = size;
+    start_indexing();
+    return;
+  }
+
+  bool restart;
+  {
+    std::lock_guard<std::mutex> lock(_index_mutex);
+    _size = size;
+    restart = !_indexing;
+  }
+  if (restart)
+    start_indexing();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void LogFileReader::start_indexing() {
+  if (_index_thread.joinable())
+    _index_thread.join();
+  _stop_indexing = false;
+  _indexing = true;
+  _index_thread = std::thread(&LogFileReader::index, this);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void LogFileReader::stop_indexing() {
+  _stop_indexing = true;
+  if (_index_thread.joinable())
+    _index_thread.join();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Runs in the index thread. Goes through the lines from where the last run stopped and records every
+ * LOG_INDEX_STRIDE-th entry start. An incomplete last line is left for the next run, as it is still being written.
+ */
+void LogFileReader::index() {
+  std::int64_t offset = _indexed_bytes;
+  std::int64_t entries = _indexed_entries;
+  bool after_time_line = _index_after_time_line;
+  std::string time = _index_time; // Formatted lazily, only sampled entries need it.
+  std::string raw_time;
+  TimeKind raw_time_kind = NoTime;
+
+  Window window(_source, _size);
+  try {
+    while (!_stop_indexing) {
+      window.resize(_size);
+      std::int64_t end = offset < window.size() ? line_end(window, offset) : window.size();
+      if (end >= window.size()) {
+        std::lock_guard<std::mutex> lock(_index_mutex);
+        if (_size == window.size()) {
+          _indexing = false;
+          break;
+        }
+        continue;
+      }
+
+      size_t length;
+      const char *p = window.line(offset, length);
+      LineKind kind = classify_line(_format, p, length);
+      if (kind == EntryLine || kind == TimeLine || (kind == UserLine && !after_time_line)) {
+        TimeKind time_kind;
+        size_t time_length = entry_timestamp(_format, p, length, time_kind);
+        if (time_length > 0) {
+          raw_time.assign(p, time_length);
+          raw_time_kind = time_kind;
+        }
+        if (entries % LOG_INDEX_STRIDE == 0) {
+          if (raw_time_kind != NoTime) {
+            time = format_timestamp(raw_time.data(), raw_time.size(), raw_time_kind);
+            raw_time_kind = NoTime;
+          }
+          std::lock_guard<std::mutex> lock(_index_mutex);
+          _samples.push_back({offset, time});
+        }
+        ++entries;
+      }
+      after_time_line = kind == TimeLine;
+
+      offset = end + 1;
+      _indexed_bytes = offset;
+      _indexed_entries = entries;
+    }
+  } catch (std::exception &e) {
+    logError("Indexing log file failed: %s\n", e.what());
+    std::lock_guard<std::mutex> lock(_index_mutex);
+    _indexing = false;
+  }
+
+  if (raw_time_kind != NoTime)
+    time = format_timestamp(raw_time.data(), raw_time.size(), raw_time_kind);
+  _index_time = time;
+  _index_after_time_line = after_time_line;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Offset of the line break ending the line at offset, or the size of the file.
+std::int64_t LogFileReader::line_end(Window &window, std::int64_t offset) {
+  while (offset < window.size()) {
+    size_t available;
+    const char *p = window.get(offset, 1, available);
+    if (available == 0)
+      break;
+    const char *end = (const char *)memchr(p, '\n', available);
+    if (end != nullptr)
+      return offset + (end - p);
+    offset += available;
+  }
+  return window.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Start of the line before the one at offset, which must be the start of a line after the first one.
+std::int64_t LogFileReader::previous_line(Window &window, std::int64_t offset) {
+  std::int64_t end = offset - 1; // The line break of the previous line.
+  while (end > 0) {
+    std::int64_t start = std::max<std::int64_t>(0, end - LOG_LINE_PREFIX);
+    size_t available;
+    const char *p = window.get(start, (size_t)(end - start), available);
+    if (available < (size_t)(end - start))
+      break;
+    for (std::int64_t i = end - start; i > 0; --i)
+      if (p[i - 1] == '\n')
+        return start + i;
+    end = start;
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool LogFileReader::is_entry_start(Window &window, std::int64_t offset) {
+  size_t length;
+  const char *p = window.line(offset, length);
+  LineKind kind = classify_line(_format, p, length);
+  if (kind != UserLine)
+    return kind != OtherLine;
+  if (offset == 0)
+    return true;
+
+  // A 5.6 server logs no time for statements in the same second as the one before.
+  p = window.line(previous_line(window, offset), length);
+  return classify_line(_format, p, length) != TimeLine;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// First entry starting at or after offset, which must be the start of a line, and before limit. Returns limit if
+// there is none.
+std::int64_t LogFileReader::next_entry(Window &window, std::int64_t offset, std::int64_t limit) {
+  while (offset < limit) {
+    if (is_entry_start(window, offset))
+      return offset;
+    offset = line_end(window, offset) + 1;
+  }
+  return limit;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Last entry starting before offset, -1 if there is none.
+std::int64_t LogFileReader::previous_entry(Window &window, std::int64_t offset) {
+  while (offset > 0) {
+    offset = previous_line(window, offset);
+    if (is_entry_start(window, offset))
+      return offset;
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The time of the entry at offset, false if it was logged without one.
+bool LogFileReader::entry_time(Window &window, std::int64_t offset, std::string &time) {
+  size_t length;
+  const char *p = window.line(offset, length);
+  TimeKind kind;
+  size_t time_length = entry_timestamp(_format, p, length, kind);
+  if (time_length == 0)
+    return false;
+  time = format_timestamp(p, time_length, kind);
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<LogFileReader::Entry> LogFileReader::page_from(std::int64_t start) {
+  _positioned = true;
+  _page_start = start;
+  _page_number = -2;
+
+  Window window(_source, _size);
+  std::int64_t offset = next_entry(window, start, _size);
+  size_t count = 0;
+  while (offset < _size && count < _page_entries) {
+    offset = next_entry(window, line_end(window, offset) + 1, _size);
+    ++count;
+  }
+  _page_end = offset;
+  return current();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<LogFileReader::Entry> LogFileReader::page_before(std::int64_t end) {
+  _positioned = true;
+  _page_end = end;
+  _page_number = -2;
+
+  Window window(_source, _size, true);
+  std::int64_t start = end;
+  for (size_t count = 0; count < _page_entries && start > 0; ++count) {
+    start = previous_entry(window, start);
+    if (start < 0)
+      break;
+  }
+  // Text before the first entry belongs to the first page, there is nothing before it to show.
+  if (start <= 0 || previous_entry(window, start) < 0)
+    start = 0;
+  _page_start = start;
+  return current();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Splits an entry into the fields wb_log_reader.py shows for it. text is at most LOG_ENTRY_READ_LIMIT bytes of the
+ * entry, whose whole length is given. The last field holds the details and gets shortened.
+ */
+LogFileReader::Entry LogFileReader::parse_entry(const std::string &text, std::int64_t length) {
+  std::vector<std::string> lines = split_lines(text);
+  if (lines.empty())
+    lines.push_back("");
+  const std::string &line = lines[0];
+  Entry entry;
+  TimeKind kind;
+  size_t pos;
+
+  switch (_format) {
+    case ErrorLog: {
+      // [time, thread, type, details], lines of an unknown format only have details.
+      pos = parse_timestamp(line.data(), line.size(), kind);
+      if (pos > 0) {
+        std::string time = format_timestamp(line.data(), pos, kind);
+        pos = skip_blanks(line.data(), line.size(), pos);
+        if (kind == ShortTime) {
+          size_t end = std::min(line.find(' ', pos), line.size());
+          entry = {time, "", line.substr(pos, end - pos), rest_of(line, end + 1)};
+        } else {
+          size_t thread_end = skip_digits(line.data(), line.size(), pos, 1, 20);
+          size_t type_end = thread_end != npos ? line.find(']', thread_end) : npos;
+          if (thread_end != npos && thread_end + 1 < line.size() && line[thread_end] == ' ' &&
+              line[thread_end + 1] == '[' && type_end != std::string::npos)
+            entry = {time, line.substr(pos, thread_end - pos), line.substr(thread_end + 2, type_end - thread_end - 2),
+                     rest_of(line, skip_blanks(line.data(), line.size(), type_end + 1))};
+        }
+      }
+      if (entry.empty())
+        entry = {"", "", "", line};
+      break;
+    }
+
+    case GeneralLog: {
+      // [time, thread, command, argument], lines that follow belong to the argument.
+      pos = parse_timestamp(line.data(), line.size(), kind);
+      std::string time = pos > 0 ? format_timestamp(line.data(), pos, kind) : "";
+      pos = skip_blanks(line.data(), line.size(), pos);
+      size_t thread_end = skip_digits(line.data(), line.size(), pos, 1, 20);
+      if (thread_end == npos)
+        thread_end = pos;
+      size_t command = skip_blanks(line.data(), line.size(), thread_end);
+      size_t command_end = command;
+      while (command_end < line.size() && line[command_end] != '\t' &&
+             !(line[command_end] == ' ' && command_end + 1 < line.size() && line[command_end + 1] == ' '))
+        ++command_end;
+      std::string argument = rest_of(line, skip_blanks(line.data(), line.size(), command_end));
+      for (size_t i = 1; i < lines.size(); ++i)
+        argument.append("\n").append(lines[i]);
+      entry = {time, line.substr(pos, thread_end - pos), line.substr(command, command_end - command), argument};
+      break;
+    }
+
+    case SlowLog: {
+      // [start time, user@host, query time, lock time, rows sent, rows examined, details]
+      std::string time, user, query_line, details;
+      size_t i = 0;
+      if (starts_with(line.data(), line.size(), "# Time: ")) {
+        pos = parse_timestamp(line.data() + 8, line.size() - 8, kind);
+        time = pos > 0 ? format_timestamp(line.data() + 8, pos, kind) : base::trim(line.substr(8));
+        ++i;
+      }
+      if (i < lines.size() && starts_with(lines[i].data(), lines[i].size(), "# User@Host: "))
+        user = lines[i++].substr(13);
+      if (i < lines.size() && starts_with(lines[i].data(), lines[i].size(), "# Query_time: "))
+        query_line = lines[i++];
+      // A server restart writes its header lines into the log, they end the statement.
+      for (; i < lines.size() && lines[i].find(", Version: ") == std::string::npos; ++i) {
+        if (!details.empty())
+          details.push_back('\n');
+        details.append(lines[i]);
+      }
+      entry = {time,
+               base::trim(user),
+               slow_log_value(query_line, "Query_time:"),
+               slow_log_value(query_line, "Lock_time:"),
+               slow_log_value(query_line, "Rows_sent:"),
+               slow_log_value(query_line, "Rows_examined:"),
+               details};
+      break;
+    }
+  }
+
+  for (auto &field : entry)
+    field = to_utf8(field);
+  std::string &details = entry.back();
+  details = shorten_field(details, (std::int64_t)details.size() + length - (std::int64_t)text.size());
+  return entry;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Pages through MySQL error, general query and slow query log files of any size.
+ *
+ * Only the entries of the current page are read and parsed. A page is found by scanning for entry boundaries from
+ * the page next to it, so the most recent entries of a huge file show up right away. A background thread builds a
+ * sparse index with the offset and time of every LOG_INDEX_STRIDE-th entry, from which entry numbers are known.
+ * Seeking to a time uses the index where it reaches and bisects the rest of the file.
+ *
+ * Entries are returned with the same fields as the Python log readers in wb_log_reader.py show them.
+ */
+class LogFileReader {
+public:
+  enum Format { ErrorLog, GeneralLog, SlowLog };
+
+  // Where the log data comes from. read() is called from the indexing thread and the caller at the same time.
+  class Source {
+  public:
+    virtual ~Source() {
+    }
+
+    virtual std::int64_t size() = 0;
+    // Reads up to length bytes at offset into data, which gets less than that only at the end of the file.
+    virtual void read(std::int64_t offset, size_t length, std::string &data) = 0;
+    // Picks up changes of the file, called by refresh() before size().
+    virtual void reopen() {
+    }
+  };
+
+  typedef std::vector<std::string> Entry;
+
+  // Maps a local file into memory. Throws std::runtime_error if that fails.
+  static Source *open_local(const std::string &path);
+  // Format names are "error", "general" and "slow".
+  static Format format_from_name(const std::string &name);
+
+  // The reader takes ownership of the source and starts indexing it.
+  LogFileReader(Source *source, Format format, size_t page_entries = 0);
+  ~LogFileReader();
+
+  // Move the page and return its entries, current() parses the current page again.
+  // Before any of them is called the current page is the last one.
+  std::vector<Entry> first();
+  std::vector<Entry> last();
+  std::vector<Entry> next();
+  std::vector<Entry> previous();
+  std::vector<Entry> current();
+  // Moves the page to the first entry logged at or after the given time. The time is compared to the one shown
+  // for entries, so "2018-03-01 14:00" or "2018-03-01 14:00:00" both work.
+  std::vector<Entry> seek_time(const std::string &time);
+
+  bool has_previous();
+  bool has_next();
+
+  std::int64_t size() const {
+    return _size;
+  }
+  std::int64_t page_start() const {
+    return _page_start;
+  }
+  std::int64_t page_end() const {
+    return _page_end;
+  }
+  size_t page_entry_count() const {
+    return _page_count;
+  }
+  // Number of the first entry of the page (0 based), -1 while the index doesn't reach the page.
+  std::int64_t page_entry_number();
+
+  std::int64_t indexed_bytes() const {
+    return _indexed_bytes;
+  }
+  std::int64_t indexed_entries() const {
+    return _indexed_entries;
+  }
+  bool indexing_done();
+
+  // Checks whether the file changed since it was opened or last refreshed. If it grew, the new entries get indexed
+  // and the next current() shows the last page. A file that got smaller was rotated and is indexed anew.
+  void refresh();
+
+private:
+  class Window;
+  struct Sample {
+    std::int64_t offset;
+    std::string time;
+  };
+
+  Source *_source;
+  Format _format;
+  size_t _page_entries;
+  std::atomic<std::int64_t> _size;
+
+  bool _positioned; // false until a page was chosen, current() then goes to the last one
+  std::int64_t _page_start;
+  std::int64_t _page_end;
+  size_t _page_count;
+  std::int64_t _page_number; // cached page_entry_number(), -2 if not known yet
+
+  std::mutex _index_mutex;
+  std::vector<Sample> _samples; // every LOG_INDEX_STRIDE-th entry, starting with the first one
+  std::atomic<std::int64_t> _indexed_bytes;
+  std::atomic<std::int64_t> _indexed_entries;
+  std::string _index_time;   // time of the last indexed entry with one, slow and general logs omit repeated times
+  bool _index_after_time_line;
+  bool _indexing;
+  std::atomic<bool> _stop_indexing;
+  std::thread _index_thread;
+
+  void start_indexing();
+  void stop_indexing();
+  void index();
+
+  std::int64_t line_end(Window &window, std::int64_t offset);
+  std::int64_t previous_line(Window &window, std::int64_t offset);
+  bool is_entry_start(Window &window, std::int64_t offset);
+  std::int64_t next_entry(Window &window, std::int64_t offset, std::int64_t limit);
+  std::int64_t previous_entry(Window &window, std::int64_t offset);
+  bool entry_time(Window &window, std::int64_t offset, std::string &time);
+
+  std::vector<Entry> page_from(std::int64_t start);
+  std::vector<Entry> page_before(std::int64_t end);
+  Entry parse_entry(const std::string &text, std::int64_t length);
+};
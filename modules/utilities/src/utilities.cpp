@@ -27,10 +27,62 @@
 #include "grt/spatial_handler.h"
 #include "base/log.h"
 
+#include "log_file_reader.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
 #define Utilities_VERSION "1.0.0"
 
 DEFAULT_LOG_DOMAIN("utilities");
 
+// Reads a log file over the SFTP channel of an admin SSH connection.
+class SSHLogSource : public LogFileReader::Source {
+public:
+  SSHLogSource(db_mgmt_SSHConnectionRef connection, const std::string &path) : _connection(connection), _path(path) {
+    if (!*_connection->isConnected())
+      _connection->connect();
+    _file = _connection->open(path);
+    if (!_file.is_valid())
+      throw std::runtime_error("Could not open remote log file " + path);
+    reopen();
+  }
+
+  virtual std::int64_t size() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+  }
+
+  virtual void read(std::int64_t offset, size_t length, std::string &data) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    data.clear();
+    _file->seek((size_t)offset);
+    while (data.size() < length) {
+      std::string chunk = *_file->read(length - data.size());
+      if (chunk.empty())
+        break;
+      data.append(chunk);
+    }
+  }
+
+  virtual void reopen() {
+    grt::DictRef info = _connection->stat(_path);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _size = info.is_valid() ? info.get_int("size") : 0;
+  }
+
+private:
+  db_mgmt_SSHConnectionRef _connection;
+  db_mgmt_SSHFileRef _file;
+  std::string _path;
+  std::int64_t _size;
+  std::mutex _mutex;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
 class UtilitiesImpl : public grt::ModuleImplBase {
 public:
   UtilitiesImpl(grt::CPPModuleLoader *loader) : grt::ModuleImplBase(loader) {
@@ -44,6 +96,36 @@ public:
                      DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::fetchAuthorityCodeFromFile,
                                                  "Load WKT SRS from file and extract EPSG code from it.",
                                                  "path the path to file that contains SRS WKT."),
+                     DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::openLogFile,
+                                                 "Opens a local server log file for paging through it. Returns a "
+                                                 "handle for the other log file functions.",
+                                                 "path the path of the log file\n"
+                                                 "format one of error, general or slow"),
+                     DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::openRemoteLogFile,
+                                                 "Opens a server log file through an SSH connection, see openLogFile.",
+                                                 "connection the SSH connection to the server host\n"
+                                                 "path the path of the log file on the server host\n"
+                                                 "format one of error, general or slow"),
+                     DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::closeLogFile,
+                                                 "Closes a log file opened with openLogFile or openRemoteLogFile.",
+                                                 "handle the log file handle"),
+                     DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::readLogPage,
+                                                 "Moves to another page of a log file and returns its entries, each "
+                                                 "one a list of strings.",
+                                                 "handle the log file handle\n"
+                                                 "page one of first, last, next, previous or current"),
+                     DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::seekLogTime,
+                                                 "Moves to the page starting with the first entry logged at or after "
+                                                 "the given time and returns its entries.",
+                                                 "handle the log file handle\n"
+                                                 "time a time as YYYY-MM-DD HH:MM:SS or a prefix of it"),
+                     DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::logFileInfo,
+                                                 "Returns the size of a log file, the position of the current page "
+                                                 "and how far indexing went.",
+                                                 "handle the log file handle"),
+                     DECLARE_MODULE_FUNCTION_DOC(UtilitiesImpl::refreshLogFile,
+                                                 "Picks up entries written to a log file since it was opened.",
+                                                 "handle the log file handle"),
                      NULL);
 
   db_mgmt_RdbmsRef loadRdbmsInfo(db_mgmt_ManagementRef owner, const std::string &path) {
@@ -69,6 +151,95 @@ public:
       logError("Unable to get contents of a file: %s\n", path.c_str());
     return epsg;
   }
+
+  int openLogFile(const std::string &path, const std::string &format) {
+    return add_log_reader(new LogFileReader(LogFileReader::open_local(path), LogFileReader::format_from_name(format)));
+  }
+
+  int openRemoteLogFile(db_mgmt_SSHConnectionRef connection, const std::string &path, const std::string &format) {
+    LogFileReader::Format log_format = LogFileReader::format_from_name(format);
+    return add_log_reader(new LogFileReader(new SSHLogSource(connection, path), log_format));
+  }
+
+  int closeLogFile(int handle) {
+    std::lock_guard<std::mutex> lock(_log_readers_mutex);
+    auto reader = _log_readers.find(handle);
+    if (reader == _log_readers.end())
+      return 0;
+    // A call still using the reader keeps it alive until it returns
+    _log_readers.erase(reader);
+    return 1;
+  }
+
+  grt::BaseListRef readLogPage(int handle, const std::string &page) {
+    std::shared_ptr<LogFileReader> reader = log_reader(handle);
+    if (page == "first")
+      return entry_list(reader->first());
+    if (page == "last")
+      return entry_list(reader->last());
+    if (page == "next")
+      return entry_list(reader->next());
+    if (page == "previous")
+      return entry_list(reader->previous());
+    if (page == "current")
+      return entry_list(reader->current());
+    throw std::invalid_argument("Unknown log page " + page);
+  }
+
+  grt::BaseListRef seekLogTime(int handle, const std::string &time) {
+    return entry_list(log_reader(handle)->seek_time(time));
+  }
+
+  grt::DictRef logFileInfo(int handle) {
+    std::shared_ptr<LogFileReader> reader = log_reader(handle);
+    grt::DictRef info(true);
+    info.gset("size", (long)reader->size());
+    info.gset("pageStart", (long)reader->page_start());
+    info.gset("pageEnd", (long)reader->page_end());
+    info.gset("pageEntries", (long)reader->page_entry_count());
+    info.gset("firstEntry", (long)reader->page_entry_number());
+    info.gset("indexedBytes", (long)reader->indexed_bytes());
+    info.gset("indexedEntries", (long)reader->indexed_entries());
+    info.gset("indexingDone", reader->indexing_done() ? 1 : 0);
+    info.gset("hasPrevious", reader->has_previous() ? 1 : 0);
+    info.gset("hasNext", reader->has_next() ? 1 : 0);
+    return info;
+  }
+
+  int refreshLogFile(int handle) {
+    log_reader(handle)->refresh();
+    return 1;
+  }
+
+private:
+  std::mutex _log_readers_mutex;
+  std::map<int, std::shared_ptr<LogFileReader> > _log_readers;
+  int _next_log_reader = 1;
+
+  int add_log_reader(LogFileReader *reader) {
+    std::lock_guard<std::mutex> lock(_log_readers_mutex);
+    _log_readers[_next_log_reader] = std::shared_ptr<LogFileReader>(reader);
+    return _next_log_reader++;
+  }
+
+  std::shared_ptr<LogFileReader> log_reader(int handle) {
+    std::lock_guard<std::mutex> lock(_log_readers_mutex);
+    auto reader = _log_readers.find(handle);
+    if (reader == _log_readers.end())
+      throw std::invalid_argument("Invalid log file handle");
+    return reader->second;
+  }
+
+  static grt::BaseListRef entry_list(const std::vector<LogFileReader::Entry> &entries) {
+    grt::BaseListRef list(true);
+    for (auto &entry : entries) {
+      grt::StringListRef fields(grt::Initialized);
+      for (auto &field : entry)
+        fields.insert(field);
+      list.ginsert(fields);
+    }
+    return list;
+  }
 };
 
 GRT_MODULE_ENTRY_POINT(UtilitiesImpl);
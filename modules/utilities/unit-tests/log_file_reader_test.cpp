@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/file_utilities.h"
+#include "wb_helpers.h"
+
+#include "modules/utilities/src/log_file_reader.h"
+
+#include <chrono>
+#include <thread>
+
+// Slow log of a 5.6 server: a header, entries with their own time and one in the same second as the one before.
+static const char *slow_log =
+  "/usr/sbin/mysqld, Version: 5.6.39-log (MySQL Community Server (GPL)). started with:\n"
+  "Tcp port: 3306  Unix socket: /var/run/mysqld/mysqld.sock\n"
+  "Time                 Id Command    Argument\n"
+  "# Time: 180301 14:00:00\n"
+  "# User@Host: root[root] @ localhost []  Id:     2\n"
+  "# Query_time: 2.000123  Lock_time: 0.000100 Rows_sent: 1  Rows_examined: 1000\n"
+  "SET timestamp=1519909200;\n"
+  "select sleep(2);\n"
+  "# User@Host: root[root] @ localhost []  Id:     2\n"
+  "# Query_time: 1.500000  Lock_time: 0.000000 Rows_sent: 0  Rows_examined: 0\n"
+  "SET timestamp=1519909200;\n"
+  "select sleep(1.5);\n"
+  "# Time: 180301 14:05:10\n"
+  "# User@Host: app[app] @ web1 [10.0.0.5]  Id:     7\n"
+  "# Query_time: 3.250000  Lock_time: 0.000200 Rows_sent: 10  Rows_examined: 500000\n"
+  "SET timestamp=1519909510;\n"
+  "select * from orders where note like '%late%';\n"
+  "# Time: 180302  9:30:00\n"
+  "# User@Host: app[app] @ web2 [10.0.0.6]  Id:     9\n"
+  "# Query_time: 5.000000  Lock_time: 0.000000 Rows_sent: 0  Rows_examined: 2\n"
+  "SET timestamp=1519979400;\n"
+  "update orders set state = 1;\n";
+
+static const char *general_log =
+  "/usr/sbin/mysqld, Version: 5.6.39-log (MySQL Community Server (GPL)). started with:\n"
+  "Tcp port: 3306  Unix socket: /var/run/mysqld/mysqld.sock\n"
+  "Time                 Id Command    Argument\n"
+  "180301 14:00:00\t    2 Connect\troot@localhost on \n"
+  "\t\t    2 Query\tselect 1\n"
+  "\t\t    2 Query\tselect *\n"
+  "from t1\n"
+  "where a = 1\n"
+  "180301 14:00:05\t    2 Init DB\tsakila\n"
+  "\t\t    2 Quit\t\n";
+
+static const char *error_log =
+  "2018-03-01 14:00:00 1234 [Note] InnoDB: Started\n"
+  "180301 14:00:01 mysqld_safe Starting mysqld daemon\n"
+  "some line in no known format\n"
+  "2018-03-01 14:00:02 1234 [ERROR] ";
+
+BEGIN_TEST_DATA_CLASS(log_file_reader)
+public:
+std::string path;
+
+TEST_DATA_CONSTRUCTOR(log_file_reader) : path("log_file_reader_test.log") {
+}
+
+LogFileReader *open(const std::string &data, LogFileReader::Format format, size_t page_entries = 0) {
+  ensure("write log file", g_file_set_contents(path.c_str(), data.data(), (gssize)data.size(), NULL) != FALSE);
+  return new LogFileReader(LogFileReader::open_local(path), format, page_entries);
+}
+
+void wait_for_index(LogFileReader *reader) {
+  for (int i = 0; i < 500 && !reader->indexing_done(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ensure("indexing done", reader->indexing_done());
+}
+END_TEST_DATA_CLASS;
+
+TEST_MODULE(log_file_reader, "paging through server log files");
+
+TEST_FUNCTION(1) {
+  LogFileReader *reader = open(slow_log, LogFileReader::SlowLog, 2);
+
+  // Without a page chosen, the last one is shown.
+  std::vector<LogFileReader::Entry> entries = reader->current();
+  ensure_equals("last page entries", entries.size(), 2U);
+  ensure_equals("last entry time", entries[1][0], "2018-03-02 09:30:00");
+  ensure_equals("last entry user", entries[1][1], "app[app] @ web2 [10.0.0.6]  Id:     9");
+  ensure_equals("last entry query time", entries[1][2], "5.000000");
+  ensure_equals("last entry rows examined", entries[1][5], "2");
+  ensure_equals("last entry detail", entries[1][6], "SET timestamp=1519979400;\nupdate orders set state = 1;");
+  ensure("last page has no next", !reader->has_next());
+  ensure("last page has previous", reader->has_previous());
+
+  // The first page includes the server header, the entry without a time of its own is one of its own.
+  entries = reader->previous();
+  ensure_equals("first page entries", entries.size(), 2U);
+  ensure_equals("first page starts at the file", reader->page_start(), 0);
+  ensure_equals("first entry time", entries[0][0], "2018-03-01 14:00:00");
+  ensure_equals("first entry query", entries[0][6], "SET timestamp=1519909200;\nselect sleep(2);");
+  ensure_equals("entry in the same second", entries[1][0], "");
+  ensure_equals("entry in the same second query time", entries[1][2], "1.500000");
+  ensure("first page has no previous", !reader->has_previous());
+
+  entries = reader->next();
+  ensure_equals("next page", entries[0][0], "2018-03-01 14:05:10");
+
+  wait_for_index(reader);
+  ensure_equals("indexed entries", reader->indexed_entries(), 4);
+  ensure_equals("number of the first entry", reader->page_entry_number(), 2);
+  delete reader;
+  base::remove(path);
+}
+
+TEST_FUNCTION(2) {
+  LogFileReader *reader = open(slow_log, LogFileReader::SlowLog, 2);
+  wait_for_index(reader);
+
+  std::vector<LogFileReader::Entry> entries = reader->seek_time("2018-03-01 14:05");
+  ensure_equals("seek to a time in between", entries[0][0], "2018-03-01 14:05:10");
+  entries = reader->seek_time("2018-03-01 14:00:00");
+  ensure_equals("seek to an exact time", entries[0][0], "2018-03-01 14:00:00");
+  entries = reader->seek_time("2018-03-02");
+  ensure_equals("seek to the last entry", entries.size(), 1U);
+  ensure_equals("seek to the last entry time", entries[0][0], "2018-03-02 09:30:00");
+  entries = reader->seek_time("2019");
+  ensure("seek after the end shows the last page", !reader->has_next());
+  delete reader;
+  base::remove(path);
+}
+
+TEST_FUNCTION(3) {
+  LogFileReader *reader = open(general_log, LogFileReader::GeneralLog);
+  std::vector<LogFileReader::Entry> entries = reader->first();
+  ensure_equals("general log entries", entries.size(), 5U);
+  ensure_equals("connect time", entries[0][0], "2018-03-01 14:00:00");
+  ensure_equals("connect thread", entries[0][1], "2");
+  ensure_equals("connect command", entries[0][2], "Connect");
+  ensure_equals("entry without time", entries[1][0], "");
+  ensure_equals("query", entries[1][3], "select 1");
+  ensure_equals("query of several lines", entries[2][3], "select *\nfrom t1\nwhere a = 1");
+  ensure_equals("command with a blank", entries[3][2], "Init DB");
+  ensure_equals("command argument", entries[3][3], "sakila");
+  ensure_equals("last command", entries[4][2], "Quit");
+  delete reader;
+  base::remove(path);
+}
+
+TEST_FUNCTION(4) {
+  std::string long_message(100000, 'x');
+  LogFileReader *reader = open(error_log + long_message + "\n", LogFileReader::ErrorLog);
+  std::vector<LogFileReader::Entry> entries = reader->last();
+  ensure_equals("error log entries", entries.size(), 4U);
+  ensure_equals("5.6 entry thread", entries[0][1], "1234");
+  ensure_equals("5.6 entry type", entries[0][2], "Note");
+  ensure_equals("5.6 entry details", entries[0][3], "InnoDB: Started");
+  ensure_equals("mysqld_safe entry time", entries[1][0], "2018-03-01 14:00:01");
+  ensure_equals("mysqld_safe entry type", entries[1][2], "mysqld_safe");
+  ensure_equals("unknown format", entries[2][3], "some line in no known format");
+  ensure_equals("long entry", entries[3][3], std::string(256, 'x') + " [truncated, 97.7 KB total]");
+  delete reader;
+  base::remove(path);
+}
+
+TEST_FUNCTION(5) {
+  // Entries appended to the file show up after a refresh, the incomplete last line is not indexed before.
+  LogFileReader *reader = open("2018-03-01 14:00:00 1 [Note] one\n2018-03-01 14:00:01 1 [Note] tw",
+                               LogFileReader::ErrorLog);
+  wait_for_index(reader);
+  ensure_equals("incomplete line not indexed", reader->indexed_entries(), 1);
+
+  std::string data = "2018-03-01 14:00:00 1 [Note] one\n2018-03-01 14:00:01 1 [Note] two\n"
+                     "2018-03-01 14:00:02 1 [Note] three\n";
+  ensure("append to log file", g_file_set_contents(path.c_str(), data.data(), (gssize)data.size(), NULL) != FALSE);
+  reader->refresh();
+  std::vector<LogFileReader::Entry> entries = reader->current();
+  ensure_equals("entries after refresh", entries.size(), 3U);
+  ensure_equals("appended entry", entries[2][3], "three");
+  wait_for_index(reader);
+  ensure_equals("appended entries indexed", reader->indexed_entries(), 3);
+  delete reader;
+  base::remove(path);
+}
+
+END_TESTS
@@ -0,0 +1,481 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "force_layout.h"
+#include "base/task_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <thread>
+
+// Graphs are not coarsened any further once they are this small, or when a level would not shrink enough.
+#define COARSEST_GRAPH_SIZE 20
+#define MIN_COARSENING_RATIO 0.8
+
+#define COARSEST_LEVEL_ITERATIONS 300
+#define LEVEL_ITERATIONS 60
+
+// Cells smaller than this fraction of their distance to a node act on it as a single body.
+#define BARNES_HUT_THETA 0.8
+#define QUAD_TREE_MAX_DEPTH 32
+
+// Pull towards the center of the layout, keeps unconnected parts of the graph together.
+#define GRAVITY 1.5
+
+// Less nodes than this per thread are not worth starting threads for.
+#define MIN_NODES_PER_THREAD 256
+
+#define MAX_OVERLAP_PASSES 200
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Barnes-Hut quad tree over the node centers of one level, rebuilt for every iteration.
+ */
+struct ForceLayout::QuadTree {
+  struct Cell {
+    double x0; // Square covered by the cell.
+    double y0;
+    double size;
+    double cx; // Center of mass of the nodes in the cell.
+    double cy;
+    double mass;
+    int children[4];
+    long node; // The node of a leaf holding exactly one, -1 otherwise.
+
+    Cell(double x, double y, double s) : x0(x), y0(y), size(s), cx(0), cy(0), mass(0), node(-1) {
+      children[0] = children[1] = children[2] = children[3] = -1;
+    }
+  };
+
+  std::vector<Cell> cells;
+
+  QuadTree(const std::vector<Node> &nodes) {
+    double minx = nodes[0].x, miny = nodes[0].y, maxx = nodes[0].x, maxy = nodes[0].y;
+    for (std::vector<Node>::const_iterator node = nodes.begin(); node != nodes.end(); ++node) {
+      minx = std::min(minx, node->x);
+      miny = std::min(miny, node->y);
+      maxx = std::max(maxx, node->x);
+      maxy = std::max(maxy, node->y);
+    }
+
+    std::vector<std::size_t> indices(nodes.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    cells.reserve(2 * nodes.size());
+    build(nodes, &indices[0], &indices[0] + indices.size(), minx, miny, std::max(maxx - minx, maxy - miny) + 1, 0);
+  }
+
+  int build(const std::vector<Node> &nodes, std::size_t *first, std::size_t *last, double x0, double y0, double size,
+            int depth) {
+    int index = (int)cells.size();
+    cells.push_back(Cell(x0, y0, size));
+
+    double mass = 0, cx = 0, cy = 0;
+    if (last - first == 1 || depth == QUAD_TREE_MAX_DEPTH) {
+      // Nodes at (nearly) the same spot end up together in the same leaf at the maximum depth.
+      for (std::size_t *i = first; i != last; ++i) {
+        mass += nodes[*i].mass;
+        cx += nodes[*i].x * nodes[*i].mass;
+        cy += nodes[*i].y * nodes[*i].mass;
+      }
+      if (last - first == 1)
+        cells[index].node = (long)*first;
+    } else {
+      double half = size / 2;
+      double mx = x0 + half, my = y0 + half;
+
+      std::size_t *bottom = std::partition(first, last, [&](std::size_t i) { return nodes[i].y < my; });
+      std::size_t *top_right = std::partition(first, bottom, [&](std::size_t i) { return nodes[i].x < mx; });
+      std::size_t *bottom_right = std::partition(bottom, last, [&](std::size_t i) { return nodes[i].x < mx; });
+
+      std::size_t *bounds[5] = {first, top_right, bottom, bottom_right, last};
+      for (int quadrant = 0; quadrant < 4; ++quadrant) {
+        if (bounds[quadrant] == bounds[quadrant + 1])
+          continue;
+        int child = build(nodes, bounds[quadrant], bounds[quadrant + 1], (quadrant & 1) ? mx : x0,
+                          (quadrant & 2) ? my : y0, half, depth + 1);
+        cells[index].children[quadrant] = child;
+        mass += cells[child].mass;
+        cx += cells[child].cx * cells[child].mass;
+        cy += cells[child].cy * cells[child].mass;
+      }
+    }
+
+    cells[index].mass = mass;
+    cells[index].cx = cx / mass;
+    cells[index].cy = cy / mass;
+
+    return index;
+  }
+
+  /**
+   * Adds the repulsion of all other nodes on the given one to fx/fy. k2 is the square of the ideal edge length.
+   */
+  void add_repulsion(const Node &node, std::size_t self, double k2, double &fx, double &fy) const {
+    int stack[4 * QUAD_TREE_MAX_DEPTH + 4];
+    int top = 0;
+
+    stack[top++] = 0;
+    while (top > 0) {
+      const Cell &cell = cells[stack[--top]];
+      if (cell.node == (long)self)
+        continue;
+
+      double dx = node.x - cell.cx;
+      double dy = node.y - cell.cy;
+      double d2 = dx * dx + dy * dy;
+      bool leaf = cell.children[0] < 0 && cell.children[1] < 0 && cell.children[2] < 0 && cell.children[3] < 0;
+
+      if (leaf || cell.size * cell.size < BARNES_HUT_THETA * BARNES_HUT_THETA * d2) {
+        if (d2 < 0.01) {
+          // Coincident nodes: push them apart in some direction that differs per node.
+          dx = (double)(self % 7) - 3 + 0.5;
+          dy = (double)(self % 5) - 2 + 0.5;
+          d2 = dx * dx + dy * dy;
+        }
+        double f = k2 * node.mass * cell.mass / d2; // k² * m1 * m2 / d, along (dx, dy) / d.
+        fx += f * dx;
+        fy += f * dy;
+      } else {
+        for (int i = 0; i < 4; ++i) {
+          if (cell.children[i] >= 0)
+            stack[top++] = cell.children[i];
+        }
+      }
+    }
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ForceLayout::ForceLayout(double spacing) : _spacing(spacing), _ideal_length(0), _levels(1) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::size_t ForceLayout::add_node(double width, double height) {
+  _levels[0].nodes.push_back(Node(width, height));
+  _levels[0].edges.push_back(std::vector<std::size_t>());
+  return _levels[0].nodes.size() - 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ForceLayout::add_edge(std::size_t node1, std::size_t node2) {
+  if (node1 == node2)
+    return;
+
+  _levels[0].edges[node1].push_back(node2);
+  _levels[0].edges[node2].push_back(node1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+double ForceLayout::left(std::size_t node) const {
+  return _levels[0].nodes[node].x - _levels[0].nodes[node].width / 2;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+double ForceLayout::top(std::size_t node) const {
+  return _levels[0].nodes[node].y - _levels[0].nodes[node].height / 2;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Adds a coarser version of the last level to the level list, with pairs of nodes merged into one. Connected nodes
+ * are merged first (leaves before hubs), unconnected ones are paired among themselves.
+ * Returns false if the last level is small enough already or did not shrink enough.
+ */
+bool ForceLayout::coarsen() {
+  const std::size_t unmatched = (std::size_t)-1;
+  Graph &fine = _levels.back();
+  std::size_t count = fine.nodes.size();
+
+  if (count <= COARSEST_GRAPH_SIZE)
+    return false;
+
+  std::vector<std::size_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) { return fine.edges[a].size() < fine.edges[b].size(); });
+
+  std::vector<std::size_t> match(count, unmatched);
+  std::vector<std::size_t> loners;
+  for (std::vector<std::size_t>::const_iterator u = order.begin(); u != order.end(); ++u) {
+    if (match[*u] != unmatched)
+      continue;
+
+    std::size_t best = unmatched;
+    for (std::vector<std::size_t>::const_iterator v = fine.edges[*u].begin(); v != fine.edges[*u].end(); ++v) {
+      if (match[*v] == unmatched && *v != *u && (best == unmatched || fine.nodes[*v].mass < fine.nodes[best].mass))
+        best = *v;
+    }
+    if (best != unmatched) {
+      match[*u] = best;
+      match[best] = *u;
+    } else if (fine.edges[*u].empty())
+      loners.push_back(*u);
+  }
+  for (std::size_t i = 0; i + 1 < loners.size(); i += 2) {
+    match[loners[i]] = loners[i + 1];
+    match[loners[i + 1]] = loners[i];
+  }
+
+  Graph coarse;
+  fine.parents.assign(count, 0);
+  for (std::size_t u = 0; u < count; ++u) {
+    if (match[u] == unmatched) {
+      fine.parents[u] = coarse.nodes.size();
+      coarse.nodes.push_back(fine.nodes[u]);
+    } else if (match[u] > u) {
+      const Node &a = fine.nodes[u];
+      const Node &b = fine.nodes[match[u]];
+      double side = sqrt(a.width * a.height + b.width * b.height);
+      Node merged(side, side);
+      merged.mass = a.mass + b.mass;
+
+      fine.parents[u] = fine.parents[match[u]] = coarse.nodes.size();
+      coarse.nodes.push_back(merged);
+    }
+  }
+
+  if (coarse.nodes.size() > count * MIN_COARSENING_RATIO) {
+    fine.parents.clear();
+    return false;
+  }
+
+  coarse.edges.resize(coarse.nodes.size());
+  for (std::size_t u = 0; u < count; ++u) {
+    for (std::vector<std::size_t>::const_iterator v = fine.edges[u].begin(); v != fine.edges[u].end(); ++v) {
+      if (fine.parents[u] != fine.parents[*v])
+        coarse.edges[fine.parents[u]].push_back(fine.parents[*v]);
+    }
+  }
+  for (std::vector<std::vector<std::size_t> >::iterator edges = coarse.edges.begin(); edges != coarse.edges.end();
+       ++edges) {
+    std::sort(edges->begin(), edges->end());
+    edges->erase(std::unique(edges->begin(), edges->end()), edges->end());
+  }
+
+  _levels.push_back(coarse); // Invalidates fine.
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Runs the force simulation on one level. Each iteration moves every node along the sum of the forces on it,
+ * by at most the current temperature, which cools down to a hundredth of its start value.
+ */
+void ForceLayout::layout_level(Graph &graph, double temperature, int iterations, double &work_done,
+                               double total_work, const ProgressSlot &progress) {
+  std::vector<Node> &nodes = graph.nodes;
+  std::size_t count = nodes.size();
+  const double k = _ideal_length;
+  const double k2 = k * k;
+  const double cooling = pow(0.01, 1.0 / iterations);
+
+  std::size_t thread_count =
+    std::min((std::size_t)std::max(1U, std::thread::hardware_concurrency()), count / MIN_NODES_PER_THREAD);
+  std::vector<double> dx(count), dy(count);
+
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    QuadTree tree(nodes);
+    double cx = tree.cells[0].cx, cy = tree.cells[0].cy;
+
+    auto compute_forces = [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        const Node &node = nodes[i];
+        double fx = 0, fy = 0;
+
+        tree.add_repulsion(node, i, k2, fx, fy);
+
+        // Attraction d² / k, along the edge.
+        for (std::vector<std::size_t>::const_iterator j = graph.edges[i].begin(); j != graph.edges[i].end(); ++j) {
+          double ex = node.x - nodes[*j].x;
+          double ey = node.y - nodes[*j].y;
+          double d = sqrt(ex * ex + ey * ey);
+          fx -= ex * d / k;
+          fy -= ey * d / k;
+        }
+
+        fx -= GRAVITY * node.mass * (node.x - cx);
+        fy -= GRAVITY * node.mass * (node.y - cy);
+
+        dx[i] = fx / node.mass;
+        dy[i] = fy / node.mass;
+      }
+    };
+
+    if (thread_count > 1) {
+      std::size_t chunk = (count + thread_count - 1) / thread_count;
+      std::size_t chunk_count = (count + chunk - 1) / chunk;
+      base::TaskScheduler::get()->run_parallel(base::TaskInteractive, chunk_count, [&](std::size_t index) {
+        compute_forces(index * chunk, std::min(count, (index + 1) * chunk));
+      });
+    } else
+      compute_forces(0, count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double length = sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+      if (length > 0) {
+        double step = std::min(length, temperature) / length;
+        nodes[i].x += dx[i] * step;
+        nodes[i].y += dy[i] * step;
+      }
+    }
+    temperature *= cooling;
+
+    work_done += count;
+    if (progress)
+      progress((float)(work_done / total_work));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * The simulation treats figures as points, so neighbours may still overlap. Push overlapping rectangles apart
+ * along the axis needing the smaller move, until every pair is at least a quarter of the spacing apart.
+ */
+void ForceLayout::remove_overlaps() {
+  std::vector<Node> &nodes = _levels[0].nodes;
+  const double gap = _spacing / 4;
+
+  std::vector<std::size_t> order(nodes.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  for (int pass = 0; pass < MAX_OVERLAP_PASSES; ++pass) {
+    bool moved = false;
+
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return nodes[a].x - nodes[a].width / 2 < nodes[b].x - nodes[b].width / 2;
+    });
+
+    for (std::size_t a = 0; a < order.size(); ++a) {
+      Node &n1 = nodes[order[a]];
+      for (std::size_t b = a + 1; b < order.size(); ++b) {
+        Node &n2 = nodes[order[b]];
+        if (n2.x - n2.width / 2 >= n1.x + n1.width / 2 + gap)
+          break;
+
+        double ox = (n1.width + n2.width) / 2 + gap - fabs(n1.x - n2.x);
+        double oy = (n1.height + n2.height) / 2 + gap - fabs(n1.y - n2.y);
+        if (ox <= 0 || oy <= 0)
+          continue;
+
+        moved = true;
+        if (ox < oy) {
+          double shift = (n1.x < n2.x || (n1.x == n2.x && order[a] < order[b])) ? -ox / 2 : ox / 2;
+          n1.x += shift;
+          n2.x -= shift;
+        } else {
+          double shift = (n1.y < n2.y || (n1.y == n2.y && order[a] < order[b])) ? -oy / 2 : oy / 2;
+          n1.y += shift;
+          n2.y -= shift;
+        }
+      }
+    }
+
+    if (!moved)
+      break;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ForceLayout::run(const ProgressSlot &progress) {
+  std::vector<Node> &nodes = _levels[0].nodes;
+  if (nodes.empty())
+    return;
+
+  // The ideal distance between two connected nodes is the average figure size plus the requested spacing.
+  // Larger figures get more mass, so they push their neighbours further away.
+  double size_sum = 0, area_sum = 0;
+  for (std::vector<Node>::const_iterator node = nodes.begin(); node != nodes.end(); ++node) {
+    size_sum += sqrt(node->width * node->height);
+    area_sum += node->width * node->height;
+  }
+  _ideal_length = size_sum / nodes.size() + _spacing;
+  double average_area = std::max(1.0, area_sum / nodes.size());
+  for (std::vector<Node>::iterator node = nodes.begin(); node != nodes.end(); ++node)
+    node->mass = std::min(4.0, std::max(0.5, node->width * node->height / average_area));
+
+  _levels.resize(1);
+  while (coarsen())
+    ;
+  std::vector<Node> &finest = _levels[0].nodes; // Adding levels moved the graphs.
+
+  double total_work = 0, work_done = 0;
+  for (std::size_t level = 0; level < _levels.size(); ++level)
+    total_work += _levels[level].nodes.size() *
+                  (level + 1 == _levels.size() ? COARSEST_LEVEL_ITERATIONS : LEVEL_ITERATIONS);
+
+  // Fixed seed, the same input always gives the same layout.
+  std::mt19937 random(4711);
+
+  Graph &coarsest = _levels.back();
+  double extent = _ideal_length * sqrt((double)coarsest.nodes.size());
+  std::uniform_real_distribution<double> spread(0, extent);
+  for (std::vector<Node>::iterator node = coarsest.nodes.begin(); node != coarsest.nodes.end(); ++node) {
+    node->x = spread(random);
+    node->y = spread(random);
+  }
+
+  std::uniform_real_distribution<double> jitter(-_ideal_length / 4, _ideal_length / 4);
+  for (std::size_t level = _levels.size() - 1;; --level) {
+    bool is_coarsest = level + 1 == _levels.size();
+    layout_level(_levels[level], is_coarsest ? extent : _ideal_length,
+                 is_coarsest ? COARSEST_LEVEL_ITERATIONS : LEVEL_ITERATIONS, work_done, total_work, progress);
+    if (level == 0)
+      break;
+
+    // Nodes start next to the node they were merged into.
+    Graph &finer = _levels[level - 1];
+    for (std::size_t i = 0; i < finer.nodes.size(); ++i) {
+      const Node &parent = _levels[level].nodes[finer.parents[i]];
+      finer.nodes[i].x = parent.x + jitter(random);
+      finer.nodes[i].y = parent.y + jitter(random);
+    }
+  }
+  _levels.resize(1);
+
+  remove_overlaps();
+
+  double minx = left(0), miny = top(0);
+  for (std::size_t i = 1; i < finest.size(); ++i) {
+    minx = std::min(minx, left(i));
+    miny = std::min(miny, top(i));
+  }
+  for (std::vector<Node>::iterator node = finest.begin(); node != finest.end(); ++node) {
+    node->x -= minx;
+    node->y -= miny;
+  }
+
+  if (progress)
+    progress(1.0f);
+}
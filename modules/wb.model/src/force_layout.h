@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * Multilevel force directed layout of a graph of rectangles (figures as nodes, connections as edges).
+ *
+ * The graph is coarsened by merging connected nodes until it is small, the coarsest graph is laid out first and
+ * every finer level starts from the positions of the level above it. On each level nodes attract along edges and
+ * repel each other (Fruchterman-Reingold). Repulsion is approximated with a Barnes-Hut quad tree and computed on
+ * several threads for large graphs. Finally, overlaps between the rectangles are pushed apart.
+ */
+class ForceLayout {
+public:
+  // Called with the fraction of the work done so far, on the thread that called run().
+  typedef std::function<void(float)> ProgressSlot;
+
+  ForceLayout(double spacing = 80);
+
+  std::size_t add_node(double width, double height);
+  void add_edge(std::size_t node1, std::size_t node2);
+
+  void run(const ProgressSlot &progress = ProgressSlot());
+
+  // Top left corner of a node after run(). The layout as a whole starts at (0, 0).
+  double left(std::size_t node) const;
+  double top(std::size_t node) const;
+
+private:
+  struct Node {
+    double x; // Center.
+    double y;
+    double width;
+    double height;
+    double mass;
+
+    Node(double w, double h) : x(0), y(0), width(w), height(h), mass(1) {
+    }
+  };
+
+  struct Graph {
+    std::vector<Node> nodes;
+    std::vector<std::vector<std::size_t> > edges; // Adjacency lists.
+    std::vector<std::size_t> parents;             // Node in the next coarser level each node was merged into.
+  };
+
+  struct QuadTree;
+
+  double _spacing;
+  double _ideal_length;
+  std::vector<Graph> _levels; // _levels[0] is the graph to lay out.
+
+  bool coarsen();
+  void layout_level(Graph &graph, double temperature, int iterations, double &work_done, double total_work,
+                    const ProgressSlot &progress);
+  void remove_overlaps();
+};
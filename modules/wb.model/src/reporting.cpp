@@ -58,29 +58,45 @@
 
 #include "mtemplate/template.h"
 
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+// Less DDL scripts than this per thread are highlighted without starting further threads.
+#define HIGHLIGHT_MIN_SCRIPTS_PER_THREAD 50
+
 using namespace base;
 
 DEFAULT_LOG_DOMAIN("Model.Reporting")
 
 //----------------- LexerDocument ------------------------------------------------------------------
 
-LexerDocument::LexerDocument(const std::string &text) : _text(text), _styling_mask('\0') {
-  _style_position = 0;
-  _style_buffer = new char[_text.size()];
-
-  // Split the text into lines and store start and length of each.
-  std::vector<std::string> lines = base::split(text, "\n");
-  std::size_t start = 0;
-  for (std::size_t i = 0; i < lines.size(); ++i) {
-    _lines.push_back(std::make_pair(start, lines[i].size() + 1));
-    start += lines[i].size() + 1;
-  }
+LexerDocument::LexerDocument(const std::string &text) : _text(&text), _styling_mask('\0') {
+  reset(text);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 LexerDocument::~LexerDocument() {
-  delete[] _style_buffer;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void LexerDocument::reset(const std::string &text) {
+  _text = &text;
+  _style_position = 0;
+  _styling_mask = '\0';
+  _style_buffer.resize(text.size());
+  _level_cache.clear();
+
+  // Store start and length of each line, including its line break.
+  _lines.clear();
+  std::size_t start = 0;
+  for (std::size_t end = text.find('\n'); end != std::string::npos; end = text.find('\n', start)) {
+    _lines.push_back(std::make_pair(start, end - start + 1));
+    start = end + 1;
+  }
+  _lines.push_back(std::make_pair(start, text.size() - start + 1));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -103,13 +119,13 @@ void LexerDocument::SetErrorStatus(int status) {
 //--------------------------------------------------------------------------------------------------
 
 int LexerDocument::Length() const {
-  return (int)_text.size();
+  return (int)_text->size();
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void LexerDocument::GetCharRange(char *buffer, int position, int lengthRetrieve) const {
-  _text.copy(buffer, lengthRetrieve, position);
+  _text->copy(buffer, lengthRetrieve, position);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -203,7 +219,7 @@ void LexerDocument::StartStyling(int position, char mask) {
 
 bool LexerDocument::SetStyleFor(int length, char style) {
   // Style buffer and text have the same length so we can use the text to get the size (which is faster).
-  if (_style_position + length >= (int)_text.size())
+  if (_style_position + length >= (int)_text->size())
     return false;
 
   int i = _style_position;
@@ -218,7 +234,7 @@ bool LexerDocument::SetStyleFor(int length, char style) {
 //--------------------------------------------------------------------------------------------------
 
 bool LexerDocument::SetStyles(int length, const char *styles) {
-  if (_style_position + length > (int)_text.size())
+  if (_style_position + length > (int)_text->size())
     return false;
 
   int i = _style_position;
@@ -758,43 +774,113 @@ const std::string markupFromStyle(int style) {
 }
 
 //--------------------------------------------------------------------------------------------------
-void set_ddl(mtemplate::DictionaryInterface *target, SQLGeneratorInterfaceImpl *sqlgenModule,
-             const GrtNamedObjectRef &object, const Scintilla::LexerModule *lexer, bool ddl_enabled) {
-  if (ddl_enabled && sqlgenModule != NULL) {
-    std::string sql = sqlgenModule->makeCreateScriptForObject(object);
 
-    if (lexer != NULL) {
-      // Add syntax highlighter markup.
-      LexerDocument *document = new LexerDocument(sql);
-      SCI_WRAPPER_NS PropSetSimple property_set;
-      SCI_WRAPPER_NS Accessor *accessor = new SCI_WRAPPER_NS Accessor(document, &property_set);
-
-      lexer->Lex(0, (int)sql.size(), 0, keywordLists, *accessor);
-
-      int currentStyle = SCE_MYSQL_DEFAULT;
-      int tokenStart = 0;
-      std::string markup = "";
-      int i;
-      for (i = 0; i < (int)sql.size(); i++)
-        if (currentStyle != accessor->StyleAt(i)) {
-          markup += base::replaceString(markupFromStyle(currentStyle), "%s", sql.substr(tokenStart, i - tokenStart));
-          tokenStart = i;
-          currentStyle = accessor->StyleAt(i);
-        }
+/**
+ * A DDL script waiting for syntax highlighting. The scripts of all objects are highlighted together after the
+ * report dictionaries are built, as that can run in parallel.
+ */
+struct PendingDDL {
+  mtemplate::DictionaryInterface *target;
+  std::string sql;
+};
 
-      markup += base::replaceString(markupFromStyle(currentStyle), "%s", sql.substr(tokenStart, i - tokenStart));
+//--------------------------------------------------------------------------------------------------
 
-      delete accessor;
-      delete document;
+/**
+ * Returns the sql with syntax highlighter markup. The document is reused for all scripts of a thread.
+ */
+static std::string highlight_sql(const std::string &sql, const Scintilla::LexerModule *lexer,
+                                 LexerDocument &document) {
+  document.reset(sql);
+  SCI_WRAPPER_NS PropSetSimple property_set;
+  SCI_WRAPPER_NS Accessor accessor(&document, &property_set);
+
+  lexer->Lex(0, (int)sql.size(), 0, keywordLists, accessor);
+
+  std::string markup;
+  markup.reserve(sql.size() * 2);
+
+  int currentStyle = SCE_MYSQL_DEFAULT;
+  int tokenStart = 0;
+  int i;
+  for (i = 0; i <= (int)sql.size(); i++) {
+    if (i < (int)sql.size() && currentStyle == accessor.StyleAt(i))
+      continue;
+
+    std::string format = markupFromStyle(currentStyle);
+    std::string::size_type placeholder = format.find("%s");
+    markup.append(format, 0, placeholder).append(sql, tokenStart, i - tokenStart).append(format, placeholder + 2,
+                                                                                          std::string::npos);
+    if (i < (int)sql.size()) {
+      tokenStart = i;
+      currentStyle = accessor.StyleAt(i);
+    }
+  }
 
-      sql = markup;
-    };
+  return markup;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Replaces the sql of all pending scripts by its highlighted version, spread over several threads for large models.
+ */
+static void highlight_ddl(std::vector<PendingDDL> &pending, const Scintilla::LexerModule *lexer) {
+  std::size_t thread_count = std::max(1U, std::thread::hardware_concurrency());
+  thread_count = std::max((std::size_t)1, std::min(thread_count, pending.size() / HIGHLIGHT_MIN_SCRIPTS_PER_THREAD));
+
+  std::vector<std::exception_ptr> errors(thread_count);
+  auto highlight_range = [&](std::size_t index) {
+    try {
+      std::string empty;
+      LexerDocument document(empty);
+      for (std::size_t i = index; i < pending.size(); i += thread_count)
+        pending[i].sql = highlight_sql(pending[i].sql, lexer, document);
+    } catch (...) {
+      errors[index] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < thread_count; ++i)
+    threads.push_back(std::thread(highlight_range, i));
+  highlight_range(0);
+  for (auto &thread : threads)
+    thread.join();
+
+  for (auto &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void set_ddl_script(mtemplate::DictionaryInterface *target, const std::string &sql) {
+  std::string fixed_line_breaks = base::replaceString(sql, "\n", "<br />");
+
+  // The DDL script is wrapped in an own section dir to allow switching it off entirely (including
+  // the surrounding HTML code).
+  target->setValueAndShowSection(REPORT_DDL_SCRIPT, fixed_line_breaks, REPORT_DDL_LISTING);
+}
+
+//--------------------------------------------------------------------------------------------------
 
-    std::string fixed_line_breaks = base::replaceString(sql, "\n", "<br />");
+/**
+ * Sets the DDL script of the object in the target dictionary. If highlighting is enabled the script is queued in
+ * pending instead and set by highlight_ddl().
+ */
+void set_ddl(mtemplate::DictionaryInterface *target, SQLGeneratorInterfaceImpl *sqlgenModule,
+             const GrtNamedObjectRef &object, std::vector<PendingDDL> *pending, bool ddl_enabled) {
+  if (ddl_enabled && sqlgenModule != NULL) {
+    std::string sql = sqlgenModule->makeCreateScriptForObject(object);
 
-    // The DDL script is wrapped in an own section dir to allow switching it off entirely (including
-    // the surrounding HTML code).
-    target->setValueAndShowSection(REPORT_DDL_SCRIPT, fixed_line_breaks, REPORT_DDL_LISTING);
+    if (pending != NULL) {
+      PendingDDL ddl;
+      ddl.target = target;
+      ddl.sql = sql;
+      pending->push_back(ddl);
+    } else
+      set_ddl_script(target, sql);
   }
 }
 
@@ -985,6 +1071,10 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
       throw std::logic_error("could not find SQL generation module for mysql");
   }
 
+  // The DDL of all objects is generated while building the dictionaries, but highlighted afterwards.
+  std::vector<PendingDDL> pending_ddl;
+  std::vector<PendingDDL> *highlight_queue = lexer != NULL ? &pending_ddl : NULL;
+
   // Build schema_dict by looping over all schemata, add it to the main_dict.
   for (int i = 0; i < (int)catalog->schemata().count(); i++) {
     db_mysql_SchemaRef schema = catalog->schemata().get(i);
@@ -994,7 +1084,7 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
     schema_dictionary->setIntValue(REPORT_SCHEMA_NUMBER, i + 1);
     schema_dictionary->setValue(REPORT_SCHEMA_NAME, *schema->name());
 
-    set_ddl(schema_dictionary, sqlgenModule, schema, lexer, show_ddl);
+    set_ddl(schema_dictionary, sqlgenModule, schema, highlight_queue, show_ddl);
 
     schema_dictionary->setIntValue(REPORT_TABLE_COUNT, (int)schema->tables().count());
 
@@ -1015,7 +1105,7 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
       table_dictionary->setValueAndShowSection(REPORT_TABLE_COMMENT, *table->comment(), REPORT_TABLE_COMMENT_LISTING);
 
       fillTablePropertyDict(table, table_dictionary);
-      set_ddl(table_dictionary, sqlgenModule, table, lexer, show_ddl);
+      set_ddl(table_dictionary, sqlgenModule, table, highlight_queue, show_ddl);
 
       if (columns_show) {
         mtemplate::DictionaryInterface *columns_list_dictionary = NULL;
@@ -1121,7 +1211,7 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
 
           mtemplate::DictionaryInterface *trigger_dictionary = schema_dictionary->addSectionDictionary(REPORT_TRIGGERS);
           fillTriggerDict(trigger, table, trigger_dictionary);
-          set_ddl(trigger_dictionary, sqlgenModule, trigger, lexer, show_ddl);
+          set_ddl(trigger_dictionary, sqlgenModule, trigger, highlight_queue, show_ddl);
 
           trigger_dictionary->setIntValue(REPORT_TRIGGER_ID, total_trigger_count++);
           trigger_dictionary->setIntValue(REPORT_TRIGGER_NUMBER, k + 1);
@@ -1137,7 +1227,7 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
       mtemplate::DictionaryInterface *view_dictionary = schema_dictionary->addSectionDictionary(REPORT_VIEWS);
       view_dictionary->setIntValue(REPORT_VIEW_ID, total_view_count++);
       view_dictionary->setIntValue(REPORT_VIEW_NUMBER, j + 1);
-      set_ddl(view_dictionary, sqlgenModule, view, lexer, show_ddl);
+      set_ddl(view_dictionary, sqlgenModule, view, highlight_queue, show_ddl);
 
       fillViewDict(view, view_dictionary);
     }
@@ -1150,12 +1240,19 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
       mtemplate::DictionaryInterface *routine_dictionary = schema_dictionary->addSectionDictionary(REPORT_ROUTINES);
       routine_dictionary->setIntValue(REPORT_ROUTINE_ID, total_sp_count++);
       routine_dictionary->setIntValue(REPORT_ROUTINE_NUMBER, j + 1);
-      set_ddl(routine_dictionary, sqlgenModule, routine, lexer, show_ddl);
+      set_ddl(routine_dictionary, sqlgenModule, routine, highlight_queue, show_ddl);
 
       fillRoutineDict(routine, routine_dictionary);
     }
   }
 
+  if (!pending_ddl.empty()) {
+    highlight_ddl(pending_ddl, lexer);
+    for (auto &ddl : pending_ddl)
+      set_ddl_script(ddl.target, ddl.sql);
+    pending_ddl.clear();
+  }
+
   main_dictionary->setIntValue(REPORT_TOTAL_COLUMN_COUNT, total_column_count);
   main_dictionary->setIntValue(REPORT_TOTAL_INDEX_COUNT, total_index_count);
   main_dictionary->setIntValue(REPORT_TOTAL_FK_COUNT, total_fk_count);
@@ -1192,10 +1289,6 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
             return 0;
           }
 
-          // expand the template based on the dictionary
-          mtemplate::TemplateOutputString string_output;
-          template_index->expand(main_dictionary, &string_output);
-
           // build output file name
           std::string output_filename;
 
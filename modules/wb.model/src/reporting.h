@@ -47,10 +47,10 @@
  */
 class LexerDocument : public Scintilla::IDocument {
 private:
-  const std::string& _text;
+  const std::string* _text;
   std::vector<std::pair<std::size_t, std::size_t> > _lines;
 
-  char* _style_buffer;
+  std::vector<char> _style_buffer;
   std::vector<int> _level_cache;
   int _style_position;
   char _styling_mask;
@@ -59,6 +59,9 @@ public:
   LexerDocument(const std::string& text);
   virtual ~LexerDocument();
 
+  // Switches to another text, keeping the allocated buffers. The text must outlive its styling.
+  void reset(const std::string& text);
+
   // IDocument implementation.
   virtual int SCI_METHOD Version() const;
   virtual void SCI_METHOD SetErrorStatus(int status);
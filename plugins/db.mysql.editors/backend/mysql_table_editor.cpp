@@ -1518,7 +1518,7 @@ void MySQLTableEditorBE::set_table_option_by_name(const std::string &name, const
           }
 
           if ("ENGINE" == name)
-            bec::ValidationManager::validate_instance(get_table(), "chk_fk_lgc");
+            bec::ValidationManager::validate_instance_later(get_table(), "chk_fk_lgc");
         }
       }
       found = true;
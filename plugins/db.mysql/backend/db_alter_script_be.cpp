@@ -219,7 +219,8 @@ std::shared_ptr<DiffTreeBE> DbMySQLDiffAlter::init_diff_tree(const std::vector<s
   omf.dontdiff_mask = 3;
   grt::NormalizedComparer comparer(get_db_options());
   comparer.init_omf(&omf);
-  _alter_change = diff_make(right_cat_copy, _left_cat_copy, &omf);
+  // _left_cat_copy is kept as long as _alter_change, so added values needn't be cloned again.
+  _alter_change = diff_make(right_cat_copy, _left_cat_copy, &omf, true);
 
   SQLGeneratorInterfaceImpl *diffsql_module =
     dynamic_cast<SQLGeneratorInterfaceImpl *>(grt::GRT::get()->get_module("DbMySQL"));
@@ -44,6 +44,7 @@ using namespace grt;
 #include "grtdb/diff_dbobjectmatch.h"
 #include "grtdb/sync_profile.h"
 #include "grtsqlparser/sql_facade.h"
+#include "grtsqlparser/mysql_parser_services.h"
 #include "db.mysql/src/module_db_mysql.h"
 #include "interfaces/sqlgenerator.h"
 
@@ -373,8 +374,12 @@ db_mysql_CatalogRef DbMySQLScriptSync::get_cat_from_file_or_tree(std::string fil
     return db_mysql_CatalogRef();
   }
 
-  SqlFacade::Ref sql_parser = SqlFacade::instance_for_rdbms(pm->rdbms());
-  sql_parser->parseSqlScriptString(cat, sql_input_script);
+  // Same parser as for the catalog fetched from the server, so both sides of the comparison are parsed alike.
+  parsers::MySQLParserServices::Ref services = parsers::MySQLParserServices::get();
+  parsers::MySQLParserContext::Ref context =
+    services->createParserContext(pm->rdbms()->characterSets(), cat->version(),
+                                  bec::GRTManager::get()->get_app_option_string("SqlMode"), true);
+  services->parseSQLIntoCatalog(context, cat, sql_input_script, grt::DictRef(true));
   g_free(sql_input_script);
 
   return cat;
@@ -395,6 +400,7 @@ ValueRef DbMySQLScriptSync::sync_task(grt::StringRef) {
 
   db_mgmt_RdbmsRef rdbms = db_mgmt_RdbmsRef::cast_from(grt::GRT::get()->get("/wb/rdbmsMgmt/rdbms/0"));
 
+  // generate_alter() builds the script from the untouched org_cat, only the copies are normalized.
   db_mysql_CatalogRef org_cat_copy = db_mysql_CatalogRef::cast_from(grt::copy_object(org_cat));
   db_mysql_CatalogRef mod_cat_copy = db_mysql_CatalogRef::cast_from(grt::copy_object(mod_cat));
 
@@ -416,7 +422,8 @@ grt::StringRef DbMySQLScriptSync::generate_alter(db_mysql_CatalogRef org_cat, db
   omf.dontdiff_mask = 3;
   grt::NormalizedComparer normalizer;
   normalizer.init_omf(&omf);
-  std::shared_ptr<DiffChange> alter_change = diff_make(org_cat_copy, mod_cat_copy, &omf);
+  // Both catalogs are private copies which outlive the change tree, so added values needn't be cloned again.
+  std::shared_ptr<DiffChange> alter_change = diff_make(org_cat_copy, mod_cat_copy, &omf, true);
 
   // nothing changed
   if (!alter_change)
@@ -456,6 +463,89 @@ void DbMySQLScriptSync::save_sync_profile() {
         profile = bec::create_sync_profile(workbench_physical_ModelRef::cast_from(model_obj), _sync_profile_name,
                                            schema->name());
       bec::update_sync_profile_from_schema(profile, schema);
+
+      grt::DictRef fingerprints(profile->lastKnownFingerprints());
+      fingerprints.reset_entries();
+      std::map<std::string, std::map<std::string, std::string> >::const_iterator tables =
+        _table_fingerprints.find(schema->name());
+      if (tables != _table_fingerprints.end()) {
+        for (std::map<std::string, std::string>::const_iterator table = tables->second.begin();
+             table != tables->second.end(); ++table)
+          fingerprints.set(table->first, grt::StringRef(table->second));
+      }
+    }
+  }
+}
+
+/**
+ * Marks the tables of the model copy which are known to equal their server counterpart, so the diff skips them.
+ * A table is known to be equal when the fingerprints of both definitions, and of the options they are compared with,
+ * are those it was found equal with in the last synchronization. The fingerprints of all tables present on both
+ * sides are kept, forget_changed_tables() then drops those of tables that turn out to differ.
+ */
+void DbMySQLScriptSync::find_unchanged_tables(db_CatalogRef model_catalog, grt::DbObjectMatchAlterOmf &omf,
+                                              const grt::DictRef &db_options) {
+  _table_fingerprints.clear();
+  if (!_org_cat.is_valid())
+    return;
+
+  GrtObjectRef model_obj = model_catalog->owner();
+  bool has_profile = _sync_profile_name.is_valid() && model_obj.is_valid() &&
+                     workbench_physical_ModelRef::can_wrap(model_obj);
+  std::string options_fingerprint = bec::ddl_fingerprint(db_options.toString());
+
+  for (size_t i = 0; i < _mod_cat_copy->schemata().count(); ++i) {
+    db_SchemaRef schema(_mod_cat_copy->schemata()[i]);
+    db_SchemaRef server_schema(grt::find_named_object_in_list(_org_cat->schemata(), schema->name()));
+    if (!server_schema.is_valid())
+      continue;
+
+    grt::DictRef known_fingerprints;
+    if (has_profile) {
+      db_mgmt_SyncProfileRef profile = bec::get_sync_profile(workbench_physical_ModelRef::cast_from(model_obj),
+                                                             _sync_profile_name, schema->name());
+      if (profile.is_valid())
+        known_fingerprints = profile->lastKnownFingerprints();
+    }
+
+    std::map<std::string, db_TableRef> server_tables;
+    for (size_t t = 0; t < server_schema->tables().count(); ++t)
+      server_tables[server_schema->tables()[t]->name()] = server_schema->tables()[t];
+
+    size_t skipped = 0;
+    for (size_t t = 0; t < schema->tables().count(); ++t) {
+      db_TableRef table(schema->tables()[t]);
+      std::map<std::string, db_TableRef>::const_iterator server_table = server_tables.find(table->name());
+      if (server_table == server_tables.end())
+        continue;
+      std::string server_fingerprint = server_table->second->customData().get_string(SYNC_DDL_FINGERPRINT_KEY, "");
+      if (server_fingerprint.empty())
+        continue;
+
+      std::string fingerprint = bec::object_fingerprint(table) + "/" + server_fingerprint + "/" + options_fingerprint;
+      _table_fingerprints[schema->name()][table->name()] = fingerprint;
+      if (known_fingerprints.is_valid() && known_fingerprints.get_string(table->name(), "") == fingerprint) {
+        omf.known_equal_targets.insert(table->id());
+        ++skipped;
+      }
+    }
+    if (skipped > 0)
+      logInfo("%i tables of schema %s did not change since the last synchronization\n", (int)skipped,
+              schema->name().c_str());
+  }
+}
+
+// Drops the fingerprints of tables the diff generated changes for.
+void DbMySQLScriptSync::forget_changed_tables() {
+  for (size_t i = 0; i < _alter_object_list.count(); ++i) {
+    GrtObjectRef object(_alter_object_list[i]);
+    while (object.is_valid() && !db_TableRef::can_wrap(object))
+      object = object->owner();
+    if (object.is_valid() && object->owner().is_valid()) {
+      std::map<std::string, std::map<std::string, std::string> >::iterator tables =
+        _table_fingerprints.find(object->owner()->name());
+      if (tables != _table_fingerprints.end())
+        tables->second.erase(object->name());
     }
   }
 }
@@ -583,7 +673,9 @@ std::shared_ptr<DiffTreeBE> DbMySQLScriptSync::init_diff_tree(const std::vector<
 
   grt::NormalizedComparer comparer(db_opts);
   comparer.init_omf(&omf);
-  _alter_change = diff_make(_org_cat, _mod_cat_copy, &omf);
+  find_unchanged_tables(left_catalog, omf, db_opts);
+  // _mod_cat_copy is kept as long as _alter_change, so added values needn't be cloned again.
+  _alter_change = diff_make(_org_cat, _mod_cat_copy, &omf, true);
 
   DbMySQLImpl* diffsql_module = grt::GRT::get()->find_native_module<DbMySQLImpl>("DbMySQL");
 
@@ -604,6 +696,10 @@ std::shared_ptr<DiffTreeBE> DbMySQLScriptSync::init_diff_tree(const std::vector<
     diffsql_module->generateSQL(_org_cat, genoptions, _alter_change);
     // TODO: use this result in generate_diff_tree_report
   }
+  if (_alter_change && !diffsql_module)
+    _table_fingerprints.clear();
+  else
+    forget_changed_tables();
 
   // 3. build the tree
   return _diff_tree = std::shared_ptr<DiffTreeBE>(new ::DiffTreeBE(schemata, _mod_cat_copy, _org_cat, _alter_change));
@@ -30,6 +30,8 @@
 #include "db_mysql_validation_page.h"
 #include "grtdb/diff_dbobjectmatch.h"
 
+#include <map>
+
 class SynchronizeDifferencesPageBEInterface {
 protected:
   std::shared_ptr<DiffTreeBE> _diff_tree;
@@ -90,6 +92,12 @@ class WBPLUGINDBMYSQLBE_PUBLIC_FUNC DbMySQLScriptSync : public DbMySQLValidation
 
   std::shared_ptr<grt::DiffChange> _alter_change;
 
+  // Fingerprints of the tables found equal in the last diff, by schema and table name, saved with the sync profile.
+  std::map<std::string, std::map<std::string, std::string> > _table_fingerprints;
+
+  void find_unchanged_tables(db_CatalogRef model_catalog, grt::DbObjectMatchAlterOmf &omf,
+                             const grt::DictRef &db_options);
+  void forget_changed_tables();
   void sync_finished(grt::ValueRef res);
   grt::ValueRef sync_task(grt::StringRef);
   db_mysql_CatalogRef get_cat_from_file_or_tree(std::string filename, std::string &error_msg);
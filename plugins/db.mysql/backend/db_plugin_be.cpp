@@ -21,9 +21,17 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
 #include <ostream>
 #include <sstream>
 #include <memory>
+#include <thread>
 
 #include "db_plugin_be.h"
 #include "grtsqlparser/sql_facade.h"
@@ -33,11 +41,17 @@
 #include "db.mysql/src/module_db_mysql.h"
 #include "base/log.h"
 #include "grtsqlparser/mysql_parser_services.h"
+#include "grtdb/sync_profile.h"
 
 #include <glib.h>
 
 DEFAULT_LOG_DOMAIN("Db Plugin")
 
+#define PARALLEL_SCRIPT_CONNECTIONS 4 // Additional connections used to create tables in parallel.
+#define PARALLEL_SCRIPT_MIN_JOBS 16   // Fewer tables in a row are not worth opening the connections.
+#define PARALLEL_FETCH_CONNECTIONS 4  // Additional connections used to fetch object DDL in parallel.
+#define PARALLEL_FETCH_MIN_OBJECTS 16 // Fewer objects are fetched with one query per schema.
+
 void Db_plugin::grtm(bool reveng) {
   _doc = workbench_DocumentRef::cast_from(grt::GRT::get()->get("/wb/doc"));
 
@@ -269,13 +283,13 @@ void Db_plugin::load_db_objects(Db_object_type db_object_type) {
 
     if (!schema_name.empty()) {
       try {
-        std::auto_ptr<sql::ResultSet> rset(dbc_meta->getSchemaObjects("", schema_name, db_object_type_name));
+        // Only the names, the DDL is fetched for all schemata at once afterwards.
+        std::auto_ptr<sql::ResultSet> rset(dbc_meta->getSchemaObjects("", schema_name, db_object_type_name, false));
         total_objects = (float)rset->rowsCount();
         while (rset->next()) {
           Db_obj_handle db_obj;
           db_obj.schema = schema_name;
           db_obj.name = rset->getString("name");
-          db_obj.ddl = rset->getString("ddl");
           setup->all.push_back(db_obj);
 
           // prefixed by schema name
@@ -299,6 +313,8 @@ void Db_plugin::load_db_objects(Db_object_type db_object_type) {
     grt::GRT::get()->send_info(base::strfmt("    %i items from %s", count, schema_name.c_str()));
   }
 
+  fetch_ddl(db_object_type, dbc_conn);
+
   // copy from temp list (used for performance optimization)
   setup->all.reserve(db_objects.size());
   std::copy(db_objects.begin(), db_objects.end(), setup->all.begin());
@@ -312,6 +328,121 @@ void Db_plugin::load_db_objects(Db_object_type db_object_type) {
   grt::GRT::get()->send_info("OK");
 }
 
+/**
+ * Few objects are fetched as before, with one query per schema. For more the round trip of each SHOW CREATE
+ * statement dominates, so they are fetched one by one over several connections at once.
+ */
+void Db_plugin::fetch_ddl(Db_object_type db_object_type, sql::ConnectionWrapper &dbc_conn) {
+  Db_objects &objects = db_objects_setup_by_type(db_object_type)->all;
+  std::string db_object_type_name = db_objects_type_to_string(db_object_type);
+
+  // Routines of different types may have the same name, the rows for a name are assigned in the order listed.
+  std::vector<std::vector<size_t> > jobs;
+  {
+    std::map<std::pair<std::string, std::string>, size_t> job_of_name;
+    for (size_t i = 0; i < objects.size(); ++i) {
+      std::pair<std::map<std::pair<std::string, std::string>, size_t>::iterator, bool> job =
+        job_of_name.insert(std::make_pair(std::make_pair(objects[i].schema, objects[i].name), jobs.size()));
+      if (job.second)
+        jobs.push_back(std::vector<size_t>());
+      jobs[job.first->second].push_back(i);
+    }
+  }
+
+  std::vector<sql::ConnectionWrapper> connections(1, dbc_conn);
+  if (objects.size() >= PARALLEL_FETCH_MIN_OBJECTS) {
+    while (connections.size() < PARALLEL_FETCH_CONNECTIONS + 1) {
+      try {
+        connections.push_back(db_conn()->get_dbc_connection());
+      } catch (std::exception &exc) {
+        logWarning("Could not open an additional connection to fetch objects: %s\n", exc.what());
+        break;
+      }
+    }
+  }
+
+  if (connections.size() == 1) {
+    sql::DatabaseMetaData *dbc_meta(dbc_conn->getMetaData());
+    size_t job = 0;
+    for (std::vector<std::string>::const_iterator iter = _schemata_selection.begin();
+         iter != _schemata_selection.end(); ++iter) {
+      if (job == jobs.size() || objects[jobs[job].front()].schema != *iter)
+        continue;
+
+      std::map<std::string, size_t> job_of_name;
+      for (; job < jobs.size() && objects[jobs[job].front()].schema == *iter; ++job)
+        job_of_name[objects[jobs[job].front()].name] = job;
+
+      try {
+        std::map<size_t, size_t> assigned;
+        std::auto_ptr<sql::ResultSet> rset(dbc_meta->getSchemaObjects("", *iter, db_object_type_name));
+        while (rset->next()) {
+          std::map<std::string, size_t>::const_iterator name = job_of_name.find(rset->getString("name"));
+          if (name != job_of_name.end() && assigned[name->second] < jobs[name->second].size())
+            objects[jobs[name->second][assigned[name->second]++]].ddl = rset->getString("ddl");
+        }
+      } catch (std::exception &e) {
+        grt::GRT::get()->send_info(base::strfmt("Failed to fetch %s objects from %s: %s",
+                                                db_object_type_name.c_str(), iter->c_str(), e.what()));
+        logError("Failed to fetch %s objects from %s: %s", db_object_type_name.c_str(), iter->c_str(), e.what());
+      }
+    }
+    return;
+  }
+
+  grt::GRT::get()->send_info(base::strfmt("Fetching %s definitions over %i connections.", db_object_type_name.c_str(),
+                                          (int)connections.size()));
+
+  std::atomic<size_t> next_job(0);
+  std::atomic<size_t> jobs_done(0);
+  std::atomic<size_t> workers_finished(0);
+  std::mutex errors_mutex;
+  std::vector<std::string> errors;
+
+  // Each worker writes the DDL of the objects of its jobs only, errors and progress are reported from this thread.
+  std::vector<std::thread> threads;
+  for (size_t w = 0; w < connections.size(); ++w) {
+    threads.push_back(std::thread([&, w]() {
+      sql::DatabaseMetaData *dbc_meta = nullptr;
+      try {
+        dbc_meta = connections[w]->getMetaData();
+      } catch (std::exception &e) {
+        // The other workers take over the jobs.
+        std::lock_guard<std::mutex> lock(errors_mutex);
+        errors.push_back(base::strfmt("Failed to fetch %s definitions: %s", db_object_type_name.c_str(), e.what()));
+      }
+      for (size_t job = dbc_meta ? next_job++ : jobs.size(); job < jobs.size(); job = next_job++) {
+        const Db_obj_handle &first = objects[jobs[job].front()];
+        try {
+          std::auto_ptr<sql::ResultSet> rset(
+            dbc_meta->getSchemaObjects("", first.schema, db_object_type_name, true, first.name));
+          for (size_t i = 0; i < jobs[job].size() && rset->next(); ++i)
+            objects[jobs[job][i]].ddl = rset->getString("ddl");
+        } catch (std::exception &e) {
+          std::lock_guard<std::mutex> lock(errors_mutex);
+          errors.push_back(base::strfmt("Failed to fetch %s %s.%s: %s", db_object_type_name.c_str(),
+                                        first.schema.c_str(), first.name.c_str(), e.what()));
+        }
+        ++jobs_done;
+      }
+      ++workers_finished;
+    }));
+  }
+
+  while (workers_finished < threads.size()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    grt::GRT::get()->send_progress((float)jobs_done / jobs.size(),
+                                   std::string("Fetching ").append(db_object_type_name).append(" definitions."));
+  }
+  for (size_t w = 0; w < threads.size(); ++w)
+    threads[w].join();
+
+  for (std::vector<std::string>::const_iterator error = errors.begin(); error != errors.end(); ++error) {
+    grt::GRT::get()->send_info(*error);
+    logError("%s\n", error->c_str());
+  }
+}
+
 /** read_back_view_ddl()
 
  Load back VIEW code from the database for everything we created, so that we know how it was normalized.
@@ -418,7 +549,7 @@ bool Db_plugin::validate_db_objects_selection(std::list<std::string> *messages)
   return true;
 }
 
-void Db_plugin::dump_ddl(Db_object_type db_object_type, std::string &sql_script) {
+void Db_plugin::dump_ddl(Db_object_type db_object_type, std::string &sql_script, const std::string &schema) {
   std::string _non_std_sql_delimiter;
   {
     SqlFacade::Ref sql_facade = SqlFacade::instance_for_rdbms(selected_rdbms());
@@ -431,6 +562,8 @@ void Db_plugin::dump_ddl(Db_object_type db_object_type, std::string &sql_script)
     bec::GrtStringListModel::Items_ids items_ids = setup->selection.items_ids();
     for (size_t n = 0, count = items_ids.size(); n < count; ++n) {
       Db_obj_handle &db_obj = setup->all[items_ids[n]];
+      if (!schema.empty() && db_obj.schema != schema)
+        continue;
 
       sql_script.append("USE `").append(db_obj.schema).append("`;\n");
 
@@ -473,6 +606,27 @@ void Db_plugin::dump_ddl(std::string &sql_script) {
   dump_ddl(dbotTrigger, sql_script);
 }
 
+/**
+ * Tells if any selected table has a foreign key to a table in another schema. SHOW CREATE TABLE qualifies the
+ * referenced table with its schema only in that case.
+ */
+bool Db_plugin::tables_reference_other_schemas() {
+  if (!_tables.activated)
+    return false;
+
+  bec::GrtStringListModel::Items_ids items_ids = _tables.selection.items_ids();
+  for (size_t n = 0, count = items_ids.size(); n < count; ++n) {
+    const std::string &ddl = _tables.all[items_ids[n]].ddl;
+    for (size_t pos = ddl.find("REFERENCES `"); pos != std::string::npos; pos = ddl.find("REFERENCES `", pos)) {
+      pos += 12;
+      size_t end = ddl.find('`', pos);
+      if (end != std::string::npos && ddl.compare(end, 3, "`.`") == 0)
+        return true;
+    }
+  }
+  return false;
+}
+
 db_CatalogRef Db_plugin::db_catalog() {
   db_CatalogRef mod_cat = model_catalog();
 
@@ -481,9 +635,6 @@ db_CatalogRef Db_plugin::db_catalog() {
 
   workbench_physical_ModelRef pm = workbench_physical_ModelRef::cast_from(mod_cat->owner());
 
-  std::string sql_input_script;
-  dump_ddl(sql_input_script);
-
   db_mysql_CatalogRef catalog = grt::GRT::get()->create_object<db_mysql_Catalog>(mod_cat.get_metaclass()->name());
 
 
@@ -502,19 +653,299 @@ db_CatalogRef Db_plugin::db_catalog() {
   auto services = parsers::MySQLParserServices::get();
   auto context = services->createParserContext(pm->rdbms()->characterSets(), version, sqlMode.c_str(),
     _db_options.get_int("CaseSensitive", 1) != 0);
-  auto errorCount = services->parseSQLIntoCatalog(context, catalog, sql_input_script, parse_options);
+  size_t errorCount = 0;
+
+  // Parse one schema at a time, so only the DDL of that schema is held as script and parsed statements.
+  // References to tables in other schemas are only resolved when all schemata are parsed together.
+  if (_schemata_selection.size() > 1 && !tables_reference_other_schemas()) {
+    for (std::vector<std::string>::const_iterator iter = _schemata_selection.begin();
+         iter != _schemata_selection.end(); ++iter) {
+      std::string sql_input_script;
+      sql_input_script.append(_schemata_ddl[*iter]).append(";\n\n");
+      dump_ddl(dbotTable, sql_input_script, *iter);
+      dump_ddl(dbotView, sql_input_script, *iter);
+      dump_ddl(dbotRoutine, sql_input_script, *iter);
+      dump_ddl(dbotTrigger, sql_input_script, *iter);
+
+      errorCount += services->parseSQLIntoCatalog(context, catalog, sql_input_script, parse_options);
+    }
+  } else {
+    std::string sql_input_script;
+    dump_ddl(sql_input_script);
+    errorCount = services->parseSQLIntoCatalog(context, catalog, sql_input_script, parse_options);
+  }
 
   if (errorCount != 0) {
     logError("There was an error while parsing the DDL retrieved from the server.\n");
   }
 
+  set_ddl_fingerprints(catalog);
+
   return catalog;
 }
 
+/**
+ * Stores the fingerprint of the fetched DDL in each parsed table, so synchronization can tell the table didn't change
+ * on the server since it was last found equal to the model. Triggers are part of the table in the catalog but not of
+ * its CREATE TABLE statement, so their definitions are included.
+ */
+void Db_plugin::set_ddl_fingerprints(db_CatalogRef catalog) {
+  if (!_tables.activated)
+    return;
+
+  std::map<std::string, std::map<std::string, db_TableRef> > tables;
+  for (size_t i = 0; i < catalog->schemata().count(); ++i) {
+    db_SchemaRef schema(catalog->schemata()[i]);
+    std::map<std::string, db_TableRef> &schema_tables(tables[schema->name()]);
+    for (size_t t = 0; t < schema->tables().count(); ++t)
+      schema_tables[schema->tables()[t]->name()] = schema->tables()[t];
+  }
+
+  bec::GrtStringListModel::Items_ids items_ids = _tables.selection.items_ids();
+  for (size_t n = 0, count = items_ids.size(); n < count; ++n) {
+    const Db_obj_handle &db_obj = _tables.all[items_ids[n]];
+    std::map<std::string, db_TableRef>::const_iterator table = tables[db_obj.schema].find(db_obj.name);
+    if (table == tables[db_obj.schema].end())
+      continue;
+
+    std::string ddl(db_obj.ddl);
+    for (size_t t = 0; t < table->second->triggers().count(); ++t)
+      ddl.append("\n").append(table->second->triggers()[t]->sqlDefinition());
+    table->second->customData().set(SYNC_DDL_FINGERPRINT_KEY, grt::StringRef(bec::ddl_fingerprint(ddl)));
+  }
+}
+
 void Db_plugin::set_task_proc() {
   _task_proc_cb = std::bind(&Db_plugin::apply_script_to_db, this);
 }
 
+//--------------------------------------------------------------------------------------------------
+
+// The first words of a statement in upper case, leading comments skipped.
+static std::string statement_head(const std::string &statement, int words) {
+  std::string head;
+  const char *p = statement.c_str();
+  while (*p && words > 0) {
+    while (*p && isspace((unsigned char)*p))
+      ++p;
+    if (*p == '#' || (p[0] == '-' && p[1] == '-' && (p[2] == 0 || isspace((unsigned char)p[2])))) {
+      while (*p && *p != '\n')
+        ++p;
+      continue;
+    }
+    if (p[0] == '/' && p[1] == '*') {
+      const char *end = strstr(p + 2, "*/");
+      p = end ? end + 2 : p + strlen(p);
+      continue;
+    }
+
+    const char *start = p;
+    while (*p && (isalnum((unsigned char)*p) || *p == '_'))
+      ++p;
+    if (p == start)
+      break;
+    if (!head.empty())
+      head.append(" ");
+    head.append(base::toupper(std::string(start, p)));
+    --words;
+  }
+  return head;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+struct ScriptSegment {
+  bool parallel;
+  std::vector<std::vector<std::string> > jobs; // Each job runs in order on one connection.
+
+  ScriptSegment(bool parallel_) : parallel(parallel_) {
+  }
+};
+
+/**
+ * Splits the script into runs of table statements, which don't depend on each other, and the statements in
+ * between, which must run in script order. Tables are independent only while foreign key checks are off, which
+ * the generated scripts ensure at their top. A CREATE TABLE joins the DROP TABLE before it and SHOW WARNINGS
+ * the statement before it, so these stay on the same connection.
+ */
+static bool plan_script(const std::list<std::string> &statements, std::vector<ScriptSegment> &segments) {
+  bool fk_checks_off = false;
+  bool has_parallel_run = false;
+  std::string last_head;
+
+  for (std::list<std::string>::const_iterator i = statements.begin(); i != statements.end(); ++i) {
+    std::string head = statement_head(*i, 2);
+    bool table_statement = fk_checks_off && (head == "CREATE TABLE" || head == "DROP TABLE");
+    bool warnings = head == "SHOW WARNINGS";
+
+    if (head.substr(0, head.find(' ')) == "SET") {
+      std::string flat = base::toupper(*i);
+      flat.erase(std::remove_if(flat.begin(), flat.end(), ::isspace), flat.end());
+      if (flat.find("FOREIGN_KEY_CHECKS=0") != std::string::npos)
+        fk_checks_off = true;
+      else if (flat.find("FOREIGN_KEY_CHECKS=") != std::string::npos)
+        fk_checks_off = false;
+    }
+
+    if (table_statement || (warnings && !segments.empty() && segments.back().parallel)) {
+      if (segments.empty() || !segments.back().parallel)
+        segments.push_back(ScriptSegment(true));
+      ScriptSegment &segment = segments.back();
+      if (segment.jobs.empty() || !(warnings || (head == "CREATE TABLE" && last_head == "DROP TABLE")))
+        segment.jobs.push_back(std::vector<std::string>());
+      segment.jobs.back().push_back(*i);
+      if (segment.jobs.size() >= PARALLEL_SCRIPT_MIN_JOBS)
+        has_parallel_run = true;
+    } else {
+      if (segments.empty() || segments.back().parallel) {
+        segments.push_back(ScriptSegment(false));
+        segments.back().jobs.push_back(std::vector<std::string>());
+      }
+      segments.back().jobs.back().push_back(*i);
+    }
+
+    if (!warnings)
+      last_head = head;
+  }
+
+  return has_parallel_run;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Runs the script like SqlBatchExec does, except that long runs of table statements are spread over additional
+ * connections, saving most of the round trip time when deploying large models. Before getting work each
+ * connection repeats the session settings (SET and USE statements) the script made so far.
+ * Returns false without executing anything if the script has no such run.
+ */
+bool Db_plugin::apply_script_in_parallel(sql::Statement *stmt, const std::list<std::string> &statements) {
+  std::vector<ScriptSegment> segments;
+  if (!plan_script(statements, segments))
+    return false;
+
+  std::vector<sql::ConnectionWrapper> connections;
+  std::vector<std::shared_ptr<sql::Statement> > worker_statements;
+  std::vector<size_t> synced; // Number of session statements each connection repeated.
+  std::vector<std::string> session;
+
+  long success_count = 0;
+  long error_count = 0;
+  size_t done = 0;
+  const float total = (float)statements.size();
+
+  // Errors and progress are only reported from this thread.
+  auto run_statement = [&](const std::string &statement) -> bool {
+    try {
+      if (stmt->execute(statement))
+        std::auto_ptr<sql::ResultSet> rs(stmt->getResultSet());
+      ++success_count;
+
+      std::string head = statement_head(statement, 1);
+      if (head == "SET" || head == "USE")
+        session.push_back(statement);
+    } catch (sql::SQLException &e) {
+      ++error_count;
+      process_sql_script_error(e.getErrorCode(), e.what(), statement);
+    }
+    process_sql_script_progress(++done / total);
+    return error_count == 0;
+  };
+
+  for (std::vector<ScriptSegment>::iterator segment = segments.begin();
+       segment != segments.end() && error_count == 0; ++segment) {
+    if (segment->parallel && segment->jobs.size() >= PARALLEL_SCRIPT_MIN_JOBS) {
+      while (connections.size() < PARALLEL_SCRIPT_CONNECTIONS) {
+        try {
+          sql::ConnectionWrapper connection = db_conn()->get_dbc_connection();
+          worker_statements.push_back(std::shared_ptr<sql::Statement>(connection->createStatement()));
+          connections.push_back(connection);
+          synced.push_back(0);
+        } catch (std::exception &exc) {
+          logWarning("Could not open an additional connection to apply the script: %s\n", exc.what());
+          break;
+        }
+      }
+    }
+
+    if (!segment->parallel || segment->jobs.size() < PARALLEL_SCRIPT_MIN_JOBS || worker_statements.empty()) {
+      for (size_t job = 0; job < segment->jobs.size() && error_count == 0; ++job) {
+        for (size_t i = 0; i < segment->jobs[job].size(); ++i) {
+          if (!run_statement(segment->jobs[job][i]))
+            break;
+        }
+      }
+      continue;
+    }
+
+    struct ScriptError {
+      int code;
+      std::string message;
+      std::string statement;
+    };
+
+    std::atomic<size_t> next_job(0);
+    std::atomic<size_t> statements_done(0);
+    std::atomic<long> statements_succeeded(0);
+    std::atomic<size_t> workers_finished(0);
+    std::atomic<bool> failed(false);
+    std::mutex errors_mutex;
+    std::vector<ScriptError> errors;
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < worker_statements.size(); ++w) {
+      threads.push_back(std::thread([&, w]() {
+        sql::Statement *worker = worker_statements[w].get();
+        std::string current;
+        try {
+          for (; synced[w] < session.size(); ++synced[w]) {
+            current = session[synced[w]];
+            worker->execute(current);
+          }
+
+          size_t job;
+          while (!failed && (job = next_job++) < segment->jobs.size()) {
+            for (size_t i = 0; i < segment->jobs[job].size(); ++i) {
+              current = segment->jobs[job][i];
+              if (worker->execute(current))
+                std::auto_ptr<sql::ResultSet> rs(worker->getResultSet());
+              ++statements_succeeded;
+              ++statements_done;
+            }
+          }
+        } catch (sql::SQLException &e) {
+          failed = true;
+          ScriptError error;
+          error.code = e.getErrorCode();
+          error.message = e.what();
+          error.statement = current;
+          std::lock_guard<std::mutex> lock(errors_mutex);
+          errors.push_back(error);
+        }
+        ++workers_finished;
+      }));
+    }
+
+    while (workers_finished < threads.size()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      process_sql_script_progress((done + statements_done) / total);
+    }
+    for (size_t w = 0; w < threads.size(); ++w)
+      threads[w].join();
+
+    done += statements_done;
+    success_count += statements_succeeded;
+    error_count += (long)errors.size();
+    for (size_t i = 0; i < errors.size(); ++i)
+      process_sql_script_error(errors[i].code, errors[i].message, errors[i].statement);
+  }
+
+  process_sql_script_statistics(success_count, error_count);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 grt::StringRef Db_plugin::apply_script_to_db() {
   sql::ConnectionWrapper conn = db_conn()->get_dbc_connection();
   std::auto_ptr<sql::Statement> stmt(conn->createStatement());
@@ -525,7 +956,11 @@ grt::StringRef Db_plugin::apply_script_to_db() {
   SqlFacade::Ref sql_splitter = SqlFacade::instance_for_rdbms(selected_rdbms());
   sql_splitter->splitSqlScript(_sql_script, statements);
 
+  if (apply_script_in_parallel(stmt.get(), statements))
+    return grt::StringRef(_("The SQL script was successfully applied to server"));
+
   sql::SqlBatchExec sql_batch_exec;
+  sql_batch_exec.batch_statements(true);
 
   sql_batch_exec.error_cb(std::bind(&Db_plugin::process_sql_script_error, this, std::placeholders::_1,
                                     std::placeholders::_2, std::placeholders::_3));
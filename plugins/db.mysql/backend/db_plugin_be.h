@@ -58,6 +58,7 @@ public:
 private:
   db_mgmt_RdbmsRef selected_rdbms();
   std::string task_desc();
+  bool apply_script_in_parallel(sql::Statement *stmt, const std::list<std::string> &statements);
 
 protected:
   void set_task_proc();
@@ -114,7 +115,12 @@ protected:
   Db_objects_setup *db_objects_setup_by_type(Db_object_type db_object_type);
   const char *db_objects_type_to_string(Db_object_type db_object_type);
 
-  void dump_ddl(Db_object_type db_object_type, std::string &sql_script);
+  // Appends the DDL of the selected objects, only those of the given schema if not empty.
+  void dump_ddl(Db_object_type db_object_type, std::string &sql_script, const std::string &schema = "");
+  bool tables_reference_other_schemas();
+  // Fetches the DDL of the objects load_db_objects() listed.
+  void fetch_ddl(Db_object_type db_object_type, sql::ConnectionWrapper &dbc_conn);
+  void set_ddl_fingerprints(db_CatalogRef catalog);
 
   int process_sql_script_error(long long err_no, const std::string &err_msg, const std::string &statement);
   int process_sql_script_progress(float progress_state);
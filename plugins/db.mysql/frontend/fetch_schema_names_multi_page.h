@@ -22,6 +22,7 @@
  */
 
 #include "grtui/wizard_progress_page.h"
+#include "grtsqlparser/mysql_parser_services.h"
 
 class FetchSchemaNamesSourceTargetProgressPage : public WizardProgressPage {
 public:
@@ -139,8 +140,11 @@ protected:
       throw std::runtime_error(file_error_msg);
     }
 
-    SqlFacade::Ref sql_parser = SqlFacade::instance_for_rdbms(pm->rdbms());
-    sql_parser->parseSqlScriptString(cat, sql_input_script);
+    parsers::MySQLParserServices::Ref services = parsers::MySQLParserServices::get();
+    parsers::MySQLParserContext::Ref context =
+      services->createParserContext(pm->rdbms()->characterSets(), cat->version(),
+                                    bec::GRTManager::get()->get_app_option_string("SqlMode"), true);
+    services->parseSQLIntoCatalog(context, cat, sql_input_script, grt::DictRef(true));
     g_free(sql_input_script);
 
     return cat;
@@ -33,7 +33,7 @@ void update_numeric(mforms::TextEntry& te) {
 }
 
 DBSearchFilterPanel::DBSearchFilterPanel()
-  : Box(false), _search_box(true), _filter_tree(mforms::TreeNoHeader), _limits_box(true) {
+  : Box(false), _search_box(true), _filter_tree(mforms::TreeNoHeader), _limits_box(true), _planning_box(true) {
   set_spacing(12);
 
   _search_box.set_spacing(8);
@@ -71,6 +71,14 @@ DBSearchFilterPanel::DBSearchFilterPanel()
   _limits_box.add(&_limit_total, false, true);
   _limit_total.signal_changed()->connect(std::bind(update_numeric, std::ref(_limit_total)));
   _limit_total.set_value("100000");
+  _connections_hint.set_text("Connections");
+  _connections_hint.set_text_align(mforms::MiddleRight);
+  _connections.set_size(40, -1);
+  _connections.set_tooltip("Number of connections searching tables in parallel.");
+  _limits_box.add(&_connections_hint, false, true);
+  _limits_box.add(&_connections, false, true);
+  _connections.signal_changed()->connect(std::bind(update_numeric, std::ref(_connections)));
+  _connections.set_value("4");
 
   _search_all_type_check.set_text("Search columns of all types");
   _search_all_type_check.set_tooltip(
@@ -82,6 +90,24 @@ DBSearchFilterPanel::DBSearchFilterPanel()
   _search_button.set_size(120, -1);
   _limits_box.add(&_search_button, false, true);
   add(&_limits_box, false, true);
+
+  _planning_box.set_spacing(4);
+  _use_fulltext_check.set_text("Use FULLTEXT indexes");
+  _use_fulltext_check.set_tooltip(
+    "If checked, CONTAINS searches use MATCH ... AGAINST on columns with a FULLTEXT index of their own. That is much "
+    "faster than scanning the table, but only finds the search text as whole words.");
+  _planning_box.add(&_use_fulltext_check, false, true);
+  _max_scan_rows_hint.set_text("Skip tables with more rows to examine than");
+  _max_scan_rows_hint.set_text_align(mforms::MiddleRight);
+  _planning_box.add(&_max_scan_rows_hint, false, true);
+  _max_scan_rows.set_size(100, -1);
+  _max_scan_rows.set_tooltip(
+    "Each search query is checked with EXPLAIN first. Tables where the server expects to examine more rows are "
+    "listed as skipped, together with their query. 0 searches all tables.");
+  _max_scan_rows.signal_changed()->connect(std::bind(update_numeric, std::ref(_max_scan_rows)));
+  _max_scan_rows.set_value("0");
+  _planning_box.add(&_max_scan_rows, false, true);
+  add(&_planning_box, false, true);
   //  add(&_search_all_type_check, false, true);
   //  _exclude_check.set_text("Invert table selection (search all tables except selected)");
   //  add(&_exclude_check, false, true);
@@ -114,6 +140,9 @@ void DBSearchFilterPanel::set_searching(bool flag) {
   _filter_selector.set_enabled(!flag);
   _limit_table.set_enabled(!flag);
   _limit_total.set_enabled(!flag);
+  _connections.set_enabled(!flag);
+  _use_fulltext_check.set_enabled(!flag);
+  _max_scan_rows.set_enabled(!flag);
 
   if (flag)
     _search_button.set_text("Stop");
@@ -24,6 +24,7 @@
 #ifndef _DB_SEARCH_FILTER_PANEL_H_
 #define _DB_SEARCH_FILTER_PANEL_H_
 #include <mforms/mforms.h>
+#include "base/string_utilities.h"
 
 class DBSearchFilterPanel : public mforms::Box {
 private:
@@ -40,7 +41,13 @@ private:
   mforms::TextEntry _limit_table;
   mforms::Label _limit_total_hint;
   mforms::TextEntry _limit_total;
+  mforms::Label _connections_hint;
+  mforms::TextEntry _connections;
   mforms::Button _search_button;
+  mforms::Box _planning_box;
+  mforms::CheckBox _use_fulltext_check;
+  mforms::Label _max_scan_rows_hint;
+  mforms::TextEntry _max_scan_rows;
 
 public:
   DBSearchFilterPanel();
@@ -62,6 +69,30 @@ public:
     _limit_total.set_value(i);
   }
 
+  int get_connections() {
+    return atoi(_connections.get_string_value().c_str());
+  }
+
+  void set_connections(const std::string &i) {
+    _connections.set_value(i);
+  }
+
+  bool use_fulltext() {
+    return _use_fulltext_check.get_active();
+  }
+
+  void set_use_fulltext(bool flag) {
+    _use_fulltext_check.set_active(flag);
+  }
+
+  int64_t get_max_scan_rows() {
+    return base::atoi<int64_t>(_max_scan_rows.get_string_value(), (int64_t)0);
+  }
+
+  void set_max_scan_rows(const std::string &i) {
+    _max_scan_rows.set_value(i);
+  }
+
   bool search_all_types() {
     return _search_all_type_check.get_active();
   }
@@ -22,7 +22,13 @@
  */
 
 #include "DbSearchPanel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include "grtui/grt_wizard_form.h"
 #include "grtui/connection_page.h"
 #include "grt/grt_string_list_model.h"
@@ -50,6 +56,14 @@ bool is_string_type(const std::string& type) {
   return chartypes.find(searchtype) != chartypes.end();
 };
 
+bool is_text_type(const std::string& type) {
+  // The string types that compare as characters already, so searching them needs no CAST.
+  static const std::set<std::string> texttypes = {"char",       "varchar",  "tinytext", "text",
+                                                  "mediumtext", "longtext", "enum",     "set"};
+  std::string searchtype = type.substr(0, type.find("("));
+  return texttypes.find(searchtype) != texttypes.end();
+};
+
 bool is_numeric_type(const std::string& type) {
   /*
   MySQL supports all standard SQL numeric data types. These types include the exact numeric data types
@@ -82,10 +96,22 @@ public:
     std::list<std::string> keys;
     std::string query;
     column_data_t data;
+    std::string note; // Shown instead of the match count, if set.
+  };
+
+  // What to search in a table, gathered before searching.
+  struct TablePlan {
+    std::string schema;
+    std::string table;
+    std::list<std::string> pk_columns;
+    std::list<std::string> select_columns; // The first one is the key shown for a match, "" if there is no PK.
+    bool match_PK = false;
+    std::set<std::string> text_columns;     // Compared without CAST.
+    std::set<std::string> fulltext_columns; // Have a FULLTEXT index of their own.
   };
 
 private:
-  sql::ConnectionWrapper _db_conn;
+  std::vector<sql::ConnectionWrapper> _db_conns; // Tables are searched in parallel, one at a time per connection.
   grt::StringListRef _filter_list;
   std::string _search_keyword;
   std::string _state;
@@ -93,31 +119,43 @@ private:
   SearchMode _search_mode;
   int _limit_total;
   int _limt_per_table;
-  int _limit_counter;
+  int _limit_counter; // Rows left of the total limit, -1 if there is none.
+  std::vector<TablePlan> _tables;
+  size_t _next_table;
+  int _tables_in_flight;
+  std::exception_ptr _error;
+  std::mutex _limit_mutex; // Protects the members above, from _limit_counter on.
+  std::condition_variable _limit_condition;
   std::vector<SearchResultEntry> _search_result;
   volatile bool _working;
   volatile bool _stop;
   volatile bool _starting;
   volatile bool _paused;
   bool _invert;
-  int _searched_tables;
-  int _matched_rows;
+  std::atomic<int> _searched_tables;
+  std::atomic<int> _matched_rows;
   std::string _cast_to;
   int _search_data_type;
+  bool _use_fulltext;
+  int64_t _max_scan_rows; // Tables for which EXPLAIN estimates more rows to examine are skipped, 0 for no limit.
   base::Mutex _search_result_mutex;
   base::Mutex _pause_mutex;
+  base::Mutex _state_mutex;
 
 protected:
-  typedef std::function<void(const std::string&, const std::string&, const std::list<std::string>&,
-                             const std::list<std::string>&, const std::string&, const bool match_PK)>
-    select_func_t;
+  // Searches one table on the given connection and returns the number of rows that count against the total limit.
+  typedef std::function<int(sql::Connection*, const TablePlan&, const std::string&)> select_func_t;
   void run(select_func_t select_func);
-  void select_data(const std::string& schema_name, const std::string& table_name,
-                   const std::list<std::string>& pk_columns, const std::list<std::string>& select_columns,
-                   const std::string& limit_clause, const bool match_PK);
-  void count_data(const std::string& schema_name, const std::string& table_name,
-                  const std::list<std::string>& pk_columns, const std::list<std::string>& select_columns,
-                  const std::string& limit_clause, const bool match_PK);
+  void search_tables(sql::Connection* connection, select_func_t select_func);
+  void plan_tables();
+  int search_table(sql::Connection* connection, const TablePlan& plan, int limit, select_func_t select_func);
+  int select_data(sql::Connection* connection, const TablePlan& plan, const std::string& limit_clause);
+  int count_data(sql::Connection* connection, const TablePlan& plan, const std::string& limit_clause);
+  bool skip_expensive_query(sql::Connection* connection, const TablePlan& plan, const std::string& query);
+  void set_state(const std::string& state) {
+    base::MutexLock lock(_state_mutex);
+    _state = state;
+  }
 
 public:
   /*
@@ -127,10 +165,11 @@ public:
           _search_result_mutex = g_mutex_new();
       };
     */
-  DBSearch(sql::ConnectionWrapper connection, const std::string& search_keyword, const grt::StringListRef& filter_list,
-           const SearchMode search_mode, const int limit_total, const int limt_per_table, const bool invert,
-           const int search_data_type, const std::string cast_to)
-    : _db_conn(connection),
+  DBSearch(const std::vector<sql::ConnectionWrapper>& connections, const std::string& search_keyword,
+           const grt::StringListRef& filter_list, const SearchMode search_mode, const int limit_total,
+           const int limt_per_table, const bool invert, const int search_data_type, const std::string cast_to,
+           const bool use_fulltext, const int64_t max_scan_rows)
+    : _db_conns(connections),
       _filter_list(filter_list),
       _search_keyword(search_keyword),
       _state("Starting"),
@@ -139,6 +178,8 @@ public:
       _limit_total(limit_total),
       _limt_per_table(limt_per_table),
       _limit_counter(0),
+      _next_table(0),
+      _tables_in_flight(0),
       _working(false),
       _stop(false),
       _starting(false),
@@ -147,7 +188,9 @@ public:
       _searched_tables(0),
       _matched_rows(0),
       _cast_to(cast_to),
-      _search_data_type(search_data_type) {
+      _search_data_type(search_data_type),
+      _use_fulltext(use_fulltext),
+      _max_scan_rows(max_scan_rows) {
   }
 
   ~DBSearch() {
@@ -182,7 +225,8 @@ public:
   float get_progress() const {
     return _progress;
   }
-  std::string get_state() const {
+  std::string get_state() {
+    base::MutexLock lock(_state_mutex);
     return _state;
   }
   const std::vector<SearchResultEntry>& search_results() const {
@@ -201,13 +245,9 @@ public:
     return _working;
   }
   void stop();
-  std::string build_where(const std::string& col, const std::string& data) const;
-  std::string build_select_query(const std::string& schema, const std::string& table,
-                                 const std::list<std::string>& columns, const std::string& limit,
-                                 const bool match_PK) const;
-  std::string build_count_query(const std::string& schema, const std::string& table,
-                                const std::list<std::string>& columns, const std::string& limit,
-                                const bool match_PK) const;
+  std::string build_where(const TablePlan& plan, const std::string& col, const std::string& data) const;
+  std::string build_select_query(const TablePlan& plan, const std::string& limit) const;
+  std::string build_count_query(const TablePlan& plan, const std::string& limit) const;
   void search();
   void count();
 };
@@ -217,18 +257,31 @@ void DBSearch::stop() {
     toggle_pause();
   if (!_working)
     return;
-  _stop = true;
+  {
+    std::lock_guard<std::mutex> lock(_limit_mutex);
+    _stop = true;
+  }
+  _limit_condition.notify_all();
   while (_working)
     ;
-  _state = "Cancelled";
+  set_state("Cancelled");
 }
 
-std::string DBSearch::build_where(const std::string& col, const std::string& data) const {
+std::string DBSearch::build_where(const TablePlan& plan, const std::string& col, const std::string& data) const {
   static const std::vector<std::string> select_modes = {"LIKE", "=", "LIKE", "REGEXP"};
   static const std::vector<std::string> inverted_select_modes = {"LIKE", "<>", "NOT LIKE", "NOT REGEXP"};
 
+  // A FULLTEXT index finds whole words only, so it's used for CONTAINS searches just when asked for.
+  if (_use_fulltext && _search_mode == Contains && !_invert && plan.fulltext_columns.count(col)) {
+    std::string phrase = data;
+    std::replace(phrase.begin(), phrase.end(), '"', ' ');
+    return base::sqlstring("MATCH(!) AGAINST(? IN BOOLEAN MODE) ", base::QuoteOnlyIfNeeded) << col
+                                                                                            << "\"" + phrase + "\"";
+  }
+
+  // Text columns are compared without CAST, so that an index on them can be used.
   std::string where_condition;
-  if (_cast_to.empty())
+  if (_cast_to.empty() || plan.text_columns.count(col))
     where_condition.append(base::sqlstring("!", base::QuoteOnlyIfNeeded) << col);
   else {
     std::string tmpl("CAST(! AS ");
@@ -246,36 +299,34 @@ std::string DBSearch::build_where(const std::string& col, const std::string& dat
   return where_condition;
 }
 
-std::string DBSearch::build_count_query(const std::string& schema, const std::string& table,
-                                        const std::list<std::string>& columns, const std::string& limit,
-                                        const bool match_PK) const {
-  if (columns.empty())
+std::string DBSearch::build_count_query(const TablePlan& plan, const std::string& limit) const {
+  if (plan.select_columns.empty())
     return std::string();
   std::string result("SELECT COUNT(*) ");
   std::string or_clause;
   std::string where_condition;
-  for (std::list<std::string>::const_iterator It = columns.begin(); It != columns.end(); ++It) {
-    std::string col_where = build_where(*It, _search_keyword);
+  for (std::list<std::string>::const_iterator It = plan.select_columns.begin(); It != plan.select_columns.end();
+       ++It) {
+    std::string col_where = build_where(plan, *It, _search_keyword);
     where_condition.append(or_clause).append(col_where);
     or_clause = "OR ";
   }
 
-  result.append(base::sqlstring(" FROM !.! WHERE ", 0) << schema << table);
+  result.append(base::sqlstring(" FROM !.! WHERE ", 0) << plan.schema << plan.table);
   result.append(where_condition).append(limit);
   return result;
 }
 
-std::string DBSearch::build_select_query(const std::string& schema, const std::string& table,
-                                         const std::list<std::string>& columns, const std::string& limit,
-                                         const bool match_PK) const {
-  if (columns.empty())
+std::string DBSearch::build_select_query(const TablePlan& plan, const std::string& limit) const {
+  if (plan.select_columns.empty())
     return std::string();
 
   std::string result("SELECT ");
   bool pk_col = true;
   std::string or_clause;
   std::string where_condition;
-  for (std::list<std::string>::const_iterator It = columns.begin(); It != columns.end(); ++It) {
+  for (std::list<std::string>::const_iterator It = plan.select_columns.begin(); It != plan.select_columns.end();
+       ++It) {
     if (pk_col) // Add data for PK column
     {
       if (It->empty()) // No PK indicator
@@ -287,7 +338,7 @@ std::string DBSearch::build_select_query(const std::string& schema, const std::s
       pk_col = false;
       continue;
     }
-    std::string col_where = build_where(*It, _search_keyword);
+    std::string col_where = build_where(plan, *It, _search_keyword);
     result.append(", IF(").append(col_where);
     result.append(base::sqlstring(", !, '') AS ! ", base::QuoteOnlyIfNeeded) << *It << *It);
 
@@ -297,58 +348,52 @@ std::string DBSearch::build_select_query(const std::string& schema, const std::s
   if (where_condition.empty()) {
     return std::string();
   }
-  result.append(base::sqlstring("FROM !.! WHERE ", base::QuoteOnlyIfNeeded) << schema << table);
+  result.append(base::sqlstring("FROM !.! WHERE ", base::QuoteOnlyIfNeeded) << plan.schema << plan.table);
   result.append(where_condition).append(limit);
   return result;
 }
 
-void DBSearch::count_data(const std::string& schema_name, const std::string& table_name,
-                          const std::list<std::string>& pk_columns, const std::list<std::string>& select_columns,
-                          const std::string& limit_clause, const bool match_PK) {
-  std::string query = build_count_query(schema_name, table_name, select_columns, limit_clause, match_PK);
-  if (query.empty())
-    return;
+int DBSearch::count_data(sql::Connection* connection, const TablePlan& plan, const std::string& limit_clause) {
+  std::string query = build_count_query(plan, limit_clause);
+  if (query.empty() || skip_expensive_query(connection, plan, query))
+    return 0;
 
-  std::unique_ptr<sql::Statement> stmt(_db_conn->createStatement());
+  std::unique_ptr<sql::Statement> stmt(connection->createStatement());
   std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(query));
-  if (_limit_counter > 0)
-    _limit_counter -= (int)rs->rowsCount();
   SearchResultEntry result;
-  result.schema = schema_name;
-  result.table = table_name;
-  result.keys = pk_columns;
+  result.schema = plan.schema;
+  result.table = plan.table;
+  result.keys = plan.pk_columns;
   result.query = query;
   while (rs->next()) {
     std::vector<std::pair<std::string, std::string> > data;
-    data.reserve(select_columns.size());
+    data.reserve(plan.select_columns.size());
     data.push_back(std::pair<std::string, std::string>("COUNT", rs->getString(1)));
     _matched_rows += rs->getInt(1);
     result.data.push_back(data);
   }
   base::MutexLock lock(_search_result_mutex);
   _search_result.push_back(result);
+  return (int)rs->rowsCount();
 };
 
-void DBSearch::select_data(const std::string& schema_name, const std::string& table_name,
-                           const std::list<std::string>& pk_columns, const std::list<std::string>& select_columns,
-                           const std::string& limit_clause, const bool match_PK) {
-  std::string query = build_select_query(schema_name, table_name, select_columns, limit_clause, match_PK);
-  if (query.empty())
-    return;
-  std::unique_ptr<sql::Statement> stmt(_db_conn->createStatement());
+int DBSearch::select_data(sql::Connection* connection, const TablePlan& plan, const std::string& limit_clause) {
+  std::string query = build_select_query(plan, limit_clause);
+  if (query.empty() || skip_expensive_query(connection, plan, query))
+    return 0;
+  std::unique_ptr<sql::Statement> stmt(connection->createStatement());
   std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(query));
-  if (_limit_counter > 0)
-    _limit_counter -= (int)rs->rowsCount();
   SearchResultEntry result;
-  result.schema = schema_name;
-  result.table = table_name;
+  result.schema = plan.schema;
+  result.table = plan.table;
   result.query = query;
-  result.keys = pk_columns;
+  result.keys = plan.pk_columns;
   while (rs->next()) {
     size_t col_idx = 1;
     std::vector<std::pair<std::string, std::string> > data;
-    data.reserve(select_columns.size());
-    for (std::list<std::string>::const_iterator It = select_columns.begin(); It != select_columns.end(); ++It)
+    data.reserve(plan.select_columns.size());
+    for (std::list<std::string>::const_iterator It = plan.select_columns.begin(); It != plan.select_columns.end();
+         ++It)
       data.push_back(std::pair<std::string, std::string>(*It, rs->getString((int)col_idx++)));
     if (!data.empty())
       result.data.push_back(data);
@@ -358,16 +403,48 @@ void DBSearch::select_data(const std::string& schema_name, const std::string& ta
     base::MutexLock lock(_search_result_mutex);
     _search_result.push_back(result);
   }
+  return (int)rs->rowsCount();
 };
 
+/**
+ * Asks the server with EXPLAIN how many rows the query would examine. If that is more than the configured maximum
+ * the table is listed as skipped, with its query so the user can still run it, and true is returned.
+ */
+bool DBSearch::skip_expensive_query(sql::Connection* connection, const TablePlan& plan, const std::string& query) {
+  if (_max_scan_rows <= 0)
+    return false;
+
+  int64_t rows = 0;
+  try {
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+    std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery("EXPLAIN " + query));
+    while (rs->next())
+      rows = std::max(rows, (int64_t)rs->getInt64("rows"));
+  } catch (std::exception& exc) {
+    logWarning("Could not estimate the search cost for %s.%s: %s\n", plan.schema.c_str(), plan.table.c_str(),
+               exc.what());
+    return false;
+  }
+  if (rows <= _max_scan_rows)
+    return false;
+
+  SearchResultEntry result;
+  result.schema = plan.schema;
+  result.table = plan.table;
+  result.query = query;
+  result.keys = plan.pk_columns;
+  result.note = base::strfmt("skipped, about %lld rows to examine", (long long)rows);
+  base::MutexLock lock(_search_result_mutex);
+  _search_result.push_back(result);
+  return true;
+}
+
 void DBSearch::search() {
-  run(std::bind(&DBSearch::select_data, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
-                std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+  run(std::bind(&DBSearch::select_data, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 };
 
 void DBSearch::count() {
-  run(std::bind(&DBSearch::count_data, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
-                std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+  run(std::bind(&DBSearch::count_data, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 };
 
 void DBSearch::run(select_func_t select_func) {
@@ -386,182 +463,245 @@ void DBSearch::run(select_func_t select_func) {
   _working = true;
   _stop = false;
   _limit_counter = _limit_total ? _limit_total : -1;
-  _state = "Fetch schema list";
   _searched_tables = 0;
   _matched_rows = 0;
-  std::map<std::string, std::vector<std::string> > schemas;
-  std::map<std::string, std::vector<std::string> > schemas_tables;
-  {
-    std::unique_ptr<sql::Statement> stmt(_db_conn->createStatement());
-    for (size_t count = _filter_list.count(), i = 0; i < count; i++) {
-      wait_if_paused();
-      if (_stop) {
-        _working = false;
-        return;
-      }
-      std::string schema_pattern = _filter_list.get(i);
-      size_t dotpos = schema_pattern.find('.');
-      std::string table_column;
-      if (dotpos != std::string::npos)
-        table_column = schema_pattern.substr(dotpos + 1);
-      schema_pattern = schema_pattern.substr(0, dotpos);
-      if (schema_pattern.empty() || schema_pattern.find('%') != std::string::npos) {
-        schema_pattern = "%";
-        std::unique_ptr<sql::ResultSet> rs(
-          stmt->executeQuery(std::string(base::sqlstring("SHOW DATABASES LIKE ?", 0) << schema_pattern)));
-        while (rs->next()) {
-          std::string schema = rs->getString(1);
-          schemas[schema].push_back(table_column);
-        }
-      } else
-        schemas[schema_pattern].push_back(table_column);
-    }
+  plan_tables();
+  if (_stop) {
+    _working = false;
+    return;
   }
-  {
-    std::unique_ptr<sql::Statement> stmt(_db_conn->createStatement());
-    for (std::map<std::string, std::vector<std::string> >::const_iterator It = schemas.begin(); It != schemas.end();
-         ++It) {
-      std::string schema_name = It->first;
-      _state = std::string("Populate tables in ") + schema_name;
-      std::vector<std::string> tables = It->second;
-      for (std::vector<std::string>::const_iterator It_tables = tables.begin(); It_tables != tables.end();
-           ++It_tables) {
-        wait_if_paused();
-        if (_stop) {
-          _working = false;
+  _next_table = 0;
+  _tables_in_flight = 0;
+  _error = std::exception_ptr();
+
+  // Every connection searches the tables it takes from the list, the first one on this thread.
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < _db_conns.size() && i < _tables.size(); ++i)
+    workers.push_back(std::thread([this, i, select_func]() {
+      search_tables(_db_conns[i].get(), select_func);
+      sql::DriverManager::getDriverManager()->thread_cleanup();
+    }));
+  search_tables(_db_conns[0].get(), select_func);
+  for (auto& worker : workers)
+    worker.join();
+
+  if (_error)
+    std::rethrow_exception(_error);
+  if (_stop) {
+    _working = false;
+    return;
+  }
+
+  if (_searched_tables == 0)
+    set_state("No tables were searched");
+  else
+    set_state(base::strfmt("Search completed in %i tables", (int)_searched_tables));
+  _progress = 1;
+  _working = false;
+}
+
+/**
+ * Worker loop for one connection. Takes the next table from the list until all are searched, the search is stopped
+ * or the total limit is used up. Rows of the total limit are reserved before a table is searched and what it didn't
+ * match is given back afterwards, so workers only give up when no table in flight can give some back.
+ */
+void DBSearch::search_tables(sql::Connection* connection, select_func_t select_func) {
+  bool in_flight = false;
+  try {
+    for (;;) {
+      wait_if_paused();
+
+      size_t index;
+      int limit = 0;
+      {
+        std::unique_lock<std::mutex> lock(_limit_mutex);
+        _limit_condition.wait(lock, [this]() { return _stop || _limit_counter != 0 || _tables_in_flight == 0; });
+        if (_stop || _limit_counter == 0 || _next_table >= _tables.size())
           return;
+
+        index = _next_table++;
+        if (_limit_counter > 0) {
+          limit = _limt_per_table > 0 ? std::min(_limit_counter, _limt_per_table) : _limit_counter;
+          _limit_counter -= limit;
         }
-        std::string table_pattern = *It_tables;
-        size_t dotpos = table_pattern.find('.');
-        std::string column_pattern;
-        if (dotpos != std::string::npos)
-          column_pattern = table_pattern.substr(dotpos + 1);
-        else
-          column_pattern = '%';
-        table_pattern = table_pattern.substr(0, dotpos);
-        if (table_pattern.empty())
-          table_pattern = "%";
-
-        std::string query;
-        if (table_pattern == "%") {
-          query.append(base::sqlstring("SHOW FULL TABLES FROM ! WHERE Table_type = 'BASE TABLE'", 0) << schema_name);
-        } else {
-          query.append(base::sqlstring("SHOW TABLES FROM ! LIKE ?", 0) << schema_name << table_pattern);
-        }
-        std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(query));
-        while (rs->next()) {
-          std::string table = rs->getString(1);
-          schemas_tables[schema_name + '.' + table].push_back(column_pattern);
-        }
+        ++_tables_in_flight;
+        in_flight = true;
       }
+
+      int rows = search_table(connection, _tables[index], limit, select_func);
+
+      {
+        std::lock_guard<std::mutex> lock(_limit_mutex);
+        if (limit > 0)
+          _limit_counter += std::max(0, limit - rows);
+        --_tables_in_flight;
+        in_flight = false;
+        ++_searched_tables;
+        _progress = (_searched_tables * 1.f) / _tables.size();
+      }
+      _limit_condition.notify_all();
     }
+  } catch (...) {
+    // The first error fails the whole search, like it did before searching in parallel.
+    {
+      std::lock_guard<std::mutex> lock(_limit_mutex);
+      if (!_error)
+        _error = std::current_exception();
+      _stop = true;
+      if (in_flight)
+        --_tables_in_flight;
+    }
+    _limit_condition.notify_all();
   }
-  int cntr = 0;
-  for (std::map<std::string, std::vector<std::string> >::const_iterator It = schemas_tables.begin();
-       It != schemas_tables.end(); ++It) {
-    // Pick columns
-    std::string table_name = It->first;
-    size_t dotpos = table_name.find('.');
-    std::string schema_name = table_name.substr(0, dotpos);
-    _state = std::string("SELECT data from ") + schema_name + "." + table_name;
-    table_name = table_name.substr(++dotpos);
-    std::vector<std::string> columns = It->second;
-    std::string like_clause;
-    static const std::string like_pattern = "Field LIKE ? OR ";
-    for (std::vector<std::string>::const_iterator It_cols = columns.begin(); It_cols != columns.end(); ++It_cols)
-      like_clause.append(std::string(base::sqlstring(like_pattern.c_str(), base::UseAnsiQuotes) << *It_cols));
-    like_clause.append("FALSE");
+}
 
+/**
+ * Builds the list of tables to search, with the columns to select from each, from the filter list (entries of the form
+ * schema.table.column with patterns for table and column). All the needed metadata comes from a single query on
+ * INFORMATION_SCHEMA.COLUMNS, instead of listing the tables of each schema and the columns of each table.
+ */
+void DBSearch::plan_tables() {
+  set_state("Fetch table and column list");
+  _tables.clear();
+
+  std::string table_conditions;
+  std::string column_conditions;
+  for (size_t count = _filter_list.count(), i = 0; i < count; i++) {
+    std::string schema_pattern = _filter_list.get(i);
+    size_t dotpos = schema_pattern.find('.');
+    std::string table_pattern;
+    if (dotpos != std::string::npos)
+      table_pattern = schema_pattern.substr(dotpos + 1);
+    schema_pattern = schema_pattern.substr(0, dotpos);
+
+    dotpos = table_pattern.find('.');
+    std::string column_pattern = "%";
+    if (dotpos != std::string::npos)
+      column_pattern = table_pattern.substr(dotpos + 1);
+    table_pattern = table_pattern.substr(0, dotpos);
+    if (table_pattern.empty())
+      table_pattern = "%";
+
+    // A schema with a wildcard stands for all schemas. All tables of a schema means base tables only, but tables
+    // given by name or pattern can be views too.
+    std::string condition;
+    if (!schema_pattern.empty() && schema_pattern.find('%') == std::string::npos)
+      condition = std::string(base::sqlstring("c.TABLE_SCHEMA = ? AND ", 0) << schema_pattern);
+    condition += std::string(base::sqlstring("c.TABLE_NAME LIKE ?", 0) << table_pattern);
+    if (table_pattern == "%")
+      condition += " AND t.TABLE_TYPE = 'BASE TABLE'";
+
+    if (!table_conditions.empty()) {
+      table_conditions += " OR ";
+      column_conditions += " OR ";
+    }
+    table_conditions += "(" + condition + ")";
+    column_conditions +=
+      "(" + condition + std::string(base::sqlstring(" AND c.COLUMN_NAME LIKE ?)", 0) << column_pattern);
+  }
+  if (table_conditions.empty())
+    return;
+
+  std::unique_ptr<sql::Statement> stmt(_db_conns[0]->createStatement());
+  std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(
+    "SELECT c.TABLE_SCHEMA, c.TABLE_NAME, c.COLUMN_NAME, c.COLUMN_TYPE, c.COLUMN_KEY = 'PRI', " + column_conditions +
+    " FROM INFORMATION_SCHEMA.COLUMNS c JOIN INFORMATION_SCHEMA.TABLES t ON t.TABLE_SCHEMA = c.TABLE_SCHEMA AND "
+    "t.TABLE_NAME = c.TABLE_NAME WHERE " +
+    table_conditions + " ORDER BY c.TABLE_SCHEMA, c.TABLE_NAME, c.ORDINAL_POSITION"));
+
+  std::list<std::string> other_pk_columns; // PK columns of the current table that don't match any column pattern.
+  auto finish_table = [&]() {
+    // Add PK col if there is at least one column matching pattern and it wasn't added during col patterns search.
+    // Set PK col to be the first, or push empty string to indicate that there is no PK at all.
+    TablePlan& plan = _tables.back();
+    if (plan.pk_columns.empty() && !plan.select_columns.empty()) {
+      plan.select_columns.insert(plan.select_columns.begin(), other_pk_columns.begin(), other_pk_columns.end());
+      plan.pk_columns = other_pk_columns;
+      if (plan.pk_columns.empty())
+        plan.select_columns.push_front("");
+    }
+    other_pk_columns.clear();
+  };
+
+  while (rs->next()) {
     wait_if_paused();
-    if (_stop) {
-      _working = false;
+    if (_stop)
       return;
+
+    std::string schema_name = rs->getString(1);
+    std::string table_name = rs->getString(2);
+    if (_tables.empty() || _tables.back().schema != schema_name || _tables.back().table != table_name) {
+      if (!_tables.empty())
+        finish_table();
+      _tables.push_back(TablePlan());
+      _tables.back().schema = schema_name;
+      _tables.back().table = table_name;
     }
 
-    std::list<std::string> pk_columns;
-    bool match_PK = false;
-    std::list<std::string> select_columns;
-    try {
-      std::unique_ptr<sql::Statement> stmt(_db_conn->createStatement());
-      std::unique_ptr<sql::ResultSet> rs(
-        stmt->executeQuery(std::string(base::sqlstring("SHOW COLUMNS FROM !.! WHERE ", base::QuoteOnlyIfNeeded)
-                                       << schema_name << table_name)
-                             .append(like_clause)));
-      while (rs->next()) {
-        std::string column = rs->getString(1);
-        std::string column_type = rs->getString(2);
-        if ((_search_data_type == search_all_types) ||
-            ((_search_data_type & numeric_type) && is_numeric_type(column_type)) ||
-            ((_search_data_type & datetime_type) && is_datetime_type(column_type)) ||
-            ((_search_data_type & text_type) && is_string_type(column_type))) {
-          if (rs->getString(4) == "PRI") {
-            select_columns.push_front(column);
-            pk_columns.push_back(column);
-            match_PK = true; // PK should be searched, not just displayed
-          }
-          select_columns.push_back(column);
-        } else {
-          if (rs->getString(4) == "PRI") {
-            select_columns.push_front(column);
-            pk_columns.push_back(column);
-          }
-        }
+    TablePlan& plan = _tables.back();
+    std::string column = rs->getString(3);
+    std::string column_type = rs->getString(4);
+    bool is_pk = rs->getBoolean(5);
+    if (is_text_type(column_type))
+      plan.text_columns.insert(column);
+    if (!rs->getBoolean(6)) {
+      if (is_pk)
+        other_pk_columns.push_back(column);
+    } else if ((_search_data_type == search_all_types) ||
+               ((_search_data_type & numeric_type) && is_numeric_type(column_type)) ||
+               ((_search_data_type & datetime_type) && is_datetime_type(column_type)) ||
+               ((_search_data_type & text_type) && is_string_type(column_type))) {
+      if (is_pk) {
+        plan.select_columns.push_front(column);
+        plan.pk_columns.push_back(column);
+        plan.match_PK = true; // PK should be searched, not just displayed
       }
-    } catch (std::exception& exc) {
-      logWarning("Could not get columns list from %s.%s: %s\n", schema_name.c_str(), table_name.c_str(), exc.what());
+      plan.select_columns.push_back(column);
+    } else if (is_pk) {
+      plan.select_columns.push_front(column);
+      plan.pk_columns.push_back(column);
     }
-    // Add PK col if there is at least one column matching pattern and it it wasn't added during col patterns search
-    if (pk_columns.empty() && !select_columns.empty()) {
-      try {
-        std::unique_ptr<sql::Statement> stmt(_db_conn->createStatement());
-        std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(
-          std::string(base::sqlstring("SHOW COLUMNS FROM !.! WHERE `Key` = 'PRI'", base::QuoteOnlyIfNeeded)
-                      << schema_name << table_name)));
-        while (rs->next()) {
-          select_columns.push_back(rs->getString(1));
-          pk_columns.push_back(rs->getString(1));
-        }
-        // set PK col to be the first, or push empty string to indicate that there is no PK at all
-        if (pk_columns.empty())
-          select_columns.push_front("");
-      } catch (std::exception& exc) {
-        logWarning("Could not get columns list from %s.%s: %s\n", schema_name.c_str(), table_name.c_str(), exc.what());
-      }
+  }
+  if (!_tables.empty())
+    finish_table();
+
+  if (_use_fulltext && _search_mode == Contains && !_invert && !_tables.empty()) {
+    std::map<std::string, size_t> plans;
+    for (size_t i = 0; i < _tables.size(); ++i)
+      plans[_tables[i].schema + "." + _tables[i].table] = i;
+
+    // MATCH() needs a FULLTEXT index on exactly the columns it is given, so only single column indexes count.
+    rs.reset(stmt->executeQuery(
+      "SELECT c.TABLE_SCHEMA, c.TABLE_NAME, MIN(c.COLUMN_NAME) FROM INFORMATION_SCHEMA.STATISTICS c "
+      "JOIN INFORMATION_SCHEMA.TABLES t ON t.TABLE_SCHEMA = c.TABLE_SCHEMA AND t.TABLE_NAME = c.TABLE_NAME "
+      "WHERE c.INDEX_TYPE = 'FULLTEXT' AND (" +
+      table_conditions + ") GROUP BY c.TABLE_SCHEMA, c.TABLE_NAME, c.INDEX_NAME HAVING COUNT(*) = 1"));
+    while (rs->next()) {
+      auto plan = plans.find(rs->getString(1) + "." + rs->getString(2));
+      if (plan != plans.end())
+        _tables[plan->second].fulltext_columns.insert(rs->getString(3));
     }
+  }
+}
 
-    { // Build select from columns fetched on previous step and use it to collect data
-      wait_if_paused();
-      if (_stop) {
-        _working = false;
-        return;
-      }
-      ++cntr;
-      std::string limit_clause("");
-      if (_limit_counter > 0) {
-        size_t limit = std::min(_limit_counter, _limt_per_table);
-        std::stringstream sout;
-        sout << "LIMIT " << limit;
-        limit_clause = sout.str();
-      } else if (_limt_per_table) {
-        std::stringstream sout;
-        sout << "LIMIT " << _limt_per_table;
-        limit_clause = sout.str();
-      }
-
-      _progress = (cntr * 1.f) / (schemas_tables.size());
-      select_func(schema_name, table_name, pk_columns, select_columns, limit_clause, match_PK);
-      _searched_tables++;
-
-      if ((_limit_total > 0) && (_limit_counter <= 0))
-        break;
-    }
+/**
+ * Searches a single table of the plan. Returns the number of rows that count against the total limit.
+ */
+int DBSearch::search_table(sql::Connection* connection, const TablePlan& plan, int limit, select_func_t select_func) {
+  set_state("SELECT data from " + plan.schema + "." + plan.table);
+
+  std::string limit_clause("");
+  if (limit > 0) {
+    std::stringstream sout;
+    sout << "LIMIT " << limit;
+    limit_clause = sout.str();
+  } else if (_limt_per_table) {
+    std::stringstream sout;
+    sout << "LIMIT " << _limt_per_table;
+    limit_clause = sout.str();
   }
-  if (_searched_tables == 0)
-    _state = "No tables were searched";
-  else
-    _state = base::strfmt("Search completed in %i tables", _searched_tables);
-  _progress = 1;
-  _working = false;
+
+  return select_func(connection, plan, limit_clause);
 }
 
 DBSearchPanel::DBSearchPanel()
@@ -776,7 +916,10 @@ void DBSearchPanel::load_model(mforms::TreeNodeRef tnode) {
     mforms::TreeNodeRef table_node = tnode->add_child();
     table_node->set_string(0, _searcher->search_results()[i].schema);
     table_node->set_string(1, _searcher->search_results()[i].table);
-    table_node->set_string(4, base::strfmt("%i rows matched", (int)rows.size()).c_str());
+    if (_searcher->search_results()[i].note.empty())
+      table_node->set_string(4, base::strfmt("%i rows matched", (int)rows.size()).c_str());
+    else
+      table_node->set_string(4, _searcher->search_results()[i].note);
     table_node->set_tag(_searcher->search_results()[i].query);
     _key_columns.insert(std::make_pair(table_node->get_tag(), _searcher->search_results()[i].keys));
 
@@ -802,10 +945,12 @@ void DBSearchPanel::load_model(mforms::TreeNodeRef tnode) {
   }
 };
 
-void DBSearchPanel::search(sql::ConnectionWrapper connection, const std::string& search_keyword,
-                           const grt::StringListRef& filter_list, const SearchMode search_mode, const int limit_total,
-                           const int limt_per_table, const bool invert, const int search_data_type,
-                           const std::string cast_to, std::function<void(grt::ValueRef)> finished_callback,
+void DBSearchPanel::search(const std::vector<sql::ConnectionWrapper>& connections,
+                           const std::string& search_keyword, const grt::StringListRef& filter_list,
+                           const SearchMode search_mode, const int limit_total, const int limt_per_table,
+                           const bool invert, const int search_data_type, const std::string cast_to,
+                           const bool use_fulltext, const int64_t max_scan_rows,
+                           std::function<void(grt::ValueRef)> finished_callback,
                            std::function<void()> failed_callback) {
   if (_searcher)
     return;
@@ -818,8 +963,9 @@ void DBSearchPanel::search(sql::ConnectionWrapper connection, const std::string&
   _search_finished = false;
   if (_update_timer)
     bec::GRTManager::get()->cancel_timer(_update_timer);
-  _searcher = std::shared_ptr<DBSearch>(new DBSearch(connection, search_keyword, filter_list, search_mode, limit_total,
-                                                     limt_per_table, invert, search_data_type, cast_to));
+  _searcher = std::shared_ptr<DBSearch>(new DBSearch(connections, search_keyword, filter_list, search_mode, limit_total,
+                                                     limt_per_table, invert, search_data_type, cast_to,
+                                                     use_fulltext, max_scan_rows));
   load_model(_results_tree.root_node());
   std::function<void()> fsearch = (std::bind(&DBSearch::search, _searcher.get()));
   // fsearch = (std::bind(&DBSearch::count, _searcher.get()));//COUNT test
@@ -55,9 +55,10 @@ protected:
 public:
   DBSearchPanel();
   ~DBSearchPanel();
-  void search(sql::ConnectionWrapper connection, const std::string& search_keyword,
+  void search(const std::vector<sql::ConnectionWrapper>& connections, const std::string& search_keyword,
               const grt::StringListRef& filter_list, const SearchMode search_mode, const int limit_total,
               const int limt_per_table, const bool invert, const int search_data_type, const std::string cast_to,
+              const bool use_fulltext, const int64_t max_scan_rows,
               std::function<void(grt::ValueRef)> finished_callback, std::function<void()> failed_callback);
   void toggle_pause();
   bool stop_search_if_working();
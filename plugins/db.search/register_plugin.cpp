@@ -38,6 +38,11 @@
 
 #define MODULE_VERSION "2.0.0"
 
+DEFAULT_LOG_DOMAIN("db.search");
+
+// Upper bound for the number of connections a search opens.
+#define MAX_SEARCH_CONNECTIONS 16
+
 #include <sstream>
 #include <boost/assign/list_of.hpp>
 #include <boost/lambda/bind.hpp>
@@ -157,28 +162,45 @@ private:
     int limit_total = _filter_panel.get_limit_total();
     int search_type = _filter_panel.get_search_type();
     bool invert = _filter_panel.exclude();
+    int connection_count = std::max(1, std::min(MAX_SEARCH_CONNECTIONS, _filter_panel.get_connections()));
     sql::DriverManager *dm = sql::DriverManager::getDriverManager();
     mforms::App::get()->set_status_text("Opening new connection...");
-    sql::ConnectionWrapper wrapper;
+    std::vector<sql::ConnectionWrapper> connections;
     try {
-      wrapper = dm->getConnection(_editor->connection());
+      connections.push_back(dm->getConnection(_editor->connection()));
     } catch (grt::user_cancelled &ucancel) {
       mforms::App::get()->set_status_text(ucancel.what());
       return;
     }
+    // The others reuse the password given for the first one. If the server doesn't allow that many connections we
+    // search with the ones we got.
+    for (int i = 1; i < connection_count; ++i) {
+      try {
+        connections.push_back(dm->getConnection(_editor->connection()));
+      } catch (std::exception &exc) {
+        logWarning("Could only open %i connections for searching: %s\n", i, exc.what());
+        break;
+      }
+    }
     mforms::App::get()->set_status_text("Searching...");
 
     bec::GRTManager::get()->set_app_option("db.search:SearchType", grt::IntegerRef(search_type));
     bec::GRTManager::get()->set_app_option("db.search:SearchLimit", grt::IntegerRef(limit_total));
     bec::GRTManager::get()->set_app_option("db.search:SearchLimitPerTable", grt::IntegerRef(limit_table));
     bec::GRTManager::get()->set_app_option("db.search:SearchInvert", grt::IntegerRef(invert));
+    bec::GRTManager::get()->set_app_option("db.search:SearchConnections", grt::IntegerRef(connection_count));
+    bec::GRTManager::get()->set_app_option("db.search:SearchUseFulltext",
+                                           grt::IntegerRef(_filter_panel.use_fulltext()));
+    bec::GRTManager::get()->set_app_option("db.search:SearchMaxScanRows",
+                                           grt::IntegerRef((long)_filter_panel.get_max_scan_rows()));
 
     _filter_panel.set_searching(true);
     _search_panel.show(true);
 
     _search_panel.search(
-      wrapper, search_keyword, filters, SearchMode(search_type), limit_total, limit_table, invert,
+      connections, search_keyword, filters, SearchMode(search_type), limit_total, limit_table, invert,
       _filter_panel.search_all_types() ? search_all_types : text_type, _filter_panel.search_all_types() ? "CHAR" : "",
+      _filter_panel.use_fulltext(), _filter_panel.get_max_scan_rows(),
       std::bind(&DBSearchView::finished_search, this), std::bind(&DBSearchView::failed_search, this));
   }
 
@@ -219,6 +241,11 @@ public:
     _filter_panel.set_limit_table(
       base::strfmt("%li", bec::GRTManager::get()->get_app_option_int("db.search:SearchLimitPerTable", 100)));
     _filter_panel.set_exclude(bec::GRTManager::get()->get_app_option_int("db.search:SearchInvert", 0) != 0);
+    _filter_panel.set_connections(
+      base::strfmt("%li", bec::GRTManager::get()->get_app_option_int("db.search:SearchConnections", 4)));
+    _filter_panel.set_use_fulltext(bec::GRTManager::get()->get_app_option_int("db.search:SearchUseFulltext", 0) != 0);
+    _filter_panel.set_max_scan_rows(
+      base::strfmt("%li", bec::GRTManager::get()->get_app_option_int("db.search:SearchMaxScanRows", 0)));
 
     _tree_selection = _editor->schemaTreeSelection();
     _filter_panel.search_button()->set_enabled(_tree_selection.count() > 0);
@@ -245,6 +245,9 @@ class DataMigrator(object):
             args.append('--target-timeout=%s' % task['ttimeout'])
         if self._resume:
             args.append("--resume")
+        if not self._options.get("ExactRowCounts", False):
+            args.append("--estimate-row-counts")
+            args.append('--source-rdbms-type=%s' % self._src_conn_object.driver.owner.name)
 
         argv = [self.copytable_path, "--count-only", "--passwords-from-stdin"] + args + table_param
         self._owner.send_info(" ".join(argv))
@@ -323,6 +326,8 @@ class DataMigrator(object):
             args.append("--log-level=debug3")
         if self._options.get("DriverSendsDataAsUTF8", False):
             args.append("--force-utf8-for-source")
+        if not self._options.get("ExactRowCounts", False):
+            args.append("--estimate-row-counts")
 
         args.append("--thread-count=" + str(num_processes));
         args.append('--source-rdbms-type=%s' % self._src_conn_object.driver.owner.name)
@@ -418,7 +423,10 @@ class DataMigrator(object):
                 if target_table in active_job_names:
                     active_job_names.remove(target_table)
                 self._owner.send_info(message)
-                progress_row_count[target_table] = (True, progress_row_count.get(target_table, (False, 0))[1])
+                # the row count of the table may have been an estimate, the END line has the real one
+                m = re.match(r"[^:]*:Finished copying (\d+) rows", message)
+                count = int(m.group(1)) if m else progress_row_count.get(target_table, (False, 0))[1]
+                progress_row_count[target_table] = (True, count)
 
             elif msgtype == "ERROR":
                 target_table = message.split(":")[0]
@@ -431,9 +439,11 @@ class DataMigrator(object):
                 self._resume = True
 
             elif msgtype == "PROGRESS":
-                target_table, current, total = message.split(":")
+                # an optional 4th field carries the bulk insert batch size in use
+                target_table, current, total = message.split(":")[:3]
                 progress_row_count[target_table] = (False, int(current))
-                self._owner.send_progress(float(sum([x[1] for x in progress_row_count.values()])) / total_row_count, "Copying %s" % ", ".join(active_job_names))
+                # estimated row counts can be too low
+                self._owner.send_progress(min(1.0, float(sum([x[1] for x in progress_row_count.values()])) / max(total_row_count, 1)), "Copying %s" % ", ".join(active_job_names))
             elif msgtype == "LOG":
                 self._owner.send_info(message)
             elif msgtype == "DONE":
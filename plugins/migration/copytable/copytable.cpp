@@ -26,12 +26,16 @@
 #include <stdint.h>
 #include <cstdlib>
 #include <cstdio>
+#include <algorithm>
 
 #include <mysql.h>
+#include <errmsg.h>
 
 #include "base/log.h"
 #include "base/string_utilities.h"
 #include "base/sqlstring.h"
+#include "base/file_functions.h"
+#include "base/trace.h"
 
 #include "copytable.h"
 #include "converter.h"
@@ -48,6 +52,18 @@
 DEFAULT_LOG_DOMAIN("copytable");
 
 #define TMP_TRIGGER_TABLE "wb_tmp_triggers"
+#define TMP_INDEX_TABLE "wb_tmp_indexes"
+
+// Replication channel of the target that tails the source binlog after the copy (--cdc-tail).
+#define CDC_CHANNEL "wbcopytables"
+
+// Amount of row data sent in every LOAD DATA LOCAL INFILE statement.
+#define LOAD_DATA_BUFFER_SIZE (16 * 1024 * 1024)
+
+// Limits and tuning of the adaptive bulk insert batch size
+#define ADAPTIVE_BATCH_MIN_ROWS 10
+#define ADAPTIVE_BATCH_MAX_ROWS 100000
+#define ADAPTIVE_BATCH_WINDOW 4 // statements measured before each adjustment
 
 #if defined(MYSQL_VERSION_MAJOR) && defined(MYSQL_VERSION_MINOR) && defined(MYSQL_VERSION_PATCH)
 #define MYSQL_CHECK_VERSION(major, minor, micro)                                                         \
@@ -201,6 +217,47 @@ static const char *odbc_type_to_name(SQLSMALLINT type) {
   }
 }
 
+// Parses a key value returned by the source as text, rejecting anything that is not a plain integer.
+static bool parse_key_value(const char *text, long long &value) {
+  if (text == NULL || *text == 0)
+    return false;
+
+  char *end = NULL;
+  errno = 0;
+  value = strtoll(text, &end, 10);
+  return errno == 0 && end != NULL && *end == 0;
+}
+
+// Runs a query and returns its first row by column name. Returns false if there is no row.
+static bool query_named_row(MYSQL *mysql, const std::string &q, std::map<std::string, std::string> &values) {
+  logDebug("Executing query: %s\n", q.c_str());
+  if (mysql_query(mysql, q.c_str()) != 0)
+    throw ConnectionError("mysql_query(" + q + ")", mysql);
+
+  MYSQL_RES *result;
+  if ((result = mysql_store_result(mysql)) == NULL)
+    throw ConnectionError("mysql_store_result(" + q + ")", mysql);
+
+  values.clear();
+  MYSQL_ROW row = mysql_fetch_row(result);
+  if (row) {
+    MYSQL_FIELD *fields = mysql_fetch_fields(result);
+    for (unsigned int i = 0; i < mysql_num_fields(result); ++i)
+      values[fields[i].name] = row[i] ? row[i] : "";
+  }
+  mysql_free_result(result);
+
+  return row != NULL;
+}
+
+// Builds the condition that restricts a query to the key range of a CopyRange spec.
+static std::string range_condition(const std::string &key, const CopySpec &spec) {
+  std::string condition = base::strfmt("%s >= %lli", key.c_str(), spec.range_start);
+  if (spec.range_end >= 0)
+    condition += base::strfmt(" AND %s <= %lli", key.c_str(), spec.range_end);
+  return condition;
+}
+
 std::string QueryBuilder::build_query() {
   std::string q;
   std::string where_cond;
@@ -258,109 +315,128 @@ std::string ConnectionError::process(SQLRETURN retcode, SQLSMALLINT htype, SQLHA
   return output;
 }
 
+RowBufferArena::RowBufferArena(size_t block_size) : _block_size(block_size), _current(0), _used(0) {
+}
+
+RowBufferArena::~RowBufferArena() {
+  for (std::vector<std::pair<char *, size_t> >::iterator block = _blocks.begin(); block != _blocks.end(); ++block)
+    free(block->first);
+}
+
+void *RowBufferArena::allocate(size_t size) {
+  // Everything is aligned for the largest type a bind buffer can hold (MYSQL_TIME, long long, double)
+  size = (size + 15) & ~(size_t)15;
+
+  while (_current < _blocks.size() && _used + size > _blocks[_current].second) {
+    _current++;
+    _used = 0;
+  }
+
+  if (_current == _blocks.size()) {
+    size_t block_size = std::max(_block_size, size);
+    char *block = (char *)malloc(block_size);
+    if (!block)
+      throw std::runtime_error(base::strfmt("Could not allocate %lu bytes for row buffers", (unsigned long)block_size));
+    _blocks.push_back(std::make_pair(block, block_size));
+    _used = 0;
+  }
+
+  void *ptr = _blocks[_current].first + _used;
+  _used += size;
+  return ptr;
+}
+
+void RowBufferArena::reset() {
+  _current = 0;
+  _used = 0;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+#if MYSQL_VERSION_ID >= 80004
+typedef bool WB_BOOL;
+#else
+typedef my_bool WB_BOOL;
+#endif
+
+static unsigned long column_buffer_length(const ColumnInfo &col, size_t max_packet_size, bool &needs_length) {
+  needs_length = false;
+
+  // Only the PS data types are handled here
+  switch (col.target_type) {
+    case MYSQL_TYPE_TINY:
+      return sizeof(char);
+    case MYSQL_TYPE_YEAR:
+    case MYSQL_TYPE_SHORT:
+      return sizeof(short);
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONG:
+      return sizeof(int);
+    case MYSQL_TYPE_LONGLONG:
+      return sizeof(long long int);
+    case MYSQL_TYPE_FLOAT:
+      return sizeof(float);
+    case MYSQL_TYPE_DOUBLE:
+      return sizeof(double);
+    case MYSQL_TYPE_TIME:
+    case MYSQL_TYPE_DATE:
+    case MYSQL_TYPE_NEWDATE:
+    case MYSQL_TYPE_DATETIME:
+    case MYSQL_TYPE_TIMESTAMP:
+      return sizeof(MYSQL_TIME);
+    case MYSQL_TYPE_NEWDECIMAL:
+    case MYSQL_TYPE_STRING:
+    case MYSQL_TYPE_VAR_STRING:
+    case MYSQL_TYPE_BIT:
+    case MYSQL_TYPE_JSON:
+      needs_length = true;
+      return col.is_long_data ? 0 : (unsigned)col.source_length + 1;
+    case MYSQL_TYPE_BLOB:
+    case MYSQL_TYPE_GEOMETRY:
+      needs_length = true;
+      // source_length is not reliable (and returns bogus value for access)
+      // so we just use the max_packet_size value
+      return (unsigned long)std::min(max_packet_size, (size_t)col.source_length + 1);
+    case MYSQL_TYPE_NULL:
+      return 0;
+    default:
+      throw std::logic_error(
+        base::strfmt("Unhandled MySQL type %i for column '%s'", col.target_type, col.target_name.c_str()));
+  }
+}
+
 RowBuffer::RowBuffer(std::shared_ptr<std::vector<ColumnInfo> > columns,
-                     std::function<void(int, const char *, size_t)> send_blob_data, size_t max_packet_size)
+                     std::function<void(int, const char *, size_t)> send_blob_data, size_t max_packet_size,
+                     RowBufferArena *arena)
   : _current_field(0), _send_blob_data(send_blob_data) {
+  // The bind data of all columns lives in one region: the buffers, plus the length, is_null and
+  // error slots, so a row costs a single allocation (or none, when taken from a shared arena)
+  const size_t slot_size = 16;
+  if (!arena) {
+    size_t total = 0;
+    bool needs_length;
+    for (std::vector<ColumnInfo>::const_iterator col = columns->begin(); col != columns->end(); ++col)
+      total += ((column_buffer_length(*col, max_packet_size, needs_length) + 15) & ~(size_t)15) + 3 * slot_size;
+    _own_arena.reset(new RowBufferArena(std::max<size_t>(total, slot_size)));
+    arena = _own_arena.get();
+  }
+
+  reserve(columns->size());
   for (std::vector<ColumnInfo>::const_iterator col = columns->begin(); col != columns->end(); ++col) {
     MYSQL_BIND bind;
     memset(&bind, 0, sizeof(bind));
 
+    bool needs_length;
     bind.buffer_type = col->target_type;
-    // Only the PS data types are handled here
-    switch (col->target_type) {
-      case MYSQL_TYPE_TINY:
-        bind.buffer_length = sizeof(char);
-        break;
-      case MYSQL_TYPE_YEAR:
-      case MYSQL_TYPE_SHORT:
-        bind.buffer_length = sizeof(short);
-        break;
-      case MYSQL_TYPE_INT24:
-      case MYSQL_TYPE_LONG:
-        bind.buffer_length = sizeof(int);
-        break;
-      case MYSQL_TYPE_LONGLONG:
-        bind.buffer_length = sizeof(long long int);
-        break;
-      case MYSQL_TYPE_FLOAT:
-        bind.buffer_length = sizeof(float);
-        break;
-      case MYSQL_TYPE_DOUBLE:
-        bind.buffer_length = sizeof(double);
-        break;
-      case MYSQL_TYPE_TIME:
-      case MYSQL_TYPE_DATE:
-      case MYSQL_TYPE_NEWDATE:
-      case MYSQL_TYPE_DATETIME:
-      case MYSQL_TYPE_TIMESTAMP:
-        bind.buffer_length = sizeof(MYSQL_TIME);
-        break;
-      case MYSQL_TYPE_NEWDECIMAL:
-      case MYSQL_TYPE_STRING:
-      case MYSQL_TYPE_VAR_STRING:
-      case MYSQL_TYPE_BIT:
-      case MYSQL_TYPE_JSON:
-        if (!col->is_long_data)
-          bind.buffer_length = (unsigned)col->source_length + 1;
-
-        bind.length = (unsigned long *)malloc(sizeof(unsigned long));
-        if (!bind.length)
-          throw std::runtime_error("Could not allocate memory for row buffer");
-        break;
-      case MYSQL_TYPE_BLOB:
-      case MYSQL_TYPE_GEOMETRY:
-        // source_length is not reliable (and returns bogus value for access)
-        // so we just use the max_packet_size value
-        bind.buffer_length = (unsigned long)std::min(max_packet_size, (size_t)col->source_length + 1);
-        bind.length = (unsigned long *)malloc(sizeof(unsigned long));
-        if (!bind.length)
-          throw std::runtime_error("Could not allocate memory for row buffer");
-        break;
-      case MYSQL_TYPE_NULL:
-        bind.buffer_length = 0;
-        break;
-      default:
-        throw std::logic_error(
-          base::strfmt("Unhandled MySQL type %i for column '%s'", col->target_type, col->target_name.c_str()));
-    }
-
-#if MYSQL_VERSION_ID >= 80004
-    typedef bool WB_BOOL;
-#else
-    typedef my_bool WB_BOOL;
-#endif
+    bind.buffer_length = column_buffer_length(*col, max_packet_size, needs_length);
+    if (needs_length)
+      bind.length = (unsigned long *)arena->allocate(sizeof(unsigned long));
 
-    bind.error = (WB_BOOL *)malloc(sizeof(WB_BOOL));
-    if (!bind.error)
-      throw std::runtime_error("Could not allocate memory for row buffer");
-    if (col->target_type != MYSQL_TYPE_NULL) {
-      bind.is_null = (WB_BOOL *)malloc(sizeof(WB_BOOL));
-      if (!bind.is_null) {
-        if (bind.length) {
-          free(bind.length);
-          bind.length = NULL;
-        }
-        throw std::runtime_error("Could not allocate row buffer");
-      }
-    }
-    if (bind.buffer_length > 0) {
-      bind.buffer = malloc(bind.buffer_length);
+    bind.error = (WB_BOOL *)arena->allocate(sizeof(WB_BOOL));
+    if (col->target_type != MYSQL_TYPE_NULL)
+      bind.is_null = (WB_BOOL *)arena->allocate(sizeof(WB_BOOL));
 
-      if (!bind.buffer) {
-        if (bind.error) {
-          free(bind.error);
-          bind.error = NULL;
-        }
-        {
-          free(bind.is_null);
-          bind.is_null = NULL;
-        }
-        throw std::runtime_error(base::strfmt("Could not allocate %lu bytes for row buffer column of %s %s %i",
-                                              bind.buffer_length, col->source_name.c_str(), col->source_type.c_str(),
-                                              col->target_type));
-      }
-    } else
-      bind.buffer = 0;
+    bind.buffer = bind.buffer_length > 0 ? arena->allocate(bind.buffer_length) : NULL;
     bind.is_unsigned = col->is_unsigned;
 
     push_back(bind);
@@ -368,16 +444,36 @@ RowBuffer::RowBuffer(std::shared_ptr<std::vector<ColumnInfo> > columns,
 }
 
 RowBuffer::~RowBuffer() {
-  for (std::vector<MYSQL_BIND>::iterator field = begin(); field != end(); ++field) {
-    if (field->buffer)
-      free(field->buffer);
-    if (field->length)
-      free(field->length);
-    if (field->is_null)
-      free(field->is_null);
-    if (field->error)
-      free(field->error);
+  // Everything else belongs to the arena
+  for (std::vector<std::pair<char *, size_t> >::iterator field = _grown_fields.begin(); field != _grown_fields.end();
+       ++field)
+    free(field->first);
+}
+
+char *RowBuffer::grow_field(size_t index, size_t length) {
+  MYSQL_BIND &bind(at(index));
+
+  if (_grown_fields.empty())
+    _grown_fields.resize(size(), std::make_pair((char *)NULL, (size_t)0));
+
+  std::pair<char *, size_t> &grown(_grown_fields[index]);
+  if (grown.first == NULL && length <= bind.buffer_length && bind.buffer)
+    return (char *)bind.buffer;
+
+  if (length > grown.second) {
+    // Grow geometrically, so a column of increasingly large blobs doesn't reallocate on every row
+    size_t capacity = std::max(length, grown.second * 2);
+    char *buffer = (char *)realloc(grown.first, std::max<size_t>(capacity, 1));
+    if (!buffer)
+      throw std::runtime_error(base::strfmt("Could not allocate %lu bytes for field %i", (unsigned long)capacity,
+                                            (int)index + 1));
+    grown.first = buffer;
+    grown.second = capacity;
   }
+
+  bind.buffer = grown.first;
+  bind.buffer_length = (unsigned long)grown.second;
+  return grown.first;
 }
 
 void RowBuffer::clear() {
@@ -499,6 +595,32 @@ void RowBuffer::send_blob_data(const char *data, size_t length) {
   _send_blob_data(_current_field, data, length);
 }
 
+size_t RowBuffer::buffer_size() const {
+  size_t size = 0;
+  for (std::vector<MYSQL_BIND>::const_iterator field = begin(); field != end(); ++field)
+    size += field->buffer_length;
+  return size;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+void RowBatchQueue::push(RowBatch *batch) {
+  {
+    base::MutexLock lock(_mutex);
+    _batches.push_back(batch);
+  }
+  _available.post();
+}
+
+RowBatch *RowBatchQueue::pop() {
+  _available.wait();
+
+  base::MutexLock lock(_mutex);
+  RowBatch *batch = _batches.front();
+  _batches.pop_front();
+  return batch;
+}
+
 // -------------------------------------------------------------------------------------------------
 
 CopyDataSource::CopyDataSource()
@@ -506,7 +628,8 @@ CopyDataSource::CopyDataSource()
     _max_blob_chunk_size(64 * 1024),
     _max_parameter_size(0),
     _abort_on_oversized_blobs(false),
-    _get_field_lengths_from_target(false) {
+    _get_field_lengths_from_target(false),
+    _estimate_row_counts(false) {
 }
 
 void CopyDataSource::set_max_blob_chunk_size(size_t size) {
@@ -519,6 +642,37 @@ void CopyDataSource::set_block_size(int bsize) {
   _block_size = bsize;
 }
 
+bool CopyDataSource::get_key_range(const std::string &schema, const std::string &table, const std::string &key,
+                                   long long &min_value, long long &max_value) {
+  return false;
+}
+
+bool CopyDataSource::estimate_rows(const std::string &schema, const std::string &table, long long &count) {
+  return false;
+}
+
+size_t CopyDataSource::rows_to_copy(const std::string &schema, const std::string &table,
+                                    const std::vector<std::string> &pk_columns, const CopySpec &spec,
+                                    const std::vector<std::string> &last_pkeys, bool &estimated) {
+  estimated = false;
+
+  // Only whole tables have statistics, key ranges, conditions and resumed copies are still counted.
+  long long count = 0;
+  if (_estimate_row_counts && spec.type == CopyAll && !(spec.resume && last_pkeys.size())) {
+    try {
+      estimated = estimate_rows(schema, table, count) && count >= 0;
+    } catch (std::exception &e) {
+      logWarning("Could not estimate the rows of %s.%s, counting them: %s\n", schema.c_str(), table.c_str(), e.what());
+    }
+  }
+  if (!estimated)
+    return count_rows(schema, table, pk_columns, spec, last_pkeys);
+
+  if (spec.max_count > 0 && spec.max_count < count)
+    count = spec.max_count;
+  return (size_t)count;
+}
+
 /*
  * get_where_condition : creates where condition for --resume parameter.
  * Parameters:
@@ -629,7 +783,13 @@ SQLSMALLINT ODBCCopyDataSource::odbc_type_to_c_type(SQLSMALLINT type, bool is_un
 
 ODBCCopyDataSource::ODBCCopyDataSource(SQLHENV env, const std::string &connstring, const std::string &password,
                                        bool force_utf8_input, const std::string &source_rdbms_type)
-  : _connstring(connstring), _stmt_ok(false), _source_rdbms_type(source_rdbms_type) {
+  : _connstring(connstring),
+    _stmt_ok(false),
+    _bind_pending(false),
+    _block_truncated(false),
+    _rows_fetched(0),
+    _current_row(0),
+    _source_rdbms_type(source_rdbms_type) {
   _blob_buffer = std::vector<char>(_max_blob_chunk_size);
 
   _force_utf8_input = force_utf8_input;
@@ -660,6 +820,36 @@ ODBCCopyDataSource::~ODBCCopyDataSource() {
   SQLFreeHandle(SQL_HANDLE_DBC, _dbc);
 }
 
+/*
+ * convert_wide_data : Converts a wide character value fetched from ODBC straight into the utf-8 row buffer,
+ *                     without going through intermediate std::wstring/std::string copies.
+ *
+ * Parameters:
+ *   - data : the fetched (null terminated) wide character data
+ *   - data_size : size in bytes of the fetch buffer, used to bound truncated values
+ *   - len_or_indicator : the byte length reported by the driver
+ *   - out_buffer, out_buffer_len : the target row buffer field
+ *
+ * Returns the number of bytes written, excluding the null terminator.
+ */
+size_t ODBCCopyDataSource::convert_wide_data(const wchar_t *data, size_t data_size, SQLLEN len_or_indicator,
+                                             char *out_buffer, size_t out_buffer_len) {
+  size_t chars = (size_t)len_or_indicator / sizeof(wchar_t);
+  // Truncated values are null terminated inside the fetch buffer.
+  if (chars >= data_size / sizeof(wchar_t))
+    chars = data_size / sizeof(wchar_t) - 1;
+
+  size_t out_size = std::min(out_buffer_len, _max_blob_chunk_size);
+  if (out_size == 0)
+    throw std::logic_error("Output buffer size is greater than max blob chunk size.");
+
+  size_t converted = base::wide_to_utf8_buffer(data, chars, out_buffer, out_size - 1);
+  if (converted == (size_t)-1)
+    throw std::logic_error("Output buffer size is greater than max blob chunk size.");
+  out_buffer[converted] = 0;
+  return converted;
+}
+
 SQLRETURN ODBCCopyDataSource::get_wchar_buffer_data(RowBuffer &rowbuffer, int column) {
   unsigned long *out_length = NULL;
   SQLLEN len_or_indicator = 0;
@@ -672,26 +862,16 @@ SQLRETURN ODBCCopyDataSource::get_wchar_buffer_data(RowBuffer &rowbuffer, int co
       "Forcing wchar_t but SQLWCHAR is of different type which shouldn't happen. Potential problems during migration "
       "may occur.\n");
 
-  SQLRETURN ret = SQLGetData(_stmt, column, _column_types[column - 1], tmpbuf, sizeof(tmpbuf), &len_or_indicator);
+  SQLRETURN ret = get_data(column, _column_types[column - 1], tmpbuf, sizeof(tmpbuf), &len_or_indicator);
   // check if the data fits
   // if (len_or_indicator > out_buffer_len)
   //  ;
   rowbuffer.prepare_add_string(out_buffer, out_buffer_len, out_length);
-  memset(out_buffer, 0, out_buffer_len);
   if (SQL_SUCCEEDED(ret)) {
     if (len_or_indicator == SQL_NO_TOTAL)
       throw std::runtime_error(base::strfmt("Got SQL_NO_TOTAL for string size during copy of column %i", column));
 
     if (len_or_indicator != SQL_NULL_DATA) {
-      size_t outbuf_len = out_buffer_len;
-
-      // convert data from UCS-2 to utf-8
-      std::string s_outbuf = base::wstring_to_string(tmpbuf);
-
-      outbuf_len = s_outbuf.size();
-      if (outbuf_len > _max_blob_chunk_size - 1)
-        throw std::logic_error("Output buffer size is greater than max blob chunk size.");
-
       // The following lengths are valid as length/indicator values:
       // - n, where n > 0,
       // - 0
@@ -699,13 +879,10 @@ SQLRETURN ODBCCopyDataSource::get_wchar_buffer_data(RowBuffer &rowbuffer, int co
       // convenient
       //            way for C programmers to pass strings without having to calculate their byte length.
       //            This value is legal only when the application sends data to the driver.
-      if (s_outbuf.empty() && len_or_indicator > 0)
-        throw std::logic_error(base::strfmt("Error during charset conversion of wstring: %s", strerror(errno)));
-
-      if (len_or_indicator > 0)
-        std::strcpy(out_buffer, s_outbuf.c_str());
-      *out_length = (unsigned long)outbuf_len;
-    }
+      *out_length = (unsigned long)convert_wide_data(tmpbuf, sizeof(tmpbuf), len_or_indicator, out_buffer,
+                                                     out_buffer_len);
+    } else if (out_buffer_len > 0)
+      *out_buffer = 0;
     rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
   }
   return ret;
@@ -719,7 +896,7 @@ SQLRETURN ODBCCopyDataSource::get_date_time_data(RowBuffer &rowbuffer, int colum
   char out_date[32];
 
   rowbuffer.prepare_add_time(out_buffer, out_buffer_len);
-  ret = SQLGetData(_stmt, column, SQL_C_CHAR, &out_date, sizeof(out_date), &len_or_indicator);
+  ret = get_data(column, SQL_C_CHAR, &out_date, sizeof(out_date), &len_or_indicator);
   if (SQL_SUCCEEDED(ret)) {
     // When driver cannot determine the number of bytes of long data
     // still available to return in an output buffer it return SQL_NO_TOTAL
@@ -745,7 +922,7 @@ SQLRETURN ODBCCopyDataSource::get_char_buffer_data(RowBuffer &rowbuffer, int col
   size_t out_buffer_len;
 
   rowbuffer.prepare_add_string(out_buffer, out_buffer_len, out_length);
-  ret = SQLGetData(_stmt, column, _column_types[column - 1], out_buffer, out_buffer_len, &len_or_indicator);
+  ret = get_data(column, _column_types[column - 1], out_buffer, out_buffer_len, &len_or_indicator);
   // check if the data fits
   // if (len_or_indicator > out_buffer_len)
   //  ;
@@ -772,31 +949,18 @@ SQLRETURN ODBCCopyDataSource::get_geometry_buffer_data(RowBuffer &rowbuffer, int
       "Forcing wchar_t but SQLWCHAR is of different type which shouldn't happen. Potential problems during migration "
       "may occur.\n");
 
-  SQLRETURN ret = SQLGetData(_stmt, column, SQL_C_WCHAR, tmpbuf, sizeof(tmpbuf), &len_or_indicator);
+  SQLRETURN ret = get_data(column, SQL_C_WCHAR, tmpbuf, sizeof(tmpbuf), &len_or_indicator);
 
   rowbuffer.prepare_add_geometry(out_buffer, out_buffer_len, out_length);
-  memset(out_buffer, 0, out_buffer_len);
   if (SQL_SUCCEEDED(ret)) {
     if (len_or_indicator == SQL_NO_TOTAL)
       throw std::runtime_error(base::strfmt("Got SQL_NO_TOTAL for string size during copy of column %i", column));
 
-    if (len_or_indicator != SQL_NULL_DATA) {
-      size_t outbuf_len = out_buffer_len;
-
-      // convert data from UCS-2 to utf-8
-      std::string s_outbuf = base::wstring_to_string(tmpbuf);
-      outbuf_len = s_outbuf.size();
-      if (outbuf_len > _max_blob_chunk_size - 1)
-        throw std::logic_error("Output buffer size is greater than max blob chunk size.");
-
-      if (s_outbuf.empty() && len_or_indicator > 0)
-        throw std::logic_error(base::strfmt("Error during charset conversion of wstring: %s", strerror(errno)));
-
-      if (len_or_indicator)
-        std::strcpy(out_buffer, s_outbuf.c_str());
-
-      *out_length = (unsigned long)outbuf_len;
-    }
+    if (len_or_indicator != SQL_NULL_DATA)
+      *out_length = (unsigned long)convert_wide_data(tmpbuf, sizeof(tmpbuf), len_or_indicator, out_buffer,
+                                                     out_buffer_len);
+    else if (out_buffer_len > 0)
+      *out_buffer = 0;
     rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
   }
   return ret;
@@ -830,6 +994,8 @@ size_t ODBCCopyDataSource::count_rows(const std::string &schema, const std::stri
         q.add_where(base::strfmt("%s AND %s", start_expr.c_str(), end_expr.c_str()));
       else
         q.add_where(start_expr);
+      if (spec.resume && last_pkeys.size())
+        q.add_where(get_where_condition(pk_columns, last_pkeys));
       break;
     }
     case CopyCount: {
@@ -859,6 +1025,85 @@ size_t ODBCCopyDataSource::count_rows(const std::string &schema, const std::stri
   return (size_t)count;
 }
 
+bool ODBCCopyDataSource::estimate_rows(const std::string &schema, const std::string &table, long long &count) {
+  // The names come quoted for the source, which is what OBJECT_ID() and regclass expect.
+  std::string name = schema.empty() ? table : schema + "." + table;
+  std::string q;
+  if (_source_rdbms_type == "Mssql") {
+    // With catalogs the schema is the database, whose own sys.partitions has the table.
+    q = base::strfmt(
+      "SELECT SUM(p.rows) FROM %ssys.partitions p WHERE p.object_id = OBJECT_ID(N'%s') AND p.index_id IN (0, 1)",
+      schema.empty() ? "" : (schema + ".").c_str(), base::replaceString(name, "'", "''").c_str());
+  } else if (_source_rdbms_type == "Postgresql")
+    q = base::strfmt("SELECT reltuples FROM pg_class WHERE oid = '%s'::regclass",
+                     base::replaceString(name, "'", "''").c_str());
+  else
+    return false;
+
+  SQLHSTMT stmt;
+  SQLRETURN ret;
+  if (!SQL_SUCCEEDED(ret = SQLAllocHandle(SQL_HANDLE_STMT, _dbc, &stmt)))
+    throw ConnectionError("SQLAllocHandle", ret, SQL_HANDLE_DBC, _dbc);
+
+  logDebug("Executing query: %s\n", q.c_str());
+  if (!SQL_SUCCEEDED(ret = SQLExecDirect(stmt, (SQLCHAR *)q.c_str(), SQL_NTS))) {
+    ConnectionError err("SQLExecDirect(" + q + ")", ret, SQL_HANDLE_STMT, stmt);
+    SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+    throw err;
+  }
+
+  // reltuples is a float and -1 for tables that were never analyzed.
+  bool ret_val = false;
+  if (SQL_SUCCEEDED(SQLFetch(stmt))) {
+    char text[64];
+    SQLLEN indicator = SQL_NULL_DATA;
+    if (SQL_SUCCEEDED(SQLGetData(stmt, 1, SQL_C_CHAR, text, sizeof(text), &indicator)) &&
+        indicator != SQL_NULL_DATA) {
+      double value = strtod(text, NULL);
+      count = (long long)value;
+      ret_val = value >= 0;
+    }
+  }
+
+  SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+
+  return ret_val;
+}
+
+bool ODBCCopyDataSource::get_key_range(const std::string &schema, const std::string &table, const std::string &key,
+                                       long long &min_value, long long &max_value) {
+  SQLHSTMT stmt;
+  SQLRETURN ret;
+  if (!SQL_SUCCEEDED(ret = SQLAllocHandle(SQL_HANDLE_STMT, _dbc, &stmt)))
+    throw ConnectionError("SQLAllocHandle", ret, SQL_HANDLE_DBC, _dbc);
+
+  QueryBuilder q;
+  q.select_columns(base::strfmt("MIN(%s), MAX(%s)", key.c_str(), key.c_str()));
+  q.select_from_table(table, schema);
+
+  logDebug("Executing query: %s\n", q.build_query().c_str());
+  if (!SQL_SUCCEEDED(ret = SQLExecDirect(stmt, (SQLCHAR *)q.build_query().c_str(), SQL_NTS))) {
+    ConnectionError err("SQLExecDirect(" + q.build_query() + ")", ret, SQL_HANDLE_STMT, stmt);
+    SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+    throw err;
+  }
+
+  bool ret_val = false;
+  if (SQL_SUCCEEDED(SQLFetch(stmt))) {
+    char min_text[64], max_text[64];
+    SQLLEN min_indicator = SQL_NULL_DATA, max_indicator = SQL_NULL_DATA;
+
+    if (SQL_SUCCEEDED(SQLGetData(stmt, 1, SQL_C_CHAR, min_text, sizeof(min_text), &min_indicator)) &&
+        SQL_SUCCEEDED(SQLGetData(stmt, 2, SQL_C_CHAR, max_text, sizeof(max_text), &max_indicator)) &&
+        min_indicator != SQL_NULL_DATA && max_indicator != SQL_NULL_DATA)
+      ret_val = parse_key_value(min_text, min_value) && parse_key_value(max_text, max_value);
+  }
+
+  SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+
+  return ret_val;
+}
+
 std::shared_ptr<std::vector<ColumnInfo> > ODBCCopyDataSource::begin_select_table(
   const std::string &schema, const std::string &table, const std::vector<std::string> &pk_columns,
   const std::string &select_expression, const CopySpec &spec, const std::vector<std::string> &last_pkeys) {
@@ -923,6 +1168,10 @@ std::shared_ptr<std::vector<ColumnInfo> > ODBCCopyDataSource::begin_select_table
       if (SQL_SUCCEEDED(SQLColAttribute(_stmt, i, SQL_DESC_UNSIGNED, NULL, 0, NULL, &attrvalue)))
         is_unsigned = attrvalue == SQL_TRUE;
 
+      SQLLEN octet_length = 0;
+      if (!SQL_SUCCEEDED(SQLColAttribute(_stmt, i, SQL_DESC_OCTET_LENGTH, NULL, 0, NULL, &octet_length)))
+        octet_length = 0;
+
       if (SQL_SUCCEEDED(
             SQLColAttribute(_stmt, i, SQL_DESC_TYPE_NAME, typeName, sizeof(typeName), &typeNameLength, NULL)))
         info.source_type = std::string((char *)typeName, typeNameLength);
@@ -945,70 +1194,346 @@ std::shared_ptr<std::vector<ColumnInfo> > ODBCCopyDataSource::begin_select_table
       columns->push_back(info);
 
       _column_types.push_back(odbc_type_to_c_type(dataType, is_unsigned));
+      _column_sizes.push_back(columnSize);
+      _column_octet_lengths.push_back(std::max<SQLLEN>(octet_length, 0));
     } else
       throw ConnectionError("SQLDescribeCol", ret, SQL_HANDLE_STMT, _stmt);
   }
 
-  return columns;
-}
+  // The column arrays are bound on the first fetch, once the target types in the row buffer are known
+  _bind_pending = _block_size > 1;
 
-void ODBCCopyDataSource::end_select_table() {
-  SQLFreeHandle(SQL_HANDLE_STMT, _stmt);
-  _column_types.clear();
-  _columns.reset();
-  _stmt_ok = false;
+  return columns;
 }
 
-bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
-  if (SQL_SUCCEEDED(SQLFetch(_stmt))) {
-    for (int i = 1; i <= _column_count; i++) {
-      SQLRETURN ret = 0;
-      SQLLEN len_or_indicator;
-      char *out_buffer;
-      size_t out_buffer_len;
-
-      // if this column is a blob, handle it as such
-      if (rowbuffer.check_if_blob() || (*_columns)[i - 1].is_long_data) {
-        ret = SQLGetData(_stmt, i, _column_types[i - 1], _blob_buffer.data(), _max_blob_chunk_size, &len_or_indicator);
-
-        // Saves the column length, at the first call it is the total column size
-        if (len_or_indicator > _max_parameter_size) {
-          if (_abort_on_oversized_blobs)
-            throw std::runtime_error(base::strfmt("oversized blob found in table %s.%s, size: %lli",
-                                                  _schema_name.c_str(), _table_name.c_str(),
-                                                  (long long)len_or_indicator));
-          else {
-            printf("oversized blob found in table %s.%s, size: %lli", _schema_name.c_str(), _table_name.c_str(),
-                   (long long)len_or_indicator);
-            rowbuffer.finish_field(true);
-            continue;
-          }
-        } else {
-          while (ret == SQL_SUCCESS_WITH_INFO) {
-            SQLUSMALLINT i = 0;
-            SQLINTEGER native;
-            SQLCHAR state[7];
-            SQLCHAR text[256];
-            SQLSMALLINT len;
+// Upper limit for the memory of the bound column arrays of a single statement.
+#define BLOCK_FETCH_MEMORY_LIMIT (16 * 1024 * 1024)
 
-            ret = SQLGetDiagRec(SQL_HANDLE_STMT, _stmt, ++i, state, &native, text, sizeof(text), &len);
+// Longest UTF-8 sequence, character data is converted to the client character set when bound as SQL_C_CHAR.
+#define MAX_BYTES_PER_CHAR 4
 
-            // This should be done ONLY if no bulk updates
-            // are being used
-            if (native == 1014 && !_use_bulk_inserts)
-              rowbuffer.send_blob_data(_blob_buffer.data(), len_or_indicator);
+/*
+ * block_c_type : determines the C type and buffer size a column is bound with for block fetching.
+ * Parameters:
+ * - rowbuffer : row buffer with the target types
+ * - column : 0 based column index
+ * - c_type : output parameter with the C type, 0 if the column data is never read
+ * - size : output parameter with the size of a single element of the bound array
+ *
+ * Remarks : The types must match what fetch_row() asks for through get_data() for each column.
+ *           Returns false if the column can't be bound (long data), so rows are fetched one by one.
+ *           Character buffers are sized in bytes for the worst case of the converted data, the column
+ *           size is in characters and the octet length is in the source encoding.
+ */
+bool ODBCCopyDataSource::block_c_type(RowBuffer &rowbuffer, int column, SQLSMALLINT &c_type, SQLLEN &size) {
+  const ColumnInfo &info = (*_columns)[column];
+  enum enum_field_types target_type = rowbuffer[column].buffer_type;
 
-            // Unrecognized characters were changed to ?? but data was read
-            else if (native == 2403) {
-              logWarning("[%s - %ld]: %s\n", state, (long int)native, text);
-              break;
-            }
+  if (info.is_long_data || target_type == MYSQL_TYPE_BLOB)
+    return false;
 
-            ret =
-              SQLGetData(_stmt, i, _column_types[i - 1], _blob_buffer.data(), _max_blob_chunk_size, &len_or_indicator);
-          }
+  SQLLEN chars = (SQLLEN)_column_sizes[column];
+  SQLLEN octets = _column_octet_lengths[column];
 
-          if (ret == SQL_SUCCESS) {
+  c_type = _column_types[column];
+  if (c_type == SQL_C_CHAR || c_type == SQL_C_WCHAR || c_type == SQL_C_BINARY) {
+    // Unknown or huge sizes can't be bound with a fixed element size
+    if ((chars <= 0 && octets <= 0) || chars > BLOCK_FETCH_MEMORY_LIMIT || octets > BLOCK_FETCH_MEMORY_LIMIT)
+      return false;
+  }
+  switch (c_type) {
+    case SQL_C_BIT:
+      c_type = SQL_C_STINYINT;
+      size = sizeof(char);
+      break;
+    case SQL_C_FLOAT:
+    case SQL_C_DOUBLE:
+      c_type = target_type == MYSQL_TYPE_FLOAT ? SQL_C_FLOAT : SQL_C_DOUBLE;
+      size = c_type == SQL_C_FLOAT ? sizeof(float) : sizeof(double);
+      break;
+    case SQL_C_DATE:
+    case SQL_C_TIME:
+    case SQL_C_TIMESTAMP:
+      c_type = SQL_C_CHAR;
+      size = 32;
+      break;
+    case SQL_C_UBIGINT:
+    case SQL_C_SBIGINT:
+      size = sizeof(SQLBIGINT);
+      break;
+    case SQL_C_ULONG:
+    case SQL_C_SLONG:
+      size = sizeof(SQLINTEGER);
+      break;
+    case SQL_C_USHORT:
+    case SQL_C_SSHORT:
+      size = sizeof(SQLSMALLINT);
+      break;
+    case SQL_C_UTINYINT:
+    case SQL_C_STINYINT:
+      size = sizeof(char);
+      break;
+    case SQL_C_WCHAR:
+    case SQL_C_CHAR:
+      if (target_type == MYSQL_TYPE_TIME || target_type == MYSQL_TYPE_DATE || target_type == MYSQL_TYPE_DATETIME ||
+          target_type == MYSQL_TYPE_NEWDATE) {
+        c_type = SQL_C_CHAR;
+        size = 32;
+      } else if (target_type == MYSQL_TYPE_GEOMETRY || c_type == SQL_C_WCHAR) {
+        // Characters outside the BMP take a surrogate pair
+        c_type = SQL_C_WCHAR;
+        size = (std::max(chars * 2, octets / (SQLLEN)sizeof(SQLWCHAR)) + 1) * sizeof(SQLWCHAR);
+      } else
+        size = std::max(chars * MAX_BYTES_PER_CHAR, octets) + 1;
+      break;
+    case SQL_C_BINARY:
+      // Binary data migrated as string is copied as NULL, see fetch_row()
+      if (target_type == MYSQL_TYPE_STRING)
+        c_type = 0;
+      size = std::max(chars, octets);
+      break;
+    default:
+      return false;
+  }
+
+  return size > 0;
+}
+
+void ODBCCopyDataSource::bind_block_columns(RowBuffer &rowbuffer) {
+  std::vector<BoundColumn> columns(_column_count);
+  SQLLEN row_size = 0;
+
+  for (int i = 0; i < _column_count; i++) {
+    if (!block_c_type(rowbuffer, i, columns[i].c_type, columns[i].element_size)) {
+      logDebug("Table %s.%s has long data columns, fetching rows one by one\n", _schema_name.c_str(),
+               _table_name.c_str());
+      return;
+    }
+    row_size += columns[i].element_size + sizeof(SQLLEN);
+  }
+
+  SQLULEN rows = std::min<SQLULEN>(_block_size, BLOCK_FETCH_MEMORY_LIMIT / std::max<SQLLEN>(row_size, 1));
+  if (rows < 2)
+    return;
+
+  SQLRETURN ret = SQLSetStmtAttr(_stmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0);
+  if (SQL_SUCCEEDED(ret))
+    ret = SQLSetStmtAttr(_stmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)rows, 0);
+
+  // Drivers may not support block cursors at all or lower the array size (01S02)
+  SQLULEN actual_rows = 0;
+  if (!SQL_SUCCEEDED(ret) || !SQL_SUCCEEDED(SQLGetStmtAttr(_stmt, SQL_ATTR_ROW_ARRAY_SIZE, &actual_rows, 0, NULL)) ||
+      actual_rows < 2) {
+    logDebug("The ODBC driver does not support block fetching, fetching rows one by one\n");
+    SQLSetStmtAttr(_stmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+    return;
+  }
+
+  _row_status.resize(actual_rows);
+  _bound_columns.swap(columns);
+  SQLSetStmtAttr(_stmt, SQL_ATTR_ROW_STATUS_PTR, _row_status.data(), 0);
+  SQLSetStmtAttr(_stmt, SQL_ATTR_ROWS_FETCHED_PTR, &_rows_fetched, 0);
+
+  for (int i = 0; i < _column_count; i++) {
+    BoundColumn &column = _bound_columns[i];
+    column.indicators.resize(actual_rows);
+    if (column.c_type == 0)
+      continue;
+
+    column.data.resize(actual_rows * column.element_size);
+    if (!SQL_SUCCEEDED(ret = SQLBindCol(_stmt, (SQLUSMALLINT)(i + 1), column.c_type, column.data.data(),
+                                        column.element_size, column.indicators.data()))) {
+      logWarning("Could not bind column %i for block fetching, fetching rows one by one: %s\n", i + 1,
+                 ConnectionError("SQLBindCol", ret, SQL_HANDLE_STMT, _stmt).what());
+      unbind_block_columns();
+      return;
+    }
+  }
+
+  logDebug("Fetching %s.%s in blocks of %lu rows\n", _schema_name.c_str(), _table_name.c_str(),
+           (unsigned long)actual_rows);
+}
+
+void ODBCCopyDataSource::unbind_block_columns() {
+  SQLFreeStmt(_stmt, SQL_UNBIND);
+  SQLSetStmtAttr(_stmt, SQL_ATTR_ROW_STATUS_PTR, NULL, 0);
+  SQLSetStmtAttr(_stmt, SQL_ATTR_ROWS_FETCHED_PTR, NULL, 0);
+  SQLSetStmtAttr(_stmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+  _bound_columns.clear();
+  _row_status.clear();
+}
+
+// Moves to the next row, either within the current block or by fetching from the driver.
+bool ODBCCopyDataSource::fetch_next(RowBuffer &rowbuffer) {
+  if (_bind_pending) {
+    _bind_pending = false;
+    bind_block_columns(rowbuffer);
+  }
+
+  if (_bound_columns.empty())
+    return SQL_SUCCEEDED(SQLFetch(_stmt));
+
+  if (++_current_row >= _rows_fetched) {
+    _current_row = 0;
+    _rows_fetched = 0;
+
+    SQLRETURN ret = SQLFetch(_stmt);
+    if (ret == SQL_NO_DATA)
+      return false;
+    if (!SQL_SUCCEEDED(ret))
+      throw ConnectionError("SQLFetch", ret, SQL_HANDLE_STMT, _stmt);
+    if (_rows_fetched == 0)
+      return false;
+
+    // 01004 means some value in the block did not fit its bound buffer
+    _block_truncated = false;
+    if (ret == SQL_SUCCESS_WITH_INFO) {
+      SQLSMALLINT i = 0;
+      SQLINTEGER native;
+      SQLCHAR state[7];
+      SQLCHAR text[256];
+      SQLSMALLINT len;
+      while (!_block_truncated &&
+             SQL_SUCCEEDED(SQLGetDiagRec(SQL_HANDLE_STMT, _stmt, ++i, state, &native, text, sizeof(text), &len)))
+        _block_truncated = strcmp((char *)state, "01004") == 0;
+    }
+  }
+
+  switch (_row_status[_current_row]) {
+    case SQL_ROW_ERROR:
+      throw std::runtime_error(
+        base::strfmt("Error fetching row from table %s.%s", _schema_name.c_str(), _table_name.c_str()));
+    case SQL_ROW_NOROW:
+      return false;
+    case SQL_ROW_SUCCESS_WITH_INFO:
+      if (_block_truncated)
+        throw std::runtime_error(base::strfmt(
+          "Data truncated while block fetching from table %s.%s, retry with --fetch-block-size=1",
+          _schema_name.c_str(), _table_name.c_str()));
+      return true;
+    default:
+      return true;
+  }
+}
+
+// Drop-in replacement for SQLGetData that serves the value from the bound arrays when block fetching.
+SQLRETURN ODBCCopyDataSource::get_data(int column, SQLSMALLINT type, SQLPOINTER buffer, SQLLEN buffer_len,
+                                       SQLLEN *len_or_indicator) {
+  if (_bound_columns.empty())
+    return SQLGetData(_stmt, (SQLUSMALLINT)column, type, buffer, buffer_len, len_or_indicator);
+
+  BoundColumn &bound = _bound_columns[column - 1];
+  if (bound.c_type != type)
+    throw std::logic_error(
+      base::strfmt("Type mismatch reading bound column %i (bound as %i, read as %i)", column, bound.c_type, type));
+
+  SQLLEN indicator = bound.indicators[_current_row];
+  if (len_or_indicator)
+    *len_or_indicator = indicator;
+  if (indicator == SQL_NULL_DATA)
+    return SQL_SUCCESS;
+
+  // Values that didn't fit the bound element were cut by the driver, never copy them as if complete
+  SQLLEN capacity = bound.element_size;
+  if (type == SQL_C_CHAR || type == SQL_C_WCHAR)
+    capacity -= type == SQL_C_WCHAR ? sizeof(SQLWCHAR) : 1;
+  if ((type == SQL_C_CHAR || type == SQL_C_WCHAR || type == SQL_C_BINARY) &&
+      (indicator == SQL_NO_TOTAL || indicator > capacity))
+    throw std::runtime_error(base::strfmt(
+      "Data truncated reading column %i of table %s.%s (%lli bytes, buffer is %lli), retry with --fetch-block-size=1",
+      column, _schema_name.c_str(), _table_name.c_str(), (long long)indicator, (long long)capacity));
+
+  const char *data = bound.data.data() + _current_row * bound.element_size;
+  switch (type) {
+    case SQL_C_CHAR:
+    case SQL_C_WCHAR: {
+      // Same as SQLGetData, character data is always null terminated
+      SQLLEN terminator = type == SQL_C_WCHAR ? sizeof(SQLWCHAR) : 1;
+      SQLLEN count = std::min(std::min(indicator, bound.element_size - terminator), buffer_len - terminator);
+      if (count < 0)
+        count = 0;
+      memcpy(buffer, data, count);
+      memset((char *)buffer + count, 0, terminator);
+      break;
+    }
+    case SQL_C_BINARY:
+      memcpy(buffer, data, std::min(std::min(indicator, bound.element_size), buffer_len));
+      break;
+    default:
+      memset(buffer, 0, buffer_len);
+      memcpy(buffer, data, std::min(bound.element_size, buffer_len));
+      break;
+  }
+
+  return SQL_SUCCESS;
+}
+
+void ODBCCopyDataSource::end_select_table() {
+  _bound_columns.clear();
+  _row_status.clear();
+  _rows_fetched = 0;
+  _current_row = 0;
+  _bind_pending = false;
+  _block_truncated = false;
+
+  SQLFreeHandle(SQL_HANDLE_STMT, _stmt);
+  _column_types.clear();
+  _column_sizes.clear();
+  _column_octet_lengths.clear();
+  _columns.reset();
+  _stmt_ok = false;
+}
+
+bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
+  if (fetch_next(rowbuffer)) {
+    for (int i = 1; i <= _column_count; i++) {
+      SQLRETURN ret = 0;
+      SQLLEN len_or_indicator;
+      char *out_buffer;
+      size_t out_buffer_len;
+
+      // if this column is a blob, handle it as such
+      if (rowbuffer.check_if_blob() || (*_columns)[i - 1].is_long_data) {
+        ret = SQLGetData(_stmt, i, _column_types[i - 1], _blob_buffer.data(), _max_blob_chunk_size, &len_or_indicator);
+
+        // Saves the column length, at the first call it is the total column size
+        if (len_or_indicator > _max_parameter_size) {
+          if (_abort_on_oversized_blobs)
+            throw std::runtime_error(base::strfmt("oversized blob found in table %s.%s, size: %lli",
+                                                  _schema_name.c_str(), _table_name.c_str(),
+                                                  (long long)len_or_indicator));
+          else {
+            printf("oversized blob found in table %s.%s, size: %lli", _schema_name.c_str(), _table_name.c_str(),
+                   (long long)len_or_indicator);
+            rowbuffer.finish_field(true);
+            continue;
+          }
+        } else {
+          while (ret == SQL_SUCCESS_WITH_INFO) {
+            SQLUSMALLINT i = 0;
+            SQLINTEGER native;
+            SQLCHAR state[7];
+            SQLCHAR text[256];
+            SQLSMALLINT len;
+
+            ret = SQLGetDiagRec(SQL_HANDLE_STMT, _stmt, ++i, state, &native, text, sizeof(text), &len);
+
+            // This should be done ONLY if no bulk updates
+            // are being used
+            if (native == 1014 && !_use_bulk_inserts)
+              rowbuffer.send_blob_data(_blob_buffer.data(), len_or_indicator);
+
+            // Unrecognized characters were changed to ?? but data was read
+            else if (native == 2403) {
+              logWarning("[%s - %ld]: %s\n", state, (long int)native, text);
+              break;
+            }
+
+            ret =
+              SQLGetData(_stmt, i, _column_types[i - 1], _blob_buffer.data(), _max_blob_chunk_size, &len_or_indicator);
+          }
+
+          if (ret == SQL_SUCCESS) {
             bool was_null = len_or_indicator == SQL_NULL_DATA;
 
             if (!was_null) {
@@ -1027,14 +1552,8 @@ bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
               }
 
               if (_use_bulk_inserts) {
-                if (rowbuffer[i - 1].buffer_length)
-                  free(rowbuffer[i - 1].buffer);
-
                 *rowbuffer[i - 1].length = (unsigned long)final_length;
-                rowbuffer[i - 1].buffer_length = (unsigned long)final_length;
-                rowbuffer[i - 1].buffer = malloc(final_length);
-
-                memcpy(rowbuffer[i - 1].buffer, final_data, final_length);
+                memcpy(rowbuffer.grow_field(i - 1, final_length), final_data, final_length);
               } else
                 rowbuffer.send_blob_data(final_data, final_length);
             }
@@ -1051,7 +1570,7 @@ bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
       switch (_column_types[i - 1]) {
         case SQL_C_BIT:
           rowbuffer.prepare_add_tiny(out_buffer, out_buffer_len);
-          ret = SQLGetData(_stmt, i, SQL_C_STINYINT, out_buffer, out_buffer_len, &len_or_indicator);
+          ret = get_data(i, SQL_C_STINYINT, out_buffer, out_buffer_len, &len_or_indicator);
           if (SQL_SUCCEEDED(ret))
             rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
           break;
@@ -1059,12 +1578,12 @@ bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
         case SQL_C_DOUBLE:
           if (rowbuffer[i - 1].buffer_type == MYSQL_TYPE_FLOAT) {
             rowbuffer.prepare_add_float(out_buffer, out_buffer_len);
-            ret = SQLGetData(_stmt, i, SQL_C_FLOAT, out_buffer, out_buffer_len, &len_or_indicator);
+            ret = get_data(i, SQL_C_FLOAT, out_buffer, out_buffer_len, &len_or_indicator);
             if (SQL_SUCCEEDED(ret))
               rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
           } else {
             rowbuffer.prepare_add_double(out_buffer, out_buffer_len);
-            ret = SQLGetData(_stmt, i, SQL_C_DOUBLE, out_buffer, out_buffer_len, &len_or_indicator);
+            ret = get_data(i, SQL_C_DOUBLE, out_buffer, out_buffer_len, &len_or_indicator);
             if (SQL_SUCCEEDED(ret))
               rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
           }
@@ -1081,7 +1600,7 @@ bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
         case SQL_C_UBIGINT:
         case SQL_C_SBIGINT:
           rowbuffer.prepare_add_bigint(out_buffer, out_buffer_len);
-          ret = SQLGetData(_stmt, i, _column_types[i - 1], out_buffer, out_buffer_len, &len_or_indicator);
+          ret = get_data(i, _column_types[i - 1], out_buffer, out_buffer_len, &len_or_indicator);
           if (SQL_SUCCEEDED(ret))
             rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
           break;
@@ -1090,7 +1609,7 @@ bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
           long tmp_buffer;
           bool unsig;
           enum enum_field_types target_type;
-          ret = SQLGetData(_stmt, i, _column_types[i - 1], &tmp_buffer, sizeof(tmp_buffer), &len_or_indicator);
+          ret = get_data(i, _column_types[i - 1], &tmp_buffer, sizeof(tmp_buffer), &len_or_indicator);
           if (SQL_SUCCEEDED(ret)) {
             switch ((target_type = rowbuffer.target_type(unsig))) {
               case MYSQL_TYPE_SHORT:
@@ -1121,14 +1640,14 @@ bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
         case SQL_C_USHORT:
         case SQL_C_SSHORT:
           rowbuffer.prepare_add_short(out_buffer, out_buffer_len);
-          ret = SQLGetData(_stmt, i, _column_types[i - 1], out_buffer, out_buffer_len, &len_or_indicator);
+          ret = get_data(i, _column_types[i - 1], out_buffer, out_buffer_len, &len_or_indicator);
           if (SQL_SUCCEEDED(ret))
             rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
           break;
         case SQL_C_UTINYINT:
         case SQL_C_STINYINT:
           rowbuffer.prepare_add_tiny(out_buffer, out_buffer_len);
-          ret = SQLGetData(_stmt, i, _column_types[i - 1], out_buffer, out_buffer_len, &len_or_indicator);
+          ret = get_data(i, _column_types[i - 1], out_buffer, out_buffer_len, &len_or_indicator);
           if (SQL_SUCCEEDED(ret))
             rowbuffer.finish_field(len_or_indicator == SQL_NULL_DATA);
           break;
@@ -1178,6 +1697,69 @@ bool ODBCCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
   return false;
 }
 
+// zlib is what the connections used before the algorithm could be chosen.
+std::string MySQLConnectionOptions::_compression = "zlib";
+base::Mutex MySQLConnectionOptions::_mutex;
+std::map<std::string, std::string> MySQLConnectionOptions::_tls_sessions;
+
+bool MySQLConnectionOptions::valid_compression(const std::string &algorithms) {
+  std::vector<std::string> names = base::split(algorithms, ",");
+  for (std::vector<std::string>::const_iterator name = names.begin(); name != names.end(); ++name) {
+    if (*name != "zstd" && *name != "zlib" && *name != "uncompressed")
+      return false;
+  }
+  return !names.empty();
+}
+
+void MySQLConnectionOptions::set_compression(const std::string &algorithms) {
+  base::MutexLock lock(_mutex);
+  _compression = algorithms;
+#if MYSQL_VERSION_ID < 80018
+  // Older client libraries only know the CLIENT_COMPRESS flag, which is zlib.
+  if (_compression.find("zstd") != std::string::npos) {
+    logWarning("zstd compression is not supported by this libmysqlclient, using zlib\n");
+    if (_compression.find("zlib") == std::string::npos)
+      _compression = "zlib";
+  }
+#endif
+}
+
+unsigned long MySQLConnectionOptions::prepare(MYSQL *mysql, const std::string &key) {
+  base::MutexLock lock(_mutex);
+  unsigned long flags = 0;
+
+#if MYSQL_VERSION_ID >= 80018
+  // The first algorithm of the list the server also supports is used, the CLIENT_COMPRESS flag is not needed.
+  mysql_options(mysql, MYSQL_OPT_COMPRESSION_ALGORITHMS, _compression.c_str());
+#else
+  if (_compression.find("zlib") != std::string::npos)
+    flags |= CLIENT_COMPRESS;
+#endif
+
+#if MYSQL_VERSION_ID >= 80029
+  std::map<std::string, std::string>::const_iterator session = _tls_sessions.find(key);
+  if (session != _tls_sessions.end())
+    mysql_options(mysql, MYSQL_OPT_SSL_SESSION_DATA, session->second.c_str());
+#endif
+
+  return flags;
+}
+
+void MySQLConnectionOptions::connected(MYSQL *mysql, const std::string &key) {
+#if MYSQL_VERSION_ID >= 80029
+  if (mysql_get_ssl_session_reused(mysql))
+    logDebug("Resumed the TLS session of an earlier connection to %s\n", key.c_str());
+
+  // Servers may hand out single use tickets, so the newest session is kept rather than the first one.
+  void *data = mysql_get_ssl_session_data(mysql, 0, NULL);
+  if (data) {
+    base::MutexLock lock(_mutex);
+    _tls_sessions[key] = (const char *)data;
+    mysql_free_ssl_session_data(mysql, data);
+  }
+#endif
+}
+
 MySQLCopyDataSource::MySQLCopyDataSource(const std::string &hostname, int port, const std::string &username,
                                          const std::string &password, const std::string &socket,
                                          bool use_cleartext_plugin, unsigned int connection_timeout)
@@ -1225,11 +1807,13 @@ MySQLCopyDataSource::MySQLCopyDataSource(const std::string &hostname, int port,
 
 #endif
 
+  std::string key = base::strfmt("%s@%s:%i%s", username.c_str(), host.c_str(), port, socket.c_str());
   if (!mysql_real_connect(&_mysql, host.c_str(), username.c_str(), password.c_str(), NULL, port, socket.c_str(),
-                          CLIENT_COMPRESS)) {
+                          MySQLConnectionOptions::prepare(&_mysql, key))) {
     logError("Failed opening connection to MySQL: %s\n", mysql_error(&_mysql));
     throw ConnectionError("mysql_real_connect", &_mysql);
   }
+  MySQLConnectionOptions::connected(&_mysql, key);
   logInfo("Connection to MySQL opened\n");
 
   std::string q = "SET NAMES 'utf8'";
@@ -1265,6 +1849,8 @@ size_t MySQLCopyDataSource::count_rows(const std::string &schema, const std::str
           base::strfmt("SELECT count(*) FROM %s WHERE %s AND %s", table.c_str(), start_expr.c_str(), end_expr.c_str());
       else
         q = base::strfmt("SELECT count(*) FROM %s WHERE %s", table.c_str(), start_expr.c_str());
+      if (spec.resume && last_pkeys.size())
+        q += base::strfmt(" AND (%s)", get_where_condition(pk_columns, last_pkeys).c_str());
       break;
     }
     case CopyCount: {
@@ -1303,6 +1889,54 @@ size_t MySQLCopyDataSource::count_rows(const std::string &schema, const std::str
   return (size_t)count;
 }
 
+bool MySQLCopyDataSource::estimate_rows(const std::string &schema, const std::string &table, long long &count) {
+  // TABLE_ROWS is exact for MyISAM and an estimate from the index statistics for InnoDB, NULL for views.
+  std::string q = base::strfmt(
+    "SELECT TABLE_ROWS FROM INFORMATION_SCHEMA.TABLES WHERE TABLE_SCHEMA = '%s' AND TABLE_NAME = '%s'",
+    base::escape_sql_string(base::unquote_identifier(schema)).c_str(),
+    base::escape_sql_string(base::unquote_identifier(table)).c_str());
+
+  logDebug("Executing query: %s\n", q.c_str());
+  if (mysql_query(&_mysql, q.data()) != 0)
+    throw ConnectionError("mysql_query(" + q + ")", &_mysql);
+
+  MYSQL_RES *result;
+  if ((result = mysql_use_result(&_mysql)) == NULL)
+    throw ConnectionError("MySQL query", &_mysql);
+
+  bool ret_val = false;
+  MYSQL_ROW row = mysql_fetch_row(result);
+  if (row)
+    ret_val = parse_key_value(row[0], count);
+
+  mysql_free_result(result);
+
+  return ret_val;
+}
+
+bool MySQLCopyDataSource::get_key_range(const std::string &schema, const std::string &table, const std::string &key,
+                                        long long &min_value, long long &max_value) {
+  std::string q =
+    base::strfmt("SELECT MIN(%s), MAX(%s) FROM %s.%s", key.c_str(), key.c_str(), schema.c_str(), table.c_str());
+
+  logDebug("Executing query: %s\n", q.c_str());
+  if (mysql_query(&_mysql, q.data()) != 0)
+    throw ConnectionError("mysql_query(" + q + ")", &_mysql);
+
+  MYSQL_RES *result;
+  if ((result = mysql_use_result(&_mysql)) == NULL)
+    throw ConnectionError("MySQL query", &_mysql);
+
+  bool ret_val = false;
+  MYSQL_ROW row = mysql_fetch_row(result);
+  if (row)
+    ret_val = parse_key_value(row[0], min_value) && parse_key_value(row[1], max_value);
+
+  mysql_free_result(result);
+
+  return ret_val;
+}
+
 std::shared_ptr<std::vector<ColumnInfo> > MySQLCopyDataSource::begin_select_table(
   const std::string &schema, const std::string &table, const std::vector<std::string> &pk_columns,
   const std::string &select_expression, const CopySpec &spec, const std::vector<std::string> &last_pkeys) {
@@ -1411,24 +2045,20 @@ bool MySQLCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
               rowbuffer[index].buffer_type == MYSQL_TYPE_LONG_BLOB || rowbuffer[index].buffer_type == MYSQL_TYPE_BLOB ||
               rowbuffer[index].buffer_type == MYSQL_TYPE_STRING ||
               rowbuffer[index].buffer_type == MYSQL_TYPE_GEOMETRY || rowbuffer[index].buffer_type == MYSQL_TYPE_JSON) {
-            if (rowbuffer[index].buffer_length)
-              free(rowbuffer[index].buffer);
-
-            rowbuffer[index].buffer_length = *rowbuffer[index].length;
+            unsigned long length = *rowbuffer[index].length;
 
-            if (_max_parameter_size >= 0 && rowbuffer[index].buffer_length > (unsigned long long)_max_parameter_size) {
+            if (_max_parameter_size >= 0 && length > (unsigned long long)_max_parameter_size) {
               if (_abort_on_oversized_blobs)
                 throw std::runtime_error(base::strfmt("oversized blob found in table %s.%s, size: %lli",
-                                                      _schema_name.c_str(), _table_name.c_str(),
-                                                      (long long)rowbuffer[index].buffer_length));
+                                                      _schema_name.c_str(), _table_name.c_str(), (long long)length));
               else {
                 printf("oversized blob found in table %s.%s, size: %lli", _schema_name.c_str(), _table_name.c_str(),
-                       (long long)rowbuffer[index].buffer_length);
+                       (long long)length);
                 *rowbuffer[index].is_null = true;
                 continue;
               }
             } else {
-              rowbuffer[index].buffer = malloc(rowbuffer[index].buffer_length);
+              rowbuffer.grow_field(index, length);
 
               mysql_stmt_fetch_column(_select_stmt, &rowbuffer[index], (unsigned int)index, 0);
             }
@@ -1508,8 +2138,117 @@ void MySQLCopyDataTarget::init() {
   }
 }
 
+void MySQLCopyDataSource::get_binlog_position(std::string &file, unsigned long long &position) {
+  // Statement based events of the copied tables can't be applied to the target without the rest of the schema.
+  std::map<std::string, std::string> values;
+  if (!query_named_row(&_mysql, "SHOW VARIABLES LIKE 'binlog_format'", values) ||
+      base::toupper(values["Value"]) != "ROW")
+    throw std::runtime_error("Changes can only be replicated from a source with binlog_format=ROW");
+
+  if (!query_named_row(&_mysql, "SHOW MASTER STATUS", values))
+    throw std::runtime_error("Changes can only be replicated from a source with binary logging enabled");
+
+  file = values["File"];
+  position = strtoull(values["Position"].c_str(), NULL, 10);
+  logInfo("Source binlog position is %s:%llu\n", file.c_str(), position);
+}
+
+void MySQLCopyDataTarget::start_binlog_tail(const BinlogTailSpec &spec) {
+  if (!is_mysql_version_at_least(8, 0, 2))
+    throw std::runtime_error("Replicating changes after the copy needs a target server 8.0.2 or newer");
+
+  // An empty filter would replicate every table of the source.
+  if (spec.tables.empty())
+    throw std::logic_error("No tables to replicate changes into");
+
+  // A channel left over by an earlier run is replaced, that the channel does not exist yet is fine.
+  stop_binlog_tail();
+
+  // Changes made while the copy ran are already in some of the copied rows, applying them again must not fail.
+  std::string q = "SET GLOBAL slave_exec_mode = 'IDEMPOTENT'";
+  if (mysql_query(&_mysql, q.c_str()) != 0)
+    throw ConnectionError(q, &_mysql);
+
+  q = base::sqlstring("CHANGE MASTER TO MASTER_HOST = ?, MASTER_PORT = ", 0) << spec.host;
+  q += base::strfmt("%i", spec.port);
+  q += base::sqlstring(", MASTER_USER = ?, MASTER_PASSWORD = ?, MASTER_LOG_FILE = ?, ", 0) << spec.user
+                                                                                          << spec.password << spec.file;
+  q += base::strfmt("MASTER_LOG_POS = %llu, GET_MASTER_PUBLIC_KEY = 1 FOR CHANNEL '%s'", spec.position, CDC_CHANNEL);
+  if (mysql_query(&_mysql, q.c_str()) != 0)
+    throw ConnectionError("CHANGE MASTER TO ... FOR CHANNEL '" CDC_CHANNEL "'", &_mysql);
+
+  // Only the copied tables are replicated, into the schemas they were copied to.
+  std::string tables, rewrites;
+  for (std::set<std::string>::const_iterator table = spec.tables.begin(); table != spec.tables.end(); ++table) {
+    std::string::size_type dot = table->find('.');
+    tables += (tables.empty() ? "" : ", ") + std::string(base::sqlstring("!.!", 0) << table->substr(0, dot)
+                                                                                   << table->substr(dot + 1));
+  }
+  for (std::map<std::string, std::string>::const_iterator schema = spec.rewrite_schemas.begin();
+       schema != spec.rewrite_schemas.end(); ++schema) {
+    if (schema->first != schema->second)
+      rewrites += (rewrites.empty() ? "(" : ", (") +
+                  std::string(base::sqlstring("!, !)", 0) << schema->first << schema->second);
+  }
+  q = "CHANGE REPLICATION FILTER REPLICATE_DO_TABLE = (" + tables + ")";
+  if (!rewrites.empty())
+    q += ", REPLICATE_REWRITE_DB = (" + rewrites + ")";
+  q += " FOR CHANNEL '" CDC_CHANNEL "'";
+  logDebug("Executing query: %s\n", q.c_str());
+  if (mysql_query(&_mysql, q.c_str()) != 0)
+    throw ConnectionError(q, &_mysql);
+
+  q = "START SLAVE FOR CHANNEL '" CDC_CHANNEL "'";
+  if (mysql_query(&_mysql, q.c_str()) != 0)
+    throw ConnectionError(q, &_mysql);
+  logInfo("Replicating changes from %s:%llu of %s:%i\n", spec.file.c_str(), spec.position, spec.host.c_str(),
+          spec.port);
+}
+
+long long MySQLCopyDataTarget::binlog_tail_lag(std::string &applied_file, unsigned long long &applied_position) {
+  std::map<std::string, std::string> status;
+  if (!query_named_row(&_mysql, "SHOW SLAVE STATUS FOR CHANNEL '" CDC_CHANNEL "'", status))
+    throw std::runtime_error("The replication channel '" CDC_CHANNEL "' does not exist on the target");
+
+  if (!status["Last_SQL_Error"].empty())
+    throw std::runtime_error("Applying the changes of the source failed: " + status["Last_SQL_Error"]);
+  if (!status["Last_IO_Error"].empty() && status["Slave_IO_Running"] != "Yes")
+    throw std::runtime_error("Reading the changes of the source failed: " + status["Last_IO_Error"]);
+
+  applied_file = status["Relay_Master_Log_File"];
+  applied_position = strtoull(status["Exec_Master_Log_Pos"].c_str(), NULL, 10);
+  if (status["Seconds_Behind_Master"].empty())
+    return -1;
+  return strtoll(status["Seconds_Behind_Master"].c_str(), NULL, 10);
+}
+
+bool MySQLCopyDataTarget::wait_binlog_tail(const std::string &file, unsigned long long position, int timeout) {
+  std::string q = base::sqlstring("SELECT MASTER_POS_WAIT(?, ", 0) << file;
+  q += base::strfmt("%llu, %i, '%s') AS result", position, timeout, CDC_CHANNEL);
+
+  // NULL if the replication stopped, -1 on timeout.
+  std::map<std::string, std::string> values;
+  if (!query_named_row(&_mysql, q, values) || values["result"].empty())
+    throw std::runtime_error("The replication channel '" CDC_CHANNEL "' is not running on the target");
+  return values["result"] != "-1";
+}
+
+void MySQLCopyDataTarget::stop_binlog_tail() {
+  // Errors 3074 (no such channel) and 1255 (not running) just mean there is nothing to stop.
+  const char *queries[] = {"STOP SLAVE FOR CHANNEL '" CDC_CHANNEL "'", "RESET SLAVE ALL FOR CHANNEL '" CDC_CHANNEL "'"};
+  for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+    if (mysql_query(&_mysql, queries[i]) != 0 && mysql_errno(&_mysql) != 3074 && mysql_errno(&_mysql) != 1255)
+      throw ConnectionError(queries[i], &_mysql);
+  }
+
+  std::string q = "SET GLOBAL slave_exec_mode = 'STRICT'";
+  if (mysql_query(&_mysql, q.c_str()) != 0)
+    throw ConnectionError(q, &_mysql);
+}
+
 std::vector<std::string> MySQLCopyDataTarget::get_last_pkeys(const std::vector<std::string> &pk_columns,
-                                                             const std::string &schema, const std::string &table) {
+                                                             const std::string &schema, const std::string &table,
+                                                             const std::string &where_condition) {
   std::vector<std::string> ret;
   std::string order_by_cond;
   if (pk_columns.empty())
@@ -1522,8 +2261,9 @@ std::vector<std::string> MySQLCopyDataTarget::get_last_pkeys(const std::vector<s
   }
 
   const std::string q =
-    base::strfmt("SELECT %s FROM %s.%s ORDER BY %s LIMIT 0,1", boost::algorithm::join(pk_columns, ", ").c_str(),
-                 schema.c_str(), table.c_str(), order_by_cond.c_str());
+    base::strfmt("SELECT %s FROM %s.%s%s ORDER BY %s LIMIT 0,1", boost::algorithm::join(pk_columns, ", ").c_str(),
+                 schema.c_str(), table.c_str(), where_condition.empty() ? "" : (" WHERE " + where_condition).c_str(),
+                 order_by_cond.c_str());
   if (mysql_query(&_mysql, q.data()) != 0)
     throw ConnectionError("mysql_query(" + q + ")", &_mysql);
 
@@ -1609,6 +2349,13 @@ void MySQLCopyDataTarget::get_server_value(const std::string &variable, unsigned
   mysql_free_result(result);
 }
 
+long long MySQLCopyDataTarget::wire_bytes_received() {
+  std::map<std::string, std::string> values;
+  if (!query_named_row(&_mysql, "SHOW SESSION STATUS LIKE 'Bytes_received'", values))
+    return 0;
+  return strtoll(values["Value"].c_str(), NULL, 10);
+}
+
 void MySQLCopyDataTarget::get_server_version() {
   std::string version;
 
@@ -1745,7 +2492,7 @@ MySQLCopyDataTarget::MySQLCopyDataTarget(const std::string &hostname, int port,
                                          const std::string &password, const std::string &socket,
                                          bool use_cleartext_plugin, const std::string &app_name,
                                          const std::string &incoming_charset, const std::string &source_rdbms_type,
-                                         const unsigned int connection_timeout)
+                                         const unsigned int connection_timeout, bool local_infile)
   : _insert_stmt(NULL),
     _max_allowed_packet(1000000),
     _max_long_data_size(1000000), // 1M default
@@ -1757,6 +2504,10 @@ MySQLCopyDataTarget::MySQLCopyDataTarget(const std::string &hostname, int port,
     _bulk_insert_buffer(this),
     _bulk_insert_record(this),
     _bulk_insert_batch(0),
+    _use_load_data(false),
+    _local_infile(local_infile),
+    _defer_indexes(false),
+    _bytes_sent(0),
     _source_rdbms_type(source_rdbms_type),
     _connection_timeout(connection_timeout) {
   std::string host = hostname;
@@ -1816,11 +2567,17 @@ MySQLCopyDataTarget::MySQLCopyDataTarget(const std::string &hostname, int port,
 
 #endif
 
+  // CLIENT_LOCAL_FILES is negotiated in the handshake, so LOAD DATA LOCAL has to be enabled before connecting
+  if (_local_infile)
+    enable_local_infile();
+
+  std::string key = base::strfmt("%s@%s:%i%s", username.c_str(), host.c_str(), port, socket.c_str());
   if (!mysql_real_connect(&_mysql, hostname.c_str(), username.c_str(), password.c_str(), NULL, port, socket.c_str(),
-                          CLIENT_COMPRESS)) {
+                          MySQLConnectionOptions::prepare(&_mysql, key))) {
     logError("Failed opening connection to MySQL: %s\n", mysql_error(&_mysql));
     throw ConnectionError("mysql_real_connect", &_mysql);
   }
+  MySQLConnectionOptions::connected(&_mysql, key);
   logInfo("Connection to MySQL opened\n");
 
   init();
@@ -1936,7 +2693,9 @@ void MySQLCopyDataTarget::set_target_table(const std::string &schema, const std:
   // TODO: Bulk inserts should be disabled when a single record can be bigger than the max_packet_size
   _use_bulk_inserts = true;
   if (_use_bulk_inserts) {
-    _bulk_insert_buffer.reset(_max_allowed_packet);
+    // LOAD DATA streams its data in packets, so its buffer is not limited by max_allowed_packet
+    _bulk_insert_buffer.reset(_use_load_data ? std::max<size_t>(LOAD_DATA_BUFFER_SIZE, _max_allowed_packet)
+                                             : _max_allowed_packet);
     _bulk_insert_record.reset(_max_allowed_packet);
   }
 }
@@ -1953,9 +2712,19 @@ void MySQLCopyDataTarget::begin_inserts() {
 
   // Initialize variables for non prepared insert statement
   _bulk_insert_query = ps_query();
+  if (_use_load_data)
+    _load_data_query = load_data_query();
   _init_bulk_insert = true;
   _bulk_record_count = 0;
 
+  // Every table starts over from the configured size, as row widths differ
+  if (_batch_sizer.enabled) {
+    if (_batch_sizer.initial_size == 0)
+      _batch_sizer.initial_size = _bulk_insert_batch;
+    _batch_sizer.reset(_batch_sizer.initial_size);
+    _bulk_insert_batch = _batch_sizer.initial_size;
+  }
+
   // The RowBuffer is used by the CopyDataSources to store in it the data read from the
   // database, once the data is loaded in it, it is used for both bulk inserts
   // and prepared statements
@@ -1992,7 +2761,12 @@ int MySQLCopyDataTarget::end_inserts(bool flush) {
 
   // When doing bulk inserts it is possible that some records are still pending on the
   // _bulk_insert_buffer or _bulk_insert_record so they need to be inserted
-  if (_use_bulk_inserts) {
+  if (_use_load_data) {
+    if (flush)
+      ret_val = send_load_data();
+    _bulk_insert_buffer.reset(_bulk_insert_buffer.size);
+    _bulk_record_count = 0;
+  } else if (_use_bulk_inserts) {
     if (flush) {
       if (_bulk_insert_buffer.length)
         ret_val = do_insert(true);
@@ -2011,8 +2785,15 @@ int MySQLCopyDataTarget::end_inserts(bool flush) {
 }
 
 int MySQLCopyDataTarget::do_insert(bool final) {
+  return do_insert(*_row_buffer, final);
+}
+
+int MySQLCopyDataTarget::do_insert(RowBuffer &row, bool final) {
   int ret_val = 0;
 
+  if (_use_load_data)
+    return load_data_insert(row, final);
+
   if (_use_bulk_inserts) {
     bool add_comma = true;
 
@@ -2037,7 +2818,7 @@ int MySQLCopyDataTarget::do_insert(bool final) {
     // Then continues with the formatting
     if (!final) {
       // Formats the next record into _bulk_insert_record
-      if (format_bulk_record()) {
+      if (format_bulk_record(row)) {
         // Next record + 1 as the comma also counts
         if (_bulk_insert_buffer.space_left() >= (_bulk_insert_record.length + (add_comma ? 1 : 0))) {
           if (add_comma)
@@ -2058,36 +2839,124 @@ int MySQLCopyDataTarget::do_insert(bool final) {
     if (do_insert) {
       ret_val = _bulk_record_count;
       _init_bulk_insert = true;
+      gint64 started = g_get_monotonic_time();
       if (mysql_real_query(&_mysql, _bulk_insert_buffer.buffer, (unsigned long)_bulk_insert_buffer.length) != 0) {
         _bulk_insert_buffer.buffer[_bulk_insert_buffer.length] = 0;
         logInfo("Statement execution failed: %s:\n%s\n", mysql_error(&_mysql), _bulk_insert_buffer.buffer);
 
         throw ConnectionError("Inserting Data", &_mysql);
       }
+      _bytes_sent += _bulk_insert_buffer.length;
+      // The final flush is usually a partial batch, which says nothing about the best size
+      if (_batch_sizer.enabled && !final) {
+        int size = _batch_sizer.statement_done(_bulk_insert_batch, _bulk_record_count, _bulk_insert_buffer.length,
+                                               g_get_monotonic_time() - started, _max_allowed_packet);
+        if (size != _bulk_insert_batch) {
+          logDebug2("Bulk insert batch size for %s.%s changed from %i to %i rows\n", _schema.c_str(), _table.c_str(),
+                    _bulk_insert_batch, size);
+          _bulk_insert_batch = size;
+        }
+      }
       _bulk_insert_buffer.reset(_max_allowed_packet);
       _bulk_record_count = 0;
     }
   } else {
+    // The statement was bound to the target's own row buffer in begin_inserts
+    if (&row != _row_buffer && mysql_stmt_bind_param(_insert_stmt, &row[0]) != 0)
+      throw ConnectionError("mysql_stmt_bind_param", _insert_stmt);
+
     if (mysql_stmt_execute(_insert_stmt) != 0)
       throw ConnectionError("mysql_stmt_execute", _insert_stmt);
 
+    for (size_t index = 0; index < row.size(); index++) {
+      if (!*row[index].is_null)
+        _bytes_sent += row[index].length ? *row[index].length : row[index].buffer_length;
+    }
     ret_val = 1;
   }
 
   return ret_val;
 }
 
-bool MySQLCopyDataTarget::format_bulk_record() {
+void MySQLCopyDataTarget::BatchSizer::reset(int size) {
+  initial_size = size;
+  direction = 1;
+  best_rate = 0;
+  window_statements = 0;
+  window_rows = 0;
+  window_bytes = 0;
+  window_usecs = 0;
+}
+
+/*
+ * statement_done : accounts an executed bulk INSERT and, once enough statements were measured, decides
+ *                  about the batch size to use next.
+ *
+ * Parameters:
+ *   - current_size : the batch size in use
+ *   - rows, bytes : number of rows and size of the statement that was executed
+ *   - usecs : server round-trip time of the statement
+ *   - max_bytes : max_allowed_packet of the server
+ *
+ * Remarks : This is a simple hill climbing. The batch keeps doubling (or halving) as long as the insert
+ *           rate improves and turns around as soon as it gets noticeably worse. The best rate decays a bit
+ *           on every step so that changing conditions (e.g. a busier server) get picked up. The size is
+ *           capped to what fits into max_allowed_packet, given the measured bytes per row, so growing
+ *           never just results in statements being flushed early because the buffer is full.
+ *
+ * Returns the batch size to use for the coming statements.
+ */
+int MySQLCopyDataTarget::BatchSizer::statement_done(int current_size, int rows, size_t bytes, gint64 usecs,
+                                                    size_t max_bytes) {
+  window_statements++;
+  window_rows += rows;
+  window_bytes += bytes;
+  window_usecs += usecs;
+
+  if (window_statements < ADAPTIVE_BATCH_WINDOW || window_rows == 0)
+    return current_size;
+
+  double rate = (double)window_rows * 1000000.0 / (double)std::max<gint64>(window_usecs, 1);
+  int max_size = (int)std::min<long long>(ADAPTIVE_BATCH_MAX_ROWS, (long long)(max_bytes * 0.9) /
+                                                                      std::max<long long>(window_bytes / window_rows, 1));
+  window_statements = 0;
+  window_rows = 0;
+  window_bytes = 0;
+  window_usecs = 0;
+
+  if (rate > best_rate * 1.05)
+    best_rate = rate;
+  else if (rate < best_rate * 0.95) {
+    direction = -direction;
+    best_rate *= 0.98;
+  } else {
+    // No real difference, stay where we are
+    best_rate *= 0.98;
+    return std::max(ADAPTIVE_BATCH_MIN_ROWS, std::min(current_size, max_size));
+  }
+
+  int size = direction > 0 ? current_size * 2 : current_size / 2;
+  if (size >= max_size) {
+    size = max_size;
+    direction = -1;
+  } else if (size <= ADAPTIVE_BATCH_MIN_ROWS) {
+    size = ADAPTIVE_BATCH_MIN_ROWS;
+    direction = 1;
+  }
+  return std::max(ADAPTIVE_BATCH_MIN_ROWS, size);
+}
+
+bool MySQLCopyDataTarget::format_bulk_record(RowBuffer &row) {
   bool ret_val = true;
   _bulk_insert_record.append("(", 1);
 
-  for (size_t index = 0; ret_val && index < _row_buffer->size() - 1; index++) {
-    ret_val = append_bulk_column(index);
+  for (size_t index = 0; ret_val && index < row.size() - 1; index++) {
+    ret_val = append_bulk_column(row, index);
     _bulk_insert_record.append(",", 1);
   }
 
   if (ret_val) {
-    ret_val = append_bulk_column(_row_buffer->size() - 1);
+    ret_val = append_bulk_column(row, row.size() - 1);
 
     if (ret_val)
       ret_val = _bulk_insert_record.append(")", 1);
@@ -2096,73 +2965,73 @@ bool MySQLCopyDataTarget::format_bulk_record() {
   return ret_val;
 }
 
-bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
+bool MySQLCopyDataTarget::append_bulk_column(RowBuffer &row, size_t col_index) {
   std::string data;
   bool ret_val = true;
 
-  if (*(*_row_buffer)[col_index].is_null)
+  if (*row[col_index].is_null)
     ret_val = _bulk_insert_record.append("NULL", 4);
   else {
-    switch ((*_row_buffer)[col_index].buffer_type) {
+    switch (row[col_index].buffer_type) {
       case MYSQL_TYPE_NULL:
         ret_val = _bulk_insert_record.append("NULL", 4);
         break;
       case MYSQL_TYPE_TINY:
-        if ((*_row_buffer)[col_index].is_unsigned) {
-          unsigned char *val_char = (unsigned char *)(*_row_buffer)[col_index].buffer;
+        if (row[col_index].is_unsigned) {
+          unsigned char *val_char = (unsigned char *)row[col_index].buffer;
           data = base::strfmt("%u", *val_char);
         } else {
-          char *val_char = (char *)(*_row_buffer)[col_index].buffer;
+          char *val_char = (char *)row[col_index].buffer;
           data = base::strfmt("%d", *val_char);
         }
         ret_val = _bulk_insert_record.append(data.data(), data.length());
         break;
       case MYSQL_TYPE_SHORT:
       case MYSQL_TYPE_YEAR:
-        if ((*_row_buffer)[col_index].is_unsigned) {
-          unsigned short *val_short = (unsigned short *)(*_row_buffer)[col_index].buffer;
+        if (row[col_index].is_unsigned) {
+          unsigned short *val_short = (unsigned short *)row[col_index].buffer;
           data = base::strfmt("%u", *val_short);
         } else {
-          short *val_short = (short *)(*_row_buffer)[col_index].buffer;
+          short *val_short = (short *)row[col_index].buffer;
           data = base::strfmt("%d", *val_short);
         }
         ret_val = _bulk_insert_record.append(data.data(), data.length());
         break;
       case MYSQL_TYPE_INT24:
       case MYSQL_TYPE_LONG:
-        if ((*_row_buffer)[col_index].is_unsigned) {
-          unsigned int *val_int = (unsigned int *)(*_row_buffer)[col_index].buffer;
+        if (row[col_index].is_unsigned) {
+          unsigned int *val_int = (unsigned int *)row[col_index].buffer;
           data = base::strfmt("%u", *val_int);
         } else {
-          int *val_int = (int *)(*_row_buffer)[col_index].buffer;
+          int *val_int = (int *)row[col_index].buffer;
           data = base::strfmt("%i", *val_int);
         }
         ret_val = _bulk_insert_record.append(data.data(), data.length());
         break;
       case MYSQL_TYPE_LONGLONG:
-        if ((*_row_buffer)[col_index].is_unsigned) {
-          unsigned long long int *val_llint = (unsigned long long int *)(*_row_buffer)[col_index].buffer;
+        if (row[col_index].is_unsigned) {
+          unsigned long long int *val_llint = (unsigned long long int *)row[col_index].buffer;
           data = base::strfmt("%llu", *val_llint);
         } else {
-          long long int *val_llint = (long long int *)(*_row_buffer)[col_index].buffer;
+          long long int *val_llint = (long long int *)row[col_index].buffer;
           data = base::strfmt("%lli", *val_llint);
         }
         ret_val = _bulk_insert_record.append(data.data(), data.length());
         break;
       case MYSQL_TYPE_FLOAT: {
-        float *val_float = (float *)(*_row_buffer)[col_index].buffer;
+        float *val_float = (float *)row[col_index].buffer;
         data = base::strfmt("%f", *val_float);
         ret_val = _bulk_insert_record.append(data.data(), data.length());
       } break;
       case MYSQL_TYPE_DOUBLE: {
-        double *val_double = (double *)(*_row_buffer)[col_index].buffer;
+        double *val_double = (double *)row[col_index].buffer;
         data = base::strfmt("%f", *val_double);
         ret_val = _bulk_insert_record.append(data.data(), data.length());
       } break;
       case MYSQL_TYPE_BIT: {
         // As managed as string, an additional byte is added to the length, so
         // we remove that here to know the real legth in bytes
-        std::div_t length = std::div((int)(*_row_buffer)[col_index].buffer_length - 1, 8);
+        std::div_t length = std::div((int)row[col_index].buffer_length - 1, 8);
 
         if (length.rem)
           ++length.quot;
@@ -2171,7 +3040,7 @@ bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
         unsigned int shift = 0;
 
         for (int index = 1; index <= length.quot; index++) {
-          uval += (((unsigned char *)(*_row_buffer)[col_index].buffer)[length.quot - index]) << shift;
+          uval += (((unsigned char *)row[col_index].buffer)[length.quot - index]) << shift;
           shift += 8;
         }
 
@@ -2182,8 +3051,8 @@ bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
       }
       case MYSQL_TYPE_DECIMAL:
       case MYSQL_TYPE_NEWDECIMAL:
-        ret_val = _bulk_insert_record.append_escaped((char *)(*_row_buffer)[col_index].buffer,
-                                                     *(*_row_buffer)[col_index].length);
+        ret_val = _bulk_insert_record.append_escaped((char *)row[col_index].buffer,
+                                                     *row[col_index].length);
         break;
       case MYSQL_TYPE_VAR_STRING:
       case MYSQL_TYPE_VARCHAR:
@@ -2192,8 +3061,8 @@ bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
       case MYSQL_TYPE_SET:
       case MYSQL_TYPE_JSON:
         _bulk_insert_record.append("'", 1);
-        ret_val = _bulk_insert_record.append_escaped((char *)(*_row_buffer)[col_index].buffer,
-                                                     *(*_row_buffer)[col_index].length);
+        ret_val = _bulk_insert_record.append_escaped((char *)row[col_index].buffer,
+                                                     *row[col_index].length);
         _bulk_insert_record.append("'", 1);
         break;
       case MYSQL_TYPE_TIME:
@@ -2201,7 +3070,7 @@ bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
       case MYSQL_TYPE_NEWDATE:
       case MYSQL_TYPE_DATETIME:
       case MYSQL_TYPE_TIMESTAMP: {
-        MYSQL_TIME *ts = (MYSQL_TIME *)(*_row_buffer)[col_index].buffer;
+        MYSQL_TIME *ts = (MYSQL_TIME *)row[col_index].buffer;
         switch (ts->time_type) {
           case MYSQL_TIMESTAMP_DATETIME:
             if (_major_version >= 6 || (_major_version == 5 && _minor_version >= 7) ||
@@ -2234,8 +3103,8 @@ bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
       case MYSQL_TYPE_MEDIUM_BLOB:
       case MYSQL_TYPE_LONG_BLOB:
         _bulk_insert_record.append("'", 1);
-        ret_val = _bulk_insert_record.append_escaped((char *)(*_row_buffer)[col_index].buffer,
-                                                     *(*_row_buffer)[col_index].length);
+        ret_val = _bulk_insert_record.append_escaped((char *)row[col_index].buffer,
+                                                     *row[col_index].length);
         _bulk_insert_record.append("'", 1);
         break;
 
@@ -2252,8 +3121,8 @@ bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
           _bulk_insert_record.append("ST_GeomFromText('");
         else
           _bulk_insert_record.append("GeomFromText('");
-        ret_val = _bulk_insert_record.append_escaped((char *)(*_row_buffer)[col_index].buffer,
-                                                     *(*_row_buffer)[col_index].length);
+        ret_val = _bulk_insert_record.append_escaped((char *)row[col_index].buffer,
+                                                     *row[col_index].length);
         _bulk_insert_record.append("')");
         break;
     }
@@ -2262,46 +3131,236 @@ bool MySQLCopyDataTarget::append_bulk_column(size_t col_index) {
   return ret_val;
 }
 
-RowBuffer &MySQLCopyDataTarget::row_buffer() {
-  return *_row_buffer;
-}
+// -------------------------------------------------------------------------------------------------
 
-long long MySQLCopyDataTarget::get_max_value(const std::string &key) {
-  std::string q = base::sqlstring("SELECT max(!) FROM !.!", 0) << key << _schema << _table;
-  mysql_query(&_mysql, q.c_str());
+// The rows of a LOAD DATA LOCAL INFILE statement are served from memory, with these callbacks
+// replacing the default handler that would read a file from disk.
+struct LoadDataStream {
+  const char *data;
+  size_t length;
+  size_t position;
+};
+
+static int local_infile_init(void **ptr, const char *filename, void *userdata) {
+  *ptr = userdata;
+  if (!userdata)
+    return 1;
+  ((LoadDataStream *)userdata)->position = 0;
   return 0;
 }
 
-void MySQLCopyDataTarget::get_triggers_for_schema(const std::string &schema,
-                                                  std::map<std::string, std::string> &triggers) {
-  // Now pulls the trigger names
-  logDebug("Retrieving trigger list\n");
-  std::string get_trigger_list = base::sqlstring("SHOW TRIGGERS FROM !", 0) << schema;
-  if (mysql_query(&_mysql, get_trigger_list.data()) != 0)
-    throw ConnectionError("Querying Trigger List", &_mysql);
-
-  MYSQL_RES *result;
-  if ((result = mysql_use_result(&_mysql)) == NULL)
-    throw ConnectionError("Getting Trigger List", &_mysql);
+static int local_infile_read(void *ptr, char *buf, unsigned int buf_len) {
+  LoadDataStream *stream = (LoadDataStream *)ptr;
+  size_t count = std::min<size_t>(buf_len, stream->length - stream->position);
+  memcpy(buf, stream->data + stream->position, count);
+  stream->position += count;
+  return (int)count;
+}
 
-  // Gets the trigger names so they can be backed up
-  MYSQL_ROW row;
-  while ((row = mysql_fetch_row(result)))
-    triggers[row[0]] = "";
+static void local_infile_end(void *ptr) {
+}
 
-  mysql_free_result(result);
+static int local_infile_error(void *ptr, char *error_msg, unsigned int error_msg_len) {
+  snprintf(error_msg, error_msg_len, "%s", "LOAD DATA LOCAL INFILE is only accepted for data sent by wbcopytables");
+  return CR_UNKNOWN_ERROR;
 }
 
-bool MySQLCopyDataTarget::get_trigger_definitions_for_schema(const std::string &schema,
-                                                             std::map<std::string, std::string> &triggers) {
-  bool success = true;
-  std::map<std::string, std::string>::iterator index, end = triggers.end();
+void MySQLCopyDataTarget::set_use_load_data(bool flag) {
+  _use_load_data = false;
+  if (!flag)
+    return;
 
-  // Pulls every trigger unless an error is found
-  for (index = triggers.begin(); success && index != end; index++) {
-    bool trigger_pulled = false;
+  if (!_local_infile) {
+    logWarning("The target connection was opened without LOAD DATA LOCAL, using INSERT statements instead\n");
+    return;
+  }
 
-    logDebug("Retrieving trigger definition for: %s\n", index->first.c_str());
+  std::string local_infile;
+  get_server_value("local_infile", local_infile);
+  if (base::toupper(local_infile) != "ON") {
+    logWarning("local_infile is disabled on the target server, using INSERT statements instead of LOAD DATA\n");
+    return;
+  }
+
+  _use_load_data = true;
+}
+
+void MySQLCopyDataTarget::enable_local_infile() {
+  unsigned int enable = 1;
+  mysql_options(&_mysql, MYSQL_OPT_LOCAL_INFILE, &enable);
+
+  // Never leave the default handler in place, it would let the server read any local file
+  mysql_set_local_infile_handler(&_mysql, local_infile_init, local_infile_read, local_infile_end, local_infile_error,
+                                 NULL);
+}
+
+std::string MySQLCopyDataTarget::load_data_query() {
+  std::string columns;
+  std::string assignments;
+  int variable = 0;
+
+  // Values that can't be loaded as text go through user variables and get converted in the SET clause
+  for (std::vector<ColumnInfo>::const_iterator iter = _columns->begin(); iter != _columns->end(); ++iter) {
+    if (!columns.empty())
+      columns.append(", ");
+
+    std::string name = base::sqlstring("!", 0) << iter->target_name;
+    if (iter->target_type == MYSQL_TYPE_BIT || iter->target_type == MYSQL_TYPE_GEOMETRY) {
+      std::string var = base::strfmt("@wb_col%i", ++variable);
+      columns.append(var);
+
+      if (!assignments.empty())
+        assignments.append(", ");
+      if (iter->target_type == MYSQL_TYPE_BIT)
+        assignments.append(base::strfmt("%s = CAST(%s AS UNSIGNED)", name.c_str(), var.c_str()));
+      else
+        assignments.append(base::strfmt("%s = %s(%s)", name.c_str(),
+                                        is_mysql_version_at_least(5, 6, 6) ? "ST_GeomFromText" : "GeomFromText",
+                                        var.c_str()));
+    } else
+      columns.append(name);
+  }
+
+  std::string q = base::strfmt(
+    "LOAD DATA LOCAL INFILE 'wbcopytables' INTO TABLE %s.%s CHARACTER SET %s FIELDS TERMINATED BY '\\t' "
+    "OPTIONALLY ENCLOSED BY '\\'' ESCAPED BY '\\\\' LINES TERMINATED BY '\\n' (%s)",
+    _schema.c_str(), _table.c_str(), _incoming_data_charset.empty() ? "utf8" : _incoming_data_charset.c_str(),
+    columns.c_str());
+  if (!assignments.empty())
+    q.append(" SET ").append(assignments);
+
+  return q;
+}
+
+// Formats a row as a line of tab separated values. Strings are enclosed and escaped exactly like for
+// the INSERT statements, so the same escaping code applies.
+bool MySQLCopyDataTarget::format_load_data_record(RowBuffer &row) {
+  bool ret_val = true;
+
+  for (size_t index = 0; ret_val && index < row.size(); index++) {
+    if (index > 0 && !_bulk_insert_record.append("\t", 1))
+      return false;
+
+    if (row[index].buffer_type == MYSQL_TYPE_NULL || *row[index].is_null)
+      ret_val = _bulk_insert_record.append("\\N", 2);
+    else if (row[index].buffer_type == MYSQL_TYPE_GEOMETRY) {
+      _bulk_insert_record.append("'", 1);
+      ret_val = _bulk_insert_record.append_escaped((char *)row[index].buffer, *row[index].length);
+      _bulk_insert_record.append("'", 1);
+    } else
+      ret_val = append_bulk_column(row, index);
+  }
+
+  if (ret_val)
+    ret_val = _bulk_insert_record.append("\n", 1);
+
+  return ret_val;
+}
+
+int MySQLCopyDataTarget::load_data_insert(RowBuffer &row, bool final) {
+  int ret_val = 0;
+
+  if (!final) {
+    _bulk_insert_record.reset(_max_allowed_packet);
+    if (!format_load_data_record(row))
+      throw std::runtime_error("Found record bigger than max_allowed_packet");
+
+    if (_bulk_insert_record.length <= _bulk_insert_buffer.space_left()) {
+      _bulk_insert_buffer.append(_bulk_insert_record.buffer, _bulk_insert_record.length);
+      _bulk_record_count++;
+      return 0;
+    }
+  }
+
+  // The buffer is full (or this is the end of the data), so it gets sent before taking the pending record
+  ret_val = send_load_data();
+
+  if (!final) {
+    _bulk_insert_buffer.append(_bulk_insert_record.buffer, _bulk_insert_record.length);
+    _bulk_record_count++;
+  }
+
+  return ret_val;
+}
+
+int MySQLCopyDataTarget::send_load_data() {
+  if (_bulk_record_count == 0)
+    return 0;
+
+  LoadDataStream stream = {_bulk_insert_buffer.buffer, _bulk_insert_buffer.length, 0};
+  mysql_set_local_infile_handler(&_mysql, local_infile_init, local_infile_read, local_infile_end, local_infile_error,
+                                 &stream);
+
+  int rc = mysql_real_query(&_mysql, _load_data_query.data(), (unsigned long)_load_data_query.length());
+  _bytes_sent += _load_data_query.length() + _bulk_insert_buffer.length;
+
+  mysql_set_local_infile_handler(&_mysql, local_infile_init, local_infile_read, local_infile_end, local_infile_error,
+                                 NULL);
+
+  if (rc != 0) {
+    logInfo("Statement execution failed: %s:\n%s\n", mysql_error(&_mysql), _load_data_query.c_str());
+    throw ConnectionError("Loading Data", &_mysql);
+  }
+
+  // LOAD DATA LOCAL turns errors like duplicate keys into warnings and skips the rows, which then show
+  // up as rows that failed to be copied
+  int ret_val = (int)mysql_affected_rows(&_mysql);
+  if (ret_val != _bulk_record_count)
+    logWarning("Loaded %i of %i rows into %s.%s (%u warnings)\n", ret_val, _bulk_record_count, _schema.c_str(),
+               _table.c_str(), mysql_warning_count(&_mysql));
+
+  _bulk_insert_buffer.reset(_bulk_insert_buffer.size);
+  _bulk_record_count = 0;
+
+  return ret_val;
+}
+
+RowBuffer &MySQLCopyDataTarget::row_buffer() {
+  return *_row_buffer;
+}
+
+RowBuffer *MySQLCopyDataTarget::create_row_buffer(RowBufferArena *arena) {
+  return new RowBuffer(_columns, std::bind(&MySQLCopyDataTarget::send_long_data, this, std::placeholders::_1,
+                                           std::placeholders::_2, std::placeholders::_3),
+                       _max_allowed_packet, arena);
+}
+
+long long MySQLCopyDataTarget::get_max_value(const std::string &key) {
+  std::string q = base::sqlstring("SELECT max(!) FROM !.!", 0) << key << _schema << _table;
+  mysql_query(&_mysql, q.c_str());
+  return 0;
+}
+
+void MySQLCopyDataTarget::get_triggers_for_schema(const std::string &schema,
+                                                  std::map<std::string, std::string> &triggers) {
+  // Now pulls the trigger names
+  logDebug("Retrieving trigger list\n");
+  std::string get_trigger_list = base::sqlstring("SHOW TRIGGERS FROM !", 0) << schema;
+  if (mysql_query(&_mysql, get_trigger_list.data()) != 0)
+    throw ConnectionError("Querying Trigger List", &_mysql);
+
+  MYSQL_RES *result;
+  if ((result = mysql_use_result(&_mysql)) == NULL)
+    throw ConnectionError("Getting Trigger List", &_mysql);
+
+  // Gets the trigger names so they can be backed up
+  MYSQL_ROW row;
+  while ((row = mysql_fetch_row(result)))
+    triggers[row[0]] = "";
+
+  mysql_free_result(result);
+}
+
+bool MySQLCopyDataTarget::get_trigger_definitions_for_schema(const std::string &schema,
+                                                             std::map<std::string, std::string> &triggers) {
+  bool success = true;
+  std::map<std::string, std::string>::iterator index, end = triggers.end();
+
+  // Pulls every trigger unless an error is found
+  for (index = triggers.begin(); success && index != end; index++) {
+    bool trigger_pulled = false;
+
+    logDebug("Retrieving trigger definition for: %s\n", index->first.c_str());
 
     std::string get_trigger = base::sqlstring("SHOW CREATE TRIGGER !.!", 0) << schema << index->first;
     if (mysql_query(&_mysql, get_trigger.data()) == 0) {
@@ -2483,6 +3542,301 @@ void MySQLCopyDataTarget::restore_triggers(std::set<std::string> &schemas) {
   }
 }
 
+void MySQLCopyDataTarget::get_column_types(const std::string &schema, const std::string &table,
+                                           std::map<std::string, std::string> &types) {
+  std::string query = base::sqlstring("SELECT COLUMN_NAME, DATA_TYPE FROM information_schema.COLUMNS WHERE "
+                                      "TABLE_SCHEMA = ? AND TABLE_NAME = ?",
+                                      0)
+                      << base::unquote_identifier(schema) << base::unquote_identifier(table);
+  if (mysql_query(&_mysql, query.c_str()) != 0)
+    throw ConnectionError("Querying column types", &_mysql);
+
+  MYSQL_RES *result = mysql_store_result(&_mysql);
+  if (!result)
+    throw ConnectionError("Getting column types", &_mysql);
+
+  MYSQL_ROW row;
+  while ((row = mysql_fetch_row(result)))
+    types[row[0]] = base::tolower(row[1] ? row[1] : "");
+  mysql_free_result(result);
+}
+
+void MySQLCopyDataTarget::get_chunk_checksums(const std::string &schema, const std::string &table,
+                                              const std::string &key, long long chunk_keys,
+                                              const std::string &row_expression, const std::string &where_condition,
+                                              std::map<long long, std::pair<long long, unsigned int> > &chunks) {
+  std::string query = base::strfmt("SELECT FLOOR(%s / %lli), COUNT(*), BIT_XOR(CRC32(%s)) FROM %s.%s", key.c_str(),
+                                   chunk_keys, row_expression.c_str(), schema.c_str(), table.c_str());
+  if (!where_condition.empty())
+    query.append(" WHERE ").append(where_condition);
+  query.append(" GROUP BY 1");
+
+  if (mysql_real_query(&_mysql, query.data(), (unsigned long)query.length()) != 0)
+    throw ConnectionError("Computing chunk checksums", &_mysql);
+
+  MYSQL_RES *result = mysql_use_result(&_mysql);
+  if (!result)
+    throw ConnectionError("Getting chunk checksums", &_mysql);
+
+  MYSQL_ROW row;
+  while ((row = mysql_fetch_row(result)))
+    chunks[base::atoi<long long>(row[0], 0)] =
+      std::make_pair(base::atoi<long long>(row[1], 0), (unsigned int)strtoul(row[2] ? row[2] : "0", NULL, 10));
+  mysql_free_result(result);
+}
+
+void MySQLCopyDataTarget::get_row_checksums(const std::string &schema, const std::string &table,
+                                            const std::string &key, const std::string &row_expression,
+                                            const std::string &where_condition,
+                                            std::unordered_map<long long, unsigned int> &rows) {
+  std::string query = base::strfmt("SELECT %s, CRC32(%s) FROM %s.%s WHERE %s", key.c_str(), row_expression.c_str(),
+                                   schema.c_str(), table.c_str(), where_condition.c_str());
+  if (mysql_real_query(&_mysql, query.data(), (unsigned long)query.length()) != 0)
+    throw ConnectionError("Computing row checksums", &_mysql);
+
+  MYSQL_RES *result = mysql_use_result(&_mysql);
+  if (!result)
+    throw ConnectionError("Getting row checksums", &_mysql);
+
+  MYSQL_ROW row;
+  while ((row = mysql_fetch_row(result)))
+    rows[base::atoi<long long>(row[0], 0)] = (unsigned int)strtoul(row[1] ? row[1] : "0", NULL, 10);
+  mysql_free_result(result);
+}
+
+void MySQLCopyDataTarget::delete_rows(const std::string &schema, const std::string &table,
+                                      const std::string &where_condition) {
+  std::string query = base::strfmt("DELETE FROM %s.%s WHERE %s", schema.c_str(), table.c_str(), where_condition.c_str());
+  if (mysql_real_query(&_mysql, query.data(), (unsigned long)query.length()) != 0)
+    throw ConnectionError("Deleting rows", &_mysql);
+}
+
+/*
+ * backup_indexes : saves the definitions of the secondary indexes of a table into a backup table and drops
+ *                  them, so they aren't maintained row by row during the copy.
+ *
+ * Parameters:
+ *   - schema, table : the target table
+ *
+ * Remarks : Only plain non unique indexes are deferred. Unique indexes keep enforcing their constraint
+ *           while the rows arrive and functional indexes can't be rebuilt from information_schema. The
+ *           definitions go into TMP_INDEX_TABLE in the same schema before anything is dropped, so an aborted
+ *           copy can still be completed by restore_indexes later, the same way trigger backups work.
+ */
+void MySQLCopyDataTarget::backup_indexes(const std::string &quoted_schema, const std::string &quoted_table) {
+  // The names of the copy tasks come quoted
+  std::string schema = base::unquote_identifier(quoted_schema);
+  std::string table = base::unquote_identifier(quoted_table);
+  std::map<std::string, std::string> indexes;
+  std::set<std::string> functional;
+
+  std::string query = base::sqlstring(
+                        "SELECT INDEX_NAME, NON_UNIQUE, COLUMN_NAME, SUB_PART, COLLATION, INDEX_TYPE, INDEX_COMMENT "
+                        "FROM information_schema.STATISTICS WHERE TABLE_SCHEMA = ? AND TABLE_NAME = ? AND "
+                        "INDEX_NAME <> 'PRIMARY' ORDER BY INDEX_NAME, SEQ_IN_INDEX",
+                        0)
+                      << schema << table;
+  if (mysql_query(&_mysql, query.c_str()) != 0)
+    throw ConnectionError("Querying index definitions", &_mysql);
+
+  MYSQL_RES *result = mysql_store_result(&_mysql);
+  if (!result)
+    throw ConnectionError("Getting index definitions", &_mysql);
+
+  std::map<std::string, std::string> index_types, index_comments;
+  std::set<std::string> unique;
+  MYSQL_ROW row;
+  while ((row = mysql_fetch_row(result))) {
+    std::string name = row[0];
+    if (row[1] && strcmp(row[1], "0") == 0)
+      unique.insert(name);
+    if (!row[2]) {
+      functional.insert(name);
+      continue;
+    }
+
+    std::string &columns(indexes[name]);
+    if (!columns.empty())
+      columns.append(", ");
+    columns.append(base::sqlstring("!", 0) << row[2]);
+    if (row[3])
+      columns.append("(").append(row[3]).append(")");
+    if (row[4] && strcmp(row[4], "D") == 0)
+      columns.append(" DESC");
+    index_types[name] = row[5] ? row[5] : "";
+    index_comments[name] = row[6] ? row[6] : "";
+  }
+  mysql_free_result(result);
+
+  std::map<std::string, std::string> definitions;
+  for (std::map<std::string, std::string>::const_iterator index = indexes.begin(); index != indexes.end(); ++index) {
+    if (unique.find(index->first) != unique.end() || functional.find(index->first) != functional.end())
+      continue;
+
+    std::string type = index_types[index->first];
+    std::string sql;
+    if (type == "FULLTEXT" || type == "SPATIAL")
+      sql = base::sqlstring((type + " INDEX ! (").c_str(), 0) << index->first;
+    else
+      sql = base::sqlstring("INDEX ! (", 0) << index->first;
+    sql.append(index->second).append(")");
+    if (type == "BTREE" || type == "HASH")
+      sql.append(" USING ").append(type);
+    if (!index_comments[index->first].empty())
+      sql.append(base::sqlstring(" COMMENT ?", 0) << index_comments[index->first]);
+    definitions[index->first] = sql;
+  }
+
+  if (definitions.empty())
+    return;
+
+  logInfo("Deferring %lu secondary indexes of %s.%s\n", (unsigned long)definitions.size(), schema.c_str(),
+          table.c_str());
+
+  std::string create_index_backup_table =
+    base::sqlstring("CREATE TABLE IF NOT EXISTS !.! (! VARCHAR(64) NOT NULL, ! VARCHAR(64) NOT NULL, ! MEDIUMTEXT, "
+                    "PRIMARY KEY (!, !))",
+                    0)
+    << schema << TMP_INDEX_TABLE << "table_name"
+    << "index_name"
+    << "index_sql"
+    << "table_name"
+    << "index_name";
+  if (mysql_query(&_mysql, create_index_backup_table.c_str()) != 0)
+    throw ConnectionError("Unable to create index backup table", &_mysql);
+
+  std::string drop = base::sqlstring("ALTER TABLE !.!", 0) << schema << table;
+  for (std::map<std::string, std::string>::const_iterator index = definitions.begin(); index != definitions.end();
+       ++index) {
+    std::string insert_index = base::sqlstring("INSERT INTO !.! VALUES (?, ?, ?)", 0)
+                               << schema << TMP_INDEX_TABLE << table << index->first << index->second;
+    // The index may be there from a previous run
+    if (mysql_query(&_mysql, insert_index.c_str()) != 0 && mysql_errno(&_mysql) != 1062)
+      throw ConnectionError("Backing up index", &_mysql);
+
+    drop.append(index == definitions.begin() ? " " : ", ").append(base::sqlstring("DROP INDEX !", 0) << index->first);
+  }
+
+  if (mysql_query(&_mysql, drop.c_str()) == 0)
+    return;
+
+  // Indexes needed by a foreign key can't be dropped, so fall back to dropping them one by one
+  // and keep the ones the server refuses
+  logDebug("Dropping indexes of %s.%s at once failed (%s), dropping them one by one\n", schema.c_str(),
+           table.c_str(), mysql_error(&_mysql));
+  for (std::map<std::string, std::string>::const_iterator index = definitions.begin(); index != definitions.end();
+       ++index) {
+    std::string drop_index = base::sqlstring("ALTER TABLE !.! DROP INDEX !", 0) << schema << table << index->first;
+    if (mysql_query(&_mysql, drop_index.c_str()) != 0) {
+      logInfo("Index %s of %s.%s can't be deferred: %s\n", index->first.c_str(), schema.c_str(), table.c_str(),
+              mysql_error(&_mysql));
+
+      std::string delete_index = base::sqlstring("DELETE FROM !.! WHERE ! = ? AND ! = ?", 0)
+                                 << schema << TMP_INDEX_TABLE << "table_name" << table << "index_name"
+                                 << index->first;
+      if (mysql_query(&_mysql, delete_index.c_str()) != 0)
+        throw ConnectionError("Deleting index backup", &_mysql);
+    }
+  }
+}
+
+/*
+ * restore_indexes : recreates the indexes saved by backup_indexes with a single ALTER TABLE per table and
+ *                   removes them from the backup table.
+ *
+ * Parameters:
+ *   - schema : the target schema
+ *   - table : the table to restore the indexes for, or empty for every table found in the backup
+ */
+void MySQLCopyDataTarget::restore_indexes(const std::string &quoted_schema, const std::string &quoted_table) {
+  std::string schema = base::unquote_identifier(quoted_schema);
+  std::string table = base::unquote_identifier(quoted_table);
+  std::string query;
+  if (table.empty())
+    query = base::sqlstring("SELECT !, ! FROM !.! ORDER BY !", 0) << "table_name"
+                                                                   << "index_sql" << schema << TMP_INDEX_TABLE
+                                                                   << "table_name";
+  else
+    query = base::sqlstring("SELECT !, ! FROM !.! WHERE ! = ?", 0) << "table_name"
+                                                                    << "index_sql" << schema << TMP_INDEX_TABLE
+                                                                    << "table_name" << table;
+
+  if (mysql_query(&_mysql, query.c_str()) != 0) {
+    // No backup table, nothing to restore
+    if (mysql_errno(&_mysql) != 1146)
+      throw ConnectionError("Querying index backups", &_mysql);
+    return;
+  }
+
+  MYSQL_RES *result = mysql_store_result(&_mysql);
+  if (!result)
+    throw ConnectionError("Getting index backups", &_mysql);
+
+  std::map<std::string, std::vector<std::string> > indexes;
+  MYSQL_ROW row;
+  while ((row = mysql_fetch_row(result)))
+    indexes[row[0]].push_back(row[1]);
+  mysql_free_result(result);
+
+  for (std::map<std::string, std::vector<std::string> >::const_iterator index = indexes.begin();
+       index != indexes.end(); ++index) {
+    logInfo("Rebuilding %lu secondary indexes of %s.%s\n", (unsigned long)index->second.size(), schema.c_str(),
+            index->first.c_str());
+
+    std::string alter = base::sqlstring("ALTER TABLE !.!", 0) << schema << index->first;
+    for (size_t i = 0; i < index->second.size(); i++)
+      alter.append(i == 0 ? " ADD " : ", ADD ").append(index->second[i]);
+
+    if (mysql_query(&_mysql, alter.c_str()) != 0) {
+      // Some of them may have been restored already by an earlier, interrupted run
+      if (mysql_errno(&_mysql) != 1061)
+        throw ConnectionError("Restoring indexes", &_mysql);
+
+      for (size_t i = 0; i < index->second.size(); i++) {
+        std::string add = base::sqlstring("ALTER TABLE !.! ADD ", 0) << schema << index->first;
+        add.append(index->second[i]);
+        if (mysql_query(&_mysql, add.c_str()) != 0 && mysql_errno(&_mysql) != 1061)
+          throw ConnectionError("Restoring index", &_mysql);
+      }
+    }
+
+    std::string delete_indexes = base::sqlstring("DELETE FROM !.! WHERE ! = ?", 0)
+                                 << schema << TMP_INDEX_TABLE << "table_name" << index->first;
+    if (mysql_query(&_mysql, delete_indexes.c_str()) != 0)
+      throw ConnectionError("Deleting index backups", &_mysql);
+  }
+}
+
+void MySQLCopyDataTarget::drop_index_backups(std::set<std::string> &schemas) {
+  std::set<std::string>::const_iterator index;
+  std::set<std::string>::const_iterator end = schemas.end();
+
+  for (index = schemas.begin(); index != end; index++) {
+    std::string a_schema = base::unquote_identifier(*index);
+
+    // The backup table is left in place while there's anything in it that wasn't restored
+    std::string count_indexes = base::sqlstring("SELECT COUNT(*) FROM !.!", 0) << a_schema << TMP_INDEX_TABLE;
+    if (mysql_query(&_mysql, count_indexes.c_str()) != 0)
+      continue;
+
+    MYSQL_RES *result = mysql_store_result(&_mysql);
+    if (!result)
+      continue;
+    MYSQL_ROW row = mysql_fetch_row(result);
+    bool empty = row && row[0] && strcmp(row[0], "0") == 0;
+    mysql_free_result(result);
+
+    if (empty) {
+      logDebug("Deleting index backups\n");
+      std::string drop_index_table = base::sqlstring("DROP TABLE !.!", 0) << a_schema << TMP_INDEX_TABLE;
+      if (mysql_query(&_mysql, drop_index_table.c_str()) != 0)
+        throw ConnectionError("Dropping index backups", &_mysql);
+    } else
+      logWarning("Some deferred indexes could not be restored, their definitions are kept in %s.%s\n",
+                 a_schema.c_str(), TMP_INDEX_TABLE);
+  }
+}
+
 TaskQueue::TaskQueue() {
 }
 
@@ -2491,6 +3845,11 @@ void TaskQueue::add_task(const TableParam &task) {
   _tasks.push_back(task);
 }
 
+std::vector<TableParam> TaskQueue::tasks() {
+  base::MutexLock lock(_task_mutex);
+  return _tasks;
+}
+
 bool TaskQueue::get_task(TableParam &task) {
   bool ret_val = false;
 
@@ -2505,9 +3864,340 @@ bool TaskQueue::get_task(TableParam &task) {
   return ret_val;
 }
 
+// Upper limit for the memory held by the row buffers of a pipelined copy. Tables with rows so wide
+// that not even two batches of a single row fit are copied without pipelining.
+#define PIPELINE_MEMORY_LIMIT (64 * 1024 * 1024)
+#define PIPELINE_MAX_BATCH_ROWS 256
+
+// Interval of the live metrics lines written for a table being copied
+#define METRICS_INTERVAL_USECS 1000000
+
+// Rows digested between the progress lines of --compare-data
+#define COMPARE_PROGRESS_ROWS 10000
+
+struct CopyDataTask::ReaderState {
+  CopyDataSource *source;
+  RowBatchQueue free_batches;
+  RowBatchQueue filled_batches;
+  long long row_limit;
+  gint abort;
+  std::string error;
+  bool timed;
+  gint64 fetch_usecs;
+  gint64 queue_wait_usecs;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+// The plain CRC-32 (IEEE 802.3) the server computes with CRC32()
+static unsigned int crc32_of(const char *data, size_t length) {
+  static unsigned int table[256];
+  static bool initialized = false;
+  if (!initialized) {
+    for (unsigned int i = 0; i < 256; i++) {
+      unsigned int c = i;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+    initialized = true;
+  }
+
+  unsigned int crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++)
+    crc = table[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFF;
+}
+
+static long long floor_div(long long value, long long divisor) {
+  long long result = value / divisor;
+  if ((value % divisor != 0) && ((value < 0) != (divisor < 0)))
+    result--;
+  return result;
+}
+
+static bool integer_value(const MYSQL_BIND &bind, long long &value, bool &is_unsigned) {
+  is_unsigned = bind.is_unsigned != 0;
+  switch (bind.buffer_type) {
+    case MYSQL_TYPE_TINY:
+      value = is_unsigned ? (long long)*(unsigned char *)bind.buffer : (long long)*(signed char *)bind.buffer;
+      return true;
+    case MYSQL_TYPE_SHORT:
+      value = is_unsigned ? (long long)*(unsigned short *)bind.buffer : (long long)*(short *)bind.buffer;
+      return true;
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONG:
+      value = is_unsigned ? (long long)*(unsigned int *)bind.buffer : (long long)*(int *)bind.buffer;
+      return true;
+    case MYSQL_TYPE_LONGLONG:
+      value = *(long long *)bind.buffer;
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*
+ * prepare : works out which columns of the table take part in the digest and the expression that makes the
+ *           target server compute exactly the same value for each row.
+ *
+ * Parameters:
+ *   - target : the connection to the target server, with the target table set
+ *   - task : the table being copied
+ *   - columns : the columns being copied, in row buffer order
+ *
+ * Remarks : every row contributes CRC32 of "<length>:<value>," (or "N," for NULL) for each digested column,
+ *           XOR'ed into the digest of its chunk. Only values whose text form is identical on both sides are
+ *           digested: integers, utf-8 character data, binary strings unless sent as long data, dates and
+ *           datetimes (to the second). Floating point, decimal, bit, json, enum/set and spatial values depend
+ *           on server side formatting and are left out.
+ *
+ * Returns false if the table can't be verified (needs a single integer primary key).
+ */
+bool ChecksumVerifier::prepare(MySQLCopyDataTarget *target, const TableParam &task,
+                               const std::vector<ColumnInfo> &columns) {
+  if (task.target_pk_columns.size() != 1 || task.copy_spec.resume || task.copy_spec.max_count > 0 ||
+      (task.copy_spec.type != CopyAll && task.copy_spec.type != CopyRange)) {
+    logInfo("Checksums can't be verified for %s.%s: a full copy with a single column primary key is needed\n",
+            task.target_schema.c_str(), task.target_table.c_str());
+    return false;
+  }
+
+  std::map<std::string, std::string> types;
+  target->get_column_types(task.target_schema, task.target_table, types);
+
+  const char *utf8_sets = "('utf8', 'utf8mb3', 'utf8mb4', 'binary')";
+  std::string charset = base::tolower(target->incoming_data_charset());
+  bool utf8_input = charset.empty() || base::hasPrefix(charset, "utf8");
+  std::string key = base::unquote_identifier(task.target_pk_columns[0]);
+  bool found_key = false;
+
+  _columns.clear();
+  _chunks.clear();
+  _target_expression = "CONCAT(";
+  for (size_t i = 0; i < columns.size(); i++) {
+    const ColumnInfo &col(columns[i]);
+    std::string type = types[col.target_name];
+    std::string name = base::sqlstring("!", 0) << col.target_name;
+    std::string value;
+    Column column = {i, VK_INTEGER};
+
+    switch (col.target_type) {
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONG:
+      case MYSQL_TYPE_LONGLONG:
+        if (col.target_name == key) {
+          _key_index = i;
+          found_key = true;
+        }
+        value = "CAST(" + name + " AS CHAR)";
+        break;
+      case MYSQL_TYPE_STRING:
+      case MYSQL_TYPE_VAR_STRING:
+      case MYSQL_TYPE_BLOB:
+        // Long data is sent right away with prepared statements and never sits in the row buffer
+        if ((col.target_type == MYSQL_TYPE_BLOB || col.is_long_data) && !target->bulk_inserts())
+          continue;
+        if (type == "binary")
+          continue; // padded with \0 by the server
+        if (type == "varbinary" || type == "tinyblob" || type == "blob" || type == "mediumblob" ||
+            type == "longblob") {
+          column.kind = VK_BINARY;
+          value = name;
+        } else if (type == "char" || type == "varchar" || type == "tinytext" || type == "text" ||
+                   type == "mediumtext" || type == "longtext") {
+          if (!utf8_input)
+            continue;
+          // CHAR values are read back without their trailing spaces
+          column.kind = type == "char" ? VK_CHAR : VK_STRING;
+          value = base::strfmt("IF(CHARSET(%s) IN %s, %s, CONVERT(%s USING utf8mb4))", name.c_str(), utf8_sets,
+                               name.c_str(), name.c_str());
+        } else
+          continue;
+        break;
+      case MYSQL_TYPE_DATE:
+      case MYSQL_TYPE_NEWDATE:
+        if (type != "date")
+          continue;
+        column.kind = VK_DATE;
+        value = "DATE_FORMAT(" + name + ", '%Y-%m-%d')";
+        break;
+      case MYSQL_TYPE_DATETIME:
+      case MYSQL_TYPE_TIMESTAMP:
+        if (type != "datetime" && type != "timestamp")
+          continue;
+        column.kind = VK_DATETIME;
+        value = "DATE_FORMAT(" + name + ", '%Y-%m-%d %H:%i:%s')";
+        break;
+      default:
+        continue;
+    }
+
+    _columns.push_back(column);
+    _target_expression.append(base::strfmt("IFNULL(CONCAT(LENGTH(%s), ':', %s), 'N'), ',', ", value.c_str(),
+                                           value.c_str()));
+  }
+
+  if (!found_key) {
+    logInfo("Checksums can't be verified for %s.%s: the primary key is not an integer column\n",
+            task.target_schema.c_str(), task.target_table.c_str());
+    return false;
+  }
+
+  // Drop the trailing separator argument
+  _target_expression.resize(_target_expression.size() - 2);
+  _target_expression.append(")");
+  logDebug("Verifying %lu of %lu columns of %s.%s by checksums\n", (unsigned long)_columns.size(),
+           (unsigned long)columns.size(), task.target_schema.c_str(), task.target_table.c_str());
+  return true;
+}
+
+void ChecksumVerifier::add_row(RowBuffer &row) {
+  long long key;
+  unsigned int digest;
+  if (!row_digest(row, key, digest))
+    return;
+
+  std::pair<long long, unsigned int> &chunk(_chunks[floor_div(key, _chunk_keys)]);
+  chunk.first++;
+  chunk.second ^= digest;
+}
+
+bool ChecksumVerifier::row_digest(RowBuffer &row, long long &key, unsigned int &digest) {
+  bool is_unsigned;
+  if (!integer_value(row[_key_index], key, is_unsigned))
+    return false;
+
+  _row.clear();
+  for (std::vector<Column>::const_iterator column = _columns.begin(); column != _columns.end(); ++column) {
+    MYSQL_BIND &bind(row[column->index]);
+    if (*bind.is_null) {
+      _row.append("N,");
+      continue;
+    }
+
+    char buffer[64];
+    const char *data = buffer;
+    size_t length = 0;
+    switch (column->kind) {
+      case VK_INTEGER: {
+        long long value;
+        integer_value(bind, value, is_unsigned);
+        length = is_unsigned ? sprintf(buffer, "%llu", (unsigned long long)value) : sprintf(buffer, "%lli", value);
+        break;
+      }
+      case VK_STRING:
+      case VK_BINARY:
+        data = (const char *)bind.buffer;
+        length = *bind.length;
+        break;
+      case VK_CHAR:
+        data = (const char *)bind.buffer;
+        length = *bind.length;
+        while (length > 0 && data[length - 1] == ' ')
+          length--;
+        break;
+      case VK_DATE: {
+        MYSQL_TIME *ts = (MYSQL_TIME *)bind.buffer;
+        length = sprintf(buffer, "%04u-%02u-%02u", ts->year, ts->month, ts->day);
+        break;
+      }
+      case VK_DATETIME: {
+        MYSQL_TIME *ts = (MYSQL_TIME *)bind.buffer;
+        length = sprintf(buffer, "%04u-%02u-%02u %02u:%02u:%02u", ts->year, ts->month, ts->day, ts->hour, ts->minute,
+                         ts->second);
+        break;
+      }
+    }
+    _row.append(base::strfmt("%lu:", (unsigned long)length));
+    _row.append(data, length);
+    _row.append(",");
+  }
+
+  digest = crc32_of(_row.data(), _row.size());
+  return true;
+}
+
+/*
+ * verify : compares the digests of the copied chunks against the ones computed by the target server in a
+ *          single grouped scan over the copied key span.
+ *
+ * Parameters:
+ *   - target : the connection to the target server
+ *   - task : the table (or key range) that was copied
+ *   - only : if given, only these chunks are compared (after re-copying them)
+ *
+ * Returns the chunks that differ, including chunks that only exist on one of the sides.
+ */
+std::vector<long long> ChecksumVerifier::verify(MySQLCopyDataTarget *target, const TableParam &task,
+                                                const std::set<long long> *only) {
+  std::vector<long long> mismatches;
+  const std::string &key(task.target_pk_columns[0]);
+
+  std::string condition;
+  if (task.copy_spec.type == CopyRange)
+    condition = range_condition(key, task.copy_spec);
+  if (only) {
+    std::string chunks;
+    for (std::set<long long>::const_iterator chunk = only->begin(); chunk != only->end(); ++chunk)
+      chunks.append(chunks.empty() ? "" : " OR ")
+        .append(base::strfmt("%s BETWEEN %lli AND %lli", key.c_str(), *chunk * _chunk_keys,
+                             *chunk * _chunk_keys + _chunk_keys - 1));
+    if (chunks.empty())
+      return mismatches;
+    condition = condition.empty() ? "(" + chunks + ")" : condition + " AND (" + chunks + ")";
+  }
+
+  Chunks target_chunks;
+  target->get_chunk_checksums(task.target_schema, task.target_table, key, _chunk_keys, _target_expression, condition,
+                              target_chunks);
+
+  // Everything found on either side must match
+  std::set<long long> keys;
+  for (Chunks::const_iterator chunk = _chunks.begin(); chunk != _chunks.end(); ++chunk)
+    if (!only || only->count(chunk->first))
+      keys.insert(chunk->first);
+  for (Chunks::const_iterator chunk = target_chunks.begin(); chunk != target_chunks.end(); ++chunk)
+    keys.insert(chunk->first);
+
+  for (std::set<long long>::const_iterator chunk = keys.begin(); chunk != keys.end(); ++chunk) {
+    Chunks::const_iterator source = _chunks.find(*chunk), copied = target_chunks.find(*chunk);
+    if (source == _chunks.end() || copied == target_chunks.end() || source->second != copied->second)
+      mismatches.push_back(*chunk);
+  }
+  return mismatches;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+MetricsLog::MetricsLog(const std::string &path) {
+  _file = base_fopen(path.c_str(), "w");
+  if (!_file)
+    throw std::runtime_error(base::strfmt("Cannot open metrics file %s: %s", path.c_str(), g_strerror(errno)));
+}
+
+MetricsLog::~MetricsLog() {
+  fclose(_file);
+}
+
+void MetricsLog::write(const std::string &line) {
+  base::MutexLock lock(_mutex);
+  fprintf(_file, "%s\n", line.c_str());
+  fflush(_file);
+}
+
 CopyDataTask::CopyDataTask(const std::string name, CopyDataSource *psource, MySQLCopyDataTarget *ptarget,
-                           TaskQueue *ptasks, bool show_progress)
-  : _source(psource), _target(ptarget) {
+                           TaskQueue *ptasks, bool show_progress, int pipeline_batches, MetricsLog *metrics,
+                           long long checksum_chunk_keys, bool compare_only)
+  : _source(psource),
+    _target(ptarget),
+    _pipeline_batches(pipeline_batches),
+    _metrics(metrics),
+    _checksum_chunk_keys(checksum_chunk_keys),
+    _compare_only(compare_only),
+    _failed_tables(0) {
   _name = name;
   _tasks = ptasks;
   _show_progress = show_progress;
@@ -2520,33 +4210,132 @@ gpointer CopyDataTask::thread_func(gpointer data) {
 
   TableParam tparam;
 
+  self->_thread_metrics.reset();
   while (self->_tasks->get_task(tparam)) {
-    self->copy_table(tparam);
+    if (self->_compare_only)
+      self->compare_table(tparam);
+    else
+      self->copy_table(tparam);
   }
 
+  if (self->_metrics)
+    self->report_metrics(NULL, "thread", self->_thread_metrics);
+
   return NULL;
 }
 
+void CopyMetrics::reset() {
+  start = g_get_monotonic_time();
+  last_report = start;
+  fetch_usecs = 0;
+  insert_usecs = 0;
+  queue_wait_usecs = 0;
+  rows = 0;
+  bytes = 0;
+  wire_bytes = 0;
+}
+
+void CopyMetrics::add(const CopyMetrics &other) {
+  fetch_usecs += other.fetch_usecs;
+  insert_usecs += other.insert_usecs;
+  queue_wait_usecs += other.queue_wait_usecs;
+  rows += other.rows;
+  bytes += other.bytes;
+  wire_bytes += other.wire_bytes;
+}
+
+/*
+ * report_metrics : writes one JSON line to the metrics log.
+ *
+ * Parameters:
+ *   - task : the table the metrics are for, NULL for the totals of the thread
+ *   - event : "progress" for the periodic lines while copying, "table" once a table (or key range) is done
+ *             and "thread" for the totals once the thread has no more work
+ *   - metrics : the measurements
+ *
+ * Remarks : all times are in milliseconds, measured with the monotonic clock. In pipelined mode the fetch
+ *           time and the time the reader waited for a free batch are only known once the table is done.
+ *           queue_wait_ms then is the time both sides spent blocked on each other, so a writer that keeps
+ *           waiting points at the source as the bottleneck and vice versa.
+ */
+void CopyDataTask::report_metrics(const TableParam *task, const char *event, const CopyMetrics &metrics) {
+  gint64 elapsed = g_get_monotonic_time() - metrics.start;
+  std::string line = base::strfmt("{\"event\": \"%s\", \"thread\": \"%s\"", event,
+                                  base::escape_json_string(_name).c_str());
+  if (task)
+    line.append(base::strfmt(", \"table\": \"%s.%s\"", base::escape_json_string(task->target_schema).c_str(),
+                             base::escape_json_string(task->target_table).c_str()));
+  line.append(base::strfmt(", \"elapsed_ms\": %.3f, \"fetch_ms\": %.3f, \"insert_ms\": %.3f", elapsed / 1000.0,
+                           metrics.fetch_usecs / 1000.0, metrics.insert_usecs / 1000.0));
+  line.append(base::strfmt(", \"queue_wait_ms\": %.3f", metrics.queue_wait_usecs / 1000.0));
+  line.append(base::strfmt(", \"rows\": %lli, \"bytes\": %lli, \"rows_per_sec\": %.1f", metrics.rows,
+                           metrics.bytes, elapsed > 0 ? metrics.rows * 1000000.0 / elapsed : 0.0));
+  if (metrics.wire_bytes > 0)
+    line.append(base::strfmt(", \"wire_bytes\": %lli, \"compression_ratio\": %.2f", metrics.wire_bytes,
+                             (double)metrics.bytes / metrics.wire_bytes));
+  if (task) {
+    // LOAD DATA sends buffers rather than a number of rows, prepared statements send single rows
+    int batch_size = 1;
+    if (_target->use_load_data())
+      batch_size = 0;
+    else if (_target->bulk_inserts())
+      batch_size = _target->get_bulk_insert_batch_size();
+    line.append(base::strfmt(", \"batch_size\": %i", batch_size));
+  }
+  line.append("}");
+
+  _metrics->write(line);
+}
+
 void CopyDataTask::copy_table(const TableParam &task) {
+  TRACE_SPAN("copytable", "CopyDataTask::copy_table");
   std::shared_ptr<std::vector<ColumnInfo> > columns;
 
   long long i = 0, total = 0;
   int inserted_records;
+  bool estimated = false, copied_all = false;
 
   time_t start = time(NULL);
+  _table_metrics.reset();
+  long long bytes_sent = _target->bytes_sent();
+  long long wire_bytes = _metrics ? _target->wire_bytes_received() : 0;
   try {
     std::vector<std::string> last_pkeys;
-    if (task.copy_spec.resume)
-      last_pkeys = _target->get_last_pkeys(task.target_pk_columns, task.target_schema, task.target_table);
-    total =
-      _source->count_rows(task.source_schema, task.source_table, task.source_pk_columns, task.copy_spec, last_pkeys);
+    if (task.copy_spec.resume) {
+      // Each key range of a sharded table resumes from the last row copied within that same range
+      if (task.progress)
+        last_pkeys = _target->get_last_pkeys(task.target_pk_columns, task.target_schema, task.target_table,
+                                             range_condition(task.target_pk_columns[0], task.copy_spec));
+      else
+        last_pkeys = _target->get_last_pkeys(task.target_pk_columns, task.target_schema, task.target_table);
+    }
+    total = _source->rows_to_copy(task.source_schema, task.source_table, task.source_pk_columns, task.copy_spec,
+                                  last_pkeys, estimated);
     columns = _source->begin_select_table(task.source_schema, task.source_table, task.source_pk_columns,
                                           task.select_expression, task.copy_spec, last_pkeys);
 
-    printf("BEGIN:%s.%s:Copying %li columns of %lli rows from table %s.%s\n", task.target_schema.c_str(),
-           task.target_table.c_str(), (long)columns->size(), total, task.source_schema.c_str(),
-           task.source_table.c_str());
-    fflush(stdout);
+    if (task.progress) {
+      base::MutexLock lock(task.progress->mutex);
+      task.progress->total += total;
+      if (!task.progress->begun) {
+        task.progress->begun = true;
+        task.progress->start = start;
+        // The other ranges of the table wait on the lock until the indexes are gone
+        if (_target->defer_indexes())
+          _target->backup_indexes(task.target_schema, task.target_table);
+        printf("BEGIN:%s.%s:Copying %li columns from table %s.%s in %i key ranges\n", task.target_schema.c_str(),
+               task.target_table.c_str(), (long)columns->size(), task.source_schema.c_str(),
+               task.source_table.c_str(), task.progress->range_count);
+        fflush(stdout);
+      }
+    } else {
+      printf("BEGIN:%s.%s:Copying %li columns of %lli rows from table %s.%s\n", task.target_schema.c_str(),
+             task.target_table.c_str(), (long)columns->size(), total, task.source_schema.c_str(),
+             task.source_table.c_str());
+      fflush(stdout);
+      if (_target->defer_indexes())
+        _target->backup_indexes(task.target_schema, task.target_table);
+    }
 
     _target->set_get_field_lengths_from_target(_source->get_get_field_lengths_from_target());
 
@@ -2555,47 +4344,561 @@ void CopyDataTask::copy_table(const TableParam &task) {
     _source->set_bulk_inserts(_target->bulk_inserts());
 
     _target->begin_inserts();
-    while (_source->fetch_row(_target->row_buffer())) {
-      inserted_records = _target->do_insert();
-      i += inserted_records;
 
-      if (_show_progress && inserted_records)
-        report_progress(task.target_schema, task.target_table, i, total);
-
-      _target->row_buffer().clear();
+    _checksums.reset();
+    if (_checksum_chunk_keys > 0) {
+      _checksums.reset(new ChecksumVerifier(_checksum_chunk_keys));
+      if (!_checksums->prepare(_target.get(), task, *columns))
+        _checksums.reset();
+    }
 
-      if ((task.copy_spec.type == CopyCount && i >= task.copy_spec.row_count) ||
-          (task.copy_spec.max_count > 0 && i >= task.copy_spec.max_count))
-        break;
+    size_t batch_rows = 0;
+    if (_pipeline_batches > 1 && _target->bulk_inserts()) {
+      size_t row_size = std::max<size_t>(_target->row_buffer().buffer_size(), 1);
+      batch_rows = std::min<size_t>(PIPELINE_MAX_BATCH_ROWS, PIPELINE_MEMORY_LIMIT / (_pipeline_batches * row_size));
     }
 
+    if (batch_rows > 0)
+      i = copy_rows_pipelined(task, total, batch_rows);
+    else
+      i = copy_rows(task, total);
+
     inserted_records = _target->end_inserts();
     i += inserted_records;
 
-    if (_show_progress && inserted_records) {
-      report_progress(task.target_schema, task.target_table, i, total);
-    }
+    if (inserted_records)
+      report_progress(task, inserted_records, i, total);
 
     _source->end_select_table();
+    copied_all = true;
   } catch (std::exception &e) {
+    _checksums.reset();
     printf("ERROR:%s.%s:%s\n", task.target_schema.c_str(), task.target_table.c_str(), e.what());
     fflush(stdout);
     _target->end_inserts(false);
     _source->end_select_table();
+
+    if (task.progress) {
+      base::MutexLock lock(task.progress->mutex);
+      task.progress->failed = true;
+    }
+  }
+
+  std::string verify_error;
+  if (_checksums) {
+    try {
+      verify_checksums(task);
+    } catch (std::exception &e) {
+      verify_error = e.what();
+    }
+    _checksums.reset();
+  }
+
+  // An estimated total is only a hint for the progress, what was copied without errors is the real one.
+  if (estimated && copied_all)
+    total = i;
+
+  if (_metrics) {
+    _table_metrics.rows = i;
+    _table_metrics.bytes = _target->bytes_sent() - bytes_sent;
+    _table_metrics.wire_bytes = _target->wire_bytes_received() - wire_bytes;
+    report_metrics(&task, "table", _table_metrics);
+    _thread_metrics.add(_table_metrics);
+  }
+
+  report_finished(task, i, total, start, verify_error);
+}
+
+/*
+ * verify_checksums : compares the chunk digests collected while copying with the target and re-copies
+ *                    the chunks that differ, once.
+ *
+ * Remarks : throws if chunks still differ after being re-copied.
+ */
+void CopyDataTask::verify_checksums(const TableParam &task) {
+  std::vector<long long> mismatches = _checksums->verify(_target.get(), task);
+  if (mismatches.empty()) {
+    logInfo("%s: checksums of %s.%s verified\n", _name.c_str(), task.target_schema.c_str(),
+            task.target_table.c_str());
+    return;
+  }
+
+  logWarning("%s: %lu chunks of %s.%s differ from the source, copying them again\n", _name.c_str(),
+             (unsigned long)mismatches.size(), task.target_schema.c_str(), task.target_table.c_str());
+
+  long long chunk_keys = _checksums->chunk_keys();
+  std::set<long long> recopied;
+  for (std::vector<long long>::const_iterator chunk = mismatches.begin(); chunk != mismatches.end(); ++chunk) {
+    long long start = *chunk * chunk_keys, end = start + chunk_keys - 1;
+
+    // Stay inside the key range of a sharded table
+    if (task.copy_spec.type == CopyRange) {
+      start = std::max(start, task.copy_spec.range_start);
+      if (task.copy_spec.range_end >= 0)
+        end = std::min(end, task.copy_spec.range_end);
+    }
+
+    _checksums->forget_chunk(*chunk);
+    recopy_chunk(task, start, end);
+    recopied.insert(*chunk);
+  }
+
+  mismatches = _checksums->verify(_target.get(), task, &recopied);
+  if (!mismatches.empty()) {
+    std::string keys;
+    for (std::vector<long long>::const_iterator chunk = mismatches.begin(); chunk != mismatches.end(); ++chunk)
+      keys.append(keys.empty() ? "" : ", ")
+        .append(base::strfmt("%lli-%lli", *chunk * chunk_keys, *chunk * chunk_keys + chunk_keys - 1));
+    throw std::runtime_error(base::strfmt("Checksum mismatch for keys %s", keys.c_str()));
+  }
+  logInfo("%s: checksums of %s.%s verified after copying %lu chunks again\n", _name.c_str(),
+          task.target_schema.c_str(), task.target_table.c_str(), (unsigned long)recopied.size());
+}
+
+void CopyDataTask::recopy_chunk(const TableParam &task, long long start, long long end) {
+  _target->delete_rows(task.target_schema, task.target_table,
+                       base::strfmt("%s BETWEEN %lli AND %lli", task.target_pk_columns[0].c_str(), start, end));
+
+  CopySpec spec = task.copy_spec;
+  spec.type = CopyRange;
+  spec.range_key = task.source_pk_columns[0];
+  spec.range_start = start;
+  spec.range_end = end;
+  spec.resume = false;
+
+  std::vector<std::string> no_pkeys;
+  _source->begin_select_table(task.source_schema, task.source_table, task.source_pk_columns,
+                              task.select_expression, spec, no_pkeys);
+  try {
+    _target->begin_inserts();
+    while (_source->fetch_row(_target->row_buffer())) {
+      _checksums->add_row(_target->row_buffer());
+      _target->do_insert();
+      _target->row_buffer().clear();
+    }
+    _target->end_inserts();
+  } catch (std::exception &) {
+    _target->end_inserts(false);
+    _source->end_select_table();
+    throw;
+  }
+  _source->end_select_table();
+}
+
+/*
+ * compare_table : compares the rows of a source table with the target table instead of copying them
+ *                 (--compare-data).
+ *
+ * Remarks : the source rows are streamed once to compute the digests of their key chunks, which are compared with
+ *           the chunk digests the target computes in a single grouped scan. Only the chunks that differ are read
+ *           again from both sides and joined by key, so after the scans the work depends on the differences only.
+ *           Each row that differs gets a DIFF:<schema>.<table>:<kind>:<key> line, with kind missing (the row is
+ *           only in the source), extra (only in the target) or changed. The columns compared are the ones that
+ *           ChecksumVerifier can digest.
+ */
+void CopyDataTask::compare_table(const TableParam &task) {
+  TRACE_SPAN("copytable", "CopyDataTask::compare_table");
+  time_t start = time(NULL);
+  long long rows = 0, total = 0, differences = 0;
+
+  try {
+    std::vector<std::string> no_pkeys;
+    if (_show_progress) {
+      bool estimated;
+      total = _source->rows_to_copy(task.source_schema, task.source_table, task.source_pk_columns, task.copy_spec,
+                                    no_pkeys, estimated);
+    }
+    std::shared_ptr<std::vector<ColumnInfo> > columns =
+      _source->begin_select_table(task.source_schema, task.source_table, task.source_pk_columns,
+                                  task.select_expression, task.copy_spec, no_pkeys);
+    ChecksumVerifier checksums(_checksum_chunk_keys);
+    try {
+      printf("BEGIN:%s.%s:Comparing %li columns with table %s.%s\n", task.target_schema.c_str(),
+             task.target_table.c_str(), (long)columns->size(), task.source_schema.c_str(), task.source_table.c_str());
+      fflush(stdout);
+
+      _target->set_target_table(task.target_schema, task.target_table, columns);
+      // Nothing is inserted, long data must stay in the row buffer to be digested
+      _source->set_bulk_inserts(true);
+      if (!checksums.prepare(_target.get(), task, *columns))
+        throw std::runtime_error("Only full tables with a single integer column primary key can be compared");
+
+      std::unique_ptr<RowBuffer> row(_target->create_row_buffer());
+      while (_source->fetch_row(*row)) {
+        checksums.add_row(*row);
+        row->clear();
+        if (++rows % COMPARE_PROGRESS_ROWS == 0 && _show_progress) {
+          printf("PROGRESS:%s.%s:%lli:%lli\n", task.target_schema.c_str(), task.target_table.c_str(), rows,
+                 std::max(total, rows));
+          fflush(stdout);
+        }
+      }
+    } catch (std::exception &) {
+      _source->end_select_table();
+      throw;
+    }
+    _source->end_select_table();
+
+    std::vector<long long> mismatches = checksums.verify(_target.get(), task);
+    long long chunk_keys = checksums.chunk_keys();
+    for (std::vector<long long>::const_iterator chunk = mismatches.begin(); chunk != mismatches.end(); ++chunk) {
+      long long first = *chunk * chunk_keys, last = first + chunk_keys - 1;
+      if (task.copy_spec.type == CopyRange) {
+        first = std::max(first, task.copy_spec.range_start);
+        if (task.copy_spec.range_end >= 0)
+          last = std::min(last, task.copy_spec.range_end);
+      }
+      differences += compare_chunk(task, checksums, first, last);
+    }
+  } catch (std::exception &e) {
+    printf("ERROR:%s.%s:%s\n", task.target_schema.c_str(), task.target_table.c_str(), e.what());
+    fflush(stdout);
+    ++_failed_tables;
+    return;
   }
 
   time_t end = time(NULL);
-  if (i != total)
-    printf("ERROR:%s.%s:Failed copying %lli rows\n", task.target_schema.c_str(), task.target_table.c_str(), total - i);
-  else
-    printf("END:%s.%s:Finished copying %lli rows in %im%02is\n", task.target_schema.c_str(), task.target_table.c_str(),
-           i, (int)((end - start) / 60), (int)((end - start) % 60));
+  printf("END:%s.%s:Compared %lli rows in %im%02is, %lli differ\n", task.target_schema.c_str(),
+         task.target_table.c_str(), rows, (int)((end - start) / 60), (int)((end - start) % 60), differences);
   fflush(stdout);
 }
 
-void CopyDataTask::report_progress(const std::string &schema, const std::string &table, long long current,
-                                   long long total) {
-  printf("PROGRESS:%s.%s:%lli:%lli\n", schema.c_str(), table.c_str(), current, total);
+/*
+ * compare_chunk : joins the rows of a chunk of keys with differing digests by key. The digests of the target rows
+ *                 are read into a hash table, which holds at most chunk_keys rows, and the source rows of the chunk
+ *                 are streamed against it.
+ *
+ * Returns the number of rows that differ.
+ */
+long long CopyDataTask::compare_chunk(const TableParam &task, ChecksumVerifier &checksums, long long start,
+                                      long long end) {
+  const std::string &key(task.target_pk_columns[0]);
+  std::unordered_map<long long, unsigned int> target_rows;
+  _target->get_row_checksums(task.target_schema, task.target_table, key, checksums.target_expression(),
+                             base::strfmt("%s BETWEEN %lli AND %lli", key.c_str(), start, end), target_rows);
+
+  CopySpec spec = task.copy_spec;
+  spec.type = CopyRange;
+  spec.range_key = task.source_pk_columns[0];
+  spec.range_start = start;
+  spec.range_end = end;
+  spec.resume = false;
+
+  long long differences = 0;
+  std::vector<std::string> no_pkeys;
+  _source->begin_select_table(task.source_schema, task.source_table, task.source_pk_columns,
+                              task.select_expression, spec, no_pkeys);
+  try {
+    std::unique_ptr<RowBuffer> row(_target->create_row_buffer());
+    long long row_key;
+    unsigned int digest;
+    while (_source->fetch_row(*row)) {
+      if (checksums.row_digest(*row, row_key, digest)) {
+        std::unordered_map<long long, unsigned int>::iterator target_row = target_rows.find(row_key);
+        if (target_row == target_rows.end()) {
+          report_difference(task, "missing", row_key);
+          differences++;
+        } else {
+          if (target_row->second != digest) {
+            report_difference(task, "changed", row_key);
+            differences++;
+          }
+          target_rows.erase(target_row);
+        }
+      }
+      row->clear();
+    }
+  } catch (std::exception &) {
+    _source->end_select_table();
+    throw;
+  }
+  _source->end_select_table();
+
+  // What is left is only in the target
+  std::vector<long long> extra;
+  for (std::unordered_map<long long, unsigned int>::const_iterator target_row = target_rows.begin();
+       target_row != target_rows.end(); ++target_row)
+    extra.push_back(target_row->first);
+  std::sort(extra.begin(), extra.end());
+  for (std::vector<long long>::const_iterator row_key = extra.begin(); row_key != extra.end(); ++row_key)
+    report_difference(task, "extra", *row_key);
+
+  return differences + (long long)extra.size();
+}
+
+void CopyDataTask::report_difference(const TableParam &task, const char *kind, long long key) {
+  printf("DIFF:%s.%s:%s:%lli\n", task.target_schema.c_str(), task.target_table.c_str(), kind, key);
+  fflush(stdout);
+}
+
+long long CopyDataTask::copy_rows(const TableParam &task, long long total) {
+  long long i = 0;
+  gint64 now = _metrics ? g_get_monotonic_time() : 0;
+
+  while (_source->fetch_row(_target->row_buffer())) {
+    if (_metrics) {
+      gint64 fetched = g_get_monotonic_time();
+      _table_metrics.fetch_usecs += fetched - now;
+      now = fetched;
+    }
+
+    if (_checksums)
+      _checksums->add_row(_target->row_buffer());
+
+    int inserted_records = _target->do_insert();
+    i += inserted_records;
+
+    if (_metrics) {
+      gint64 inserted = g_get_monotonic_time();
+      _table_metrics.insert_usecs += inserted - now;
+      now = inserted;
+      if (inserted_records)
+        report_live_metrics(task, i, now);
+    }
+
+    if (inserted_records)
+      report_progress(task, inserted_records, i, total);
+
+    _target->row_buffer().clear();
+
+    if ((task.copy_spec.type == CopyCount && i >= task.copy_spec.row_count) ||
+        (task.copy_spec.max_count > 0 && i >= task.copy_spec.max_count))
+      break;
+  }
+
+  return i;
+}
+
+/*
+ * copy_rows_pipelined : copies the rows with the source fetch and the target insert running in parallel.
+ * Parameters:
+ * - task : the table being copied
+ * - total : the number of rows expected, used for progress reporting
+ * - batch_rows : the number of rows in each batch passed from the reader to the writer
+ *
+ * Remarks : A reader thread fills batches of row buffers from the source while this thread inserts the
+ *           previously filled ones, so the network latency of each side is hidden behind the other.
+ *           Only _pipeline_batches batches exist, which bounds both memory use and how far ahead
+ *           the reader can get.
+ */
+long long CopyDataTask::copy_rows_pipelined(const TableParam &task, long long total, size_t batch_rows) {
+  long long i = 0;
+  std::vector<RowBatch *> batches;
+  ReaderState state;
+
+  state.source = _source.get();
+  state.abort = 0;
+  state.row_limit = 0;
+  state.timed = _metrics != NULL;
+  state.fetch_usecs = 0;
+  state.queue_wait_usecs = 0;
+  if (task.copy_spec.type == CopyCount)
+    state.row_limit = task.copy_spec.row_count;
+  if (task.copy_spec.max_count > 0 && (state.row_limit == 0 || task.copy_spec.max_count < state.row_limit))
+    state.row_limit = task.copy_spec.max_count;
+
+  // The batches of the previous table are gone, so their memory can be handed out again
+  _arena.reset();
+  try {
+    for (int index = 0; index < _pipeline_batches; index++) {
+      RowBatch *batch = new RowBatch();
+      batches.push_back(batch);
+      for (size_t row = 0; row < batch_rows; row++)
+        batch->rows.push_back(_target->create_row_buffer(&_arena));
+      state.free_batches.push(batch);
+    }
+  } catch (std::exception &) {
+    for (std::vector<RowBatch *>::iterator iter = batches.begin(); iter != batches.end(); ++iter)
+      delete *iter;
+    throw;
+  }
+
+  logDebug("%s: copying %s.%s through %i batches of %lu rows\n", _name.c_str(), task.source_schema.c_str(),
+           task.source_table.c_str(), _pipeline_batches, (unsigned long)batch_rows);
+
+  GThread *reader = base::create_thread(&CopyDataTask::reader_thread_func, &state);
+
+  std::string error;
+  RowBatch *batch;
+  gint64 now = _metrics ? g_get_monotonic_time() : 0;
+  while ((batch = state.filled_batches.pop()) != NULL) {
+    if (_metrics) {
+      gint64 popped = g_get_monotonic_time();
+      _table_metrics.queue_wait_usecs += popped - now;
+      now = popped;
+    }
+
+    // After a failure the remaining batches are only recycled, so the reader is never left waiting
+    if (error.empty()) {
+      try {
+        for (size_t row = 0; row < batch->count; row++) {
+          if (_checksums)
+            _checksums->add_row(*batch->rows[row]);
+
+          int inserted_records = _target->do_insert(*batch->rows[row]);
+          i += inserted_records;
+
+          if (inserted_records)
+            report_progress(task, inserted_records, i, total);
+
+          batch->rows[row]->clear();
+        }
+      } catch (std::exception &e) {
+        error = e.what();
+        g_atomic_int_set(&state.abort, 1);
+      }
+    }
+    batch->count = 0;
+    state.free_batches.push(batch);
+
+    if (_metrics) {
+      gint64 inserted = g_get_monotonic_time();
+      _table_metrics.insert_usecs += inserted - now;
+      now = inserted;
+      report_live_metrics(task, i, now);
+    }
+  }
+
+  g_thread_join(reader);
+  _table_metrics.fetch_usecs += state.fetch_usecs;
+  _table_metrics.queue_wait_usecs += state.queue_wait_usecs;
+
+  for (std::vector<RowBatch *>::iterator iter = batches.begin(); iter != batches.end(); ++iter)
+    delete *iter;
+
+  if (error.empty())
+    error = state.error;
+  if (!error.empty())
+    throw std::runtime_error(error);
+
+  return i;
+}
+
+gpointer CopyDataTask::reader_thread_func(gpointer data) {
+  ReaderState *state = (ReaderState *)data;
+  long long fetched = 0;
+
+  try {
+    bool done = false;
+    while (!done) {
+      gint64 waiting = state->timed ? g_get_monotonic_time() : 0;
+      RowBatch *batch = state->free_batches.pop();
+      gint64 filling = state->timed ? g_get_monotonic_time() : 0;
+      state->queue_wait_usecs += filling - waiting;
+
+      while (batch->count < batch->rows.size()) {
+        if (g_atomic_int_get(&state->abort) || (state->row_limit > 0 && fetched >= state->row_limit) ||
+            !state->source->fetch_row(*batch->rows[batch->count])) {
+          done = true;
+          break;
+        }
+        batch->rows[batch->count]->clear();
+        batch->count++;
+        fetched++;
+      }
+      if (state->timed)
+        state->fetch_usecs += g_get_monotonic_time() - filling;
+
+      if (batch->count > 0)
+        state->filled_batches.push(batch);
+      else
+        state->free_batches.push(batch);
+    }
+  } catch (std::exception &e) {
+    state->error = e.what();
+  }
+
+  // Tells the writer there is nothing else to come
+  state->filled_batches.push(NULL);
+
+  return NULL;
+}
+
+void CopyDataTask::report_live_metrics(const TableParam &task, long long copied, gint64 now) {
+  if (now - _table_metrics.last_report < METRICS_INTERVAL_USECS)
+    return;
+
+  _table_metrics.last_report = now;
+  _table_metrics.rows = copied;
+  report_metrics(&task, "progress", _table_metrics);
+}
+
+void CopyDataTask::report_progress(const TableParam &task, long long inserted, long long current, long long total) {
+  if (task.progress) {
+    // Rows of a sharded table are accounted for the whole table, not for the single range
+    base::MutexLock lock(task.progress->mutex);
+    task.progress->copied += inserted;
+    if (_show_progress) {
+      if (_target->adaptive_bulk_insert_batch())
+        printf("PROGRESS:%s.%s:%lli:%lli:%i\n", task.target_schema.c_str(), task.target_table.c_str(),
+               task.progress->copied, task.progress->total, _target->get_bulk_insert_batch_size());
+      else
+        printf("PROGRESS:%s.%s:%lli:%lli\n", task.target_schema.c_str(), task.target_table.c_str(),
+               task.progress->copied, task.progress->total);
+      fflush(stdout);
+    }
+  } else if (_show_progress) {
+    // The total may be an estimate that turned out too low.
+    total = std::max(total, current);
+    if (_target->adaptive_bulk_insert_batch())
+      printf("PROGRESS:%s.%s:%lli:%lli:%i\n", task.target_schema.c_str(), task.target_table.c_str(), current, total,
+             _target->get_bulk_insert_batch_size());
+    else
+      printf("PROGRESS:%s.%s:%lli:%lli\n", task.target_schema.c_str(), task.target_table.c_str(), current, total);
+    fflush(stdout);
+  }
+}
+
+void CopyDataTask::report_finished(const TableParam &task, long long copied, long long total, time_t start,
+                                   const std::string &error) {
+  if (task.progress) {
+    base::MutexLock lock(task.progress->mutex);
+    if (copied != total || !error.empty())
+      task.progress->failed = true;
+    if (!error.empty()) {
+      printf("ERROR:%s.%s:%s\n", task.target_schema.c_str(), task.target_table.c_str(), error.c_str());
+      fflush(stdout);
+    }
+
+    // Only the last range to complete reports the outcome for the table
+    if (++task.progress->ranges_done < task.progress->range_count)
+      return;
+
+    copied = task.progress->copied;
+    total = task.progress->total;
+    start = task.progress->start;
+    if (task.progress->failed && copied == total)
+      total = -1;
+  }
+
+  // Whatever happened to the rows, the table gets its indexes back. If even that fails they stay
+  // in the backup table for a later run.
+  if (_target->defer_indexes()) {
+    try {
+      _target->restore_indexes(task.target_schema, task.target_table);
+    } catch (std::exception &e) {
+      printf("ERROR:%s.%s:Restoring deferred indexes: %s\n", task.target_schema.c_str(), task.target_table.c_str(),
+             e.what());
+      fflush(stdout);
+      ++_failed_tables;
+      return;
+    }
+  }
+
+  time_t end = time(NULL);
+  if (!error.empty() || total < 0 || copied != total)
+    ++_failed_tables;
+  if (!error.empty() && !task.progress)
+    printf("ERROR:%s.%s:%s\n", task.target_schema.c_str(), task.target_table.c_str(), error.c_str());
+  else if (total < 0)
+    printf("ERROR:%s.%s:Failed copying some of the key ranges\n", task.target_schema.c_str(),
+           task.target_table.c_str());
+  else if (copied != total)
+    printf("ERROR:%s.%s:Failed copying %lli rows\n", task.target_schema.c_str(), task.target_table.c_str(),
+           total - copied);
+  else
+    printf("END:%s.%s:Finished copying %lli rows in %im%02is\n", task.target_schema.c_str(), task.target_table.c_str(),
+           copied, (int)((end - start) / 60), (int)((end - start) % 60));
   fflush(stdout);
 }
 
@@ -2643,7 +4946,20 @@ bool MySQLCopyDataTarget::InsertBuffer::append_escaped(const char *data, size_t
   // This is needed because the escaping depends on the character set in use by the server
   unsigned long ret_length = 0;
 
-
+  // For utf-8 and single byte connection charsets escaping doesn't depend on the charset at all, so use the
+  // vectorized escaping from base which copies clean runs in bulk. Multi byte charsets like sjis or gbk can
+  // have a backslash as trailing byte and must go through the client library.
+  if (_simple_escaping < 0) {
+    std::string charset = base::tolower(mysql_character_set_name(_mysql));
+    _simple_escaping = (base::hasPrefix(charset, "utf8") || charset == "latin1" || charset == "ascii" ||
+                        charset == "binary")
+                         ? 1
+                         : 0;
+  }
+  if (_simple_escaping && !(_mysql->server_status & SERVER_STATUS_NO_BACKSLASH_ESCAPES)) {
+    length += base::escape_sql_buffer(data, dlength, buffer + length);
+    return true;
+  }
 
 #if MYSQL_VERSION_ID >= 50706
   if (_target->is_mysql_version_at_least(5, 7, 6))
@@ -30,14 +30,17 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include <vector>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <stdexcept>
 #include <memory>
 #include <functional>
+#include <deque>
 
 #ifdef __APPLE
 #pragma GCC diagnostic ignored "-Wdeprecated-register"
@@ -96,6 +99,24 @@ public:
   }
 };
 
+// Settings shared by all the MySQL connections of the process. The TLS session of the last connection to a server
+// is kept, so the connections of the other threads resume it instead of doing the full handshake again.
+class MySQLConnectionOptions {
+  static std::string _compression;
+  static base::Mutex _mutex;
+  static std::map<std::string, std::string> _tls_sessions; // PEM session data by user@server
+
+public:
+  // Comma separated list of zstd, zlib and uncompressed, in order of preference.
+  static void set_compression(const std::string &algorithms);
+  static bool valid_compression(const std::string &algorithms);
+
+  // Called before mysql_real_connect(), returns its client flags.
+  static unsigned long prepare(MYSQL *mysql, const std::string &key);
+  // Called once the connection is open.
+  static void connected(MYSQL *mysql, const std::string &key);
+};
+
 enum SourceType { ST_MYSQL, ST_ODBC, ST_PYTHON };
 
 struct ColumnInfo {
@@ -110,20 +131,46 @@ struct ColumnInfo {
   bool is_long_data;
 };
 
+// Hands out memory for the column buffers of row buffers from a few large blocks. Nothing is freed
+// individually, reset() makes the whole region reusable (e.g. for the batches of the next table).
+class RowBufferArena {
+  std::vector<std::pair<char *, size_t> > _blocks;
+  size_t _block_size;
+  size_t _current;
+  size_t _used;
+
+  RowBufferArena(const RowBufferArena &o) {
+  }
+
+public:
+  RowBufferArena(size_t block_size = 4 * 1024 * 1024);
+  ~RowBufferArena();
+
+  void *allocate(size_t size);
+  void reset();
+};
+
 class RowBuffer : public std::vector<MYSQL_BIND> {
   int _current_field;
   std::function<void(int, const char *, size_t)> _send_blob_data;
+  std::unique_ptr<RowBufferArena> _own_arena;
+  std::vector<std::pair<char *, size_t> > _grown_fields; // heap buffers of fields that outgrew their slot
 
   RowBuffer(const RowBuffer &o) : std::vector<MYSQL_BIND>(), _current_field(0) {
   }
 
 public:
+  // The column buffers are taken from arena if given, otherwise from a single block owned by the row
   RowBuffer(std::shared_ptr<std::vector<ColumnInfo> > columns,
-            std::function<void(int, const char *, size_t)> send_blob_data, size_t max_packet_size);
+            std::function<void(int, const char *, size_t)> send_blob_data, size_t max_packet_size,
+            RowBufferArena *arena = NULL);
   ~RowBuffer();
 
   void clear();
 
+  // Makes the buffer of a field (usually a blob) big enough for length bytes, keeping it for the next rows
+  char *grow_field(size_t index, size_t length);
+
   void prepare_add_string(char *&buffer, size_t &buffer_len, unsigned long *&length);
   void prepare_add_float(char *&buffer, size_t &buffer_len);
   void prepare_add_double(char *&buffer, size_t &buffer_len);
@@ -139,6 +186,37 @@ public:
 
   bool check_if_blob();
   void send_blob_data(const char *data, size_t length);
+
+  size_t buffer_size() const;
+};
+
+// A group of rows fetched from the source in one go, handed over from the reader to the writer stage.
+struct RowBatch {
+  std::vector<RowBuffer *> rows;
+  size_t count;
+
+  RowBatch() : count(0) {
+  }
+  ~RowBatch() {
+    for (std::vector<RowBuffer *>::iterator iter = rows.begin(); iter != rows.end(); ++iter)
+      delete *iter;
+  }
+};
+
+// FIFO of row batches shared by the reader and the writer stage of a copy. The queue itself is not
+// bounded, the pipeline is: only a fixed number of batches exists, and they circulate between a queue
+// of free batches and a queue of filled ones. A NULL batch marks the end of the data.
+class RowBatchQueue {
+  std::deque<RowBatch *> _batches;
+  base::Mutex _mutex;
+  base::Semaphore _available;
+
+public:
+  RowBatchQueue() : _available(0) {
+  }
+
+  void push(RowBatch *batch);
+  RowBatch *pop();
 };
 
 enum CopyType { CopyAll, CopyRange, CopyCount, CopyWhere };
@@ -155,6 +233,38 @@ struct CopySpec {
   bool resume;
 };
 
+// Shared by all the key ranges a single table was split into, so that progress,
+// the BEGIN line and the final END/ERROR line are still reported once per table.
+struct TableProgress {
+  base::Mutex mutex;
+  int range_count;
+  int ranges_done;
+  long long total;
+  long long copied;
+  bool begun;
+  bool failed;
+  time_t start;
+
+  TableProgress(int count)
+    : range_count(count), ranges_done(0), total(0), copied(0), begun(false), failed(false), start(0) {
+  }
+};
+
+// Replication of the source binlog into the target that follows the bulk copy with --cdc-tail.
+struct BinlogTailSpec {
+  std::string host; // The source as the target server reaches it.
+  int port;
+  std::string user;
+  std::string password;
+  std::string file; // Binlog position of the source when the copy started.
+  unsigned long long position;
+  std::map<std::string, std::string> rewrite_schemas; // Source schema -> target schema, unquoted.
+  std::set<std::string> tables;                       // Target schema.table of the copied tables, unquoted.
+
+  BinlogTailSpec() : port(3306), position(0) {
+  }
+};
+
 struct TableParam {
   std::string source_schema;
   std::string source_table;
@@ -164,6 +274,7 @@ struct TableParam {
   std::vector<std::string> source_pk_columns;
   std::vector<std::string> target_pk_columns;
   CopySpec copy_spec;
+  std::shared_ptr<TableProgress> progress; // Set only for the key ranges of a sharded table.
 };
 
 class CopyDataSource {
@@ -178,6 +289,7 @@ protected:
   bool _use_bulk_inserts;
   bool _get_field_lengths_from_target;
   unsigned int _connection_timeout;
+  bool _estimate_row_counts;
 
 public:
   CopyDataSource();
@@ -200,12 +312,30 @@ public:
   void set_bulk_inserts(bool value) {
     _use_bulk_inserts = value;
   }
+  void set_estimate_row_counts(bool value) {
+    _estimate_row_counts = value;
+  }
   std::string get_where_condition(const std::vector<std::string> &pk_columns,
                                   const std::vector<std::string> &last_pkeys);
 
+  // Retrieves the lowest and highest values of an integer key column. Returns false if the source
+  // cannot provide them (e.g. the key is not numeric), in which case the table is not split.
+  virtual bool get_key_range(const std::string &schema, const std::string &table, const std::string &key,
+                             long long &min_value, long long &max_value);
+
+  // Reads the number of rows of a table from the statistics of the source, without counting them. Returns false
+  // if the source has no such statistics for the table.
+  virtual bool estimate_rows(const std::string &schema, const std::string &table, long long &count);
+
   virtual size_t count_rows(const std::string &schema, const std::string &table,
                             const std::vector<std::string> &pk_columns, const CopySpec &spec,
                             const std::vector<std::string> &last_pkeys) = 0;
+
+  // The number of rows to copy for progress reports. With estimates enabled whole tables are not counted but
+  // estimated, estimated is set then and the real number is only known once the copy is done.
+  size_t rows_to_copy(const std::string &schema, const std::string &table, const std::vector<std::string> &pk_columns,
+                      const CopySpec &spec, const std::vector<std::string> &last_pkeys, bool &estimated);
+
   virtual std::shared_ptr<std::vector<ColumnInfo> > begin_select_table(
     const std::string &schema, const std::string &table, const std::vector<std::string> &pk_columns,
     const std::string &select_expression, const CopySpec &spec, const std::vector<std::string> &last_pkeys) = 0;
@@ -214,21 +344,48 @@ public:
 };
 
 class ODBCCopyDataSource : public CopyDataSource {
+  // Column-wise bound array used when fetching blocks of rows with SQL_ATTR_ROW_ARRAY_SIZE.
+  struct BoundColumn {
+    SQLSMALLINT c_type;
+    SQLLEN element_size;
+    std::vector<char> data;
+    std::vector<SQLLEN> indicators;
+
+    BoundColumn() : c_type(0), element_size(0) {
+    }
+  };
+
   SQLHDBC _dbc;
   std::string _connstring;
 
   SQLHSTMT _stmt;
   std::shared_ptr<std::vector<ColumnInfo> > _columns;
   std::vector<SQLSMALLINT> _column_types;
+  std::vector<SQLULEN> _column_sizes;        // Column size in characters as reported by SQLDescribeCol
+  std::vector<SQLLEN> _column_octet_lengths; // SQL_DESC_OCTET_LENGTH, 0 if the driver doesn't know
   int _column_count;
 
   bool _stmt_ok;
   bool _force_utf8_input;
 
+  // Block fetch state, _bound_columns is empty when rows are fetched one by one
+  bool _bind_pending;
+  bool _block_truncated;
+  std::vector<BoundColumn> _bound_columns;
+  std::vector<SQLUSMALLINT> _row_status;
+  SQLULEN _rows_fetched;
+  SQLULEN _current_row;
+
   std::string _source_rdbms_type;
 
   SQLSMALLINT odbc_type_to_c_type(SQLSMALLINT type, bool is_unsigned);
 
+  bool block_c_type(RowBuffer &rowbuffer, int column, SQLSMALLINT &c_type, SQLLEN &size);
+  void bind_block_columns(RowBuffer &rowbuffer);
+  void unbind_block_columns();
+  bool fetch_next(RowBuffer &rowbuffer);
+  SQLRETURN get_data(int column, SQLSMALLINT type, SQLPOINTER buffer, SQLLEN buffer_len, SQLLEN *len_or_indicator);
+
   void ucs2_to_utf8(char *inbuf, size_t inbuf_len, char *&utf8buf, size_t &utf8buf_len);
 
 public:
@@ -237,11 +394,16 @@ public:
   virtual ~ODBCCopyDataSource();
 
   SQLRETURN get_wchar_buffer_data(RowBuffer &rowbuffer, int column);
+  size_t convert_wide_data(const wchar_t *data, size_t data_size, SQLLEN len_or_indicator, char *out_buffer,
+                           size_t out_buffer_len);
   SQLRETURN get_char_buffer_data(RowBuffer &rowbuffer, int column);
   SQLRETURN get_date_time_data(RowBuffer &rowbuffer, int column, int type);
   SQLRETURN get_geometry_buffer_data(RowBuffer &rowbuffer, int column);
 
 public:
+  virtual bool get_key_range(const std::string &schema, const std::string &table, const std::string &key,
+                             long long &min_value, long long &max_value);
+  virtual bool estimate_rows(const std::string &schema, const std::string &table, long long &count);
   virtual size_t count_rows(const std::string &schema, const std::string &table,
                             const std::vector<std::string> &pk_columns, const CopySpec &spec,
                             const std::vector<std::string> &last_pkeys);
@@ -263,6 +425,9 @@ public:
                       const std::string &socket, bool use_cleartext_plugin, const unsigned int connection_timeout);
   virtual ~MySQLCopyDataSource();
 
+  virtual bool get_key_range(const std::string &schema, const std::string &table, const std::string &key,
+                             long long &min_value, long long &max_value);
+  virtual bool estimate_rows(const std::string &schema, const std::string &table, long long &count);
   virtual size_t count_rows(const std::string &schema, const std::string &table,
                             const std::vector<std::string> &pk_columns, const CopySpec &spec,
                             const std::vector<std::string> &last_pkeys);
@@ -271,6 +436,9 @@ public:
     const std::string &select_expression, const CopySpec &spec, const std::vector<std::string> &last_pkeys);
   virtual void end_select_table();
   virtual bool fetch_row(RowBuffer &rowbuffer);
+
+  // The current binlog position, throws if the server has no row based binlog to replicate changes from.
+  void get_binlog_position(std::string &file, unsigned long long &position);
 };
 
 class MySQLCopyDataTarget {
@@ -281,9 +449,10 @@ class MySQLCopyDataTarget {
     size_t length;
     size_t size;
     size_t last_insert_length;
+    int _simple_escaping; // -1 until the connection charset is known
 
     InsertBuffer(MySQLCopyDataTarget *target)
-      : _target(target), buffer(NULL), length(0), size(0), last_insert_length(0) {
+      : _target(target), buffer(NULL), length(0), size(0), last_insert_length(0), _simple_escaping(-1) {
     }
     ~InsertBuffer() {
       if (buffer)
@@ -297,6 +466,7 @@ class MySQLCopyDataTarget {
     bool append_escaped(const char *data, size_t length);
     void set_connection(MYSQL *mysql) {
       _mysql = mysql;
+      _simple_escaping = -1;
     }
     size_t space_left();
   };
@@ -324,14 +494,49 @@ class MySQLCopyDataTarget {
   InsertBuffer _bulk_insert_record;
   int _bulk_record_count;
   int _bulk_insert_batch;
+
+  // Tunes _bulk_insert_batch while copying, based on the measured rows/s of the executed INSERTs
+  struct BatchSizer {
+    bool enabled;
+    int initial_size;
+    int direction;       // 1 while growing the batch, -1 while shrinking it
+    double best_rate;    // best rows/s seen so far for the current table
+    int window_statements;
+    long long window_rows;
+    long long window_bytes;
+    gint64 window_usecs;
+
+    BatchSizer() : enabled(false), initial_size(0) {
+      reset(0);
+    }
+    void reset(int size);
+    int statement_done(int current_size, int rows, size_t bytes, gint64 usecs, size_t max_bytes);
+  };
+  BatchSizer _batch_sizer;
+
+  // Variables used for LOAD DATA LOCAL INFILE streaming
+  bool _use_load_data;
+  bool _local_infile; // Whether the connection was opened with LOAD DATA LOCAL enabled.
+  std::string _load_data_query;
+
+  // Secondary indexes are dropped before and rebuilt after copying each table
+  bool _defer_indexes;
+
+  // Size of the statements and parameter data sent to the server so far
+  long long _bytes_sent;
   std::string _source_rdbms_type;
   unsigned int _connection_timeout;
 
   MYSQL_RES *get_server_value(const std::string &variable);
   void get_server_value(const std::string &variable, std::string &value);
   void get_server_value(const std::string &variable, unsigned long &value);
-  bool format_bulk_record();
-  bool append_bulk_column(size_t col_index);
+  bool format_bulk_record(RowBuffer &row);
+  bool append_bulk_column(RowBuffer &row, size_t col_index);
+  bool format_load_data_record(RowBuffer &row);
+  int load_data_insert(RowBuffer &row, bool final);
+  int send_load_data();
+  void enable_local_infile();
+  std::string load_data_query();
 
   void get_server_version();
   bool is_mysql_version_at_least(const int _major, const int _minor, const int _build);
@@ -347,7 +552,7 @@ public:
   MySQLCopyDataTarget(const std::string &hostname, int port, const std::string &username, const std::string &password,
                       const std::string &socket, bool use_cleartext_plugin, const std::string &app_name,
                       const std::string &incoming_charset, const std::string &source_rdbms_type,
-                      const unsigned int connection_timeout);
+                      const unsigned int connection_timeout, bool local_infile = false);
 
   ~MySQLCopyDataTarget();
 
@@ -370,6 +575,25 @@ public:
   void set_bulk_insert_batch_size(int value) {
     _bulk_insert_batch = value;
   }
+  int get_bulk_insert_batch_size() {
+    return _bulk_insert_batch;
+  }
+
+  // Lets the bulk insert batch size float around the configured value, towards the best insert rate.
+  void set_adaptive_bulk_insert_batch(bool flag) {
+    _batch_sizer.enabled = flag;
+  }
+  bool adaptive_bulk_insert_batch() {
+    return _batch_sizer.enabled && _use_bulk_inserts && !_use_load_data;
+  }
+
+  // Streams the rows to the server with LOAD DATA LOCAL INFILE instead of multi-row INSERTs.
+  // Falls back to INSERTs if the server has local_infile disabled.
+  // Only has an effect if the target was created with local_infile, which must be set before connecting.
+  void set_use_load_data(bool flag);
+  bool use_load_data() {
+    return _use_load_data;
+  }
 
   bool get_get_field_lengths_from_target() {
     return _get_field_lengths_from_target;
@@ -381,6 +605,10 @@ public:
   void begin_inserts();
   int end_inserts(bool flush = true);
   int do_insert(bool final = false);
+  int do_insert(RowBuffer &row, bool final = false);
+
+  // Creates an additional row buffer for the current target table, owned by the caller.
+  RowBuffer *create_row_buffer(RowBufferArena *arena = NULL);
 
   void restore_triggers(std::set<std::string> &schemas);
   void backup_triggers(std::set<std::string> &schemas);
@@ -388,8 +616,46 @@ public:
   void get_triggers_for_schema(const std::string &schema, std::map<std::string, std::string> &triggers);
   bool get_trigger_definitions_for_schema(const std::string &schema, std::map<std::string, std::string> &triggers);
   void drop_trigger_backups(const std::string &schema);
+
+  long long bytes_sent() {
+    return _bytes_sent;
+  }
+  // Bytes the server received on this connection, as they went over the network.
+  long long wire_bytes_received();
+
+  void set_defer_indexes(bool flag) {
+    _defer_indexes = flag;
+  }
+  bool defer_indexes() {
+    return _defer_indexes;
+  }
+  const std::string &incoming_data_charset() {
+    return _incoming_data_charset;
+  }
+  void get_column_types(const std::string &schema, const std::string &table,
+                        std::map<std::string, std::string> &types);
+  void get_chunk_checksums(const std::string &schema, const std::string &table, const std::string &key,
+                           long long chunk_keys, const std::string &row_expression, const std::string &where_condition,
+                           std::map<long long, std::pair<long long, unsigned int> > &chunks);
+  void get_row_checksums(const std::string &schema, const std::string &table, const std::string &key,
+                         const std::string &row_expression, const std::string &where_condition,
+                         std::unordered_map<long long, unsigned int> &rows);
+  void delete_rows(const std::string &schema, const std::string &table, const std::string &where_condition);
+
+  void backup_indexes(const std::string &schema, const std::string &table);
+  void restore_indexes(const std::string &schema, const std::string &table = "");
+  void drop_index_backups(std::set<std::string> &schemas);
   std::vector<std::string> get_last_pkeys(const std::vector<std::string> &pk_columns, const std::string &schema,
-                                          const std::string &table);
+                                          const std::string &table, const std::string &where_condition = "");
+
+  // Replicates the changes the source made since the copy started into the copied tables, on a replication
+  // channel of its own. Rows the copy already has are overwritten, so the copy needs no consistent snapshot.
+  void start_binlog_tail(const BinlogTailSpec &spec);
+  // Seconds the replication is behind the source, -1 while it has not connected yet. Throws on replication errors.
+  long long binlog_tail_lag(std::string &applied_file, unsigned long long &applied_position);
+  // Waits until the replication applied everything up to the given source position. False on timeout.
+  bool wait_binlog_tail(const std::string &file, unsigned long long position, int timeout);
+  void stop_binlog_tail();
 
   RowBuffer &row_buffer();
 };
@@ -403,6 +669,7 @@ public:
   TaskQueue();
   void add_task(const TableParam &task);
   bool get_task(TableParam &task);
+  std::vector<TableParam> tasks();
 
   size_t size() {
     return _tasks.size();
@@ -412,27 +679,127 @@ public:
   }
 };
 
+// Digests of the copied rows per chunk of key values, compared against what the target server computes
+// for the same chunks with BIT_XOR(CRC32(...)) (--verify-checksums).
+class ChecksumVerifier {
+public:
+  typedef std::map<long long, std::pair<long long, unsigned int> > Chunks; // chunk -> (row count, digest)
+
+private:
+  enum ValueKind { VK_INTEGER, VK_STRING, VK_CHAR, VK_BINARY, VK_DATE, VK_DATETIME };
+  struct Column {
+    size_t index;
+    ValueKind kind;
+  };
+
+  long long _chunk_keys;
+  size_t _key_index;
+  std::vector<Column> _columns;
+  std::string _target_expression;
+  Chunks _chunks;
+  std::string _row;
+
+public:
+  ChecksumVerifier(long long chunk_keys) : _chunk_keys(chunk_keys), _key_index(0) {
+  }
+
+  bool prepare(MySQLCopyDataTarget *target, const TableParam &task, const std::vector<ColumnInfo> &columns);
+  void add_row(RowBuffer &row);
+  // The digest of a single row, false if the row has no integer key.
+  bool row_digest(RowBuffer &row, long long &key, unsigned int &digest);
+  void forget_chunk(long long chunk) {
+    _chunks.erase(chunk);
+  }
+
+  long long chunk_keys() const {
+    return _chunk_keys;
+  }
+  const std::string &target_expression() const {
+    return _target_expression;
+  }
+  std::vector<long long> verify(MySQLCopyDataTarget *target, const TableParam &task,
+                                const std::set<long long> *only = NULL);
+};
+
+// Writes the JSON lines of the --metrics-file option, shared by all copy threads
+class MetricsLog {
+  FILE *_file;
+  base::Mutex _mutex;
+
+public:
+  MetricsLog(const std::string &path);
+  ~MetricsLog();
+
+  void write(const std::string &line);
+};
+
+// Time spent on each side of a copy, in microseconds of the monotonic clock
+struct CopyMetrics {
+  gint64 start;
+  gint64 last_report;
+  gint64 fetch_usecs;
+  gint64 insert_usecs;
+  gint64 queue_wait_usecs;
+  long long rows;
+  long long bytes;
+  long long wire_bytes; // What the target server received for them, after protocol compression
+
+  CopyMetrics() {
+    reset();
+  }
+  void reset();
+  void add(const CopyMetrics &other);
+};
+
 class CopyDataTask {
 private:
+  struct ReaderState;
+
   std::string _name;
   std::unique_ptr<CopyDataSource> _source;
   std::unique_ptr<MySQLCopyDataTarget> _target;
   TaskQueue *_tasks;
   bool _show_progress;
+  int _pipeline_batches;
+  MetricsLog *_metrics;
+  CopyMetrics _table_metrics;
+  CopyMetrics _thread_metrics;
+  RowBufferArena _arena; // column buffers of the pipeline batches
+  long long _checksum_chunk_keys;
+  std::unique_ptr<ChecksumVerifier> _checksums; // set while copying a table with --verify-checksums
+  bool _compare_only;                           // --compare-data, the tables are compared instead of copied
 
   GThread *_thread;
 
   static gpointer thread_func(gpointer data);
+  static gpointer reader_thread_func(gpointer data);
 
   void copy_table(const TableParam &task);
-
-  void report_progress(const std::string &schema, const std::string &table, long long current, long long total);
+  long long copy_rows(const TableParam &task, long long total);
+  long long copy_rows_pipelined(const TableParam &task, long long total, size_t batch_rows);
+
+  void report_progress(const TableParam &task, long long inserted, long long current, long long total);
+  void report_finished(const TableParam &task, long long copied, long long total, time_t start,
+                       const std::string &error = "");
+  void verify_checksums(const TableParam &task);
+  void recopy_chunk(const TableParam &task, long long start, long long end);
+  void compare_table(const TableParam &task);
+  long long compare_chunk(const TableParam &task, ChecksumVerifier &checksums, long long start, long long end);
+  void report_difference(const TableParam &task, const char *kind, long long key);
+  void report_live_metrics(const TableParam &task, long long copied, gint64 now);
+  void report_metrics(const TableParam *task, const char *event, const CopyMetrics &metrics);
+
+  int _failed_tables;
 
 public:
   CopyDataTask(const std::string name, CopyDataSource *psource, MySQLCopyDataTarget *ptarget, TaskQueue *ptasks,
-               bool show_progress);
+               bool show_progress, int pipeline_batches = 0, MetricsLog *metrics = NULL,
+               long long checksum_chunk_keys = 0, bool compare_only = false);
   ~CopyDataTask();
   void wait() {
     g_thread_join(_thread);
   }
+  int failed_tables() const {
+    return _failed_tables;
+  }
 };
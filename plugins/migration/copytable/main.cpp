@@ -38,6 +38,7 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <limits>
 
 #include "base/log.h"
 #include "base/sqlstring.h"
@@ -58,10 +59,14 @@ public:
 
 DEFAULT_LOG_DOMAIN("copytable");
 
+#define CDC_POLL_INTERVAL 1000000 // usecs between replication lag checks
+#define CDC_WAIT_TIMEOUT 5        // secs before --cdc-stop reports the lag again
+
 static void count_rows(std::unique_ptr<CopyDataSource> &source, const std::string &source_schema,
                        const std::string &source_table, const std::vector<std::string> &pk_columns,
                        const CopySpec &spec, const std::vector<std::string> &last_pkeys) {
-  unsigned long long total = source->count_rows(source_schema, source_table, pk_columns, spec, last_pkeys);
+  bool estimated;
+  unsigned long long total = source->rows_to_copy(source_schema, source_table, pk_columns, spec, last_pkeys, estimated);
 
   printf("ROW_COUNT:%s:%s: %llu\n", source_schema.c_str(), source_table.c_str(), total);
   fflush(stdout);
@@ -141,9 +146,11 @@ static void show_help() {
   printf("--target=<mysql connstring>\n");
   printf("--target-password=<password>\n");
   printf("--force-utf8-for-source\n");
+  printf("--compress=<algorithms> (zstd, zlib or uncompressed, comma separated by preference, default zlib)\n");
   printf("--truncate-target\n");
   printf("--progress\n");
   printf("--count-only\n");
+  printf("--estimate-row-counts (row counts from the table statistics, for progress only)\n");
   printf("--jobs-from-stdin\n");
   printf("--abort-on-oversized-blobs\n");
   printf("--max-count=<max rows count>\n");
@@ -163,8 +170,22 @@ static void show_help() {
   printf("\n");
   printf("--log-file=<file_path>\n");
   printf("--log-level=<level>\n");
+  printf("--log-async\n");
   printf("--thread-count=<count>\n");
-  printf("--bulk-insert-batch-size=<size>\n");
+  printf("--table-shards=<count>\n");
+  printf("--pipeline-batches=<count>\n");
+  printf("--bulk-insert-batch-size=<size> (disables the adaptive batch size)\n");
+  printf("--use-load-data\n");
+  printf("--defer-secondary-indexes\n");
+  printf("--metrics-file=<file_path>\n");
+  printf("--verify-checksums\n");
+  printf("--checksum-chunk-keys=<keys>\n");
+  printf("--compare-data (reports the rows that differ between source and target instead of copying)\n");
+  printf("--fetch-block-size=<rows>\n");
+  printf("--cdc-tail (replicate changes made during the copy, MySQL sources only)\n");
+  printf("--cdc-max-lag=<seconds> (replication lag at which --cdc-tail returns, default 1)\n");
+  printf("--cdc-source-host=<host>[:<port>] (the source as the target server reaches it)\n");
+  printf("--cdc-stop (waits for the replication to catch up and removes it, for the cutover)\n");
   printf("--disable-triggers-on=<schema>\n");
   printf("--reenable-triggers-on=<schema>\n");
   printf("--dont-disable-triggers");
@@ -238,6 +259,63 @@ bool read_tasks_from_file(const std::string file_name, bool count_only, TaskQueu
   return !error;
 }
 
+/*
+ * shard_tasks : splits full table copies into key ranges that can be copied in parallel.
+ * Parameters:
+ * - tasks : the task queue, sharded tables are replaced by one CopyRange task per key range
+ * - source : connection used to find out the key boundaries of each table
+ * - shard_count : the number of key ranges each table should be split into
+ *
+ * Remarks : Only tables copied in full with a single integer PK column are split. The ranges
+ *           of a table share a TableProgress so they are still reported as a single table, and
+ *           the last range is left open ended so rows above the current maximum key get copied too.
+ */
+static void shard_tasks(TaskQueue &tasks, CopyDataSource *source, int shard_count) {
+  std::vector<TableParam> sharded;
+  TableParam task;
+
+  while (tasks.get_task(task)) {
+    long long min_value = 0, max_value = 0;
+
+    if (task.copy_spec.type != CopyAll || task.copy_spec.max_count > 0 || task.source_pk_columns.size() != 1 ||
+        task.target_pk_columns.size() != 1 ||
+        !source->get_key_range(task.source_schema, task.source_table, task.source_pk_columns[0], min_value,
+                               max_value) ||
+        min_value < 0 || max_value <= min_value) {
+      sharded.push_back(task);
+      continue;
+    }
+
+    // The whole key range may not fit a signed value, e.g. 0 to LLONG_MAX
+    unsigned long long span = (unsigned long long)max_value - (unsigned long long)min_value;
+    if (span == std::numeric_limits<unsigned long long>::max()) {
+      sharded.push_back(task);
+      continue;
+    }
+    ++span;
+    unsigned long long step = span / shard_count + (span % shard_count ? 1 : 0);
+    int count = (int)(span / step + (span % step ? 1 : 0));
+
+    logInfo("Splitting table %s.%s into %i key ranges of %llu values on %s\n", task.source_schema.c_str(),
+            task.source_table.c_str(), count, step, task.source_pk_columns[0].c_str());
+
+    task.progress.reset(new TableProgress(count));
+    for (int index = 0; index < count; index++) {
+      TableParam range(task);
+      range.copy_spec.type = CopyRange;
+      range.copy_spec.range_key = task.source_pk_columns[0];
+      // Both stay below max_value, except for the open ended last range
+      range.copy_spec.range_start = (long long)((unsigned long long)min_value + index * step);
+      range.copy_spec.range_end =
+        index == count - 1 ? -1 : (long long)((unsigned long long)range.copy_spec.range_start + step - 1);
+      sharded.push_back(range);
+    }
+  }
+
+  for (std::vector<TableParam>::const_iterator iter = sharded.begin(); iter != sharded.end(); ++iter)
+    tasks.add_task(*iter);
+}
+
 int main(int argc, char **argv) {
   std::string app_name = base::basename(argv[0]);
 
@@ -266,9 +344,25 @@ int main(int argc, char **argv) {
   bool reenable_triggers = false;
   bool disable_triggers_on_copy = true;
   bool resume = false;
+  bool use_load_data = false;
+  bool estimate_row_counts = false;
   int thread_count = 1;
+  int table_shards = 1;
+  int pipeline_batches = 4;
+  int fetch_block_size = 256;
   long long bulk_insert_batch = 100;
+  bool adaptive_bulk_insert_batch = true;
+  bool defer_indexes = false;
+  std::string metrics_file;
+  bool verify_checksums = false;
+  bool compare_data = false;
+  long long checksum_chunk_keys = 100000;
   long long max_count = 0;
+  bool cdc_tail = false;
+  bool cdc_stop = false;
+  int cdc_max_lag = 1;
+  std::string cdc_source_host;
+  std::string compression;
 
   std::string table_file;
 
@@ -277,6 +371,7 @@ int main(int argc, char **argv) {
   unsigned int target_connection_timeout = 60;
   unsigned int source_connection_timeout = 60;
 
+  bool log_async = false;
   bool log_level_set = false;
   int i = 1;
   while (i < argc) {
@@ -322,6 +417,24 @@ int main(int argc, char **argv) {
       disable_triggers_on_copy = false;
     else if (strcmp(argv[i], "--resume") == 0)
       resume = true;
+    else if (strcmp(argv[i], "--log-async") == 0)
+      log_async = true;
+    else if (strcmp(argv[i], "--use-load-data") == 0)
+      use_load_data = true;
+    else if (strcmp(argv[i], "--estimate-row-counts") == 0)
+      estimate_row_counts = true;
+    else if (strcmp(argv[i], "--defer-secondary-indexes") == 0)
+      defer_indexes = true;
+    else if (strcmp(argv[i], "--verify-checksums") == 0)
+      verify_checksums = true;
+    else if (strcmp(argv[i], "--compare-data") == 0)
+      compare_data = true;
+    else if (strcmp(argv[i], "--cdc-tail") == 0)
+      cdc_tail = true;
+    else if (strcmp(argv[i], "--cdc-stop") == 0)
+      cdc_stop = true;
+    else if (check_arg_with_value(argv, i, "--cdc-source-host", argval, true))
+      cdc_source_host = argval;
     else if (check_arg_with_value(argv, i, "--disable-triggers-on", argval, true)) {
       // disabling/enabling triggers are standalone operations and mutually exclusive
       // so here it ensures a request for trigger enabling was not found first
@@ -340,10 +453,40 @@ int main(int argc, char **argv) {
       thread_count = base::atoi<int>(argval, 0);
       if (thread_count < 1)
         thread_count = 1;
+    } else if (check_arg_with_value(argv, i, "--table-shards", argval, true)) {
+      table_shards = base::atoi<int>(argval, 0);
+      if (table_shards < 1)
+        table_shards = 1;
+    } else if (check_arg_with_value(argv, i, "--pipeline-batches", argval, true)) {
+      pipeline_batches = base::atoi<int>(argval, 0);
+      if (pipeline_batches < 0)
+        pipeline_batches = 0;
+    } else if (check_arg_with_value(argv, i, "--cdc-max-lag", argval, true)) {
+      cdc_max_lag = base::atoi<int>(argval, 0);
+      if (cdc_max_lag < 0)
+        cdc_max_lag = 0;
+    } else if (check_arg_with_value(argv, i, "--compress", argval, true)) {
+      if (!MySQLConnectionOptions::valid_compression(argval)) {
+        fprintf(stderr, "%s: invalid argument '%s' for option %s\n", argv[0], argval, "--compress");
+        exit(1);
+      }
+      compression = argval;
+    } else if (check_arg_with_value(argv, i, "--metrics-file", argval, true)) {
+      metrics_file = argval;
+    } else if (check_arg_with_value(argv, i, "--checksum-chunk-keys", argval, true)) {
+      checksum_chunk_keys = base::atoi<long long>(argval, 0);
+      if (checksum_chunk_keys < 1)
+        checksum_chunk_keys = 1;
+    } else if (check_arg_with_value(argv, i, "--fetch-block-size", argval, true)) {
+      fetch_block_size = base::atoi<int>(argval, 0);
+      if (fetch_block_size < 1)
+        fetch_block_size = 1;
     } else if (check_arg_with_value(argv, i, "--bulk-insert-batch-size", argval, true)) {
       bulk_insert_batch = base::atoi<int>(argval, 0);
       if (bulk_insert_batch < 1)
         bulk_insert_batch = 100;
+      // An explicitly given size is used as is
+      adaptive_bulk_insert_batch = false;
     } else if (strcmp(argv[i], "--version") == 0) {
       const char *type = APP_EDITION_NAME;
       if (strcmp(APP_EDITION_NAME, "Community") == (0)) // Extra parens to silence warning.
@@ -486,6 +629,8 @@ int main(int argc, char **argv) {
   // Creates the log to the target file if any, if not
   // uses std_error
   base::Logger logger(true, log_file);
+  if (log_async)
+    base::Logger::async_mode(true);
 
   if (!log_level.empty()) {
     if (!set_log_level(log_level)) {
@@ -507,6 +652,9 @@ int main(int argc, char **argv) {
     base::Logger::active_level(level);
   }
 
+  if (!compression.empty())
+    MySQLConnectionOptions::set_compression(compression);
+
   // If needed, reads the tasks from the table definition file
   if (!table_file.empty()) {
     if (!read_tasks_from_file(table_file, count_only, tables, trigger_schemas, resume, max_count)) {
@@ -530,11 +678,28 @@ int main(int argc, char **argv) {
 
   // Table definitions will be required only if the standalone operations to
   // Reenable or disable triggers are not called
-  if (tables.empty() && !reenable_triggers && !disable_triggers) {
+  if (tables.empty() && !reenable_triggers && !disable_triggers && !cdc_stop) {
     logWarning("Missing table list specification\n");
     exit(0);
   }
 
+  if ((cdc_tail || cdc_stop) && (source_type != ST_MYSQL || count_only)) {
+    fprintf(stderr, "--cdc-tail and --cdc-stop need a MySQL source and a target\n");
+    exit(1);
+  }
+
+  // Comparing leaves the target as it is
+  if (compare_data) {
+    if (count_only || cdc_tail || cdc_stop || reenable_triggers || disable_triggers) {
+      fprintf(stderr, "--compare-data can't be combined with --count-only, --cdc-* or the trigger options\n");
+      exit(1);
+    }
+    truncate_target = false;
+    disable_triggers_on_copy = false;
+    defer_indexes = false;
+    table_shards = 1;
+  }
+
   std::string source_host;
   std::string source_user;
   int source_port = -1;
@@ -618,6 +783,7 @@ int main(int argc, char **argv) {
                                               source_use_cleartext_plugin, source_connection_timeout));
       else
         psource.reset(new PythonCopyDataSource(source_connstring, source_password));
+      psource->set_estimate_row_counts(estimate_row_counts);
 
       std::unique_ptr<MySQLCopyDataTarget> ptarget;
       TableParam task;
@@ -632,6 +798,28 @@ int main(int argc, char **argv) {
         }
         count_rows(psource, task.source_schema, task.source_table, task.source_pk_columns, task.copy_spec, last_pkeys);
       }
+    } else if (cdc_stop) {
+      MySQLCopyDataSource source(source_host, source_port, source_user, source_password, source_socket,
+                                 source_use_cleartext_plugin, source_connection_timeout);
+      MySQLCopyDataTarget target(target_host, target_port, target_user, target_password, target_socket,
+                                 target_use_cleartext_plugin, app_name, source_charset, source_rdbms_type,
+                                 target_connection_timeout);
+
+      // The application writing to the source is expected to be stopped, so its last position is final
+      std::string file;
+      unsigned long long position;
+      source.get_binlog_position(file, position);
+      logInfo("Waiting for the replication to reach %s:%llu\n", file.c_str(), position);
+      while (!target.wait_binlog_tail(file, position, CDC_WAIT_TIMEOUT)) {
+        std::string applied_file;
+        unsigned long long applied_position;
+        long long lag = target.binlog_tail_lag(applied_file, applied_position);
+        printf("CDC:%lld:%s:%llu\n", lag, applied_file.c_str(), applied_position);
+        fflush(stdout);
+      }
+      target.stop_binlog_tail();
+      printf("CDC_STOPPED:%s:%llu\n", file.c_str(), position);
+      fflush(stdout);
     } else if (reenable_triggers || disable_triggers) {
       std::unique_ptr<MySQLCopyDataTarget> ptarget;
       ptarget.reset(new MySQLCopyDataTarget(target_host, target_port, target_user, target_password, target_socket,
@@ -640,10 +828,20 @@ int main(int argc, char **argv) {
 
       if (disable_triggers)
         ptarget->backup_triggers(trigger_schemas);
-      else
+      else {
         ptarget->restore_triggers(trigger_schemas);
+
+        // Also completes index rebuilds left over by an aborted --defer-secondary-indexes copy
+        for (std::set<std::string>::const_iterator schema = trigger_schemas.begin(); schema != trigger_schemas.end();
+             ++schema)
+          ptarget->restore_indexes(base::unquote_identifier(*schema));
+        ptarget->drop_index_backups(trigger_schemas);
+      }
     } else {
       std::vector<CopyDataTask *> threads;
+      std::unique_ptr<MetricsLog> metrics;
+      if (!metrics_file.empty())
+        metrics.reset(new MetricsLog(metrics_file));
 
       std::unique_ptr<MySQLCopyDataTarget> ptarget_conn;
       MySQLCopyDataTarget *ptarget = NULL;
@@ -656,6 +854,73 @@ int main(int argc, char **argv) {
         ptarget_conn->backup_triggers(trigger_schemas);
       }
 
+      // Python DB API modules may refuse to be used from a thread other than the one that connected
+      // (e.g. sqlite3), so there the rows are fetched on the same thread that inserts them
+      if (source_type == ST_PYTHON)
+        pipeline_batches = 0;
+
+      // Big tables are split into key ranges up front, so the worker threads can share them
+      if (table_shards > 1) {
+        std::unique_ptr<CopyDataSource> shard_source;
+        SQLHENV shard_env = SQL_NULL_HANDLE;
+
+        // The environment is only needed for the key lookups, it's freed after the source is disconnected
+        try {
+          if (source_type == ST_ODBC) {
+            SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &shard_env);
+            SQLSetEnvAttr(shard_env, SQL_ATTR_ODBC_VERSION, (void *)SQL_OV_ODBC3, 0);
+
+            shard_source.reset(new ODBCCopyDataSource(shard_env, source_connstring, source_password, source_is_utf8,
+                                                      source_rdbms_type));
+          } else if (source_type == ST_MYSQL)
+            shard_source.reset(new MySQLCopyDataSource(source_host, source_port, source_user, source_password,
+                                                       source_socket, source_use_cleartext_plugin,
+                                                       source_connection_timeout));
+          else
+            logWarning("Table sharding is not supported for Python DB API sources\n");
+
+          if (shard_source.get())
+            shard_tasks(tables, shard_source.get(), table_shards);
+        } catch (...) {
+          shard_source.reset();
+          if (shard_env != SQL_NULL_HANDLE)
+            SQLFreeHandle(SQL_HANDLE_ENV, shard_env);
+          throw;
+        }
+        shard_source.reset();
+        if (shard_env != SQL_NULL_HANDLE)
+          SQLFreeHandle(SQL_HANDLE_ENV, shard_env);
+      }
+
+      // The position is taken before any row is read, everything changed after it is replicated once the copy is done
+      BinlogTailSpec tail;
+      if (cdc_tail && !check_types_only) {
+        MySQLCopyDataSource binlog_source(source_host, source_port, source_user, source_password, source_socket,
+                                          source_use_cleartext_plugin, source_connection_timeout);
+        binlog_source.get_binlog_position(tail.file, tail.position);
+        logInfo("Changes will be replicated from %s:%llu\n", tail.file.c_str(), tail.position);
+
+        tail.host = source_host;
+        tail.port = source_port > 0 ? source_port : 3306;
+        if (!cdc_source_host.empty()) {
+          std::string::size_type p = cdc_source_host.rfind(':');
+          tail.host = cdc_source_host.substr(0, p);
+          if (p != std::string::npos)
+            tail.port = base::atoi<int>(cdc_source_host.substr(p + 1), tail.port);
+        }
+        tail.user = source_user;
+        tail.password = source_password;
+
+        std::vector<TableParam> tasks = tables.tasks();
+        for (std::vector<TableParam>::const_iterator task = tasks.begin(); task != tasks.end(); ++task) {
+          std::string source_schema = base::unquote_identifier(task->source_schema);
+          std::string target_schema = base::unquote_identifier(task->target_schema);
+          if (source_schema != target_schema)
+            tail.rewrite_schemas[source_schema] = target_schema;
+          tail.tables.insert(target_schema + "." + base::unquote_identifier(task->target_table));
+        }
+      }
+
       for (int index = 0; index < thread_count; index++) {
         if (source_type == ST_ODBC) {
           SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &odbc_env);
@@ -671,28 +936,40 @@ int main(int argc, char **argv) {
 
         ptarget = new MySQLCopyDataTarget(target_host, target_port, target_user, target_password, target_socket,
                                           target_use_cleartext_plugin, app_name, source_charset, source_rdbms_type,
-                                          target_connection_timeout);
+                                          target_connection_timeout, use_load_data);
 
         psource->set_max_blob_chunk_size(ptarget->get_max_allowed_packet());
         psource->set_max_parameter_size((unsigned long)ptarget->get_max_long_data_size());
         psource->set_abort_on_oversized_blobs(abort_on_oversized_blobs);
+        psource->set_block_size(fetch_block_size);
+        psource->set_estimate_row_counts(estimate_row_counts);
         ptarget->set_truncate(truncate_target);
-        if (max_count > 0)
+        if (max_count > 0) {
           bulk_insert_batch = max_count;
+          adaptive_bulk_insert_batch = false;
+        }
         ptarget->set_bulk_insert_batch_size((int)bulk_insert_batch);
+        ptarget->set_adaptive_bulk_insert_batch(adaptive_bulk_insert_batch);
+        ptarget->set_use_load_data(use_load_data);
+        ptarget->set_defer_indexes(defer_indexes);
 
         if (check_types_only) {
           // XXXX
           delete psource;
         } else {
           threads.push_back(
-            new CopyDataTask(base::strfmt("Task %d", index + 1), psource, ptarget, &tables, show_progress));
+            new CopyDataTask(base::strfmt("Task %d", index + 1), psource, ptarget, &tables, show_progress,
+                             pipeline_batches, metrics.get(),
+                             verify_checksums || compare_data ? checksum_chunk_keys : 0, compare_data));
         }
       }
 
       // Waits for all the threads to complete
-      for (size_t index = 0; index < threads.size(); index++)
+      int failed_tables = 0;
+      for (size_t index = 0; index < threads.size(); index++) {
         threads[index]->wait();
+        failed_tables += threads[index]->failed_tables();
+      }
 
       // Finally destroys the threads and connections
       for (size_t index = 0; index < threads.size(); index++)
@@ -701,6 +978,41 @@ int main(int argc, char **argv) {
       // Finally restores the triggers
       if (disable_triggers_on_copy)
         ptarget_conn->restore_triggers(trigger_schemas);
+
+      // The indexes were rebuilt table by table, only the backup tables are left
+      if (defer_indexes && !check_types_only) {
+        if (!ptarget_conn.get())
+          ptarget_conn.reset(new MySQLCopyDataTarget(target_host, target_port, target_user, target_password,
+                                                     target_socket, target_use_cleartext_plugin, app_name,
+                                                     source_charset, source_rdbms_type, target_connection_timeout));
+        ptarget_conn->drop_index_backups(trigger_schemas);
+      }
+
+      // Replicating into an incomplete copy would only hide the failed tables
+      if (cdc_tail && !check_types_only && failed_tables > 0)
+        logError("%i tables were not copied completely, changes made during the copy are not replicated\n",
+                 failed_tables);
+      else if (cdc_tail && !check_types_only) {
+        if (!ptarget_conn.get())
+          ptarget_conn.reset(new MySQLCopyDataTarget(target_host, target_port, target_user, target_password,
+                                                     target_socket, target_use_cleartext_plugin, app_name,
+                                                     source_charset, source_rdbms_type, target_connection_timeout));
+        ptarget_conn->start_binlog_tail(tail);
+
+        // The channel keeps running after this, until --cdc-stop is called for the cutover
+        for (;;) {
+          std::string applied_file;
+          unsigned long long applied_position;
+          long long lag = ptarget_conn->binlog_tail_lag(applied_file, applied_position);
+          printf("CDC:%lld:%s:%llu\n", lag, applied_file.c_str(), applied_position);
+          fflush(stdout);
+          if (lag >= 0 && lag <= cdc_max_lag)
+            break;
+          g_usleep(CDC_POLL_INTERVAL);
+        }
+        printf("CDC_CAUGHT_UP\n");
+        fflush(stdout);
+      }
     }
   } catch (std::exception &e) {
     logError("Exception: %s\n", e.what());
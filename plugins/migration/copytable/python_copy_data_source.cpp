@@ -39,7 +39,7 @@
 DEFAULT_LOG_DOMAIN("copytable");
 
 PythonCopyDataSource::PythonCopyDataSource(const std::string &connstring, const std::string &password)
-  : _password(password), _connection(NULL), _cursor(NULL), initialized(false) {
+  : _password(password), _connection(NULL), _cursor(NULL), _rows(NULL), _next_row(0), initialized(false) {
   // connstring comes as "pythonmodule://connection_parameters"
   std::vector<std::string> conn_parts = base::split(connstring, "://", 1);
   if (conn_parts.size() != 2)
@@ -64,6 +64,7 @@ PythonCopyDataSource::PythonCopyDataSource(const std::string &connstring, const
 
 PythonCopyDataSource::~PythonCopyDataSource() {
   PyGILState_STATE state = PyGILState_Ensure();
+  Py_XDECREF(_rows);
   Py_XDECREF(_cursor);
   Py_XDECREF(_connection);
   PyGILState_Release(state);
@@ -231,6 +232,8 @@ size_t PythonCopyDataSource::count_rows(const std::string &schema, const std::st
           base::strfmt("SELECT count(*) FROM %s WHERE %s AND %s", table.c_str(), start_expr.c_str(), end_expr.c_str());
       else
         q = base::strfmt("SELECT count(*) FROM %s WHERE %s", table.c_str(), start_expr.c_str());
+      if (spec.resume && last_pkeys.size())
+        q += base::strfmt(" AND (%s)", get_where_condition(pk_columns, last_pkeys).c_str());
       break;
     }
     case CopyCount: {
@@ -289,6 +292,10 @@ std::shared_ptr<std::vector<ColumnInfo> > PythonCopyDataSource::begin_select_tab
 
   PyGILState_STATE state = PyGILState_Ensure();
 
+  // Rows left over from the previous table
+  Py_CLEAR(_rows);
+  _next_row = 0;
+
   if (!_cursor)
     std::runtime_error("No python cursor available");
 
@@ -371,6 +378,45 @@ std::shared_ptr<std::vector<ColumnInfo> > PythonCopyDataSource::begin_select_tab
 }
 
 void PythonCopyDataSource::end_select_table() {
+  if (_rows) {
+    PyGILState_STATE state = PyGILState_Ensure();
+    Py_CLEAR(_rows);
+    PyGILState_Release(state);
+  }
+  _next_row = 0;
+}
+
+/*
+ * next_row : returns the next row of the result set, or NULL at its end. Must be called with the GIL held.
+ *
+ * Remarks : Rows are fetched with cursor.fetchmany() in blocks of _block_size, as calling fetchone() for each row
+ *           costs more than converting the row itself. The returned row is borrowed from the block.
+ */
+PyObject *PythonCopyDataSource::next_row() {
+  if (_rows && _next_row >= PySequence_Fast_GET_SIZE(_rows))
+    Py_CLEAR(_rows);
+
+  if (!_rows) {
+    _next_row = 0;
+    PyObject *block = PyObject_CallMethod(_cursor, (char *)"fetchmany", (char *)"(i)", std::max(_block_size, 1));
+    if (block == NULL || block == Py_None) {
+      if (PyErr_Occurred())
+        PyErr_Print();
+      Py_XDECREF(block);
+      return NULL;
+    }
+
+    _rows = PySequence_Fast(block, "fetchmany() did not return a sequence");
+    Py_DECREF(block);
+    if (!_rows || PySequence_Fast_GET_SIZE(_rows) == 0) {
+      if (PyErr_Occurred())
+        PyErr_Print();
+      Py_CLEAR(_rows);
+      return NULL;
+    }
+  }
+
+  return PySequence_Fast_GET_ITEM(_rows, _next_row++);
 }
 
 bool PythonCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
@@ -383,7 +429,7 @@ bool PythonCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
     return false;
   }
 
-  PyObject *row = PyObject_CallMethod(_cursor, (char *)"fetchone", NULL);
+  PyObject *row = next_row();
   if (row == NULL || row == Py_None) {
     PyGILState_Release(state);
     return false;
@@ -458,22 +504,13 @@ bool PythonCopyDataSource::fetch_row(RowBuffer &rowbuffer) {
       {
         Py_ssize_t copied_bytes = 0;
         if (!blob_read_buffer_len) // empty buffer
-        {
-          rowbuffer[i].buffer_length = *rowbuffer[i].length = (unsigned long)blob_read_buffer_len;
-          rowbuffer[i].buffer = NULL;
-        }
+          *rowbuffer[i].length = 0;
         while (copied_bytes < blob_read_buffer_len) {
           Py_ssize_t this_pass_size = std::min(blob_read_buffer_len - copied_bytes, (Py_ssize_t)_max_blob_chunk_size);
           // ---- Begin Section: This will fail if multiple passes are done. TODO: Fix this.
           if (_use_bulk_inserts) {
-            if (rowbuffer[i].buffer_length)
-              free(rowbuffer[i].buffer);
-
             *rowbuffer[i].length = (unsigned long)blob_read_buffer_len;
-            rowbuffer[i].buffer_length = (unsigned long)blob_read_buffer_len;
-            rowbuffer[i].buffer = malloc(blob_read_buffer_len);
-
-            memcpy(rowbuffer[i].buffer, blob_read_buffer, blob_read_buffer_len);
+            memcpy(rowbuffer.grow_field(i, blob_read_buffer_len), blob_read_buffer, blob_read_buffer_len);
           } else
             rowbuffer.send_blob_data(blob_read_buffer + copied_bytes, this_pass_size);
           // ---- End Section
@@ -41,9 +41,14 @@ class PythonCopyDataSource : public CopyDataSource {
   std::vector<SQLSMALLINT> _column_types;
   size_t _column_count;
 
+  // Rows of the last cursor.fetchmany() call, as a list or tuple, and the next one fetch_row() returns
+  PyObject *_rows;
+  Py_ssize_t _next_row;
+
   bool initialized;
 
   void _init();
+  PyObject *next_row();
   bool pystring_to_string(PyObject *strobject, std::string &ret_string, bool convert);
 
 public:
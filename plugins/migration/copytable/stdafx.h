@@ -39,6 +39,7 @@ typedef int ssize_t;
 
 #include <errno.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include <vector>
 #include <set>
@@ -144,6 +144,12 @@ class SetupMainView(WizardPage):
         self._driver_sends_utf8.set_text("Driver sends data already encoded as UTF-8.")
         self.options_box.add(self._driver_sends_utf8, False, True)
 
+        self._exact_row_counts = mforms.newCheckBox()
+        self._exact_row_counts.set_text("Count table rows exactly before copying (can take long for big tables)")
+        self._exact_row_counts.set_tooltip("Otherwise the number of rows is estimated from the table statistics of the source,\n"+
+          "which is only used to show the progress of the copy.")
+        self.options_box.add(self._exact_row_counts, False, True)
+
 
         ###
 
@@ -205,6 +211,7 @@ All tables are copied by default.""")
         self.main.plan.state.dataBulkTransferParams["LiveDataCopy"] = 1 if self._copy_db.get_active() else 0
         self.main.plan.state.dataBulkTransferParams["DebugTableCopy"] = 1 if self._debug_copy.get_active() else 0
         self.main.plan.state.dataBulkTransferParams["DriverSendsDataAsUTF8"] = 1 if self._driver_sends_utf8.get_active() else 0
+        self.main.plan.state.dataBulkTransferParams["ExactRowCounts"] = 1 if self._exact_row_counts.get_active() else 0
         self.main.plan.state.dataBulkTransferParams["TruncateTargetTables"] = 1 if self._truncate_db.get_active() else 0
 
         for key in self.main.plan.state.dataBulkTransferParams.keys():
@@ -692,6 +699,9 @@ fi
                 else:
                     count = 0
                     ok = False
+                if ok and not self.main.plan.state.dataBulkTransferParams.get("ExactRowCounts", 0):
+                    # row counts were estimated, the copy itself knows how many rows there were
+                    row_count = count
                 if ok and count == row_count:
                     fully_copied = fully_copied + 1
 
@@ -211,7 +211,9 @@ class WbAdminControl(object):
         self.server_variables = {}
         self.status_variables = {} # 1st time is updated by us and then in a fixed interval by the monitoring thread
         self.status_variables_time = None
+        self.status_rates = None # per second change of the status variables, if the native sampler provides them
         self.status_variable_poll_interval = 3
+        self.status_history_size = 100
 
         # Sets the default logging callback
         self.log_cb = self.raw_log
@@ -365,6 +367,7 @@ uses_ssh: %i uses_wmi: %i\n""" % (self.server_profile.uses_ssh, self.server_prof
                 self.server_variables = {}
                 self.status_variables_time = None
                 self.status_variables = {}
+                self.status_rates = None
 
             return new_state
         return None
@@ -562,27 +565,53 @@ uses_ssh: %i uses_wmi: %i\n""" % (self.server_profile.uses_ssh, self.server_prof
             return None
 
         log_debug("Monitoring thread running...\n")
-        time.sleep(self.status_variable_poll_interval)
-        try:
-            # runs in a separate thread to fetch status variables
-            while self.running:
-                log_debug3("Poll server status\n")
-                variables = {}
-                result = self.poll_connection.executeQuery("SHOW GLOBAL STATUS")
-                while result and result.nextRow():
-                    variables[result.stringByName("Variable_name")] = result.stringByName("Value")
+        if hasattr(grt.modules.DbMySQLQuery, 'startStatusSampler'):
+            self.sample_server_status()
+        else:
+            time.sleep(self.status_variable_poll_interval)
+            try:
+                # runs in a separate thread to fetch status variables
+                while self.running:
+                    log_debug3("Poll server status\n")
+                    variables = {}
+                    result = self.poll_connection.executeQuery("SHOW GLOBAL STATUS")
+                    while result and result.nextRow():
+                        variables[result.stringByName("Variable_name")] = result.stringByName("Value")
 
-                self.status_variables, self.status_variables_time = variables, time.time()
+                    self.status_variables, self.status_variables_time = variables, time.time()
 
-                time.sleep(self.status_variable_poll_interval)
-        except QueryError:
-            log_error("Error in monitoring thread: %s\n" % traceback.format_exc())
+                    time.sleep(self.status_variable_poll_interval)
+            except QueryError:
+                log_error("Error in monitoring thread: %s\n" % traceback.format_exc())
 
         log_debug("Monitoring thread done.\n")
         self.poll_connection.disconnect()
         self.poll_connection = None
         mforms.Utilities.driver_shutdown()
 
+    #---------------------------------------------------------------------------
+    def sample_server_status(self):
+        # The status query runs in the native sampler on the poll connection, this only picks up its samples
+        sampler = grt.modules.DbMySQLQuery.startStatusSampler(self.poll_connection.connection,
+                                                              self.status_variable_poll_interval,
+                                                              self.status_history_size)
+        serial = 0
+        try:
+            while self.running:
+                time.sleep(self.status_variable_poll_interval)
+                snapshot = grt.modules.DbMySQLQuery.statusSamplerSnapshot(sampler, 0)
+                if snapshot["error"]:
+                    log_error("Error in monitoring thread: %s\n" % snapshot["error"])
+                    break
+                if snapshot["serial"] == serial or not snapshot.has_key("values"):
+                    continue
+                serial = snapshot["serial"]
+                variables = dict(snapshot["values"].items())
+                rates = dict(snapshot["rates"].items()) if snapshot["elapsed"] > 0 else None
+                self.status_variables, self.status_rates, self.status_variables_time = variables, rates, snapshot["time"]
+        finally:
+            grt.modules.DbMySQLQuery.stopStatusSampler(sampler)
+
     #---------------------------------------------------------------------------
     def get_mysql_password(self):
         found, password = mforms.Utilities.find_cached_password(self.server_profile.db_connection_params.hostIdentifier, self.server_profile.mysql_username)
@@ -700,6 +729,7 @@ uses_ssh: %i uses_wmi: %i\n""" % (self.server_profile.uses_ssh, self.server_prof
 
         self.status_variables_time = time.time()
         self.status_variables = {}
+        self.status_rates = None
         result = self.exec_query("SHOW GLOBAL STATUS")
         while result and result.nextRow():
             self.status_variables[result.stringByName("Variable_name")] = result.stringByName("Value")
@@ -97,6 +97,8 @@ Current limitations:
 
 import re
 
+import grt
+
 from workbench.log import log_info, log_error, log_warning
 
 from wb_server_management import SudoTailInputFile, LocalInputFile, SFTPInputFile
@@ -286,7 +288,14 @@ class BaseLogFileReader(object):
         The base class for logs stored in files unreadable to the current user.
 
         **This is not intended for direct instantiation.**
+
+        Files that can be read without sudo are paged through by the LogFileReader of the Utilities
+        module, which only parses the entries shown and indexes the file in the background. Subclasses
+        set native_format to the log format name it uses, the chunk based parsing in here is used
+        for the other files.
         '''
+    native_format = None
+
     def __init__(self, ctrl_be, log_file_param, pat, chunk_size, truncate_long_lines, append_gaps=True):
         """Constructor
 
@@ -390,6 +399,19 @@ class BaseLogFileReader(object):
             self.log_file = LocalInputFile(self.log_file_name)
             self.file_size = self.log_file.size
 
+        self.native_reader = None
+        if self.native_format and not use_sudo and not use_event_viewer:
+            try:
+                if use_sftp:
+                    self.native_reader = grt.modules.Utilities.openRemoteLogFile(self.ctrl_be.editor.sshConnection,
+                                                                                 self.log_file_name, self.native_format)
+                else:
+                    self.native_reader = grt.modules.Utilities.openLogFile(self.log_file_name, self.native_format)
+                self.native_info = grt.modules.Utilities.logFileInfo(self.native_reader)
+            except SystemError, e:
+                log_warning("Could not open log file %s with the native reader, will parse it in chunks: %s\n" %
+                            (self.log_file_name, e))
+
         self.chunk_size = chunk_size
         # chunk_start is the start of the chunk to be read (ie, we start reading from the end of the file, so we get the last page starting from there)
         self.chunk_start = max(0, self.file_size - chunk_size)
@@ -399,19 +421,49 @@ class BaseLogFileReader(object):
 
 
 
+    def __del__(self):
+        if getattr(self, 'native_reader', None):
+            grt.modules.Utilities.closeLogFile(self.native_reader)
+
+    def _native_call(self, function, *args):
+        '''
+            Calls a log file function of the Utilities module and takes the page position from it.
+            '''
+        try:
+            result = function(self.native_reader, *args)
+            info = grt.modules.Utilities.logFileInfo(self.native_reader)
+        except SystemError, e:
+            raise RuntimeError("Error reading log file %s: %s" % (self.log_file_name, e))
+        self.file_size = info['size']
+        self.chunk_start = info['pageStart']
+        self.chunk_end = info['pageEnd']
+        self.record_count = info['pageEntries']
+        self.native_info = info
+        return result
+
+    def _native_page(self, page):
+        return [list(record) for record in self._native_call(grt.modules.Utilities.readLogPage, page)]
+
     def has_previous(self):
         '''
             If there is a previous chunk that can be read.
             '''
+        if self.native_reader:
+            return bool(self.native_info['hasPrevious'])
         return self.chunk_start > 0
 
     def has_next(self):
         '''
             If there is a next chunk that can be read.
             '''
+        if self.native_reader:
+            return bool(self.native_info['hasNext'])
         return self.chunk_end != self.file_size
 
     def range_text(self):
+        if self.native_reader and self.native_info['firstEntry'] >= 0 and self.record_count > 0:
+            first = self.native_info['firstEntry'] + 1
+            return 'Records %s to %s' % (first, first + self.record_count - 1)
         return '%s records starting at byte offset %s' % (self.record_count, self.chunk_start)
 
     def size_text(self):
@@ -491,6 +543,8 @@ class BaseLogFileReader(object):
             Each record is a list with the values for each column of
             the corresponding log entry.
             '''
+        if self.native_reader:
+            return self._native_page('current')
         data = self.log_file.get_range(self.chunk_start, self.chunk_end)
         if self.chunk_start > self.chunk_size / 10:
             # adjust the start of the current chunk to the start of the 1st record (if we're not too close to the top)
@@ -506,6 +560,8 @@ class BaseLogFileReader(object):
             Each record is a list with the values for each column of
             the corresponding log entry.
             '''
+        if self.native_reader:
+            return self._native_page('previous')
         if self.chunk_start == 0:
             return []
         self.chunk_end = self.chunk_start
@@ -518,6 +574,8 @@ class BaseLogFileReader(object):
             Each record is a list with the values for each column of
             the corresponding log entry.
             '''
+        if self.native_reader:
+            return self._native_page('next')
         if self.chunk_end == self.file_size:
             return []
         self.chunk_start = self.chunk_end
@@ -528,18 +586,33 @@ class BaseLogFileReader(object):
         '''
             Returns a list with the records in the first chunk
             '''
+        if self.native_reader:
+            return self._native_page('first')
         self.chunk_start = 0
         self.chunk_end = self.chunk_size
         return self.current()
     
     def last(self):
         '''
-            Returns a list with the records in the first chunk
+            Returns a list with the records in the last chunk
             '''
+        if self.native_reader:
+            return self._native_page('last')
         self.chunk_start = max(0, self.file_size - self.chunk_size)
         self.chunk_end = self.file_size
         return self.current()
 
+    def seek_time(self, timestamp):
+        '''
+            Returns a list with the records of the page starting with the first record logged at or after
+            the given time (a 'YYYY-MM-DD HH:MM:SS' string or a prefix of it). Only files opened by the
+            native reader support this, for others the current records are returned.
+            '''
+        if self.native_reader:
+            records = self._native_call(grt.modules.Utilities.seekLogTime, timestamp)
+            return [list(record) for record in records]
+        return self.current()
+
     def refresh(self):
         '''
             Checks if the log file has been updated since it was opened and if so
@@ -548,6 +621,8 @@ class BaseLogFileReader(object):
             '''
         if self.log_file.path == "stderr":
             return
+        elif self.native_reader:
+            self._native_call(grt.modules.Utilities.refreshLogFile)
         else:
             new_size = self.log_file.size
             if new_size != self.file_size:
@@ -562,6 +637,8 @@ class ErrorLogFileReader(BaseLogFileReader):
     This class enables the retrieval of log entries in a MySQL error
     log file.
     '''
+    native_format = 'error'
+
     def __init__(self, ctrl_be, file_name, chunk_size=64 * 1024, truncate_long_lines=True):
         # The error log is a mess, there are several different formats for each entry and a new one comes up every version
         mysql_56 = r'^(?P<v56>(\d{2,4}-\d{1,2}-\d{2} {1,2}\d{1,2}:\d{2}:\d{2}) (\d+) \[(.*)\] (.*?))$'
@@ -612,7 +689,7 @@ class ErrorLogFileReader(BaseLogFileReader):
 
     def current(self):
         records = super(ErrorLogFileReader, self).current()
-        if self.chunk_end < self.file_size:
+        if self.chunk_end < self.file_size and not self.native_reader:
             # check if the last record is truncated
             rec = records[-1]
             if not any(f != "" for f in rec[:-1]):
@@ -628,6 +705,8 @@ class GeneralLogFileReader(BaseLogFileReader):
     This class enables the retrieval of log entries in a MySQL general query
     log file.
     '''
+    native_format = 'general'
+
     def __init__(self, ctrl_be, file_name, chunk_size=64 * 1024, truncate_long_lines=True):
         pat = re.compile(r'^(?P<v57>(\d{2,4}-\d{1,2}-\d{2}T{1,2}\d{1,2}:\d{2}:\d{2}.\d+Z)[\t ]*(\d+)\s*(.*?)(?:\t+| {2,})(.*?))$|^(?P<v56>(\d{6} {1,2}\d{1,2}:\d{2}:\d{2}[\t ]+|[\t ]+)(\s*\d+)(\s*.*?)(?:\t+| {2,})(.*?))$', re.M)
 
@@ -656,6 +735,8 @@ class SlowLogFileReader(BaseLogFileReader):
     This class enables the retrieval of log entries in a MySQL slow query
     log file.
     '''
+    native_format = 'slow'
+
     def __init__(self, ctrl_be, file_name, chunk_size=64 * 1024, truncate_long_lines=True, append_gaps=False):
         mysql_57 = r'(?:^|\n)(?P<v57># Time: (\d{2,4}-\d{1,2}-\d{2}T{1,2}\d{1,2}:\d{2}:\d{2}.\d+Z).*?\n# User@Host: (.*?)\n# Query_time: +([0-9.]+) +Lock_time: +([\d.]+) +Rows_sent: +(\d+) +Rows_examined: +(\d+)\s*\n(.*?)(?=\n# |\n[^\n]+, Version: |$))'
         mysql_56 = r'(?:^|\n)(?P<v56># Time: (\d{6} {1,2}\d{1,2}:\d{2}:\d{2}).*?\n# User@Host: (.*?)\n# Query_time: +([0-9.]+) +Lock_time: +([\d.]+) +Rows_sent: +(\d+) +Rows_examined: +(\d+)\s*\n(.*?)(?=\n# |\n[^\n]+, Version: |$))'
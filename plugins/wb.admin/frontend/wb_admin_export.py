@@ -130,22 +130,33 @@ def get_mysqldump_version():
     major, minor, revision = [int(i) for i in version_group.split(".")[:3]]
     return Version(major, minor, revision)
 
+def parallel_dump_jobs(options):
+    """Number of dump or restore processes to run at the same time for a dump project folder."""
+    try:
+        return max(1, int(options.get("$internal$parallel-jobs", "1")))
+    except ValueError:
+        return 1
+
 ####################################################################################################
 
 
 class DumpThread(threading.Thread):
     class TaskData:
-        def __init__(self, title, table_count, extra_arguments, objec_names, tables_to_ignore, make_pipe = lambda:None):
+        def __init__(self, title, table_count, extra_arguments, objec_names, tables_to_ignore, make_pipe = lambda:None, barrier = False):
             """description, object_count, pipe_factory, extra_args, objects
-            operations.append((title, len(tables), lambda schema=schema:self.dump_to_file([schema]), params, objects))"""
+            operations.append((title, len(tables), lambda schema=schema:self.dump_to_file([schema]), params, objects))
+            A barrier task only starts after all tasks before it are finished, when tasks run in parallel."""
             self.title = title
             self.table_count = table_count
             self.extra_arguments = extra_arguments
             self.objec_names = objec_names
             self.tables_to_ignore = tables_to_ignore
             self.make_pipe = make_pipe
+            self.barrier = barrier
 
-    def __init__(self, command, operations, pwd, owner, log_queue):
+    def __init__(self, command, operations, pwd, owner, log_queue, jobs = 1):
+        """With jobs > 1 that many tasks are run at the same time. Each task must then get its own pipe from
+        make_pipe, which is closed when the task is done, and fail_callback gets the pipe of the failed task."""
         self.owner = owner
         self.pwd = pwd
         self.logging_lock, self.log = log_queue
@@ -156,9 +167,13 @@ class DumpThread(threading.Thread):
         self.progress = 0
         self.status_text = "Starting"
         self.error_count = 0
-        self.process_handle = None
+        self.process_handles = set()
         self.abort_requested = False
         self.e = None
+        self.jobs = max(1, jobs)
+        self.state_lock = threading.Lock()
+        self.tables_processed = 0.0
+        self.tables_total = 0.0
         threading.Thread.__init__(self)
 
     def process_db(self, respipe, extra_arguments, object_names, tables_to_ignore):
@@ -243,7 +258,9 @@ class DumpThread(threading.Thread):
 #                    pass
 
 
-            self.process_handle = p1
+            if p1:
+                with self.state_lock:
+                    self.process_handles.add(p1)
 
             while p1 and p1.poll() == None and not self.abort_requested:
                 err = p1.stderr.read()
@@ -272,6 +289,9 @@ class DumpThread(threading.Thread):
         if err != "":
             result += err
 
+        with self.state_lock:
+            self.process_handles.discard(p1)
+
         exitcode = p1.poll()
         if exitcode != 0:
             log_warning("Task exited with code %s\n" % exitcode)
@@ -287,16 +307,18 @@ class DumpThread(threading.Thread):
 
     def kill(self):
         self.abort_requested = True
-        if self.process_handle:
+        with self.state_lock:
+            process_handles = list(self.process_handles)
+        for process_handle in process_handles:
             if platform.system() == 'Windows':
-                cmd = "taskkill /F /T /PID %i" % self.process_handle.pid
+                cmd = "taskkill /F /T /PID %i" % process_handle.pid
                 log_debug("Killing task: %s\n" % cmd)
                 subprocess.Popen(cmd , shell=True)
             else:
                 import signal
                 try:
-                    log_debug("Sending SIGTERM to task %s\n" % self.process_handle.pid)
-                    os.kill(self.process_handle.pid, signal.SIGTERM)
+                    log_debug("Sending SIGTERM to task %s\n" % process_handle.pid)
+                    os.kill(process_handle.pid, signal.SIGTERM)
                 except OSError, exc:
                     log_error("Exception sending SIGTERM to task: %s\n" % exc)
                     self.print_log_message("kill task: %s" % str(exc))
@@ -307,39 +329,73 @@ class DumpThread(threading.Thread):
             self.log.append(message)
             self.logging_lock.release()
 
+    def run_task(self, task):
+        self.print_log_message(time.strftime(u'%X ') + task.title.encode('utf-8'))
+
+        pipe = task.make_pipe()
+        exitcode = self.process_db(pipe, task.extra_arguments, task.objec_names, task.tables_to_ignore)
+        with self.state_lock:
+            self.tables_processed += task.table_count or 1
+            if exitcode == 0:
+                if self.is_import:
+                    self.status_text = "%i of %i imported." % (self.tables_processed, self.tables_total)
+                else:
+                    self.status_text = "%i of %i exported." % (self.tables_processed, self.tables_total)
+            else:
+                self.error_count += 1
+            self.progress = float(self.tables_processed) / self.tables_total
+
+        if self.jobs > 1:
+            if exitcode != 0:
+                self.owner.fail_callback(pipe)
+            elif pipe and not pipe.closed:
+                pipe.close()
+        elif exitcode != 0:
+            self.owner.fail_callback()
+
+    def run_parallel(self, tasks):
+        pending = list(tasks)
+        def work():
+            while not self.abort_requested:
+                with self.state_lock:
+                    if not pending:
+                        return
+                    task = pending.pop(0)
+                self.run_task(task)
+
+        workers = [threading.Thread(target=work) for i in range(min(self.jobs, len(pending)))]
+        for worker in workers:
+            worker.start()
+        for worker in workers:
+            worker.join()
+
     def run(self):
         try:
             self.progress = 0
-            tables_processed = 0.0
-            tables_total = 0.0
+            self.tables_processed = 0.0
+            self.tables_total = 0.0
 #            for title, count, make_pipe, args, objs in self.operations:
             for task in self.operations:
-                tables_total += task.table_count or 1
-
+                self.tables_total += task.table_count or 1
+
+            if self.jobs > 1:
+                # Tasks between barriers run in parallel, a barrier task runs alone.
+                batch = []
+                for task in self.operations + [None]:
+                    if task is not None and not task.barrier:
+                        batch.append(task)
+                        continue
+                    self.run_parallel(batch)
+                    batch = []
+                    if task is None or self.abort_requested:
+                        break
+                    self.run_task(task)
+            else:
 #            for title, table_count, make_pipe, arguments, objects in self.operations:
-            for task in self.operations:
-                self.print_log_message(time.strftime(u'%X ') + task.title.encode('utf-8'))
-
-                tables_processed += task.table_count or 1
-                pipe = task.make_pipe()
-                exitcode = self.process_db(pipe, task.extra_arguments, task.objec_names, task.tables_to_ignore)
-                if exitcode == 0:
-                    if self.is_import:
-                        self.status_text = "%i of %i imported." % (tables_processed, tables_total)
-                    else:
-                        self.status_text = "%i of %i exported." % (tables_processed, tables_total)
-                else:
-                    self.owner.fail_callback()
-                    self.error_count += 1
-
-                if self.abort_requested:
-                    break
-
-                self.progress = float(tables_processed) / tables_total
-#                print self.progress
-#               Emulate slow dump
-#                import time
-#                time.sleep(1)
+                for task in self.operations:
+                    self.run_task(task)
+                    if self.abort_requested:
+                        break
         except Exception, exc:
             import traceback
             traceback.print_exc()
@@ -463,6 +519,7 @@ class WbAdminSchemaListTab(mforms.Box):
         self.bad_password_detected = False
         self.server_profile = server_profile
         self.out_pipe = None
+        self.folder_file_lock = threading.Lock()
 
         if self.savefolder_path is None:
             self.savefolder_path = self.get_default_dump_folder()
@@ -1207,8 +1264,9 @@ class WbAdminImportTab(WbAdminSchemaListTab):
                     #operations.insert(0,task)
                     operations.append(task)
                 else:
+                    # views and routines need the tables, so they wait for all table files to be restored
                     path = self.views_paths.get((schema, table))
-                    task = DumpThread.TaskData(logmsg, 1, extra_args, [path], None, lambda:None)
+                    task = DumpThread.TaskData(logmsg, 1, extra_args, [path], None, lambda:None, True)
                     if path != None:
                         operations.append(task)
         else:
@@ -1285,7 +1343,13 @@ class WbAdminImportTab(WbAdminSchemaListTab):
             self.cancelled("Password Input Cancelled")
             return
 
-        self.dump_thread = DumpThread(cmd, operations, password, self, (self.progress_tab.logging_lock, self.progress_tab.log_queue))
+        # the table files of a dump project folder are independent of each other, so they can be restored at once
+        # (the export stores its options when the export page is closed)
+        jobs = 1
+        dic = grt.root.wb.options.options
+        if from_folder and dic.has_key("wb.admin.export.option:$internal$parallel-jobs"):
+            jobs = parallel_dump_jobs({"$internal$parallel-jobs": dic["wb.admin.export.option:$internal$parallel-jobs"]})
+        self.dump_thread = DumpThread(cmd, operations, password, self, (self.progress_tab.logging_lock, self.progress_tab.log_queue), jobs)
         self.dump_thread.is_import = True
         self.dump_thread.start()
         self._update_progress_tm = Utilities.add_timeout(float(0.4), self._update_progress)
@@ -1296,7 +1360,7 @@ class WbAdminImportTab(WbAdminSchemaListTab):
             self._update_progress_tm = None
         return r
 
-    def fail_callback(self):
+    def fail_callback(self, pipe=None):
         pass
 
     def close_pipe(self):
@@ -1619,20 +1683,27 @@ class WbAdminExportTab(WbAdminSchemaListTab):
                 extra_args = []
             DumpThread.TaskData.__init__(self,title, len(views), ["--skip-triggers", " --no-data" ," --no-create-db"] + extra_args + args, [schema] + views, None, make_pipe)
 
-    def dump_to_folder(self, schemaname, tablename):
-        self.close_pipe()
-        path = os.path.join(self.path, normalize_filename(schemaname) + "_" + normalize_filename(tablename) + '.sql')
-        i = 0
-        # check if the path already exists (they could become duplicated because of normalization)
-        while os.path.exists(path):
-            path = os.path.join(self.path, normalize_filename(schemaname) + "_" + normalize_filename(tablename) + ('%i.sql'%i))
-        self.out_pipe = open(path,"w")
+    def open_folder_file(self, schemaname, tablename):
+        # parallel dump tasks open their files at the same time
+        with self.folder_file_lock:
+            path = os.path.join(self.path, normalize_filename(schemaname) + "_" + normalize_filename(tablename) + '.sql')
+            i = 0
+            # check if the path already exists (they could become duplicated because of normalization)
+            while os.path.exists(path):
+                path = os.path.join(self.path, normalize_filename(schemaname) + "_" + normalize_filename(tablename) + ('%i.sql'%i))
+                i += 1
+            pipe = open(path,"w")
         if self.include_schema_check.get_active():
             data = self.table_list_model.get_schema_sql(schemaname)
             if type(data) is unicode:
                 data = data.encode("utf-8")
-            self.out_pipe.write(data)
-            self.out_pipe.flush()
+            pipe.write(data)
+            pipe.flush()
+        return pipe
+
+    def dump_to_folder(self, schemaname, tablename):
+        self.close_pipe()
+        self.out_pipe = self.open_folder_file(schemaname, tablename)
         return self.out_pipe
 
     def start(self):
@@ -1664,6 +1735,11 @@ class WbAdminExportTab(WbAdminSchemaListTab):
 
         save_to_folder = not self.fileradio.get_active()
 
+        # A dump project folder gets a file per table, which can be written by several mysqldump processes at once.
+        # No single transaction is possible there anyway. A self-contained file is written by a single process.
+        jobs = parallel_dump_jobs(self.owner.get_export_options({})) if save_to_folder else 1
+        make_folder_pipe = self.open_folder_file if jobs > 1 else self.dump_to_folder
+
         if save_to_folder:
             self.path = self.folder_te.get_string_value()
         else:
@@ -1706,9 +1782,9 @@ class WbAdminExportTab(WbAdminSchemaListTab):
                             args.append('--no-create-info')
 
                         if skip_data:
-                            task = self.TableDumpNoData(schema,table, args, lambda schema=schema,table=table:self.dump_to_folder(schema, table))
+                            task = self.TableDumpNoData(schema,table, args, lambda schema=schema,table=table:make_folder_pipe(schema, table))
                         else:
-                            task = self.TableDumpData(schema,table, args, lambda schema=schema,table=table:self.dump_to_folder(schema, table))
+                            task = self.TableDumpData(schema,table, args, lambda schema=schema,table=table:make_folder_pipe(schema, table))
                         operations.append(task)
                 # dump everything non-tables to file for routines
                 #if views:
@@ -1723,7 +1799,7 @@ class WbAdminExportTab(WbAdminSchemaListTab):
                         args.append("--routines")
                     if dump_events:
                         args.append("--events")
-                    task = self.ViewsRoutinesEventsDumpData(schema, views, args, lambda schema=schema, table=None:self.dump_to_folder(schema, "routines"))
+                    task = self.ViewsRoutinesEventsDumpData(schema, views, args, lambda schema=schema, table=None:make_folder_pipe(schema, "routines"))
                     operations.append(task)
         else: # single file
             if not os.path.exists(os.path.dirname(self.path)):
@@ -1860,7 +1936,7 @@ class WbAdminExportTab(WbAdminSchemaListTab):
         self.progress_tab.did_start()
         self.progress_tab.set_status("Export is running...")
 
-        self.dump_thread = DumpThread(cmd, operations, password, self, (self.progress_tab.logging_lock, self.progress_tab.log_queue))
+        self.dump_thread = DumpThread(cmd, operations, password, self, (self.progress_tab.logging_lock, self.progress_tab.log_queue), jobs)
         self.dump_thread.is_import = False
         self.dump_thread.start()
         self._update_progress_tm = Utilities.add_timeout(float(0.4), self._update_progress)
@@ -1880,9 +1956,13 @@ class WbAdminExportTab(WbAdminSchemaListTab):
             self.out_pipe.flush()
         return self.out_pipe
 
-    def fail_callback(self):
-        fname = self.out_pipe.name
-        self.close_pipe()
+    def fail_callback(self, pipe=None):
+        if pipe is None or pipe is self.out_pipe:
+            fname = self.out_pipe.name
+            self.close_pipe()
+        else:
+            fname = pipe.name
+            pipe.close()
         os.remove(fname)
 
     def close_pipe(self):
@@ -56,6 +56,7 @@ export_options = {
     "order-by-primary":["Dump each table's rows sorted by its primary key, or by its first unique index.","FALSE"],
     "dump-date":["Include dump date as \"Dump completed on\" comment if --comments is given.","TRUE"],
     "$internal$show-internal-schemas":["Show internal MySQL schemas (mysql, information_schema, performance_schema) in the export schema list.","FALSE"],
+    "$internal$parallel-jobs":["Number of tables dumped or restored at the same time with a dump project folder.","1","STR",(None, None)],
     "tz-utc":["Add SET TIME_ZONE='+00:00' to the dump file.","TRUE"],
 #    "xml":["Produce XML output.","FALSE"]
     "set-gtid-purged":["Add 'SET @@GLOBAL.GTID_PURGED' to the output.","AUTO","STR",("5.6.9", None)]
@@ -202,6 +202,13 @@ class RenderBox(mforms.PyDrawBox):
                 self.tooltip.show_and_track(self, xx, yy, mforms.StartRight)
 
 
+class StatusValues(dict):
+    """Status variables with the rates per second the native status sampler computed for them (None without)."""
+    def __init__(self, values, rates):
+        dict.__init__(self, values)
+        self.rates = rates
+
+
 class CDifferencePerSecond(object):
     def __init__(self, expr):
         self.expr = expr
@@ -224,7 +231,12 @@ class CDifferencePerSecond(object):
 
         if not self.expr:
             return result
-      
+
+        # The expressions are sums of counters, so their rate is the same sum of the counter rates.
+        rates = getattr(values, 'rates', None)
+        if rates is not None:
+            return eval(self.expr % rates)
+
         value = eval(self.expr % values)
       
         if self.old_value and self.old_value_timestamp:
@@ -752,9 +764,12 @@ class WbAdminDashboard(WbAdminTabBase):
     def refresh(self):
         status_variables, timestamp = self.ctrl_be.status_variables, self.ctrl_be.status_variables_time
         if self.last_refresh_time != timestamp:
+            # Rates are only right once per sample, the timer doesn't run in step with the sampler.
+            self.last_refresh_time = timestamp
+            values = StatusValues(status_variables, self.ctrl_be.status_rates)
             for w in self.widgets:
                 if hasattr(w, 'process'):
-                    w.process(status_variables, timestamp)
+                    w.process(values, timestamp)
 
             self.drawbox.variable_values.update(status_variables)
 
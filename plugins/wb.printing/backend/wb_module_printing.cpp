@@ -136,6 +136,7 @@ grt::ListRef<app_Plugin> WbPrintingImpl::getPluginInfo() {
 }
 
 int WbPrintingImpl::printToPDFFile(model_DiagramRef view, const std::string &path) {
+  view->get_data()->ensure_contents_realized();
   mdc::CanvasViewExtras extras(view->get_data()->get_canvas_view());
 
   app_PageSettingsRef page(workbench_DocumentRef::cast_from(grt::GRT::get()->get("/wb/doc"))->pageSettings());
@@ -174,6 +175,7 @@ int WbPrintingImpl::printDiagramsToFile(grt::ListRef<model_Diagram> views, const
     std::auto_ptr<mdc::Surface> surf;
 
     GRTLIST_FOREACH(model_Diagram, views, view) {
+      (*view)->get_data()->ensure_contents_realized();
       mdc::CanvasViewExtras extras((*view)->get_data()->get_canvas_view());
 
       extras.set_page_margins(page->marginTop(), page->marginLeft(), page->marginBottom(), page->marginRight());
@@ -203,6 +205,7 @@ int WbPrintingImpl::printDiagramsToFile(grt::ListRef<model_Diagram> views, const
 }
 
 int WbPrintingImpl::printToPSFile(model_DiagramRef view, const std::string &path) {
+  view->get_data()->ensure_contents_realized();
   mdc::CanvasViewExtras extras(view->get_data()->get_canvas_view());
 
   app_PageSettingsRef page(workbench_DocumentRef::cast_from(grt::GRT::get()->get("/wb/doc"))->pageSettings());
@@ -59,6 +59,7 @@ app_PageSettingsRef wbprint::getPageSettings(model_DiagramRef diagram) {
 #ifdef _WIN32
 
 int wbprint::printPageHDC(model_DiagramRef view, int pagenum, HDC hdc, int width, int height) {
+  view->get_data()->ensure_contents_realized();
   mdc::CanvasViewExtras extras(view->get_data()->get_canvas_view());
 
   app_PageSettingsRef page(workbench_DocumentRef::cast_from(grt::GRT::get()->get("/wb/doc"))->pageSettings());
@@ -210,6 +210,7 @@ namespace linux_printing {
     pageSize.width = paperWidth - marginLeft - marginRight;
     pageSize.height = paperHeight - marginTop - marginBottom;
 
+    _diagram->get_data()->ensure_contents_realized();
     _printer = new mdc::CanvasViewExtras(_diagram->get_data()->get_canvas_view());
 
     // margins are already added by the system
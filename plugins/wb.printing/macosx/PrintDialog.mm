@@ -76,6 +76,7 @@
     float yscale= [printInfo paperSize].height / paperHeight;
     float scale= (xscale + yscale) / 2;
     
+    diagram->get_data()->ensure_contents_realized();
     _printer= new mdc::CanvasViewExtras(diagram->get_data()->get_canvas_view());
     
     // margins are already added by the system
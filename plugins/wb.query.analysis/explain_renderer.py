@@ -31,6 +31,15 @@ import cairo
 
 import StringIO
 import json
+import sys
+
+# The plan is drawn once into image tiles of this size that are then copied to the view, so scrolling
+# doesn't render the nodes again. Tiles are rendered at twice the size on Retina capable Macs.
+TILE_SIZE = 512
+TILE_SCALE = 2 if sys.platform == "darwin" else 1
+MAX_CACHED_TILE_PIXELS = 16 * 1024 * 1024
+# Room around a node for its cost and row count captions, when checking whether it is visible.
+EXTENT_MARGIN = 60
 
 
 def decode_json(text):
@@ -242,11 +251,34 @@ class ExplainNode(VBoxFigure):
 
 
     def render_extras(self, cr):
-        self.do_render_extras(cr)
+        if self._context.is_visible(self._extent):
+            self.do_render_extras(cr)
 
         for ch in self.children:
             assert ch.parent == self
-            ch.render_extras(cr)
+            if self._context.is_visible(ch._subtree_extent):
+                ch.render_extras(cr)
+
+
+    def update_extent(self, origin_x, origin_y, parent_rect):
+        """Computes, in canvas coordinates, the area the node draws itself in, which includes its arrow to the parent,
+        and the area of the node with all its children"""
+        x, y = origin_x + self.x, origin_y + self.y
+        left, top, right, bottom = parent_rect if parent_rect else (x, y, x, y)
+        for item in self._items:
+            left, top = min(left, x + item.x), min(top, y + item.y)
+            right, bottom = max(right, x + item.x + item.width), max(bottom, y + item.y + item.height)
+        figure_rect = (x + self._figure.x, y + self._figure.y,
+                       x + self._figure.x + self._figure.width, y + self._figure.y + self._figure.height)
+        self._extent = (left - EXTENT_MARGIN, top - EXTENT_MARGIN, right + EXTENT_MARGIN, bottom + EXTENT_MARGIN)
+
+        left, top = min(self._extent[0], x), min(self._extent[1], y)
+        right, bottom = max(self._extent[2], x + self.width), max(self._extent[3], y + self.height)
+        for ch in self.children:
+            l, t, r, b = ch.update_extent(x, y, figure_rect)
+            left, top, right, bottom = min(left, l), min(top, t), max(right, r), max(bottom, b)
+        self._subtree_extent = (left, top, right, bottom)
+        return self._subtree_extent
 
     def render(self, cr):
         self.do_render(cr)
@@ -254,13 +286,15 @@ class ExplainNode(VBoxFigure):
 
 
     def do_render(self, cr):
-        VBoxFigure.render(self, cr)
+        if self._context.is_visible(self._extent):
+            VBoxFigure.render(self, cr)
 
         cr.save()
         cr.translate(self.x, self.y)
 
         for ch in self.children:
-            ch.do_render(cr)
+            if self._context.is_visible(ch._subtree_extent):
+                ch.do_render(cr)
 
         #ctx = cr
         #ctx.rectangle(0, 0, self.width, self.height)
@@ -1409,6 +1443,11 @@ class ExplainContext:
         self.displayed_cost_info = None
         self.cost_value_is_amount = False
 
+        self._tiles = {}
+        self._tile_order = []
+        self._overview_image = None
+        self._clip_rect = None
+
 
     def unexpected(self, node, context=""):
         if context:
@@ -1662,7 +1701,10 @@ class ExplainContext:
 
 
     def init_canvas(self, view, scroll, queue_repaint_cb):
-        self._canvas = MyCanvas(queue_repaint_cb)
+        def queue_repaint(x, y, w, h):
+            self.invalidate_cache()
+            queue_repaint_cb(x, y, w, h)
+        self._canvas = MyCanvas(queue_repaint)
         self._canvas.add(self._root)
 
         self._view = view
@@ -1691,18 +1733,105 @@ class ExplainContext:
         c = Context(ImageSurface(width=1, height=1))
 
         self._root.do_relayout(c)
+        self._root._layout_dirty = False # already laid out, the canvas doesn't need to do it again on the next repaint
         self._root.move(self.global_padding, self.global_padding)
+        self._root.update_extent(0, 0, None)
 
         w, h = self._root.size
         self.size = w + self.global_padding * 2, h + self.global_padding * 2
+        self.invalidate_cache()
         return self.size
-    
-    
-    def repaint(self, cr):
+
+
+    def invalidate_cache(self):
+        self._tiles = {}
+        self._tile_order = []
+        self._overview_image = None
+
+
+    def is_visible(self, extent):
+        """Whether the given area is in the part of the plan being rendered"""
+        if self._clip_rect is None:
+            return True
+        left, top, right, bottom = extent
+        x, y, w, h = self._clip_rect
+        return left < x + w and right > x and top < y + h and bottom > y
+
+
+    def _get_tile(self, column, row):
+        tile = self._tiles.get((column, row))
+        if tile:
+            self._tile_order.remove((column, row))
+            self._tile_order.append((column, row))
+            return tile
+
+        max_tiles = max(4, MAX_CACHED_TILE_PIXELS / (TILE_SIZE * TILE_SCALE) ** 2)
+        while len(self._tile_order) >= max_tiles:
+            del self._tiles[self._tile_order.pop(0)]
+
+        tile = ImageSurface(width=TILE_SIZE * TILE_SCALE, height=TILE_SIZE * TILE_SCALE)
+        cr = Context(tile)
+        cr.scale(TILE_SCALE, TILE_SCALE)
+        cr.translate(-column * TILE_SIZE, -row * TILE_SIZE)
+        self._clip_rect = (column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE)
+        try:
+            self._canvas.repaint(cr, 0, 0, self.size[0], self.size[1])
+        finally:
+            self._clip_rect = None
+        del cr
+
+        self._tiles[(column, row)] = tile
+        self._tile_order.append((column, row))
+        return tile
+
+
+    def _paint_tiles(self, cr, x, y, w, h):
+        # exposed area in canvas coordinates
+        left, top = max(0, int(x)), max(0, int(y))
+        right, bottom = min(self.size[0], int(x + w) + 1), min(self.size[1], int(y + h) + 1)
+        for row in range(top / TILE_SIZE, (bottom - 1) / TILE_SIZE + 1):
+            for column in range(left / TILE_SIZE, (right - 1) / TILE_SIZE + 1):
+                tile = self._get_tile(column, row)
+                cr.save()
+                cr.translate(column * TILE_SIZE, row * TILE_SIZE)
+                cr.scale(1.0 / TILE_SCALE, 1.0 / TILE_SCALE)
+                cr.set_source_surface(tile, 0, 0)
+                cr.rectangle(0, 0, TILE_SIZE * TILE_SCALE, TILE_SIZE * TILE_SCALE)
+                cr.fill()
+                cr.restore()
+
+
+    def _paint_overview(self, cr):
+        # the whole plan shrunk to the view is drawn once, the visible area marker is drawn over it
+        if not self._overview_image:
+            width = max(1, int(self.size[0] * self._scale * TILE_SCALE) + 1)
+            height = max(1, int(self.size[1] * self._scale * TILE_SCALE) + 1)
+            self._overview_image = ImageSurface(width=width, height=height)
+            c = Context(self._overview_image)
+            c.scale(self._scale * TILE_SCALE, self._scale * TILE_SCALE)
+            self._canvas.repaint(c, 0, 0, self.size[0], self.size[1])
+            del c
+        cr.save()
+        cr.scale(1.0 / (self._scale * TILE_SCALE), 1.0 / (self._scale * TILE_SCALE))
+        cr.set_source_surface(self._overview_image, 0, 0)
+        cr.paint()
+        cr.restore()
+
+
+    def repaint(self, cr, x=0, y=0, w=None, h=None):
+        """Paints the area x, y, w, h of the view (the whole plan if no size is given)"""
         cr.translate(self._offset[0] + self._extra_offset[0], self._offset[1] + self._extra_offset[1])
         cr.scale(self._scale, self._scale)
         try:
-            self._canvas.repaint(cr, 0, 0, self.size[0], self.size[1])
+            if self.overview_mode:
+                self._paint_overview(cr)
+            else:
+                if w is None or h is None:
+                    x, y, w, h = 0, 0, self.size[0], self.size[1]
+                else:
+                    x -= self._offset[0] + self._extra_offset[0]
+                    y -= self._offset[1] + self._extra_offset[1]
+                self._paint_tiles(cr, x, y, w, h)
 
             if self.overview_mode:
                 x, y, w, h = self._overview_visible_rect
@@ -1748,6 +1877,7 @@ class ExplainContext:
 
         self.overview_mode = True
         self._overview_visible_rect = r
+        self._overview_image = None
 
         # extra offset needed to center contents
         self._extra_offset = (view_width - total_width * self._scale)/2, (view_height - total_height * self._scale)/2
@@ -1799,10 +1929,12 @@ class ExplainContext:
     def show_cost_info_type(self, name):
         self.cost_value_is_amount = "data_read_per_join" == name
         self.displayed_cost_info = name
+        self.invalidate_cache()
 
 
     def show_aggregated_cost_info(self, flag):
         self.aggregate_costs = flag
+        self.invalidate_cache()
 
 
     def close_tooltip(self):
@@ -137,7 +137,7 @@ class RenderBox(mforms.PyDrawBox):
                 yy = (self.get_height() - dh)/2
             self.offset = (xx, yy)
             self.econtext.set_offset(xx, yy)
-            self.econtext.repaint(c)
+            self.econtext.repaint(c, x, y, w, h)
         except Exception:
             import traceback
             log_error("Exception rendering explain output: %s\n" % traceback.format_exc())
@@ -728,7 +728,13 @@ class IndexManager(ObjectManager):
     klass = "db.Index"
     node_name = "indexes"
     filter = None
-    show_query = "show index from `%(table)s` from `%(schema)s`"
+    # One query for the whole schema instead of a SHOW INDEX per table, the columns are renamed to the SHOW INDEX ones.
+    show_query = "select %(columns)s from information_schema.statistics where table_schema = '%(schema)s' order by table_name, index_name, seq_in_index"
+    statistics_columns = {"Table" : "TABLE_NAME", "Key_name" : "INDEX_NAME", "Non_unique" : "NON_UNIQUE",
+                          "Index_type" : "INDEX_TYPE", "Index_comment" : "INDEX_COMMENT", "Column_name" : "COLUMN_NAME",
+                          "Seq_in_index" : "SEQ_IN_INDEX", "Packed" : "PACKED", "Collation" : "COLLATION",
+                          "Cardinality" : "CARDINALITY", "Sub_part" : "SUB_PART", "Null" : "NULLABLE",
+                          "Comment" : "COMMENT", "Visible" : "IS_VISIBLE"}
     parent_name_column = 0
     name_column = 1
     icon_column = 0
@@ -752,7 +758,6 @@ class IndexManager(ObjectManager):
         ObjectManager.__init__(self, editor, schema)
 
         self.owner= owner
-        self.table_manager = owner.tab_tables
             
     def preload_columns(self):
         if self.target_version.is_supported_mysql_version_at_least(8, 0, 4):
@@ -762,44 +767,17 @@ class IndexManager(ObjectManager):
         self.owner.show_index_manager()
 
 
-    def refresh(self):
-        self.tree.clear()
-        for table in self.table_manager.table_names or []:
-            try:
-                rset = self.editor.executeManagementQuery(self.show_query % {'table' : table.replace("`", "``"), 'schema' : self.schema.replace("`", "``")}, 0)
-            except grt.DBError, err:
-                log_warning("Error querying index info for %s.%s: %s\n" % (self.schema, table, err[0]))
+    def get_query(self):
+        cols = []
+        for field_obj, ctype, caption, width, min_version in self.columns:
+            if min_version and not self.target_version.is_supported_mysql_version_at_least(Version.fromstr(min_version)):
                 continue
-            ok = rset.goToFirstRow()
-            while ok:
-                if not self.filter or self.filter(rset):
-                    node = self.tree.add_node()
-                    node.set_icon_path(0, self.icon_path)
-                    i = 0
-                    for field_obj, ctype, caption, width, min_version in self.columns:
-                        if min_version and not self.target_version.is_supported_mysql_version_at_least(Version.fromstr(min_version)):
-                            continue
-                        format_func = None
-                        field = None
-                        try:
-                            format_func = field_obj['format_func']
-                            field = field_obj['field']
-                        except:
-                            field = field_obj
-
-                        if ctype == mforms.IntegerColumnType:
-                            if type(field) is int:
-                                node.set_int(i, rset.intFieldValue(field) or 0)
-                            else:
-                                node.set_int(i, rset.intFieldValueByName(field) or 0)
-                        else:
-                            if type(field) is int:
-                                node.set_string(i, rset.stringFieldValue(field) or "" if format_func is None else format_func(rset.stringFieldValue(field)))
-                            else:
-                                node.set_string(i, rset.stringFieldValueByName(field) or "" if format_func is None else format_func(rset.stringFieldValueByName(field)))
-                        i += 1
-                ok = rset.nextRow()
-        self.refresh_row_count()
+            try:
+                field = field_obj['field']
+            except:
+                field = field_obj
+            cols.append("%s as `%s`" % (self.statistics_columns[field], field))
+        return self.show_query % {'schema' : self.schema, 'columns' : ", ".join(cols)}
 
 
 class GrantsManager(ObjectManager):
@@ -222,6 +222,96 @@ def verticalOutput(editor):
     return 0
 
 
+def format_query_time(seconds):
+    if seconds >= 1:
+        return "%.3f s" % seconds
+    return "%.3f ms" % (seconds * 1000)
+
+
+class QueryStatisticsTab(mforms.AppView):
+    orders = [("Total Time", "total"), ("Average Time", "average"), ("Max Time", "max"), ("Rows Examined", "rows_examined")]
+
+    def __init__(self, editor):
+        super(QueryStatisticsTab, self).__init__(False, "QueryStatistics", False)
+        self.editor = editor
+        self.set_padding(8)
+        self.set_spacing(8)
+
+        bbox = mforms.newBox(True)
+        bbox.set_spacing(8)
+        bbox.add(mforms.newLabel("Rank by:"), False, True)
+        self.order = mforms.newSelector()
+        self.order.add_items([caption for caption, order in self.orders])
+        self.order.add_changed_callback(self.refresh)
+        bbox.add(self.order, False, True)
+        self.info = mforms.newLabel("")
+        bbox.add(self.info, True, True)
+        clear = mforms.newButton()
+        clear.set_text("Clear")
+        clear.add_clicked_callback(self.clear)
+        bbox.add_end(clear, False, True)
+        refresh = mforms.newButton()
+        refresh.set_text("Refresh")
+        refresh.add_clicked_callback(self.refresh)
+        bbox.add_end(refresh, False, True)
+        self.add(bbox, False, True)
+
+        self.tree = mforms.newTreeView(mforms.TreeFlatList|mforms.TreeAltRowColors|mforms.TreeShowColumnLines)
+        self.tree.add_column(mforms.StringColumnType, "Statement", 400, False)
+        self.tree.add_column(mforms.LongIntegerColumnType, "Runs", 50, False)
+        self.tree.add_column(mforms.StringColumnType, "Total Time", 80, False)
+        self.tree.add_column(mforms.StringColumnType, "Average Time", 80, False)
+        self.tree.add_column(mforms.StringColumnType, "Max Time", 80, False)
+        self.tree.add_column(mforms.LongIntegerColumnType, "Rows Examined (avg)", 120, False)
+        self.tree.add_column(mforms.LongIntegerColumnType, "Rows Sent (avg)", 100, False)
+        self.tree.add_column(mforms.LongIntegerColumnType, "Tmp Disk Tables", 100, False)
+        self.tree.add_column(mforms.LongIntegerColumnType, "No Index Used", 90, False)
+        self.tree.add_column(mforms.StringColumnType, "Last Run", 130, False)
+        self.tree.end_columns()
+        self.add(self.tree, True, True)
+
+        self.refresh()
+
+    def refresh(self):
+        import time
+        order = self.orders[max(0, self.order.get_selected_index())][1]
+        self.tree.clear()
+        entries = self.editor.queryStatistics(order, 200)
+        for entry in entries:
+            count = max(1, entry["count"])
+            node = self.tree.add_node()
+            node.set_string(0, entry["statement"])
+            node.set_long(1, entry["count"])
+            node.set_string(2, format_query_time(entry["total_time"]))
+            node.set_string(3, format_query_time(entry["total_time"] / count))
+            node.set_string(4, format_query_time(entry["max_time"]))
+            node.set_long(5, entry["rows_examined"] / count)
+            node.set_long(6, entry["rows_sent"] / count)
+            node.set_long(7, entry["tmp_disk_tables"])
+            node.set_long(8, entry["no_index_used"])
+            node.set_string(9, time.strftime("%Y-%m-%d %H:%M:%S", time.localtime(entry["last_seen"])))
+        if entries:
+            self.info.set_text("%i statements" % len(entries))
+        else:
+            self.info.set_text("Statements are added while Query > Collect Performance Schema Stats is enabled")
+
+    def clear(self):
+        if mforms.Utilities.show_message("Clear Query Statistics", "Remove the statistics of all statements run with this connection?", "Clear", "Cancel", "") == mforms.ResultOk:
+            self.editor.clearQueryStatistics()
+            self.refresh()
+
+
+@ModuleInfo.plugin("wb.sqlide.showQueryStatistics", caption="Query Statistics History", input=[wbinputs.currentSQLEditor()])
+@ModuleInfo.export(grt.INT, grt.classes.db_query_Editor)
+def showQueryStatistics(editor):
+    view = QueryStatisticsTab(editor)
+    dock = mforms.fromgrt(editor.dockingPoint)
+    dock.dock_view(view, "", 0)
+    dock.select_view(view)
+    view.set_title("Query Statistics")
+    return 0
+
+
 def doReformatSQLStatement(text, return_none_if_unsupported):
     from grt.modules import MysqlSqlFacade
     ast_list = MysqlSqlFacade.parseAstFromSqlScript(text)
@@ -260,6 +260,49 @@ class base_module:
             raise
         
     
+    def native_import(self, columns, options = {}):
+        # The SQL editor parses the file in a stream and sends the rows as multi-row INSERTs. Every call imports the
+        # next part of the file, so progress and stop requests are handled here in between.
+        options = dict(options)
+        options['path'] = self._filepath
+        options['format'] = self.name
+        options['table'] = self._table_w_prefix
+        options['columns'] = columns
+        options['decimalSeparator'] = self._decimal_separator
+        options['dateFormat'] = self._date_format
+        options['stFunctions'] = 1 if self._targetVersion.is_supported_mysql_version_at_least(Version.fromstr("5.7.5")) else 0
+        options['position'] = 0
+        try:
+            rset = self._editor.executeManagementQuery("SELECT @@max_allowed_packet", 0)
+            if rset and rset.goToFirstRow():
+                options['maxAllowedPacket'] = rset.intFieldValue(0)
+        except Exception, e:
+            log_warning("Could not read max_allowed_packet, using the default statement size: %s\n" % e)
+
+        result = True
+        self.update_progress(0.0, "Begin Import")
+        while True:
+            if self._thread_event and self._thread_event.is_set():
+                log_debug2("Worker thread was stopped by user")
+                self.update_progress(round(self._current_row / self._max_rows, 2), "Import stopped by user request")
+                return False
+
+            state = self._editor.importTableData(options)
+            options['position'] = state['position']
+            self.item_count = self.item_count + state['rows']
+            self._current_row = float(state['position'])
+            self._max_rows = max(state['size'], 1)
+            if state['failed'] > 0:
+                result = False
+                self.update_progress(round(self._current_row / self._max_rows, 2), "Row import failed with error: %s" % state['error'])
+            else:
+                self.update_progress(round(self._current_row / self._max_rows, 2), "Data import")
+            if state['done']:
+                break
+
+        self.update_progress(1.0, "Import finished")
+        return result
+
     def get_command(self):
         return False
     
@@ -418,6 +461,11 @@ class csv_module(base_module):
             self.update_progress(0.0, "Truncate table")
             self._editor.executeManagementCommand("TRUNCATE TABLE %s" % self._table_w_prefix, 1)
             
+        if self._encoding.lower().replace('_', '-') in ['utf-8', 'utf8', 'ascii']:
+            columns = [{'index': i['col_no'], 'target': i['dest_col'], 'type': i['type']} for i in self._mapping if i['active']]
+            return self.native_import(columns, {'separator': self.dialect.delimiter, 'quote': self.dialect.quotechar or '',
+                                                'hasHeader': 1 if self.has_header else 0})
+
         result = True
         
         with open(self._filepath, 'rb') as csvfile:
@@ -664,66 +712,8 @@ class json_module(base_module):
             self.update_progress(0.0, "Truncate table")
             self._editor.executeManagementCommand("TRUNCATE TABLE %s" % self._table_w_prefix, 1)
         
-        result = True
-        with open(self._filepath, 'rb') as jsonfile:
-            data = json.load(jsonfile)
-            dest_col_order = list(set([i['dest_col'] for i in self._mapping if i['active']]))
-            query = """PREPARE stmt FROM 'INSERT INTO %s (%s) VALUES(%s)'""" % (self._table_w_prefix, ",".join(["`%s`" % col for col in dest_col_order]), ",".join(["?" for i in dest_col_order]))
-            col_order = dict([(i['dest_col'], i['name']) for i in self._mapping if i['active']])
-            col_type = dict([(i['name'], i['type']) for i in self._mapping if i['active']])
-            
-            self._editor.executeManagementCommand(query, 1)
-            try:
-                self._max_rows = len(data)
-                for row in data:
-                    if self._thread_event and self._thread_event.is_set():
-                        log_debug2("Worker thread was stopped by user")
-                        self._editor.executeManagementCommand("DEALLOCATE PREPARE stmt", 1)
-                        return False
-                    self._current_row = self._current_row + 1
-                    for i, col in enumerate(col_order):
-                        if col_order[col] not in row:
-                            log_error("Can't find col: %s in row: %s" % (col_order[col], row))
-                            result = False
-                            break
-
-                        val = row[col_order[col]]
-                        col_name = col_order[col]
-
-                        if col_type[col] == "geometry":
-                            val = """ ST_GeomFromGeoJSON('%s')""" % json.dumps(val).replace("\\", "\\\\").replace("'", "\\'")
-                                 
-                            self._editor.executeManagementCommand("""SET @a%d = %s """ % (i, val), 0)
-                        else:
-                            if col_type[col_name] != "json" and hasattr(val, "replace"):
-                                val = val.replace("\\", "\\\\").replace("'", "\\'")
-                                
-                            if col_type[col_name] == 'double':
-                                val = val(str).replace(self._decimal_separator, '.')
-                            elif col_type[col_name] == 'datetime':
-                                val = datetime.datetime.strptime(val, self._date_format).strftime("%Y-%m-%d %H:%M:%S")
-                            elif col_type[col_name] == "json":
-                                val = json.dumps(val).replace("\\", "\\\\").replace("'", "\\'")                                
-    
-                            if col_type[col_name] == "int":
-                                self._editor.executeManagementCommand("""SET @a%d = %d """ % (i, int(val)), 0)
-                            else:
-                                self._editor.executeManagementCommand("""SET @a%d = '%s' """ % (i, val), 0)
-
-                    else:
-                        try:
-                            self._editor.executeManagementCommand("EXECUTE stmt USING %s" % ", ".join(['@a%d' % i for i, col in enumerate(col_order)]), 0)
-                            self.item_count = self.item_count + 1
-                        except Exception, e:
-                            log_error("Row import failed with error: %s" % e)
-                        
-            except Exception, e:
-                import traceback
-                log_debug3("Import failed traceback: %s" % traceback.format_exc())
-                log_error("Import failed: %s" % e)
-            self._editor.executeManagementCommand("DEALLOCATE PREPARE stmt", 1)
-            
-        return result
+        columns = [{'source': i['name'], 'target': i['dest_col'], 'type': i['type']} for i in self._mapping if i['active']]
+        return self.native_import(columns)
 
     def analyze_file(self):
         data = []